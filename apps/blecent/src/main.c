@@ -273,7 +273,7 @@ blecent_scan(void)
 static int
 blecent_should_connect(const struct ble_gap_disc_desc *disc)
 {
-    int i;
+    int rc;
 
     /* The device has to be advertising connectability. */
     if (disc->event_type != BLE_HCI_ADV_RPT_EVTYPE_ADV_IND &&
@@ -285,13 +285,9 @@ blecent_should_connect(const struct ble_gap_disc_desc *disc)
     /* The device has to advertise support for the Alert Notification
      * service (0x1811).
      */
-    for (i = 0; i < disc->fields->num_uuids16; i++) {
-        if (disc->fields->uuids16[i] == BLECENT_SVC_ALERT_UUID) {
-            return 1;
-        }
-    }
-
-    return 0;
+    rc = ble_hs_adv_find_uuid16(BLECENT_SVC_ALERT_UUID, disc->data,
+                                disc->length_data);
+    return rc == 0;
 }
 
 /**
@@ -351,7 +347,9 @@ blecent_gap_event(struct ble_gap_event *event, void *arg)
     switch (event->type) {
     case BLE_GAP_EVENT_DISC:
         /* An advertisment report was received during GAP discovery. */
-        print_adv_fields(event->disc.fields);
+        if (event->disc.fields != NULL) {
+            print_adv_fields(event->disc.fields);
+        }
 
         /* Try to connect to the advertiser if it looks interesting. */
         blecent_connect_if_interesting(&event->disc);
@@ -283,29 +283,58 @@ gatt_svr_uuid_to_s(const void *uuid128, char *dst)
     return dst;
 }
 
+/**
+ * Returns the 128-bit form of a definition's UUID, whether the definition
+ * specifies it natively or as a byte array.
+ */
+static const void *
+gatt_svr_def_uuid128(const ble_uuid_t *uuid, const uint8_t *uuid128,
+                     uint8_t *dst)
+{
+    if (uuid != NULL) {
+        ble_uuid_to_128(uuid, dst);
+        return dst;
+    }
+
+    return uuid128;
+}
+
 void
 gatt_svr_register_cb(struct ble_gatt_register_ctxt *ctxt, void *arg)
 {
+    uint8_t uuid128[16];
     char buf[40];
 
     switch (ctxt->op) {
     case BLE_GATT_REGISTER_OP_SVC:
         BLEPRPH_LOG(DEBUG, "registered service %s with handle=%d\n",
-                    gatt_svr_uuid_to_s(ctxt->svc.svc_def->uuid128, buf),
+                    gatt_svr_uuid_to_s(
+                        gatt_svr_def_uuid128(ctxt->svc.svc_def->uuid,
+                                             ctxt->svc.svc_def->uuid128,
+                                             uuid128),
+                        buf),
                     ctxt->svc.handle);
         break;
 
     case BLE_GATT_REGISTER_OP_CHR:
         BLEPRPH_LOG(DEBUG, "registering characteristic %s with "
                            "def_handle=%d val_handle=%d\n",
-                    gatt_svr_uuid_to_s(ctxt->chr.chr_def->uuid128, buf),
+                    gatt_svr_uuid_to_s(
+                        gatt_svr_def_uuid128(ctxt->chr.chr_def->uuid,
+                                             ctxt->chr.chr_def->uuid128,
+                                             uuid128),
+                        buf),
                     ctxt->chr.def_handle,
                     ctxt->chr.val_handle);
         break;
 
     case BLE_GATT_REGISTER_OP_DSC:
         BLEPRPH_LOG(DEBUG, "registering descriptor %s with handle=%d\n",
-                    gatt_svr_uuid_to_s(ctxt->dsc.dsc_def->uuid128, buf),
+                    gatt_svr_uuid_to_s(
+                        gatt_svr_def_uuid128(ctxt->dsc.dsc_def->uuid,
+                                             ctxt->dsc.dsc_def->uuid128,
+                                             uuid128),
+                        buf),
                     ctxt->dsc.handle);
         break;
 
@@ -0,0 +1,867 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * Throughput and latency benchmark.
+ *
+ * One device streams packets to its peer for a fixed duration (or issues
+ * back-to-back ATT reads), while the peer runs the "rx" type and counts what
+ * arrives.  Each streamed packet starts with a 32-bit little-endian sequence
+ * number so the receiver can detect gaps.  Both sides print a report when the
+ * run ends; "b bench show" prints one for the run in progress.
+ *
+ * The sender keeps the host's transmit queue full: it sends a burst of
+ * packets per event and backs off for one tick whenever the host runs out of
+ * buffers.  Its counts therefore include packets that are still queued when
+ * the run ends; the receiver's numbers are the authoritative goodput.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "os/os_cputime.h"
+#include "stats/stats.h"
+#include "console/console.h"
+#include "nimble/ble.h"
+#include "host/ble_hs.h"
+#include "host/ble_l2cap.h"
+#include "bletiny.h"
+
+/** Number of packets queued per event while streaming. */
+#define BLETINY_BENCH_BURST         8
+
+/** Number of round-trip samples retained for the percentile report. */
+#define BLETINY_BENCH_RTT_MAX       128
+
+#define BLETINY_BENCH_SEQ_LEN       4
+
+/** Largest SDU accepted on the benchmark's L2CAP channel. */
+#define BLETINY_BENCH_COC_MTU       512
+
+struct bletiny_bench {
+    struct bletiny_bench_params params;
+    uint8_t active;
+    uint8_t read_pending;
+    uint8_t coc_stalled;
+
+    os_time_t start;
+    os_time_t stop;
+    os_time_t rx_first;
+    os_time_t rx_last;
+    os_time_t idle_start;
+    os_time_t idle_stop;
+
+    uint32_t tx_seq;
+    uint32_t tx_pkts;
+    uint32_t tx_bytes;
+    uint32_t tx_stalls;
+    uint32_t tx_errs;
+
+    uint32_t rx_next_seq;
+    uint32_t rx_pkts;
+    uint32_t rx_bytes;
+    uint32_t rx_lost;
+
+    uint32_t read_start;
+    uint32_t rtt_cnt;
+    uint32_t rtt_min;
+    uint32_t rtt_max;
+    uint64_t rtt_sum;
+    uint32_t rtt_samples[BLETINY_BENCH_RTT_MAX];
+
+    int ll_txf_valid;
+    uint32_t ll_txf_start;
+    uint32_t ll_txf_stop;
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+    struct ble_l2cap_chan *coc_chan;
+#endif
+};
+
+static struct bletiny_bench bletiny_bench;
+static struct os_callout bletiny_bench_timer;
+
+extern struct os_task g_idle_task;
+
+static const char *bletiny_bench_type_names[] = {
+    [BLETINY_BENCH_TYPE_NOTIFY] = "notify",
+    [BLETINY_BENCH_TYPE_WRITE]  = "write",
+    [BLETINY_BENCH_TYPE_READ]   = "read",
+    [BLETINY_BENCH_TYPE_COC]    = "coc",
+    [BLETINY_BENCH_TYPE_RX]     = "rx",
+};
+
+struct bletiny_bench_stat_arg {
+    const char *name;
+    uint32_t val;
+    int found;
+};
+
+static int
+bletiny_bench_stat_walk(struct stats_hdr *hdr, void *arg, char *name,
+                        uint16_t stat_off)
+{
+    struct bletiny_bench_stat_arg *sa;
+    void *stat_val;
+
+    sa = arg;
+    if (strcmp(name, sa->name) != 0) {
+        return 0;
+    }
+
+    stat_val = (uint8_t *)hdr + stat_off;
+    if (hdr->s_type == STATS_TYPE_SHARD) {
+        sa->val = stats_shard_sum(stat_val);
+    } else if (hdr->s_type == STATS_TYPE_CNT &&
+               hdr->s_size == sizeof (uint32_t)) {
+        sa->val = *(uint32_t *)stat_val;
+    } else if (hdr->s_type == STATS_TYPE_CNT &&
+               hdr->s_size == sizeof (uint16_t)) {
+        sa->val = *(uint16_t *)stat_val;
+    } else {
+        return 1;
+    }
+
+    sa->found = 1;
+    return 1;
+}
+
+/**
+ * Reads the controller's count of data PDUs that had to be retransmitted.
+ * The counter is only reachable when the controller runs in this image and
+ * statistic names are compiled in.
+ */
+static int
+bletiny_bench_ll_txf(uint32_t *out_val)
+{
+    struct bletiny_bench_stat_arg sa;
+    struct stats_hdr *hdr;
+
+    hdr = stats_group_find("ble_ll_conn");
+    if (hdr == NULL) {
+        return BLE_HS_ENOENT;
+    }
+
+    sa.name = "data_pdu_txf";
+    sa.found = 0;
+    stats_walk(hdr, bletiny_bench_stat_walk, &sa);
+    if (!sa.found) {
+        return BLE_HS_ENOENT;
+    }
+
+    *out_val = sa.val;
+    return 0;
+}
+
+static int
+bletiny_bench_cmp_u32(const void *a, const void *b)
+{
+    uint32_t ua;
+    uint32_t ub;
+
+    ua = *(const uint32_t *)a;
+    ub = *(const uint32_t *)b;
+
+    if (ua < ub) {
+        return -1;
+    }
+    if (ua > ub) {
+        return 1;
+    }
+    return 0;
+}
+
+static unsigned long
+bletiny_bench_rate(uint32_t bytes, os_time_t ticks)
+{
+    if (ticks == 0) {
+        return 0;
+    }
+
+    return (unsigned long)((uint64_t)bytes * OS_TICKS_PER_SEC / ticks);
+}
+
+static unsigned long
+bletiny_bench_ms(os_time_t ticks)
+{
+    return (unsigned long)((uint64_t)ticks * 1000 / OS_TICKS_PER_SEC);
+}
+
+void
+bletiny_bench_report(void)
+{
+    uint32_t samples[BLETINY_BENCH_RTT_MAX];
+    os_time_t elapsed;
+    os_time_t idle;
+    os_time_t now;
+    uint32_t txf;
+    int num_samples;
+
+    if (!bletiny_bench.active && bletiny_bench.stop == 0) {
+        console_printf("no benchmark results\n");
+        return;
+    }
+
+    now = os_time_get();
+    if (bletiny_bench.active) {
+        elapsed = now - bletiny_bench.start;
+        idle = g_idle_task.t_run_time - bletiny_bench.idle_start;
+    } else {
+        elapsed = bletiny_bench.stop - bletiny_bench.start;
+        idle = bletiny_bench.idle_stop - bletiny_bench.idle_start;
+    }
+
+    console_printf("bench %s; type=%s conn=%d len=%d elapsed_ms=%lu\n",
+                   bletiny_bench.active ? "running" : "complete",
+                   bletiny_bench_type_names[bletiny_bench.params.type],
+                   bletiny_bench.params.conn_handle, bletiny_bench.params.len,
+                   bletiny_bench_ms(elapsed));
+
+    if (bletiny_bench.params.type != BLETINY_BENCH_TYPE_RX) {
+        console_printf("    tx: pkts=%lu bytes=%lu Bps=%lu stalls=%lu "
+                       "errs=%lu\n",
+                       (unsigned long)bletiny_bench.tx_pkts,
+                       (unsigned long)bletiny_bench.tx_bytes,
+                       bletiny_bench_rate(bletiny_bench.tx_bytes, elapsed),
+                       (unsigned long)bletiny_bench.tx_stalls,
+                       (unsigned long)bletiny_bench.tx_errs);
+    }
+
+    if (bletiny_bench.rx_pkts != 0) {
+        console_printf("    rx: pkts=%lu bytes=%lu Bps=%lu lost=%lu\n",
+                       (unsigned long)bletiny_bench.rx_pkts,
+                       (unsigned long)bletiny_bench.rx_bytes,
+                       bletiny_bench_rate(bletiny_bench.rx_bytes,
+                                          bletiny_bench.rx_last -
+                                          bletiny_bench.rx_first),
+                       (unsigned long)bletiny_bench.rx_lost);
+    }
+
+    if (bletiny_bench.rtt_cnt != 0) {
+        num_samples = min(bletiny_bench.rtt_cnt, BLETINY_BENCH_RTT_MAX);
+        memcpy(samples, bletiny_bench.rtt_samples,
+               num_samples * sizeof samples[0]);
+        qsort(samples, num_samples, sizeof samples[0], bletiny_bench_cmp_u32);
+
+        console_printf("    rtt_us: n=%lu min=%lu avg=%lu p50=%lu p90=%lu "
+                       "p99=%lu max=%lu\n",
+                       (unsigned long)bletiny_bench.rtt_cnt,
+                       (unsigned long)bletiny_bench.rtt_min,
+                       (unsigned long)(bletiny_bench.rtt_sum /
+                                       bletiny_bench.rtt_cnt),
+                       (unsigned long)samples[num_samples * 50 / 100],
+                       (unsigned long)samples[num_samples * 90 / 100],
+                       (unsigned long)samples[num_samples * 99 / 100],
+                       (unsigned long)bletiny_bench.rtt_max);
+    }
+
+    console_printf("    ll_retx=");
+    if (bletiny_bench.ll_txf_valid) {
+        if (bletiny_bench.active) {
+            bletiny_bench_ll_txf(&txf);
+        } else {
+            txf = bletiny_bench.ll_txf_stop;
+        }
+        console_printf("%lu",
+                       (unsigned long)(txf - bletiny_bench.ll_txf_start));
+    } else {
+        console_printf("n/a");
+    }
+
+    if (elapsed != 0 && idle <= elapsed) {
+        console_printf(" cpu=%lu%%",
+                       (unsigned long)(100 -
+                                       (uint64_t)idle * 100 / elapsed));
+    }
+    console_printf("\n");
+}
+
+static void
+bletiny_bench_finish(void)
+{
+    if (!bletiny_bench.active) {
+        return;
+    }
+
+    os_callout_stop(&bletiny_bench_timer);
+
+    bletiny_bench.stop = os_time_get();
+    bletiny_bench.idle_stop = g_idle_task.t_run_time;
+    if (bletiny_bench.ll_txf_valid) {
+        bletiny_bench_ll_txf(&bletiny_bench.ll_txf_stop);
+    }
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+    if (bletiny_bench.coc_chan != NULL) {
+        ble_l2cap_disconnect(bletiny_bench.coc_chan);
+        bletiny_bench.coc_chan = NULL;
+    }
+#endif
+
+    bletiny_bench.active = 0;
+    bletiny_bench_report();
+}
+
+static os_time_t
+bletiny_bench_duration_ticks(void)
+{
+    uint32_t ticks;
+    int rc;
+
+    rc = os_time_ms_to_ticks(bletiny_bench.params.duration_ms, &ticks);
+    if (rc != 0) {
+        return UINT32_MAX / 2;
+    }
+
+    return ticks;
+}
+
+static int
+bletiny_bench_expired(void)
+{
+    if (bletiny_bench.params.duration_ms == 0) {
+        return 0;
+    }
+
+    return OS_TIME_TICK_GEQ(os_time_get(), bletiny_bench.start +
+                                           bletiny_bench_duration_ticks());
+}
+
+static void
+bletiny_bench_rx_count(struct os_mbuf *om)
+{
+    uint8_t buf[BLETINY_BENCH_SEQ_LEN];
+    uint32_t seq;
+    int rc;
+
+    bletiny_bench.rx_last = os_time_get();
+    if (bletiny_bench.rx_pkts == 0) {
+        bletiny_bench.rx_first = bletiny_bench.rx_last;
+    }
+
+    bletiny_bench.rx_pkts++;
+    bletiny_bench.rx_bytes += OS_MBUF_PKTLEN(om);
+
+    rc = os_mbuf_copydata(om, 0, sizeof buf, buf);
+    if (rc != 0) {
+        return;
+    }
+
+    seq = le32toh(buf);
+    if ((int32_t)(seq - bletiny_bench.rx_next_seq) > 0) {
+        bletiny_bench.rx_lost += seq - bletiny_bench.rx_next_seq;
+    }
+    bletiny_bench.rx_next_seq = seq + 1;
+}
+
+/**
+ * Counts a packet received by the benchmark's GATT characteristic or in a
+ * notification.
+ *
+ * @return                      0 if a receive benchmark is running on the
+ *                                  connection and the packet was counted;
+ *                              BLE_HS_ENOENT otherwise.
+ */
+int
+bletiny_bench_rx(uint16_t conn_handle, struct os_mbuf *om)
+{
+    if (!bletiny_bench.active ||
+        bletiny_bench.params.type != BLETINY_BENCH_TYPE_RX ||
+        bletiny_bench.params.conn_handle != conn_handle) {
+
+        return BLE_HS_ENOENT;
+    }
+
+    bletiny_bench_rx_count(om);
+    return 0;
+}
+
+/**
+ * Indicates whether the benchmark is streaming on the specified connection;
+ * the application suppresses per-packet console output while it is.
+ */
+int
+bletiny_bench_busy(uint16_t conn_handle)
+{
+    return bletiny_bench.active &&
+           bletiny_bench.params.conn_handle == conn_handle;
+}
+
+void
+bletiny_bench_conn_lost(uint16_t conn_handle)
+{
+    if (bletiny_bench_busy(conn_handle)) {
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+        /* The channel is gone along with the connection. */
+        bletiny_bench.coc_chan = NULL;
+#endif
+        bletiny_bench_finish();
+    }
+}
+
+static struct os_mbuf *
+bletiny_bench_pkt(void)
+{
+    static const uint8_t pattern[16] = {
+        0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+        0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff,
+    };
+    uint8_t seq[BLETINY_BENCH_SEQ_LEN];
+    struct os_mbuf *om;
+    int chunk;
+    int rem;
+    int rc;
+
+    om = ble_hs_mbuf_att_pkt();
+    if (om == NULL) {
+        return NULL;
+    }
+
+    htole32(seq, bletiny_bench.tx_seq);
+    rc = os_mbuf_append(om, seq, sizeof seq);
+    if (rc != 0) {
+        goto err;
+    }
+
+    rem = bletiny_bench.params.len - sizeof seq;
+    while (rem > 0) {
+        chunk = min(rem, sizeof pattern);
+        rc = os_mbuf_append(om, pattern, chunk);
+        if (rc != 0) {
+            goto err;
+        }
+        rem -= chunk;
+    }
+
+    return om;
+
+err:
+    os_mbuf_free_chain(om);
+    return NULL;
+}
+
+static int
+bletiny_bench_on_read(uint16_t conn_handle, const struct ble_gatt_error *error,
+                      struct ble_gatt_attr *attr, void *arg)
+{
+    uint32_t rtt;
+    uint32_t idx;
+
+    if (!bletiny_bench.active) {
+        return 0;
+    }
+
+    bletiny_bench.read_pending = 0;
+
+    if (error->status != 0) {
+        bletiny_bench.tx_errs++;
+        if (error->status == BLE_HS_ENOTCONN) {
+            bletiny_bench_finish();
+            return 0;
+        }
+    } else {
+        rtt = os_cputime_ticks_to_usecs(os_cputime_get32() -
+                                        bletiny_bench.read_start);
+
+        bletiny_bench.tx_pkts++;
+        bletiny_bench.rx_last = os_time_get();
+        if (bletiny_bench.rx_pkts == 0) {
+            bletiny_bench.rx_first = bletiny_bench.start;
+        }
+        bletiny_bench.rx_pkts++;
+        bletiny_bench.rx_bytes += OS_MBUF_PKTLEN(attr->om);
+
+        /* Keep a uniform random sample of all round trips so that
+         * percentiles cover the whole run.
+         */
+        if (bletiny_bench.rtt_cnt < BLETINY_BENCH_RTT_MAX) {
+            idx = bletiny_bench.rtt_cnt;
+        } else {
+            idx = (uint32_t)rand() % (bletiny_bench.rtt_cnt + 1);
+        }
+        if (idx < BLETINY_BENCH_RTT_MAX) {
+            bletiny_bench.rtt_samples[idx] = rtt;
+        }
+
+        if (bletiny_bench.rtt_cnt == 0 || rtt < bletiny_bench.rtt_min) {
+            bletiny_bench.rtt_min = rtt;
+        }
+        if (rtt > bletiny_bench.rtt_max) {
+            bletiny_bench.rtt_max = rtt;
+        }
+        bletiny_bench.rtt_sum += rtt;
+        bletiny_bench.rtt_cnt++;
+    }
+
+    os_callout_reset(&bletiny_bench_timer, 0);
+    return 0;
+}
+
+static int
+bletiny_bench_read_next(void)
+{
+    int rc;
+
+    if (bletiny_bench.read_pending) {
+        return 0;
+    }
+
+    bletiny_bench.read_start = os_cputime_get32();
+    rc = ble_gattc_read(bletiny_bench.params.conn_handle,
+                        bletiny_bench.params.attr_handle,
+                        bletiny_bench_on_read, NULL);
+    if (rc != 0) {
+        return rc;
+    }
+
+    bletiny_bench.read_pending = 1;
+    return 0;
+}
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+
+static int
+bletiny_bench_coc_rx_ready(struct ble_l2cap_chan *chan)
+{
+    struct os_mbuf *sdu_rx;
+
+    sdu_rx = os_msys_get_pkthdr(0, 0);
+    if (sdu_rx == NULL) {
+        return BLE_HS_ENOMEM;
+    }
+
+    return ble_l2cap_recv_ready(chan, sdu_rx);
+}
+
+static int
+bletiny_bench_coc_event(struct ble_l2cap_event *event, void *arg)
+{
+    switch (event->type) {
+    case BLE_L2CAP_EVENT_COC_CONNECTED:
+        if (event->connect.status != 0) {
+            console_printf("bench: coc connect failed; status=%d\n",
+                           event->connect.status);
+            bletiny_bench.coc_chan = NULL;
+            bletiny_bench_finish();
+            return 0;
+        }
+
+        bletiny_bench.coc_chan = event->chan;
+        if (bletiny_bench.params.type != BLETINY_BENCH_TYPE_RX) {
+            bletiny_bench.start = os_time_get();
+            bletiny_bench.idle_start = g_idle_task.t_run_time;
+            os_callout_reset(&bletiny_bench_timer, 0);
+        }
+        return 0;
+
+    case BLE_L2CAP_EVENT_COC_DISCONNECTED:
+        if (event->chan == bletiny_bench.coc_chan) {
+            bletiny_bench.coc_chan = NULL;
+            if (bletiny_bench.params.type != BLETINY_BENCH_TYPE_RX) {
+                bletiny_bench_finish();
+            }
+        }
+        return 0;
+
+    case BLE_L2CAP_EVENT_COC_ACCEPT:
+        if (!bletiny_bench.active ||
+            bletiny_bench.params.type != BLETINY_BENCH_TYPE_RX ||
+            bletiny_bench.params.conn_handle != event->conn_handle ||
+            bletiny_bench.coc_chan != NULL) {
+
+            return BLE_HS_EREJECT;
+        }
+
+        bletiny_bench.coc_chan = event->chan;
+        return bletiny_bench_coc_rx_ready(event->chan);
+
+    case BLE_L2CAP_EVENT_COC_DATA_RECEIVED:
+        if (bletiny_bench.active) {
+            bletiny_bench_rx_count(event->receive.sdu_rx);
+        }
+        os_mbuf_free_chain(event->receive.sdu_rx);
+        bletiny_bench_coc_rx_ready(event->chan);
+        return 0;
+
+    case BLE_L2CAP_EVENT_COC_TX_UNSTALLED:
+        bletiny_bench.coc_stalled = 0;
+        if (event->tx_unstalled.status != 0) {
+            bletiny_bench.tx_errs++;
+        }
+        if (bletiny_bench.active) {
+            os_callout_reset(&bletiny_bench_timer, 0);
+        }
+        return 0;
+
+    default:
+        return 0;
+    }
+}
+
+#endif
+
+/**
+ * Queues a packet on the benchmark's transport.  The buffer is consumed.
+ */
+static int
+bletiny_bench_tx(struct os_mbuf *om)
+{
+    switch (bletiny_bench.params.type) {
+    case BLETINY_BENCH_TYPE_NOTIFY:
+        return ble_gattc_notify_custom(bletiny_bench.params.conn_handle,
+                                       bletiny_bench.params.attr_handle, om);
+
+    case BLETINY_BENCH_TYPE_WRITE:
+        return ble_gattc_write_no_rsp(bletiny_bench.params.conn_handle,
+                                      bletiny_bench.params.attr_handle, om);
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+    case BLETINY_BENCH_TYPE_COC:
+        return ble_l2cap_send(bletiny_bench.coc_chan, om);
+#endif
+
+    default:
+        os_mbuf_free_chain(om);
+        return BLE_HS_EINVAL;
+    }
+}
+
+static void
+bletiny_bench_timer_cb(struct os_event *ev)
+{
+    struct os_mbuf *om;
+    int rc;
+    int i;
+
+    if (!bletiny_bench.active) {
+        return;
+    }
+
+    if (bletiny_bench_expired()) {
+        bletiny_bench_finish();
+        return;
+    }
+
+    switch (bletiny_bench.params.type) {
+    case BLETINY_BENCH_TYPE_RX:
+        /* Only wakes up to end the run. */
+        os_callout_reset(&bletiny_bench_timer, OS_TICKS_PER_SEC);
+        return;
+
+    case BLETINY_BENCH_TYPE_READ:
+        rc = bletiny_bench_read_next();
+        if (rc == BLE_HS_ENOMEM) {
+            bletiny_bench.tx_stalls++;
+            os_callout_reset(&bletiny_bench_timer, 1);
+        } else if (rc != 0) {
+            console_printf("bench: read failed; rc=%d\n", rc);
+            bletiny_bench_finish();
+        }
+        return;
+
+    case BLETINY_BENCH_TYPE_COC:
+        if (bletiny_bench.coc_stalled) {
+            /* Resumed by the unstalled event; check back for the deadline. */
+            os_callout_reset(&bletiny_bench_timer, OS_TICKS_PER_SEC / 10 + 1);
+            return;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    for (i = 0; i < BLETINY_BENCH_BURST; i++) {
+        om = bletiny_bench_pkt();
+        if (om == NULL) {
+            bletiny_bench.tx_stalls++;
+            os_callout_reset(&bletiny_bench_timer, 1);
+            return;
+        }
+
+        rc = bletiny_bench_tx(om);
+        switch (rc) {
+        case 0:
+        case BLE_HS_ESTALLED:
+            bletiny_bench.tx_seq++;
+            bletiny_bench.tx_pkts++;
+            bletiny_bench.tx_bytes += bletiny_bench.params.len;
+            if (rc == BLE_HS_ESTALLED) {
+                bletiny_bench.tx_stalls++;
+                bletiny_bench.coc_stalled = 1;
+                os_callout_reset(&bletiny_bench_timer,
+                                 OS_TICKS_PER_SEC / 10 + 1);
+                return;
+            }
+            break;
+
+        case BLE_HS_ENOMEM:
+            bletiny_bench.tx_stalls++;
+            os_callout_reset(&bletiny_bench_timer, 1);
+            return;
+
+        default:
+            bletiny_bench.tx_errs++;
+            console_printf("bench: tx failed; rc=%d\n", rc);
+            bletiny_bench_finish();
+            return;
+        }
+    }
+
+    /* Yield to other events before queueing the next burst. */
+    os_callout_reset(&bletiny_bench_timer, 0);
+}
+
+int
+bletiny_bench_start(const struct bletiny_bench_params *params)
+{
+    uint16_t mtu;
+    int rc;
+
+    if (bletiny_bench.active) {
+        return BLE_HS_EALREADY;
+    }
+
+    if (params->type != BLETINY_BENCH_TYPE_RX || params->psm == 0) {
+        mtu = ble_att_mtu(params->conn_handle);
+        if (mtu == 0) {
+            return BLE_HS_ENOTCONN;
+        }
+    } else {
+        mtu = 0;
+    }
+
+    memset(&bletiny_bench, 0, sizeof bletiny_bench);
+    bletiny_bench.params = *params;
+
+    switch (params->type) {
+    case BLETINY_BENCH_TYPE_NOTIFY:
+        if (bletiny_bench.params.attr_handle == 0) {
+            bletiny_bench.params.attr_handle = gatt_svr_bench_val_handle;
+        }
+        /* Fall through. */
+    case BLETINY_BENCH_TYPE_WRITE:
+        if (bletiny_bench.params.attr_handle == 0) {
+            return BLE_HS_EINVAL;
+        }
+        if (bletiny_bench.params.len == 0) {
+            bletiny_bench.params.len = mtu - 3;
+        }
+        if (bletiny_bench.params.len < BLETINY_BENCH_SEQ_LEN ||
+            bletiny_bench.params.len > mtu - 3) {
+
+            return BLE_HS_EINVAL;
+        }
+        break;
+
+    case BLETINY_BENCH_TYPE_READ:
+        if (bletiny_bench.params.attr_handle == 0) {
+            return BLE_HS_EINVAL;
+        }
+        break;
+
+    case BLETINY_BENCH_TYPE_COC:
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+        if (bletiny_bench.params.psm == 0) {
+            return BLE_HS_EINVAL;
+        }
+        if (bletiny_bench.params.len == 0) {
+            bletiny_bench.params.len = min(MYNEWT_VAL(BLE_L2CAP_COC_MPS),
+                                           BLETINY_BENCH_COC_MTU);
+        }
+        if (bletiny_bench.params.len < BLETINY_BENCH_SEQ_LEN ||
+            bletiny_bench.params.len > BLETINY_BENCH_COC_MTU) {
+
+            return BLE_HS_EINVAL;
+        }
+        break;
+#else
+        return BLE_HS_ENOTSUP;
+#endif
+
+    case BLETINY_BENCH_TYPE_RX:
+        break;
+
+    default:
+        return BLE_HS_EINVAL;
+    }
+
+    bletiny_bench.active = 1;
+    bletiny_bench.start = os_time_get();
+    bletiny_bench.idle_start = g_idle_task.t_run_time;
+    bletiny_bench.ll_txf_valid =
+        bletiny_bench_ll_txf(&bletiny_bench.ll_txf_start) == 0;
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+    if (params->type == BLETINY_BENCH_TYPE_COC) {
+        /* The stream starts once the channel is connected. */
+        rc = ble_l2cap_connect(params->conn_handle, params->psm,
+                               BLETINY_BENCH_COC_MTU,
+                               os_msys_get_pkthdr(0, 0),
+                               bletiny_bench_coc_event, NULL);
+        if (rc != 0) {
+            bletiny_bench.active = 0;
+            return rc;
+        }
+        return 0;
+    }
+
+    if (params->type == BLETINY_BENCH_TYPE_RX && params->psm != 0) {
+        rc = ble_l2cap_create_server(params->psm,
+                                     BLETINY_BENCH_COC_MTU,
+                                     bletiny_bench_coc_event, NULL);
+        if (rc != 0 && rc != BLE_HS_EALREADY) {
+            bletiny_bench.active = 0;
+            return rc;
+        }
+    }
+#endif
+
+    rc = 0;
+    if (params->type == BLETINY_BENCH_TYPE_RX) {
+        if (params->duration_ms != 0) {
+            os_callout_reset(&bletiny_bench_timer,
+                             bletiny_bench_duration_ticks());
+        }
+    } else {
+        os_callout_reset(&bletiny_bench_timer, 0);
+    }
+
+    return rc;
+}
+
+int
+bletiny_bench_stop(void)
+{
+    if (!bletiny_bench.active) {
+        return BLE_HS_EALREADY;
+    }
+
+    bletiny_bench_finish();
+    return 0;
+}
+
+void
+bletiny_bench_init(void)
+{
+    os_callout_init(&bletiny_bench_timer, &bletiny_evq,
+                    bletiny_bench_timer_cb, NULL);
+}
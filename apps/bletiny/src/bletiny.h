@@ -42,6 +42,8 @@ union ble_store_key;
 struct ble_gap_adv_params;
 struct ble_gap_conn_desc;
 struct ble_gap_disc_params;
+struct ble_gap_conn_tput;
+struct ble_gap_conn_perf;
 
 typedef int cmd_fn(int argc, char **argv);
 struct cmd_entry {
@@ -87,6 +89,8 @@ extern int bletiny_num_conns;
 
 extern uint16_t nm_attr_val_handle;
 
+extern struct os_eventq bletiny_evq;
+
 extern struct log bletiny_log;
 
 const struct cmd_entry *parse_cmd_find(const struct cmd_entry *cmds,
@@ -172,6 +176,10 @@ int bletiny_update_conn(uint16_t conn_handle,
 void bletiny_chrup(uint16_t attr_handle);
 int bletiny_datalen(uint16_t conn_handle, uint16_t tx_octets,
                     uint16_t tx_time);
+int bletiny_tput_tune(uint16_t conn_handle, uint16_t itvl);
+int bletiny_tput(uint16_t conn_handle, struct ble_gap_conn_tput *out_tput);
+int bletiny_perf(uint16_t conn_handle, int reset,
+                 struct ble_gap_conn_perf *out_perf);
 int bletiny_l2cap_update(uint16_t conn_handle,
                           struct ble_l2cap_sig_update_params *params);
 int bletiny_sec_start(uint16_t conn_handle);
@@ -194,6 +202,8 @@ int bletiny_rssi(uint16_t conn_handle, int8_t *out_rssi);
 #define GATT_SVR_CHR_UNR_ALERT_STAT_UUID      0x2A45
 #define GATT_SVR_CHR_ALERT_NOT_CTRL_PT        0x2A44
 
+extern uint16_t gatt_svr_bench_val_handle;
+
 void gatt_svr_register_cb(struct ble_gatt_register_ctxt *ctxt, void *arg);
 int gatt_svr_init(void);
 
@@ -208,6 +218,42 @@ uint16_t chr_end_handle(const struct bletiny_svc *svc,
 int chr_is_empty(const struct bletiny_svc *svc, const struct bletiny_chr *chr);
 void print_conn_desc(const struct ble_gap_conn_desc *desc);
 
+/** Benchmark. */
+#define BLETINY_BENCH_TYPE_NOTIFY       0
+#define BLETINY_BENCH_TYPE_WRITE        1
+#define BLETINY_BENCH_TYPE_READ         2
+#define BLETINY_BENCH_TYPE_COC          3
+#define BLETINY_BENCH_TYPE_RX           4
+
+struct bletiny_bench_params {
+    /** One of the BLETINY_BENCH_TYPE_[...] codes. */
+    uint8_t type;
+    uint16_t conn_handle;
+
+    /**
+     * Attribute to notify, write or read.  0 selects the local benchmark
+     * characteristic for notifications.
+     */
+    uint16_t attr_handle;
+
+    /** Payload size; 0 selects the largest that fits in one PDU. */
+    uint16_t len;
+
+    /** L2CAP PSM for the coc type, and for rx over a channel. */
+    uint16_t psm;
+
+    /** Run time; 0 runs until stopped (rx type only). */
+    uint32_t duration_ms;
+};
+
+void bletiny_bench_init(void);
+int bletiny_bench_start(const struct bletiny_bench_params *params);
+int bletiny_bench_stop(void);
+void bletiny_bench_report(void);
+int bletiny_bench_rx(uint16_t conn_handle, struct os_mbuf *om);
+int bletiny_bench_busy(uint16_t conn_handle);
+void bletiny_bench_conn_lost(uint16_t conn_handle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -481,6 +481,114 @@ cmd_conn(int argc, char **argv)
     return 0;
 }
 
+/*****************************************************************************
+ * $bench                                                                    *
+ *****************************************************************************/
+
+static struct kv_pair cmd_bench_types[] = {
+    { "notify",     BLETINY_BENCH_TYPE_NOTIFY },
+    { "write",      BLETINY_BENCH_TYPE_WRITE },
+    { "read",       BLETINY_BENCH_TYPE_READ },
+    { "coc",        BLETINY_BENCH_TYPE_COC },
+    { "rx",         BLETINY_BENCH_TYPE_RX },
+    { NULL }
+};
+
+static int
+cmd_bench_start(int argc, char **argv)
+{
+    struct bletiny_bench_params params;
+    uint16_t dur;
+    int rc;
+
+    memset(&params, 0, sizeof params);
+
+    params.conn_handle = parse_arg_uint16("conn", &rc);
+    if (rc != 0) {
+        return rc;
+    }
+
+    params.type = parse_arg_kv("type", cmd_bench_types, &rc);
+    if (rc != 0) {
+        return rc;
+    }
+
+    params.attr_handle = parse_arg_uint16_dflt("attr", 0, &rc);
+    if (rc != 0) {
+        return rc;
+    }
+
+    params.len = parse_arg_uint16_dflt("len", 0, &rc);
+    if (rc != 0) {
+        return rc;
+    }
+
+    params.psm = parse_arg_uint16_dflt("psm", 0, &rc);
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* Receivers run until stopped unless told otherwise. */
+    dur = parse_arg_uint16_dflt(
+        "dur", params.type == BLETINY_BENCH_TYPE_RX ? 0 : 10, &rc);
+    if (rc != 0) {
+        return rc;
+    }
+    if (dur == 0 && params.type != BLETINY_BENCH_TYPE_RX) {
+        return EINVAL;
+    }
+    params.duration_ms = dur * 1000UL;
+
+    rc = bletiny_bench_start(&params);
+    if (rc != 0) {
+        console_printf("error starting benchmark; rc=%d\n", rc);
+        return rc;
+    }
+
+    return 0;
+}
+
+static int
+cmd_bench_stop(int argc, char **argv)
+{
+    int rc;
+
+    rc = bletiny_bench_stop();
+    if (rc != 0) {
+        console_printf("no benchmark running\n");
+        return rc;
+    }
+
+    return 0;
+}
+
+static int
+cmd_bench_show(int argc, char **argv)
+{
+    bletiny_bench_report();
+    return 0;
+}
+
+static const struct cmd_entry cmd_bench_entries[] = {
+    { "start",  cmd_bench_start },
+    { "stop",   cmd_bench_stop },
+    { "show",   cmd_bench_show },
+    { NULL, NULL }
+};
+
+static int
+cmd_bench(int argc, char **argv)
+{
+    int rc;
+
+    rc = cmd_exec(cmd_bench_entries, argc, argv);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return 0;
+}
+
 /*****************************************************************************
  * $chrup                                                                    *
  *****************************************************************************/
@@ -2276,12 +2384,144 @@ cmd_tx(int argc, char **argv)
     return rc;
 }
 
+/*****************************************************************************
+ * $tput                                                                     *
+ *****************************************************************************/
+
+static int
+cmd_tput(int argc, char **argv)
+{
+    struct ble_gap_conn_tput tput;
+    uint16_t conn_handle;
+    uint16_t itvl;
+    int tune;
+    int rc;
+
+    conn_handle = parse_arg_uint16("conn", &rc);
+    if (rc != 0) {
+        return rc;
+    }
+
+    tune = parse_arg_bool_default("tune", 0, &rc);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (tune) {
+        itvl = parse_arg_uint16_dflt("itvl", BLE_HCI_CONN_ITVL_MIN, &rc);
+        if (rc != 0) {
+            return rc;
+        }
+
+        rc = bletiny_tput_tune(conn_handle, itvl);
+        if (rc != 0) {
+            console_printf("error tuning connection; rc=%d\n", rc);
+            return rc;
+        }
+    }
+
+    rc = bletiny_tput(conn_handle, &tput);
+    if (rc != 0) {
+        console_printf("error reading throughput; rc=%d\n", rc);
+        return rc;
+    }
+
+    console_printf("conn=%d tx_bps=%lu rx_bps=%lu mtu=%d itvl=%d\n",
+                   conn_handle, (unsigned long)tput.tx_bps,
+                   (unsigned long)tput.rx_bps, tput.mtu, tput.itvl);
+
+    return 0;
+}
+
+/*****************************************************************************
+ * $perf                                                                     *
+ *****************************************************************************/
+
+/* Per mille of num in total, for printing error and empty ratios. */
+static unsigned long
+cmd_perf_ratio(uint32_t num, uint32_t total)
+{
+    if (total == 0) {
+        return 0;
+    }
+    return (uint64_t)num * 1000 / total;
+}
+
+static int
+cmd_perf(int argc, char **argv)
+{
+    struct ble_gap_conn_perf perf;
+    uint16_t conn_handle;
+    int reset;
+    int rc;
+
+    conn_handle = parse_arg_uint16("conn", &rc);
+    if (rc != 0) {
+        return rc;
+    }
+
+    reset = parse_arg_bool_default("reset", 0, &rc);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = bletiny_perf(conn_handle, reset, &perf);
+    if (rc != 0) {
+        console_printf("error reading link statistics; rc=%d\n", rc);
+        return rc;
+    }
+
+    if (perf.ctlr_valid) {
+        console_printf("conn=%d rssi=%d rssi_avg=%d events=%lu skipped=%lu\n",
+                       conn_handle, perf.ctlr_rssi, perf.ctlr_rssi_avg,
+                       (unsigned long)perf.ctlr_events,
+                       (unsigned long)perf.ctlr_events_skipped);
+        console_printf("    rx_ok=%lu crc_err=%lu (%lu/1000) "
+                       "empty=%lu (%lu/1000)\n",
+                       (unsigned long)perf.ctlr_rx_ok,
+                       (unsigned long)perf.ctlr_rx_crc_err,
+                       cmd_perf_ratio(perf.ctlr_rx_crc_err,
+                                      perf.ctlr_rx_ok + perf.ctlr_rx_crc_err),
+                       (unsigned long)perf.ctlr_rx_empty,
+                       cmd_perf_ratio(perf.ctlr_rx_empty, perf.ctlr_rx_ok));
+        console_printf("    tx_ack=%lu retry=%lu (%lu/1000) "
+                       "empty=%lu (%lu/1000)\n",
+                       (unsigned long)perf.ctlr_tx_ack,
+                       (unsigned long)perf.ctlr_tx_retry,
+                       cmd_perf_ratio(perf.ctlr_tx_retry,
+                                      perf.ctlr_tx_ack + perf.ctlr_tx_retry),
+                       (unsigned long)perf.ctlr_tx_empty,
+                       cmd_perf_ratio(perf.ctlr_tx_empty, perf.ctlr_tx_ack));
+        console_printf("    tx_pkts=%lu lat_avg=%luus lat_max=%luus\n",
+                       (unsigned long)perf.ctlr_tx_pkts,
+                       (unsigned long)perf.ctlr_tx_lat_avg,
+                       (unsigned long)perf.ctlr_tx_lat_max);
+    } else {
+        console_printf("conn=%d controller statistics not available\n",
+                       conn_handle);
+    }
+
+    if (perf.host_valid) {
+        console_printf("    host tx_frags=%lu no_credit=%lu "
+                       "comp_lat_avg=%lums comp_lat_max=%lums "
+                       "outstanding=%d max_outstanding=%d\n",
+                       (unsigned long)perf.host_tx_frags,
+                       (unsigned long)perf.host_tx_no_credit,
+                       (unsigned long)perf.host_comp_lat_avg,
+                       (unsigned long)perf.host_comp_lat_max,
+                       perf.host_outstanding, perf.host_max_outstanding);
+    }
+
+    return 0;
+}
+
 /*****************************************************************************
  * $init                                                                     *
  *****************************************************************************/
 
 static struct cmd_entry cmd_b_entries[] = {
     { "adv",        cmd_adv },
+    { "bench",      cmd_bench },
     { "conn",       cmd_conn },
     { "chrup",      cmd_chrup },
     { "datalen",    cmd_datalen },
@@ -2290,6 +2530,7 @@ static struct cmd_entry cmd_b_entries[] = {
     { "l2cap",      cmd_l2cap },
     { "mtu",        cmd_mtu },
     { "passkey",    cmd_passkey },
+    { "perf",       cmd_perf },
     { "read",       cmd_read },
     { "rssi",       cmd_rssi },
     { "scan",       cmd_scan },
@@ -2298,6 +2539,7 @@ static struct cmd_entry cmd_b_entries[] = {
     { "set",        cmd_set },
     { "store",      cmd_keystore },
     { "term",       cmd_term },
+    { "tput",       cmd_tput },
     { "update",     cmd_update },
     { "tx",         cmd_tx },
     { "wl",         cmd_wl },
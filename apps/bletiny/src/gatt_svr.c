@@ -54,6 +54,27 @@ const uint8_t gatt_svr_chr_sec_test_static_uuid[16] = {
 
 static uint8_t gatt_svr_sec_test_static_val;
 
+/**
+ * The vendor specific benchmark service has a single characteristic that
+ * accepts writes without response, sends notifications and can be read.  The
+ * "b bench" command streams to and from it.
+ */
+
+/* 0b0a5f30-2b51-4d3e-9a4b-52a5f1d5e8a0 */
+const uint8_t gatt_svr_svc_bench_uuid[16] = {
+    0xa0, 0xe8, 0xd5, 0xf1, 0xa5, 0x52, 0x4b, 0x9a,
+    0x3e, 0x4d, 0x51, 0x2b, 0x30, 0x5f, 0x0a, 0x0b
+};
+
+/* 0b0a5f31-2b51-4d3e-9a4b-52a5f1d5e8a0 */
+const uint8_t gatt_svr_chr_bench_uuid[16] = {
+    0xa0, 0xe8, 0xd5, 0xf1, 0xa5, 0x52, 0x4b, 0x9a,
+    0x3e, 0x4d, 0x51, 0x2b, 0x31, 0x5f, 0x0a, 0x0b
+};
+
+uint16_t gatt_svr_bench_val_handle;
+static uint32_t gatt_svr_bench_reads;
+
 static int
 gatt_svr_chr_access_alert(uint16_t conn_handle, uint16_t attr_handle,
                           struct ble_gatt_access_ctxt *ctxt,
@@ -64,6 +85,11 @@ gatt_svr_chr_access_sec_test(uint16_t conn_handle, uint16_t attr_handle,
                              struct ble_gatt_access_ctxt *ctxt,
                              void *arg);
 
+static int
+gatt_svr_chr_access_bench(uint16_t conn_handle, uint16_t attr_handle,
+                          struct ble_gatt_access_ctxt *ctxt,
+                          void *arg);
+
 static const struct ble_gatt_svc_def gatt_svr_svcs[] = {
     {
         /*** Alert Notification Service. */
@@ -114,6 +140,21 @@ static const struct ble_gatt_svc_def gatt_svr_svcs[] = {
         } },
     },
 
+    {
+        /*** Service: Benchmark. */
+        .type = BLE_GATT_SVC_TYPE_PRIMARY,
+        .uuid128 = gatt_svr_svc_bench_uuid,
+        .characteristics = (struct ble_gatt_chr_def[]) { {
+            .uuid128 = gatt_svr_chr_bench_uuid,
+            .access_cb = gatt_svr_chr_access_bench,
+            .val_handle = &gatt_svr_bench_val_handle,
+            .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_WRITE_NO_RSP |
+                     BLE_GATT_CHR_F_NOTIFY,
+        }, {
+            0, /* No more characteristics in this service. */
+        } },
+    },
+
     {
         0, /* No more services. */
     },
@@ -262,6 +303,32 @@ gatt_svr_chr_access_sec_test(uint16_t conn_handle, uint16_t attr_handle,
     return BLE_ATT_ERR_UNLIKELY;
 }
 
+static int
+gatt_svr_chr_access_bench(uint16_t conn_handle, uint16_t attr_handle,
+                          struct ble_gatt_access_ctxt *ctxt,
+                          void *arg)
+{
+    int rc;
+
+    switch (ctxt->op) {
+    case BLE_GATT_ACCESS_OP_READ_CHR:
+        /* Respond with the number of reads served so far. */
+        gatt_svr_bench_reads++;
+        rc = os_mbuf_append(ctxt->om, &gatt_svr_bench_reads,
+                            sizeof gatt_svr_bench_reads);
+        return rc == 0 ? 0 : BLE_ATT_ERR_INSUFFICIENT_RES;
+
+    case BLE_GATT_ACCESS_OP_WRITE_CHR:
+        /* Writes are only counted, and only while a benchmark receives. */
+        bletiny_bench_rx(conn_handle, ctxt->om);
+        return 0;
+
+    default:
+        assert(0);
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+}
+
 static char *
 gatt_svr_uuid_to_s(const void *uuid128, char *dst)
 {
@@ -284,29 +351,58 @@ gatt_svr_uuid_to_s(const void *uuid128, char *dst)
     return dst;
 }
 
+/**
+ * Returns the 128-bit form of a definition's UUID, whether the definition
+ * specifies it natively or as a byte array.
+ */
+static const void *
+gatt_svr_def_uuid128(const ble_uuid_t *uuid, const uint8_t *uuid128,
+                     uint8_t *dst)
+{
+    if (uuid != NULL) {
+        ble_uuid_to_128(uuid, dst);
+        return dst;
+    }
+
+    return uuid128;
+}
+
 void
 gatt_svr_register_cb(struct ble_gatt_register_ctxt *ctxt, void *arg)
 {
+    uint8_t uuid128[16];
     char buf[40];
 
     switch (ctxt->op) {
     case BLE_GATT_REGISTER_OP_SVC:
         BLETINY_LOG(DEBUG, "registered service %s with handle=%d\n",
-                    gatt_svr_uuid_to_s(ctxt->svc.svc_def->uuid128, buf),
+                    gatt_svr_uuid_to_s(
+                        gatt_svr_def_uuid128(ctxt->svc.svc_def->uuid,
+                                             ctxt->svc.svc_def->uuid128,
+                                             uuid128),
+                        buf),
                     ctxt->svc.handle);
         break;
 
     case BLE_GATT_REGISTER_OP_CHR:
         BLETINY_LOG(DEBUG, "registering characteristic %s with "
                            "def_handle=%d val_handle=%d\n",
-                    gatt_svr_uuid_to_s(ctxt->chr.chr_def->uuid128, buf),
+                    gatt_svr_uuid_to_s(
+                        gatt_svr_def_uuid128(ctxt->chr.chr_def->uuid,
+                                             ctxt->chr.chr_def->uuid128,
+                                             uuid128),
+                        buf),
                     ctxt->chr.def_handle,
                     ctxt->chr.val_handle);
         break;
 
     case BLE_GATT_REGISTER_OP_DSC:
         BLETINY_LOG(DEBUG, "registering descriptor %s with handle=%d\n",
-                    gatt_svr_uuid_to_s(ctxt->dsc.dsc_def->uuid128, buf),
+                    gatt_svr_uuid_to_s(
+                        gatt_svr_def_uuid128(ctxt->dsc.dsc_def->uuid,
+                                             ctxt->dsc.dsc_def->uuid128,
+                                             uuid128),
+                        buf),
                     ctxt->dsc.handle);
         break;
 
@@ -912,6 +912,8 @@ bletiny_gap_event(struct ble_gap_event *event, void *arg)
         console_printf("disconnect; reason=%d ", event->disconnect.reason);
         print_conn_desc(&event->disconnect.conn);
 
+        bletiny_bench_conn_lost(event->disconnect.conn.conn_handle);
+
         conn_idx = bletiny_conn_find_idx(event->disconnect.conn.conn_handle);
         if (conn_idx != -1) {
             bletiny_conn_delete_idx(conn_idx);
@@ -976,6 +978,11 @@ bletiny_gap_event(struct ble_gap_event *event, void *arg)
         return 0;
 
     case BLE_GAP_EVENT_NOTIFY_RX:
+        if (bletiny_bench_rx(event->notify_rx.conn_handle,
+                             event->notify_rx.om) == 0) {
+            return 0;
+        }
+
         console_printf("notification rx event; attr_handle=%d indication=%d "
                        "len=%d data=",
                        event->notify_rx.attr_handle,
@@ -987,6 +994,10 @@ bletiny_gap_event(struct ble_gap_event *event, void *arg)
         return 0;
 
     case BLE_GAP_EVENT_NOTIFY_TX:
+        if (bletiny_bench_busy(event->notify_tx.conn_handle)) {
+            return 0;
+        }
+
         console_printf("notification tx event; status=%d attr_handle=%d "
                        "indication=%d\n",
                        event->notify_tx.status,
@@ -1398,6 +1409,34 @@ bletiny_datalen(uint16_t conn_handle, uint16_t tx_octets, uint16_t tx_time)
     return rc;
 }
 
+int
+bletiny_tput_tune(uint16_t conn_handle, uint16_t itvl)
+{
+    int rc;
+
+    rc = ble_gap_tput_tune(conn_handle, itvl);
+    return rc;
+}
+
+int
+bletiny_tput(uint16_t conn_handle, struct ble_gap_conn_tput *out_tput)
+{
+    int rc;
+
+    rc = ble_gap_conn_tput(conn_handle, out_tput);
+    return rc;
+}
+
+int
+bletiny_perf(uint16_t conn_handle, int reset,
+             struct ble_gap_conn_perf *out_perf)
+{
+    int rc;
+
+    rc = ble_gap_conn_perf(conn_handle, reset, out_perf);
+    return rc;
+}
+
 int
 bletiny_l2cap_update(uint16_t conn_handle,
                      struct ble_l2cap_sig_update_params *params)
@@ -1638,6 +1677,8 @@ main(void)
     os_callout_init(&bletiny_tx_timer, &bletiny_evq, bletiny_tx_timer_cb,
                     NULL);
 
+    bletiny_bench_init();
+
     /* Set the default eventq for packages that lack a dedicated task. */
     os_eventq_dflt_set(&bletiny_evq);
 
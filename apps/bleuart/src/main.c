@@ -170,6 +170,7 @@ bleuart_gap_event(struct ble_gap_event *event, void *arg)
 
     case BLE_GAP_EVENT_DISCONNECT:
         /* Connection terminated; resume advertising. */
+        bleuart_set_conn_handle(BLE_HS_CONN_HANDLE_NONE);
         bleuart_advertise();
         return 0;
     }
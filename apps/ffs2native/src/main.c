@@ -29,7 +29,9 @@
 #include <fs/fs.h>
 #include <bsp/bsp.h>
 #include <nffs/nffs.h>
+#include <hal/hal_bsp.h>
 #include <hal/hal_flash.h>
+#include <hal/hal_flash_int.h>
 #include <flash_map/flash_map.h>
 
 #include <sysinit/sysinit.h>
@@ -47,6 +49,7 @@
 
 struct log nffs_log;
 static const char *copy_in_dir;
+static const char *image_file;
 static const char *progname;
 static int print_verbose;
 
@@ -56,6 +59,14 @@ int file_scratch_idx;
 
 #define MAX_AREAS    16
 static struct nffs_area_desc area_descs[MAX_AREAS];
+
+/*
+ * Area layout of the target, given with -l.  The image is built with each
+ * area placed in its own simulated flash sector, and laid out at the target
+ * offsets when written out with -o.
+ */
+static struct nffs_area_desc layout_descs[MAX_AREAS];
+static int layout_cnt;
 int nffs_version;
 int force_version;
 
@@ -360,6 +371,182 @@ copy_in_directory(const char *src, const char *dst)
     closedir(dr);
 }
 
+/*
+ * Parses a target area layout: "off:len[,off:len...]".  Areas must be listed
+ * in ascending order and must not overlap.
+ */
+static int
+parse_layout(char *arg)
+{
+    char *tok;
+    char *ep;
+    uint32_t off;
+    uint32_t len;
+
+    layout_cnt = 0;
+    for (tok = strtok(arg, ","); tok; tok = strtok(NULL, ",")) {
+        if (layout_cnt >= MAX_AREAS - 1) {
+            return -1;
+        }
+        off = strtoul(tok, &ep, 0);
+        if (*ep != ':') {
+            return -1;
+        }
+        len = strtoul(ep + 1, &ep, 0);
+        if (*ep != '\0' || len == 0) {
+            return -1;
+        }
+        if (layout_cnt > 0 &&
+          off < layout_descs[layout_cnt - 1].nad_offset +
+                layout_descs[layout_cnt - 1].nad_length) {
+            return -1;
+        }
+        layout_descs[layout_cnt].nad_offset = off;
+        layout_descs[layout_cnt].nad_length = len;
+        layout_descs[layout_cnt].nad_flash_id = 0;
+        layout_cnt++;
+    }
+    if (layout_cnt < 2) {
+        return -1;
+    }
+    layout_descs[layout_cnt].nad_length = 0;
+    return 0;
+}
+
+/*
+ * Assigns each area of the target layout to a separate sector of the
+ * simulated flash, so that erasing one area never touches another.  The
+ * smallest free sector which fits is used.
+ */
+static int
+place_layout(void)
+{
+    const struct hal_flash *hf;
+    uint32_t used = 0;
+    uint32_t addr;
+    uint32_t size;
+    uint32_t best_addr;
+    uint32_t best_size;
+    int best;
+    int i;
+    int j;
+
+    hf = hal_bsp_flash_dev(0);
+    assert(hf->hf_sector_cnt <= 32);
+
+    for (i = 0; i < layout_cnt; i++) {
+        best = -1;
+        best_addr = 0;
+        best_size = 0;
+        for (j = 0; j < hf->hf_sector_cnt; j++) {
+            if (used & (1 << j)) {
+                continue;
+            }
+            hf->hf_itf->hff_sector_info(j, &addr, &size);
+            if (size >= layout_descs[i].nad_length &&
+              (best < 0 || size < best_size)) {
+                best = j;
+                best_addr = addr;
+                best_size = size;
+            }
+        }
+        if (best < 0) {
+            printf("No room for area %d (%u bytes) in simulated flash\n",
+              i, (unsigned)layout_descs[i].nad_length);
+            return -1;
+        }
+        used |= 1 << best;
+        area_descs[i].nad_offset = best_addr;
+        area_descs[i].nad_length = layout_descs[i].nad_length;
+        area_descs[i].nad_flash_id = 0;
+    }
+    area_descs[layout_cnt].nad_length = 0;
+    return 0;
+}
+
+/*
+ * Runs a garbage collection cycle over every area.  Appending blocks leaves
+ * superseded inode records behind; afterwards only live objects remain, with
+ * consecutive data blocks collated.  The device then mounts an image without
+ * garbage.
+ */
+static int
+compact_fs(void)
+{
+    int rc;
+    int i;
+
+    for (i = 0; i < nffs_num_areas; i++) {
+        rc = nffs_gc(NULL);
+        if (rc) {
+            return rc;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Writes the NFFS areas out as a single raw image, covering the range from
+ * the start of the first area to the end of the last one.  Gaps between the
+ * areas are filled with 0xff.  The image can be written to the target in one
+ * operation at the printed offset.
+ */
+static int
+write_image(const char *name)
+{
+    const struct nffs_area_desc *dst;
+    uint32_t start;
+    uint32_t end;
+    uint8_t *buf;
+    FILE *fp;
+    int rc;
+    int i;
+
+    dst = layout_cnt ? layout_descs : area_descs;
+    start = dst[0].nad_offset;
+    end = 0;
+    for (i = 0; dst[i].nad_length; i++) {
+        end = dst[i].nad_offset + dst[i].nad_length;
+    }
+
+    buf = malloc(end - start);
+    if (!buf) {
+        return -1;
+    }
+    memset(buf, 0xff, end - start);
+    for (i = 0; dst[i].nad_length; i++) {
+        rc = hal_flash_read(area_descs[i].nad_flash_id,
+                            area_descs[i].nad_offset,
+                            buf + dst[i].nad_offset - start,
+                            dst[i].nad_length);
+        if (rc) {
+            goto out;
+        }
+    }
+
+    fp = fopen(name, "wb");
+    if (!fp) {
+        perror("fopen()");
+        rc = -1;
+        goto out;
+    }
+    if (fwrite(buf, end - start, 1, fp) != 1) {
+        perror("fwrite()");
+        rc = -1;
+    } else {
+        rc = 0;
+    }
+    fclose(fp);
+
+    if (rc == 0) {
+        printf("Wrote %s: %u bytes, flash offset 0x%x\n",
+          name, (unsigned)(end - start), (unsigned)start);
+    }
+out:
+    free(buf);
+    return rc;
+}
+
 static int
 file_flash_read(uint32_t addr, void *dst, int byte_cnt)
 {
@@ -619,13 +806,17 @@ printfs(void)
 static void
 usage(int rc)
 {
-    printf("%s [-v][-c]|[-d dir][-s][-f flash_file]\n", progname);
+    printf("%s [-v][-c]|[-d dir][-l layout][-o image][-s][-f flash_file]\n",
+      progname);
     printf("  Tool for operating on simulator flash image file\n");
     printf("   -c: ...\n");
     printf("   -v: verbose\n");
     printf("   -d: use dir as root for NFFS portion and create flash image\n");
     printf("   -f: flash_file is the name of the flash image file\n");
     printf("   -s: use flash area layout in flash image file\n");
+    printf("   -l: target area layout, off:len[,off:len...]\n");
+    printf("   -o: write the compacted NFFS areas to image, as laid out on "
+           "the target\n");
     exit(rc);
 }
 
@@ -643,7 +834,7 @@ main(int argc, char **argv)
     progname = argv[0];
     force_version = -1;
 
-    while ((ch = getopt(argc, argv, "c:d:f:sv01")) != -1) {
+    while ((ch = getopt(argc, argv, "c:d:f:l:o:sv01")) != -1) {
         switch (ch) {
         case 'c':
             fp = fopen(optarg, "rb");
@@ -660,6 +851,15 @@ main(int argc, char **argv)
         case 'f':
             native_flash_file = optarg;
             break;
+        case 'l':
+            if (parse_layout(optarg)) {
+                printf("Invalid area layout\n");
+                usage(1);
+            }
+            break;
+        case 'o':
+            image_file = optarg;
+            break;
         case 'v':
             print_verbose++;
             break;
@@ -696,9 +896,19 @@ main(int argc, char **argv)
         return 0;
     }
 
-    rc = nffs_misc_desc_from_flash_area(MYNEWT_VAL(NFFS_FLASH_AREA), &cnt,
-      area_descs);
-    assert(rc == 0);
+    if (layout_cnt) {
+        if (!copy_in_dir) {
+            printf("-l requires -d\n");
+            usage(1);
+        }
+        if (place_layout()) {
+            exit(1);
+        }
+    } else {
+        rc = nffs_misc_desc_from_flash_area(MYNEWT_VAL(NFFS_FLASH_AREA), &cnt,
+          area_descs);
+        assert(rc == 0);
+    }
 
     if (copy_in_dir) {
         /*
@@ -707,6 +917,11 @@ main(int argc, char **argv)
         rc = nffs_format(area_descs);
         assert(rc == 0);
         copy_in_directory(copy_in_dir, "");
+        rc = compact_fs();
+        if (rc) {
+            printf("compaction failed, rc=%d\n", rc);
+            exit(1);
+        }
     } else {
         rc = nffs_detect(area_descs);
         if (rc) {
@@ -716,5 +931,12 @@ main(int argc, char **argv)
     }
     printfs();
 
+    if (image_file) {
+        rc = write_image(image_file);
+        if (rc) {
+            exit(1);
+        }
+    }
+
     return 0;
 }
@@ -22,6 +22,7 @@
 #include <ctype.h>
 #include <stdio.h>
 
+#include "syscfg/syscfg.h"
 #include "sysflash/sysflash.h"
 
 #include <bsp/bsp.h>
@@ -242,6 +243,68 @@ out:
     flash_area_close(fap);
 }
 
+#if MYNEWT_VAL(BOOT_SERIAL_BIN)
+/*
+ * Switch to binary upload mode.  The request gives the image length and
+ * optionally a baud rate to continue at.  The response gives the window and
+ * frame size to use, and the baud rate.
+ */
+static void
+bs_bin_upload(char *buf, int len)
+{
+    CborParser parser;
+    struct cbor_buf_reader reader;
+    struct CborValue value;
+    long long unsigned int img_len = 0;
+    long long unsigned int baud = 0;
+    const struct cbor_attr_t attr[3] = {
+        [0] = {
+            .attribute = "len",
+            .type = CborAttrUnsignedIntegerType,
+            .addr.uinteger = &img_len,
+            .nodefault = true
+        },
+        [1] = {
+            .attribute = "baud",
+            .type = CborAttrUnsignedIntegerType,
+            .addr.uinteger = &baud,
+            .nodefault = true
+        }
+    };
+    int rc;
+
+    cbor_buf_reader_init(&reader, (uint8_t *)buf, len);
+    cbor_parser_init(&reader.r, 0, &parser, &value);
+    rc = cbor_read_object(&value, attr);
+    if (rc || img_len == 0 || baud > MYNEWT_VAL(BOOT_SERIAL_BIN_MAX_BAUD)) {
+        rc = MGMT_ERR_EINVAL;
+    } else {
+        rc = bs_bin_open(img_len);
+    }
+    if (baud == 0) {
+        baud = MYNEWT_VAL(BOOT_SERIAL_BIN_BAUD);
+    }
+
+    cbor_encoder_create_map(&bs_root, &bs_rsp, CborIndefiniteLength);
+    cbor_encode_text_stringz(&bs_rsp, "rc");
+    cbor_encode_int(&bs_rsp, rc);
+    if (rc == 0) {
+        cbor_encode_text_stringz(&bs_rsp, "win");
+        cbor_encode_uint(&bs_rsp, bs_bin_window());
+        cbor_encode_text_stringz(&bs_rsp, "frame");
+        cbor_encode_uint(&bs_rsp, MYNEWT_VAL(BOOT_SERIAL_BIN_FRAME_SIZE));
+        cbor_encode_text_stringz(&bs_rsp, "baud");
+        cbor_encode_uint(&bs_rsp, baud);
+    }
+    cbor_encoder_close_container(&bs_root, &bs_rsp);
+    boot_serial_output();
+
+    if (rc == 0) {
+        bs_bin_run(baud);
+    }
+}
+#endif
+
 /*
  * Console echo control. Send empty response, don't do anything.
  */
@@ -303,6 +366,11 @@ boot_serial_input(char *buf, int len)
         case IMGMGR_NMGR_OP_UPLOAD:
             bs_upload(buf, len);
             break;
+#if MYNEWT_VAL(BOOT_SERIAL_BIN)
+        case IMGMGR_NMGR_OP_BIN_UPLOAD:
+            bs_bin_upload(buf, len);
+            break;
+#endif
         default:
             break;
         }
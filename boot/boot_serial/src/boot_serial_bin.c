@@ -0,0 +1,421 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Binary upload mode.
+ *
+ * Entered with an IMGMGR_NMGR_OP_BIN_UPLOAD request over the regular
+ * newtmgr serial protocol.  After the response has been sent, the UART is
+ * taken over from the console, optionally switched to a different baud
+ * rate, and image0 is received as binary frames:
+ *
+ *     0   sync (0xb5 0x62)
+ *     2   type
+ *     3   reserved, 0
+ *     4   payload length, network byte order
+ *     6   image offset, network byte order
+ *    10   payload
+ *         CRC16-CCITT of type through payload, network byte order
+ *
+ * The host sends DATA frames, and may have as many outstanding as the window
+ * given in the handshake response.  Each one is answered with an ACK whose
+ * offset is the next one expected, and whose one byte payload is a
+ * BS_BIN_ST_* status.  A frame which does not start at the expected offset
+ * is dropped; the first such frame is answered with BS_BIN_ST_RESEND, and
+ * the host resumes from the acknowledged offset.  Frames with a bad CRC are
+ * dropped silently.
+ *
+ * Sectors are erased as the data reaches them rather than all up front.
+ * Received bytes are buffered from the UART interrupt, so reception carries
+ * on while a sector is being erased or written.
+ *
+ * DONE completes the upload and ABORT cancels it; either way the device
+ * resets after acknowledging.  So does silence for BOOT_SERIAL_BIN_TIMEOUT_MS.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+#include <inttypes.h>
+#include <string.h>
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(BOOT_SERIAL_BIN)
+
+#include <flash_map/flash_map.h>
+#include <hal/hal_system.h>
+#include <hal/hal_uart.h>
+
+#include <os/endian.h>
+#include <os/os.h>
+#include <os/os_cputime.h>
+
+#include <crc/crc16.h>
+
+#include "boot_serial_priv.h"
+
+#define BS_BIN_SYNC1            0xb5
+#define BS_BIN_SYNC2            0x62
+#define BS_BIN_HDR_SZ           10
+#define BS_BIN_OVERHEAD         (BS_BIN_HDR_SZ + sizeof(uint16_t))
+#define BS_BIN_PAD_MAX          8
+
+#define BS_BIN_RX_MASK          (MYNEWT_VAL(BOOT_SERIAL_BIN_RX_BUF_SIZE) - 1)
+
+static struct {
+    const struct flash_area *fap;
+    uint32_t img_size;
+    uint32_t curr_off;
+    uint32_t erased_off;
+    uint8_t resend_sent;
+    uint8_t done;
+
+    /* Receive ring, filled from interrupt context. */
+    volatile uint16_t rx_head;
+    volatile uint16_t rx_tail;
+    uint8_t rx_buf[MYNEWT_VAL(BOOT_SERIAL_BIN_RX_BUF_SIZE)];
+
+    /* Frame being assembled, with room to pad the last one for writing. */
+    int frame_len;
+    uint8_t frame[BS_BIN_OVERHEAD + MYNEWT_VAL(BOOT_SERIAL_BIN_FRAME_SIZE) +
+                  BS_BIN_PAD_MAX];
+
+    volatile uint8_t tx_off;
+    volatile uint8_t tx_len;
+    uint8_t tx_buf[BS_BIN_OVERHEAD + 1];
+} bs_bin;
+
+/*
+ * Number of frames the host may have outstanding; all of them fit in the
+ * receive buffer.
+ */
+int
+bs_bin_window(void)
+{
+    int win;
+
+    win = MYNEWT_VAL(BOOT_SERIAL_BIN_RX_BUF_SIZE) /
+          (BS_BIN_OVERHEAD + MYNEWT_VAL(BOOT_SERIAL_BIN_FRAME_SIZE));
+    return win > 0 ? win : 1;
+}
+
+/*
+ * Prepares to receive an image of img_size bytes into slot 0.
+ */
+int
+bs_bin_open(uint32_t img_size)
+{
+    int rc;
+
+    if (bs_bin.fap) {
+        flash_area_close(bs_bin.fap);
+        bs_bin.fap = NULL;
+    }
+    rc = flash_area_open(flash_area_id_from_image_slot(0), &bs_bin.fap);
+    if (rc) {
+        return MGMT_ERR_EINVAL;
+    }
+    if (img_size == 0 || img_size > bs_bin.fap->fa_size) {
+        flash_area_close(bs_bin.fap);
+        bs_bin.fap = NULL;
+        return MGMT_ERR_EINVAL;
+    }
+    bs_bin.img_size = img_size;
+    bs_bin.curr_off = 0;
+    bs_bin.erased_off = 0;
+    bs_bin.resend_sent = 0;
+    bs_bin.done = 0;
+    return 0;
+}
+
+/*
+ * Erases sectors until everything below 'end' is erased.
+ */
+static int
+bs_bin_erase_to(uint32_t end)
+{
+    struct flash_area sector;
+    uint32_t off;
+    int rc;
+
+    while (bs_bin.erased_off < end) {
+        rc = flash_area_sector_from_off(bs_bin.fap, bs_bin.erased_off,
+                                        &sector);
+        if (rc < 0) {
+            return -1;
+        }
+        off = sector.fa_off - bs_bin.fap->fa_off;
+        rc = flash_area_erase(bs_bin.fap, off, sector.fa_size);
+        if (rc) {
+            return -1;
+        }
+        bs_bin.erased_off = off + sector.fa_size;
+    }
+    return 0;
+}
+
+static int
+bs_bin_write(uint32_t off, uint8_t *data, uint32_t len)
+{
+    uint32_t ahead;
+    uint8_t align;
+    int rc;
+
+    /* Keep at least a frame's worth erased beyond what is being written. */
+    ahead = min(off + len + MYNEWT_VAL(BOOT_SERIAL_BIN_FRAME_SIZE),
+                bs_bin.img_size);
+    if (bs_bin_erase_to(ahead)) {
+        return -1;
+    }
+
+    /* Only the last frame can be unaligned; pad it as erased flash. */
+    align = flash_area_align(bs_bin.fap);
+    if (align > BS_BIN_PAD_MAX) {
+        return -1;
+    }
+    while (len % align) {
+        if (off + len >= bs_bin.fap->fa_size) {
+            return -1;
+        }
+        data[len++] = 0xff;
+    }
+    rc = flash_area_write(bs_bin.fap, off, data, len);
+    return rc ? -1 : 0;
+}
+
+/*
+ * Processes one complete frame.  Returns the BS_BIN_ST_* status to
+ * acknowledge with, or -1 if no acknowledgement is to be sent.  The offset
+ * to acknowledge is written to out_off.
+ */
+int
+bs_bin_process(uint8_t *frame, int len, uint32_t *out_off)
+{
+    uint16_t crc;
+    uint16_t data_len;
+    uint32_t off;
+    int rc;
+
+    if (len < BS_BIN_OVERHEAD ||
+        frame[0] != BS_BIN_SYNC1 || frame[1] != BS_BIN_SYNC2) {
+        return -1;
+    }
+    memcpy(&data_len, frame + 4, sizeof(data_len));
+    data_len = ntohs(data_len);
+    if (len != BS_BIN_OVERHEAD + data_len) {
+        return -1;
+    }
+    memcpy(&crc, frame + BS_BIN_HDR_SZ + data_len, sizeof(crc));
+    if (crc16_ccitt(CRC16_INITIAL_CRC, frame + 2,
+                    BS_BIN_HDR_SZ - 2 + data_len) != ntohs(crc)) {
+        return -1;
+    }
+    memcpy(&off, frame + 6, sizeof(off));
+    off = ntohl(off);
+
+    switch (frame[2]) {
+    case BS_BIN_DATA:
+        if (off != bs_bin.curr_off) {
+            if (bs_bin.resend_sent) {
+                return -1;
+            }
+            bs_bin.resend_sent = 1;
+            rc = BS_BIN_ST_RESEND;
+            break;
+        }
+        bs_bin.resend_sent = 0;
+        if (data_len == 0 || off + data_len > bs_bin.img_size) {
+            rc = BS_BIN_ST_INVAL;
+            break;
+        }
+        if (bs_bin_write(off, frame + BS_BIN_HDR_SZ, data_len)) {
+            rc = BS_BIN_ST_FLASH;
+            break;
+        }
+        bs_bin.curr_off += data_len;
+        rc = BS_BIN_ST_OK;
+        break;
+
+    case BS_BIN_DONE:
+        if (bs_bin.curr_off != bs_bin.img_size) {
+            rc = BS_BIN_ST_RESEND;
+            break;
+        }
+        bs_bin.done = 1;
+        rc = BS_BIN_ST_OK;
+        break;
+
+    case BS_BIN_ABORT:
+        bs_bin.done = 1;
+        rc = BS_BIN_ST_OK;
+        break;
+
+    default:
+        rc = BS_BIN_ST_INVAL;
+        break;
+    }
+
+    *out_off = bs_bin.curr_off;
+    return rc;
+}
+
+static int
+bs_bin_rx_char(void *arg, uint8_t byte)
+{
+    uint16_t head;
+
+    head = bs_bin.rx_head;
+    if (((head + 1) & BS_BIN_RX_MASK) != bs_bin.rx_tail) {
+        bs_bin.rx_buf[head] = byte;
+        bs_bin.rx_head = (head + 1) & BS_BIN_RX_MASK;
+    }
+    /* On overflow, the byte is lost and the frame fails its CRC. */
+    return 0;
+}
+
+static int
+bs_bin_tx_char(void *arg)
+{
+    if (bs_bin.tx_off >= bs_bin.tx_len) {
+        return -1;
+    }
+    return bs_bin.tx_buf[bs_bin.tx_off++];
+}
+
+static void
+bs_bin_tx_wait(void)
+{
+    while (bs_bin.tx_off < bs_bin.tx_len) {
+    }
+}
+
+static void
+bs_bin_ack(int status, uint32_t off)
+{
+    uint16_t crc;
+    uint16_t len;
+
+    bs_bin_tx_wait();
+
+    bs_bin.tx_buf[0] = BS_BIN_SYNC1;
+    bs_bin.tx_buf[1] = BS_BIN_SYNC2;
+    bs_bin.tx_buf[2] = BS_BIN_ACK;
+    bs_bin.tx_buf[3] = 0;
+    len = htons(1);
+    memcpy(bs_bin.tx_buf + 4, &len, sizeof(len));
+    off = htonl(off);
+    memcpy(bs_bin.tx_buf + 6, &off, sizeof(off));
+    bs_bin.tx_buf[BS_BIN_HDR_SZ] = status;
+    crc = crc16_ccitt(CRC16_INITIAL_CRC, bs_bin.tx_buf + 2, BS_BIN_HDR_SZ - 1);
+    crc = htons(crc);
+    memcpy(bs_bin.tx_buf + BS_BIN_HDR_SZ + 1, &crc, sizeof(crc));
+
+    bs_bin.tx_off = 0;
+    bs_bin.tx_len = BS_BIN_OVERHEAD + 1;
+    hal_uart_start_tx(MYNEWT_VAL(BOOT_SERIAL_BIN_UART));
+}
+
+/*
+ * Feeds a received byte to the frame assembler.  Returns 1 when a complete
+ * frame is in bs_bin.frame.
+ */
+static int
+bs_bin_rx_byte(uint8_t byte)
+{
+    uint16_t data_len;
+
+    if (bs_bin.frame_len == 0 && byte != BS_BIN_SYNC1) {
+        return 0;
+    }
+    if (bs_bin.frame_len == 1 && byte != BS_BIN_SYNC2) {
+        bs_bin.frame_len = (byte == BS_BIN_SYNC1);
+        return 0;
+    }
+    bs_bin.frame[bs_bin.frame_len++] = byte;
+    if (bs_bin.frame_len < BS_BIN_HDR_SZ) {
+        return 0;
+    }
+
+    memcpy(&data_len, bs_bin.frame + 4, sizeof(data_len));
+    data_len = ntohs(data_len);
+    if (data_len > MYNEWT_VAL(BOOT_SERIAL_BIN_FRAME_SIZE)) {
+        /* Not a header; hunt for the next sync. */
+        bs_bin.frame_len = 0;
+        return 0;
+    }
+    return bs_bin.frame_len == BS_BIN_OVERHEAD + data_len;
+}
+
+/*
+ * Takes over the UART and receives the image.  Does not return.
+ */
+void
+bs_bin_run(uint32_t baud)
+{
+    uint32_t timeout;
+    uint32_t last_rx;
+    uint32_t off;
+    uint16_t tail;
+    int port;
+    int rc;
+
+    port = MYNEWT_VAL(BOOT_SERIAL_BIN_UART);
+
+    /* Let the handshake response drain at the console baud rate. */
+    os_cputime_delay_usecs(50000);
+
+    hal_uart_close(port);
+    rc = hal_uart_init_cbs(port, bs_bin_tx_char, NULL, bs_bin_rx_char, NULL);
+    assert(rc == 0);
+    rc = hal_uart_config(port, baud, 8, 1, HAL_UART_PARITY_NONE,
+                         HAL_UART_FLOW_CTL_NONE);
+    assert(rc == 0);
+
+    timeout = os_cputime_usecs_to_ticks(
+        MYNEWT_VAL(BOOT_SERIAL_BIN_TIMEOUT_MS) * 1000);
+    last_rx = os_cputime_get32();
+    bs_bin.frame_len = 0;
+
+    while (!bs_bin.done) {
+        tail = bs_bin.rx_tail;
+        if (tail == bs_bin.rx_head) {
+            if (os_cputime_get32() - last_rx > timeout) {
+                break;
+            }
+            continue;
+        }
+        last_rx = os_cputime_get32();
+
+        rc = bs_bin_rx_byte(bs_bin.rx_buf[tail]);
+        bs_bin.rx_tail = (tail + 1) & BS_BIN_RX_MASK;
+        if (rc) {
+            rc = bs_bin_process(bs_bin.frame, bs_bin.frame_len, &off);
+            bs_bin.frame_len = 0;
+            if (rc >= 0) {
+                bs_bin_ack(rc, off);
+            }
+        }
+    }
+
+    bs_bin_tx_wait();
+    os_cputime_delay_usecs(10000);
+    hal_system_reset();
+}
+
+#endif
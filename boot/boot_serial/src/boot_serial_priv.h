@@ -64,9 +64,35 @@ struct nmgr_hdr {
 #define IMGMGR_NMGR_OP_STATE            0
 #define IMGMGR_NMGR_OP_UPLOAD           1
 
+/*
+ * Boot serial only; switches to binary upload mode.
+ */
+#define IMGMGR_NMGR_OP_BIN_UPLOAD       32
+
+/*
+ * Binary upload frame types.
+ */
+#define BS_BIN_DATA             1
+#define BS_BIN_DONE             2
+#define BS_BIN_ABORT            3
+#define BS_BIN_ACK              0x80
+
+/*
+ * Binary upload acknowledgement status.
+ */
+#define BS_BIN_ST_OK            0
+#define BS_BIN_ST_RESEND        1
+#define BS_BIN_ST_FLASH         2
+#define BS_BIN_ST_INVAL         3
+
 
 void boot_serial_input(char *buf, int len);
 
+int bs_bin_window(void);
+int bs_bin_open(uint32_t img_size);
+int bs_bin_process(uint8_t *frame, int len, uint32_t *out_off);
+void bs_bin_run(uint32_t baud);
+
 #ifdef __cplusplus
 }
 #endif
@@ -38,6 +38,7 @@ TEST_CASE_DECL(boot_serial_empty_msg)
 TEST_CASE_DECL(boot_serial_empty_img_msg)
 TEST_CASE_DECL(boot_serial_img_msg)
 TEST_CASE_DECL(boot_serial_upload_bigger_image)
+TEST_CASE_DECL(boot_serial_bin_upload)
 
 void
 tx_msg(void *src, int len)
@@ -52,6 +53,7 @@ TEST_SUITE(boot_serial_suite)
     boot_serial_empty_img_msg();
     boot_serial_img_msg();
     boot_serial_upload_bigger_image();
+    boot_serial_bin_upload();
 }
 
 int
@@ -0,0 +1,126 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "boot_test.h"
+
+static int
+bin_frame(uint8_t *frame, int type, uint32_t off, const void *data,
+          uint16_t len)
+{
+    uint16_t crc;
+    uint16_t nlen;
+    uint32_t noff;
+
+    frame[0] = 0xb5;
+    frame[1] = 0x62;
+    frame[2] = type;
+    frame[3] = 0;
+    nlen = htons(len);
+    memcpy(frame + 4, &nlen, sizeof(nlen));
+    noff = htonl(off);
+    memcpy(frame + 6, &noff, sizeof(noff));
+    memcpy(frame + 10, data, len);
+    crc = crc16_ccitt(CRC16_INITIAL_CRC, frame + 2, 8 + len);
+    crc = htons(crc);
+    memcpy(frame + 10 + len, &crc, sizeof(crc));
+
+    return 12 + len;
+}
+
+TEST_CASE(boot_serial_bin_upload)
+{
+    uint8_t img[1000];
+    uint8_t frame[12 + 256];
+    uint8_t buf[100];
+    const struct flash_area *fap;
+    uint32_t ack_off;
+    int len;
+    int off;
+    int rc;
+    int i;
+
+    for (i = 0; i < sizeof(img); i++) {
+        img[i] = i * 7;
+    }
+
+    rc = bs_bin_open(sizeof(img));
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* First frame. */
+    len = bin_frame(frame, BS_BIN_DATA, 0, img, 256);
+    rc = bs_bin_process(frame, len, &ack_off);
+    TEST_ASSERT(rc == BS_BIN_ST_OK);
+    TEST_ASSERT(ack_off == 256);
+
+    /* A lost frame: the next one is out of order, asked to resend once. */
+    len = bin_frame(frame, BS_BIN_DATA, 512, img + 512, 256);
+    rc = bs_bin_process(frame, len, &ack_off);
+    TEST_ASSERT(rc == BS_BIN_ST_RESEND);
+    TEST_ASSERT(ack_off == 256);
+    len = bin_frame(frame, BS_BIN_DATA, 768, img + 768, 232);
+    rc = bs_bin_process(frame, len, &ack_off);
+    TEST_ASSERT(rc == -1);
+
+    /* Corrupted frame is dropped silently. */
+    len = bin_frame(frame, BS_BIN_DATA, 256, img + 256, 256);
+    frame[20] ^= 1;
+    rc = bs_bin_process(frame, len, &ack_off);
+    TEST_ASSERT(rc == -1);
+
+    /* Not done yet. */
+    len = bin_frame(frame, BS_BIN_DONE, 0, NULL, 0);
+    rc = bs_bin_process(frame, len, &ack_off);
+    TEST_ASSERT(rc == BS_BIN_ST_RESEND);
+
+    /* Go back and send the rest. */
+    for (off = 256; off < sizeof(img); off += len) {
+        len = sizeof(img) - off;
+        if (len > 256) {
+            len = 256;
+        }
+        rc = bs_bin_process(frame,
+                            bin_frame(frame, BS_BIN_DATA, off, img + off, len),
+                            &ack_off);
+        TEST_ASSERT(rc == BS_BIN_ST_OK);
+        TEST_ASSERT(ack_off == off + len);
+    }
+
+    /* Past the end of the image. */
+    len = bin_frame(frame, BS_BIN_DATA, sizeof(img), img, 1);
+    rc = bs_bin_process(frame, len, &ack_off);
+    TEST_ASSERT(rc == BS_BIN_ST_INVAL);
+
+    len = bin_frame(frame, BS_BIN_DONE, 0, NULL, 0);
+    rc = bs_bin_process(frame, len, &ack_off);
+    TEST_ASSERT(rc == BS_BIN_ST_OK);
+    TEST_ASSERT(ack_off == sizeof(img));
+
+    /*
+     * Validate contents inside image 0 slot
+     */
+    rc = flash_area_open(FLASH_AREA_IMAGE_0, &fap);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (off = 0; off < sizeof(img); off += sizeof(buf)) {
+        rc = flash_area_read(fap, off, buf, sizeof(buf));
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(!memcmp(buf, &img[off], sizeof(buf)));
+    }
+    flash_area_close(fap);
+}
@@ -48,6 +48,24 @@ struct boot_rsp {
     uint32_t br_image_addr;
 };
 
+/**
+ * Cumulative cost of image swaps performed since reset.  Times are in
+ * os_cputime ticks, sizes in bytes.  Only kept with BOOTUTIL_SWAP_STATS.
+ */
+struct boot_swap_stats {
+    uint32_t bss_erase_ticks;
+    uint32_t bss_copy_ticks;
+    uint32_t bss_status_ticks;
+    uint32_t bss_erased;
+    /** Erases skipped because the region was already blank. */
+    uint32_t bss_erase_skipped;
+    uint32_t bss_copied;
+    /** Ranges not swapped because neither slot holds image data there. */
+    uint32_t bss_swap_skipped;
+};
+
+extern struct boot_swap_stats boot_swap_stats;
+
 /* you must have pre-allocated all the entries within this structure */
 int boot_go(struct boot_rsp *rsp);
 
@@ -87,6 +87,18 @@ int bootutil_img_validate(struct image_header *hdr,
                           uint8_t *tmp_buf, uint32_t tmp_buf_sz,
                           uint8_t *seed, int seed_len, uint8_t *out_hash);
 
+/*
+ * Computes the SHA256 of an image's header and body, optionally seeded.
+ * Flash which is not memory mapped is read through tmp_buf.  With
+ * BOOTUTIL_HASH_CACHE, results are remembered until the flash area they were
+ * computed over is passed to bootutil_img_hash_cache_clear(); anything
+ * modifying an image slot must do so.
+ */
+int bootutil_img_hash(struct image_header *hdr, const struct flash_area *fap,
+                      uint8_t *tmp_buf, uint32_t tmp_buf_sz,
+                      uint8_t *hash_result, uint8_t *seed, int seed_len);
+void bootutil_img_hash_cache_clear(int fa_id);
+
 #ifdef __cplusplus
 }
 #endif
@@ -454,3 +454,90 @@ done:
     flash_area_close(fap);
     return rc;
 }
+
+#if MYNEWT_VAL(BOOTUTIL_VALIDATE_CACHE)
+
+/**
+ * Checks whether the scratch area holds a validation record for the
+ * specified slot 0 image.
+ *
+ * @param hdr               The header of the image in slot 0.
+ * @param hash              The SHA256 hash recorded in the image's TLVs.
+ *
+ * @return                  0 if the image was previously validated;
+ *                          nonzero otherwise.
+ */
+int
+boot_read_validated(const struct image_header *hdr, const uint8_t *hash)
+{
+    const struct flash_area *fap;
+    struct boot_validated bv;
+    int rc;
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_SCRATCH, &fap);
+    if (rc != 0) {
+        return BOOT_EFLASH;
+    }
+
+    rc = flash_area_read(fap, 0, &bv, sizeof bv);
+    flash_area_close(fap);
+    if (rc != 0) {
+        return BOOT_EFLASH;
+    }
+
+    if (bv.bv_magic != BOOT_VALIDATED_MAGIC ||
+        bv.bv_img_size != hdr->ih_img_size ||
+        memcmp(bv.bv_hash, hash, sizeof bv.bv_hash) != 0) {
+
+        return BOOT_EBADIMAGE;
+    }
+
+    return 0;
+}
+
+/**
+ * Records in the scratch area that the specified slot 0 image has been
+ * validated.  This erases the start of the scratch area, so it must only be
+ * called while no swap is in progress.
+ *
+ * @param hdr               The header of the image in slot 0.
+ * @param hash              The hash the image was validated against.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+int
+boot_write_validated(const struct image_header *hdr, const uint8_t *hash)
+{
+    const struct flash_area *fap;
+    struct boot_validated bv;
+    int rc;
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_SCRATCH, &fap);
+    if (rc != 0) {
+        return BOOT_EFLASH;
+    }
+
+    rc = flash_area_erase(fap, 0, sizeof bv);
+    if (rc != 0) {
+        rc = BOOT_EFLASH;
+        goto done;
+    }
+
+    bv.bv_magic = BOOT_VALIDATED_MAGIC;
+    bv.bv_img_size = hdr->ih_img_size;
+    memcpy(bv.bv_hash, hash, sizeof bv.bv_hash);
+
+    rc = flash_area_write(fap, 0, &bv, sizeof bv);
+    if (rc != 0) {
+        rc = BOOT_EFLASH;
+        goto done;
+    }
+
+    rc = 0;
+
+done:
+    flash_area_close(fap);
+    return rc;
+}
+
+#endif
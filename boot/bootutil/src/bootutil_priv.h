@@ -37,7 +37,7 @@ struct flash_area;
 #define BOOT_ENOMEM     6
 #define BOOT_EBADARGS   7
 
-#define BOOT_TMPBUF_SZ  256
+#define BOOT_TMPBUF_SZ  MYNEWT_VAL(BOOTUTIL_HASH_BUF_SIZE)
 
 /*
  * Maintain state of copy progress.
@@ -71,6 +71,20 @@ struct boot_status {
 
 extern const uint32_t boot_img_magic[4];
 
+/**
+ * Record kept at the start of the scratch area once the image in slot 0 has
+ * been validated.  The hash is the one the image was validated against; an
+ * image whose SHA256 TLV no longer matches it is validated again.  Any swap
+ * erases the scratch area, and with it the record.
+ */
+struct boot_validated {
+    uint32_t bv_magic;
+    uint32_t bv_img_size;
+    uint8_t bv_hash[32];
+};
+
+#define BOOT_VALIDATED_MAGIC    0x5681a7e4
+
 struct boot_swap_state {
     uint8_t magic;  /* One of the BOOT_MAGIC_[...] values. */
     uint8_t copy_done;
@@ -101,6 +115,11 @@ int boot_write_image_ok(const struct flash_area *fap);
 
 uint32_t boot_status_sz(uint8_t min_write_sz);
 
+int bootutil_img_hash_tlv(struct image_header *hdr,
+                          const struct flash_area *fap, uint8_t *out_hash);
+int boot_read_validated(const struct image_header *hdr, const uint8_t *hash);
+int boot_write_validated(const struct image_header *hdr, const uint8_t *hash);
+
 #ifdef __cplusplus
 }
 #endif
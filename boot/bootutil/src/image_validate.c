@@ -35,36 +35,143 @@
 
 #include "bootutil_priv.h"
 
+#if MYNEWT_VAL(BOOTUTIL_HASH_CACHE) > 0
+/*
+ * Hashes computed since boot, keyed by flash area, image header and seed.
+ * Entries are replaced round-robin.
+ */
+struct bootutil_hash_cache_entry {
+    struct image_header bhc_hdr;
+    uint8_t bhc_seed[32];
+    uint8_t bhc_hash[32];
+    uint8_t bhc_fa_id;
+    uint8_t bhc_seed_len;
+    uint8_t bhc_valid;
+};
+
+static struct bootutil_hash_cache_entry
+    bootutil_hash_cache[MYNEWT_VAL(BOOTUTIL_HASH_CACHE)];
+static int bootutil_hash_cache_next;
+
+static struct bootutil_hash_cache_entry *
+bootutil_hash_cache_find(const struct image_header *hdr,
+                         const struct flash_area *fap,
+                         const uint8_t *seed, int seed_len)
+{
+    struct bootutil_hash_cache_entry *bhc;
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(BOOTUTIL_HASH_CACHE); i++) {
+        bhc = &bootutil_hash_cache[i];
+        if (bhc->bhc_valid &&
+            bhc->bhc_fa_id == fap->fa_id &&
+            bhc->bhc_seed_len == seed_len &&
+            !memcmp(&bhc->bhc_hdr, hdr, sizeof(*hdr)) &&
+            (seed_len == 0 || !memcmp(bhc->bhc_seed, seed, seed_len))) {
+            return bhc;
+        }
+    }
+    return NULL;
+}
+
+static void
+bootutil_hash_cache_add(const struct image_header *hdr,
+                        const struct flash_area *fap,
+                        const uint8_t *seed, int seed_len,
+                        const uint8_t *hash)
+{
+    struct bootutil_hash_cache_entry *bhc;
+
+    if (seed_len > (int)sizeof(bhc->bhc_seed)) {
+        return;
+    }
+    bhc = &bootutil_hash_cache[bootutil_hash_cache_next];
+    bootutil_hash_cache_next = (bootutil_hash_cache_next + 1) %
+                               MYNEWT_VAL(BOOTUTIL_HASH_CACHE);
+
+    bhc->bhc_hdr = *hdr;
+    if (seed_len > 0) {
+        memcpy(bhc->bhc_seed, seed, seed_len);
+    }
+    memcpy(bhc->bhc_hash, hash, 32);
+    bhc->bhc_fa_id = fap->fa_id;
+    bhc->bhc_seed_len = seed_len;
+    bhc->bhc_valid = 1;
+}
+#endif
+
+void
+bootutil_img_hash_cache_clear(int fa_id)
+{
+#if MYNEWT_VAL(BOOTUTIL_HASH_CACHE) > 0
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(BOOTUTIL_HASH_CACHE); i++) {
+        if (bootutil_hash_cache[i].bhc_fa_id == fa_id) {
+            bootutil_hash_cache[i].bhc_valid = 0;
+        }
+    }
+#else
+    (void)fa_id;
+#endif
+}
+
 /*
  * Compute SHA256 over the image.
  */
-static int
+int
 bootutil_img_hash(struct image_header *hdr, const struct flash_area *fap,
                   uint8_t *tmp_buf, uint32_t tmp_buf_sz,
                   uint8_t *hash_result, uint8_t *seed, int seed_len)
 {
     mbedtls_sha256_context sha256_ctx;
+#if MYNEWT_VAL(BOOTUTIL_FLASH_MAP)
+    const uint8_t *img;
+#endif
+#if MYNEWT_VAL(BOOTUTIL_HASH_CACHE) > 0
+    struct bootutil_hash_cache_entry *bhc;
+#endif
     uint32_t blk_sz;
     uint32_t size;
     uint32_t off;
     int rc;
 
+    if (!seed) {
+        seed_len = 0;
+    }
+
+#if MYNEWT_VAL(BOOTUTIL_HASH_CACHE) > 0
+    bhc = bootutil_hash_cache_find(hdr, fap, seed, seed_len);
+    if (bhc) {
+        memcpy(hash_result, bhc->bhc_hash, 32);
+        return 0;
+    }
+#endif
+
     mbedtls_sha256_init(&sha256_ctx);
     mbedtls_sha256_starts(&sha256_ctx, 0);
 
     /* in some cases (split image) the hash is seeded with data from
      * the loader image */
-    if(seed && (seed_len > 0)) {
+    if (seed_len > 0) {
         mbedtls_sha256_update(&sha256_ctx, seed, seed_len);
     }
 
-    size = hdr->ih_img_size + hdr->ih_hdr_size;
-
     /*
      * Hash is computed over image header and image itself. No TLV is
      * included ATM.
      */
     size = hdr->ih_img_size + hdr->ih_hdr_size;
+
+#if MYNEWT_VAL(BOOTUTIL_FLASH_MAP)
+    /* Memory-mapped flash is hashed in place, in one pass. */
+    img = hal_flash_map(fap->fa_device_id, fap->fa_off, size);
+    if (img != NULL) {
+        mbedtls_sha256_update(&sha256_ctx, img, size);
+        goto done;
+    }
+#endif
+
     for (off = 0; off < size; off += blk_sz) {
         blk_sz = size - off;
         if (blk_sz > tmp_buf_sz) {
@@ -76,11 +183,50 @@ bootutil_img_hash(struct image_header *hdr, const struct flash_area *fap,
         }
         mbedtls_sha256_update(&sha256_ctx, tmp_buf, blk_sz);
     }
+
+#if MYNEWT_VAL(BOOTUTIL_FLASH_MAP)
+done:
+#endif
     mbedtls_sha256_finish(&sha256_ctx, hash_result);
+#if MYNEWT_VAL(BOOTUTIL_HASH_CACHE) > 0
+    bootutil_hash_cache_add(hdr, fap, seed, seed_len, hash_result);
+#endif
 
     return 0;
 }
 
+/*
+ * Read the SHA256 hash recorded in the image's TLVs, without hashing the
+ * image.
+ */
+int
+bootutil_img_hash_tlv(struct image_header *hdr, const struct flash_area *fap,
+                      uint8_t *out_hash)
+{
+    struct image_tlv tlv;
+    uint32_t size;
+    uint32_t off;
+    int rc;
+
+    off = hdr->ih_img_size + hdr->ih_hdr_size;
+    size = off + hdr->ih_tlv_size;
+
+    for (; off < size; off += sizeof(tlv) + tlv.it_len) {
+        rc = flash_area_read(fap, off, &tlv, sizeof tlv);
+        if (rc) {
+            return rc;
+        }
+        if (tlv.it_type == IMAGE_TLV_SHA256) {
+            if (tlv.it_len != 32) {
+                return -1;
+            }
+            return flash_area_read(fap, off + sizeof(tlv), out_hash, 32);
+        }
+    }
+
+    return -1;
+}
+
 /*
  * Verify the integrity of the image.
  * Return non-zero if image could not be validated/does not validate.
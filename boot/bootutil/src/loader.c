@@ -31,6 +31,7 @@
 #include "flash_map/flash_map.h"
 #include <hal/hal_flash.h>
 #include <os/os_malloc.h>
+#include <os/os_cputime.h>
 #include "bootutil/bootutil.h"
 #include "bootutil/image.h"
 #include "bootutil_priv.h"
@@ -40,6 +41,21 @@
 /** Number of image slots in flash; currently limited to two. */
 #define BOOT_NUM_SLOTS              2
 
+#if MYNEWT_VAL(BOOTUTIL_SWAP_STATS)
+struct boot_swap_stats boot_swap_stats;
+
+#define BOOT_SWAP_STAT_ADD(field, n)        (boot_swap_stats.field += (n))
+#define BOOT_SWAP_TIME_DECL(var)            uint32_t var
+#define BOOT_SWAP_TIME_START(var)           ((var) = os_cputime_get32())
+#define BOOT_SWAP_TIME_END(field, var)                                  \
+    (boot_swap_stats.field += os_cputime_get32() - (var))
+#else
+#define BOOT_SWAP_STAT_ADD(field, n)
+#define BOOT_SWAP_TIME_DECL(var)
+#define BOOT_SWAP_TIME_START(var)
+#define BOOT_SWAP_TIME_END(field, var)
+#endif
+
 static struct {
     struct {
         struct image_header hdr;
@@ -482,7 +498,8 @@ done:
  * Validate image hash/signature in a slot.
  */
 static int
-boot_image_check(struct image_header *hdr, const struct flash_area *fap)
+boot_image_check(struct image_header *hdr, const struct flash_area *fap,
+                 uint8_t *out_hash)
 {
     static void *tmpbuf;
 
@@ -493,7 +510,7 @@ boot_image_check(struct image_header *hdr, const struct flash_area *fap)
         }
     }
     if (bootutil_img_validate(hdr, fap, tmpbuf, BOOT_TMPBUF_SZ,
-                              NULL, 0, NULL)) {
+                              NULL, 0, out_hash)) {
         return BOOT_EBADIMAGE;
     }
     return 0;
@@ -550,7 +567,7 @@ boot_validate_slot1(void)
     }
 
     if (boot_data.imgs[1].hdr.ih_magic != IMAGE_MAGIC ||
-        boot_image_check(&boot_data.imgs[1].hdr, fap) != 0) {
+        boot_image_check(&boot_data.imgs[1].hdr, fap, NULL) != 0) {
 
         /* Image in slot 1 is invalid.  Erase the image and continue booting
          * from slot 0.
@@ -565,6 +582,57 @@ boot_validate_slot1(void)
     return 0;
 }
 
+#if MYNEWT_VAL(BOOTUTIL_VALIDATE_SLOT0)
+/**
+ * Validates the image about to be booted from slot 0.  With
+ * BOOTUTIL_VALIDATE_CACHE, an image that was validated on an earlier boot is
+ * trusted without being hashed again.
+ *
+ * @param hdr                   The header of the image now in slot 0.
+ *
+ * @return                      0 if the image is valid; nonzero otherwise.
+ */
+static int
+boot_validate_slot0(struct image_header *hdr)
+{
+    const struct flash_area *fap;
+    uint8_t hash[32];
+    int rc;
+
+    if (hdr->ih_magic != IMAGE_MAGIC) {
+        return BOOT_EBADIMAGE;
+    }
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_0, &fap);
+    if (rc != 0) {
+        return BOOT_EFLASH;
+    }
+
+#if MYNEWT_VAL(BOOTUTIL_VALIDATE_CACHE)
+    if (bootutil_img_hash_tlv(hdr, fap, hash) == 0 &&
+        boot_read_validated(hdr, hash) == 0) {
+
+        rc = 0;
+        goto done;
+    }
+#endif
+
+    rc = boot_image_check(hdr, fap, hash);
+    if (rc != 0) {
+        goto done;
+    }
+
+#if MYNEWT_VAL(BOOTUTIL_VALIDATE_CACHE)
+    /* Failing to record the result only costs a rehash next boot. */
+    (void)boot_write_validated(hdr, hash);
+#endif
+
+done:
+    flash_area_close(fap);
+    return rc;
+}
+#endif
+
 /**
  * Determines which swap operation to perform, if any.  If it is determined
  * that a swap operation is required, the image in the second slot is checked
@@ -631,6 +699,52 @@ boot_copy_sz(int last_sector_idx, int *out_first_sector_idx)
     return sz;
 }
 
+#if MYNEWT_VAL(BOOTUTIL_SWAP_BLANK_CHECK)
+/**
+ * Indicates whether a region of flash is already in the erased state.
+ * Reading a region is far cheaper than erasing it, and during a swap the
+ * regions beyond the end of an image usually have not been written since
+ * they were last erased.
+ */
+static int
+boot_area_is_blank(const struct flash_area *fap, uint32_t off, uint32_t sz)
+{
+    const uint8_t *p;
+    uint8_t buf[64];
+    uint32_t chunk_sz;
+    uint32_t i;
+
+#if MYNEWT_VAL(BOOTUTIL_FLASH_MAP)
+    p = hal_flash_map(fap->fa_device_id, fap->fa_off + off, sz);
+    if (p != NULL) {
+        for (i = 0; i < sz; i++) {
+            if (p[i] != 0xff) {
+                return 0;
+            }
+        }
+        return 1;
+    }
+#endif
+
+    p = buf;
+    while (sz > 0) {
+        chunk_sz = sz < sizeof buf ? sz : sizeof buf;
+        if (flash_area_read(fap, off, buf, chunk_sz) != 0) {
+            return 0;
+        }
+        for (i = 0; i < chunk_sz; i++) {
+            if (p[i] != 0xff) {
+                return 0;
+            }
+        }
+        off += chunk_sz;
+        sz -= chunk_sz;
+    }
+
+    return 1;
+}
+#endif
+
 /**
  * Erases a region of flash.
  *
@@ -646,24 +760,37 @@ static int
 boot_erase_area(int flash_area_id, uint32_t off, uint32_t sz)
 {
     const struct flash_area *fap;
+    BOOT_SWAP_TIME_DECL(start);
     int rc;
 
+    BOOT_SWAP_TIME_START(start);
+
     rc = flash_area_open(flash_area_id, &fap);
     if (rc != 0) {
         rc = BOOT_EFLASH;
         goto done;
     }
 
+#if MYNEWT_VAL(BOOTUTIL_SWAP_BLANK_CHECK)
+    if (boot_area_is_blank(fap, off, sz)) {
+        BOOT_SWAP_STAT_ADD(bss_erase_skipped, sz);
+        rc = 0;
+        goto done;
+    }
+#endif
+
     rc = flash_area_erase(fap, off, sz);
     if (rc != 0) {
         rc = BOOT_EFLASH;
         goto done;
     }
+    BOOT_SWAP_STAT_ADD(bss_erased, sz);
 
     rc = 0;
 
 done:
     flash_area_close(fap);
+    BOOT_SWAP_TIME_END(bss_erase_ticks, start);
     return rc;
 }
 
@@ -688,10 +815,17 @@ boot_copy_area(int flash_area_id_src, int flash_area_id_dst,
     const struct flash_area *fap_src;
     const struct flash_area *fap_dst;
     uint32_t bytes_copied;
+#if MYNEWT_VAL(BOOTUTIL_FLASH_MAP)
+    const void *src;
+#endif
     int chunk_sz;
     int rc;
 
-    static uint8_t buf[1024];
+    static uint8_t buf[MYNEWT_VAL(BOOTUTIL_COPY_BUF_SIZE)];
+    BOOT_SWAP_TIME_DECL(start);
+
+    BOOT_SWAP_TIME_START(start);
+    BOOT_SWAP_STAT_ADD(bss_copied, sz);
 
     fap_src = NULL;
     fap_dst = NULL;
@@ -708,6 +842,18 @@ boot_copy_area(int flash_area_id_src, int flash_area_id_dst,
         goto done;
     }
 
+#if MYNEWT_VAL(BOOTUTIL_FLASH_MAP)
+    /* Memory-mapped sources are written straight to the destination. */
+    src = hal_flash_map(fap_src->fa_device_id, fap_src->fa_off + off_src, sz);
+    if (src != NULL) {
+        rc = flash_area_write(fap_dst, off_dst, src, sz);
+        if (rc != 0) {
+            rc = BOOT_EFLASH;
+        }
+        goto done;
+    }
+#endif
+
     bytes_copied = 0;
     while (bytes_copied < sz) {
         if (sz - bytes_copied > sizeof buf) {
@@ -736,9 +882,24 @@ boot_copy_area(int flash_area_id_src, int flash_area_id_dst,
 done:
     flash_area_close(fap_src);
     flash_area_close(fap_dst);
+    BOOT_SWAP_TIME_END(bss_copy_ticks, start);
     return rc;
 }
 
+/**
+ * Records swap progress.  A failed write is not fatal; the swap is just
+ * resumed from an earlier step after a reset.
+ */
+static void
+boot_swap_write_status(struct boot_status *bs)
+{
+    BOOT_SWAP_TIME_DECL(start);
+
+    BOOT_SWAP_TIME_START(start);
+    (void)boot_write_status(bs);
+    BOOT_SWAP_TIME_END(bss_status_ticks, start);
+}
+
 /**
  * Swaps the contents of two flash regions within the two image slots.
  *
@@ -774,7 +935,7 @@ boot_swap_areas(int idx, uint32_t sz, struct boot_status *bs)
         }
 
         bs->state = 1;
-        (void)boot_write_status(bs);
+        boot_swap_write_status(bs);
     }
     if (bs->state == 1) {
         rc = boot_erase_area(FLASH_AREA_IMAGE_1, img_off, sz);
@@ -799,7 +960,7 @@ boot_swap_areas(int idx, uint32_t sz, struct boot_status *bs)
         }
 
         bs->state = 2;
-        (void)boot_write_status(bs);
+        boot_swap_write_status(bs);
     }
     if (bs->state == 2) {
         rc = boot_erase_area(FLASH_AREA_IMAGE_0, img_off, sz);
@@ -815,12 +976,64 @@ boot_swap_areas(int idx, uint32_t sz, struct boot_status *bs)
 
         bs->idx++;
         bs->state = 0;
-        (void)boot_write_status(bs);
+        boot_swap_write_status(bs);
     }
 
     return 0;
 }
 
+#if MYNEWT_VAL(BOOTUTIL_SWAP_SKIP_EMPTY)
+/**
+ * Calculates the offset, from the start of a slot, beyond which neither
+ * slot holds image data.  If either slot lacks a valid header, its contents
+ * are unknown and the whole slot is swapped.
+ */
+static uint32_t
+boot_swap_img_end(void)
+{
+    const struct image_header *hdr;
+    uint32_t img_end;
+    uint32_t end;
+    int i;
+
+    img_end = 0;
+    for (i = 0; i < BOOT_NUM_SLOTS; i++) {
+        hdr = &boot_data.imgs[i].hdr;
+        if (hdr->ih_magic != IMAGE_MAGIC) {
+            return UINT32_MAX;
+        }
+
+        end = hdr->ih_hdr_size + hdr->ih_img_size + hdr->ih_tlv_size;
+        if (end > img_end) {
+            img_end = end;
+        }
+    }
+
+    return img_end;
+}
+
+/**
+ * Steps over a range of sectors that holds no image data in either slot.
+ * The status entries a swap of the range would have written are still
+ * written, so that the status remains contiguous and an interrupted swap
+ * resumes at the right place.
+ */
+static void
+boot_swap_skip(uint32_t sz, struct boot_status *bs)
+{
+    BOOT_SWAP_STAT_ADD(bss_swap_skipped, sz);
+
+    while (bs->state < BOOT_STATUS_STATE_COUNT - 1) {
+        bs->state++;
+        boot_swap_write_status(bs);
+    }
+
+    bs->idx++;
+    bs->state = 0;
+    boot_swap_write_status(bs);
+}
+#endif
+
 /**
  * Swaps the two images in flash.  If a prior copy operation was interrupted
  * by a system reset, this function completes that operation.
@@ -837,15 +1050,34 @@ static int
 boot_copy_image(struct boot_status *bs)
 {
     uint32_t sz;
+#if MYNEWT_VAL(BOOTUTIL_SWAP_SKIP_EMPTY)
+    uint32_t img_end;
+    uint32_t img_off;
+#endif
     int first_sector_idx;
     int last_sector_idx;
     int swap_idx;
 
+#if MYNEWT_VAL(BOOTUTIL_SWAP_SKIP_EMPTY)
+    img_end = boot_swap_img_end();
+#endif
+
+    bootutil_img_hash_cache_clear(FLASH_AREA_IMAGE_0);
+    bootutil_img_hash_cache_clear(FLASH_AREA_IMAGE_1);
+
     swap_idx = 0;
     last_sector_idx = boot_data.num_img_sectors - 1;
     while (last_sector_idx >= 0) {
         sz = boot_copy_sz(last_sector_idx, &first_sector_idx);
         if (swap_idx >= bs->idx) {
+#if MYNEWT_VAL(BOOTUTIL_SWAP_SKIP_EMPTY)
+            img_off = boot_data.imgs[0].sectors[first_sector_idx].fa_off -
+                      boot_data.imgs[0].sectors[0].fa_off;
+            if (swap_idx != 0 && img_off >= img_end) {
+                /* Nothing but free space on either side. */
+                boot_swap_skip(sz, bs);
+            } else
+#endif
             boot_swap_areas(first_sector_idx, sz, bs);
         }
 
@@ -1018,6 +1250,13 @@ boot_go(struct boot_rsp *rsp)
         break;
     }
 
+#if MYNEWT_VAL(BOOTUTIL_VALIDATE_SLOT0)
+    rc = boot_validate_slot0(&boot_data.imgs[slot].hdr);
+    if (rc != 0) {
+        return rc;
+    }
+#endif
+
     /* Always boot from the primary slot. */
     rsp->br_flash_id = boot_data.imgs[0].sectors[0].fa_device_id;
     rsp->br_image_addr = boot_data.imgs[0].sectors[0].fa_off;
@@ -51,6 +51,15 @@ TEST_CASE_DECL(boot_test_no_flag_has_hash)
 TEST_CASE_DECL(boot_test_invalid_hash)
 TEST_CASE_DECL(boot_test_revert)
 TEST_CASE_DECL(boot_test_revert_continue)
+#if MYNEWT_VAL(BOOTUTIL_VALIDATE_CACHE)
+TEST_CASE_DECL(boot_test_validate_cache)
+#endif
+#if MYNEWT_VAL(BOOTUTIL_SWAP_SKIP_EMPTY) && MYNEWT_VAL(BOOTUTIL_SWAP_STATS)
+TEST_CASE_DECL(boot_test_swap_skip)
+#endif
+#if MYNEWT_VAL(BOOTUTIL_HASH_CACHE) > 0
+TEST_CASE_DECL(boot_test_hash_cache)
+#endif
 
 TEST_SUITE(boot_test_main)
 {
@@ -71,6 +80,15 @@ TEST_SUITE(boot_test_main)
     boot_test_invalid_hash();
     boot_test_revert();
     boot_test_revert_continue();
+#if MYNEWT_VAL(BOOTUTIL_VALIDATE_CACHE)
+    boot_test_validate_cache();
+#endif
+#if MYNEWT_VAL(BOOTUTIL_SWAP_SKIP_EMPTY) && MYNEWT_VAL(BOOTUTIL_SWAP_STATS)
+    boot_test_swap_skip();
+#endif
+#if MYNEWT_VAL(BOOTUTIL_HASH_CACHE) > 0
+    boot_test_hash_cache();
+#endif
 }
 
 int
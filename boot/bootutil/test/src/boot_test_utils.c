@@ -73,6 +73,9 @@ boot_test_util_init_flash(void)
         rc = flash_area_erase(area_desc, 0, area_desc->fa_size);
         TEST_ASSERT(rc == 0);
     }
+
+    bootutil_img_hash_cache_clear(FLASH_AREA_IMAGE_0);
+    bootutil_img_hash_cache_clear(FLASH_AREA_IMAGE_1);
 }
 
 void
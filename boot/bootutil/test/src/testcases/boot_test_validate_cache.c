@@ -0,0 +1,77 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "boot_test.h"
+
+#if MYNEWT_VAL(BOOTUTIL_VALIDATE_CACHE)
+TEST_CASE(boot_test_validate_cache)
+{
+    const struct flash_area *fap;
+    uint8_t tlv_hash[32];
+    uint8_t hash[32];
+    uint8_t tmpbuf[BOOT_TMPBUF_SZ];
+    int rc;
+
+    struct image_header hdr = {
+        .ih_magic = IMAGE_MAGIC,
+        .ih_tlv_size = 4 + 32,
+        .ih_hdr_size = BOOT_TEST_HEADER_SIZE,
+        .ih_img_size = 12 * 1024,
+        .ih_flags = IMAGE_F_SHA256,
+        .ih_ver = { 0, 2, 3, 4 },
+    };
+
+    boot_test_util_init_flash();
+    boot_test_util_write_image(&hdr, 0);
+    boot_test_util_write_hash(&hdr, 0);
+
+    rc = flash_area_open(FLASH_AREA_IMAGE_0, &fap);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = bootutil_img_validate(&hdr, fap, tmpbuf, sizeof tmpbuf, NULL, 0,
+                               hash);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* The TLV hash is read without hashing the image. */
+    rc = bootutil_img_hash_tlv(&hdr, fap, tlv_hash);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(memcmp(tlv_hash, hash, sizeof hash) == 0);
+
+    /* Nothing recorded yet. */
+    TEST_ASSERT(boot_read_validated(&hdr, hash) != 0);
+
+    rc = boot_write_validated(&hdr, hash);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(boot_read_validated(&hdr, hash) == 0);
+
+    /* A different image is not trusted. */
+    tlv_hash[0] ^= 0xff;
+    TEST_ASSERT(boot_read_validated(&hdr, tlv_hash) != 0);
+    hdr.ih_img_size += 4;
+    TEST_ASSERT(boot_read_validated(&hdr, hash) != 0);
+    hdr.ih_img_size -= 4;
+
+    /* Recording again replaces the previous record. */
+    rc = boot_write_validated(&hdr, tlv_hash);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(boot_read_validated(&hdr, tlv_hash) == 0);
+    TEST_ASSERT(boot_read_validated(&hdr, hash) != 0);
+
+    flash_area_close(fap);
+}
+#endif
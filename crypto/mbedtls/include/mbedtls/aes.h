@@ -271,6 +271,25 @@ void mbedtls_aes_decrypt( mbedtls_aes_context *ctx,
                           const unsigned char input[16],
                           unsigned char output[16] );
 
+#if defined(MBEDTLS_AES_HW_ENCRYPT)
+/**
+ * \brief           Block encryption on a hardware engine, supplied by the
+ *                  MCU package.  mbedtls_aes_encrypt() tries it first and
+ *                  uses the software rounds if it returns non-zero, e.g.
+ *                  for key sizes the engine does not handle.
+ *
+ * \param nr        Number of rounds (10, 12 or 14)
+ * \param rk        Expanded encryption key; rk[0..3] is the cipher key
+ * \param input     Plaintext block
+ * \param output    Output (ciphertext) block
+ *
+ * \return          0 if the block was encrypted
+ */
+int mbedtls_aes_hw_encrypt( int nr, const uint32_t *rk,
+                            const unsigned char input[16],
+                            unsigned char output[16] );
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -46,6 +46,12 @@ extern "C" {
 
 #define MBEDTLS_SHA256_SMALLER		/* comes with performance hit */
 
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(MBEDTLS_AES_HW_ENCRYPT)
+#define MBEDTLS_AES_HW_ENCRYPT		/* see mbedtls_aes_hw_encrypt() */
+#endif
+
 /**
  * \name SECTION: Module configuration options
  *
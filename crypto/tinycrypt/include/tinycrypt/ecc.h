@@ -275,6 +275,16 @@ void EccPoint_add(EccPointJacobi *P1, EccPointJacobi *P2);
 void EccPoint_mult(EccPointJacobi *p_result, EccPoint *p_point,
 		uint32_t *p_scalar);
 
+/*
+ * @brief Scalar multiplication of the curve base point, with result in
+ * Jacobi coordinates. Gives the same result as EccPoint_mult() on curve_G,
+ * using a precomputed comb table for roughly a quarter of the doublings.
+ *
+ * @param p_result OUT -- Product of curve_G by p_scalar.
+ * @param p_scalar IN -- Scalar integer
+ */
+void EccPoint_mult_base(EccPointJacobi *p_result, uint32_t *p_scalar);
+
 /*
  * @brief Convert an integer in standard octet representation to native format.
  * @return returns TC_SUCCESS (1)
@@ -85,6 +85,76 @@ uint32_t curve_n[NUM_ECC_DIGITS] = Curve_N;
 uint32_t curve_pb[NUM_ECC_DIGITS + 1] = Curve_P_Barrett;
 uint32_t curve_nb[NUM_ECC_DIGITS + 1] = Curve_N_Barrett;
 
+/*
+ * Fixed-base comb table for curve_G: entry b - 1 holds
+ * sum(2^(64 j) G) over the bits j set in b, in affine coordinates.
+ */
+#define ECC_COMB_TEETH 4
+#define ECC_COMB_SPACING (NUM_ECC_DIGITS * 32 / ECC_COMB_TEETH)
+
+static const EccPoint curve_G_comb[(1 << ECC_COMB_TEETH) - 1] = {
+	/*  1 */ {{0xD898C296, 0xF4A13945, 0x2DEB33A0, 0x77037D81,
+		  0x63A440F2, 0xF8BCE6E5, 0xE12C4247, 0x6B17D1F2},
+		 {0x37BF51F5, 0xCBB64068, 0x6B315ECE, 0x2BCE3357,
+		  0x7C0F9E16, 0x8EE7EB4A, 0xFE1A7F9B, 0x4FE342E2} },
+	/*  2 */ {{0x8E14DB63, 0x90E75CB4, 0xAD651F7E, 0x29493BAA,
+		  0x326E25DE, 0x8492592E, 0x2811AAA5, 0x0FA822BC},
+		 {0x5F462EE7, 0xE4112454, 0x50FE82F5, 0x34B1A650,
+		  0xB3DF188B, 0x6F4AD4BC, 0xF5DBA80D, 0xBFF44AE8} },
+	/*  3 */ {{0x097992AF, 0x93391CE2, 0x0D35F1FA, 0xE96C98FD,
+		  0x95E02789, 0xB257C0DE, 0x89D6726F, 0x300A4BBC},
+		 {0xC08127A0, 0xAA54A291, 0xA9D806A5, 0x5BB1EEAD,
+		  0xFF1E3C6F, 0x7F1DDB25, 0xD09B4644, 0x72AAC7E0} },
+	/*  4 */ {{0xD789BD85, 0x57C84FC9, 0xC297EAC3, 0xFC35FF7D,
+		  0x88C6766E, 0xFB982FD5, 0xEEDB5E67, 0x447D739B},
+		 {0x72E25B32, 0x0C7E33C9, 0xA7FAE500, 0x3D349B95,
+		  0x3A4AAFF7, 0xE12E9D95, 0x834131EE, 0x2D4825AB} },
+	/*  5 */ {{0x2A1D367F, 0x13949C93, 0x1A0A11B7, 0xEF7FBD2B,
+		  0xB91DFC60, 0xDDC6068B, 0x8A9C72FF, 0xEF951932},
+		 {0x7376D8A8, 0x196035A7, 0x95CA1740, 0x23183B08,
+		  0x022C219C, 0xC1EE9807, 0x7DBB2C9B, 0x611E9FC3} },
+	/*  6 */ {{0x0B57F4BC, 0xCAE2B192, 0xC6C9BC36, 0x2936DF5E,
+		  0xE11238BF, 0x7DEA6482, 0x7B51F5D8, 0x55066379},
+		 {0x348A964C, 0x44FFE216, 0xDBDEFBE1, 0x9FB3D576,
+		  0x8D9D50E5, 0x0AFA4001, 0x8AECB851, 0x15716484} },
+	/*  7 */ {{0xFC5CDE01, 0xE48ECAFF, 0x0D715F26, 0x7CCD84E7,
+		  0xF43E4391, 0xA2E8F483, 0xB21141EA, 0xEB5D7745},
+		 {0x731A3479, 0xCAC917E2, 0x2844B645, 0x85F22CFE,
+		  0x58006CEE, 0x0990E6A1, 0xDBECC17B, 0xEAFD72EB} },
+	/*  8 */ {{0x313728BE, 0x6CF20FFB, 0xA3C6B94A, 0x96439591,
+		  0x44315FC5, 0x2736FF83, 0xA7849276, 0xA6D39677},
+		 {0xC357F5F4, 0xF2BAB833, 0x2284059B, 0x824A920C,
+		  0x2D27ECDF, 0x66B8BABD, 0x9B0B8816, 0x674F8474} },
+	/*  9 */ {{0x677C8A3E, 0x2DF48C04, 0x0203A56B, 0x74E02F08,
+		  0xB8C7FEDB, 0x31855F7D, 0x72C9DDAD, 0x4E769E76},
+		 {0xB824BBB0, 0xA4C36165, 0x3B9122A5, 0xFB9AE16F,
+		  0x06947281, 0x1EC00572, 0xDE830663, 0x42B99082} },
+	/* 10 */ {{0xDDA868B9, 0x6EF95150, 0x9C0CE131, 0xD1F89E79,
+		  0x08A1C478, 0x7FDC1CA0, 0x1C6CE04D, 0x78878EF6},
+		 {0x1FE0D976, 0x9C62B912, 0xBDE08D4F, 0x6ACE570E,
+		  0x12309DEF, 0xDE53142C, 0x7B72C321, 0xB6CB3F5D} },
+	/* 11 */ {{0xC31A3573, 0x7F991ED2, 0xD54FB496, 0x5B82DD5B,
+		  0x812FFCAE, 0x595C5220, 0x716B1287, 0x0C88BC4D},
+		 {0x5F48ACA8, 0x3A57BF63, 0xDF2564F3, 0x7C8181F4,
+		  0x9C04E6AA, 0x18D1B5B3, 0xF3901DC6, 0xDD5DDEA3} },
+	/* 12 */ {{0x3E72AD0C, 0xE96A79FB, 0x42BA792F, 0x43A0A28C,
+		  0x083E49F3, 0xEFE0A423, 0x6B317466, 0x68F344AF},
+		 {0x3FB24D4A, 0xCDFE17DB, 0x71F5C626, 0x668BFC22,
+		  0x24D67FF3, 0x604ED93C, 0xF8540A20, 0x31B9C405} },
+	/* 13 */ {{0xA2582E7F, 0xD36B4789, 0x4EC39C28, 0x0D1A1014,
+		  0xEDBAD7A0, 0x663C62C3, 0x6F461DB9, 0x4052BF4B},
+		 {0x188D25EB, 0x235A27C3, 0x99BFCC5B, 0xE724F339,
+		  0x71D70CC8, 0x862BE6BD, 0x90B0FC61, 0xFECF4D51} },
+	/* 14 */ {{0xA1D4CFAC, 0x74346C10, 0x8526A7A4, 0xAFDF5CC0,
+		  0xF62BFF7A, 0x123202A8, 0xC802E41A, 0x1EDDBAE2},
+		 {0xD603F844, 0x8FA0AF2D, 0x4C701917, 0x36E06B7E,
+		  0x73DB33A0, 0x0C45F452, 0x560EBCFC, 0x43104D86} },
+	/* 15 */ {{0x0D1D78E5, 0x9615B511, 0x25C4744B, 0x66B0DE32,
+		  0x6AAF363A, 0x0A4A46FB, 0x84F7A21C, 0xB48E26B4},
+		 {0x21A01B2D, 0x06EBB0F6, 0x8B7B0F98, 0xC004E404,
+		  0xFED6F668, 0x64131BCD, 0x4D4D3DAB, 0xFAC01540} }
+};
+
 /* ------ Static functions: ------ */
 
 /* Zeroing out p_vli. */
@@ -174,13 +244,44 @@ static uint32_t vli_add(uint32_t *p_result, uint32_t *p_left,
 }
 
 
+/*
+ * Computes (r2:r1:r0) += p_a * p_b.
+ *
+ * This is the inner step of the multiply and square loops, so on Cortex-M3
+ * and M4 it is done with a single UMULL and a three register add with carry
+ * rather than leaving the compiler to rebuild the carry out of 64-bit
+ * compares.
+ */
+static inline void vli_muladd(uint32_t p_a, uint32_t p_b, uint32_t *r0,
+			      uint32_t *r1, uint32_t *r2)
+{
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+	uint32_t lo, hi;
+
+	__asm__ ("umull %0, %1, %5, %6\n\t"
+		 "adds  %2, %2, %0\n\t"
+		 "adcs  %3, %3, %1\n\t"
+		 "adc   %4, %4, #0\n\t"
+		 : "=&r" (lo), "=&r" (hi), "+r" (*r0), "+r" (*r1), "+r" (*r2)
+		 : "r" (p_a), "r" (p_b)
+		 : "cc");
+#else
+	uint64_t l_product = (uint64_t)p_a * p_b;
+	uint64_t r01 = ((uint64_t)*r1 << 32) | *r0;
+
+	r01 += l_product;
+	*r2 += (r01 < l_product);
+	*r1 = r01 >> 32;
+	*r0 = (uint32_t)r01;
+#endif
+}
+
 /* Computes p_result = p_left * p_right. */
 static void vli_mult(uint32_t *p_result, uint32_t *p_left,
 		     uint32_t *p_right, uint32_t word_size)
 {
 
-	uint64_t r01 = 0;
-	uint32_t r2 = 0;
+	uint32_t r0 = 0, r1 = 0, r2 = 0;
 
 	/* Compute each digit of p_result in sequence, maintaining the carries. */
 	for (uint32_t k = 0; k < word_size*2 - 1; ++k) {
@@ -188,26 +289,22 @@ static void vli_mult(uint32_t *p_result, uint32_t *p_left,
 		uint32_t l_min = (k < word_size ? 0 : (k + 1) - word_size);
 
 		for (uint32_t i = l_min; i <= k && i < word_size; ++i) {
-
-			uint64_t l_product = (uint64_t)p_left[i] * p_right[k - i];
-
-			r01 += l_product;
-			r2 += (r01 < l_product);
+			vli_muladd(p_left[i], p_right[k - i], &r0, &r1, &r2);
 		}
-		p_result[k] = (uint32_t)r01;
-		r01 = (r01 >> 32) | (((uint64_t)r2) << 32);
+		p_result[k] = r0;
+		r0 = r1;
+		r1 = r2;
 		r2 = 0;
 	}
 
-	p_result[word_size * 2 - 1] = (uint32_t)r01;
+	p_result[word_size * 2 - 1] = r0;
 }
 
 /* Computes p_result = p_left^2. */
 static void vli_square(uint32_t *p_result, uint32_t *p_left)
 {
 
-	uint64_t r01 = 0;
-	uint32_t r2 = 0;
+	uint32_t r0 = 0, r1 = 0, r2 = 0;
 	uint32_t i, k;
 
 	for (k = 0; k < NUM_ECC_DIGITS * 2 - 1; ++k) {
@@ -215,23 +312,127 @@ static void vli_square(uint32_t *p_result, uint32_t *p_left)
 		uint32_t l_min = (k < NUM_ECC_DIGITS ? 0 : (k + 1) - NUM_ECC_DIGITS);
 
 		for (i = l_min; i <= k && i <= k - i; ++i) {
-
-			uint64_t l_product = (uint64_t)p_left[i] * p_left[k - i];
-
+			vli_muladd(p_left[i], p_left[k - i], &r0, &r1, &r2);
 			if (i < k - i) {
-
-				r2 += l_product >> 63;
-				l_product *= 2;
+				vli_muladd(p_left[i], p_left[k - i], &r0, &r1, &r2);
 			}
-			r01 += l_product;
-			r2 += (r01 < l_product);
 		}
-		p_result[k] = (uint32_t)r01;
-		r01 = (r01 >> 32) | (((uint64_t)r2) << 32);
+		p_result[k] = r0;
+		r0 = r1;
+		r1 = r2;
 		r2 = 0;
 	}
 
-	p_result[NUM_ECC_DIGITS * 2 - 1] = (uint32_t)r01;
+	p_result[NUM_ECC_DIGITS * 2 - 1] = r0;
+}
+
+/*
+ * Computes p_result = p_product % curve_p.
+ *
+ * Uses the special form of the P-256 prime (FIPS 186-3, D.2.3): the high half
+ * of the product is folded back in with a handful of word-shuffled additions
+ * and subtractions, which is several times cheaper than the two
+ * multiplications Barrett reduction needs.
+ */
+static void vli_mmod_fast(uint32_t *p_result, uint32_t *p_product)
+{
+	uint32_t tmp[NUM_ECC_DIGITS];
+	int32_t carry;
+
+	/* t */
+	vli_set(p_result, p_product);
+
+	/* s1 */
+	tmp[0] = tmp[1] = tmp[2] = 0;
+	tmp[3] = p_product[11];
+	tmp[4] = p_product[12];
+	tmp[5] = p_product[13];
+	tmp[6] = p_product[14];
+	tmp[7] = p_product[15];
+	carry = vli_add(tmp, tmp, tmp);
+	carry += vli_add(p_result, p_result, tmp);
+
+	/* s2 */
+	tmp[3] = p_product[12];
+	tmp[4] = p_product[13];
+	tmp[5] = p_product[14];
+	tmp[6] = p_product[15];
+	tmp[7] = 0;
+	carry += vli_add(tmp, tmp, tmp);
+	carry += vli_add(p_result, p_result, tmp);
+
+	/* s3 */
+	tmp[0] = p_product[8];
+	tmp[1] = p_product[9];
+	tmp[2] = p_product[10];
+	tmp[3] = tmp[4] = tmp[5] = 0;
+	tmp[6] = p_product[14];
+	tmp[7] = p_product[15];
+	carry += vli_add(p_result, p_result, tmp);
+
+	/* s4 */
+	tmp[0] = p_product[9];
+	tmp[1] = p_product[10];
+	tmp[2] = p_product[11];
+	tmp[3] = p_product[13];
+	tmp[4] = p_product[14];
+	tmp[5] = p_product[15];
+	tmp[6] = p_product[13];
+	tmp[7] = p_product[8];
+	carry += vli_add(p_result, p_result, tmp);
+
+	/* d1 */
+	tmp[0] = p_product[11];
+	tmp[1] = p_product[12];
+	tmp[2] = p_product[13];
+	tmp[3] = tmp[4] = tmp[5] = 0;
+	tmp[6] = p_product[8];
+	tmp[7] = p_product[10];
+	carry -= vli_sub(p_result, p_result, tmp, NUM_ECC_DIGITS);
+
+	/* d2 */
+	tmp[0] = p_product[12];
+	tmp[1] = p_product[13];
+	tmp[2] = p_product[14];
+	tmp[3] = p_product[15];
+	tmp[4] = tmp[5] = 0;
+	tmp[6] = p_product[9];
+	tmp[7] = p_product[11];
+	carry -= vli_sub(p_result, p_result, tmp, NUM_ECC_DIGITS);
+
+	/* d3 */
+	tmp[0] = p_product[13];
+	tmp[1] = p_product[14];
+	tmp[2] = p_product[15];
+	tmp[3] = p_product[8];
+	tmp[4] = p_product[9];
+	tmp[5] = p_product[10];
+	tmp[6] = 0;
+	tmp[7] = p_product[12];
+	carry -= vli_sub(p_result, p_result, tmp, NUM_ECC_DIGITS);
+
+	/* d4 */
+	tmp[0] = p_product[14];
+	tmp[1] = p_product[15];
+	tmp[2] = 0;
+	tmp[3] = p_product[9];
+	tmp[4] = p_product[10];
+	tmp[5] = p_product[11];
+	tmp[6] = 0;
+	tmp[7] = p_product[13];
+	carry -= vli_sub(p_result, p_result, tmp, NUM_ECC_DIGITS);
+
+	/* carry is now in [-4, 6]; bring the result back into [0, p). */
+	if (carry < 0) {
+		do {
+			carry += vli_add(p_result, p_result, curve_p);
+		} while (carry < 0);
+	} else {
+		while (carry || vli_cmp(curve_p, p_result, NUM_ECC_DIGITS) != 1) {
+			carry -= vli_sub(p_result, p_result, curve_p,
+					 NUM_ECC_DIGITS);
+		}
+	}
 }
 
 /* Computes p_result = p_product % curve_p using Barrett reduction. */
@@ -279,6 +480,17 @@ static void vli_mmod_barrett(uint32_t *p_result, uint32_t *p_product,
 	}
 }
 
+/* Computes p_result = p_product % p_mod, using the fast path for curve_p. */
+static void vli_mmod(uint32_t *p_result, uint32_t *p_product,
+		     uint32_t *p_mod, uint32_t *p_barrett)
+{
+	if (p_mod == curve_p) {
+		vli_mmod_fast(p_result, p_product);
+	} else {
+		vli_mmod_barrett(p_result, p_product, p_mod, p_barrett);
+	}
+}
+
 /*
  * Computes modular exponentiation.
  *
@@ -298,9 +510,9 @@ static void vli_modExp(uint32_t *p_result, uint32_t *p_base,
 	for (i = NUM_ECC_DIGITS - 1; i >= 0; i--) {
 		for (j = 1 << 31; j > 0; j = j >> 1) {
 			vli_square(product, acc);
-			vli_mmod_barrett(acc, product, p_mod, p_barrett);
+			vli_mmod(acc, product, p_mod, p_barrett);
 			vli_mult(product, acc, p_base, NUM_ECC_DIGITS);
-			vli_mmod_barrett(tmp, product, p_mod, p_barrett);
+			vli_mmod(tmp, product, p_mod, p_barrett);
 			vli_cond_set(acc, tmp, acc, j & p_exp[i]);
 		}
 	}
@@ -439,7 +651,7 @@ void vli_modMult_fast(uint32_t *p_result, uint32_t *p_left,
 	uint32_t l_product[2 * NUM_ECC_DIGITS];
 
 	vli_mult(l_product, p_left, p_right, NUM_ECC_DIGITS);
-	vli_mmod_barrett(p_result, l_product, curve_p, curve_pb);
+	vli_mmod_fast(p_result, l_product);
 }
 
 void vli_modSquare_fast(uint32_t *p_result, uint32_t *p_left)
@@ -447,7 +659,7 @@ void vli_modSquare_fast(uint32_t *p_result, uint32_t *p_left)
 	uint32_t l_product[2 * NUM_ECC_DIGITS];
 
 	vli_square(l_product, p_left);
-	vli_mmod_barrett(p_result, l_product, curve_p, curve_pb);
+	vli_mmod_fast(p_result, l_product);
 }
 
 void vli_modMult(uint32_t *p_result, uint32_t *p_left, uint32_t *p_right,
@@ -457,7 +669,7 @@ void vli_modMult(uint32_t *p_result, uint32_t *p_left, uint32_t *p_right,
 	uint32_t l_product[2 * NUM_ECC_DIGITS];
 
 	vli_mult(l_product, p_left, p_right, NUM_ECC_DIGITS);
-	vli_mmod_barrett(p_result, l_product, p_mod, p_barrett);
+	vli_mmod(p_result, l_product, p_mod, p_barrett);
 }
 
 void vli_modInv(uint32_t *p_result, uint32_t *p_input, uint32_t *p_mod,
@@ -568,6 +780,59 @@ void EccPoint_mult(EccPointJacobi *p_result, EccPoint *p_point, uint32_t *p_scal
 	}
 }
 
+/*
+ * Fixed-base scalar multiplication with result in Jacobi coordinates:
+ *
+ * p_result = p_scalar * curve_G.
+ *
+ * Side-channel countermeasure: every table entry is read on each step and
+ * the additions are always performed, the result being picked with
+ * vli_cond_set.
+ */
+void EccPoint_mult_base(EccPointJacobi *p_result, uint32_t *p_scalar)
+{
+
+	int32_t i;
+	uint32_t b, j, idx, is_inf;
+	EccPointJacobi p_comb, p_tmp;
+
+	vli_clear(p_result->X);
+	vli_clear(p_result->Y);
+	vli_clear(p_result->Z);
+	vli_clear(p_comb.Z);
+	p_comb.Z[0] = 1;
+
+	for (i = ECC_COMB_SPACING - 1; i >= 0; i--) {
+		idx = 0;
+		for (j = 0; j < ECC_COMB_TEETH; j++) {
+			idx |= !!vli_testBit(p_scalar, i + j * ECC_COMB_SPACING) << j;
+		}
+
+		vli_clear(p_comb.X);
+		vli_clear(p_comb.Y);
+		for (b = 1; b < (1 << ECC_COMB_TEETH); b++) {
+			vli_cond_set(p_comb.X, (uint32_t *)curve_G_comb[b - 1].x,
+				     p_comb.X, b == idx);
+			vli_cond_set(p_comb.Y, (uint32_t *)curve_G_comb[b - 1].y,
+				     p_comb.Y, b == idx);
+		}
+
+		EccPoint_double(p_result);
+		EccPointJacobi_set(&p_tmp, p_result);
+		EccPoint_add(&p_tmp, &p_comb);
+
+		/* Adding to the point at infinity yields the table entry. */
+		is_inf = vli_isZero(p_result->Z);
+		vli_cond_set(p_tmp.X, p_comb.X, p_tmp.X, is_inf);
+		vli_cond_set(p_tmp.Y, p_comb.Y, p_tmp.Y, is_inf);
+		vli_cond_set(p_tmp.Z, p_comb.Z, p_tmp.Z, is_inf);
+
+		vli_cond_set(p_result->X, p_tmp.X, p_result->X, idx);
+		vli_cond_set(p_result->Y, p_tmp.Y, p_result->Y, idx);
+		vli_cond_set(p_result->Z, p_tmp.Z, p_result->Z, idx);
+	}
+}
+
 /* -------- Conversions between big endian and little endian: -------- */
 
 void ecc_bytes2native(uint32_t p_native[NUM_ECC_DIGITS],
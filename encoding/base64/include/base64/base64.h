@@ -33,6 +33,45 @@ int base64_decode_len(const char *str);
 
 #define BASE64_ENCODE_SIZE(__size) (((((__size) - 1) / 3) * 4) + 4)
 
+/* Upper bound on the bytes decoded from __len characters. */
+#define BASE64_DECODE_SIZE(__len) (((__len) / 4) * 3)
+
+/*
+ * Streaming encoder, for data which is not contiguous (e.g. an mbuf chain
+ * walked one buffer at a time).  base64_encoder_update() writes whole
+ * 4 character groups only, at most BASE64_ENCODE_SIZE(len + 2) characters,
+ * and keeps up to 2 bytes for the next call.  base64_encoder_finish()
+ * writes the last group, if any, and a terminating null.  The output is the
+ * same as base64_encode() over the concatenated input.
+ */
+struct base64_encoder {
+    uint8_t be_buf[3];
+    uint8_t be_len;
+};
+
+void base64_encoder_init(struct base64_encoder *be);
+int base64_encoder_update(struct base64_encoder *be, const void *data,
+                          int len, char *s);
+int base64_encoder_finish(struct base64_encoder *be, char *s,
+                          uint8_t should_pad);
+
+/*
+ * Streaming decoder.  Input may be split anywhere; an incomplete token is
+ * kept for the next call.  base64_decoder_update() writes at most
+ * BASE64_DECODE_SIZE(len + 3) bytes and returns the number written, or -1 on
+ * malformed input.  base64_decoder_finish() returns -1 if input ended in the
+ * middle of a token.
+ */
+struct base64_decoder {
+    char bd_buf[4];
+    uint8_t bd_len;
+};
+
+void base64_decoder_init(struct base64_decoder *bd);
+int base64_decoder_update(struct base64_decoder *bd, const char *s, int len,
+                          void *data);
+int base64_decoder_finish(struct base64_decoder *bd);
+
 #ifdef __cplusplus
 }
 #endif
@@ -51,55 +51,85 @@ static const char base64_chars[] =
 static int
 pos(char c)
 {
-    const char *p;
-    for (p = base64_chars; *p; p++)
-        if (*p == c)
-            return p - base64_chars;
+    if (c >= 'A' && c <= 'Z') {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9') {
+        return c - '0' + 52;
+    }
+    if (c == '+') {
+        return 62;
+    }
+    if (c == '/') {
+        return 63;
+    }
     return -1;
 }
 
+/*
+ * Encodes 'size' (at most 3) trailing bytes.
+ */
+static char *
+base64_encode_tail(const unsigned char *q, int size, char *p,
+                   uint8_t should_pad)
+{
+    int c;
+
+    c = q[0] << 16;
+    if (size > 1) {
+        c |= q[1] << 8;
+    }
+    if (size > 2) {
+        c |= q[2];
+    }
+    p[0] = base64_chars[(c >> 18) & 0x3f];
+    p[1] = base64_chars[(c >> 12) & 0x3f];
+    p[2] = base64_chars[(c >> 6) & 0x3f];
+    p[3] = base64_chars[c & 0x3f];
+    if (size < 3) {
+        if (should_pad) {
+            memset(p + size + 1, '=', 3 - size);
+        } else {
+            return p + size + 1;
+        }
+    }
+    return p + 4;
+}
+
+/*
+ * Encodes whole 3 byte groups, returns the end of the output.
+ */
+static char *
+base64_encode_blocks(const unsigned char *q, int size, char *p)
+{
+    int c;
+
+    for (; size >= 3; size -= 3, q += 3, p += 4) {
+        c = (q[0] << 16) | (q[1] << 8) | q[2];
+        p[0] = base64_chars[c >> 18];
+        p[1] = base64_chars[(c >> 12) & 0x3f];
+        p[2] = base64_chars[(c >> 6) & 0x3f];
+        p[3] = base64_chars[c & 0x3f];
+    }
+    return p;
+}
+
 int
 base64_encode(const void *data, int size, char *s, uint8_t should_pad)
 {
-    char *p;
-    int i;
-    int c;
     const unsigned char *q;
-    char *last;
-    int diff;
-
-    p = s;
+    int full;
+    char *p;
 
     q = (const unsigned char *) data;
-    last = NULL;
-    i = 0;
-    while (i < size) {
-        c = q[i++];
-        c *= 256;
-        if (i < size)
-            c += q[i];
-        i++;
-        c *= 256;
-        if (i < size)
-            c += q[i];
-        i++;
-        p[0] = base64_chars[(c & 0x00fc0000) >> 18];
-        p[1] = base64_chars[(c & 0x0003f000) >> 12];
-        p[2] = base64_chars[(c & 0x00000fc0) >> 6];
-        p[3] = base64_chars[(c & 0x0000003f) >> 0];
-        last = p;
-        p += 4;
-    }
-
-    if (last) {
-        diff = i - size;
-        if (diff > 0) {
-            if (should_pad) {
-                memset(last + (4 - diff), '=', diff);
-            } else {
-                p = last + (4 - diff);
-            }
-        }
+    full = size - size % 3;
+
+    p = base64_encode_blocks(q, full, s);
+    if (size > full) {
+        p = base64_encode_tail(q + full, size - full, p, should_pad);
     }
 
     *p = 0;
@@ -124,26 +154,46 @@ base64_pad(char *buf, int len)
 
 #define DECODE_ERROR -1
 
-static unsigned int
-token_decode(const char *token)
+/*
+ * Decodes one 4 character token into q.  Returns the number of bytes
+ * written, or DECODE_ERROR.
+ */
+static int
+token_decode(const char *token, unsigned char *q)
 {
+    unsigned int val;
+    int marker;
+    int c;
     int i;
-    unsigned int val = 0;
-    int marker = 0;
-    if (strlen(token) < 4)
-        return DECODE_ERROR;
+
+    val = 0;
+    marker = 0;
     for (i = 0; i < 4; i++) {
-        val *= 64;
-        if (token[i] == '=')
+        val <<= 6;
+        if (token[i] == '=') {
             marker++;
-        else if (marker > 0)
+        } else if (marker > 0) {
             return DECODE_ERROR;
-        else
-            val += pos(token[i]);
+        } else {
+            c = pos(token[i]);
+            if (c < 0) {
+                return DECODE_ERROR;
+            }
+            val |= c;
+        }
     }
-    if (marker > 2)
+    if (marker > 2) {
         return DECODE_ERROR;
-    return (marker << 24) | val;
+    }
+
+    q[0] = (val >> 16) & 0xff;
+    if (marker < 2) {
+        q[1] = (val >> 8) & 0xff;
+    }
+    if (marker < 1) {
+        q[2] = val & 0xff;
+    }
+    return 3 - marker;
 }
 
 int
@@ -151,18 +201,22 @@ base64_decode(const char *str, void *data)
 {
     const char *p;
     unsigned char *q;
+    int rc;
 
+    /*
+     * Output never overtakes the input, so str and data may be the same
+     * buffer.
+     */
     q = data;
-    for (p = str; *p && (*p == '=' || strchr(base64_chars, *p)); p += 4) {
-        unsigned int val = token_decode(p);
-        unsigned int marker = (val >> 24) & 0xff;
-        if (val == DECODE_ERROR)
+    for (p = str; *p && (*p == '=' || pos(*p) >= 0); p += 4) {
+        if (!p[1] || !p[2] || !p[3]) {
             return -1;
-        *q++ = (val >> 16) & 0xff;
-        if (marker < 2)
-            *q++ = (val >> 8) & 0xff;
-        if (marker < 1)
-            *q++ = val & 0xff;
+        }
+        rc = token_decode(p, q);
+        if (rc == DECODE_ERROR) {
+            return -1;
+        }
+        q += rc;
     }
     return q - (unsigned char *) data;
 }
@@ -179,3 +233,113 @@ base64_decode_len(const char *str)
     }
     return len * 3 / 4;
 }
+
+void
+base64_encoder_init(struct base64_encoder *be)
+{
+    be->be_len = 0;
+}
+
+int
+base64_encoder_update(struct base64_encoder *be, const void *data, int len,
+                      char *s)
+{
+    const unsigned char *q;
+    char *p;
+    int full;
+
+    q = data;
+    p = s;
+
+    /* Complete a group left over from the previous call. */
+    if (be->be_len) {
+        while (be->be_len < 3 && len > 0) {
+            be->be_buf[be->be_len++] = *q++;
+            len--;
+        }
+        if (be->be_len < 3) {
+            return 0;
+        }
+        p = base64_encode_blocks(be->be_buf, 3, p);
+        be->be_len = 0;
+    }
+
+    full = len - len % 3;
+    p = base64_encode_blocks(q, full, p);
+
+    memcpy(be->be_buf, q + full, len - full);
+    be->be_len = len - full;
+
+    return p - s;
+}
+
+int
+base64_encoder_finish(struct base64_encoder *be, char *s, uint8_t should_pad)
+{
+    char *p;
+
+    p = s;
+    if (be->be_len) {
+        p = base64_encode_tail(be->be_buf, be->be_len, p, should_pad);
+        be->be_len = 0;
+    }
+    *p = 0;
+
+    return p - s;
+}
+
+void
+base64_decoder_init(struct base64_decoder *bd)
+{
+    bd->bd_len = 0;
+}
+
+int
+base64_decoder_update(struct base64_decoder *bd, const char *s, int len,
+                      void *data)
+{
+    unsigned char *q;
+    int rc;
+
+    q = data;
+
+    /* Complete a token left over from the previous call. */
+    if (bd->bd_len) {
+        while (bd->bd_len < 4 && len > 0) {
+            bd->bd_buf[bd->bd_len++] = *s++;
+            len--;
+        }
+        if (bd->bd_len < 4) {
+            return 0;
+        }
+        rc = token_decode(bd->bd_buf, q);
+        if (rc == DECODE_ERROR) {
+            return -1;
+        }
+        q += rc;
+        bd->bd_len = 0;
+    }
+
+    for (; len >= 4; len -= 4, s += 4) {
+        rc = token_decode(s, q);
+        if (rc == DECODE_ERROR) {
+            return -1;
+        }
+        q += rc;
+    }
+
+    memcpy(bd->bd_buf, s, len);
+    bd->bd_len = len;
+
+    return q - (unsigned char *) data;
+}
+
+int
+base64_decoder_finish(struct base64_decoder *bd)
+{
+    if (bd->bd_len) {
+        bd->bd_len = 0;
+        return -1;
+    }
+    return 0;
+}
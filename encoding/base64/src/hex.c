@@ -18,13 +18,25 @@
  */
 
 #include <inttypes.h>
-#include <ctype.h>
 #include <stddef.h>
 
 #include "base64/hex.h"
 
 static const char hex_bytes[] = "0123456789abcdef";
 
+static int
+hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c |= 0x20; /* lower case */
+    if (c >= 'a' && c <= 'f') {
+        return c - ('a' - 10);
+    }
+    return -1;
+}
+
 /*
  * Turn byte array into a printable array. I.e. "\x01" -> "01"
  *
@@ -46,10 +58,9 @@ hex_format(void *src_v, int src_len, char *dst, int dst_len)
         return NULL;
     }
     for (i = 0; i < src_len; i++) {
-        tgt[0] = hex_bytes[(src[i] >> 4) & 0xf];
+        tgt[0] = hex_bytes[src[i] >> 4];
         tgt[1] = hex_bytes[src[i] & 0xf];
         tgt += 2;
-        dst_len -= 2;
     }
     *tgt = '\0';
     return dst;
@@ -70,7 +81,8 @@ hex_parse(char *src, int src_len, void *dst_v, int dst_len)
 {
     int i;
     uint8_t *dst = (uint8_t *)dst_v;
-    char c;
+    int hi;
+    int lo;
 
     if (src_len & 0x1) {
         return -1;
@@ -78,24 +90,13 @@ hex_parse(char *src, int src_len, void *dst_v, int dst_len)
     if (dst_len * 2 < src_len) {
         return -1;
     }
-    for (i = 0; i < src_len; i++, src++) {
-        c = *src;
-        if (isdigit((int) c)) {
-            c -= '0';
-        } else if (c >= 'a' && c <= 'f') {
-            c -= ('a' - 10);
-        } else if (c >= 'A' && c <= 'F') {
-            c -= ('A' - 10);
-        } else {
+    for (i = 0; i < src_len; i += 2, src += 2) {
+        hi = hex_nibble(src[0]);
+        lo = hex_nibble(src[1]);
+        if ((hi | lo) < 0) {
             return -1;
         }
-        if (i & 1) {
-            *dst |= c;
-            dst++;
-            dst_len--;
-        } else {
-            *dst = c << 4;
-        }
+        *dst++ = (hi << 4) | lo;
     }
     return src_len >> 1;
 }
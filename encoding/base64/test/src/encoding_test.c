@@ -24,6 +24,8 @@
 
 TEST_CASE_DECL(hex2str)
 TEST_CASE_DECL(str2hex)
+TEST_CASE_DECL(base64_codec)
+TEST_CASE_DECL(base64_stream)
 
 int
 hex_fmt_test_all(void)
@@ -36,6 +38,8 @@ TEST_SUITE(hex_fmt_test_suite)
 {
     hex2str();
     str2hex();
+    base64_codec();
+    base64_stream();
 }
 
 #if MYNEWT_VAL(SELFTEST)
@@ -23,6 +23,7 @@
 #include <stddef.h>
 #include "syscfg/syscfg.h"
 #include "base64/hex.h"
+#include "base64/base64.h"
 #include "testutil/testutil.h"
 
 #ifdef __cplusplus
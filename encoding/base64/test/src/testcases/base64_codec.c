@@ -0,0 +1,73 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <string.h>
+#include "encoding_test_priv.h"
+
+TEST_CASE(base64_codec)
+{
+    char enc[16];
+    uint8_t dec[16];
+    int rc;
+    int i;
+
+    struct {
+        char *in;
+        int inlen;
+        char *out;
+        char *out_nopad;
+    } test_data[] = {
+        { "", 0, "", "" },
+        { "f", 1, "Zg==", "Zg" },
+        { "fo", 2, "Zm8=", "Zm8" },
+        { "foo", 3, "Zm9v", "Zm9v" },
+        { "foob", 4, "Zm9vYg==", "Zm9vYg" },
+        { "fooba", 5, "Zm9vYmE=", "Zm9vYmE" },
+        { "\xff\xfe\x00\x3f", 4, "//4APw==", "//4APw" },
+    };
+
+    for (i = 0; i < sizeof(test_data) / sizeof(test_data[0]); i++) {
+        rc = base64_encode(test_data[i].in, test_data[i].inlen, enc, 1);
+        TEST_ASSERT(rc == strlen(test_data[i].out));
+        TEST_ASSERT(!strcmp(enc, test_data[i].out));
+
+        rc = base64_encode(test_data[i].in, test_data[i].inlen, enc, 0);
+        TEST_ASSERT(rc == strlen(test_data[i].out_nopad));
+        TEST_ASSERT(!strcmp(enc, test_data[i].out_nopad));
+
+        rc = base64_decode(test_data[i].out, dec);
+        TEST_ASSERT(rc == test_data[i].inlen);
+        TEST_ASSERT(!memcmp(dec, test_data[i].in, rc));
+
+        /* Decoding in place. */
+        strcpy(enc, test_data[i].out);
+        rc = base64_decode(enc, enc);
+        TEST_ASSERT(rc == test_data[i].inlen);
+        TEST_ASSERT(!memcmp(enc, test_data[i].in, rc));
+    }
+
+    /* Decoding stops at the first character which is not base64. */
+    rc = base64_decode("Zm9v\nZm9v", dec);
+    TEST_ASSERT(rc == 3);
+
+    /* Malformed tokens. */
+    TEST_ASSERT(base64_decode("Zm9", dec) == -1);
+    TEST_ASSERT(base64_decode("Z===", dec) == -1);
+    TEST_ASSERT(base64_decode("Zm=v", dec) == -1);
+    TEST_ASSERT(base64_decode("Zm\n=", dec) == -1);
+}
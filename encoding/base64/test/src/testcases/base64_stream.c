@@ -0,0 +1,81 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <string.h>
+#include "encoding_test_priv.h"
+
+TEST_CASE(base64_stream)
+{
+    struct base64_encoder be;
+    struct base64_decoder bd;
+    uint8_t data[64];
+    uint8_t dec[64];
+    char ref[BASE64_ENCODE_SIZE(sizeof(data)) + 1];
+    char enc[BASE64_ENCODE_SIZE(sizeof(data)) + 1];
+    int chunk;
+    int elen;
+    int dlen;
+    int off;
+    int rc;
+    int i;
+
+    for (i = 0; i < sizeof(data); i++) {
+        data[i] = i * 37 + 11;
+    }
+    base64_encode(data, sizeof(data), ref, 1);
+
+    /* Feeding the data in pieces gives the same result. */
+    for (chunk = 1; chunk <= 7; chunk++) {
+        base64_encoder_init(&be);
+        elen = 0;
+        for (off = 0; off < sizeof(data); off += chunk) {
+            rc = sizeof(data) - off;
+            if (rc > chunk) {
+                rc = chunk;
+            }
+            elen += base64_encoder_update(&be, data + off, rc, enc + elen);
+            TEST_ASSERT(elen % 4 == 0);
+        }
+        elen += base64_encoder_finish(&be, enc + elen, 1);
+        TEST_ASSERT(elen == strlen(ref));
+        TEST_ASSERT(!strcmp(enc, ref));
+
+        base64_decoder_init(&bd);
+        dlen = 0;
+        for (off = 0; off < elen; off += chunk) {
+            rc = elen - off;
+            if (rc > chunk) {
+                rc = chunk;
+            }
+            rc = base64_decoder_update(&bd, enc + off, rc, dec + dlen);
+            TEST_ASSERT_FATAL(rc >= 0);
+            dlen += rc;
+        }
+        TEST_ASSERT(base64_decoder_finish(&bd) == 0);
+        TEST_ASSERT(dlen == sizeof(data));
+        TEST_ASSERT(!memcmp(dec, data, sizeof(data)));
+    }
+
+    /* Truncated and malformed input. */
+    base64_decoder_init(&bd);
+    TEST_ASSERT(base64_decoder_update(&bd, "Zm9vY", 5, dec) == 3);
+    TEST_ASSERT(base64_decoder_finish(&bd) == -1);
+
+    base64_decoder_init(&bd);
+    TEST_ASSERT(base64_decoder_update(&bd, "Zm9v*m9v", 8, dec) == -1);
+}
@@ -17,6 +17,7 @@
  * under the License.
  */
 
+#include <string.h>
 #include <cborattr/cborattr.h>
 #include <tinycbor/cbor.h>
 
@@ -123,12 +124,47 @@ cbor_target_address(const struct cbor_attr_t *cursor,
     return targetaddr;
 }
 
+static int
+cbor_attr_match(const struct cbor_attr_t *cursor, const char *key, size_t len,
+                CborType type)
+{
+    return cursor->attribute[0] == key[0] &&
+           strncmp(cursor->attribute, key, len) == 0 &&
+           cursor->attribute[len] == '\0' &&
+           valid_attr_type(type, cursor->type);
+}
+
+/* Find the attribute for a key.  Senders usually encode keys in the same
+ * order as the table lists them, so the search starts right after the
+ * previous match and wraps around; in-order input then takes one compare
+ * per key however long the table is. */
+static const struct cbor_attr_t *
+cbor_attr_find(const struct cbor_attr_t *attrs,
+               const struct cbor_attr_t *hint, const char *key, size_t len,
+               CborType type)
+{
+    const struct cbor_attr_t *cursor;
+
+    for (cursor = hint; cursor->attribute != NULL; cursor++) {
+        if (cbor_attr_match(cursor, key, len, type)) {
+            return cursor;
+        }
+    }
+    for (cursor = attrs; cursor != hint; cursor++) {
+        if (cbor_attr_match(cursor, key, len, type)) {
+            return cursor;
+        }
+    }
+    return NULL;
+}
+
 static int
 cbor_internal_read_object(CborValue *root_value,
                           const struct cbor_attr_t *attrs,
                           const struct cbor_array_t *parent,
                           int offset) {
     const struct cbor_attr_t *cursor;
+    const struct cbor_attr_t *hint;
     char attrbuf[CBOR_ATTR_MAX + 1];
     char *lptr;
     CborValue cur_value;
@@ -173,6 +209,8 @@ cbor_internal_read_object(CborValue *root_value,
         return g_err;
     }
 
+    hint = attrs;
+
     /* contains key value pairs */
     while (cbor_value_is_valid(&cur_value)) {
         /* get the attribute */
@@ -200,15 +238,14 @@ cbor_internal_read_object(CborValue *root_value,
         }
 
         /* find this attribute in our list */
-        for (cursor = attrs; cursor->attribute != NULL; cursor++) {
-            if ( valid_attr_type(type, cursor->type) &&
-                (memcmp(cursor->attribute, attrbuf, len) == 0 )) {
-                break;
-            }
-        }
+        cursor = cbor_attr_find(attrs, hint, attrbuf, len, type);
 
         /* we found a match */
-        if ( cursor->attribute != NULL ) {
+        if (cursor != NULL) {
+            hint = cursor + 1;
+            if (hint->attribute == NULL) {
+                hint = attrs;
+            }
            lptr = cbor_target_address(cursor, parent, offset);
             switch (cursor->type) {
                 case CborAttrNullType:
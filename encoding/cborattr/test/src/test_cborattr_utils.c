@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "testutil/testutil.h"
+#include "test_cborattr.h"
+#include "tinycbor/cbor_buf_reader.h"
+#include "tinycbor/cbor_buf_writer.h"
+
+/*
+ * Encodes a map of integers, with the keys in the order given.  Returns the
+ * encoded length.
+ */
+int
+test_cborattr_encode_ints(uint8_t *buf, size_t size, const char **keys,
+                          const long long int *vals, int cnt)
+{
+    struct CborBufWriter writer;
+    CborEncoder encoder;
+    CborEncoder map;
+    int i;
+
+    cbor_buf_writer_init(&writer, buf, size);
+    cbor_encoder_init(&encoder, &writer.enc, 0);
+
+    TEST_ASSERT_FATAL(cbor_encoder_create_map(&encoder, &map, cnt) == 0);
+    for (i = 0; i < cnt; i++) {
+        TEST_ASSERT_FATAL(cbor_encode_text_stringz(&map, keys[i]) == 0);
+        TEST_ASSERT_FATAL(cbor_encode_int(&map, vals[i]) == 0);
+    }
+    TEST_ASSERT_FATAL(cbor_encoder_close_container(&encoder, &map) == 0);
+
+    return cbor_buf_writer_buffer_size(&writer, buf);
+}
+
+int
+test_cborattr_decode(const uint8_t *buf, int len,
+                     const struct cbor_attr_t *attrs)
+{
+    struct cbor_buf_reader reader;
+    CborParser parser;
+    CborValue value;
+
+    cbor_buf_reader_init(&reader, buf, len);
+    cbor_parser_init(&reader.r, 0, &parser, &value);
+
+    return cbor_read_object(&value, attrs);
+}
@@ -0,0 +1,91 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "test_cborattr.h"
+
+/*
+ * Keys arrive in a different order from the table, and some are prefixes
+ * of, or extend, other attribute names.  Each value must land in the
+ * attribute whose name matches its key exactly.
+ */
+TEST_CASE(test_cborattr_decode_key_order)
+{
+    long long int val_abc;
+    long long int val_ab;
+    long long int val_a;
+    long long int val_b;
+    long long int val_c;
+    const struct cbor_attr_t attrs[] = {
+        [0] = {
+            .attribute = "abc",
+            .type = CborAttrIntegerType,
+            .addr.integer = &val_abc,
+            .dflt.integer = -1,
+        },
+        [1] = {
+            .attribute = "ab",
+            .type = CborAttrIntegerType,
+            .addr.integer = &val_ab,
+            .dflt.integer = -1,
+        },
+        [2] = {
+            .attribute = "a",
+            .type = CborAttrIntegerType,
+            .addr.integer = &val_a,
+            .dflt.integer = -1,
+        },
+        [3] = {
+            .attribute = "b",
+            .type = CborAttrIntegerType,
+            .addr.integer = &val_b,
+            .dflt.integer = -1,
+        },
+        [4] = {
+            .attribute = "c",
+            .type = CborAttrIntegerType,
+            .addr.integer = &val_c,
+            .dflt.integer = -1,
+        },
+        [5] = {
+            .attribute = NULL
+        }
+    };
+    const char *keys[] = { "c", "a", "abcd", "b", "ab", "x", "abc" };
+    const long long int vals[] = { 5, 3, 99, 4, 2, 98, 1 };
+    uint8_t buf[64];
+    int len;
+    int rc;
+
+    len = test_cborattr_encode_ints(buf, sizeof(buf), keys, vals,
+                                    sizeof(keys) / sizeof(keys[0]));
+    rc = test_cborattr_decode(buf, len, attrs);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(val_abc == 1);
+    TEST_ASSERT(val_ab == 2);
+    TEST_ASSERT(val_a == 3);
+    TEST_ASSERT(val_b == 4);
+    TEST_ASSERT(val_c == 5);
+
+    /* Only "a": the attributes it is a prefix of keep their defaults. */
+    len = test_cborattr_encode_ints(buf, sizeof(buf), keys + 1, vals + 1, 1);
+    rc = test_cborattr_decode(buf, len, attrs);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(val_a == 3);
+    TEST_ASSERT(val_ab == -1);
+    TEST_ASSERT(val_abc == -1);
+}
@@ -83,11 +83,20 @@ struct json_value {
 typedef int (*json_write_func_t)(void *buf, char *data,
         int len);
 
+#define JSON_ENCODE_BUF_SIZE (64)
+
+/*
+ * Output is staged in je_encode_buf and handed to je_write in chunks.  The
+ * buffer is flushed whenever the outermost object or array is finished; call
+ * json_encode_flush() when writing anything else at the top level.
+ */
 struct json_encoder {
     json_write_func_t je_write;
     void *je_arg;
     int je_wr_commas:1;
-    char je_encode_buf[64];
+    uint8_t je_buf_len;
+    uint8_t je_depth;
+    char je_encode_buf[JSON_ENCODE_BUF_SIZE];
 };
 
 
@@ -103,6 +112,7 @@ int json_encode_array_name(struct json_encoder *encoder, char *name);
 int json_encode_array_start(struct json_encoder *encoder);
 int json_encode_array_value(struct json_encoder *encoder, struct json_value *val);
 int json_encode_array_finish(struct json_encoder *encoder);
+int json_encode_flush(struct json_encoder *encoder);
 
 /* Json parser definitions */
 typedef enum {
@@ -227,6 +237,62 @@ int json_read_array(struct json_buffer *, const struct json_array_t *);
 #define JSON_ERR_BADNUM      21  /* error while parsing a numerical argument */
 #define JSON_ERR_NULLPTR     22  /* unexpected null value or attribute pointer */
 
+#define JSON_ERR_DEPTH       23  /* objects/arrays nested too deeply */
+
+/*
+ * Event driven reader.  Instead of filling in attribute tables, the reader
+ * walks the input once and calls jr_cb for every token, so handlers can
+ * pick out what they need from inputs of any size.  Nothing is allocated
+ * and nothing recurses; string and number text is passed through jr_tok,
+ * in several JSON_TOK_F_PARTIAL pieces if it does not fit.
+ */
+#define JSON_TOK_OBJECT_START   1
+#define JSON_TOK_OBJECT_END     2
+#define JSON_TOK_ARRAY_START    3
+#define JSON_TOK_ARRAY_END      4
+#define JSON_TOK_KEY            5
+#define JSON_TOK_STRING         6
+#define JSON_TOK_NUMBER         7
+#define JSON_TOK_TRUE           8
+#define JSON_TOK_FALSE          9
+#define JSON_TOK_NULL           10
+
+/* More pieces of this key/string follow. */
+#define JSON_TOK_F_PARTIAL      0x01
+
+#define JSON_READER_TOK_MAX     32
+#define JSON_READER_DEPTH_MAX   32
+
+struct json_token {
+    uint8_t jt_type;
+    uint8_t jt_flags;
+    /* Nesting depth of the token; 0 for the outermost value. */
+    uint8_t jt_depth;
+    /* Decoded text for keys, strings and numbers. */
+    const char *jt_data;
+    int jt_len;
+    /* Offset of the token's first character in the input. */
+    int jt_off;
+};
+
+/* Return non-zero to stop reading; json_read() then returns that value. */
+typedef int (*json_token_cb_t)(void *arg, const struct json_token *tok);
+
+struct json_reader {
+    struct json_buffer *jr_buf;
+    json_token_cb_t jr_cb;
+    void *jr_arg;
+    int jr_off;
+    int jr_unget;
+    uint32_t jr_in_object;
+    uint8_t jr_depth;
+    char jr_tok[JSON_READER_TOK_MAX];
+};
+
+void json_reader_init(struct json_reader *jr, struct json_buffer *jb,
+        json_token_cb_t cb, void *arg);
+int json_read(struct json_reader *jr);
+
 /*
  * Use the following macros to declare template initializers for structobject
  * arrays.  Writing the equivalents out by hand is error-prone.
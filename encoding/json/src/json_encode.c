@@ -23,27 +23,90 @@
 #include <json/json.h>
 
 #define JSON_ENCODE_OBJECT_START(__e) \
-    (__e)->je_write((__e)->je_arg, "{", sizeof("{")-1);
+    json_encode_put((__e), "{", sizeof("{")-1);
 
 #define JSON_ENCODE_OBJECT_END(__e) \
-    (__e)->je_write((__e)->je_arg, "}", sizeof("}")-1);
+    json_encode_put((__e), "}", sizeof("}")-1);
 
 #define JSON_ENCODE_ARRAY_START(__e) \
-    (__e)->je_write((__e)->je_arg, "[", sizeof("[")-1);
+    json_encode_put((__e), "[", sizeof("[")-1);
 
 #define JSON_ENCODE_ARRAY_END(__e) \
-    (__e)->je_write((__e)->je_arg, "]", sizeof("]")-1);
+    json_encode_put((__e), "]", sizeof("]")-1);
+
+int
+json_encode_flush(struct json_encoder *encoder)
+{
+    if (encoder->je_buf_len > 0) {
+        encoder->je_write(encoder->je_arg, encoder->je_encode_buf,
+                encoder->je_buf_len);
+        encoder->je_buf_len = 0;
+    }
+
+    return (0);
+}
+
+static void
+json_encode_put(struct json_encoder *encoder, const char *data, int len)
+{
+    if (encoder->je_buf_len + len > JSON_ENCODE_BUF_SIZE) {
+        json_encode_flush(encoder);
+        if (len > JSON_ENCODE_BUF_SIZE) {
+            encoder->je_write(encoder->je_arg, (char *) data, len);
+            return;
+        }
+    }
+    memcpy(encoder->je_encode_buf + encoder->je_buf_len, data, len);
+    encoder->je_buf_len += len;
+}
+
+static void
+json_encode_putc(struct json_encoder *encoder, char c)
+{
+    if (encoder->je_buf_len == JSON_ENCODE_BUF_SIZE) {
+        json_encode_flush(encoder);
+    }
+    encoder->je_encode_buf[encoder->je_buf_len++] = c;
+}
+
+static void
+json_encode_uint(struct json_encoder *encoder, uint64_t u, int neg)
+{
+    char digits[21];
+    int i;
+
+    i = sizeof(digits);
+    do {
+        digits[--i] = '0' + (u % 10);
+        u /= 10;
+    } while (u != 0);
+    if (neg) {
+        digits[--i] = '-';
+    }
+    json_encode_put(encoder, digits + i, sizeof(digits) - i);
+}
+
+/* Flush once the outermost container is done, so the caller sees all of
+ * its output without having to know about the staging buffer. */
+static void
+json_encode_done(struct json_encoder *encoder)
+{
+    if (encoder->je_depth == 0) {
+        json_encode_flush(encoder);
+    }
+}
 
 
 int
 json_encode_object_start(struct json_encoder *encoder)
 {
     if (encoder->je_wr_commas) {
-        encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
+        json_encode_putc(encoder, ',');
         encoder->je_wr_commas = 0;
     }
     JSON_ENCODE_OBJECT_START(encoder);
     encoder->je_wr_commas = 0;
+    encoder->je_depth++;
 
     return (0);
 }
@@ -53,65 +116,57 @@ json_encode_value(struct json_encoder *encoder, struct json_value *jv)
 {
     int rc;
     int i;
-    int len;
 
     switch (jv->jv_type) {
         case JSON_VALUE_TYPE_BOOL:
-            len = sprintf(encoder->je_encode_buf, "%s",
-                    jv->jv_val.u > 0 ? "true" : "false");
-            encoder->je_write(encoder->je_arg, encoder->je_encode_buf, len);
+            if (jv->jv_val.u > 0) {
+                json_encode_put(encoder, "true", sizeof("true")-1);
+            } else {
+                json_encode_put(encoder, "false", sizeof("false")-1);
+            }
             break;
         case JSON_VALUE_TYPE_UINT64:
-            len = sprintf(encoder->je_encode_buf, "%llu",
-                    jv->jv_val.u);
-            encoder->je_write(encoder->je_arg, encoder->je_encode_buf, len);
+            json_encode_uint(encoder, jv->jv_val.u, 0);
             break;
         case JSON_VALUE_TYPE_INT64:
-            len = sprintf(encoder->je_encode_buf, "%lld",
-                    jv->jv_val.u);
-            encoder->je_write(encoder->je_arg, encoder->je_encode_buf, len);
+            if ((int64_t) jv->jv_val.u < 0) {
+                json_encode_uint(encoder, -jv->jv_val.u, 1);
+            } else {
+                json_encode_uint(encoder, jv->jv_val.u, 0);
+            }
             break;
         case JSON_VALUE_TYPE_STRING:
-            encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
+            json_encode_putc(encoder, '"');
             for (i = 0; i < jv->jv_len; i++) {
                 switch (jv->jv_val.str[i]) {
                     case '"':
                     case '/':
                     case '\\':
-                        encoder->je_write(encoder->je_arg, "\\",
-                                sizeof("\\")-1);
-                        encoder->je_write(encoder->je_arg,
-                                (char *) &jv->jv_val.str[i], 1);
-
+                        json_encode_putc(encoder, '\\');
+                        json_encode_putc(encoder, jv->jv_val.str[i]);
                         break;
                     case '\t':
-                        encoder->je_write(encoder->je_arg, "\\t",
-                                sizeof("\\t")-1);
+                        json_encode_put(encoder, "\\t", sizeof("\\t")-1);
                         break;
                     case '\r':
-                        encoder->je_write(encoder->je_arg, "\\r",
-                                sizeof("\\r")-1);
+                        json_encode_put(encoder, "\\r", sizeof("\\r")-1);
                         break;
                     case '\n':
-                        encoder->je_write(encoder->je_arg, "\\n",
-                                sizeof("\\n")-1);
+                        json_encode_put(encoder, "\\n", sizeof("\\n")-1);
                         break;
                     case '\f':
-                        encoder->je_write(encoder->je_arg, "\\f",
-                                sizeof("\\f")-1);
+                        json_encode_put(encoder, "\\f", sizeof("\\f")-1);
                         break;
                     case '\b':
-                        encoder->je_write(encoder->je_arg, "\\b",
-                                sizeof("\\b")-1);
+                        json_encode_put(encoder, "\\b", sizeof("\\b")-1);
                         break;
                    default:
-                        encoder->je_write(encoder->je_arg,
-                                (char *) &jv->jv_val.str[i], 1);
+                        json_encode_putc(encoder, jv->jv_val.str[i]);
                         break;
                 }
 
             }
-            encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
+            json_encode_putc(encoder, '"');
             break;
         case JSON_VALUE_TYPE_ARRAY:
             JSON_ENCODE_ARRAY_START(encoder);
@@ -121,7 +176,7 @@ json_encode_value(struct json_encoder *encoder, struct json_value *jv)
                     goto err;
                 }
                 if (i != jv->jv_len - 1) {
-                    encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
+                    json_encode_putc(encoder, ',');
                 }
             }
             JSON_ENCODE_ARRAY_END(encoder);
@@ -153,14 +208,15 @@ int
 json_encode_object_key(struct json_encoder *encoder, char *key)
 {
     if (encoder->je_wr_commas) {
-        encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
+        json_encode_putc(encoder, ',');
         encoder->je_wr_commas = 0;
     }
 
     /* Write the key entry */
-    encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
-    encoder->je_write(encoder->je_arg, key, strlen(key));
-    encoder->je_write(encoder->je_arg, "\": ", sizeof("\": ")-1);
+    json_encode_putc(encoder, '"');
+    json_encode_put(encoder, key, strlen(key));
+    json_encode_put(encoder, "\": ", sizeof("\": ")-1);
+    json_encode_done(encoder);
 
     return (0);
 }
@@ -172,19 +228,20 @@ json_encode_object_entry(struct json_encoder *encoder, char *key,
     int rc;
 
     if (encoder->je_wr_commas) {
-        encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
+        json_encode_putc(encoder, ',');
         encoder->je_wr_commas = 0;
     }
     /* Write the key entry */
-    encoder->je_write(encoder->je_arg, "\"", sizeof("\"")-1);
-    encoder->je_write(encoder->je_arg, key, strlen(key));
-    encoder->je_write(encoder->je_arg, "\": ", sizeof("\": ")-1);
+    json_encode_putc(encoder, '"');
+    json_encode_put(encoder, key, strlen(key));
+    json_encode_put(encoder, "\": ", sizeof("\": ")-1);
 
     rc = json_encode_value(encoder, val);
     if (rc != 0) {
         goto err;
     }
     encoder->je_wr_commas = 1;
+    json_encode_done(encoder);
 
     return (0);
 err:
@@ -197,6 +254,10 @@ json_encode_object_finish(struct json_encoder *encoder)
     JSON_ENCODE_OBJECT_END(encoder);
     /* Useful in case of nested objects. */
     encoder->je_wr_commas = 1;
+    if (encoder->je_depth > 0) {
+        encoder->je_depth--;
+    }
+    json_encode_done(encoder);
 
     return (0);
 }
@@ -212,6 +273,7 @@ json_encode_array_start(struct json_encoder *encoder)
 {
     JSON_ENCODE_ARRAY_START(encoder);
     encoder->je_wr_commas = 0;
+    encoder->je_depth++;
 
     return (0);
 }
@@ -222,7 +284,7 @@ json_encode_array_value(struct json_encoder *encoder, struct json_value *jv)
     int rc;
 
     if (encoder->je_wr_commas) {
-        encoder->je_write(encoder->je_arg, ",", sizeof(",")-1);
+        json_encode_putc(encoder, ',');
         encoder->je_wr_commas = 0;
     }
 
@@ -231,6 +293,7 @@ json_encode_array_value(struct json_encoder *encoder, struct json_value *jv)
         goto err;
     }
     encoder->je_wr_commas = 1;
+    json_encode_done(encoder);
 
     return (0);
 err:
@@ -243,6 +306,10 @@ json_encode_array_finish(struct json_encoder *encoder)
 {
     encoder->je_wr_commas = 1;
     JSON_ENCODE_ARRAY_END(encoder);
+    if (encoder->je_depth > 0) {
+        encoder->je_depth--;
+    }
+    json_encode_done(encoder);
 
     return (0);
 }
@@ -0,0 +1,395 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <ctype.h>
+#include <string.h>
+
+#include <json/json.h>
+
+#define JSON_READER_NEED_VALUE  0
+#define JSON_READER_NEED_KEY    1
+#define JSON_READER_NEED_COMMA  2
+
+void
+json_reader_init(struct json_reader *jr, struct json_buffer *jb,
+        json_token_cb_t cb, void *arg)
+{
+    memset(jr, 0, sizeof(*jr));
+    jr->jr_buf = jb;
+    jr->jr_cb = cb;
+    jr->jr_arg = arg;
+    jr->jr_unget = -1;
+}
+
+/* Returns the next character, or -1 at the end of input. */
+static int
+json_reader_getc(struct json_reader *jr)
+{
+    int c;
+
+    if (jr->jr_unget >= 0) {
+        c = jr->jr_unget;
+        jr->jr_unget = -1;
+    } else {
+        c = (unsigned char) jr->jr_buf->jb_read_next(jr->jr_buf);
+        if (c == '\0') {
+            return -1;
+        }
+    }
+    jr->jr_off++;
+
+    return c;
+}
+
+static void
+json_reader_ungetc(struct json_reader *jr, int c)
+{
+    if (c >= 0) {
+        jr->jr_unget = c;
+        jr->jr_off--;
+    }
+}
+
+static int
+json_reader_skip_ws(struct json_reader *jr)
+{
+    int c;
+
+    do {
+        c = json_reader_getc(jr);
+    } while (c >= 0 && isspace(c));
+
+    return c;
+}
+
+static int
+json_reader_emit(struct json_reader *jr, int type, int flags, int len,
+        int off)
+{
+    struct json_token tok;
+
+    tok.jt_type = type;
+    tok.jt_flags = flags;
+    tok.jt_depth = jr->jr_depth;
+    tok.jt_data = jr->jr_tok;
+    tok.jt_len = len;
+    tok.jt_off = off;
+
+    return jr->jr_cb(jr->jr_arg, &tok);
+}
+
+static int
+json_reader_hex(struct json_reader *jr)
+{
+    int val;
+    int c;
+    int i;
+
+    val = 0;
+    for (i = 0; i < 4; i++) {
+        c = json_reader_getc(jr);
+        if (c >= '0' && c <= '9') {
+            c -= '0';
+        } else if (c >= 'a' && c <= 'f') {
+            c -= 'a' - 10;
+        } else if (c >= 'A' && c <= 'F') {
+            c -= 'A' - 10;
+        } else {
+            return -1;
+        }
+        val = (val << 4) | c;
+    }
+
+    return val;
+}
+
+/* Reads a string whose opening quote has been consumed. */
+static int
+json_reader_string(struct json_reader *jr, int type, int off)
+{
+    char utf8[3];
+    int ulen;
+    int ucs;
+    int len;
+    int rc;
+    int c;
+    int i;
+
+    len = 0;
+    while (1) {
+        c = json_reader_getc(jr);
+        if (c < 0 || c < ' ') {
+            return JSON_ERR_BADSTRING;
+        }
+        if (c == '"') {
+            break;
+        }
+
+        ulen = 1;
+        if (c == '\\') {
+            c = json_reader_getc(jr);
+            switch (c) {
+            case '"':
+            case '\\':
+            case '/':
+                break;
+            case 'b':
+                c = '\b';
+                break;
+            case 'f':
+                c = '\f';
+                break;
+            case 'n':
+                c = '\n';
+                break;
+            case 'r':
+                c = '\r';
+                break;
+            case 't':
+                c = '\t';
+                break;
+            case 'u':
+                ucs = json_reader_hex(jr);
+                if (ucs < 0) {
+                    return JSON_ERR_BADSTRING;
+                }
+                if (ucs < 0x80) {
+                    c = ucs;
+                } else if (ucs < 0x800) {
+                    utf8[0] = 0xc0 | (ucs >> 6);
+                    utf8[1] = 0x80 | (ucs & 0x3f);
+                    ulen = 2;
+                } else {
+                    utf8[0] = 0xe0 | (ucs >> 12);
+                    utf8[1] = 0x80 | ((ucs >> 6) & 0x3f);
+                    utf8[2] = 0x80 | (ucs & 0x3f);
+                    ulen = 3;
+                }
+                break;
+            default:
+                return JSON_ERR_BADSTRING;
+            }
+        }
+        if (ulen == 1) {
+            utf8[0] = c;
+        }
+
+        if (len + ulen > JSON_READER_TOK_MAX) {
+            rc = json_reader_emit(jr, type, JSON_TOK_F_PARTIAL, len, off);
+            if (rc != 0) {
+                return rc;
+            }
+            len = 0;
+        }
+        for (i = 0; i < ulen; i++) {
+            jr->jr_tok[len++] = utf8[i];
+        }
+    }
+
+    return json_reader_emit(jr, type, 0, len, off);
+}
+
+static int
+json_reader_number(struct json_reader *jr, int c, int off)
+{
+    int len;
+
+    len = 0;
+    while (c >= 0 && (isdigit(c) || c == '-' || c == '+' || c == '.' ||
+                      c == 'e' || c == 'E')) {
+        if (len == JSON_READER_TOK_MAX) {
+            return JSON_ERR_TOKLONG;
+        }
+        jr->jr_tok[len++] = c;
+        c = json_reader_getc(jr);
+    }
+    json_reader_ungetc(jr, c);
+
+    return json_reader_emit(jr, JSON_TOK_NUMBER, 0, len, off);
+}
+
+static int
+json_reader_literal(struct json_reader *jr, int c, int off)
+{
+    const char *word;
+    int type;
+
+    switch (c) {
+    case 't':
+        word = "true";
+        type = JSON_TOK_TRUE;
+        break;
+    case 'f':
+        word = "false";
+        type = JSON_TOK_FALSE;
+        break;
+    default:
+        word = "null";
+        type = JSON_TOK_NULL;
+        break;
+    }
+    for (word++; *word != '\0'; word++) {
+        if (json_reader_getc(jr) != *word) {
+            return JSON_ERR_MISC;
+        }
+    }
+    c = json_reader_getc(jr);
+    if (c >= 0 && isalnum(c)) {
+        return JSON_ERR_MISC;
+    }
+    json_reader_ungetc(jr, c);
+
+    return json_reader_emit(jr, type, 0, 0, off);
+}
+
+static int
+json_reader_push(struct json_reader *jr, int object, int off)
+{
+    int rc;
+
+    if (jr->jr_depth >= JSON_READER_DEPTH_MAX) {
+        return JSON_ERR_DEPTH;
+    }
+    rc = json_reader_emit(jr,
+            object ? JSON_TOK_OBJECT_START : JSON_TOK_ARRAY_START, 0, 0, off);
+    if (object) {
+        jr->jr_in_object |= 1UL << jr->jr_depth;
+    } else {
+        jr->jr_in_object &= ~(1UL << jr->jr_depth);
+    }
+    jr->jr_depth++;
+
+    return rc;
+}
+
+static int
+json_reader_pop(struct json_reader *jr, int off)
+{
+    int object;
+
+    jr->jr_depth--;
+    object = (jr->jr_in_object >> jr->jr_depth) & 1;
+
+    return json_reader_emit(jr,
+            object ? JSON_TOK_OBJECT_END : JSON_TOK_ARRAY_END, 0, 0, off);
+}
+
+static int
+json_reader_in_object(struct json_reader *jr)
+{
+    return (jr->jr_in_object >> (jr->jr_depth - 1)) & 1;
+}
+
+/*
+ * Reads one JSON value, reporting each token to the callback.  Returns 0
+ * once the value is complete; whatever follows it is left unread.
+ */
+int
+json_read(struct json_reader *jr)
+{
+    int allow_close;
+    int need;
+    int off;
+    int rc;
+    int c;
+
+    need = JSON_READER_NEED_VALUE;
+    allow_close = 0;
+    while (1) {
+        c = json_reader_skip_ws(jr);
+        off = jr->jr_off - 1;
+        if (c < 0) {
+            return jr->jr_depth == 0 ? JSON_ERR_OBSTART : JSON_ERR_BADTRAIL;
+        }
+
+        switch (need) {
+        case JSON_READER_NEED_VALUE:
+            if (c == ']' && allow_close) {
+                rc = json_reader_pop(jr, off);
+                break;
+            }
+            allow_close = 1;
+            if (c == '{') {
+                rc = json_reader_push(jr, 1, off);
+                need = JSON_READER_NEED_KEY;
+                if (rc != 0) {
+                    return rc;
+                }
+                continue;
+            } else if (c == '[') {
+                rc = json_reader_push(jr, 0, off);
+                if (rc != 0) {
+                    return rc;
+                }
+                continue;
+            } else if (c == '"') {
+                rc = json_reader_string(jr, JSON_TOK_STRING, off);
+            } else if (c == '-' || isdigit(c)) {
+                rc = json_reader_number(jr, c, off);
+            } else if (c == 't' || c == 'f' || c == 'n') {
+                rc = json_reader_literal(jr, c, off);
+            } else {
+                rc = jr->jr_depth == 0 ? JSON_ERR_OBSTART : JSON_ERR_BADTRAIL;
+            }
+            break;
+        case JSON_READER_NEED_KEY:
+            if (c == '}' && allow_close) {
+                rc = json_reader_pop(jr, off);
+                break;
+            }
+            if (c != '"') {
+                return JSON_ERR_ATTRSTART;
+            }
+            rc = json_reader_string(jr, JSON_TOK_KEY, off);
+            if (rc != 0) {
+                return rc;
+            }
+            if (json_reader_skip_ws(jr) != ':') {
+                return JSON_ERR_BADTRAIL;
+            }
+            need = JSON_READER_NEED_VALUE;
+            allow_close = 0;
+            continue;
+        default:
+            if (c == ',') {
+                if (json_reader_in_object(jr)) {
+                    need = JSON_READER_NEED_KEY;
+                } else {
+                    need = JSON_READER_NEED_VALUE;
+                }
+                allow_close = 0;
+                continue;
+            }
+            if (c != (json_reader_in_object(jr) ? '}' : ']')) {
+                return JSON_ERR_BADTRAIL;
+            }
+            rc = json_reader_pop(jr, off);
+            break;
+        }
+
+        /* A value (or a whole container) has been read. */
+        if (rc != 0) {
+            return rc;
+        }
+        if (jr->jr_depth == 0) {
+            return 0;
+        }
+        need = JSON_READER_NEED_COMMA;
+    }
+}
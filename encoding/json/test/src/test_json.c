@@ -23,10 +23,14 @@
 
 TEST_CASE_DECL(test_json_simple_encode);
 TEST_CASE_DECL(test_json_simple_decode);
+TEST_CASE_DECL(test_json_buffered_encode);
+TEST_CASE_DECL(test_json_reader_decode);
 
 TEST_SUITE(test_json_suite) {
     test_json_simple_encode();
     test_json_simple_decode();
+    test_json_buffered_encode();
+    test_json_reader_decode();
 }
 
 #if MYNEWT_VAL(SELFTEST)
@@ -0,0 +1,78 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "test_json.h"
+
+static int test_write_calls;
+
+static int
+test_count_write(void *buf, char *data, int len)
+{
+    test_write_calls++;
+    return test_write(buf, data, len);
+}
+
+TEST_CASE(test_json_buffered_encode)
+{
+    struct json_encoder encoder;
+    struct json_value value;
+    char *longstr =
+        "0123456789012345678901234567890123456789012345678901234567890123456789";
+    char expect[256];
+    int rc;
+
+    buf_index = 0;
+    memset(bigbuf, 0, sizeof(bigbuf));
+    memset(&encoder, 0, sizeof(encoder));
+    test_write_calls = 0;
+
+    encoder.je_write = test_count_write;
+    encoder.je_arg = NULL;
+
+    rc = json_encode_object_start(&encoder);
+    TEST_ASSERT(rc == 0);
+
+    JSON_VALUE_UINT(&value, 18446744073709551615ULL);
+    rc = json_encode_object_entry(&encoder, "max", &value);
+    TEST_ASSERT(rc == 0);
+
+    /* Nothing is written while the staging buffer has room. */
+    TEST_ASSERT(test_write_calls == 0);
+
+    JSON_VALUE_INT(&value, INT64_MIN);
+    rc = json_encode_object_entry(&encoder, "min", &value);
+    TEST_ASSERT(rc == 0);
+
+    JSON_VALUE_INT(&value, 0);
+    rc = json_encode_object_entry(&encoder, "zero", &value);
+    TEST_ASSERT(rc == 0);
+
+    JSON_VALUE_STRING(&value, longstr);
+    rc = json_encode_object_entry(&encoder, "long", &value);
+    TEST_ASSERT(rc == 0);
+
+    rc = json_encode_object_finish(&encoder);
+    TEST_ASSERT(rc == 0);
+
+    sprintf(expect, "{\"max\": 18446744073709551615,"
+            "\"min\": -9223372036854775808,\"zero\": 0,\"long\": \"%s\"}",
+            longstr);
+    TEST_ASSERT(strcmp(bigbuf, expect) == 0);
+    TEST_ASSERT(test_write_calls <=
+                (int)strlen(expect) / JSON_ENCODE_BUF_SIZE + 1);
+}
@@ -0,0 +1,94 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "test_json.h"
+
+static char test_events[256];
+static int test_events_len;
+static int test_string_off;
+
+static int
+test_reader_cb(void *arg, const struct json_token *tok)
+{
+    static const char tags[] = "?{}[]KSNtfn";
+
+    test_events_len += sprintf(test_events + test_events_len, "%c%d",
+            tags[tok->jt_type], tok->jt_depth);
+    if (tok->jt_len > 0) {
+        test_events_len += sprintf(test_events + test_events_len, "=%.*s",
+                tok->jt_len, tok->jt_data);
+    }
+    if (tok->jt_flags & JSON_TOK_F_PARTIAL) {
+        test_events[test_events_len++] = '+';
+    }
+    test_events[test_events_len++] = ' ';
+    test_events[test_events_len] = '\0';
+
+    if (tok->jt_type == JSON_TOK_STRING && test_string_off < 0) {
+        test_string_off = tok->jt_off;
+    }
+
+    return 0;
+}
+
+static int
+test_reader_run(char *input)
+{
+    struct test_jbuf tjb;
+    struct json_reader jr;
+
+    test_events_len = 0;
+    test_events[0] = '\0';
+    test_string_off = -1;
+    test_buf_init(&tjb, input);
+    json_reader_init(&jr, &tjb.json_buf, test_reader_cb, NULL);
+
+    return json_read(&jr);
+}
+
+TEST_CASE(test_json_reader_decode)
+{
+    int rc;
+
+    rc = test_reader_run("{\"a\": [1, -2.5e3, true], \"b\": {\"c\": null},"
+            " \"d\": \"x\\ty\\u00e9\", \"e\": [], \"f\": false}");
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(strcmp(test_events,
+            "{0 K1=a [1 N2=1 N2=-2.5e3 t2 ]1 K1=b {1 K2=c n2 }1 "
+            "K1=d S1=x\ty\xc3\xa9 K1=e [1 ]1 K1=f f1 }0 ") == 0);
+    TEST_ASSERT(test_string_off == 48);
+
+    /* Strings longer than the token buffer come in pieces. */
+    rc = test_reader_run("[\"0123456789012345678901234567890123456789\"]");
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(strcmp(test_events,
+            "[0 S1=01234567890123456789012345678901+ S1=23456789 ]0 ") == 0);
+    TEST_ASSERT(test_string_off == 1);
+
+    rc = test_reader_run("{\"a\": 1,}");
+    TEST_ASSERT(rc == JSON_ERR_ATTRSTART);
+
+    rc = test_reader_run("[1 2]");
+    TEST_ASSERT(rc == JSON_ERR_BADTRAIL);
+
+    rc = test_reader_run("{\"a\": tru}");
+    TEST_ASSERT(rc == JSON_ERR_MISC);
+
+    rc = test_reader_run("[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[1]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]");
+    TEST_ASSERT(rc == JSON_ERR_DEPTH);
+}
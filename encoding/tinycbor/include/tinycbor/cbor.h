@@ -160,10 +160,15 @@ CBOR_API const char *cbor_error_string(CborError error);
 struct cbor_encoder_writer;
 
 typedef int (cbor_encoder_write)(struct cbor_encoder_writer *, const char *data, int len);
+/* Overwrites bytes already written, at offset off from the start of output. */
+typedef int (cbor_encoder_rewrite)(struct cbor_encoder_writer *, int off, const char *data, int len);
 
 typedef struct cbor_encoder_writer {
     cbor_encoder_write *write;
     int                 bytes_written;
+    /* Optional; when set, indefinite-length containers that turn out to be
+     * short are patched into definite-length ones on close. */
+    cbor_encoder_rewrite *rewrite;
 } cbor_encoder_writer;
 
 
@@ -174,6 +179,7 @@ struct CborEncoder
     void *writer_arg;
     size_t added;
     int flags;
+    int hdr_off;
 };
 typedef struct CborEncoder CborEncoder;
 
@@ -48,6 +48,7 @@ static inline void
 cbor_cnt_writer_init(struct CborCntWriter *cb) {
     cb->enc.bytes_written = 0;
     cb->enc.write = &cbor_cnt_writer;
+    cb->enc.rewrite = NULL;
 }
 
 #ifdef __cplusplus
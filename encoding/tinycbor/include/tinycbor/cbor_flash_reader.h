@@ -0,0 +1,55 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef CBOR_FLASH_READER_H
+#define CBOR_FLASH_READER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "syscfg/syscfg.h"
+#include <tinycbor/cbor.h>
+#include <flash_map/flash_map.h>
+
+/*
+ * Parses CBOR data in a flash area in place.  Reads go through a small
+ * window of the data cached in the reader, so RAM use does not depend on the
+ * size of the document.
+ */
+struct cbor_flash_reader {
+    struct cbor_decoder_reader r;
+    const struct flash_area *fa;
+    uint32_t off;                     /* start of the data in the area */
+    uint32_t win_off;                 /* data offset of win[0] */
+    uint16_t win_len;                 /* valid bytes in win */
+    uint8_t err;                      /* set if a flash read failed */
+    uint8_t win[MYNEWT_VAL(CBOR_FLASH_READER_WIN_SZ)];
+};
+
+void
+cbor_flash_reader_init(struct cbor_flash_reader *cb,
+                       const struct flash_area *fa, uint32_t off,
+                       size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CBOR_FLASH_READER_H */
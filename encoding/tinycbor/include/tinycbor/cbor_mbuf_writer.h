@@ -28,6 +28,10 @@ extern "C" {
 struct CborMbufWriter {
     struct cbor_encoder_writer enc;
     struct os_mbuf *m;
+    /* Last mbuf in the chain; small items are copied straight into it. */
+    struct os_mbuf *tail;
+    /* Length of the chain before encoding started. */
+    int base;
 };
 
 void
@@ -41,12 +41,24 @@ int cbor_buf_writer(struct cbor_encoder_writer *arg, const char *data, int len)
     return CborNoError;
 }
 
+static int cbor_buf_rewriter(struct cbor_encoder_writer *arg, int off,
+                             const char *data, int len) {
+    struct CborBufWriter *cb = (struct CborBufWriter *) arg;
+
+    if (off < 0 || off + len > cb->enc.bytes_written) {
+        return CborErrorInternalError;
+    }
+    memcpy(cb->ptr - cb->enc.bytes_written + off, data, len);
+    return CborNoError;
+}
+
 void cbor_buf_writer_init(struct CborBufWriter *cb, uint8_t *buffer, size_t size)
 {
     cb->ptr = buffer;
     cb->end = buffer + size;
     cb->enc.bytes_written = 0;
     cb->enc.write = cbor_buf_writer;
+    cb->enc.rewrite = cbor_buf_rewriter;
 }
 
 size_t
@@ -0,0 +1,143 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+
+#include <tinycbor/cbor_flash_reader.h>
+#include <tinycbor/compilersupport_p.h>
+
+#if MYNEWT_VAL(CBOR_FLASH_READER_WIN_SZ) < 8
+#error "CBOR_FLASH_READER_WIN_SZ must fit the largest CBOR number"
+#endif
+
+/*
+ * Returns a pointer to len bytes of data at offset, moving the window if
+ * they are not all in it.  len is at most the window size.  A failed flash
+ * read is remembered in cb->err, and reads back as 0xff.
+ */
+static const uint8_t *
+cbor_flash_reader_get(struct cbor_flash_reader *cb, int offset, int len)
+{
+    uint32_t cnt;
+
+    if (offset < cb->win_off || offset + len > cb->win_off + cb->win_len) {
+        cnt = cb->r.message_size - offset;
+        if (cnt > sizeof(cb->win)) {
+            cnt = sizeof(cb->win);
+        }
+        cb->win_off = offset;
+        cb->win_len = cnt;
+        if (flash_area_read(cb->fa, cb->off + offset, cb->win, cnt)) {
+            memset(cb->win, 0xff, sizeof(cb->win));
+            cb->err = 1;
+        }
+    }
+    return &cb->win[offset - cb->win_off];
+}
+
+static uint8_t
+cbuf_flash_reader_get8(struct cbor_decoder_reader *d, int offset) {
+    struct cbor_flash_reader *cb = (struct cbor_flash_reader *) d;
+    return *cbor_flash_reader_get(cb, offset, sizeof(uint8_t));
+}
+
+static uint16_t
+cbuf_flash_reader_get16(struct cbor_decoder_reader *d, int offset) {
+    uint16_t val;
+    struct cbor_flash_reader *cb = (struct cbor_flash_reader *) d;
+    memcpy(&val, cbor_flash_reader_get(cb, offset, sizeof(val)), sizeof(val));
+    return cbor_ntohs(val);
+}
+
+static uint32_t
+cbuf_flash_reader_get32(struct cbor_decoder_reader *d, int offset) {
+    uint32_t val;
+    struct cbor_flash_reader *cb = (struct cbor_flash_reader *) d;
+    memcpy(&val, cbor_flash_reader_get(cb, offset, sizeof(val)), sizeof(val));
+    return cbor_ntohl(val);
+}
+
+static uint64_t
+cbuf_flash_reader_get64(struct cbor_decoder_reader *d, int offset) {
+    uint64_t val;
+    struct cbor_flash_reader *cb = (struct cbor_flash_reader *) d;
+    memcpy(&val, cbor_flash_reader_get(cb, offset, sizeof(val)), sizeof(val));
+    return cbor_ntohll(val);
+}
+
+static uintptr_t
+cbor_flash_reader_cmp(struct cbor_decoder_reader *d, char *buf, int offset, size_t len) {
+    struct cbor_flash_reader *cb = (struct cbor_flash_reader *) d;
+    size_t cnt;
+    int rc;
+
+    while (len > 0) {
+        cnt = len < sizeof(cb->win) ? len : sizeof(cb->win);
+        rc = memcmp(buf, cbor_flash_reader_get(cb, offset, cnt), cnt);
+        if (rc || cb->err) {
+            return rc ? rc : 1;
+        }
+        buf += cnt;
+        offset += cnt;
+        len -= cnt;
+    }
+    return 0;
+}
+
+static uintptr_t
+cbor_flash_reader_cpy(struct cbor_decoder_reader *d, char *dst, int offset, size_t len) {
+    struct cbor_flash_reader *cb = (struct cbor_flash_reader *) d;
+
+    /* Strings go straight to the destination; the window is for headers. */
+    if (flash_area_read(cb->fa, cb->off + offset, dst, len)) {
+        cb->err = 1;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Sets up a reader for CBOR data stored in a flash area.  The area must stay
+ * open, and the data unchanged, while it is being parsed.  A failed flash
+ * read makes the parser see erased flash, which usually fails the parse;
+ * check cb->err afterwards to tell the two apart.
+ *
+ * @param cb            The reader to initialize.
+ * @param fa            The flash area the data is in.
+ * @param off           Offset of the data in the area.
+ * @param len           Length of the data.
+ */
+void
+cbor_flash_reader_init(struct cbor_flash_reader *cb,
+                       const struct flash_area *fa, uint32_t off, size_t len)
+{
+    cb->r.get8 = &cbuf_flash_reader_get8;
+    cb->r.get16 = &cbuf_flash_reader_get16;
+    cb->r.get32 = &cbuf_flash_reader_get32;
+    cb->r.get64 = &cbuf_flash_reader_get64;
+    cb->r.cmp = &cbor_flash_reader_cmp;
+    cb->r.cpy = &cbor_flash_reader_cpy;
+    cb->r.message_size = len;
+
+    cb->fa = fa;
+    cb->off = off;
+    cb->win_off = 0;
+    cb->win_len = 0;
+    cb->err = 0;
+}
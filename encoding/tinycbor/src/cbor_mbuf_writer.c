@@ -17,30 +17,65 @@
  * under the License.
  */
 
+#include <string.h>
 #include <tinycbor/cbor.h>
 #include <os/os_mbuf.h>
-#include <tinycbor/cbor.h>
 #include <tinycbor/cbor_mbuf_writer.h>
 
 int
 cbor_mbuf_writer(struct cbor_encoder_writer *arg, const char *data, int len) {
     int rc;
     struct CborMbufWriter *cb = (struct CborMbufWriter *) arg;
-    rc = os_mbuf_append(cb->m, data, len);
+    struct os_mbuf *om;
 
-    if (rc) {
-        return CborErrorOutOfMemory;
+    om = cb->tail;
+    if (SLIST_NEXT(om, om_next) == NULL && OS_MBUF_TRAILINGSPACE(om) >= len) {
+        memcpy(om->om_data + om->om_len, data, len);
+        om->om_len += len;
+        if (OS_MBUF_IS_PKTHDR(cb->m)) {
+            OS_MBUF_PKTHDR(cb->m)->omp_len += len;
+        }
+    } else {
+        rc = os_mbuf_append(cb->m, data, len);
+        if (rc) {
+            return CborErrorOutOfMemory;
+        }
+        while (SLIST_NEXT(om, om_next) != NULL) {
+            om = SLIST_NEXT(om, om_next);
+        }
+        cb->tail = om;
     }
 
     cb->enc.bytes_written += len;
     return CborNoError;
 }
 
+static int
+cbor_mbuf_rewriter(struct cbor_encoder_writer *arg, int off, const char *data,
+                   int len) {
+    struct CborMbufWriter *cb = (struct CborMbufWriter *) arg;
+
+    if (off < 0 || off + len > cb->enc.bytes_written) {
+        return CborErrorInternalError;
+    }
+    if (os_mbuf_copyinto(cb->m, cb->base + off, data, len)) {
+        return CborErrorOutOfMemory;
+    }
+    return CborNoError;
+}
 
 void
 cbor_mbuf_writer_init(struct CborMbufWriter *cb, struct os_mbuf *m) {
+    struct os_mbuf *om;
+
     cb->m = m;
+    cb->base = m->om_len;
+    for (om = m; SLIST_NEXT(om, om_next) != NULL; ) {
+        om = SLIST_NEXT(om, om_next);
+        cb->base += om->om_len;
+    }
+    cb->tail = om;
     cb->enc.bytes_written = 0;
     cb->enc.write = &cbor_mbuf_writer;
+    cb->enc.rewrite = &cbor_mbuf_rewriter;
 }
-
@@ -433,6 +433,7 @@ static CborError create_container(CborEncoder *encoder, CborEncoder *container,
 
     if (length == CborIndefiniteLength) {
         container->flags |= CborIteratorFlag_UnknownLength;
+        container->hdr_off = container->writer->bytes_written;
         err = append_byte_to_buffer(container, shiftedMajorType + IndefiniteLength);
     } else {
         err = encode_number_no_update(container, length, shiftedMajorType);
@@ -501,11 +502,31 @@ CborError cbor_encoder_create_map(CborEncoder *encoder, CborEncoder *mapEncoder,
  */
 CborError cbor_encoder_close_container(CborEncoder *encoder, const CborEncoder *containerEncoder)
 {
+    uint8_t hdr;
+    size_t count;
+
     encoder->writer = containerEncoder->writer;
 
-    if (containerEncoder->flags & CborIteratorFlag_UnknownLength)
-        return append_byte_to_buffer(encoder, BreakByte);
-    return CborNoError;
+    if (!(containerEncoder->flags & CborIteratorFlag_UnknownLength))
+        return CborNoError;
+
+    /* If the writer can go back and the item count fits in the initial
+     * byte, turn the container into a definite-length one: same header size
+     * and no break byte.  Longer containers stay indefinite-length. */
+    count = containerEncoder->added;
+    if (containerEncoder->flags & CborIteratorFlag_ContainerIsMap) {
+        hdr = MapType << MajorTypeShift;
+        count /= 2;
+    } else {
+        hdr = ArrayType << MajorTypeShift;
+    }
+    if (encoder->writer->rewrite && count < Value8Bit) {
+        hdr += count;
+        if (encoder->writer->rewrite(encoder->writer, containerEncoder->hdr_off,
+                                     (const char *)&hdr, 1) == CborNoError)
+            return CborNoError;
+    }
+    return append_byte_to_buffer(encoder, BreakByte);
 }
 
 /**
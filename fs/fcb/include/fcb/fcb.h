@@ -29,6 +29,7 @@ extern "C" {
 #include <inttypes.h>
 #include <limits.h>
 
+#include "syscfg/syscfg.h"
 #include "flash_map/flash_map.h"
 
 #include "os/os_mutex.h"
@@ -46,13 +47,29 @@ struct fcb_entry {
     uint16_t fe_data_len;	/* size of data area */
 };
 
+/*
+ * Sparse in-RAM index of one sector; the offsets of every fsi_stride'th
+ * valid entry.  Rebuilt by fcb_init(), and updated by fcb_append_finish().
+ */
+struct fcb_sector_index {
+    uint32_t fsi_marks[MYNEWT_VAL(FCB_INDEX_MARKS)]; /* entry offsets */
+    uint16_t fsi_cnt;		/* Number of valid entries in sector */
+    uint16_t fsi_stride;	/* Entries between consecutive marks */
+    uint8_t fsi_mark_cnt;	/* Number of marks in use */
+};
+
 struct fcb {
-    /* Caller of fcb_init fills this in */
+    /*
+     * Caller of fcb_init fills this in. Zero the whole struct first; the
+     * optional fields, like f_index, are read by fcb_init() and must be 0
+     * when not used.
+     */
     uint32_t f_magic;		/* As placed on the disk */
     uint8_t f_version;  	/* Current version number of the data */
     uint8_t f_sector_cnt;	/* Number of elements in sector array */
     uint8_t f_scratch_cnt;	/* How many sectors should be kept empty */
     struct flash_area *f_sectors; /* Array of sectors, must be contiguous */
+    struct fcb_sector_index *f_index; /* Optional, f_sector_cnt elements */
 
     /* Flash circular buffer internal state */
     struct os_mutex f_mtx;	/* Locking for accessing the FCB data */
@@ -60,6 +77,7 @@ struct fcb {
     struct fcb_entry f_active;
     uint16_t f_active_id;
     uint8_t f_align;		/* writes to flash have to aligned to this */
+    struct flash_area *volatile f_erasing; /* sector fcb_erase_step() is on */
 };
 
 /*
@@ -91,10 +109,36 @@ int log_fcb_init(struct fcb_log *fcblog, struct fcb *fcb, uint16_t entries);
  * contents for the entry, use loc->fl_area and loc->fl_data_off with
  * flash_area_write(). When you're finished, call fcb_append_finish() with
  * loc as argument.
+ *
+ * fcb_append() reserves space: it holds the FCB lock only to move the write
+ * pointer and write the entry length, which keeps the layout recoverable
+ * after a reset. The contents are written without the lock, and
+ * fcb_append_finish() commits the entry by writing its CRC. Readers do not
+ * lock; they see an entry once it has been committed.
  */
 int fcb_append(struct fcb *, uint16_t len, struct fcb_entry *loc);
 int fcb_append_finish(struct fcb *, struct fcb_entry *append_loc);
 
+/*
+ * Batched appends. fcb_batch_add() lays records out in a caller supplied RAM
+ * buffer exactly as they will appear in flash, and fcb_batch_write() stores
+ * all of them with a single flash write. Every record carries its own CRC,
+ * so a write interrupted by reset leaves a prefix of complete records; the
+ * rest of the batch fails CRC check and is skipped by readers.
+ * A batch must fit within one sector.
+ */
+struct fcb_batch {
+    uint8_t *fb_buf;		/* staging buffer */
+    uint16_t fb_buf_sz;		/* size of staging buffer */
+    uint16_t fb_len;		/* bytes staged */
+    uint16_t fb_cnt;		/* records staged */
+};
+
+void fcb_batch_init(struct fcb_batch *, void *buf, uint16_t buf_sz);
+int fcb_batch_add(struct fcb *, struct fcb_batch *, const void *data,
+  uint16_t len);
+int fcb_batch_write(struct fcb *, struct fcb_batch *);
+
 /*
  * Walk over all log entries in FCB, or entries in a given flash_area.
  * cb gets called for every entry. If cb wants to stop the walk, it should
@@ -104,14 +148,40 @@ int fcb_append_finish(struct fcb *, struct fcb_entry *append_loc);
  * loc->fe_area, loc->fe_data_off, and loc->fe_data_len as arguments.
  */
 typedef int (*fcb_walk_cb)(struct fcb_entry *loc, void *arg);
+/*
+ * fcb_walk() and fcb_getnext() do not take the FCB lock, so they do not
+ * wait for, or hold up, appends.
+ */
 int fcb_walk(struct fcb *, struct flash_area *, fcb_walk_cb cb, void *cb_arg);
 int fcb_getnext(struct fcb *, struct fcb_entry *loc);
 
+/*
+ * Fills in fe_data_off and fe_data_len of the entry at loc->fe_area,
+ * loc->fe_elem_off, and checks its CRC. Used to get back to an entry found
+ * earlier.
+ */
+int fcb_elem_info(struct fcb *, struct fcb_entry *loc);
+
+/*
+ * Finds the n'th entry, counting from 0 at the oldest entry. With f_index
+ * set this jumps to the nearest indexed entry instead of reading every
+ * entry before it. The index assumes entries are finished with
+ * fcb_append_finish() in the order they were appended.
+ */
+int fcb_getnth(struct fcb *, uint32_t n, struct fcb_entry *loc);
+
 /*
  * Erases the data from oldest sector.
  */
 int fcb_rotate(struct fcb *);
 
+/*
+ * With FCB_DEFERRED_ERASE, erase one sector retired by fcb_rotate().
+ * Returns FCB_ERR_NOVAR when no sector is waiting to be erased. The FCB is
+ * not locked while the erase is in progress.
+ */
+int fcb_erase_step(struct fcb *);
+
 /*
  * Start using the scratch block.
  */
@@ -38,6 +38,7 @@ fcb_init(struct fcb *fcb)
     if (!fcb->f_sectors || fcb->f_sector_cnt - fcb->f_scratch_cnt < 1) {
         return FCB_ERR_ARGS;
     }
+    fcb->f_erasing = NULL;
 
     /* Fill last used, first used */
     for (i = 0; i < fcb->f_sector_cnt; i++) {
@@ -90,6 +91,9 @@ fcb_init(struct fcb *fcb)
             break;
         }
     }
+    if (rc == FCB_OK) {
+        fcb_index_build(fcb);
+    }
     os_mutex_init(&fcb->f_mtx);
     return rc;
 }
@@ -154,6 +158,39 @@ fcb_get_len(uint8_t *buf, uint16_t *len)
     return rc;
 }
 
+#if MYNEWT_VAL(FCB_DEFERRED_ERASE)
+/**
+ * Make sure a sector about to be taken into use is erased; it can still
+ * hold entries retired by fcb_rotate().
+ */
+static int
+fcb_sector_prepare(struct fcb *fcb, struct flash_area *fap)
+{
+    int rc;
+
+    /*
+     * fcb_erase_step() might be erasing this one. Wait for it, keeping
+     * f_mtx held so that FCB state does not change meanwhile.
+     */
+    while (fcb->f_erasing == fap) {
+        os_time_delay(1);
+    }
+
+    rc = fcb_sector_hdr_read(fcb, fap, NULL);
+    if (rc == 0) {
+        return 0;
+    }
+    if (rc == FCB_ERR_FLASH) {
+        return rc;
+    }
+    rc = flash_area_erase(fap, 0, fap->fa_size);
+    if (rc) {
+        return FCB_ERR_FLASH;
+    }
+    return 0;
+}
+#endif
+
 /**
  * Initialize erased sector for use.
  */
@@ -163,6 +200,13 @@ fcb_sector_hdr_init(struct fcb *fcb, struct flash_area *fap, uint16_t id)
     struct fcb_disk_area fda;
     int rc;
 
+#if MYNEWT_VAL(FCB_DEFERRED_ERASE)
+    rc = fcb_sector_prepare(fcb, fap);
+    if (rc) {
+        return rc;
+    }
+#endif
+
     fda.fd_magic = fcb->f_magic;
     fda.fd_ver = fcb->f_version;
     fda._pad = 0xff;
@@ -172,6 +216,7 @@ fcb_sector_hdr_init(struct fcb *fcb, struct flash_area *fap, uint16_t id)
     if (rc) {
         return FCB_ERR_FLASH;
     }
+    fcb_index_reset(fcb, fap);
     return 0;
 }
 
@@ -216,8 +261,32 @@ fcb_offset_last_n(struct fcb *fcb, uint8_t entries, uint32_t *last_n_off)
 {
     struct fcb_entry loc;
     struct fcb_entry start;
+    uint32_t cnt;
     int i;
 
+    if (fcb->f_index && entries > 0) {
+        /*
+         * Same result as the walk below, without reading every entry: the
+         * offset of the entry following the entries'th newest one, or of
+         * the first entry if there are fewer.
+         */
+        cnt = fcb_index_entry_cnt(fcb);
+        if (cnt == 0) {
+            return 0;
+        }
+        if (cnt < entries) {
+            cnt = 0;
+        } else {
+            cnt -= entries - 1;
+        }
+        if (fcb_getnth(fcb, cnt, &loc) == 0) {
+            *last_n_off = loc.fe_elem_off;
+        } else {
+            *last_n_off = fcb->f_active.fe_elem_off;
+        }
+        return 0;
+    }
+
     i = 0;
     memset(&loc, 0, sizeof(loc));
     while (!fcb_getnext(fcb, &loc)) {
@@ -17,6 +17,9 @@
  * under the License.
  */
 #include <stddef.h>
+#include <string.h>
+
+#include <crc/crc8.h>
 
 #include "fcb/fcb.h"
 #include "fcb_priv.h"
@@ -66,11 +69,38 @@ fcb_append_to_scratch(struct fcb *fcb)
     return FCB_OK;
 }
 
+/*
+ * Make sure the active area has room for len more bytes, moving to a new
+ * area if needed. Called with f_mtx held.
+ */
+static int
+fcb_reserve(struct fcb *fcb, uint32_t len)
+{
+    struct fcb_entry *active;
+    struct flash_area *fa;
+    int rc;
+
+    active = &fcb->f_active;
+    if (active->fe_elem_off + len > active->fe_area->fa_size) {
+        fa = fcb_new_area(fcb, fcb->f_scratch_cnt);
+        if (!fa || (fa->fa_size < sizeof(struct fcb_disk_area) + len)) {
+            return FCB_ERR_NOSPACE;
+        }
+        rc = fcb_sector_hdr_init(fcb, fa, fcb->f_active_id + 1);
+        if (rc) {
+            return rc;
+        }
+        fcb->f_active.fe_area = fa;
+        fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
+        fcb->f_active_id++;
+    }
+    return 0;
+}
+
 int
 fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
 {
     struct fcb_entry *active;
-    struct flash_area *fa;
     uint8_t tmp_str[2];
     int cnt;
     int rc;
@@ -87,20 +117,9 @@ fcb_append(struct fcb *fcb, uint16_t len, struct fcb_entry *append_loc)
         return FCB_ERR_ARGS;
     }
     active = &fcb->f_active;
-    if (active->fe_elem_off + len + cnt > active->fe_area->fa_size) {
-        fa = fcb_new_area(fcb, fcb->f_scratch_cnt);
-        if (!fa || (fa->fa_size <
-            sizeof(struct fcb_disk_area) + len + cnt)) {
-            rc = FCB_ERR_NOSPACE;
-            goto err;
-        }
-        rc = fcb_sector_hdr_init(fcb, fa, fcb->f_active_id + 1);
-        if (rc) {
-            goto err;
-        }
-        fcb->f_active.fe_area = fa;
-        fcb->f_active.fe_elem_off = sizeof(struct fcb_disk_area);
-        fcb->f_active_id++;
+    rc = fcb_reserve(fcb, len + cnt);
+    if (rc) {
+        goto err;
     }
 
     rc = flash_area_write(active->fe_area, active->fe_elem_off, tmp_str, cnt);
@@ -139,5 +158,126 @@ fcb_append_finish(struct fcb *fcb, struct fcb_entry *loc)
     if (rc) {
         return FCB_ERR_FLASH;
     }
+
+    if (fcb->f_index) {
+        rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+        if (rc && rc != OS_NOT_STARTED) {
+            return FCB_ERR_ARGS;
+        }
+        fcb_index_add(fcb, loc);
+        os_mutex_release(&fcb->f_mtx);
+    }
     return 0;
 }
+
+void
+fcb_batch_init(struct fcb_batch *batch, void *buf, uint16_t buf_sz)
+{
+    batch->fb_buf = buf;
+    batch->fb_buf_sz = buf_sz;
+    batch->fb_len = 0;
+    batch->fb_cnt = 0;
+}
+
+/*
+ * Stage a record; length, data and CRC are placed at the same alignment
+ * fcb_append() would use. Padding is left as erased flash.
+ */
+int
+fcb_batch_add(struct fcb *fcb, struct fcb_batch *batch, const void *data,
+  uint16_t len)
+{
+    uint8_t tmp_str[2];
+    uint8_t crc8;
+    uint8_t *p;
+    int cnt;
+    int sz;
+
+    cnt = fcb_put_len(tmp_str, len);
+    if (cnt < 0) {
+        return cnt;
+    }
+    sz = fcb_len_in_flash(fcb, cnt) + fcb_len_in_flash(fcb, len) +
+      fcb_len_in_flash(fcb, FCB_CRC_SZ);
+    if (batch->fb_len + sz > batch->fb_buf_sz) {
+        return FCB_ERR_NOMEM;
+    }
+
+    crc8 = crc8_init();
+    crc8 = crc8_calc(crc8, tmp_str, cnt);
+    crc8 = crc8_calc(crc8, (void *)data, len);
+
+    p = batch->fb_buf + batch->fb_len;
+    memset(p, 0xff, sz);
+    memcpy(p, tmp_str, cnt);
+    p += fcb_len_in_flash(fcb, cnt);
+    memcpy(p, data, len);
+    p += fcb_len_in_flash(fcb, len);
+    *p = crc8;
+
+    batch->fb_len += sz;
+    batch->fb_cnt++;
+    return FCB_OK;
+}
+
+/*
+ * Write all staged records with one flash write, and empty the batch.
+ * On FCB_ERR_NOSPACE the batch is kept, so it can be retried after
+ * fcb_rotate().
+ */
+int
+fcb_batch_write(struct fcb *fcb, struct fcb_batch *batch)
+{
+    struct fcb_entry *active;
+    struct fcb_entry loc;
+    uint32_t base;
+    uint16_t off;
+    uint16_t len;
+    int cnt;
+    int rc;
+
+    if (batch->fb_cnt == 0) {
+        return FCB_OK;
+    }
+
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+    active = &fcb->f_active;
+    rc = fcb_reserve(fcb, batch->fb_len);
+    if (rc) {
+        goto out;
+    }
+
+    /*
+     * Space is consumed even if the write fails; the area may be partially
+     * programmed.
+     */
+    base = active->fe_elem_off;
+    active->fe_elem_off += batch->fb_len;
+    rc = flash_area_write(active->fe_area, base, batch->fb_buf,
+      batch->fb_len);
+    if (rc) {
+        rc = FCB_ERR_FLASH;
+        goto out;
+    }
+
+    if (fcb->f_index) {
+        loc.fe_area = active->fe_area;
+        for (off = 0; off < batch->fb_len; ) {
+            cnt = fcb_get_len(batch->fb_buf + off, &len);
+            loc.fe_elem_off = base + off;
+            fcb_index_add(fcb, &loc);
+            off += fcb_len_in_flash(fcb, cnt) + fcb_len_in_flash(fcb, len) +
+              fcb_len_in_flash(fcb, FCB_CRC_SZ);
+        }
+    }
+out:
+    if (rc != FCB_ERR_NOSPACE) {
+        batch->fb_len = 0;
+        batch->fb_cnt = 0;
+    }
+    os_mutex_release(&fcb->f_mtx);
+    return rc;
+}
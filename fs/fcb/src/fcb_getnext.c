@@ -116,17 +116,15 @@ next_sector:
     return 0;
 }
 
+/*
+ * Readers do not take f_mtx. An entry becomes visible once its CRC has
+ * been written by fcb_append_finish(); entries still being written fail
+ * the CRC check, or end the walk at their unwritten length, and are
+ * skipped. The sector pointers read here are single words, updated under
+ * f_mtx by appends and fcb_rotate().
+ */
 int
 fcb_getnext(struct fcb *fcb, struct fcb_entry *loc)
 {
-    int rc;
-
-    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
-    if (rc && rc != OS_NOT_STARTED) {
-        return FCB_ERR_ARGS;
-    }
-    rc = fcb_getnext_nolock(fcb, loc);
-    os_mutex_release(&fcb->f_mtx);
-
-    return rc;
+    return fcb_getnext_nolock(fcb, loc);
 }
@@ -0,0 +1,186 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "fcb/fcb.h"
+#include "fcb_priv.h"
+
+#define FCB_INDEX_MARKS     MYNEWT_VAL(FCB_INDEX_MARKS)
+
+#if FCB_INDEX_MARKS < 1 || MYNEWT_VAL(FCB_INDEX_STRIDE) < 1
+#error "FCB_INDEX_MARKS and FCB_INDEX_STRIDE must be at least 1"
+#endif
+
+static struct fcb_sector_index *
+fcb_index_of(struct fcb *fcb, struct flash_area *fap)
+{
+    return &fcb->f_index[fap - fcb->f_sectors];
+}
+
+/*
+ * Forget everything indexed for a sector; called when it is (re)initialized.
+ */
+void
+fcb_index_reset(struct fcb *fcb, struct flash_area *fap)
+{
+    struct fcb_sector_index *fsi;
+
+    if (!fcb->f_index) {
+        return;
+    }
+    fsi = fcb_index_of(fcb, fap);
+    memset(fsi, 0, sizeof(*fsi));
+    fsi->fsi_stride = MYNEWT_VAL(FCB_INDEX_STRIDE);
+}
+
+/*
+ * Account for a valid entry at the end of a sector.
+ */
+void
+fcb_index_add(struct fcb *fcb, struct fcb_entry *loc)
+{
+    struct fcb_sector_index *fsi;
+    int i;
+
+    if (!fcb->f_index) {
+        return;
+    }
+    fsi = fcb_index_of(fcb, loc->fe_area);
+    if (fsi->fsi_cnt % fsi->fsi_stride == 0 &&
+      fsi->fsi_mark_cnt == FCB_INDEX_MARKS) {
+        /*
+         * Out of marks; keep every other one, and space them twice as far.
+         */
+        for (i = 0; 2 * i < FCB_INDEX_MARKS; i++) {
+            fsi->fsi_marks[i] = fsi->fsi_marks[2 * i];
+        }
+        fsi->fsi_mark_cnt = i;
+        fsi->fsi_stride *= 2;
+    }
+    if (fsi->fsi_cnt % fsi->fsi_stride == 0) {
+        fsi->fsi_marks[fsi->fsi_mark_cnt++] = loc->fe_elem_off;
+    }
+    fsi->fsi_cnt++;
+}
+
+/*
+ * Index everything currently in flash.
+ */
+void
+fcb_index_build(struct fcb *fcb)
+{
+    struct fcb_entry loc;
+    int i;
+
+    if (!fcb->f_index) {
+        return;
+    }
+    for (i = 0; i < fcb->f_sector_cnt; i++) {
+        fcb_index_reset(fcb, &fcb->f_sectors[i]);
+    }
+    memset(&loc, 0, sizeof(loc));
+    while (fcb_getnext_nolock(fcb, &loc) == 0) {
+        fcb_index_add(fcb, &loc);
+    }
+}
+
+/*
+ * Number of valid entries in the FCB, according to the index.
+ */
+uint32_t
+fcb_index_entry_cnt(struct fcb *fcb)
+{
+    struct flash_area *fap;
+    uint32_t cnt;
+
+    cnt = 0;
+    fap = fcb->f_oldest;
+    while (1) {
+        cnt += fcb_index_of(fcb, fap)->fsi_cnt;
+        if (fap == fcb->f_active.fe_area) {
+            break;
+        }
+        fap = fcb_getnext_area(fcb, fap);
+    }
+    return cnt;
+}
+
+static int
+fcb_getnth_indexed(struct fcb *fcb, uint32_t n, struct fcb_entry *loc)
+{
+    struct fcb_sector_index *fsi;
+    struct flash_area *fap;
+    int mark;
+    int rc;
+
+    fap = fcb->f_oldest;
+    while (1) {
+        fsi = fcb_index_of(fcb, fap);
+        if (n < fsi->fsi_cnt) {
+            break;
+        }
+        n -= fsi->fsi_cnt;
+        if (fap == fcb->f_active.fe_area) {
+            return FCB_ERR_NOVAR;
+        }
+        fap = fcb_getnext_area(fcb, fap);
+    }
+
+    mark = n / fsi->fsi_stride;
+    loc->fe_area = fap;
+    loc->fe_elem_off = fsi->fsi_marks[mark];
+    rc = fcb_elem_info(fcb, loc);
+    if (rc) {
+        return rc;
+    }
+    for (n -= mark * fsi->fsi_stride; n > 0; n--) {
+        rc = fcb_getnext_in_area(fcb, loc);
+        if (rc) {
+            return rc;
+        }
+    }
+    return 0;
+}
+
+int
+fcb_getnth(struct fcb *fcb, uint32_t n, struct fcb_entry *loc)
+{
+    int rc;
+
+    if (!fcb->f_index) {
+        /* Lock-free, like fcb_getnext(). */
+        memset(loc, 0, sizeof(*loc));
+        do {
+            rc = fcb_getnext_nolock(fcb, loc);
+        } while (rc == 0 && n-- > 0);
+        return rc;
+    }
+
+    /* The index is updated by fcb_append_finish() under f_mtx. */
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+    rc = fcb_getnth_indexed(fcb, n, loc);
+    os_mutex_release(&fcb->f_mtx);
+
+    return rc;
+}
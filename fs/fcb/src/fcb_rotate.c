@@ -31,11 +31,13 @@ fcb_rotate(struct fcb *fcb)
         return FCB_ERR_ARGS;
     }
 
+#if !MYNEWT_VAL(FCB_DEFERRED_ERASE)
     rc = flash_area_erase(fcb->f_oldest, 0, fcb->f_oldest->fa_size);
     if (rc) {
         rc = FCB_ERR_FLASH;
         goto out;
     }
+#endif
     if (fcb->f_oldest == fcb->f_active.fe_area) {
         /*
          * Need to create a new active area, as we're wiping the current.
@@ -54,3 +56,40 @@ out:
     os_mutex_release(&fcb->f_mtx);
     return rc;
 }
+
+int
+fcb_erase_step(struct fcb *fcb)
+{
+    struct flash_area *fap;
+    int rc;
+
+    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
+    if (rc && rc != OS_NOT_STARTED) {
+        return FCB_ERR_ARGS;
+    }
+
+    /*
+     * Sectors between the active and the oldest one are free. Erase the one
+     * that appends will need first.
+     */
+    fap = fcb->f_active.fe_area;
+    while (1) {
+        fap = fcb_getnext_area(fcb, fap);
+        if (fap == fcb->f_oldest) {
+            os_mutex_release(&fcb->f_mtx);
+            return FCB_ERR_NOVAR;
+        }
+        if (fcb_sector_hdr_read(fcb, fap, NULL) != 0) {
+            break;
+        }
+    }
+    fcb->f_erasing = fap;
+    os_mutex_release(&fcb->f_mtx);
+
+    rc = flash_area_erase(fap, 0, fap->fa_size);
+    fcb->f_erasing = NULL;
+    if (rc) {
+        return FCB_ERR_FLASH;
+    }
+    return 0;
+}
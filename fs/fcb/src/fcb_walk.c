@@ -33,12 +33,8 @@ fcb_walk(struct fcb *fcb, struct flash_area *fap, fcb_walk_cb cb, void *cb_arg)
     loc.fe_area = fap;
     loc.fe_elem_off = 0;
 
-    rc = os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
-    if (rc && rc != OS_NOT_STARTED) {
-        return FCB_ERR_ARGS;
-    }
+    /* Lock-free, like fcb_getnext(). */
     while ((rc = fcb_getnext_nolock(fcb, &loc)) != FCB_ERR_NOVAR) {
-        os_mutex_release(&fcb->f_mtx);
         if (fap && loc.fe_area != fap) {
             return 0;
         }
@@ -46,8 +42,6 @@ fcb_walk(struct fcb *fcb, struct flash_area *fap, fcb_walk_cb cb, void *cb_arg)
         if (rc) {
             return rc;
         }
-        os_mutex_pend(&fcb->f_mtx, OS_WAIT_FOREVER);
     }
-    os_mutex_release(&fcb->f_mtx);
     return 0;
 }
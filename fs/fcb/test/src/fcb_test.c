@@ -158,6 +158,12 @@ TEST_CASE_DECL(fcb_test_append_fill)
 TEST_CASE_DECL(fcb_test_reset)
 TEST_CASE_DECL(fcb_test_rotate)
 TEST_CASE_DECL(fcb_test_multiple_scratch)
+TEST_CASE_DECL(fcb_test_getnth)
+TEST_CASE_DECL(fcb_test_batch)
+TEST_CASE_DECL(fcb_test_reserve)
+#if MYNEWT_VAL(FCB_DEFERRED_ERASE)
+TEST_CASE_DECL(fcb_test_deferred_erase)
+#endif
 
 TEST_SUITE(fcb_test_all)
 {
@@ -188,6 +194,20 @@ TEST_SUITE(fcb_test_all)
 
     tu_case_set_pre_cb(fcb_tc_pretest, (void*)4);
     fcb_test_multiple_scratch();
+
+    tu_case_set_pre_cb(fcb_tc_pretest, (void*)2);
+    fcb_test_getnth();
+
+    tu_case_set_pre_cb(fcb_tc_pretest, (void*)2);
+    fcb_test_batch();
+
+    tu_case_set_pre_cb(fcb_tc_pretest, (void*)2);
+    fcb_test_reserve();
+
+#if MYNEWT_VAL(FCB_DEFERRED_ERASE)
+    tu_case_set_pre_cb(fcb_tc_pretest, (void*)2);
+    fcb_test_deferred_erase();
+#endif
 }
 
 #if MYNEWT_VAL(SELFTEST)
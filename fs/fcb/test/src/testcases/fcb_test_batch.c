@@ -0,0 +1,119 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+TEST_CASE(fcb_test_batch)
+{
+    struct fcb *fcb;
+    struct fcb_batch batch;
+    struct fcb_sector_index index[2];
+    struct fcb_entry loc;
+    uint8_t batch_buf[1024];
+    uint8_t test_data[32];
+    uint32_t off;
+    int var_cnt;
+    int rc;
+    int i;
+    int j;
+
+    fcb = &test_fcb;
+    fcb->f_index = index;
+    rc = fcb_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+    fcb_batch_init(&batch, batch_buf, sizeof(batch_buf));
+
+    /* Empty batch is a no-op */
+    rc = fcb_batch_write(fcb, &batch);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb_is_empty(fcb));
+
+    for (i = 0; i < sizeof(test_data); i++) {
+        for (j = 0; j < i; j++) {
+            test_data[j] = fcb_test_append_data(i, j);
+        }
+        rc = fcb_batch_add(fcb, &batch, test_data, i);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT(batch.fb_cnt == sizeof(test_data));
+
+    /* Staging buffer full */
+    rc = fcb_batch_add(fcb, &batch, batch_buf, sizeof(batch_buf));
+    TEST_ASSERT(rc == FCB_ERR_NOMEM);
+
+    rc = fcb_batch_write(fcb, &batch);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(batch.fb_cnt == 0 && batch.fb_len == 0);
+
+    var_cnt = 0;
+    rc = fcb_walk(fcb, 0, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == sizeof(test_data));
+
+    /* Batched records are indexed */
+    TEST_ASSERT(index[0].fsi_cnt == sizeof(test_data));
+    rc = fcb_getnth(fcb, 17, &loc);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(loc.fe_data_len == 17);
+
+    /*
+     * Interrupted batch write: only the first part of the staged records
+     * reaches flash. Complete records are kept, the torn one is skipped.
+     */
+    fcb_test_wipe();
+    memset(fcb, 0, sizeof(*fcb));
+    fcb->f_sector_cnt = 2;
+    fcb->f_sectors = test_fcb_area;
+    rc = fcb_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    fcb_batch_init(&batch, batch_buf, sizeof(batch_buf));
+    for (i = 0; i < 4; i++) {
+        for (j = 0; j < i; j++) {
+            test_data[j] = fcb_test_append_data(i, j);
+        }
+        rc = fcb_batch_add(fcb, &batch, test_data, i);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    off = fcb->f_active.fe_elem_off;
+    rc = flash_area_write(fcb->f_active.fe_area, off, batch_buf,
+      batch.fb_len - 2);
+    TEST_ASSERT(rc == 0);
+
+    rc = fcb_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    var_cnt = 0;
+    rc = fcb_walk(fcb, 0, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == 3);
+
+    /* Appends continue after the torn record */
+    TEST_ASSERT(fcb->f_active.fe_elem_off == off + batch.fb_len);
+
+    fcb_batch_init(&batch, batch_buf, sizeof(batch_buf));
+    rc = fcb_batch_add(fcb, &batch, test_data, 3);
+    TEST_ASSERT(rc == 0);
+    rc = fcb_batch_write(fcb, &batch);
+    TEST_ASSERT(rc == 0);
+
+    var_cnt = 0;
+    rc = fcb_walk(fcb, 0, fcb_test_data_walk_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == 4);
+}
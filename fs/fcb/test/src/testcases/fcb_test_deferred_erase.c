@@ -0,0 +1,121 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+#if MYNEWT_VAL(FCB_DEFERRED_ERASE)
+
+static int
+fcb_test_deferred_erase_fill(struct fcb *fcb)
+{
+    struct fcb_entry loc;
+    uint8_t test_data[128];
+    int cnt;
+    int rc;
+
+    memset(test_data, 0xa5, sizeof(test_data));
+    for (cnt = 0; ; cnt++) {
+        rc = fcb_append(fcb, sizeof(test_data), &loc);
+        if (rc == FCB_ERR_NOSPACE) {
+            break;
+        }
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = flash_area_write(loc.fe_area, loc.fe_data_off, test_data,
+          sizeof(test_data));
+        TEST_ASSERT(rc == 0);
+        rc = fcb_append_finish(fcb, &loc);
+        TEST_ASSERT(rc == 0);
+    }
+    return cnt;
+}
+
+static int
+fcb_test_deferred_erase_cnt(struct fcb *fcb)
+{
+    struct fcb_entry loc;
+    int cnt;
+
+    cnt = 0;
+    memset(&loc, 0, sizeof(loc));
+    while (fcb_getnext(fcb, &loc) == 0) {
+        cnt++;
+    }
+    return cnt;
+}
+
+TEST_CASE(fcb_test_deferred_erase)
+{
+    struct fcb *fcb;
+    struct flash_area *old;
+    int per_sector;
+    int cnt;
+    int rc;
+
+    fcb = &test_fcb;
+
+    /* Nothing to erase in a freshly initialized FCB */
+    rc = fcb_erase_step(fcb);
+    TEST_ASSERT(rc == FCB_ERR_NOVAR);
+
+    cnt = fcb_test_deferred_erase_fill(fcb);
+    per_sector = cnt / 2;
+    TEST_ASSERT_FATAL(cnt == 2 * per_sector && per_sector > 0);
+
+    /* Rotation drops the oldest sector without erasing it */
+    old = fcb->f_oldest;
+    rc = fcb_rotate(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb_sector_hdr_read(fcb, old, NULL) == 1);
+    TEST_ASSERT(fcb_test_deferred_erase_cnt(fcb) == per_sector);
+
+    /* Until erased, a restart finds the rotated entries again */
+    rc = fcb_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(fcb->f_oldest == old);
+    TEST_ASSERT(fcb_test_deferred_erase_cnt(fcb) == 2 * per_sector);
+    rc = fcb_rotate(fcb);
+    TEST_ASSERT(rc == 0);
+
+    /* Background erase */
+    rc = fcb_erase_step(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb_sector_hdr_read(fcb, old, NULL) == 0);
+    rc = fcb_erase_step(fcb);
+    TEST_ASSERT(rc == FCB_ERR_NOVAR);
+
+    cnt = fcb_test_deferred_erase_fill(fcb);
+    TEST_ASSERT(cnt == per_sector);
+    TEST_ASSERT(fcb_test_deferred_erase_cnt(fcb) == 2 * per_sector);
+
+    /* A sector still dirty when appends need it is erased then */
+    rc = fcb_rotate(fcb);
+    TEST_ASSERT(rc == 0);
+    cnt = fcb_test_deferred_erase_fill(fcb);
+    TEST_ASSERT(cnt == per_sector);
+    TEST_ASSERT(fcb_test_deferred_erase_cnt(fcb) == 2 * per_sector);
+
+    rc = fcb_clear(fcb);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(fcb_is_empty(fcb));
+    while (fcb_erase_step(fcb) == 0);
+    rc = fcb_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(fcb_test_deferred_erase_cnt(fcb) == 0);
+}
+
+#endif
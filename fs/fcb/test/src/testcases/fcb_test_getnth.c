@@ -0,0 +1,138 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+#define FCB_TEST_GETNTH_MAX     400
+
+static struct fcb_sector_index fcb_test_index[2];
+static struct fcb_entry fcb_test_locs[FCB_TEST_GETNTH_MAX];
+
+static int
+fcb_test_getnth_collect(struct fcb *fcb)
+{
+    struct fcb_entry loc;
+    int cnt;
+
+    cnt = 0;
+    memset(&loc, 0, sizeof(loc));
+    while (fcb_getnext(fcb, &loc) == 0) {
+        TEST_ASSERT_FATAL(cnt < FCB_TEST_GETNTH_MAX);
+        fcb_test_locs[cnt++] = loc;
+    }
+    return cnt;
+}
+
+static void
+fcb_test_getnth_append(struct fcb *fcb, int cnt)
+{
+    struct fcb_entry loc;
+    uint8_t test_data[80];
+    int rc;
+    int i;
+
+    for (i = 0; i < cnt; i++) {
+        memset(test_data, i, sizeof(test_data));
+        rc = fcb_append(fcb, sizeof(test_data), &loc);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = flash_area_write(loc.fe_area, loc.fe_data_off, test_data,
+          sizeof(test_data));
+        TEST_ASSERT(rc == 0);
+        rc = fcb_append_finish(fcb, &loc);
+        TEST_ASSERT(rc == 0);
+    }
+}
+
+static void
+fcb_test_getnth_verify(struct fcb *fcb)
+{
+    static const uint8_t last_n[] = { 1, 2, 3, 17, 100, 255 };
+    struct fcb_sector_index *index;
+    struct fcb_entry loc;
+    uint32_t off_indexed;
+    uint32_t off;
+    int cnt;
+    int rc;
+    int i;
+
+    cnt = fcb_test_getnth_collect(fcb);
+    for (i = 0; i < cnt; i++) {
+        rc = fcb_getnth(fcb, i, &loc);
+        TEST_ASSERT_FATAL(rc == 0, "n=%d rc=%d", i, rc);
+        TEST_ASSERT(loc.fe_area == fcb_test_locs[i].fe_area);
+        TEST_ASSERT(loc.fe_elem_off == fcb_test_locs[i].fe_elem_off);
+        TEST_ASSERT(loc.fe_data_len == fcb_test_locs[i].fe_data_len);
+    }
+    rc = fcb_getnth(fcb, cnt, &loc);
+    TEST_ASSERT(rc == FCB_ERR_NOVAR);
+
+    for (i = 0; i < sizeof(last_n); i++) {
+        off_indexed = off = 0xffffffff;
+        rc = fcb_offset_last_n(fcb, last_n[i], &off_indexed);
+        TEST_ASSERT(rc == 0);
+
+        index = fcb->f_index;
+        fcb->f_index = NULL;
+        rc = fcb_offset_last_n(fcb, last_n[i], &off);
+        fcb->f_index = index;
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(off_indexed == off, "n=%d off=%u expected=%u",
+          last_n[i], (unsigned)off_indexed, (unsigned)off);
+    }
+}
+
+TEST_CASE(fcb_test_getnth)
+{
+    struct fcb *fcb;
+    struct fcb_entry loc;
+    int rc;
+
+    fcb = &test_fcb;
+
+    /* Without an index */
+    rc = fcb_getnth(fcb, 0, &loc);
+    TEST_ASSERT(rc == FCB_ERR_NOVAR);
+    fcb_test_getnth_append(fcb, 50);
+    fcb_test_getnth_verify(fcb);
+
+    /* Index built by fcb_init() */
+    fcb->f_index = fcb_test_index;
+    rc = fcb_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(fcb_test_index[0].fsi_cnt == 50);
+    fcb_test_getnth_verify(fcb);
+
+    /* Index maintained by fcb_append_finish(), spanning both sectors */
+    fcb_test_getnth_append(fcb, 250);
+    TEST_ASSERT(fcb_test_index[0].fsi_cnt + fcb_test_index[1].fsi_cnt == 300);
+    TEST_ASSERT(fcb_test_index[0].fsi_stride >
+      MYNEWT_VAL(FCB_INDEX_STRIDE));
+    fcb_test_getnth_verify(fcb);
+
+    /* Rotating drops the oldest sector */
+    rc = fcb_rotate(fcb);
+    TEST_ASSERT(rc == 0);
+    fcb_test_getnth_verify(fcb);
+
+    /* Rebuilt index matches the incrementally maintained one */
+    rc = fcb_init(fcb);
+    TEST_ASSERT_FATAL(rc == 0);
+    fcb_test_getnth_verify(fcb);
+
+    fcb->f_index = NULL;
+}
@@ -0,0 +1,97 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "fcb_test.h"
+
+static int
+fcb_test_reserve_cnt_cb(struct fcb_entry *loc, void *arg)
+{
+    (*(int *)arg)++;
+    return 0;
+}
+
+static void
+fcb_test_reserve_write(struct fcb *fcb, struct fcb_entry *loc, int len)
+{
+    uint8_t test_data[16];
+    int rc;
+    int i;
+
+    for (i = 0; i < len; i++) {
+        test_data[i] = fcb_test_append_data(len, i);
+    }
+    rc = fcb_append(fcb, len, loc);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_write(loc->fe_area, loc->fe_data_off, test_data, len);
+    TEST_ASSERT(rc == 0);
+}
+
+TEST_CASE(fcb_test_reserve)
+{
+    struct fcb *fcb;
+    struct fcb_entry loc[3];
+    struct fcb_entry next;
+    int var_cnt;
+    int rc;
+
+    fcb = &test_fcb;
+
+    /*
+     * An entry that has been written but not committed is not visible to
+     * readers; entries committed after it are.
+     */
+    fcb_test_reserve_write(fcb, &loc[0], 4);
+    rc = fcb_append_finish(fcb, &loc[0]);
+    TEST_ASSERT(rc == 0);
+    fcb_test_reserve_write(fcb, &loc[1], 8);
+    fcb_test_reserve_write(fcb, &loc[2], 12);
+    rc = fcb_append_finish(fcb, &loc[2]);
+    TEST_ASSERT(rc == 0);
+
+    var_cnt = 0;
+    rc = fcb_walk(fcb, 0, fcb_test_reserve_cnt_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == 2);
+
+    memset(&next, 0, sizeof(next));
+    rc = fcb_getnext(fcb, &next);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(next.fe_elem_off == loc[0].fe_elem_off);
+    rc = fcb_getnext(fcb, &next);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(next.fe_elem_off == loc[2].fe_elem_off);
+    rc = fcb_getnext(fcb, &next);
+    TEST_ASSERT(rc == FCB_ERR_NOVAR);
+
+    /* Committing it makes it visible, in place. */
+    rc = fcb_append_finish(fcb, &loc[1]);
+    TEST_ASSERT(rc == 0);
+
+    var_cnt = 0;
+    rc = fcb_walk(fcb, 0, fcb_test_reserve_cnt_cb, &var_cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(var_cnt == 3);
+
+    memset(&next, 0, sizeof(next));
+    rc = fcb_getnext(fcb, &next);
+    TEST_ASSERT(rc == 0);
+    rc = fcb_getnext(fcb, &next);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(next.fe_elem_off == loc[1].fe_elem_off);
+    TEST_ASSERT(next.fe_data_len == 8);
+}
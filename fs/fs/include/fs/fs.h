@@ -33,14 +33,19 @@ extern "C" {
 struct fs_file;
 struct fs_dir;
 struct fs_dirent;
+struct os_mbuf;
 
 int fs_open(const char *filename, uint8_t access_flags, struct fs_file **);
 int fs_close(struct fs_file *);
 int fs_read(struct fs_file *, uint32_t len, void *out_data, uint32_t *out_len);
 int fs_write(struct fs_file *, const void *data, int len);
+int fs_read_mbuf(struct fs_file *, uint32_t len, struct os_mbuf *om,
+  uint32_t *out_len);
+int fs_write_mbuf(struct fs_file *, const struct os_mbuf *om);
 int fs_seek(struct fs_file *, uint32_t offset);
 uint32_t fs_getpos(const struct fs_file *);
 int fs_filelen(const struct fs_file *, uint32_t *out_len);
+int fs_version(const struct fs_file *, uint32_t *out_ver);
 
 int fs_unlink(const char *filename);
 int fs_rename(const char *from, const char *to);
@@ -52,6 +57,7 @@ int fs_closedir(struct fs_dir *);
 int fs_dirent_name(const struct fs_dirent *, size_t max_len,
   char *out_name, uint8_t *out_name_len);
 int fs_dirent_is_dir(const struct fs_dirent *);
+int fs_dirent_size(const struct fs_dirent *, uint32_t *out_len);
 
 /*
  * File access flags.
@@ -35,10 +35,25 @@ struct fs_ops {
       uint32_t *out_len);
     int (*f_write)(struct fs_file *file, const void *data, int len);
 
+    /*
+     * Optional; read into / write from an mbuf chain without an intermediate
+     * flat buffer. fs_read_mbuf() and fs_write_mbuf() fall back to f_read
+     * and f_write when these are not provided.
+     */
+    int (*f_read_mbuf)(struct fs_file *file, uint32_t len, struct os_mbuf *om,
+      uint32_t *out_len);
+    int (*f_write_mbuf)(struct fs_file *file, const struct os_mbuf *om);
+
     int (*f_seek)(struct fs_file *file, uint32_t offset);
     uint32_t (*f_getpos)(const struct fs_file *file);
     int (*f_filelen)(const struct fs_file *file, uint32_t *out_len);
 
+    /*
+     * Optional; a value that changes whenever the file is written to or
+     * renamed.
+     */
+    int (*f_version)(const struct fs_file *file, uint32_t *out_ver);
+
     int (*f_unlink)(const char *filename);
     int (*f_rename)(const char *from, const char *to);
     int (*f_mkdir)(const char *path);
@@ -51,6 +66,11 @@ struct fs_ops {
       char *out_name, uint8_t *out_name_len);
     int (*f_dirent_is_dir)(const struct fs_dirent *dirent);
 
+    /*
+     * Optional; size of a file entry without opening it.
+     */
+    int (*f_dirent_size)(const struct fs_dirent *dirent, uint32_t *out_len);
+
     const char *f_name;
 };
 
@@ -83,6 +83,7 @@ fs_ls_cmd(int argc, char **argv)
     char name[64];
     int plen;
     uint8_t namelen;
+    uint32_t len;
 
     switch (argc) {
     case 1:
@@ -122,12 +123,16 @@ fs_ls_cmd(int argc, char **argv)
                 &namelen)) {
                 break;
             }
-            rc = fs_open(name, FS_ACCESS_READ, &file);
-            if (rc == 0) {
-                fs_ls_file(name, file);
-                fs_close(file);
-            } else {
+            if (fs_dirent_is_dir(dirent)) {
                 fs_ls_dir(name);
+            } else if (fs_dirent_size(dirent, &len) == 0) {
+                console_printf("\t%6lu %s\n", (unsigned long)len, name);
+            } else {
+                rc = fs_open(name, FS_ACCESS_READ, &file);
+                if (rc == 0) {
+                    fs_ls_file(name, file);
+                    fs_close(file);
+                }
             }
             file_cnt++;
         } while (1);
@@ -50,3 +50,12 @@ fs_dirent_is_dir(const struct fs_dirent *dirent)
 {
     return fs_root_ops->f_dirent_is_dir(dirent);
 }
+
+int
+fs_dirent_size(const struct fs_dirent *dirent, uint32_t *out_len)
+{
+    if (fs_root_ops->f_dirent_size == NULL) {
+        return FS_EINVAL;
+    }
+    return fs_root_ops->f_dirent_size(dirent, out_len);
+}
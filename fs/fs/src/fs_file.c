@@ -16,6 +16,7 @@
  * specific language governing permissions and limitations
  * under the License.
  */
+#include <os/os.h>
 #include <fs/fs.h>
 #include <fs/fs_if.h>
 
@@ -45,6 +46,99 @@ fs_write(struct fs_file *file, const void *data, int len)
     return fs_root_ops->f_write(file, data, len);
 }
 
+/*
+ * Size of the stack buffer used when the filesystem does not read into or
+ * write from mbufs natively.
+ */
+#define FS_MBUF_CHUNK_SZ    64
+
+/**
+ * Reads up to len bytes from the current position of a file and appends them
+ * to an mbuf chain. Fewer bytes are read if the end of the file is reached.
+ *
+ * @param file              The file to read from.
+ * @param len               The number of bytes to attempt to read.
+ * @param om                The packet header mbuf chain to append the data
+ *                              to; new buffers come from this chain's
+ *                              pool.
+ * @param out_len           On success, the number of bytes actually read
+ *                              gets written here.  Pass null if you don't
+ *                              care.
+ *
+ * @return                  0 on success; FS_ENOMEM if the mbuf pool ran
+ *                              out; other nonzero on failure.
+ */
+int
+fs_read_mbuf(struct fs_file *file, uint32_t len, struct os_mbuf *om,
+             uint32_t *out_len)
+{
+    uint8_t buf[FS_MBUF_CHUNK_SZ];
+    uint32_t total;
+    uint32_t chunk;
+    uint32_t got;
+    int rc;
+
+    if (fs_root_ops->f_read_mbuf != NULL) {
+        return fs_root_ops->f_read_mbuf(file, len, om, out_len);
+    }
+
+    total = 0;
+    rc = 0;
+    while (total < len) {
+        chunk = len - total;
+        if (chunk > sizeof buf) {
+            chunk = sizeof buf;
+        }
+        rc = fs_root_ops->f_read(file, chunk, buf, &got);
+        if (rc != 0) {
+            break;
+        }
+        if (os_mbuf_append(om, buf, got) != 0) {
+            rc = FS_ENOMEM;
+            break;
+        }
+        total += got;
+        if (got < chunk) {
+            break;
+        }
+    }
+
+    if (out_len != NULL) {
+        *out_len = total;
+    }
+    return rc;
+}
+
+/**
+ * Writes the contents of an mbuf chain to the current position of a file.
+ * The chain is not freed.
+ *
+ * @param file              The file to write to.
+ * @param om                The data to write.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+int
+fs_write_mbuf(struct fs_file *file, const struct os_mbuf *om)
+{
+    int rc;
+
+    if (fs_root_ops->f_write_mbuf != NULL) {
+        return fs_root_ops->f_write_mbuf(file, om);
+    }
+
+    for (; om != NULL; om = SLIST_NEXT(om, om_next)) {
+        if (om->om_len == 0) {
+            continue;
+        }
+        rc = fs_root_ops->f_write(file, om->om_data, om->om_len);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+    return 0;
+}
+
 int
 fs_seek(struct fs_file *file, uint32_t offset)
 {
@@ -63,6 +157,23 @@ fs_filelen(const struct fs_file *file, uint32_t *out_len)
     return fs_root_ops->f_filelen(file, out_len);
 }
 
+/**
+ * Retrieves a value identifying the current contents and name of a file,
+ * e.g. for use as a cache validator.  The value changes whenever the file is
+ * written to or renamed; it is not otherwise meaningful.
+ *
+ * @return 0 on success; FS_EINVAL if the file system does not track file
+ *         versions.
+ */
+int
+fs_version(const struct fs_file *file, uint32_t *out_ver)
+{
+    if (fs_root_ops->f_version == NULL) {
+        return FS_EINVAL;
+    }
+    return fs_root_ops->f_version(file, out_ver);
+}
+
 int
 fs_unlink(const char *filename)
 {
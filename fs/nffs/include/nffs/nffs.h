@@ -62,6 +62,19 @@ struct nffs_area_desc {
 int nffs_init(void);
 int nffs_detect(const struct nffs_area_desc *area_descs);
 int nffs_format(const struct nffs_area_desc *area_descs);
+int nffs_checkpoint(void);
+int nffs_flush(struct fs_file *file);
+
+struct nffs_area_info {
+    uint32_t nai_length;    /* Size of area, in bytes. */
+    uint32_t nai_used;      /* Bytes written since the area was erased. */
+    uint32_t nai_erase_cnt; /* Erases since the file system was mounted. */
+    uint8_t nai_gc_seq;     /* Persistent erase count, modulo 256. */
+    uint8_t nai_is_scratch; /* 1 if this is the scratch area. */
+};
+
+int nffs_gc_step(int *out_pending);
+int nffs_area_info(int area_idx, struct nffs_area_info *out_info);
 
 int nffs_misc_desc_from_flash_area(int idx, int *cnt, struct nffs_area_desc *nad);
 
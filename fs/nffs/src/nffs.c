@@ -68,9 +68,13 @@ static int nffs_close(struct fs_file *fs_file);
 static int nffs_read(struct fs_file *fs_file, uint32_t len, void *out_data,
   uint32_t *out_len);
 static int nffs_write(struct fs_file *fs_file, const void *data, int len);
+static int nffs_read_mbuf(struct fs_file *fs_file, uint32_t len,
+  struct os_mbuf *om, uint32_t *out_len);
+static int nffs_write_mbuf(struct fs_file *fs_file, const struct os_mbuf *om);
 static int nffs_seek(struct fs_file *fs_file, uint32_t offset);
 static uint32_t nffs_getpos(const struct fs_file *fs_file);
 static int nffs_file_len(const struct fs_file *fs_file, uint32_t *out_len);
+static int nffs_file_version(const struct fs_file *fs_file, uint32_t *out_ver);
 static int nffs_unlink(const char *path);
 static int nffs_rename(const char *from, const char *to);
 static int nffs_mkdir(const char *path);
@@ -80,16 +84,21 @@ static int nffs_closedir(struct fs_dir *dir);
 static int nffs_dirent_name(const struct fs_dirent *fs_dirent, size_t max_len,
   char *out_name, uint8_t *out_name_len);
 static int nffs_dirent_is_dir(const struct fs_dirent *fs_dirent);
+static int nffs_dirent_size(const struct fs_dirent *fs_dirent,
+                            uint32_t *out_len);
 
 static const struct fs_ops nffs_ops = {
     .f_open = nffs_open,
     .f_close = nffs_close,
     .f_read = nffs_read,
     .f_write = nffs_write,
+    .f_read_mbuf = nffs_read_mbuf,
+    .f_write_mbuf = nffs_write_mbuf,
 
     .f_seek = nffs_seek,
     .f_getpos = nffs_getpos,
     .f_filelen = nffs_file_len,
+    .f_version = nffs_file_version,
 
     .f_unlink = nffs_unlink,
     .f_rename = nffs_rename,
@@ -101,6 +110,7 @@ static const struct fs_ops nffs_ops = {
 
     .f_dirent_name = nffs_dirent_name,
     .f_dirent_is_dir = nffs_dirent_is_dir,
+    .f_dirent_size = nffs_dirent_size,
 
     .f_name = "nffs"
 };
@@ -109,14 +119,22 @@ STATS_SECT_DECL(nffs_stats) nffs_stats;
 STATS_NAME_START(nffs_stats)
     STATS_NAME(nffs_stats, nffs_hashcnt_ins)
     STATS_NAME(nffs_stats, nffs_hashcnt_rm)
+    STATS_NAME(nffs_stats, nffs_hashcnt_lookup)
+    STATS_NAME(nffs_stats, nffs_hashcnt_probe)
+    STATS_NAME(nffs_stats, nffs_hashcnt_grow)
+    STATS_NAME(nffs_stats, nffs_hashcnt_max_chain)
     STATS_NAME(nffs_stats, nffs_object_count)
     STATS_NAME(nffs_stats, nffs_iocnt_read)
     STATS_NAME(nffs_stats, nffs_iocnt_write)
     STATS_NAME(nffs_stats, nffs_gccnt)
+    STATS_NAME(nffs_stats, nffs_gccnt_step)
+    STATS_NAME(nffs_stats, nffs_gccnt_wear)
+    STATS_NAME(nffs_stats, nffs_gccnt_erase)
     STATS_NAME(nffs_stats, nffs_readcnt_data)
     STATS_NAME(nffs_stats, nffs_readcnt_block)
     STATS_NAME(nffs_stats, nffs_readcnt_crc)
     STATS_NAME(nffs_stats, nffs_readcnt_copy)
+    STATS_NAME(nffs_stats, nffs_readcnt_mapped)
     STATS_NAME(nffs_stats, nffs_readcnt_format)
     STATS_NAME(nffs_stats, nffs_readcnt_gccollate)
     STATS_NAME(nffs_stats, nffs_readcnt_inode)
@@ -126,6 +144,18 @@ STATS_NAME_START(nffs_stats)
     STATS_NAME(nffs_stats, nffs_readcnt_filename)
     STATS_NAME(nffs_stats, nffs_readcnt_object)
     STATS_NAME(nffs_stats, nffs_readcnt_detect)
+    STATS_NAME(nffs_stats, nffs_readcnt_ckpt)
+    STATS_NAME(nffs_stats, nffs_ckptcnt_write)
+    STATS_NAME(nffs_stats, nffs_ckptcnt_crc_skip)
+    STATS_NAME(nffs_stats, nffs_cachecnt_readahead)
+    STATS_NAME(nffs_stats, nffs_wbufcnt_write)
+    STATS_NAME(nffs_stats, nffs_wbufcnt_flush)
+    STATS_NAME(nffs_stats, nffs_dindexcnt_build)
+    STATS_NAME(nffs_stats, nffs_dindexcnt_evict)
+    STATS_NAME(nffs_stats, nffs_dindexcnt_hit)
+    STATS_NAME(nffs_stats, nffs_dindexcnt_collision)
+    STATS_NAME(nffs_stats, nffs_filecnt_dyn_alloc)
+    STATS_NAME(nffs_stats, nffs_filecnt_alloc_fail)
 STATS_NAME_END(nffs_stats)
 
 static void
@@ -299,6 +329,34 @@ nffs_file_len(const struct fs_file *fs_file, uint32_t *out_len)
 
     nffs_lock();
     rc = nffs_inode_data_len(file->nf_inode_entry, out_len);
+#if MYNEWT_VAL(NFFS_WRITE_BUF_SIZE) > 0
+    if (rc == 0) {
+        /* Buffered data always extends the file. */
+        *out_len += file->nf_wbuf_len;
+    }
+#endif
+    nffs_unlock();
+
+    return rc;
+}
+
+/**
+ * Retrieves a value that changes whenever the file is written to or renamed.
+ * Data still in the write buffer is not accounted for until it is flushed.
+ *
+ * @param file              The file to query.
+ * @param out_ver           On success, the file's version gets written here.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+static int
+nffs_file_version(const struct fs_file *fs_file, uint32_t *out_ver)
+{
+    int rc;
+    const struct nffs_file *file = (const struct nffs_file *)fs_file;
+
+    nffs_lock();
+    rc = nffs_inode_version(file->nf_inode_entry, out_ver);
     nffs_unlock();
 
     return rc;
@@ -364,6 +422,71 @@ done:
     return rc;
 }
 
+/**
+ * Reads data from the specified file and appends it to an mbuf chain.  Data
+ * goes from flash straight into the mbufs; no intermediate buffer is used.
+ *
+ * @param file              The file to read from.
+ * @param len               The number of bytes to attempt to read.
+ * @param om                The mbuf chain to append the data to.
+ * @param out_len           On success, the number of bytes actually read gets
+ *                              written here.  Pass null if you don't care.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+static int
+nffs_read_mbuf(struct fs_file *fs_file, uint32_t len, struct os_mbuf *om,
+               uint32_t *out_len)
+{
+    int rc;
+    struct nffs_file *file = (struct nffs_file *)fs_file;
+
+    nffs_lock();
+    rc = nffs_file_read_mbuf(file, len, om, out_len);
+    nffs_unlock();
+
+    return rc;
+}
+
+/**
+ * Writes the contents of an mbuf chain to the current offset of the specified
+ * file handle.  Each buffer in the chain is written in place.
+ *
+ * @param file              The file to write to.
+ * @param om                The data to write.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+static int
+nffs_write_mbuf(struct fs_file *fs_file, const struct os_mbuf *om)
+{
+    int rc;
+    struct nffs_file *file = (struct nffs_file *)fs_file;
+
+    nffs_lock();
+
+    if (!nffs_misc_ready()) {
+        rc = FS_EUNINIT;
+        goto done;
+    }
+
+    for (; om != NULL; om = SLIST_NEXT(om, om_next)) {
+        if (om->om_len == 0) {
+            continue;
+        }
+        rc = nffs_write_to_file(file, om->om_data, om->om_len);
+        if (rc != 0) {
+            goto done;
+        }
+    }
+
+    rc = 0;
+
+done:
+    nffs_unlock();
+    return rc;
+}
+
 /**
  * Unlinks the file or directory at the specified path.  If the path refers to
  * a directory, all the directory's descendants are recursively unlinked.  Any
@@ -572,14 +695,38 @@ static int
 nffs_dirent_name(const struct fs_dirent *fs_dirent, size_t max_len,
                  char *out_name, uint8_t *out_name_len)
 {
+    uint8_t name_len;
+    int read_len;
     int rc;
     struct nffs_dirent *dirent = (struct nffs_dirent *)fs_dirent;
 
     nffs_lock();
 
     assert(dirent != NULL && dirent->nde_inode_entry != NULL);
-    rc = nffs_inode_read_filename(dirent->nde_inode_entry, max_len, out_name,
-                                  out_name_len);
+
+    name_len = dirent->nde_inode.ni_filename_len;
+    if (max_len > name_len) {
+        read_len = name_len;
+    } else {
+        read_len = max_len - 1;
+    }
+
+#if MYNEWT_VAL(NFFS_DIRENT_NAME_LEN) > 0
+    if (dirent->nde_name_cached) {
+        memcpy(out_name, dirent->nde_name, read_len);
+        rc = 0;
+    } else
+#endif
+    {
+        rc = nffs_inode_read_filename_chunk(&dirent->nde_inode, 0, out_name,
+                                            read_len);
+    }
+    if (rc == 0) {
+        out_name[read_len] = '\0';
+        if (out_name_len != NULL) {
+            *out_name_len = name_len;
+        }
+    }
 
     nffs_unlock();
 
@@ -611,6 +758,26 @@ nffs_dirent_is_dir(const struct fs_dirent *fs_dirent)
     return nffs_hash_id_is_dir(id);
 }
 
+/**
+ * Retrieves the size of the specified directory entry, as it was when the
+ * entry was read.  Directories have a size of 0.
+ *
+ * @param dirent                The directory entry to query.
+ * @param out_len               On success, the entry's size is written here.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+static int
+nffs_dirent_size(const struct fs_dirent *fs_dirent, uint32_t *out_len)
+{
+    const struct nffs_dirent *dirent = (const struct nffs_dirent *)fs_dirent;
+
+    assert(dirent != NULL && dirent->nde_inode_entry != NULL);
+    *out_len = dirent->nde_data_len;
+
+    return 0;
+}
+
 /**
  * Erases all the specified areas and initializes them with a clean nffs
  * file system.
@@ -657,6 +824,136 @@ nffs_detect(const struct nffs_area_desc *area_descs)
     return rc;
 }
 
+/**
+ * Writes any data held in the specified file's write-back buffer to flash.
+ * Buffered data is also flushed when the file is closed, read, or
+ * repositioned, and whenever the buffer fills.
+ *
+ * @param file              The file to flush.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+int
+nffs_flush(struct fs_file *fs_file)
+{
+    int rc;
+    struct nffs_file *file = (struct nffs_file *)fs_file;
+
+    nffs_lock();
+    rc = nffs_write_flush(file);
+    nffs_unlock();
+
+    return rc;
+}
+
+/**
+ * Performs a bounded amount of garbage collection ahead of need.  This is
+ * intended to be called periodically from an application task while the file
+ * system is otherwise idle, so that writes rarely have to wait for a full
+ * garbage collection cycle.  A cycle is started only when free space falls
+ * below NFFS_GC_BG_THRESHOLD percent; each call processes at most
+ * NFFS_GC_STEP_BUCKETS hash buckets.
+ *
+ * @param out_pending       On success, 1 is written here if the current
+ *                              cycle requires more calls; 0 otherwise.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+int
+nffs_gc_step(int *out_pending)
+{
+    int rc;
+
+    nffs_lock();
+
+    if (!nffs_misc_ready()) {
+        rc = FS_EUNINIT;
+    } else {
+        rc = nffs_gc_slice(out_pending);
+    }
+
+    nffs_unlock();
+
+    return rc;
+}
+
+/**
+ * Retrieves usage and wear information about a single area.
+ *
+ * @param area_idx          The index of the area to query.
+ * @param out_info          On success, the area's information gets written
+ *                              here.
+ *
+ * @return                  0 on success;
+ *                          FS_EINVAL if the index is out of range;
+ *                          FS_EUNINIT if no file system is present.
+ */
+int
+nffs_area_info(int area_idx, struct nffs_area_info *out_info)
+{
+    const struct nffs_area *area;
+    int rc;
+
+    nffs_lock();
+
+    if (!nffs_misc_ready()) {
+        rc = FS_EUNINIT;
+    } else if (area_idx < 0 || area_idx >= nffs_num_areas) {
+        rc = FS_EINVAL;
+    } else {
+        area = nffs_areas + area_idx;
+        out_info->nai_length = area->na_length;
+        out_info->nai_used = area->na_cur;
+        out_info->nai_erase_cnt = area->na_erase_cnt;
+        out_info->nai_gc_seq = area->na_gc_seq;
+        out_info->nai_is_scratch = area_idx == nffs_scratch_area_idx;
+        rc = 0;
+    }
+
+    nffs_unlock();
+
+    return rc;
+}
+
+/**
+ * Writes a mount checkpoint describing the current state of the file system.
+ * A subsequent nffs_detect() only validates objects written after the
+ * checkpoint, which greatly reduces the amount of flash read at mount.  This
+ * is intended to be called before a clean shutdown.  The checkpoint is
+ * discarded by the next garbage collection cycle.
+ *
+ * @return                  0 on success;
+ *                          FS_EINVAL if checkpoints are not enabled;
+ *                          other nonzero on failure.
+ */
+int
+nffs_checkpoint(void)
+{
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    int rc;
+
+    nffs_lock();
+
+    if (!nffs_misc_ready()) {
+        rc = FS_EUNINIT;
+    } else {
+        /* The checkpoint is stored in the scratch area, which is in use
+         * until an unfinished garbage collection cycle completes.
+         */
+        rc = nffs_gc_finish();
+        if (rc == 0) {
+            rc = nffs_ckpt_write();
+        }
+    }
+
+    nffs_unlock();
+
+    return rc;
+#else
+    return FS_EINVAL;
+#endif
+}
+
 /**
  * Initializes internal nffs memory and data structures.  This must be called
  * before any nffs operations are attempted.
@@ -740,24 +1037,15 @@ nffs_init(void)
     return 0;
 }
 
-void
-nffs_pkg_init(void)
+static int
+nffs_pkg_restore(void *arg)
 {
-    struct nffs_area_desc descs[NFFS_AREA_MAX + 1];
-    int cnt;
+    struct nffs_area_desc *descs;
+    uint32_t mark;
     int rc;
 
-    /* Initialize nffs's internal state. */
-    rc = nffs_init();
-    SYSINIT_PANIC_ASSERT(rc == 0);
-
-    /* Convert the set of flash blocks we intend to use for nffs into an array
-     * of nffs area descriptors.
-     */
-    cnt = NFFS_AREA_MAX;
-    rc = nffs_misc_desc_from_flash_area(
-        MYNEWT_VAL(NFFS_FLASH_AREA), &cnt, descs);
-    SYSINIT_PANIC_ASSERT(rc == 0);
+    descs = arg;
+    mark = SYSINIT_PROFILE_MARK();
 
     /* Attempt to restore an existing nffs file system from flash. */
     rc = nffs_detect(descs);
@@ -788,4 +1076,44 @@ nffs_pkg_init(void)
         SYSINIT_PANIC();
         break;
     }
+
+    SYSINIT_PROFILE_RECORD("nffs_restore", mark);
+
+    return 0;
+}
+
+#if MYNEWT_VAL(NFFS_RESTORE_ASYNC)
+static struct sysinit_job nffs_restore_job = {
+    .sj_name = "nffs",
+    .sj_fn = nffs_pkg_restore,
+};
+#endif
+
+void
+nffs_pkg_init(void)
+{
+    static struct nffs_area_desc descs[NFFS_AREA_MAX + 1];
+    int cnt;
+    int rc;
+
+    /* Initialize nffs's internal state. */
+    rc = nffs_init();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    /* Convert the set of flash blocks we intend to use for nffs into an array
+     * of nffs area descriptors.
+     */
+    cnt = NFFS_AREA_MAX;
+    rc = nffs_misc_desc_from_flash_area(
+        MYNEWT_VAL(NFFS_FLASH_AREA), &cnt, descs);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+#if MYNEWT_VAL(NFFS_RESTORE_ASYNC)
+    /* File system calls fail with FS_EUNINIT until the restore completes. */
+    nffs_restore_job.sj_arg = descs;
+    rc = sysinit_defer(&nffs_restore_job);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#else
+    nffs_pkg_restore(descs);
+#endif
 }
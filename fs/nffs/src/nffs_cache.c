@@ -26,6 +26,11 @@ TAILQ_HEAD(nffs_cache_inode_list, nffs_cache_inode);
 static struct nffs_cache_inode_list nffs_cache_inode_list =
     TAILQ_HEAD_INITIALIZER(nffs_cache_inode_list);
 
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+/* Blocks to read ahead; at most NFFS_CACHE_READ_AHEAD, 0 turns it off. */
+uint8_t nffs_cache_read_ahead_max = MYNEWT_VAL(NFFS_CACHE_READ_AHEAD);
+#endif
+
 static void nffs_cache_reclaim_blocks(void);
 
 static struct nffs_cache_block *
@@ -344,6 +349,53 @@ nffs_cache_insert_block(struct nffs_cache_inode *cache_inode,
     nffs_cache_log_insert_block(cache_inode, cache_block, tail);
 }
 
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+/**
+ * Appends the blocks that follow a newly cached block to the cache.  These
+ * blocks were already read from flash while searching backwards from the end
+ * of the file, so caching them costs no additional flash reads and saves the
+ * next sequential seek from repeating the search.  Read-ahead stops early if
+ * the block pool is exhausted; existing cache entries are never reclaimed to
+ * make room.
+ *
+ * @param cache_inode           The cached file inode being read.
+ * @param ra_blocks             Ring of blocks that follow the sought-after
+ *                                  block, most recently read (i.e., nearest)
+ *                                  at index ra_count - 1.
+ * @param ra_count              The number of blocks read after the
+ *                                  sought-after block.
+ * @param file_offset           File offset of the first block to append.
+ */
+static void
+nffs_cache_read_ahead(struct nffs_cache_inode *cache_inode,
+                      const struct nffs_block *ra_blocks, int ra_count,
+                      uint32_t file_offset)
+{
+    struct nffs_cache_block *cache_block;
+    int num;
+    int i;
+
+    num = ra_count;
+    if (num > nffs_cache_read_ahead_max) {
+        num = nffs_cache_read_ahead_max;
+    }
+    for (i = 0; i < num; i++) {
+        cache_block = nffs_cache_block_alloc();
+        if (cache_block == NULL) {
+            return;
+        }
+
+        cache_block->ncb_block =
+            ra_blocks[(ra_count - 1 - i) % MYNEWT_VAL(NFFS_CACHE_READ_AHEAD)];
+        cache_block->ncb_file_offset = file_offset;
+        file_offset += cache_block->ncb_block.nb_data_len;
+
+        nffs_cache_insert_block(cache_inode, cache_block, 1);
+        STATS_INC(nffs_stats, nffs_cachecnt_readahead);
+    }
+}
+#endif
+
 /**
  * Finds the data block containing the specified offset within a file inode.
  * If the block is not yet cached, it gets cached as a result of this
@@ -380,12 +432,21 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
     struct nffs_hash_entry *block_entry;
     struct nffs_hash_entry *pred_entry;
     struct nffs_block block;
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+    struct nffs_block ra_blocks[MYNEWT_VAL(NFFS_CACHE_READ_AHEAD)];
+    int ra_count;
+    int sequential;
+#endif
     uint32_t cache_start;
     uint32_t cache_end;
     uint32_t block_start;
     uint32_t block_end;
     int rc;
 
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+    ra_count = 0;
+#endif
+
     /* Empty files have no blocks that can be cached. */
     if (cache_inode->nci_file_size == 0) {
         return FS_ENOENT;
@@ -472,10 +533,27 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
                     last_cached_entry == pred_entry) {
 
                     nffs_cache_insert_block(cache_inode, cache_block, 1);
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+                    sequential = 1;
+#endif
                 } else {
                     nffs_cache_inode_free_blocks(cache_inode);
                     nffs_cache_insert_block(cache_inode, cache_block, 0);
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+                    sequential = block_start == 0;
+#endif
                 }
+
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+                /* The cache is being extended forwards, or a read is starting
+                 * at the beginning of the file; expect the following blocks
+                 * to be read next.
+                 */
+                if (sequential) {
+                    nffs_cache_read_ahead(cache_inode, ra_blocks, ra_count,
+                                          block_end);
+                }
+#endif
             }
 
             if (out_cache_block != NULL) {
@@ -489,6 +567,15 @@ nffs_cache_seek(struct nffs_cache_inode *cache_inode, uint32_t seek_offset,
             cache_block = TAILQ_PREV(cache_block, nffs_cache_block_list,
                                      ncb_link);
         }
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+        else {
+            /* Remember the most recent uncached blocks; they follow the
+             * sought-after block and are candidates for read-ahead.
+             */
+            ra_blocks[ra_count % MYNEWT_VAL(NFFS_CACHE_READ_AHEAD)] = block;
+            ra_count++;
+        }
+#endif
         block_entry = pred_entry;
         block_end = block_start;
     }
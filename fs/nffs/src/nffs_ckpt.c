@@ -0,0 +1,308 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "hal/hal_flash.h"
+#include "crc/crc16.h"
+#include "nffs_priv.h"
+#include "nffs/nffs.h"
+
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+
+/**
+ * Offset within the scratch area where the next checkpoint gets written; 0 if
+ * the scratch area does not contain any checkpoints.
+ */
+uint32_t nffs_ckpt_next_offset;
+
+static void
+nffs_ckpt_area_to_disk(const struct nffs_area *area,
+                       struct nffs_disk_ckpt_area *out_disk_ckpt_area)
+{
+    memset(out_disk_ckpt_area, 0, sizeof *out_disk_ckpt_area);
+    out_disk_ckpt_area->ndca_offset = area->na_offset;
+    out_disk_ckpt_area->ndca_verified = area->na_verified;
+    out_disk_ckpt_area->ndca_flash_id = area->na_flash_id;
+    out_disk_ckpt_area->ndca_id = area->na_id;
+    out_disk_ckpt_area->ndca_gc_seq = area->na_gc_seq;
+}
+
+static uint32_t
+nffs_ckpt_len(uint8_t num_areas)
+{
+    return sizeof (struct nffs_disk_ckpt) +
+           num_areas * sizeof (struct nffs_disk_ckpt_area);
+}
+
+/**
+ * Reads the checkpoint at the specified scratch area offset and verifies its
+ * CRC.
+ *
+ * @return                      0 on success;
+ *                              FS_EEMPTY if the offset is unwritten;
+ *                              FS_ECORRUPT if the checkpoint is invalid;
+ *                              other nonzero on error.
+ */
+static int
+nffs_ckpt_read(uint32_t area_offset, struct nffs_disk_ckpt *out_disk_ckpt)
+{
+    struct nffs_disk_ckpt_area disk_ckpt_area;
+    struct nffs_area *area;
+    uint32_t rec_offset;
+    uint16_t crc;
+    int rc;
+    int i;
+
+    area = nffs_areas + nffs_scratch_area_idx;
+    if (area_offset + sizeof *out_disk_ckpt > area->na_length) {
+        return FS_EEMPTY;
+    }
+
+    STATS_INC(nffs_stats, nffs_readcnt_ckpt);
+    rc = nffs_flash_read(nffs_scratch_area_idx, area_offset, out_disk_ckpt,
+                         sizeof *out_disk_ckpt);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (out_disk_ckpt->ndc_magic == 0xffffffff) {
+        return FS_EEMPTY;
+    }
+    if (out_disk_ckpt->ndc_magic != NFFS_CKPT_MAGIC ||
+        area_offset + nffs_ckpt_len(out_disk_ckpt->ndc_num_areas) >
+            area->na_length) {
+
+        return FS_ECORRUPT;
+    }
+
+    crc = crc16_ccitt(0, out_disk_ckpt, NFFS_DISK_CKPT_OFFSET_CRC);
+    rec_offset = area_offset + sizeof *out_disk_ckpt;
+    for (i = 0; i < out_disk_ckpt->ndc_num_areas; i++) {
+        rc = nffs_flash_read(nffs_scratch_area_idx, rec_offset,
+                             &disk_ckpt_area, sizeof disk_ckpt_area);
+        if (rc != 0) {
+            return rc;
+        }
+        crc = crc16_ccitt(crc, &disk_ckpt_area, sizeof disk_ckpt_area);
+        rec_offset += sizeof disk_ckpt_area;
+    }
+
+    if (crc != out_disk_ckpt->ndc_crc16) {
+        return FS_ECORRUPT;
+    }
+
+    return 0;
+}
+
+/**
+ * Applies the area records of a valid checkpoint to the RAM area
+ * representation.  An area record is only trusted if it describes the same
+ * physical area with the same ID and garbage collection sequence number.
+ */
+static int
+nffs_ckpt_apply(uint32_t area_offset, const struct nffs_disk_ckpt *disk_ckpt)
+{
+    struct nffs_disk_ckpt_area disk_ckpt_area;
+    struct nffs_area *area;
+    int rc;
+    int i;
+    int j;
+
+    area_offset += sizeof *disk_ckpt;
+    for (i = 0; i < disk_ckpt->ndc_num_areas; i++) {
+        rc = nffs_flash_read(nffs_scratch_area_idx, area_offset,
+                             &disk_ckpt_area, sizeof disk_ckpt_area);
+        if (rc != 0) {
+            return rc;
+        }
+        area_offset += sizeof disk_ckpt_area;
+
+        for (j = 0; j < nffs_num_areas; j++) {
+            area = nffs_areas + j;
+            if (j != nffs_scratch_area_idx &&
+                area->na_offset == disk_ckpt_area.ndca_offset &&
+                area->na_flash_id == disk_ckpt_area.ndca_flash_id &&
+                area->na_id == disk_ckpt_area.ndca_id &&
+                area->na_gc_seq == disk_ckpt_area.ndca_gc_seq &&
+                disk_ckpt_area.ndca_verified <= area->na_length) {
+
+                area->na_verified = disk_ckpt_area.ndca_verified;
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Loads the most recent valid checkpoint from the scratch area.  On return,
+ * each area's na_verified field indicates how much of the area can be
+ * restored without validating object CRCs.  This must be called after all
+ * area headers have been read, but before any area contents are restored.
+ */
+void
+nffs_ckpt_restore(void)
+{
+    struct nffs_disk_ckpt disk_ckpt;
+    struct nffs_disk_ckpt last_ckpt;
+    uint32_t last_offset;
+    uint32_t area_offset;
+    int rc;
+    int i;
+
+    for (i = 0; i < nffs_num_areas; i++) {
+        nffs_areas[i].na_verified = 0;
+    }
+    nffs_ckpt_next_offset = 0;
+
+    if (nffs_scratch_area_idx == NFFS_AREA_ID_NONE) {
+        return;
+    }
+
+    /* The scratch area's header is the only object it contains. */
+    nffs_areas[nffs_scratch_area_idx].na_verified = NFFS_AREA_OFFSET_ID;
+
+    last_offset = 0;
+    area_offset = sizeof (struct nffs_disk_area);
+    while (1) {
+        rc = nffs_ckpt_read(area_offset, &disk_ckpt);
+        if (rc == FS_EEMPTY) {
+            break;
+        }
+        if (rc != 0 && rc != FS_ECORRUPT) {
+            return;
+        }
+        if (disk_ckpt.ndc_magic != NFFS_CKPT_MAGIC) {
+            /* Unrecognized data; the scratch area must be erased before it
+             * can hold another checkpoint.
+             */
+            area_offset = nffs_areas[nffs_scratch_area_idx].na_length;
+            break;
+        }
+
+        /* A checkpoint with a bad CRC was interrupted while being written;
+         * skip it and keep looking for a newer one.
+         */
+        if (rc == 0) {
+            last_ckpt = disk_ckpt;
+            last_offset = area_offset;
+        }
+        area_offset += nffs_ckpt_len(disk_ckpt.ndc_num_areas);
+    }
+
+    /* Even if no valid checkpoint was found, the scratch area is no longer
+     * pristine and must be erased before garbage collection uses it.
+     */
+    if (area_offset > sizeof (struct nffs_disk_area)) {
+        nffs_ckpt_next_offset = area_offset;
+    }
+
+    if (last_offset != 0) {
+        nffs_ckpt_apply(last_offset, &last_ckpt);
+    }
+}
+
+/**
+ * Appends a checkpoint describing the current state of every area to the
+ * scratch area.  If the scratch area is full of old checkpoints, it is
+ * reformatted first.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_ckpt_write(void)
+{
+    struct nffs_disk_ckpt_area disk_ckpt_area;
+    struct nffs_disk_ckpt disk_ckpt;
+    struct nffs_area *scratch;
+    uint32_t area_offset;
+    uint32_t len;
+    int rc;
+    int i;
+
+    if (nffs_scratch_area_idx == NFFS_AREA_ID_NONE) {
+        return FS_EUNINIT;
+    }
+    scratch = nffs_areas + nffs_scratch_area_idx;
+
+#if MYNEWT_VAL(NFFS_ERASE_ASYNC)
+    /* The scratch area may still be being erased after garbage collection. */
+    nffs_erase_wait();
+#endif
+
+    len = nffs_ckpt_len(nffs_num_areas);
+    if (nffs_ckpt_next_offset == 0) {
+        nffs_ckpt_next_offset = sizeof (struct nffs_disk_area);
+    }
+    if (nffs_ckpt_next_offset + len > scratch->na_length) {
+        rc = nffs_format_area(nffs_scratch_area_idx, 1);
+        if (rc != 0) {
+            return rc;
+        }
+        nffs_ckpt_next_offset = sizeof (struct nffs_disk_area);
+    }
+    if (nffs_ckpt_next_offset + len > scratch->na_length) {
+        return FS_EFULL;
+    }
+
+    memset(&disk_ckpt, 0, sizeof disk_ckpt);
+    disk_ckpt.ndc_magic = NFFS_CKPT_MAGIC;
+    disk_ckpt.ndc_num_areas = nffs_num_areas;
+    disk_ckpt.ndc_crc16 = crc16_ccitt(0, &disk_ckpt,
+                                      NFFS_DISK_CKPT_OFFSET_CRC);
+    for (i = 0; i < nffs_num_areas; i++) {
+        nffs_ckpt_area_to_disk(nffs_areas + i, &disk_ckpt_area);
+        disk_ckpt.ndc_crc16 = crc16_ccitt(disk_ckpt.ndc_crc16,
+                                          &disk_ckpt_area,
+                                          sizeof disk_ckpt_area);
+    }
+
+    /* The scratch area's header is written without an ID, so its write
+     * pointer lags behind the checkpoint region; checkpoints are written
+     * directly rather than through nffs_flash_write().
+     */
+    area_offset = nffs_ckpt_next_offset;
+    rc = hal_flash_write(scratch->na_flash_id,
+                         scratch->na_offset + area_offset,
+                         &disk_ckpt, sizeof disk_ckpt);
+    if (rc != 0) {
+        return FS_EHW;
+    }
+    area_offset += sizeof disk_ckpt;
+
+    for (i = 0; i < nffs_num_areas; i++) {
+        nffs_ckpt_area_to_disk(nffs_areas + i, &disk_ckpt_area);
+        rc = hal_flash_write(scratch->na_flash_id,
+                             scratch->na_offset + area_offset,
+                             &disk_ckpt_area, sizeof disk_ckpt_area);
+        if (rc != 0) {
+            return FS_EHW;
+        }
+        area_offset += sizeof disk_ckpt_area;
+    }
+
+    nffs_ckpt_next_offset = area_offset;
+    STATS_INC(nffs_stats, nffs_ckptcnt_write);
+
+    return 0;
+}
+
+#endif
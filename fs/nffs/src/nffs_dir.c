@@ -80,6 +80,52 @@ nffs_dir_open(const char *path, struct nffs_dir **out_dir)
     return 0;
 }
 
+/**
+ * Captures everything a directory listing needs from the specified child in
+ * a single pass: the inode, the file size and, if it is short enough, the
+ * filename.
+ */
+static int
+nffs_dir_snapshot(struct nffs_dirent *dirent, struct nffs_inode_entry *child)
+{
+    int rc;
+
+    dirent->nde_inode_entry = child;
+    dirent->nde_data_len = 0;
+#if MYNEWT_VAL(NFFS_DIRENT_NAME_LEN) > 0
+    dirent->nde_name_cached = 0;
+#endif
+
+    rc = nffs_inode_from_entry(&dirent->nde_inode, child);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (!nffs_hash_id_is_dir(child->nie_hash_entry.nhe_id)) {
+        rc = nffs_inode_data_len(child, &dirent->nde_data_len);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+#if MYNEWT_VAL(NFFS_DIRENT_NAME_LEN) > 0
+    if (dirent->nde_inode.ni_filename_len <=
+        MYNEWT_VAL(NFFS_DIRENT_NAME_LEN)) {
+
+        rc = nffs_inode_read_filename_chunk(&dirent->nde_inode, 0,
+                                            dirent->nde_name,
+                                            dirent->nde_inode.ni_filename_len);
+        if (rc != 0) {
+            return rc;
+        }
+        dirent->nde_name[dirent->nde_inode.ni_filename_len] = '\0';
+        dirent->nde_name_cached = 1;
+    }
+#endif
+
+    return 0;
+}
+
 int
 nffs_dir_read(struct nffs_dir *dir, struct nffs_dirent **out_dirent)
 {
@@ -104,6 +150,12 @@ nffs_dir_read(struct nffs_dir *dir, struct nffs_dirent **out_dirent)
     }
 
     nffs_inode_inc_refcnt(child);
+
+    rc = nffs_dir_snapshot(&dir->nd_dirent, child);
+    if (rc != 0) {
+        return rc;
+    }
+
     *out_dirent = &dir->nd_dirent;
 
     return 0;
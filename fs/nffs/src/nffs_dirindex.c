@@ -0,0 +1,400 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+#include "nffs_priv.h"
+#include "nffs/nffs.h"
+
+#if MYNEWT_VAL(NFFS_DIR_INDEX_ENTRIES) > 0
+
+/*
+ * The directory index maps (directory, filename) pairs to child inode entries
+ * for a small number of large, recently used directories.  Without it, each
+ * path component is resolved by walking the directory's child list and
+ * reading every child's inode from flash.  With it, a lookup reads only the
+ * inode of the matching child, to confirm that the filename hashes did not
+ * merely collide.
+ *
+ * An indexed directory always has every one of its children in the index, so
+ * a miss means the child does not exist.  If the entry budget runs out, the
+ * least recently used directory loses its index; if that is not enough, the
+ * directory being indexed is left unindexed.
+ */
+
+#define NFFS_DIRINDEX_NUM_ENTRIES   MYNEWT_VAL(NFFS_DIR_INDEX_ENTRIES)
+#define NFFS_DIRINDEX_NUM_DIRS      MYNEWT_VAL(NFFS_DIR_INDEX_DIRS)
+#define NFFS_DIRINDEX_NONE          0xff
+
+#if NFFS_DIRINDEX_NUM_DIRS < 1 || NFFS_DIRINDEX_NUM_DIRS >= NFFS_DIRINDEX_NONE
+#error "NFFS_DIR_INDEX_DIRS must be between 1 and 254"
+#endif
+
+struct nffs_dirindex_entry {
+    SLIST_ENTRY(nffs_dirindex_entry) nde_next;
+    struct nffs_inode_entry *nde_child;
+    uint32_t nde_hash;
+    uint8_t nde_dir;                    /* Index into nffs_dirindex_dirs. */
+};
+
+SLIST_HEAD(nffs_dirindex_list, nffs_dirindex_entry);
+
+struct nffs_dirindex_dir {
+    struct nffs_inode_entry *ndd_dir;   /* Null if slot is unused. */
+    uint32_t ndd_last_use;
+};
+
+static struct nffs_dirindex_entry
+    nffs_dirindex_entries[NFFS_DIRINDEX_NUM_ENTRIES];
+static struct nffs_dirindex_list
+    nffs_dirindex_buckets[NFFS_DIRINDEX_NUM_ENTRIES];
+static struct nffs_dirindex_list nffs_dirindex_free_list;
+static struct nffs_dirindex_dir nffs_dirindex_dirs[NFFS_DIRINDEX_NUM_DIRS];
+static uint32_t nffs_dirindex_clock;
+
+/**
+ * Adds the specified bytes to a 32-bit FNV-1a filename hash.  Start with
+ * NFFS_DIRINDEX_HASH_INIT.
+ */
+uint32_t
+nffs_dirindex_hash(uint32_t hash, const void *data, int len)
+{
+    const uint8_t *u8p;
+    int i;
+
+    u8p = data;
+    for (i = 0; i < len; i++) {
+        hash ^= u8p[i];
+        hash *= 16777619;
+    }
+
+    return hash;
+}
+
+static struct nffs_dirindex_list *
+nffs_dirindex_bucket(const struct nffs_inode_entry *dir, uint32_t hash)
+{
+    uint32_t key;
+
+    key = nffs_dirindex_hash(hash, &dir->nie_hash_entry.nhe_id,
+                             sizeof dir->nie_hash_entry.nhe_id);
+    return nffs_dirindex_buckets + key % NFFS_DIRINDEX_NUM_ENTRIES;
+}
+
+static int
+nffs_dirindex_dir_find(const struct nffs_inode_entry *dir)
+{
+    int i;
+
+    for (i = 0; i < NFFS_DIRINDEX_NUM_DIRS; i++) {
+        if (nffs_dirindex_dirs[i].ndd_dir == dir) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Removes every entry belonging to the specified directory slot and frees the
+ * slot.
+ */
+static void
+nffs_dirindex_dir_clear(int slot)
+{
+    struct nffs_dirindex_entry *entry;
+    int i;
+
+    for (i = 0; i < NFFS_DIRINDEX_NUM_ENTRIES; i++) {
+        entry = nffs_dirindex_entries + i;
+        if (entry->nde_child != NULL && entry->nde_dir == slot) {
+            SLIST_REMOVE(nffs_dirindex_bucket(nffs_dirindex_dirs[slot].ndd_dir,
+                                              entry->nde_hash),
+                         entry, nffs_dirindex_entry, nde_next);
+            entry->nde_child = NULL;
+            SLIST_INSERT_HEAD(&nffs_dirindex_free_list, entry, nde_next);
+        }
+    }
+
+    nffs_dirindex_dirs[slot].ndd_dir = NULL;
+}
+
+/**
+ * Frees the least recently used directory slot, other than the specified one.
+ *
+ * @return                  0 if a slot was freed; FS_ENOMEM otherwise.
+ */
+static int
+nffs_dirindex_evict(int keep_slot)
+{
+    int best;
+    int i;
+
+    best = -1;
+    for (i = 0; i < NFFS_DIRINDEX_NUM_DIRS; i++) {
+        if (i == keep_slot || nffs_dirindex_dirs[i].ndd_dir == NULL) {
+            continue;
+        }
+        if (best == -1 ||
+            (int32_t)(nffs_dirindex_dirs[i].ndd_last_use -
+                      nffs_dirindex_dirs[best].ndd_last_use) < 0) {
+            best = i;
+        }
+    }
+
+    if (best == -1) {
+        return FS_ENOMEM;
+    }
+
+    nffs_dirindex_dir_clear(best);
+    STATS_INC(nffs_stats, nffs_dindexcnt_evict);
+    return 0;
+}
+
+static int
+nffs_dirindex_insert(int slot, struct nffs_inode *child)
+{
+    struct nffs_dirindex_entry *entry;
+    uint32_t hash;
+    int rc;
+
+    rc = nffs_inode_filename_hash(child, &hash);
+    if (rc != 0) {
+        return rc;
+    }
+
+    entry = SLIST_FIRST(&nffs_dirindex_free_list);
+    if (entry == NULL) {
+        rc = nffs_dirindex_evict(slot);
+        if (rc != 0) {
+            return rc;
+        }
+        entry = SLIST_FIRST(&nffs_dirindex_free_list);
+        if (entry == NULL) {
+            return FS_ENOMEM;
+        }
+    }
+    SLIST_REMOVE_HEAD(&nffs_dirindex_free_list, nde_next);
+
+    entry->nde_child = child->ni_inode_entry;
+    entry->nde_hash = hash;
+    entry->nde_dir = slot;
+    SLIST_INSERT_HEAD(nffs_dirindex_bucket(nffs_dirindex_dirs[slot].ndd_dir,
+                                           hash),
+                      entry, nde_next);
+
+    return 0;
+}
+
+/**
+ * Indexes every child of the specified directory.
+ *
+ * @return                  The directory's slot on success; -1 if the
+ *                              directory could not be indexed.
+ */
+static int
+nffs_dirindex_build(struct nffs_inode_entry *dir)
+{
+    struct nffs_inode_entry *cur;
+    struct nffs_inode inode;
+    int num_children;
+    int slot;
+    int rc;
+
+    num_children = 0;
+    SLIST_FOREACH(cur, &dir->nie_child_list, nie_sibling_next) {
+        num_children++;
+    }
+    if (num_children < MYNEWT_VAL(NFFS_DIR_INDEX_MIN_CHILDREN) ||
+        num_children > NFFS_DIRINDEX_NUM_ENTRIES) {
+
+        return -1;
+    }
+
+    slot = nffs_dirindex_dir_find(NULL);
+    if (slot == -1) {
+        nffs_dirindex_evict(-1);
+        slot = nffs_dirindex_dir_find(NULL);
+        assert(slot != -1);
+    }
+    nffs_dirindex_dirs[slot].ndd_dir = dir;
+
+    SLIST_FOREACH(cur, &dir->nie_child_list, nie_sibling_next) {
+        rc = nffs_inode_from_entry(&inode, cur);
+        if (rc == 0) {
+            rc = nffs_dirindex_insert(slot, &inode);
+        }
+        if (rc != 0) {
+            nffs_dirindex_dir_clear(slot);
+            return -1;
+        }
+    }
+
+    STATS_INC(nffs_stats, nffs_dindexcnt_build);
+    return slot;
+}
+
+/**
+ * Looks up a child of the specified directory by name.  If the directory is
+ * not indexed yet, it gets indexed if it has at least
+ * NFFS_DIR_INDEX_MIN_CHILDREN children.
+ *
+ * @param dir               The directory to search.
+ * @param name              The filename to look up; not null-terminated.
+ * @param name_len          The length of the filename.
+ * @param out_inode_entry   On success, the matching child gets written here.
+ * @param out_indexed       On return, indicates whether the directory is
+ *                              indexed.  If it is not, the caller needs to
+ *                              search the directory's child list instead.
+ *
+ * @return                  0 on success;
+ *                          FS_ENOENT if the directory is indexed and contains
+ *                              no such child;
+ *                          other nonzero on error.
+ */
+int
+nffs_dirindex_find(struct nffs_inode_entry *dir, const char *name,
+                   int name_len, struct nffs_inode_entry **out_inode_entry,
+                   int *out_indexed)
+{
+    struct nffs_dirindex_entry *entry;
+    struct nffs_inode inode;
+    uint32_t hash;
+    int slot;
+    int cmp;
+    int rc;
+
+    slot = nffs_dirindex_dir_find(dir);
+    if (slot == -1) {
+        slot = nffs_dirindex_build(dir);
+        if (slot == -1) {
+            *out_indexed = 0;
+            return 0;
+        }
+    }
+    *out_indexed = 1;
+
+    nffs_dirindex_dirs[slot].ndd_last_use = ++nffs_dirindex_clock;
+
+    hash = nffs_dirindex_hash(NFFS_DIRINDEX_HASH_INIT, name, name_len);
+    SLIST_FOREACH(entry, nffs_dirindex_bucket(dir, hash), nde_next) {
+        if (entry->nde_hash != hash || entry->nde_dir != slot) {
+            continue;
+        }
+
+        rc = nffs_inode_from_entry(&inode, entry->nde_child);
+        if (rc != 0) {
+            return rc;
+        }
+        rc = nffs_inode_filename_cmp_ram(&inode, name, name_len, &cmp);
+        if (rc != 0) {
+            return rc;
+        }
+        if (cmp == 0) {
+            STATS_INC(nffs_stats, nffs_dindexcnt_hit);
+            *out_inode_entry = entry->nde_child;
+            return 0;
+        }
+        STATS_INC(nffs_stats, nffs_dindexcnt_collision);
+    }
+
+    return FS_ENOENT;
+}
+
+/**
+ * Records a new child of the specified directory.  If the child cannot be
+ * indexed, the directory's index is discarded.
+ */
+void
+nffs_dirindex_add(struct nffs_inode_entry *dir, struct nffs_inode *child)
+{
+    int slot;
+    int rc;
+
+    slot = nffs_dirindex_dir_find(dir);
+    if (slot != -1) {
+        rc = nffs_dirindex_insert(slot, child);
+        if (rc != 0) {
+            nffs_dirindex_dir_clear(slot);
+        }
+    }
+}
+
+/**
+ * Forgets a child that is being removed from the specified directory.
+ */
+void
+nffs_dirindex_remove(struct nffs_inode_entry *dir,
+                     struct nffs_inode_entry *child)
+{
+    struct nffs_dirindex_entry *entry;
+    int slot;
+    int i;
+
+    slot = nffs_dirindex_dir_find(dir);
+    if (slot == -1) {
+        return;
+    }
+
+    for (i = 0; i < NFFS_DIRINDEX_NUM_ENTRIES; i++) {
+        entry = nffs_dirindex_entries + i;
+        if (entry->nde_child == child && entry->nde_dir == slot) {
+            SLIST_REMOVE(nffs_dirindex_bucket(dir, entry->nde_hash),
+                         entry, nffs_dirindex_entry, nde_next);
+            entry->nde_child = NULL;
+            SLIST_INSERT_HEAD(&nffs_dirindex_free_list, entry, nde_next);
+            return;
+        }
+    }
+}
+
+/**
+ * Discards the index of the specified directory, if it has one.
+ */
+void
+nffs_dirindex_drop(struct nffs_inode_entry *dir)
+{
+    int slot;
+
+    slot = nffs_dirindex_dir_find(dir);
+    if (slot != -1) {
+        nffs_dirindex_dir_clear(slot);
+    }
+}
+
+/**
+ * Discards all directory indexes.
+ */
+void
+nffs_dirindex_reset(void)
+{
+    int i;
+
+    SLIST_INIT(&nffs_dirindex_free_list);
+    for (i = 0; i < NFFS_DIRINDEX_NUM_ENTRIES; i++) {
+        SLIST_INIT(nffs_dirindex_buckets + i);
+        nffs_dirindex_entries[i].nde_child = NULL;
+        SLIST_INSERT_HEAD(&nffs_dirindex_free_list, nffs_dirindex_entries + i,
+                          nde_next);
+    }
+
+    memset(nffs_dirindex_dirs, 0, sizeof nffs_dirindex_dirs);
+}
+
+#endif
@@ -0,0 +1,209 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(NFFS_ERASE_ASYNC)
+
+#include <assert.h>
+#include "os/os.h"
+#include "hal/hal_bsp.h"
+#include "hal/hal_flash.h"
+#include "hal/hal_flash_int.h"
+#include "nffs/nffs.h"
+#include "nffs_priv.h"
+
+/*
+ * The area garbage collection turned into the new scratch area is erased
+ * with queued flash operations, one sector at a time, while file system
+ * operations on areas of other flash devices carry on.  Anything that
+ * touches the device being erased waits for the erase to finish first.
+ *
+ * Completions are posted to a queue nobody runs; progress is made whenever
+ * nffs checks on the erase, so no task context is needed.  If the erase
+ * fails, the area is left without a scratch header, and the next garbage
+ * collection cycle formats it the slow way.
+ */
+static struct {
+    struct hal_flash_op op;
+    struct os_eventq evq;
+    int sector_idx;             /* Next device sector to consider */
+    uint8_t active;             /* An area is being erased */
+    uint8_t area_idx;
+    uint8_t flash_id;
+    int rc;
+} nffs_erase;
+
+/**
+ * Submits the erase of the next sector of the area, if any.
+ *
+ * @return                      1 if a sector erase was submitted;
+ *                              0 if the whole area has been erased.
+ */
+static int
+nffs_erase_next(void)
+{
+    const struct hal_flash *hf;
+    const struct nffs_area *area;
+    uint32_t start;
+    uint32_t size;
+    int rc;
+
+    area = nffs_areas + nffs_erase.area_idx;
+    hf = hal_bsp_flash_dev(area->na_flash_id);
+    assert(hf != NULL);
+
+    for (; nffs_erase.sector_idx < hf->hf_sector_cnt;
+         nffs_erase.sector_idx++) {
+
+        rc = hf->hf_itf->hff_sector_info(nffs_erase.sector_idx, &start,
+                                         &size);
+        assert(rc == 0);
+        if (area->na_offset < start + size &&
+            area->na_offset + area->na_length > start) {
+
+            nffs_erase.sector_idx++;
+            nffs_erase.op.hfo_addr = start;
+            rc = hal_flash_op_submit(&nffs_erase.op);
+            if (rc != 0) {
+                nffs_erase.rc = FS_EHW;
+                return 0;
+            }
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Writes the scratch header once the area has been erased.
+ */
+static void
+nffs_erase_done(void)
+{
+    uint8_t area_idx;
+
+    area_idx = nffs_erase.area_idx;
+    nffs_erase.active = 0;
+
+    if (nffs_erase.rc == 0) {
+        nffs_format_area_hdr(area_idx, 1);
+    }
+}
+
+/**
+ * Collects completed sector erases and submits the following ones.
+ */
+static void
+nffs_erase_poll(void)
+{
+    while (nffs_erase.active &&
+           OS_EVENT_QUEUED(&nffs_erase.op.hfo_ev)) {
+
+        os_eventq_remove(&nffs_erase.evq, &nffs_erase.op.hfo_ev);
+        if (nffs_erase.op.hfo_status != 0) {
+            nffs_erase.rc = FS_EHW;
+        }
+        if (nffs_erase.rc != 0 || !nffs_erase_next()) {
+            nffs_erase_done();
+        }
+    }
+}
+
+/**
+ * Starts erasing an area in the background.  Its scratch header is written
+ * when the erase completes.
+ *
+ * @param area_idx              The area to erase.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_erase_start(uint8_t area_idx)
+{
+    struct nffs_area *area;
+
+    nffs_erase_wait();
+
+    if (!os_eventq_inited(&nffs_erase.evq)) {
+        os_eventq_init(&nffs_erase.evq);
+    }
+
+    area = nffs_areas + area_idx;
+    nffs_erase.active = 1;
+    nffs_erase.area_idx = area_idx;
+    nffs_erase.flash_id = area->na_flash_id;
+    nffs_erase.sector_idx = 0;
+    nffs_erase.rc = 0;
+
+    nffs_erase.op.hfo_type = HAL_FLASH_OP_ERASE_SECTOR;
+    nffs_erase.op.hfo_flash_id = area->na_flash_id;
+    nffs_erase.op.hfo_evq = &nffs_erase.evq;
+
+    if (!nffs_erase_next()) {
+        /* Nothing could be queued; erase the area right away. */
+        nffs_erase.active = 0;
+        return nffs_format_area(area_idx, 1);
+    }
+    nffs_erase_poll();
+
+    return 0;
+}
+
+/**
+ * Indicates whether an area of the specified flash device is being erased.
+ */
+int
+nffs_erase_busy(uint8_t flash_id)
+{
+    nffs_erase_poll();
+    return nffs_erase.active && nffs_erase.flash_id == flash_id;
+}
+
+/**
+ * Waits for the background erase, if any, to complete.
+ */
+void
+nffs_erase_wait(void)
+{
+    while (1) {
+        nffs_erase_poll();
+        if (!nffs_erase.active) {
+            break;
+        }
+        if (os_started()) {
+            os_time_delay(1);
+        }
+    }
+}
+
+/**
+ * Waits for the background erase if it is on the specified flash device.
+ * Called before the device is accessed.
+ */
+void
+nffs_erase_sync_dev(uint8_t flash_id)
+{
+    if (nffs_erase_busy(flash_id)) {
+        nffs_erase_wait();
+    }
+}
+
+#endif
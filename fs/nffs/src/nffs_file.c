@@ -18,18 +18,43 @@
  */
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 #include "nffs_priv.h"
 #include "nffs/nffs.h"
 
+#if MYNEWT_VAL(NFFS_FILE_MEM_BUDGET) > 0
+/** Heap bytes currently held by file handles outside nffs_file_pool. */
+static uint32_t nffs_file_dyn_bytes;
+#endif
+
 static struct nffs_file *
 nffs_file_alloc(void)
 {
     struct nffs_file *file;
 
     file = os_memblock_get(&nffs_file_pool);
+
+#if MYNEWT_VAL(NFFS_FILE_MEM_BUDGET) > 0
+    /* The fixed pool is exhausted; borrow from the heap if the budget
+     * allows.
+     */
+    if (file == NULL &&
+        nffs_file_dyn_bytes + sizeof *file <=
+            MYNEWT_VAL(NFFS_FILE_MEM_BUDGET)) {
+
+        file = malloc(sizeof *file);
+        if (file != NULL) {
+            nffs_file_dyn_bytes += sizeof *file;
+            STATS_INC(nffs_stats, nffs_filecnt_dyn_alloc);
+        }
+    }
+#endif
+
     if (file != NULL) {
         memset(file, 0, sizeof *file);
+    } else {
+        STATS_INC(nffs_stats, nffs_filecnt_alloc_fail);
     }
 
     return file;
@@ -41,6 +66,15 @@ nffs_file_free(struct nffs_file *file)
     int rc;
 
     if (file != NULL) {
+#if MYNEWT_VAL(NFFS_FILE_MEM_BUDGET) > 0
+        if (!os_memblock_from(&nffs_file_pool, file)) {
+            assert(nffs_file_dyn_bytes >= sizeof *file);
+            nffs_file_dyn_bytes -= sizeof *file;
+            free(file);
+            return 0;
+        }
+#endif
+
         rc = os_memblock_put(&nffs_file_pool, file);
         if (rc != 0) {
             return FS_EOS;
@@ -268,6 +302,11 @@ nffs_file_seek(struct nffs_file *file, uint32_t offset)
     uint32_t len;
     int rc;
 
+    rc = nffs_write_flush(file);
+    if (rc != 0) {
+        return rc;
+    }
+
     rc = nffs_inode_data_len(file->nf_inode_entry, &len);
     if (rc != 0) {
         return rc;
@@ -309,6 +348,11 @@ nffs_file_read(struct nffs_file *file, uint32_t len, void *out_data,
         return FS_EACCESS;
     }
 
+    rc = nffs_write_flush(file);
+    if (rc != 0) {
+        return rc;
+    }
+
     rc = nffs_inode_read(file->nf_inode_entry, file->nf_offset, len, out_data,
                         &bytes_read);
     if (rc != 0) {
@@ -323,6 +367,53 @@ nffs_file_read(struct nffs_file *file, uint32_t len, void *out_data,
     return 0;
 }
 
+/**
+ * Reads data from the specified file and appends it to an mbuf chain.  If
+ * more data is requested than remains in the file, all available data is
+ * retrieved and a success code is returned.
+ *
+ * @param file              The file to read from.
+ * @param len               The number of bytes to attempt to read.
+ * @param om                The mbuf chain to append the data to.
+ * @param out_len           On success, the number of bytes actually read gets
+ *                              written here.  Pass null if you don't care.
+ *
+ * @return                  0 on success; nonzero on failure.
+ */
+int
+nffs_file_read_mbuf(struct nffs_file *file, uint32_t len, struct os_mbuf *om,
+                    uint32_t *out_len)
+{
+    uint32_t bytes_read;
+    int rc;
+
+    if (!nffs_misc_ready()) {
+        return FS_EUNINIT;
+    }
+
+    if (!(file->nf_access_flags & FS_ACCESS_READ)) {
+        return FS_EACCESS;
+    }
+
+    rc = nffs_write_flush(file);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = nffs_inode_read_mbuf(file->nf_inode_entry, file->nf_offset, len, om,
+                              &bytes_read);
+    if (rc != 0) {
+        return rc;
+    }
+
+    file->nf_offset += bytes_read;
+    if (out_len != NULL) {
+        *out_len = bytes_read;
+    }
+
+    return 0;
+}
+
 /**
  * Closes the specified file and invalidates the file handle.  If the file has
  * already been unlinked, and this is the last open handle to the file, this
@@ -335,8 +426,12 @@ nffs_file_read(struct nffs_file *file, uint32_t len, void *out_data,
 int
 nffs_file_close(struct nffs_file *file)
 {
+    int flush_rc;
     int rc;
 
+    /* Release the handle even if buffered data could not be written. */
+    flush_rc = nffs_write_flush(file);
+
     rc = nffs_inode_dec_refcnt(file->nf_inode_entry);
     if (rc != 0) {
         return rc;
@@ -347,5 +442,5 @@ nffs_file_close(struct nffs_file *file)
         return rc;
     }
 
-    return 0;
+    return flush_rc;
 }
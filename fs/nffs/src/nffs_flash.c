@@ -54,6 +54,10 @@ nffs_flash_read(uint8_t area_idx, uint32_t area_offset, void *data,
         return FS_EOFFSET;
     }
 
+#if MYNEWT_VAL(NFFS_ERASE_ASYNC)
+    nffs_erase_sync_dev(area->na_flash_id);
+#endif
+
     STATS_INC(nffs_stats, nffs_iocnt_read);
     rc = hal_flash_read(area->na_flash_id, area->na_offset + area_offset, data,
                         len);
@@ -64,6 +68,42 @@ nffs_flash_read(uint8_t area_idx, uint32_t area_offset, void *data,
     return 0;
 }
 
+/**
+ * Gets a pointer through which a region of an area can be read in place.
+ *
+ * @param area_idx              The index of the area to map.
+ * @param area_offset           The offset within the area.
+ * @param len                   The length of the region.
+ *
+ * @return                      A pointer to the region's contents, or NULL if
+ *                                  the area's flash device is not memory
+ *                                  mapped or the range is invalid.
+ */
+const void *
+nffs_flash_map(uint8_t area_idx, uint32_t area_offset, uint32_t len)
+{
+#if MYNEWT_VAL(NFFS_FLASH_MAP)
+    const struct nffs_area *area;
+
+    assert(area_idx < nffs_num_areas);
+
+    area = nffs_areas + area_idx;
+
+    if (area_offset + len > area->na_length) {
+        return NULL;
+    }
+
+#if MYNEWT_VAL(NFFS_ERASE_ASYNC)
+    nffs_erase_sync_dev(area->na_flash_id);
+#endif
+
+    return hal_flash_map(area->na_flash_id, area->na_offset + area_offset,
+                         len);
+#else
+    return NULL;
+#endif
+}
+
 /**
  * Writes a chunk of data to flash.
  *
@@ -96,6 +136,10 @@ nffs_flash_write(uint8_t area_idx, uint32_t area_offset, const void *data,
         return FS_EOFFSET;
     }
 
+#if MYNEWT_VAL(NFFS_ERASE_ASYNC)
+    nffs_erase_sync_dev(area->na_flash_id);
+#endif
+
     STATS_INC(nffs_stats, nffs_iocnt_write);
     rc = hal_flash_write(area->na_flash_id, area->na_offset + area_offset,
                          data, len);
@@ -103,6 +147,15 @@ nffs_flash_write(uint8_t area_idx, uint32_t area_offset, const void *data,
         return FS_EHW;
     }
 
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    /* Objects written by this code are valid, so the verified prefix grows
+     * as long as nothing unverified precedes the write.
+     */
+    if (area->na_verified == area_offset) {
+        area->na_verified = area_offset + len;
+    }
+#endif
+
     area->na_cur = area_offset + len;
 
     return 0;
@@ -124,9 +177,17 @@ nffs_flash_copy(uint8_t area_idx_from, uint32_t area_offset_from,
                 uint8_t area_idx_to, uint32_t area_offset_to,
                 uint32_t len)
 {
+    const void *src;
     uint32_t chunk_len;
     int rc;
 
+    /* A mapped source can be written out without a bounce buffer. */
+    src = nffs_flash_map(area_idx_from, area_offset_from, len);
+    if (src != NULL) {
+        STATS_INC(nffs_stats, nffs_readcnt_mapped);
+        return nffs_flash_write(area_idx_to, area_offset_to, src, len);
+    }
+
     /* Copy data in chunks small enough to fit in the flash buffer. */
     while (len > 0) {
         if (len > sizeof nffs_flash_buf) {
@@ -42,6 +42,18 @@ nffs_format_from_scratch_area(uint8_t area_idx, uint8_t area_id)
     }
 
     nffs_areas[area_idx].na_id = area_id;
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    /* Checkpoints occupy the body of the scratch area; erase them before
+     * the area receives objects.
+     */
+    if (area_idx == nffs_scratch_area_idx && nffs_ckpt_next_offset != 0) {
+        nffs_ckpt_next_offset = 0;
+        rc = nffs_format_area(area_idx, 0);
+        if (rc != 0) {
+            return rc;
+        }
+    } else
+#endif
     if (!nffs_area_is_scratch(&disk_area)) {
         rc = nffs_format_area(area_idx, 0);
         if (rc != 0) {
@@ -65,18 +77,43 @@ nffs_format_from_scratch_area(uint8_t area_idx, uint8_t area_id)
 int
 nffs_format_area(uint8_t area_idx, int is_scratch)
 {
-    struct nffs_disk_area disk_area;
     struct nffs_area *area;
-    uint32_t write_len;
     int rc;
 
     area = nffs_areas + area_idx;
 
+#if MYNEWT_VAL(NFFS_ERASE_ASYNC)
+    nffs_erase_wait();
+#endif
+
     rc = hal_flash_erase(area->na_flash_id, area->na_offset, area->na_length);
     if (rc != 0) {
         return FS_EHW;
     }
+
+    return nffs_format_area_hdr(area_idx, is_scratch);
+}
+
+/**
+ * Writes the header of an area that has just been erased, and resets its
+ * RAM state.
+ */
+int
+nffs_format_area_hdr(uint8_t area_idx, int is_scratch)
+{
+    struct nffs_disk_area disk_area;
+    struct nffs_area *area;
+    uint32_t write_len;
+    int rc;
+
+    area = nffs_areas + area_idx;
     area->na_cur = 0;
+    area->na_tombstones = 0;
+    area->na_erase_cnt++;
+    STATS_INC(nffs_stats, nffs_gccnt_erase);
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    area->na_verified = 0;
+#endif
 
     nffs_area_to_disk(area, &disk_area);
 
@@ -139,6 +176,7 @@ nffs_format_full(const struct nffs_area_desc *area_descs)
         nffs_areas[i].na_flash_id = area_descs[i].nad_flash_id;
         nffs_areas[i].na_cur = 0;
         nffs_areas[i].na_gc_seq = 0;
+        nffs_areas[i].na_erase_cnt = 0;
 
         if (i == nffs_scratch_area_idx) {
             nffs_areas[i].na_id = NFFS_AREA_ID_NONE;
@@ -74,16 +74,37 @@ nffs_gc_copy_inode(struct nffs_inode_entry *inode_entry, uint8_t to_area_idx)
         return rc;
     }
 
+    if (nffs_inode_is_deleted(inode_entry)) {
+        nffs_areas[to_area_idx].na_tombstones++;
+    }
+
     return 0;
 }
 
 /**
- * Selects the most appropriate area for garbage collection.
+ * Index of the area being collected by an unfinished garbage collection cycle,
+ * or NFFS_AREA_ID_NONE if no cycle is in progress.  New objects are never
+ * written to this area.
+ */
+uint8_t nffs_gc_from_area_idx = NFFS_AREA_ID_NONE;
+
+#define NFFS_GC_PHASE_IDLE          0
+#define NFFS_GC_PHASE_SCAN          1
+#define NFFS_GC_PHASE_COPY          2
+
+static uint8_t nffs_gc_phase;
+static uint32_t nffs_gc_bucket;
+
+/** Total bytes written when background collection last found no garbage. */
+static uint32_t nffs_gc_bg_idle_cur;
+
+/**
+ * Selects the oldest area for garbage collection.
  *
  * @return                  The ID of the area to garbage collect.
  */
-static uint16_t
-nffs_gc_select_area(void)
+static uint8_t
+nffs_gc_select_area_oldest(void)
 {
     const struct nffs_area *area;
     uint8_t best_area_idx;
@@ -115,6 +136,133 @@ nffs_gc_select_area(void)
     return best_area_idx;
 }
 
+/**
+ * Calculates the number of bytes in the specified area occupied by obsolete
+ * objects.  This is only accurate after a scan phase has set the area's live
+ * byte count.
+ */
+static uint32_t
+nffs_gc_area_garbage(const struct nffs_area *area)
+{
+    uint32_t used;
+
+    used = area->na_cur - sizeof (struct nffs_disk_area);
+    if (area->na_cur < sizeof (struct nffs_disk_area) ||
+        used <= area->na_live) {
+
+        return 0;
+    }
+
+    return used - area->na_live;
+}
+
+/**
+ * Selects an area for garbage collection using the live byte counts gathered
+ * during a scan phase.  Each area is scored like a log-structured file system
+ * cleaner: benefit / cost = garbage * (age + 1) / (length + live).  Here the
+ * age of an area is the number of times it has been erased less than the most
+ * worn area.  If an area falls NFFS_GC_WEAR_THRESHOLD or more erases behind,
+ * it is selected regardless of its score so that areas holding static data
+ * still get cycled.
+ *
+ * Deletion records are not represented in RAM, so collecting an area discards
+ * them.  If the records they supersede are still present in another area, the
+ * deleted inodes would reappear at the next mount.  For this reason, an area
+ * containing deletion records is only considered when it is also the oldest
+ * area, i.e., when the default policy would have selected it.
+ *
+ * @param out_reclaimable   On success, indicates whether collecting the
+ *                              selected area is expected to achieve
+ *                              anything.
+ *
+ * @return                  The ID of the area to garbage collect.
+ */
+static uint8_t
+nffs_gc_select_area_cost_benefit(int *out_reclaimable)
+{
+    const struct nffs_area *scratch;
+    const struct nffs_area *area;
+    uint64_t best_score;
+    uint64_t score;
+    uint32_t garbage;
+    uint8_t oldest_idx;
+    uint8_t newest_seq;
+    uint8_t best_idx;
+    uint8_t wear_idx;
+    int8_t wear_age;
+    int8_t age;
+    int i;
+
+    scratch = nffs_areas + nffs_scratch_area_idx;
+    oldest_idx = nffs_gc_select_area_oldest();
+
+    newest_seq = nffs_areas[0].na_gc_seq;
+    for (i = 1; i < nffs_num_areas; i++) {
+        age = nffs_areas[i].na_gc_seq - newest_seq;
+        if (age > 0) {
+            newest_seq = nffs_areas[i].na_gc_seq;
+        }
+    }
+
+    best_idx = NFFS_AREA_ID_NONE;
+    best_score = 0;
+    wear_idx = NFFS_AREA_ID_NONE;
+    wear_age = 0;
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (i == nffs_scratch_area_idx) {
+            continue;
+        }
+
+        area = nffs_areas + i;
+
+        /* The source area becomes the new scratch area, which must be at
+         * least as large as every other area.
+         */
+        if (area->na_length < scratch->na_length) {
+            continue;
+        }
+        if (area->na_tombstones > 0 && i != oldest_idx) {
+            continue;
+        }
+
+        age = newest_seq - area->na_gc_seq;
+        if (age < 0) {
+            age = 0;
+        }
+        if (MYNEWT_VAL(NFFS_GC_WEAR_THRESHOLD) > 0 &&
+            age >= MYNEWT_VAL(NFFS_GC_WEAR_THRESHOLD) && age > wear_age) {
+
+            wear_idx = i;
+            wear_age = age;
+        }
+
+        garbage = nffs_gc_area_garbage(area);
+        score = (uint64_t)garbage * (age + 1) * 65536 /
+                (area->na_length + area->na_live);
+        if (score > best_score) {
+            best_idx = i;
+            best_score = score;
+        }
+    }
+
+    if (wear_idx != NFFS_AREA_ID_NONE) {
+        STATS_INC(nffs_stats, nffs_gccnt_wear);
+        *out_reclaimable = 1;
+        return wear_idx;
+    }
+
+    if (best_idx == NFFS_AREA_ID_NONE) {
+        /* No area contains garbage; fall back to cycling through the areas
+         * so that repeated collection eventually visits every one of them.
+         */
+        *out_reclaimable = 0;
+        return oldest_idx;
+    }
+
+    *out_reclaimable = 1;
+    return best_idx;
+}
+
 static int
 nffs_gc_block_chain_copy(struct nffs_hash_entry *last_entry, uint32_t data_len,
                          uint8_t to_area_idx)
@@ -397,12 +545,300 @@ nffs_gc_inode_blocks(struct nffs_inode_entry *inode_entry,
     return 0;
 }
 
+/**
+ * Sums the write offsets of all areas.  This increases whenever an object is
+ * written or deleted.
+ */
+static uint32_t
+nffs_gc_total_cur(void)
+{
+    uint32_t total;
+    int i;
+
+    total = 0;
+    for (i = 0; i < nffs_num_areas; i++) {
+        total += nffs_areas[i].na_cur;
+    }
+
+    return total;
+}
+
+/**
+ * Marks the start of a scan phase.  The scan phase determines how many bytes
+ * of live data are stored in each area.
+ */
+static void
+nffs_gc_scan_begin(void)
+{
+    int i;
+
+    for (i = 0; i < nffs_num_areas; i++) {
+        nffs_areas[i].na_live = 0;
+    }
+
+    nffs_gc_phase = NFFS_GC_PHASE_SCAN;
+    nffs_gc_bucket = 0;
+}
+
+/**
+ * Adds the on-disk size of each object in the specified hash bucket to the
+ * live byte count of the area it resides in.
+ */
+static int
+nffs_gc_scan_bucket(int bucket)
+{
+    struct nffs_disk_inode disk_inode;
+    struct nffs_disk_block disk_block;
+    struct nffs_hash_entry *entry;
+    uint32_t area_offset;
+    uint8_t area_idx;
+    int rc;
+
+    SLIST_FOREACH(entry, nffs_hash + bucket, nhe_next) {
+        if (nffs_hash_entry_is_dummy(entry)) {
+            continue;
+        }
+
+        nffs_flash_loc_expand(entry->nhe_flash_loc, &area_idx, &area_offset);
+        if (nffs_hash_id_is_inode(entry->nhe_id)) {
+            rc = nffs_inode_read_disk(area_idx, area_offset, &disk_inode);
+            if (rc != 0) {
+                return rc;
+            }
+            nffs_areas[area_idx].na_live +=
+                sizeof disk_inode + disk_inode.ndi_filename_len;
+        } else {
+            rc = nffs_block_read_disk(area_idx, area_offset, &disk_block);
+            if (rc != 0) {
+                return rc;
+            }
+            nffs_areas[area_idx].na_live +=
+                sizeof disk_block + disk_block.ndb_data_len;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Selects the source area and converts the scratch area into the destination
+ * area.  This marks the start of the copy phase.
+ *
+ * @param background        Whether the cycle was started by nffs_gc_step().
+ *                              A background cycle is abandoned if it would
+ *                              not reclaim any space.
+ *
+ * @return                  0 on success; nonzero on error.
+ */
+static int
+nffs_gc_copy_begin(int background)
+{
+    uint8_t from_area_idx;
+    int reclaimable;
+    int rc;
+
+    if (nffs_gc_phase == NFFS_GC_PHASE_SCAN) {
+        from_area_idx = nffs_gc_select_area_cost_benefit(&reclaimable);
+        if (background && !reclaimable) {
+            nffs_gc_bg_idle_cur = nffs_gc_total_cur();
+            nffs_gc_phase = NFFS_GC_PHASE_IDLE;
+            return 0;
+        }
+    } else {
+        from_area_idx = nffs_gc_select_area_oldest();
+    }
+
+    rc = nffs_format_from_scratch_area(nffs_scratch_area_idx,
+                                       nffs_areas[from_area_idx].na_id);
+    if (rc != 0) {
+        nffs_gc_phase = NFFS_GC_PHASE_IDLE;
+        return rc;
+    }
+
+    nffs_gc_from_area_idx = from_area_idx;
+    nffs_gc_phase = NFFS_GC_PHASE_COPY;
+    nffs_gc_bucket = 0;
+
+    return 0;
+}
+
+/**
+ * Copies each object in the specified hash bucket that is resident in the
+ * source area to the destination area.
+ */
+static int
+nffs_gc_copy_bucket(int bucket)
+{
+    struct nffs_inode_entry *inode_entry;
+    struct nffs_hash_entry *entry;
+    struct nffs_hash_entry *next;
+    uint32_t area_offset;
+    uint8_t area_idx;
+    int rc;
+
+    entry = SLIST_FIRST(nffs_hash + bucket);
+    while (entry != NULL) {
+        next = SLIST_NEXT(entry, nhe_next);
+
+        if (nffs_hash_id_is_inode(entry->nhe_id)) {
+            /* The inode gets copied if it is in the source area. */
+            nffs_flash_loc_expand(entry->nhe_flash_loc,
+                                  &area_idx, &area_offset);
+            inode_entry = (struct nffs_inode_entry *)entry;
+            if (area_idx == nffs_gc_from_area_idx) {
+                rc = nffs_gc_copy_inode(inode_entry, nffs_scratch_area_idx);
+                if (rc != 0) {
+                    return rc;
+                }
+            }
+
+            /* If the inode is a file, all constituent data blocks that are
+             * resident in the source area get copied.
+             */
+            if (nffs_hash_id_is_file(entry->nhe_id)) {
+                rc = nffs_gc_inode_blocks(inode_entry, nffs_gc_from_area_idx,
+                                          nffs_scratch_area_idx, &next);
+                if (rc != 0) {
+                    return rc;
+                }
+            }
+        }
+
+        entry = next;
+    }
+
+    return 0;
+}
+
+/**
+ * Turns the source area into the new scratch area.  This completes a garbage
+ * collection cycle.
+ */
+static int
+nffs_gc_copy_end(uint8_t *out_area_idx)
+{
+    struct nffs_area *from_area;
+    struct nffs_area *to_area;
+    int rc;
+
+    from_area = nffs_areas + nffs_gc_from_area_idx;
+    to_area = nffs_areas + nffs_scratch_area_idx;
+
+    /* The amount of written data should never increase as a result of a gc
+     * cycle.
+     */
+    assert(to_area->na_cur <= from_area->na_cur);
+
+    /* Turn the source area into the new scratch area. */
+    from_area->na_gc_seq++;
+#if MYNEWT_VAL(NFFS_ERASE_ASYNC)
+    /* Writes to areas on other flash devices go ahead during the erase. */
+    rc = nffs_erase_start(nffs_gc_from_area_idx);
+#else
+    rc = nffs_format_area(nffs_gc_from_area_idx, 1);
+#endif
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (out_area_idx != NULL) {
+        *out_area_idx = nffs_scratch_area_idx;
+    }
+
+    nffs_scratch_area_idx = nffs_gc_from_area_idx;
+    nffs_gc_from_area_idx = NFFS_AREA_ID_NONE;
+    nffs_gc_phase = NFFS_GC_PHASE_IDLE;
+
+    /* Garbage collection renders the cache invalid:
+     *     o All cached blocks are now invalid; drop them.
+     *     o Flash locations of inodes may have changed; the cached inodes need
+     *       updated to reflect this.
+     */
+    rc = nffs_cache_inode_refresh();
+    if (rc != 0) {
+        return rc;
+    }
+
+    /* Increment the garbage collection counter so that client code knows to
+     * reset its pointers to cached objects.
+     */
+    nffs_gc_count++;
+    STATS_INC(nffs_stats, nffs_gccnt);
+
+#if MYNEWT_VAL(NFFS_CHECKPOINT_AFTER_GC)
+    /* A checkpoint only speeds up the next mount; a failure to write one does
+     * not affect the result of garbage collection.
+     */
+    nffs_ckpt_write();
+#endif
+
+    return 0;
+}
+
+/**
+ * Advances the current garbage collection cycle by up to the specified number
+ * of hash buckets.
+ *
+ * @param max_buckets       The maximum number of hash buckets to process.
+ * @param background        Whether this is a background step.
+ * @param out_area_idx      If the cycle completes, the ID of the cleaned up
+ *                              area gets written here.  May be null.
+ *
+ * @return                  0 on success; nonzero on error.
+ */
+static int
+nffs_gc_run(uint32_t max_buckets, int background, uint8_t *out_area_idx)
+{
+    int copied;
+    int rc;
+
+    copied = 0;
+    while (max_buckets > 0 && nffs_gc_phase != NFFS_GC_PHASE_IDLE) {
+        if (nffs_gc_bucket < nffs_hash_size) {
+            if (nffs_gc_phase == NFFS_GC_PHASE_SCAN) {
+                rc = nffs_gc_scan_bucket(nffs_gc_bucket);
+            } else {
+                rc = nffs_gc_copy_bucket(nffs_gc_bucket);
+                copied = 1;
+            }
+            if (rc != 0) {
+                goto done;
+            }
+            nffs_gc_bucket++;
+            max_buckets--;
+        } else if (nffs_gc_phase == NFFS_GC_PHASE_SCAN) {
+            rc = nffs_gc_copy_begin(background);
+            if (rc != 0) {
+                return rc;
+            }
+        } else {
+            return nffs_gc_copy_end(out_area_idx);
+        }
+    }
+
+    rc = 0;
+
+done:
+    if (copied) {
+        /* Objects were relocated, and some cached blocks may have been
+         * collated away.
+         */
+        STATS_INC(nffs_stats, nffs_gccnt_step);
+        nffs_cache_inode_refresh();
+    }
+    return rc;
+}
+
 /**
  * Triggers a garbage collection cycle.  This is implemented as follows:
  *
  *  (1) The non-scratch area with the lowest garbage collection sequence
  *      number is selected as the "source area."  If there are other areas
  *      with the same sequence number, the first one encountered is selected.
+ *      If NFFS_GC_COST_BENEFIT is enabled, the RAM representation is first
+ *      scanned to determine how much live data each area contains, and the
+ *      area with the best ratio of reclaimable space to copying cost is
+ *      selected instead.
  *
  *  (2) The source area's ID is written to the scratch area's header,
  *      transforming it into a non-scratch ID.  The former scratch area is now
@@ -434,6 +870,9 @@ nffs_gc_inode_blocks(struct nffs_inode_entry *inode_entry,
  *     after calling this function.  Cached inodes are not invalidated by
  *     garbage collection.
  *
+ *     If a cycle was already started by nffs_gc_step(), that cycle is
+ *     completed rather than a new one being started.
+ *
  *     If a parent function potentially calls this function, the caller of the
  *     parent function needs to explicitly check if garbage collection
  *     occurred.  This is done by inspecting the nffs_gc_count variable before
@@ -448,96 +887,114 @@ nffs_gc_inode_blocks(struct nffs_inode_entry *inode_entry,
 int
 nffs_gc(uint8_t *out_area_idx)
 {
-    struct nffs_hash_entry *entry;
-    struct nffs_hash_entry *next;
-    struct nffs_area *from_area;
-    struct nffs_area *to_area;
-    struct nffs_inode_entry *inode_entry;
-    uint32_t area_offset;
-    uint8_t from_area_idx;
-    uint8_t area_idx;
     int rc;
-    int i;
 
-    from_area_idx = nffs_gc_select_area();
-    from_area = nffs_areas + from_area_idx;
-    to_area = nffs_areas + nffs_scratch_area_idx;
+    if (nffs_gc_phase == NFFS_GC_PHASE_IDLE) {
+        if (MYNEWT_VAL(NFFS_GC_COST_BENEFIT)) {
+            nffs_gc_scan_begin();
+        } else {
+            rc = nffs_gc_copy_begin(0);
+            if (rc != 0) {
+                return rc;
+            }
+        }
+    }
 
-    rc = nffs_format_from_scratch_area(nffs_scratch_area_idx,
-                                       from_area->na_id);
+    rc = nffs_gc_run(UINT32_MAX, 0, out_area_idx);
     if (rc != 0) {
         return rc;
     }
 
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
-        entry = SLIST_FIRST(nffs_hash + i);
-        while (entry != NULL) {
-            next = SLIST_NEXT(entry, nhe_next);
-
-            if (nffs_hash_id_is_inode(entry->nhe_id)) {
-                /* The inode gets copied if it is in the source area. */
-                nffs_flash_loc_expand(entry->nhe_flash_loc,
-                                      &area_idx, &area_offset);
-                inode_entry = (struct nffs_inode_entry *)entry;
-                if (area_idx == from_area_idx) {
-                    rc = nffs_gc_copy_inode(inode_entry,
-                                            nffs_scratch_area_idx);
-                    if (rc != 0) {
-                        return rc;
-                    }
-                }
+    assert(nffs_gc_phase == NFFS_GC_PHASE_IDLE);
+    return 0;
+}
 
-                /* If the inode is a file, all constituent data blocks that are
-                 * resident in the source area get copied.
-                 */
-                if (nffs_hash_id_is_file(entry->nhe_id)) {
-                    rc = nffs_gc_inode_blocks(inode_entry, from_area_idx,
-                                              nffs_scratch_area_idx, &next);
-                    if (rc != 0) {
-                        return rc;
-                    }
-                }
-            }
+/**
+ * Indicates whether free space is low enough for background garbage
+ * collection to start a new cycle.
+ */
+static int
+nffs_gc_bg_needed(void)
+{
+    uint32_t total;
+    uint32_t free;
+    int i;
 
-            entry = next;
+    if (nffs_gc_total_cur() == nffs_gc_bg_idle_cur) {
+        /* Nothing has changed since the last scan found no garbage. */
+        return 0;
+    }
+
+    total = 0;
+    free = 0;
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (i != nffs_scratch_area_idx) {
+            total += nffs_areas[i].na_length;
+            free += nffs_area_free_space(nffs_areas + i);
         }
     }
 
-    /* The amount of written data should never increase as a result of a gc
-     * cycle.
-     */
-    assert(to_area->na_cur <= from_area->na_cur);
+    return (uint64_t)free * 100 <
+           (uint64_t)total * MYNEWT_VAL(NFFS_GC_BG_THRESHOLD);
+}
 
-    /* Turn the source area into the new scratch area. */
-    from_area->na_gc_seq++;
-    rc = nffs_format_area(from_area_idx, 1);
-    if (rc != 0) {
-        return rc;
-    }
+/**
+ * Performs a bounded amount of background garbage collection.  A new cycle is
+ * started when the free space outside the scratch area falls below
+ * NFFS_GC_BG_THRESHOLD percent.  Each call processes at most
+ * NFFS_GC_STEP_BUCKETS hash buckets, so a cycle is spread over several calls.
+ * Until the cycle completes, the source area does not accept new objects.
+ *
+ * @param out_pending       On success, indicates whether the current cycle
+ *                              requires further steps.
+ *
+ * @return                  0 on success; nonzero on error.
+ */
+int
+nffs_gc_slice(int *out_pending)
+{
+    int rc;
 
-    if (out_area_idx != NULL) {
-        *out_area_idx = nffs_scratch_area_idx;
+    if (nffs_gc_phase == NFFS_GC_PHASE_IDLE) {
+        if (!nffs_gc_bg_needed()) {
+            *out_pending = 0;
+            return 0;
+        }
+        nffs_gc_scan_begin();
     }
 
-    nffs_scratch_area_idx = from_area_idx;
+    rc = nffs_gc_run(MYNEWT_VAL(NFFS_GC_STEP_BUCKETS), 1, NULL);
+    *out_pending = nffs_gc_phase != NFFS_GC_PHASE_IDLE;
 
-    /* Garbage collection renders the cache invalid:
-     *     o All cached blocks are now invalid; drop them.
-     *     o Flash locations of inodes may have changed; the cached inodes need
-     *       updated to reflect this.
-     */
-    rc = nffs_cache_inode_refresh();
-    if (rc != 0) {
-        return rc;
+    return rc;
+}
+
+/**
+ * Completes a garbage collection cycle that was started by nffs_gc_step(), if
+ * any.
+ *
+ * @return                  0 on success; nonzero on error.
+ */
+int
+nffs_gc_finish(void)
+{
+    if (nffs_gc_phase == NFFS_GC_PHASE_IDLE) {
+        return 0;
     }
 
-    /* Increment the garbage collection counter so that client code knows to
-     * reset its pointers to cached objects.
-     */
-    nffs_gc_count++;
-    STATS_INC(nffs_stats, nffs_gccnt);
+    return nffs_gc(NULL);
+}
 
-    return 0;
+/**
+ * Discards the state of any unfinished garbage collection cycle.  Called when
+ * the RAM representation of the file system is reset.
+ */
+void
+nffs_gc_reset(void)
+{
+    nffs_gc_phase = NFFS_GC_PHASE_IDLE;
+    nffs_gc_from_area_idx = NFFS_AREA_ID_NONE;
+    nffs_gc_bg_idle_cur = 0;
 }
 
 /**
@@ -18,6 +18,7 @@
  */
 
 #include <stddef.h>
+#include <stdlib.h>
 #include <string.h>
 #include <assert.h>
 #include "nffs/nffs.h"
@@ -25,6 +26,12 @@
 
 struct nffs_hash_list *nffs_hash;
 
+/** Current bucket count; always a power of two. */
+uint32_t nffs_hash_size;
+
+/** log2(nffs_hash_size). */
+static uint8_t nffs_hash_bits;
+
 uint32_t nffs_hash_next_dir_id;
 uint32_t nffs_hash_next_file_id;
 uint32_t nffs_hash_next_block_id;
@@ -53,10 +60,15 @@ nffs_hash_id_is_block(uint32_t id)
     return id >= NFFS_ID_BLOCK_MIN && id < NFFS_ID_BLOCK_MAX;
 }
 
-static int
+/**
+ * Maps an object ID to a bucket index.  IDs of each type are allocated
+ * sequentially from a power-of-two aligned base, so the low bits are already
+ * uniformly distributed.
+ */
+int
 nffs_hash_fn(uint32_t id)
 {
-    return id % NFFS_HASH_SIZE;
+    return id & (nffs_hash_size - 1);
 }
 
 static struct nffs_hash_entry *
@@ -70,8 +82,11 @@ nffs_hash_find_reorder(uint32_t id)
     idx = nffs_hash_fn(id);
     list = nffs_hash + idx;
 
+    STATS_INC(nffs_stats, nffs_hashcnt_lookup);
+
     prev = NULL;
     SLIST_FOREACH(entry, list, nhe_next) {
+        STATS_INC(nffs_stats, nffs_hashcnt_probe);
         if (entry->nhe_id == id) {
             /* Put entry at the front of the list. */
             if (prev != NULL) {
@@ -97,7 +112,10 @@ nffs_hash_find(uint32_t id)
     idx = nffs_hash_fn(id);
     list = nffs_hash + idx;
 
+    STATS_INC(nffs_stats, nffs_hashcnt_lookup);
+
     SLIST_FOREACH(entry, list, nhe_next) {
+        STATS_INC(nffs_stats, nffs_hashcnt_probe);
         if (entry->nhe_id == id) {
             return entry;
         }
@@ -194,21 +212,118 @@ nffs_hash_remove(struct nffs_hash_entry *entry)
     assert(nffs_hash_find(entry->nhe_id) == NULL);
 }
 
+static int
+nffs_hash_alloc(uint32_t size, struct nffs_hash_list **out_hash)
+{
+    struct nffs_hash_list *hash;
+    uint32_t i;
+
+    hash = malloc(size * sizeof *hash);
+    if (hash == NULL) {
+        return FS_ENOMEM;
+    }
+
+    for (i = 0; i < size; i++) {
+        SLIST_INIT(hash + i);
+    }
+
+    *out_hash = hash;
+    return 0;
+}
+
+static void
+nffs_hash_set_size(uint32_t size)
+{
+    nffs_hash_size = size;
+
+    nffs_hash_bits = 0;
+    while ((1UL << nffs_hash_bits) < size) {
+        nffs_hash_bits++;
+    }
+}
+
 int
 nffs_hash_init(void)
 {
-    int i;
+    int rc;
 
     free(nffs_hash);
+    nffs_hash = NULL;
 
-    nffs_hash = malloc(NFFS_HASH_SIZE * sizeof *nffs_hash);
-    if (nffs_hash == NULL) {
-        return FS_ENOMEM;
+    rc = nffs_hash_alloc(NFFS_HASH_SIZE, &nffs_hash);
+    if (rc != 0) {
+        return rc;
+    }
+    nffs_hash_set_size(NFFS_HASH_SIZE);
+
+    return 0;
+}
+
+/**
+ * Resizes the hash table to suit the number of entries it contains.  This is
+ * called once a file system has been restored, when the entry count is known.
+ * The table is doubled until there is at least one bucket per entry or
+ * NFFS_HASH_MAX_SIZE is reached.  If memory for a larger table cannot be
+ * allocated, the current table is kept.  The length of the longest chain is
+ * recorded in the nffs_hashcnt_max_chain statistic.
+ */
+void
+nffs_hash_grow(void)
+{
+    struct nffs_hash_entry *entry;
+    struct nffs_hash_entry *next;
+    struct nffs_hash_list *old_hash;
+    struct nffs_hash_list *hash;
+    uint32_t old_size;
+    uint32_t max_chain;
+    uint32_t num_entries;
+    uint32_t chain;
+    uint32_t size;
+    int rc;
+    int i;
+
+    num_entries = 0;
+    NFFS_HASH_FOREACH(entry, i, next) {
+        num_entries++;
     }
 
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
-        SLIST_INIT(nffs_hash + i);
+    size = nffs_hash_size;
+    while (size < num_entries && size < NFFS_HASH_MAX_SIZE) {
+        size <<= 1;
     }
 
-    return 0;
+    if (size != nffs_hash_size) {
+        rc = nffs_hash_alloc(size, &hash);
+        if (rc == 0) {
+            old_hash = nffs_hash;
+            old_size = nffs_hash_size;
+
+            nffs_hash = hash;
+            nffs_hash_set_size(size);
+
+            for (i = 0; i < old_size; i++) {
+                while ((entry = SLIST_FIRST(old_hash + i)) != NULL) {
+                    SLIST_REMOVE_HEAD(old_hash + i, nhe_next);
+                    SLIST_INSERT_HEAD(nffs_hash + nffs_hash_fn(entry->nhe_id),
+                                      entry, nhe_next);
+                }
+            }
+            free(old_hash);
+
+            STATS_INC(nffs_stats, nffs_hashcnt_grow);
+        }
+    }
+
+    max_chain = 0;
+    for (i = 0; i < nffs_hash_size; i++) {
+        chain = 0;
+        SLIST_FOREACH(entry, nffs_hash + i, nhe_next) {
+            chain++;
+        }
+        if (chain > max_chain) {
+            max_chain = chain;
+        }
+    }
+    STATS_CLEAR(nffs_stats, nffs_hashcnt_max_chain);
+    STATS_INCN(nffs_stats, nffs_hashcnt_max_chain, max_chain);
 }
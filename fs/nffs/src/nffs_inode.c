@@ -22,6 +22,7 @@
 #include <assert.h>
 #include "testutil/testutil.h"
 #include "os/os_mempool.h"
+#include "os/os_mbuf.h"
 #include "nffs/nffs.h"
 #include "nffs_priv.h"
 
@@ -55,6 +56,11 @@ nffs_inode_entry_free(struct nffs_inode_entry *inode_entry)
     if (inode_entry != NULL) {
         assert(!nffs_inode_getflags(inode_entry, NFFS_INODE_FLAG_INHASH));
         assert(nffs_hash_id_is_inode(inode_entry->nie_hash_entry.nhe_id));
+#if MYNEWT_VAL(NFFS_DIR_INDEX_ENTRIES) > 0
+        if (nffs_hash_id_is_dir(inode_entry->nie_hash_entry.nhe_id)) {
+            nffs_dirindex_drop(inode_entry);
+        }
+#endif
         os_memblock_put(&nffs_inode_entry_pool, inode_entry);
     }
 }
@@ -184,6 +190,64 @@ nffs_inode_data_len(struct nffs_inode_entry *inode_entry, uint32_t *out_len)
     return 0;
 }
 
+static uint32_t
+nffs_inode_version_add(uint32_t ver, uint32_t val)
+{
+    int i;
+
+    /* FNV-1a */
+    for (i = 0; i < 4; i++) {
+        ver ^= val & 0xff;
+        ver *= 16777619u;
+        val >>= 8;
+    }
+    return ver;
+}
+
+/**
+ * Calculates a value that changes whenever the file is renamed or any of
+ * its data blocks is rewritten: a hash of the inode's sequence number and the
+ * ID, sequence number and length of each of its blocks.  Reads one block
+ * header per block, so it is meant to be called once per open, not per read.
+ */
+int
+nffs_inode_version(struct nffs_inode_entry *inode_entry, uint32_t *out_ver)
+{
+    struct nffs_hash_entry *cur;
+    struct nffs_inode inode;
+    struct nffs_block block;
+    uint32_t ver;
+    int rc;
+
+    rc = nffs_inode_from_entry(&inode, inode_entry);
+    if (rc != 0) {
+        return rc;
+    }
+
+    ver = 2166136261u;
+    ver = nffs_inode_version_add(ver, inode_entry->nie_hash_entry.nhe_id);
+    ver = nffs_inode_version_add(ver, inode.ni_seq);
+
+    cur = inode_entry->nie_last_block_entry;
+    while (cur != NULL) {
+        ver = nffs_inode_version_add(ver, cur->nhe_id);
+        if (nffs_block_is_dummy(cur)) {
+            break;
+        }
+        rc = nffs_block_from_hash_entry(&block, cur);
+        if (rc != 0) {
+            return rc;
+        }
+        ver = nffs_inode_version_add(ver, block.nb_seq);
+        ver = nffs_inode_version_add(ver, block.nb_data_len);
+
+        cur = block.nb_prev;
+    }
+
+    *out_ver = ver;
+    return 0;
+}
+
 static void
 nffs_inode_restore_from_dummy_entry(struct nffs_inode *out_inode,
                                     struct nffs_inode_entry *inode_entry)
@@ -487,6 +551,9 @@ nffs_inode_delete_from_disk(struct nffs_inode *inode)
     nffs_crc_disk_inode_fill(&disk_inode, "");
 
     rc = nffs_inode_write_disk(&disk_inode, "", area_idx, offset);
+    if (rc == 0) {
+        nffs_areas[area_idx].na_tombstones++;
+    }
     NFFS_LOG(DEBUG, "inode_del_disk: wrote unlinked ino %x to disk ref %d\n",
                (unsigned int)disk_inode.ndi_id,
                inode->ni_inode_entry->nie_refcnt);
@@ -564,6 +631,7 @@ nffs_inode_rename(struct nffs_inode_entry *inode_entry,
     uint8_t area_idx;
     int filename_len;
     int ancestor;
+    int renamed;
     int rc;
 
     /* Don't allow a directory to be moved into a descendent directory. */
@@ -593,7 +661,8 @@ nffs_inode_rename(struct nffs_inode_entry *inode_entry,
         inode.ni_parent = new_parent;
     }
 
-    if (new_filename != NULL) {
+    renamed = new_filename != NULL;
+    if (renamed) {
         filename_len = strlen(new_filename);
     } else {
         filename_len = inode.ni_filename_len;
@@ -638,6 +707,18 @@ nffs_inode_rename(struct nffs_inode_entry *inode_entry,
     inode_entry->nie_hash_entry.nhe_flash_loc =
         nffs_flash_loc(area_idx, area_offset);
 
+#if MYNEWT_VAL(NFFS_DIR_INDEX_ENTRIES) > 0
+    /* The parent's index refers to the inode by its old name. */
+    if (new_parent != NULL && renamed) {
+        nffs_dirindex_remove(new_parent, inode_entry);
+        if (nffs_inode_from_entry(&inode, inode_entry) == 0) {
+            nffs_dirindex_add(new_parent, &inode);
+        } else {
+            nffs_dirindex_drop(new_parent);
+        }
+    }
+#endif
+
     return 0;
 }
 
@@ -710,7 +791,7 @@ nffs_inode_update(struct nffs_inode_entry *inode_entry)
     return 0;
 }
 
-static int
+int
 nffs_inode_read_filename_chunk(const struct nffs_inode *inode,
                                uint8_t filename_offset, void *buf, int len)
 {
@@ -778,6 +859,54 @@ nffs_inode_read_filename(struct nffs_inode_entry *inode_entry, size_t max_len,
     return 0;
 }
 
+#if MYNEWT_VAL(NFFS_DIR_INDEX_ENTRIES) > 0
+/**
+ * Calculates the directory index hash of the specified inode's filename.
+ *
+ * @param inode                 The inode to hash.
+ * @param out_hash              On success, the hash gets written here.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_inode_filename_hash(const struct nffs_inode *inode, uint32_t *out_hash)
+{
+    uint32_t hash;
+    int chunk_len;
+    int off;
+    int rc;
+
+    if (inode->ni_filename_len < NFFS_SHORT_FILENAME_LEN) {
+        chunk_len = inode->ni_filename_len;
+    } else {
+        chunk_len = NFFS_SHORT_FILENAME_LEN;
+    }
+    hash = nffs_dirindex_hash(NFFS_DIRINDEX_HASH_INIT, inode->ni_filename,
+                              chunk_len);
+
+    off = chunk_len;
+    while (off < inode->ni_filename_len) {
+        chunk_len = inode->ni_filename_len - off;
+        if (chunk_len > NFFS_INODE_FILENAME_BUF_SZ) {
+            chunk_len = NFFS_INODE_FILENAME_BUF_SZ;
+        }
+
+        rc = nffs_inode_read_filename_chunk(inode, off,
+                                            nffs_inode_filename_buf0,
+                                            chunk_len);
+        if (rc != 0) {
+            return rc;
+        }
+
+        hash = nffs_dirindex_hash(hash, nffs_inode_filename_buf0, chunk_len);
+        off += chunk_len;
+    }
+
+    *out_hash = hash;
+    return 0;
+}
+#endif
+
 int
 nffs_inode_add_child(struct nffs_inode_entry *parent,
                      struct nffs_inode_entry *child)
@@ -823,6 +952,9 @@ nffs_inode_add_child(struct nffs_inode_entry *parent,
         SLIST_INSERT_AFTER(prev, child, nie_sibling_next);
     }
     nffs_inode_setflags(child, NFFS_INODE_FLAG_INTREE);
+#if MYNEWT_VAL(NFFS_DIR_INDEX_ENTRIES) > 0
+    nffs_dirindex_add(parent, &child_inode);
+#endif
 
     return 0;
 }
@@ -836,6 +968,9 @@ nffs_inode_remove_child(struct nffs_inode *child)
     parent = child->ni_parent;
     assert(parent != NULL);
     assert(nffs_hash_id_is_dir(parent->nie_hash_entry.nhe_id));
+#if MYNEWT_VAL(NFFS_DIR_INDEX_ENTRIES) > 0
+    nffs_dirindex_remove(parent, child->ni_inode_entry);
+#endif
     SLIST_REMOVE(&parent->nie_child_list, child->ni_inode_entry,
                  nffs_inode_entry, nie_sibling_next);
     SLIST_NEXT(child->ni_inode_entry, nie_sibling_next) = NULL;
@@ -1029,21 +1164,86 @@ nffs_inode_seek(struct nffs_inode_entry *inode_entry, uint32_t offset,
 }
 
 /**
- * Reads data from the specified file inode.
- *
- * @param inode_entry           The inode to read from.
- * @param offset                The offset within the file to start the read
- *                                  at.
- * @param len                   The number of bytes to attempt to read.
- * @param out_data              On success, the read data gets written here.
- * @param out_len               On success, the number of bytes actually read
- *                                  gets written here.
- *
- * @return                      0 on success; nonzero on failure.
+ * Lengthens an mbuf chain by the specified number of bytes without writing
+ * any data; the new space is filled in afterwards by reading directly from
+ * flash.  On failure, the chain is left at its original length.
  */
-int
-nffs_inode_read(struct nffs_inode_entry *inode_entry, uint32_t offset,
-                uint32_t len, void *out_data, uint32_t *out_len)
+static int
+nffs_inode_mbuf_grow(struct os_mbuf *om, uint32_t len)
+{
+    struct os_mbuf *last;
+    uint32_t grown;
+    uint16_t chunk;
+
+    grown = 0;
+    while (grown < len) {
+        last = om;
+        while (SLIST_NEXT(last, om_next) != NULL) {
+            last = SLIST_NEXT(last, om_next);
+        }
+
+        chunk = OS_MBUF_TRAILINGSPACE(last);
+        if (chunk == 0) {
+            chunk = om->om_omp->omp_databuf_len;
+        }
+        if (chunk > len - grown) {
+            chunk = len - grown;
+        }
+
+        if (os_mbuf_extend(om, chunk) == NULL) {
+            os_mbuf_adj(om, -(int)grown);
+            return FS_ENOMEM;
+        }
+        grown += chunk;
+    }
+
+    return 0;
+}
+
+/**
+ * Reads a range of a data block into an mbuf chain at the specified chain
+ * offset.  The chain must already be long enough.
+ */
+static int
+nffs_inode_read_block_mbuf(const struct nffs_block *block, uint16_t block_off,
+                           uint16_t len, struct os_mbuf *om, uint32_t om_off)
+{
+    struct os_mbuf *cur;
+    uint16_t cur_off;
+    uint16_t chunk;
+    int rc;
+
+    while (len > 0) {
+        cur = os_mbuf_off(om, om_off, &cur_off);
+        assert(cur != NULL);
+
+        chunk = cur->om_len - cur_off;
+        if (chunk > len) {
+            chunk = len;
+        }
+
+        rc = nffs_block_read_data(block, block_off, chunk,
+                                  cur->om_data + cur_off);
+        if (rc != 0) {
+            return rc;
+        }
+
+        block_off += chunk;
+        om_off += chunk;
+        len -= chunk;
+    }
+
+    return 0;
+}
+
+/**
+ * Reads data from the specified file inode into either a flat buffer or an
+ * mbuf chain (appended).
+ */
+static int
+nffs_inode_read_priv(struct nffs_inode_entry *inode_entry, uint32_t offset,
+                     uint32_t len, void *out_data, struct os_mbuf *om,
+                     uint32_t *out_len)
 {
     struct nffs_cache_inode *cache_inode;
     struct nffs_cache_block *cache_block;
@@ -1051,6 +1251,7 @@ nffs_inode_read(struct nffs_inode_entry *inode_entry, uint32_t offset,
     uint32_t dst_off;
     uint32_t src_off;
     uint32_t src_end;
+    uint32_t om_base;
     uint16_t block_off;
     uint16_t chunk_sz;
     uint8_t *dptr;
@@ -1072,6 +1273,21 @@ nffs_inode_read(struct nffs_inode_entry *inode_entry, uint32_t offset,
     if (src_end > cache_inode->nci_file_size) {
         src_end = cache_inode->nci_file_size;
     }
+    if (src_end <= offset) {
+        if (out_len != NULL) {
+            *out_len = 0;
+        }
+        return 0;
+    }
+
+    om_base = 0;
+    if (om != NULL) {
+        om_base = OS_MBUF_PKTLEN(om);
+        rc = nffs_inode_mbuf_grow(om, src_end - offset);
+        if (rc != 0) {
+            return rc;
+        }
+    }
 
     /* Initialize variables for the first iteration. */
     dst_off = src_end - offset;
@@ -1086,7 +1302,7 @@ nffs_inode_read(struct nffs_inode_entry *inode_entry, uint32_t offset,
         if (cache_block == NULL) {
             rc = nffs_cache_seek(cache_inode, src_off - 1, &cache_block);
             if (rc != 0) {
-                return rc;
+                goto err;
             }
         }
 
@@ -1106,10 +1322,15 @@ nffs_inode_read(struct nffs_inode_entry *inode_entry, uint32_t offset,
         dst_off -= chunk_sz;
         src_off -= chunk_sz;
 
-        rc = nffs_block_read_data(&cache_block->ncb_block, block_off, chunk_sz,
-                                  dptr + dst_off);
+        if (om != NULL) {
+            rc = nffs_inode_read_block_mbuf(&cache_block->ncb_block, block_off,
+                                            chunk_sz, om, om_base + dst_off);
+        } else {
+            rc = nffs_block_read_data(&cache_block->ncb_block, block_off,
+                                      chunk_sz, dptr + dst_off);
+        }
         if (rc != 0) {
-            return rc;
+            goto err;
         }
 
         cache_block = TAILQ_PREV(cache_block, nffs_cache_block_list, ncb_link);
@@ -1120,6 +1341,56 @@ nffs_inode_read(struct nffs_inode_entry *inode_entry, uint32_t offset,
     }
 
     return 0;
+
+err:
+    if (om != NULL) {
+        os_mbuf_adj(om, -(int)(src_end - offset));
+    }
+    return rc;
+}
+
+/**
+ * Reads data from the specified file inode.
+ *
+ * @param inode_entry           The inode to read from.
+ * @param offset                The offset within the file to start the read
+ *                                  at.
+ * @param len                   The number of bytes to attempt to read.
+ * @param out_data              On success, the read data gets written here.
+ * @param out_len               On success, the number of bytes actually read
+ *                                  gets written here.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+nffs_inode_read(struct nffs_inode_entry *inode_entry, uint32_t offset,
+                uint32_t len, void *out_data, uint32_t *out_len)
+{
+    return nffs_inode_read_priv(inode_entry, offset, len, out_data, NULL,
+                                out_len);
+}
+
+/**
+ * Reads data from the specified file inode and appends it to an mbuf chain.
+ * Data is read from flash directly into the mbuf data areas; additional
+ * buffers are allocated from the chain's pool.
+ *
+ * @param inode_entry           The inode to read from.
+ * @param offset                The offset within the file to start the read
+ *                                  at.
+ * @param len                   The number of bytes to attempt to read.
+ * @param om                    The packet header mbuf chain to append to.
+ * @param out_len               On success, the number of bytes actually read
+ *                                  gets written here.
+ *
+ * @return                      0 on success; FS_ENOMEM if the mbuf pool is
+ *                                  exhausted; other nonzero on failure.
+ */
+int
+nffs_inode_read_mbuf(struct nffs_inode_entry *inode_entry, uint32_t offset,
+                     uint32_t len, struct os_mbuf *om, uint32_t *out_len)
+{
+    return nffs_inode_read_priv(inode_entry, offset, len, NULL, om, out_len);
 }
 
 static int
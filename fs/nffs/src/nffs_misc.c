@@ -194,6 +194,36 @@ nffs_misc_reserve_space_area(uint8_t area_idx, uint16_t space,
     return FS_EFULL;
 }
 
+/**
+ * Indicates whether an object of the specified size is best placed in an
+ * area.  Areas on a flash device that is being erased are avoided, so the
+ * write does not wait for the erase.  With NFFS_FAST_FLASH_ID, small objects
+ * go to the faster device and large ones are kept off it.
+ */
+static int
+nffs_misc_area_preferred(uint8_t area_idx, uint16_t space)
+{
+    const struct nffs_area *area;
+
+    area = nffs_areas + area_idx;
+    (void)area;
+
+#if MYNEWT_VAL(NFFS_ERASE_ASYNC)
+    if (nffs_erase_busy(area->na_flash_id)) {
+        return 0;
+    }
+#endif
+
+#if MYNEWT_VAL(NFFS_FAST_FLASH_ID) >= 0
+    if ((space <= MYNEWT_VAL(NFFS_FAST_OBJ_MAX)) !=
+        (area->na_flash_id == MYNEWT_VAL(NFFS_FAST_FLASH_ID))) {
+        return 0;
+    }
+#endif
+
+    return 1;
+}
+
 /**
  * Finds an area that can accommodate an object of the specified size.  If no
  * such area exists, this function performs a garbage collection cycle.
@@ -211,12 +241,21 @@ nffs_misc_reserve_space(uint16_t space,
                         uint8_t *out_area_idx, uint32_t *out_area_offset)
 {
     uint8_t area_idx;
+    int pass;
     int rc;
     int i;
 
-    /* Find the first area with sufficient free space. */
-    for (i = 0; i < nffs_num_areas; i++) {
-        if (i != nffs_scratch_area_idx) {
+    /* Find the first area with sufficient free space, trying the areas that
+     * suit the object best first.
+     */
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < nffs_num_areas; i++) {
+            if (i == nffs_scratch_area_idx || i == nffs_gc_from_area_idx) {
+                continue;
+            }
+            if (pass == 0 && !nffs_misc_area_preferred(i, space)) {
+                continue;
+            }
             rc = nffs_misc_reserve_space_area(i, space, out_area_offset);
             if (rc == 0) {
                 *out_area_idx = i;
@@ -363,6 +402,11 @@ nffs_misc_reset(void)
 {
     int rc;
 
+#if MYNEWT_VAL(NFFS_ERASE_ASYNC)
+    /* Let the erase of the old scratch area finish before areas go away. */
+    nffs_erase_wait();
+#endif
+
     nffs_cache_clear();
 
     rc = os_mempool_init(&nffs_file_pool, nffs_config.nc_num_files,
@@ -422,6 +466,13 @@ nffs_misc_reset(void)
     nffs_root_dir = NULL;
     nffs_lost_found_dir = NULL;
     nffs_scratch_area_idx = NFFS_AREA_ID_NONE;
+    nffs_gc_reset();
+#if MYNEWT_VAL(NFFS_DIR_INDEX_ENTRIES) > 0
+    nffs_dirindex_reset();
+#endif
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    nffs_ckpt_next_offset = 0;
+#endif
 
     nffs_hash_next_file_id = NFFS_ID_FILE_MIN;
     nffs_hash_next_dir_id = NFFS_ID_DIR_MIN;
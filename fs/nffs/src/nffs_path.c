@@ -74,6 +74,15 @@ nffs_path_find_child(struct nffs_inode_entry *parent,
     struct nffs_inode inode;
     int cmp;
     int rc;
+#if MYNEWT_VAL(NFFS_DIR_INDEX_ENTRIES) > 0
+    int indexed;
+
+    rc = nffs_dirindex_find(parent, name, name_len, out_inode_entry,
+                            &indexed);
+    if (indexed || rc != 0) {
+        return rc;
+    }
+#endif
 
     SLIST_FOREACH(cur, &parent->nie_child_list, nie_sibling_next) {
         rc = nffs_inode_from_entry(&inode, cur);
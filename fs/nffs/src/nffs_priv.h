@@ -21,6 +21,7 @@
 #define H_NFFS_PRIV_
 
 #include <inttypes.h>
+#include "syscfg/syscfg.h"
 #include "log/log.h"
 #include "os/queue.h"
 #include "os/os_mempool.h"
@@ -33,7 +34,17 @@
 extern "C" {
 #endif
 
-#define NFFS_HASH_SIZE               256
+#define NFFS_HASH_SIZE               MYNEWT_VAL(NFFS_HASH_SIZE)
+#define NFFS_HASH_MAX_SIZE           MYNEWT_VAL(NFFS_HASH_MAX_SIZE)
+
+#if (NFFS_HASH_SIZE & (NFFS_HASH_SIZE - 1)) != 0 || \
+    (NFFS_HASH_MAX_SIZE & (NFFS_HASH_MAX_SIZE - 1)) != 0
+#error "NFFS_HASH_SIZE and NFFS_HASH_MAX_SIZE must be powers of two"
+#endif
+
+#if NFFS_HASH_MAX_SIZE < NFFS_HASH_SIZE
+#error "NFFS_HASH_MAX_SIZE must not be less than NFFS_HASH_SIZE"
+#endif
 
 #define NFFS_ID_DIR_MIN              0
 #define NFFS_ID_DIR_MAX              0x10000000
@@ -63,6 +74,10 @@ extern "C" {
 
 #define NFFS_BLOCK_MAX_DATA_SZ_MAX   2048
 
+#if MYNEWT_VAL(NFFS_WRITE_BUF_SIZE) > NFFS_BLOCK_MAX_DATA_SZ_MAX
+#error "NFFS_WRITE_BUF_SIZE must not exceed NFFS_BLOCK_MAX_DATA_SZ_MAX"
+#endif
+
 #define NFFS_DETECT_FAIL_IGNORE     1
 #define NFFS_DETECT_FAIL_FORMAT     2
 
@@ -174,6 +189,11 @@ struct nffs_file {
     struct nffs_inode_entry *nf_inode_entry;
     uint32_t nf_offset;
     uint8_t nf_access_flags;
+#if MYNEWT_VAL(NFFS_WRITE_BUF_SIZE) > 0
+    /* Data written at nf_offset - nf_wbuf_len that is not yet on flash. */
+    uint16_t nf_wbuf_len;
+    uint8_t nf_wbuf[MYNEWT_VAL(NFFS_WRITE_BUF_SIZE)];
+#endif
 };
 
 struct nffs_area {
@@ -184,6 +204,38 @@ struct nffs_area {
     uint8_t na_gc_seq;
     uint8_t na_flash_id;
     uint32_t na_obsolete;   /* deleted bytecount */
+    uint32_t na_live;       /* Live bytes, as of the last gc scan. */
+    uint16_t na_tombstones; /* Deletion records written since erase. */
+    uint32_t na_erase_cnt;  /* Erases since the file system was mounted. */
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    uint32_t na_verified;   /* Length of CRC-validated prefix. */
+#endif
+};
+
+#define NFFS_CKPT_MAGIC              0x7b2c91e4
+
+/**
+ * Mount checkpoint header.  Checkpoints are appended to the otherwise unused
+ * body of the scratch area; each header is followed by one
+ * nffs_disk_ckpt_area record per area.  The CRC covers the header up to the
+ * CRC field and all of the area records.
+ */
+struct nffs_disk_ckpt {
+    uint32_t ndc_magic;     /* NFFS_CKPT_MAGIC */
+    uint8_t ndc_num_areas;  /* Number of area records that follow. */
+    uint8_t reserved8;
+    uint16_t ndc_crc16;
+};
+
+#define NFFS_DISK_CKPT_OFFSET_CRC    6
+
+struct nffs_disk_ckpt_area {
+    uint32_t ndca_offset;   /* Flash offset of start of area. */
+    uint32_t ndca_verified; /* Bytes known to contain only valid objects. */
+    uint8_t ndca_flash_id;
+    uint8_t ndca_id;
+    uint8_t ndca_gc_seq;
+    uint8_t reserved8;
 };
 
 struct nffs_disk_object {
@@ -237,8 +289,19 @@ struct nffs_cache_inode {
     uint32_t nci_file_size;                        /* Total file size. */
 };
 
+/**
+ * Snapshot of a directory child, taken by nffs_dir_read().  Names that fit in
+ * nde_name and file sizes are answered from the snapshot without touching
+ * flash.
+ */
 struct nffs_dirent {
     struct nffs_inode_entry *nde_inode_entry;
+    struct nffs_inode nde_inode;
+    uint32_t nde_data_len;
+#if MYNEWT_VAL(NFFS_DIRENT_NAME_LEN) > 0
+    uint8_t nde_name_cached:1;
+    char nde_name[MYNEWT_VAL(NFFS_DIRENT_NAME_LEN) + 1];
+#endif
 };
 
 struct nffs_dir {
@@ -249,14 +312,22 @@ struct nffs_dir {
 STATS_SECT_START(nffs_stats)
     STATS_SECT_ENTRY(nffs_hashcnt_ins)
     STATS_SECT_ENTRY(nffs_hashcnt_rm)
+    STATS_SECT_ENTRY(nffs_hashcnt_lookup)
+    STATS_SECT_ENTRY(nffs_hashcnt_probe)
+    STATS_SECT_ENTRY(nffs_hashcnt_grow)
+    STATS_SECT_ENTRY(nffs_hashcnt_max_chain)
     STATS_SECT_ENTRY(nffs_object_count)
     STATS_SECT_ENTRY(nffs_iocnt_read)
     STATS_SECT_ENTRY(nffs_iocnt_write)
     STATS_SECT_ENTRY(nffs_gccnt)
+    STATS_SECT_ENTRY(nffs_gccnt_step)
+    STATS_SECT_ENTRY(nffs_gccnt_wear)
+    STATS_SECT_ENTRY(nffs_gccnt_erase)
     STATS_SECT_ENTRY(nffs_readcnt_data)
     STATS_SECT_ENTRY(nffs_readcnt_block)
     STATS_SECT_ENTRY(nffs_readcnt_crc)
     STATS_SECT_ENTRY(nffs_readcnt_copy)
+    STATS_SECT_ENTRY(nffs_readcnt_mapped)
     STATS_SECT_ENTRY(nffs_readcnt_format)
     STATS_SECT_ENTRY(nffs_readcnt_gccollate)
     STATS_SECT_ENTRY(nffs_readcnt_inode)
@@ -266,6 +337,18 @@ STATS_SECT_START(nffs_stats)
     STATS_SECT_ENTRY(nffs_readcnt_filename)
     STATS_SECT_ENTRY(nffs_readcnt_object)
     STATS_SECT_ENTRY(nffs_readcnt_detect)
+    STATS_SECT_ENTRY(nffs_readcnt_ckpt)
+    STATS_SECT_ENTRY(nffs_ckptcnt_write)
+    STATS_SECT_ENTRY(nffs_ckptcnt_crc_skip)
+    STATS_SECT_ENTRY(nffs_cachecnt_readahead)
+    STATS_SECT_ENTRY(nffs_wbufcnt_write)
+    STATS_SECT_ENTRY(nffs_wbufcnt_flush)
+    STATS_SECT_ENTRY(nffs_dindexcnt_build)
+    STATS_SECT_ENTRY(nffs_dindexcnt_evict)
+    STATS_SECT_ENTRY(nffs_dindexcnt_hit)
+    STATS_SECT_ENTRY(nffs_dindexcnt_collision)
+    STATS_SECT_ENTRY(nffs_filecnt_dyn_alloc)
+    STATS_SECT_ENTRY(nffs_filecnt_alloc_fail)
 STATS_SECT_END
 extern STATS_SECT_DECL(nffs_stats) nffs_stats;
 
@@ -288,13 +371,21 @@ extern struct nffs_area *nffs_areas;
 extern uint8_t nffs_num_areas;
 extern uint8_t nffs_scratch_area_idx;
 extern uint16_t nffs_block_max_data_sz;
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+extern uint8_t nffs_cache_read_ahead_max;
+#endif
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+extern uint32_t nffs_ckpt_next_offset;
+#endif
 extern unsigned int nffs_gc_count;
+extern uint8_t nffs_gc_from_area_idx;
 extern struct nffs_area_desc *nffs_current_area_descs;
 
 #define NFFS_FLASH_BUF_SZ        256
 extern uint8_t nffs_flash_buf[NFFS_FLASH_BUF_SZ];
 
 extern struct nffs_hash_list *nffs_hash;
+extern uint32_t nffs_hash_size;
 extern struct nffs_inode_entry *nffs_root_dir;
 extern struct nffs_inode_entry *nffs_lost_found_dir;
 
@@ -360,6 +451,12 @@ int nffs_crc_disk_inode_validate(const struct nffs_disk_inode *disk_inode,
 void nffs_crc_disk_inode_fill(struct nffs_disk_inode *disk_inode,
                               const char *filename);
 
+/* @ckpt */
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+int nffs_ckpt_write(void);
+void nffs_ckpt_restore(void);
+#endif
+
 /* @config */
 void nffs_config_init(void);
 
@@ -368,12 +465,28 @@ int nffs_dir_open(const char *path, struct nffs_dir **out_dir);
 int nffs_dir_read(struct nffs_dir *dir, struct nffs_dirent **out_dirent);
 int nffs_dir_close(struct nffs_dir *dir);
 
+/* @dirindex */
+#if MYNEWT_VAL(NFFS_DIR_INDEX_ENTRIES) > 0
+#define NFFS_DIRINDEX_HASH_INIT     2166136261UL
+uint32_t nffs_dirindex_hash(uint32_t hash, const void *data, int len);
+int nffs_dirindex_find(struct nffs_inode_entry *dir, const char *name,
+                       int name_len, struct nffs_inode_entry **out_inode_entry,
+                       int *out_indexed);
+void nffs_dirindex_add(struct nffs_inode_entry *dir, struct nffs_inode *child);
+void nffs_dirindex_remove(struct nffs_inode_entry *dir,
+                          struct nffs_inode_entry *child);
+void nffs_dirindex_drop(struct nffs_inode_entry *dir);
+void nffs_dirindex_reset(void);
+#endif
+
 /* @file */
 int nffs_file_open(struct nffs_file **out_file, const char *filename,
                    uint8_t access_flags);
 int nffs_file_seek(struct nffs_file *file, uint32_t offset);
 int nffs_file_read(struct nffs_file *file, uint32_t len, void *out_data,
                    uint32_t *out_len);
+int nffs_file_read_mbuf(struct nffs_file *file, uint32_t len,
+                        struct os_mbuf *om, uint32_t *out_len);
 int nffs_file_close(struct nffs_file *file);
 int nffs_file_new(struct nffs_inode_entry *parent, const char *filename,
                   uint8_t filename_len, int is_dir,
@@ -381,12 +494,24 @@ int nffs_file_new(struct nffs_inode_entry *parent, const char *filename,
 
 /* @format */
 int nffs_format_area(uint8_t area_idx, int is_scratch);
+int nffs_format_area_hdr(uint8_t area_idx, int is_scratch);
 int nffs_format_from_scratch_area(uint8_t area_idx, uint8_t area_id);
 int nffs_format_full(const struct nffs_area_desc *area_descs);
 
 /* @gc */
 int nffs_gc(uint8_t *out_area_idx);
 int nffs_gc_until(uint32_t space, uint8_t *out_area_idx);
+int nffs_gc_slice(int *out_pending);
+int nffs_gc_finish(void);
+void nffs_gc_reset(void);
+
+#if MYNEWT_VAL(NFFS_ERASE_ASYNC)
+/* @erase */
+int nffs_erase_start(uint8_t area_idx);
+int nffs_erase_busy(uint8_t flash_id);
+void nffs_erase_wait(void);
+void nffs_erase_sync_dev(uint8_t flash_id);
+#endif
 
 /* @flash */
 struct nffs_area *nffs_flash_find_area(uint16_t logical_id);
@@ -400,6 +525,7 @@ int nffs_flash_copy(uint8_t area_id_from, uint32_t offset_from,
 uint32_t nffs_flash_loc(uint8_t area_idx, uint32_t offset);
 void nffs_flash_loc_expand(uint32_t flash_loc, uint8_t *out_area_idx,
                            uint32_t *out_area_offset);
+const void *nffs_flash_map(uint8_t area_idx, uint32_t offset, uint32_t len);
 
 /* @hash */
 int nffs_hash_id_is_dir(uint32_t id);
@@ -411,7 +537,9 @@ struct nffs_inode_entry *nffs_hash_find_inode(uint32_t id);
 struct nffs_hash_entry *nffs_hash_find_block(uint32_t id);
 void nffs_hash_insert(struct nffs_hash_entry *entry);
 void nffs_hash_remove(struct nffs_hash_entry *entry);
+int nffs_hash_fn(uint32_t id);
 int nffs_hash_init(void);
+void nffs_hash_grow(void);
 int nffs_hash_entry_is_dummy(struct nffs_hash_entry *he);
 int nffs_hash_id_is_dummy(uint32_t id);
 
@@ -423,6 +551,8 @@ int nffs_inode_calc_data_length(struct nffs_inode_entry *inode_entry,
                                 uint32_t *out_len);
 int nffs_inode_data_len(struct nffs_inode_entry *inode_entry,
                         uint32_t *out_len);
+int nffs_inode_version(struct nffs_inode_entry *inode_entry,
+                       uint32_t *out_ver);
 uint32_t nffs_inode_parent_id(const struct nffs_inode *inode);
 int nffs_inode_delete_from_disk(struct nffs_inode *inode);
 int nffs_inode_entry_from_disk(struct nffs_inode_entry *out_inode,
@@ -441,10 +571,15 @@ int nffs_inode_write_disk(const struct nffs_disk_inode *disk_inode,
                           uint32_t offset);
 int nffs_inode_inc_refcnt(struct nffs_inode_entry *inode_entry);
 int nffs_inode_dec_refcnt(struct nffs_inode_entry *inode_entry);
+int nffs_inode_filename_hash(const struct nffs_inode *inode,
+                             uint32_t *out_hash);
 int nffs_inode_add_child(struct nffs_inode_entry *parent,
                          struct nffs_inode_entry *child);
 void nffs_inode_remove_child(struct nffs_inode *child);
 int nffs_inode_is_root(const struct nffs_disk_inode *disk_inode);
+int nffs_inode_read_filename_chunk(const struct nffs_inode *inode,
+                                   uint8_t filename_offset, void *buf,
+                                   int len);
 int nffs_inode_read_filename(struct nffs_inode_entry *inode_entry,
                              size_t max_len, char *out_name,
                              uint8_t *out_full_len);
@@ -456,6 +591,9 @@ int nffs_inode_filename_cmp_flash(const struct nffs_inode *inode1,
                                   int *result);
 int nffs_inode_read(struct nffs_inode_entry *inode_entry, uint32_t offset,
                     uint32_t len, void *data, uint32_t *out_len);
+int nffs_inode_read_mbuf(struct nffs_inode_entry *inode_entry,
+                         uint32_t offset, uint32_t len, struct os_mbuf *om,
+                         uint32_t *out_len);
 int nffs_inode_seek(struct nffs_inode_entry *inode_entry, uint32_t offset,
                     uint32_t length, struct nffs_seek_info *out_seek_info);
 int nffs_inode_from_entry(struct nffs_inode *out_inode,
@@ -501,10 +639,11 @@ int nffs_restore_full(const struct nffs_area_desc *area_descs);
 
 /* @write */
 int nffs_write_to_file(struct nffs_file *file, const void *data, int len);
+int nffs_write_flush(struct nffs_file *file);
 
 
 #define NFFS_HASH_FOREACH(entry, i, next)                               \
-    for ((i) = 0; (i) < NFFS_HASH_SIZE; (i)++)                          \
+    for ((i) = 0; (i) < nffs_hash_size; (i)++)                          \
         for ((entry) = SLIST_FIRST(nffs_hash + (i));                    \
              (entry) && (((next)) = SLIST_NEXT((entry), nhe_next), 1);  \
              (entry) = ((next)))
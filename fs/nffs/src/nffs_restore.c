@@ -288,7 +288,7 @@ nffs_restore_sweep(void)
     /* Iterate through every object in the hash table, deleting all inodes that
      * should be removed.
      */
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    for (i = 0; i < nffs_hash_size; i++) {
         list = nffs_hash + i;
 
         entry = SLIST_FIRST(list);
@@ -455,6 +455,25 @@ nffs_restore_inode_gets_replaced(struct nffs_inode_entry *old_inode_entry,
     return 0;
 }
 
+/**
+ * Indicates whether the specified object lies entirely within the prefix of
+ * its area that the mount checkpoint vouches for.  Such objects do not need
+ * their CRCs validated.
+ */
+static int
+nffs_restore_obj_is_verified(uint8_t area_idx, uint32_t area_offset,
+                             uint32_t obj_len)
+{
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    if (area_offset + obj_len <= nffs_areas[area_idx].na_verified) {
+        STATS_INC(nffs_stats, nffs_ckptcnt_crc_skip);
+        return 1;
+    }
+#endif
+
+    return 0;
+}
+
 /**
  * Determines if the specified inode should be added to the RAM representation
  * and adds it if appropriate.
@@ -480,9 +499,17 @@ nffs_restore_inode(const struct nffs_disk_inode *disk_inode, uint8_t area_idx,
     new_inode = 0;
 
     /* Check the inode's CRC.  If the inode is corrupt, discard it. */
-    rc = nffs_crc_disk_inode_validate(disk_inode, area_idx, area_offset);
-    if (rc != 0) {
-        goto err;
+    if (!nffs_restore_obj_is_verified(area_idx, area_offset,
+                                      sizeof *disk_inode +
+                                      disk_inode->ndi_filename_len)) {
+        rc = nffs_crc_disk_inode_validate(disk_inode, area_idx, area_offset);
+        if (rc != 0) {
+            goto err;
+        }
+    }
+
+    if (disk_inode->ndi_flags & NFFS_INODE_FLAG_DELETED) {
+        nffs_areas[area_idx].na_tombstones++;
     }
 
     inode_entry = nffs_hash_find_inode(disk_inode->ndi_id);
@@ -801,9 +828,13 @@ nffs_restore_block(const struct nffs_disk_block *disk_block, uint8_t area_idx,
     /* Check the block's CRC.  If the block is corrupt, discard it.  If this
      * block would have superseded another, the old block becomes current.
      */
-    rc = nffs_crc_disk_block_validate(disk_block, area_idx, area_offset);
-    if (rc != 0) {
-        goto err;
+    if (!nffs_restore_obj_is_verified(area_idx, area_offset,
+                                      sizeof *disk_block +
+                                      disk_block->ndb_data_len)) {
+        rc = nffs_crc_disk_block_validate(disk_block, area_idx, area_offset);
+        if (rc != 0) {
+            goto err;
+        }
     }
 
     entry = nffs_hash_find_block(disk_block->ndb_id);
@@ -1027,6 +1058,22 @@ nffs_restore_disk_object_size(const struct nffs_disk_object *disk_object)
     }
 }
 
+/**
+ * Records that corrupt data was found at an area's current restore offset.
+ * The first such point bounds the prefix of the area that a future
+ * checkpoint may vouch for.
+ */
+static void
+nffs_restore_area_corrupt(struct nffs_area *area, int *corrupt)
+{
+    if (!*corrupt) {
+        *corrupt = 1;
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+        area->na_verified = area->na_cur;
+#endif
+    }
+}
+
 /**
  * Reads the specified area from disk and loads its contents into the RAM
  * representation.
@@ -1040,9 +1087,11 @@ nffs_restore_area_contents(int area_idx)
 {
     struct nffs_disk_object disk_object;
     struct nffs_area *area;
+    int corrupt;
     int rc;
 
     area = nffs_areas + area_idx;
+    corrupt = 0;
 
     area->na_cur = sizeof (struct nffs_disk_area);
     while (1) {
@@ -1060,6 +1109,7 @@ nffs_restore_area_contents(int area_idx)
              * XXX Deal with file system corruption
              */
             if (rc == FS_ECORRUPT) {
+                nffs_restore_area_corrupt(area, &corrupt);
                 area->na_cur++;
             } else {
                 STATS_INC(nffs_stats, nffs_object_count); /* restored objects */
@@ -1072,12 +1122,18 @@ nffs_restore_area_contents(int area_idx)
              * Invalid object; keep scanning for a valid object ID and CRC
              * Can nffs_restore_disk_object return FS_ECORRUPT? XXX
              */
+            nffs_restore_area_corrupt(area, &corrupt);
             area->na_cur++;
             break;
 
         case FS_EEMPTY:
         case FS_EOFFSET:
             /* End of disk encountered; area fully restored. */
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+            if (!corrupt) {
+                area->na_verified = area->na_cur;
+            }
+#endif
             return 0;
 
         default:
@@ -1158,7 +1214,7 @@ nffs_restore_corrupt_scratch(void)
     }
 
     /* Invalidate all objects resident in the bad area. */
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    for (i = 0; i < nffs_hash_size; i++) {
         entry = SLIST_FIRST(&nffs_hash[i]);
         while (entry != NULL) {
             next = SLIST_NEXT(entry, nhe_next);
@@ -1202,7 +1258,8 @@ nffs_restore_corrupt_scratch(void)
 static void
 nffs_log_contents(void)
 {
-#if MYNEWT_VAL(LOG_LEVEL) > LOG_LEVEL_DEBUG
+#if MYNEWT_VAL(LOG_LEVEL) > LOG_LEVEL_DEBUG || \
+    MYNEWT_VAL(LOG_LEVEL_NFFS) > LOG_LEVEL_DEBUG
     return;
 #endif
 
@@ -1349,6 +1406,8 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
             nffs_areas[cur_area_idx].na_flash_id = area_descs[i].nad_flash_id;
             nffs_areas[cur_area_idx].na_gc_seq = disk_area.nda_gc_seq;
             nffs_areas[cur_area_idx].na_id = disk_area.nda_id;
+            nffs_areas[cur_area_idx].na_erase_cnt = 0;
+            nffs_areas[cur_area_idx].na_tombstones = 0;
 
             if (disk_area.nda_id == NFFS_AREA_ID_NONE) {
                 nffs_areas[cur_area_idx].na_cur = NFFS_AREA_OFFSET_ID;
@@ -1356,12 +1415,28 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
             } else {
                 nffs_areas[cur_area_idx].na_cur =
                     sizeof (struct nffs_disk_area);
-                nffs_restore_area_contents(cur_area_idx);
             }
         }
     }
 
-    /* All areas have been restored from flash. */
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    /* Determine how much of each area a checkpoint vouches for before any
+     * contents are read.
+     */
+    nffs_ckpt_restore();
+#endif
+
+    /* Populate RAM with a representation of each area's contents. */
+    for (i = 0; i < nffs_num_areas; i++) {
+        if (i != nffs_scratch_area_idx) {
+            nffs_restore_area_contents(i);
+        }
+    }
+
+    /* All areas have been restored from flash.  Now that the number of
+     * objects is known, size the hash table.
+     */
+    nffs_hash_grow();
 
     if (nffs_scratch_area_idx == NFFS_AREA_ID_NONE) {
         /* No scratch area.  The system may have been rebooted in the middle of
@@ -1399,6 +1474,13 @@ nffs_restore_full(const struct nffs_area_desc *area_descs)
      */
     nffs_restore_sweep();
 
+#if MYNEWT_VAL(NFFS_DIR_INDEX_ENTRIES) > 0
+    /* Directories may have been indexed while their contents were still
+     * being reconstructed, e.g., while creating lost+found entries.
+     */
+    nffs_dirindex_reset();
+#endif
+
     /* Set the maximum data block size according to the size of the smallest
      * area.
      */
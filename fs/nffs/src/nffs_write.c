@@ -18,6 +18,7 @@
  */
 
 #include <assert.h>
+#include <string.h>
 #include "testutil/testutil.h"
 #include "nffs/nffs.h"
 #include "nffs_priv.h"
@@ -371,6 +372,136 @@ nffs_write_chunk(struct nffs_inode_entry *inode_entry, uint32_t file_offset,
     return 0;
 }
 
+/**
+ * Writes data to a file at the file's current offset, as a sequence of
+ * blocks no larger than the maximum block size.
+ */
+static int
+nffs_write_blocks(struct nffs_file *file, const uint8_t *data, int len)
+{
+    uint16_t chunk_size;
+    int rc;
+
+    while (len > 0) {
+        if (len > nffs_block_max_data_sz) {
+            chunk_size = nffs_block_max_data_sz;
+        } else {
+            chunk_size = len;
+        }
+
+        rc = nffs_write_chunk(file->nf_inode_entry, file->nf_offset, data,
+                              chunk_size);
+        if (rc != 0) {
+            return rc;
+        }
+
+        len -= chunk_size;
+        data += chunk_size;
+        file->nf_offset += chunk_size;
+    }
+
+    return 0;
+}
+
+/**
+ * Writes any data held in the specified file's write-back buffer to flash.
+ * This must be done before the file's position or contents are inspected
+ * through the same handle.
+ *
+ * @param file                  The file to flush.
+ *
+ * @return                      0 on success; nonzero on failure.  On
+ *                                  failure, the buffered data is discarded.
+ */
+int
+nffs_write_flush(struct nffs_file *file)
+{
+#if MYNEWT_VAL(NFFS_WRITE_BUF_SIZE) > 0
+    struct nffs_cache_inode *cache_inode;
+    uint16_t len;
+    int rc;
+
+    if (file->nf_wbuf_len == 0) {
+        return 0;
+    }
+
+    len = file->nf_wbuf_len;
+    file->nf_wbuf_len = 0;
+
+    /* The append flag forces all writes to the end of the file, even if
+     * another handle has extended the file since this data was buffered.
+     */
+    if (file->nf_access_flags & FS_ACCESS_APPEND) {
+        rc = nffs_cache_inode_ensure(&cache_inode, file->nf_inode_entry);
+        if (rc != 0) {
+            return rc;
+        }
+        file->nf_offset = cache_inode->nci_file_size;
+    } else {
+        file->nf_offset -= len;
+    }
+
+    STATS_INC(nffs_stats, nffs_wbufcnt_flush);
+    rc = nffs_write_blocks(file, file->nf_wbuf, len);
+    if (rc != 0) {
+        return rc;
+    }
+#endif
+
+    return 0;
+}
+
+#if MYNEWT_VAL(NFFS_WRITE_BUF_SIZE) > 0
+/**
+ * Attempts to add data to a file's write-back buffer.  Only writes that
+ * extend the file are buffered, since they can be combined into a single
+ * block later.  If the data does not fit, the buffer is flushed first.
+ *
+ * @param out_buffered          On success, indicates whether the data was
+ *                                  buffered (1) or must be written
+ *                                  directly (0).
+ *
+ * @return                      0 on success; nonzero on flush failure.
+ */
+static int
+nffs_write_buffer(struct nffs_file *file,
+                  const struct nffs_cache_inode *cache_inode,
+                  const void *data, int len, int *out_buffered)
+{
+    int rc;
+
+    *out_buffered = 0;
+
+    if (file->nf_offset != cache_inode->nci_file_size + file->nf_wbuf_len) {
+        /* Overwrite; write through. */
+        return nffs_write_flush(file);
+    }
+
+    if (file->nf_wbuf_len + len > MYNEWT_VAL(NFFS_WRITE_BUF_SIZE)) {
+        rc = nffs_write_flush(file);
+        if (rc != 0) {
+            return rc;
+        }
+
+        if (len >= MYNEWT_VAL(NFFS_WRITE_BUF_SIZE)) {
+            return 0;
+        }
+    }
+
+    memcpy(file->nf_wbuf + file->nf_wbuf_len, data, len);
+    file->nf_wbuf_len += len;
+    file->nf_offset += len;
+    *out_buffered = 1;
+    STATS_INC(nffs_stats, nffs_wbufcnt_write);
+
+    if (file->nf_wbuf_len == MYNEWT_VAL(NFFS_WRITE_BUF_SIZE)) {
+        return nffs_write_flush(file);
+    }
+
+    return 0;
+}
+#endif
+
 /**
  * Writes a chunk of contiguous data to a file.
  *
@@ -384,8 +515,9 @@ int
 nffs_write_to_file(struct nffs_file *file, const void *data, int len)
 {
     struct nffs_cache_inode *cache_inode;
-    const uint8_t *data_ptr;
-    uint16_t chunk_size;
+#if MYNEWT_VAL(NFFS_WRITE_BUF_SIZE) > 0
+    int buffered;
+#endif
     int rc;
 
     if (!(file->nf_access_flags & FS_ACCESS_WRITE)) {
@@ -406,27 +538,18 @@ nffs_write_to_file(struct nffs_file *file, const void *data, int len)
      */
     if (file->nf_access_flags & FS_ACCESS_APPEND) {
         file->nf_offset = cache_inode->nci_file_size;
+#if MYNEWT_VAL(NFFS_WRITE_BUF_SIZE) > 0
+        file->nf_offset += file->nf_wbuf_len;
+#endif
     }
 
-    /* Write data as a sequence of blocks. */
-    data_ptr = data;
-    while (len > 0) {
-        if (len > nffs_block_max_data_sz) {
-            chunk_size = nffs_block_max_data_sz;
-        } else {
-            chunk_size = len;
-        }
-
-        rc = nffs_write_chunk(file->nf_inode_entry, file->nf_offset, data_ptr,
-                              chunk_size);
-        if (rc != 0) {
-            return rc;
-        }
-
-        len -= chunk_size;
-        data_ptr += chunk_size;
-        file->nf_offset += chunk_size;
+#if MYNEWT_VAL(NFFS_WRITE_BUF_SIZE) > 0
+    rc = nffs_write_buffer(file, cache_inode, data, len, &buffered);
+    if (rc != 0 || buffered) {
+        return rc;
     }
+#endif
 
-    return 0;
+    /* Write data as a sequence of blocks. */
+    return nffs_write_blocks(file, data, len);
 }
@@ -89,6 +89,7 @@ TEST_CASE_DECL(nffs_test_rename)
 TEST_CASE_DECL(nffs_test_truncate)
 TEST_CASE_DECL(nffs_test_append)
 TEST_CASE_DECL(nffs_test_read)
+TEST_CASE_DECL(nffs_test_read_mbuf)
 TEST_CASE_DECL(nffs_test_open)
 TEST_CASE_DECL(nffs_test_overwrite_one)
 TEST_CASE_DECL(nffs_test_overwrite_two)
@@ -106,8 +107,25 @@ TEST_CASE_DECL(nffs_test_large_unlink)
 TEST_CASE_DECL(nffs_test_large_system)
 TEST_CASE_DECL(nffs_test_lost_found)
 TEST_CASE_DECL(nffs_test_readdir)
+TEST_CASE_DECL(nffs_test_readdir_snapshot)
 TEST_CASE_DECL(nffs_test_split_file)
 TEST_CASE_DECL(nffs_test_gc_on_oom)
+TEST_CASE_DECL(nffs_test_gc_step)
+#if MYNEWT_VAL(NFFS_DIR_INDEX_ENTRIES) > 0
+TEST_CASE_DECL(nffs_test_dir_index)
+#endif
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+TEST_CASE_DECL(nffs_test_checkpoint)
+#endif
+#if NFFS_HASH_MAX_SIZE > NFFS_HASH_SIZE
+TEST_CASE_DECL(nffs_test_hash_grow)
+#endif
+#if MYNEWT_VAL(NFFS_WRITE_BUF_SIZE) > 0
+TEST_CASE_DECL(nffs_test_write_buf)
+#endif
+#if MYNEWT_VAL(NFFS_FLASH_MAP)
+TEST_CASE_DECL(nffs_test_flash_map)
+#endif
 
 void
 nffs_test_suite_gen_1_1_init(void)
@@ -155,6 +173,7 @@ TEST_SUITE(nffs_test_suite)
     nffs_test_truncate();
     nffs_test_append();
     nffs_test_read();
+    nffs_test_read_mbuf();
     nffs_test_open();
     nffs_test_overwrite_one();
     nffs_test_overwrite_two();
@@ -172,11 +191,31 @@ TEST_SUITE(nffs_test_suite)
     nffs_test_large_system();
     nffs_test_lost_found();
     nffs_test_readdir();
+    nffs_test_readdir_snapshot();
     nffs_test_split_file();
     nffs_test_gc_on_oom();
+    nffs_test_gc_step();
+#if MYNEWT_VAL(NFFS_DIR_INDEX_ENTRIES) > 0
+    nffs_test_dir_index();
+#endif
+#if MYNEWT_VAL(NFFS_CHECKPOINT)
+    nffs_test_checkpoint();
+#endif
+#if NFFS_HASH_MAX_SIZE > NFFS_HASH_SIZE
+    nffs_test_hash_grow();
+#endif
+#if MYNEWT_VAL(NFFS_WRITE_BUF_SIZE) > 0
+    nffs_test_write_buf();
+#endif
+#if MYNEWT_VAL(NFFS_FLASH_MAP)
+    nffs_test_flash_map();
+#endif
 }
 
 TEST_CASE_DECL(nffs_test_cache_large_file)
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+TEST_CASE_DECL(nffs_test_cache_read_ahead)
+#endif
 
 TEST_SUITE(nffs_suite_cache)
 {
@@ -186,6 +225,9 @@ TEST_SUITE(nffs_suite_cache)
     TEST_ASSERT(rc == 0);
 
     nffs_test_cache_large_file();
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+    nffs_test_cache_read_ahead();
+#endif
 }
 
 void
@@ -406,12 +448,6 @@ print_nffs_flash_areas(int verbose)
     }
 }
 
-static int
-nffs_hash_fn(uint32_t id)
-{
-    return id % NFFS_HASH_SIZE;
-}
-
 void
 print_hashlist(struct nffs_hash_entry *he)
 {
@@ -687,7 +723,7 @@ print_hash_entries(int verbose)
     struct nffs_hash_entry *next;
 
     printf("\nnffs_hash_entries:\n");
-    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+    for (i = 0; i < nffs_hash_size; i++) {
         he = SLIST_FIRST(nffs_hash + i);
         while (he != NULL) {
             next = SLIST_NEXT(he, nhe_next);
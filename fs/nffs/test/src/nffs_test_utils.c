@@ -244,6 +244,11 @@ nffs_test_util_create_file_blocks(const char *filename,
     for (i = 0; i < num_writes; i++) {
         rc = fs_write(file, blocks[i].data, blocks[i].data_len);
         TEST_ASSERT(rc == 0);
+#if MYNEWT_VAL(NFFS_WRITE_BUF_SIZE) > 0
+        /* Keep each write in a block of its own. */
+        rc = nffs_flush(file);
+        TEST_ASSERT(rc == 0);
+#endif
 
         total_len += blocks[i].data_len;
     }
@@ -27,6 +27,10 @@ TEST_CASE(nffs_test_cache_large_file)
     int rc;
 
     /*** Setup. */
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+    /* Read-ahead changes which blocks get cached. */
+    nffs_cache_read_ahead_max = 0;
+#endif
     rc = nffs_format(nffs_current_area_descs);
     TEST_ASSERT(rc == 0);
 
@@ -86,4 +90,8 @@ TEST_CASE(nffs_test_cache_large_file)
 
     rc = fs_close(file);
     TEST_ASSERT(rc == 0);
+
+#if MYNEWT_VAL(NFFS_CACHE_READ_AHEAD) > 0
+    nffs_cache_read_ahead_max = MYNEWT_VAL(NFFS_CACHE_READ_AHEAD);
+#endif
 }
@@ -0,0 +1,96 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include "nffs_test_utils.h"
+
+TEST_CASE(nffs_test_checkpoint)
+{
+    uint32_t crc_skip;
+    int rc;
+
+    static const struct nffs_area_desc area_descs_two[] = {
+        { 0x00020000, 128 * 1024 },
+        { 0x00040000, 128 * 1024 },
+        { 0, 0 },
+    };
+
+    /*** Setup. */
+    rc = nffs_format(area_descs_two);
+    TEST_ASSERT(rc == 0);
+
+    rc = fs_mkdir("/mydir");
+    TEST_ASSERT(rc == 0);
+    nffs_test_util_create_file("/mydir/a.txt", "aaaa", 4);
+
+    rc = nffs_checkpoint();
+    TEST_ASSERT(rc == 0);
+
+    /* Objects written after the checkpoint must still be restored. */
+    nffs_test_util_create_file("/mydir/b.txt", "bbbbbb", 6);
+
+    /*** Objects covered by the checkpoint skip CRC validation. */
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+
+    crc_skip = nffs_stats.snffs_ckptcnt_crc_skip;
+    rc = nffs_detect(area_descs_two);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(nffs_stats.snffs_ckptcnt_crc_skip > crc_skip);
+
+    struct nffs_test_file_desc *expected_system =
+        (struct nffs_test_file_desc[]) { {
+            .filename = "",
+            .is_dir = 1,
+            .children = (struct nffs_test_file_desc[]) { {
+                .filename = "mydir",
+                .is_dir = 1,
+                .children = (struct nffs_test_file_desc[]) { {
+                    .filename = "a.txt",
+                    .contents = "aaaa",
+                    .contents_len = 4,
+                }, {
+                    .filename = "b.txt",
+                    .contents = "bbbbbb",
+                    .contents_len = 6,
+                }, {
+                    .filename = NULL,
+                } },
+            }, {
+                .filename = NULL,
+            } },
+    } };
+
+    nffs_test_assert_system(expected_system, area_descs_two);
+
+    /*** Garbage collection discards the checkpoint. */
+    rc = nffs_checkpoint();
+    TEST_ASSERT(rc == 0);
+
+    rc = nffs_gc(NULL);
+    TEST_ASSERT(rc == 0);
+
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+
+    rc = nffs_detect(area_descs_two);
+    TEST_ASSERT(rc == 0);
+
+    nffs_test_assert_system(expected_system, area_descs_two);
+}
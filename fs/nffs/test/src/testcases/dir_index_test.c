@@ -0,0 +1,106 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+#include "nffs_test_utils.h"
+
+#if MYNEWT_VAL(NFFS_DIR_INDEX_ENTRIES) > 0
+
+TEST_CASE(nffs_test_dir_index)
+{
+    struct nffs_inode_entry *inode_entry;
+    struct fs_file *file;
+    uint32_t inode_reads;
+    uint32_t builds;
+    char filename[64];
+    int num_files;
+    int rc;
+    int i;
+
+    /*** Setup. */
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+
+    num_files = MYNEWT_VAL(NFFS_DIR_INDEX_MIN_CHILDREN) + 4;
+    if (num_files > MYNEWT_VAL(NFFS_DIR_INDEX_ENTRIES)) {
+        num_files = MYNEWT_VAL(NFFS_DIR_INDEX_ENTRIES);
+    }
+
+    builds = nffs_stats.snffs_dindexcnt_build;
+    rc = fs_mkdir("/dir");
+    TEST_ASSERT(rc == 0);
+    for (i = 0; i < num_files; i++) {
+        snprintf(filename, sizeof filename, "/dir/file_with_long_name_%d", i);
+        nffs_test_util_create_file(filename, "x", 1);
+    }
+
+    /* The directory got indexed once it was large enough. */
+    TEST_ASSERT(nffs_stats.snffs_dindexcnt_build > builds);
+    builds = nffs_stats.snffs_dindexcnt_build;
+    rc = nffs_path_find_inode_entry("/dir/file_with_long_name_0",
+                                    &inode_entry);
+    TEST_ASSERT(rc == 0);
+
+    /* Subsequent lookups read only the matching inode. */
+    inode_reads = nffs_stats.snffs_readcnt_inode;
+    snprintf(filename, sizeof filename, "/dir/file_with_long_name_%d",
+             num_files - 1);
+    rc = nffs_path_find_inode_entry(filename, &inode_entry);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(nffs_stats.snffs_readcnt_inode - inode_reads <= 2);
+
+    /* Misses do not need to read any inodes. */
+    inode_reads = nffs_stats.snffs_readcnt_inode;
+    rc = nffs_path_find_inode_entry("/dir/nonexistent", &inode_entry);
+    TEST_ASSERT(rc == FS_ENOENT);
+    TEST_ASSERT(nffs_stats.snffs_readcnt_inode - inode_reads <= 1);
+
+    /* The index tracks additions, removals, and renames. */
+    nffs_test_util_create_file("/dir/new", "y", 1);
+    rc = fs_unlink("/dir/file_with_long_name_1");
+    TEST_ASSERT(rc == 0);
+    rc = fs_rename("/dir/file_with_long_name_2", "/dir/renamed");
+    TEST_ASSERT(rc == 0);
+
+    rc = fs_open("/dir/new", FS_ACCESS_READ, &file);
+    TEST_ASSERT(rc == 0);
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+    rc = fs_open("/dir/renamed", FS_ACCESS_READ, &file);
+    TEST_ASSERT(rc == 0);
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+    rc = nffs_path_find_inode_entry("/dir/file_with_long_name_1",
+                                    &inode_entry);
+    TEST_ASSERT(rc == FS_ENOENT);
+    rc = nffs_path_find_inode_entry("/dir/file_with_long_name_2",
+                                    &inode_entry);
+    TEST_ASSERT(rc == FS_ENOENT);
+
+    /* None of this required rebuilding the index. */
+    TEST_ASSERT(nffs_stats.snffs_dindexcnt_build == builds);
+
+    for (i = 3; i < num_files; i++) {
+        snprintf(filename, sizeof filename, "/dir/file_with_long_name_%d", i);
+        nffs_test_util_assert_contents(filename, "x", 1);
+    }
+}
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+#if MYNEWT_VAL(NFFS_FLASH_MAP)
+
+TEST_CASE(nffs_test_flash_map)
+{
+    static char data[3 * NFFS_FLASH_BUF_SZ + 17];
+    struct fs_file *file;
+    uint32_t mapped;
+    uint32_t reads;
+    int rc;
+    int i;
+
+    /*** Setup. */
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+
+    /* The simulated flash is memory mapped. */
+    TEST_ASSERT(nffs_flash_map(0, 0, 16) != NULL);
+    TEST_ASSERT(nffs_flash_map(0, nffs_areas[0].na_length, 1) == NULL);
+
+    for (i = 0; i < sizeof data; i++) {
+        data[i] = i * 7;
+    }
+    nffs_test_util_create_file("/myfile.txt", data, sizeof data);
+
+    /*** Overwriting the middle of a block copies and checksums the old
+     * contents in place.
+     */
+    mapped = nffs_stats.snffs_readcnt_mapped;
+    reads = nffs_stats.snffs_readcnt_copy + nffs_stats.snffs_readcnt_crc;
+
+    rc = fs_open("/myfile.txt", FS_ACCESS_WRITE, &file);
+    TEST_ASSERT(rc == 0);
+    rc = fs_seek(file, NFFS_FLASH_BUF_SZ + 3);
+    TEST_ASSERT(rc == 0);
+    rc = fs_write(file, "abcd", 4);
+    TEST_ASSERT(rc == 0);
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+    memcpy(data + NFFS_FLASH_BUF_SZ + 3, "abcd", 4);
+
+    TEST_ASSERT(nffs_stats.snffs_readcnt_mapped > mapped);
+    TEST_ASSERT(nffs_stats.snffs_readcnt_copy + nffs_stats.snffs_readcnt_crc ==
+                reads);
+    nffs_test_util_assert_contents("/myfile.txt", data, sizeof data);
+
+    /*** Restore validates block CRCs in place. */
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+
+    mapped = nffs_stats.snffs_readcnt_mapped;
+    rc = nffs_detect(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(nffs_stats.snffs_readcnt_mapped > mapped);
+    nffs_test_util_assert_contents("/myfile.txt", data, sizeof data);
+}
+
+#endif
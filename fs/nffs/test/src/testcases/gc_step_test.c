@@ -0,0 +1,117 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+#include "nffs_test_utils.h"
+
+TEST_CASE(nffs_test_gc_step)
+{
+    static const struct nffs_area_desc area_descs_three[] = {
+        { 0x00000000, 16 * 1024 },
+        { 0x00004000, 16 * 1024 },
+        { 0x00008000, 16 * 1024 },
+        { 0, 0 },
+    };
+    static char data[2 * 1024];
+    struct nffs_area_info info;
+    unsigned int gc_count;
+    uint32_t erase_cnt;
+    uint32_t from_cur;
+    uint8_t from_idx;
+    int pending;
+    int steps;
+    int rc;
+    int i;
+
+    /*** Setup. */
+    rc = nffs_format(area_descs_three);
+    TEST_ASSERT(rc == 0);
+
+    /* Nothing to do while there is plenty of free space. */
+    rc = nffs_gc_step(&pending);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!pending);
+
+    /* Repeatedly rewrite a file until free space drops below the background
+     * threshold.  Every previous version of the file is garbage.
+     */
+    for (i = 0; i < 12; i++) {
+        memset(data, i, sizeof data);
+        nffs_test_util_create_file("/myfile.txt", data, sizeof data);
+    }
+    gc_count = nffs_gc_count;
+
+    /* The first step starts a cycle without completing it. */
+    rc = nffs_gc_step(&pending);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(pending);
+    TEST_ASSERT(nffs_gc_count == gc_count);
+
+    /* Finish the scan so that a source area is selected. */
+    while (nffs_gc_from_area_idx == NFFS_AREA_ID_NONE) {
+        rc = nffs_gc_step(&pending);
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT(pending);
+    }
+    from_idx = nffs_gc_from_area_idx;
+    rc = nffs_area_info(from_idx, &info);
+    TEST_ASSERT(rc == 0);
+    erase_cnt = info.nai_erase_cnt;
+
+    /* Writes during the cycle do not go to the source area. */
+    from_cur = nffs_areas[from_idx].na_cur;
+    nffs_test_util_create_file("/other.txt", "abc", 3);
+    TEST_ASSERT(nffs_areas[from_idx].na_cur == from_cur);
+
+    /* Each step processes a bounded number of hash buckets. */
+    steps = 0;
+    while (pending) {
+        rc = nffs_gc_step(&pending);
+        TEST_ASSERT(rc == 0);
+        steps++;
+    }
+    TEST_ASSERT(steps > 1);
+    TEST_ASSERT(nffs_gc_count == gc_count + 1);
+    TEST_ASSERT(nffs_scratch_area_idx == from_idx);
+
+    rc = nffs_area_info(from_idx, &info);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(info.nai_is_scratch);
+    TEST_ASSERT(info.nai_erase_cnt == erase_cnt + 1);
+
+    struct nffs_test_file_desc *expected_system =
+        (struct nffs_test_file_desc[]) { {
+            .filename = "",
+            .is_dir = 1,
+            .children = (struct nffs_test_file_desc[]) { {
+                .filename = "myfile.txt",
+                .contents = data,
+                .contents_len = sizeof data,
+            }, {
+                .filename = "other.txt",
+                .contents = "abc",
+                .contents_len = 3,
+            }, {
+                .filename = NULL,
+            } },
+    } };
+
+    nffs_test_assert_system(expected_system, area_descs_three);
+}
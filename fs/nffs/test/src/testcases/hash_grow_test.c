@@ -0,0 +1,56 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include "nffs_test_utils.h"
+
+TEST_CASE(nffs_test_hash_grow)
+{
+    struct fs_file *file;
+    char filename[32];
+    int rc;
+    int i;
+
+    /*** Setup. */
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(nffs_hash_size == NFFS_HASH_SIZE);
+
+    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+        snprintf(filename, sizeof filename, "/f%d", i);
+        nffs_test_util_create_file(filename, "x", 1);
+    }
+
+    /*** Restore; the table grows to hold the file inodes and blocks. */
+    rc = nffs_misc_reset();
+    TEST_ASSERT(rc == 0);
+
+    rc = nffs_detect(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(nffs_hash_size > NFFS_HASH_SIZE);
+    TEST_ASSERT(nffs_hash_size <= NFFS_HASH_MAX_SIZE);
+
+    for (i = 0; i < NFFS_HASH_SIZE; i++) {
+        snprintf(filename, sizeof filename, "/f%d", i);
+        rc = fs_open(filename, FS_ACCESS_READ, &file);
+        TEST_ASSERT_FATAL(rc == 0);
+        rc = fs_close(file);
+        TEST_ASSERT(rc == 0);
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/os.h"
+#include "nffs_test_utils.h"
+
+#define NFFS_TEST_MBUF_BUF_SZ   16
+#define NFFS_TEST_MBUF_COUNT    16
+#define NFFS_TEST_MBUF_MEMBLOCK_SZ \
+    (NFFS_TEST_MBUF_BUF_SZ + sizeof (struct os_mbuf) + \
+     sizeof (struct os_mbuf_pkthdr))
+
+static os_membuf_t nffs_test_mbuf_mem[
+    OS_MEMPOOL_SIZE(NFFS_TEST_MBUF_COUNT, NFFS_TEST_MBUF_MEMBLOCK_SZ)];
+
+TEST_CASE(nffs_test_read_mbuf)
+{
+    struct os_mbuf_pool mbuf_pool;
+    struct os_mempool mempool;
+    struct fs_file *file;
+    struct os_mbuf *om;
+    uint8_t data[40];
+    uint8_t buf[40];
+    uint32_t bytes_read;
+    int rc;
+    int i;
+
+    rc = os_mempool_init(&mempool, NFFS_TEST_MBUF_COUNT,
+                         NFFS_TEST_MBUF_MEMBLOCK_SZ, nffs_test_mbuf_mem,
+                         "nffs_test_mbuf");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(&mbuf_pool, &mempool, NFFS_TEST_MBUF_MEMBLOCK_SZ,
+                           NFFS_TEST_MBUF_COUNT);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+
+    for (i = 0; i < sizeof data; i++) {
+        data[i] = i;
+    }
+
+    /* Write a file from a chain spanning several mbufs. */
+    om = os_mbuf_get_pkthdr(&mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, data, sizeof data);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(SLIST_NEXT(om, om_next) != NULL);
+
+    rc = fs_open("/myfile.bin", FS_ACCESS_WRITE, &file);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = fs_write_mbuf(file, om);
+    TEST_ASSERT(rc == 0);
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+    os_mbuf_free_chain(om);
+
+    /* Append part of the file to a chain that already holds data. */
+    rc = fs_open("/myfile.bin", FS_ACCESS_READ, &file);
+    TEST_ASSERT_FATAL(rc == 0);
+    nffs_test_util_assert_file_len(file, sizeof data);
+
+    rc = fs_seek(file, 3);
+    TEST_ASSERT(rc == 0);
+
+    om = os_mbuf_get_pkthdr(&mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, "ab", 2);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = fs_read_mbuf(file, 30, om, &bytes_read);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(bytes_read == 30);
+    TEST_ASSERT(fs_getpos(file) == 33);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 32);
+
+    rc = os_mbuf_copydata(om, 0, 32, buf);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(memcmp(buf, "ab", 2) == 0);
+    TEST_ASSERT(memcmp(buf + 2, data + 3, 30) == 0);
+
+    /* Reading past the end returns only what is left. */
+    rc = fs_read_mbuf(file, 30, om, &bytes_read);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(bytes_read == sizeof data - 33);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 32 + sizeof data - 33);
+    rc = os_mbuf_copydata(om, 32, sizeof data - 33, buf);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(memcmp(buf, data + 33, sizeof data - 33) == 0);
+
+    os_mbuf_free_chain(om);
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+}
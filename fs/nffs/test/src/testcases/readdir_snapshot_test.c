@@ -0,0 +1,81 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "nffs_test_utils.h"
+
+#define NFFS_TEST_LONG_NAME \
+    "a_filename_longer_than_the_dirent_name_snapshot"
+
+TEST_CASE(nffs_test_readdir_snapshot)
+{
+    struct fs_dirent *dirent;
+    struct fs_dir *dir;
+    char name[8];
+    uint8_t name_len;
+    uint32_t len;
+    int rc;
+
+    /*** Setup. */
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = fs_mkdir("/mydir");
+    TEST_ASSERT_FATAL(rc == 0);
+
+    nffs_test_util_create_file("/mydir/" NFFS_TEST_LONG_NAME,
+                               "0123456789", 10);
+    nffs_test_util_create_file("/mydir/b", "bbbb", 4);
+    rc = fs_mkdir("/mydir/c");
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = fs_opendir("/mydir", &dir);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Long name is read from flash; size comes from the snapshot. */
+    rc = fs_readdir(dir, &dirent);
+    TEST_ASSERT_FATAL(rc == 0);
+    nffs_test_util_assert_ent_name(dirent, NFFS_TEST_LONG_NAME);
+    rc = fs_dirent_size(dirent, &len);
+    TEST_ASSERT(rc == 0 && len == 10);
+
+    /* Truncated copy into a short buffer. */
+    rc = fs_dirent_name(dirent, sizeof name, name, &name_len);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(name_len == strlen(NFFS_TEST_LONG_NAME));
+    TEST_ASSERT(strcmp(name, "a_filen") == 0);
+
+    rc = fs_readdir(dir, &dirent);
+    TEST_ASSERT_FATAL(rc == 0);
+    nffs_test_util_assert_ent_name(dirent, "b");
+    rc = fs_dirent_size(dirent, &len);
+    TEST_ASSERT(rc == 0 && len == 4);
+
+    rc = fs_readdir(dir, &dirent);
+    TEST_ASSERT_FATAL(rc == 0);
+    nffs_test_util_assert_ent_name(dirent, "c");
+    TEST_ASSERT(fs_dirent_is_dir(dirent) == 1);
+    rc = fs_dirent_size(dirent, &len);
+    TEST_ASSERT(rc == 0 && len == 0);
+
+    rc = fs_readdir(dir, &dirent);
+    TEST_ASSERT(rc == FS_ENOENT);
+
+    rc = fs_closedir(dir);
+    TEST_ASSERT(rc == 0);
+}
@@ -0,0 +1,111 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+
+#include "nffs_test_utils.h"
+
+#if MYNEWT_VAL(NFFS_WRITE_BUF_SIZE) > 0
+
+TEST_CASE(nffs_test_write_buf)
+{
+    static char data[MYNEWT_VAL(NFFS_WRITE_BUF_SIZE)];
+    static char expected[sizeof data + 20];
+    struct fs_file *file;
+    uint32_t flushes;
+    uint32_t len;
+    uint8_t b;
+    int rc;
+    int i;
+
+    /*** Setup. */
+    rc = nffs_format(nffs_current_area_descs);
+    TEST_ASSERT(rc == 0);
+
+    for (i = 0; i < sizeof data; i++) {
+        data[i] = i;
+    }
+
+    rc = fs_open("/myfile.txt", FS_ACCESS_WRITE | FS_ACCESS_APPEND, &file);
+    TEST_ASSERT(rc == 0);
+
+    /* Small appends stay in RAM until the buffer fills. */
+    flushes = nffs_stats.snffs_wbufcnt_flush;
+    for (i = 0; i < sizeof data - 1; i++) {
+        rc = fs_write(file, data + i, 1);
+        TEST_ASSERT(rc == 0);
+    }
+    TEST_ASSERT(nffs_stats.snffs_wbufcnt_flush == flushes);
+    nffs_test_util_assert_file_len(file, sizeof data - 1);
+
+    /* Filling the buffer writes a single block. */
+    rc = fs_write(file, data + i, 1);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(nffs_stats.snffs_wbufcnt_flush == flushes + 1);
+    nffs_test_util_assert_block_count("/myfile.txt", 1);
+
+    memcpy(expected, data, sizeof data);
+    memcpy(expected + sizeof data, data, 10);
+    memcpy(expected + sizeof data + 10, data, 10);
+
+    /* Closing flushes a partial buffer. */
+    rc = fs_write(file, data, 10);
+    TEST_ASSERT(rc == 0);
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+    nffs_test_util_assert_block_count("/myfile.txt", 2);
+
+    rc = fs_open("/myfile.txt", FS_ACCESS_READ | FS_ACCESS_WRITE, &file);
+    TEST_ASSERT(rc == 0);
+    rc = fs_seek(file, sizeof data + 10);
+    TEST_ASSERT(rc == 0);
+
+    /* The file length includes buffered data. */
+    flushes = nffs_stats.snffs_wbufcnt_flush;
+    rc = fs_write(file, data, 5);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(nffs_stats.snffs_wbufcnt_flush == flushes);
+    nffs_test_util_assert_file_len(file, sizeof data + 15);
+    TEST_ASSERT(fs_getpos(file) == sizeof data + 15);
+
+    /* Reading flushes the buffer first. */
+    rc = fs_read(file, 1, &b, &len);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(len == 0);
+    TEST_ASSERT(nffs_stats.snffs_wbufcnt_flush == flushes + 1);
+    nffs_test_util_assert_block_count("/myfile.txt", 3);
+
+    /* So does seeking. */
+    rc = fs_write(file, data + 5, 5);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(nffs_stats.snffs_wbufcnt_flush == flushes + 1);
+    rc = fs_seek(file, 0);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(nffs_stats.snffs_wbufcnt_flush == flushes + 2);
+    nffs_test_util_assert_block_count("/myfile.txt", 4);
+    nffs_test_util_assert_file_len(file, sizeof expected);
+
+    rc = fs_close(file);
+    TEST_ASSERT(rc == 0);
+
+    nffs_test_util_assert_contents("/myfile.txt", expected,
+                                   sizeof expected);
+}
+
+#endif
@@ -22,6 +22,7 @@
 #include <string.h>
 #include <inttypes.h>
 #include <bsp/bsp.h>
+#include "syscfg/syscfg.h"
 #include "sysflash/sysflash.h"
 #include "os/os.h"
 #include "hal/hal_flash_int.h"
@@ -37,12 +38,18 @@ const struct hal_flash *
 hal_bsp_flash_dev(uint8_t id)
 {
     /*
-     * Just one to start with
+     * Internal flash mapped to id 0, optional external flash to id 1.
      */
-    if (id != 0) {
+    switch (id) {
+    case 0:
+        return &native_flash_dev;
+#if MYNEWT_VAL(NATIVE_FLASH_EXT_SIZE) > 0
+    case 1:
+        return &native_flash_ext_dev;
+#endif
+    default:
         return NULL;
     }
-    return &native_flash_dev;
 }
 
 int
@@ -59,6 +59,12 @@ struct stm32f4_adc_dev_cfg {
     void *secondarybuf;
     int buflen;
     ADC_HandleTypeDef *sac_adc_handle;
+    /*
+     * Continuous sampling state, managed by the driver. The DMA stream is
+     * run in double buffer mode, so its handle must be set up circular.
+     */
+    uint8_t sac_continuous;
+    uint8_t sac_buf_held;       /* buffers given to app, not yet released */
 };
 
 int stm32f4_adc_dev_init(struct os_dev *, void *);
@@ -29,6 +29,7 @@
 #include "stm32f4xx_hal.h"
 #include "adc_stm32f4/adc_stm32f4.h"
 #include "stm32f4xx_hal_dma.h"
+#include "stm32f4xx_hal_dma_ex.h"
 #include "mcu/stm32f4xx_mynewt_hal.h"
 #include "syscfg/syscfg.h"
 
@@ -50,6 +51,7 @@ struct stm32f4_adc_stats {
     uint16_t adc_dma_start_error;
     uint16_t adc_dma_overrun;
     uint16_t adc_internal_error;
+    uint16_t adc_buf_overrun;
 };
 
 static struct stm32f4_adc_stats stm32f4_adc_stats;
@@ -349,6 +351,84 @@ HAL_ADC_ConvCpltCallback(ADC_HandleTypeDef *hadc)
     }
 }
 
+/*
+ * Continuous sampling. DMA runs in double buffer mode, memory 0 being the
+ * primary buffer and memory 1 the secondary one.
+ */
+static void
+stm32f4_adc_cont_event(DMA_HandleTypeDef *hdma, int idx, int half)
+{
+    struct adc_dev *adc;
+    struct stm32f4_adc_dev_cfg *cfg;
+    void *buf;
+    int rc;
+
+    adc = adc_dma[stm32f4_resolve_dma_handle_idx(hdma)];
+    cfg = (struct stm32f4_adc_dev_cfg *)adc->ad_dev.od_init_arg;
+    buf = idx ? cfg->secondarybuf : cfg->primarybuf;
+
+    if (half) {
+        rc = 0;
+        if (adc->ad_event_handler_func) {
+            rc = adc->ad_event_handler_func(adc, adc->ad_event_handler_arg,
+                                            ADC_EVENT_HALF_RESULT, buf,
+                                            cfg->buflen / 2);
+        }
+    } else {
+        ++stm32f4_adc_stats.adc_dma_xfer_complete;
+
+        /*
+         * DMA has already moved on to the other buffer; if application
+         * still holds it, samples are being written over its data.
+         */
+        if (cfg->sac_buf_held & (1 << !idx)) {
+            ++stm32f4_adc_stats.adc_buf_overrun;
+        }
+        cfg->sac_buf_held |= 1 << idx;
+
+        rc = 0;
+        if (adc->ad_event_handler_func) {
+            rc = adc->ad_event_handler_func(adc, adc->ad_event_handler_arg,
+                                            ADC_EVENT_RESULT, buf,
+                                            cfg->buflen);
+        }
+    }
+    if (rc) {
+        ++stm32f4_adc_stats.adc_error;
+    }
+}
+
+static void
+stm32f4_adc_cont_m0_cplt(DMA_HandleTypeDef *hdma)
+{
+    stm32f4_adc_cont_event(hdma, 0, 0);
+}
+
+static void
+stm32f4_adc_cont_m1_cplt(DMA_HandleTypeDef *hdma)
+{
+    stm32f4_adc_cont_event(hdma, 1, 0);
+}
+
+static void
+stm32f4_adc_cont_m0_half(DMA_HandleTypeDef *hdma)
+{
+    stm32f4_adc_cont_event(hdma, 0, 1);
+}
+
+static void
+stm32f4_adc_cont_m1_half(DMA_HandleTypeDef *hdma)
+{
+    stm32f4_adc_cont_event(hdma, 1, 1);
+}
+
+static void
+stm32f4_adc_cont_error(DMA_HandleTypeDef *hdma)
+{
+    ++stm32f4_adc_stats.adc_error;
+    ++stm32f4_adc_stats.adc_dma_xfer_failed;
+}
+
 static void
 stm32f4_adc_dma_init(ADC_HandleTypeDef* hadc)
 {
@@ -586,16 +666,115 @@ stm32f4_adc_release_buffer(struct adc_dev *dev, void *buf, int buf_len)
 {
     ADC_HandleTypeDef *hadc;
     struct stm32f4_adc_dev_cfg *cfg;
+    os_sr_t sr;
 
     assert(dev);
     cfg  = (struct stm32f4_adc_dev_cfg *)dev->ad_dev.od_init_arg;
     hadc = cfg->sac_adc_handle;
 
+    if (cfg->sac_continuous) {
+        OS_ENTER_CRITICAL(sr);
+        if (buf == cfg->primarybuf) {
+            cfg->sac_buf_held &= ~1;
+        } else if (buf == cfg->secondarybuf) {
+            cfg->sac_buf_held &= ~2;
+        }
+        OS_EXIT_CRITICAL(sr);
+        return (0);
+    }
+
     HAL_ADC_Stop_DMA(hadc);
 
     return (0);
 }
 
+/**
+ * Start continuous sampling into the primary and secondary buffers.
+ * Conversions are started by the external trigger set in the ADC handle
+ * (ExternalTrigConv, e.g. a timer TRGO), or run back to back if the
+ * handle is set up for software trigger with ContinuousConvMode.
+ *
+ * @param ADC device structure
+ * @return OS_OK on success, non OS_OK on failure
+ */
+static int
+stm32f4_adc_start_continuous(struct adc_dev *dev)
+{
+    ADC_HandleTypeDef *hadc;
+    DMA_HandleTypeDef *hdma;
+    struct stm32f4_adc_dev_cfg *cfg;
+
+    assert(dev);
+    cfg  = (struct stm32f4_adc_dev_cfg *)dev->ad_dev.od_init_arg;
+    hadc = cfg->sac_adc_handle;
+    hdma = hadc->DMA_Handle;
+
+    if (cfg->sac_continuous || !cfg->primarybuf || !cfg->secondarybuf) {
+        return (OS_EINVAL);
+    }
+
+    hdma->XferCpltCallback = stm32f4_adc_cont_m0_cplt;
+    hdma->XferM1CpltCallback = stm32f4_adc_cont_m1_cplt;
+    hdma->XferHalfCpltCallback = stm32f4_adc_cont_m0_half;
+    hdma->XferM1HalfCpltCallback = stm32f4_adc_cont_m1_half;
+    hdma->XferErrorCallback = stm32f4_adc_cont_error;
+
+    cfg->sac_buf_held = 0;
+    cfg->sac_continuous = 1;
+
+    /* Keep issuing DMA requests after the last conversion of a sequence */
+    hadc->Instance->CR2 |= ADC_CR2_DMA | ADC_CR2_DDS;
+
+    if (HAL_DMAEx_MultiBufferStart_IT(hdma, (uint32_t)&hadc->Instance->DR,
+                                      (uint32_t)cfg->primarybuf,
+                                      (uint32_t)cfg->secondarybuf,
+                                      cfg->buflen) != HAL_OK) {
+        goto err;
+    }
+    if (HAL_ADC_Start(hadc) != HAL_OK) {
+        HAL_DMA_Abort(hdma);
+        goto err;
+    }
+
+    return (OS_OK);
+err:
+    ++stm32f4_adc_stats.adc_dma_start_error;
+    hadc->Instance->CR2 &= ~(ADC_CR2_DMA | ADC_CR2_DDS);
+    cfg->sac_continuous = 0;
+    return (OS_EINVAL);
+}
+
+static int
+stm32f4_adc_stop_continuous(struct adc_dev *dev)
+{
+    ADC_HandleTypeDef *hadc;
+    DMA_HandleTypeDef *hdma;
+    struct stm32f4_adc_dev_cfg *cfg;
+
+    assert(dev);
+    cfg  = (struct stm32f4_adc_dev_cfg *)dev->ad_dev.od_init_arg;
+    hadc = cfg->sac_adc_handle;
+    hdma = hadc->DMA_Handle;
+
+    if (!cfg->sac_continuous) {
+        return (OS_EINVAL);
+    }
+
+    HAL_ADC_Stop(hadc);
+    hadc->Instance->CR2 &= ~(ADC_CR2_DMA | ADC_CR2_DDS);
+    HAL_DMA_Abort(hdma);
+    hdma->Instance->CR &= ~DMA_SxCR_DBM;
+
+    /* HAL_ADC_Start_DMA() installs its own memory 0 callbacks */
+    hdma->XferM1CpltCallback = NULL;
+    hdma->XferM1HalfCpltCallback = NULL;
+
+    cfg->sac_continuous = 0;
+    cfg->sac_buf_held = 0;
+
+    return (OS_OK);
+}
+
 /**
  * Trigger an ADC sample.
  *
@@ -613,6 +792,11 @@ stm32f4_adc_sample(struct adc_dev *dev)
     cfg  = (struct stm32f4_adc_dev_cfg *)dev->ad_dev.od_init_arg;
     hadc = cfg->sac_adc_handle;
 
+    rc = OS_EBUSY;
+    if (cfg->sac_continuous) {
+        goto err;
+    }
+
     rc = OS_EINVAL;
 
     if (HAL_ADC_Start_DMA(hadc, cfg->primarybuf, cfg->buflen) != HAL_OK) {
@@ -718,6 +902,8 @@ stm32f4_adc_dev_init(struct os_dev *odev, void *arg)
     af->af_release_buffer = stm32f4_adc_release_buffer;
     af->af_read_buffer = stm32f4_adc_read_buffer;
     af->af_size_buffer = stm32f4_adc_size_buffer;
+    af->af_start_continuous = stm32f4_adc_start_continuous;
+    af->af_stop_continuous = stm32f4_adc_stop_continuous;
 
     return (OS_OK);
 }
@@ -33,7 +33,12 @@ struct adc_dev;
  */
 typedef enum {
     /* This event represents the result of an ADC run. */
-    ADC_EVENT_RESULT = 0
+    ADC_EVENT_RESULT = 0,
+    /*
+     * In continuous mode, first half of a buffer has been filled. The event
+     * data is that first half; the whole buffer follows as ADC_EVENT_RESULT.
+     */
+    ADC_EVENT_HALF_RESULT = 1
 } adc_event_type_t;
 
 /**
@@ -136,6 +141,16 @@ typedef int (*adc_buf_read_func_t)(struct adc_dev *, void *, int, int, int *);
  */
 typedef int (*adc_buf_size_func_t)(struct adc_dev *, int, int);
 
+/**
+ * Start or stop continuous sampling.  This is implemented by the HW specific
+ * drivers which support it.
+ *
+ * @param The ADC device to start or stop
+ *
+ * @return 0 on success, non-zero error code on failure
+ */
+typedef int (*adc_continuous_func_t)(struct adc_dev *);
+
 struct adc_driver_funcs {
     adc_configure_channel_func_t af_configure_channel;
     adc_sample_func_t af_sample;
@@ -144,6 +159,8 @@ struct adc_driver_funcs {
     adc_buf_release_func_t af_release_buffer;
     adc_buf_read_func_t af_read_buffer;
     adc_buf_size_func_t af_size_buffer;
+    adc_continuous_func_t af_start_continuous;
+    adc_continuous_func_t af_stop_continuous;
 };
 
 struct adc_chan_config {
@@ -252,6 +269,43 @@ adc_buf_size(struct adc_dev *dev, int chans, int samples)
     return (dev->ad_funcs.af_size_buffer(dev, chans, samples));
 }
 
+/**
+ * Start continuous sampling into both buffers given to adc_buf_set().
+ * Conversions are paced by the trigger the device is configured with
+ * (e.g. a timer), and the driver alternates between the two buffers
+ * without stopping.  Each full buffer is passed to the event handler,
+ * and must be given back with adc_buf_release() before the driver
+ * wraps around to it; otherwise it is counted as an overrun.
+ *
+ * @param dev The ADC device to start sampling on
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+static inline int
+adc_continuous_start(struct adc_dev *dev)
+{
+    if (!dev->ad_funcs.af_start_continuous) {
+        return (OS_EINVAL);
+    }
+    return (dev->ad_funcs.af_start_continuous(dev));
+}
+
+/**
+ * Stop continuous sampling started with adc_continuous_start().
+ *
+ * @param dev The ADC device to stop sampling on
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+static inline int
+adc_continuous_stop(struct adc_dev *dev)
+{
+    if (!dev->ad_funcs.af_stop_continuous) {
+        return (OS_EINVAL);
+    }
+    return (dev->ad_funcs.af_stop_continuous(dev));
+}
+
 /**
  * Take an ADC result and convert it to millivolts.
  *
@@ -0,0 +1,53 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __SPIFLASH_H_
+#define __SPIFLASH_H_
+
+#include <inttypes.h>
+#include <hal/hal_spi.h>
+#include <hal/hal_flash_int.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Where the flash chip is. BSP passes this to spiflash_configure() before
+ * flash is initialized.
+ */
+struct spiflash_cfg {
+    const char *sc_spi_dev;     /* name of spi_dev the chip is on */
+    int sc_cs_pin;
+    struct hal_spi_settings sc_settings;
+};
+
+/*
+ * Flash device to return from hal_bsp_flash_dev(). Geometry comes from
+ * syscfg; hff_init checks it against the JEDEC ID of the chip.
+ */
+extern const struct hal_flash spiflash_dev;
+
+int spiflash_configure(const struct spiflash_cfg *cfg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SPIFLASH_H_ */
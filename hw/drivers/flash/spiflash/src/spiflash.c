@@ -0,0 +1,519 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include <os/os.h>
+#include <os/os_dev.h>
+#include <hal/hal_flash_int.h>
+#include <spi/spi.h>
+
+#include "spiflash/spiflash.h"
+
+#define SPIFLASH_CMD_PP                 0x02
+#define SPIFLASH_CMD_READ               0x03
+#define SPIFLASH_CMD_RDSR               0x05
+#define SPIFLASH_CMD_WREN               0x06
+#define SPIFLASH_CMD_FAST_READ          0x0B
+#define SPIFLASH_CMD_SE                 0x20
+#define SPIFLASH_CMD_ERASE_SUSPEND      0x75
+#define SPIFLASH_CMD_ERASE_RESUME       0x7A
+#define SPIFLASH_CMD_RDID               0x9F
+#define SPIFLASH_CMD_RDP                0xAB    /* release power down */
+
+#define SPIFLASH_SR_WIP                 0x01
+
+#define SPIFLASH_PAGE_SIZE      MYNEWT_VAL(SPIFLASH_PAGE_SIZE)
+#define SPIFLASH_SECTOR_SIZE    MYNEWT_VAL(SPIFLASH_SECTOR_SIZE)
+#define SPIFLASH_SIZE                                                   \
+    (MYNEWT_VAL(SPIFLASH_SECTOR_SIZE) * MYNEWT_VAL(SPIFLASH_SECTOR_COUNT))
+#define SPIFLASH_CACHE_SIZE     MYNEWT_VAL(SPIFLASH_READ_CACHE_SIZE)
+#define SPIFLASH_CACHE_INVALID  0xffffffff
+
+#if MYNEWT_VAL(SPIFLASH_FAST_READ)
+#define SPIFLASH_READ_CMD       SPIFLASH_CMD_FAST_READ
+#define SPIFLASH_READ_HDR_LEN   5       /* opcode, address, dummy byte */
+#else
+#define SPIFLASH_READ_CMD       SPIFLASH_CMD_READ
+#define SPIFLASH_READ_HDR_LEN   4
+#endif
+
+/*
+ * Longest data phase of a single SPI transaction.
+ */
+#define SPIFLASH_XFER_MAX       4096
+
+static int spiflash_read(uint32_t address, void *dst, uint32_t num_bytes);
+static int spiflash_write(uint32_t address, const void *src,
+  uint32_t num_bytes);
+static int spiflash_erase_sector(uint32_t sector_address);
+static int spiflash_sector_info(int idx, uint32_t *address, uint32_t *sz);
+static int spiflash_init(void);
+
+static const struct hal_flash_funcs spiflash_flash_funcs = {
+    .hff_read = spiflash_read,
+    .hff_write = spiflash_write,
+    .hff_erase_sector = spiflash_erase_sector,
+    .hff_sector_info = spiflash_sector_info,
+    .hff_init = spiflash_init
+};
+
+const struct hal_flash spiflash_dev = {
+    .hf_itf = &spiflash_flash_funcs,
+    .hf_base_addr = 0,
+    .hf_size = SPIFLASH_SIZE,
+    .hf_sector_cnt = MYNEWT_VAL(SPIFLASH_SECTOR_COUNT),
+    .hf_align = 1
+};
+
+static struct {
+    const struct spiflash_cfg *sf_cfg;
+    struct spi_node sf_node;
+    struct spi_txn sf_txn[2];
+    struct os_eventq sf_evq;
+    struct os_mutex sf_lock;
+    uint8_t sf_erasing:1;       /* sector erase started, not yet seen done */
+    uint32_t sf_erase_addr;
+    uint8_t sf_cmd[SPIFLASH_READ_HDR_LEN];
+    uint8_t sf_sr;
+    uint8_t sf_page[SPIFLASH_PAGE_SIZE];
+#if SPIFLASH_CACHE_SIZE
+    uint32_t sf_cache_addr;
+    uint8_t sf_cache[SPIFLASH_CACHE_SIZE];
+#endif
+} spiflash;
+
+static void
+spiflash_lock(void)
+{
+    if (os_started()) {
+        os_mutex_pend(&spiflash.sf_lock, OS_TIMEOUT_NEVER);
+    }
+}
+
+static void
+spiflash_unlock(void)
+{
+    if (os_started()) {
+        os_mutex_release(&spiflash.sf_lock);
+    }
+}
+
+/*
+ * Send the first hdr_len bytes of sf_cmd, and then len bytes of data with
+ * chip select held. Data is sent from tx and received to rx; either can be
+ * NULL. Waits until the transfer is done.
+ */
+static int
+spiflash_xfer(int hdr_len, const void *tx, void *rx, uint32_t len)
+{
+    struct spi_txn *txn;
+    struct spi_txn *data;
+    int rc;
+
+    assert(len <= SPIFLASH_XFER_MAX);
+
+    txn = &spiflash.sf_txn[0];
+    data = &spiflash.sf_txn[1];
+    memset(spiflash.sf_txn, 0, sizeof(spiflash.sf_txn));
+
+    txn->st_node = &spiflash.sf_node;
+    txn->st_txbuf = spiflash.sf_cmd;
+    txn->st_len = hdr_len;
+    if (len) {
+        /*
+         * Master has to transmit something while receiving; send whatever
+         * rx holds.
+         */
+        data->st_node = &spiflash.sf_node;
+        data->st_txbuf = tx ? (void *)tx : rx;
+        data->st_rxbuf = rx;
+        data->st_len = len;
+        txn->st_chain = data;
+    }
+
+    /*
+     * Before OS starts (e.g. bootloader) there is nobody to wake us up;
+     * poll for completion instead.
+     */
+    if (os_started()) {
+        txn->st_evq = &spiflash.sf_evq;
+    }
+    rc = spi_txn_submit(txn);
+    if (rc) {
+        return -1;
+    }
+    if (txn->st_evq) {
+        os_eventq_get(&spiflash.sf_evq);
+    } else {
+        while (*(volatile int *)&txn->st_status == OS_EBUSY) {
+        }
+    }
+    return txn->st_status ? -1 : 0;
+}
+
+static int
+spiflash_cmd(uint8_t op)
+{
+    spiflash.sf_cmd[0] = op;
+    return spiflash_xfer(1, NULL, NULL, 0);
+}
+
+static void
+spiflash_cmd_addr(uint8_t op, uint32_t addr)
+{
+    spiflash.sf_cmd[0] = op;
+    spiflash.sf_cmd[1] = addr >> 16;
+    spiflash.sf_cmd[2] = addr >> 8;
+    spiflash.sf_cmd[3] = addr;
+#if MYNEWT_VAL(SPIFLASH_FAST_READ)
+    spiflash.sf_cmd[4] = 0;
+#endif
+}
+
+/*
+ * Poll status register until program/erase/suspend is done.
+ */
+static int
+spiflash_wait_idle(void)
+{
+    do {
+        spiflash.sf_cmd[0] = SPIFLASH_CMD_RDSR;
+        if (spiflash_xfer(1, NULL, &spiflash.sf_sr, 1)) {
+            return -1;
+        }
+    } while (spiflash.sf_sr & SPIFLASH_SR_WIP);
+    return 0;
+}
+
+/*
+ * Wait for an ongoing sector erase to complete.
+ */
+static int
+spiflash_erase_wait(void)
+{
+    if (!spiflash.sf_erasing) {
+        return 0;
+    }
+    if (spiflash_wait_idle()) {
+        return -1;
+    }
+    spiflash.sf_erasing = 0;
+    return 0;
+}
+
+static int
+spiflash_overlap(uint32_t a, uint32_t a_len, uint32_t b, uint32_t b_len)
+{
+    return a < b + b_len && b < a + a_len;
+}
+
+static void
+spiflash_cache_inval(uint32_t addr, uint32_t len)
+{
+#if SPIFLASH_CACHE_SIZE
+    if (spiflash.sf_cache_addr != SPIFLASH_CACHE_INVALID &&
+      spiflash_overlap(addr, len, spiflash.sf_cache_addr,
+        SPIFLASH_CACHE_SIZE)) {
+        spiflash.sf_cache_addr = SPIFLASH_CACHE_INVALID;
+    }
+#endif
+}
+
+static int
+spiflash_read_direct(uint32_t addr, uint8_t *dst, uint32_t len)
+{
+    uint32_t cnt;
+
+    while (len) {
+        cnt = len;
+        if (cnt > SPIFLASH_XFER_MAX) {
+            cnt = SPIFLASH_XFER_MAX;
+        }
+        spiflash_cmd_addr(SPIFLASH_READ_CMD, addr);
+        if (spiflash_xfer(SPIFLASH_READ_HDR_LEN, NULL, dst, cnt)) {
+            return -1;
+        }
+        addr += cnt;
+        dst += cnt;
+        len -= cnt;
+    }
+    return 0;
+}
+
+#if SPIFLASH_CACHE_SIZE
+static int
+spiflash_read_cached(uint32_t addr, uint8_t *dst, uint32_t len)
+{
+    uint32_t blk;
+    uint32_t off;
+    uint32_t cnt;
+
+    while (len) {
+        off = addr % SPIFLASH_CACHE_SIZE;
+        blk = addr - off;
+        if (blk != spiflash.sf_cache_addr) {
+            spiflash.sf_cache_addr = SPIFLASH_CACHE_INVALID;
+            if (spiflash_read_direct(blk, spiflash.sf_cache,
+                SPIFLASH_CACHE_SIZE)) {
+                return -1;
+            }
+            spiflash.sf_cache_addr = blk;
+        }
+        cnt = SPIFLASH_CACHE_SIZE - off;
+        if (cnt > len) {
+            cnt = len;
+        }
+        memcpy(dst, spiflash.sf_cache + off, cnt);
+        addr += cnt;
+        dst += cnt;
+        len -= cnt;
+    }
+    return 0;
+}
+#endif
+
+static int
+spiflash_read(uint32_t address, void *dst, uint32_t num_bytes)
+{
+    uint32_t start;
+    uint32_t end;
+    int suspended;
+    int rc;
+
+    /*
+     * Short reads go through the cache, which reads whole cache blocks.
+     */
+    start = address;
+    end = address + num_bytes;
+#if SPIFLASH_CACHE_SIZE
+    if (num_bytes < SPIFLASH_CACHE_SIZE) {
+        start -= start % SPIFLASH_CACHE_SIZE;
+        end += (SPIFLASH_CACHE_SIZE - end % SPIFLASH_CACHE_SIZE) %
+          SPIFLASH_CACHE_SIZE;
+    }
+#endif
+
+    spiflash_lock();
+
+    /*
+     * Reads during a sector erase suspend it, unless they hit the sector
+     * being erased; those have to wait for the erase to finish.
+     */
+    suspended = 0;
+    rc = 0;
+    if (spiflash.sf_erasing) {
+        if (MYNEWT_VAL(SPIFLASH_ERASE_SUSPEND) &&
+          !spiflash_overlap(start, end - start, spiflash.sf_erase_addr,
+            SPIFLASH_SECTOR_SIZE)) {
+            rc = spiflash_cmd(SPIFLASH_CMD_ERASE_SUSPEND);
+            if (!rc) {
+                rc = spiflash_wait_idle();
+            }
+            suspended = 1;
+        } else {
+            rc = spiflash_erase_wait();
+        }
+    }
+
+    if (!rc) {
+#if SPIFLASH_CACHE_SIZE
+        if (num_bytes < SPIFLASH_CACHE_SIZE) {
+            rc = spiflash_read_cached(address, dst, num_bytes);
+        } else
+#endif
+        rc = spiflash_read_direct(address, dst, num_bytes);
+    }
+
+    if (suspended) {
+        if (spiflash_cmd(SPIFLASH_CMD_ERASE_RESUME)) {
+            rc = -1;
+        }
+    }
+
+    spiflash_unlock();
+    return rc;
+}
+
+static int
+spiflash_write(uint32_t address, const void *src, uint32_t num_bytes)
+{
+    const uint8_t *p;
+    uint32_t cnt;
+    int rc;
+
+    p = src;
+
+    spiflash_lock();
+
+    spiflash_cache_inval(address, num_bytes);
+    rc = spiflash_erase_wait();
+
+    /*
+     * Program one page at a time. Data is staged in RAM, as the SPI
+     * controller might not be able to transmit straight from src (e.g.
+     * when it is in internal flash).
+     */
+    while (!rc && num_bytes) {
+        cnt = SPIFLASH_PAGE_SIZE - address % SPIFLASH_PAGE_SIZE;
+        if (cnt > num_bytes) {
+            cnt = num_bytes;
+        }
+        memcpy(spiflash.sf_page, p, cnt);
+        rc = spiflash_cmd(SPIFLASH_CMD_WREN);
+        if (rc) {
+            break;
+        }
+        spiflash_cmd_addr(SPIFLASH_CMD_PP, address);
+        rc = spiflash_xfer(4, spiflash.sf_page, NULL, cnt);
+        if (rc) {
+            break;
+        }
+        rc = spiflash_wait_idle();
+        address += cnt;
+        p += cnt;
+        num_bytes -= cnt;
+    }
+
+    spiflash_unlock();
+    return rc;
+}
+
+static int
+spiflash_erase_sector(uint32_t sector_address)
+{
+    int rc;
+
+    sector_address -= sector_address % SPIFLASH_SECTOR_SIZE;
+
+    spiflash_lock();
+    spiflash_cache_inval(sector_address, SPIFLASH_SECTOR_SIZE);
+    rc = spiflash_erase_wait();
+    if (!rc) {
+        rc = spiflash_cmd(SPIFLASH_CMD_WREN);
+    }
+    if (!rc) {
+        spiflash_cmd_addr(SPIFLASH_CMD_SE, sector_address);
+        rc = spiflash_xfer(4, NULL, NULL, 0);
+    }
+    if (rc) {
+        spiflash_unlock();
+        return -1;
+    }
+    spiflash.sf_erasing = 1;
+    spiflash.sf_erase_addr = sector_address;
+    spiflash_unlock();
+
+    /*
+     * Erase takes tens of milliseconds. Poll without holding the lock,
+     * so that reads can suspend the erase meanwhile. Someone else might
+     * also see the erase complete first.
+     */
+    while (1) {
+        if (os_started()) {
+            os_time_delay(1);
+        }
+        spiflash_lock();
+        if (!spiflash.sf_erasing) {
+            break;
+        }
+        spiflash.sf_cmd[0] = SPIFLASH_CMD_RDSR;
+        rc = spiflash_xfer(1, NULL, &spiflash.sf_sr, 1);
+        if (rc || !(spiflash.sf_sr & SPIFLASH_SR_WIP)) {
+            spiflash.sf_erasing = 0;
+            break;
+        }
+        spiflash_unlock();
+    }
+    spiflash_unlock();
+
+    return rc ? -1 : 0;
+}
+
+static int
+spiflash_sector_info(int idx, uint32_t *address, uint32_t *sz)
+{
+    assert(idx < spiflash_dev.hf_sector_cnt);
+    *address = idx * SPIFLASH_SECTOR_SIZE;
+    *sz = SPIFLASH_SECTOR_SIZE;
+    return 0;
+}
+
+static int
+spiflash_init(void)
+{
+    const struct spiflash_cfg *cfg;
+    struct spi_dev *bus;
+    uint8_t id[3];
+    int rc;
+
+    cfg = spiflash.sf_cfg;
+    if (!cfg) {
+        return -1;
+    }
+    bus = (struct spi_dev *)os_dev_open((char *)cfg->sc_spi_dev, 0, NULL);
+    if (!bus) {
+        return -1;
+    }
+    rc = spi_node_init(&spiflash.sf_node, bus, cfg->sc_cs_pin,
+      &cfg->sc_settings);
+    if (rc) {
+        return -1;
+    }
+    os_eventq_init(&spiflash.sf_evq);
+    os_mutex_init(&spiflash.sf_lock);
+    spiflash.sf_erasing = 0;
+#if SPIFLASH_CACHE_SIZE
+    spiflash.sf_cache_addr = SPIFLASH_CACHE_INVALID;
+#endif
+
+    /*
+     * Chip might be in deep power down. Also, it might have been in the
+     * middle of erase when we were reset.
+     */
+    if (spiflash_cmd(SPIFLASH_CMD_RDP) || spiflash_wait_idle()) {
+        return -1;
+    }
+
+    /*
+     * Manufacturer, memory type, capacity as log2 of size in bytes.
+     */
+    spiflash.sf_cmd[0] = SPIFLASH_CMD_RDID;
+    if (spiflash_xfer(1, NULL, id, sizeof(id))) {
+        return -1;
+    }
+    if (id[0] == 0x00 || id[0] == 0xff) {
+        return -1;
+    }
+    if (id[2] < 32 && (1UL << id[2]) < SPIFLASH_SIZE) {
+        return -1;
+    }
+    return 0;
+}
+
+int
+spiflash_configure(const struct spiflash_cfg *cfg)
+{
+    if (!cfg || !cfg->sc_spi_dev) {
+        return OS_EINVAL;
+    }
+    spiflash.sf_cfg = cfg;
+    return OS_OK;
+}
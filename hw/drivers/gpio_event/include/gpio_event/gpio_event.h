@@ -0,0 +1,78 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __GPIO_EVENT_H_
+#define __GPIO_EVENT_H_
+
+#include <inttypes.h>
+#include <hal/hal_gpio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct gpio_event;
+
+/*
+ * Called from the work task with the edges latched on the pin since the
+ * previous call. ticks is the os_cputime of the first of them.
+ */
+typedef void (*gpio_event_cb)(struct gpio_event *ev, uint32_t ticks,
+  int edges);
+
+/*
+ * The interrupt handler only records the edge, and posts the work item;
+ * edges seen before the work task gets to run are reported with a single
+ * call.
+ *
+ * With debounce, callback is delayed until the pin has had no edges for
+ * the debounce time. Read the pin in the callback for the settled level.
+ */
+struct gpio_event {
+    int ge_pin;
+    gpio_event_cb ge_cb;
+    void *ge_arg;
+    uint32_t ge_debounce;       /* os_cputime ticks; 0 if none */
+    uint8_t ge_idx;
+    uint16_t ge_edges;          /* latched, not yet reported */
+    uint32_t ge_first;          /* time of first latched edge */
+    uint32_t ge_last;           /* time of latest edge */
+};
+
+/*
+ * Configure pin as interrupt input, and enable the interrupt. Event must
+ * stay valid until released.
+ *
+ * @return		0 on success, OS_ENOMEM if all GPIO_EVENT_MAX are in
+ *			use, OS_EINVAL if the interrupt could not be set up.
+ */
+int gpio_event_init(struct gpio_event *ev, int pin, hal_gpio_irq_trig_t trig,
+  hal_gpio_pull_t pull, uint32_t debounce_usecs, gpio_event_cb cb, void *arg);
+
+/*
+ * Disable and release the pin interrupt. Edges not yet reported are
+ * dropped.
+ */
+void gpio_event_release(struct gpio_event *ev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __GPIO_EVENT_H_ */
@@ -0,0 +1,208 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include <os/os.h>
+#include <os/os_cputime.h>
+#include <os/os_work.h>
+#include <hal/hal_gpio.h>
+
+#include "gpio_event/gpio_event.h"
+
+#if MYNEWT_VAL(GPIO_EVENT_MAX) > 32
+#error "GPIO_EVENT_MAX must be 32 or less"
+#endif
+
+static struct gpio_event *gpio_events[MYNEWT_VAL(GPIO_EVENT_MAX)];
+
+/*
+ * Bit per gpio_events[] slot. Pending ones have edges for the work task to
+ * look at; settling ones are waiting for their debounce time to pass.
+ */
+static uint32_t gpio_event_pending;
+static uint32_t gpio_event_settling;
+
+static struct os_work gpio_event_work;
+static struct os_callout gpio_event_timer;
+
+static void
+gpio_event_irq(void *arg)
+{
+    struct gpio_event *ev;
+    uint32_t now;
+    os_sr_t sr;
+
+    ev = arg;
+    now = os_cputime_get32();
+
+    OS_ENTER_CRITICAL(sr);
+    if (ev->ge_edges == 0) {
+        ev->ge_first = now;
+    }
+    if (ev->ge_edges != UINT16_MAX) {
+        ev->ge_edges++;
+    }
+    ev->ge_last = now;
+    gpio_event_pending |= 1UL << ev->ge_idx;
+    OS_EXIT_CRITICAL(sr);
+
+    os_work_post(&gpio_event_work);
+}
+
+static void
+gpio_event_timer_start(uint32_t cputicks)
+{
+    uint32_t ticks;
+
+    if (os_time_ms_to_ticks(os_cputime_ticks_to_usecs(cputicks) / 1000 + 1,
+        &ticks) || ticks == 0) {
+        ticks = 1;
+    }
+    os_callout_reset(&gpio_event_timer, ticks);
+}
+
+static void
+gpio_event_timer_exp(struct os_event *oev)
+{
+    os_work_post(&gpio_event_work);
+}
+
+static void
+gpio_event_run(struct os_event *oev)
+{
+    struct gpio_event *ev;
+    uint32_t pending;
+    uint32_t first;
+    uint32_t quiet;
+    uint32_t wait;
+    int edges;
+    int i;
+    os_sr_t sr;
+
+    /*
+     * Settling ones are checked every time, so that the timer is always
+     * set for the one which settles first.
+     */
+    OS_ENTER_CRITICAL(sr);
+    pending = gpio_event_pending | gpio_event_settling;
+    gpio_event_pending = 0;
+    gpio_event_settling = 0;
+    OS_EXIT_CRITICAL(sr);
+
+    wait = 0;
+    for (i = 0; pending; i++) {
+        if (!(pending & (1UL << i))) {
+            continue;
+        }
+        pending &= ~(1UL << i);
+
+        OS_ENTER_CRITICAL(sr);
+        ev = gpio_events[i];
+        if (!ev || ev->ge_edges == 0) {
+            OS_EXIT_CRITICAL(sr);
+            continue;
+        }
+        if (ev->ge_debounce) {
+            quiet = os_cputime_get32() - ev->ge_last;
+            if (quiet < ev->ge_debounce) {
+                /*
+                 * Still bouncing; come back when it might have settled.
+                 */
+                gpio_event_settling |= 1UL << i;
+                OS_EXIT_CRITICAL(sr);
+                if (!wait || ev->ge_debounce - quiet < wait) {
+                    wait = ev->ge_debounce - quiet;
+                }
+                continue;
+            }
+        }
+        edges = ev->ge_edges;
+        first = ev->ge_first;
+        ev->ge_edges = 0;
+        OS_EXIT_CRITICAL(sr);
+
+        ev->ge_cb(ev, first, edges);
+    }
+
+    if (wait) {
+        gpio_event_timer_start(wait);
+    }
+}
+
+int
+gpio_event_init(struct gpio_event *ev, int pin, hal_gpio_irq_trig_t trig,
+  hal_gpio_pull_t pull, uint32_t debounce_usecs, gpio_event_cb cb, void *arg)
+{
+    static int inited;
+    os_sr_t sr;
+    int i;
+
+    if (!cb) {
+        return OS_EINVAL;
+    }
+    if (!inited) {
+        os_work_init(&gpio_event_work, gpio_event_run, NULL);
+        os_callout_init(&gpio_event_timer, os_eventq_dflt_get(),
+          gpio_event_timer_exp, NULL);
+        inited = 1;
+    }
+
+    memset(ev, 0, sizeof(*ev));
+    ev->ge_pin = pin;
+    ev->ge_cb = cb;
+    ev->ge_arg = arg;
+    ev->ge_debounce = os_cputime_usecs_to_ticks(debounce_usecs);
+
+    OS_ENTER_CRITICAL(sr);
+    for (i = 0; i < MYNEWT_VAL(GPIO_EVENT_MAX); i++) {
+        if (!gpio_events[i]) {
+            gpio_events[i] = ev;
+            break;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+    if (i == MYNEWT_VAL(GPIO_EVENT_MAX)) {
+        return OS_ENOMEM;
+    }
+    ev->ge_idx = i;
+
+    if (hal_gpio_irq_init(pin, gpio_event_irq, ev, trig, pull)) {
+        gpio_events[i] = NULL;
+        return OS_EINVAL;
+    }
+    hal_gpio_irq_enable(pin);
+    return OS_OK;
+}
+
+void
+gpio_event_release(struct gpio_event *ev)
+{
+    os_sr_t sr;
+
+    hal_gpio_irq_release(ev->ge_pin);
+
+    OS_ENTER_CRITICAL(sr);
+    gpio_event_pending &= ~(1UL << ev->ge_idx);
+    gpio_event_settling &= ~(1UL << ev->ge_idx);
+    gpio_events[ev->ge_idx] = NULL;
+    ev->ge_edges = 0;
+    OS_EXIT_CRITICAL(sr);
+}
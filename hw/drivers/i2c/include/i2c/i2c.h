@@ -0,0 +1,88 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __DRIVERS_I2C_H_
+#define __DRIVERS_I2C_H_
+
+#include <inttypes.h>
+#include <os/os.h>
+#include <os/os_dev.h>
+#include <hal/hal_i2c.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct i2c_txn;
+
+/*
+ * Called from interrupt context when transaction completes.
+ *
+ * @param txn		Transaction which completed.
+ * @param status	0 on success, non-zero if write or read failed.
+ */
+typedef void (*i2c_txn_cb)(struct i2c_txn *txn, int status);
+
+/*
+ * Write it_wlen bytes from it_wbuf, and then read it_rlen bytes into
+ * it_rbuf with a repeated start in between. Either part can be left
+ * out by setting its length to zero. it_addr is the 7-bit address.
+ */
+struct i2c_txn {
+    STAILQ_ENTRY(i2c_txn) it_next;
+    uint8_t it_addr;
+    uint16_t it_wlen;
+    uint16_t it_rlen;
+    uint8_t *it_wbuf;
+    uint8_t *it_rbuf;
+    i2c_txn_cb it_cb;
+    void *it_arg;
+};
+
+struct i2c_dev {
+    struct os_dev id_dev;
+    uint8_t id_unit;
+    STAILQ_HEAD(, i2c_txn) id_txq;
+    struct i2c_txn *id_cur;
+    struct hal_i2c_master_data id_wdata;
+    struct hal_i2c_master_data id_rdata;
+};
+
+/*
+ * Initialize os_dev for I2C master. Device name must end with I2C
+ * number, e.g. "i2c0". Arg points to BSP specific I2C configuration,
+ * which is passed to hal_i2c_init().
+ */
+int i2c_hal_init(struct os_dev *odev, void *arg);
+
+/*
+ * Queue transaction for transfer. Can be called from interrupt context,
+ * including from the completion callback of a previous transaction.
+ * Transaction, and its buffers, must stay valid until its callback
+ * has been called.
+ *
+ * @return		0 if queued, OS_EINVAL on bad parameters.
+ */
+int i2c_txn_submit(struct i2c_dev *dev, struct i2c_txn *txn);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DRIVERS_I2C_H_ */
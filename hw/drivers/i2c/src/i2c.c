@@ -0,0 +1,159 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <ctype.h>
+#include <assert.h>
+#include <string.h>
+
+#include <os/os.h>
+#include <os/os_dev.h>
+#include <hal/hal_i2c.h>
+
+#include "i2c/i2c.h"
+
+static void i2c_start(struct i2c_dev *dev);
+
+/*
+ * Called from interrupt context when the transfer is done.
+ */
+static void
+i2c_xfer_cb(void *arg, int status)
+{
+    struct i2c_dev *dev;
+    struct i2c_txn *txn;
+    os_sr_t sr;
+
+    dev = arg;
+
+    OS_ENTER_CRITICAL(sr);
+    txn = dev->id_cur;
+    dev->id_cur = NULL;
+    OS_EXIT_CRITICAL(sr);
+
+    if (txn && txn->it_cb) {
+        txn->it_cb(txn, status);
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    i2c_start(dev);
+    OS_EXIT_CRITICAL(sr);
+}
+
+/*
+ * Start the next queued transaction, if bus is idle.
+ * Called with interrupts disabled.
+ */
+static void
+i2c_start(struct i2c_dev *dev)
+{
+    struct hal_i2c_master_data *wdata;
+    struct hal_i2c_master_data *rdata;
+    struct i2c_txn *txn;
+    int rc;
+
+    while (!dev->id_cur && (txn = STAILQ_FIRST(&dev->id_txq))) {
+        STAILQ_REMOVE_HEAD(&dev->id_txq, it_next);
+
+        wdata = NULL;
+        rdata = NULL;
+        if (txn->it_wlen) {
+            wdata = &dev->id_wdata;
+            wdata->address = txn->it_addr;
+            wdata->buffer = txn->it_wbuf;
+            wdata->len = txn->it_wlen;
+        }
+        if (txn->it_rlen) {
+            rdata = &dev->id_rdata;
+            rdata->address = txn->it_addr;
+            rdata->buffer = txn->it_rbuf;
+            rdata->len = txn->it_rlen;
+        }
+
+        dev->id_cur = txn;
+        rc = hal_i2c_master_xfer_noblock(dev->id_unit, wdata, rdata,
+          i2c_xfer_cb, dev);
+        if (rc) {
+            dev->id_cur = NULL;
+            if (txn->it_cb) {
+                txn->it_cb(txn, rc);
+            }
+        }
+    }
+}
+
+int
+i2c_txn_submit(struct i2c_dev *dev, struct i2c_txn *txn)
+{
+    os_sr_t sr;
+
+    if ((txn->it_wlen == 0 && txn->it_rlen == 0) ||
+      (txn->it_wlen && !txn->it_wbuf) || (txn->it_rlen && !txn->it_rbuf)) {
+        return OS_EINVAL;
+    }
+    if (!(dev->id_dev.od_flags & OS_DEV_F_STATUS_OPEN)) {
+        return OS_EINVAL;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    STAILQ_INSERT_TAIL(&dev->id_txq, txn, it_next);
+    i2c_start(dev);
+    OS_EXIT_CRITICAL(sr);
+
+    return OS_OK;
+}
+
+static int
+i2c_hal_close(struct os_dev *odev)
+{
+    struct i2c_dev *dev;
+
+    dev = (struct i2c_dev *)odev;
+
+    if (odev->od_open_ref == 1) {
+        if (dev->id_cur || !STAILQ_EMPTY(&dev->id_txq)) {
+            return OS_EBUSY;
+        }
+    }
+    return OS_OK;
+}
+
+int
+i2c_hal_init(struct os_dev *odev, void *arg)
+{
+    struct i2c_dev *dev;
+    char ch;
+
+    dev = (struct i2c_dev *)odev;
+
+    ch = odev->od_name[strlen(odev->od_name) - 1];
+    if (!isdigit((int) ch)) {
+        return OS_EINVAL;
+    }
+    dev->id_unit = ch - '0';
+    STAILQ_INIT(&dev->id_txq);
+    dev->id_cur = NULL;
+
+    if (hal_i2c_init(dev->id_unit, arg)) {
+        return OS_EINVAL;
+    }
+
+    OS_DEV_SETHANDLERS(odev, NULL, i2c_hal_close);
+
+    return OS_OK;
+}
@@ -20,7 +20,10 @@
 #ifndef __STM32F4_ETH_H__
 #define __STM32F4_ETH_H__
 
+#include <inttypes.h>
+
 int stm32f4_eth_init(void *cfg);
+int stm32f4_eth_set_hwaddr(uint8_t *addr);
 int stm32f4_eth_open(void);
 int stm32f4_eth_close(void);
 
@@ -25,8 +25,15 @@
  */
 #define STM32F4_MAX_PORTS	9
 
+#define STM32F4_ETH_PHY_MII     0
+#define STM32F4_ETH_PHY_RMII    1
+
 struct stm32f4_eth_cfg {
     /* Mask of pins from ports A-I to use */
     uint32_t sec_port_mask[STM32F4_MAX_PORTS];
+    /* PHY address on the MDIO bus */
+    uint8_t sec_phy_addr;
+    /* STM32F4_ETH_PHY_MII or STM32F4_ETH_PHY_RMII */
+    uint8_t sec_phy_type;
 };
 #endif /* __STM32F4_ETH_CFG_H__ */
@@ -17,614 +17,451 @@
  * under the License.
  */
 
+#include <string.h>
+#include <assert.h>
+
+#include <os/os.h>
 #include <hal/hal_gpio.h>
 #include <bsp/cmsis_nvic.h>
 
 #include <stm32f4xx.h>
 #include <stm32f4xx_hal_gpio.h>
-#include <stm32f4xx_hal_eth.h>
 #include <stm32f4xx_hal_rcc.h>
+#include <stm32f4xx_hal_eth.h>
 #include <mcu/stm32f4_bsp.h>
 
 #include <netif/etharp.h>
 #include <netif/ethernet.h>
 #include <lwip/ethip6.h>
-#include <string.h>
+#include <lwip/stats.h>
+#include <lwip/tcpip.h>
+#include <lwip/timeouts.h>
 
 #include "stm32f4_eth/stm32f4_eth.h"
 #include "stm32f4_eth/stm32f4_eth_cfg.h"
 
-#if 0
-/* Private typedef -----------------------------------------------------------*/
-/* Private define ------------------------------------------------------------*/
-/* Network interface name */
-#define IFNAME0 's'
-#define IFNAME1 't'
-
-/* Private macro -------------------------------------------------------------*/
-/* Private variables ---------------------------------------------------------*/
-#if defined ( __ICCARM__ ) /*!< IAR Compiler */
-  #pragma data_alignment=4   
-#endif
-__ALIGN_BEGIN ETH_DMADescTypeDef  DMARxDscrTab[ETH_RXBUFNB] __ALIGN_END;/* Ethernet Rx MA Descriptor */
+/*
+ * Native driver for the ETH MAC.  Descriptors are in ring mode and point
+ * straight at pbuf payloads, both ways; the ST HAL driver's static DMA
+ * buffers and copies are not used.
+ *
+ * Received frames are handled NAPI style: the interrupt masks itself and
+ * schedules stm32f4_eth_poll() in the tcpip thread, which takes up to
+ * STM32F4_ETH_RX_BUDGET frames per pass and keeps going until the ring
+ * is empty, only then turning interrupts back on.
+ */
 
-#if defined ( __ICCARM__ ) /*!< IAR Compiler */
-  #pragma data_alignment=4   
-#endif
-__ALIGN_BEGIN ETH_DMADescTypeDef  DMATxDscrTab[ETH_TXBUFNB] __ALIGN_END;/* Ethernet Tx DMA Descriptor */
+#define STM32F4_ETH_RX_CNT      MYNEWT_VAL(STM32F4_ETH_RX_DESC_CNT)
+#define STM32F4_ETH_TX_CNT      MYNEWT_VAL(STM32F4_ETH_TX_DESC_CNT)
+
+/* Room for a VLAN tagged frame plus CRC, multiple of 4. */
+#define STM32F4_ETH_RX_BUF_SIZE 1524
+#define STM32F4_ETH_CRC_LEN     4
+
+#define STM32F4_ETH_LINK_POLL_MS 1000
+
+/* Unique device ID, used to make up a MAC address. */
+#define STM32F4_UID_BASE        0x1FFF7A10U
+
+/* Standard PHY registers */
+#define PHY_BCR                 0x00
+#define PHY_BCR_RESET           0x8000
+#define PHY_BCR_AN_ENABLE       0x1000
+#define PHY_BCR_AN_RESTART      0x0200
+#define PHY_BSR                 0x01
+#define PHY_BSR_LINK            0x0004
+#define PHY_BSR_AN_DONE         0x0020
+#define PHY_ANAR                0x04
+#define PHY_ANLPAR              0x05
+#define PHY_AN_100FD            0x0100
+#define PHY_AN_100HD            0x0080
+#define PHY_AN_10FD             0x0040
+
+#define STM32F4_ETH_MII_TMO     100000
+#define STM32F4_ETH_RESET_TMO   1000000
+
+struct stm32f4_eth_desc {
+    volatile uint32_t sed_status;
+    volatile uint32_t sed_ctrl;
+    volatile uint32_t sed_buf1;
+    volatile uint32_t sed_buf2;
+};
 
-#if defined ( __ICCARM__ ) /*!< IAR Compiler */
-  #pragma data_alignment=4   
-#endif
-__ALIGN_BEGIN uint8_t Rx_Buff[ETH_RXBUFNB][ETH_RX_BUF_SIZE] __ALIGN_END; /* Ethernet Receive Buffer */
+struct stm32f4_eth_state {
+    struct netif st_nif;
+    struct stm32f4_eth_cfg *st_cfg;
+    uint8_t st_hwaddr[ETHARP_HWADDR_LEN];
+    uint8_t st_hwaddr_set;
+    volatile uint8_t st_poll_pending;
+    uint8_t st_rx_idx;          /* next RX descriptor to look at */
+    uint8_t st_tx_head;         /* next free TX descriptor */
+    uint8_t st_tx_tail;         /* oldest TX descriptor given to DMA */
+    uint8_t st_tx_cnt;          /* TX descriptors given to DMA */
+    uint8_t st_link_up;
+    uint32_t st_rx_ctrl;
+    struct tcpip_callback_msg *st_poll_msg;
+    struct os_callout st_retry;
+    struct pbuf *st_rx_pbuf[STM32F4_ETH_RX_CNT];
+    /* Kept on the last descriptor of each frame */
+    struct pbuf *st_tx_pbuf[STM32F4_ETH_TX_CNT];
+};
 
-#if defined ( __ICCARM__ ) /*!< IAR Compiler */
-  #pragma data_alignment=4   
-#endif
-__ALIGN_BEGIN uint8_t Tx_Buff[ETH_TXBUFNB][ETH_TX_BUF_SIZE] __ALIGN_END; /* Ethernet Transmit Buffer */
+static struct stm32f4_eth_state stm32f4_eth_state;
 
-ETH_HandleTypeDef EthHandle;
+static struct stm32f4_eth_desc stm32f4_eth_rx_desc[STM32F4_ETH_RX_CNT]
+  __attribute__((aligned(4)));
+static struct stm32f4_eth_desc stm32f4_eth_tx_desc[STM32F4_ETH_TX_CNT]
+  __attribute__((aligned(4)));
 
-/* Private function prototypes -----------------------------------------------*/
-/* Private functions ---------------------------------------------------------*/
-/*******************************************************************************
-                       Ethernet MSP Routines
-*******************************************************************************/
-/**
-  * @brief  Initializes the ETH MSP.
-  * @param  heth: ETH handle
-  * @retval None
-  */
-void HAL_ETH_MspInit(ETH_HandleTypeDef *heth)
-{ 
-  GPIO_InitTypeDef GPIO_InitStructure;
-  
-  /* Enable GPIOs clocks */
-  __HAL_RCC_GPIOA_CLK_ENABLE();
-  __HAL_RCC_GPIOB_CLK_ENABLE();
-  __HAL_RCC_GPIOC_CLK_ENABLE();
-  __HAL_RCC_GPIOF_CLK_ENABLE();
-  __HAL_RCC_GPIOG_CLK_ENABLE();
-  __HAL_RCC_GPIOH_CLK_ENABLE();
-  __HAL_RCC_GPIOI_CLK_ENABLE(); 
-
-/* Ethernet pins configuration ************************************************/
-   /*
-        ETH_MDIO -------------------------> PA2
-        ETH_MDC --------------------------> PC1
-        ETH_PPS_OUT ----------------------> PB5
-        ETH_MII_CRS ----------------------> PH2
-        ETH_MII_COL ----------------------> PH3
-        ETH_MII_RX_ER --------------------> PI10
-        ETH_MII_RXD2 ---------------------> PH6
-        ETH_MII_RXD3 ---------------------> PH7
-        ETH_MII_TX_CLK -------------------> PC3
-        ETH_MII_TXD2 ---------------------> PC2
-        ETH_MII_TXD3 ---------------------> PB8
-        ETH_MII_RX_CLK/ETH_RMII_REF_CLK---> PA1
-        ETH_MII_RX_DV/ETH_RMII_CRS_DV ----> PA7
-        ETH_MII_RXD0/ETH_RMII_RXD0 -------> PC4
-        ETH_MII_RXD1/ETH_RMII_RXD1 -------> PC5
-        ETH_MII_TX_EN/ETH_RMII_TX_EN -----> PG11
-        ETH_MII_TXD0/ETH_RMII_TXD0 -------> PG13
-        ETH_MII_TXD1/ETH_RMII_TXD1 -------> PG14
-                                                  */
-
-  /* Configure PA1, PA2 , PA7 */
-  GPIO_InitStructure.Pin = GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_7;
-  GPIO_InitStructure.Speed = GPIO_SPEED_HIGH;
-  GPIO_InitStructure.Mode = GPIO_MODE_AF_PP;
-  GPIO_InitStructure.Pull = GPIO_NOPULL; 
-  GPIO_InitStructure.Alternate = GPIO_AF11_ETH;
-  HAL_GPIO_Init(GPIOA, &GPIO_InitStructure);
-
-  /* Configure PB5 and PB8 */
-  GPIO_InitStructure.Pin = GPIO_PIN_5 | GPIO_PIN_8;
-  HAL_GPIO_Init(GPIOB, &GPIO_InitStructure);
-
-  /* Configure PC1, PC2, PC3, PC4 and PC5 */
-  GPIO_InitStructure.Pin = GPIO_PIN_1 | GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_4 | GPIO_PIN_5;
-  HAL_GPIO_Init(GPIOC, &GPIO_InitStructure);
-                             
-  /* Configure PG11, PG14 and PG13 */
-  GPIO_InitStructure.Pin =  GPIO_PIN_11 | GPIO_PIN_13 | GPIO_PIN_14;
-  HAL_GPIO_Init(GPIOG, &GPIO_InitStructure);
-
-  /* Configure PH2, PH3, PH6, PH7 */
-  GPIO_InitStructure.Pin = GPIO_PIN_2 | GPIO_PIN_3 | GPIO_PIN_6 | GPIO_PIN_7;
-  HAL_GPIO_Init(GPIOH, &GPIO_InitStructure);
-
-  /* Configure PI10 */
-  GPIO_InitStructure.Pin = GPIO_PIN_10;
-  HAL_GPIO_Init(GPIOI, &GPIO_InitStructure);
-  
-  /* Enable ETHERNET clock  */
-  __HAL_RCC_ETH_CLK_ENABLE();
-  
-  if (heth->Init.MediaInterface == ETH_MEDIA_INTERFACE_MII)
-  {
-    /* Output HSE clock (25MHz) on MCO pin (PA8) to clock the PHY */
-    HAL_RCC_MCOConfig(RCC_MCO1, RCC_MCO1SOURCE_HSE, RCC_MCODIV_1);
-  }
+/*
+ * Hardware configuration. Should be called from BSP init.
+ */
+int
+stm32f4_eth_init(void *cfg)
+{
+    stm32f4_eth_state.st_cfg = cfg;
+    return 0;
 }
 
-/*******************************************************************************
-                       LL Driver Interface ( LwIP stack --> ETH) 
-*******************************************************************************/
-/**
-  * In this function, the hardware should be initialized.
-  * Called from ethernetif_init().
-  *
-  * @param netif the already initialized lwip network interface structure
-  *        for this ethernetif
-  */
-static void low_level_init(struct netif *netif)
-{ 
-  uint32_t regvalue = 0;
-  uint8_t macaddress[6]= { MAC_ADDR0, MAC_ADDR1, MAC_ADDR2, MAC_ADDR3, MAC_ADDR4, MAC_ADDR5 };
-
-  EthHandle.Instance = ETH;  
-  EthHandle.Init.MACAddr = macaddress;
-  EthHandle.Init.AutoNegotiation = ETH_AUTONEGOTIATION_ENABLE;
-  EthHandle.Init.Speed = ETH_SPEED_100M;
-  EthHandle.Init.DuplexMode = ETH_MODE_FULLDUPLEX;
-  EthHandle.Init.MediaInterface = ETH_MEDIA_INTERFACE_MII;
-  EthHandle.Init.RxMode = ETH_RXPOLLING_MODE;
-  EthHandle.Init.ChecksumMode = ETH_CHECKSUM_BY_HARDWARE;
-  EthHandle.Init.PhyAddress = DP83848_PHY_ADDRESS;
-  
-  /* configure ethernet peripheral (GPIOs, clocks, MAC, DMA) */
-  if (HAL_ETH_Init(&EthHandle) == HAL_OK)
-  {
-    /* Set netif link flag */
-    netif->flags |= NETIF_FLAG_LINK_UP;
-  }
-  
-  /* Initialize Tx Descriptors list: Chain Mode */
-  HAL_ETH_DMATxDescListInit(&EthHandle, DMATxDscrTab, &Tx_Buff[0][0], ETH_TXBUFNB);
-     
-  /* Initialize Rx Descriptors list: Chain Mode  */
-  HAL_ETH_DMARxDescListInit(&EthHandle, DMARxDscrTab, &Rx_Buff[0][0], ETH_RXBUFNB);
-
-  /* set MAC hardware address length */
-  netif->hwaddr_len = ETHARP_HWADDR_LEN;
-  
-  /* set MAC hardware address */
-  netif->hwaddr[0] =  MAC_ADDR0;
-  netif->hwaddr[1] =  MAC_ADDR1;
-  netif->hwaddr[2] =  MAC_ADDR2;
-  netif->hwaddr[3] =  MAC_ADDR3;
-  netif->hwaddr[4] =  MAC_ADDR4;
-  netif->hwaddr[5] =  MAC_ADDR5;
-  
-  /* maximum transfer unit */
-  netif->mtu = 1500;
-  
-  /* device capabilities */
-  /* don't set NETIF_FLAG_ETHARP if this device is not an ethernet one */
-  netif->flags |= NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP;
-  
-  /* Enable MAC and DMA transmission and reception */
-  HAL_ETH_Start(&EthHandle);
-  
-  /**** Configure PHY to generate an interrupt when Eth Link state changes ****/
-  /* Read Register Configuration */
-  HAL_ETH_ReadPHYRegister(&EthHandle, PHY_MICR, &regvalue);
-  
-  regvalue |= (PHY_MICR_INT_EN | PHY_MICR_INT_OE);
-
-  /* Enable Interrupts */
-  HAL_ETH_WritePHYRegister(&EthHandle, PHY_MICR, regvalue );
-  
-  /* Read Register Configuration */
-  HAL_ETH_ReadPHYRegister(&EthHandle, PHY_MISR, &regvalue);
-  
-  regvalue |= PHY_MISR_LINK_INT_EN;
-    
-  /* Enable Interrupt on change of link status */
-  HAL_ETH_WritePHYRegister(&EthHandle, PHY_MISR, regvalue);
+/*
+ * Set the MAC address to use.  Must be called before stm32f4_eth_open();
+ * otherwise one is made up from the unique device ID.
+ */
+int
+stm32f4_eth_set_hwaddr(uint8_t *addr)
+{
+    memcpy(stm32f4_eth_state.st_hwaddr, addr, ETHARP_HWADDR_LEN);
+    stm32f4_eth_state.st_hwaddr_set = 1;
+    return 0;
 }
 
-/**
-  * This function should do the actual transmission of the packet. The packet is
-  * contained in the pbuf that is passed to the function. This pbuf
-  * might be chained.
-  *
-  * @param netif the lwip network interface structure for this ethernetif
-  * @param p the MAC packet to send (e.g. IP packet including MAC addresses and type)
-  * @return ERR_OK if the packet could be sent
-  *         an err_t value if the packet couldn't be sent
-  *
-  * @note Returning ERR_MEM here if a DMA queue of your MAC is full can lead to
-  *       strange results. You might consider waiting for space in the DMA queue
-  *       to become availale since the stack doesn't retry to send a packet
-  *       dropped because of memory failure (except for the TCP timers).
-  */
-static err_t low_level_output(struct netif *netif, struct pbuf *p)
+static void
+stm32f4_eth_default_hwaddr(uint8_t *addr)
 {
-  err_t errval;
-  struct pbuf *q;
-  uint8_t *buffer = (uint8_t *)(EthHandle.TxDesc->Buffer1Addr);
-  __IO ETH_DMADescTypeDef *DmaTxDesc;
-  uint32_t framelength = 0;
-  uint32_t bufferoffset = 0;
-  uint32_t byteslefttocopy = 0;
-  uint32_t payloadoffset = 0;
-
-  DmaTxDesc = EthHandle.TxDesc;
-  bufferoffset = 0;
-  
-  /* copy frame from pbufs to driver buffers */
-  for(q = p; q != NULL; q = q->next)
-  {
-    /* Is this buffer available? If not, goto error */
-    if((DmaTxDesc->Status & ETH_DMATXDESC_OWN) != (uint32_t)RESET)
-    {
-      errval = ERR_USE;
-      goto error;
-    }
-    
-    /* Get bytes in current lwIP buffer */
-    byteslefttocopy = q->len;
-    payloadoffset = 0;
-    
-    /* Check if the length of data to copy is bigger than Tx buffer size*/
-    while( (byteslefttocopy + bufferoffset) > ETH_TX_BUF_SIZE )
-    {
-      /* Copy data to Tx buffer*/
-      memcpy( (uint8_t*)((uint8_t*)buffer + bufferoffset), (uint8_t*)((uint8_t*)q->payload + payloadoffset), (ETH_TX_BUF_SIZE - bufferoffset) );
-      
-      /* Point to next descriptor */
-      DmaTxDesc = (ETH_DMADescTypeDef *)(DmaTxDesc->Buffer2NextDescAddr);
-      
-      /* Check if the buffer is available */
-      if((DmaTxDesc->Status & ETH_DMATXDESC_OWN) != (uint32_t)RESET)
-      {
-        errval = ERR_USE;
-        goto error;
-      }
-      
-      buffer = (uint8_t *)(DmaTxDesc->Buffer1Addr);
-      
-      byteslefttocopy = byteslefttocopy - (ETH_TX_BUF_SIZE - bufferoffset);
-      payloadoffset = payloadoffset + (ETH_TX_BUF_SIZE - bufferoffset);
-      framelength = framelength + (ETH_TX_BUF_SIZE - bufferoffset);
-      bufferoffset = 0;
-    }
-    
-    /* Copy the remaining bytes */
-    memcpy( (uint8_t*)((uint8_t*)buffer + bufferoffset), (uint8_t*)((uint8_t*)q->payload + payloadoffset), byteslefttocopy );
-    bufferoffset = bufferoffset + byteslefttocopy;
-    framelength = framelength + byteslefttocopy;
-  }
-  
-  /* Prepare transmit descriptors to give to DMA */ 
-  HAL_ETH_TransmitFrame(&EthHandle, framelength);
-  
-  errval = ERR_OK;
-  
-error:
-  
-  /* When Transmit Underflow flag is set, clear it and issue a Transmit Poll Demand to resume transmission */
-  if ((EthHandle.Instance->DMASR & ETH_DMASR_TUS) != (uint32_t)RESET)
-  {
-    /* Clear TUS ETHERNET DMA flag */
-    EthHandle.Instance->DMASR = ETH_DMASR_TUS;
-    
-    /* Resume DMA transmission*/
-    EthHandle.Instance->DMATPDR = 0;
-  }
-  return errval;
+    const uint8_t *uid = (const uint8_t *)STM32F4_UID_BASE;
+    int i;
+
+    memset(addr, 0, ETHARP_HWADDR_LEN);
+    for (i = 0; i < 12; i++) {
+        addr[1 + i % (ETHARP_HWADDR_LEN - 1)] ^= uid[i];
+    }
+    /* Locally administered, unicast */
+    addr[0] = 0x02;
 }
 
-/**
-  * Should allocate a pbuf and transfer the bytes of the incoming
-  * packet from the interface into the pbuf.
-  *
-  * @param netif the lwip network interface structure for this ethernetif
-  * @return a pbuf filled with the received packet (including MAC header)
-  *         NULL on memory error
-  */
-static struct pbuf * low_level_input(struct netif *netif)
+static int
+stm32f4_eth_mii_wait(void)
 {
-  struct pbuf *p = NULL;
-  struct pbuf *q;
-  uint16_t len;
-  uint8_t *buffer;
-  __IO ETH_DMADescTypeDef *dmarxdesc;
-  uint32_t bufferoffset = 0;
-  uint32_t payloadoffset = 0;
-  uint32_t byteslefttocopy = 0;
-  uint32_t i=0;
-  
-  if (HAL_ETH_GetReceivedFrame(&EthHandle) != HAL_OK)
-    return NULL;
-  
-  /* Obtain the size of the packet and put it into the "len" variable. */
-  len = EthHandle.RxFrameInfos.length;
-  buffer = (uint8_t *)EthHandle.RxFrameInfos.buffer;
-  
-  /* We allocate a pbuf chain of pbufs from the Lwip buffer pool */
-  p = pbuf_alloc(PBUF_RAW, len, PBUF_POOL);
-  
-  if (p != NULL)
-  {
-    dmarxdesc = EthHandle.RxFrameInfos.FSRxDesc;
-    bufferoffset = 0;
-    for(q = p; q != NULL; q = q->next)
-    {
-      byteslefttocopy = q->len;
-      payloadoffset = 0;
-      
-      /* Check if the length of bytes to copy in current pbuf is bigger than Rx buffer size*/
-      while( (byteslefttocopy + bufferoffset) > ETH_RX_BUF_SIZE )
-      {
-        /* Copy data to pbuf*/
-        memcpy( (u8_t*)((u8_t*)q->payload + payloadoffset), (u8_t*)((u8_t*)buffer + bufferoffset), (ETH_RX_BUF_SIZE - bufferoffset));
-        
-        /* Point to next descriptor */
-        dmarxdesc = (ETH_DMADescTypeDef *)(dmarxdesc->Buffer2NextDescAddr);
-        buffer = (unsigned char *)(dmarxdesc->Buffer1Addr);
-        
-        byteslefttocopy = byteslefttocopy - (ETH_RX_BUF_SIZE - bufferoffset);
-        payloadoffset = payloadoffset + (ETH_RX_BUF_SIZE - bufferoffset);
-        bufferoffset = 0;
-      }
-      /* Copy remaining data in pbuf */
-      memcpy( (u8_t*)((u8_t*)q->payload + payloadoffset), (u8_t*)((u8_t*)buffer + bufferoffset), byteslefttocopy);
-      bufferoffset = bufferoffset + byteslefttocopy;
-    }
-  }
-  
-  dmarxdesc = EthHandle.RxFrameInfos.FSRxDesc;
-  
-  /* Set Own bit in Rx descriptors: gives the buffers back to DMA */
-  for (i=0; i< (EthHandle.RxFrameInfos).SegCount; i++)
-  {  
-    dmarxdesc->Status = ETH_DMARXDESC_OWN;
-    dmarxdesc = (ETH_DMADescTypeDef *)(dmarxdesc->Buffer2NextDescAddr);
-  }
-  
-  /* Clear Segment_Count */
-  (EthHandle.RxFrameInfos).SegCount =0;
-  
-  /* When Rx Buffer unavailable flag is set: clear it and resume reception */
-  if (((EthHandle.Instance)->DMASR & ETH_DMASR_RBUS) != (uint32_t)RESET)  
-  {
-    /* Clear RBUS ETHERNET DMA flag */
-    (EthHandle.Instance)->DMASR = ETH_DMASR_RBUS;
-    /* Resume DMA reception */
-    (EthHandle.Instance)->DMARPDR = 0;
-  }
-  return p;
+    int i;
+
+    for (i = 0; i < STM32F4_ETH_MII_TMO; i++) {
+        if ((ETH->MACMIIAR & ETH_MACMIIAR_MB) == 0) {
+            return 0;
+        }
+    }
+    return -1;
 }
 
-/**
-  * This function should be called when a packet is ready to be read
-  * from the interface. It uses the function low_level_input() that
-  * should handle the actual reception of bytes from the network
-  * interface. Then the type of the received packet is determined and
-  * the appropriate input function is called.
-  *
-  * @param netif the lwip network interface structure for this ethernetif
-  */
-void ethernetif_input(struct netif *netif)
+static int
+stm32f4_eth_phy_read(struct stm32f4_eth_state *ses, int reg, uint16_t *val)
 {
-  err_t err;
-  struct pbuf *p;
-  
-  /* move received packet into a new pbuf */
-  p = low_level_input(netif);
-    
-  /* no packet could be read, silently ignore this */
-  if (p == NULL) return;
-    
-  /* entry point to the LwIP stack */
-  err = netif->input(p, netif);
-    
-  if (err != ERR_OK)
-  {
-    LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: IP input error\n"));
-    pbuf_free(p);
-    p = NULL;
-  }
+    ETH->MACMIIAR = (ETH->MACMIIAR & ETH_MACMIIAR_CR) |
+      ((ses->st_cfg->sec_phy_addr << 11) & ETH_MACMIIAR_PA) |
+      ((reg << 6) & ETH_MACMIIAR_MR) | ETH_MACMIIAR_MB;
+    if (stm32f4_eth_mii_wait()) {
+        return -1;
+    }
+    *val = ETH->MACMIIDR;
+    return 0;
 }
 
-/**
-  * Should be called at the beginning of the program to set up the
-  * network interface. It calls the function low_level_init() to do the
-  * actual setup of the hardware.
-  *
-  * This function should be passed as a parameter to netif_add().
-  *
-  * @param netif the lwip network interface structure for this ethernetif
-  * @return ERR_OK if the loopif is initialized
-  *         ERR_MEM if private data couldn't be allocated
-  *         any other err_t on error
-  */
-err_t ethernetif_init(struct netif *netif)
+static int
+stm32f4_eth_phy_write(struct stm32f4_eth_state *ses, int reg, uint16_t val)
 {
-  LWIP_ASSERT("netif != NULL", (netif != NULL));
-  
-#if LWIP_NETIF_HOSTNAME
-  /* Initialize interface hostname */
-  netif->hostname = "lwip";
-#endif /* LWIP_NETIF_HOSTNAME */
-
-  netif->name[0] = IFNAME0;
-  netif->name[1] = IFNAME1;
-  /* We directly use etharp_output() here to save a function call.
-   * You can instead declare your own function an call etharp_output()
-   * from it if you have to do some checks before sending (e.g. if link
-   * is available...) */
-  netif->output = etharp_output;
-  netif->linkoutput = low_level_output;
-
-  /* initialize the hardware */
-  low_level_init(netif);
-
-  return ERR_OK;
+    ETH->MACMIIDR = val;
+    ETH->MACMIIAR = (ETH->MACMIIAR & ETH_MACMIIAR_CR) |
+      ((ses->st_cfg->sec_phy_addr << 11) & ETH_MACMIIAR_PA) |
+      ((reg << 6) & ETH_MACMIIAR_MR) | ETH_MACMIIAR_MW | ETH_MACMIIAR_MB;
+    return stm32f4_eth_mii_wait();
 }
 
-/**
-  * @brief  Returns the current time in milliseconds
-  *         when LWIP_TIMERS == 1 and NO_SYS == 1
-  * @param  None
-  * @retval Time
-  */
-u32_t sys_now(void)
+static uint32_t
+stm32f4_eth_mdc_div(uint32_t hclk)
 {
-  return HAL_GetTick();
+    if (hclk < 35000000) {
+        return ETH_MACMIIAR_CR_Div16;
+    } else if (hclk < 60000000) {
+        return ETH_MACMIIAR_CR_Div26;
+    } else if (hclk < 100000000) {
+        return ETH_MACMIIAR_CR_Div42;
+    } else if (hclk < 150000000) {
+        return ETH_MACMIIAR_CR_Div62;
+    }
+    return ETH_MACMIIAR_CR_Div102;
 }
 
-/**
-  * @brief  This function sets the netif link status.
-  * @param  netif: the network interface
-  * @retval None
-  */
-void ethernetif_set_link(struct netif *netif)
+static inline int
+stm32f4_eth_next(int idx, int cnt)
 {
-  uint32_t regvalue = 0;
-  
-  /* Read PHY_MISR*/
-  HAL_ETH_ReadPHYRegister(&EthHandle, PHY_MISR, &regvalue);
-  
-  /* Check whether the link interrupt has occurred or not */
-  if((regvalue & PHY_LINK_INTERRUPT) != (uint16_t)RESET)
-  {
-    /* Read PHY_SR*/
-    HAL_ETH_ReadPHYRegister(&EthHandle, PHY_SR, &regvalue);
-    
-    /* Check whether the link is up or down*/
-    if((regvalue & PHY_LINK_STATUS)!= (uint16_t)RESET)
-    {
-      netif_set_link_up(netif);
-    }
-    else
-    {
-      netif_set_link_down(netif);
-    }
-  }
+    return (idx + 1 == cnt) ? 0 : idx + 1;
 }
 
-/**
-  * @brief  Link callback function, this function is called on change of link status
-  *         to update low level driver configuration.
-  * @param  netif: The network interface
-  * @retval None
-  */
-void ethernetif_update_config(struct netif *netif)
+static struct pbuf *
+stm32f4_eth_rx_alloc(void)
 {
-  __IO uint32_t tickstart = 0;
-  uint32_t regvalue = 0;
-  
-  if(netif_is_link_up(netif))
-  { 
-    /* Restart the auto-negotiation */
-    if(EthHandle.Init.AutoNegotiation != ETH_AUTONEGOTIATION_DISABLE)
-    {
-      /* Enable Auto-Negotiation */
-      HAL_ETH_WritePHYRegister(&EthHandle, PHY_BCR, PHY_AUTONEGOTIATION);
-      
-      /* Get tick */
-      tickstart = HAL_GetTick();
-      
-      /* Wait until the auto-negotiation will be completed */
-      do
-      {
-        HAL_ETH_ReadPHYRegister(&EthHandle, PHY_BSR, &regvalue);
-        
-        /* Check for the Timeout ( 1s ) */
-        if((HAL_GetTick() - tickstart ) > 1000)
-        {
-          /* In case of timeout */
-          goto error;
+#if PBUF_POOL_BUFSIZE >= STM32F4_ETH_RX_BUF_SIZE
+    return pbuf_alloc(PBUF_RAW, STM32F4_ETH_RX_BUF_SIZE, PBUF_POOL);
+#else
+    return pbuf_alloc(PBUF_RAW, STM32F4_ETH_RX_BUF_SIZE, PBUF_RAM);
+#endif
+}
+
+/*
+ * Hands the buffer of pbuf p to the DMA engine through RX descriptor idx.
+ */
+static void
+stm32f4_eth_rx_give(struct stm32f4_eth_state *ses, int idx, struct pbuf *p)
+{
+    struct stm32f4_eth_desc *d = &stm32f4_eth_rx_desc[idx];
+
+    ses->st_rx_pbuf[idx] = p;
+    d->sed_buf1 = (uint32_t)p->payload;
+    d->sed_ctrl = ses->st_rx_ctrl | STM32F4_ETH_RX_BUF_SIZE |
+      (idx == STM32F4_ETH_RX_CNT - 1 ? ETH_DMARXDESC_RER : 0);
+    __DMB();
+    d->sed_status = ETH_DMARXDESC_OWN;
+}
+
+/*
+ * Passes up to budget received frames to lwIP.  Every buffer taken out of
+ * the ring is replaced right away; if that cannot be done, the frame is
+ * dropped and its buffer reused.  Returns the number of descriptors
+ * processed.
+ */
+static int
+stm32f4_eth_rx(struct stm32f4_eth_state *ses, int budget)
+{
+    struct stm32f4_eth_desc *d;
+    struct pbuf *p;
+    struct pbuf *q;
+    uint32_t status;
+    int idx;
+    int len;
+    int n;
+
+    idx = ses->st_rx_idx;
+    for (n = 0; n < budget; n++) {
+        d = &stm32f4_eth_rx_desc[idx];
+        status = d->sed_status;
+        if (status & ETH_DMARXDESC_OWN) {
+            break;
         }
-        
-      } while (((regvalue & PHY_AUTONEGO_COMPLETE) != PHY_AUTONEGO_COMPLETE));
-      
-      /* Read the result of the auto-negotiation */
-      HAL_ETH_ReadPHYRegister(&EthHandle, PHY_SR, &regvalue);
-      
-      /* Configure the MAC with the Duplex Mode fixed by the auto-negotiation process */
-      if((regvalue & PHY_DUPLEX_STATUS) != (uint32_t)RESET)
-      {
-        /* Set Ethernet duplex mode to Full-duplex following the auto-negotiation */
-        EthHandle.Init.DuplexMode = ETH_MODE_FULLDUPLEX;  
-      }
-      else
-      {
-        /* Set Ethernet duplex mode to Half-duplex following the auto-negotiation */
-        EthHandle.Init.DuplexMode = ETH_MODE_HALFDUPLEX;           
-      }
-      /* Configure the MAC with the speed fixed by the auto-negotiation process */
-      if(regvalue & PHY_SPEED_STATUS)
-      {  
-        /* Set Ethernet speed to 10M following the auto-negotiation */
-        EthHandle.Init.Speed = ETH_SPEED_10M; 
-      }
-      else
-      {   
-        /* Set Ethernet speed to 100M following the auto-negotiation */ 
-        EthHandle.Init.Speed = ETH_SPEED_100M;
-      }
-    }
-    else /* AutoNegotiation Disable */
-    {
-    error :
-      /* Check parameters */
-      assert_param(IS_ETH_SPEED(EthHandle.Init.Speed));
-      assert_param(IS_ETH_DUPLEX_MODE(EthHandle.Init.DuplexMode));
-      
-      /* Set MAC Speed and Duplex Mode to PHY */
-      HAL_ETH_WritePHYRegister(&EthHandle, PHY_BCR, ((uint16_t)(EthHandle.Init.DuplexMode >> 3) |
-                                                     (uint16_t)(EthHandle.Init.Speed >> 1))); 
-    }
-
-    /* ETHERNET MAC Re-Configuration */
-    HAL_ETH_ConfigMAC(&EthHandle, (ETH_MACInitTypeDef *) NULL);
-
-    /* Restart MAC interface */
-    HAL_ETH_Start(&EthHandle);   
-  }
-  else
-  {
-    /* Stop MAC interface */
-    HAL_ETH_Stop(&EthHandle);
-  }
-
-  ethernetif_notify_conn_changed(netif);
+        p = ses->st_rx_pbuf[idx];
+        if ((status & (ETH_DMARXDESC_ES | ETH_DMARXDESC_FS |
+              ETH_DMARXDESC_LS)) != (ETH_DMARXDESC_FS | ETH_DMARXDESC_LS)) {
+            LINK_STATS_INC(link.err);
+            LINK_STATS_INC(link.drop);
+        } else if ((q = stm32f4_eth_rx_alloc()) == NULL) {
+            LINK_STATS_INC(link.memerr);
+            LINK_STATS_INC(link.drop);
+        } else {
+            len = ((status & ETH_DMARXDESC_FL) >>
+              ETH_DMARXDESC_FRAME_LENGTHSHIFT) - STM32F4_ETH_CRC_LEN;
+            pbuf_realloc(p, len);
+            LINK_STATS_INC(link.recv);
+            if (ses->st_nif.input(p, &ses->st_nif) != ERR_OK) {
+                pbuf_free(p);
+            }
+            p = q;
+        }
+        stm32f4_eth_rx_give(ses, idx, p);
+        idx = stm32f4_eth_next(idx, STM32F4_ETH_RX_CNT);
+    }
+    ses->st_rx_idx = idx;
+
+    /*
+     * If DMA ran out of descriptors, it suspended; make it look again.
+     */
+    if (ETH->DMASR & ETH_DMASR_RBUS) {
+        ETH->DMASR = ETH_DMASR_RBUS;
+        ETH->DMARPDR = 0;
+    }
+    return n;
 }
 
-/**
-  * @brief  This function notify user about link status changement.
-  * @param  netif: the network interface
-  * @retval None
-  */
-__weak void ethernetif_notify_conn_changed(struct netif *netif)
+/*
+ * Releases pbufs of frames DMA is done with.
+ */
+static void
+stm32f4_eth_tx_reclaim(struct stm32f4_eth_state *ses)
 {
-  /* NOTE : This is function clould be implemented in user file 
-            when the callback is needed,
-  */  
+    int idx;
+
+    idx = ses->st_tx_tail;
+    while (ses->st_tx_cnt) {
+        if (stm32f4_eth_tx_desc[idx].sed_status & ETH_DMATXDESC_OWN) {
+            break;
+        }
+        if (ses->st_tx_pbuf[idx]) {
+            pbuf_free(ses->st_tx_pbuf[idx]);
+            ses->st_tx_pbuf[idx] = NULL;
+        }
+        idx = stm32f4_eth_next(idx, STM32F4_ETH_TX_CNT);
+        ses->st_tx_cnt--;
+    }
+    ses->st_tx_tail = idx;
 }
-#endif
 
-struct stm32f4_eth_state {
-    struct netif nif;
-    ETH_HandleTypeDef st_eth;
-    struct stm32f4_eth_cfg *cfg;
-};
+static void
+stm32f4_eth_poll(void *arg)
+{
+    struct stm32f4_eth_state *ses = arg;
+
+    for (;;) {
+        /*
+         * Anything completing from here on sets the status bits again,
+         * and fires as soon as interrupts are turned back on.
+         */
+        ETH->DMASR = ETH_DMASR_RS | ETH_DMASR_TS;
+        stm32f4_eth_tx_reclaim(ses);
+        if (stm32f4_eth_rx(ses, MYNEWT_VAL(STM32F4_ETH_RX_BUDGET)) <
+          MYNEWT_VAL(STM32F4_ETH_RX_BUDGET)) {
+            break;
+        }
+        /*
+         * Still busy.  Give other tcpip thread work a turn before going
+         * on, unless the mailbox is full.
+         */
+        if (tcpip_trycallback(ses->st_poll_msg) == ERR_OK) {
+            return;
+        }
+    }
+    ses->st_poll_pending = 0;
+    ETH->DMAIER |= ETH_DMAIER_RIE | ETH_DMAIER_TIE;
+}
 
-static struct stm32f4_eth_state stm32f4_eth_state;
+static void
+stm32f4_eth_schedule(struct stm32f4_eth_state *ses)
+{
+    if (tcpip_trycallback(ses->st_poll_msg) != ERR_OK) {
+        /*
+         * tcpip mailbox is full; try again shortly.
+         */
+        os_callout_reset(&ses->st_retry, 1);
+    }
+}
+
+static void
+stm32f4_eth_retry(struct os_event *ev)
+{
+    stm32f4_eth_schedule(ev->ev_arg);
+}
+
+static void
+stm32f4_eth_isr(void)
+{
+    struct stm32f4_eth_state *ses = &stm32f4_eth_state;
+
+    if (ETH->DMASR & (ETH_DMASR_RS | ETH_DMASR_TS)) {
+        ETH->DMAIER &= ~(ETH_DMAIER_RIE | ETH_DMAIER_TIE);
+        ETH->DMASR = ETH_DMASR_NIS;
+        if (!ses->st_poll_pending) {
+            ses->st_poll_pending = 1;
+            stm32f4_eth_schedule(ses);
+        }
+    }
+}
 
 /*
- * Hardware configuration. Should be called from BSP init.
+ * Frames are sent out of the pbufs themselves, one descriptor per pbuf,
+ * and the chain is held on to until DMA is done with it.  IP, TCP, UDP
+ * and ICMP checksums are filled in by the MAC.
  */
-int
-stm32f4_eth_init(void *cfg)
+static err_t
+stm32f4_output(struct netif *nif, struct pbuf *p)
 {
-    stm32f4_eth_state.cfg = cfg;
-    return 0;
+    struct stm32f4_eth_state *ses = &stm32f4_eth_state;
+    struct stm32f4_eth_desc *d;
+    struct pbuf *q;
+    uint32_t status;
+    int first;
+    int last;
+    int idx;
+    int cnt;
+
+    stm32f4_eth_tx_reclaim(ses);
+
+    cnt = 0;
+    for (q = p; q; q = q->next) {
+        if (q->type == PBUF_REF) {
+            /*
+             * Data not owned by the pbuf may be gone before DMA is done.
+             */
+            break;
+        }
+        if (q->len) {
+            cnt++;
+        }
+    }
+    if (q) {
+        q = pbuf_alloc(PBUF_RAW, p->tot_len, PBUF_RAM);
+        if (!q) {
+            LINK_STATS_INC(link.memerr);
+            LINK_STATS_INC(link.drop);
+            return ERR_MEM;
+        }
+        pbuf_copy(q, p);
+        p = q;
+        cnt = 1;
+    } else {
+        pbuf_ref(p);
+    }
+    if (cnt == 0 || cnt > STM32F4_ETH_TX_CNT - ses->st_tx_cnt) {
+        pbuf_free(p);
+        LINK_STATS_INC(link.drop);
+        return ERR_MEM;
+    }
+
+    first = last = idx = ses->st_tx_head;
+    for (q = p; q; q = q->next) {
+        if (q->len == 0) {
+            continue;
+        }
+        d = &stm32f4_eth_tx_desc[idx];
+        d->sed_buf1 = (uint32_t)q->payload;
+        d->sed_ctrl = q->len & ETH_DMATXDESC_TBS1;
+        status = ETH_DMATXDESC_CIC_TCPUDPICMP_FULL;
+        if (idx == STM32F4_ETH_TX_CNT - 1) {
+            status |= ETH_DMATXDESC_TER;
+        }
+        if (idx == first) {
+            status |= ETH_DMATXDESC_FS;
+        } else {
+            status |= ETH_DMATXDESC_OWN;
+        }
+        d->sed_status = status;
+        last = idx;
+        idx = stm32f4_eth_next(idx, STM32F4_ETH_TX_CNT);
+    }
+    stm32f4_eth_tx_desc[last].sed_status |= ETH_DMATXDESC_LS |
+      ETH_DMATXDESC_IC;
+    ses->st_tx_pbuf[last] = p;
+    ses->st_tx_head = idx;
+    ses->st_tx_cnt += cnt;
+
+    /*
+     * First descriptor goes to DMA last, so it never sees half a frame.
+     */
+    __DMB();
+    stm32f4_eth_tx_desc[first].sed_status |= ETH_DMATXDESC_OWN;
+    __DMB();
+    if (ETH->DMASR & ETH_DMASR_TBUS) {
+        ETH->DMASR = ETH_DMASR_TBUS;
+    }
+    ETH->DMATPDR = 0;
+
+    LINK_STATS_INC(link.xmit);
+    return ERR_OK;
 }
 
 #if LWIP_IGMP
@@ -632,7 +469,8 @@ static err_t
 stm32f4_igmp_mac_filter(struct netif *nif, const ip4_addr_t *group,
   enum netif_mac_filter_action action)
 {
-    return -1;
+    /* All multicast is passed up. */
+    return ERR_OK;
 }
 #endif
 
@@ -641,28 +479,76 @@ static err_t
 stm32f4_mld_mac_filter(struct netif *nif, const ip6_addr_t *group,
   enum netif_mac_filter_action action)
 {
-    return -1;
-}
-#endif
-
-static err_t
-stm32f4_output(struct netif *nif, struct pbuf *p)
-{
+    /* All multicast is passed up. */
     return ERR_OK;
 }
+#endif
 
+/*
+ * Follows the PHY's link state.  Runs in the tcpip thread.
+ */
 static void
-stm32f4_eth_isr(void)
+stm32f4_eth_link_poll(void *arg)
 {
-    HAL_ETH_IRQHandler(&stmref4_eth_State.st_eth);
+    struct stm32f4_eth_state *ses = arg;
+    uint16_t bsr;
+    uint16_t anar;
+    uint16_t anlpar;
+    uint32_t maccr;
+    int up;
+
+    sys_timeout(STM32F4_ETH_LINK_POLL_MS, stm32f4_eth_link_poll, ses);
+
+    /*
+     * Link status is latched low; the second read tells the current state.
+     */
+    if (stm32f4_eth_phy_read(ses, PHY_BSR, &bsr) ||
+        stm32f4_eth_phy_read(ses, PHY_BSR, &bsr)) {
+        return;
+    }
+    up = (bsr & (PHY_BSR_LINK | PHY_BSR_AN_DONE)) ==
+      (PHY_BSR_LINK | PHY_BSR_AN_DONE);
+    if (up == ses->st_link_up) {
+        return;
+    }
+    ses->st_link_up = up;
+    if (!up) {
+        netif_set_link_down(&ses->st_nif);
+        return;
+    }
+
+    /*
+     * Use the best mode both ends advertised.
+     */
+    if (stm32f4_eth_phy_read(ses, PHY_ANAR, &anar) ||
+        stm32f4_eth_phy_read(ses, PHY_ANLPAR, &anlpar)) {
+        ses->st_link_up = 0;
+        return;
+    }
+    anar &= anlpar;
+    maccr = ETH->MACCR & ~(ETH_MACCR_FES | ETH_MACCR_DM);
+    if (anar & PHY_AN_100FD) {
+        maccr |= ETH_MACCR_FES | ETH_MACCR_DM;
+    } else if (anar & PHY_AN_100HD) {
+        maccr |= ETH_MACCR_FES;
+    } else if (anar & PHY_AN_10FD) {
+        maccr |= ETH_MACCR_DM;
+    }
+    ETH->MACCR = maccr;
+    (void)ETH->MACCR;
+    netif_set_link_up(&ses->st_nif);
 }
 
 static err_t
 stm32f4_lwip_init(struct netif *nif)
 {
     struct stm32f4_eth_state *ses = &stm32f4_eth_state;
-    int i, j;
     struct stm32f4_eth_cfg *cfg;
+    struct pbuf *p;
+    uint32_t hclk;
+    uint32_t rswt;
+    uint16_t bcr;
+    int i, j;
 
     /*
      * LwIP clears most of these field in netif_add() before calling
@@ -677,6 +563,10 @@ stm32f4_lwip_init(struct netif *nif)
     nif->mtu = 1500;
     nif->hwaddr_len = ETHARP_HWADDR_LEN;
     nif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP;
+    if (!ses->st_hwaddr_set) {
+        stm32f4_eth_default_hwaddr(ses->st_hwaddr);
+    }
+    memcpy(nif->hwaddr, ses->st_hwaddr, ETHARP_HWADDR_LEN);
 
 #if LWIP_IGMP
     nif->flags |= NETIF_FLAG_IGMP;
@@ -686,8 +576,16 @@ stm32f4_lwip_init(struct netif *nif)
     nif->flags |= NETIF_FLAG_MLD6;
     nif->mld_mac_filter = stm32f4_mld_mac_filter;
 #endif
+#if LWIP_CHECKSUM_CTRL_PER_NETIF
+    /*
+     * MAC inserts IPv4/TCP/UDP/ICMP checksums, and drops received frames
+     * where they are wrong.  ICMPv6 is left to lwIP.
+     */
+    NETIF_SET_CHECKSUM_CTRL(nif,
+      NETIF_CHECKSUM_GEN_ICMP6 | NETIF_CHECKSUM_CHECK_ICMP6);
+#endif
 
-    cfg = ses->cfg;
+    cfg = ses->st_cfg;
 
     /*
      * Now take the BSP specific HW config and set up the hardware.
@@ -697,23 +595,99 @@ stm32f4_lwip_init(struct netif *nif)
             if ((cfg->sec_port_mask[i] & (1 << j)) == 0) {
                 continue;
             }
-            hal_gpio_init_af(i * 16 + j, GPIO_AF11_ETH, GPIO_NOPULL);
+            hal_gpio_init_af(i * 16 + j, GPIO_AF11_ETH, HAL_GPIO_PULL_NONE, 0);
+        }
+    }
+
+    __HAL_RCC_SYSCFG_CLK_ENABLE();
+    if (cfg->sec_phy_type == STM32F4_ETH_PHY_RMII) {
+        SYSCFG->PMC |= SYSCFG_PMC_MII_RMII_SEL;
+    } else {
+        SYSCFG->PMC &= ~SYSCFG_PMC_MII_RMII_SEL;
+    }
+    __HAL_RCC_ETH_CLK_ENABLE();
+
+    /*
+     * Reset needs the PHY clock running; it does not finish without.
+     */
+    ETH->DMABMR |= ETH_DMABMR_SR;
+    for (i = 0; ETH->DMABMR & ETH_DMABMR_SR; i++) {
+        if (i == STM32F4_ETH_RESET_TMO) {
+            return ERR_IF;
         }
     }
 
+    hclk = HAL_RCC_GetHCLKFreq();
+    ETH->MACMIIAR = stm32f4_eth_mdc_div(hclk);
+
+    if (stm32f4_eth_phy_write(ses, PHY_BCR, PHY_BCR_RESET)) {
+        return ERR_IF;
+    }
+    for (i = 0; i < STM32F4_ETH_RESET_TMO; i++) {
+        if (stm32f4_eth_phy_read(ses, PHY_BCR, &bcr)) {
+            return ERR_IF;
+        }
+        if ((bcr & PHY_BCR_RESET) == 0) {
+            break;
+        }
+    }
+    stm32f4_eth_phy_write(ses, PHY_BCR, PHY_BCR_AN_ENABLE |
+      PHY_BCR_AN_RESTART);
+
+    ETH->MACA0HR = (ses->st_hwaddr[5] << 8) | ses->st_hwaddr[4];
+    ETH->MACA0LR = (ses->st_hwaddr[3] << 24) | (ses->st_hwaddr[2] << 16) |
+      (ses->st_hwaddr[1] << 8) | ses->st_hwaddr[0];
+    ETH->MACFFR = ETH_MACFFR_PAM;
+    ETH->MACCR = ETH_MACCR_IPCO | ETH_MACCR_FES | ETH_MACCR_DM;
+
+    /*
+     * With coalescing, frames don't signal completion one by one; the
+     * receive watchdog (in units of 256 HCLK cycles) fires instead.
+     */
+    rswt = MYNEWT_VAL(STM32F4_ETH_RX_COALESCE_USECS) * (hclk / 1000000) / 256;
+    if (rswt > 0xff) {
+        rswt = 0xff;
+    }
+    if (rswt) {
+        ses->st_rx_ctrl = ETH_DMARXDESC_DIC;
+        ETH->DMARSWTR = rswt;
+    }
+
+    for (i = 0; i < STM32F4_ETH_RX_CNT; i++) {
+        p = stm32f4_eth_rx_alloc();
+        if (!p) {
+            while (--i >= 0) {
+                pbuf_free(ses->st_rx_pbuf[i]);
+                ses->st_rx_pbuf[i] = NULL;
+            }
+            return ERR_MEM;
+        }
+        stm32f4_eth_rx_give(ses, i, p);
+    }
+    for (i = 0; i < STM32F4_ETH_TX_CNT; i++) {
+        stm32f4_eth_tx_desc[i].sed_status =
+          (i == STM32F4_ETH_TX_CNT - 1) ? ETH_DMATXDESC_TER : 0;
+    }
+    ses->st_rx_idx = 0;
+    ses->st_tx_head = ses->st_tx_tail = ses->st_tx_cnt = 0;
+
+    ETH->DMABMR = ETH_DMABMR_AAB | ETH_DMABMR_FB | ETH_DMABMR_USP |
+      ETH_DMABMR_RDP_32Beat | ETH_DMABMR_PBL_32Beat;
+    ETH->DMARDLAR = (uint32_t)stm32f4_eth_rx_desc;
+    ETH->DMATDLAR = (uint32_t)stm32f4_eth_tx_desc;
+    /* Checksum insertion needs store and forward. */
+    ETH->DMAOMR = ETH_DMAOMR_RSF | ETH_DMAOMR_TSF | ETH_DMAOMR_OSF;
+    ETH->DMAIER = ETH_DMAIER_NISE | ETH_DMAIER_RIE | ETH_DMAIER_TIE;
+
     NVIC_SetVector(ETH_IRQn, (uint32_t)stm32f4_eth_isr);
     NVIC_EnableIRQ(ETH_IRQn);
-    __HAL_RCC_ETH_CLK_ENABLE();
 
-    ses->st_eth.Instance = ETH;
-    ses->st_eth.Init.MACAddr = { 0, 1, 2, 3, 4, 5 };
-    ses->st_eth.Init.Autonegotiation = ETH_AUTONEGOTIATION_ENABLE;
-    ses->st_eth.Init.Speed = ETH_SPEED_100M;
-    ses->st_eth.Init.DuplexMode = ETH_MODE_FULLDUPLEX;
-    ses->st_eth.Init.PhyAddress = 0;
-    ses->st_eth.Init.RxMode = ETH_RXINTERRUPT_MODE;
-    ses->st_eth.Init.ChecksumMode = ETH_CHECKSUM_BY_HARDWARE;
-    ses->st_eth.Init.MediaInterface = ETH_MEDIA_INTERFACE_RMII;
+    ETH->MACCR |= ETH_MACCR_TE;
+    ETH->DMAOMR |= ETH_DMAOMR_FTF;
+    while (ETH->DMAOMR & ETH_DMAOMR_FTF);
+    ETH->DMAOMR |= ETH_DMAOMR_ST;
+    ETH->MACCR |= ETH_MACCR_RE;
+    ETH->DMAOMR |= ETH_DMAOMR_SR;
 
     return ERR_OK;
 }
@@ -725,16 +699,27 @@ stm32f4_eth_open(void)
     struct netif *nif;
     struct ip4_addr addr;
 
-    if (ses->cfg == NULL) {
+    if (ses->st_cfg == NULL) {
         return -1;
     }
 
+    ses->st_poll_msg = tcpip_callbackmsg_new(stm32f4_eth_poll, ses);
+    if (!ses->st_poll_msg) {
+        return -1;
+    }
+    os_callout_init(&ses->st_retry, os_eventq_dflt_get(), stm32f4_eth_retry,
+      ses);
+
     /*
      * Register network interface with LwIP.
      */
     memset(&addr, 0, sizeof(addr));
-    nif = netif_add(&ses->nif, &addr, &addr, &addr, NULL, stm32f4_lwip_init,
-      ethernet_input);
-    assert(nif);
+    nif = netif_add(&ses->st_nif, &addr, &addr, &addr, NULL,
+      stm32f4_lwip_init, ethernet_input);
+    if (!nif) {
+        tcpip_callbackmsg_delete(ses->st_poll_msg);
+        return -1;
+    }
+    tcpip_callback(stm32f4_eth_link_poll, ses);
     return 0;
 }
@@ -25,6 +25,8 @@
 #include "nimble/ble.h"
 #include "nimble/nimble_opt.h"
 #include "controller/ble_hw.h"
+#include "tinycrypt/aes.h"
+#include "tinycrypt/constants.h"
 
 /* Total number of white list elements supported by nrf52 */
 #define BLE_HW_WHITE_LIST_SIZE      (0)
@@ -111,11 +113,25 @@ ble_hw_whitelist_match(void)
     return 0;
 }
 
-/* Encrypt data */
+/*
+ * Encrypt data.  There is no ECB peripheral to use, so the block is
+ * encrypted in software.  Key and data are in the same byte order the
+ * Nordic ECB expects, which is also tinycrypt's.
+ */
 int
 ble_hw_encrypt_block(struct ble_encryption_block *ecb)
 {
-    return -1;
+    struct tc_aes_key_sched_struct sched;
+
+    if (tc_aes128_set_encrypt_key(&sched, ecb->key) != TC_CRYPTO_SUCCESS) {
+        return -1;
+    }
+    if (tc_aes_encrypt(ecb->cipher_text, ecb->plain_text,
+                       &sched) != TC_CRYPTO_SUCCESS) {
+        return -1;
+    }
+
+    return 0;
 }
 
 /**
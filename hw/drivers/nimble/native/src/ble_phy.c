@@ -588,6 +588,19 @@ ble_phy_max_data_pdu_pyld(void)
     return BLE_LL_DATA_PDU_MAX_PYLD;
 }
 
+/* Whitelist filtering in the radio is not supported; PDUs are always passed
+ * up to the link layer.
+ */
+void
+ble_phy_wl_filter_enable(void)
+{
+}
+
+void
+ble_phy_wl_filter_disable(void)
+{
+}
+
 #if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY) == 1)
 void
 ble_phy_resolv_list_enable(void)
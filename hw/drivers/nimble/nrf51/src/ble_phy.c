@@ -582,6 +582,8 @@ ble_phy_isr(void)
 {
     uint32_t irq_en;
 
+    OS_TRACE_ISR_ENTER(RADIO_IRQn);
+
     /* Read irq register to determine which interrupts are enabled */
     irq_en = NRF_RADIO->INTENCLR;
 
@@ -605,6 +607,8 @@ ble_phy_isr(void)
 
     /* Count # of interrupts */
     STATS_INC(ble_phy_stats, phy_isrs);
+
+    OS_TRACE_ISR_EXIT(RADIO_IRQn);
 }
 
 /**
@@ -1188,6 +1192,19 @@ ble_phy_max_data_pdu_pyld(void)
 #endif
 }
 
+/* Whitelist filtering in the radio is not supported; PDUs are always passed
+ * up to the link layer.
+ */
+void
+ble_phy_wl_filter_enable(void)
+{
+}
+
+void
+ble_phy_wl_filter_disable(void)
+{
+}
+
 #if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY) == 1)
 void
 ble_phy_resolv_list_enable(void)
@@ -61,6 +61,14 @@ extern uint32_t g_nrf_irk_list[];
 #define NRF_TX_PWR_MAX_DBM      (4)
 #define NRF_TX_PWR_MIN_DBM      (-40)
 
+/*
+ * Programmable PPI channel used to abort reception on a device address
+ * mismatch (RADIO->EVENTS_DEVMISS -> RADIO->TASKS_DISABLE) when whitelist
+ * filtering is done by the radio.
+ */
+#define NRF_PPI_CH_DEVMISS      (4)
+#define NRF_PPI_CH_DEVMISS_Msk  (1UL << NRF_PPI_CH_DEVMISS)
+
 /* BLE PHY data structure */
 struct ble_phy_obj
 {
@@ -72,6 +80,7 @@ struct ble_phy_obj
     uint8_t phy_rx_started;
     uint8_t phy_encrypted;
     uint8_t phy_privacy;
+    uint8_t phy_wl_filter;
     uint8_t phy_tx_pyld_len;
     uint32_t phy_aar_scratch;
     uint32_t phy_access_address;
@@ -337,23 +346,42 @@ ble_phy_rx_xcvr_setup(void)
     NRF_RADIO->BCC = 8; /* in bits */
     NRF_RADIO->EVENTS_ADDRESS = 0;
     NRF_RADIO->EVENTS_DEVMATCH = 0;
+    NRF_RADIO->EVENTS_DEVMISS = 0;
     NRF_RADIO->EVENTS_BCMATCH = 0;
     NRF_RADIO->EVENTS_RSSIEND = 0;
-    NRF_RADIO->SHORTS = RADIO_SHORTS_END_DISABLE_Msk |
-                        RADIO_SHORTS_READY_START_Msk |
-                        RADIO_SHORTS_DISABLED_TXEN_Msk |
-                        RADIO_SHORTS_ADDRESS_BCSTART_Msk |
-                        RADIO_SHORTS_ADDRESS_RSSISTART_Msk |
-                        RADIO_SHORTS_DISABLED_RSSISTOP_Msk;
-
-    NRF_RADIO->INTENSET = RADIO_INTENSET_ADDRESS_Msk;
+
+    /*
+     * When the radio does the whitelist filtering, a device address mismatch
+     * disables the radio, which immediately re-enables the receiver. The
+     * cpu is only interrupted on a match; the rx start isr then restores the
+     * normal disabled to TXEN shortcut.
+     */
+    if (g_ble_phy_data.phy_wl_filter) {
+        NRF_RADIO->SHORTS = RADIO_SHORTS_END_DISABLE_Msk |
+                            RADIO_SHORTS_READY_START_Msk |
+                            RADIO_SHORTS_DISABLED_RXEN_Msk |
+                            RADIO_SHORTS_ADDRESS_BCSTART_Msk |
+                            RADIO_SHORTS_ADDRESS_RSSISTART_Msk |
+                            RADIO_SHORTS_DISABLED_RSSISTOP_Msk;
+        NRF_PPI->CHENSET = NRF_PPI_CH_DEVMISS_Msk;
+        NRF_RADIO->INTENSET = RADIO_INTENSET_DEVMATCH_Msk;
+    } else {
+        NRF_RADIO->SHORTS = RADIO_SHORTS_END_DISABLE_Msk |
+                            RADIO_SHORTS_READY_START_Msk |
+                            RADIO_SHORTS_DISABLED_TXEN_Msk |
+                            RADIO_SHORTS_ADDRESS_BCSTART_Msk |
+                            RADIO_SHORTS_ADDRESS_RSSISTART_Msk |
+                            RADIO_SHORTS_DISABLED_RSSISTOP_Msk;
+        NRF_PPI->CHENCLR = NRF_PPI_CH_DEVMISS_Msk;
+        NRF_RADIO->INTENSET = RADIO_INTENSET_ADDRESS_Msk;
+    }
 }
 
 /**
  * Called from interrupt context when the transmit ends
  *
  */
-static void
+static OS_RAMFUNC void
 ble_phy_tx_end_isr(void)
 {
     uint8_t was_encrypted;
@@ -427,7 +455,7 @@ ble_phy_tx_end_isr(void)
     }
 }
 
-static void
+static OS_RAMFUNC void
 ble_phy_rx_end_isr(void)
 {
     int rc;
@@ -501,7 +529,7 @@ ble_phy_rx_end_isr(void)
     }
 }
 
-static void
+static OS_RAMFUNC void
 ble_phy_rx_start_isr(void)
 {
     int rc;
@@ -512,6 +540,20 @@ ble_phy_rx_start_isr(void)
     NRF_RADIO->EVENTS_ADDRESS = 0;
     NRF_RADIO->INTENCLR = RADIO_INTENCLR_ADDRESS_Msk;
 
+    /*
+     * If the radio is filtering, we got here on a device address match. Stop
+     * aborting on mismatches and go back to the disabled to TXEN shortcut
+     * so a response can be sent. The match event is left set; the link layer
+     * reads it when checking the whitelist.
+     */
+    if (g_ble_phy_data.phy_wl_filter) {
+        NRF_RADIO->INTENCLR = RADIO_INTENCLR_DEVMATCH_Msk;
+        NRF_PPI->CHENCLR = NRF_PPI_CH_DEVMISS_Msk;
+        NRF_RADIO->SHORTS = (NRF_RADIO->SHORTS &
+                             ~RADIO_SHORTS_DISABLED_RXEN_Msk) |
+                            RADIO_SHORTS_DISABLED_TXEN_Msk;
+    }
+
     /* Wait to get 1st byte of frame */
     while (1) {
         state = NRF_RADIO->STATE;
@@ -565,11 +607,13 @@ ble_phy_rx_start_isr(void)
     STATS_INC(ble_phy_stats, rx_starts);
 }
 
-static void
+static OS_RAMFUNC void
 ble_phy_isr(void)
 {
     uint32_t irq_en;
 
+    OS_TRACE_ISR_ENTER(RADIO_IRQn);
+
     /* Read irq register to determine which interrupts are enabled */
     irq_en = NRF_RADIO->INTENCLR;
 
@@ -583,6 +627,11 @@ ble_phy_isr(void)
         ble_phy_rx_start_isr();
     }
 
+    /* Same, but the radio is filtering and the device address matched */
+    if ((irq_en & RADIO_INTENCLR_DEVMATCH_Msk) && NRF_RADIO->EVENTS_DEVMATCH) {
+        ble_phy_rx_start_isr();
+    }
+
     /* Receive packet end (we dont enable this for transmit) */
     if ((irq_en & RADIO_INTENCLR_END_Msk) && NRF_RADIO->EVENTS_END) {
         ble_phy_rx_end_isr();
@@ -593,6 +642,8 @@ ble_phy_isr(void)
 
     /* Count # of interrupts */
     STATS_INC(ble_phy_stats, phy_isrs);
+
+    OS_TRACE_ISR_EXIT(RADIO_IRQn);
 }
 
 /**
@@ -660,6 +711,11 @@ ble_phy_init(void)
     /* Captures tx/rx start in timer0 capture 1 */
     NRF_PPI->CHENSET = PPI_CHEN_CH26_Msk;
 
+    /* Aborts reception on device address mismatch; enabled per rx */
+    NRF_PPI->CH[NRF_PPI_CH_DEVMISS].EEP = (uint32_t)&NRF_RADIO->EVENTS_DEVMISS;
+    NRF_PPI->CH[NRF_PPI_CH_DEVMISS].TEP = (uint32_t)&NRF_RADIO->TASKS_DISABLE;
+    NRF_PPI->CHENCLR = NRF_PPI_CH_DEVMISS_Msk;
+
 #if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_ENCRYPTION) == 1)
     NRF_CCM->INTENCLR = 0xffffffff;
     NRF_CCM->SHORTS = CCM_SHORTS_ENDKSGEN_CRYPT_Msk;
@@ -1095,7 +1151,8 @@ ble_phy_disable(void)
     NRF_RADIO->INTENCLR = NRF_RADIO_IRQ_MASK_ALL;
     NRF_RADIO->SHORTS = 0;
     NRF_RADIO->TASKS_DISABLE = 1;
-    NRF_PPI->CHENCLR = PPI_CHEN_CH23_Msk | PPI_CHEN_CH21_Msk | PPI_CHEN_CH20_Msk;
+    NRF_PPI->CHENCLR = PPI_CHEN_CH23_Msk | PPI_CHEN_CH21_Msk |
+                       PPI_CHEN_CH20_Msk | NRF_PPI_CH_DEVMISS_Msk;
     NVIC_ClearPendingIRQ(RADIO_IRQn);
     g_ble_phy_data.phy_state = BLE_PHY_STATE_IDLE;
 }
@@ -1154,6 +1211,18 @@ ble_phy_max_data_pdu_pyld(void)
     return BLE_LL_DATA_PDU_MAX_PYLD;
 }
 
+void
+ble_phy_wl_filter_enable(void)
+{
+    g_ble_phy_data.phy_wl_filter = 1;
+}
+
+void
+ble_phy_wl_filter_disable(void)
+{
+    g_ble_phy_data.phy_wl_filter = 0;
+}
+
 #if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY) == 1)
 void
 ble_phy_resolv_list_enable(void)
@@ -0,0 +1,102 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __DRIVERS_SPI_H_
+#define __DRIVERS_SPI_H_
+
+#include <inttypes.h>
+#include <os/os.h>
+#include <os/os_dev.h>
+#include <hal/hal_spi.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct spi_dev;
+
+/*
+ * Peripheral attached to the bus. Bus is reconfigured with sn_settings
+ * when it switches to a transaction from a different node.
+ */
+struct spi_node {
+    struct spi_dev *sn_bus;
+    int sn_cs_pin;              /* chip select, active low; -1 if none */
+    struct hal_spi_settings sn_settings;
+};
+
+/*
+ * One transfer of st_len values. st_txbuf must not be NULL; st_rxbuf can
+ * be NULL if received data is not needed.
+ *
+ * Transactions linked with st_chain are run back to back with chip select
+ * held asserted; only the head of the chain is submitted. When the whole
+ * chain is done, st_status of the head is set and st_ev is posted to
+ * st_evq, with ev_arg pointing to the head. Caller fills in st_ev.ev_cb.
+ * st_evq can be NULL if no event is wanted.
+ */
+struct spi_txn {
+    STAILQ_ENTRY(spi_txn) st_next;
+    struct spi_txn *st_chain;
+    struct spi_node *st_node;
+    void *st_txbuf;
+    void *st_rxbuf;
+    uint16_t st_len;
+    int st_status;              /* OS_EBUSY until done */
+    struct os_eventq *st_evq;
+    struct os_event st_ev;
+};
+
+struct spi_dev {
+    struct os_dev sd_dev;
+    int sd_unit;
+    STAILQ_HEAD(, spi_txn) sd_txq;
+    struct spi_txn *sd_cur;     /* head of chain being transferred */
+    struct spi_txn *sd_seg;     /* part of the chain being transferred */
+    struct spi_node *sd_node;   /* node whose settings are in use */
+};
+
+/*
+ * Initialize os_dev for SPI master. Device name must end with SPI
+ * number, e.g. "spi0". Arg points to BSP specific SPI configuration,
+ * which is passed to hal_spi_init().
+ */
+int spi_hal_init(struct os_dev *odev, void *arg);
+
+/*
+ * Attach a peripheral to a bus. Bus must have been opened with
+ * os_dev_open(). Chip select pin is configured as output, and deasserted.
+ */
+int spi_node_init(struct spi_node *node, struct spi_dev *bus, int cs_pin,
+  const struct hal_spi_settings *settings);
+
+/*
+ * Queue transaction (chain) for transfer. Can be called from interrupt
+ * context. Transaction, and its buffers, must stay valid until it has
+ * completed.
+ *
+ * @return		0 if queued, OS_EINVAL on bad parameters.
+ */
+int spi_txn_submit(struct spi_txn *txn);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __DRIVERS_SPI_H_ */
@@ -0,0 +1,276 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <ctype.h>
+#include <assert.h>
+#include <string.h>
+
+#include <os/os.h>
+#include <os/os_dev.h>
+#include <hal/hal_gpio.h>
+#include <hal/hal_spi.h>
+
+#include "spi/spi.h"
+
+static void spi_start(struct spi_dev *dev);
+
+static void
+spi_cs_set(struct spi_node *node, int val)
+{
+    if (node->sn_cs_pin >= 0) {
+        hal_gpio_write(node->sn_cs_pin, val);
+    }
+}
+
+static void
+spi_txn_done(struct spi_txn *txn, int status)
+{
+    txn->st_status = status;
+    if (txn->st_evq) {
+        txn->st_ev.ev_arg = txn;
+        os_eventq_put(txn->st_evq, &txn->st_ev);
+    }
+}
+
+/*
+ * Called with interrupts disabled.
+ */
+static void
+spi_end(struct spi_dev *dev, int status)
+{
+    struct spi_txn *txn;
+
+    txn = dev->sd_cur;
+    spi_cs_set(txn->st_node, 1);
+    dev->sd_cur = NULL;
+    dev->sd_seg = NULL;
+    spi_txn_done(txn, status);
+#if MYNEWT_VAL(OS_PM)
+    os_pm_dev_idle(&dev->sd_dev);
+#endif
+}
+
+/*
+ * Called from interrupt context when a part of the chain is done.
+ */
+static void
+spi_txrx_cb(void *arg, int len)
+{
+    struct spi_dev *dev;
+    struct spi_txn *seg;
+    int rc;
+
+    dev = arg;
+    seg = dev->sd_seg;
+    if (!seg) {
+        return;
+    }
+    seg = seg->st_chain;
+    if (seg) {
+        dev->sd_seg = seg;
+        rc = hal_spi_txrx_noblock(dev->sd_unit, seg->st_txbuf, seg->st_rxbuf,
+          seg->st_len);
+        if (rc == 0) {
+            return;
+        }
+        spi_end(dev, OS_EINVAL);
+    } else {
+        spi_end(dev, OS_OK);
+    }
+    spi_start(dev);
+}
+
+/*
+ * Start the next queued transaction, if bus is idle.
+ * Called with interrupts disabled.
+ */
+static void
+spi_start(struct spi_dev *dev)
+{
+    struct spi_txn *txn;
+    struct spi_node *node;
+    int rc;
+
+    while (!dev->sd_cur && (txn = STAILQ_FIRST(&dev->sd_txq))) {
+        STAILQ_REMOVE_HEAD(&dev->sd_txq, st_next);
+
+        node = txn->st_node;
+        if (node != dev->sd_node) {
+            hal_spi_disable(dev->sd_unit);
+            rc = hal_spi_config(dev->sd_unit, &node->sn_settings);
+            hal_spi_enable(dev->sd_unit);
+            if (rc) {
+                dev->sd_node = NULL;
+                spi_txn_done(txn, OS_EINVAL);
+#if MYNEWT_VAL(OS_PM)
+                os_pm_dev_idle(&dev->sd_dev);
+#endif
+                continue;
+            }
+            dev->sd_node = node;
+        }
+
+        dev->sd_cur = txn;
+        dev->sd_seg = txn;
+        spi_cs_set(node, 0);
+        rc = hal_spi_txrx_noblock(dev->sd_unit, txn->st_txbuf, txn->st_rxbuf,
+          txn->st_len);
+        if (rc) {
+            spi_end(dev, OS_EINVAL);
+        }
+    }
+}
+
+int
+spi_txn_submit(struct spi_txn *txn)
+{
+    struct spi_dev *dev;
+    struct spi_txn *seg;
+    os_sr_t sr;
+
+    if (!txn->st_node) {
+        return OS_EINVAL;
+    }
+    for (seg = txn; seg; seg = seg->st_chain) {
+        if (!seg->st_txbuf || seg->st_len == 0) {
+            return OS_EINVAL;
+        }
+    }
+    dev = txn->st_node->sn_bus;
+    if (!(dev->sd_dev.od_flags & OS_DEV_F_STATUS_OPEN)) {
+        return OS_EINVAL;
+    }
+
+    txn->st_status = OS_EBUSY;
+
+    OS_ENTER_CRITICAL(sr);
+#if MYNEWT_VAL(OS_PM)
+    /* Bus is kept active from submit until the transaction completes */
+    os_pm_dev_active(&dev->sd_dev);
+#endif
+    STAILQ_INSERT_TAIL(&dev->sd_txq, txn, st_next);
+    spi_start(dev);
+    OS_EXIT_CRITICAL(sr);
+
+    return OS_OK;
+}
+
+int
+spi_node_init(struct spi_node *node, struct spi_dev *bus, int cs_pin,
+  const struct hal_spi_settings *settings)
+{
+    if (!bus || !settings) {
+        return OS_EINVAL;
+    }
+    node->sn_bus = bus;
+    node->sn_cs_pin = cs_pin;
+    node->sn_settings = *settings;
+    if (cs_pin >= 0) {
+        if (hal_gpio_init_out(cs_pin, 1)) {
+            return OS_EINVAL;
+        }
+    }
+    return OS_OK;
+}
+
+static int
+spi_hal_open(struct os_dev *odev, uint32_t wait, void *arg)
+{
+    struct spi_dev *dev;
+    int rc;
+
+    dev = (struct spi_dev *)odev;
+
+    /*
+     * Bus is shared by all the nodes on it; set it up only on first open.
+     */
+    if (odev->od_flags & OS_DEV_F_STATUS_OPEN) {
+        return OS_OK;
+    }
+    rc = hal_spi_set_txrx_cb(dev->sd_unit, spi_txrx_cb, dev);
+    if (rc) {
+        return OS_EINVAL;
+    }
+    dev->sd_node = NULL;
+    return OS_OK;
+}
+
+static int
+spi_hal_close(struct os_dev *odev)
+{
+    struct spi_dev *dev;
+
+    dev = (struct spi_dev *)odev;
+
+    if (odev->od_open_ref == 1) {
+        if (dev->sd_cur || !STAILQ_EMPTY(&dev->sd_txq)) {
+            return OS_EBUSY;
+        }
+        hal_spi_disable(dev->sd_unit);
+    }
+    return OS_OK;
+}
+
+#if MYNEWT_VAL(OS_PM)
+/*
+ * SPI is only enabled while it has transactions queued.
+ */
+static void
+spi_hal_clock(struct os_dev *odev, int on)
+{
+    struct spi_dev *dev;
+
+    dev = (struct spi_dev *)odev;
+    if (on) {
+        hal_spi_enable(dev->sd_unit);
+    } else {
+        hal_spi_disable(dev->sd_unit);
+    }
+}
+#endif
+
+int
+spi_hal_init(struct os_dev *odev, void *arg)
+{
+    struct spi_dev *dev;
+    char ch;
+
+    dev = (struct spi_dev *)odev;
+
+    ch = odev->od_name[strlen(odev->od_name) - 1];
+    if (!isdigit((int) ch)) {
+        return OS_EINVAL;
+    }
+    dev->sd_unit = ch - '0';
+    STAILQ_INIT(&dev->sd_txq);
+    dev->sd_cur = NULL;
+    dev->sd_seg = NULL;
+    dev->sd_node = NULL;
+
+    if (hal_spi_init(dev->sd_unit, arg, HAL_SPI_TYPE_MASTER)) {
+        return OS_EINVAL;
+    }
+
+    OS_DEV_SETHANDLERS(odev, spi_hal_open, spi_hal_close);
+#if MYNEWT_VAL(OS_PM)
+    odev->od_handlers.od_clock = spi_hal_clock;
+#endif
+
+    return OS_OK;
+}
@@ -25,6 +25,7 @@ extern "C" {
 #endif
 
 #include <inttypes.h>
+#include "os/os_eventq.h"
 
 int hal_flash_read(uint8_t flash_id, uint32_t address, void *dst,
   uint32_t num_bytes);
@@ -33,8 +34,46 @@ int hal_flash_write(uint8_t flash_id, uint32_t address, const void *src,
 int hal_flash_erase_sector(uint8_t flash_id, uint32_t sector_address);
 int hal_flash_erase(uint8_t flash_id, uint32_t address, uint32_t num_bytes);
 uint8_t hal_flash_align(uint8_t flash_id);
+const void *hal_flash_map(uint8_t flash_id, uint32_t address,
+  uint32_t num_bytes);
 int hal_flash_init(void);
 
+/*
+ * Completion callback of asynchronous driver operations. Status is 0 on
+ * success. Called from interrupt context.
+ */
+typedef void (*hal_flash_done_cb)(void *arg, int status);
+
+#define HAL_FLASH_OP_WRITE              1
+#define HAL_FLASH_OP_ERASE_SECTOR       2
+
+/*
+ * Queued flash operation. Operations are run one at a time, in the order
+ * they were submitted. When an operation is done, hfo_status is set and
+ * hfo_ev is posted to hfo_evq, with ev_arg pointing to the operation.
+ * Caller fills in hfo_ev.ev_cb; hfo_evq can be NULL.
+ *
+ * Flash drivers which can run writes and erases in the background do so,
+ * and the submitting task continues right away. With other drivers the
+ * operation runs synchronously before hal_flash_op_submit() returns.
+ */
+struct hal_flash_op {
+    STAILQ_ENTRY(hal_flash_op) hfo_next;
+    uint8_t hfo_type;
+    uint8_t hfo_flash_id;
+    uint32_t hfo_addr;
+    const void *hfo_src;        /* HAL_FLASH_OP_WRITE only */
+    uint32_t hfo_len;           /* HAL_FLASH_OP_WRITE only */
+    int hfo_status;             /* -1 until done */
+    struct os_eventq *hfo_evq;
+    struct os_event hfo_ev;
+};
+
+/*
+ * Queue operation. Operation, and the data to write, must stay valid until
+ * the completion event has been posted.
+ */
+int hal_flash_op_submit(struct hal_flash_op *op);
 
 #ifdef __cplusplus
 }
@@ -25,6 +25,7 @@ extern "C" {
 #endif
 
 #include <inttypes.h>
+#include "hal/hal_flash.h"
 
 /*
  * API that flash driver has to implement.
@@ -35,6 +36,20 @@ struct hal_flash_funcs {
     int (*hff_erase_sector)(uint32_t sector_address);
     int (*hff_sector_info)(int idx, uint32_t *address, uint32_t *size);
     int (*hff_init)(void);
+    /*
+     * Optional; returns a CPU-readable pointer to the contents at address if
+     * the device is memory mapped.  NULL if reads must go through hff_read.
+     */
+    const void *(*hff_map)(uint32_t address);
+    /*
+     * Optional; start a write or erase and return without waiting for it.
+     * cb is called from interrupt context when the operation completes.
+     * hal_flash_op_submit() falls back to hff_write/hff_erase_sector if NULL.
+     */
+    int (*hff_write_async)(uint32_t address, const void *src,
+      uint32_t num_bytes, hal_flash_done_cb cb, void *arg);
+    int (*hff_erase_sector_async)(uint32_t sector_address,
+      hal_flash_done_cb cb, void *arg);
 };
 
 struct hal_flash {
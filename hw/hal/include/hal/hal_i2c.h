@@ -133,6 +133,37 @@ int hal_i2c_master_read(uint8_t i2c_num, struct hal_i2c_master_data *pdata,
 int hal_i2c_master_probe(uint8_t i2c_num, uint8_t address,
                          uint32_t timeout);
 
+/**
+ * Completion callback for hal_i2c_master_xfer_noblock(). Status is 0 on
+ * success, non-zero if the transfer failed (e.g. no ACK from the device).
+ * Called from interrupt context.
+ */
+typedef void (*hal_i2c_master_cb)(void *arg, int status);
+
+/**
+ * Non-blocking write followed by read. Issues a start condition, writes
+ * wdata, issues a repeated start, reads rdata and finally a stop
+ * condition. Either wdata or rdata can be NULL, in which case only the
+ * other one is done. The callback is called after the stop condition.
+ *
+ * Buffers must stay valid until the callback is called, and the blocking
+ * calls must not be used on the bus while the transfer is in progress.
+ *
+ * Only implemented by MCUs with interrupt driven I2C.
+ *
+ * @param i2c_num The number of the I2C device
+ * @param wdata Data to write, or NULL
+ * @param rdata Where to place read data, or NULL
+ * @param cb Completion callback
+ * @param arg Argument passed to the callback
+ *
+ * @return 0 if transfer was started, non-zero error code on failure
+ */
+int hal_i2c_master_xfer_noblock(uint8_t i2c_num,
+                                struct hal_i2c_master_data *wdata,
+                                struct hal_i2c_master_data *rdata,
+                                hal_i2c_master_cb cb, void *arg);
+
 #ifdef __cplusplus
 }
 #endif
@@ -118,6 +118,65 @@ void hal_uart_start_rx(int uart);
  */
 void hal_uart_blocking_tx(int uart, uint8_t byte);
 
+/*
+ * Function prototype for UART driver to report that a buffer passed to
+ * hal_uart_dma_tx() or hal_uart_dma_rx() has been completely transmitted
+ * or filled.
+ * Driver calls this from interrupt context.
+ */
+typedef void (*hal_uart_dma_done)(void *arg);
+
+/**
+ * hal uart dma init cbs
+ *
+ * Optional buffer based interface for UARTs which can move whole buffers
+ * by DMA. Used instead of hal_uart_init_cbs(); when configured this way the
+ * driver does not call the per character callbacks and does not receive
+ * data until hal_uart_dma_rx() is called. Hardware flow control should be
+ * enabled so that no data is lost between two receive buffers.
+ *
+ * Only implemented by MCUs with DMA capable UARTs.
+ */
+int hal_uart_dma_init_cbs(int uart, hal_uart_dma_done tx_done,
+  hal_uart_dma_done rx_done, void *arg);
+
+/**
+ * hal uart dma tx
+ *
+ * Start transmitting len bytes from buf. The buffer must stay valid until
+ * the tx_done callback is called. Returns -1 if the length is larger than
+ * the driver can handle in one transfer.
+ */
+int hal_uart_dma_tx(int uart, const uint8_t *buf, uint16_t len);
+
+/**
+ * hal uart dma rx
+ *
+ * Receive exactly len bytes into buf. The rx_done callback is called once
+ * the buffer is full. Returns -1 if the length is larger than the driver
+ * can handle in one transfer.
+ */
+int hal_uart_dma_rx(int uart, uint8_t *buf, uint16_t len);
+
+/**
+ * hal uart dma set rx idle cb
+ *
+ * Register a callback which is called when the receive line goes idle
+ * while the current receive buffer is only partially filled. The caller
+ * typically uses hal_uart_dma_rx_stop() from the callback to collect the
+ * bytes received so far. Returns -1 if the driver cannot detect idle line.
+ */
+int hal_uart_dma_set_rx_idle_cb(int uart, hal_uart_dma_done rx_idle);
+
+/**
+ * hal uart dma rx stop
+ *
+ * Stop the receive started with hal_uart_dma_rx() before the buffer is
+ * full. The rx_done callback is not called for a stopped buffer. Returns
+ * the number of bytes written to the buffer, or -1 on error.
+ */
+int hal_uart_dma_rx_stop(int uart);
+
 #ifdef __cplusplus
 }
 #endif
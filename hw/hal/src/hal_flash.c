@@ -16,10 +16,12 @@
  * specific language governing permissions and limitations
  * under the License.
  */
+#include <stddef.h>
 #include <inttypes.h>
 #include <assert.h>
 #include <bsp/bsp.h>
 
+#include "os/os.h"
 #include "hal/hal_bsp.h"
 #include "hal/hal_flash.h"
 #include "hal/hal_flash_int.h"
@@ -92,6 +94,27 @@ hal_flash_read(uint8_t id, uint32_t address, void *dst, uint32_t num_bytes)
     return hf->hf_itf->hff_read(address, dst, num_bytes);
 }
 
+/*
+ * Returns a pointer through which the given range can be read directly, or
+ * NULL if the device is not memory mapped or the range is invalid.  Data read
+ * through the pointer is the same as what hal_flash_read() would return.
+ */
+const void *
+hal_flash_map(uint8_t id, uint32_t address, uint32_t num_bytes)
+{
+    const struct hal_flash *hf;
+
+    hf = hal_bsp_flash_dev(id);
+    if (!hf || !hf->hf_itf->hff_map) {
+        return NULL;
+    }
+    if (hal_flash_check_addr(hf, address) ||
+      hal_flash_check_addr(hf, address + num_bytes)) {
+        return NULL;
+    }
+    return hf->hf_itf->hff_map(address);
+}
+
 int
 hal_flash_write(uint8_t id, uint32_t address, const void *src,
   uint32_t num_bytes)
@@ -167,3 +190,148 @@ hal_flash_erase(uint8_t id, uint32_t address, uint32_t num_bytes)
     }
     return 0;
 }
+
+static STAILQ_HEAD(, hal_flash_op) hal_flash_op_q =
+    STAILQ_HEAD_INITIALIZER(hal_flash_op_q);
+static struct hal_flash_op *hal_flash_op_cur;
+
+static void hal_flash_op_run(void);
+
+static void
+hal_flash_op_kick(struct os_event *ev)
+{
+    hal_flash_op_run();
+}
+
+/*
+ * Used to continue with the next operation in task context, after an
+ * asynchronous one completes.
+ */
+static struct os_event hal_flash_op_kick_ev = {
+    .ev_cb = hal_flash_op_kick,
+};
+
+static void
+hal_flash_op_complete(struct hal_flash_op *op, int status)
+{
+    op->hfo_status = status;
+    if (op->hfo_evq) {
+        op->hfo_ev.ev_arg = op;
+        os_eventq_put(op->hfo_evq, &op->hfo_ev);
+    }
+}
+
+static void
+hal_flash_op_done(void *arg, int status)
+{
+    struct hal_flash_op *op;
+    int pending;
+    os_sr_t sr;
+
+    op = arg;
+
+    OS_ENTER_CRITICAL(sr);
+    hal_flash_op_cur = NULL;
+    pending = !STAILQ_EMPTY(&hal_flash_op_q);
+    OS_EXIT_CRITICAL(sr);
+
+    hal_flash_op_complete(op, status ? -1 : 0);
+    if (pending) {
+        os_eventq_put(os_eventq_dflt_get(), &hal_flash_op_kick_ev);
+    }
+}
+
+/*
+ * Returns 0 if the driver started the operation in the background.
+ */
+static int
+hal_flash_op_start_async(struct hal_flash_op *op)
+{
+    const struct hal_flash *hf;
+
+    hf = hal_bsp_flash_dev(op->hfo_flash_id);
+    if (!hf) {
+        return -1;
+    }
+    switch (op->hfo_type) {
+    case HAL_FLASH_OP_WRITE:
+        if (!hf->hf_itf->hff_write_async ||
+          hal_flash_check_addr(hf, op->hfo_addr) ||
+          hal_flash_check_addr(hf, op->hfo_addr + op->hfo_len)) {
+            return -1;
+        }
+        return hf->hf_itf->hff_write_async(op->hfo_addr, op->hfo_src,
+          op->hfo_len, hal_flash_op_done, op);
+    case HAL_FLASH_OP_ERASE_SECTOR:
+        if (!hf->hf_itf->hff_erase_sector_async ||
+          hal_flash_check_addr(hf, op->hfo_addr)) {
+            return -1;
+        }
+        return hf->hf_itf->hff_erase_sector_async(op->hfo_addr,
+          hal_flash_op_done, op);
+    default:
+        return -1;
+    }
+}
+
+static void
+hal_flash_op_run(void)
+{
+    struct hal_flash_op *op;
+    os_sr_t sr;
+    int rc;
+
+    while (1) {
+        OS_ENTER_CRITICAL(sr);
+        if (hal_flash_op_cur || STAILQ_EMPTY(&hal_flash_op_q)) {
+            OS_EXIT_CRITICAL(sr);
+            return;
+        }
+        op = STAILQ_FIRST(&hal_flash_op_q);
+        STAILQ_REMOVE_HEAD(&hal_flash_op_q, hfo_next);
+        hal_flash_op_cur = op;
+        OS_EXIT_CRITICAL(sr);
+
+        if (!hal_flash_op_start_async(op)) {
+            return;
+        }
+
+        /*
+         * Synchronous fallback.
+         */
+        if (op->hfo_type == HAL_FLASH_OP_WRITE) {
+            rc = hal_flash_write(op->hfo_flash_id, op->hfo_addr, op->hfo_src,
+              op->hfo_len);
+        } else {
+            rc = hal_flash_erase_sector(op->hfo_flash_id, op->hfo_addr);
+        }
+
+        OS_ENTER_CRITICAL(sr);
+        hal_flash_op_cur = NULL;
+        OS_EXIT_CRITICAL(sr);
+
+        hal_flash_op_complete(op, rc ? -1 : 0);
+    }
+}
+
+int
+hal_flash_op_submit(struct hal_flash_op *op)
+{
+    os_sr_t sr;
+
+    if (op->hfo_type != HAL_FLASH_OP_WRITE &&
+      op->hfo_type != HAL_FLASH_OP_ERASE_SECTOR) {
+        return -1;
+    }
+    if (!hal_bsp_flash_dev(op->hfo_flash_id)) {
+        return -1;
+    }
+    op->hfo_status = -1;
+
+    OS_ENTER_CRITICAL(sr);
+    STAILQ_INSERT_TAIL(&hal_flash_op_q, op, hfo_next);
+    OS_EXIT_CRITICAL(sr);
+
+    hal_flash_op_run();
+    return 0;
+}
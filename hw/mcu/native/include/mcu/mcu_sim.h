@@ -26,6 +26,7 @@ extern "C" {
 #define OS_TICKS_PER_SEC    (100)
 
 extern char *native_flash_file;
+extern char *native_flash_ext_file;
 extern char *native_uart_log_file;
 
 void mcu_sim_parse_args(int argc, char **argv);
@@ -19,11 +19,28 @@
 #ifndef H_NATIVE_BSP_
 #define H_NATIVE_BSP_
 
+#include <inttypes.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 extern const struct hal_flash native_flash_dev;
+extern const struct hal_flash native_flash_ext_dev;
+
+/* Operation counters of a simulated flash device. */
+struct native_flash_stats {
+    uint32_t nfs_reads;
+    uint32_t nfs_read_bytes;
+    uint32_t nfs_writes;
+    uint32_t nfs_write_bytes;
+    uint32_t nfs_erases;
+    uint32_t nfs_max_erase_cnt;     /* Highest erase count of any sector. */
+};
+
+int native_flash_stats_get(uint8_t flash_id,
+                           struct native_flash_stats *out_stats);
+int native_flash_sector_erase_cnt(uint8_t flash_id, int sector);
 
 #ifdef __cplusplus
 }
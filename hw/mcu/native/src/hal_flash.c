@@ -23,14 +23,42 @@
 #include <string.h>
 #include <inttypes.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include "syscfg/syscfg.h"
 #include "hal/hal_flash_int.h"
 #include "mcu/mcu_sim.h"
+#include "mcu/native_bsp.h"
 
 char *native_flash_file;
-static int file;
-static void *file_loc;
+char *native_flash_ext_file;
+
+/*
+ * State of a simulated flash device.  Internal flash (id 0) uses the fixed
+ * sector table below; the optional external device (id 1) has uniform
+ * sectors.
+ *
+ * A device without a backing file lives in anonymous memory, and its
+ * sectors are materialized lazily: a sector which has been erased and not
+ * written since is "pristine", reads as 0xff without touching memory, and is
+ * only filled in on its first write.  Erasing such a device gives the
+ * sector's memory back to the host.
+ */
+struct native_flash {
+    const struct hal_flash *nf_dev;
+    const uint32_t *nf_sectors;     /* NULL if sectors are uniform. */
+    uint32_t nf_sector_size;
+    char **nf_file_name;
+    int nf_file;
+    char *nf_loc;
+    uint8_t *nf_pristine;           /* Bitmap, NULL if not lazy. */
+    uint32_t *nf_erase_cnt;         /* Per sector. */
+    struct native_flash_stats nf_stats;
+};
 
 static int native_flash_init(void);
+static const void *native_flash_map(uint32_t address);
 static int native_flash_read(uint32_t address, void *dst, uint32_t length);
 static int native_flash_write(uint32_t address, const void *src,
   uint32_t length);
@@ -42,7 +70,8 @@ static const struct hal_flash_funcs native_flash_funcs = {
     .hff_write = native_flash_write,
     .hff_erase_sector = native_flash_erase_sector,
     .hff_sector_info = native_flash_sector_info,
-    .hff_init = native_flash_init
+    .hff_init = native_flash_init,
+    .hff_map = native_flash_map
 };
 
 static const uint32_t native_flash_sectors[] = {
@@ -71,56 +100,258 @@ const struct hal_flash native_flash_dev = {
     .hf_align = 1
 };
 
+static uint32_t native_flash_erase_cnt[FLASH_NUM_AREAS];
+
+#if MYNEWT_VAL(NATIVE_FLASH_EXT_SIZE) > 0
+
+#define FLASH_EXT_NUM_SECTORS                                           \
+    (MYNEWT_VAL(NATIVE_FLASH_EXT_SIZE) /                                \
+     MYNEWT_VAL(NATIVE_FLASH_EXT_SECTOR_SIZE))
+
+static int native_flash_ext_init(void);
+static int native_flash_ext_read(uint32_t address, void *dst,
+  uint32_t length);
+static int native_flash_ext_write(uint32_t address, const void *src,
+  uint32_t length);
+static int native_flash_ext_erase_sector(uint32_t sector_address);
+static int native_flash_ext_sector_info(int idx, uint32_t *address,
+  uint32_t *size);
+
+/* No hff_map; the contents of a lazy device are not all in memory. */
+static const struct hal_flash_funcs native_flash_ext_funcs = {
+    .hff_read = native_flash_ext_read,
+    .hff_write = native_flash_ext_write,
+    .hff_erase_sector = native_flash_ext_erase_sector,
+    .hff_sector_info = native_flash_ext_sector_info,
+    .hff_init = native_flash_ext_init,
+};
+
+const struct hal_flash native_flash_ext_dev = {
+    .hf_itf = &native_flash_ext_funcs,
+    .hf_base_addr = 0,
+    .hf_size = FLASH_EXT_NUM_SECTORS * MYNEWT_VAL(NATIVE_FLASH_EXT_SECTOR_SIZE),
+    .hf_sector_cnt = FLASH_EXT_NUM_SECTORS,
+    .hf_align = 1
+};
+
+static uint32_t native_flash_ext_erase_cnt[FLASH_EXT_NUM_SECTORS];
+static uint8_t native_flash_ext_pristine[(FLASH_EXT_NUM_SECTORS + 7) / 8];
+#endif
+
+static struct native_flash native_flashes[] = {
+    {
+        .nf_dev = &native_flash_dev,
+        .nf_sectors = native_flash_sectors,
+        .nf_file_name = &native_flash_file,
+        .nf_erase_cnt = native_flash_erase_cnt,
+    },
+#if MYNEWT_VAL(NATIVE_FLASH_EXT_SIZE) > 0
+    {
+        .nf_dev = &native_flash_ext_dev,
+        .nf_sector_size = MYNEWT_VAL(NATIVE_FLASH_EXT_SECTOR_SIZE),
+        .nf_file_name = &native_flash_ext_file,
+        .nf_erase_cnt = native_flash_ext_erase_cnt,
+    },
+#endif
+};
+
+#define NATIVE_FLASH_NUM_DEVS                                           \
+    (int)(sizeof native_flashes / sizeof native_flashes[0])
+
+static int
+nf_pristine(const struct native_flash *nf, int sector)
+{
+    return nf->nf_pristine &&
+           (nf->nf_pristine[sector / 8] & (1 << (sector % 8)));
+}
+
+static void
+nf_set_pristine(struct native_flash *nf, int sector, int pristine)
+{
+    if (pristine) {
+        nf->nf_pristine[sector / 8] |= 1 << (sector % 8);
+    } else {
+        nf->nf_pristine[sector / 8] &= ~(1 << (sector % 8));
+    }
+}
+
+static int
+nf_sector_cnt(const struct native_flash *nf)
+{
+    return nf->nf_dev->hf_sector_cnt;
+}
+
+static uint32_t
+nf_sector_addr(const struct native_flash *nf, int sector)
+{
+    if (nf->nf_sectors) {
+        return nf->nf_sectors[sector];
+    }
+    return sector * nf->nf_sector_size;
+}
+
+static uint32_t
+nf_sector_len(const struct native_flash *nf, int sector)
+{
+    uint32_t end;
+
+    if (!nf->nf_sectors) {
+        return nf->nf_sector_size;
+    }
+    if (sector == nf_sector_cnt(nf) - 1) {
+        end = nf->nf_dev->hf_size + nf->nf_sectors[0];
+    } else {
+        end = nf->nf_sectors[sector + 1];
+    }
+    return end - nf->nf_sectors[sector];
+}
+
+/* Returns the index of the sector containing address. */
+static int
+nf_sector_of(const struct native_flash *nf, uint32_t address)
+{
+    int i;
+
+    if (!nf->nf_sectors) {
+        return address / nf->nf_sector_size;
+    }
+    for (i = nf_sector_cnt(nf) - 1; i > 0; i--) {
+        if (nf->nf_sectors[i] <= address) {
+            break;
+        }
+    }
+    return i;
+}
+
+/*
+ * Emulates the time a flash operation takes on hardware.  The host sleeps,
+ * so OS time keeps advancing at the usual rate.
+ */
 static void
-flash_native_erase(uint32_t addr, uint32_t len)
+nf_delay(uint32_t usecs)
 {
-    memset(file_loc + addr, 0xff, len);
+    struct timespec ts;
+
+    if (usecs == 0) {
+        return;
+    }
+    ts.tv_sec = usecs / 1000000;
+    ts.tv_nsec = (usecs % 1000000) * 1000;
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+    }
 }
 
 static void
-flash_native_file_open(char *name)
+nf_open(struct native_flash *nf)
 {
     int created = 0;
+    char *name;
     extern char *tmpnam(char *s);
     extern int ftruncate(int fd, off_t length);
 
+    name = *nf->nf_file_name;
+
+    if (!name && nf->nf_dev != &native_flash_dev) {
+        /*
+         * No backing file; everything starts out erased, and memory is only
+         * touched as sectors get written.
+         */
+        nf->nf_loc = mmap(0, nf->nf_dev->hf_size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        assert(nf->nf_loc != MAP_FAILED);
+        nf->nf_file = -1;
+#if MYNEWT_VAL(NATIVE_FLASH_EXT_SIZE) > 0
+        nf->nf_pristine = native_flash_ext_pristine;
+        memset(nf->nf_pristine, 0xff, sizeof native_flash_ext_pristine);
+#endif
+        return;
+    }
+
     if (!name) {
         name = tmpnam(NULL);
     }
-    file = open(name, O_RDWR);
-    if (file < 0) {
-        file = open(name, O_RDWR | O_CREAT, 0660);
-        assert(file > 0);
+    nf->nf_file = open(name, O_RDWR);
+    if (nf->nf_file < 0) {
+        nf->nf_file = open(name, O_RDWR | O_CREAT, 0660);
+        assert(nf->nf_file > 0);
         created = 1;
-        if (ftruncate(file, native_flash_dev.hf_size) < 0) {
+        if (ftruncate(nf->nf_file, nf->nf_dev->hf_size) < 0) {
             assert(0);
         }
     }
-    file_loc = mmap(0, native_flash_dev.hf_size,
-          PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
-    assert(file_loc != MAP_FAILED);
+    nf->nf_loc = mmap(0, nf->nf_dev->hf_size,
+          PROT_READ | PROT_WRITE, MAP_SHARED, nf->nf_file, 0);
+    assert(nf->nf_loc != MAP_FAILED);
     if (created) {
-        flash_native_erase(0, native_flash_dev.hf_size);
+        memset(nf->nf_loc, 0xff, nf->nf_dev->hf_size);
+    }
+}
+
+static void
+nf_ensure_open(struct native_flash *nf)
+{
+    if (nf->nf_loc == NULL) {
+        nf_open(nf);
     }
 }
 
+/* Fills in a pristine sector so that it can be written to. */
 static void
-flash_native_ensure_file_open(void)
+nf_materialize(struct native_flash *nf, int sector)
 {
-    if (file == 0) {
-        flash_native_file_open(NULL);
+    if (nf_pristine(nf, sector)) {
+        memset(nf->nf_loc + nf_sector_addr(nf, sector), 0xff,
+               nf_sector_len(nf, sector));
+        nf_set_pristine(nf, sector, 0);
     }
 }
 
 static int
-flash_native_write_internal(uint32_t address, const void *src, uint32_t length,
-                            int allow_overwrite)
+nf_read(struct native_flash *nf, uint32_t address, void *dst, uint32_t length)
+{
+    uint32_t end;
+    uint32_t chunk;
+    int sector;
+
+    nf_ensure_open(nf);
+
+    nf->nf_stats.nfs_reads++;
+    nf->nf_stats.nfs_read_bytes += length;
+
+    if (!nf->nf_pristine) {
+        memcpy(dst, nf->nf_loc + address, length);
+    } else {
+        end = address + length;
+        while (address < end) {
+            sector = nf_sector_of(nf, address);
+            chunk = nf_sector_addr(nf, sector) + nf_sector_len(nf, sector) -
+                    address;
+            if (chunk > end - address) {
+                chunk = end - address;
+            }
+            if (nf_pristine(nf, sector)) {
+                memset(dst, 0xff, chunk);
+            } else {
+                memcpy(dst, nf->nf_loc + address, chunk);
+            }
+            dst = (uint8_t *)dst + chunk;
+            address += chunk;
+        }
+    }
+
+    nf_delay((uint64_t)length * MYNEWT_VAL(NATIVE_FLASH_READ_NSECS_PER_BYTE) /
+             1000);
+    return 0;
+}
+
+static int
+nf_write(struct native_flash *nf, uint32_t address, const void *src,
+         uint32_t length, int allow_overwrite)
 {
-    static uint8_t buf[256];
     uint32_t cur;
     uint32_t end;
-    int chunk_sz;
-    int rc;
+    int first;
+    int last;
     int i;
 
     if (length == 0) {
@@ -129,30 +360,73 @@ flash_native_write_internal(uint32_t address, const void *src, uint32_t length,
 
     end = address + length;
 
-    flash_native_ensure_file_open();
+    nf_ensure_open(nf);
 
-    cur = address;
-    while (cur < end) {
-        if (end - cur < sizeof buf) {
-            chunk_sz = end - cur;
-        } else {
-            chunk_sz = sizeof buf;
+    first = nf_sector_of(nf, address);
+    last = nf_sector_of(nf, end - 1);
+    for (i = first; i <= last; i++) {
+        nf_materialize(nf, i);
+    }
+
+    /* Ensure data is not being overwritten. */
+    if (!allow_overwrite) {
+        for (cur = address; cur < end; cur++) {
+            assert((uint8_t)nf->nf_loc[cur] == 0xff);
         }
+    }
 
-        /* Ensure data is not being overwritten. */
-        if (!allow_overwrite) {
-            rc = native_flash_read(cur, buf, chunk_sz);
-            assert(rc == 0);
-            for (i = 0; i < chunk_sz; i++) {
-                assert(buf[i] == 0xff);
-            }
+    memcpy(nf->nf_loc + address, src, length);
+
+    nf->nf_stats.nfs_writes++;
+    nf->nf_stats.nfs_write_bytes += length;
+    nf_delay((uint64_t)length * MYNEWT_VAL(NATIVE_FLASH_WRITE_NSECS_PER_BYTE) /
+             1000);
+    return 0;
+}
+
+static int
+nf_erase_sector(struct native_flash *nf, uint32_t sector_address)
+{
+    uint32_t len;
+    int sector;
+
+    nf_ensure_open(nf);
+
+    sector = nf_sector_of(nf, sector_address);
+    if (nf_sector_addr(nf, sector) != sector_address) {
+        return -1;
+    }
+    len = nf_sector_len(nf, sector);
+
+    if (!nf->nf_pristine) {
+        memset(nf->nf_loc + sector_address, 0xff, len);
+    } else if (!nf_pristine(nf, sector)) {
+        /* Hand the memory back; the sector reads as erased from now on. */
+        if (len % getpagesize() != 0 ||
+            madvise(nf->nf_loc + sector_address, len, MADV_DONTNEED) != 0) {
+            memset(nf->nf_loc + sector_address, 0xff, len);
         }
+        nf_set_pristine(nf, sector, 1);
+    }
 
-        cur += chunk_sz;
+    nf->nf_erase_cnt[sector]++;
+    if (nf->nf_erase_cnt[sector] > nf->nf_stats.nfs_max_erase_cnt) {
+        nf->nf_stats.nfs_max_erase_cnt = nf->nf_erase_cnt[sector];
     }
+    nf->nf_stats.nfs_erases++;
+    nf_delay((uint64_t)len * MYNEWT_VAL(NATIVE_FLASH_ERASE_USECS_PER_KB) /
+             1024);
+    return 0;
+}
 
-    memcpy((char *)file_loc + address, src, length);
+static int
+nf_sector_info(struct native_flash *nf, int idx, uint32_t *address,
+               uint32_t *size)
+{
+    assert(idx < nf_sector_cnt(nf));
 
+    *address = nf_sector_addr(nf, idx);
+    *size = nf_sector_len(nf, idx);
     return 0;
 }
 
@@ -160,85 +434,116 @@ static int
 native_flash_write(uint32_t address, const void *src, uint32_t length)
 {
     assert(address % native_flash_dev.hf_align == 0);
-    return flash_native_write_internal(address, src, length, 0);
+    return nf_write(&native_flashes[0], address, src, length, 0);
 }
 
 int
 flash_native_memset(uint32_t offset, uint8_t c, uint32_t len)
 {
-    memset(file_loc + offset, c, len);
+    memset(native_flashes[0].nf_loc + offset, c, len);
     return 0;
 }
 
 static int
 native_flash_read(uint32_t address, void *dst, uint32_t length)
 {
-    flash_native_ensure_file_open();
-    memcpy(dst, (char *)file_loc + address, length);
+    return nf_read(&native_flashes[0], address, dst, length);
+}
 
-    return 0;
+static const void *
+native_flash_map(uint32_t address)
+{
+    nf_ensure_open(&native_flashes[0]);
+    return native_flashes[0].nf_loc + address;
 }
 
 static int
-find_area(uint32_t address)
+native_flash_erase_sector(uint32_t sector_address)
 {
-    int i;
-
-    for (i = 0; i < FLASH_NUM_AREAS; i++) {
-        if (native_flash_sectors[i] == address) {
-            return i;
-        }
-    }
-
-    return -1;
+    return nf_erase_sector(&native_flashes[0], sector_address);
 }
 
 static int
-flash_sector_len(int sector)
+native_flash_sector_info(int idx, uint32_t *address, uint32_t *size)
 {
-    uint32_t end;
+    return nf_sector_info(&native_flashes[0], idx, address, size);
+}
 
-    if (sector == FLASH_NUM_AREAS - 1) {
-        end = native_flash_dev.hf_size + native_flash_sectors[0];
-    } else {
-        end = native_flash_sectors[sector + 1];
+static int
+native_flash_init(void)
+{
+    if (native_flash_file) {
+        nf_open(&native_flashes[0]);
     }
-    return end - native_flash_sectors[sector];
+    return 0;
 }
 
+#if MYNEWT_VAL(NATIVE_FLASH_EXT_SIZE) > 0
 static int
-native_flash_erase_sector(uint32_t sector_address)
+native_flash_ext_read(uint32_t address, void *dst, uint32_t length)
 {
-    int area_id;
-    uint32_t len;
+    return nf_read(&native_flashes[1], address, dst, length);
+}
 
-    flash_native_ensure_file_open();
+static int
+native_flash_ext_write(uint32_t address, const void *src, uint32_t length)
+{
+    return nf_write(&native_flashes[1], address, src, length, 0);
+}
 
-    area_id = find_area(sector_address);
-    if (area_id == -1) {
-        return -1;
-    }
-    len = flash_sector_len(area_id);
-    flash_native_erase(sector_address, len);
-    return 0;
+static int
+native_flash_ext_erase_sector(uint32_t sector_address)
+{
+    return nf_erase_sector(&native_flashes[1], sector_address);
 }
 
 static int
-native_flash_sector_info(int idx, uint32_t *address, uint32_t *size)
+native_flash_ext_sector_info(int idx, uint32_t *address, uint32_t *size)
 {
-    assert(idx < FLASH_NUM_AREAS);
+    return nf_sector_info(&native_flashes[1], idx, address, size);
+}
 
-    *address = native_flash_sectors[idx];
-    *size = flash_sector_len(idx);
+static int
+native_flash_ext_init(void)
+{
+    nf_ensure_open(&native_flashes[1]);
     return 0;
 }
+#endif
 
-static int
-native_flash_init(void)
+/**
+ * Retrieves the operation counters of a simulated flash device.
+ *
+ * @param flash_id              The device to query.
+ * @param out_stats             On success, the counters get written here.
+ *
+ * @return                      0 on success; -1 if there is no such device.
+ */
+int
+native_flash_stats_get(uint8_t flash_id, struct native_flash_stats *out_stats)
 {
-    if (native_flash_file) {
-        flash_native_file_open(native_flash_file);
+    if (flash_id >= NATIVE_FLASH_NUM_DEVS) {
+        return -1;
     }
+    *out_stats = native_flashes[flash_id].nf_stats;
     return 0;
 }
 
+/**
+ * Returns the number of times a sector of a simulated flash device has been
+ * erased since startup, or -1 if there is no such sector.
+ */
+int
+native_flash_sector_erase_cnt(uint8_t flash_id, int sector)
+{
+    struct native_flash *nf;
+
+    if (flash_id >= NATIVE_FLASH_NUM_DEVS) {
+        return -1;
+    }
+    nf = &native_flashes[flash_id];
+    if (sector < 0 || sector >= nf_sector_cnt(nf)) {
+        return -1;
+    }
+    return nf->nf_erase_cnt[sector];
+}
@@ -39,9 +39,11 @@ static void
 usage(char *progname, int rc)
 {
     const char msg[] =
-      "Usage: %s [-f flash_file] [-u uart_log_file]\n"
+      "Usage: %s [-f flash_file] [-F ext_flash_file] [-u uart_log_file]\n"
       "     -f flash_file tells where binary flash file is located. It gets\n"
       "        created if it doesn't already exist.\n"
+      "     -F ext_flash_file is the same for the external flash device.\n"
+      "        Without it, external flash is kept in memory only.\n"
       "     -u uart_log_file puts all UART data exchanges into a logfile.\n";
 
     write(2, msg, strlen(msg));
@@ -54,11 +56,14 @@ mcu_sim_parse_args(int argc, char **argv)
     int ch;
     char *progname = argv[0];
 
-    while ((ch = getopt(argc, argv, "hf:u:")) != -1) {
+    while ((ch = getopt(argc, argv, "hf:F:u:")) != -1) {
         switch (ch) {
         case 'f':
             native_flash_file = optarg;
             break;
+        case 'F':
+            native_flash_ext_file = optarg;
+            break;
         case 'u':
             native_uart_log_file = optarg;
             break;
@@ -33,13 +33,15 @@ static int nrf51_flash_write(uint32_t address, const void *src,
 static int nrf51_flash_erase_sector(uint32_t sector_address);
 static int nrf51_flash_sector_info(int idx, uint32_t *address, uint32_t *sz);
 static int nrf51_flash_init(void);
+static const void *nrf51_flash_map(uint32_t address);
 
 static const struct hal_flash_funcs nrf51_flash_funcs = {
     .hff_read = nrf51_flash_read,
     .hff_write = nrf51_flash_write,
     .hff_erase_sector = nrf51_flash_erase_sector,
     .hff_sector_info = nrf51_flash_sector_info,
-    .hff_init = nrf51_flash_init
+    .hff_init = nrf51_flash_init,
+    .hff_map = nrf51_flash_map
 };
 
 const struct hal_flash nrf51_flash_dev = {
@@ -72,6 +74,12 @@ nrf51_flash_read(uint32_t address, void *dst, uint32_t num_bytes)
     return 0;
 }
 
+static const void *
+nrf51_flash_map(uint32_t address)
+{
+    return (const void *)address;
+}
+
 /*
  * Flash write is done by writing 4 bytes at a time at a word boundary.
  */
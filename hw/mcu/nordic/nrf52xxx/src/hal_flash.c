@@ -33,13 +33,15 @@ static int nrf52k_flash_write(uint32_t address, const void *src,
 static int nrf52k_flash_erase_sector(uint32_t sector_address);
 static int nrf52k_flash_sector_info(int idx, uint32_t *address, uint32_t *sz);
 static int nrf52k_flash_init(void);
+static const void *nrf52k_flash_map(uint32_t address);
 
 static const struct hal_flash_funcs nrf52k_flash_funcs = {
     .hff_read = nrf52k_flash_read,
     .hff_write = nrf52k_flash_write,
     .hff_erase_sector = nrf52k_flash_erase_sector,
     .hff_sector_info = nrf52k_flash_sector_info,
-    .hff_init = nrf52k_flash_init
+    .hff_init = nrf52k_flash_init,
+    .hff_map = nrf52k_flash_map
 };
 
 const struct hal_flash nrf52k_flash_dev = {
@@ -72,6 +74,12 @@ nrf52k_flash_read(uint32_t address, void *dst, uint32_t num_bytes)
     return 0;
 }
 
+static const void *
+nrf52k_flash_map(uint32_t address)
+{
+    return (const void *)address;
+}
+
 /*
  * Flash write is done by writing 4 bytes at a time at a word boundary.
  */
@@ -25,6 +25,7 @@
 #include <os/os_time.h>
 
 #include "syscfg/syscfg.h"
+#include <bsp/cmsis_nvic.h>
 #include <hal/hal_i2c.h>
 #include <hal/hal_gpio.h>
 #include <mcu/nrf52_hal.h>
@@ -33,6 +34,9 @@
 
 #define NRF52_HAL_I2C_MAX (2)
 
+/* Largest EasyDMA transfer; MAXCNT is 8 bits on nRF52832 */
+#define NRF52_HAL_I2C_DMA_MAX (255)
+
 #define NRF52_SCL_PIN_CONF                                              \
     ((GPIO_PIN_CNF_SENSE_Disabled << GPIO_PIN_CNF_SENSE_Pos) |          \
       (GPIO_PIN_CNF_DRIVE_S0D1    << GPIO_PIN_CNF_DRIVE_Pos) |          \
@@ -52,22 +56,33 @@
         goto err;                                            \
     }
 
+/*
+ * Blocking calls use the peripheral as TWI, non-blocking ones switch it
+ * over to TWIM for the duration of the transfer to get EasyDMA.
+ */
 struct nrf52_hal_i2c {
     NRF_TWI_Type *nhi_regs;
+    IRQn_Type nhi_irqn;
+    uint8_t nhi_busy;
+    int nhi_status;
+    hal_i2c_master_cb nhi_cb;
+    void *nhi_cb_arg;
 };
 
 #if MYNEWT_VAL(I2C_0)
 struct nrf52_hal_i2c hal_twi_i2c0 = {
-    .nhi_regs = NRF_TWI0
+    .nhi_regs = NRF_TWI0,
+    .nhi_irqn = SPIM0_SPIS0_TWIM0_TWIS0_SPI0_TWI0_IRQn
 };
 #endif
 #if MYNEWT_VAL(I2C_1)
 struct nrf52_hal_i2c hal_twi_i2c1 = {
-    .nhi_regs = NRF_TWI1
+    .nhi_regs = NRF_TWI1,
+    .nhi_irqn = SPIM1_SPIS1_TWIM1_TWIS1_SPI1_TWI1_IRQn
 };
 #endif
 
-static const struct nrf52_hal_i2c *nrf52_hal_i2cs[NRF52_HAL_I2C_MAX] = {
+static struct nrf52_hal_i2c *nrf52_hal_i2cs[NRF52_HAL_I2C_MAX] = {
 #if MYNEWT_VAL(I2C_0)
     &hal_twi_i2c0,
 #else
@@ -375,3 +390,131 @@ hal_i2c_master_probe(uint8_t i2c_num, uint8_t address, uint32_t timo)
 
     return hal_i2c_master_read(i2c_num, &rx, timo, 1);
 }
+
+static void
+nrf52_i2c_irq_handler(struct nrf52_hal_i2c *i2c)
+{
+    NRF_TWIM_Type *twim;
+    uint32_t err;
+
+    twim = (NRF_TWIM_Type *)i2c->nhi_regs;
+    if (twim->EVENTS_ERROR) {
+        twim->EVENTS_ERROR = 0;
+        err = twim->ERRORSRC;
+        twim->ERRORSRC = err;
+        i2c->nhi_status = err ? err : -1;
+        twim->TASKS_STOP = 1;
+    }
+    if (twim->EVENTS_STOPPED) {
+        twim->EVENTS_STOPPED = 0;
+        twim->INTENCLR = TWIM_INTENCLR_STOPPED_Msk | TWIM_INTENCLR_ERROR_Msk;
+        twim->SHORTS = 0;
+
+        /* Back to TWI for the blocking calls */
+        twim->ENABLE = TWIM_ENABLE_ENABLE_Disabled;
+        i2c->nhi_regs->ENABLE = TWI_ENABLE_ENABLE_Enabled;
+
+        i2c->nhi_busy = 0;
+        if (i2c->nhi_cb) {
+            i2c->nhi_cb(i2c->nhi_cb_arg, i2c->nhi_status);
+        }
+    }
+}
+
+#if MYNEWT_VAL(I2C_0)
+static void
+nrf52_i2c0_irq_handler(void)
+{
+    nrf52_i2c_irq_handler(&hal_twi_i2c0);
+}
+#endif
+
+#if MYNEWT_VAL(I2C_1)
+static void
+nrf52_i2c1_irq_handler(void)
+{
+    nrf52_i2c_irq_handler(&hal_twi_i2c1);
+}
+#endif
+
+int
+hal_i2c_master_xfer_noblock(uint8_t i2c_num,
+                            struct hal_i2c_master_data *wdata,
+                            struct hal_i2c_master_data *rdata,
+                            hal_i2c_master_cb cb, void *arg)
+{
+    struct nrf52_hal_i2c *i2c;
+    NRF_TWIM_Type *twim;
+    uint32_t handler;
+    int sr;
+    int rc;
+
+    NRF52_HAL_I2C_RESOLVE(i2c_num, i2c);
+
+    if ((!wdata && !rdata) ||
+      (wdata && (wdata->len == 0 || wdata->len > NRF52_HAL_I2C_DMA_MAX)) ||
+      (rdata && (rdata->len == 0 || rdata->len > NRF52_HAL_I2C_DMA_MAX))) {
+        rc = EINVAL;
+        goto err;
+    }
+
+    __HAL_DISABLE_INTERRUPTS(sr);
+    if (i2c->nhi_busy) {
+        __HAL_ENABLE_INTERRUPTS(sr);
+        rc = EBUSY;
+        goto err;
+    }
+    i2c->nhi_busy = 1;
+    __HAL_ENABLE_INTERRUPTS(sr);
+
+    i2c->nhi_status = 0;
+    i2c->nhi_cb = cb;
+    i2c->nhi_cb_arg = arg;
+
+    handler = 0;
+#if MYNEWT_VAL(I2C_0)
+    if (i2c == &hal_twi_i2c0) {
+        handler = (uint32_t)nrf52_i2c0_irq_handler;
+    }
+#endif
+#if MYNEWT_VAL(I2C_1)
+    if (i2c == &hal_twi_i2c1) {
+        handler = (uint32_t)nrf52_i2c1_irq_handler;
+    }
+#endif
+    NVIC_SetVector(i2c->nhi_irqn, handler);
+    NVIC_EnableIRQ(i2c->nhi_irqn);
+
+    /* Pin and frequency registers are shared by TWI and TWIM */
+    i2c->nhi_regs->ENABLE = TWI_ENABLE_ENABLE_Disabled;
+    twim = (NRF_TWIM_Type *)i2c->nhi_regs;
+    twim->ENABLE = TWIM_ENABLE_ENABLE_Enabled;
+
+    twim->ADDRESS = wdata ? wdata->address : rdata->address;
+    twim->EVENTS_STOPPED = 0;
+    twim->EVENTS_ERROR = 0;
+    twim->INTENSET = TWIM_INTENSET_STOPPED_Msk | TWIM_INTENSET_ERROR_Msk;
+
+    if (rdata) {
+        twim->RXD.PTR = (uint32_t)rdata->buffer;
+        twim->RXD.MAXCNT = rdata->len;
+    }
+    if (wdata) {
+        twim->TXD.PTR = (uint32_t)wdata->buffer;
+        twim->TXD.MAXCNT = wdata->len;
+        if (rdata) {
+            twim->SHORTS = TWIM_SHORTS_LASTTX_STARTRX_Msk |
+                           TWIM_SHORTS_LASTRX_STOP_Msk;
+        } else {
+            twim->SHORTS = TWIM_SHORTS_LASTTX_STOP_Msk;
+        }
+        twim->TASKS_STARTTX = 1;
+    } else {
+        twim->SHORTS = TWIM_SHORTS_LASTRX_STOP_Msk;
+        twim->TASKS_STARTRX = 1;
+    }
+
+    return (0);
+err:
+    return (rc);
+}
@@ -194,6 +194,17 @@ os_tick_idle(os_time_t ticks)
         nrf52_os_tick_set_ocmp(ocmp);
     }
 
+#if MYNEWT_VAL(OS_PM)
+    /*
+     * RTC runs off LFCLK, and keeps running in deep sleep.
+     */
+    if (os_pm_idle_state() == OS_PM_STATE_DEEP) {
+        SCB->SCR |= SCB_SCR_SLEEPDEEP_Msk;
+    } else {
+        SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+    }
+#endif
+
     __DSB();
     __WFI();
 
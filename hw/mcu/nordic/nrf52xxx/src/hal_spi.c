@@ -151,12 +151,12 @@ nrf52_irqm_handler(struct nrf52_hal_spi *spi)
             }
             spim->TASKS_START = 1;
         } else {
+            /* Done before callback, which can start the next transfer */
+            spi->spi_xfr_flag = 0;
+            spim->INTENCLR = SPIM_INTENSET_END_Msk;
             if (spi->txrx_cb_func) {
                 spi->txrx_cb_func(spi->txrx_cb_arg, spi->nhs_buflen);
-
             }
-            spi->spi_xfr_flag = 0;
-            spim->INTENCLR = SPIM_INTENSET_END_Msk;
         }
     }
 }
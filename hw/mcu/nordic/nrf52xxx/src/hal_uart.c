@@ -33,6 +33,9 @@
 #define UARTE_ENABLE		UARTE_ENABLE_ENABLE_Enabled
 #define UARTE_DISABLE           UARTE_ENABLE_ENABLE_Disabled
 
+/* Largest EasyDMA transfer; MAXCNT is 8 bits on nRF52832 */
+#define UARTE_DMA_MAX_XFER      (255)
+
 /*
  * Only one UART on NRF 52832.
  */
@@ -40,11 +43,15 @@ struct hal_uart {
     uint8_t u_open:1;
     uint8_t u_rx_stall:1;
     uint8_t u_tx_started:1;
+    uint8_t u_dma:1;
+    uint8_t u_rx_active:1;
     uint8_t u_rx_buf;
     uint8_t u_tx_buf[8];
     hal_uart_rx_char u_rx_func;
     hal_uart_tx_char u_tx_func;
     hal_uart_tx_done u_tx_done;
+    hal_uart_dma_done u_dma_tx_done;
+    hal_uart_dma_done u_dma_rx_done;
     void *u_func_arg;
 };
 static struct hal_uart uart;
@@ -62,6 +69,7 @@ hal_uart_init_cbs(int port, hal_uart_tx_char tx_func, hal_uart_tx_done tx_done,
     if (u->u_open) {
         return -1;
     }
+    u->u_dma = 0;
     u->u_rx_func = rx_func;
     u->u_tx_func = tx_func;
     u->u_tx_done = tx_done;
@@ -69,6 +77,113 @@ hal_uart_init_cbs(int port, hal_uart_tx_char tx_func, hal_uart_tx_done tx_done,
     return 0;
 }
 
+int
+hal_uart_dma_init_cbs(int port, hal_uart_dma_done tx_done,
+  hal_uart_dma_done rx_done, void *arg)
+{
+    struct hal_uart *u;
+
+    if (port != 0) {
+        return -1;
+    }
+    u = &uart;
+    if (u->u_open) {
+        return -1;
+    }
+    u->u_dma = 1;
+    u->u_dma_tx_done = tx_done;
+    u->u_dma_rx_done = rx_done;
+    u->u_func_arg = arg;
+    return 0;
+}
+
+int
+hal_uart_dma_tx(int port, const uint8_t *buf, uint16_t len)
+{
+    struct hal_uart *u;
+    int sr;
+
+    if (port != 0) {
+        return -1;
+    }
+    u = &uart;
+    if (!u->u_open || !u->u_dma || (len == 0) || (len > UARTE_DMA_MAX_XFER)) {
+        return -1;
+    }
+
+    __HAL_DISABLE_INTERRUPTS(sr);
+    NRF_UARTE0->TXD.PTR = (uint32_t)buf;
+    NRF_UARTE0->TXD.MAXCNT = len;
+    NRF_UARTE0->TASKS_STARTTX = 1;
+    u->u_tx_started = 1;
+    __HAL_ENABLE_INTERRUPTS(sr);
+
+    return 0;
+}
+
+int
+hal_uart_dma_rx(int port, uint8_t *buf, uint16_t len)
+{
+    struct hal_uart *u;
+    int sr;
+
+    if (port != 0) {
+        return -1;
+    }
+    u = &uart;
+    if (!u->u_open || !u->u_dma || (len == 0) || (len > UARTE_DMA_MAX_XFER)) {
+        return -1;
+    }
+
+    __HAL_DISABLE_INTERRUPTS(sr);
+    NRF_UARTE0->RXD.PTR = (uint32_t)buf;
+    NRF_UARTE0->RXD.MAXCNT = len;
+    NRF_UARTE0->TASKS_STARTRX = 1;
+    u->u_rx_active = 1;
+    __HAL_ENABLE_INTERRUPTS(sr);
+
+    return 0;
+}
+
+int
+hal_uart_dma_set_rx_idle_cb(int port, hal_uart_dma_done rx_idle)
+{
+    /* UARTE has no idle line event */
+    return -1;
+}
+
+int
+hal_uart_dma_rx_stop(int port)
+{
+    struct hal_uart *u;
+    int cnt;
+    int sr;
+
+    if (port != 0) {
+        return -1;
+    }
+    u = &uart;
+    if (!u->u_open || !u->u_dma) {
+        return -1;
+    }
+
+    __HAL_DISABLE_INTERRUPTS(sr);
+    if (!u->u_rx_active) {
+        __HAL_ENABLE_INTERRUPTS(sr);
+        return 0;
+    }
+    NRF_UARTE0->TASKS_STOPRX = 1;
+    while (!NRF_UARTE0->EVENTS_ENDRX) {
+    }
+    NRF_UARTE0->EVENTS_ENDRX = 0;
+    NRF_UARTE0->EVENTS_RXTO = 0;
+    u->u_rx_active = 0;
+    cnt = NRF_UARTE0->RXD.AMOUNT;
+    __HAL_ENABLE_INTERRUPTS(sr);
+
+    return cnt;
+}
+
 static int
 hal_uart_tx_fill_buf(struct hal_uart *u)
 {
@@ -174,6 +289,23 @@ uart_irq_handler(void)
     int rc;
 
     u = &uart;
+    if (u->u_dma) {
+        if (NRF_UARTE0->EVENTS_ENDTX) {
+            NRF_UARTE0->EVENTS_ENDTX = 0;
+            u->u_tx_started = 0;
+            u->u_dma_tx_done(u->u_func_arg);
+            if (!u->u_tx_started) {
+                NRF_UARTE0->TASKS_STOPTX = 1;
+            }
+        }
+        if (NRF_UARTE0->EVENTS_ENDRX) {
+            NRF_UARTE0->EVENTS_ENDRX = 0;
+            u->u_rx_active = 0;
+            u->u_dma_rx_done(u->u_func_arg);
+        }
+        return;
+    }
+
     if (NRF_UARTE0->EVENTS_ENDTX) {
         NRF_UARTE0->EVENTS_ENDTX = 0;
         rc = hal_uart_tx_fill_buf(u);
@@ -319,10 +451,18 @@ hal_uart_config(int port, int32_t baudrate, uint8_t databits, uint8_t stopbits,
 
     NRF_UARTE0->ENABLE = UARTE_ENABLE;
 
-    NRF_UARTE0->INTENSET = UARTE_INT_ENDRX;
-    NRF_UARTE0->RXD.PTR = (uint32_t)&u->u_rx_buf;
-    NRF_UARTE0->RXD.MAXCNT = sizeof(u->u_rx_buf);
-    NRF_UARTE0->TASKS_STARTRX = 1;
+    if (u->u_dma) {
+        /* Reception starts when the first buffer is handed to us */
+        NRF_UARTE0->EVENTS_ENDRX = 0;
+        NRF_UARTE0->EVENTS_ENDTX = 0;
+        NRF_UARTE0->INTENSET = UARTE_INT_ENDRX | UARTE_INT_ENDTX;
+        u->u_rx_active = 0;
+    } else {
+        NRF_UARTE0->INTENSET = UARTE_INT_ENDRX;
+        NRF_UARTE0->RXD.PTR = (uint32_t)&u->u_rx_buf;
+        NRF_UARTE0->RXD.MAXCNT = sizeof(u->u_rx_buf);
+        NRF_UARTE0->TASKS_STARTRX = 1;
+    }
 
     u->u_rx_stall = 0;
     u->u_tx_started = 0;
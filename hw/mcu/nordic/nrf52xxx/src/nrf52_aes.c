@@ -0,0 +1,86 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(MBEDTLS_AES_HW_ENCRYPT)
+
+#include "nrf.h"
+#include "mcu/nrf52_hal.h"
+
+/* Layout of the data block the ECB peripheral reads and writes. */
+struct nrf52_ecb_block {
+    uint8_t key[16];
+    uint8_t cleartext[16];
+    uint8_t ciphertext[16];
+};
+
+/*
+ * AES-128 block encryption on the ECB peripheral, called by mbedtls before
+ * it falls back to software.  Returns -1 for other key sizes or on error.
+ *
+ * The BLE controller also drives the ECB from its task.  Interrupts stay
+ * off for the whole operation so nothing can start another one halfway
+ * through; since the controller task runs at the highest priority, no
+ * caller can preempt it while it has the peripheral.
+ */
+int
+mbedtls_aes_hw_encrypt(int nr, const uint32_t *rk, const unsigned char in[16],
+                       unsigned char out[16])
+{
+    struct nrf52_ecb_block ecb;
+    uint32_t ctx;
+    int rc;
+
+    if (nr != 10) {
+        return -1;
+    }
+
+    /* The first round key of AES-128, stored little endian, is the key. */
+    memcpy(ecb.key, rk, sizeof(ecb.key));
+    memcpy(ecb.cleartext, in, sizeof(ecb.cleartext));
+
+    __HAL_DISABLE_INTERRUPTS(ctx);
+
+    NRF_ECB->TASKS_STOPECB = 1;
+    NRF_ECB->EVENTS_ENDECB = 0;
+    NRF_ECB->EVENTS_ERRORECB = 0;
+    NRF_ECB->ECBDATAPTR = (uint32_t)&ecb;
+    NRF_ECB->TASKS_STARTECB = 1;
+
+    while (!NRF_ECB->EVENTS_ENDECB && !NRF_ECB->EVENTS_ERRORECB) {
+    }
+    rc = NRF_ECB->EVENTS_ERRORECB ? -1 : 0;
+    NRF_ECB->EVENTS_ENDECB = 0;
+    NRF_ECB->EVENTS_ERRORECB = 0;
+
+    __HAL_ENABLE_INTERRUPTS(ctx);
+
+    if (rc == 0) {
+        memcpy(out, ecb.ciphertext, sizeof(ecb.ciphertext));
+    }
+    memset(&ecb, 0, sizeof(ecb));
+
+    return rc;
+}
+
+#endif
@@ -37,13 +37,15 @@ static int mk64f12_flash_write(uint32_t address, const void *src,
 static int mk64f12_flash_erase_sector(uint32_t sector_address);
 static int mk64f12_flash_sector_info(int idx, uint32_t *addr, uint32_t *sz);
 static int mk64f12_flash_init(void);
+static const void *mk64f12_flash_map(uint32_t address);
 
 static const struct hal_flash_funcs mk64f12_flash_funcs = {
     .hff_read = mk64f12_flash_read,
     .hff_write = mk64f12_flash_write,
     .hff_erase_sector = mk64f12_flash_erase_sector,
     .hff_sector_info = mk64f12_flash_sector_info,
-    .hff_init = mk64f12_flash_init
+    .hff_init = mk64f12_flash_init,
+    .hff_map = mk64f12_flash_map
 };
 
 static flash_config_t mk64f12_config;
@@ -61,6 +63,12 @@ mk64f12_flash_read(uint32_t address, void *dst, uint32_t num_bytes)
     return 0;
 }
 
+static const void *
+mk64f12_flash_map(uint32_t address)
+{
+    return (const void *)address;
+}
+
 static int
 mk64f12_flash_write(uint32_t address, const void *src, uint32_t len)
 {
@@ -26,6 +26,20 @@
 
 #include "fsl_pit.h"
 
+/*
+ * Number of PIT cycles that go by while the channel is stopped to be
+ * reprogrammed on the way into the tickless regime.
+ */
+#define OS_TICK_STOPPED_CYCLES  (20)
+
+struct hal_os_tick
+{
+    uint32_t cycles_per_ostick;
+    os_time_t max_idle_ticks;
+};
+
+static struct hal_os_tick g_hal_os_tick;
+
 static void nxp_pit0_timer_handler(void)
 {
     uint32_t sr;
@@ -39,12 +53,88 @@ static void nxp_pit0_timer_handler(void)
     OS_EXIT_CRITICAL(sr);
 }
 
+/*
+ * Restarts PIT channel 0 so that the next tick interrupt fires after
+ * 'cycles' cycles, with periodic ticks from then on.  The channel must be
+ * stopped.
+ */
+static void nxp_pit0_restart(uint32_t cycles)
+{
+    PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, cycles > 1 ? cycles - 1 : 1);
+    PIT_StartTimer(PIT, kPIT_Chnl_0);
+
+    /* Only takes effect when the channel next times out. */
+    PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, g_hal_os_tick.cycles_per_ostick - 1);
+}
+
 void os_tick_idle(os_time_t ticks)
 {
+    uint32_t cycles_per_ostick;
+    uint32_t reload;
+    uint32_t elapsed;
+    uint32_t count;
+
     OS_ASSERT_CRITICAL();
 
+    cycles_per_ostick = g_hal_os_tick.cycles_per_ostick;
+    reload = 0;
+    if (ticks > g_hal_os_tick.max_idle_ticks) {
+        ticks = g_hal_os_tick.max_idle_ticks;
+    }
+
+    if (ticks > 1) {
+        /*
+         * Enter tickless regime during long idle durations: stretch the
+         * current tick so that it ends when the next timer expires.
+         */
+        count = PIT_GetCurrentTimerCount(PIT, kPIT_Chnl_0);
+        PIT_StopTimer(PIT, kPIT_Chnl_0);
+        if (PIT_GetStatusFlags(PIT, kPIT_Chnl_0) & PIT_TFLG_TIF_MASK) {
+            /* A tick is already due; stay in the periodic regime. */
+            nxp_pit0_restart(count + 1);
+            ticks = 0;
+        } else {
+            reload = count + (ticks - 1) * cycles_per_ostick;
+            if (reload > OS_TICK_STOPPED_CYCLES) {
+                reload -= OS_TICK_STOPPED_CYCLES;
+            }
+            PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, reload);
+            PIT_StartTimer(PIT, kPIT_Chnl_0);
+        }
+    }
+
     __DSB();
     __WFI();
+
+    if (ticks > 1) {
+        count = PIT_GetCurrentTimerCount(PIT, kPIT_Chnl_0);
+        PIT_StopTimer(PIT, kPIT_Chnl_0);
+
+        if (PIT_GetStatusFlags(PIT, kPIT_Chnl_0) & PIT_TFLG_TIF_MASK) {
+            /*
+             * Slept until the stretched tick expired.  Account for it here
+             * rather than in the pending interrupt, and carry over the
+             * cycles that have gone by since.
+             */
+            PIT_ClearStatusFlags(PIT, kPIT_Chnl_0, PIT_TFLG_TIF_MASK);
+            NVIC_ClearPendingIRQ(PIT0_IRQn);
+            elapsed = reload - count;
+            if (elapsed >= cycles_per_ostick) {
+                elapsed = 0;
+            }
+            nxp_pit0_restart(cycles_per_ostick - elapsed);
+            os_time_advance(ticks);
+        } else {
+            /*
+             * Woken early by another interrupt.  Account for the whole ticks
+             * that went by and keep the fraction of the current one.
+             */
+            elapsed = ticks * cycles_per_ostick - count;
+            ticks = elapsed / cycles_per_ostick;
+            nxp_pit0_restart((ticks + 1) * cycles_per_ostick - elapsed);
+            os_time_advance(ticks);
+        }
+    }
 }
 
 void os_tick_init(uint32_t os_ticks_per_sec, int prio)
@@ -61,8 +151,13 @@ void os_tick_init(uint32_t os_ticks_per_sec, int prio)
     /* Clear interrupt flag.*/
     PIT_ClearStatusFlags(PIT, kPIT_Chnl_0, PIT_TFLG_TIF_MASK);
 
+    g_hal_os_tick.cycles_per_ostick =
+        USEC_TO_COUNT(ticks_per_ostick, CLOCK_GetFreq(kCLOCK_BusClk));
+    g_hal_os_tick.max_idle_ticks = UINT32_MAX / 2 /
+                                   g_hal_os_tick.cycles_per_ostick;
+
     /* Set timer period for channel 0 */
-    PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, USEC_TO_COUNT(ticks_per_ostick, CLOCK_GetFreq(kCLOCK_BusClk)));
+    PIT_SetTimerPeriod(PIT, kPIT_Chnl_0, g_hal_os_tick.cycles_per_ostick - 1);
 
     /* Enable timer interrupts for channel 0 */
     PIT_EnableInterrupts(PIT, kPIT_Chnl_0, kPIT_TimerInterruptEnable);
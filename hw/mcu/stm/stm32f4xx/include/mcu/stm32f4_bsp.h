@@ -37,6 +37,14 @@ struct stm32f4_uart_cfg {
     int8_t suc_pin_cts;
     uint8_t suc_pin_af;				/* AF selection for this */
     IRQn_Type suc_irqn;				/* NVIC IRQn */
+    /*
+     * Optional, for hal_uart_dma_*(). Instance and Init.Channel must be
+     * filled in; the driver sets up the rest. NULL if not used.
+     */
+    struct __DMA_HandleTypeDef *suc_dma_tx;
+    struct __DMA_HandleTypeDef *suc_dma_rx;
+    IRQn_Type suc_dma_tx_irqn;			/* NVIC IRQn of DMA streams */
+    IRQn_Type suc_dma_rx_irqn;
 };
 
 /*
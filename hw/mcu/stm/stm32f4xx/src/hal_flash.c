@@ -29,13 +29,15 @@ static int stm32f4_flash_write(uint32_t address, const void *src,
 static int stm32f4_flash_erase_sector(uint32_t sector_address);
 static int stm32f4_flash_sector_info(int idx, uint32_t *address, uint32_t *sz);
 static int stm32f4_flash_init(void);
+static const void *stm32f4_flash_map(uint32_t address);
 
 static const struct hal_flash_funcs stm32f4_flash_funcs = {
     .hff_read = stm32f4_flash_read,
     .hff_write = stm32f4_flash_write,
     .hff_erase_sector = stm32f4_flash_erase_sector,
     .hff_sector_info = stm32f4_flash_sector_info,
-    .hff_init = stm32f4_flash_init
+    .hff_init = stm32f4_flash_init,
+    .hff_map = stm32f4_flash_map
 };
 
 static const uint32_t stm32f4_flash_sectors[] = {
@@ -73,6 +75,12 @@ stm32f4_flash_read(uint32_t address, void *dst, uint32_t num_bytes)
     return 0;
 }
 
+static const void *
+stm32f4_flash_map(uint32_t address)
+{
+    return (const void *)address;
+}
+
 static int
 stm32f4_flash_write(uint32_t address, const void *src, uint32_t num_bytes)
 {
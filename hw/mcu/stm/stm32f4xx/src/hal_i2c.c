@@ -25,6 +25,7 @@
 
 #include <hal/hal_i2c.h>
 #include <hal/hal_gpio.h>
+#include <bsp/cmsis_nvic.h>
 
 #include "stm32f4xx.h"
 #include "stm32f4xx_hal_dma.h"
@@ -40,6 +41,9 @@
 
 struct stm32f4_hal_i2c {
     I2C_HandleTypeDef hid_handle;
+    struct hal_i2c_master_data *hid_rdata;  /* read after write completes */
+    hal_i2c_master_cb hid_cb;
+    void *hid_cb_arg;
 };
 
 #if MYNEWT_VAL(I2C_0)
@@ -170,3 +174,194 @@ hal_i2c_master_probe(uint8_t i2c_num, uint8_t address, uint32_t timo)
     rc = HAL_I2C_IsDeviceReady(&dev->hid_handle, address, 1, timo);
     return rc;
 }
+
+/*
+ * Non-blocking transfers. Write-then-read is done as two sequential
+ * frames, HAL generates the repeated start between them.
+ */
+static void
+i2c_irq_ev(struct stm32f4_hal_i2c *dev)
+{
+    HAL_I2C_EV_IRQHandler(&dev->hid_handle);
+}
+
+static void
+i2c_irq_er(struct stm32f4_hal_i2c *dev)
+{
+    HAL_I2C_ER_IRQHandler(&dev->hid_handle);
+}
+
+#if MYNEWT_VAL(I2C_0)
+static void
+i2c0_irq_ev(void)
+{
+    i2c_irq_ev(&i2c0);
+}
+
+static void
+i2c0_irq_er(void)
+{
+    i2c_irq_er(&i2c0);
+}
+#endif
+#if MYNEWT_VAL(I2C_1)
+static void
+i2c1_irq_ev(void)
+{
+    i2c_irq_ev(&i2c1);
+}
+
+static void
+i2c1_irq_er(void)
+{
+    i2c_irq_er(&i2c1);
+}
+#endif
+#if MYNEWT_VAL(I2C_2)
+static void
+i2c2_irq_ev(void)
+{
+    i2c_irq_ev(&i2c2);
+}
+
+static void
+i2c2_irq_er(void)
+{
+    i2c_irq_er(&i2c2);
+}
+#endif
+
+static int
+i2c_set_nvic(struct stm32f4_hal_i2c *dev)
+{
+    IRQn_Type ev_irqn;
+    IRQn_Type er_irqn;
+    uint32_t ev_isr = 0;
+    uint32_t er_isr = 0;
+
+    switch ((uintptr_t)dev->hid_handle.Instance) {
+    case (uintptr_t)I2C1:
+        ev_irqn = I2C1_EV_IRQn;
+        er_irqn = I2C1_ER_IRQn;
+        break;
+    case (uintptr_t)I2C2:
+        ev_irqn = I2C2_EV_IRQn;
+        er_irqn = I2C2_ER_IRQn;
+        break;
+    case (uintptr_t)I2C3:
+        ev_irqn = I2C3_EV_IRQn;
+        er_irqn = I2C3_ER_IRQn;
+        break;
+    default:
+        return -1;
+    }
+#if MYNEWT_VAL(I2C_0)
+    if (dev == &i2c0) {
+        ev_isr = (uint32_t)i2c0_irq_ev;
+        er_isr = (uint32_t)i2c0_irq_er;
+    }
+#endif
+#if MYNEWT_VAL(I2C_1)
+    if (dev == &i2c1) {
+        ev_isr = (uint32_t)i2c1_irq_ev;
+        er_isr = (uint32_t)i2c1_irq_er;
+    }
+#endif
+#if MYNEWT_VAL(I2C_2)
+    if (dev == &i2c2) {
+        ev_isr = (uint32_t)i2c2_irq_ev;
+        er_isr = (uint32_t)i2c2_irq_er;
+    }
+#endif
+    NVIC_SetVector(ev_irqn, ev_isr);
+    NVIC_SetVector(er_irqn, er_isr);
+    NVIC_EnableIRQ(ev_irqn);
+    NVIC_EnableIRQ(er_irqn);
+    return 0;
+}
+
+static void
+i2c_xfer_done(struct stm32f4_hal_i2c *dev, int status)
+{
+    dev->hid_rdata = NULL;
+    if (dev->hid_cb) {
+        dev->hid_cb(dev->hid_cb_arg, status);
+    }
+}
+
+void
+HAL_I2C_MasterTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    struct stm32f4_hal_i2c *dev;
+    struct hal_i2c_master_data *rdata;
+    int rc;
+
+    dev = (struct stm32f4_hal_i2c *)hi2c;
+    rdata = dev->hid_rdata;
+    if (rdata) {
+        dev->hid_rdata = NULL;
+        rc = HAL_I2C_Master_Sequential_Receive_IT(hi2c, rdata->address << 1,
+          rdata->buffer, rdata->len, I2C_LAST_FRAME);
+        if (rc == HAL_OK) {
+            return;
+        }
+        i2c_xfer_done(dev, rc);
+    } else {
+        i2c_xfer_done(dev, 0);
+    }
+}
+
+void
+HAL_I2C_MasterRxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    i2c_xfer_done((struct stm32f4_hal_i2c *)hi2c, 0);
+}
+
+void
+HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    i2c_xfer_done((struct stm32f4_hal_i2c *)hi2c, hi2c->ErrorCode);
+}
+
+int
+hal_i2c_master_xfer_noblock(uint8_t i2c_num,
+                            struct hal_i2c_master_data *wdata,
+                            struct hal_i2c_master_data *rdata,
+                            hal_i2c_master_cb cb, void *arg)
+{
+    struct stm32f4_hal_i2c *dev;
+    int rc;
+
+    if (i2c_num >= HAL_I2C_MAX_DEVS || !(dev = hal_i2c_devs[i2c_num])) {
+        return -1;
+    }
+    if ((!wdata && !rdata) || (wdata && wdata->len == 0) ||
+      (rdata && rdata->len == 0)) {
+        return -1;
+    }
+    if (dev->hid_handle.State != HAL_I2C_STATE_READY) {
+        return HAL_BUSY;
+    }
+    if (i2c_set_nvic(dev)) {
+        return -1;
+    }
+
+    dev->hid_cb = cb;
+    dev->hid_cb_arg = arg;
+    dev->hid_handle.PreviousState = HAL_I2C_MODE_NONE;
+    if (wdata) {
+        dev->hid_rdata = rdata;
+        rc = HAL_I2C_Master_Sequential_Transmit_IT(&dev->hid_handle,
+          wdata->address << 1, wdata->buffer, wdata->len,
+          rdata ? I2C_FIRST_FRAME : I2C_FIRST_AND_LAST_FRAME);
+    } else {
+        dev->hid_rdata = NULL;
+        rc = HAL_I2C_Master_Sequential_Receive_IT(&dev->hid_handle,
+          rdata->address << 1, rdata->buffer, rdata->len,
+          I2C_FIRST_AND_LAST_FRAME);
+    }
+    if (rc) {
+        dev->hid_rdata = NULL;
+    }
+    return rc;
+}
@@ -22,14 +22,103 @@
 #include <hal/hal_os_tick.h>
 
 /*
- * XXX implement tickless mode.
+ * Number of SysTick cycles that go by while the counter is stopped to be
+ * reprogrammed on the way into the tickless regime.
  */
+#define OS_TICK_STOPPED_CYCLES  (45)
+
+struct hal_os_tick
+{
+    uint32_t cycles_per_ostick;
+    os_time_t max_idle_ticks;
+};
+
+static struct hal_os_tick g_hal_os_tick;
+
+/*
+ * Restarts SysTick so that the next tick interrupt fires after 'cycles'
+ * cycles, with periodic ticks from then on.  SysTick must be stopped.
+ */
+static void
+stm32f4_os_tick_restart(uint32_t cycles)
+{
+    SysTick->LOAD = cycles > 1 ? cycles - 1 : 1;
+    SysTick->VAL = 0;
+    SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+    /* Only takes effect when the counter next reloads. */
+    SysTick->LOAD = g_hal_os_tick.cycles_per_ostick - 1;
+}
+
 void
 os_tick_idle(os_time_t ticks)
 {
+    uint32_t cycles_per_ostick;
+    uint32_t reload;
+    uint32_t elapsed;
+    uint32_t ctrl;
+
     OS_ASSERT_CRITICAL();
+
+    cycles_per_ostick = g_hal_os_tick.cycles_per_ostick;
+    reload = 0;
+    if (ticks > g_hal_os_tick.max_idle_ticks) {
+        ticks = g_hal_os_tick.max_idle_ticks;
+    }
+
+    if (ticks > 1) {
+        /*
+         * Enter tickless regime during long idle durations: stretch the
+         * current tick so that it ends when the next timer expires.
+         */
+        SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+        if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+            /* A tick is already due; stay in the periodic regime. */
+            SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+            ticks = 0;
+        } else {
+            reload = SysTick->VAL + (ticks - 1) * cycles_per_ostick;
+            if (reload > OS_TICK_STOPPED_CYCLES) {
+                reload -= OS_TICK_STOPPED_CYCLES;
+            }
+            SysTick->LOAD = reload;
+            SysTick->VAL = 0;
+            SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+        }
+    }
+
     __DSB();
     __WFI();
+
+    if (ticks > 1) {
+        /* Reading CTRL clears COUNTFLAG, so read it exactly once. */
+        ctrl = SysTick->CTRL;
+        SysTick->CTRL = ctrl & ~SysTick_CTRL_ENABLE_Msk;
+
+        if (ctrl & SysTick_CTRL_COUNTFLAG_Msk) {
+            /*
+             * Slept until the stretched tick expired.  Account for it here
+             * rather than in the pending interrupt, and carry over the
+             * cycles that have gone by since.
+             */
+            SCB->ICSR = SCB_ICSR_PENDSTCLR_Msk;
+            elapsed = reload - SysTick->VAL;
+            if (elapsed >= cycles_per_ostick) {
+                elapsed = 0;
+            }
+            stm32f4_os_tick_restart(cycles_per_ostick - elapsed);
+            os_time_advance(ticks);
+        } else {
+            /*
+             * Woken early by another interrupt.  Account for the whole ticks
+             * that went by and keep the fraction of the current one.
+             */
+            elapsed = ticks * cycles_per_ostick - SysTick->VAL;
+            ticks = elapsed / cycles_per_ostick;
+            stm32f4_os_tick_restart((ticks + 1) * cycles_per_ostick - elapsed);
+            os_time_advance(ticks);
+        }
+    }
 }
 
 void
@@ -39,6 +128,10 @@ os_tick_init(uint32_t os_ticks_per_sec, int prio)
 
     reload_val = ((uint64_t)SystemCoreClock / os_ticks_per_sec) - 1;
 
+    g_hal_os_tick.cycles_per_ostick = reload_val + 1;
+    g_hal_os_tick.max_idle_ticks = SysTick_LOAD_RELOAD_Msk /
+                                   g_hal_os_tick.cycles_per_ostick;
+
     /* Set the system time ticker up */
     SysTick->LOAD = reload_val;
     SysTick->VAL = 0;
@@ -35,10 +35,15 @@ struct hal_uart {
     uint8_t u_open:1;
     uint8_t u_rx_stall:1;
     uint8_t u_tx_end:1;
+    uint8_t u_dma:1;
     uint8_t u_rx_data;
+    uint16_t u_dma_rx_len;
     hal_uart_rx_char u_rx_func;
     hal_uart_tx_char u_tx_func;
     hal_uart_tx_done u_tx_done;
+    hal_uart_dma_done u_dma_tx_done;
+    hal_uart_dma_done u_dma_rx_done;
+    hal_uart_dma_done u_dma_rx_idle;
     void *u_func_arg;
     const struct stm32f4_uart_cfg *u_cfg;
 };
@@ -50,6 +55,39 @@ struct hal_uart_irq {
 };
 static struct hal_uart_irq uart_irqs[6];
 
+/*
+ * DMA stream interrupts, two per UART. Slot is (port * 2) for TX and
+ * (port * 2 + 1) for RX.
+ */
+#define UART_DMA_IRQ_CNT        (6 * 2)
+static DMA_HandleTypeDef *uart_dma_irqs[UART_DMA_IRQ_CNT];
+
+#define UART_DMA_IRQ(n)                                                 \
+    static void                                                         \
+    uart_dma_irq##n(void)                                               \
+    {                                                                   \
+        HAL_DMA_IRQHandler(uart_dma_irqs[n]);                           \
+    }
+
+UART_DMA_IRQ(0)
+UART_DMA_IRQ(1)
+UART_DMA_IRQ(2)
+UART_DMA_IRQ(3)
+UART_DMA_IRQ(4)
+UART_DMA_IRQ(5)
+UART_DMA_IRQ(6)
+UART_DMA_IRQ(7)
+UART_DMA_IRQ(8)
+UART_DMA_IRQ(9)
+UART_DMA_IRQ(10)
+UART_DMA_IRQ(11)
+
+static void (* const uart_dma_isrs[UART_DMA_IRQ_CNT])(void) = {
+    uart_dma_irq0, uart_dma_irq1, uart_dma_irq2, uart_dma_irq3,
+    uart_dma_irq4, uart_dma_irq5, uart_dma_irq6, uart_dma_irq7,
+    uart_dma_irq8, uart_dma_irq9, uart_dma_irq10, uart_dma_irq11
+};
+
 int
 hal_uart_init_cbs(int port, hal_uart_tx_char tx_func, hal_uart_tx_done tx_done,
   hal_uart_rx_char rx_func, void *arg)
@@ -60,6 +98,7 @@ hal_uart_init_cbs(int port, hal_uart_tx_char tx_func, hal_uart_tx_done tx_done,
     if (port >= UART_CNT || u->u_open) {
         return -1;
     }
+    u->u_dma = 0;
     u->u_rx_func = rx_func;
     u->u_tx_func = tx_func;
     u->u_tx_done = tx_done;
@@ -67,6 +106,179 @@ hal_uart_init_cbs(int port, hal_uart_tx_char tx_func, hal_uart_tx_done tx_done,
     return 0;
 }
 
+int
+hal_uart_dma_init_cbs(int port, hal_uart_dma_done tx_done,
+  hal_uart_dma_done rx_done, void *arg)
+{
+    struct hal_uart *u;
+
+    if (port >= UART_CNT) {
+        return -1;
+    }
+    u = &uarts[port];
+    if (u->u_open || !u->u_cfg || !u->u_cfg->suc_dma_tx ||
+      !u->u_cfg->suc_dma_rx) {
+        return -1;
+    }
+    u->u_dma = 1;
+    u->u_dma_tx_done = tx_done;
+    u->u_dma_rx_done = rx_done;
+    u->u_func_arg = arg;
+    return 0;
+}
+
+int
+hal_uart_dma_set_rx_idle_cb(int port, hal_uart_dma_done rx_idle)
+{
+    struct hal_uart *u;
+    int sr;
+
+    if (port >= UART_CNT) {
+        return -1;
+    }
+    u = &uarts[port];
+    if (!u->u_dma) {
+        return -1;
+    }
+
+    __HAL_DISABLE_INTERRUPTS(sr);
+    u->u_dma_rx_idle = rx_idle;
+    if (u->u_open) {
+        if (rx_idle) {
+            u->u_regs->CR1 |= USART_CR1_IDLEIE;
+        } else {
+            u->u_regs->CR1 &= ~USART_CR1_IDLEIE;
+        }
+    }
+    __HAL_ENABLE_INTERRUPTS(sr);
+    return 0;
+}
+
+int
+hal_uart_dma_tx(int port, const uint8_t *buf, uint16_t len)
+{
+    struct hal_uart *u;
+
+    if (port >= UART_CNT) {
+        return -1;
+    }
+    u = &uarts[port];
+    if (!u->u_open || !u->u_dma || len == 0) {
+        return -1;
+    }
+    if (HAL_DMA_Start_IT(u->u_cfg->suc_dma_tx, (uint32_t)buf,
+        (uint32_t)&u->u_regs->DR, len) != HAL_OK) {
+        return -1;
+    }
+    return 0;
+}
+
+int
+hal_uart_dma_rx(int port, uint8_t *buf, uint16_t len)
+{
+    struct hal_uart *u;
+
+    if (port >= UART_CNT) {
+        return -1;
+    }
+    u = &uarts[port];
+    if (!u->u_open || !u->u_dma || len == 0) {
+        return -1;
+    }
+    u->u_dma_rx_len = len;
+    if (HAL_DMA_Start_IT(u->u_cfg->suc_dma_rx, (uint32_t)&u->u_regs->DR,
+        (uint32_t)buf, len) != HAL_OK) {
+        return -1;
+    }
+    return 0;
+}
+
+int
+hal_uart_dma_rx_stop(int port)
+{
+    struct hal_uart *u;
+    DMA_HandleTypeDef *hdma;
+    int cnt;
+    int sr;
+
+    if (port >= UART_CNT) {
+        return -1;
+    }
+    u = &uarts[port];
+    if (!u->u_open || !u->u_dma) {
+        return -1;
+    }
+    hdma = u->u_cfg->suc_dma_rx;
+
+    __HAL_DISABLE_INTERRUPTS(sr);
+    if (hdma->State != HAL_DMA_STATE_BUSY) {
+        __HAL_ENABLE_INTERRUPTS(sr);
+        return 0;
+    }
+    /*
+     * Abort clears the pending transfer complete flag, so rx_done does
+     * not get called for this buffer.
+     */
+    HAL_DMA_Abort(hdma);
+    cnt = u->u_dma_rx_len - __HAL_DMA_GET_COUNTER(hdma);
+    __HAL_ENABLE_INTERRUPTS(sr);
+
+    return cnt;
+}
+
+static void
+uart_dma_tx_cplt(DMA_HandleTypeDef *hdma)
+{
+    struct hal_uart *u;
+
+    u = hdma->Parent;
+    if (u->u_dma_tx_done) {
+        u->u_dma_tx_done(u->u_func_arg);
+    }
+}
+
+static void
+uart_dma_rx_cplt(DMA_HandleTypeDef *hdma)
+{
+    struct hal_uart *u;
+
+    u = hdma->Parent;
+    if (u->u_dma_rx_done) {
+        u->u_dma_rx_done(u->u_func_arg);
+    }
+}
+
+static int
+uart_dma_setup(struct hal_uart *u, int slot, DMA_HandleTypeDef *hdma,
+  IRQn_Type irqn, uint32_t dir, void (*cplt)(DMA_HandleTypeDef *))
+{
+    if ((uint32_t)hdma->Instance >= DMA2_BASE) {
+        __HAL_RCC_DMA2_CLK_ENABLE();
+    } else {
+        __HAL_RCC_DMA1_CLK_ENABLE();
+    }
+
+    hdma->Init.Direction = dir;
+    hdma->Init.PeriphInc = DMA_PINC_DISABLE;
+    hdma->Init.MemInc = DMA_MINC_ENABLE;
+    hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    hdma->Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    hdma->Init.Mode = DMA_NORMAL;
+    hdma->Init.Priority = DMA_PRIORITY_HIGH;
+    hdma->Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    if (HAL_DMA_Init(hdma) != HAL_OK) {
+        return -1;
+    }
+    hdma->Parent = u;
+    hdma->XferCpltCallback = cplt;
+
+    uart_dma_irqs[slot] = hdma;
+    NVIC_SetVector(irqn, (uint32_t)uart_dma_isrs[slot]);
+    NVIC_EnableIRQ(irqn);
+
+    return 0;
+}
+
 static void
 uart_irq_handler(int num)
 {
@@ -84,6 +296,17 @@ uart_irq_handler(int num)
     regs = u->u_regs;
 
     isr = regs->SR;
+    if (u->u_dma) {
+        if (isr & USART_SR_IDLE) {
+            /* Cleared by reading SR followed by DR */
+            (void)regs->DR;
+            if (u->u_dma_rx_idle &&
+              u->u_cfg->suc_dma_rx->State == HAL_DMA_STATE_BUSY) {
+                u->u_dma_rx_idle(u->u_func_arg);
+            }
+        }
+        return;
+    }
     if (isr & USART_SR_RXNE) {
         data = regs->DR;
         rc = u->u_rx_func(u->u_func_arg, data);
@@ -293,7 +516,8 @@ hal_uart_config(int port, int32_t baudrate, uint8_t databits, uint8_t stopbits,
     cr1 &= ~(USART_CR1_M | USART_CR1_PCE | USART_CR1_PS | USART_CR1_RE |
       USART_CR1_OVER8);
     cr2 &= ~(USART_CR2_STOP);
-    cr3 &= ~(USART_CR3_RTSE | USART_CR3_CTSE);
+    cr3 &= ~(USART_CR3_RTSE | USART_CR3_CTSE | USART_CR3_DMAT |
+      USART_CR3_DMAR);
 
     switch (databits) {
     case 8:
@@ -349,6 +573,16 @@ hal_uart_config(int port, int32_t baudrate, uint8_t databits, uint8_t stopbits,
 
     cr1 |= (UART_MODE_RX | UART_MODE_TX | UART_OVERSAMPLING_16);
 
+    if (u->u_dma) {
+        cr3 |= USART_CR3_DMAT | USART_CR3_DMAR;
+        if (uart_dma_setup(u, port * 2, cfg->suc_dma_tx,
+            cfg->suc_dma_tx_irqn, DMA_MEMORY_TO_PERIPH, uart_dma_tx_cplt) ||
+          uart_dma_setup(u, port * 2 + 1, cfg->suc_dma_rx,
+            cfg->suc_dma_rx_irqn, DMA_PERIPH_TO_MEMORY, uart_dma_rx_cplt)) {
+            return -1;
+        }
+    }
+
     *cfg->suc_rcc_reg |= cfg->suc_rcc_dev;
 
     hal_gpio_init_af(cfg->suc_pin_tx, cfg->suc_pin_af, 0, 0);
@@ -372,7 +606,15 @@ hal_uart_config(int port, int32_t baudrate, uint8_t databits, uint8_t stopbits,
     (void)u->u_regs->SR;
     hal_uart_set_nvic(cfg->suc_irqn, u);
 
-    u->u_regs->CR1 |= (USART_CR1_RXNEIE | USART_CR1_UE);
+    if (u->u_dma) {
+        /* Reception starts when the first buffer is handed to us */
+        if (u->u_dma_rx_idle) {
+            u->u_regs->CR1 |= USART_CR1_IDLEIE;
+        }
+        u->u_regs->CR1 |= USART_CR1_UE;
+    } else {
+        u->u_regs->CR1 |= (USART_CR1_RXNEIE | USART_CR1_UE);
+    }
     u->u_open = 1;
 
     return 0;
@@ -404,6 +646,14 @@ hal_uart_close(int port)
 
     u->u_open = 0;
     u->u_regs->CR1 = 0;
+    if (u->u_dma) {
+        if (u->u_cfg->suc_dma_tx->State == HAL_DMA_STATE_BUSY) {
+            HAL_DMA_Abort(u->u_cfg->suc_dma_tx);
+        }
+        if (u->u_cfg->suc_dma_rx->State == HAL_DMA_STATE_BUSY) {
+            HAL_DMA_Abort(u->u_cfg->suc_dma_rx);
+        }
+    }
 
     return 0;
 }
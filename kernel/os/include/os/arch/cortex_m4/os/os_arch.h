@@ -58,6 +58,32 @@ typedef uint32_t os_stack_t;
 #define OS_EXIT_CRITICAL(__os_sr) (os_arch_restore_sr(__os_sr))
 #define OS_ASSERT_CRITICAL() (assert(os_arch_in_critical()))
 
+/*
+ * Exclusive load / store (LDREX / STREX).  The local monitor is cleared on
+ * every exception entry and return, so a store only succeeds if nothing ran
+ * on the core since the matching load.
+ */
+#define OS_ARCH_HAS_EXCLUSIVE   (1)
+
+static inline uint32_t
+os_arch_ldrex(volatile uint32_t *addr)
+{
+    return __LDREXW(addr);
+}
+
+/* Returns 0 if the store succeeded, 1 if it must be retried. */
+static inline int
+os_arch_strex(volatile uint32_t *addr, uint32_t val)
+{
+    return __STREXW(val, addr);
+}
+
+static inline void
+os_arch_clrex(void)
+{
+    __CLREX();
+}
+
 os_stack_t *os_arch_task_stack_init(struct os_task *, os_stack_t *, int);
 void timer_handler(void);
 void os_arch_ctx_sw(struct os_task *);
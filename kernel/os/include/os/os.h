@@ -22,6 +22,7 @@
 
 #include <stdlib.h>
 #include <inttypes.h>
+#include "syscfg/syscfg.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -46,6 +47,28 @@ extern "C" {
 
 #define CTASSERT(x) typedef int __ctasssert ## __LINE__[(x) ? 1 : -1]
 
+/*
+ * Section placement.  OS_RAMFUNC puts a function in RAM, where it runs
+ * without flash wait states; the startup code copies it along with .data.
+ * OS_CCM_DATA and OS_CCM_BSS put initialized and zeroed variables in
+ * core-coupled RAM, which only the CPU can reach (not DMA), on MCUs that
+ * have it; elsewhere they land in ordinary RAM.  The BSP linker script must
+ * map the .ramfunc, .data.core and .bss.core sections.
+ */
+#if MYNEWT_VAL(OS_RAMFUNC)
+#define OS_RAMFUNC  __attribute__((section(".ramfunc"), noinline))
+#else
+#define OS_RAMFUNC
+#endif
+
+#if MYNEWT_VAL(OS_CCM)
+#define OS_CCM_DATA __attribute__((section(".data.core")))
+#define OS_CCM_BSS  __attribute__((section(".bss.core")))
+#else
+#define OS_CCM_DATA
+#define OS_CCM_BSS
+#endif
+
 
 /**
  * Whether or not the operating system has been started.  Set to
@@ -96,15 +119,20 @@ void os_init_idle_task(void);
 #include "os/os_callout.h"
 #include "os/os_dev.h"
 #include "os/os_eventq.h"
+#include "os/os_fiber.h"
 #include "os/os_heap.h"
 #include "os/os_mbuf.h"
 #include "os/os_mempool.h"
 #include "os/os_mutex.h"
+#include "os/os_pm.h"
+#include "os/os_rwlock.h"
 #include "os/os_sanity.h"
 #include "os/os_sched.h"
 #include "os/os_sem.h"
 #include "os/os_task.h"
 #include "os/os_time.h"
+#include "os/os_trace.h"
+#include "os/os_work.h"
 
 #ifdef __cplusplus
 }
@@ -198,6 +198,80 @@ void os_cputime_timer_relative(struct hal_timer *timer, uint32_t usecs);
  */
 void os_cputime_timer_stop(struct hal_timer *timer);
 
+#if MYNEWT_VAL(OS_CPUTIME_BATCH)
+/*
+ * A batched cputime timer.  All batched timers are multiplexed onto one
+ * hal_timer; see OS_CPUTIME_BATCH_SLACK_USECS.  The callback is called at
+ * interrupt context.
+ */
+struct os_cputime_btimer {
+    hal_timer_cb bt_cb;
+    void *bt_arg;
+    uint32_t bt_expiry;
+    uint8_t bt_queued;
+    uint8_t bt_idx;             /* position in the timer heap */
+    /* Lateness is the time from expiry to the callback, in cputime ticks */
+    uint32_t bt_fired;
+    uint32_t bt_last_late;
+    uint32_t bt_max_late;
+};
+
+/**
+ * Initializes a batched timer.  Must not be called while the timer is
+ * running.
+ *
+ * @param bt    The timer to initialize. Cannot be NULL.
+ * @param fp    The timer callback function. Cannot be NULL.
+ * @param arg   Pointer to data object to pass to the callback.
+ */
+void os_cputime_btimer_init(struct os_cputime_btimer *bt, hal_timer_cb fp,
+                            void *arg);
+
+/**
+ * Starts, or restarts, a batched timer that expires at 'cputime'.  At most
+ * OS_CPUTIME_BATCH_MAX timers can be running at a time.
+ *
+ * @param bt        The timer to start. Cannot be NULL.
+ * @param cputime   The cputime at which the timer should expire.
+ *
+ * @return 0 on success; OS_ENOMEM if the timer is not running and
+ *         OS_CPUTIME_BATCH_MAX timers already are.
+ */
+int os_cputime_btimer_start(struct os_cputime_btimer *bt, uint32_t cputime);
+
+/**
+ * Starts, or restarts, a batched timer that expires 'usecs' microseconds
+ * from now.
+ *
+ * @param bt    The timer to start. Cannot be NULL.
+ * @param usecs The number of usecs from now at which the timer will expire.
+ *
+ * @return 0 on success; OS_ENOMEM if OS_CPUTIME_BATCH_MAX timers are
+ *         already running.
+ */
+int os_cputime_btimer_relative(struct os_cputime_btimer *bt, uint32_t usecs);
+
+/**
+ * Stops a batched timer.  Can be called even if the timer is not running.
+ *
+ * @param bt The timer to stop. Cannot be NULL.
+ */
+void os_cputime_btimer_stop(struct os_cputime_btimer *bt);
+
+/**
+ * Returns the number of times the batched timer service has programmed the
+ * hardware compare.
+ */
+uint32_t os_cputime_btimer_reprograms(void);
+
+/**
+ * Returns the measured delay from a compare match to the batched timer
+ * interrupt handler running, in cputime ticks.  Updated only if
+ * OS_CPUTIME_BATCH_LATENCY_MAX_USECS is non-zero.
+ */
+uint32_t os_cputime_btimer_latency(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
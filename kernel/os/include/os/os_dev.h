@@ -59,12 +59,17 @@ typedef int (*os_dev_open_func_t)(struct os_dev *, uint32_t,
 typedef int (*os_dev_suspend_func_t)(struct os_dev *, os_time_t, int);
 typedef int (*os_dev_resume_func_t)(struct os_dev *);
 typedef int (*os_dev_close_func_t)(struct os_dev *);
+typedef void (*os_dev_clock_func_t)(struct os_dev *, int on);
 
 struct os_dev_handlers {
     os_dev_open_func_t od_open;
     os_dev_suspend_func_t od_suspend;
     os_dev_resume_func_t od_resume;
     os_dev_close_func_t od_close;
+#if MYNEWT_VAL(OS_PM)
+    /* Turn peripheral clock on/off; see os_pm_dev_active() */
+    os_dev_clock_func_t od_clock;
+#endif
 };
 
 /*
@@ -79,6 +84,10 @@ struct os_dev {
     uint8_t od_open_ref;
     uint8_t od_flags;
     char *od_name;
+#if MYNEWT_VAL(OS_PM)
+    uint8_t od_pm_active;       /* activity reference count */
+    uint8_t od_pm_max_state;    /* deepest sleep state while active */
+#endif
     STAILQ_ENTRY(os_dev) od_next;
 };
 
@@ -21,6 +21,7 @@
 #define _OS_EVENTQ_H
 
 #include <inttypes.h>
+#include "syscfg/syscfg.h"
 #include "os/os_time.h"
 #include "os/queue.h"
 
@@ -33,16 +34,76 @@ typedef void os_event_fn(struct os_event *ev);
 
 struct os_event {
     uint8_t ev_queued;
+#if MYNEWT_VAL(OS_EVENTQ_PRIOS) > 1
+    /* Priority level; 0 is the most urgent, see OS_EVENT_PRIO_SET() */
+    uint8_t ev_prio;
+#endif
     os_event_fn *ev_cb;
     void *ev_arg;
     STAILQ_ENTRY(os_event) ev_next;
+#if MYNEWT_VAL(OS_EVENTQ_STATS)
+    /* OS time at which the event was queued */
+    os_time_t ev_time;
+#endif
+#if MYNEWT_VAL(OS_EVENTQ_LATENCY)
+    /* os_cputime at which the event was queued */
+    uint32_t ev_cputime;
+#endif
 };
 
 #define OS_EVENT_QUEUED(__ev) ((__ev)->ev_queued)
 
+/*
+ * Event priority levels.  Events of a more urgent level (lower number) are
+ * taken before any queued event of a less urgent one; events of the same
+ * level are taken in FIFO order.  Levels past OS_EVENT_PRIO_LOWEST are
+ * treated as OS_EVENT_PRIO_LOWEST.  Zero-initialized events have the most
+ * urgent level, so only bulk work needs to be demoted.  Without
+ * OS_EVENTQ_PRIOS the priority is ignored and each queue is a single FIFO.
+ */
+#define OS_EVENT_PRIO_HIGHEST   (0)
+#define OS_EVENT_PRIO_LOWEST    (MYNEWT_VAL(OS_EVENTQ_PRIOS) - 1)
+
+#if MYNEWT_VAL(OS_EVENTQ_PRIOS) > 1
+#define OS_EVENT_PRIO_SET(__ev, __prio) ((__ev)->ev_prio = (__prio))
+#define OS_EVENT_PRIO(__ev)                                 \
+    ((__ev)->ev_prio > OS_EVENT_PRIO_LOWEST ?               \
+        OS_EVENT_PRIO_LOWEST : (__ev)->ev_prio)
+#else
+#define OS_EVENT_PRIO_SET(__ev, __prio) ((void)(__ev), (void)(__prio))
+#define OS_EVENT_PRIO(__ev)             (0)
+#endif
+
 struct os_eventq {
     struct os_task *evq_task;
     STAILQ_HEAD(, os_event) evq_list;
+#if MYNEWT_VAL(OS_EVENTQ_PRIOS) > 1
+    /*
+     * evq_list is kept sorted by priority; this is the last queued event of
+     * each level, or NULL if the level has none queued.
+     */
+    struct os_event *evq_prio_tail[MYNEWT_VAL(OS_EVENTQ_PRIOS)];
+#endif
+#if MYNEWT_VAL(OS_EVENTQ_STATS)
+    /* Number of events currently queued, and the most ever queued */
+    uint16_t evq_depth;
+    uint16_t evq_max_depth;
+    /* Longest time, in OS ticks, an event waited before being removed */
+    os_time_t evq_max_latency;
+#if MYNEWT_VAL(OS_EVENTQ_PRIOS) > 1
+    /*
+     * The same, per priority level.  Shows how long urgent traffic starves
+     * the less urgent levels.
+     */
+    os_time_t evq_prio_max_latency[MYNEWT_VAL(OS_EVENTQ_PRIOS)];
+#endif
+#endif
+#if MYNEWT_VAL(OS_EVENTQ_LATENCY)
+    /* Bucket n counts events that waited 2^n to 2^(n+1) cputime ticks */
+    uint32_t evq_lat_hist[MYNEWT_VAL(OS_EVENTQ_LATENCY_BUCKETS)];
+    const char *evq_name;
+    STAILQ_ENTRY(os_eventq) evq_lat_next;
+#endif
 };
 
 void os_eventq_init(struct os_eventq *);
@@ -50,6 +111,8 @@ int os_eventq_inited(const struct os_eventq *evq);
 void os_eventq_put(struct os_eventq *, struct os_event *);
 struct os_event *os_eventq_get(struct os_eventq *);
 void os_eventq_run(struct os_eventq *evq);
+int os_eventq_run_many(struct os_eventq *evq, int max_events,
+                       os_time_t budget);
 struct os_event *os_eventq_poll(struct os_eventq **, int, os_time_t);
 void os_eventq_remove(struct os_eventq *, struct os_event *);
 void os_eventq_dflt_set(struct os_eventq *evq);
@@ -58,6 +121,19 @@ void os_eventq_designate(struct os_eventq **dst, struct os_eventq *val,
                          struct os_event *start_ev);
 void os_eventq_ensure(struct os_eventq **evq, struct os_event *start_ev);
 
+#if MYNEWT_VAL(OS_EVENTQ_LATENCY)
+#define OS_EVENTQ_INFO_NAME_LEN (32)
+
+struct os_eventq_info {
+    uint32_t oei_lat_hist[MYNEWT_VAL(OS_EVENTQ_LATENCY_BUCKETS)];
+    char oei_name[OS_EVENTQ_INFO_NAME_LEN];
+};
+
+int os_eventq_lat_register(struct os_eventq *evq, const char *name);
+struct os_eventq *os_eventq_info_get_next(struct os_eventq *,
+        struct os_eventq_info *);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,148 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _OS_FIBER_H_
+#define _OS_FIBER_H_
+
+#include <inttypes.h>
+#include "syscfg/syscfg.h"
+#include "os/queue.h"
+#include "os/os_eventq.h"
+#include "os/os_callout.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Fibers are stackless cooperative threads (protothreads).  A fiber is a
+ * function that is called from an event queue, on whichever task runs that
+ * queue, every time the fiber is woken.  It uses the OS_FIBER_* macros to
+ * wait; a wait saves the resume point in the fiber and returns, and the next
+ * call jumps back to it.  So a fiber costs the size of struct os_fiber
+ * rather than a stack, but:
+ *   - local variables do not survive a wait; keep state in a struct that
+ *     embeds the os_fiber,
+ *   - waits can only appear in the fiber function itself, not in functions
+ *     it calls, and not inside a switch statement,
+ *   - a fiber must not block the task it runs on; use the fiber waits.
+ * A fiber can be resumed when nothing it waits for has happened; every wait
+ * rechecks its condition.
+ */
+struct os_fiber;
+typedef int os_fiber_fn(struct os_fiber *f);
+
+/* Values returned by a fiber function; the macros return them. */
+#define OS_FIBER_WAITING    (0)
+#define OS_FIBER_EXITED     (1)
+
+struct os_fiber {
+    struct os_event of_ev;          /* Posted to resume the fiber */
+    struct os_callout of_timer;     /* Sleep timer */
+    struct os_eventq *of_evq;
+    os_fiber_fn *of_fn;
+    void *of_arg;
+    struct os_fiber_sem *of_sem;    /* Semaphore waited on, if any */
+    SLIST_ENTRY(os_fiber) of_sem_next;
+    uint16_t of_lc;                 /* Resume point, 0 for the start */
+    uint8_t of_running;
+    uint8_t of_signalled;
+};
+
+/*
+ * A counting semaphore fibers can wait on.  It can be released from any
+ * task or interrupt handler.
+ */
+struct os_fiber_sem {
+    uint16_t ofs_tokens;
+    SLIST_HEAD(, os_fiber) ofs_waiters;
+};
+
+void os_fiber_init(struct os_fiber *f, os_fiber_fn *fn, void *arg);
+void os_fiber_start(struct os_fiber *f, struct os_eventq *evq);
+void os_fiber_stop(struct os_fiber *f);
+void os_fiber_wake(struct os_fiber *f);
+void os_fiber_signal(struct os_fiber *f);
+
+void os_fiber_sem_init(struct os_fiber_sem *sem, uint16_t tokens);
+void os_fiber_sem_release(struct os_fiber_sem *sem);
+
+/* Used by the macros below. */
+void os_fiber_sleep_start(struct os_fiber *f, os_time_t ticks);
+int os_fiber_sleeping(struct os_fiber *f);
+int os_fiber_sem_try(struct os_fiber *f, struct os_fiber_sem *sem);
+int os_fiber_signal_take(struct os_fiber *f);
+
+/* Must open a fiber function, after its declarations. */
+#define OS_FIBER_BEGIN(f)                                           \
+    switch ((f)->of_lc) {                                           \
+    case 0:
+
+/* Must close a fiber function; the fiber exits when it gets here. */
+#define OS_FIBER_END(f)                                             \
+    }                                                               \
+    (f)->of_lc = 0;                                                 \
+    return OS_FIBER_EXITED
+
+/* Exits the fiber. */
+#define OS_FIBER_EXIT(f)                                            \
+    do {                                                            \
+        (f)->of_lc = 0;                                             \
+        return OS_FIBER_EXITED;                                     \
+    } while (0)
+
+/* Waits until 'cond' is true; it is evaluated every time the fiber runs. */
+#define OS_FIBER_WAIT_UNTIL(f, cond)                                \
+    do {                                                            \
+        (f)->of_lc = __LINE__;                                      \
+    case __LINE__:                                                  \
+        if (!(cond)) {                                              \
+            return OS_FIBER_WAITING;                                \
+        }                                                           \
+    } while (0)
+
+/* Lets the other events on the fiber's queue run, then continues. */
+#define OS_FIBER_YIELD(f)                                           \
+    do {                                                            \
+        os_fiber_wake(f);                                           \
+        (f)->of_lc = __LINE__;                                      \
+        return OS_FIBER_WAITING;                                    \
+    case __LINE__:;                                                 \
+    } while (0)
+
+/* Sleeps for 'ticks' OS ticks. */
+#define OS_FIBER_SLEEP(f, ticks)                                    \
+    do {                                                            \
+        os_fiber_sleep_start((f), (ticks));                         \
+        OS_FIBER_WAIT_UNTIL((f), !os_fiber_sleeping(f));            \
+    } while (0)
+
+/* Takes a token from a fiber semaphore, waiting until one is available. */
+#define OS_FIBER_SEM_WAIT(f, sem)                                   \
+    OS_FIBER_WAIT_UNTIL((f), os_fiber_sem_try((f), (sem)) == 0)
+
+/* Waits until os_fiber_signal() is called for the fiber. */
+#define OS_FIBER_WAIT_SIGNAL(f)                                     \
+    OS_FIBER_WAIT_UNTIL((f), os_fiber_signal_take(f))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* _OS_FIBER_H_ */
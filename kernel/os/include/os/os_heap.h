@@ -21,6 +21,7 @@
 #define H_OS_HEAP_
 
 #include <stddef.h>
+#include <inttypes.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -30,6 +31,18 @@ void *os_malloc(size_t size);
 void os_free(void *mem);
 void *os_realloc(void *ptr, size_t size);
 
+struct os_heap_info {
+    uint32_t ohi_free;          /* bytes on the heap free list */
+    uint32_t ohi_min_free;      /* low-water mark of ohi_free */
+    uint32_t ohi_largest_free;  /* largest free block */
+    uint32_t ohi_free_blocks;   /* number of free blocks */
+    uint32_t ohi_num_allocs;
+    uint32_t ohi_num_frees;
+    uint32_t ohi_num_fail;
+};
+
+int os_heap_info_get(struct os_heap_info *ohi);
+
 #ifdef __cplusplus
 }
 #endif
@@ -49,6 +49,15 @@ struct os_mbuf_pool {
      */
     struct os_mempool *omp_pool;
 
+    /**
+     * Number of msys allocations served by this pool.
+     */
+    uint32_t omp_msys_hits;
+    /**
+     * Number of msys allocations that tried this pool and found it empty.
+     */
+    uint32_t omp_msys_misses;
+
     /**
      * Link to the next mbuf pool for system memory pools.
      */
@@ -74,6 +83,39 @@ struct os_mbuf_pkthdr {
     STAILQ_ENTRY(os_mbuf_pkthdr) omp_next;
 };
 
+struct os_mbuf_ext;
+typedef void os_mbuf_ext_free_fn(struct os_mbuf_ext *ext);
+
+/**
+ * An externally owned data buffer that mbufs can point into instead of
+ * carrying the data in their own pool block.  The buffer is shared by every
+ * mbuf that references it; when the last of them is freed, ome_free_cb is
+ * called so the owner can reclaim the memory.  The data of an external mbuf
+ * must be treated as read-only.
+ */
+struct os_mbuf_ext {
+    /**
+     * Start of the external data.
+     */
+    uint8_t *ome_buf;
+    /**
+     * Size of the external data, in bytes.
+     */
+    uint16_t ome_len;
+    /**
+     * Number of mbufs currently referencing the buffer.
+     */
+    uint16_t ome_refcnt;
+    /**
+     * Called when the last reference is dropped; may be NULL.
+     */
+    os_mbuf_ext_free_fn *ome_free_cb;
+    /**
+     * Argument for the owner's use.
+     */
+    void *ome_arg;
+};
+
 /**
  * Chained memory buffer.
  */
@@ -111,9 +153,45 @@ struct os_mbuf {
     uint8_t om_databuf[0];
 };
 
+/**
+ * A contiguous run of mbuf data, as filled in by os_mbuf_iovec().
+ */
+struct os_mbuf_iovec {
+    /**
+     * Start of the data; points into the mbuf's data buffer.
+     */
+    uint8_t *oiov_base;
+    /**
+     * Number of bytes at oiov_base.
+     */
+    uint16_t oiov_len;
+};
+
+struct os_mqueue;
+
+/*
+ * Called when an mbuf queue becomes congested (its depth reached the high
+ * watermark), and again when it drains to the low watermark.
+ */
+typedef void os_mqueue_flow_fn(struct os_mqueue *mq, int congested);
+
+/* Only post the event when an mbuf is put on an empty queue */
+#define OS_MQUEUE_F_BATCH       (0x01)
+#define OS_MQUEUE_F_CONGESTED   (0x02)
+
 struct os_mqueue {
     STAILQ_HEAD(, os_mbuf_pkthdr) mq_head;
     struct os_event mq_ev;
+#if MYNEWT_VAL(OS_MQUEUE_FLOW)
+    uint16_t mq_depth;
+    uint16_t mq_max_depth;
+    uint16_t mq_high;           /* 0 for no limit */
+    uint16_t mq_low;
+    uint8_t mq_flags;
+    os_mqueue_flow_fn *mq_flow_cb;
+    uint32_t mq_posts;          /* # of events posted */
+    uint32_t mq_drops;          /* # of puts refused while congested */
+#endif
 };
 
 /*
@@ -123,6 +201,20 @@ struct os_mqueue {
  */
 #define OS_MBUF_F_MASK(__n) (1 << (__n))
 
+/* The mbuf's data lives in an external buffer; see os_mbuf_get_ext(). */
+#define OS_MBUF_F_EXT       (7)
+
+/*
+ * Checks whether a given mbuf points at an external buffer
+ *
+ * @param __om The mbuf to check
+ */
+#define OS_MBUF_IS_EXT(__om) \
+    ((__om)->om_flags & OS_MBUF_F_MASK(OS_MBUF_F_EXT))
+
+/* Get the external buffer descriptor of an external mbuf */
+#define OS_MBUF_EXT(__om) (*(struct os_mbuf_ext **)&(__om)->om_databuf[0])
+
 /* 
  * Checks whether a given mbuf is a packet header mbuf 
  *
@@ -180,6 +272,10 @@ _os_mbuf_leadingspace(struct os_mbuf *om)
     uint16_t startoff;
     uint16_t leadingspace;
 
+    if (OS_MBUF_IS_EXT(om)) {
+        return 0;
+    }
+
     startoff = 0;
     if (OS_MBUF_IS_PKTHDR(om)) {
         startoff = om->om_pkthdr_len;
@@ -209,6 +305,10 @@ _os_mbuf_trailingspace(struct os_mbuf *om)
 {
     struct os_mbuf_pool *omp;
 
+    if (OS_MBUF_IS_EXT(om)) {
+        return 0;
+    }
+
     omp = om->om_omp;
 
     return (&om->om_databuf[0] + omp->omp_databuf_len) -
@@ -237,6 +337,15 @@ struct os_mbuf *os_mqueue_get(struct os_mqueue *);
 /* Put an element in a mbuf queue */
 int os_mqueue_put(struct os_mqueue *, struct os_eventq *, struct os_mbuf *);
 
+#if MYNEWT_VAL(OS_MQUEUE_FLOW)
+/* Set the flow control watermarks and options of a mbuf queue */
+int os_mqueue_flow_set(struct os_mqueue *mq, uint16_t high, uint16_t low,
+                       uint8_t flags, os_mqueue_flow_fn *cb);
+
+/* Check whether a mbuf queue is refusing puts */
+int os_mqueue_congested(const struct os_mqueue *mq);
+#endif
+
 /* Register an mbuf pool with the system pool registry */
 int os_msys_register(struct os_mbuf_pool *);
 
@@ -252,6 +361,47 @@ struct os_mbuf *os_msys_get_pkthdr(uint16_t dsize, uint16_t user_hdr_len);
 int os_msys_count(void);
 int os_msys_num_free(void);
 
+#if MYNEWT_VAL(OS_MSYS_ADVISE)
+/*
+ * Number of size classes os_msys_get() requests are counted in.  Class n
+ * counts requests for up to 16 << n bytes of data (packet headers
+ * included) that do not fit class n - 1; the last class also counts all
+ * larger requests.  Requests of unknown (0) size count in class 0.
+ */
+#define OS_MSYS_DEMAND_CLASSES      (8)
+
+/* Most pools in a recommended layout (MSYS_1 to MSYS_5) */
+#define OS_MSYS_ADVICE_MAX_POOLS    (5)
+
+struct os_msys_demand {
+    uint32_t omd_reqs[OS_MSYS_DEMAND_CLASSES];
+    /* Requests no pool could satisfy */
+    uint32_t omd_num_fail;
+};
+
+/* One pool of a recommended layout, as MSYS_<n>_BLOCK_SIZE / _COUNT */
+struct os_msys_advice_pool {
+    uint16_t omap_block_size;
+    uint16_t omap_block_count;
+};
+
+struct os_msys_advice {
+    /* RAM taken by the recommended layout */
+    uint32_t oma_bytes;
+    /* RAM the layout would take if it was not fitted to the budget */
+    uint32_t oma_need_bytes;
+    uint8_t oma_num_pools;
+    struct os_msys_advice_pool oma_pools[OS_MSYS_ADVICE_MAX_POOLS];
+};
+
+/* Read or clear the msys demand counters */
+void os_msys_demand_get(struct os_msys_demand *omd);
+void os_msys_demand_clear(void);
+
+/* Recommend an msys pool layout for a RAM budget */
+int os_msys_advise(uint32_t budget, struct os_msys_advice *oma);
+#endif
+
 /* Initialize a mbuf pool */
 int os_mbuf_pool_init(struct os_mbuf_pool *, struct os_mempool *mp, 
         uint16_t, uint16_t);
@@ -263,6 +413,15 @@ struct os_mbuf *os_mbuf_get(struct os_mbuf_pool *omp, uint16_t);
 struct os_mbuf *os_mbuf_get_pkthdr(struct os_mbuf_pool *omp, 
         uint8_t pkthdr_len);
 
+/* Initialize an external buffer descriptor */
+void os_mbuf_ext_init(struct os_mbuf_ext *ext, void *buf, uint16_t len,
+                      os_mbuf_ext_free_fn *free_cb, void *arg);
+
+/* Allocate a new mbuf that points into an external buffer */
+struct os_mbuf *os_mbuf_get_ext(struct os_mbuf_pool *omp,
+                                struct os_mbuf_ext *ext, uint16_t off,
+                                uint16_t len);
+
 /* Duplicate a mbuf from the pool */
 struct os_mbuf *os_mbuf_dup(struct os_mbuf *m);
 
@@ -272,6 +431,10 @@ struct os_mbuf *os_mbuf_off(const struct os_mbuf *om, int off,
 /* Copy data from an mbuf to a flat buffer. */
 int os_mbuf_copydata(const struct os_mbuf *m, int off, int len, void *dst);
 
+/* Describe a range of an mbuf chain as an array of contiguous segments. */
+int os_mbuf_iovec(const struct os_mbuf *om, int off, int len,
+                  struct os_mbuf_iovec *iov, int max_iov);
+
 /* Append data onto a mbuf */
 int os_mbuf_append(struct os_mbuf *m, const void *, uint16_t);
 
@@ -285,6 +448,8 @@ int os_mbuf_free(struct os_mbuf *mb);
 int os_mbuf_free_chain(struct os_mbuf *om);
 
 void os_mbuf_adj(struct os_mbuf *mp, int req_len);
+/* Split a packet in two at the given offset */
+struct os_mbuf *os_mbuf_split(struct os_mbuf *om, uint16_t off);
 int os_mbuf_cmpf(const struct os_mbuf *om, int off, const void *data,
                    int len);
 int os_mbuf_cmpm(const struct os_mbuf *om1, uint16_t offset1,
@@ -295,6 +460,11 @@ struct os_mbuf *os_mbuf_prepend(struct os_mbuf *om, int len);
 struct os_mbuf *os_mbuf_prepend_pullup(struct os_mbuf *om, uint16_t len);
 int os_mbuf_copyinto(struct os_mbuf *om, int off, const void *src, int len);
 void os_mbuf_concat(struct os_mbuf *first, struct os_mbuf *second);
+/* Move chain data into earlier buffers and free the emptied ones */
+int os_mbuf_compact(struct os_mbuf *om);
+int os_mbuf_waste(const struct os_mbuf *om);
+int os_mbuf_compact_wasteful(struct os_mbuf *om);
+struct os_mbuf *os_mbuf_pack_chains(struct os_mbuf *m1, struct os_mbuf *m2);
 void *os_mbuf_extend(struct os_mbuf *om, uint16_t len);
 struct os_mbuf *os_mbuf_pullup(struct os_mbuf *om, uint16_t len);
 
@@ -47,6 +47,8 @@ struct os_mempool {
     int mp_block_size;          /* Size of the memory blocks, in bytes. */
     int mp_num_blocks;          /* The number of memory blocks. */
     int mp_num_free;            /* The number of free blocks left */
+    int mp_min_free;            /* Lowest number of free blocks ever seen */
+    uint32_t mp_num_fail;       /* Number of failed allocations */
     uint32_t mp_membuf_addr;    /* Address of memory buffer used by pool */
     STAILQ_ENTRY(os_mempool) mp_list;
     SLIST_HEAD(,os_memblock);   /* Pointer to list of free blocks */
@@ -59,12 +61,21 @@ struct os_mempool_info {
     int omi_block_size;
     int omi_num_blocks;
     int omi_num_free;
+    int omi_min_free;
+    uint32_t omi_num_fail;
+    /* RAM taken by the pool's blocks, including alignment padding */
+    uint32_t omi_mem_bytes;
     char omi_name[OS_MEMPOOL_INFO_NAME_LEN];
 };
 
 struct os_mempool *os_mempool_info_get_next(struct os_mempool *,
         struct os_mempool_info *);
 
+#if MYNEWT_VAL(OS_MSYS_ADVISE)
+/* Recommend a block count for a pool, given how it has been used */
+int os_mempool_advise(const struct os_mempool *mp);
+#endif
+
 /*
  * To calculate size of the memory buffer needed for the pool. NOTE: This size
  * is NOT in bytes! The size is the number of os_membuf_t elements required for
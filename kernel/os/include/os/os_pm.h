@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _OS_PM_H
+#define _OS_PM_H
+
+#include <inttypes.h>
+#include "syscfg/syscfg.h"
+#include "os/os_time.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sleep states, from shallowest to deepest.  What the MCU does in each is
+ * up to its os_tick_idle(), which can check os_pm_idle_state().
+ */
+#define OS_PM_STATE_IDLE        0       /* wait for interrupt, clocks on */
+#define OS_PM_STATE_SLEEP       1       /* all devices idle and gated */
+#define OS_PM_STATE_DEEP        2       /* deep sleep; slow to wake up */
+#define OS_PM_STATE_CNT         3
+
+#if MYNEWT_VAL(OS_PM)
+struct os_dev;
+
+/*
+ * Mark device as being in use, e.g. when a transfer starts.  Calls nest;
+ * the device clock is turned on by the first, and turned off again by the
+ * matching last os_pm_dev_idle().  While a device is active the system
+ * sleeps no deeper than its max state, OS_PM_STATE_IDLE by default.  Can
+ * be called from interrupt context.  Return OS_EINVAL if the calls nest
+ * too deep, or on os_pm_dev_idle() for a device that is not active.
+ */
+int os_pm_dev_active(struct os_dev *dev);
+int os_pm_dev_idle(struct os_dev *dev);
+
+/*
+ * Set the deepest sleep state the device can work in while active.
+ * Returns OS_EINVAL if state is not a valid sleep state.
+ */
+int os_pm_dev_max_state(struct os_dev *dev, int state);
+
+/*
+ * State the idle task is entering; for use by os_tick_idle().
+ */
+int os_pm_idle_state(void);
+
+/*
+ * Called by the idle task, with interrupts disabled, instead of calling
+ * os_tick_idle() directly.
+ */
+void os_pm_idle(os_time_t ticks);
+
+/*
+ * Time spent in a sleep state, in OS ticks, and number of times it was
+ * entered.
+ */
+int os_pm_residency(int state, uint32_t *ticks, uint32_t *entries);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _OS_PM_H */
@@ -0,0 +1,64 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _OS_RWLOCK_H_
+#define _OS_RWLOCK_H_
+
+#include "os/os.h"
+#include "os/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A reader/writer lock.  Any number of tasks may hold it for reading, or a
+ * single task for writing.  Waiting tasks are served in priority order, and
+ * a task holding the write lock inherits the priority of any higher priority
+ * task waiting on it.  The lock is not recursive.
+ */
+struct os_rwlock
+{
+    SLIST_HEAD(, os_task) rwl_head; /* chain of waiting tasks */
+    uint8_t     _pad;
+    uint8_t     rwl_prio;           /* writer's default priority */
+    uint16_t    rwl_readers;        /* # of tasks holding a read lock */
+    struct os_task *rwl_writer;     /* task holding the write lock */
+};
+
+/* Initialize a reader/writer lock */
+os_error_t os_rwlock_init(struct os_rwlock *rwl);
+
+/* Pend (wait) for a read lock */
+os_error_t os_rwlock_read_pend(struct os_rwlock *rwl, uint32_t timeout);
+
+/* Release a read lock */
+os_error_t os_rwlock_read_release(struct os_rwlock *rwl);
+
+/* Pend (wait) for the write lock */
+os_error_t os_rwlock_write_pend(struct os_rwlock *rwl, uint32_t timeout);
+
+/* Release the write lock */
+os_error_t os_rwlock_write_release(struct os_rwlock *rwl);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* _OS_RWLOCK_H_ */
@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 
+#include "syscfg/syscfg.h"
 #include "os/os_time.h"
 #include "os/queue.h"
 
@@ -37,6 +38,13 @@ struct os_sanity_check {
     os_time_t sc_checkin_itvl;
     os_sanity_check_func_t sc_func;
     void *sc_arg;
+#if MYNEWT_VAL(SANITY_STATS)
+    /* Cost of sc_func, in os_cputime ticks */
+    uint32_t sc_num_runs;
+    uint32_t sc_last_ticks;
+    uint32_t sc_max_ticks;
+    uint32_t sc_total_ticks;
+#endif
 
     SLIST_ENTRY(os_sanity_check) sc_next;
 
@@ -49,6 +57,7 @@ struct os_sanity_check {
 
 int os_sanity_init(void);
 void os_sanity_run(void);
+os_time_t os_sanity_itvl_get(void);
 
 struct os_task;
 int os_sanity_task_checkin(struct os_task *);
@@ -39,6 +39,13 @@ int os_sched_suspend(struct os_task *);
 void os_sched_resort(struct os_task *);
 os_time_t os_sched_wakeup_ticks(os_time_t now);
 
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+void os_prof_isr_enter(void);
+void os_prof_isr_exit(void);
+uint32_t os_prof_isr_time(void);
+uint8_t os_prof_cpu_pct(const struct os_task *t);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -20,6 +20,7 @@
 #ifndef _OS_TASK_H
 #define _OS_TASK_H
 
+#include "syscfg/syscfg.h"
 #include "os/os.h"
 #include "os/os_sanity.h" 
 #include "os/queue.h"
@@ -56,6 +57,9 @@ typedef enum os_task_state {
 #define OS_TASK_FLAG_MUTEX_WAIT     (0x04U)
 #define OS_TASK_FLAG_EVQ_WAIT       (0x08U)
 #define OS_TASK_FLAG_LOCK_HELD      (0x10U)
+#define OS_TASK_FLAG_RWLOCK_WAIT    (0x20U)
+#define OS_TASK_FLAG_RWLOCK_WRITE   (0x40U)
+#define OS_TASK_FLAG_STACK_ALERT    (0x80U)
 
 typedef void (*os_task_func_t)(void *);
 
@@ -72,7 +76,8 @@ struct os_task {
     uint8_t t_state;
     uint8_t t_flags;
     uint8_t t_lockcnt;
-    uint8_t t_pad;
+    /* Priority the task was queued at on the run list */
+    uint8_t t_run_prio;
 
     const char *t_name;
     os_task_func_t t_func;
@@ -86,6 +91,23 @@ struct os_task {
     os_time_t t_run_time;
     uint32_t t_ctx_sw_cnt;
 
+#if MYNEWT_VAL(OS_STACK_SCAN)
+    /* Most stack words ever found in use */
+    uint16_t t_stack_hwm;
+    /* Next word, counted from the bottom, the stack scan will look at */
+    uint16_t t_stack_scan;
+#endif
+
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+    /* Times are in os_cputime ticks */
+    uint32_t t_prof_run;            /* total run time */
+    uint32_t t_prof_max_run;        /* longest continuous run */
+    uint32_t t_prof_win_base;       /* t_prof_run when the window started */
+    uint32_t t_prof_win_run;        /* run time during the last window */
+    uint32_t t_prof_preempts;       /* switched out while still ready */
+    uint32_t t_prof_yields;         /* switched out after blocking */
+#endif
+
     /* Global list of all tasks, irrespective of run or sleep lists */
     STAILQ_ENTRY(os_task) t_os_task_list;
 
@@ -103,6 +125,13 @@ int os_task_suspend(struct os_task *t);
 
 uint8_t os_task_count(void);
 
+#if MYNEWT_VAL(OS_STACK_SCAN)
+typedef void os_task_stack_alert_fn(struct os_task *t, uint16_t headroom);
+
+void os_task_stack_scan(int words);
+void os_task_stack_alert_set(os_task_stack_alert_fn *cb);
+#endif
+
 struct os_task_info {
     uint8_t oti_prio;
     uint8_t oti_taskid;
@@ -114,6 +143,14 @@ struct os_task_info {
     uint32_t oti_runtime;
     os_time_t oti_last_checkin;
     os_time_t oti_next_checkin;
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+    uint32_t oti_prof_run;
+    uint32_t oti_prof_max_run;
+    uint32_t oti_prof_preempts;
+    uint32_t oti_prof_yields;
+    /* Share of the CPU during the last profiling window, in percent */
+    uint8_t oti_cpu_pct;
+#endif
 
     char oti_name[OS_TASK_MAX_NAME_LEN];
 };
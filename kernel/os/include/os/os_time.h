@@ -71,6 +71,7 @@ typedef uint32_t os_time_t;
 
 os_time_t os_time_get(void);
 void os_time_advance(int ticks);
+uint32_t os_time_suppressed_ticks(void);
 void os_time_delay(int32_t osticks);
 
 #define OS_TIME_TICK_LT(__t1, __t2) ((int32_t) ((__t1) - (__t2)) < 0)
@@ -110,6 +111,9 @@ struct os_timezone {
 int os_settimeofday(struct os_timeval *utctime, struct os_timezone *tz);
 int os_gettimeofday(struct os_timeval *utctime, struct os_timezone *tz);
 int64_t os_get_uptime_usec(void);
+uint64_t os_time_get64(void);
+int64_t os_time_ticks64_to_usec(uint64_t ticks);
+int os_time_ticks64_to_utc(uint64_t ticks, int64_t *out_usec);
 int os_time_ms_to_ticks(uint32_t ms, uint32_t *out_ticks);
 
 #ifdef __cplusplus
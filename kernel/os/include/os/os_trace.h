@@ -0,0 +1,86 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _OS_TRACE_H
+#define _OS_TRACE_H
+
+#include <inttypes.h>
+#include "syscfg/syscfg.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Trace record IDs.  0x00-0x3f are reserved for the kernel; 0x40-0x7f are
+ * assigned to other packages here, so that host tools can decode every
+ * record without per-application tables; 0x80-0xff are free for
+ * applications.
+ */
+#define OS_TRACE_ID_INFO            0x00    /* p16: version, p32: cputime Hz */
+#define OS_TRACE_ID_OVERFLOW        0x01    /* p32: records dropped */
+#define OS_TRACE_ID_TASK_SWITCH     0x02    /* p16: next taskid, p32: task */
+#define OS_TRACE_ID_ISR_ENTER       0x03    /* p16: irq number */
+#define OS_TRACE_ID_ISR_EXIT        0x04    /* p16: irq number */
+#define OS_TRACE_ID_EVQ_PUT         0x05    /* p32: event */
+#define OS_TRACE_ID_EVQ_GET         0x06    /* p32: event */
+#define OS_TRACE_ID_MEMPOOL_EMPTY   0x07    /* p16: block size, p32: pool */
+#define OS_TRACE_ID_CALLOUT_FIRE    0x08    /* p32: callout */
+#define OS_TRACE_ID_BLE_LL_SCHED    0x40    /* p16: sched type, p32: start */
+
+#define OS_TRACE_VERSION            1
+
+/**
+ * A trace record; 12 bytes, little endian when streamed.  otr_task is the
+ * ID of the task that was running, or 0xff in interrupt context.
+ */
+struct os_trace_rec {
+    uint32_t otr_ts;            /* os_cputime. */
+    uint8_t otr_id;
+    uint8_t otr_task;
+    uint16_t otr_p16;
+    uint32_t otr_p32;
+};
+
+#if MYNEWT_VAL(OS_TRACE)
+
+void os_trace_rec(uint8_t id, uint16_t p16, uint32_t p32);
+int os_trace_read(struct os_trace_rec *out_recs, int max_recs);
+void os_trace_enable(int on);
+void os_trace_isr_enter(uint16_t irq);
+void os_trace_isr_exit(uint16_t irq);
+
+#define OS_TRACE(id, p16, p32)      \
+    os_trace_rec((id), (p16), (uint32_t)(uintptr_t)(p32))
+#define OS_TRACE_ISR_ENTER(irq)     os_trace_isr_enter(irq)
+#define OS_TRACE_ISR_EXIT(irq)      os_trace_isr_exit(irq)
+
+#else
+
+#define OS_TRACE(id, p16, p32)
+#define OS_TRACE_ISR_ENTER(irq)
+#define OS_TRACE_ISR_EXIT(irq)
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _OS_TRACE_H */
@@ -0,0 +1,62 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef _OS_WORK_H_
+#define _OS_WORK_H_
+
+#include "syscfg/syscfg.h"
+#include "os/os_eventq.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A deferred interrupt work item.  An ISR posts it with os_work_post(), and
+ * the work task, which runs at OS_WORK_TASK_PRIO, calls its function.  Work
+ * items are never allocated; posting an item that is already pending does
+ * not queue it twice, so its function runs once for any number of posts.
+ */
+struct os_work {
+    struct os_event w_ev;
+    uint32_t w_posts;           /* # of times posted */
+    uint32_t w_coalesced;       /* # of posts made while already pending */
+#if MYNEWT_VAL(OS_WORK_STATS)
+    /* Execution times are in os_cputime ticks */
+    uint32_t w_runs;
+    uint32_t w_last_ticks;
+    uint32_t w_max_ticks;
+    uint32_t w_total_ticks;
+#endif
+};
+
+/* Initialize a work item; 'fn' is called with the item's os_event */
+void os_work_init(struct os_work *w, os_event_fn *fn, void *arg);
+
+/* Queue a work item to run on the work task; can be called from an ISR */
+void os_work_post(struct os_work *w);
+
+/* Remove a work item that has been posted but has not run yet */
+void os_work_cancel(struct os_work *w);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* _OS_WORK_H_ */
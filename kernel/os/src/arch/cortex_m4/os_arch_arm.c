@@ -17,6 +17,7 @@
  * under the License.
  */
 
+#include "syscfg/syscfg.h"
 #include "os/os.h"
 #include "os/os_arch.h"
 #include <hal/hal_bsp.h>
@@ -100,22 +101,67 @@ struct stack_frame {
 /* XXX: determine how we will deal with running un-privileged */
 uint32_t os_flags = OS_RUN_PRIV;
 
-void
+OS_RAMFUNC void
 timer_handler(void)
 {
     os_time_advance(1);
 }
 
-void
+#if MYNEWT_VAL(OS_STACK_GUARD)
+#if !defined(__MPU_PRESENT) || !__MPU_PRESENT
+#error "OS_STACK_GUARD requires the Cortex-M MPU"
+#endif
+
+/* Highest numbered region, so it takes precedence over any others. */
+#define OS_STACK_GUARD_REGION   (7)
+#define OS_STACK_GUARD_SIZE     (32)
+
+/*
+ * Points the guard region at the lowest 32 byte aligned block of the task's
+ * stack.  The region has no access permissions, so touching it from the task
+ * (or stacking an exception frame into it) raises a MemManage fault.
+ */
+static void
+os_arch_stack_guard_set(struct os_task *t)
+{
+    uint32_t base;
+
+    base = (uint32_t)(t->t_stacktop - t->t_stacksize);
+    base = (base + OS_STACK_GUARD_SIZE - 1) & ~(OS_STACK_GUARD_SIZE - 1);
+
+    MPU->RNR = OS_STACK_GUARD_REGION;
+    MPU->RBAR = base;
+    /* SIZE encodes 2^(SIZE + 1) bytes; AP = 0 is no access */
+    MPU->RASR = MPU_RASR_XN_Msk | (4 << MPU_RASR_SIZE_Pos) |
+                MPU_RASR_ENABLE_Msk;
+    __DSB();
+    __ISB();
+}
+
+static void
+os_arch_stack_guard_init(void)
+{
+    SCB->SHCSR |= SCB_SHCSR_MEMFAULTENA_Msk;
+    /* Keep the default memory map for everything not covered by a region */
+    MPU->CTRL = MPU_CTRL_PRIVDEFENA_Msk | MPU_CTRL_ENABLE_Msk;
+    __DSB();
+    __ISB();
+}
+#endif
+
+OS_RAMFUNC void
 os_arch_ctx_sw(struct os_task *t)
 {
+#if MYNEWT_VAL(OS_STACK_GUARD)
+    os_arch_stack_guard_set(t);
+#endif
     os_sched_ctx_sw_hook(t);
 
     /* Set PendSV interrupt pending bit to force context switch */
     SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
 }
 
-os_sr_t
+OS_RAMFUNC os_sr_t
 os_arch_save_sr(void)
 {
     uint32_t isr_ctx;
@@ -125,7 +171,7 @@ os_arch_save_sr(void)
     return (isr_ctx & 1);
 }
 
-void
+OS_RAMFUNC void
 os_arch_restore_sr(os_sr_t isr_ctx)
 {
     if (!isr_ctx) {
@@ -176,6 +222,9 @@ os_arch_init(void)
      * Trap on divide-by-zero.
      */
     SCB->CCR |= SCB_CCR_DIV_0_TRP_Msk;
+#if MYNEWT_VAL(OS_STACK_GUARD)
+    os_arch_stack_guard_init();
+#endif
     os_init_idle_task();
 }
 
@@ -229,6 +229,15 @@ os_tick_idle(os_time_t ticks)
 
     OS_ASSERT_CRITICAL();
 
+    if (MYNEWT_VAL(OS_SIM_VIRTUAL_TIME)) {
+        /*
+         * Nothing can happen before the next deadline, so jump to it.  With
+         * nothing due, this is the tick the periodic timer would deliver.
+         */
+        os_time_advance(ticks > 0 ? ticks : 1);
+        return;
+    }
+
     if (ticks > 0) {
         /*
          * Enter tickless regime and set the timer to fire after 'ticks'
@@ -375,6 +384,11 @@ start_timer(void)
     struct itimerval it;
     int rc;
 
+    /* In virtual time, time only advances while the idle task runs. */
+    if (MYNEWT_VAL(OS_SIM_VIRTUAL_TIME)) {
+        return;
+    }
+
     memset(&it, 0, sizeof(it));
     it.it_value.tv_sec = 0;
     it.it_value.tv_usec = OS_USEC_PER_TICK;
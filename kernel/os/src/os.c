@@ -39,7 +39,7 @@
  */
 
 struct os_task g_idle_task;
-os_stack_t g_idle_task_stack[OS_STACK_ALIGN(OS_IDLE_STACK_SIZE)];
+OS_CCM_BSS os_stack_t g_idle_task_stack[OS_STACK_ALIGN(OS_IDLE_STACK_SIZE)];
 
 uint32_t g_os_idle_ctr;
 /* Default zero.  Set by the architecture specific code when os is started.
@@ -70,8 +70,14 @@ os_idle_task(void *arg)
     os_time_t iticks, sticks, cticks;
     os_time_t sanity_last;
     os_time_t sanity_itvl_ticks;
+#if MYNEWT_VAL(SANITY_IDLE_PIGGYBACK)
+    os_time_t sanity_wdog_ticks;
+
+    /* Latest the sanity checks can run and still tickle the watchdog. */
+    sanity_wdog_ticks =
+        ((MYNEWT_VAL(WATCHDOG_INTERVAL) - 200) * OS_TICKS_PER_SEC) / 1000;
+#endif
 
-    sanity_itvl_ticks = (MYNEWT_VAL(SANITY_INTERVAL) * OS_TICKS_PER_SEC) / 1000;
     sanity_last = 0;
 
     hal_watchdog_tickle();
@@ -80,6 +86,7 @@ os_idle_task(void *arg)
         ++g_os_idle_ctr;
 
         now = os_time_get();
+        sanity_itvl_ticks = os_sanity_itvl_get();
         if (OS_TIME_TICK_GT(now, sanity_last + sanity_itvl_ticks)) {
             os_sanity_run();
             /* Tickle the watchdog after successfully running sanity */
@@ -87,15 +94,24 @@ os_idle_task(void *arg)
             sanity_last = now;
         }
 
+#if MYNEWT_VAL(OS_STACK_SCAN)
+        os_task_stack_scan(MYNEWT_VAL(OS_STACK_SCAN_WORDS));
+#endif
+
         OS_ENTER_CRITICAL(sr);
         now = os_time_get();
         sticks = os_sched_wakeup_ticks(now);
         cticks = os_callout_wakeup_ticks(now);
         iticks = min(sticks, cticks);
+#if MYNEWT_VAL(SANITY_IDLE_PIGGYBACK)
+        /* Only wake up for sanity when the watchdog needs tickling. */
+        iticks = min(iticks, ((sanity_last + sanity_wdog_ticks) - now));
+#else
         /* Wakeup in time to run sanity as well from the idle context,
          * as the idle task does not schedule itself.
          */
         iticks = min(iticks, ((sanity_last + sanity_itvl_ticks) - now));
+#endif
 
         if (iticks < MIN_IDLE_TICKS) {
             iticks = 0;
@@ -107,7 +123,11 @@ os_idle_task(void *arg)
         /* Tell the architecture specific support to put the processor to sleep
          * for 'n' ticks.
          */
+#if MYNEWT_VAL(OS_PM)
+        os_pm_idle(iticks);
+#else
         os_tick_idle(iticks);
+#endif
         OS_EXIT_CRITICAL(sr);
     }
 }
@@ -139,6 +159,10 @@ os_init_idle_task(void)
     assert(rc == 0);
 
     assert(MYNEWT_VAL(WATCHDOG_INTERVAL) - 200 > MYNEWT_VAL(SANITY_INTERVAL));
+#if MYNEWT_VAL(SANITY_ADAPTIVE)
+    assert(MYNEWT_VAL(WATCHDOG_INTERVAL) - 200 >=
+           MYNEWT_VAL(SANITY_MAX_INTERVAL));
+#endif
 
     rc = hal_watchdog_init(MYNEWT_VAL(WATCHDOG_INTERVAL));
     assert(rc == 0);
@@ -153,7 +177,8 @@ os_init(void)
 {
     os_error_t err;
 
-    TAILQ_INIT(&g_callout_list);
+    os_callout_list_init();
+    os_sched_run_list_init();
     STAILQ_INIT(&g_os_task_list);
 
     /* Initialize device list. */
@@ -162,6 +187,10 @@ os_init(void)
     err = os_arch_os_init();
     assert(err == OS_OK);
 
+#if MYNEWT_VAL(OS_WORK)
+    os_work_task_init();
+#endif
+
     /* Call bsp related OS initializations */
     hal_bsp_init();
 
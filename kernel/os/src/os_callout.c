@@ -29,8 +29,142 @@
  *   @defgroup OSCallouts Event Timers (Callouts)
  *   @{
  */
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+
+#define OS_CALLOUT_WHEEL_MASK   (MYNEWT_VAL(OS_CALLOUT_WHEEL_SIZE) - 1)
+
+CTASSERT((MYNEWT_VAL(OS_CALLOUT_WHEEL_SIZE) & OS_CALLOUT_WHEEL_MASK) == 0);
+
+struct os_callout_wheel g_callout_wheel;
+
+static struct os_callout_list *
+os_callout_slot(os_time_t ticks)
+{
+    return &g_callout_wheel.cw_slots[ticks & OS_CALLOUT_WHEEL_MASK];
+}
+
+/*
+ * Removes and returns an armed callout that has expired by 'now', or NULL if
+ * there is none.  The wheel is swept from cw_next up to 'now'; every slot is
+ * swept at most once per call, so a large jump in time costs at most one
+ * revolution.
+ */
+static struct os_callout *
+os_callout_wheel_expired(os_time_t now)
+{
+    struct os_callout_wheel *cw;
+    struct os_callout *c;
+
+    OS_ASSERT_CRITICAL();
+
+    cw = &g_callout_wheel;
+    if (cw->cw_count == 0) {
+        return NULL;
+    }
+
+    if (OS_TIME_TICK_LT(cw->cw_next, now - OS_CALLOUT_WHEEL_MASK)) {
+        cw->cw_next = now - OS_CALLOUT_WHEEL_MASK;
+    }
+
+    while (OS_TIME_TICK_GEQ(now, cw->cw_next)) {
+        TAILQ_FOREACH(c, os_callout_slot(cw->cw_next), c_next) {
+            if (OS_TIME_TICK_GEQ(now, c->c_ticks)) {
+                TAILQ_REMOVE(os_callout_slot(c->c_ticks), c, c_next);
+                c->c_next.tqe_prev = NULL;
+                cw->cw_count--;
+                return c;
+            }
+        }
+        cw->cw_next++;
+    }
+
+    return NULL;
+}
+
+/*
+ * Moves cw_next forward to the expiry time of the earliest armed callout, so
+ * that os_callout_wakeup_ticks() does not wake the idle task early.  Each slot
+ * is examined in its own critical section; the scan gives up if a concurrent
+ * os_callout_reset() moves cw_next back, as that callout is the new earliest.
+ */
+static void
+os_callout_wheel_advance(void)
+{
+    struct os_callout_wheel *cw;
+    struct os_callout *first;
+    struct os_callout *c;
+    os_time_t next;
+    os_sr_t sr;
+    int i;
+
+    cw = &g_callout_wheel;
+
+    OS_ENTER_CRITICAL(sr);
+    next = cw->cw_next;
+    OS_EXIT_CRITICAL(sr);
+
+    for (i = 0; i <= OS_CALLOUT_WHEEL_MASK; i++) {
+        OS_ENTER_CRITICAL(sr);
+        if (cw->cw_count == 0 || cw->cw_next != next) {
+            OS_EXIT_CRITICAL(sr);
+            return;
+        }
+        TAILQ_FOREACH(c, os_callout_slot(next), c_next) {
+            if (c->c_ticks == next) {
+                OS_EXIT_CRITICAL(sr);
+                return;
+            }
+        }
+        cw->cw_next = ++next;
+        OS_EXIT_CRITICAL(sr);
+    }
+
+    /*
+     * Nothing expires within the next revolution.  Find the earliest callout
+     * the slow way; this only happens when all timers are far in the future.
+     */
+    OS_ENTER_CRITICAL(sr);
+    if (cw->cw_count != 0 && cw->cw_next == next) {
+        first = NULL;
+        for (i = 0; i <= OS_CALLOUT_WHEEL_MASK; i++) {
+            TAILQ_FOREACH(c, &cw->cw_slots[i], c_next) {
+                if (first == NULL ||
+                    OS_TIME_TICK_LT(c->c_ticks, first->c_ticks)) {
+
+                    first = c;
+                }
+            }
+        }
+        cw->cw_next = first->c_ticks;
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+#else
+
 struct os_callout_list g_callout_list;
 
+#endif
+
+/*
+ * Initializes the list of armed callouts.  Called once, from os_init().
+ */
+void
+os_callout_list_init(void)
+{
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    int i;
+
+    for (i = 0; i <= OS_CALLOUT_WHEEL_MASK; i++) {
+        TAILQ_INIT(&g_callout_wheel.cw_slots[i]);
+    }
+    g_callout_wheel.cw_next = os_time_get();
+    g_callout_wheel.cw_count = 0;
+#else
+    TAILQ_INIT(&g_callout_list);
+#endif
+}
+
 /**
  * Initialize a callout.
  *
@@ -70,7 +204,12 @@ os_callout_stop(struct os_callout *c)
     OS_ENTER_CRITICAL(sr);
 
     if (os_callout_queued(c)) {
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+        TAILQ_REMOVE(os_callout_slot(c->c_ticks), c, c_next);
+        g_callout_wheel.cw_count--;
+#else
         TAILQ_REMOVE(&g_callout_list, c, c_next);
+#endif
         c->c_next.tqe_prev = NULL;
     }
 
@@ -92,7 +231,9 @@ os_callout_stop(struct os_callout *c)
 int
 os_callout_reset(struct os_callout *c, int32_t ticks)
 {
+#if !MYNEWT_VAL(OS_CALLOUT_WHEEL)
     struct os_callout *entry;
+#endif
     os_sr_t sr;
     int rc;
 
@@ -111,6 +252,15 @@ os_callout_reset(struct os_callout *c, int32_t ticks)
 
     c->c_ticks = os_time_get() + ticks;
 
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    TAILQ_INSERT_TAIL(os_callout_slot(c->c_ticks), c, c_next);
+    if (g_callout_wheel.cw_count == 0 ||
+        OS_TIME_TICK_LT(c->c_ticks, g_callout_wheel.cw_next)) {
+
+        g_callout_wheel.cw_next = c->c_ticks;
+    }
+    g_callout_wheel.cw_count++;
+#else
     entry = NULL;
     TAILQ_FOREACH(entry, &g_callout_list, c_next) {
         if (OS_TIME_TICK_LT(c->c_ticks, entry->c_ticks)) {
@@ -123,6 +273,7 @@ os_callout_reset(struct os_callout *c, int32_t ticks)
     } else {
         TAILQ_INSERT_TAIL(&g_callout_list, c, c_next);
     }
+#endif
 
     OS_EXIT_CRITICAL(sr);
 
@@ -148,6 +299,9 @@ os_callout_tick(void)
 
     while (1) {
         OS_ENTER_CRITICAL(sr);
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+        c = os_callout_wheel_expired(now);
+#else
         c = TAILQ_FIRST(&g_callout_list);
         if (c) {
             if (OS_TIME_TICK_GEQ(now, c->c_ticks)) {
@@ -157,14 +311,20 @@ os_callout_tick(void)
                 c = NULL;
             }
         }
+#endif
         OS_EXIT_CRITICAL(sr);
 
         if (c) {
+            OS_TRACE(OS_TRACE_ID_CALLOUT_FIRE, 0, c);
             os_eventq_put(c->c_evq, &c->c_ev);
         } else {
             break;
         }
     }
+
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    os_callout_wheel_advance();
+#endif
 }
 
 /*
@@ -179,10 +339,26 @@ os_time_t
 os_callout_wakeup_ticks(os_time_t now)
 {
     os_time_t rt;
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    os_time_t next;
+#else
     struct os_callout *c;
+#endif
 
     OS_ASSERT_CRITICAL();
 
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+    if (g_callout_wheel.cw_count != 0) {
+        next = g_callout_wheel.cw_next;
+        if (OS_TIME_TICK_GEQ(next, now)) {
+            rt = next - now;
+        } else {
+            rt = 0;
+        }
+    } else {
+        rt = OS_TIMEOUT_NEVER;
+    }
+#else
     c = TAILQ_FIRST(&g_callout_list);
     if (c != NULL) {
         if (OS_TIME_TICK_GEQ(c->c_ticks, now)) {
@@ -193,6 +369,7 @@ os_callout_wakeup_ticks(os_time_t now)
     } else {
         rt = OS_TIMEOUT_NEVER;
     }
+#endif
 
     return (rt);
 }
@@ -32,6 +32,27 @@
 
 struct os_cputime_data g_os_cputime;
 
+#if MYNEWT_VAL(OS_CPUTIME_BATCH)
+/*
+ * Running batched timers, as a binary min-heap on expiry.
+ */
+static struct os_cputime_btimer *
+os_cputime_bheap[MYNEWT_VAL(OS_CPUTIME_BATCH_MAX)];
+static int os_cputime_bheap_cnt;
+
+static struct hal_timer os_cputime_bhw;
+static uint32_t os_cputime_bhw_expiry;  /* expiry the compare is for */
+static uint32_t os_cputime_bhw_cmp;     /* where compare was programmed */
+static uint8_t os_cputime_bhw_armed;
+static uint32_t os_cputime_bhw_reprograms;
+#if MYNEWT_VAL(OS_CPUTIME_BATCH_LATENCY_MAX_USECS)
+/* Compare to ISR latency, in 1/8 cputime ticks */
+static uint32_t os_cputime_bhw_latency;
+#endif
+
+static void os_cputime_btimer_fire(void *arg);
+#endif
+
 /**
  * os cputime init
  *
@@ -51,6 +72,11 @@ os_cputime_init(uint32_t clock_freq)
     /* Set the ticks per microsecond. */
     g_os_cputime.ticks_per_usec = clock_freq / 1000000U;
     rc = hal_timer_config(MYNEWT_VAL(OS_CPUTIME_TIMER_NUM), clock_freq);
+#if MYNEWT_VAL(OS_CPUTIME_BATCH)
+    if (rc == 0) {
+        os_cputime_timer_init(&os_cputime_bhw, os_cputime_btimer_fire, NULL);
+    }
+#endif
     return rc;
 }
 
@@ -257,6 +283,318 @@ os_cputime_timer_stop(struct hal_timer *timer)
     hal_timer_stop(timer);
 }
 
+#if MYNEWT_VAL(OS_CPUTIME_BATCH)
+static void
+os_cputime_bheap_set(int idx, struct os_cputime_btimer *bt)
+{
+    os_cputime_bheap[idx] = bt;
+    bt->bt_idx = idx;
+}
+
+static void
+os_cputime_bheap_up(int idx)
+{
+    struct os_cputime_btimer *bt;
+    int parent;
+
+    bt = os_cputime_bheap[idx];
+    while (idx > 0) {
+        parent = (idx - 1) / 2;
+        if (CPUTIME_LEQ(os_cputime_bheap[parent]->bt_expiry, bt->bt_expiry)) {
+            break;
+        }
+        os_cputime_bheap_set(idx, os_cputime_bheap[parent]);
+        idx = parent;
+    }
+    os_cputime_bheap_set(idx, bt);
+}
+
+static void
+os_cputime_bheap_down(int idx)
+{
+    struct os_cputime_btimer *bt;
+    int child;
+
+    bt = os_cputime_bheap[idx];
+    while (1) {
+        child = 2 * idx + 1;
+        if (child >= os_cputime_bheap_cnt) {
+            break;
+        }
+        if (child + 1 < os_cputime_bheap_cnt &&
+            CPUTIME_LT(os_cputime_bheap[child + 1]->bt_expiry,
+                       os_cputime_bheap[child]->bt_expiry)) {
+            child++;
+        }
+        if (CPUTIME_LEQ(bt->bt_expiry, os_cputime_bheap[child]->bt_expiry)) {
+            break;
+        }
+        os_cputime_bheap_set(idx, os_cputime_bheap[child]);
+        idx = child;
+    }
+    os_cputime_bheap_set(idx, bt);
+}
+
+/*
+ * Latest expiry, not past 'limit', in the subheap at idx.  Subheaps whose
+ * root is past the limit are skipped, so this only visits the timers
+ * within the window and their children.
+ */
+static uint32_t
+os_cputime_bheap_latest(int idx, uint32_t limit, uint32_t latest)
+{
+    struct os_cputime_btimer *bt;
+
+    if (idx >= os_cputime_bheap_cnt) {
+        return latest;
+    }
+    bt = os_cputime_bheap[idx];
+    if (CPUTIME_GT(bt->bt_expiry, limit)) {
+        return latest;
+    }
+    if (CPUTIME_GT(bt->bt_expiry, latest)) {
+        latest = bt->bt_expiry;
+    }
+    latest = os_cputime_bheap_latest(2 * idx + 1, limit, latest);
+    return os_cputime_bheap_latest(2 * idx + 2, limit, latest);
+}
+
+#if MYNEWT_VAL(OS_CPUTIME_BATCH_LATENCY_MAX_USECS)
+static uint32_t
+os_cputime_btimer_comp(void)
+{
+    uint32_t comp;
+    uint32_t max;
+
+    comp = os_cputime_bhw_latency / 8;
+    max = os_cputime_usecs_to_ticks(
+        MYNEWT_VAL(OS_CPUTIME_BATCH_LATENCY_MAX_USECS));
+    if (comp > max) {
+        comp = max;
+    }
+    return comp;
+}
+#endif
+
+/*
+ * Programs the hardware compare for the head of the batched timer heap.
+ * The compare is placed at the latest expiry within the slack window after
+ * the head, so that those timers are all serviced by one interrupt.  Left
+ * alone if that is where it already is.  Called with interrupts disabled.
+ */
+static void
+os_cputime_btimer_arm(void)
+{
+    struct os_cputime_btimer *head;
+    uint32_t expiry;
+    uint32_t slack;
+
+    if (os_cputime_bheap_cnt == 0) {
+        if (os_cputime_bhw_armed) {
+            hal_timer_stop(&os_cputime_bhw);
+            os_cputime_bhw_armed = 0;
+        }
+        return;
+    }
+
+    head = os_cputime_bheap[0];
+    expiry = head->bt_expiry;
+    slack = os_cputime_usecs_to_ticks(
+        MYNEWT_VAL(OS_CPUTIME_BATCH_SLACK_USECS));
+    if (slack != 0) {
+        expiry = os_cputime_bheap_latest(0, head->bt_expiry + slack, expiry);
+    }
+
+    if (os_cputime_bhw_armed) {
+        if (expiry == os_cputime_bhw_expiry) {
+            return;
+        }
+        hal_timer_stop(&os_cputime_bhw);
+    }
+    os_cputime_bhw_expiry = expiry;
+#if MYNEWT_VAL(OS_CPUTIME_BATCH_LATENCY_MAX_USECS)
+    os_cputime_bhw_cmp = expiry - os_cputime_btimer_comp();
+#else
+    os_cputime_bhw_cmp = expiry;
+#endif
+    hal_timer_start_at(&os_cputime_bhw, os_cputime_bhw_cmp);
+    os_cputime_bhw_armed = 1;
+    os_cputime_bhw_reprograms++;
+}
+
+/*
+ * Removes a timer from the heap.  Called with interrupts disabled.
+ */
+static void
+os_cputime_btimer_unlink(struct os_cputime_btimer *bt)
+{
+    struct os_cputime_btimer *last;
+    int idx;
+
+    if (!bt->bt_queued) {
+        return;
+    }
+    bt->bt_queued = 0;
+
+    idx = bt->bt_idx;
+    last = os_cputime_bheap[--os_cputime_bheap_cnt];
+    if (last == bt) {
+        return;
+    }
+    os_cputime_bheap_set(idx, last);
+    if (idx > 0 && CPUTIME_LT(last->bt_expiry,
+                              os_cputime_bheap[(idx - 1) / 2]->bt_expiry)) {
+        os_cputime_bheap_up(idx);
+    } else {
+        os_cputime_bheap_down(idx);
+    }
+}
+
+/*
+ * Hardware timer callback: runs every batched timer that has expired, then
+ * rearms for whatever is left.
+ */
+static void
+os_cputime_btimer_fire(void *arg)
+{
+    struct os_cputime_btimer *bt;
+    uint32_t now;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    now = os_cputime_get32();
+#if MYNEWT_VAL(OS_CPUTIME_BATCH_LATENCY_MAX_USECS)
+    /*
+     * Track compare to handler delay, and wait out the part of it the
+     * compare was moved early by.
+     */
+    if (os_cputime_bhw_armed && CPUTIME_GEQ(now, os_cputime_bhw_cmp)) {
+        os_cputime_bhw_latency += now - os_cputime_bhw_cmp -
+            os_cputime_bhw_latency / 8;
+    }
+    if (os_cputime_bhw_armed) {
+        while (CPUTIME_LT(now, os_cputime_bhw_expiry)) {
+            now = os_cputime_get32();
+        }
+    }
+#endif
+    os_cputime_bhw_armed = 0;
+    while (os_cputime_bheap_cnt) {
+        bt = os_cputime_bheap[0];
+        now = os_cputime_get32();
+        if (CPUTIME_GT(bt->bt_expiry, now)) {
+            break;
+        }
+        os_cputime_btimer_unlink(bt);
+
+        bt->bt_fired++;
+        bt->bt_last_late = now - bt->bt_expiry;
+        if (bt->bt_last_late > bt->bt_max_late) {
+            bt->bt_max_late = bt->bt_last_late;
+        }
+
+        OS_EXIT_CRITICAL(sr);
+        bt->bt_cb(bt->bt_arg);
+        OS_ENTER_CRITICAL(sr);
+    }
+    os_cputime_btimer_arm();
+    OS_EXIT_CRITICAL(sr);
+}
+
+void
+os_cputime_btimer_init(struct os_cputime_btimer *bt, hal_timer_cb fp,
+                       void *arg)
+{
+    assert(bt != NULL);
+    assert(fp != NULL);
+
+    memset(bt, 0, sizeof(*bt));
+    bt->bt_cb = fp;
+    bt->bt_arg = arg;
+}
+
+int
+os_cputime_btimer_start(struct os_cputime_btimer *bt, uint32_t cputime)
+{
+    uint32_t slack;
+    os_sr_t sr;
+
+    assert(bt != NULL);
+
+    OS_ENTER_CRITICAL(sr);
+
+    /* Restarting a running timer reuses its slot in the heap. */
+    if (!bt->bt_queued &&
+        os_cputime_bheap_cnt >= MYNEWT_VAL(OS_CPUTIME_BATCH_MAX)) {
+        OS_EXIT_CRITICAL(sr);
+        return OS_ENOMEM;
+    }
+
+    os_cputime_btimer_unlink(bt);
+    bt->bt_expiry = cputime;
+
+    os_cputime_bheap_set(os_cputime_bheap_cnt++, bt);
+    os_cputime_bheap_up(bt->bt_idx);
+    bt->bt_queued = 1;
+
+    /*
+     * A timer that the armed compare already services within the slack
+     * does not need the hardware touched.
+     */
+    slack = os_cputime_usecs_to_ticks(
+        MYNEWT_VAL(OS_CPUTIME_BATCH_SLACK_USECS));
+    if (!os_cputime_bhw_armed ||
+        CPUTIME_GT(cputime, os_cputime_bhw_expiry) ||
+        os_cputime_bhw_expiry - cputime > slack) {
+        os_cputime_btimer_arm();
+    }
+
+    OS_EXIT_CRITICAL(sr);
+
+    return 0;
+}
+
+int
+os_cputime_btimer_relative(struct os_cputime_btimer *bt, uint32_t usecs)
+{
+    uint32_t cputime;
+
+    cputime = os_cputime_get32() + os_cputime_usecs_to_ticks(usecs);
+    return os_cputime_btimer_start(bt, cputime);
+}
+
+void
+os_cputime_btimer_stop(struct os_cputime_btimer *bt)
+{
+    os_sr_t sr;
+
+    assert(bt != NULL);
+
+    OS_ENTER_CRITICAL(sr);
+    if (bt->bt_queued) {
+        os_cputime_btimer_unlink(bt);
+        os_cputime_btimer_arm();
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+uint32_t
+os_cputime_btimer_reprograms(void)
+{
+    return (os_cputime_bhw_reprograms);
+}
+
+uint32_t
+os_cputime_btimer_latency(void)
+{
+#if MYNEWT_VAL(OS_CPUTIME_BATCH_LATENCY_MAX_USECS)
+    return (os_cputime_bhw_latency / 8);
+#else
+    return (0);
+#endif
+}
+#endif
+
 /**
  * os cputime get32
  *
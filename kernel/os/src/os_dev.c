@@ -45,6 +45,10 @@ os_dev_init(struct os_dev *dev, char *name, uint8_t stage,
     dev->od_init = od_init;
     dev->od_init_arg = arg;
     memset(&dev->od_handlers, 0, sizeof(dev->od_handlers));
+#if MYNEWT_VAL(OS_PM)
+    dev->od_pm_active = 0;
+    dev->od_pm_max_state = OS_PM_STATE_IDLE;
+#endif
 
     return (0);
 }
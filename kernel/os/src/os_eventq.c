@@ -20,7 +20,9 @@
 #include <assert.h>
 #include <string.h>
 
+#include "syscfg/syscfg.h"
 #include "os/os.h"
+#include "os/os_cputime.h"
 
 /**
  * @addtogroup OSKernel
@@ -29,8 +31,131 @@
  *   @{
  */
 
+/* Values of ev_queued; OS_EVENT_QUEUED() is true for both. */
+#define OS_EVENT_Q_LIST     (1)     /* On the queue's event list */
+#define OS_EVENT_Q_BATCH    (2)     /* Taken by os_eventq_run_many() */
+
 static struct os_eventq *os_eventq_main;
 
+#if MYNEWT_VAL(OS_EVENTQ_LATENCY)
+static STAILQ_HEAD(, os_eventq) os_eventq_lat_list =
+    STAILQ_HEAD_INITIALIZER(os_eventq_lat_list);
+
+static void
+os_eventq_lat_record(struct os_eventq *evq, uint32_t ticks)
+{
+    int bucket;
+
+    bucket = 0;
+    if (ticks != 0) {
+        bucket = 31 - __builtin_clz(ticks);
+    }
+    if (bucket >= MYNEWT_VAL(OS_EVENTQ_LATENCY_BUCKETS)) {
+        bucket = MYNEWT_VAL(OS_EVENTQ_LATENCY_BUCKETS) - 1;
+    }
+    evq->evq_lat_hist[bucket]++;
+}
+#endif
+
+/*
+ * Links an event into the queue's event list, behind all queued events of
+ * the same or a more urgent priority level.  Must be called with interrupts
+ * disabled.
+ */
+static void
+os_eventq_link(struct os_eventq *evq, struct os_event *ev)
+{
+#if MYNEWT_VAL(OS_EVENTQ_PRIOS) > 1
+    int prio;
+    int i;
+
+    prio = OS_EVENT_PRIO(ev);
+    for (i = prio; i >= 0; i--) {
+        if (evq->evq_prio_tail[i] != NULL) {
+            break;
+        }
+    }
+    if (i < 0) {
+        STAILQ_INSERT_HEAD(&evq->evq_list, ev, ev_next);
+    } else {
+        STAILQ_INSERT_AFTER(&evq->evq_list, evq->evq_prio_tail[i], ev,
+                            ev_next);
+    }
+    evq->evq_prio_tail[prio] = ev;
+#else
+    STAILQ_INSERT_TAIL(&evq->evq_list, ev, ev_next);
+#endif
+}
+
+/*
+ * Removes an event from the queue's event list.  Must be called with
+ * interrupts disabled.
+ */
+static void
+os_eventq_unlink(struct os_eventq *evq, struct os_event *ev)
+{
+#if MYNEWT_VAL(OS_EVENTQ_PRIOS) > 1
+    struct os_event *prev;
+    int prio;
+
+    prev = NULL;
+    if (STAILQ_FIRST(&evq->evq_list) == ev) {
+        STAILQ_REMOVE_HEAD(&evq->evq_list, ev_next);
+    } else {
+        prev = STAILQ_FIRST(&evq->evq_list);
+        while (STAILQ_NEXT(prev, ev_next) != ev) {
+            prev = STAILQ_NEXT(prev, ev_next);
+        }
+        STAILQ_REMOVE_AFTER(&evq->evq_list, prev, ev_next);
+    }
+
+    prio = OS_EVENT_PRIO(ev);
+    if (evq->evq_prio_tail[prio] == ev) {
+        if (prev != NULL && OS_EVENT_PRIO(prev) == prio) {
+            evq->evq_prio_tail[prio] = prev;
+        } else {
+            evq->evq_prio_tail[prio] = NULL;
+        }
+    }
+#else
+    STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
+#endif
+    ev->ev_queued = 0;
+
+#if MYNEWT_VAL(OS_EVENTQ_STATS)
+    evq->evq_depth--;
+#endif
+}
+
+/*
+ * Removes an event from the queue's event list for dispatch, accounting for
+ * the time it waited.  Must be called with interrupts disabled.
+ */
+static void
+os_eventq_take(struct os_eventq *evq, struct os_event *ev)
+{
+#if MYNEWT_VAL(OS_EVENTQ_STATS)
+    os_time_t latency;
+#endif
+
+    os_eventq_unlink(evq, ev);
+
+#if MYNEWT_VAL(OS_EVENTQ_STATS)
+    latency = os_time_get() - ev->ev_time;
+    if (latency > evq->evq_max_latency) {
+        evq->evq_max_latency = latency;
+    }
+#if MYNEWT_VAL(OS_EVENTQ_PRIOS) > 1
+    if (latency > evq->evq_prio_max_latency[OS_EVENT_PRIO(ev)]) {
+        evq->evq_prio_max_latency[OS_EVENT_PRIO(ev)] = latency;
+    }
+#endif
+#endif
+#if MYNEWT_VAL(OS_EVENTQ_LATENCY)
+    os_eventq_lat_record(evq, os_cputime_get32() - ev->ev_cputime);
+#endif
+}
+
 /**
  * Initialize the event queue
  *
@@ -50,7 +175,8 @@ os_eventq_inited(const struct os_eventq *evq)
 }
 
 /**
- * Put an event on the event queue.
+ * Put an event on the event queue.  With OS_EVENTQ_PRIOS, the event is
+ * queued behind all events of the same or a more urgent priority level.
  *
  * @param evq The event queue to put an event on
  * @param ev The event to put on the queue
@@ -70,8 +196,18 @@ os_eventq_put(struct os_eventq *evq, struct os_event *ev)
     }
 
     /* Queue the event */
-    ev->ev_queued = 1;
-    STAILQ_INSERT_TAIL(&evq->evq_list, ev, ev_next);
+    ev->ev_queued = OS_EVENT_Q_LIST;
+    os_eventq_link(evq, ev);
+#if MYNEWT_VAL(OS_EVENTQ_STATS)
+    ev->ev_time = os_time_get();
+    evq->evq_depth++;
+    if (evq->evq_depth > evq->evq_max_depth) {
+        evq->evq_max_depth = evq->evq_depth;
+    }
+#endif
+#if MYNEWT_VAL(OS_EVENTQ_LATENCY)
+    ev->ev_cputime = os_cputime_get32();
+#endif
 
     resched = 0;
     if (evq->evq_task) {
@@ -91,6 +227,8 @@ os_eventq_put(struct os_eventq *evq, struct os_event *ev)
 
     OS_EXIT_CRITICAL(sr);
 
+    OS_TRACE(OS_TRACE_ID_EVQ_PUT, resched, ev);
+
     if (resched) {
         os_sched(NULL);
     }
@@ -116,8 +254,7 @@ pull_one:
     ev = STAILQ_FIRST(&evq->evq_list);
     t = os_sched_get_current_task();
     if (ev) {
-        STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
-        ev->ev_queued = 0;
+        os_eventq_take(evq, ev);
         t->t_flags &= ~OS_TASK_FLAG_EVQ_WAIT;
     } else {
         evq->evq_task = t;
@@ -133,6 +270,8 @@ pull_one:
     }
     OS_EXIT_CRITICAL(sr);
 
+    OS_TRACE(OS_TRACE_ID_EVQ_GET, 0, ev);
+
     return (ev);
 }
 
@@ -147,6 +286,98 @@ os_eventq_run(struct os_eventq *evq)
     ev->ev_cb(ev);
 }
 
+/**
+ * Dispatch events from an event queue in batches.  Blocks until there is at
+ * least one event on the queue.  Events are then removed from the queue up
+ * to OS_EVENTQ_BATCH_SIZE at a time, each batch in a single critical section,
+ * and dispatched in order.  Further batches are taken until the queue is
+ * empty, max_events have been dispatched, or the tick budget has run out.
+ *
+ * An event that is put while it sits in a batch is dispatched just once; an
+ * event removed with os_eventq_remove() while it sits in a batch is not
+ * dispatched.
+ *
+ * @param evq The event queue to dispatch events from
+ * @param max_events Maximum number of events to dispatch, 0 for no limit
+ * @param budget Number of OS ticks after which no new batch is taken,
+ *               OS_TIMEOUT_NEVER for no limit.  The budget is checked
+ *               between batches, so 0 dispatches a single batch.
+ *
+ * @return The number of events dispatched
+ */
+int
+os_eventq_run_many(struct os_eventq *evq, int max_events, os_time_t budget)
+{
+    struct os_event *batch[MYNEWT_VAL(OS_EVENTQ_BATCH_SIZE)];
+    struct os_event *ev;
+    os_time_t start;
+    os_sr_t sr;
+    int total;
+    int count;
+    int max;
+    int run;
+    int i;
+
+    start = os_time_get();
+    total = 0;
+    while (max_events <= 0 || total < max_events) {
+        max = sizeof(batch) / sizeof(batch[0]);
+        if (max_events > 0 && max_events - total < max) {
+            max = max_events - total;
+        }
+
+        count = 0;
+        OS_ENTER_CRITICAL(sr);
+        while (count < max) {
+            ev = STAILQ_FIRST(&evq->evq_list);
+            if (!ev) {
+                break;
+            }
+            os_eventq_take(evq, ev);
+            ev->ev_queued = OS_EVENT_Q_BATCH;
+            batch[count++] = ev;
+        }
+        OS_EXIT_CRITICAL(sr);
+
+        if (count == 0) {
+            if (total > 0) {
+                break;
+            }
+            /* Nothing queued yet; wait for the first event. */
+            ev = os_eventq_get(evq);
+            start = os_time_get();
+            assert(ev->ev_cb != NULL);
+            ev->ev_cb(ev);
+            total++;
+            continue;
+        }
+
+        for (i = 0; i < count; i++) {
+            ev = batch[i];
+
+            /* Claim the event, unless it was removed from the batch. */
+            OS_ENTER_CRITICAL(sr);
+            run = ev->ev_queued == OS_EVENT_Q_BATCH;
+            if (run) {
+                ev->ev_queued = 0;
+            }
+            OS_EXIT_CRITICAL(sr);
+
+            if (run) {
+                assert(ev->ev_cb != NULL);
+                ev->ev_cb(ev);
+                total++;
+            }
+        }
+
+        if (budget != OS_TIMEOUT_NEVER && os_time_get() - start >= budget) {
+            break;
+        }
+    }
+
+    return (total);
+}
+
 static struct os_event *
 os_eventq_poll_0timo(struct os_eventq **evq, int nevqs)
 {
@@ -160,8 +391,7 @@ os_eventq_poll_0timo(struct os_eventq **evq, int nevqs)
     for (i = 0; i < nevqs; i++) {
         ev = STAILQ_FIRST(&evq[i]->evq_list);
         if (ev) {
-            STAILQ_REMOVE(&evq[i]->evq_list, ev, os_event, ev_next);
-            ev->ev_queued = 0;
+            os_eventq_take(evq[i], ev);
             break;
         }
     }
@@ -205,8 +435,7 @@ os_eventq_poll(struct os_eventq **evq, int nevqs, os_time_t timo)
     for (i = 0; i < nevqs; i++) {
         ev = STAILQ_FIRST(&evq[i]->evq_list);
         if (ev) {
-            STAILQ_REMOVE(&evq[i]->evq_list, ev, os_event, ev_next);
-            ev->ev_queued = 0;
+            os_eventq_take(evq[i], ev);
             /* Reset the items that already have an evq task set. */
             for (j = 0; j < i; j++) {
                 evq[j]->evq_task = NULL;
@@ -236,8 +465,7 @@ os_eventq_poll(struct os_eventq **evq, int nevqs, os_time_t timo)
         if (!ev) {
             ev = STAILQ_FIRST(&evq[i]->evq_list);
             if (ev) {
-                STAILQ_REMOVE(&evq[i]->evq_list, ev, os_event, ev_next);
-                ev->ev_queued = 0;
+                os_eventq_take(evq[i], ev);
             }
         }
         evq[i]->evq_task = NULL;
@@ -260,9 +488,10 @@ os_eventq_remove(struct os_eventq *evq, struct os_event *ev)
     os_sr_t sr;
 
     OS_ENTER_CRITICAL(sr);
-    if (OS_EVENT_QUEUED(ev)) {
-        STAILQ_REMOVE(&evq->evq_list, ev, os_event, ev_next);
+    if (ev->ev_queued == OS_EVENT_Q_LIST) {
+        os_eventq_unlink(evq, ev);
     }
+    /* A batched event that is no longer marked is not dispatched. */
     ev->ev_queued = 0;
     OS_EXIT_CRITICAL(sr);
 }
@@ -322,6 +551,68 @@ os_eventq_ensure(struct os_eventq **evq, struct os_event *start_ev)
     }
 }
 
+#if MYNEWT_VAL(OS_EVENTQ_LATENCY)
+/**
+ * Adds an event queue to the list of queues whose latency histograms are
+ * reported by os_eventq_info_get_next().  Must be called after the queue
+ * has been initialized, and the queue must not be initialized again.
+ *
+ * @param evq The event queue to register
+ * @param name The name to report the queue under
+ *
+ * @return 0 on success, OS_EINVAL if the queue is already registered
+ */
+int
+os_eventq_lat_register(struct os_eventq *evq, const char *name)
+{
+    struct os_eventq *cur;
+
+    STAILQ_FOREACH(cur, &os_eventq_lat_list, evq_lat_next) {
+        if (cur == evq) {
+            return (OS_EINVAL);
+        }
+    }
+
+    evq->evq_name = name;
+    STAILQ_INSERT_TAIL(&os_eventq_lat_list, evq, evq_lat_next);
+
+    return (0);
+}
+
+/**
+ * Get event queue latency statistics
+ *
+ * @param evq The event queue to get statistics for, NULL to start with the
+ *            first registered queue
+ * @param oei Filled with the statistics of the queue that follows 'evq'
+ *
+ * @return The queue that follows 'evq', NULL if there is none
+ */
+struct os_eventq *
+os_eventq_info_get_next(struct os_eventq *evq, struct os_eventq_info *oei)
+{
+    struct os_eventq *cur;
+    os_sr_t sr;
+
+    if (evq == NULL) {
+        cur = STAILQ_FIRST(&os_eventq_lat_list);
+    } else {
+        cur = STAILQ_NEXT(evq, evq_lat_next);
+    }
+
+    if (cur == NULL) {
+        return (NULL);
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    memcpy(oei->oei_lat_hist, cur->evq_lat_hist, sizeof(oei->oei_lat_hist));
+    OS_EXIT_CRITICAL(sr);
+    strncpy(oei->oei_name, cur->evq_name, sizeof(oei->oei_name));
+
+    return (cur);
+}
+#endif
+
 /**
  *   @} OSEvent
  * @} OSKernel
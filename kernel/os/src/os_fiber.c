@@ -0,0 +1,262 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "os/os_fiber.h"
+
+#include <assert.h>
+#include <string.h>
+
+/**
+ * @addtogroup OSKernel
+ * @{
+ *   @defgroup OSFiber Fibers
+ *   @{
+ */
+
+#if MYNEWT_VAL(OS_FIBER)
+
+/* Must be called with interrupts disabled. */
+static void
+os_fiber_sem_unlink(struct os_fiber *f)
+{
+    if (f->of_sem != NULL) {
+        SLIST_REMOVE(&f->of_sem->ofs_waiters, f, os_fiber, of_sem_next);
+        f->of_sem = NULL;
+    }
+}
+
+static void
+os_fiber_run(struct os_event *ev)
+{
+    struct os_fiber *f;
+    int rc;
+
+    f = ev->ev_arg;
+    if (!f->of_running) {
+        return;
+    }
+
+    /* This run covers any other wakeup that is still queued. */
+    os_eventq_remove(f->of_evq, &f->of_ev);
+    os_eventq_remove(f->of_evq, &f->of_timer.c_ev);
+
+    rc = f->of_fn(f);
+    if (rc == OS_FIBER_EXITED) {
+        os_fiber_stop(f);
+    }
+}
+
+/**
+ * Initializes a fiber.  Must not be called while the fiber is running.
+ *
+ * @param f   The fiber to initialize.
+ * @param fn  The fiber function.
+ * @param arg Stored in the fiber's of_arg.
+ */
+void
+os_fiber_init(struct os_fiber *f, os_fiber_fn *fn, void *arg)
+{
+    memset(f, 0, sizeof(*f));
+    f->of_fn = fn;
+    f->of_arg = arg;
+}
+
+/**
+ * Starts a fiber from the beginning of its function.  The fiber runs on the
+ * task that processes 'evq', starting once that task gets to it.
+ *
+ * @param f   The fiber to start.
+ * @param evq The event queue the fiber is run from.
+ */
+void
+os_fiber_start(struct os_fiber *f, struct os_eventq *evq)
+{
+    os_fiber_stop(f);
+
+    f->of_evq = evq;
+    f->of_ev.ev_cb = os_fiber_run;
+    f->of_ev.ev_arg = f;
+    os_callout_init(&f->of_timer, evq, os_fiber_run, f);
+    f->of_lc = 0;
+    f->of_signalled = 0;
+    f->of_running = 1;
+
+    os_eventq_put(evq, &f->of_ev);
+}
+
+/**
+ * Stops a fiber; it is not called again until it is restarted.  Called
+ * automatically when the fiber exits.
+ *
+ * @param f The fiber to stop.
+ */
+void
+os_fiber_stop(struct os_fiber *f)
+{
+    os_sr_t sr;
+
+    if (!f->of_running) {
+        return;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    f->of_running = 0;
+    os_fiber_sem_unlink(f);
+    OS_EXIT_CRITICAL(sr);
+
+    os_callout_stop(&f->of_timer);
+    os_eventq_remove(f->of_evq, &f->of_ev);
+}
+
+/**
+ * Schedules a fiber to run, so that it rechecks what it waits for.  Can be
+ * called from an interrupt handler.
+ *
+ * @param f The fiber to wake.
+ */
+void
+os_fiber_wake(struct os_fiber *f)
+{
+    if (f->of_running) {
+        os_eventq_put(f->of_evq, &f->of_ev);
+    }
+}
+
+/**
+ * Signals a fiber, ending its OS_FIBER_WAIT_SIGNAL() wait.  A signal sent
+ * while the fiber is not waiting is kept until its next wait; signals do not
+ * accumulate.  Can be called from an interrupt handler.
+ *
+ * @param f The fiber to signal.
+ */
+void
+os_fiber_signal(struct os_fiber *f)
+{
+    f->of_signalled = 1;
+    os_fiber_wake(f);
+}
+
+int
+os_fiber_signal_take(struct os_fiber *f)
+{
+    os_sr_t sr;
+    int rc;
+
+    OS_ENTER_CRITICAL(sr);
+    rc = f->of_signalled;
+    f->of_signalled = 0;
+    OS_EXIT_CRITICAL(sr);
+
+    return rc;
+}
+
+void
+os_fiber_sleep_start(struct os_fiber *f, os_time_t ticks)
+{
+    os_callout_reset(&f->of_timer, ticks);
+}
+
+int
+os_fiber_sleeping(struct os_fiber *f)
+{
+    return os_callout_queued(&f->of_timer);
+}
+
+/**
+ * Initializes a fiber semaphore.
+ *
+ * @param sem    The semaphore to initialize.
+ * @param tokens The number of tokens initially available.
+ */
+void
+os_fiber_sem_init(struct os_fiber_sem *sem, uint16_t tokens)
+{
+    sem->ofs_tokens = tokens;
+    SLIST_INIT(&sem->ofs_waiters);
+}
+
+/**
+ * Adds a token to a fiber semaphore and wakes the fiber that has waited
+ * longest for it.  Can be called from an interrupt handler.
+ *
+ * @param sem The semaphore to release.
+ */
+void
+os_fiber_sem_release(struct os_fiber_sem *sem)
+{
+    struct os_fiber *f;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    sem->ofs_tokens++;
+    f = SLIST_FIRST(&sem->ofs_waiters);
+    if (f != NULL) {
+        SLIST_REMOVE_HEAD(&sem->ofs_waiters, of_sem_next);
+        f->of_sem = NULL;
+        os_fiber_wake(f);
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+/*
+ * Takes a token if one is available.  Otherwise queues the fiber to be woken
+ * by the next release, and returns nonzero.
+ */
+int
+os_fiber_sem_try(struct os_fiber *f, struct os_fiber_sem *sem)
+{
+    struct os_fiber *last;
+    struct os_fiber *cur;
+    os_sr_t sr;
+    int rc;
+
+    OS_ENTER_CRITICAL(sr);
+    if (sem->ofs_tokens > 0) {
+        sem->ofs_tokens--;
+        os_fiber_sem_unlink(f);
+        rc = 0;
+    } else {
+        if (f->of_sem == NULL) {
+            /* Waiters are woken in FIFO order. */
+            last = NULL;
+            SLIST_FOREACH(cur, &sem->ofs_waiters, of_sem_next) {
+                last = cur;
+            }
+            if (last == NULL) {
+                SLIST_INSERT_HEAD(&sem->ofs_waiters, f, of_sem_next);
+            } else {
+                SLIST_INSERT_AFTER(last, f, of_sem_next);
+            }
+            f->of_sem = sem;
+        }
+        rc = 1;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return rc;
+}
+
+#endif
+
+/**
+ *   @} OSFiber
+ * @} OSKernel
+ */
@@ -19,6 +19,9 @@
 
 
 #include <assert.h>
+#include <string.h>
+#include "syscfg/syscfg.h"
+#include "os/os.h"
 #include "os/os_mutex.h"
 #include "os/os_heap.h"
 
@@ -31,6 +34,120 @@
 
 static struct os_mutex os_malloc_mutex;
 
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+#define OS_SLAB_CLASSES     (5)
+
+static const struct {
+    uint16_t size;
+    uint16_t blocks;
+} os_slab_cfg[OS_SLAB_CLASSES] = {
+    { 16,  MYNEWT_VAL(OS_MALLOC_SLAB_16) },
+    { 32,  MYNEWT_VAL(OS_MALLOC_SLAB_32) },
+    { 64,  MYNEWT_VAL(OS_MALLOC_SLAB_64) },
+    { 128, MYNEWT_VAL(OS_MALLOC_SLAB_128) },
+    { 256, MYNEWT_VAL(OS_MALLOC_SLAB_256) },
+};
+
+/* One spare element keeps the arrays non-empty when a class is disabled. */
+static os_membuf_t os_slab_buf16[
+    OS_MEMPOOL_SIZE(MYNEWT_VAL(OS_MALLOC_SLAB_16), 16) + 1];
+static os_membuf_t os_slab_buf32[
+    OS_MEMPOOL_SIZE(MYNEWT_VAL(OS_MALLOC_SLAB_32), 32) + 1];
+static os_membuf_t os_slab_buf64[
+    OS_MEMPOOL_SIZE(MYNEWT_VAL(OS_MALLOC_SLAB_64), 64) + 1];
+static os_membuf_t os_slab_buf128[
+    OS_MEMPOOL_SIZE(MYNEWT_VAL(OS_MALLOC_SLAB_128), 128) + 1];
+static os_membuf_t os_slab_buf256[
+    OS_MEMPOOL_SIZE(MYNEWT_VAL(OS_MALLOC_SLAB_256), 256) + 1];
+
+static os_membuf_t * const os_slab_bufs[OS_SLAB_CLASSES] = {
+    os_slab_buf16, os_slab_buf32, os_slab_buf64, os_slab_buf128,
+    os_slab_buf256,
+};
+
+static char *os_slab_names[OS_SLAB_CLASSES] = {
+    "slab16", "slab32", "slab64", "slab128", "slab256",
+};
+
+static struct os_mempool os_slab_pools[OS_SLAB_CLASSES];
+static uint8_t os_slab_ready;
+
+/*
+ * The pools are set up on first use, as os_malloc() may be called before
+ * os_init().
+ */
+static void
+os_slab_init(void)
+{
+    os_sr_t sr;
+    int rc;
+    int i;
+
+    OS_ENTER_CRITICAL(sr);
+    if (!os_slab_ready) {
+        for (i = 0; i < OS_SLAB_CLASSES; i++) {
+            if (os_slab_cfg[i].blocks == 0) {
+                continue;
+            }
+            rc = os_mempool_init(&os_slab_pools[i], os_slab_cfg[i].blocks,
+                                 os_slab_cfg[i].size, os_slab_bufs[i],
+                                 os_slab_names[i]);
+            assert(rc == 0);
+        }
+        os_slab_ready = 1;
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+/*
+ * Returns a block from the smallest slab class that fits 'size', or NULL if
+ * the request is too large or that class is empty.
+ */
+static void *
+os_slab_get(size_t size)
+{
+    int i;
+
+    if (!os_slab_ready) {
+        os_slab_init();
+    }
+
+    for (i = 0; i < OS_SLAB_CLASSES; i++) {
+        if (size <= os_slab_cfg[i].size) {
+            if (os_slab_cfg[i].blocks == 0) {
+                return NULL;
+            }
+            return os_memblock_get(&os_slab_pools[i]);
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Returns the slab pool 'mem' was allocated from, or NULL if it came from
+ * the heap.
+ */
+static struct os_mempool *
+os_slab_pool(void *mem)
+{
+    int i;
+
+    if (!os_slab_ready || mem == NULL) {
+        return NULL;
+    }
+
+    for (i = 0; i < OS_SLAB_CLASSES; i++) {
+        if (os_slab_cfg[i].blocks != 0 &&
+            os_memblock_from(&os_slab_pools[i], mem)) {
+            return &os_slab_pools[i];
+        }
+    }
+
+    return NULL;
+}
+#endif
+
 static void
 os_malloc_lock(void)
 {
@@ -68,8 +185,19 @@ os_malloc(size_t size)
 {
     void *ptr;
 
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    ptr = os_slab_get(size);
+    if (ptr != NULL) {
+        return ptr;
+    }
+#endif
+
     os_malloc_lock();
+#if MYNEWT_VAL(BASELIBC_MALLOC_TRACE) > 0
+    ptr = malloc_traced(size, __builtin_return_address(0));
+#else
     ptr = malloc(size);
+#endif
     os_malloc_unlock();
 
     return ptr;
@@ -85,8 +213,24 @@ os_malloc(size_t size)
 void
 os_free(void *mem)
 {
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    struct os_mempool *mp;
+    int rc;
+
+    mp = os_slab_pool(mem);
+    if (mp != NULL) {
+        rc = os_memblock_put(mp, mem);
+        assert(rc == 0);
+        return;
+    }
+#endif
+
     os_malloc_lock();
+#if MYNEWT_VAL(BASELIBC_MALLOC_TRACE) > 0
+    free_traced(mem, __builtin_return_address(0));
+#else
     free(mem);
+#endif
     os_malloc_unlock();
 }
 
@@ -105,13 +249,71 @@ os_realloc(void *ptr, size_t size)
 {
     void *new_ptr;
 
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    struct os_mempool *mp;
+
+    mp = os_slab_pool(ptr);
+    if (mp != NULL) {
+        if (size <= mp->mp_block_size && size > 0) {
+            return ptr;
+        }
+        new_ptr = NULL;
+        if (size > 0) {
+            new_ptr = os_malloc(size);
+            if (new_ptr == NULL) {
+                return NULL;
+            }
+            memcpy(new_ptr, ptr, min(size, mp->mp_block_size));
+        }
+        os_free(ptr);
+        return new_ptr;
+    }
+#endif
+
     os_malloc_lock();
+#if MYNEWT_VAL(BASELIBC_MALLOC_TRACE) > 0
+    new_ptr = realloc_traced(ptr, size, __builtin_return_address(0));
+#else
     new_ptr = realloc(ptr, size);
+#endif
     os_malloc_unlock();
 
     return new_ptr;
 }
 
+/**
+ * Reads heap usage statistics.  The allocation counts and the low-water mark
+ * are only kept when BASELIBC_MALLOC_STATS is enabled, and are 0 otherwise.
+ * Blocks served from the os_malloc() slabs are not included.
+ *
+ * @param ohi The structure to fill out.
+ *
+ * @return 0 on success, OS_ENOENT if the libc in use does not report heap
+ *         statistics.
+ */
+int
+os_heap_info_get(struct os_heap_info *ohi)
+{
+#if MYNEWT_VAL(BASELIBC_PRESENT)
+    struct malloc_stats ms;
+
+    get_malloc_stats(&ms);
+
+    ohi->ohi_free = ms.ms_free_bytes;
+    ohi->ohi_min_free = ms.ms_min_free_bytes;
+    ohi->ohi_largest_free = ms.ms_largest_free;
+    ohi->ohi_free_blocks = ms.ms_free_blocks;
+    ohi->ohi_num_allocs = ms.ms_num_allocs;
+    ohi->ohi_num_frees = ms.ms_num_frees;
+    ohi->ohi_num_fail = ms.ms_num_fail;
+
+    return 0;
+#else
+    memset(ohi, 0, sizeof(*ohi));
+    return OS_ENOENT;
+#endif
+}
+
 /**
  *   @} OSGeneral
  * @} OS Kernel
@@ -33,7 +33,9 @@
  *
  */
 
+#include "syscfg/syscfg.h"
 #include "os/os.h"
+#include "os_priv.h"
 
 #include <assert.h>
 #include <string.h>
@@ -47,7 +49,7 @@
  */
 
 
-STAILQ_HEAD(, os_mbuf_pool) g_msys_pool_list =
+struct os_msys_pool_list g_msys_pool_list =
     STAILQ_HEAD_INITIALIZER(g_msys_pool_list);
 
 /**
@@ -77,6 +79,17 @@ os_mqueue_init(struct os_mqueue *mq, os_event_fn *ev_cb, void *arg)
     ev->ev_cb = ev_cb;
     ev->ev_arg = arg;
 
+#if MYNEWT_VAL(OS_MQUEUE_FLOW)
+    mq->mq_depth = 0;
+    mq->mq_max_depth = 0;
+    mq->mq_high = 0;
+    mq->mq_low = 0;
+    mq->mq_flags = 0;
+    mq->mq_flow_cb = NULL;
+    mq->mq_posts = 0;
+    mq->mq_drops = 0;
+#endif
+
     return (0);
 }
 
@@ -93,14 +106,33 @@ os_mqueue_get(struct os_mqueue *mq)
     struct os_mbuf_pkthdr *mp;
     struct os_mbuf *m;
     os_sr_t sr;
+#if MYNEWT_VAL(OS_MQUEUE_FLOW)
+    int relieved;
+
+    relieved = 0;
+#endif
 
     OS_ENTER_CRITICAL(sr);
     mp = STAILQ_FIRST(&mq->mq_head);
     if (mp) {
         STAILQ_REMOVE_HEAD(&mq->mq_head, omp_next);
+#if MYNEWT_VAL(OS_MQUEUE_FLOW)
+        mq->mq_depth--;
+        if ((mq->mq_flags & OS_MQUEUE_F_CONGESTED) &&
+            mq->mq_depth <= mq->mq_low) {
+            mq->mq_flags &= ~OS_MQUEUE_F_CONGESTED;
+            relieved = 1;
+        }
+#endif
     }
     OS_EXIT_CRITICAL(sr);
 
+#if MYNEWT_VAL(OS_MQUEUE_FLOW)
+    if (relieved && mq->mq_flow_cb) {
+        mq->mq_flow_cb(mq, 0);
+    }
+#endif
+
     if (mp) {
         m = OS_MBUF_PKTHDR_TO_MBUF(mp);
     } else {
@@ -118,7 +150,8 @@ os_mqueue_get(struct os_mqueue *mq)
  * @param evq The event queue to post an OS_EVENT_T_MQUEUE_DATA event to
  * @param m The mbuf to append to the mbuf queue
  *
- * @return 0 on success, non-zero on failure.
+ * @return 0 on success; OS_EBUSY if the queue is congested, in which case
+ *         the caller still owns the mbuf; other non-zero on failure.
  */
 int
 os_mqueue_put(struct os_mqueue *mq, struct os_eventq *evq, struct os_mbuf *m)
@@ -126,6 +159,10 @@ os_mqueue_put(struct os_mqueue *mq, struct os_eventq *evq, struct os_mbuf *m)
     struct os_mbuf_pkthdr *mp;
     os_sr_t sr;
     int rc;
+#if MYNEWT_VAL(OS_MQUEUE_FLOW)
+    int congested;
+    int post;
+#endif
 
     /* Can only place the head of a chained mbuf on the queue. */
     if (!OS_MBUF_IS_PKTHDR(m)) {
@@ -135,6 +172,41 @@ os_mqueue_put(struct os_mqueue *mq, struct os_eventq *evq, struct os_mbuf *m)
 
     mp = OS_MBUF_PKTHDR(m);
 
+#if MYNEWT_VAL(OS_MQUEUE_PACK)
+    os_mbuf_compact_wasteful(m);
+#endif
+
+#if MYNEWT_VAL(OS_MQUEUE_FLOW)
+    congested = 0;
+    OS_ENTER_CRITICAL(sr);
+    if (mq->mq_flags & OS_MQUEUE_F_CONGESTED) {
+        mq->mq_drops++;
+        OS_EXIT_CRITICAL(sr);
+        rc = OS_EBUSY;
+        goto err;
+    }
+    STAILQ_INSERT_TAIL(&mq->mq_head, mp, omp_next);
+    post = !(mq->mq_flags & OS_MQUEUE_F_BATCH) || mq->mq_depth == 0;
+    mq->mq_depth++;
+    if (mq->mq_depth > mq->mq_max_depth) {
+        mq->mq_max_depth = mq->mq_depth;
+    }
+    if (mq->mq_high != 0 && mq->mq_depth >= mq->mq_high) {
+        mq->mq_flags |= OS_MQUEUE_F_CONGESTED;
+        congested = 1;
+    }
+    if (post && evq) {
+        mq->mq_posts++;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (post && evq) {
+        os_eventq_put(evq, &mq->mq_ev);
+    }
+    if (congested && mq->mq_flow_cb) {
+        mq->mq_flow_cb(mq, 1);
+    }
+#else
     OS_ENTER_CRITICAL(sr);
     STAILQ_INSERT_TAIL(&mq->mq_head, mp, omp_next);
     OS_EXIT_CRITICAL(sr);
@@ -143,12 +215,71 @@ os_mqueue_put(struct os_mqueue *mq, struct os_eventq *evq, struct os_mbuf *m)
     if (evq) {
         os_eventq_put(evq, &mq->mq_ev);
     }
+#endif
 
     return (0);
 err:
     return (rc);
 }
 
+#if MYNEWT_VAL(OS_MQUEUE_FLOW)
+/**
+ * Configures flow control for an mbuf queue.  Once the queue holds 'high'
+ * mbufs it becomes congested: os_mqueue_put() refuses further mbufs with
+ * OS_EBUSY until the consumer has drained it to 'low' mbufs.  The callback,
+ * if any, is told about both transitions, so a producer can stop and resume
+ * generating data instead of polling.
+ *
+ * With OS_MQUEUE_F_BATCH in 'flags', the queue event is only posted when an
+ * mbuf is put on an empty queue, so the consumer wakes once per batch.  The
+ * consumer must then keep calling os_mqueue_get() until it returns NULL.
+ *
+ * @param mq    The mbuf queue to configure.
+ * @param high  Depth at which the queue becomes congested; 0 for no limit.
+ * @param low   Depth at which a congested queue accepts mbufs again.
+ * @param flags OS_MQUEUE_F_BATCH, or 0.
+ * @param cb    Function to call on congestion changes, or NULL.
+ *
+ * @return 0 on success; OS_EINVAL if 'low' is not below 'high'.
+ */
+int
+os_mqueue_flow_set(struct os_mqueue *mq, uint16_t high, uint16_t low,
+                   uint8_t flags, os_mqueue_flow_fn *cb)
+{
+    os_sr_t sr;
+
+    if (high != 0 && low >= high) {
+        return OS_EINVAL;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    mq->mq_high = high;
+    mq->mq_low = low;
+    mq->mq_flags = (mq->mq_flags & OS_MQUEUE_F_CONGESTED) |
+                   (flags & OS_MQUEUE_F_BATCH);
+    mq->mq_flow_cb = cb;
+    if (high == 0 || mq->mq_depth <= low) {
+        mq->mq_flags &= ~OS_MQUEUE_F_CONGESTED;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return 0;
+}
+
+/**
+ * Indicates whether an mbuf queue is congested, and so refusing puts.
+ *
+ * @param mq The mbuf queue to check.
+ *
+ * @return 1 if congested, 0 otherwise.
+ */
+int
+os_mqueue_congested(const struct os_mqueue *mq)
+{
+    return !!(mq->mq_flags & OS_MQUEUE_F_CONGESTED);
+}
+#endif
+
 /**
  * MSYS is a system level mbuf registry.  Allows the system to share
  * packet buffers amongst the various networking stacks that can be running
@@ -168,19 +299,22 @@ err:
 int
 os_msys_register(struct os_mbuf_pool *new_pool)
 {
+    struct os_mbuf_pool *prev;
     struct os_mbuf_pool *pool;
 
-    pool = NULL;
+    /* Keep the list sorted from smallest to largest buffer. */
+    prev = NULL;
     STAILQ_FOREACH(pool, &g_msys_pool_list, omp_next) {
-        if (new_pool->omp_databuf_len > pool->omp_databuf_len) {
+        if (new_pool->omp_databuf_len < pool->omp_databuf_len) {
             break;
         }
+        prev = pool;
     }
 
-    if (pool) {
-        STAILQ_INSERT_AFTER(&g_msys_pool_list, pool, new_pool, omp_next);
+    if (prev) {
+        STAILQ_INSERT_AFTER(&g_msys_pool_list, prev, new_pool, omp_next);
     } else {
-        STAILQ_INSERT_TAIL(&g_msys_pool_list, new_pool, omp_next);
+        STAILQ_INSERT_HEAD(&g_msys_pool_list, new_pool, omp_next);
     }
 
     return (0);
@@ -214,6 +348,92 @@ _os_msys_find_pool(uint16_t dsize)
     return (pool);
 }
 
+static struct os_mbuf *
+_os_msys_get_from(struct os_mbuf_pool *pool, int pkthdr, uint16_t len)
+{
+    struct os_mbuf *m;
+    os_sr_t sr;
+
+    if (pkthdr) {
+        m = os_mbuf_get_pkthdr(pool, len);
+    } else {
+        m = os_mbuf_get(pool, len);
+    }
+
+    /* Allocations can come from interrupt context; don't lose counts. */
+    OS_ENTER_CRITICAL(sr);
+    if (m) {
+        pool->omp_msys_hits++;
+    } else {
+        pool->omp_msys_misses++;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return (m);
+}
+
+/*
+ * Allocates from the best fitting pool for 'dsize'.  If that pool is empty,
+ * falls back to other pools according to the MSYS_FALLBACK_* settings.
+ * 'len' is the leading space, or the user header length if 'pkthdr' is set.
+ */
+static struct os_mbuf *
+_os_msys_alloc(uint16_t dsize, int pkthdr, uint16_t len)
+{
+    struct os_mbuf_pool *best;
+#if MYNEWT_VAL(MSYS_FALLBACK_LARGER) || MYNEWT_VAL(MSYS_FALLBACK_SMALLER)
+    struct os_mbuf_pool *pool;
+#endif
+    struct os_mbuf *m;
+
+#if MYNEWT_VAL(OS_MSYS_ADVISE)
+    os_msys_demand_add(dsize);
+#endif
+
+    best = _os_msys_find_pool(dsize);
+    if (!best) {
+        return (NULL);
+    }
+
+    m = _os_msys_get_from(best, pkthdr, len);
+    if (m) {
+        return (m);
+    }
+
+#if MYNEWT_VAL(MSYS_FALLBACK_LARGER)
+    for (pool = STAILQ_NEXT(best, omp_next);
+         pool != NULL;
+         pool = STAILQ_NEXT(pool, omp_next)) {
+
+        m = _os_msys_get_from(pool, pkthdr, len);
+        if (m) {
+            return (m);
+        }
+    }
+#endif
+
+#if MYNEWT_VAL(MSYS_FALLBACK_SMALLER)
+    /* Walk the smaller pools from largest to smallest. */
+    while (best != STAILQ_FIRST(&g_msys_pool_list)) {
+        pool = STAILQ_FIRST(&g_msys_pool_list);
+        while (STAILQ_NEXT(pool, omp_next) != best) {
+            pool = STAILQ_NEXT(pool, omp_next);
+        }
+
+        m = _os_msys_get_from(pool, pkthdr, len);
+        if (m) {
+            return (m);
+        }
+        best = pool;
+    }
+#endif
+
+#if MYNEWT_VAL(OS_MSYS_ADVISE)
+    os_msys_demand_fail();
+#endif
+    return (NULL);
+}
+
 /**
  * Allocate a mbuf from msys.  Based upon the data size requested,
  * os_msys_get() will choose the mbuf pool that has the best fit.
@@ -227,18 +447,7 @@ _os_msys_find_pool(uint16_t dsize)
 struct os_mbuf *
 os_msys_get(uint16_t dsize, uint16_t leadingspace)
 {
-    struct os_mbuf *m;
-    struct os_mbuf_pool *pool;
-
-    pool = _os_msys_find_pool(dsize);
-    if (!pool) {
-        goto err;
-    }
-
-    m = os_mbuf_get(pool, leadingspace);
-    return (m);
-err:
-    return (NULL);
+    return _os_msys_alloc(dsize, 0, leadingspace);
 }
 
 /**
@@ -254,19 +463,9 @@ struct os_mbuf *
 os_msys_get_pkthdr(uint16_t dsize, uint16_t user_hdr_len)
 {
     uint16_t total_pkthdr_len;
-    struct os_mbuf *m;
-    struct os_mbuf_pool *pool;
 
     total_pkthdr_len =  user_hdr_len + sizeof(struct os_mbuf_pkthdr);
-    pool = _os_msys_find_pool(dsize + total_pkthdr_len);
-    if (!pool) {
-        goto err;
-    }
-
-    m = os_mbuf_get_pkthdr(pool, user_hdr_len);
-    return (m);
-err:
-    return (NULL);
+    return _os_msys_alloc(dsize + total_pkthdr_len, 1, user_hdr_len);
 }
 
 int
@@ -314,6 +513,8 @@ os_mbuf_pool_init(struct os_mbuf_pool *omp, struct os_mempool *mp,
     omp->omp_databuf_len = buf_len - sizeof(struct os_mbuf);
     omp->omp_mbuf_count = nbufs;
     omp->omp_pool = mp;
+    omp->omp_msys_hits = 0;
+    omp->omp_msys_misses = 0;
 
     return (0);
 }
@@ -389,6 +590,79 @@ os_mbuf_get_pkthdr(struct os_mbuf_pool *omp, uint8_t user_pkthdr_len)
     return om;
 }
 
+/**
+ * Initialize an external buffer descriptor.  The descriptor must stay valid
+ * until the last mbuf referencing it has been freed.
+ *
+ * @param ext The descriptor to initialize
+ * @param buf The externally owned data
+ * @param len The size of the data, in bytes
+ * @param free_cb Called when the last referencing mbuf is freed; may be NULL
+ *                for memory that is never reclaimed, such as static tables.
+ * @param arg Argument for the owner's use, stored in ome_arg.
+ */
+void
+os_mbuf_ext_init(struct os_mbuf_ext *ext, void *buf, uint16_t len,
+                 os_mbuf_ext_free_fn *free_cb, void *arg)
+{
+    ext->ome_buf = buf;
+    ext->ome_len = len;
+    ext->ome_refcnt = 0;
+    ext->ome_free_cb = free_cb;
+    ext->ome_arg = arg;
+}
+
+/**
+ * Allocate a new mbuf out of the os_mbuf_pool whose data points into an
+ * external buffer instead of its own pool block.  No data is copied.  The
+ * resulting mbuf never has a packet header and has no leading or trailing
+ * space, so it is normally chained behind a regular packet header mbuf.
+ *
+ * @param omp The mbuf pool to allocate the mbuf header out of
+ * @param ext The external buffer to reference
+ * @param off The offset of the mbuf's data within the external buffer
+ * @param len The number of bytes of external data the mbuf holds
+ *
+ * @return A freshly allocated mbuf on success, NULL on failure.
+ */
+struct os_mbuf *
+os_mbuf_get_ext(struct os_mbuf_pool *omp, struct os_mbuf_ext *ext,
+                uint16_t off, uint16_t len)
+{
+    struct os_mbuf *om;
+    os_sr_t sr;
+
+    if (off + len > ext->ome_len ||
+        omp->omp_databuf_len < sizeof(struct os_mbuf_ext *)) {
+        return NULL;
+    }
+
+    om = os_mbuf_get(omp, 0);
+    if (om) {
+        OS_ENTER_CRITICAL(sr);
+        ext->ome_refcnt++;
+        OS_EXIT_CRITICAL(sr);
+
+        OS_MBUF_EXT(om) = ext;
+        om->om_flags = OS_MBUF_F_MASK(OS_MBUF_F_EXT);
+        om->om_data = ext->ome_buf + off;
+        om->om_len = len;
+    }
+
+    return om;
+}
+
+/* Creates an external mbuf that shares the data of another one. */
+static struct os_mbuf *
+_os_mbuf_share(struct os_mbuf_pool *omp, const struct os_mbuf *om,
+               uint16_t off, uint16_t len)
+{
+    struct os_mbuf_ext *ext;
+
+    ext = OS_MBUF_EXT(om);
+    return os_mbuf_get_ext(omp, ext, om->om_data + off - ext->ome_buf, len);
+}
+
 /**
  * Release a mbuf back to the pool
  *
@@ -400,8 +674,23 @@ os_mbuf_get_pkthdr(struct os_mbuf_pool *omp, uint8_t user_pkthdr_len)
 int
 os_mbuf_free(struct os_mbuf *om)
 {
+    struct os_mbuf_ext *ext;
+    os_sr_t sr;
+    int refcnt;
     int rc;
 
+    if (OS_MBUF_IS_EXT(om)) {
+        ext = OS_MBUF_EXT(om);
+
+        OS_ENTER_CRITICAL(sr);
+        refcnt = --ext->ome_refcnt;
+        OS_EXIT_CRITICAL(sr);
+
+        if (refcnt == 0 && ext->ome_free_cb != NULL) {
+            ext->ome_free_cb(ext);
+        }
+    }
+
     if (om->om_omp != NULL) {
         rc = os_memblock_put(om->om_omp->omp_pool, om);
         if (rc != 0) {
@@ -545,10 +834,40 @@ err:
     return (rc);
 }
 
+/*
+ * Appends an external mbuf sharing part of 'src' to the end of the 'dst'
+ * chain.
+ */
+static int
+_os_mbuf_append_ext(struct os_mbuf *dst, const struct os_mbuf *src,
+                    uint16_t off, uint16_t len)
+{
+    struct os_mbuf *last;
+    struct os_mbuf *new;
+
+    new = _os_mbuf_share(dst->om_omp, src, off, len);
+    if (new == NULL) {
+        return OS_ENOMEM;
+    }
+
+    last = dst;
+    while (SLIST_NEXT(last, om_next) != NULL) {
+        last = SLIST_NEXT(last, om_next);
+    }
+    SLIST_NEXT(last, om_next) = new;
+
+    if (OS_MBUF_IS_PKTHDR(dst)) {
+        OS_MBUF_PKTHDR(dst)->omp_len += len;
+    }
+
+    return 0;
+}
+
 /**
  * Reads data from one mbuf and appends it to another.  On error, the specified
  * data range may be partially appended.  Neither mbuf is required to contain
- * an mbuf packet header.
+ * an mbuf packet header.  Data held in external buffers is shared with the
+ * destination chain rather than copied.
  *
  * @param dst                   The mbuf to append to.
  * @param src                   The mbuf to copy data from.
@@ -576,7 +895,13 @@ os_mbuf_appendfrom(struct os_mbuf *dst, const struct os_mbuf *src,
         }
 
         chunk_sz = min(len, src_cur_om->om_len - src_cur_off);
-        rc = os_mbuf_append(dst, src_cur_om->om_data + src_cur_off, chunk_sz);
+        if (OS_MBUF_IS_EXT(src_cur_om)) {
+            /* Share external data rather than copying it. */
+            rc = _os_mbuf_append_ext(dst, src_cur_om, src_cur_off, chunk_sz);
+        } else {
+            rc = os_mbuf_append(dst, src_cur_om->om_data + src_cur_off,
+                                chunk_sz);
+        }
         if (rc != 0) {
             return rc;
         }
@@ -589,8 +914,23 @@ os_mbuf_appendfrom(struct os_mbuf *dst, const struct os_mbuf *src,
     return 0;
 }
 
+/*
+ * Allocates the duplicate of a single mbuf: external mbufs share their
+ * buffer, regular mbufs get a fresh buffer with the same leading space.
+ */
+static struct os_mbuf *
+_os_mbuf_dup_one(struct os_mbuf_pool *omp, struct os_mbuf *om)
+{
+    if (OS_MBUF_IS_EXT(om)) {
+        return _os_mbuf_share(omp, om, 0, om->om_len);
+    } else {
+        return os_mbuf_get(omp, OS_MBUF_LEADINGSPACE(om));
+    }
+}
+
 /**
  * Duplicate a chain of mbufs.  Return the start of the duplicated chain.
+ * Data held in external buffers is shared rather than copied.
  *
  * @param omp The mbuf pool to duplicate out of
  * @param om  The mbuf chain to duplicate
@@ -611,8 +951,7 @@ os_mbuf_dup(struct os_mbuf *om)
 
     for (; om != NULL; om = SLIST_NEXT(om, om_next)) {
         if (head) {
-            SLIST_NEXT(copy, om_next) = os_mbuf_get(omp,
-                    OS_MBUF_LEADINGSPACE(om));
+            SLIST_NEXT(copy, om_next) = _os_mbuf_dup_one(omp, om);
             if (!SLIST_NEXT(copy, om_next)) {
                 os_mbuf_free_chain(head);
                 goto err;
@@ -620,7 +959,7 @@ os_mbuf_dup(struct os_mbuf *om)
 
             copy = SLIST_NEXT(copy, om_next);
         } else {
-            head = os_mbuf_get(omp, OS_MBUF_LEADINGSPACE(om));
+            head = _os_mbuf_dup_one(omp, om);
             if (!head) {
                 goto err;
             }
@@ -630,6 +969,9 @@ os_mbuf_dup(struct os_mbuf *om)
             }
             copy = head;
         }
+        if (OS_MBUF_IS_EXT(om)) {
+            continue;
+        }
         copy->om_flags = om->om_flags;
         copy->om_len = om->om_len;
         memcpy(OS_MBUF_DATA(copy, uint8_t *), OS_MBUF_DATA(om, uint8_t *),
@@ -728,6 +1070,59 @@ os_mbuf_copydata(const struct os_mbuf *m, int off, int len, void *dst)
     return (len > 0 ? -1 : 0);
 }
 
+/**
+ * Describes "len" bytes of an mbuf chain, starting "off" bytes from the
+ * beginning, as an array of contiguous segments.  No data is copied; the
+ * segments point straight into the mbufs, so a DMA capable driver can
+ * transmit the chain without staging it in a flat buffer.  The segments
+ * remain valid only as long as the chain is neither modified nor freed.
+ *
+ * @param om                    The mbuf chain to describe.
+ * @param off                   The offset into the chain of the first byte.
+ * @param len                   The number of bytes to describe.
+ * @param iov                   The array to fill with segments.
+ * @param max_iov               The number of entries in "iov".
+ *
+ * @return                      The number of segments filled in on success;
+ *                              -1 if the chain does not contain enough data
+ *                                  or more than "max_iov" segments would be
+ *                                  needed.
+ */
+int
+os_mbuf_iovec(const struct os_mbuf *om, int off, int len,
+              struct os_mbuf_iovec *iov, int max_iov)
+{
+    uint16_t count;
+    int cnt;
+
+    while (om != NULL && off >= om->om_len) {
+        off -= om->om_len;
+        om = SLIST_NEXT(om, om_next);
+    }
+
+    cnt = 0;
+    while (len > 0) {
+        if (om == NULL || cnt >= max_iov) {
+            return (-1);
+        }
+
+        count = min(om->om_len - off, len);
+        iov[cnt].oiov_base = om->om_data + off;
+        iov[cnt].oiov_len = count;
+        cnt++;
+
+        len -= count;
+        off = 0;
+
+        /* Skip empty mbufs so that every segment has data. */
+        do {
+            om = SLIST_NEXT(om, om_next);
+        } while (om != NULL && om->om_len == 0);
+    }
+
+    return (cnt);
+}
+
 /**
  * Adjust the length of a mbuf, trimming either from the head or the tail
  * of the mbuf.
@@ -810,6 +1205,88 @@ os_mbuf_adj(struct os_mbuf *mp, int req_len)
     }
 }
 
+/**
+ * Splits a packet in two.  The first "off" bytes stay in the original
+ * chain; the rest are moved to a new packet with a copy of the user
+ * header.  Whole mbufs are moved without copying; only the part of an mbuf
+ * straddling the split point is copied, or shared if it is held in an
+ * external buffer.
+ *
+ * @param om                    The packet header mbuf of the chain to split.
+ * @param off                   The number of bytes to leave in the original
+ *                                  chain; must be less than its length.
+ *
+ * @return                      The packet holding the remaining data on
+ *                                  success;
+ *                              NULL on failure, in which case the original
+ *                                  chain is unchanged.
+ */
+struct os_mbuf *
+os_mbuf_split(struct os_mbuf *om, uint16_t off)
+{
+    struct os_mbuf_pkthdr *hdr;
+    struct os_mbuf *tail;
+    struct os_mbuf *prev;
+    struct os_mbuf *part;
+    struct os_mbuf *cur;
+    uint16_t cur_off;
+    uint16_t len;
+
+    hdr = OS_MBUF_PKTHDR(om);
+    if (off >= hdr->omp_len) {
+        return NULL;
+    }
+
+    cur = os_mbuf_off(om, off, &cur_off);
+    if (cur == NULL) {
+        return NULL;
+    }
+
+    tail = os_mbuf_get_pkthdr(om->om_omp, OS_MBUF_USRHDR_LEN(om));
+    if (tail == NULL) {
+        return NULL;
+    }
+    memcpy(OS_MBUF_USRHDR(tail), OS_MBUF_USRHDR(om), OS_MBUF_USRHDR_LEN(om));
+
+    if (cur_off == 0 && cur != om) {
+        /* Split falls on an mbuf boundary; just unlink. */
+        for (prev = om; SLIST_NEXT(prev, om_next) != cur;
+             prev = SLIST_NEXT(prev, om_next)) {
+        }
+        SLIST_NEXT(prev, om_next) = NULL;
+        SLIST_NEXT(tail, om_next) = cur;
+    } else {
+        len = cur->om_len - cur_off;
+        if (OS_MBUF_IS_EXT(cur)) {
+            part = _os_mbuf_share(om->om_omp, cur, cur_off, len);
+        } else {
+            part = os_mbuf_get(om->om_omp, 0);
+            if (part != NULL && OS_MBUF_TRAILINGSPACE(part) < len) {
+                os_mbuf_free(part);
+                part = NULL;
+            }
+            if (part != NULL) {
+                memcpy(part->om_data, cur->om_data + cur_off, len);
+                part->om_len = len;
+            }
+        }
+        if (part == NULL) {
+            os_mbuf_free(tail);
+            return NULL;
+        }
+
+        SLIST_NEXT(part, om_next) = SLIST_NEXT(cur, om_next);
+        SLIST_NEXT(cur, om_next) = NULL;
+        cur->om_len = cur_off;
+        SLIST_NEXT(tail, om_next) = part;
+    }
+
+    OS_MBUF_PKTHDR(tail)->omp_len = hdr->omp_len - off;
+    hdr->omp_len = off;
+
+    return tail;
+}
+
 /**
  * Performs a memory compare of the specified region of an mbuf chain against a
  * flat buffer.
@@ -1146,6 +1623,150 @@ os_mbuf_concat(struct os_mbuf *first, struct os_mbuf *second)
     second->om_pkthdr_len = 0;
 }
 
+/**
+ * Compacts an mbuf chain in place: the data of each buffer is moved forward
+ * into the free space of the buffer before it, and buffers that end up
+ * empty are freed.  The head keeps its leading space, so the chain can still
+ * be prepended to; the leading space of the other buffers is reclaimed.
+ * External mbufs are left as they are, as are their neighbours' contents
+ * across them.  The packet length does not change.
+ *
+ * @param om                    The head of the chain to compact.
+ *
+ * @return                      The number of mbufs freed.
+ */
+int
+os_mbuf_compact(struct os_mbuf *om)
+{
+    struct os_mbuf *next;
+    struct os_mbuf *cur;
+    uint8_t *start;
+    uint16_t space;
+    uint16_t len;
+    int freed;
+
+    freed = 0;
+    for (cur = om; cur != NULL; cur = SLIST_NEXT(cur, om_next)) {
+        if (OS_MBUF_IS_EXT(cur)) {
+            continue;
+        }
+
+        if (cur != om) {
+            start = cur->om_databuf + cur->om_pkthdr_len;
+            if (cur->om_data != start) {
+                memmove(start, cur->om_data, cur->om_len);
+                cur->om_data = start;
+            }
+        }
+
+        while (1) {
+            next = SLIST_NEXT(cur, om_next);
+            if (next == NULL || OS_MBUF_IS_EXT(next)) {
+                break;
+            }
+
+            if (next->om_len != 0) {
+                space = OS_MBUF_TRAILINGSPACE(cur);
+                if (space == 0) {
+                    break;
+                }
+
+                len = min(space, next->om_len);
+                memcpy(cur->om_data + cur->om_len, next->om_data, len);
+                cur->om_len += len;
+                next->om_data += len;
+                next->om_len -= len;
+                if (next->om_len != 0) {
+                    break;
+                }
+            }
+
+            SLIST_NEXT(cur, om_next) = SLIST_NEXT(next, om_next);
+            os_mbuf_free(next);
+            freed++;
+        }
+    }
+
+    return freed;
+}
+
+/**
+ * Counts the free bytes inside an mbuf chain that os_mbuf_compact() could
+ * reclaim: the trailing space of every buffer but the last, and the leading
+ * space of every buffer but the head.  External mbufs have neither.
+ *
+ * @param om                    The head of the chain to inspect.
+ *
+ * @return                      The number of wasted bytes.
+ */
+int
+os_mbuf_waste(const struct os_mbuf *om)
+{
+    const struct os_mbuf *cur;
+    int waste;
+
+    waste = 0;
+    for (cur = om; cur != NULL; cur = SLIST_NEXT(cur, om_next)) {
+        if (OS_MBUF_IS_EXT(cur)) {
+            continue;
+        }
+        if (cur != om) {
+            waste += OS_MBUF_LEADINGSPACE((struct os_mbuf *)cur);
+        }
+        if (SLIST_NEXT(cur, om_next) != NULL) {
+            waste += OS_MBUF_TRAILINGSPACE((struct os_mbuf *)cur);
+        }
+    }
+
+    return waste;
+}
+
+/**
+ * Compacts an mbuf chain if that would free at least one buffer's worth of
+ * space.  Intended for chains that are about to be held for a long time,
+ * such as queued packets.
+ *
+ * @param om                    The head of the chain to compact.
+ *
+ * @return                      The number of mbufs freed.
+ */
+int
+os_mbuf_compact_wasteful(struct os_mbuf *om)
+{
+    if (om == NULL || OS_MBUF_IS_EXT(om) ||
+        os_mbuf_waste(om) < om->om_omp->omp_databuf_len) {
+
+        return 0;
+    }
+
+    return os_mbuf_compact(om);
+}
+
+/**
+ * Attaches the second mbuf chain onto the end of the first and compacts the
+ * result.  Either chain may be NULL.
+ *
+ * @param m1                    The chain being attached to.
+ * @param m2                    The chain that gets attached.
+ *
+ * @return                      The head of the packed chain.
+ */
+struct os_mbuf *
+os_mbuf_pack_chains(struct os_mbuf *m1, struct os_mbuf *m2)
+{
+    if (m1 == NULL) {
+        m1 = m2;
+    } else if (m2 != NULL) {
+        os_mbuf_concat(m1, m2);
+    }
+
+    if (m1 != NULL) {
+        os_mbuf_compact(m1);
+    }
+
+    return m1;
+}
+
 /**
  * Increases the length of an mbuf chain by the specified amount.  If there is
  * not sufficient room in the last buffer, a new buffer is allocated and
@@ -17,6 +17,7 @@
  * under the License.
  */
 
+#include "syscfg/syscfg.h"
 #include "os/os.h"
 
 #include <string.h>
@@ -31,6 +32,33 @@
 
 #define OS_MEMPOOL_TRUE_BLOCK_SIZE(bsize)   OS_ALIGN(bsize, OS_ALIGNMENT)
 
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+#ifndef OS_ARCH_HAS_EXCLUSIVE
+#error "OS_MEMPOOL_LOCKFREE requires exclusive load / store support"
+#endif
+
+#define OS_MEMPOOL_HEAD(mp) ((volatile uint32_t *)&SLIST_FIRST(mp))
+
+/*
+ * Atomically adds 'delta' to a pool counter and returns the new value.  The
+ * counters are only informational in lock-free mode; the free list head is
+ * authoritative.
+ */
+static uint32_t
+os_mempool_atomic_add(void *counter, int delta)
+{
+    volatile uint32_t *addr;
+    uint32_t val;
+
+    addr = counter;
+    do {
+        val = os_arch_ldrex(addr) + delta;
+    } while (os_arch_strex(addr, val) != 0);
+
+    return val;
+}
+#endif
+
 STAILQ_HEAD(, os_mempool) g_os_mempool_list =
     STAILQ_HEAD_INITIALIZER(g_os_mempool_list);
 
@@ -77,6 +105,8 @@ os_mempool_init(struct os_mempool *mp, int blocks, int block_size,
     /* Initialize the memory pool structure */
     mp->mp_block_size = block_size;
     mp->mp_num_free = blocks;
+    mp->mp_min_free = blocks;
+    mp->mp_num_fail = 0;
     mp->mp_num_blocks = blocks;
     mp->mp_membuf_addr = (uint32_t)membuf;
     mp->name = name;
@@ -148,6 +178,39 @@ os_memblock_from(struct os_mempool *mp, void *block_addr)
 void *
 os_memblock_get(struct os_mempool *mp)
 {
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+    struct os_memblock *block;
+    struct os_memblock *next;
+    int num_free;
+
+    if (mp == NULL) {
+        return NULL;
+    }
+
+    /*
+     * Pop the head of the free list.  The store fails if anything else ran
+     * since the load (including an ISR that took and returned the same
+     * block), so the 'next' pointer read here can never be stale.
+     */
+    do {
+        block = (struct os_memblock *)os_arch_ldrex(OS_MEMPOOL_HEAD(mp));
+        if (block == NULL) {
+            os_arch_clrex();
+            os_mempool_atomic_add(&mp->mp_num_fail, 1);
+            OS_TRACE(OS_TRACE_ID_MEMPOOL_EMPTY, 0, mp);
+            return NULL;
+        }
+        next = SLIST_NEXT(block, mb_next);
+    } while (os_arch_strex(OS_MEMPOOL_HEAD(mp), (uint32_t)next) != 0);
+
+    /* The low-water mark may lag a concurrent update; that is harmless. */
+    num_free = os_mempool_atomic_add(&mp->mp_num_free, -1);
+    if (num_free < mp->mp_min_free) {
+        mp->mp_min_free = num_free;
+    }
+
+    return (void *)block;
+#else
     os_sr_t sr;
     struct os_memblock *block;
 
@@ -165,11 +228,21 @@ os_memblock_get(struct os_mempool *mp)
 
             /* Decrement number free by 1 */
             mp->mp_num_free--;
+            if (mp->mp_num_free < mp->mp_min_free) {
+                mp->mp_min_free = mp->mp_num_free;
+            }
+        } else {
+            mp->mp_num_fail++;
         }
         OS_EXIT_CRITICAL(sr);
+
+        if (block == NULL) {
+            OS_TRACE(OS_TRACE_ID_MEMPOOL_EMPTY, 0, mp);
+        }
     }
 
     return (void *)block;
+#endif
 }
 
 /**
@@ -185,7 +258,9 @@ os_memblock_get(struct os_mempool *mp)
 os_error_t
 os_memblock_put(struct os_mempool *mp, void *block_addr)
 {
+#if !MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
     os_sr_t sr;
+#endif
     struct os_memblock *block;
 
     /* Make sure parameters are valid */
@@ -199,6 +274,16 @@ os_memblock_put(struct os_mempool *mp, void *block_addr)
     }
 
     block = (struct os_memblock *)block_addr;
+
+#if MYNEWT_VAL(OS_MEMPOOL_LOCKFREE)
+    /* Push the block onto the head of the free list. */
+    do {
+        SLIST_NEXT(block, mb_next) =
+            (struct os_memblock *)os_arch_ldrex(OS_MEMPOOL_HEAD(mp));
+    } while (os_arch_strex(OS_MEMPOOL_HEAD(mp), (uint32_t)block) != 0);
+
+    os_mempool_atomic_add(&mp->mp_num_free, 1);
+#else
     OS_ENTER_CRITICAL(sr);
 
     /* Chain current free list pointer to this block; make this block head */
@@ -210,6 +295,7 @@ os_memblock_put(struct os_mempool *mp, void *block_addr)
     mp->mp_num_free++;
 
     OS_EXIT_CRITICAL(sr);
+#endif
 
     return OS_OK;
 }
@@ -233,11 +319,44 @@ os_mempool_info_get_next(struct os_mempool *mp, struct os_mempool_info *omi)
     omi->omi_block_size = cur->mp_block_size;
     omi->omi_num_blocks = cur->mp_num_blocks;
     omi->omi_num_free = cur->mp_num_free;
+    omi->omi_min_free = cur->mp_min_free;
+    omi->omi_num_fail = cur->mp_num_fail;
+    omi->omi_mem_bytes = cur->mp_num_blocks *
+        OS_MEMPOOL_TRUE_BLOCK_SIZE(cur->mp_block_size);
     strncpy(omi->omi_name, cur->name, sizeof(omi->omi_name));
 
     return (cur);
 }
 
+#if MYNEWT_VAL(OS_MSYS_ADVISE)
+/**
+ * Recommends a block count for a memory pool: the most blocks the pool has
+ * had in use at once, plus OS_MEMPOOL_ADVISE_HEADROOM percent.  A pool that
+ * has run out only tells that it needed more blocks than it has; it is
+ * recommended half as many again, plus the headroom.
+ *
+ * @param mp The memory pool
+ *
+ * @return The recommended number of blocks; 0 if the pool was never used.
+ */
+int
+os_mempool_advise(const struct os_mempool *mp)
+{
+    int used;
+
+    if (mp->mp_num_fail > 0) {
+        used = mp->mp_num_blocks + (mp->mp_num_blocks + 1) / 2;
+    } else {
+        used = mp->mp_num_blocks - mp->mp_min_free;
+    }
+    if (used == 0) {
+        return 0;
+    }
+
+    return used + (used * MYNEWT_VAL(OS_MEMPOOL_ADVISE_HEADROOM) + 99) / 100;
+}
+#endif
+
 
 /**
  *   @} OSMempool
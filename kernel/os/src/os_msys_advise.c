@@ -0,0 +1,267 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(OS_MSYS_ADVISE)
+
+#include <string.h>
+
+#include "os/os.h"
+#include "os_priv.h"
+
+/* Largest request, in bytes, counted in a demand class */
+#define OS_MSYS_CLASS_MAX(cls)      (16UL << (cls))
+
+static struct os_msys_demand os_msys_demand;
+
+/*
+ * Counts an os_msys_get() request.  Counters are bumped without a critical
+ * section; the odd count lost to a race does not change the advice.
+ */
+void
+os_msys_demand_add(uint16_t dsize)
+{
+    int cls;
+
+    for (cls = 0; cls < OS_MSYS_DEMAND_CLASSES - 1; cls++) {
+        if (dsize <= OS_MSYS_CLASS_MAX(cls)) {
+            break;
+        }
+    }
+    os_msys_demand.omd_reqs[cls]++;
+}
+
+void
+os_msys_demand_fail(void)
+{
+    os_msys_demand.omd_num_fail++;
+}
+
+/**
+ * Reads the msys demand counters.
+ *
+ * @param omd The counters get copied here
+ */
+void
+os_msys_demand_get(struct os_msys_demand *omd)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    *omd = os_msys_demand;
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * Clears the msys demand counters, e.g. after the pools have been resized.
+ */
+void
+os_msys_demand_clear(void)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    memset(&os_msys_demand, 0, sizeof(os_msys_demand));
+    OS_EXIT_CRITICAL(sr);
+}
+
+static void
+os_msys_advice_add(struct os_msys_advice *oma, uint32_t databuf_len,
+                   int count)
+{
+    struct os_msys_advice_pool *ap;
+
+    ap = &oma->oma_pools[oma->oma_num_pools++];
+    ap->omap_block_size = databuf_len + sizeof(struct os_mbuf);
+    ap->omap_block_count = count;
+}
+
+static uint32_t
+os_msys_advice_bytes(const struct os_msys_advice *oma)
+{
+    const struct os_msys_advice_pool *ap;
+    uint32_t bytes;
+    int i;
+
+    bytes = 0;
+    for (i = 0; i < oma->oma_num_pools; i++) {
+        ap = &oma->oma_pools[i];
+        bytes += ap->omap_block_count *
+                 OS_ALIGN(ap->omap_block_size, OS_ALIGNMENT);
+    }
+    return bytes;
+}
+
+/*
+ * Fits a layout to a budget: scales all block counts down in proportion,
+ * then takes blocks off the pool with the most until it fits.  Every pool
+ * keeps at least one block, so a budget that is too small is exceeded.
+ */
+static void
+os_msys_advice_fit(struct os_msys_advice *oma, uint32_t budget)
+{
+    struct os_msys_advice_pool *most;
+    struct os_msys_advice_pool *ap;
+    uint32_t bytes;
+    int i;
+
+    bytes = os_msys_advice_bytes(oma);
+    if (bytes <= budget) {
+        return;
+    }
+
+    for (i = 0; i < oma->oma_num_pools; i++) {
+        ap = &oma->oma_pools[i];
+        ap->omap_block_count = (uint64_t)ap->omap_block_count * budget / bytes;
+        if (ap->omap_block_count == 0) {
+            ap->omap_block_count = 1;
+        }
+    }
+
+    while (os_msys_advice_bytes(oma) > budget) {
+        most = NULL;
+        for (i = 0; i < oma->oma_num_pools; i++) {
+            ap = &oma->oma_pools[i];
+            if (ap->omap_block_count > 1 &&
+                (most == NULL ||
+                 ap->omap_block_count > most->omap_block_count)) {
+
+                most = ap;
+            }
+        }
+        if (most == NULL) {
+            break;
+        }
+        most->omap_block_count--;
+    }
+}
+
+/**
+ * Recommends a layout for the msys pools, from the pools' usage and the
+ * sizes of the requests made to msys.
+ *
+ * Each registered pool is recommended os_mempool_advise() blocks.  If
+ * OS_MSYS_ADVISE_SPLIT_PCT percent or more of the requests a pool is the
+ * best fit for would fit in blocks half its size, and there is a pool to
+ * spare, a pool of the smallest class size covering that share is split off
+ * and given a share of the blocks in proportion to its requests.  Pools
+ * that were never used are left out.  Last, block counts are scaled down
+ * until the layout fits the budget.
+ *
+ * Block sizes include the mbuf header, like MSYS_<n>_BLOCK_SIZE.
+ *
+ * @param budget RAM for the msys pools, in bytes; 0 for no limit.
+ * @param oma    The recommended layout, smallest blocks first.
+ *
+ * @return 0 on success; OS_ENOENT if there are no msys pools.
+ */
+int
+os_msys_advise(uint32_t budget, struct os_msys_advice *oma)
+{
+    struct os_msys_demand omd;
+    struct os_mbuf_pool *omp;
+    uint32_t small_reqs;
+    uint32_t pool_reqs;
+    int pools_left;
+    int small_cnt;
+    int split_cls;
+    int first_cls;
+    int need;
+    int cls;
+    int i;
+
+    memset(oma, 0, sizeof(*oma));
+    os_msys_demand_get(&omd);
+
+    pools_left = 0;
+    STAILQ_FOREACH(omp, &g_msys_pool_list, omp_next) {
+        pools_left++;
+    }
+    if (pools_left == 0) {
+        return OS_ENOENT;
+    }
+
+    cls = 0;
+    STAILQ_FOREACH(omp, &g_msys_pool_list, omp_next) {
+        pools_left--;
+        if (oma->oma_num_pools == OS_MSYS_ADVICE_MAX_POOLS) {
+            break;
+        }
+
+        /*
+         * The classes this pool is the best fit for.  The largest pool also
+         * serves all larger requests, in chains of blocks.
+         */
+        first_cls = cls;
+        pool_reqs = 0;
+        for (; cls < OS_MSYS_DEMAND_CLASSES; cls++) {
+            if (pools_left > 0 &&
+                OS_MSYS_CLASS_MAX(cls) > omp->omp_databuf_len) {
+                break;
+            }
+            pool_reqs += omd.omd_reqs[cls];
+        }
+
+        need = os_mempool_advise(omp->omp_pool);
+        if (need == 0) {
+            continue;
+        }
+
+        split_cls = -1;
+        small_reqs = 0;
+        if (need > 1 && pool_reqs > 0 &&
+            oma->oma_num_pools + pools_left + 2 <= OS_MSYS_ADVICE_MAX_POOLS) {
+
+            for (i = first_cls; i < cls; i++) {
+                if (OS_MSYS_CLASS_MAX(i) > omp->omp_databuf_len / 2) {
+                    break;
+                }
+                small_reqs += omd.omd_reqs[i];
+                if ((uint64_t)small_reqs * 100 >=
+                    (uint64_t)pool_reqs * MYNEWT_VAL(OS_MSYS_ADVISE_SPLIT_PCT)) {
+
+                    split_cls = i;
+                    break;
+                }
+            }
+        }
+
+        if (split_cls >= 0) {
+            small_cnt = ((uint64_t)need * small_reqs + pool_reqs - 1) /
+                        pool_reqs;
+            if (small_cnt >= need) {
+                small_cnt = need - 1;
+            }
+            os_msys_advice_add(oma, OS_MSYS_CLASS_MAX(split_cls), small_cnt);
+            need -= small_cnt;
+        }
+        os_msys_advice_add(oma, omp->omp_databuf_len, need);
+    }
+
+    oma->oma_need_bytes = os_msys_advice_bytes(oma);
+    if (budget != 0) {
+        os_msys_advice_fit(oma, budget);
+    }
+    oma->oma_bytes = os_msys_advice_bytes(oma);
+
+    return 0;
+}
+
+#endif
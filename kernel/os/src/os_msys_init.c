@@ -24,13 +24,19 @@
 #include "mem/mem.h"
 #include "os_priv.h"
 
+#if MYNEWT_VAL(OS_MSYS_CCM)
+#define OS_MSYS_SECTION OS_CCM_BSS
+#else
+#define OS_MSYS_SECTION
+#endif
+
 #if MYNEWT_VAL(MSYS_1_BLOCK_COUNT) > 0
 #define SYSINIT_MSYS_1_MEMBLOCK_SIZE                \
     OS_ALIGN(MYNEWT_VAL(MSYS_1_BLOCK_SIZE), 4)
 #define SYSINIT_MSYS_1_MEMPOOL_SIZE                 \
     OS_MEMPOOL_SIZE(MYNEWT_VAL(MSYS_1_BLOCK_COUNT),  \
                     SYSINIT_MSYS_1_MEMBLOCK_SIZE)
-static os_membuf_t os_msys_init_1_data[SYSINIT_MSYS_1_MEMPOOL_SIZE];
+static OS_MSYS_SECTION os_membuf_t os_msys_init_1_data[SYSINIT_MSYS_1_MEMPOOL_SIZE];
 static struct os_mbuf_pool os_msys_init_1_mbuf_pool;
 static struct os_mempool os_msys_init_1_mempool;
 #endif
@@ -41,7 +47,7 @@ static struct os_mempool os_msys_init_1_mempool;
 #define SYSINIT_MSYS_2_MEMPOOL_SIZE                 \
     OS_MEMPOOL_SIZE(MYNEWT_VAL(MSYS_2_BLOCK_COUNT),  \
                     SYSINIT_MSYS_2_MEMBLOCK_SIZE)
-static os_membuf_t os_msys_init_2_data[SYSINIT_MSYS_2_MEMPOOL_SIZE];
+static OS_MSYS_SECTION os_membuf_t os_msys_init_2_data[SYSINIT_MSYS_2_MEMPOOL_SIZE];
 static struct os_mbuf_pool os_msys_init_2_mbuf_pool;
 static struct os_mempool os_msys_init_2_mempool;
 #endif
@@ -52,7 +58,7 @@ static struct os_mempool os_msys_init_2_mempool;
 #define SYSINIT_MSYS_3_MEMPOOL_SIZE                 \
     OS_MEMPOOL_SIZE(MYNEWT_VAL(MSYS_3_BLOCK_COUNT),  \
                     SYSINIT_MSYS_3_MEMBLOCK_SIZE)
-static os_membuf_t os_msys_init_3_data[SYSINIT_MSYS_3_MEMPOOL_SIZE];
+static OS_MSYS_SECTION os_membuf_t os_msys_init_3_data[SYSINIT_MSYS_3_MEMPOOL_SIZE];
 static struct os_mbuf_pool os_msys_init_3_mbuf_pool;
 static struct os_mempool os_msys_init_3_mempool;
 #endif
@@ -63,7 +69,7 @@ static struct os_mempool os_msys_init_3_mempool;
 #define SYSINIT_MSYS_4_MEMPOOL_SIZE                 \
     OS_MEMPOOL_SIZE(MYNEWT_VAL(MSYS_4_BLOCK_COUNT),  \
                     SYSINIT_MSYS_4_MEMBLOCK_SIZE)
-static os_membuf_t os_msys_init_4_data[SYSINIT_MSYS_4_MEMPOOL_SIZE];
+static OS_MSYS_SECTION os_membuf_t os_msys_init_4_data[SYSINIT_MSYS_4_MEMPOOL_SIZE];
 static struct os_mbuf_pool os_msys_init_4_mbuf_pool;
 static struct os_mempool os_msys_init_4_mempool;
 #endif
@@ -75,7 +81,7 @@ static struct os_mempool os_msys_init_4_mempool;
     OS_MEMPOOL_SIZE(MYNEWT_VAL(MSYS_5_BLOCK_COUNT),  \
                     SYSINIT_MSYS_5_MEMBLOCK_SIZE)
 
-static os_membuf_t os_msys_init_5_data[SYSINIT_MSYS_5_MEMPOOL_SIZE];
+static OS_MSYS_SECTION os_membuf_t os_msys_init_5_data[SYSINIT_MSYS_5_MEMPOOL_SIZE];
 static struct os_mbuf_pool os_msys_init_5_mbuf_pool;
 static struct os_mempool os_msys_init_5_mempool;
 #endif
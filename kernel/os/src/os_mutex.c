@@ -20,6 +20,20 @@
 #include "os/os.h"
 #include <assert.h>
 
+#if MYNEWT_VAL(OS_MUTEX_LOCKFREE)
+#ifndef OS_ARCH_HAS_EXCLUSIVE
+#error "OS_MUTEX_LOCKFREE requires exclusive load / store support"
+#endif
+
+/*
+ * In lock-free mode the owner pointer is authoritative: a mutex is free iff
+ * mu_owner is NULL.  Uncontended pend / release swap it with exclusive
+ * load / store; any other state change happens in a critical section, which
+ * also clears the exclusive monitor on the core.
+ */
+#define OS_MUTEX_OWNER(mu)  ((volatile uint32_t *)&(mu)->mu_owner)
+#endif
+
 /**
  * @addtogroup OSKernel
  * @{
@@ -74,6 +88,9 @@ os_mutex_release(struct os_mutex *mu)
     os_sr_t sr;
     struct os_task *current;
     struct os_task *rdy;
+#if MYNEWT_VAL(OS_MUTEX_LOCKFREE)
+    int released = 0;
+#endif
 
     /* Check if OS is started */
     if (!g_os_started) {
@@ -97,12 +114,38 @@ os_mutex_release(struct os_mutex *mu)
         return (OS_OK);
     }
 
+#if MYNEWT_VAL(OS_MUTEX_LOCKFREE)
+    /*
+     * No waiters and no inherited priority: just clear the owner.  A task
+     * that queues itself on the mutex must run first, which makes the store
+     * fail, so the checks below cannot go stale.
+     */
+    do {
+        os_arch_ldrex(OS_MUTEX_OWNER(mu));
+        if (!SLIST_EMPTY(&mu->mu_head) || current->t_prio != mu->mu_prio) {
+            os_arch_clrex();
+            break;
+        }
+        released = (os_arch_strex(OS_MUTEX_OWNER(mu), 0) == 0);
+    } while (!released);
+
+    if (released) {
+        /* Only the running task changes its own lock count. */
+        if (--current->t_lockcnt == 0) {
+            current->t_flags &= ~OS_TASK_FLAG_LOCK_HELD;
+        }
+        return OS_OK;
+    }
+#endif
+
     OS_ENTER_CRITICAL(sr);
 
     /* Restore owner task's priority; resort list if different  */
+    resched = 0;
     if (current->t_prio != mu->mu_prio) {
         current->t_prio = mu->mu_prio;
         os_sched_resort(current);
+        resched = 1;
     }
 
     /* Check if tasks are waiting for the mutex */
@@ -127,11 +170,13 @@ os_mutex_release(struct os_mutex *mu)
         current->t_flags &= ~OS_TASK_FLAG_LOCK_HELD;
     }
 
-    /* Do we need to re-schedule? */
-    resched = 0;
-    rdy = os_sched_next_task();
-    if (rdy != current) {
-        resched = 1;
+    /*
+     * Do we need to re-schedule?  Releasing a mutex nobody waits on without
+     * dropping an inherited priority cannot make another task runnable.
+     */
+    if (resched || mu->mu_owner != NULL) {
+        rdy = os_sched_next_task();
+        resched = (rdy != current);
     }
     OS_EXIT_CRITICAL(sr);
 
@@ -167,6 +212,10 @@ os_mutex_pend(struct os_mutex *mu, uint32_t timeout)
     struct os_task *current;
     struct os_task *entry;
     struct os_task *last;
+#if MYNEWT_VAL(OS_MUTEX_LOCKFREE)
+    struct os_task *owner;
+    uint8_t prio;
+#endif
 
     /* OS must be started when calling this function */
     if (!g_os_started) {
@@ -178,11 +227,40 @@ os_mutex_pend(struct os_mutex *mu, uint32_t timeout)
         return OS_INVALID_PARM;
     }
 
+    current = os_sched_get_current_task();
+
+#if MYNEWT_VAL(OS_MUTEX_LOCKFREE)
+    /*
+     * Uncontended acquire.  The priority is sampled before taking ownership;
+     * once the owner is visible a waiter may boost it, and mu_prio must hold
+     * the priority to restore on release.
+     */
+    prio = current->t_prio;
+    do {
+        owner = (struct os_task *)os_arch_ldrex(OS_MUTEX_OWNER(mu));
+        if (owner != NULL) {
+            os_arch_clrex();
+            break;
+        }
+    } while (os_arch_strex(OS_MUTEX_OWNER(mu), (uint32_t)current) != 0);
+
+    if (owner == NULL) {
+        mu->mu_prio = prio;
+        mu->mu_level = 1;
+        current->t_lockcnt++;
+        current->t_flags |= OS_TASK_FLAG_LOCK_HELD;
+        return OS_OK;
+    }
+    if (owner == current) {
+        ++mu->mu_level;
+        return OS_OK;
+    }
+#endif
+
     OS_ENTER_CRITICAL(sr);
 
     /* Is this owned? */
-    current = os_sched_get_current_task();
-    if (mu->mu_level == 0) {
+    if (mu->mu_owner == NULL) {
         mu->mu_owner = current;
         mu->mu_prio  = current->t_prio;
         current->t_lockcnt++;
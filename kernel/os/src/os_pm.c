@@ -0,0 +1,169 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+
+#include "os/os.h"
+#include "hal/hal_os_tick.h"
+
+/**
+ * @addtogroup OSKernel
+ * @{
+ *   @defgroup OSPower Device Power Management
+ *   @{
+ */
+
+#if MYNEWT_VAL(OS_PM)
+/*
+ * os_pm_denied[s] is the number of active devices which can not work in
+ * sleep state s.
+ */
+static uint8_t os_pm_denied[OS_PM_STATE_CNT];
+static uint8_t os_pm_state;
+
+static const os_time_t os_pm_min_ticks[OS_PM_STATE_CNT] = {
+    [OS_PM_STATE_IDLE] = 0,
+    [OS_PM_STATE_SLEEP] = MYNEWT_VAL(OS_PM_SLEEP_MIN_TICKS),
+    [OS_PM_STATE_DEEP] = MYNEWT_VAL(OS_PM_DEEP_MIN_TICKS),
+};
+
+static uint32_t os_pm_ticks[OS_PM_STATE_CNT];
+static uint32_t os_pm_entries[OS_PM_STATE_CNT];
+
+static void
+os_pm_deny(int from_state, int delta)
+{
+    int s;
+
+    for (s = from_state; s < OS_PM_STATE_CNT; s++) {
+        os_pm_denied[s] += delta;
+    }
+}
+
+int
+os_pm_dev_active(struct os_dev *dev)
+{
+    os_sr_t sr;
+    int rc;
+
+    rc = OS_OK;
+    OS_ENTER_CRITICAL(sr);
+    if (dev->od_pm_active == UINT8_MAX) {
+        rc = OS_EINVAL;
+    } else if (dev->od_pm_active++ == 0) {
+        os_pm_deny(dev->od_pm_max_state + 1, 1);
+        if (dev->od_handlers.od_clock) {
+            dev->od_handlers.od_clock(dev, 1);
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+    return rc;
+}
+
+int
+os_pm_dev_idle(struct os_dev *dev)
+{
+    os_sr_t sr;
+    int rc;
+
+    rc = OS_OK;
+    OS_ENTER_CRITICAL(sr);
+    if (dev->od_pm_active == 0) {
+        rc = OS_EINVAL;
+    } else if (--dev->od_pm_active == 0) {
+        os_pm_deny(dev->od_pm_max_state + 1, -1);
+        if (dev->od_handlers.od_clock) {
+            dev->od_handlers.od_clock(dev, 0);
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+    return rc;
+}
+
+int
+os_pm_dev_max_state(struct os_dev *dev, int state)
+{
+    os_sr_t sr;
+
+    if (state < OS_PM_STATE_IDLE || state >= OS_PM_STATE_CNT) {
+        return OS_EINVAL;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    if (dev->od_pm_active) {
+        os_pm_deny(dev->od_pm_max_state + 1, -1);
+        os_pm_deny(state + 1, 1);
+    }
+    dev->od_pm_max_state = state;
+    OS_EXIT_CRITICAL(sr);
+    return OS_OK;
+}
+
+int
+os_pm_idle_state(void)
+{
+    return os_pm_state;
+}
+
+void
+os_pm_idle(os_time_t ticks)
+{
+    os_time_t start;
+    int state;
+
+    OS_ASSERT_CRITICAL();
+
+    for (state = OS_PM_STATE_DEEP; state > OS_PM_STATE_IDLE; state--) {
+        if (!os_pm_denied[state] && ticks >= os_pm_min_ticks[state]) {
+            break;
+        }
+    }
+
+    os_pm_state = state;
+    start = os_time_get();
+    os_tick_idle(ticks);
+    os_pm_ticks[state] += os_time_get() - start;
+    os_pm_entries[state]++;
+    os_pm_state = OS_PM_STATE_IDLE;
+}
+
+int
+os_pm_residency(int state, uint32_t *ticks, uint32_t *entries)
+{
+    os_sr_t sr;
+
+    if (state < 0 || state >= OS_PM_STATE_CNT) {
+        return OS_EINVAL;
+    }
+    OS_ENTER_CRITICAL(sr);
+    if (ticks) {
+        *ticks = os_pm_ticks[state];
+    }
+    if (entries) {
+        *entries = os_pm_entries[state];
+    }
+    OS_EXIT_CRITICAL(sr);
+    return OS_OK;
+}
+#endif
+
+/**
+ *   @} OSPower
+ * @} OSKernel
+ */
@@ -21,6 +21,7 @@
 #define H_OS_PRIV_
 
 #include "os/queue.h"
+#include "syscfg/syscfg.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -35,9 +36,35 @@ extern struct os_task_list g_os_run_list;
 extern struct os_task_list g_os_sleep_list;
 extern struct os_task_stailq g_os_task_list;
 extern struct os_task *g_current_task;
+
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+struct os_callout_wheel {
+    struct os_callout_list cw_slots[MYNEWT_VAL(OS_CALLOUT_WHEEL_SIZE)];
+    /* Lower bound on the expiry time of every armed callout. */
+    os_time_t cw_next;
+    uint32_t cw_count;
+};
+
+extern struct os_callout_wheel g_callout_wheel;
+#else
 extern struct os_callout_list g_callout_list;
+#endif
+
+void os_callout_list_init(void);
+void os_sched_run_list_init(void);
+
+STAILQ_HEAD(os_msys_pool_list, os_mbuf_pool);
+extern struct os_msys_pool_list g_msys_pool_list;
 
 void os_msys_init(void);
+#if MYNEWT_VAL(OS_MSYS_ADVISE)
+void os_msys_demand_add(uint16_t dsize);
+void os_msys_demand_fail(void);
+#endif
+
+#if MYNEWT_VAL(OS_WORK)
+void os_work_task_init(void);
+#endif
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,407 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "os/os.h"
+#include <assert.h>
+
+/**
+ * @addtogroup OSKernel
+ * @{
+ *   @defgroup OSRwlock Reader/Writer Locks
+ *   @{
+ */
+
+/*
+ * Hand the lock to waiting tasks if it can be granted: to the first waiter
+ * if it wants to write and the lock is free, otherwise to every reader ahead
+ * of the first waiting writer.  Must be called with interrupts disabled.
+ *
+ * @return The highest priority task woken up, or NULL if none was.
+ */
+static struct os_task *
+os_rwlock_grant(struct os_rwlock *rwl)
+{
+    struct os_task *first;
+    struct os_task *rdy;
+
+    first = NULL;
+    if (rwl->rwl_writer) {
+        return (NULL);
+    }
+
+    while ((rdy = SLIST_FIRST(&rwl->rwl_head)) != NULL) {
+        if (rdy->t_flags & OS_TASK_FLAG_RWLOCK_WRITE) {
+            if (rwl->rwl_readers != 0) {
+                break;
+            }
+            rwl->rwl_writer = rdy;
+            rwl->rwl_prio = rdy->t_prio;
+        } else {
+            rwl->rwl_readers++;
+        }
+
+        rdy->t_flags &= ~(OS_TASK_FLAG_RWLOCK_WAIT | OS_TASK_FLAG_RWLOCK_WRITE);
+        rdy->t_lockcnt++;
+        rdy->t_flags |= OS_TASK_FLAG_LOCK_HELD;
+        os_sched_wakeup(rdy);
+
+        if (!first) {
+            first = rdy;
+        }
+        if (rwl->rwl_writer) {
+            break;
+        }
+    }
+
+    return (first);
+}
+
+/*
+ * Put the current task to sleep on the lock's wait list, in priority order.
+ * If the lock is held for writing, the writer inherits the task's priority.
+ * Must be called with interrupts disabled.
+ */
+static void
+os_rwlock_sleep(struct os_rwlock *rwl, struct os_task *current,
+                uint8_t flags, uint32_t timeout)
+{
+    struct os_task *entry;
+    struct os_task *last;
+
+    /* Change priority of writer if needed */
+    if (rwl->rwl_writer && rwl->rwl_writer->t_prio > current->t_prio) {
+        rwl->rwl_writer->t_prio = current->t_prio;
+        os_sched_resort(rwl->rwl_writer);
+    }
+
+    /* Link current task to tasks waiting for the lock */
+    last = NULL;
+    SLIST_FOREACH(entry, &rwl->rwl_head, t_obj_list) {
+        if (current->t_prio < entry->t_prio) {
+            break;
+        }
+        last = entry;
+    }
+
+    if (last) {
+        SLIST_INSERT_AFTER(last, current, t_obj_list);
+    } else {
+        SLIST_INSERT_HEAD(&rwl->rwl_head, current, t_obj_list);
+    }
+
+    current->t_obj = rwl;
+    current->t_flags |= OS_TASK_FLAG_RWLOCK_WAIT | flags;
+    os_sched_sleep(current, timeout);
+}
+
+/*
+ * Called by a task after it has slept on the lock.
+ *
+ * @return OS_OK if the lock was granted, OS_TIMEOUT otherwise.
+ */
+static os_error_t
+os_rwlock_wait_done(struct os_rwlock *rwl, struct os_task *current)
+{
+    struct os_task *rdy;
+    os_error_t rc;
+    os_sr_t sr;
+
+    rdy = NULL;
+    rc = OS_OK;
+
+    OS_ENTER_CRITICAL(sr);
+    if (current->t_flags & OS_TASK_FLAG_RWLOCK_WAIT) {
+        current->t_flags &= ~(OS_TASK_FLAG_RWLOCK_WAIT |
+                              OS_TASK_FLAG_RWLOCK_WRITE);
+        rc = OS_TIMEOUT;
+
+        /* A writer giving up may have been holding back readers. */
+        rdy = os_rwlock_grant(rwl);
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (rdy && rdy->t_prio < current->t_prio) {
+        os_sched(NULL);
+    }
+
+    return (rc);
+}
+
+/**
+ * os rwlock init
+ *
+ * Initialize a reader/writer lock.
+ *
+ * @param rwl Pointer to the lock
+ *
+ * @return os_error_t
+ *      OS_INVALID_PARM     Lock passed in was NULL.
+ *      OS_OK               no error.
+ */
+os_error_t
+os_rwlock_init(struct os_rwlock *rwl)
+{
+    if (!rwl) {
+        return OS_INVALID_PARM;
+    }
+
+    rwl->rwl_prio = 0;
+    rwl->rwl_readers = 0;
+    rwl->rwl_writer = NULL;
+    SLIST_FIRST(&rwl->rwl_head) = NULL;
+
+    return OS_OK;
+}
+
+/**
+ * os rwlock read pend
+ *
+ * Pend (wait) for a read lock.  A read lock is granted while the lock is not
+ * held for writing, unless a writer of the same or higher priority is
+ * already waiting for it.
+ *
+ * @param rwl Pointer to the lock
+ * @param timeout Timeout, in os ticks. A timeout of 0 means do
+ *                not wait if not available. A timeout of
+ *                0xFFFFFFFF means wait forever.
+ *
+ * @return os_error_t
+ *      OS_INVALID_PARM     Lock passed in was NULL.
+ *      OS_TIMEOUT          Lock was not granted within the timeout.
+ *      OS_OK               no error.
+ */
+os_error_t
+os_rwlock_read_pend(struct os_rwlock *rwl, uint32_t timeout)
+{
+    struct os_task *current;
+    struct os_task *first;
+    os_sr_t sr;
+
+    /* OS must be started when calling this function */
+    if (!g_os_started) {
+        return (OS_NOT_STARTED);
+    }
+
+    if (!rwl) {
+        return OS_INVALID_PARM;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+
+    current = os_sched_get_current_task();
+    first = SLIST_FIRST(&rwl->rwl_head);
+    if (!rwl->rwl_writer && (!first || current->t_prio < first->t_prio)) {
+        rwl->rwl_readers++;
+        current->t_lockcnt++;
+        current->t_flags |= OS_TASK_FLAG_LOCK_HELD;
+        OS_EXIT_CRITICAL(sr);
+        return OS_OK;
+    }
+
+    if (timeout == 0) {
+        OS_EXIT_CRITICAL(sr);
+        return OS_TIMEOUT;
+    }
+
+    os_rwlock_sleep(rwl, current, 0, timeout);
+    OS_EXIT_CRITICAL(sr);
+
+    os_sched(NULL);
+
+    return os_rwlock_wait_done(rwl, current);
+}
+
+/**
+ * os rwlock read release
+ *
+ * Release a read lock.
+ *
+ * @param rwl Pointer to the lock
+ *
+ * @return os_error_t
+ *      OS_INVALID_PARM     Lock passed in was NULL.
+ *      OS_BAD_MUTEX        Lock was not held for reading.
+ *      OS_OK               No error
+ */
+os_error_t
+os_rwlock_read_release(struct os_rwlock *rwl)
+{
+    struct os_task *current;
+    struct os_task *rdy;
+    os_sr_t sr;
+
+    if (!g_os_started) {
+        return (OS_NOT_STARTED);
+    }
+
+    if (!rwl) {
+        return OS_INVALID_PARM;
+    }
+
+    current = os_sched_get_current_task();
+
+    OS_ENTER_CRITICAL(sr);
+    if (rwl->rwl_readers == 0) {
+        OS_EXIT_CRITICAL(sr);
+        return (OS_BAD_MUTEX);
+    }
+
+    rwl->rwl_readers--;
+    if (--current->t_lockcnt == 0) {
+        current->t_flags &= ~OS_TASK_FLAG_LOCK_HELD;
+    }
+    rdy = os_rwlock_grant(rwl);
+    OS_EXIT_CRITICAL(sr);
+
+    /* Re-schedule if needed */
+    if (rdy && rdy->t_prio < current->t_prio) {
+        os_sched(NULL);
+    }
+
+    return OS_OK;
+}
+
+/**
+ * os rwlock write pend
+ *
+ * Pend (wait) for the write lock.  While waiting, a task that holds the
+ * write lock runs at the waiting task's priority if it is higher.
+ *
+ * @param rwl Pointer to the lock
+ * @param timeout Timeout, in os ticks. A timeout of 0 means do
+ *                not wait if not available. A timeout of
+ *                0xFFFFFFFF means wait forever.
+ *
+ * @return os_error_t
+ *      OS_INVALID_PARM     Lock passed in was NULL, or is already held
+ *                          for writing by the calling task.
+ *      OS_TIMEOUT          Lock was not granted within the timeout.
+ *      OS_OK               no error.
+ */
+os_error_t
+os_rwlock_write_pend(struct os_rwlock *rwl, uint32_t timeout)
+{
+    struct os_task *current;
+    os_sr_t sr;
+
+    if (!g_os_started) {
+        return (OS_NOT_STARTED);
+    }
+
+    if (!rwl) {
+        return OS_INVALID_PARM;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+
+    current = os_sched_get_current_task();
+    if (!rwl->rwl_writer && rwl->rwl_readers == 0) {
+        rwl->rwl_writer = current;
+        rwl->rwl_prio = current->t_prio;
+        current->t_lockcnt++;
+        current->t_flags |= OS_TASK_FLAG_LOCK_HELD;
+        OS_EXIT_CRITICAL(sr);
+        return OS_OK;
+    }
+
+    if (rwl->rwl_writer == current) {
+        OS_EXIT_CRITICAL(sr);
+        return OS_INVALID_PARM;
+    }
+
+    if (timeout == 0) {
+        OS_EXIT_CRITICAL(sr);
+        return OS_TIMEOUT;
+    }
+
+    os_rwlock_sleep(rwl, current, OS_TASK_FLAG_RWLOCK_WRITE, timeout);
+    OS_EXIT_CRITICAL(sr);
+
+    os_sched(NULL);
+
+    return os_rwlock_wait_done(rwl, current);
+}
+
+/**
+ * os rwlock write release
+ *
+ * Release the write lock, and restore the priority the writer had when it
+ * was granted the lock.
+ *
+ * @param rwl Pointer to the lock
+ *
+ * @return os_error_t
+ *      OS_INVALID_PARM     Lock passed in was NULL.
+ *      OS_BAD_MUTEX        Lock was not held for writing by current task.
+ *      OS_OK               No error
+ */
+os_error_t
+os_rwlock_write_release(struct os_rwlock *rwl)
+{
+    struct os_task *current;
+    struct os_task *rdy;
+    int resched;
+    os_sr_t sr;
+
+    if (!g_os_started) {
+        return (OS_NOT_STARTED);
+    }
+
+    if (!rwl) {
+        return OS_INVALID_PARM;
+    }
+
+    current = os_sched_get_current_task();
+    if (rwl->rwl_writer != current) {
+        return (OS_BAD_MUTEX);
+    }
+
+    OS_ENTER_CRITICAL(sr);
+
+    /* Restore writer's priority; resort list if different */
+    if (current->t_prio != rwl->rwl_prio) {
+        current->t_prio = rwl->rwl_prio;
+        os_sched_resort(current);
+    }
+
+    rwl->rwl_writer = NULL;
+    if (--current->t_lockcnt == 0) {
+        current->t_flags &= ~OS_TASK_FLAG_LOCK_HELD;
+    }
+    os_rwlock_grant(rwl);
+
+    /* Do we need to re-schedule? */
+    resched = 0;
+    rdy = os_sched_next_task();
+    if (rdy != current) {
+        resched = 1;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (resched) {
+        os_sched(rdy);
+    }
+
+    return OS_OK;
+}
+
+/**
+ *   @} OSRwlock
+ * @} OSKernel
+ */
@@ -20,7 +20,9 @@
 #include <assert.h>
 #include <string.h>
 
+#include "syscfg/syscfg.h"
 #include "os/os.h"
+#include "os/os_cputime.h"
 
 /**
  * @addtogroup OSKernel
@@ -34,6 +36,14 @@ SLIST_HEAD(, os_sanity_check) g_os_sanity_check_list =
 
 struct os_mutex g_os_sanity_check_mu;
 
+#define OS_SANITY_ITVL_TICKS \
+    ((MYNEWT_VAL(SANITY_INTERVAL) * OS_TICKS_PER_SEC) / 1000)
+#define OS_SANITY_MAX_ITVL_TICKS \
+    ((MYNEWT_VAL(SANITY_MAX_INTERVAL) * OS_TICKS_PER_SEC) / 1000)
+
+/* Time between sanity runs, in OS ticks */
+static os_time_t os_sanity_itvl = OS_SANITY_ITVL_TICKS;
+
 /**
  * Initialize a sanity check
  *
@@ -194,29 +204,64 @@ void
 os_sanity_run(void)
 {
     struct os_sanity_check *sc;
+    int healthy;
     int rc;
+#if MYNEWT_VAL(SANITY_STATS)
+    uint32_t start;
+    uint32_t ticks;
+#endif
 
     rc = os_sanity_check_list_lock();
     if (rc != 0) {
         assert(0);
     }
 
+    healthy = 1;
     SLIST_FOREACH(sc, &g_os_sanity_check_list, sc_next) {
         rc = OS_OK;
 
         if (sc->sc_func) {
+#if MYNEWT_VAL(SANITY_STATS)
+            start = os_cputime_get32();
+            rc = sc->sc_func(sc, sc->sc_arg);
+            ticks = os_cputime_get32() - start;
+            sc->sc_num_runs++;
+            sc->sc_last_ticks = ticks;
+            sc->sc_total_ticks += ticks;
+            if (ticks > sc->sc_max_ticks) {
+                sc->sc_max_ticks = ticks;
+            }
+#else
             rc = sc->sc_func(sc, sc->sc_arg);
+#endif
             if (rc == OS_OK) {
                 sc->sc_checkin_last = os_time_get();
                 continue;
             }
+            healthy = 0;
         }
 
         if (OS_TIME_TICK_GT(os_time_get(),
                     sc->sc_checkin_last + sc->sc_checkin_itvl)) {
             assert(0);
         }
+        if (OS_TIME_TICK_GT(os_time_get(),
+                    sc->sc_checkin_last + sc->sc_checkin_itvl / 2)) {
+            healthy = 0;
+        }
+    }
+
+#if MYNEWT_VAL(SANITY_ADAPTIVE)
+    if (!healthy) {
+        os_sanity_itvl = OS_SANITY_ITVL_TICKS;
+    } else if (os_sanity_itvl < OS_SANITY_MAX_ITVL_TICKS / 2) {
+        os_sanity_itvl *= 2;
+    } else {
+        os_sanity_itvl = OS_SANITY_MAX_ITVL_TICKS;
     }
+#else
+    (void)healthy;
+#endif
 
     rc = os_sanity_check_list_unlock();
     if (rc != 0) {
@@ -224,6 +269,18 @@ os_sanity_run(void)
     }
 }
 
+/**
+ * Returns the time to wait before the next sanity run, in OS ticks.  This is
+ * SANITY_INTERVAL, unless SANITY_ADAPTIVE has backed it off.
+ *
+ * @return The sanity interval, in OS ticks.
+ */
+os_time_t
+os_sanity_itvl_get(void)
+{
+    return (os_sanity_itvl);
+}
+
 /**
  * Initialize the sanity task and mutex.
  *
@@ -234,6 +291,9 @@ os_sanity_init(void)
 {
     int rc;
 
+    SLIST_INIT(&g_os_sanity_check_list);
+    os_sanity_itvl = OS_SANITY_ITVL_TICKS;
+
     rc = os_mutex_init(&g_os_sanity_check_mu);
     if (rc != 0) {
         goto err;
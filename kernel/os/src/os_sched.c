@@ -17,10 +17,14 @@
  * under the License.
  */
 
+#include "syscfg/syscfg.h"
 #include "os/os.h"
 #include "os/queue.h"
+#include "os/os_cputime.h"
+#include "os_priv.h"
 
 #include <assert.h>
+#include <string.h>
 
 /**
  * @addtogroup OSKernel
@@ -29,15 +33,204 @@
  *   @{
  */
 
-TAILQ_HEAD(, os_task) g_os_run_list = TAILQ_HEAD_INITIALIZER(g_os_run_list);
+struct os_task_list g_os_run_list = TAILQ_HEAD_INITIALIZER(g_os_run_list);
 
-TAILQ_HEAD(, os_task) g_os_sleep_list = TAILQ_HEAD_INITIALIZER(g_os_sleep_list);
+struct os_task_list g_os_sleep_list = TAILQ_HEAD_INITIALIZER(g_os_sleep_list);
 
 struct os_task *g_current_task;
 
 extern os_time_t g_os_time;
 os_time_t g_os_last_ctx_sw_time;
 
+#if MYNEWT_VAL(OS_SCHED_BITMAP)
+#define OS_SCHED_PRIO_CNT   (256)
+#define OS_SCHED_MAP_WORDS  (OS_SCHED_PRIO_CNT / 32)
+
+/*
+ * The run list stays a single priority sorted TAILQ (the context switch code
+ * reads its head directly), but it is indexed by priority: a bit is set in
+ * the map for every priority that has a ready task, and the last ready task
+ * at that priority is remembered.  Tasks of one priority form a FIFO run on
+ * the list, so inserting is a push after the tail of the task's own priority,
+ * or after the tail of the nearest higher priority found with CLZ.
+ */
+static uint32_t os_sched_prio_map[OS_SCHED_MAP_WORDS];
+static struct os_task *os_sched_prio_tail[OS_SCHED_PRIO_CNT];
+
+/*
+ * Returns the last ready task with a priority higher (numerically lower)
+ * than 'prio', or NULL if there is none.
+ */
+static struct os_task *
+os_sched_prio_pred(uint8_t prio)
+{
+    uint32_t bits;
+    int word;
+
+    word = prio >> 5;
+    bits = os_sched_prio_map[word] & ((1UL << (prio & 31)) - 1);
+    while (!bits) {
+        if (--word < 0) {
+            return (NULL);
+        }
+        bits = os_sched_prio_map[word];
+    }
+
+    return (os_sched_prio_tail[(word << 5) + 31 - __builtin_clz(bits)]);
+}
+#endif
+
+void
+os_sched_run_list_init(void)
+{
+    TAILQ_INIT(&g_os_run_list);
+#if MYNEWT_VAL(OS_SCHED_BITMAP)
+    memset(os_sched_prio_map, 0, sizeof(os_sched_prio_map));
+    memset(os_sched_prio_tail, 0, sizeof(os_sched_prio_tail));
+#endif
+}
+
+/*
+ * Removes a task from the run list.  Must be called with interrupts disabled.
+ */
+static void
+os_sched_run_list_remove(struct os_task *t)
+{
+#if MYNEWT_VAL(OS_SCHED_BITMAP)
+    struct os_task *prev;
+    uint8_t prio;
+
+    prio = t->t_run_prio;
+    if (os_sched_prio_tail[prio] == t) {
+        prev = TAILQ_PREV(t, os_task_list, t_os_list);
+        if (prev != NULL && prev->t_run_prio == prio) {
+            os_sched_prio_tail[prio] = prev;
+        } else {
+            os_sched_prio_tail[prio] = NULL;
+            os_sched_prio_map[prio >> 5] &= ~(1UL << (prio & 31));
+        }
+    }
+#endif
+
+    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+}
+
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+/* All times are in os_cputime ticks. */
+static uint32_t os_prof_switch_time;    /* when the current task got the CPU */
+static uint32_t os_prof_isr_start;      /* when the outermost ISR was entered */
+static uint32_t os_prof_isr_slice;      /* ISR time since the last switch */
+static uint32_t os_prof_isr_total;
+static uint8_t os_prof_isr_nest;
+static uint32_t os_prof_win_start;
+static uint32_t os_prof_win_len;        /* length of the last full window */
+static uint32_t os_prof_win_ticks;
+
+/**
+ * Marks the start of an interrupt handler, so that the time spent in it is
+ * not billed to the interrupted task.  Must be called with interrupts
+ * disabled, or from a handler that cannot be preempted by another handler
+ * that also calls it.
+ */
+void
+os_prof_isr_enter(void)
+{
+    if (os_prof_isr_nest++ == 0) {
+        os_prof_isr_start = os_cputime_get32();
+    }
+}
+
+/**
+ * Marks the end of an interrupt handler started with os_prof_isr_enter().
+ */
+void
+os_prof_isr_exit(void)
+{
+    uint32_t delta;
+
+    assert(os_prof_isr_nest > 0);
+    if (--os_prof_isr_nest == 0) {
+        delta = os_cputime_get32() - os_prof_isr_start;
+        os_prof_isr_slice += delta;
+        os_prof_isr_total += delta;
+    }
+}
+
+/**
+ * Returns the total time spent in profiled interrupt handlers, in os_cputime
+ * ticks.
+ */
+uint32_t
+os_prof_isr_time(void)
+{
+    return (os_prof_isr_total);
+}
+
+/**
+ * Returns the share of the CPU, in percent, that a task used during the last
+ * complete profiling window.
+ */
+uint8_t
+os_prof_cpu_pct(const struct os_task *t)
+{
+    if (os_prof_win_len == 0) {
+        return (0);
+    }
+
+    return ((uint64_t)t->t_prof_win_run * 100 / os_prof_win_len);
+}
+
+/*
+ * Bills the time since the last context switch, less any ISR time, to the
+ * task being switched out, and rolls the CPU usage window when it expires.
+ * Called with interrupts disabled.
+ */
+static void
+os_prof_switch(struct os_task *cur)
+{
+    struct os_task *t;
+    uint32_t now;
+    uint32_t run;
+
+    now = os_cputime_get32();
+
+    if (os_prof_isr_nest > 0) {
+        /* Switching from an ISR; bill what has elapsed of it so far. */
+        os_prof_isr_slice += now - os_prof_isr_start;
+        os_prof_isr_total += now - os_prof_isr_start;
+        os_prof_isr_start = now;
+    }
+
+    run = now - os_prof_switch_time - os_prof_isr_slice;
+    cur->t_prof_run += run;
+    if (run > cur->t_prof_max_run) {
+        cur->t_prof_max_run = run;
+    }
+    if (cur->t_state == OS_TASK_READY) {
+        cur->t_prof_preempts++;
+    } else {
+        cur->t_prof_yields++;
+    }
+
+    os_prof_switch_time = now;
+    os_prof_isr_slice = 0;
+
+    if (os_prof_win_ticks == 0) {
+        os_prof_win_ticks = os_cputime_usecs_to_ticks(
+            MYNEWT_VAL(OS_TASK_PROFILE_WINDOW_MS) * 1000);
+        os_prof_win_start = now;
+    }
+    if (now - os_prof_win_start >= os_prof_win_ticks) {
+        STAILQ_FOREACH(t, &g_os_task_list, t_os_task_list) {
+            t->t_prof_win_run = t->t_prof_run - t->t_prof_win_base;
+            t->t_prof_win_base = t->t_prof_run;
+        }
+        os_prof_win_len = now - os_prof_win_start;
+        os_prof_win_start = now;
+    }
+}
+#endif
+
 /**
  * os sched insert
  *
@@ -63,6 +256,20 @@ os_sched_insert(struct os_task *t)
 
     entry = NULL;
     OS_ENTER_CRITICAL(sr);
+#if MYNEWT_VAL(OS_SCHED_BITMAP)
+    t->t_run_prio = t->t_prio;
+    entry = os_sched_prio_tail[t->t_prio];
+    if (!entry) {
+        entry = os_sched_prio_pred(t->t_prio);
+    }
+    if (entry) {
+        TAILQ_INSERT_AFTER(&g_os_run_list, entry, t, t_os_list);
+    } else {
+        TAILQ_INSERT_HEAD(&g_os_run_list, t, t_os_list);
+    }
+    os_sched_prio_tail[t->t_prio] = t;
+    os_sched_prio_map[t->t_prio >> 5] |= 1UL << (t->t_prio & 31);
+#else
     TAILQ_FOREACH(entry, &g_os_run_list, t_os_list) {
         if (t->t_prio < entry->t_prio) {
             break;
@@ -73,6 +280,7 @@ os_sched_insert(struct os_task *t)
     } else {
         TAILQ_INSERT_TAIL(&g_os_run_list, (struct os_task *) t, t_os_list);
     }
+#endif
     OS_EXIT_CRITICAL(sr);
 
     return (0);
@@ -80,7 +288,7 @@ err:
     return (rc);
 }
 
-void
+OS_RAMFUNC void
 os_sched_ctx_sw_hook(struct os_task *next_t)
 {
     if (g_current_task == next_t) {
@@ -90,6 +298,12 @@ os_sched_ctx_sw_hook(struct os_task *next_t)
     next_t->t_ctx_sw_cnt++;
     g_current_task->t_run_time += g_os_time - g_os_last_ctx_sw_time;
     g_os_last_ctx_sw_time = g_os_time;
+
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+    os_prof_switch(g_current_task);
+#endif
+
+    OS_TRACE(OS_TRACE_ID_TASK_SWITCH, next_t->t_taskid, next_t->t_prio);
 }
 
 
@@ -132,7 +346,7 @@ os_sched_set_current_task(struct os_task *t)
  *
  * @param next_t Task to run
  */
-void
+OS_RAMFUNC void
 os_sched(struct os_task *next_t)
 {
     os_sr_t sr;
@@ -170,7 +384,7 @@ os_sched_sleep(struct os_task *t, os_time_t nticks)
 
     entry = NULL;
 
-    TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+    os_sched_run_list_remove(t);
     t->t_state = OS_TASK_SLEEP;
     t->t_next_wakeup = os_time_get() + nticks;
     if (nticks == OS_TIMEOUT_NEVER) {
@@ -213,7 +427,7 @@ os_sched_suspend(struct os_task *t)
     if (t->t_state == OS_TASK_SLEEP) {
         TAILQ_REMOVE(&g_os_sleep_list, t, t_os_list);
     } else if (t->t_state == OS_TASK_READY) {
-        TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+        os_sched_run_list_remove(t);
     }
     t->t_state = OS_TASK_SUSPEND;
     t->t_next_wakeup = 0;
@@ -336,7 +550,7 @@ os_sched_wakeup_ticks(os_time_t now)
  *
  * @return struct os_task*
  */
-struct os_task *
+OS_RAMFUNC struct os_task *
 os_sched_next_task(void)
 {
     return (TAILQ_FIRST(&g_os_run_list));
@@ -359,7 +573,7 @@ void
 os_sched_resort(struct os_task *t)
 {
     if (t->t_state == OS_TASK_READY) {
-        TAILQ_REMOVE(&g_os_run_list, t, t_os_list);
+        os_sched_run_list_remove(t);
         os_sched_insert(t);
     }
 }
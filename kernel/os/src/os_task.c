@@ -35,6 +35,11 @@ uint8_t g_task_id;
 
 struct os_task_stailq g_os_task_list;
 
+#if MYNEWT_VAL(OS_STACK_SCAN)
+static struct os_task *os_task_stack_scan_next;
+static os_task_stack_alert_fn *os_task_stack_alert_cb;
+#endif
+
 static void
 _clear_stack(os_stack_t *stack_bottom, int size)
 {
@@ -202,6 +207,87 @@ os_task_suspend(struct os_task *t)
     return rc;
 }
 
+#if MYNEWT_VAL(OS_STACK_SCAN)
+/**
+ * Sets the function called when a task's stack headroom first drops below
+ * OS_STACK_ALERT_PCT percent of its stack.
+ *
+ * @param cb The function to call, or NULL to stop alerting.
+ */
+void
+os_task_stack_alert_set(os_task_stack_alert_fn *cb)
+{
+    os_task_stack_alert_cb = cb;
+}
+
+/*
+ * Records that 'used' words of the task's stack have been touched.
+ */
+static void
+os_task_stack_hwm_set(struct os_task *t, uint16_t used)
+{
+    uint16_t headroom;
+
+    t->t_stack_hwm = used;
+
+    headroom = t->t_stacksize - used;
+    if (MYNEWT_VAL(OS_STACK_ALERT_PCT) > 0 &&
+        !(t->t_flags & OS_TASK_FLAG_STACK_ALERT) &&
+        (uint32_t)headroom * 100 <
+          (uint32_t)t->t_stacksize * MYNEWT_VAL(OS_STACK_ALERT_PCT)) {
+        t->t_flags |= OS_TASK_FLAG_STACK_ALERT;
+        if (os_task_stack_alert_cb) {
+            os_task_stack_alert_cb(t, headroom);
+        }
+    }
+}
+
+/**
+ * Examines up to 'words' stack words, continuing where the previous call
+ * left off, and raises the high-water mark of the task being scanned when it
+ * finds a word that no longer holds OS_STACK_PATTERN.  Each task's stack is
+ * scanned upwards from the bottom to the current mark, and then the scan
+ * moves on to the next task.  Called from the idle task.
+ *
+ * @param words The maximum number of stack words to examine.
+ */
+void
+os_task_stack_scan(int words)
+{
+    struct os_task *t;
+    os_stack_t *bottom;
+    uint16_t limit;
+
+    while (words > 0) {
+        t = os_task_stack_scan_next;
+        if (t == NULL) {
+            t = STAILQ_FIRST(&g_os_task_list);
+            if (t == NULL) {
+                return;
+            }
+            os_task_stack_scan_next = t;
+        }
+
+        bottom = t->t_stacktop - t->t_stacksize;
+        limit = t->t_stacksize - t->t_stack_hwm;
+        while (t->t_stack_scan < limit && words > 0) {
+            if (bottom[t->t_stack_scan] != OS_STACK_PATTERN) {
+                os_task_stack_hwm_set(t, t->t_stacksize - t->t_stack_scan);
+                break;
+            }
+            t->t_stack_scan++;
+            words--;
+        }
+
+        if (words > 0) {
+            /* Reached the mark; start over on the next task's stack. */
+            t->t_stack_scan = 0;
+            os_task_stack_scan_next = STAILQ_NEXT(t, t_os_task_list);
+        }
+    }
+}
+#endif
+
 /**
  * Iterate through tasks, and return the following information about them:
  *
@@ -236,8 +322,10 @@ struct os_task *
 os_task_info_get_next(const struct os_task *prev, struct os_task_info *oti)
 {
     struct os_task *next;
+#if !MYNEWT_VAL(OS_STACK_SCAN)
     os_stack_t *top;
     os_stack_t *bottom;
+#endif
 
     if (prev != NULL) {
         next = STAILQ_NEXT(prev, t_os_task_list);
@@ -256,6 +344,10 @@ os_task_info_get_next(const struct os_task *prev, struct os_task_info *oti)
     oti->oti_taskid = next->t_taskid;
     oti->oti_state = next->t_state;
 
+#if MYNEWT_VAL(OS_STACK_SCAN)
+    /* The idle task keeps the mark up to date. */
+    oti->oti_stkusage = next->t_stack_hwm;
+#else
     top = next->t_stacktop;
     bottom = next->t_stacktop - next->t_stacksize;
     while (bottom < top) {
@@ -266,12 +358,20 @@ os_task_info_get_next(const struct os_task *prev, struct os_task_info *oti)
     }
 
     oti->oti_stkusage = (uint16_t) (next->t_stacktop - bottom);
+#endif
     oti->oti_stksize = next->t_stacksize;
     oti->oti_cswcnt = next->t_ctx_sw_cnt;
     oti->oti_runtime = next->t_run_time;
     oti->oti_last_checkin = next->t_sanity_check.sc_checkin_last;
     oti->oti_next_checkin = next->t_sanity_check.sc_checkin_last +
         next->t_sanity_check.sc_checkin_itvl;
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+    oti->oti_prof_run = next->t_prof_run;
+    oti->oti_prof_max_run = next->t_prof_max_run;
+    oti->oti_prof_preempts = next->t_prof_preempts;
+    oti->oti_prof_yields = next->t_prof_yields;
+    oti->oti_cpu_pct = os_prof_cpu_pct(next);
+#endif
     strncpy(oti->oti_name, next->t_name, sizeof(oti->oti_name));
 
     return (next);
@@ -35,6 +35,23 @@ CTASSERT(sizeof(os_time_t) == 4);
 
 os_time_t g_os_time;
 
+/* Number of ticks that went by without a tick interrupt */
+static uint32_t os_time_suppressed;
+
+/* Upper half of the 64-bit tick count; bumped when g_os_time wraps. */
+static uint32_t os_time_hi;
+
+/*
+ * 64-bit tick count at which the time of day was last set, and the time of
+ * day then, in microseconds.  Lets os_time_ticks64_to_utc() convert stamps
+ * taken before the time of day was set.
+ */
+static struct {
+    uint64_t ticks;
+    int64_t utc_usec;
+    uint8_t valid;
+} os_time_utc_anchor;
+
 /*
  * Time-of-day collateral.
  */
@@ -78,6 +95,9 @@ os_time_tick(int ticks)
     OS_ENTER_CRITICAL(sr);
     prev_os_time = g_os_time;
     g_os_time += ticks;
+    if (g_os_time < prev_os_time) {
+        os_time_hi++;
+    }
 
     /*
      * Update 'basetod' when 'g_os_time' crosses the 0x00000000 and
@@ -103,6 +123,11 @@ os_time_advance(int ticks)
     assert(ticks >= 0);
 
     if (ticks > 0) {
+        /*
+         * Tickless idle accounts for all the ticks it slept through in a
+         * single call; only one of them took a tick interrupt.
+         */
+        os_time_suppressed += ticks - 1;
         if (!os_started()) {
             g_os_time += ticks;
         } else {
@@ -114,6 +139,18 @@ os_time_advance(int ticks)
     }
 }
 
+/**
+ * Returns the number of OS ticks that have gone by without a tick interrupt
+ * because the idle task was in the tickless regime.
+ *
+ * @return Number of suppressed ticks
+ */
+uint32_t
+os_time_suppressed_ticks(void)
+{
+    return (os_time_suppressed);
+}
+
 /**
  * Puts the current task to sleep for the specified number of os ticks. There
  * is no delay if ticks is <= 0.
@@ -157,6 +194,11 @@ os_settimeofday(struct os_timeval *utctime, struct os_timezone *tz)
         os_deltatime(delta, &basetod.uptime, &basetod.uptime);
         basetod.utctime = *utctime;
         basetod.ostime += delta;
+
+        os_time_utc_anchor.ticks = (uint64_t)os_time_hi << 32 | g_os_time;
+        os_time_utc_anchor.utc_usec = utctime->tv_sec * 1000000 +
+                                      utctime->tv_usec;
+        os_time_utc_anchor.valid = 1;
     }
 
     if (tz != NULL) {
@@ -222,6 +264,80 @@ os_get_uptime_usec(void)
   return(tv.tv_sec * 1000000 + tv.tv_usec);
 }
 
+/**
+ * Gets the number of ticks since boot, extended to 64 bits so that it does
+ * not wrap.  Cheap enough to stamp every log or trace record with; the
+ * stamp is converted to a time with os_time_ticks64_to_usec() or
+ * os_time_ticks64_to_utc() when it is read.
+ *
+ * @return The 64-bit tick count
+ */
+uint64_t
+os_time_get64(void)
+{
+    os_sr_t sr;
+    uint64_t ticks;
+
+    OS_ENTER_CRITICAL(sr);
+    ticks = (uint64_t)os_time_hi << 32 | g_os_time;
+    OS_EXIT_CRITICAL(sr);
+
+    return ticks;
+}
+
+static int64_t
+os_time_ticks64_diff_usec(int64_t delta)
+{
+    return (delta / OS_TICKS_PER_SEC) * 1000000 +
+           (delta % OS_TICKS_PER_SEC) * OS_USEC_PER_TICK;
+}
+
+/**
+ * Converts a stamp from os_time_get64() to microseconds since boot.
+ *
+ * @param ticks The stamp
+ *
+ * @return Microseconds since boot
+ */
+int64_t
+os_time_ticks64_to_usec(uint64_t ticks)
+{
+    return os_time_ticks64_diff_usec(ticks);
+}
+
+/**
+ * Converts a stamp from os_time_get64() to UTC microseconds, using the
+ * time of day set most recently.  Stamps taken before the time of day was
+ * set convert too.
+ *
+ * @param ticks    The stamp
+ * @param out_usec On success, the UTC time in microseconds
+ *
+ * @return 0 on success; OS_ENOENT if the time of day has not been set.
+ */
+int
+os_time_ticks64_to_utc(uint64_t ticks, int64_t *out_usec)
+{
+    os_sr_t sr;
+    uint64_t anchor_ticks;
+    int64_t anchor_usec;
+    int valid;
+
+    OS_ENTER_CRITICAL(sr);
+    anchor_ticks = os_time_utc_anchor.ticks;
+    anchor_usec = os_time_utc_anchor.utc_usec;
+    valid = os_time_utc_anchor.valid;
+    OS_EXIT_CRITICAL(sr);
+
+    if (!valid) {
+        return OS_ENOENT;
+    }
+
+    *out_usec = anchor_usec +
+                os_time_ticks64_diff_usec((int64_t)(ticks - anchor_ticks));
+    return 0;
+}
+
 /**
  * Converts milliseconds to OS ticks.
  *
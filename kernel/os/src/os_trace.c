@@ -0,0 +1,176 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(OS_TRACE)
+
+#include <assert.h>
+#include <string.h>
+
+#include "os/os.h"
+#include "os/os_cputime.h"
+#include "os/os_trace.h"
+
+#define OS_TRACE_MASK   (MYNEWT_VAL(OS_TRACE_ENTRIES) - 1)
+
+#if (MYNEWT_VAL(OS_TRACE_ENTRIES) & OS_TRACE_MASK) != 0
+#error "OS_TRACE_ENTRIES must be a power of two"
+#endif
+
+static struct os_trace_rec os_trace_ring[MYNEWT_VAL(OS_TRACE_ENTRIES)];
+static uint32_t os_trace_head;          /* Next slot to write. */
+static uint32_t os_trace_tail;          /* Next slot to read. */
+static uint32_t os_trace_dropped;       /* Not yet reported. */
+static uint8_t os_trace_isr_nest;
+static uint8_t os_trace_on = MYNEWT_VAL(OS_TRACE_START);
+
+/* Called with interrupts disabled and a free slot available. */
+static void
+os_trace_put(uint32_t ts, uint8_t id, uint16_t p16, uint32_t p32)
+{
+    struct os_trace_rec *rec;
+    struct os_task *t;
+
+    rec = &os_trace_ring[os_trace_head & OS_TRACE_MASK];
+    rec->otr_ts = ts;
+    rec->otr_id = id;
+    t = os_sched_get_current_task();
+    if (os_trace_isr_nest > 0 || t == NULL) {
+        rec->otr_task = 0xff;
+    } else {
+        rec->otr_task = t->t_taskid;
+    }
+    rec->otr_p16 = p16;
+    rec->otr_p32 = p32;
+    os_trace_head++;
+}
+
+/**
+ * Adds a record to the trace ring.  Safe to call from interrupt context.
+ * When the ring is full the record is dropped; an OS_TRACE_ID_OVERFLOW
+ * record with the number of drops is inserted once there is room again.
+ *
+ * @param id                    The record ID; one of OS_TRACE_ID_*.
+ * @param p16                   First ID-specific parameter.
+ * @param p32                   Second ID-specific parameter.
+ */
+void
+os_trace_rec(uint8_t id, uint16_t p16, uint32_t p32)
+{
+    uint32_t used;
+    uint32_t ts;
+    os_sr_t sr;
+
+    if (!os_trace_on) {
+        return;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+
+    ts = os_cputime_get32();
+    used = os_trace_head - os_trace_tail;
+
+    if (os_trace_dropped != 0) {
+        if (used + 2 > MYNEWT_VAL(OS_TRACE_ENTRIES)) {
+            os_trace_dropped++;
+            OS_EXIT_CRITICAL(sr);
+            return;
+        }
+        os_trace_put(ts, OS_TRACE_ID_OVERFLOW, 0, os_trace_dropped);
+        os_trace_dropped = 0;
+    } else if (used >= MYNEWT_VAL(OS_TRACE_ENTRIES)) {
+        os_trace_dropped = 1;
+        OS_EXIT_CRITICAL(sr);
+        return;
+    }
+
+    os_trace_put(ts, id, p16, p32);
+
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * Removes the oldest records from the trace ring.
+ *
+ * @param out_recs              Destination for the records.
+ * @param max_recs              The maximum number of records to remove.
+ *
+ * @return                      The number of records removed.
+ */
+int
+os_trace_read(struct os_trace_rec *out_recs, int max_recs)
+{
+    os_sr_t sr;
+    int cnt;
+
+    OS_ENTER_CRITICAL(sr);
+    for (cnt = 0; cnt < max_recs && os_trace_tail != os_trace_head; cnt++) {
+        out_recs[cnt] = os_trace_ring[os_trace_tail & OS_TRACE_MASK];
+        os_trace_tail++;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return cnt;
+}
+
+/**
+ * Starts or stops recording.  Starting records an OS_TRACE_ID_INFO record
+ * so that a host can synchronize on the stream.
+ */
+void
+os_trace_enable(int on)
+{
+    os_trace_on = !!on;
+    if (on) {
+        os_trace_rec(OS_TRACE_ID_INFO, OS_TRACE_VERSION,
+                     os_cputime_usecs_to_ticks(1000000));
+    }
+}
+
+/**
+ * Marks the start of an interrupt handler.  Records made until the matching
+ * os_trace_isr_exit() are attributed to interrupt context.
+ */
+void
+os_trace_isr_enter(uint16_t irq)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    os_trace_isr_nest++;
+    OS_EXIT_CRITICAL(sr);
+
+    os_trace_rec(OS_TRACE_ID_ISR_ENTER, irq, 0);
+}
+
+void
+os_trace_isr_exit(uint16_t irq)
+{
+    os_sr_t sr;
+
+    os_trace_rec(OS_TRACE_ID_ISR_EXIT, irq, 0);
+
+    OS_ENTER_CRITICAL(sr);
+    assert(os_trace_isr_nest > 0);
+    os_trace_isr_nest--;
+    OS_EXIT_CRITICAL(sr);
+}
+
+#endif /* MYNEWT_VAL(OS_TRACE) */
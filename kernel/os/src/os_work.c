@@ -0,0 +1,140 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "os/os_cputime.h"
+#include "os_priv.h"
+
+#include <assert.h>
+#include <string.h>
+
+/**
+ * @addtogroup OSKernel
+ * @{
+ *   @defgroup OSWork Deferred Interrupt Work
+ *   @{
+ */
+
+#if MYNEWT_VAL(OS_WORK)
+static struct os_eventq os_work_evq;
+static struct os_task os_work_task;
+static os_stack_t os_work_stack[OS_STACK_ALIGN(MYNEWT_VAL(OS_WORK_STACK_SIZE))];
+
+static void
+os_work_task_handler(void *arg)
+{
+    struct os_event *ev;
+#if MYNEWT_VAL(OS_WORK_STATS)
+    struct os_work *w;
+    uint32_t start;
+    uint32_t ticks;
+#endif
+
+    while (1) {
+        ev = os_eventq_get(&os_work_evq);
+#if MYNEWT_VAL(OS_WORK_STATS)
+        w = (struct os_work *)ev;
+        start = os_cputime_get32();
+        ev->ev_cb(ev);
+        ticks = os_cputime_get32() - start;
+
+        w->w_runs++;
+        w->w_last_ticks = ticks;
+        w->w_total_ticks += ticks;
+        if (ticks > w->w_max_ticks) {
+            w->w_max_ticks = ticks;
+        }
+#else
+        ev->ev_cb(ev);
+#endif
+    }
+}
+
+/*
+ * Creates the work task.  Called once, from os_init().
+ */
+void
+os_work_task_init(void)
+{
+    int rc;
+
+    os_eventq_init(&os_work_evq);
+    rc = os_task_init(&os_work_task, "work", os_work_task_handler, NULL,
+                      MYNEWT_VAL(OS_WORK_TASK_PRIO), OS_WAIT_FOREVER,
+                      os_work_stack,
+                      OS_STACK_ALIGN(MYNEWT_VAL(OS_WORK_STACK_SIZE)));
+    assert(rc == 0);
+}
+
+/**
+ * Initializes a work item.  Must not be called while the item is pending.
+ *
+ * @param w   The work item to initialize.
+ * @param fn  The function to call; it is passed the item's event, whose
+ *            ev_arg is 'arg'.  Runs in the work task.
+ * @param arg The argument to pass to the function.
+ */
+void
+os_work_init(struct os_work *w, os_event_fn *fn, void *arg)
+{
+    memset(w, 0, sizeof(*w));
+    w->w_ev.ev_cb = fn;
+    w->w_ev.ev_arg = arg;
+}
+
+/**
+ * Queues a work item to run on the work task.  If it is already pending,
+ * the post is counted and otherwise ignored.  Can be called from an
+ * interrupt handler.
+ *
+ * @param w The work item to post.
+ */
+void
+os_work_post(struct os_work *w)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    w->w_posts++;
+    if (OS_EVENT_QUEUED(&w->w_ev)) {
+        w->w_coalesced++;
+    } else {
+        os_eventq_put(&os_work_evq, &w->w_ev);
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * Removes a pending work item, so that its function does not run.  Has no
+ * effect if the item is not pending.
+ *
+ * @param w The work item to cancel.
+ */
+void
+os_work_cancel(struct os_work *w)
+{
+    os_eventq_remove(&os_work_evq, &w->w_ev);
+}
+#endif
+
+/**
+ *   @} OSWork
+ * @} OSKernel
+ */
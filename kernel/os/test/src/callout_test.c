@@ -230,10 +230,12 @@ callout_task_stop_listen(void *arg)
 TEST_CASE_DECL(callout_test_speak)
 TEST_CASE_DECL(callout_test_stop)
 TEST_CASE_DECL(callout_test)
+TEST_CASE_DECL(callout_test_wheel)
 
 TEST_SUITE(os_callout_test_suite)
 {   
     callout_test();
     callout_test_stop();
     callout_test_speak();
+    callout_test_wheel();
 }
@@ -0,0 +1,125 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os/os_cputime.h"
+#include "os_test_priv.h"
+
+#if MYNEWT_VAL(OS_CPUTIME_BATCH)
+struct os_task cputime_test_task;
+os_stack_t cputime_test_stack[CPUTIME_TEST_STACK_SIZE];
+
+struct os_cputime_btimer cputime_test_bt[CPUTIME_TEST_BT_CNT];
+
+static void
+cputime_test_bt_cb(void *arg)
+{
+}
+
+/*
+ * Two timers half the slack apart must be serviced by one compare, and
+ * starting the earlier one must not touch the hardware.
+ */
+void
+cputime_test_batch_handler(void *arg)
+{
+    uint32_t reprograms;
+    uint32_t ostick;
+    uint32_t slack;
+    uint32_t now;
+    int rc;
+    int i;
+
+    rc = os_cputime_init(1000000);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < CPUTIME_TEST_BT_CNT; i++) {
+        os_cputime_btimer_init(&cputime_test_bt[i], cputime_test_bt_cb,
+                               &cputime_test_bt[i]);
+    }
+
+    slack = os_cputime_usecs_to_ticks(
+        MYNEWT_VAL(OS_CPUTIME_BATCH_SLACK_USECS));
+    ostick = os_cputime_usecs_to_ticks(1000000 / OS_TICKS_PER_SEC);
+    reprograms = os_cputime_btimer_reprograms();
+    now = os_cputime_get32();
+
+    /* The later timer first; the compare goes to its expiry. */
+    rc = os_cputime_btimer_start(&cputime_test_bt[1], now + 4 * slack);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_cputime_btimer_reprograms() == reprograms + 1);
+
+    /* Within the slack before the compare: nothing to reprogram. */
+    rc = os_cputime_btimer_start(&cputime_test_bt[0],
+                                 now + 4 * slack - slack / 2);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_cputime_btimer_reprograms() == reprograms + 1);
+
+    /* Beyond the window of the head timer: still nothing to reprogram. */
+    rc = os_cputime_btimer_start(&cputime_test_bt[2], now + 10 * slack);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_cputime_btimer_reprograms() == reprograms + 1);
+
+    os_time_delay(os_cputime_ticks_to_usecs(6 * slack) /
+                  (1000000 / OS_TICKS_PER_SEC) + 1);
+
+    TEST_ASSERT(cputime_test_bt[0].bt_fired == 1);
+    TEST_ASSERT(cputime_test_bt[1].bt_fired == 1);
+    TEST_ASSERT(cputime_test_bt[2].bt_fired == 0);
+
+    /* The early timer waited for the later one, but not past the slack. */
+    TEST_ASSERT(cputime_test_bt[0].bt_last_late >= slack / 2);
+    TEST_ASSERT(cputime_test_bt[0].bt_last_late <= slack + 2 * ostick,
+                "late=%lu slack=%lu",
+                (unsigned long)cputime_test_bt[0].bt_last_late,
+                (unsigned long)slack);
+    TEST_ASSERT(cputime_test_bt[1].bt_last_late <= 2 * ostick);
+
+    /* One compare for both, then one for the timer left. */
+    TEST_ASSERT(os_cputime_btimer_reprograms() == reprograms + 2);
+
+    os_cputime_btimer_stop(&cputime_test_bt[2]);
+
+    /* Fill the heap; restarting a running timer still works. */
+    now = os_cputime_get32();
+    for (i = 0; i < CPUTIME_TEST_BT_CNT - 1; i++) {
+        rc = os_cputime_btimer_start(&cputime_test_bt[i], now + 10 * slack);
+        TEST_ASSERT(rc == 0);
+    }
+    rc = os_cputime_btimer_start(&cputime_test_bt[CPUTIME_TEST_BT_CNT - 1],
+                                 now + 10 * slack);
+    TEST_ASSERT(rc == OS_ENOMEM);
+    rc = os_cputime_btimer_start(&cputime_test_bt[0], now + 11 * slack);
+    TEST_ASSERT(rc == 0);
+
+    for (i = 0; i < CPUTIME_TEST_BT_CNT; i++) {
+        os_cputime_btimer_stop(&cputime_test_bt[i]);
+    }
+
+    os_test_restart();
+}
+#endif
+
+TEST_CASE_DECL(os_cputime_test_batch)
+
+TEST_SUITE(os_cputime_test_suite)
+{
+    os_cputime_test_batch();
+}
@@ -0,0 +1,49 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _CPUTIME_TEST_H
+#define _CPUTIME_TEST_H
+
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os/os_cputime.h"
+#include "os_test_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(OS_CPUTIME_BATCH)
+#define CPUTIME_TEST_STACK_SIZE     (5120)
+#define CPUTIME_TEST_TASK_PRIO      (1)
+extern struct os_task cputime_test_task;
+extern os_stack_t cputime_test_stack[CPUTIME_TEST_STACK_SIZE];
+
+/* One more than can run at once, to overflow the timer heap */
+#define CPUTIME_TEST_BT_CNT         (MYNEWT_VAL(OS_CPUTIME_BATCH_MAX) + 1)
+extern struct os_cputime_btimer cputime_test_bt[CPUTIME_TEST_BT_CNT];
+
+void cputime_test_batch_handler(void *arg);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CPUTIME_TEST_H */
@@ -86,6 +86,10 @@ TEST_CASE_DECL(event_test_poll_sr)
 TEST_CASE_DECL(event_test_poll_timeout_sr)
 TEST_CASE_DECL(event_test_poll_single_sr)
 TEST_CASE_DECL(event_test_poll_0timo)
+TEST_CASE_DECL(event_test_run_many)
+TEST_CASE_DECL(event_test_lat)
+TEST_CASE_DECL(event_test_prio)
+TEST_CASE_DECL(event_test_fiber)
 
 /* This is the task function  to send data */
 void
@@ -270,4 +274,8 @@ TEST_SUITE(os_eventq_test_suite)
     event_test_poll_timeout_sr();
     event_test_poll_single_sr();
     event_test_poll_0timo();
+    event_test_run_many();
+    event_test_lat();
+    event_test_prio();
+    event_test_fiber();
 }
@@ -102,6 +102,13 @@ TEST_CASE_DECL(os_mbuf_test_pullup)
 TEST_CASE_DECL(os_mbuf_test_extend)
 TEST_CASE_DECL(os_mbuf_test_adj)
 TEST_CASE_DECL(os_mbuf_test_get_pkthdr)
+TEST_CASE_DECL(os_mbuf_test_msys)
+TEST_CASE_DECL(os_mbuf_test_iovec)
+TEST_CASE_DECL(os_mbuf_test_ext)
+TEST_CASE_DECL(os_mbuf_test_mqueue)
+TEST_CASE_DECL(os_mbuf_test_split)
+TEST_CASE_DECL(os_mbuf_test_compact)
+TEST_CASE_DECL(os_mbuf_test_advise)
 
 TEST_SUITE(os_mbuf_test_suite)
 {
@@ -112,4 +119,11 @@ TEST_SUITE(os_mbuf_test_suite)
     os_mbuf_test_extend();
     os_mbuf_test_adj();
     os_mbuf_test_get_pkthdr();
+    os_mbuf_test_msys();
+    os_mbuf_test_iovec();
+    os_mbuf_test_ext();
+    os_mbuf_test_mqueue();
+    os_mbuf_test_split();
+    os_mbuf_test_compact();
+    os_mbuf_test_advise();
 }
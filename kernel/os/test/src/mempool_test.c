@@ -81,8 +81,10 @@ os_mempool_test_init(void *arg)
 }
 
 TEST_CASE_DECL(os_mempool_test_case)
+TEST_CASE_DECL(os_mempool_test_slab)
 
 TEST_SUITE(os_mempool_test_suite)
 {
     os_mempool_test_case();
+    os_mempool_test_slab();
 }
@@ -52,6 +52,7 @@ volatile int g_task4_val;
 #if MYNEWT_VAL(SELFTEST)
 struct os_mutex g_mutex1;
 struct os_mutex g_mutex2;
+struct os_rwlock g_rwlock1;
 volatile int g_mutex_test;
 #endif
 
@@ -134,6 +135,130 @@ mutex_test_basic_handler(void *arg)
     os_test_restart();
 }
 
+/**
+ * mutex test uncontended
+ *
+ * Acquire and release a mutex nobody else wants.  Releasing it must not
+ * hand the CPU to another task, and must leave the owner and lock counts
+ * clean, whichever release path is compiled in.
+ */
+void
+mutex_test_uncontended_handler(void *arg)
+{
+    struct os_mutex *mu;
+    struct os_task *t;
+    uint32_t ctx_sw_cnt;
+    os_error_t err;
+    int i;
+
+    mu = &g_mutex1;
+    t = os_sched_get_current_task();
+    ctx_sw_cnt = t->t_ctx_sw_cnt;
+
+    for (i = 0; i < 16; i++) {
+        err = os_mutex_pend(mu, 0);
+        TEST_ASSERT(err == 0, "Did not get free mutex (err=%d)", err);
+        err = os_mutex_pend(mu, 0);
+        TEST_ASSERT(err == 0, "Did not get my mutex (err=%d)", err);
+        TEST_ASSERT(mu->mu_owner == t && mu->mu_level == 2 &&
+                    t->t_lockcnt == 1 &&
+                    (t->t_flags & OS_TASK_FLAG_LOCK_HELD));
+
+        /* Nested release keeps the mutex */
+        err = os_mutex_release(mu);
+        TEST_ASSERT(err == 0, "Could not release mutex I own (err=%d)", err);
+        TEST_ASSERT(mu->mu_owner == t && mu->mu_level == 1);
+
+        err = os_mutex_release(mu);
+        TEST_ASSERT(err == 0, "Could not release mutex I own (err=%d)", err);
+        TEST_ASSERT(mu->mu_owner == NULL && mu->mu_level == 0 &&
+                    mu->mu_prio == t->t_prio && SLIST_EMPTY(&mu->mu_head),
+                    "Mutex internals not correct after release\n"
+                    "Mutex: owner=%p prio=%u level=%u head=%p\n"
+                    "Task: task=%p prio=%u",
+                    mu->mu_owner, mu->mu_prio, mu->mu_level,
+                    SLIST_FIRST(&mu->mu_head), t, t->t_prio);
+        TEST_ASSERT(t->t_lockcnt == 0 &&
+                    !(t->t_flags & OS_TASK_FLAG_LOCK_HELD));
+    }
+
+    TEST_ASSERT(os_mutex_release(mu) == OS_BAD_MUTEX);
+
+    /* No release above should have switched tasks */
+    TEST_ASSERT(t->t_ctx_sw_cnt == ctx_sw_cnt,
+                "Task switched on uncontended release (%u -> %u)",
+                (unsigned)ctx_sw_cnt, (unsigned)t->t_ctx_sw_cnt);
+
+    os_test_restart();
+}
+
+/**
+ * rwlock test basic
+ *
+ * Basic reader/writer lock tests, from a single task.
+ */
+void
+rwlock_test_basic_handler(void *arg)
+{
+    struct os_rwlock *rwl;
+    struct os_task *t;
+    os_error_t err;
+
+    rwl = &g_rwlock1;
+    t = os_sched_get_current_task();
+
+    /* Test some error cases */
+    TEST_ASSERT(os_rwlock_init(NULL)            == OS_INVALID_PARM);
+    TEST_ASSERT(os_rwlock_read_pend(NULL, 0)    == OS_INVALID_PARM);
+    TEST_ASSERT(os_rwlock_read_release(NULL)    == OS_INVALID_PARM);
+    TEST_ASSERT(os_rwlock_write_pend(NULL, 0)   == OS_INVALID_PARM);
+    TEST_ASSERT(os_rwlock_write_release(NULL)   == OS_INVALID_PARM);
+    TEST_ASSERT(os_rwlock_read_release(rwl)     == OS_BAD_MUTEX);
+    TEST_ASSERT(os_rwlock_write_release(rwl)    == OS_BAD_MUTEX);
+
+    /* Readers share the lock */
+    err = os_rwlock_read_pend(rwl, 0);
+    TEST_ASSERT(err == 0, "Did not get free read lock (err=%d)", err);
+    err = os_rwlock_read_pend(rwl, 0);
+    TEST_ASSERT(err == 0, "Did not get shared read lock (err=%d)", err);
+    TEST_ASSERT(rwl->rwl_readers == 2 && rwl->rwl_writer == NULL &&
+                SLIST_EMPTY(&rwl->rwl_head),
+                "Rwlock internals not correct after read locking\n"
+                "Rwlock: readers=%u writer=%p head=%p",
+                rwl->rwl_readers, rwl->rwl_writer,
+                SLIST_FIRST(&rwl->rwl_head));
+
+    /* Writer is kept out while readers hold the lock */
+    err = os_rwlock_write_pend(rwl, 0);
+    TEST_ASSERT(err == OS_TIMEOUT, "Got write lock while read locked");
+
+    TEST_ASSERT(os_rwlock_read_release(rwl) == 0);
+    TEST_ASSERT(os_rwlock_read_release(rwl) == 0);
+    TEST_ASSERT(os_rwlock_read_release(rwl) == OS_BAD_MUTEX);
+
+    /* Writer gets the lock exclusively */
+    err = os_rwlock_write_pend(rwl, 0);
+    TEST_ASSERT(err == 0, "Did not get free write lock (err=%d)", err);
+    TEST_ASSERT(rwl->rwl_writer == t && rwl->rwl_prio == t->t_prio &&
+                rwl->rwl_readers == 0,
+                "Rwlock internals not correct after write locking\n"
+                "Rwlock: readers=%u writer=%p prio=%u\n"
+                "Task: task=%p prio=%u",
+                rwl->rwl_readers, rwl->rwl_writer, rwl->rwl_prio,
+                t, t->t_prio);
+
+    /* The lock is not recursive */
+    TEST_ASSERT(os_rwlock_write_pend(rwl, 0) == OS_INVALID_PARM);
+    TEST_ASSERT(os_rwlock_read_pend(rwl, 0) == OS_TIMEOUT);
+
+    TEST_ASSERT(os_rwlock_write_release(rwl) == 0);
+    TEST_ASSERT(rwl->rwl_writer == NULL && rwl->rwl_readers == 0 &&
+                SLIST_EMPTY(&rwl->rwl_head));
+    TEST_ASSERT(os_rwlock_write_release(rwl) == OS_BAD_MUTEX);
+
+    os_test_restart();
+}
+
 void 
 mutex_test1_task1_handler(void *arg)
 {
@@ -359,10 +484,14 @@ os_mutex_test_init(void *arg)
 TEST_CASE_DECL(os_mutex_test_basic)
 TEST_CASE_DECL(os_mutex_test_case_1)
 TEST_CASE_DECL(os_mutex_test_case_2)
+TEST_CASE_DECL(os_rwlock_test_basic)
+TEST_CASE_DECL(os_mutex_test_uncontended)
 
 TEST_SUITE(os_mutex_test_suite)
 {
     os_mutex_test_basic();
     os_mutex_test_case_1();
     os_mutex_test_case_2();
+    os_rwlock_test_basic();
+    os_mutex_test_uncontended();
 }
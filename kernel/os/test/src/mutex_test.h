@@ -39,9 +39,12 @@ extern volatile int g_task3_val;
 extern volatile int g_task4_val;
 extern struct os_mutex g_mutex1;
 extern struct os_mutex g_mutex2;
+extern struct os_rwlock g_rwlock1;
 extern volatile int g_mutex_test;
 
 void mutex_test_basic_handler(void *arg);
+void rwlock_test_basic_handler(void *arg);
+void mutex_test_uncontended_handler(void *arg);
 void mutex_test1_task1_handler(void *arg);
 void mutex_test2_task1_handler(void *arg);
 void mutex_task2_handler(void *arg);
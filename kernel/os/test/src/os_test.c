@@ -80,6 +80,24 @@ os_test_all(void)
 
     os_callout_test_suite();
 
+    os_sched_test_suite();
+
+    os_cputime_test_suite();
+
+    os_sanity_test_suite();
+
+    os_profile_test_suite();
+
+    os_pm_test_suite();
+
+    os_stack_test_suite();
+
+    os_time_test_suite();
+
+    os_trace_test_suite();
+
+    os_work_test_suite();
+
     return tu_case_failed;
 }
 
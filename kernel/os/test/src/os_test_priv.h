@@ -26,12 +26,21 @@
 #include "os_test_priv.h"
 
 #include "callout_test.h"
+#include "cputime_test.h"
 
 #include "eventq_test.h"
 #include "mbuf_test.h"
 #include "mempool_test.h"
 #include "mutex_test.h"
+#include "pm_test.h"
+#include "profile_test.h"
+#include "sanity_test.h"
+#include "sched_test.h"
 #include "sem_test.h"
+#include "stack_test.h"
+#include "time_test.h"
+#include "trace_test.h"
+#include "work_test.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -64,6 +73,15 @@ int os_mutex_test_suite(void);
 int os_sem_test_suite(void);
 int os_eventq_test_suite(void);
 int os_callout_test_suite(void);
+int os_sched_test_suite(void);
+int os_cputime_test_suite(void);
+int os_sanity_test_suite(void);
+int os_profile_test_suite(void);
+int os_pm_test_suite(void);
+int os_stack_test_suite(void);
+int os_time_test_suite(void);
+int os_trace_test_suite(void);
+int os_work_test_suite(void);
 
 #ifdef __cplusplus
 }
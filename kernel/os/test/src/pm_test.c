@@ -0,0 +1,100 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <string.h>
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os_test_priv.h"
+
+#if MYNEWT_VAL(OS_PM)
+struct os_dev pm_test_dev[PM_TEST_DEV_CNT];
+int pm_test_clock_on[PM_TEST_DEV_CNT];
+int pm_test_clock_calls[PM_TEST_DEV_CNT];
+
+static void
+pm_test_clock(struct os_dev *dev, int on)
+{
+    int i;
+
+    i = dev - pm_test_dev;
+    pm_test_clock_on[i] = on;
+    pm_test_clock_calls[i]++;
+}
+
+/*
+ * Sets the test devices up the way os_dev_create() would, without adding
+ * them to the device list.
+ */
+void
+pm_test_dev_init(void)
+{
+    int i;
+
+    memset(pm_test_dev, 0, sizeof(pm_test_dev));
+    for (i = 0; i < PM_TEST_DEV_CNT; i++) {
+        pm_test_dev[i].od_handlers.od_clock = pm_test_clock;
+        pm_test_dev[i].od_pm_max_state = OS_PM_STATE_IDLE;
+        pm_test_clock_on[i] = 0;
+        pm_test_clock_calls[i] = 0;
+    }
+}
+
+/*
+ * Idles the way the idle task does, and returns the sleep state that was
+ * entered, or -1 if the residency counts are off.
+ */
+int
+pm_test_idle(os_time_t ticks)
+{
+    uint32_t before[OS_PM_STATE_CNT];
+    uint32_t after;
+    os_sr_t sr;
+    int state;
+    int s;
+
+    for (s = 0; s < OS_PM_STATE_CNT; s++) {
+        os_pm_residency(s, NULL, &before[s]);
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    os_pm_idle(ticks);
+    OS_EXIT_CRITICAL(sr);
+
+    state = -1;
+    for (s = 0; s < OS_PM_STATE_CNT; s++) {
+        os_pm_residency(s, NULL, &after);
+        if (after == before[s] + 1 && state == -1) {
+            state = s;
+        } else if (after != before[s]) {
+            return -1;
+        }
+    }
+
+    return state;
+}
+#endif
+
+TEST_CASE_DECL(os_pm_test_states)
+TEST_CASE_DECL(os_pm_test_active)
+
+TEST_SUITE(os_pm_test_suite)
+{
+    os_pm_test_states();
+    os_pm_test_active();
+}
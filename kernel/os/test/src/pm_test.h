@@ -0,0 +1,48 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _PM_TEST_H
+#define _PM_TEST_H
+
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os_test_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(OS_PM)
+#define PM_TEST_DEV_CNT     (2)
+/* An idle period long enough for any sleep state */
+#define PM_TEST_LONG_TICKS  (MYNEWT_VAL(OS_PM_DEEP_MIN_TICKS) + 10)
+
+extern struct os_dev pm_test_dev[PM_TEST_DEV_CNT];
+extern int pm_test_clock_on[PM_TEST_DEV_CNT];
+extern int pm_test_clock_calls[PM_TEST_DEV_CNT];
+
+void pm_test_dev_init(void);
+int pm_test_idle(os_time_t ticks);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PM_TEST_H */
@@ -0,0 +1,54 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os/os_cputime.h"
+#include "os_test_priv.h"
+
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+struct os_task profile_test_task[2];
+os_stack_t profile_test_stack[2][PROFILE_TEST_STACK_SIZE];
+
+/* Converts OS ticks to os_cputime ticks. */
+uint32_t
+profile_test_ticks(os_time_t osticks)
+{
+    return os_cputime_usecs_to_ticks(osticks * (1000000 / OS_TICKS_PER_SEC));
+}
+
+/*
+ * Lets the current task run for 'osticks' OS ticks, then switches to 'next'
+ * the way the context switch code does.
+ */
+void
+profile_test_switch(struct os_task *next, os_time_t osticks)
+{
+    os_time_advance(osticks);
+    os_sched_ctx_sw_hook(next);
+    os_sched_set_current_task(next);
+}
+#endif
+
+TEST_CASE_DECL(os_profile_test_run)
+
+TEST_SUITE(os_profile_test_suite)
+{
+    os_profile_test_run();
+}
@@ -0,0 +1,54 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _PROFILE_TEST_H
+#define _PROFILE_TEST_H
+
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os_test_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+#if MYNEWT_VAL(SELFTEST)
+#define PROFILE_TEST_STACK_SIZE     (1024)
+#else
+#define PROFILE_TEST_STACK_SIZE     (64)
+#endif
+#define PROFILE_TEST_TASK_PRIO      (10)
+#define PROFILE_TEST_CPUTIME_FREQ   (1000000)
+/* Profiling window length, in OS ticks */
+#define PROFILE_TEST_WIN_TICKS      \
+    (MYNEWT_VAL(OS_TASK_PROFILE_WINDOW_MS) * OS_TICKS_PER_SEC / 1000)
+
+extern struct os_task profile_test_task[2];
+extern os_stack_t profile_test_stack[2][PROFILE_TEST_STACK_SIZE];
+
+uint32_t profile_test_ticks(os_time_t osticks);
+void profile_test_switch(struct os_task *next, os_time_t osticks);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _PROFILE_TEST_H */
@@ -0,0 +1,84 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os_test_priv.h"
+
+/* Value returned by sanity_test_check() */
+int sanity_test_rc;
+
+/* Number of calls to sanity_test_check(), and when and where the last ran */
+int sanity_test_runs;
+os_time_t sanity_test_ran_at;
+struct os_task *sanity_test_ran_on;
+
+int
+sanity_test_check(struct os_sanity_check *sc, void *arg)
+{
+    sanity_test_runs++;
+    sanity_test_ran_at = os_time_get();
+    sanity_test_ran_on = os_sched_get_current_task();
+    return sanity_test_rc;
+}
+
+#if MYNEWT_VAL(SANITY_IDLE_PIGGYBACK)
+struct os_task sanity_test_task;
+os_stack_t sanity_test_stack[SANITY_TEST_STACK_SIZE];
+
+/*
+ * Sleeps for longer than any sanity interval.  The idle task does not wake
+ * up to run the checks at the end of the interval, but runs them when it
+ * gets to run again after this task wakes up.
+ */
+void
+sanity_test_idle_handler(void *arg)
+{
+    os_time_t wakeup;
+    int runs;
+
+    /* Whatever ran before, the checks are due once this task blocks. */
+    os_time_delay(SANITY_TEST_MAX_ITVL_TICKS + 1);
+    os_time_delay(1);
+    runs = sanity_test_runs;
+    TEST_ASSERT_FATAL(runs > 0);
+    TEST_ASSERT(sanity_test_ran_at == os_time_get() - 1);
+    TEST_ASSERT(sanity_test_ran_on != NULL &&
+                sanity_test_ran_on->t_prio == OS_IDLE_PRIO);
+
+    os_time_delay(SANITY_TEST_MAX_ITVL_TICKS + 1);
+    wakeup = os_time_get();
+    TEST_ASSERT(sanity_test_runs == runs);
+
+    os_time_delay(1);
+    TEST_ASSERT(sanity_test_runs == runs + 1);
+    TEST_ASSERT(sanity_test_ran_at == wakeup);
+    TEST_ASSERT(sanity_test_ran_on != NULL &&
+                sanity_test_ran_on->t_prio == OS_IDLE_PRIO);
+
+    os_test_restart();
+}
+#endif
+
+TEST_CASE_DECL(os_sanity_test_adaptive)
+
+TEST_SUITE(os_sanity_test_suite)
+{
+    os_sanity_test_adaptive();
+}
@@ -0,0 +1,56 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _SANITY_TEST_H
+#define _SANITY_TEST_H
+
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os_test_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SANITY_TEST_ITVL_TICKS \
+    ((MYNEWT_VAL(SANITY_INTERVAL) * OS_TICKS_PER_SEC) / 1000)
+#define SANITY_TEST_MAX_ITVL_TICKS \
+    ((MYNEWT_VAL(SANITY_MAX_INTERVAL) * OS_TICKS_PER_SEC) / 1000)
+
+extern int sanity_test_rc;
+extern int sanity_test_runs;
+extern os_time_t sanity_test_ran_at;
+extern struct os_task *sanity_test_ran_on;
+
+int sanity_test_check(struct os_sanity_check *sc, void *arg);
+
+#if MYNEWT_VAL(SANITY_IDLE_PIGGYBACK)
+#define SANITY_TEST_STACK_SIZE  (5120)
+#define SANITY_TEST_TASK_PRIO   (10)
+extern struct os_task sanity_test_task;
+extern os_stack_t sanity_test_stack[SANITY_TEST_STACK_SIZE];
+
+void sanity_test_idle_handler(void *arg);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SANITY_TEST_H */
@@ -0,0 +1,92 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os_test_priv.h"
+
+struct os_task sched_test_tasks[SCHED_TEST_TASK_CNT];
+os_stack_t sched_test_stacks[SCHED_TEST_TASK_CNT][SCHED_TEST_STACK_SIZE];
+
+static void
+sched_test_task_handler(void *arg)
+{
+}
+
+void
+sched_test_task_init(int idx, uint8_t prio)
+{
+    int rc;
+
+    rc = os_task_init(&sched_test_tasks[idx], "sched_test",
+                      sched_test_task_handler, NULL, prio, OS_WAIT_FOREVER,
+                      sched_test_stacks[idx], SCHED_TEST_STACK_SIZE);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+/* Takes a task off the run list by putting it to sleep. */
+void
+sched_test_remove(int idx)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    os_sched_sleep(&sched_test_tasks[idx], OS_TIMEOUT_NEVER);
+    OS_EXIT_CRITICAL(sr);
+}
+
+/* Puts a task removed by sched_test_remove() back on the run list. */
+void
+sched_test_restore(int idx)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    os_sched_wakeup(&sched_test_tasks[idx]);
+    OS_EXIT_CRITICAL(sr);
+}
+
+/*
+ * Returns 1 if the run list holds exactly the test tasks listed in 'order',
+ * in that order, followed by the idle task.
+ */
+int
+sched_test_run_list_is(const int *order, int cnt)
+{
+    struct os_task *t;
+    int i;
+
+    t = os_sched_next_task();
+    for (i = 0; i < cnt; i++) {
+        if (t != &sched_test_tasks[order[i]]) {
+            return 0;
+        }
+        t = TAILQ_NEXT(t, t_os_list);
+    }
+
+    return t != NULL && t->t_prio == OS_IDLE_PRIO &&
+           TAILQ_NEXT(t, t_os_list) == NULL;
+}
+
+TEST_CASE_DECL(os_sched_test_run_list)
+
+TEST_SUITE(os_sched_test_suite)
+{
+    os_sched_test_run_list();
+}
@@ -0,0 +1,50 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _SCHED_TEST_H
+#define _SCHED_TEST_H
+
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os_test_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(SELFTEST)
+#define SCHED_TEST_STACK_SIZE   (1024)
+#else
+#define SCHED_TEST_STACK_SIZE   (32)
+#endif
+
+#define SCHED_TEST_TASK_CNT     (8)
+extern struct os_task sched_test_tasks[SCHED_TEST_TASK_CNT];
+extern os_stack_t sched_test_stacks[SCHED_TEST_TASK_CNT][SCHED_TEST_STACK_SIZE];
+
+void sched_test_task_init(int idx, uint8_t prio);
+void sched_test_remove(int idx);
+void sched_test_restore(int idx);
+int sched_test_run_list_is(const int *order, int cnt);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _SCHED_TEST_H */
@@ -0,0 +1,80 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os_test_priv.h"
+
+#if MYNEWT_VAL(OS_STACK_SCAN)
+struct os_task stack_test_task;
+os_stack_t stack_test_stack[STACK_TEST_STACK_SIZE];
+
+int stack_test_alerts;
+uint16_t stack_test_headroom;
+
+void
+stack_test_alert(struct os_task *t, uint16_t headroom)
+{
+    if (t == &stack_test_task) {
+        stack_test_alerts++;
+        stack_test_headroom = headroom;
+    }
+}
+
+/* Marks the top 'words' words of the test task's stack as used. */
+void
+stack_test_dirty(int words)
+{
+    int i;
+
+    for (i = STACK_TEST_STACK_SIZE - words; i < STACK_TEST_STACK_SIZE; i++) {
+        stack_test_stack[i] = 0;
+    }
+}
+
+/*
+ * Runs the idle task's scan, a bounded number of words at a time, for long
+ * enough to cover every task's stack more than once.
+ */
+void
+stack_test_scan(void)
+{
+    struct os_task_info oti;
+    struct os_task *t;
+    int words;
+    int i;
+
+    words = 0;
+    t = NULL;
+    while ((t = os_task_info_get_next(t, &oti)) != NULL) {
+        words += oti.oti_stksize;
+    }
+
+    for (i = 0; i < 4 * words / MYNEWT_VAL(OS_STACK_SCAN_WORDS) + 1; i++) {
+        os_task_stack_scan(MYNEWT_VAL(OS_STACK_SCAN_WORDS));
+    }
+}
+#endif
+
+TEST_CASE_DECL(os_stack_test_scan)
+
+TEST_SUITE(os_stack_test_suite)
+{
+    os_stack_test_scan();
+}
@@ -0,0 +1,53 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _STACK_TEST_H
+#define _STACK_TEST_H
+
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os_test_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(OS_STACK_SCAN)
+#if MYNEWT_VAL(SELFTEST)
+#define STACK_TEST_STACK_SIZE   (1000)
+#else
+#define STACK_TEST_STACK_SIZE   (100)
+#endif
+#define STACK_TEST_TASK_PRIO    (10)
+extern struct os_task stack_test_task;
+extern os_stack_t stack_test_stack[STACK_TEST_STACK_SIZE];
+
+extern int stack_test_alerts;
+extern uint16_t stack_test_headroom;
+
+void stack_test_alert(struct os_task *t, uint16_t headroom);
+void stack_test_dirty(int words);
+void stack_test_scan(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _STACK_TEST_H */
@@ -0,0 +1,113 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#if MYNEWT_VAL(OS_FIBER)
+
+static struct os_fiber fiber_test_fiber;
+static struct os_fiber_sem fiber_test_sem;
+static int fiber_test_step;
+
+static int
+fiber_test_fn(struct os_fiber *f)
+{
+    OS_FIBER_BEGIN(f);
+
+    fiber_test_step = 1;
+    OS_FIBER_SEM_WAIT(f, &fiber_test_sem);
+
+    fiber_test_step = 2;
+    OS_FIBER_WAIT_SIGNAL(f);
+
+    fiber_test_step = 3;
+    OS_FIBER_YIELD(f);
+
+    fiber_test_step = 4;
+
+    OS_FIBER_END(f);
+}
+
+/* Runs every event on my_eventq without involving the scheduler. */
+static int
+fiber_test_run(void)
+{
+    struct os_eventq *evqs[1];
+    struct os_event *ev;
+    int count;
+
+    evqs[0] = &my_eventq;
+    count = 0;
+    while ((ev = os_eventq_poll(evqs, 1, 0)) != NULL) {
+        ev->ev_cb(ev);
+        count++;
+    }
+
+    return count;
+}
+
+#endif
+
+/**
+ * Steps a fiber through its semaphore, signal and yield waits.
+ */
+TEST_CASE(event_test_fiber)
+{
+#if MYNEWT_VAL(OS_FIBER)
+    os_eventq_init(&my_eventq);
+    os_fiber_sem_init(&fiber_test_sem, 0);
+    os_fiber_init(&fiber_test_fiber, fiber_test_fn, NULL);
+    os_fiber_start(&fiber_test_fiber, &my_eventq);
+
+    /* Blocks on the empty semaphore. */
+    TEST_ASSERT(fiber_test_run() == 1);
+    TEST_ASSERT(fiber_test_step == 1);
+
+    /* A spurious wakeup rechecks the semaphore and keeps waiting. */
+    os_fiber_wake(&fiber_test_fiber);
+    TEST_ASSERT(fiber_test_run() == 1);
+    TEST_ASSERT(fiber_test_step == 1);
+    TEST_ASSERT(fiber_test_sem.ofs_tokens == 0);
+
+    os_fiber_sem_release(&fiber_test_sem);
+    TEST_ASSERT(fiber_test_run() == 1);
+    TEST_ASSERT(fiber_test_step == 2);
+    TEST_ASSERT(fiber_test_sem.ofs_tokens == 0);
+    TEST_ASSERT(SLIST_EMPTY(&fiber_test_sem.ofs_waiters));
+
+    /* The yield takes a second run. */
+    os_fiber_signal(&fiber_test_fiber);
+    TEST_ASSERT(fiber_test_run() == 2);
+    TEST_ASSERT(fiber_test_step == 4);
+    TEST_ASSERT(!fiber_test_fiber.of_running);
+
+    /* A stopped fiber ignores wakeups. */
+    os_fiber_signal(&fiber_test_fiber);
+    TEST_ASSERT(fiber_test_run() == 0);
+
+    /* Stopping a waiting fiber takes it off the semaphore. */
+    os_fiber_start(&fiber_test_fiber, &my_eventq);
+    TEST_ASSERT(fiber_test_run() == 1);
+    TEST_ASSERT(!SLIST_EMPTY(&fiber_test_sem.ofs_waiters));
+    os_fiber_stop(&fiber_test_fiber);
+    TEST_ASSERT(SLIST_EMPTY(&fiber_test_sem.ofs_waiters));
+    os_fiber_sem_release(&fiber_test_sem);
+    TEST_ASSERT(fiber_test_run() == 0);
+    TEST_ASSERT(fiber_test_sem.ofs_tokens == 1);
+#endif
+}
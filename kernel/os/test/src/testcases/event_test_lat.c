@@ -0,0 +1,81 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define LAT_NUM_EVENTS          (5)
+
+/**
+ * Tests event queue depth tracking and the latency histogram kept for a
+ * registered queue.  Events are put and removed directly, so the OS need
+ * not be started.
+ */
+TEST_CASE(event_test_lat)
+{
+    struct os_event evs[LAT_NUM_EVENTS];
+    struct os_eventq_info oei;
+    struct os_eventq *evq;
+    uint32_t total;
+    int found;
+    int rc;
+    int i;
+
+    os_eventq_init(&my_eventq);
+    memset(evs, 0, sizeof evs);
+
+    for (i = 0; i < LAT_NUM_EVENTS; i++) {
+        os_eventq_put(&my_eventq, &evs[i]);
+    }
+    TEST_ASSERT(my_eventq.evq_depth == LAT_NUM_EVENTS);
+    TEST_ASSERT(my_eventq.evq_max_depth == LAT_NUM_EVENTS);
+
+    for (i = 0; i < LAT_NUM_EVENTS - 1; i++) {
+        evq = &my_eventq;
+        TEST_ASSERT(os_eventq_poll(&evq, 1, 0) == &evs[i]);
+    }
+    os_eventq_remove(&my_eventq, &evs[LAT_NUM_EVENTS - 1]);
+    TEST_ASSERT(my_eventq.evq_depth == 0);
+    TEST_ASSERT(my_eventq.evq_max_depth == LAT_NUM_EVENTS);
+
+    rc = os_eventq_lat_register(&my_eventq, "lat_test");
+    TEST_ASSERT(rc == 0);
+    rc = os_eventq_lat_register(&my_eventq, "lat_test");
+    TEST_ASSERT(rc == OS_EINVAL);
+
+    found = 0;
+    evq = NULL;
+    while (1) {
+        evq = os_eventq_info_get_next(evq, &oei);
+        if (evq == NULL) {
+            break;
+        }
+        if (evq != &my_eventq) {
+            continue;
+        }
+
+        found = 1;
+        TEST_ASSERT(strcmp(oei.oei_name, "lat_test") == 0);
+        total = 0;
+        for (i = 0; i < MYNEWT_VAL(OS_EVENTQ_LATENCY_BUCKETS); i++) {
+            total += oei.oei_lat_hist[i];
+        }
+        /* The removed event was never dispatched. */
+        TEST_ASSERT(total == LAT_NUM_EVENTS - 1);
+    }
+    TEST_ASSERT(found);
+}
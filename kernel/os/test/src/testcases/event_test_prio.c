@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define PRIO_NUM_EVENTS     (6)
+
+static struct os_event prio_events[PRIO_NUM_EVENTS];
+
+/* Takes the next event without involving the scheduler. */
+static int
+prio_take(void)
+{
+    struct os_eventq *evqs[1];
+    struct os_event *ev;
+
+    evqs[0] = &my_eventq;
+    ev = os_eventq_poll(evqs, 1, 0);
+    if (ev == NULL) {
+        return -1;
+    }
+    return ev - prio_events;
+}
+
+/**
+ * Tests that events are taken in priority order and FIFO order within a
+ * level, and that removal keeps the per-level ordering intact.
+ */
+TEST_CASE(event_test_prio)
+{
+    static const uint8_t prios[PRIO_NUM_EVENTS] = { 2, 1, 2, 0, 1, 9 };
+    int i;
+
+    os_eventq_init(&my_eventq);
+    memset(prio_events, 0, sizeof prio_events);
+    for (i = 0; i < PRIO_NUM_EVENTS; i++) {
+        OS_EVENT_PRIO_SET(&prio_events[i], prios[i]);
+        os_eventq_put(&my_eventq, &prio_events[i]);
+    }
+
+#if MYNEWT_VAL(OS_EVENTQ_PRIOS) > 1
+    /* Remove the tail of level 1; its predecessor becomes the new tail. */
+    os_eventq_remove(&my_eventq, &prio_events[4]);
+    os_eventq_put(&my_eventq, &prio_events[4]);
+
+    TEST_ASSERT(prio_take() == 3);
+    TEST_ASSERT(prio_take() == 1);
+    TEST_ASSERT(prio_take() == 4);
+    TEST_ASSERT(prio_take() == 0);
+    TEST_ASSERT(prio_take() == 2);
+    /* Levels past the lowest are treated as the lowest. */
+    TEST_ASSERT(prio_take() == 5);
+
+    /* Level tails are cleared as levels drain. */
+    os_eventq_put(&my_eventq, &prio_events[0]);
+    os_eventq_put(&my_eventq, &prio_events[3]);
+    TEST_ASSERT(prio_take() == 3);
+    TEST_ASSERT(prio_take() == 0);
+#else
+    for (i = 0; i < PRIO_NUM_EVENTS; i++) {
+        TEST_ASSERT(prio_take() == i);
+    }
+#endif
+
+    TEST_ASSERT(prio_take() == -1);
+    TEST_ASSERT(STAILQ_EMPTY(&my_eventq.evq_list));
+}
@@ -0,0 +1,96 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define RUN_MANY_NUM_EVENTS     (20)
+
+static struct os_event run_many_events[RUN_MANY_NUM_EVENTS];
+static int run_many_order[RUN_MANY_NUM_EVENTS];
+static int run_many_count;
+
+static void
+run_many_cb(struct os_event *ev)
+{
+    run_many_order[run_many_count++] = ev - run_many_events;
+}
+
+/* Removes the event that follows it from the queue. */
+static void
+run_many_remove_cb(struct os_event *ev)
+{
+    run_many_cb(ev);
+    os_eventq_remove(&my_eventq, ev + 1);
+}
+
+static void
+run_many_fill(int num)
+{
+    int i;
+
+    os_eventq_init(&my_eventq);
+    memset(run_many_events, 0, sizeof run_many_events);
+    run_many_count = 0;
+
+    for (i = 0; i < num; i++) {
+        run_many_events[i].ev_cb = run_many_cb;
+        os_eventq_put(&my_eventq, &run_many_events[i]);
+    }
+}
+
+/**
+ * Tests os_eventq_run_many() on queues that already hold events, so the
+ * scheduler is never involved and the OS need not be started.
+ */
+TEST_CASE(event_test_run_many)
+{
+    int rc;
+    int i;
+
+    /* Drain a queue that takes several batches. */
+    run_many_fill(RUN_MANY_NUM_EVENTS);
+    rc = os_eventq_run_many(&my_eventq, 0, OS_TIMEOUT_NEVER);
+    TEST_ASSERT(rc == RUN_MANY_NUM_EVENTS);
+    TEST_ASSERT(run_many_count == RUN_MANY_NUM_EVENTS);
+    for (i = 0; i < RUN_MANY_NUM_EVENTS; i++) {
+        TEST_ASSERT(run_many_order[i] == i);
+        TEST_ASSERT(!OS_EVENT_QUEUED(&run_many_events[i]));
+    }
+    TEST_ASSERT(STAILQ_EMPTY(&my_eventq.evq_list));
+
+    /* Stop after max_events. */
+    run_many_fill(RUN_MANY_NUM_EVENTS);
+    rc = os_eventq_run_many(&my_eventq, 3, OS_TIMEOUT_NEVER);
+    TEST_ASSERT(rc == 3);
+    TEST_ASSERT(STAILQ_FIRST(&my_eventq.evq_list) == &run_many_events[3]);
+
+    /* A zero budget dispatches a single batch. */
+    rc = os_eventq_run_many(&my_eventq, 0, 0);
+    TEST_ASSERT(rc == MYNEWT_VAL(OS_EVENTQ_BATCH_SIZE));
+    TEST_ASSERT(run_many_order[3] == 3);
+
+    /* An event removed while it sits in a batch is not dispatched. */
+    run_many_fill(4);
+    run_many_events[1].ev_cb = run_many_remove_cb;
+    rc = os_eventq_run_many(&my_eventq, 0, OS_TIMEOUT_NEVER);
+    TEST_ASSERT(rc == 3);
+    TEST_ASSERT(run_many_order[0] == 0);
+    TEST_ASSERT(run_many_order[1] == 1);
+    TEST_ASSERT(run_many_order[2] == 3);
+    TEST_ASSERT(!OS_EVENT_QUEUED(&run_many_events[2]));
+}
@@ -0,0 +1,109 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#if MYNEWT_VAL(OS_CALLOUT_WHEEL)
+#define CALLOUT_TEST_WHEEL_REV  MYNEWT_VAL(OS_CALLOUT_WHEEL_SIZE)
+#else
+#define CALLOUT_TEST_WHEEL_REV  64
+#endif
+
+static os_time_t
+callout_test_wakeup_ticks(void)
+{
+    os_time_t ticks;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    ticks = os_callout_wakeup_ticks(os_time_get());
+    OS_EXIT_CRITICAL(sr);
+
+    return ticks;
+}
+
+/*
+ * Steps time by hand, with the OS stopped, across more than a revolution of
+ * the callout wheel.
+ */
+TEST_CASE(callout_test_wheel)
+{
+#if MYNEWT_VAL(SELFTEST)
+    struct os_callout c_near;
+    struct os_callout c_far;
+    struct os_eventq evq;
+    int rc;
+
+    sysinit();
+
+    os_eventq_init(&evq);
+    os_callout_init(&c_near, &evq, my_callout, NULL);
+    os_callout_init(&c_far, &evq, my_callout, NULL);
+
+    rc = os_callout_reset(&c_near, 5);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_callout_reset(&c_far, 3 * CALLOUT_TEST_WHEEL_REV + 7);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(callout_test_wakeup_ticks() == 5);
+
+    /* Nothing fires early. */
+    os_time_advance(4);
+    os_callout_tick();
+    TEST_ASSERT(os_callout_queued(&c_near));
+    TEST_ASSERT(callout_test_wakeup_ticks() == 1);
+
+    /*
+     * Once the near callout fires, the next wakeup is the far one, more
+     * than a revolution away.
+     */
+    os_time_advance(1);
+    os_callout_tick();
+    TEST_ASSERT(!os_callout_queued(&c_near));
+    TEST_ASSERT(c_near.c_ev.ev_queued);
+    TEST_ASSERT(os_callout_queued(&c_far));
+    TEST_ASSERT(callout_test_wakeup_ticks() ==
+                3 * CALLOUT_TEST_WHEEL_REV + 2);
+
+    /* A jump of several revolutions fires everything it passes. */
+    os_eventq_remove(&evq, &c_near.c_ev);
+    rc = os_callout_reset(&c_near, CALLOUT_TEST_WHEEL_REV / 2);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(callout_test_wakeup_ticks() == CALLOUT_TEST_WHEEL_REV / 2);
+
+    os_time_advance(5 * CALLOUT_TEST_WHEEL_REV + 3);
+    os_callout_tick();
+    TEST_ASSERT(!os_callout_queued(&c_near));
+    TEST_ASSERT(!os_callout_queued(&c_far));
+    TEST_ASSERT(c_near.c_ev.ev_queued);
+    TEST_ASSERT(c_far.c_ev.ev_queued);
+    TEST_ASSERT(callout_test_wakeup_ticks() == OS_TIMEOUT_NEVER);
+
+    /* A callout set after the jump is not mistaken for an expired one. */
+    os_eventq_remove(&evq, &c_near.c_ev);
+    rc = os_callout_reset(&c_near, CALLOUT_TEST_WHEEL_REV + 1);
+    TEST_ASSERT_FATAL(rc == 0);
+    os_time_advance(1);
+    os_callout_tick();
+    TEST_ASSERT(os_callout_queued(&c_near));
+    TEST_ASSERT(callout_test_wakeup_ticks() == CALLOUT_TEST_WHEEL_REV);
+
+    os_callout_stop(&c_near);
+    os_callout_stop(&c_far);
+    TEST_ASSERT(callout_test_wakeup_ticks() == OS_TIMEOUT_NEVER);
+#endif
+}
@@ -0,0 +1,104 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define MBUF_TEST_ADVISE_SMALL      (4)
+
+TEST_CASE(os_mbuf_test_advise)
+{
+#if MYNEWT_VAL(OS_MSYS_ADVISE)
+    struct os_mbuf *small[MBUF_TEST_ADVISE_SMALL];
+    struct os_msys_advice oma;
+    struct os_msys_demand omd;
+    struct os_mbuf *m;
+    int small_cnt;
+    int need;
+    int rc;
+    int i;
+
+    os_mbuf_test_setup();
+    os_msys_reset();
+    os_msys_demand_clear();
+
+    rc = os_msys_advise(0, &oma);
+    TEST_ASSERT(rc == OS_ENOENT);
+
+    os_msys_register(&os_mbuf_pool);
+
+    /* Mostly small requests, and one large one. */
+    for (i = 0; i < MBUF_TEST_ADVISE_SMALL; i++) {
+        small[i] = os_msys_get(16, 0);
+        TEST_ASSERT_FATAL(small[i] != NULL);
+    }
+    m = os_msys_get(200, 0);
+    TEST_ASSERT_FATAL(m != NULL);
+
+    os_msys_demand_get(&omd);
+    TEST_ASSERT(omd.omd_reqs[0] == MBUF_TEST_ADVISE_SMALL);
+    TEST_ASSERT(omd.omd_reqs[4] == 1);
+    TEST_ASSERT(omd.omd_num_fail == 0);
+
+    os_mbuf_free(m);
+    for (i = 0; i < MBUF_TEST_ADVISE_SMALL; i++) {
+        os_mbuf_free(small[i]);
+    }
+
+    /* Five blocks were in use at once, plus headroom. */
+    need = os_mempool_advise(&os_mbuf_mempool);
+    TEST_ASSERT(need == MBUF_TEST_ADVISE_SMALL + 1 +
+                ((MBUF_TEST_ADVISE_SMALL + 1) *
+                 MYNEWT_VAL(OS_MEMPOOL_ADVISE_HEADROOM) + 99) / 100);
+
+    /* Most requests fit in 16 bytes; those get a pool of their own. */
+    rc = os_msys_advise(0, &oma);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(oma.oma_num_pools == 2);
+    small_cnt = (need * MBUF_TEST_ADVISE_SMALL + MBUF_TEST_ADVISE_SMALL) /
+                (MBUF_TEST_ADVISE_SMALL + 1);
+    if (small_cnt >= need) {
+        small_cnt = need - 1;
+    }
+    TEST_ASSERT(oma.oma_pools[0].omap_block_size ==
+                16 + sizeof(struct os_mbuf));
+    TEST_ASSERT(oma.oma_pools[0].omap_block_count == small_cnt);
+    TEST_ASSERT(oma.oma_pools[1].omap_block_size ==
+                os_mbuf_pool.omp_databuf_len + sizeof(struct os_mbuf));
+    TEST_ASSERT(oma.oma_pools[1].omap_block_count == need - small_cnt);
+    TEST_ASSERT(oma.oma_bytes == oma.oma_need_bytes);
+
+    /* A smaller budget scales the layout down. */
+    rc = os_msys_advise(oma.oma_need_bytes * 3 / 4, &oma);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(oma.oma_bytes <= oma.oma_need_bytes * 3 / 4);
+    TEST_ASSERT(oma.oma_pools[0].omap_block_count >= 1);
+    TEST_ASSERT(oma.oma_pools[1].omap_block_count >= 1);
+
+    /* A budget too small for a block of each keeps one of each. */
+    rc = os_msys_advise(1, &oma);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(oma.oma_pools[0].omap_block_count == 1);
+    TEST_ASSERT(oma.oma_pools[1].omap_block_count == 1);
+
+    os_msys_demand_clear();
+    os_msys_demand_get(&omd);
+    TEST_ASSERT(omd.omd_reqs[0] == 0);
+
+    os_msys_reset();
+#endif
+}
@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+static struct os_mbuf *
+os_mbuf_test_compact_pkt(int off, int len)
+{
+    struct os_mbuf *om;
+    int rc;
+
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    rc = os_mbuf_append(om, os_mbuf_test_data + off, len);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    return om;
+}
+
+TEST_CASE(os_mbuf_test_compact)
+{
+    struct os_mbuf *om;
+    struct os_mbuf *om2;
+    int rc;
+    int i;
+
+    os_mbuf_test_setup();
+
+    /*** Packing several small packets leaves a single buffer. */
+    om = os_mbuf_test_compact_pkt(0, 10);
+    for (i = 1; i < 4; i++) {
+        om = os_mbuf_pack_chains(om, os_mbuf_test_compact_pkt(i * 10, 10));
+    }
+    TEST_ASSERT(SLIST_NEXT(om, om_next) == NULL);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT - 1);
+    os_mbuf_test_misc_assert_sane(om, os_mbuf_test_data, 40, 40, 8);
+
+    /*** Data spills from the head into the next buffer; leading space of the
+     *   second buffer is reclaimed and the third buffer is freed. */
+    om2 = os_mbuf_test_compact_pkt(40, 200);
+    os_mbuf_concat(om, om2);
+    om2 = os_mbuf_test_compact_pkt(240, 30);
+    os_mbuf_concat(om, om2);
+    TEST_ASSERT(os_mbuf_waste(om) >= os_mbuf_pool.omp_databuf_len);
+
+    rc = os_mbuf_compact_wasteful(om);
+    TEST_ASSERT(rc == 1);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT - 2);
+    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(om) == 0);
+    om2 = SLIST_NEXT(om, om_next);
+    TEST_ASSERT_FATAL(om2 != NULL);
+    TEST_ASSERT(SLIST_NEXT(om2, om_next) == NULL);
+    TEST_ASSERT(OS_MBUF_LEADINGSPACE(om2) == 0);
+    TEST_ASSERT(om->om_len + om2->om_len == 270);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 270);
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, os_mbuf_test_data, 270) == 0);
+
+    /*** A dense chain is left alone. */
+    TEST_ASSERT(os_mbuf_compact_wasteful(om) == 0);
+    TEST_ASSERT(os_mbuf_compact(om) == 0);
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, os_mbuf_test_data, 270) == 0);
+
+    rc = os_mbuf_free_chain(om);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT);
+}
@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+static int os_mbuf_test_ext_freed;
+
+static void
+os_mbuf_test_ext_free(struct os_mbuf_ext *ext)
+{
+    os_mbuf_test_ext_freed++;
+}
+
+TEST_CASE(os_mbuf_test_ext)
+{
+    struct os_mbuf_ext ext;
+    struct os_mbuf *head;
+    struct os_mbuf *dup;
+    struct os_mbuf *om;
+    int rc;
+
+    os_mbuf_test_setup();
+    os_mbuf_test_ext_freed = 0;
+
+    os_mbuf_ext_init(&ext, os_mbuf_test_data, sizeof os_mbuf_test_data,
+                     os_mbuf_test_ext_free, NULL);
+
+    /* Out of range references are rejected. */
+    om = os_mbuf_get_ext(&os_mbuf_pool, &ext, sizeof os_mbuf_test_data, 1);
+    TEST_ASSERT(om == NULL);
+
+    om = os_mbuf_get_ext(&os_mbuf_pool, &ext, 0, sizeof os_mbuf_test_data);
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT(OS_MBUF_IS_EXT(om));
+    TEST_ASSERT(om->om_data == os_mbuf_test_data);
+    TEST_ASSERT(OS_MBUF_TRAILINGSPACE(om) == 0);
+    TEST_ASSERT(OS_MBUF_LEADINGSPACE(om) == 0);
+    TEST_ASSERT(ext.ome_refcnt == 1);
+
+    /* Chain it behind a packet header; appendfrom shares the data. */
+    head = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(head != NULL);
+    rc = os_mbuf_appendfrom(head, om, 100, 500);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(ext.ome_refcnt == 2);
+    TEST_ASSERT(OS_MBUF_PKTLEN(head) == 500);
+    TEST_ASSERT(os_mbuf_cmpf(head, 0, os_mbuf_test_data + 100, 500) == 0);
+
+    /* Appending after an external mbuf allocates a regular one. */
+    rc = os_mbuf_append(head, os_mbuf_test_data, 10);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(OS_MBUF_PKTLEN(head) == 510);
+    TEST_ASSERT(ext.ome_refcnt == 2);
+
+    /* Duplicating the chain shares the external data too. */
+    dup = os_mbuf_dup(head);
+    TEST_ASSERT_FATAL(dup != NULL);
+    TEST_ASSERT(ext.ome_refcnt == 3);
+    TEST_ASSERT(os_mbuf_cmpm(head, 0, dup, 0, 510) == 0);
+
+    os_mbuf_free_chain(om);
+    os_mbuf_free_chain(dup);
+    TEST_ASSERT(os_mbuf_test_ext_freed == 0);
+    os_mbuf_free_chain(head);
+    TEST_ASSERT(ext.ome_refcnt == 0);
+    TEST_ASSERT(os_mbuf_test_ext_freed == 1);
+}
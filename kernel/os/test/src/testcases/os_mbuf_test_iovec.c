@@ -0,0 +1,64 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+TEST_CASE(os_mbuf_test_iovec)
+{
+    struct os_mbuf_iovec iov[4];
+    struct os_mbuf *om;
+    int off;
+    int rc;
+    int i;
+
+    os_mbuf_test_setup();
+
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL, "Error allocating mbuf");
+
+    /* Spread the test data over three mbufs. */
+    rc = os_mbuf_append(om, os_mbuf_test_data, 600);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT_FATAL(OS_MBUF_PKTLEN(om) == 600);
+
+    rc = os_mbuf_iovec(om, 100, 400, iov, 4);
+    TEST_ASSERT_FATAL(rc == 2 || rc == 3, "Unexpected segment count %d", rc);
+
+    off = 100;
+    for (i = 0; i < rc; i++) {
+        TEST_ASSERT(iov[i].oiov_len > 0);
+        TEST_ASSERT(memcmp(iov[i].oiov_base, os_mbuf_test_data + off,
+                           iov[i].oiov_len) == 0);
+        off += iov[i].oiov_len;
+    }
+    TEST_ASSERT(off == 500);
+
+    /* The whole chain in a single segment is impossible. */
+    rc = os_mbuf_iovec(om, 0, 600, iov, 1);
+    TEST_ASSERT(rc == -1);
+
+    /* Reading past the end of the chain fails. */
+    rc = os_mbuf_iovec(om, 500, 101, iov, 4);
+    TEST_ASSERT(rc == -1);
+
+    /* A zero length request needs no segments. */
+    rc = os_mbuf_iovec(om, 600, 0, iov, 4);
+    TEST_ASSERT(rc == 0);
+
+    os_mbuf_free_chain(om);
+}
@@ -0,0 +1,133 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#if MYNEWT_VAL(OS_MQUEUE_FLOW)
+static int os_mbuf_test_mqueue_flow_calls;
+static int os_mbuf_test_mqueue_flow_state;
+
+static void
+os_mbuf_test_mqueue_flow_cb(struct os_mqueue *mq, int congested)
+{
+    os_mbuf_test_mqueue_flow_calls++;
+    os_mbuf_test_mqueue_flow_state = congested;
+}
+#endif
+
+TEST_CASE(os_mbuf_test_mqueue)
+{
+#if MYNEWT_VAL(OS_MQUEUE_FLOW)
+    struct os_eventq evq;
+    struct os_mqueue mq;
+    struct os_mbuf *om;
+#if MYNEWT_VAL(OS_MQUEUE_PACK)
+    struct os_mbuf *om2;
+#endif
+    int rc;
+    int i;
+
+    os_mbuf_test_setup();
+    os_eventq_init(&evq);
+
+    rc = os_mqueue_init(&mq, NULL, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = os_mqueue_flow_set(&mq, 2, 2, 0, NULL);
+    TEST_ASSERT(rc == OS_EINVAL);
+    rc = os_mqueue_flow_set(&mq, 4, 1, OS_MQUEUE_F_BATCH,
+                            os_mbuf_test_mqueue_flow_cb);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Fill to the high watermark; only the first put posts the event */
+    for (i = 0; i < 4; i++) {
+        om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+        TEST_ASSERT_FATAL(om != NULL);
+        rc = os_mqueue_put(&mq, &evq, om);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT(mq.mq_depth == 4);
+    TEST_ASSERT(mq.mq_max_depth == 4);
+    TEST_ASSERT(mq.mq_posts == 1);
+    TEST_ASSERT(os_mqueue_congested(&mq));
+    TEST_ASSERT(os_mbuf_test_mqueue_flow_calls == 1);
+    TEST_ASSERT(os_mbuf_test_mqueue_flow_state == 1);
+
+    /* Congested; the producer keeps the mbuf */
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mqueue_put(&mq, &evq, om);
+    TEST_ASSERT(rc == OS_EBUSY);
+    TEST_ASSERT(mq.mq_drops == 1);
+    os_mbuf_free_chain(om);
+
+    /* Still congested above the low watermark */
+    os_mbuf_free_chain(os_mqueue_get(&mq));
+    os_mbuf_free_chain(os_mqueue_get(&mq));
+    TEST_ASSERT(os_mqueue_congested(&mq));
+    TEST_ASSERT(os_mbuf_test_mqueue_flow_calls == 1);
+
+    os_mbuf_free_chain(os_mqueue_get(&mq));
+    TEST_ASSERT(!os_mqueue_congested(&mq));
+    TEST_ASSERT(os_mbuf_test_mqueue_flow_calls == 2);
+    TEST_ASSERT(os_mbuf_test_mqueue_flow_state == 0);
+
+    os_mbuf_free_chain(os_mqueue_get(&mq));
+    TEST_ASSERT(os_mqueue_get(&mq) == NULL);
+    TEST_ASSERT(mq.mq_depth == 0);
+
+    /* A put on the drained queue posts again */
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mqueue_put(&mq, &evq, om);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(mq.mq_posts == 2);
+    os_eventq_remove(&evq, &mq.mq_ev);
+    os_mbuf_free_chain(os_mqueue_get(&mq));
+
+#if MYNEWT_VAL(OS_MQUEUE_PACK)
+    /* A packet spread thinly over three buffers comes out in one */
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+    TEST_ASSERT_FATAL(om != NULL);
+    rc = os_mbuf_append(om, os_mbuf_test_data, 10);
+    TEST_ASSERT_FATAL(rc == 0);
+    for (i = 1; i < 3; i++) {
+        om2 = os_mbuf_get_pkthdr(&os_mbuf_pool, 0);
+        TEST_ASSERT_FATAL(om2 != NULL);
+        rc = os_mbuf_append(om2, os_mbuf_test_data + i * 10, 10);
+        TEST_ASSERT_FATAL(rc == 0);
+        os_mbuf_concat(om, om2);
+    }
+    TEST_ASSERT_FATAL(os_mbuf_mempool.mp_num_free ==
+                      MBUF_TEST_POOL_BUF_COUNT - 3);
+
+    rc = os_mqueue_put(&mq, &evq, om);
+    TEST_ASSERT_FATAL(rc == 0);
+    os_eventq_remove(&evq, &mq.mq_ev);
+    om = os_mqueue_get(&mq);
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT(SLIST_NEXT(om, om_next) == NULL);
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT - 1);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 30);
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, os_mbuf_test_data, 30) == 0);
+    os_mbuf_free_chain(om);
+#endif
+
+    TEST_ASSERT(os_mbuf_mempool.mp_num_free == MBUF_TEST_POOL_BUF_COUNT);
+#endif
+}
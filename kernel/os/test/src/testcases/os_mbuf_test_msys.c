@@ -0,0 +1,87 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#define MBUF_TEST_MSYS_SMALL_SIZE   (64)
+#define MBUF_TEST_MSYS_SMALL_COUNT  (2)
+
+static os_membuf_t os_mbuf_test_small_membuf[
+    OS_MEMPOOL_SIZE(MBUF_TEST_MSYS_SMALL_COUNT, MBUF_TEST_MSYS_SMALL_SIZE)];
+static struct os_mempool os_mbuf_test_small_mempool;
+static struct os_mbuf_pool os_mbuf_test_small_pool;
+
+TEST_CASE(os_mbuf_test_msys)
+{
+    struct os_mbuf *small[MBUF_TEST_MSYS_SMALL_COUNT];
+    struct os_mbuf *m;
+    int rc;
+    int i;
+
+    os_mbuf_test_setup();
+
+    rc = os_mempool_init(&os_mbuf_test_small_mempool,
+                         MBUF_TEST_MSYS_SMALL_COUNT,
+                         MBUF_TEST_MSYS_SMALL_SIZE,
+                         os_mbuf_test_small_membuf, "mbuf_small");
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_mbuf_pool_init(&os_mbuf_test_small_pool,
+                           &os_mbuf_test_small_mempool,
+                           MBUF_TEST_MSYS_SMALL_SIZE,
+                           MBUF_TEST_MSYS_SMALL_COUNT);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Register the large pool first; msys must still sort them. */
+    os_msys_reset();
+    os_msys_register(&os_mbuf_pool);
+    os_msys_register(&os_mbuf_test_small_pool);
+
+    /* Small requests come from the small pool. */
+    for (i = 0; i < MBUF_TEST_MSYS_SMALL_COUNT; i++) {
+        small[i] = os_msys_get(16, 0);
+        TEST_ASSERT_FATAL(small[i] != NULL);
+        TEST_ASSERT(small[i]->om_omp == &os_mbuf_test_small_pool);
+    }
+    TEST_ASSERT(os_mbuf_test_small_pool.omp_msys_hits ==
+                MBUF_TEST_MSYS_SMALL_COUNT);
+
+    /* Large requests come from the large pool. */
+    m = os_msys_get(MBUF_TEST_MSYS_SMALL_SIZE * 2, 0);
+    TEST_ASSERT_FATAL(m != NULL);
+    TEST_ASSERT(m->om_omp == &os_mbuf_pool);
+    TEST_ASSERT(os_mbuf_pool.omp_msys_hits == 1);
+    os_mbuf_free(m);
+
+    /* The small pool is now empty. */
+    m = os_msys_get(16, 0);
+    TEST_ASSERT(os_mbuf_test_small_pool.omp_msys_misses == 1);
+#if MYNEWT_VAL(MSYS_FALLBACK_LARGER)
+    TEST_ASSERT_FATAL(m != NULL);
+    TEST_ASSERT(m->om_omp == &os_mbuf_pool);
+    TEST_ASSERT(os_mbuf_pool.omp_msys_hits == 2);
+    os_mbuf_free(m);
+#else
+    TEST_ASSERT(m == NULL);
+#endif
+
+    for (i = 0; i < MBUF_TEST_MSYS_SMALL_COUNT; i++) {
+        os_mbuf_free(small[i]);
+    }
+
+    os_msys_reset();
+}
@@ -0,0 +1,65 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+TEST_CASE(os_mbuf_test_split)
+{
+    struct os_mbuf *second;
+    struct os_mbuf *tail;
+    struct os_mbuf *rest;
+    struct os_mbuf *om;
+    int rc;
+
+    os_mbuf_test_setup();
+
+    om = os_mbuf_get_pkthdr(&os_mbuf_pool, sizeof(uint32_t));
+    TEST_ASSERT_FATAL(om != NULL, "Error allocating mbuf");
+    *(uint32_t *)OS_MBUF_USRHDR(om) = 0x12345678;
+
+    rc = os_mbuf_append(om, os_mbuf_test_data, 600);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Split in the middle of an mbuf. */
+    tail = os_mbuf_split(om, 100);
+    TEST_ASSERT_FATAL(tail != NULL);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 100);
+    TEST_ASSERT(OS_MBUF_PKTLEN(tail) == 500);
+    TEST_ASSERT(*(uint32_t *)OS_MBUF_USRHDR(tail) == 0x12345678);
+    TEST_ASSERT(os_mbuf_cmpf(om, 0, os_mbuf_test_data, 100) == 0);
+    TEST_ASSERT(os_mbuf_cmpf(tail, 0, os_mbuf_test_data + 100, 500) == 0);
+
+    /* Split on an mbuf boundary; the mbuf is moved, not copied. */
+    second = SLIST_NEXT(SLIST_NEXT(tail, om_next), om_next);
+    TEST_ASSERT_FATAL(second != NULL);
+    rest = os_mbuf_split(tail, SLIST_NEXT(tail, om_next)->om_len);
+    TEST_ASSERT_FATAL(rest != NULL);
+    TEST_ASSERT(SLIST_NEXT(rest, om_next) == second);
+    TEST_ASSERT(OS_MBUF_PKTLEN(tail) + OS_MBUF_PKTLEN(rest) == 500);
+    TEST_ASSERT(os_mbuf_cmpf(rest, 0,
+                             os_mbuf_test_data + 100 + OS_MBUF_PKTLEN(tail),
+                             OS_MBUF_PKTLEN(rest)) == 0);
+
+    /* The split point must be inside the packet. */
+    TEST_ASSERT(os_mbuf_split(om, 100) == NULL);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) == 100);
+
+    os_mbuf_free_chain(om);
+    os_mbuf_free_chain(tail);
+    os_mbuf_free_chain(rest);
+}
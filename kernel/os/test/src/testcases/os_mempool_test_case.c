@@ -47,6 +47,11 @@ mempool_test(int num_blocks, int block_size)
     TEST_ASSERT(g_TstMempool.mp_num_free == num_blocks,
                 "Number of free blocks not equal to total blocks!");
 
+    TEST_ASSERT(g_TstMempool.mp_min_free == num_blocks,
+                "Low-water mark not equal to total blocks!");
+    TEST_ASSERT(g_TstMempool.mp_num_fail == 0,
+                "Failure count not zero after init!");
+
     TEST_ASSERT(SLIST_FIRST(&g_TstMempool) == (void *)&TstMembuf[0],
                 "Free list pointer does not point to first block!");
 
@@ -135,6 +140,14 @@ mempool_test(int num_blocks, int block_size)
                 "Got all blocks but number free not zero! (%d)",
                 g_TstMempool.mp_num_free);
 
+    /* The get that came back empty should have been counted. */
+    TEST_ASSERT(g_TstMempool.mp_min_free == 0,
+                "Low-water mark not zero after draining pool! (%d)",
+                g_TstMempool.mp_min_free);
+    TEST_ASSERT(g_TstMempool.mp_num_fail == 1,
+                "Failure count incorrect (%u vs 1)",
+                (unsigned)g_TstMempool.mp_num_fail);
+
     /* Now put them all back */
     for (cnt = 0; cnt < g_TstMempool.mp_num_blocks; ++cnt) {
         rc = os_memblock_put(&g_TstMempool, block_array[cnt]);
@@ -147,6 +160,10 @@ mempool_test(int num_blocks, int block_size)
     TEST_ASSERT(g_TstMempool.mp_num_free == g_TstMempool.mp_num_blocks,
                 "Put all blocks but number free not equal to total!");
 
+    /* Returning blocks must not raise the low-water mark. */
+    TEST_ASSERT(g_TstMempool.mp_min_free == 0,
+                "Low-water mark changed when blocks were returned!");
+
     /* Better get error when we try these things! */
     rc = os_memblock_put(NULL, block_array[0]);
     TEST_ASSERT(rc != 0,
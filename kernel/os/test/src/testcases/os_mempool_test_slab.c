@@ -0,0 +1,69 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <string.h>
+#include "os_test_priv.h"
+
+#define SLAB_TEST_ALLOCS    (MYNEWT_VAL(OS_MALLOC_SLAB_16) + 4)
+
+TEST_CASE(os_mempool_test_slab)
+{
+#if MYNEWT_VAL(OS_MALLOC_SLAB)
+    uint8_t *ptrs[SLAB_TEST_ALLOCS];
+    uint8_t *p;
+    int i;
+    int j;
+
+    /* More allocations than the 16 byte class holds; the rest use the heap */
+    for (i = 0; i < SLAB_TEST_ALLOCS; i++) {
+        ptrs[i] = os_malloc(12);
+        TEST_ASSERT_FATAL(ptrs[i] != NULL);
+        memset(ptrs[i], i, 12);
+        for (j = 0; j < i; j++) {
+            TEST_ASSERT(ptrs[j] != ptrs[i]);
+        }
+    }
+    for (i = 0; i < SLAB_TEST_ALLOCS; i++) {
+        for (j = 0; j < 12; j++) {
+            TEST_ASSERT(ptrs[i][j] == i);
+        }
+        os_free(ptrs[i]);
+    }
+
+    /* Growing within a class keeps the block */
+    p = os_malloc(10);
+    TEST_ASSERT_FATAL(p != NULL);
+    memset(p, 0xa5, 10);
+    TEST_ASSERT(os_realloc(p, 16) == p);
+
+    /* Growing past it moves the data to a bigger class or the heap */
+    p = os_realloc(p, 200);
+    TEST_ASSERT_FATAL(p != NULL);
+    for (i = 0; i < 10; i++) {
+        TEST_ASSERT(p[i] == 0xa5);
+    }
+    p = os_realloc(p, 1000);
+    TEST_ASSERT_FATAL(p != NULL);
+    for (i = 0; i < 10; i++) {
+        TEST_ASSERT(p[i] == 0xa5);
+    }
+    os_free(p);
+
+    os_free(NULL);
+#endif
+}
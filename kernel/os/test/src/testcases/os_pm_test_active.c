@@ -0,0 +1,110 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+/*
+ * Active devices keep the system out of the sleep states they can not work
+ * in, and have their clock on exactly while active.
+ */
+TEST_CASE(os_pm_test_active)
+{
+#if MYNEWT_VAL(OS_PM) && MYNEWT_VAL(OS_SIM_VIRTUAL_TIME) && \
+    MYNEWT_VAL(SELFTEST)
+    struct os_dev *a;
+    struct os_dev *b;
+    int rc;
+    int i;
+
+    sysinit();
+    pm_test_dev_init();
+    a = &pm_test_dev[0];
+    b = &pm_test_dev[1];
+
+    /* Nested activity; the clock follows the outermost pair. */
+    rc = os_pm_dev_active(a);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(pm_test_clock_on[0] && pm_test_clock_calls[0] == 1);
+    TEST_ASSERT(pm_test_idle(PM_TEST_LONG_TICKS) == OS_PM_STATE_IDLE);
+
+    rc = os_pm_dev_active(a);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_pm_dev_idle(a);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(pm_test_clock_on[0] && pm_test_clock_calls[0] == 1);
+    TEST_ASSERT(pm_test_idle(PM_TEST_LONG_TICKS) == OS_PM_STATE_IDLE);
+
+    rc = os_pm_dev_idle(a);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!pm_test_clock_on[0] && pm_test_clock_calls[0] == 2);
+    TEST_ASSERT(pm_test_idle(PM_TEST_LONG_TICKS) == OS_PM_STATE_DEEP);
+
+    /* Unbalanced idle is refused and leaves the counts alone. */
+    TEST_ASSERT(os_pm_dev_idle(a) == OS_EINVAL);
+    TEST_ASSERT(pm_test_clock_calls[0] == 2);
+    TEST_ASSERT(pm_test_idle(PM_TEST_LONG_TICKS) == OS_PM_STATE_DEEP);
+
+    /* A device that works in sleep only limits how deep it goes. */
+    rc = os_pm_dev_max_state(b, OS_PM_STATE_SLEEP);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(pm_test_idle(PM_TEST_LONG_TICKS) == OS_PM_STATE_DEEP);
+    rc = os_pm_dev_active(b);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(pm_test_idle(PM_TEST_LONG_TICKS) == OS_PM_STATE_SLEEP);
+    TEST_ASSERT(pm_test_idle(MYNEWT_VAL(OS_PM_SLEEP_MIN_TICKS) - 1) ==
+                OS_PM_STATE_IDLE);
+
+    /* Changing the max state of an active device takes effect at once. */
+    rc = os_pm_dev_max_state(b, OS_PM_STATE_IDLE);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(pm_test_idle(PM_TEST_LONG_TICKS) == OS_PM_STATE_IDLE);
+    rc = os_pm_dev_max_state(b, OS_PM_STATE_DEEP);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(pm_test_idle(PM_TEST_LONG_TICKS) == OS_PM_STATE_DEEP);
+
+    /* Out of range states are refused. */
+    TEST_ASSERT(os_pm_dev_max_state(b, OS_PM_STATE_CNT) == OS_EINVAL);
+    TEST_ASSERT(os_pm_dev_max_state(b, -1) == OS_EINVAL);
+    TEST_ASSERT(b->od_pm_max_state == OS_PM_STATE_DEEP);
+    TEST_ASSERT(pm_test_idle(PM_TEST_LONG_TICKS) == OS_PM_STATE_DEEP);
+
+    /* The shallowest limit of all active devices wins. */
+    rc = os_pm_dev_active(a);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(pm_test_idle(PM_TEST_LONG_TICKS) == OS_PM_STATE_IDLE);
+    rc = os_pm_dev_idle(a);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_pm_dev_idle(b);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!pm_test_clock_on[0] && !pm_test_clock_on[1]);
+    TEST_ASSERT(pm_test_idle(PM_TEST_LONG_TICKS) == OS_PM_STATE_DEEP);
+
+    /* Nesting deeper than the count can hold is refused. */
+    for (i = 0; i < UINT8_MAX; i++) {
+        rc = os_pm_dev_active(a);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT(os_pm_dev_active(a) == OS_EINVAL);
+    for (i = 0; i < UINT8_MAX; i++) {
+        rc = os_pm_dev_idle(a);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    TEST_ASSERT(!pm_test_clock_on[0]);
+    TEST_ASSERT(pm_test_idle(PM_TEST_LONG_TICKS) == OS_PM_STATE_DEEP);
+#endif
+}
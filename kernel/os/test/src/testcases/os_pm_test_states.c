@@ -0,0 +1,60 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+/*
+ * With no device active, the idle task sleeps as deep as the length of the
+ * idle period allows.  Runs with the OS stopped; virtual time makes each
+ * idle period last exactly as long as asked.
+ */
+TEST_CASE(os_pm_test_states)
+{
+#if MYNEWT_VAL(OS_PM) && MYNEWT_VAL(OS_SIM_VIRTUAL_TIME) && \
+    MYNEWT_VAL(SELFTEST)
+    uint32_t ticks;
+    uint32_t deep_ticks;
+    int rc;
+
+    sysinit();
+    pm_test_dev_init();
+
+    TEST_ASSERT(pm_test_idle(MYNEWT_VAL(OS_PM_SLEEP_MIN_TICKS) - 1) ==
+                OS_PM_STATE_IDLE);
+    TEST_ASSERT(pm_test_idle(MYNEWT_VAL(OS_PM_SLEEP_MIN_TICKS)) ==
+                OS_PM_STATE_SLEEP);
+    TEST_ASSERT(pm_test_idle(MYNEWT_VAL(OS_PM_DEEP_MIN_TICKS) - 1) ==
+                OS_PM_STATE_SLEEP);
+
+    rc = os_pm_residency(OS_PM_STATE_DEEP, &deep_ticks, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(pm_test_idle(MYNEWT_VAL(OS_PM_DEEP_MIN_TICKS)) ==
+                OS_PM_STATE_DEEP);
+    TEST_ASSERT(pm_test_idle(PM_TEST_LONG_TICKS) == OS_PM_STATE_DEEP);
+    TEST_ASSERT(os_pm_idle_state() == OS_PM_STATE_IDLE);
+
+    /* Residency counts the time spent in the state. */
+    rc = os_pm_residency(OS_PM_STATE_DEEP, &ticks, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(ticks - deep_ticks ==
+                MYNEWT_VAL(OS_PM_DEEP_MIN_TICKS) + PM_TEST_LONG_TICKS);
+
+    TEST_ASSERT(os_pm_residency(OS_PM_STATE_CNT, &ticks, NULL) == OS_EINVAL);
+    TEST_ASSERT(os_pm_residency(-1, &ticks, NULL) == OS_EINVAL);
+#endif
+}
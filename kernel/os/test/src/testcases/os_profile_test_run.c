@@ -0,0 +1,103 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+static void
+profile_test_handler(void *arg)
+{
+}
+#endif
+
+/*
+ * Drives the context switch hook with the OS stopped, billing known run
+ * times to two tasks.
+ */
+TEST_CASE(os_profile_test_run)
+{
+#if MYNEWT_VAL(OS_TASK_PROFILE) && MYNEWT_VAL(SELFTEST)
+    struct os_task *a;
+    struct os_task *b;
+    uint32_t a_run;
+    uint32_t b_run;
+    uint32_t a_win;
+    int rc;
+    int i;
+
+    sysinit();
+
+    rc = os_cputime_init(PROFILE_TEST_CPUTIME_FREQ);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    for (i = 0; i < 2; i++) {
+        rc = os_task_init(&profile_test_task[i], "profile_test",
+                          profile_test_handler, NULL,
+                          PROFILE_TEST_TASK_PRIO + i, OS_WAIT_FOREVER,
+                          profile_test_stack[i], PROFILE_TEST_STACK_SIZE);
+        TEST_ASSERT_FATAL(rc == 0);
+    }
+    a = &profile_test_task[0];
+    b = &profile_test_task[1];
+
+    /*
+     * The first switch ever starts the first window, and any later one a
+     * full window after the previous switch rolls it over: either way, a
+     * fresh window begins at the second of these.
+     */
+    os_sched_set_current_task(a);
+    profile_test_switch(b, PROFILE_TEST_WIN_TICKS);
+    profile_test_switch(a, PROFILE_TEST_WIN_TICKS);
+    a_run = a->t_prof_run;
+    b_run = b->t_prof_run;
+    a_win = a->t_prof_win_run;
+
+    /* Run time accumulates over several turns on the CPU. */
+    profile_test_switch(b, 30);
+    profile_test_switch(a, 10);
+    TEST_ASSERT(a->t_prof_run - a_run == profile_test_ticks(30));
+    TEST_ASSERT(b->t_prof_run - b_run == profile_test_ticks(10));
+
+    profile_test_switch(b, PROFILE_TEST_WIN_TICKS - 60);
+    TEST_ASSERT(a->t_prof_run - a_run ==
+                profile_test_ticks(PROFILE_TEST_WIN_TICKS - 30));
+    TEST_ASSERT(a->t_prof_max_run >= profile_test_ticks(30));
+    TEST_ASSERT(a->t_prof_preempts == 3);
+    TEST_ASSERT(a->t_prof_yields == 0);
+
+    /* Nothing new is reported until the window is over. */
+    TEST_ASSERT(a->t_prof_win_run == a_win);
+
+    /* The window ends at this switch and rolls over. */
+    profile_test_switch(a, 20);
+    TEST_ASSERT(b->t_prof_run - b_run == profile_test_ticks(30));
+    TEST_ASSERT(a->t_prof_win_run ==
+                profile_test_ticks(PROFILE_TEST_WIN_TICKS - 30));
+    TEST_ASSERT(b->t_prof_win_run == profile_test_ticks(30));
+    TEST_ASSERT(os_prof_cpu_pct(a) ==
+                (uint64_t)(PROFILE_TEST_WIN_TICKS - 30) * 100 /
+                PROFILE_TEST_WIN_TICKS);
+    TEST_ASSERT(os_prof_cpu_pct(b) == 30 * 100 / PROFILE_TEST_WIN_TICKS);
+
+    /* A window in which b did not run reports no CPU for it. */
+    profile_test_switch(b, PROFILE_TEST_WIN_TICKS);
+    TEST_ASSERT(a->t_prof_win_run == profile_test_ticks(PROFILE_TEST_WIN_TICKS));
+    TEST_ASSERT(b->t_prof_win_run == 0);
+    TEST_ASSERT(os_prof_cpu_pct(a) == 100);
+#endif
+}
@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+/*
+ * Runs the sanity checks by hand, with the OS stopped, and follows the
+ * interval as the checks go from healthy to failing and back.  Then, with
+ * SANITY_IDLE_PIGGYBACK, starts the OS to see the idle task run them.
+ */
+TEST_CASE(os_sanity_test_adaptive)
+{
+#if MYNEWT_VAL(SANITY_ADAPTIVE) && MYNEWT_VAL(SELFTEST)
+    struct os_sanity_check sc_func;
+    struct os_sanity_check sc_task;
+    os_time_t itvl;
+    int rc;
+    int i;
+
+    sysinit();
+
+    TEST_ASSERT(os_sanity_itvl_get() == SANITY_TEST_ITVL_TICKS);
+    TEST_ASSERT_FATAL(SANITY_TEST_ITVL_TICKS < SANITY_TEST_MAX_ITVL_TICKS / 2);
+
+    sanity_test_rc = 0;
+    os_sanity_check_init(&sc_func);
+    OS_SANITY_CHECK_SETFUNC(&sc_func, sanity_test_check, NULL, 10);
+    rc = os_sanity_check_register(&sc_func);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Healthy runs back off, up to the maximum. */
+    os_sanity_run();
+    TEST_ASSERT(os_sanity_itvl_get() == 2 * SANITY_TEST_ITVL_TICKS);
+    itvl = os_sanity_itvl_get();
+    for (i = 0; i < 8; i++) {
+        os_sanity_run();
+        TEST_ASSERT(os_sanity_itvl_get() >= itvl);
+        itvl = os_sanity_itvl_get();
+    }
+    TEST_ASSERT(itvl == SANITY_TEST_MAX_ITVL_TICKS);
+#if MYNEWT_VAL(SANITY_STATS)
+    TEST_ASSERT(sc_func.sc_num_runs == 9);
+#endif
+
+    /* A failing check drops straight back to the base interval. */
+    sanity_test_rc = 1;
+    os_sanity_run();
+    TEST_ASSERT(os_sanity_itvl_get() == SANITY_TEST_ITVL_TICKS);
+
+    sanity_test_rc = 0;
+    os_sanity_run();
+    TEST_ASSERT(os_sanity_itvl_get() == 2 * SANITY_TEST_ITVL_TICKS);
+
+    /* So does a task more than halfway to its checkin deadline. */
+    os_sanity_check_init(&sc_task);
+    sc_task.sc_checkin_itvl = 100;
+    rc = os_sanity_check_register(&sc_task);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = os_sanity_check_reset(&sc_task);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    os_time_advance(40);
+    os_sanity_run();
+    TEST_ASSERT(os_sanity_itvl_get() == 4 * SANITY_TEST_ITVL_TICKS ||
+                os_sanity_itvl_get() == SANITY_TEST_MAX_ITVL_TICKS);
+
+    os_time_advance(20);
+    os_sanity_run();
+    TEST_ASSERT(os_sanity_itvl_get() == SANITY_TEST_ITVL_TICKS);
+
+    rc = os_sanity_check_reset(&sc_task);
+    TEST_ASSERT_FATAL(rc == 0);
+    os_sanity_run();
+    TEST_ASSERT(os_sanity_itvl_get() == 2 * SANITY_TEST_ITVL_TICKS);
+
+#if MYNEWT_VAL(SANITY_IDLE_PIGGYBACK)
+    sysinit();
+
+    sanity_test_rc = 0;
+    sanity_test_runs = 0;
+    os_sanity_check_init(&sc_func);
+    OS_SANITY_CHECK_SETFUNC(&sc_func, sanity_test_check, NULL, 10);
+    rc = os_sanity_check_register(&sc_func);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    os_task_init(&sanity_test_task, "sanity_test", sanity_test_idle_handler,
+        NULL, SANITY_TEST_TASK_PRIO, OS_WAIT_FOREVER, sanity_test_stack,
+        SANITY_TEST_STACK_SIZE);
+
+    os_start();
+#endif
+#endif
+}
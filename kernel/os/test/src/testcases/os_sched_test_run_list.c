@@ -0,0 +1,97 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+/* Priorities span several words of the ready bitmap. */
+#define SCHED_TEST_PRIO_HI      (5)
+#define SCHED_TEST_PRIO_A       (10)
+#define SCHED_TEST_PRIO_B       (35)
+#define SCHED_TEST_PRIO_LO      (70)
+
+TEST_CASE(os_sched_test_run_list)
+{
+#if MYNEWT_VAL(SELFTEST)
+    /* Tasks 0-2 share priority A, 3-4 share B. */
+    static const int order_init[] = { 5, 0, 1, 2, 3, 4, 6 };
+    static const int order_mid[] = { 5, 0, 2, 3, 4, 6 };
+    static const int order_mid_back[] = { 5, 0, 2, 1, 3, 4, 6 };
+    static const int order_head[] = { 5, 2, 1, 3, 4, 6 };
+    static const int order_head_back[] = { 5, 2, 1, 0, 3, 4, 6 };
+    static const int order_no_b[] = { 5, 2, 1, 0, 6 };
+    static const int order_b_back[] = { 5, 2, 1, 0, 4, 3, 6 };
+    static const int order_no_hi[] = { 2, 1, 0, 4, 3, 6 };
+    static const int order_new[] = { 7, 2, 1, 0, 4, 3, 6 };
+    static const int order_resort[] = { 7, 1, 0, 4, 3, 2, 6 };
+
+    sysinit();
+
+    /* Equal priorities run in the order they became ready. */
+    sched_test_task_init(0, SCHED_TEST_PRIO_A);
+    sched_test_task_init(3, SCHED_TEST_PRIO_B);
+    sched_test_task_init(1, SCHED_TEST_PRIO_A);
+    sched_test_task_init(5, SCHED_TEST_PRIO_HI);
+    sched_test_task_init(2, SCHED_TEST_PRIO_A);
+    sched_test_task_init(6, SCHED_TEST_PRIO_LO);
+    sched_test_task_init(4, SCHED_TEST_PRIO_B);
+    TEST_ASSERT(sched_test_run_list_is(order_init, 7));
+
+    /* Middle of a band; it comes back at the end of it. */
+    sched_test_remove(1);
+    TEST_ASSERT(sched_test_run_list_is(order_mid, 6));
+    sched_test_restore(1);
+    TEST_ASSERT(sched_test_run_list_is(order_mid_back, 7));
+
+    /* Tail of a band; the task before it becomes the tail. */
+    sched_test_remove(1);
+    TEST_ASSERT(sched_test_run_list_is(order_mid, 6));
+    sched_test_restore(1);
+    TEST_ASSERT(sched_test_run_list_is(order_mid_back, 7));
+
+    /* Head of a band. */
+    sched_test_remove(0);
+    TEST_ASSERT(sched_test_run_list_is(order_head, 6));
+    sched_test_restore(0);
+    TEST_ASSERT(sched_test_run_list_is(order_head_back, 7));
+
+    /*
+     * Empty band B; a task below it, and then B itself, must land after
+     * the tail of A, found through the bitmap.
+     */
+    sched_test_remove(3);
+    sched_test_remove(4);
+    TEST_ASSERT(sched_test_run_list_is(order_no_b, 5));
+    sched_test_remove(6);
+    sched_test_restore(6);
+    TEST_ASSERT(sched_test_run_list_is(order_no_b, 5));
+    sched_test_restore(4);
+    sched_test_restore(3);
+    TEST_ASSERT(sched_test_run_list_is(order_b_back, 7));
+
+    /* Head of the whole list, alone at its priority. */
+    sched_test_remove(5);
+    TEST_ASSERT(sched_test_run_list_is(order_no_hi, 6));
+    sched_test_task_init(7, SCHED_TEST_PRIO_HI);
+    TEST_ASSERT(sched_test_run_list_is(order_new, 7));
+
+    /* A priority change moves the task to the end of its new band. */
+    sched_test_tasks[2].t_prio = SCHED_TEST_PRIO_B;
+    os_sched_resort(&sched_test_tasks[2]);
+    TEST_ASSERT(sched_test_run_list_is(order_resort, 7));
+#endif
+}
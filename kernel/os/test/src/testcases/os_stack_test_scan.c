@@ -0,0 +1,91 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+#if MYNEWT_VAL(OS_STACK_SCAN)
+static void
+stack_test_handler(void *arg)
+{
+}
+
+static uint16_t
+stack_test_reported(void)
+{
+    struct os_task_info oti;
+    struct os_task *t;
+
+    t = NULL;
+    while ((t = os_task_info_get_next(t, &oti)) != NULL) {
+        if (t == &stack_test_task) {
+            return oti.oti_stkusage;
+        }
+    }
+
+    return 0;
+}
+#endif
+
+/*
+ * Runs the stack scan with the OS stopped, over a stack used to known
+ * depths.
+ */
+TEST_CASE(os_stack_test_scan)
+{
+#if MYNEWT_VAL(OS_STACK_SCAN) && MYNEWT_VAL(SELFTEST)
+    int deep;
+    int rc;
+
+    sysinit();
+
+    stack_test_alerts = 0;
+    os_task_stack_alert_set(stack_test_alert);
+
+    rc = os_task_init(&stack_test_task, "stack_test", stack_test_handler,
+                      NULL, STACK_TEST_TASK_PRIO, OS_WAIT_FOREVER,
+                      stack_test_stack, STACK_TEST_STACK_SIZE);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Half the stack used: plenty of headroom. */
+    stack_test_dirty(STACK_TEST_STACK_SIZE / 2);
+    stack_test_scan();
+    TEST_ASSERT(stack_test_task.t_stack_hwm == STACK_TEST_STACK_SIZE / 2);
+    TEST_ASSERT(stack_test_reported() == STACK_TEST_STACK_SIZE / 2);
+    TEST_ASSERT(!(stack_test_task.t_flags & OS_TASK_FLAG_STACK_ALERT));
+    TEST_ASSERT(stack_test_alerts == 0);
+
+    /* Headroom below the alert threshold; the alert fires once. */
+    deep = STACK_TEST_STACK_SIZE -
+           STACK_TEST_STACK_SIZE * MYNEWT_VAL(OS_STACK_ALERT_PCT) / 200;
+    stack_test_dirty(deep);
+    stack_test_scan();
+    TEST_ASSERT(stack_test_task.t_stack_hwm == deep);
+    TEST_ASSERT(stack_test_reported() == deep);
+    TEST_ASSERT(stack_test_task.t_flags & OS_TASK_FLAG_STACK_ALERT);
+    TEST_ASSERT(stack_test_alerts == 1);
+    TEST_ASSERT(stack_test_headroom == STACK_TEST_STACK_SIZE - deep);
+
+    /* Deeper still: the mark follows, but there is no second alert. */
+    stack_test_dirty(STACK_TEST_STACK_SIZE - 1);
+    stack_test_scan();
+    TEST_ASSERT(stack_test_task.t_stack_hwm == STACK_TEST_STACK_SIZE - 1);
+    TEST_ASSERT(stack_test_alerts == 1);
+
+    os_task_stack_alert_set(NULL);
+#endif
+}
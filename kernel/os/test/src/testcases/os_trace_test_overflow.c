@@ -0,0 +1,91 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+TEST_CASE(os_trace_test_overflow)
+{
+#if MYNEWT_VAL(OS_TRACE) && MYNEWT_VAL(SELFTEST)
+    int overflows;
+    int cnt;
+    int i;
+
+    sysinit();
+
+    trace_test_drain();
+
+    /* Starting the trace leads with an INFO record. */
+    os_trace_enable(1);
+    cnt = os_trace_read(trace_test_recs, TRACE_TEST_ENTRIES);
+    TEST_ASSERT_FATAL(cnt == 1);
+    TEST_ASSERT(trace_test_recs[0].otr_id == OS_TRACE_ID_INFO);
+    TEST_ASSERT(trace_test_recs[0].otr_p16 == OS_TRACE_VERSION);
+
+    /* Fill the ring, then overrun it. */
+    for (i = 0; i < TRACE_TEST_ENTRIES; i++) {
+        os_trace_rec(TRACE_TEST_ID_FILL, i, 0);
+    }
+    for (i = 0; i < 5; i++) {
+        os_trace_rec(TRACE_TEST_ID_LOST, i, 0);
+    }
+
+    /* One free slot is not enough for the OVERFLOW record and another. */
+    cnt = os_trace_read(trace_test_recs, 1);
+    TEST_ASSERT_FATAL(cnt == 1);
+    TEST_ASSERT(trace_test_recs[0].otr_p16 == 0);
+    os_trace_rec(TRACE_TEST_ID_LOST, 5, 0);
+
+    cnt = os_trace_read(trace_test_recs, 1);
+    TEST_ASSERT_FATAL(cnt == 1);
+    TEST_ASSERT(trace_test_recs[0].otr_p16 == 1);
+    os_trace_rec(TRACE_TEST_ID_AFTER, 0, 0);
+
+    cnt = os_trace_read(trace_test_recs, TRACE_TEST_ENTRIES);
+    TEST_ASSERT_FATAL(cnt == TRACE_TEST_ENTRIES);
+
+    /* The rest of the fill, in order... */
+    for (i = 0; i < TRACE_TEST_ENTRIES - 2; i++) {
+        TEST_ASSERT(trace_test_recs[i].otr_id == TRACE_TEST_ID_FILL);
+        TEST_ASSERT(trace_test_recs[i].otr_p16 == i + 2);
+    }
+
+    /* ...one OVERFLOW counting every record lost, then what followed. */
+    TEST_ASSERT(trace_test_recs[i].otr_id == OS_TRACE_ID_OVERFLOW);
+    TEST_ASSERT(trace_test_recs[i].otr_p32 == 6);
+    TEST_ASSERT(trace_test_recs[i + 1].otr_id == TRACE_TEST_ID_AFTER);
+    TEST_ASSERT(trace_test_recs[i + 1].otr_p16 == 0);
+
+    overflows = 0;
+    for (i = 0; i < cnt; i++) {
+        if (trace_test_recs[i].otr_id == OS_TRACE_ID_OVERFLOW) {
+            overflows++;
+        }
+    }
+    TEST_ASSERT(overflows == 1);
+
+    /* The drop count was reported; nothing more is owed. */
+    os_trace_rec(TRACE_TEST_ID_AFTER, 1, 0);
+    cnt = os_trace_read(trace_test_recs, TRACE_TEST_ENTRIES);
+    TEST_ASSERT(cnt == 1);
+    TEST_ASSERT(trace_test_recs[0].otr_id == TRACE_TEST_ID_AFTER);
+    TEST_ASSERT(trace_test_recs[0].otr_p16 == 1);
+
+    trace_test_drain();
+    os_trace_enable(MYNEWT_VAL(OS_TRACE_START));
+#endif
+}
@@ -0,0 +1,32 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "os_test_priv.h"
+
+TEST_CASE(os_work_test_post)
+{
+#if MYNEWT_VAL(OS_WORK) && MYNEWT_VAL(SELFTEST)
+    sysinit();
+
+    os_task_init(&work_test_task, "work_test", work_test_post_handler, NULL,
+        WORK_TEST_TASK_PRIO, OS_WAIT_FOREVER, work_test_stack,
+        WORK_TEST_STACK_SIZE);
+
+    os_start();
+#endif
+}
@@ -0,0 +1,82 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <sys/time.h>
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os_test_priv.h"
+
+#if MYNEWT_VAL(OS_SIM_VIRTUAL_TIME)
+struct os_task time_test_task;
+os_stack_t time_test_stack[TIME_TEST_STACK_SIZE];
+
+static struct os_eventq time_test_evq;
+static struct os_callout time_test_callout;
+static os_time_t time_test_fired;
+
+static void
+time_test_callout_cb(struct os_event *ev)
+{
+    time_test_fired = os_time_get();
+}
+
+/*
+ * With every task blocked, time must jump to the next deadline rather than
+ * follow the host clock.
+ */
+void
+time_test_virtual_handler(void *arg)
+{
+    struct timeval tv_start;
+    struct timeval tv_end;
+    struct timeval tv_diff;
+    os_time_t start;
+    int rc;
+
+    gettimeofday(&tv_start, NULL);
+
+    start = os_time_get();
+    os_time_delay(TIME_TEST_LONG_TICKS);
+    TEST_ASSERT(os_time_get() - start == TIME_TEST_LONG_TICKS);
+
+    os_eventq_init(&time_test_evq);
+    os_callout_init(&time_test_callout, &time_test_evq, time_test_callout_cb,
+                    NULL);
+    start = os_time_get();
+    rc = os_callout_reset(&time_test_callout, TIME_TEST_LONG_TICKS);
+    TEST_ASSERT_FATAL(rc == 0);
+    os_eventq_run(&time_test_evq);
+    TEST_ASSERT(time_test_fired - start == TIME_TEST_LONG_TICKS);
+    TEST_ASSERT(os_time_get() == time_test_fired);
+
+    /* Two hours of OS time went by in a fraction of that on the host. */
+    gettimeofday(&tv_end, NULL);
+    timersub(&tv_end, &tv_start, &tv_diff);
+    TEST_ASSERT(tv_diff.tv_sec < TIME_TEST_LONG_SECS / 60);
+
+    os_test_restart();
+}
+#endif
+
+TEST_CASE_DECL(os_time_test_virtual)
+
+TEST_SUITE(os_time_test_suite)
+{
+    os_time_test_virtual();
+}
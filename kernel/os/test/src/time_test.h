@@ -0,0 +1,48 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _TIME_TEST_H
+#define _TIME_TEST_H
+
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os_test_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(OS_SIM_VIRTUAL_TIME)
+#define TIME_TEST_STACK_SIZE    (5120)
+#define TIME_TEST_TASK_PRIO     (1)
+extern struct os_task time_test_task;
+extern os_stack_t time_test_stack[TIME_TEST_STACK_SIZE];
+
+/* One hour; far longer than the test is allowed to take. */
+#define TIME_TEST_LONG_SECS     (3600)
+#define TIME_TEST_LONG_TICKS    (TIME_TEST_LONG_SECS * OS_TICKS_PER_SEC)
+
+void time_test_virtual_handler(void *arg);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TIME_TEST_H */
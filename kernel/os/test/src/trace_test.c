@@ -0,0 +1,43 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os/os_trace.h"
+#include "os_test_priv.h"
+
+#if MYNEWT_VAL(OS_TRACE)
+struct os_trace_rec trace_test_recs[TRACE_TEST_ENTRIES];
+
+/* Stops recording and empties the ring. */
+void
+trace_test_drain(void)
+{
+    os_trace_enable(0);
+    while (os_trace_read(trace_test_recs, TRACE_TEST_ENTRIES) > 0) {
+    }
+}
+#endif
+
+TEST_CASE_DECL(os_trace_test_overflow)
+
+TEST_SUITE(os_trace_test_suite)
+{
+    os_trace_test_overflow();
+}
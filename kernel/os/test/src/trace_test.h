@@ -0,0 +1,49 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _TRACE_TEST_H
+#define _TRACE_TEST_H
+
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os/os_trace.h"
+#include "os_test_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(OS_TRACE)
+#define TRACE_TEST_ENTRIES      MYNEWT_VAL(OS_TRACE_ENTRIES)
+
+/* Application record IDs used by the tests. */
+#define TRACE_TEST_ID_FILL      0x80
+#define TRACE_TEST_ID_LOST      0x81
+#define TRACE_TEST_ID_AFTER     0x82
+
+extern struct os_trace_rec trace_test_recs[TRACE_TEST_ENTRIES];
+
+void trace_test_drain(void);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TRACE_TEST_H */
@@ -0,0 +1,93 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os_test_priv.h"
+
+#if MYNEWT_VAL(OS_WORK)
+struct os_task work_test_task;
+os_stack_t work_test_stack[WORK_TEST_STACK_SIZE];
+
+static struct os_work work_test_work;
+static int work_test_runs;
+static struct os_task *work_test_ran_on;
+
+static void
+work_test_cb(struct os_event *ev)
+{
+    TEST_ASSERT(ev->ev_arg == &work_test_runs);
+    work_test_runs++;
+    work_test_ran_on = os_sched_get_current_task();
+}
+
+/*
+ * Posts from a task below the work task in priority, so a post normally
+ * runs the work before os_work_post() returns.  Posts made with interrupts
+ * disabled stand in for an ISR that fires more than once before the work
+ * task gets to run.
+ */
+void
+work_test_post_handler(void *arg)
+{
+    os_sr_t sr;
+
+    os_work_init(&work_test_work, work_test_cb, &work_test_runs);
+
+    os_work_post(&work_test_work);
+    TEST_ASSERT(work_test_runs == 1);
+    TEST_ASSERT_FATAL(work_test_ran_on != NULL);
+    TEST_ASSERT(work_test_ran_on != &work_test_task);
+    TEST_ASSERT(work_test_ran_on->t_prio == MYNEWT_VAL(OS_WORK_TASK_PRIO));
+    TEST_ASSERT(work_test_work.w_posts == 1);
+    TEST_ASSERT(work_test_work.w_coalesced == 0);
+
+    /* A post while pending is counted, but the work runs once. */
+    OS_ENTER_CRITICAL(sr);
+    os_work_post(&work_test_work);
+    os_work_post(&work_test_work);
+    os_work_post(&work_test_work);
+    OS_EXIT_CRITICAL(sr);
+    TEST_ASSERT(work_test_runs == 2);
+    TEST_ASSERT(work_test_work.w_posts == 4);
+    TEST_ASSERT(work_test_work.w_coalesced == 2);
+
+    /* Cancelled work does not run. */
+    OS_ENTER_CRITICAL(sr);
+    os_work_post(&work_test_work);
+    os_work_cancel(&work_test_work);
+    OS_EXIT_CRITICAL(sr);
+    os_time_delay(1);
+    TEST_ASSERT(work_test_runs == 2);
+
+    /* Once it has run, the next post queues it again. */
+    os_work_post(&work_test_work);
+    TEST_ASSERT(work_test_runs == 3);
+    TEST_ASSERT(work_test_work.w_coalesced == 2);
+
+    os_test_restart();
+}
+#endif
+
+TEST_CASE_DECL(os_work_test_post)
+
+TEST_SUITE(os_work_test_suite)
+{
+    os_work_test_post();
+}
@@ -0,0 +1,44 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef _WORK_TEST_H
+#define _WORK_TEST_H
+
+#include "sysinit/sysinit.h"
+#include "testutil/testutil.h"
+#include "os/os.h"
+#include "os_test_priv.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if MYNEWT_VAL(OS_WORK)
+#define WORK_TEST_STACK_SIZE    (5120)
+#define WORK_TEST_TASK_PRIO     (MYNEWT_VAL(OS_WORK_TASK_PRIO) + 10)
+extern struct os_task work_test_task;
+extern os_stack_t work_test_stack[WORK_TEST_STACK_SIZE];
+
+void work_test_post_handler(void *arg);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _WORK_TEST_H */
@@ -9,6 +9,7 @@
 #include <klibc/inline.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -45,6 +46,29 @@ __extern void *realloc(void *, size_t);
 __extern void add_malloc_block(void *, size_t);
 __extern void get_malloc_memory_status(size_t *, size_t *);
 
+/* Heap statistics; counts are kept only with BASELIBC_MALLOC_STATS */
+struct malloc_stats {
+	size_t ms_free_bytes;		/* bytes on the free list */
+	size_t ms_min_free_bytes;	/* lowest ms_free_bytes seen */
+	size_t ms_largest_free;		/* largest free block */
+	uint32_t ms_free_blocks;	/* number of free blocks */
+	uint32_t ms_num_allocs;
+	uint32_t ms_num_frees;
+	uint32_t ms_num_fail;
+};
+__extern void get_malloc_stats(struct malloc_stats *);
+
+/* Allocation trace, kept with BASELIBC_MALLOC_TRACE */
+struct malloc_trace {
+	void *mt_ptr;
+	const void *mt_caller;
+	size_t mt_size;			/* 0 for free() */
+};
+__extern int get_malloc_trace(int, struct malloc_trace *);
+__extern void *malloc_traced(size_t, const void *);
+__extern void free_traced(void *, const void *);
+__extern void *realloc_traced(void *, size_t, const void *);
+
 /* Malloc locking
  * Until the callbacks are set, malloc doesn't do any locking.
  * malloc_lock() *may* timeout, in which case malloc() will return NULL.
@@ -61,6 +85,10 @@ __extern unsigned long long strtoull(const char *, char **, int);
 typedef int (*__comparefunc_t) (const void *, const void *);
 __extern void *bsearch(const void *, const void *, size_t, size_t,
 		       __comparefunc_t);
+/* First element not less than the key: the insertion point for sorted
+ * arrays. */
+__extern void *bsearch_lower(const void *, const void *, size_t, size_t,
+			     __comparefunc_t);
 __extern void qsort(void *, size_t, size_t, __comparefunc_t);
 
 __extern long jrand48(unsigned short *);
@@ -24,3 +24,25 @@ void *bsearch(const void *key, const void *base, size_t nmemb,
 
 	return NULL;
 }
+
+/*
+ * Returns the first element that does not compare less than key, or the
+ * end of the array if there is none; the insertion point for key in a
+ * sorted array.
+ */
+void *bsearch_lower(const void *key, const void *base, size_t nmemb,
+		    size_t size, int (*cmp) (const void *, const void *))
+{
+	while (nmemb) {
+		size_t mididx = nmemb / 2;
+		const void *midobj = base + mididx * size;
+
+		if (cmp(key, midobj) > 0) {
+			base = midobj + size;
+			nmemb -= mididx + 1;
+		} else
+			nmemb = mididx;
+	}
+
+	return (void *)base;
+}
@@ -6,7 +6,9 @@
 
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
+#include "syscfg/syscfg.h"
 #include "malloc.h"
 
 /* Both the arena list and the free memory list are double linked
@@ -29,6 +31,52 @@ static void malloc_unlock_nop() {}
 static malloc_lock_t malloc_lock = &malloc_lock_nop;
 static malloc_unlock_t malloc_unlock = &malloc_unlock_nop;
 
+#if MYNEWT_VAL(BASELIBC_MALLOC_STATS)
+static struct malloc_stats __malloc_stats = {
+	.ms_min_free_bytes = (size_t)-1,
+};
+#define MALLOC_STATS_INC(__name) (__malloc_stats.__name++)
+#else
+#define MALLOC_STATS_INC(__name)
+#endif
+
+static inline void malloc_stats_free_add(size_t size)
+{
+#if MYNEWT_VAL(BASELIBC_MALLOC_STATS)
+	__malloc_stats.ms_free_bytes += size;
+#endif
+}
+
+static inline void malloc_stats_free_sub(size_t size)
+{
+#if MYNEWT_VAL(BASELIBC_MALLOC_STATS)
+	__malloc_stats.ms_free_bytes -= size;
+	if (__malloc_stats.ms_free_bytes < __malloc_stats.ms_min_free_bytes)
+		__malloc_stats.ms_min_free_bytes = __malloc_stats.ms_free_bytes;
+#endif
+}
+
+#if MYNEWT_VAL(BASELIBC_MALLOC_TRACE) > 0
+static struct malloc_trace __malloc_trace[MYNEWT_VAL(BASELIBC_MALLOC_TRACE)];
+/* Number of entries ever recorded; the next one goes at this modulo size */
+static uint32_t __malloc_trace_cnt;
+
+/* Called with the malloc lock held */
+static void malloc_trace_add(void *ptr, size_t size, const void *caller)
+{
+	struct malloc_trace *mt;
+
+	mt = &__malloc_trace[__malloc_trace_cnt %
+			     MYNEWT_VAL(BASELIBC_MALLOC_TRACE)];
+	mt->mt_ptr = ptr;
+	mt->mt_caller = caller;
+	mt->mt_size = size;
+	__malloc_trace_cnt++;
+}
+#else
+#define malloc_trace_add(ptr, size, caller)
+#endif
+
 static inline void mark_block_dead(struct free_arena_header *ah)
 {
 #ifdef DEBUG_MALLOC
@@ -98,6 +146,7 @@ static void *__malloc_from_block(struct free_arena_header *fp, size_t size)
 		fp->a.type = ARENA_TYPE_USED; /* Allocate the whole block */
 		remove_from_free_chain(fp);
 	}
+	malloc_stats_free_sub(fp->a.size);
 
 	return (void *)(&fp->a + 1);
 }
@@ -143,11 +192,20 @@ static struct free_arena_header *__free_block(struct free_arena_header *ah)
 }
 
 void *malloc(size_t size)
+{
+	return malloc_traced(size, __builtin_return_address(0));
+}
+
+/* malloc(), recording 'caller' in the allocation trace */
+void *malloc_traced(size_t size, const void *caller)
 {
 	struct free_arena_header *fp;
         void *more_mem;
         extern void *_sbrk(int incr);
+	size_t req = size;
 
+	(void)caller;
+	(void)req;
 	if (size == 0)
 		return NULL;
 
@@ -174,6 +232,12 @@ retry_alloc:
                 goto retry_alloc;
             }
         }
+        if (result == NULL) {
+            MALLOC_STATS_INC(ms_num_fail);
+        } else {
+            MALLOC_STATS_INC(ms_num_allocs);
+            malloc_trace_add(result, req, caller);
+        }
         malloc_unlock();
 	return result;
 }
@@ -214,15 +278,23 @@ void add_malloc_block(void *buf, size_t size)
 	fp->a.next->a.prev = fp;
 
 	/* Insert into the free chain and coalesce with adjacent blocks */
+	malloc_stats_free_add(size);
 	fp = __free_block(fp);
 
         malloc_unlock();
 }
 
 void free(void *ptr)
+{
+	free_traced(ptr, __builtin_return_address(0));
+}
+
+/* free(), recording 'caller' in the allocation trace */
+void free_traced(void *ptr, const void *caller)
 {
 	struct free_arena_header *ah;
 
+	(void)caller;
 	if (!ptr)
 		return;
 
@@ -236,6 +308,10 @@ void free(void *ptr)
         if (!malloc_lock())
             return;
 
+	MALLOC_STATS_INC(ms_num_frees);
+	malloc_trace_add(ptr, 0, caller);
+	malloc_stats_free_add(ah->a.size);
+
 	/* Merge into adjacent free blocks */
 	ah = __free_block(ah);
         malloc_unlock();
@@ -260,6 +336,62 @@ void get_malloc_memory_status(size_t *free_bytes, size_t *largest_block)
     malloc_unlock();
 }
 
+void get_malloc_stats(struct malloc_stats *ms)
+{
+    struct free_arena_header *fp;
+
+    memset(ms, 0, sizeof(*ms));
+
+    if (!malloc_lock())
+            return;
+
+#if MYNEWT_VAL(BASELIBC_MALLOC_STATS)
+    *ms = __malloc_stats;
+    if (ms->ms_min_free_bytes == (size_t)-1)
+        ms->ms_min_free_bytes = ms->ms_free_bytes;
+    ms->ms_free_bytes = 0;
+#endif
+
+    for (fp = __malloc_head.next_free; fp->a.type != ARENA_TYPE_HEAD; fp = fp->next_free) {
+        ms->ms_free_bytes += fp->a.size;
+        ms->ms_free_blocks++;
+        if (fp->a.size > ms->ms_largest_free) {
+            ms->ms_largest_free = fp->a.size;
+        }
+    }
+
+    malloc_unlock();
+}
+
+/*
+ * Reads entry 'idx' of the allocation trace, 0 being the most recent.
+ * Returns 0 on success, -1 if there is no such entry.
+ */
+int get_malloc_trace(int idx, struct malloc_trace *mt)
+{
+#if MYNEWT_VAL(BASELIBC_MALLOC_TRACE) > 0
+    int rc;
+
+    if (!malloc_lock())
+            return -1;
+
+    rc = -1;
+    if (idx >= 0 && idx < MYNEWT_VAL(BASELIBC_MALLOC_TRACE) &&
+        (uint32_t)idx < __malloc_trace_cnt) {
+        *mt = __malloc_trace[(__malloc_trace_cnt - 1 - idx) %
+                             MYNEWT_VAL(BASELIBC_MALLOC_TRACE)];
+        rc = 0;
+    }
+
+    malloc_unlock();
+    return rc;
+#else
+    (void)idx;
+    (void)mt;
+    return -1;
+#endif
+}
+
 void set_malloc_locking(malloc_lock_t lock, malloc_unlock_t unlock)
 {
     if (lock)
@@ -3,12 +3,46 @@
  */
 
 #include <string.h>
+#include "memword.h"
 
 int memcmp(const void *s1, const void *s2, size_t n)
 {
 	const unsigned char *c1 = s1, *c2 = s2;
 	int d = 0;
 
+	/*
+	 * Skip over equal words; the first word that differs is settled by
+	 * the byte loop below.
+	 */
+	if (n >= MEM_WORD_MIN &&
+	    (MEM_UNALIGNED_OK ||
+	     ((uintptr_t)c1 & MEM_WORD_MASK) == ((uintptr_t)c2 & MEM_WORD_MASK))) {
+		while (!MEM_ALIGNED(c1)) {
+			d = (int)*c1++ - (int)*c2++;
+			n--;
+			if (d)
+				return d;
+		}
+		if (MEM_ALIGNED(c2)) {
+			while (n >= sizeof(mem_word_t) &&
+			       *(const mem_word_t *)c1 == *(const mem_word_t *)c2) {
+				c1 += sizeof(mem_word_t);
+				c2 += sizeof(mem_word_t);
+				n -= sizeof(mem_word_t);
+			}
+		}
+#if MEM_UNALIGNED_OK
+		else {
+			while (n >= sizeof(mem_word_t) &&
+			       *(const mem_word_t *)c1 == MEM_LOADU(c2)) {
+				c1 += sizeof(mem_word_t);
+				c2 += sizeof(mem_word_t);
+				n -= sizeof(mem_word_t);
+			}
+		}
+#endif
+	}
+
 	while (n--) {
 		d = (int)*c1++ - (int)*c2++;
 		if (d)
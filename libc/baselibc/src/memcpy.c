@@ -4,6 +4,7 @@
 
 #include <string.h>
 #include <stdint.h>
+#include "memword.h"
 
 void *memcpy(void *dst, const void *src, size_t n)
 {
@@ -20,6 +21,47 @@ void *memcpy(void *dst, const void *src, size_t n)
 		      (nq), "+S"(p), "+D"(q)
 		      :"r"((uint32_t) (n & 7)));
 #else
+	/*
+	 * Align the destination, then move whole words.  Copying always runs
+	 * upwards and reads each block before writing it; memmove() relies on
+	 * that for overlapping moves to a lower address.
+	 */
+	if (n >= MEM_WORD_MIN &&
+	    (MEM_UNALIGNED_OK ||
+	     ((uintptr_t)p & MEM_WORD_MASK) == ((uintptr_t)q & MEM_WORD_MASK))) {
+		while (!MEM_ALIGNED(q)) {
+			*q++ = *p++;
+			n--;
+		}
+		if (MEM_ALIGNED(p)) {
+#if MEM_LDM_STM
+			while (n >= 4 * sizeof(mem_word_t)) {
+				asm volatile ("ldmia %0!, {r3-r6}\n\t"
+					      "stmia %1!, {r3-r6}"
+					      : "+r" (p), "+r" (q)
+					      :
+					      : "r3", "r4", "r5", "r6", "memory");
+				n -= 4 * sizeof(mem_word_t);
+			}
+#endif
+			while (n >= sizeof(mem_word_t)) {
+				*(mem_word_t *)q = *(const mem_word_t *)p;
+				p += sizeof(mem_word_t);
+				q += sizeof(mem_word_t);
+				n -= sizeof(mem_word_t);
+			}
+		}
+#if MEM_UNALIGNED_OK
+		else {
+			while (n >= sizeof(mem_word_t)) {
+				*(mem_word_t *)q = MEM_LOADU(p);
+				p += sizeof(mem_word_t);
+				q += sizeof(mem_word_t);
+				n -= sizeof(mem_word_t);
+			}
+		}
+#endif
+	}
 	while (n--) {
 		*q++ = *p++;
 	}
@@ -3,6 +3,7 @@
  */
 
 #include <string.h>
+#include "memword.h"
 
 void *memmove(void *dst, const void *src, size_t n)
 {
@@ -20,12 +21,25 @@ void *memmove(void *dst, const void *src, size_t n)
 	}
 #else
 	if (q < p) {
-		while (n--) {
-			*q++ = *p++;
-		}
+		/* memcpy() copies upwards, which is safe for this overlap. */
+		return memcpy(dst, src, n);
 	} else {
 		p += n;
 		q += n;
+		if (n >= MEM_WORD_MIN &&
+		    ((uintptr_t)p & MEM_WORD_MASK) ==
+		    ((uintptr_t)q & MEM_WORD_MASK)) {
+			while (!MEM_ALIGNED(q)) {
+				*--q = *--p;
+				n--;
+			}
+			while (n >= sizeof(mem_word_t)) {
+				p -= sizeof(mem_word_t);
+				q -= sizeof(mem_word_t);
+				*(mem_word_t *)q = *(const mem_word_t *)p;
+				n -= sizeof(mem_word_t);
+			}
+		}
 		while (n--) {
 			*--q = *--p;
 		}
@@ -4,6 +4,7 @@
 
 #include <string.h>
 #include <stdint.h>
+#include "memword.h"
 
 void *memset(void *dst, int c, size_t n)
 {
@@ -21,6 +22,36 @@ void *memset(void *dst, int c, size_t n)
 		      : "a" ((unsigned char)c * 0x0101010101010101U),
 			"r" ((uint32_t) n & 7));
 #else
+	mem_word_t w;
+
+	if (n >= MEM_WORD_MIN) {
+		while (!MEM_ALIGNED(q)) {
+			*q++ = c;
+			n--;
+		}
+		w = (unsigned char)c * 0x01010101U;
+#if MEM_LDM_STM
+		if (n >= 4 * sizeof(mem_word_t)) {
+			register mem_word_t w0 asm("r3") = w;
+			register mem_word_t w1 asm("r4") = w;
+			register mem_word_t w2 asm("r5") = w;
+			register mem_word_t w3 asm("r6") = w;
+
+			while (n >= 4 * sizeof(mem_word_t)) {
+				asm volatile ("stmia %0!, {%1-%4}"
+					      : "+r" (q)
+					      : "r" (w0), "r" (w1), "r" (w2), "r" (w3)
+					      : "memory");
+				n -= 4 * sizeof(mem_word_t);
+			}
+		}
+#endif
+		while (n >= sizeof(mem_word_t)) {
+			*(mem_word_t *)q = w;
+			q += sizeof(mem_word_t);
+			n -= sizeof(mem_word_t);
+		}
+	}
 	while (n--) {
 		*q++ = c;
 	}
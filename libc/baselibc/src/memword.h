@@ -0,0 +1,43 @@
+/*
+ * memword.h
+ *
+ * Internals for the word-at-a-time mem*() routines
+ */
+
+#ifndef MEMWORD_H
+#define MEMWORD_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * Word accesses alias whatever the caller's buffer holds, so they must be
+ * exempt from strict aliasing.
+ */
+typedef uint32_t __attribute__((__may_alias__)) mem_word_t;
+
+/* Unaligned word load, where the core does it in one instruction. */
+#if defined(__ARM_FEATURE_UNALIGNED)
+#define MEM_UNALIGNED_OK 1
+struct mem_uword {
+	mem_word_t w;
+} __attribute__((__packed__, __may_alias__));
+#define MEM_LOADU(p) (((const struct mem_uword *)(p))->w)
+#else
+#define MEM_UNALIGNED_OK 0
+#endif
+
+#define MEM_WORD_MASK (sizeof(mem_word_t) - 1)
+#define MEM_ALIGNED(p) (((uintptr_t)(p) & MEM_WORD_MASK) == 0)
+
+/* Below this size the byte loop wins. */
+#define MEM_WORD_MIN (2 * sizeof(mem_word_t))
+
+/* Cortex-M3/M4/M7 can burst 4 words with LDM/STM. */
+#if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+#define MEM_LDM_STM 1
+#else
+#define MEM_LDM_STM 0
+#endif
+
+#endif /* MEMWORD_H */
@@ -1,46 +1,154 @@
 /*
  * qsort.c
  *
- * This is actually combsort.  It's an O(n log n) algorithm with
- * simplicity/small code size being its main virtue.
+ * Introsort: quicksort with median-of-three pivots, finishing short runs
+ * with insertion sort and switching to heapsort when partitioning goes
+ * badly, so the worst case stays O(n log n).  Nothing recurses; pending
+ * partitions live in a fixed stack sized by the bits in size_t.
  */
 
+#include <limits.h>
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 
-static inline size_t newgap(size_t gap)
+/* Runs this short are cheaper to finish with insertion sort. */
+#define QSORT_CUTOFF 8
+
+static void insertion_sort(char *base, size_t nmemb, size_t size,
+			   __comparefunc_t compar)
+{
+	char *end = base + nmemb * size;
+	char *p, *q;
+
+	for (p = base + size; p < end; p += size) {
+		for (q = p; q > base && compar(q - size, q) > 0; q -= size)
+			memswap(q - size, q, size);
+	}
+}
+
+static void sift_down(char *base, size_t root, size_t nmemb, size_t size,
+		      __comparefunc_t compar)
 {
-	gap = (gap * 10) / 13;
-	if (gap == 9 || gap == 10)
-		gap = 11;
+	size_t child;
 
-	if (gap < 1)
-		gap = 1;
-	return gap;
+	while ((child = 2 * root + 1) < nmemb) {
+		if (child + 1 < nmemb &&
+		    compar(base + child * size, base + (child + 1) * size) < 0)
+			child++;
+		if (compar(base + root * size, base + child * size) >= 0)
+			break;
+		memswap(base + root * size, base + child * size, size);
+		root = child;
+	}
+}
+
+static void heap_sort(char *base, size_t nmemb, size_t size,
+		      __comparefunc_t compar)
+{
+	size_t i;
+
+	for (i = nmemb / 2; i-- > 0;)
+		sift_down(base, i, nmemb, size, compar);
+	for (i = nmemb - 1; i > 0; i--) {
+		memswap(base, base + i * size, size);
+		sift_down(base, 0, i, size, compar);
+	}
+}
+
+/*
+ * Partitions around the median of the first, middle and last elements and
+ * returns the pivot's final position.
+ */
+static char *partition(char *base, size_t nmemb, size_t size,
+		       __comparefunc_t compar)
+{
+	char *mid = base + (nmemb / 2) * size;
+	char *last = base + (nmemb - 1) * size;
+	char *i, *j;
+
+	if (compar(mid, base) < 0)
+		memswap(mid, base, size);
+	if (compar(last, mid) < 0) {
+		memswap(last, mid, size);
+		if (compar(mid, base) < 0)
+			memswap(mid, base, size);
+	}
+	/* Pivot to the front; last is now known to be >= pivot. */
+	memswap(base, mid, size);
+
+	i = base;
+	j = base + nmemb * size;
+	for (;;) {
+		do {
+			i += size;
+		} while (compar(i, base) < 0);
+		do {
+			j -= size;
+		} while (compar(j, base) > 0);
+		if (i >= j)
+			break;
+		memswap(i, j, size);
+	}
+	memswap(base, j, size);
+
+	return j;
 }
 
 void qsort(void *base, size_t nmemb, size_t size,
 	   int (*compar) (const void *, const void *))
 {
-	size_t gap = nmemb;
-	size_t i, j;
-	char *p1, *p2;
-	int swapped;
-
-	if (!nmemb)
-		return;
-
-	do {
-		gap = newgap(gap);
-		swapped = 0;
-
-		for (i = 0, p1 = base; i < nmemb - gap; i++, p1 += size) {
-			j = i + gap;
-			if (compar(p1, p2 = (char *)base + j * size) > 0) {
-				memswap(p1, p2, size);
-				swapped = 1;
+	struct {
+		char *base;
+		size_t nmemb;
+		int depth;
+	} stack[sizeof(size_t) * CHAR_BIT];
+	int sp = 0;
+	char *b = base;
+	char *pivot;
+	size_t nleft, nright;
+	size_t n;
+	int depth;
+
+	/* Allow about 2 * log2(nmemb) levels before giving up on quicksort. */
+	depth = 0;
+	for (n = nmemb; n > 1; n >>= 1)
+		depth += 2;
+
+	for (;;) {
+		while (nmemb > QSORT_CUTOFF) {
+			if (depth-- == 0) {
+				heap_sort(b, nmemb, size, compar);
+				nmemb = 0;
+				break;
+			}
+			pivot = partition(b, nmemb, size, compar);
+			nleft = (pivot - b) / size;
+			nright = nmemb - nleft - 1;
+
+			/* Defer the larger side and carry on with the smaller
+			 * one, so the stack never holds more than log2(nmemb)
+			 * entries. */
+			if (nleft > nright) {
+				stack[sp].base = b;
+				stack[sp].nmemb = nleft;
+				b = pivot + size;
+				nmemb = nright;
+			} else {
+				stack[sp].base = pivot + size;
+				stack[sp].nmemb = nright;
+				nmemb = nleft;
 			}
+			stack[sp].depth = depth;
+			sp++;
 		}
-	} while (gap > 1 || swapped);
+		if (nmemb > 1)
+			insertion_sort(b, nmemb, size, compar);
+		if (sp == 0)
+			break;
+		sp--;
+		b = stack[sp].base;
+		nmemb = stack[sp].nmemb;
+		depth = stack[sp].depth;
+	}
 }
@@ -10,16 +10,23 @@
 /* FIXME: This is cheesy, it should be fixed later */
 
 void *realloc(void *ptr, size_t size)
+{
+	return realloc_traced(ptr, size, __builtin_return_address(0));
+}
+
+/* realloc(), recording 'caller' in the allocation trace */
+void *realloc_traced(void *ptr, size_t size, const void *caller)
 {
 	struct free_arena_header *ah;
 	void *newptr;
 	size_t oldsize;
+	size_t req = size;
 
 	if (!ptr)
-		return malloc(size);
+		return malloc_traced(size, caller);
 
 	if (size == 0) {
-		free(ptr);
+		free_traced(ptr, caller);
 		return NULL;
 	}
 
@@ -39,11 +46,11 @@ void *realloc(void *ptr, size_t size)
 
 		oldsize = ah->a.size - sizeof(struct arena_header);
 
-		newptr = malloc(size);
+		newptr = malloc_traced(req, caller);
                 if(newptr) {
-                    memcpy(newptr, ptr, (size < oldsize) ? size : oldsize);
+                    memcpy(newptr, ptr, (req < oldsize) ? req : oldsize);
                 }
-		free(ptr);
+		free_traced(ptr, caller);
 
 		return newptr;
 	}
@@ -52,8 +52,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 /* This is a smaller implementation of printf-family of functions,
  * based on tinyprintf code by Kustaa Nyholm.
- * The formats supported by this implementation are: 'd' 'u' 'c' 's' 'x' 'X'.
- * Zero padding and field width are also supported.
+ * The formats supported by this implementation are: 'd' 'u' 'c' 's' 'x' 'X'
+ * and 'o'.  Zero padding, field width and the '#' flag are also supported;
+ * 'o', '#' and full 64-bit "ll" output can be left out through syscfg.
+ * Output is gathered in a small buffer and written to the stream in chunks.
  * If the library is compiled with 'PRINTF_SUPPORT_LONG' defined then the
  * long specifier is also supported.
  * Otherwise it is ignored, so on 32 bit platforms there is no point to use
@@ -61,6 +63,10 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
 #include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "syscfg/syscfg.h"
 
 struct param {
     unsigned char width; /**< field width */
@@ -72,32 +78,95 @@ struct param {
     char *bf;           /**<  Buffer to output */
 };
 
-static void ui2a(unsigned long long int num, struct param *p)
+/* Output is collected here and handed to the stream in chunks. */
+#define TFP_OUT_BUF_SIZE 32
+
+struct tfp_out {
+    FILE *f;
+    size_t written;
+    unsigned char len;
+    char buf[TFP_OUT_BUF_SIZE];
+};
+
+#if MYNEWT_VAL(BASELIBC_PRINTF_LONG_LONG)
+typedef unsigned long long tfp_uint_t;
+typedef long long tfp_int_t;
+#else
+typedef unsigned long tfp_uint_t;
+typedef long tfp_int_t;
+#endif
+
+static const char tfp_digits2[] =
+    "00010203040506070809101112131415161718192021222324"
+    "25262728293031323334353637383940414243444546474849"
+    "50515253545556575859606162636465666768697071727374"
+    "75767778798081828384858687888990919293949596979899";
+
+/* Writes v backwards ending at q; at least min digits. */
+static char *u32_dec(uint32_t v, char *q, int min)
 {
-    int n = 0;
-    unsigned long long int d = 1;
-    char *bf = p->bf;
-    while (num / d >= p->base)
-        d *= p->base;
-    while (d != 0) {
-        unsigned long long  dgt = num / d;
-        num %= d;
-        d /= p->base;
-        if (n || dgt > 0 || d == 0) {
-            *bf++ = dgt + (dgt < 10 ? '0' : (p->uc ? 'A' : 'a') - 10);
-            ++n;
+    char *end = q;
+    uint32_t t;
+
+    /* Division by a constant compiles to a multiply. */
+    while (v >= 100) {
+        t = v / 100;
+        q -= 2;
+        memcpy(q, &tfp_digits2[(v - t * 100) * 2], 2);
+        v = t;
+    }
+    if (v >= 10) {
+        q -= 2;
+        memcpy(q, &tfp_digits2[v * 2], 2);
+    } else {
+        *--q = '0' + v;
+    }
+    while (end - q < min) {
+        *--q = '0';
+    }
+    return q;
+}
+
+/* Formats num into bf, which must hold 23 characters, and points p->bf to
+ * the first digit. */
+static void ui2a(tfp_uint_t num, struct param *p, char *bf)
+{
+    char *q = bf + 22;
+    const char *hex;
+    int shift;
+
+    *q = 0;
+    if (p->base == 10) {
+#if MYNEWT_VAL(BASELIBC_PRINTF_LONG_LONG)
+        /* One 64-bit division per nine digits; the rest is 32-bit. */
+        while (num > UINT32_MAX) {
+            tfp_uint_t hi = num / 1000000000;
+
+            q = u32_dec((uint32_t)(num - hi * 1000000000), q, 9);
+            num = hi;
         }
+#endif
+        q = u32_dec((uint32_t)num, q, 0);
+    } else {
+        hex = p->uc ? "0123456789ABCDEF" : "0123456789abcdef";
+        shift = (p->base == 16) ? 4 : 3;
+        do {
+            *--q = hex[num & (p->base - 1)];
+            num >>= shift;
+        } while (num != 0);
     }
-    *bf = 0;
+    p->bf = q;
 }
 
-static void i2a(long long int num, struct param *p)
+static void i2a(tfp_int_t num, struct param *p, char *bf)
 {
+    tfp_uint_t u = num;
+
     if (num < 0) {
-        num = -num;
+        u = -u;
         p->sign = 1;
     }
-    ui2a(num, p);
+    ui2a(u, p, bf);
 }
 
 static int a2d(char ch)
@@ -128,61 +197,80 @@ static char a2i(char ch, const char **src, int base, unsigned char *nump)
     return ch;
 }
 
-static int putf(FILE *putp, char c)
+static void out_flush(struct tfp_out *out)
 {
-    if (fputc(c, putp) == EOF)
-        return 0;
-    else
-        return 1;
+    if (out->len) {
+        out->written += fwrite(out->buf, 1, out->len, out->f);
+        out->len = 0;
+    }
 }
 
-static unsigned putchw(FILE *putp, struct param *p)
+static void out_write(struct tfp_out *out, const char *bp, size_t n)
 {
-    unsigned written = 0;
-    char ch;
-    int n = p->width;
-    char *bf = p->bf;
+    if (out->len + n > TFP_OUT_BUF_SIZE) {
+        out_flush(out);
+        if (n > TFP_OUT_BUF_SIZE) {
+            out->written += fwrite(bp, 1, n, out->f);
+            return;
+        }
+    }
+    memcpy(out->buf + out->len, bp, n);
+    out->len += n;
+}
+
+static void putf(struct tfp_out *out, char c)
+{
+    if (out->len == TFP_OUT_BUF_SIZE) {
+        out_flush(out);
+    }
+    out->buf[out->len++] = c;
+}
+
+static void putfill(struct tfp_out *out, char c, int n)
+{
+    while (n-- > 0)
+        putf(out, c);
+}
+
+static void putchw(struct tfp_out *out, struct param *p)
+{
+    int len = strlen(p->bf);
+    int n = p->width - len;
 
     /* Number of filling characters */
-    while (*bf++ && n > 0)
-        n--;
     if (p->sign)
         n--;
+#if MYNEWT_VAL(BASELIBC_PRINTF_ALT_FORM)
     if (p->alt && p->base == 16)
         n -= 2;
     else if (p->alt && p->base == 8)
         n--;
+#endif
 
     /* Fill with space, before alternate or sign */
-    if (!p->lz) {
-        while (n-- > 0)
-            written += putf(putp, ' ');
-    }
+    if (!p->lz)
+        putfill(out, ' ', n);
 
     /* print sign */
     if (p->sign)
-        written += putf(putp, '-');
+        putf(out, '-');
 
+#if MYNEWT_VAL(BASELIBC_PRINTF_ALT_FORM)
     /* Alternate */
     if (p->alt && p->base == 16) {
-        written += putf(putp, '0');
-        written += putf(putp, (p->uc ? 'X' : 'x'));
+        putf(out, '0');
+        putf(out, (p->uc ? 'X' : 'x'));
     } else if (p->alt && p->base == 8) {
-        written += putf(putp, '0');
+        putf(out, '0');
     }
+#endif
 
     /* Fill with zeros, after alternate or sign */
-    if (p->lz) {
-        while (n-- > 0)
-            written += putf(putp, '0');
-    }
+    if (p->lz)
+        putfill(out, '0', n);
 
     /* Put actual buffer */
-    bf = p->bf;
-    while ((ch = *bf++))
-        written += putf(putp, ch);
-    
-    return written;
+    out_write(out, p->bf, len);
 }
 
 static unsigned long long
@@ -226,98 +314,111 @@ intarg(int lng, int sign, va_list *va)
 
 size_t tfp_format(FILE *putp, const char *fmt, va_list va)
 {
-    size_t written = 0;
+    struct tfp_out out;
     struct param p;
+    const char *run;
     char bf[23];
     char ch;
     char lng;
 
-    p.bf = bf;
-
-    while ((ch = *(fmt++))) {
-        if (ch != '%') {
-            written += putf(putp, ch);
-        } else {
-            /* Init parameter struct */
-            p.lz = 0;
-            p.alt = 0;
-            p.width = 0;
-            p.sign = 0;
-            lng = 0;
-
-            /* Flags */
-            while ((ch = *(fmt++))) {
-                switch (ch) {
-                case '0':
-                    p.lz = 1;
-                    continue;
-                case '#':
-                    p.alt = 1;
-                    continue;
-                default:
-                    break;
-                }
+    out.f = putp;
+    out.written = 0;
+    out.len = 0;
+
+    while (*fmt) {
+        /* Copy literal text up to the next conversion in one go. */
+        run = fmt;
+        while (*fmt && *fmt != '%')
+            fmt++;
+        if (fmt != run)
+            out_write(&out, run, fmt - run);
+        if (!*fmt)
+            break;
+        fmt++;
+
+        /* Init parameter struct */
+        p.lz = 0;
+        p.alt = 0;
+        p.width = 0;
+        p.sign = 0;
+        p.uc = 0;
+        lng = 0;
+
+        /* Flags */
+        while ((ch = *(fmt++))) {
+            switch (ch) {
+            case '0':
+                p.lz = 1;
+                continue;
+            case '#':
+                p.alt = 1;
+                continue;
+            default:
                 break;
             }
+            break;
+        }
+
+        /* Width */
+        if (ch >= '0' && ch <= '9') {
+            ch = a2i(ch, &fmt, 10, &(p.width));
+        }
+        if (ch == 'l') {
+            ch = *(fmt++);
+            lng = 1;
 
-            /* Width */
-            if (ch >= '0' && ch <= '9') {
-                ch = a2i(ch, &fmt, 10, &(p.width));
-            }
             if (ch == 'l') {
                 ch = *(fmt++);
-                lng = 1;
-
-                if (ch == 'l') {
-                    ch = *(fmt++);
-                    lng = 2;
-                }
+                lng = 2;
             }
+        }
 
-            switch (ch) {
-            case 0:
-                goto abort;
-            case 'u':
-                p.base = 10;
-                ui2a(intarg(lng, 0, &va), &p);
-                written += putchw(putp, &p);
-                break;
-            case 'd':
-            case 'i':
-                p.base = 10;
-                i2a(intarg(lng, 1, &va), &p);
-                written += putchw(putp, &p);
-                break;
-            case 'x':
-            case 'X':
-                p.base = 16;
-                p.uc = (ch == 'X');
-                ui2a(intarg(lng, 0, &va), &p);
-                written += putchw(putp, &p);
-                break;
-            case 'o':
-                p.base = 8;
-                ui2a(intarg(lng, 0, &va), &p);
-                written += putchw(putp, &p);
-                break;
-            case 'c':
-                written += putf(putp, (char)(va_arg(va, int)));
-                break;
-            case 's':
-                p.bf = va_arg(va, char *);
-                written += putchw(putp, &p);
-                p.bf = bf;
-                break;
-            case '%':
-                written += putf(putp, ch);
-            default:
-                break;
-            }
+        switch (ch) {
+        case 0:
+            goto abort;
+        case 'u':
+            p.base = 10;
+            ui2a(intarg(lng, 0, &va), &p, bf);
+            putchw(&out, &p);
+            break;
+        case 'd':
+        case 'i':
+            p.base = 10;
+            i2a(intarg(lng, 1, &va), &p, bf);
+            putchw(&out, &p);
+            break;
+        case 'x':
+        case 'X':
+            p.base = 16;
+            p.uc = (ch == 'X');
+            ui2a(intarg(lng, 0, &va), &p, bf);
+            putchw(&out, &p);
+            break;
+#if MYNEWT_VAL(BASELIBC_PRINTF_OCTAL)
+        case 'o':
+            p.base = 8;
+            ui2a(intarg(lng, 0, &va), &p, bf);
+            putchw(&out, &p);
+            break;
+#endif
+        case 'c':
+            putf(&out, (char)(va_arg(va, int)));
+            break;
+        case 's':
+            p.bf = va_arg(va, char *);
+            p.base = 0;
+            putchw(&out, &p);
+            break;
+        case '%':
+            putf(&out, ch);
+        default:
+            break;
         }
     }
- abort:;
- 
- return written;
+ abort:
+    out_flush(&out);
+
+    return out.written;
 }
 
 int vfprintf(FILE *f, const char *fmt, va_list va)
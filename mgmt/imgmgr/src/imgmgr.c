@@ -16,6 +16,7 @@
  * specific language governing permissions and limitations
  * under the License.
  */
+#include <os/os.h>
 #include <os/endian.h>
 
 #include <limits.h>
@@ -85,23 +86,86 @@ static struct mgmt_group imgr_nmgr_group = {
 
 struct imgr_state imgr_state;
 
+#if MYNEWT_VAL(IMGMGR_INFO_CACHE)
 /*
- * Read version and build hash from image located slot "image_slot".  Note:
- * this is a slot index, not a flash area ID.
- *
- * @param image_slot
- * @param ver (optional)
- * @param hash (optional)
- * @param flags
- *
- * Returns -1 if area is not readable.
- * Returns 0 if image in slot is ok, and version string is valid.
- * Returns 1 if there is not a full image.
- * Returns 2 if slot is empty. XXXX not there yet
+ * What imgr_read_info() and boot_swap_type() last read from flash.  The
+ * upload task may change the slots while the mgmt task reads them, so
+ * lookups note the generation before going to flash, and only store the
+ * result if nothing was invalidated meanwhile.
+ */
+struct imgr_slot_info {
+    uint8_t valid;
+    int8_t rc;
+    uint32_t flags;
+    struct image_version ver;
+    uint8_t hash[IMGMGR_HASH_LEN];
+};
+
+static struct {
+    uint32_t gen;
+    struct imgr_slot_info slots[IMGMGR_MAX_IMGS];
+    uint8_t swap_valid;
+    int8_t swap_type;
+} imgr_info_cache;
+
+/*
+ * Forgets the cached slot contents and boot state.  Called whenever the
+ * image slots or their boot trailers are written.
+ */
+void
+imgr_info_invalidate(void)
+{
+    os_sr_t sr;
+    int i;
+
+    OS_ENTER_CRITICAL(sr);
+    imgr_info_cache.gen++;
+    for (i = 0; i < IMGMGR_MAX_IMGS; i++) {
+        imgr_info_cache.slots[i].valid = 0;
+    }
+    imgr_info_cache.swap_valid = 0;
+    OS_EXIT_CRITICAL(sr);
+}
+
+/*
+ * boot_swap_type(), which reads both boot trailers, through the cache.
  */
 int
-imgr_read_info(int image_slot, struct image_version *ver, uint8_t *hash,
-               uint32_t *flags)
+imgr_swap_type(void)
+{
+    uint32_t gen;
+    os_sr_t sr;
+    int swap_type;
+
+    OS_ENTER_CRITICAL(sr);
+    gen = imgr_info_cache.gen;
+    swap_type = imgr_info_cache.swap_type;
+    if (imgr_info_cache.swap_valid) {
+        OS_EXIT_CRITICAL(sr);
+        return swap_type;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    swap_type = boot_swap_type();
+
+    OS_ENTER_CRITICAL(sr);
+    if (gen == imgr_info_cache.gen) {
+        imgr_info_cache.swap_type = swap_type;
+        imgr_info_cache.swap_valid = 1;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return swap_type;
+}
+#endif
+
+/*
+ * Reads version, flags and build hash of the image in slot "image_slot"
+ * from flash.
+ */
+static int
+imgr_read_info_flash(int image_slot, struct image_version *ver,
+                     uint8_t *hash, uint32_t *flags)
 {
     struct image_header *hdr;
     struct image_tlv *tlv;
@@ -183,6 +247,72 @@ end:
     return rc;
 }
 
+/*
+ * Read version and build hash from image located slot "image_slot".  Note:
+ * this is a slot index, not a flash area ID.  With IMGMGR_INFO_CACHE, flash
+ * is only read the first time a slot is asked about after it changed.
+ *
+ * @param image_slot
+ * @param ver (optional)
+ * @param hash (optional)
+ * @param flags (optional)
+ *
+ * Returns -1 if area is not readable.
+ * Returns 0 if image in slot is ok, and version string is valid.
+ * Returns 1 if there is not a full image.
+ * Returns 2 if slot is empty.
+ */
+int
+imgr_read_info(int image_slot, struct image_version *ver, uint8_t *hash,
+               uint32_t *flags)
+{
+#if MYNEWT_VAL(IMGMGR_INFO_CACHE)
+    struct imgr_slot_info info;
+    uint32_t gen;
+    os_sr_t sr;
+    int rc;
+
+    if (image_slot < 0 || image_slot >= IMGMGR_MAX_IMGS) {
+        return -1;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    gen = imgr_info_cache.gen;
+    info = imgr_info_cache.slots[image_slot];
+    OS_EXIT_CRITICAL(sr);
+
+    if (!info.valid) {
+        memset(&info, 0xff, sizeof(info));
+        rc = imgr_read_info_flash(image_slot, &info.ver, info.hash,
+                                  &info.flags);
+        if (rc < 0) {
+            return rc;
+        }
+        info.rc = rc;
+        info.valid = 1;
+
+        OS_ENTER_CRITICAL(sr);
+        if (gen == imgr_info_cache.gen) {
+            imgr_info_cache.slots[image_slot] = info;
+        }
+        OS_EXIT_CRITICAL(sr);
+    }
+
+    if (ver != NULL) {
+        *ver = info.ver;
+    }
+    if (flags != NULL) {
+        *flags = info.flags;
+    }
+    if (hash != NULL && info.rc == 0) {
+        memcpy(hash, info.hash, IMGMGR_HASH_LEN);
+    }
+    return info.rc;
+#else
+    return imgr_read_info_flash(image_slot, ver, hash, flags);
+#endif
+}
+
 int
 imgr_my_version(struct image_version *ver)
 {
@@ -231,6 +361,16 @@ imgr_find_by_hash(uint8_t *find, struct image_version *ver)
     return -1;
 }
 
+/*
+ * Called once the last byte of an upload has been written.
+ */
+void
+imgr_upload_done(void)
+{
+    flash_area_close(imgr_state.upload.fa);
+    imgr_state.upload.fa = NULL;
+}
+
 static int
 imgr_upload(struct mgmt_cbuf *cb)
 {
@@ -262,6 +402,13 @@ imgr_upload(struct mgmt_cbuf *cb)
     };
     struct image_version ver;
     struct image_header *hdr;
+    uint32_t img_size;
+#if MYNEWT_VAL(IMGMGR_DELTA)
+    int is_delta;
+#endif
+#if MYNEWT_VAL(IMGMGR_LZ)
+    int is_lz;
+#endif
     int area_id;
     int best;
     int rc;
@@ -276,6 +423,22 @@ imgr_upload(struct mgmt_cbuf *cb)
         goto err;
     }
 
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+    if (off == 0) {
+        /* Let the previous upload finish before touching its state. */
+        imgr_upload_flush();
+    } else if (imgr_state.upload.err) {
+        /* A queued chunk failed to write; the upload has to restart. */
+        rc = imgr_state.upload.err;
+        imgr_upload_flush();
+        imgr_state.upload.err = 0;
+        if (imgr_state.upload.fa) {
+            goto err_close;
+        }
+        goto err;
+    }
+#endif
+
     if (off == 0) {
         if (data_len < sizeof(struct image_header)) {
             /*
@@ -285,7 +448,25 @@ imgr_upload(struct mgmt_cbuf *cb)
             goto err;
         }
         hdr = (struct image_header *)img_data;
-        if (hdr->ih_magic != IMAGE_MAGIC) {
+#if MYNEWT_VAL(IMGMGR_DELTA)
+        is_delta = imgr_delta_is_patch(img_data, data_len);
+#endif
+#if MYNEWT_VAL(IMGMGR_LZ)
+        is_lz = imgr_lz_is_stream(img_data, data_len);
+#endif
+#if MYNEWT_VAL(IMGMGR_DELTA)
+        if (is_delta) {
+            img_size = imgr_delta_img_size(img_data);
+        } else
+#endif
+#if MYNEWT_VAL(IMGMGR_LZ)
+        if (is_lz) {
+            img_size = imgr_lz_img_size(img_data);
+        } else
+#endif
+        if (hdr->ih_magic == IMAGE_MAGIC) {
+            img_size = IMAGE_SIZE(hdr);
+        } else {
             rc = MGMT_ERR_EINVAL;
             goto err;
         }
@@ -330,15 +511,34 @@ imgr_upload(struct mgmt_cbuf *cb)
                 rc = MGMT_ERR_EINVAL;
                 goto err;
             }
-            if (IMAGE_SIZE(hdr) > imgr_state.upload.fa->fa_size) {
+            if (img_size > imgr_state.upload.fa->fa_size) {
                 rc = MGMT_ERR_EINVAL;
                 goto err;
             }
-            /*
-             * XXX only erase if needed.
-             */
-            rc = flash_area_erase(imgr_state.upload.fa, 0,
-              imgr_state.upload.fa->fa_size);
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+            imgr_state.upload.err = 0;
+#endif
+            rc = imgr_upload_erase_init();
+            if (rc) {
+                rc = MGMT_ERR_EINVAL;
+                goto err_close;
+            }
+#if MYNEWT_VAL(IMGMGR_DELTA)
+            if (is_delta) {
+                rc = imgr_delta_start(img_data);
+            } else {
+                imgr_delta_stop();
+            }
+            if (rc) {
+                goto err_close;
+            }
+#endif
+#if MYNEWT_VAL(IMGMGR_LZ)
+            imgr_state.upload.is_lz = 0;
+            if (is_lz) {
+                imgr_lz_start(img_data);
+            }
+#endif
         } else {
             /*
              * No slot where to upload!
@@ -359,18 +559,23 @@ imgr_upload(struct mgmt_cbuf *cb)
         goto err;
     }
     if (data_len) {
-        rc = flash_area_write(imgr_state.upload.fa, imgr_state.upload.off,
-          img_data, data_len);
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+        /* The offset acknowledged covers queued chunks as well as those
+         * already written.
+         */
+        imgr_upload_queue_data(imgr_state.upload.off, img_data, data_len);
+        imgr_state.upload.off += data_len;
+#else
+        rc = imgr_upload_write(imgr_state.upload.off, img_data, data_len);
         if (rc) {
             rc = MGMT_ERR_EINVAL;
             goto err_close;
         }
         imgr_state.upload.off += data_len;
         if (imgr_state.upload.size == imgr_state.upload.off) {
-            /* Done */
-            flash_area_close(imgr_state.upload.fa);
-            imgr_state.upload.fa = NULL;
+            imgr_upload_done();
         }
+#endif
     }
 out:
     g_err |= cbor_encoder_create_map(penc, &rsp, CborIndefiniteLength);
@@ -378,6 +583,10 @@ out:
     g_err |= cbor_encode_int(&rsp, MGMT_ERR_EOK);
     g_err |= cbor_encode_text_stringz(&rsp, "off");
     g_err |= cbor_encode_int(&rsp, imgr_state.upload.off);
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+    g_err |= cbor_encode_text_stringz(&rsp, "win");
+    g_err |= cbor_encode_int(&rsp, MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW));
+#endif
     g_err |= cbor_encoder_close_container(penc, &rsp);
 
     if (g_err) {
@@ -385,6 +594,9 @@ out:
     }
     return 0;
 err_close:
+#if MYNEWT_VAL(IMGMGR_DELTA)
+    imgr_delta_stop();
+#endif
     flash_area_close(imgr_state.upload.fa);
     imgr_state.upload.fa = NULL;
 err:
@@ -400,6 +612,10 @@ imgmgr_module_init(void)
     rc = mgmt_group_register(&imgr_nmgr_group);
     SYSINIT_PANIC_ASSERT(rc == 0);
 
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+    imgr_upload_init();
+#endif
+
 #if MYNEWT_VAL(IMGMGR_CLI)
     rc = imgr_cli_register();
     SYSINIT_PANIC_ASSERT(rc == 0);
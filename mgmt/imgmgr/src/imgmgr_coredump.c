@@ -73,13 +73,11 @@ imgr_core_load(struct mgmt_cbuf *cb)
     int sz;
     const struct flash_area *fa;
     uint8_t data[IMGMGR_NMGR_MAX_MSG];
-    struct coredump_header *hdr;
+    uint32_t size;
     CborError g_err = CborNoError;
     CborEncoder *penc = &cb->encoder;
     CborEncoder rsp;
 
-    hdr = (struct coredump_header *)data;
-
     rc = cbor_read_object(&cb->it, dload_attr);
     if (rc || off == UINT_MAX) {
         rc = MGMT_ERR_EINVAL;
@@ -92,24 +90,24 @@ imgr_core_load(struct mgmt_cbuf *cb)
         goto err;
     }
 
-    rc = flash_area_read(fa, 0, hdr, sizeof(*hdr));
+    /*
+     * Corefile is sent expanded, as if it had been written without
+     * compression.
+     */
+    rc = coredump_size(fa, &size);
     if (rc) {
-        rc = MGMT_ERR_EINVAL;
-        goto err_close;
-    }
-    if (hdr->ch_magic != COREDUMP_MAGIC) {
         rc = MGMT_ERR_ENOENT;
         goto err_close;
     }
-    if (off > hdr->ch_size) {
-        off = hdr->ch_size;
+    if (off > size) {
+        off = size;
     }
-    sz = hdr->ch_size - off;
+    sz = size - off;
     if (sz > sizeof(data)) {
         sz = sizeof(data);
     }
 
-    rc = flash_area_read(fa, off, data, sz);
+    rc = coredump_read(fa, off, data, sz);
     if (rc) {
         rc = MGMT_ERR_EINVAL;
         goto err_close;
@@ -0,0 +1,258 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(IMGMGR_DELTA)
+
+#include <stddef.h>
+#include <string.h>
+
+#include "flash_map/flash_map.h"
+#include "bootutil/image.h"
+#include "mgmt/mgmt.h"
+
+#include "imgmgr/imgmgr.h"
+#include "imgmgr_priv.h"
+
+#define IMGR_DELTA_ST_HDR       0
+#define IMGR_DELTA_ST_OP        1
+#define IMGR_DELTA_ST_LIT       2
+
+static uint32_t
+imgr_delta_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+ * Checks whether a received chunk at upload offset 0 starts a patch.
+ */
+int
+imgr_delta_is_patch(const void *data, uint32_t len)
+{
+    return len >= sizeof(struct imgr_delta_hdr) &&
+           imgr_delta_u32(data) == IMGR_DELTA_MAGIC;
+}
+
+/*
+ * Size of the image a patch produces.
+ */
+uint32_t
+imgr_delta_img_size(const void *data)
+{
+    return imgr_delta_u32((const uint8_t *)data +
+                          offsetof(struct imgr_delta_hdr, idh_img_size));
+}
+
+/*
+ * Starts applying a patch to the upload area.  The patch must have been
+ * made against the image in the slot we are running from, and must produce
+ * an image that fits the upload area.
+ */
+int
+imgr_delta_start(const void *data)
+{
+    struct imgr_delta_state *ds;
+    uint8_t hash[IMGMGR_HASH_LEN];
+    int rc;
+
+    imgr_delta_stop();
+
+    ds = &imgr_state.upload.delta;
+    ds->ids_img_size = imgr_delta_img_size(data);
+    if (ds->ids_img_size < sizeof(struct image_header) ||
+        ds->ids_img_size > imgr_state.upload.fa->fa_size) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    rc = imgr_read_info(boot_current_slot, NULL, hash, NULL);
+    if (rc != 0) {
+        return MGMT_ERR_EINVAL;
+    }
+    if (memcmp(hash, (const uint8_t *)data +
+               offsetof(struct imgr_delta_hdr, idh_src_hash),
+               IMGMGR_HASH_LEN)) {
+        /* The patch was made against a different image. */
+        return MGMT_ERR_EINVAL;
+    }
+
+    rc = flash_area_open(flash_area_id_from_image_slot(boot_current_slot),
+                         &ds->ids_src);
+    if (rc) {
+        return MGMT_ERR_EINVAL;
+    }
+    imgr_state.upload.is_delta = 1;
+
+    return 0;
+}
+
+/*
+ * Stops applying a patch, whether it completed or not.
+ */
+void
+imgr_delta_stop(void)
+{
+    struct imgr_delta_state *ds;
+
+    ds = &imgr_state.upload.delta;
+    if (ds->ids_src) {
+        flash_area_close(ds->ids_src);
+    }
+    memset(ds, 0, sizeof(*ds));
+    imgr_state.upload.is_delta = 0;
+}
+
+static int
+imgr_delta_copy(struct imgr_delta_state *ds, uint32_t src_off, uint32_t len)
+{
+    uint8_t buf[64];
+    uint32_t chunk;
+    int rc;
+
+    if (src_off + len < src_off || src_off + len > ds->ids_src->fa_size ||
+        ds->ids_out_off + len > ds->ids_img_size) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    while (len > 0) {
+        chunk = len < sizeof(buf) ? len : sizeof(buf);
+        rc = flash_area_read(ds->ids_src, src_off, buf, chunk);
+        if (rc) {
+            return MGMT_ERR_EINVAL;
+        }
+        rc = imgr_upload_flash_write(ds->ids_out_off, buf, chunk);
+        if (rc) {
+            return MGMT_ERR_EINVAL;
+        }
+        src_off += chunk;
+        ds->ids_out_off += chunk;
+        len -= chunk;
+    }
+
+    return 0;
+}
+
+/*
+ * Feeds the next bytes of a patch.  Patches are consumed strictly in
+ * order; the image is written as it is reconstructed.
+ */
+int
+imgr_delta_write(const void *data, uint32_t len)
+{
+    struct imgr_delta_state *ds;
+    const uint8_t *p;
+    uint32_t need;
+    uint32_t n;
+    int rc;
+
+    ds = &imgr_state.upload.delta;
+    p = data;
+    while (len > 0) {
+        switch (ds->ids_state) {
+        case IMGR_DELTA_ST_HDR:
+        case IMGR_DELTA_ST_OP:
+            if (ds->ids_state == IMGR_DELTA_ST_HDR) {
+                need = sizeof(struct imgr_delta_hdr);
+            } else if (ds->ids_buf_len == 0 ||
+                       ds->ids_buf[0] == IMGR_DELTA_OP_LITERAL) {
+                need = 5;
+            } else if (ds->ids_buf[0] == IMGR_DELTA_OP_COPY) {
+                need = 9;
+            } else {
+                return MGMT_ERR_EINVAL;
+            }
+            n = need - ds->ids_buf_len;
+            if (n > len) {
+                n = len;
+            }
+            memcpy(ds->ids_buf + ds->ids_buf_len, p, n);
+            ds->ids_buf_len += n;
+            p += n;
+            len -= n;
+            if (ds->ids_buf_len < need) {
+                break;
+            }
+            if (ds->ids_state == IMGR_DELTA_ST_OP && need == 5 &&
+                ds->ids_buf[0] != IMGR_DELTA_OP_LITERAL) {
+                /* Opcode known now; a copy has a longer header. */
+                break;
+            }
+            ds->ids_buf_len = 0;
+
+            if (ds->ids_state == IMGR_DELTA_ST_HDR) {
+                /* Already checked by imgr_delta_start(). */
+                ds->ids_state = IMGR_DELTA_ST_OP;
+            } else if (ds->ids_buf[0] == IMGR_DELTA_OP_LITERAL) {
+                ds->ids_lit_rem = imgr_delta_u32(ds->ids_buf + 1);
+                if (ds->ids_out_off + ds->ids_lit_rem > ds->ids_img_size) {
+                    return MGMT_ERR_EINVAL;
+                }
+                ds->ids_state = IMGR_DELTA_ST_LIT;
+            } else {
+                rc = imgr_delta_copy(ds, imgr_delta_u32(ds->ids_buf + 1),
+                                     imgr_delta_u32(ds->ids_buf + 5));
+                if (rc) {
+                    return rc;
+                }
+            }
+            break;
+
+        case IMGR_DELTA_ST_LIT:
+            n = ds->ids_lit_rem;
+            if (n > len) {
+                n = len;
+            }
+            rc = imgr_upload_flash_write(ds->ids_out_off, p, n);
+            if (rc) {
+                return MGMT_ERR_EINVAL;
+            }
+            ds->ids_out_off += n;
+            ds->ids_lit_rem -= n;
+            p += n;
+            len -= n;
+            if (ds->ids_lit_rem == 0) {
+                ds->ids_state = IMGR_DELTA_ST_OP;
+            }
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Called once the whole patch has been fed.  Checks that it reconstructed
+ * a complete image, and validates that image like the boot loader would.
+ */
+int
+imgr_delta_finish(void)
+{
+    struct imgr_delta_state *ds;
+
+    ds = &imgr_state.upload.delta;
+    if (ds->ids_state != IMGR_DELTA_ST_OP || ds->ids_buf_len != 0 ||
+        ds->ids_out_off != ds->ids_img_size) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    return imgr_upload_validate(ds->ids_img_size);
+}
+
+#endif /* MYNEWT_VAL(IMGMGR_DELTA) */
@@ -0,0 +1,245 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(IMGMGR_LZ)
+
+#include <stddef.h>
+#include <string.h>
+
+#include "flash_map/flash_map.h"
+#include "mgmt/mgmt.h"
+
+#include "imgmgr/imgmgr.h"
+#include "imgmgr_priv.h"
+
+#define IMGR_LZ_ST_HDR          0
+#define IMGR_LZ_ST_TOKEN        1
+#define IMGR_LZ_ST_LIT          2
+
+#define IMGR_LZ_WIN_SZ          MYNEWT_VAL(IMGMGR_LZ_WINDOW)
+
+static uint32_t
+imgr_lz_u32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/*
+ * Checks whether a received chunk at upload offset 0 starts a compressed
+ * image.
+ */
+int
+imgr_lz_is_stream(const void *data, uint32_t len)
+{
+    return len >= sizeof(struct imgr_lz_hdr) &&
+           imgr_lz_u32(data) == IMGR_LZ_MAGIC;
+}
+
+/*
+ * Size of the image once decompressed.
+ */
+uint32_t
+imgr_lz_img_size(const void *data)
+{
+    return imgr_lz_u32((const uint8_t *)data +
+                       offsetof(struct imgr_lz_hdr, ilh_img_size));
+}
+
+/*
+ * Starts decompressing into the upload area.  Size of the image has
+ * already been checked against the area.
+ */
+void
+imgr_lz_start(const void *data)
+{
+    struct imgr_lz_state *ls;
+
+    ls = &imgr_state.upload.lz;
+    memset(ls, 0, offsetof(struct imgr_lz_state, ils_win));
+    ls->ils_img_size = imgr_lz_img_size(data);
+    imgr_state.upload.is_lz = 1;
+}
+
+/*
+ * Writes out everything decompressed so far.  Data is contiguous in the
+ * window, except when it wraps around the end.
+ */
+static int
+imgr_lz_flush(struct imgr_lz_state *ls)
+{
+    uint32_t idx;
+    uint32_t n;
+    int rc;
+
+    while (ls->ils_flushed < ls->ils_out_off) {
+        idx = ls->ils_flushed % IMGR_LZ_WIN_SZ;
+        n = ls->ils_out_off - ls->ils_flushed;
+        if (n > IMGR_LZ_WIN_SZ - idx) {
+            n = IMGR_LZ_WIN_SZ - idx;
+        }
+        rc = imgr_upload_flash_write(ls->ils_flushed, &ls->ils_win[idx], n);
+        if (rc) {
+            return MGMT_ERR_EINVAL;
+        }
+        ls->ils_flushed += n;
+    }
+    return 0;
+}
+
+/*
+ * Appends a byte of output.  The window is flushed when it is full of
+ * unwritten data; it still holds the last IMGR_LZ_WIN_SZ bytes after that.
+ */
+static int
+imgr_lz_put(struct imgr_lz_state *ls, uint8_t byte)
+{
+    int rc;
+
+    if (ls->ils_out_off >= ls->ils_img_size) {
+        return MGMT_ERR_EINVAL;
+    }
+    if (ls->ils_out_off - ls->ils_flushed == IMGR_LZ_WIN_SZ) {
+        rc = imgr_lz_flush(ls);
+        if (rc) {
+            return rc;
+        }
+    }
+    ls->ils_win[ls->ils_out_off % IMGR_LZ_WIN_SZ] = byte;
+    ls->ils_out_off++;
+    return 0;
+}
+
+static int
+imgr_lz_match(struct imgr_lz_state *ls, uint32_t dist, uint32_t len)
+{
+    uint32_t idx;
+    int rc;
+
+    if (dist == 0 || dist > IMGR_LZ_WIN_SZ || dist > ls->ils_out_off) {
+        return MGMT_ERR_EINVAL;
+    }
+    /* Byte at a time; the match may overlap what it produces. */
+    while (len-- > 0) {
+        idx = (ls->ils_out_off - dist) % IMGR_LZ_WIN_SZ;
+        rc = imgr_lz_put(ls, ls->ils_win[idx]);
+        if (rc) {
+            return rc;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Feeds the next bytes of a compressed image.
+ */
+int
+imgr_lz_write(const void *data, uint32_t len)
+{
+    struct imgr_lz_state *ls;
+    const uint8_t *p;
+    uint32_t need;
+    uint32_t n;
+    int rc;
+
+    ls = &imgr_state.upload.lz;
+    p = data;
+    while (len > 0) {
+        switch (ls->ils_state) {
+        case IMGR_LZ_ST_HDR:
+            need = sizeof(struct imgr_lz_hdr);
+            n = need - ls->ils_buf_len;
+            if (n > len) {
+                n = len;
+            }
+            memcpy(ls->ils_buf + ls->ils_buf_len, p, n);
+            ls->ils_buf_len += n;
+            p += n;
+            len -= n;
+            if (ls->ils_buf_len == need) {
+                /* Already checked by imgr_lz_start(). */
+                ls->ils_buf_len = 0;
+                ls->ils_state = IMGR_LZ_ST_TOKEN;
+            }
+            break;
+
+        case IMGR_LZ_ST_TOKEN:
+            ls->ils_buf[ls->ils_buf_len++] = *p++;
+            len--;
+            if (!(ls->ils_buf[0] & 0x80)) {
+                ls->ils_rem = ls->ils_buf[0] + 1;
+                ls->ils_buf_len = 0;
+                ls->ils_state = IMGR_LZ_ST_LIT;
+            } else if (ls->ils_buf_len == 3) {
+                ls->ils_buf_len = 0;
+                rc = imgr_lz_match(ls, ls->ils_buf[1] | (ls->ils_buf[2] << 8),
+                                   (ls->ils_buf[0] & 0x7f) +
+                                   IMGR_LZ_MATCH_MIN);
+                if (rc) {
+                    return rc;
+                }
+            }
+            break;
+
+        case IMGR_LZ_ST_LIT:
+            while (len > 0 && ls->ils_rem > 0) {
+                rc = imgr_lz_put(ls, *p++);
+                if (rc) {
+                    return rc;
+                }
+                len--;
+                ls->ils_rem--;
+            }
+            if (ls->ils_rem == 0) {
+                ls->ils_state = IMGR_LZ_ST_TOKEN;
+            }
+            break;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Called once the whole stream has been fed.  Writes out the remainder, and
+ * validates the image like the boot loader would.
+ */
+int
+imgr_lz_finish(void)
+{
+    struct imgr_lz_state *ls;
+    int rc;
+
+    ls = &imgr_state.upload.lz;
+    if (ls->ils_state != IMGR_LZ_ST_TOKEN || ls->ils_buf_len != 0 ||
+        ls->ils_out_off != ls->ils_img_size) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    rc = imgr_lz_flush(ls);
+    if (rc) {
+        return rc;
+    }
+
+    return imgr_upload_validate(ls->ils_img_size);
+}
+
+#endif /* MYNEWT_VAL(IMGMGR_LZ) */
@@ -66,11 +66,17 @@ struct imgmgr_upload_cmd {
  *      "len":<img_size>		inspected when off = 0
  *      "data":<base64encoded binary>
  * }
+ * With IMGMGR_DELTA, the data may be a delta image instead, and with
+ * IMGMGR_LZ a compressed image; "off" and "len" then refer to the patch
+ * or the compressed stream.
  *
  *
  * Response to upload:
  * {
  *      "off":<offset>
+ *      "win":<chunks>		with IMGMGR_UPLOAD_WINDOW; number of
+ *				chunks the client may send ahead of the
+ *				acknowledged offset
  * }
  *
  *
@@ -83,6 +89,66 @@ struct imgmgr_upload_cmd {
  * }
  */
 
+/*
+ * Delta image.  Uploaded in place of a full image; the image is rebuilt
+ * in the upload area from the image we are running and the patch.  All
+ * fields are little-endian.  The header is followed by a sequence of ops:
+ *
+ *   0x01 <len:4> <len bytes>          literal; bytes are copied from patch
+ *   0x02 <src_off:4> <len:4>          bytes are copied from running image
+ */
+#define IMGR_DELTA_MAGIC        0x96a1d3e5
+#define IMGR_DELTA_OP_LITERAL   0x01
+#define IMGR_DELTA_OP_COPY      0x02
+
+struct imgr_delta_hdr {
+    uint32_t idh_magic;
+    uint32_t idh_img_size;              /* Size of resulting image. */
+    uint8_t idh_src_hash[IMGMGR_HASH_LEN]; /* Hash of the source image. */
+};
+
+struct imgr_delta_state {
+    const struct flash_area *ids_src;
+    uint32_t ids_img_size;
+    uint32_t ids_out_off;       /* Bytes of image rebuilt so far. */
+    uint32_t ids_lit_rem;       /* Literal bytes still to come. */
+    uint8_t ids_state;
+    uint8_t ids_buf_len;
+    uint8_t ids_buf[sizeof(struct imgr_delta_hdr)]; /* Partial header/op. */
+};
+
+/*
+ * Compressed image.  Uploaded in place of a full image, and decompressed
+ * into the upload area as it arrives.  Fields are little-endian.  The
+ * header is followed by tokens:
+ *
+ *   0x00-0x7f <n + 1 bytes>           literal run of n + 1 bytes
+ *   0x80-0xff <dist:2>                copy (n & 0x7f) + 3 bytes starting
+ *                                     dist bytes back in the output
+ *
+ * dist must not exceed IMGMGR_LZ_WINDOW.
+ */
+#define IMGR_LZ_MAGIC           0x96a1d3e6
+#define IMGR_LZ_MATCH_MIN       3
+
+struct imgr_lz_hdr {
+    uint32_t ilh_magic;
+    uint32_t ilh_img_size;              /* Size of decompressed image. */
+};
+
+#if MYNEWT_VAL(IMGMGR_LZ)
+struct imgr_lz_state {
+    uint32_t ils_img_size;
+    uint32_t ils_out_off;       /* Bytes decompressed so far... */
+    uint32_t ils_flushed;       /* ...and written to flash. */
+    uint8_t ils_state;
+    uint8_t ils_rem;            /* Literal bytes still to come. */
+    uint8_t ils_buf_len;
+    uint8_t ils_buf[sizeof(struct imgr_lz_hdr)]; /* Partial header/token. */
+    uint8_t ils_win[MYNEWT_VAL(IMGMGR_LZ_WINDOW)];
+};
+#endif
+
 struct nmgr_hdr;
 struct os_mbuf;
 struct fs_file;
@@ -93,8 +159,21 @@ struct imgr_state {
         uint32_t off;
         uint32_t size;
         const struct flash_area *fa;
+        uint32_t erased_to;     /* Area is erased up to here... */
+        uint32_t tail_off;      /* ...and from here to the end. */
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+        int err;                /* Set if a queued chunk failed to write. */
+#endif
 #if MYNEWT_VAL(IMGMGR_FS)
         struct fs_file *file;
+#endif
+#if MYNEWT_VAL(IMGMGR_DELTA)
+        uint8_t is_delta;       /* Upload is a patch, not an image. */
+        struct imgr_delta_state delta;
+#endif
+#if MYNEWT_VAL(IMGMGR_LZ)
+        uint8_t is_lz;          /* Upload is compressed. */
+        struct imgr_lz_state lz;
 #endif
     } upload;
 };
@@ -118,6 +197,40 @@ int imgr_find_by_ver(struct image_version *find, uint8_t *hash);
 int imgr_find_by_hash(uint8_t *find, struct image_version *ver);
 int imgr_cli_register(void);
 
+#if MYNEWT_VAL(IMGMGR_INFO_CACHE)
+void imgr_info_invalidate(void);
+int imgr_swap_type(void);
+#else
+#define imgr_info_invalidate()
+#define imgr_swap_type() boot_swap_type()
+#endif
+
+int imgr_upload_erase_init(void);
+int imgr_upload_flash_write(uint32_t off, const void *data, uint32_t len);
+int imgr_upload_write(uint32_t off, const void *data, uint32_t len);
+int imgr_upload_validate(uint32_t img_size);
+void imgr_upload_done(void);
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+void imgr_upload_init(void);
+int imgr_upload_queue_data(uint32_t off, const void *data, uint32_t len);
+void imgr_upload_flush(void);
+#endif
+#if MYNEWT_VAL(IMGMGR_DELTA)
+int imgr_delta_is_patch(const void *data, uint32_t len);
+uint32_t imgr_delta_img_size(const void *data);
+int imgr_delta_start(const void *data);
+void imgr_delta_stop(void);
+int imgr_delta_write(const void *data, uint32_t len);
+int imgr_delta_finish(void);
+#endif
+#if MYNEWT_VAL(IMGMGR_LZ)
+int imgr_lz_is_stream(const void *data, uint32_t len);
+uint32_t imgr_lz_img_size(const void *data);
+void imgr_lz_start(const void *data);
+int imgr_lz_write(const void *data, uint32_t len);
+int imgr_lz_finish(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
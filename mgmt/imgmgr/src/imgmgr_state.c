@@ -46,7 +46,7 @@ imgmgr_state_flags(int query_slot)
     /* Determine if this is is pending or confirmed (only applicable for
      * unified images and loaders.
      */
-    swap_type = boot_swap_type();
+    swap_type = imgr_swap_type();
     switch (swap_type) {
     case BOOT_SWAP_TYPE_NONE:
         if (query_slot == 0) {
@@ -162,6 +162,7 @@ imgmgr_state_test_slot(int slot)
         if (!split_app_active) {
             /* No change in split status. */
             rc = boot_set_pending();
+            imgr_info_invalidate();
             if (rc != 0) {
                 return MGMT_ERR_EUNKNOWN;
             }
@@ -192,6 +193,7 @@ imgmgr_state_confirm(void)
 
     /* Confirm the unified image or loader in slot 0. */
     rc = boot_set_confirmed();
+    imgr_info_invalidate();
     if (rc != 0) {
         return MGMT_ERR_EUNKNOWN;
     }
@@ -228,6 +230,11 @@ imgmgr_state_read(struct mgmt_cbuf *cb)
     CborEncoder *penc = &cb->encoder;
     CborEncoder rsp, images, image;
 
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+    /* Report on the image as uploaded, not as written so far. */
+    imgr_upload_flush();
+#endif
+
     any_non_bootable = 0;
 
     g_err |= cbor_encoder_create_map(penc, &rsp, CborIndefiniteLength);
@@ -320,6 +327,11 @@ imgmgr_state_write(struct mgmt_cbuf *cb)
         [2] = { 0 },
     };
 
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+    /* Act on the image as uploaded, not as written so far. */
+    imgr_upload_flush();
+#endif
+
     rc = cbor_read_object(&cb->it, write_attr);
     if (rc != 0) {
         rc = MGMT_ERR_EINVAL;
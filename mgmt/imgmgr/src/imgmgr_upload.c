@@ -0,0 +1,342 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "flash_map/flash_map.h"
+#include "bootutil/image.h"
+#include "mgmt/mgmt.h"
+
+#include "imgmgr/imgmgr.h"
+#include "imgmgr_priv.h"
+
+/*
+ * Finds the flash sector containing the given offset of the upload area.
+ * Offsets are relative to the start of the area.
+ */
+static int
+imgr_upload_sector(const struct flash_area *fa, uint32_t off,
+                   uint32_t *out_start, uint32_t *out_end)
+{
+    struct flash_area sector;
+
+    if (flash_area_sector_from_off(fa, off, &sector) < 0) {
+        return -1;
+    }
+    *out_start = sector.fa_off - fa->fa_off;
+    *out_end = sector.fa_off + sector.fa_size - fa->fa_off;
+    return 0;
+}
+
+/*
+ * Prepares the upload area for a new image.  Only the sector at the end of
+ * the area, which holds the boot trailer, is erased now; the remaining
+ * sectors are erased as data reaches them.
+ */
+int
+imgr_upload_erase_init(void)
+{
+    const struct flash_area *fa;
+    uint32_t start;
+    uint32_t end;
+    int rc;
+
+    fa = imgr_state.upload.fa;
+    bootutil_img_hash_cache_clear(fa->fa_id);
+    imgr_info_invalidate();
+    rc = imgr_upload_sector(fa, fa->fa_size - 1, &start, &end);
+    if (rc) {
+        return rc;
+    }
+    rc = flash_area_erase(fa, start, end - start);
+    if (rc) {
+        return rc;
+    }
+
+    imgr_state.upload.erased_to = 0;
+    imgr_state.upload.tail_off = start;
+
+    return 0;
+}
+
+/*
+ * Writes a chunk of image data to the upload area, erasing the sectors it
+ * extends into first.
+ */
+int
+imgr_upload_flash_write(uint32_t off, const void *data, uint32_t len)
+{
+    const struct flash_area *fa;
+    uint32_t start;
+    uint32_t end;
+    int rc;
+
+    fa = imgr_state.upload.fa;
+    imgr_info_invalidate();
+    while (imgr_state.upload.erased_to < off + len) {
+        if (imgr_state.upload.erased_to >= imgr_state.upload.tail_off) {
+            /* The trailer sector was erased when the upload started. */
+            imgr_state.upload.erased_to = fa->fa_size;
+            break;
+        }
+        rc = imgr_upload_sector(fa, imgr_state.upload.erased_to, &start,
+                                &end);
+        if (rc) {
+            return rc;
+        }
+        rc = flash_area_erase(fa, start, end - start);
+        if (rc) {
+            return rc;
+        }
+        imgr_state.upload.erased_to = end;
+    }
+
+    return flash_area_write(fa, off, data, len);
+}
+
+/*
+ * Checks the image rebuilt from a patch or a compressed stream, like the
+ * boot loader would.
+ */
+int
+imgr_upload_validate(uint32_t img_size)
+{
+    struct image_header hdr;
+    uint8_t tmp_buf[64];
+    int rc;
+
+    rc = flash_area_read(imgr_state.upload.fa, 0, &hdr, sizeof(hdr));
+    if (rc || hdr.ih_magic != IMAGE_MAGIC || IMAGE_SIZE(&hdr) != img_size) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    rc = bootutil_img_validate(&hdr, imgr_state.upload.fa, tmp_buf,
+                               sizeof(tmp_buf), NULL, 0, NULL);
+    if (rc) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    return 0;
+}
+
+#if MYNEWT_VAL(IMGMGR_DELTA) || MYNEWT_VAL(IMGMGR_LZ)
+/*
+ * Called after the last chunk of a patch or compressed stream.  An image
+ * which failed to validate has its header erased, so that it doesn't look
+ * like an image.
+ */
+static int
+imgr_upload_check(int rc)
+{
+    uint32_t start;
+    uint32_t end;
+
+    if (rc && !imgr_upload_sector(imgr_state.upload.fa, 0, &start, &end)) {
+        flash_area_erase(imgr_state.upload.fa, start, end - start);
+        imgr_info_invalidate();
+    }
+    return rc;
+}
+#endif
+
+/*
+ * Consumes a chunk of the upload.  Images are written as they come; for a
+ * patch or a compressed stream the image it describes is written instead,
+ * and checked once the last chunk has been fed.
+ */
+int
+imgr_upload_write(uint32_t off, const void *data, uint32_t len)
+{
+#if MYNEWT_VAL(IMGMGR_DELTA) || MYNEWT_VAL(IMGMGR_LZ)
+    int last;
+    int rc;
+
+    last = off + len == imgr_state.upload.size;
+#endif
+
+#if MYNEWT_VAL(IMGMGR_DELTA)
+    if (imgr_state.upload.is_delta) {
+        rc = imgr_delta_write(data, len);
+        if (rc == 0 && last) {
+            rc = imgr_upload_check(imgr_delta_finish());
+            imgr_delta_stop();
+        }
+        return rc;
+    }
+#endif
+#if MYNEWT_VAL(IMGMGR_LZ)
+    if (imgr_state.upload.is_lz) {
+        rc = imgr_lz_write(data, len);
+        if (rc == 0 && last) {
+            rc = imgr_upload_check(imgr_lz_finish());
+            imgr_state.upload.is_lz = 0;
+        }
+        return rc;
+    }
+#endif
+
+    return imgr_upload_flash_write(off, data, len);
+}
+
+#if MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0
+
+/*
+ * Chunks accepted from the client, but not yet written to flash.
+ */
+struct imgr_upload_buf {
+    STAILQ_ENTRY(imgr_upload_buf) iub_next;
+    uint32_t iub_off;
+    uint16_t iub_len;
+    uint8_t iub_data[IMGMGR_NMGR_MAX_MSG];
+};
+
+static struct imgr_upload_buf
+    imgr_upload_bufs[MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW)];
+static STAILQ_HEAD(, imgr_upload_buf) imgr_upload_free =
+    STAILQ_HEAD_INITIALIZER(imgr_upload_free);
+static STAILQ_HEAD(, imgr_upload_buf) imgr_upload_queue =
+    STAILQ_HEAD_INITIALIZER(imgr_upload_queue);
+
+/* Counts free buffers; a buffer is only released once it is written. */
+static struct os_sem imgr_upload_sem;
+
+static struct os_eventq imgr_upload_evq;
+static struct os_event imgr_upload_ev;
+static struct os_task imgr_upload_task;
+static os_stack_t imgr_upload_stack[
+    OS_STACK_ALIGN(MYNEWT_VAL(IMGMGR_UPLOAD_STACK_SIZE))];
+
+static void
+imgr_upload_drain(struct os_event *ev)
+{
+    struct imgr_upload_buf *iub;
+    os_sr_t sr;
+    int rc;
+
+    while (1) {
+        OS_ENTER_CRITICAL(sr);
+        iub = STAILQ_FIRST(&imgr_upload_queue);
+        if (iub) {
+            STAILQ_REMOVE_HEAD(&imgr_upload_queue, iub_next);
+        }
+        OS_EXIT_CRITICAL(sr);
+        if (!iub) {
+            break;
+        }
+
+        if (imgr_state.upload.err == 0) {
+            rc = imgr_upload_write(iub->iub_off, iub->iub_data,
+                                   iub->iub_len);
+            if (rc) {
+                imgr_state.upload.err = MGMT_ERR_EINVAL;
+            } else if (iub->iub_off + iub->iub_len ==
+                       imgr_state.upload.size) {
+                imgr_upload_done();
+            }
+        }
+
+        OS_ENTER_CRITICAL(sr);
+        STAILQ_INSERT_TAIL(&imgr_upload_free, iub, iub_next);
+        OS_EXIT_CRITICAL(sr);
+        os_sem_release(&imgr_upload_sem);
+    }
+}
+
+static void
+imgr_upload_task_handler(void *arg)
+{
+    while (1) {
+        os_eventq_run(&imgr_upload_evq);
+    }
+}
+
+/*
+ * Queues a chunk to be written by the upload task.  Blocks while all
+ * buffers are in use.
+ */
+int
+imgr_upload_queue_data(uint32_t off, const void *data, uint32_t len)
+{
+    struct imgr_upload_buf *iub;
+    os_sr_t sr;
+
+    os_sem_pend(&imgr_upload_sem, OS_TIMEOUT_NEVER);
+
+    OS_ENTER_CRITICAL(sr);
+    iub = STAILQ_FIRST(&imgr_upload_free);
+    assert(iub != NULL);
+    STAILQ_REMOVE_HEAD(&imgr_upload_free, iub_next);
+    OS_EXIT_CRITICAL(sr);
+
+    iub->iub_off = off;
+    iub->iub_len = len;
+    memcpy(iub->iub_data, data, len);
+
+    OS_ENTER_CRITICAL(sr);
+    STAILQ_INSERT_TAIL(&imgr_upload_queue, iub, iub_next);
+    OS_EXIT_CRITICAL(sr);
+
+    os_eventq_put(&imgr_upload_evq, &imgr_upload_ev);
+
+    return 0;
+}
+
+/*
+ * Waits until every queued chunk has been written to flash.
+ */
+void
+imgr_upload_flush(void)
+{
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW); i++) {
+        os_sem_pend(&imgr_upload_sem, OS_TIMEOUT_NEVER);
+    }
+    for (i = 0; i < MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW); i++) {
+        os_sem_release(&imgr_upload_sem);
+    }
+}
+
+void
+imgr_upload_init(void)
+{
+    int rc;
+    int i;
+
+    for (i = 0; i < MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW); i++) {
+        STAILQ_INSERT_TAIL(&imgr_upload_free, &imgr_upload_bufs[i],
+                           iub_next);
+    }
+    rc = os_sem_init(&imgr_upload_sem, MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW));
+    assert(rc == 0);
+
+    os_eventq_init(&imgr_upload_evq);
+    imgr_upload_ev.ev_cb = imgr_upload_drain;
+    rc = os_task_init(&imgr_upload_task, "imgr_upload",
+                      imgr_upload_task_handler, NULL,
+                      MYNEWT_VAL(IMGMGR_UPLOAD_TASK_PRIO), OS_WAIT_FOREVER,
+                      imgr_upload_stack,
+                      OS_STACK_ALIGN(MYNEWT_VAL(IMGMGR_UPLOAD_STACK_SIZE)));
+    assert(rc == 0);
+}
+
+#endif /* MYNEWT_VAL(IMGMGR_UPLOAD_WINDOW) > 0 */
@@ -48,6 +48,8 @@ extern "C" {
 #define MGMT_GROUP_ID_CRASH     (5)
 #define MGMT_GROUP_ID_SPLIT     (6)
 #define MGMT_GROUP_ID_RUNTEST   (7)
+#define MGMT_GROUP_ID_BENCH     (8)
+#define MGMT_GROUP_ID_BLE       (9)
 #define MGMT_GROUP_ID_PERUSER   (64)
 
 /**
@@ -33,12 +33,18 @@ extern "C" {
 #define NMGR_OP_WRITE           (2)
 #define NMGR_OP_WRITE_RSP       (3)
 
+/*
+ * A client may have several requests outstanding, and may also pack more
+ * than one request into a packet; each request is a header followed by
+ * nh_len bytes of payload.  Requests are answered in the order received,
+ * and responses are matched to requests by nh_seq.
+ */
 struct nmgr_hdr {
     uint8_t  nh_op;             /* NMGR_OP_XXX */
     uint8_t  nh_flags;
     uint16_t nh_len;            /* length of the payload */
     uint16_t nh_group;          /* NMGR_GROUP_XXX */
-    uint8_t  nh_seq;            /* sequence number */
+    uint8_t  nh_seq;            /* sequence number; echoed in response */
     uint8_t  nh_id;             /* message ID within group */
 };
 
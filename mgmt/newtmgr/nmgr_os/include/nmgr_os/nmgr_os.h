@@ -33,6 +33,9 @@ extern "C" {
 #define NMGR_ID_MPSTATS         3
 #define NMGR_ID_DATETIME_STR    4
 #define NMGR_ID_RESET           5
+#define NMGR_ID_EVQSTATS        6
+#define NMGR_ID_HEAPSTATS       7
+#define NMGR_ID_MSYS_ADVICE     8
 
 int nmgr_os_groups_register(void);
 
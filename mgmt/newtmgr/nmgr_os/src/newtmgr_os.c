@@ -17,6 +17,7 @@
  * under the License.
  */
 
+#include <syscfg/syscfg.h>
 #include <os/os.h>
 #include <os/endian.h>
 
@@ -45,6 +46,14 @@ static int nmgr_def_mpstat_read(struct mgmt_cbuf *njb);
 static int nmgr_datetime_get(struct mgmt_cbuf *njb);
 static int nmgr_datetime_set(struct mgmt_cbuf *njb);
 static int nmgr_reset(struct mgmt_cbuf *njb);
+#if MYNEWT_VAL(OS_EVENTQ_LATENCY)
+static int nmgr_def_evqstat_read(struct mgmt_cbuf *njb);
+#endif
+static int nmgr_def_heapstat_read(struct mgmt_cbuf *njb);
+#if MYNEWT_VAL(OS_MSYS_ADVISE)
+static int nmgr_def_msys_advice_read(struct mgmt_cbuf *njb);
+static int nmgr_def_msys_advice_clear(struct mgmt_cbuf *njb);
+#endif
 
 static const struct mgmt_handler nmgr_def_group_handlers[] = {
     [NMGR_ID_ECHO] = {
@@ -65,6 +74,19 @@ static const struct mgmt_handler nmgr_def_group_handlers[] = {
     [NMGR_ID_RESET] = {
         NULL, nmgr_reset
     },
+#if MYNEWT_VAL(OS_EVENTQ_LATENCY)
+    [NMGR_ID_EVQSTATS] = {
+        nmgr_def_evqstat_read, NULL
+    },
+#endif
+    [NMGR_ID_HEAPSTATS] = {
+        nmgr_def_heapstat_read, NULL
+    },
+#if MYNEWT_VAL(OS_MSYS_ADVISE)
+    [NMGR_ID_MSYS_ADVICE] = {
+        nmgr_def_msys_advice_read, nmgr_def_msys_advice_clear
+    },
+#endif
 };
 
 #define NMGR_DEF_GROUP_SZ                                               \
@@ -161,27 +183,43 @@ nmgr_def_taskstat_read(struct mgmt_cbuf *cb)
 
         g_err |= cbor_encode_text_stringz(&tasks, oti.oti_name);
         g_err |= cbor_encoder_create_map(&tasks, &task, CborIndefiniteLength);
-        g_err |= cbor_encode_text_stringz(&rsp, "prio");
-        g_err |= cbor_encode_uint(&rsp, oti.oti_prio);
-        g_err |= cbor_encode_text_stringz(&rsp, "tid");
-        g_err |= cbor_encode_uint(&rsp, oti.oti_taskid);
-        g_err |= cbor_encode_text_stringz(&rsp, "state");
-        g_err |= cbor_encode_uint(&rsp, oti.oti_state);
-        g_err |= cbor_encode_text_stringz(&rsp, "stkuse");
-        g_err |= cbor_encode_uint(&rsp, oti.oti_stkusage);
-        g_err |= cbor_encode_text_stringz(&rsp, "stksiz");
-        g_err |= cbor_encode_uint(&rsp, oti.oti_stksize);
-        g_err |= cbor_encode_text_stringz(&rsp, "cswcnt");
-        g_err |= cbor_encode_uint(&rsp, oti.oti_cswcnt);
-        g_err |= cbor_encode_text_stringz(&rsp, "runtime");
-        g_err |= cbor_encode_uint(&rsp, oti.oti_runtime);
-        g_err |= cbor_encode_text_stringz(&rsp, "last_checkin");
-        g_err |= cbor_encode_uint(&rsp, oti.oti_last_checkin);
-        g_err |= cbor_encode_text_stringz(&rsp, "next_checkin");
-        g_err |= cbor_encode_uint(&rsp, oti.oti_next_checkin);
+        g_err |= cbor_encode_text_stringz(&task, "prio");
+        g_err |= cbor_encode_uint(&task, oti.oti_prio);
+        g_err |= cbor_encode_text_stringz(&task, "tid");
+        g_err |= cbor_encode_uint(&task, oti.oti_taskid);
+        g_err |= cbor_encode_text_stringz(&task, "state");
+        g_err |= cbor_encode_uint(&task, oti.oti_state);
+        g_err |= cbor_encode_text_stringz(&task, "stkuse");
+        g_err |= cbor_encode_uint(&task, oti.oti_stkusage);
+        g_err |= cbor_encode_text_stringz(&task, "stksiz");
+        g_err |= cbor_encode_uint(&task, oti.oti_stksize);
+        g_err |= cbor_encode_text_stringz(&task, "cswcnt");
+        g_err |= cbor_encode_uint(&task, oti.oti_cswcnt);
+        g_err |= cbor_encode_text_stringz(&task, "runtime");
+        g_err |= cbor_encode_uint(&task, oti.oti_runtime);
+        g_err |= cbor_encode_text_stringz(&task, "last_checkin");
+        g_err |= cbor_encode_uint(&task, oti.oti_last_checkin);
+        g_err |= cbor_encode_text_stringz(&task, "next_checkin");
+        g_err |= cbor_encode_uint(&task, oti.oti_next_checkin);
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+        g_err |= cbor_encode_text_stringz(&task, "prof_run");
+        g_err |= cbor_encode_uint(&task, oti.oti_prof_run);
+        g_err |= cbor_encode_text_stringz(&task, "prof_maxrun");
+        g_err |= cbor_encode_uint(&task, oti.oti_prof_max_run);
+        g_err |= cbor_encode_text_stringz(&task, "preempts");
+        g_err |= cbor_encode_uint(&task, oti.oti_prof_preempts);
+        g_err |= cbor_encode_text_stringz(&task, "yields");
+        g_err |= cbor_encode_uint(&task, oti.oti_prof_yields);
+        g_err |= cbor_encode_text_stringz(&task, "cpu_pct");
+        g_err |= cbor_encode_uint(&task, oti.oti_cpu_pct);
+#endif
         g_err |= cbor_encoder_close_container(&tasks, &task);
     }
     g_err |= cbor_encoder_close_container(&rsp, &tasks);
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+    g_err |= cbor_encode_text_stringz(&rsp, "isr_time");
+    g_err |= cbor_encode_uint(&rsp, os_prof_isr_time());
+#endif
     g_err |= cbor_encoder_close_container(&cb->encoder, &rsp);
 
     if (g_err) {
@@ -213,12 +251,18 @@ nmgr_def_mpstat_read(struct mgmt_cbuf *cb)
 
         g_err |= cbor_encode_text_stringz(&pools, omi.omi_name);
         g_err |= cbor_encoder_create_map(&pools, &pool, CborIndefiniteLength);
-        g_err |= cbor_encode_text_stringz(&rsp, "blksiz");
-        g_err |= cbor_encode_uint(&rsp, omi.omi_block_size);
-        g_err |= cbor_encode_text_stringz(&rsp, "nblks");
-        g_err |= cbor_encode_uint(&rsp, omi.omi_num_blocks);
-        g_err |= cbor_encode_text_stringz(&rsp, "nfree");
-        g_err |= cbor_encode_uint(&rsp, omi.omi_num_free);
+        g_err |= cbor_encode_text_stringz(&pool, "blksiz");
+        g_err |= cbor_encode_uint(&pool, omi.omi_block_size);
+        g_err |= cbor_encode_text_stringz(&pool, "nblks");
+        g_err |= cbor_encode_uint(&pool, omi.omi_num_blocks);
+        g_err |= cbor_encode_text_stringz(&pool, "nfree");
+        g_err |= cbor_encode_uint(&pool, omi.omi_num_free);
+        g_err |= cbor_encode_text_stringz(&pool, "min");
+        g_err |= cbor_encode_uint(&pool, omi.omi_min_free);
+        g_err |= cbor_encode_text_stringz(&pool, "nfail");
+        g_err |= cbor_encode_uint(&pool, omi.omi_num_fail);
+        g_err |= cbor_encode_text_stringz(&pool, "bytes");
+        g_err |= cbor_encode_uint(&pool, omi.omi_mem_bytes);
         g_err |= cbor_encoder_close_container(&pools, &pool);
     }
 
@@ -231,6 +275,217 @@ nmgr_def_mpstat_read(struct mgmt_cbuf *cb)
     return (0);
 }
 
+#if MYNEWT_VAL(OS_EVENTQ_LATENCY)
+static int
+nmgr_def_evqstat_read(struct mgmt_cbuf *cb)
+{
+    struct os_eventq *prev_evq;
+    struct os_eventq_info oei;
+    CborError g_err = CborNoError;
+    CborEncoder rsp, evqs, evq, hist;
+    int i;
+
+    g_err |= cbor_encoder_create_map(&cb->encoder, &rsp, CborIndefiniteLength);
+    g_err |= cbor_encode_text_stringz(&rsp, "rc");
+    g_err |= cbor_encode_int(&rsp, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&rsp, "evqs");
+    g_err |= cbor_encoder_create_map(&rsp, &evqs, CborIndefiniteLength);
+
+    prev_evq = NULL;
+    while (1) {
+        prev_evq = os_eventq_info_get_next(prev_evq, &oei);
+        if (prev_evq == NULL) {
+            break;
+        }
+
+        g_err |= cbor_encode_text_stringz(&evqs, oei.oei_name);
+        g_err |= cbor_encoder_create_map(&evqs, &evq, CborIndefiniteLength);
+        g_err |= cbor_encode_text_stringz(&evq, "lat");
+        g_err |= cbor_encoder_create_array(&evq, &hist,
+                MYNEWT_VAL(OS_EVENTQ_LATENCY_BUCKETS));
+        for (i = 0; i < MYNEWT_VAL(OS_EVENTQ_LATENCY_BUCKETS); i++) {
+            g_err |= cbor_encode_uint(&hist, oei.oei_lat_hist[i]);
+        }
+        g_err |= cbor_encoder_close_container(&evq, &hist);
+        g_err |= cbor_encoder_close_container(&evqs, &evq);
+    }
+
+    g_err |= cbor_encoder_close_container(&rsp, &evqs);
+    g_err |= cbor_encoder_close_container(&cb->encoder, &rsp);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+}
+#endif
+
+static int
+nmgr_def_heapstat_read(struct mgmt_cbuf *cb)
+{
+    struct os_heap_info ohi;
+    CborError g_err = CborNoError;
+    CborEncoder rsp;
+#if MYNEWT_VAL(BASELIBC_MALLOC_TRACE) > 0
+    struct malloc_trace mt;
+    CborEncoder trace, ent;
+    int i;
+#endif
+
+    if (os_heap_info_get(&ohi) != 0) {
+        return MGMT_ERR_ENOENT;
+    }
+
+    g_err |= cbor_encoder_create_map(&cb->encoder, &rsp, CborIndefiniteLength);
+    g_err |= cbor_encode_text_stringz(&rsp, "rc");
+    g_err |= cbor_encode_int(&rsp, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&rsp, "free");
+    g_err |= cbor_encode_uint(&rsp, ohi.ohi_free);
+    g_err |= cbor_encode_text_stringz(&rsp, "min");
+    g_err |= cbor_encode_uint(&rsp, ohi.ohi_min_free);
+    g_err |= cbor_encode_text_stringz(&rsp, "largest");
+    g_err |= cbor_encode_uint(&rsp, ohi.ohi_largest_free);
+    g_err |= cbor_encode_text_stringz(&rsp, "nfblks");
+    g_err |= cbor_encode_uint(&rsp, ohi.ohi_free_blocks);
+    g_err |= cbor_encode_text_stringz(&rsp, "nalloc");
+    g_err |= cbor_encode_uint(&rsp, ohi.ohi_num_allocs);
+    g_err |= cbor_encode_text_stringz(&rsp, "nfree");
+    g_err |= cbor_encode_uint(&rsp, ohi.ohi_num_frees);
+    g_err |= cbor_encode_text_stringz(&rsp, "nfail");
+    g_err |= cbor_encode_uint(&rsp, ohi.ohi_num_fail);
+
+#if MYNEWT_VAL(BASELIBC_MALLOC_TRACE) > 0
+    /* Most recent first; a size of 0 is a free */
+    g_err |= cbor_encode_text_stringz(&rsp, "trace");
+    g_err |= cbor_encoder_create_array(&rsp, &trace, CborIndefiniteLength);
+    for (i = 0; get_malloc_trace(i, &mt) == 0; i++) {
+        g_err |= cbor_encoder_create_map(&trace, &ent, CborIndefiniteLength);
+        g_err |= cbor_encode_text_stringz(&ent, "ptr");
+        g_err |= cbor_encode_uint(&ent, (uintptr_t)mt.mt_ptr);
+        g_err |= cbor_encode_text_stringz(&ent, "size");
+        g_err |= cbor_encode_uint(&ent, mt.mt_size);
+        g_err |= cbor_encode_text_stringz(&ent, "pc");
+        g_err |= cbor_encode_uint(&ent, (uintptr_t)mt.mt_caller);
+        g_err |= cbor_encoder_close_container(&trace, &ent);
+    }
+    g_err |= cbor_encoder_close_container(&rsp, &trace);
+#endif
+
+    g_err |= cbor_encoder_close_container(&cb->encoder, &rsp);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return (0);
+}
+
+#if MYNEWT_VAL(OS_MSYS_ADVISE)
+/*
+ * Reports the msys demand counters, the msys pool layout recommended for
+ * the RAM budget given in the request, and the number of blocks recommended
+ * for every memory pool.
+ */
+static int
+nmgr_def_msys_advice_read(struct mgmt_cbuf *cb)
+{
+    struct os_msys_demand omd;
+    struct os_msys_advice oma;
+    struct os_mempool *prev_mp;
+    struct os_mempool_info omi;
+    long long unsigned int budget;
+    CborError g_err = CborNoError;
+    CborEncoder rsp, arr, ent;
+    int rc;
+    int i;
+    const struct cbor_attr_t advice_attr[2] = {
+        [0] = {
+            .attribute = "budget",
+            .type = CborAttrUnsignedIntegerType,
+            .addr.uinteger = &budget,
+            .dflt.integer = 0,
+        },
+        { 0 },
+    };
+
+    budget = 0;
+    rc = cbor_read_object(&cb->it, advice_attr);
+    if (rc != 0 || budget > UINT32_MAX) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    os_msys_demand_get(&omd);
+    rc = os_msys_advise(budget, &oma);
+    if (rc != 0) {
+        return MGMT_ERR_ENOENT;
+    }
+
+    g_err |= cbor_encoder_create_map(&cb->encoder, &rsp, CborIndefiniteLength);
+    g_err |= cbor_encode_text_stringz(&rsp, "rc");
+    g_err |= cbor_encode_int(&rsp, MGMT_ERR_EOK);
+
+    g_err |= cbor_encode_text_stringz(&rsp, "demand");
+    g_err |= cbor_encoder_create_array(&rsp, &arr, OS_MSYS_DEMAND_CLASSES);
+    for (i = 0; i < OS_MSYS_DEMAND_CLASSES; i++) {
+        g_err |= cbor_encode_uint(&arr, omd.omd_reqs[i]);
+    }
+    g_err |= cbor_encoder_close_container(&rsp, &arr);
+    g_err |= cbor_encode_text_stringz(&rsp, "nfail");
+    g_err |= cbor_encode_uint(&rsp, omd.omd_num_fail);
+
+    g_err |= cbor_encode_text_stringz(&rsp, "msys");
+    g_err |= cbor_encoder_create_array(&rsp, &arr, oma.oma_num_pools);
+    for (i = 0; i < oma.oma_num_pools; i++) {
+        g_err |= cbor_encoder_create_map(&arr, &ent, CborIndefiniteLength);
+        g_err |= cbor_encode_text_stringz(&ent, "blksiz");
+        g_err |= cbor_encode_uint(&ent, oma.oma_pools[i].omap_block_size);
+        g_err |= cbor_encode_text_stringz(&ent, "nblks");
+        g_err |= cbor_encode_uint(&ent, oma.oma_pools[i].omap_block_count);
+        g_err |= cbor_encoder_close_container(&arr, &ent);
+    }
+    g_err |= cbor_encoder_close_container(&rsp, &arr);
+    g_err |= cbor_encode_text_stringz(&rsp, "bytes");
+    g_err |= cbor_encode_uint(&rsp, oma.oma_bytes);
+    g_err |= cbor_encode_text_stringz(&rsp, "need");
+    g_err |= cbor_encode_uint(&rsp, oma.oma_need_bytes);
+
+    g_err |= cbor_encode_text_stringz(&rsp, "mpools");
+    g_err |= cbor_encoder_create_map(&rsp, &arr, CborIndefiniteLength);
+    prev_mp = NULL;
+    while (1) {
+        prev_mp = os_mempool_info_get_next(prev_mp, &omi);
+        if (prev_mp == NULL) {
+            break;
+        }
+
+        g_err |= cbor_encode_text_stringz(&arr, omi.omi_name);
+        g_err |= cbor_encoder_create_map(&arr, &ent, CborIndefiniteLength);
+        g_err |= cbor_encode_text_stringz(&ent, "nblks");
+        g_err |= cbor_encode_uint(&ent, omi.omi_num_blocks);
+        g_err |= cbor_encode_text_stringz(&ent, "advice");
+        g_err |= cbor_encode_uint(&ent, os_mempool_advise(prev_mp));
+        g_err |= cbor_encoder_close_container(&arr, &ent);
+    }
+    g_err |= cbor_encoder_close_container(&rsp, &arr);
+    g_err |= cbor_encoder_close_container(&cb->encoder, &rsp);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return 0;
+}
+
+/*
+ * Clears the msys demand counters; e.g. after changing the pool layout.
+ */
+static int
+nmgr_def_msys_advice_clear(struct mgmt_cbuf *cb)
+{
+    os_msys_demand_clear();
+    mgmt_cbuf_setoerr(cb, 0);
+    return 0;
+}
+#endif
+
 static int
 nmgr_datetime_get(struct mgmt_cbuf *cb)
 {
@@ -98,6 +98,7 @@ nmgr_send_err_rsp(struct nmgr_transport *nt, struct os_mbuf *m,
 {
     hdr = nmgr_init_rsp(m, hdr);
     if (!hdr) {
+        os_mbuf_free_chain(m);
         return;
     }
 
@@ -110,179 +111,145 @@ nmgr_send_err_rsp(struct nmgr_transport *nt, struct os_mbuf *m,
     nt->nt_output(nt, nmgr_task_cbuf.n_out_m);
 }
 
+/*
+ * Sends a response in MTU sized fragments.  Fragments are split off the
+ * response chain instead of being copied out of it.  The response is
+ * consumed.
+ */
 static int
-nmgr_send_rspfrag(struct nmgr_transport *nt, struct os_mbuf *rsp,
-                  struct os_mbuf *req, uint16_t len)
+nmgr_rsp_fragment(struct nmgr_transport *nt, struct os_mbuf *rsp,
+                  struct os_mbuf *req)
 {
-    struct os_mbuf *rspfrag;
-    int rc;
-
-    rspfrag = NULL;
-
-    rspfrag = os_msys_get_pkthdr(len, OS_MBUF_USRHDR_LEN(req));
-    if (!rspfrag) {
-        rc = MGMT_ERR_ENOMEM;
-        goto err;
-    }
+    struct os_mbuf *rest;
+    uint16_t mtu;
 
-    /* Copy the request packet header into the response. */
-    memcpy(OS_MBUF_USRHDR(rspfrag), OS_MBUF_USRHDR(req),
-           OS_MBUF_USRHDR_LEN(req));
+    mtu = nt->nt_get_mtu(req);
 
-    if (os_mbuf_appendfrom(rspfrag, rsp, 0, len)) {
-        rc = MGMT_ERR_ENOMEM;
-        goto err;
+    while (OS_MBUF_PKTLEN(rsp) > mtu) {
+        rest = os_mbuf_split(rsp, mtu);
+        if (!rest) {
+            os_mbuf_free_chain(rsp);
+            return MGMT_ERR_ENOMEM;
+        }
+        nt->nt_output(nt, rsp);
+        rsp = rest;
     }
-
-    nt->nt_output(nt, rspfrag);
+    nt->nt_output(nt, rsp);
 
     return MGMT_ERR_EOK;
-err:
-    if (rspfrag) {
-        os_mbuf_free_chain(rspfrag);
-    }
-    return rc;
 }
 
-static int
-nmgr_rsp_fragment(struct nmgr_transport *nt, struct nmgr_hdr *rsp_hdr,
-                  struct os_mbuf *rsp, struct os_mbuf *req)
+/*
+ * Processes one request out of a packet, starting at offset "off".
+ */
+static void
+nmgr_handle_one(struct nmgr_transport *nt, struct os_mbuf *req, int off,
+                struct nmgr_hdr *hdr)
 {
-    uint16_t mtu;
-    uint16_t rsplen;
-    uint16_t len ;
+    const struct mgmt_handler *handler;
+    struct nmgr_hdr *rsp_hdr;
+    struct os_mbuf *rsp;
     int rc;
 
-    len = 0;
+    rsp = os_msys_get_pkthdr(512, OS_MBUF_USRHDR_LEN(req));
+    if (!rsp) {
+        return;
+    }
 
-    mtu = nt->nt_get_mtu(req);
+    /* Copy the request packet header into the response. */
+    memcpy(OS_MBUF_USRHDR(rsp), OS_MBUF_USRHDR(req), OS_MBUF_USRHDR_LEN(req));
+
+    handler = mgmt_find_handler(ntohs(hdr->nh_group), hdr->nh_id);
+    if (!handler) {
+        rc = MGMT_ERR_ENOENT;
+        goto err;
+    }
 
-    do {
-        len = OS_MBUF_PKTLEN(rsp);
-        if (len >= mtu) {
-            rsplen = mtu;
+    /* Build response header apriori.  Then pass to the handlers
+     * to fill out the response data, and adjust length & flags.
+     */
+    rsp_hdr = nmgr_init_rsp(rsp, hdr);
+    if (!rsp_hdr) {
+        os_mbuf_free_chain(rsp);
+        return;
+    }
+
+    cbor_mbuf_reader_init(&nmgr_task_cbuf.reader, req, off + sizeof(*hdr));
+    cbor_parser_init(&nmgr_task_cbuf.reader.r, 0,
+                     &nmgr_task_cbuf.n_b.parser, &nmgr_task_cbuf.n_b.it);
+
+    if (hdr->nh_op == NMGR_OP_READ) {
+        if (handler->mh_read) {
+            rc = handler->mh_read(&nmgr_task_cbuf.n_b);
         } else {
-            rsplen = len;
+            rc = MGMT_ERR_ENOENT;
         }
-
-        rc = nmgr_send_rspfrag(nt, rsp, req, rsplen);
-        if (rc) {
-            goto err;
+    } else if (hdr->nh_op == NMGR_OP_WRITE) {
+        if (handler->mh_write) {
+            rc = handler->mh_write(&nmgr_task_cbuf.n_b);
+        } else {
+            rc = MGMT_ERR_ENOENT;
         }
+    } else {
+        rc = MGMT_ERR_EINVAL;
+    }
 
-        os_mbuf_adj(rsp, rsplen);
+    if (rc != 0) {
+        goto err;
+    }
 
-    } while (OS_MBUF_PKTLEN(rsp));
+    rsp_hdr->nh_len +=
+        cbor_encode_bytes_written(&nmgr_task_cbuf.n_b.encoder);
+    rsp_hdr->nh_len = htons(rsp_hdr->nh_len);
+
+    nmgr_rsp_fragment(nt, rsp, req);
+    return;
 
-    return MGMT_ERR_EOK;
 err:
-    return rc;
+    /* Drop whatever the handler encoded before failing. */
+    if (SLIST_NEXT(rsp, om_next)) {
+        os_mbuf_free_chain(SLIST_NEXT(rsp, om_next));
+        SLIST_NEXT(rsp, om_next) = NULL;
+    }
+    OS_MBUF_PKTHDR(rsp)->omp_len = rsp->om_len = 0;
+    nmgr_send_err_rsp(nt, rsp, hdr, rc);
 }
 
+/*
+ * A packet can hold several requests back to back.  Each is answered on
+ * its own, in order, with the sequence number of the request; a failure
+ * only affects the request that caused it.
+ */
 static void
 nmgr_handle_req(struct nmgr_transport *nt, struct os_mbuf *req)
 {
-    struct os_mbuf *rsp;
-    const struct mgmt_handler *handler;
-    struct nmgr_hdr *rsp_hdr;
     struct nmgr_hdr hdr;
     int off;
     uint16_t len;
     int rc;
 
-    rsp_hdr = NULL;
-
-    rsp = os_msys_get_pkthdr(512, OS_MBUF_USRHDR_LEN(req));
-    if (!rsp) {
-        rc = os_mbuf_copydata(req, 0, sizeof(hdr), &hdr);
-        if (rc < 0) {
-            goto err_norsp;
-        }
-        rsp = req;
-        req = NULL;
-        goto err;
-    }
-
-    /* Copy the request packet header into the response. */
-    memcpy(OS_MBUF_USRHDR(rsp), OS_MBUF_USRHDR(req), OS_MBUF_USRHDR_LEN(req));
-
     off = 0;
     len = OS_MBUF_PKTHDR(req)->omp_len;
 
-    while (off < len) {
+    while (off + sizeof(hdr) <= len) {
         rc = os_mbuf_copydata(req, off, sizeof(hdr), &hdr);
         if (rc < 0) {
-            rc = MGMT_ERR_EINVAL;
-            goto err_norsp;
+            break;
         }
 
         hdr.nh_len = ntohs(hdr.nh_len);
-
-        handler = mgmt_find_handler(ntohs(hdr.nh_group), hdr.nh_id);
-        if (!handler) {
-            rc = MGMT_ERR_ENOENT;
-            goto err;
-        }
-
-        /* Build response header apriori.  Then pass to the handlers
-         * to fill out the response data, and adjust length & flags.
-         */
-        rsp_hdr = nmgr_init_rsp(rsp, &hdr);
-        if (!rsp_hdr) {
-            rc = MGMT_ERR_ENOMEM;
-            goto err_norsp;
-        }
-
-        cbor_mbuf_reader_init(&nmgr_task_cbuf.reader, req, sizeof(hdr));
-        cbor_parser_init(&nmgr_task_cbuf.reader.r, 0,
-                         &nmgr_task_cbuf.n_b.parser, &nmgr_task_cbuf.n_b.it);
-
-        if (hdr.nh_op == NMGR_OP_READ) {
-            if (handler->mh_read) {
-                rc = handler->mh_read(&nmgr_task_cbuf.n_b);
-            } else {
-                rc = MGMT_ERR_ENOENT;
-            }
-        } else if (hdr.nh_op == NMGR_OP_WRITE) {
-            if (handler->mh_write) {
-                rc = handler->mh_write(&nmgr_task_cbuf.n_b);
-            } else {
-                rc = MGMT_ERR_ENOENT;
-            }
-        } else {
-            rc = MGMT_ERR_EINVAL;
-        }
-
-        if (rc != 0) {
-            goto err;
+        if (off + sizeof(hdr) + hdr.nh_len > len) {
+            break;
         }
 
-        rsp_hdr->nh_len +=
-            cbor_encode_bytes_written(&nmgr_task_cbuf.n_b.encoder);
-        off += sizeof(hdr) + OS_ALIGN(hdr.nh_len, 4);
+        nmgr_handle_one(nt, req, off, &hdr);
 
-        rsp_hdr->nh_len = htons(rsp_hdr->nh_len);
-        rc = nmgr_rsp_fragment(nt, rsp_hdr, rsp, req);
-        if (rc) {
-            goto err;
-        }
+        off += sizeof(hdr) + hdr.nh_len;
     }
 
-    os_mbuf_free_chain(rsp);
     os_mbuf_free_chain(req);
-    return;
-err:
-    OS_MBUF_PKTHDR(rsp)->omp_len = rsp->om_len = 0;
-    nmgr_send_err_rsp(nt, rsp, &hdr, rc);
-    os_mbuf_free_chain(req);
-    return;
-err_norsp:
-    os_mbuf_free_chain(rsp);
-    os_mbuf_free_chain(req);
-    return;
 }
 
-
 static void
 nmgr_process(struct nmgr_transport *nt)
 {
@@ -0,0 +1,261 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "syscfg/syscfg.h"
+
+#include <lwip/opt.h>
+#include <lwip/init.h>
+#include <lwip/apps/fs.h>
+
+#if LWIP_HTTPD_FS
+
+/*
+ * lwipopts.h renames the httpd's file API out of the way of fs/fs; from here
+ * on, fs_* is fs/fs and the httpd's file is struct httpd_fs_file.
+ */
+#undef fs_open
+#undef fs_close
+#undef fs_read
+#undef fs_file
+
+#include <fs/fs.h>
+
+#define HTTPD_FS_PATH_MAX       64
+#define HTTPD_FS_HDR_MAX        256
+
+/*
+ * An open file.  The response header is generated when the file is opened,
+ * and handed to the httpd ahead of the file data, as if it was part of the
+ * file.  The data itself is read from the file system straight into the
+ * httpd's send buffer, which the httpd sizes to the TCP send window.
+ */
+struct httpd_fs_ent {
+    struct fs_file *hfe_file;
+    uint16_t hfe_hdr_len;
+    char hfe_hdr[HTTPD_FS_HDR_MAX];
+};
+
+static struct httpd_fs_ent httpd_fs_ents[MYNEWT_VAL(HTTPD_FS_MAX_OPEN)];
+
+static const struct {
+    const char *ext;
+    const char *type;
+} httpd_fs_types[] = {
+    { "html", "text/html" },
+    { "htm", "text/html" },
+    { "css", "text/css" },
+    { "js", "application/javascript" },
+    { "json", "application/json" },
+    { "txt", "text/plain" },
+    { "log", "text/plain" },
+    { "svg", "image/svg+xml" },
+    { "png", "image/png" },
+    { "jpg", "image/jpeg" },
+    { "gif", "image/gif" },
+    { "ico", "image/x-icon" },
+};
+
+static const char *
+httpd_fs_type(const char *path)
+{
+    const char *ext;
+    int i;
+
+    ext = strrchr(path, '.');
+    if (ext != NULL && strchr(ext, '/') == NULL) {
+        ext++;
+        for (i = 0; i < sizeof(httpd_fs_types) / sizeof(httpd_fs_types[0]);
+             i++) {
+            if (!strcmp(ext, httpd_fs_types[i].ext)) {
+                return httpd_fs_types[i].type;
+            }
+        }
+    }
+    return "application/octet-stream";
+}
+
+static struct httpd_fs_ent *
+httpd_fs_ent_alloc(void)
+{
+    int i;
+
+    /* Only ever called from the tcpip thread. */
+    for (i = 0; i < MYNEWT_VAL(HTTPD_FS_MAX_OPEN); i++) {
+        if (httpd_fs_ents[i].hfe_file == NULL) {
+            return &httpd_fs_ents[i];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Maps a request URI to a path under HTTPD_FS_ROOT.
+ *
+ * @return 0 on success; -1 if the URI is too long, or tries to leave the
+ *         root.
+ */
+static int
+httpd_fs_path(const char *name, char *path)
+{
+    const char *index;
+    int len;
+
+    if (name[0] != '/' || strstr(name, "..") != NULL) {
+        return -1;
+    }
+    index = name[strlen(name) - 1] == '/' ? MYNEWT_VAL(HTTPD_FS_INDEX) : "";
+    len = snprintf(path, HTTPD_FS_PATH_MAX, "%s%s%s",
+                   MYNEWT_VAL(HTTPD_FS_ROOT), name, index);
+    if (len >= HTTPD_FS_PATH_MAX) {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Called by the httpd for every request before it looks in the compiled in
+ * fsdata.
+ *
+ * @return 1 if the file was opened; 0 if the httpd should look for it in
+ *         fsdata.
+ */
+int
+fs_open_custom(struct httpd_fs_file *file, const char *name)
+{
+    char path[HTTPD_FS_PATH_MAX];
+    struct httpd_fs_ent *hfe;
+    uint32_t len;
+    uint32_t ver;
+    int off;
+    int rc;
+
+    if (httpd_fs_path(name, path)) {
+        return 0;
+    }
+    hfe = httpd_fs_ent_alloc();
+    if (hfe == NULL) {
+        return 0;
+    }
+    rc = fs_open(path, FS_ACCESS_READ, &hfe->hfe_file);
+    if (rc) {
+        hfe->hfe_file = NULL;
+        return 0;
+    }
+    rc = fs_filelen(hfe->hfe_file, &len);
+    if (rc) {
+        goto err;
+    }
+
+    off = snprintf(hfe->hfe_hdr, sizeof(hfe->hfe_hdr),
+                   "HTTP/1.1 200 OK\r\n"
+                   "Server: " HTTPD_SERVER_AGENT "\r\n"
+                   "Content-Type: %s\r\n"
+                   "Content-Length: %lu\r\n",
+                   httpd_fs_type(path), (unsigned long)len);
+    if (fs_version(hfe->hfe_file, &ver) == 0) {
+        /*
+         * The version changes whenever the file is rewritten; the length
+         * tells apart files that were recreated from scratch.
+         */
+        off += snprintf(hfe->hfe_hdr + off, sizeof(hfe->hfe_hdr) - off,
+                        "ETag: \"%08lx-%lx\"\r\n",
+                        (unsigned long)ver, (unsigned long)len);
+    }
+    off += snprintf(hfe->hfe_hdr + off, sizeof(hfe->hfe_hdr) - off,
+                    "Cache-Control: max-age=%d\r\n\r\n",
+                    MYNEWT_VAL(HTTPD_FS_MAX_AGE));
+    if (off >= sizeof(hfe->hfe_hdr)) {
+        goto err;
+    }
+    hfe->hfe_hdr_len = off;
+
+    file->data = NULL;
+    file->len = hfe->hfe_hdr_len + len;
+    file->index = 0;
+    file->pextension = hfe;
+    file->flags = FS_FILE_FLAGS_HEADER_INCLUDED |
+                  FS_FILE_FLAGS_HEADER_PERSISTENT;
+    return 1;
+
+err:
+    fs_close(hfe->hfe_file);
+    hfe->hfe_file = NULL;
+    return 0;
+}
+
+void
+fs_close_custom(struct httpd_fs_file *file)
+{
+    struct httpd_fs_ent *hfe;
+
+    hfe = file->pextension;
+    if (hfe != NULL) {
+        fs_close(hfe->hfe_file);
+        hfe->hfe_file = NULL;
+        file->pextension = NULL;
+    }
+}
+
+/*
+ * Fills the httpd's send buffer: header first, then file data read directly
+ * into the buffer.  The httpd limits count to what the connection can take.
+ */
+int
+fs_read_custom(struct httpd_fs_file *file, char *buffer, int count)
+{
+    struct httpd_fs_ent *hfe;
+    uint32_t got;
+    int cnt;
+    int rc;
+
+    hfe = file->pextension;
+    if (file->index >= file->len) {
+        return FS_READ_EOF;
+    }
+    if (count > file->len - file->index) {
+        count = file->len - file->index;
+    }
+
+    cnt = 0;
+    if (file->index < hfe->hfe_hdr_len) {
+        cnt = hfe->hfe_hdr_len - file->index;
+        if (cnt > count) {
+            cnt = count;
+        }
+        memcpy(buffer, hfe->hfe_hdr + file->index, cnt);
+    }
+    if (cnt < count) {
+        rc = fs_read(hfe->hfe_file, count - cnt, buffer + cnt, &got);
+        if (rc) {
+            return FS_READ_EOF;
+        }
+        cnt += got;
+    }
+    if (cnt == 0) {
+        /* File was truncated while being served. */
+        return FS_READ_EOF;
+    }
+    file->index += cnt;
+
+    return cnt;
+}
+
+#endif
@@ -113,7 +113,14 @@ sys_now(void)
 static inline err_t
 sys_mbox_new(sys_mbox_t *mbox, int size)
 {
-    if (os_queue_init(mbox, sizeof(void *), size)) {
+    int rc;
+
+#if LWIP_MBOX_SPSC
+    rc = os_queue_init_spsc(mbox, sizeof(void *), size);
+#else
+    rc = os_queue_init(mbox, sizeof(void *), size);
+#endif
+    if (rc) {
         return ERR_MEM;
     }
     return ERR_OK;
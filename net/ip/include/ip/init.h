@@ -19,12 +19,27 @@
 #ifndef __IP_INIT_H__
 #define __IP_INIT_H__
 
+#include <inttypes.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 int ip_init(void);
 
+/*
+ * Memory lwIP holds when built with LWIP_MSYS_MEM.  Blocks are counted in
+ * os_msys the same way as any other mbuf user's; these tell lwIP's share.
+ */
+struct ip_msys_stats {
+    uint16_t ims_blocks;        /* msys blocks in use */
+    uint16_t ims_blocks_peak;   /* most msys blocks in use at once */
+    uint16_t ims_heap;          /* heap blocks in use, too large for msys */
+    uint16_t ims_fails;         /* allocations refused, msys exhausted */
+};
+
+void ip_msys_stats(struct ip_msys_stats *stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,18 +24,26 @@ extern "C" {
 #endif
 
 struct os_queue {
-    uint8_t oq_head;
-    uint8_t oq_tail;
+    volatile uint8_t oq_head;
+    volatile uint8_t oq_tail;
     uint8_t oq_size;
     uint8_t oq_elem_size;
+    uint8_t oq_flags;
     struct os_sem oq_items;
     struct os_sem oq_space;
     void *oq_q;
 };
 
+/* Single producer, single consumer queue; see os_queue_init_spsc(). */
+#define OS_QUEUE_F_SPSC         0x01
+
 int os_queue_init(struct os_queue *, uint8_t elem_size, uint8_t elem_cnt);
+int os_queue_init_spsc(struct os_queue *, uint8_t elem_size,
+                       uint8_t elem_cnt);
 int os_queue_put(struct os_queue *, void *elem, uint32_t timeout);
 int os_queue_get(struct os_queue *, void *elem, uint32_t timeout);
+int os_queue_get_batch(struct os_queue *, void *elems, int max, int *cnt,
+                       uint32_t timeout);
 
 #ifdef __cplusplus
 }
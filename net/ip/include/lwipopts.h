@@ -31,6 +31,13 @@ extern "C" {
 #define TCPIP_THREAD_STACKSIZE	((6 * 1024) / sizeof(portSTACK_TYPE))
 #define TCPIP_MBOX_SIZE			10
 
+/* LWIP_MBOX_SPSC: use lock-free single producer queues for mailboxes.  Only
+   valid if a single task or interrupt ever posts to the tcpip thread, e.g.
+   one network interface and no tcpip_callback() users elsewhere. */
+#ifndef LWIP_MBOX_SPSC
+#define LWIP_MBOX_SPSC                  0
+#endif
+
 #define MEMP_NUM_ARP_QUEUE		4
 #define MEMP_NUM_RAW_PCB		1
 #define LWIP_SO_RCVTIMEO                1
@@ -57,6 +64,9 @@ extern "C" {
 
 #define LWIP_NETIF_API                  0
 
+/* Lets drivers with checksum offload turn off lwIP's own. */
+#define LWIP_CHECKSUM_CTRL_PER_NETIF    1
+
 #define SYS_LIGHTWEIGHT_PROT            1
 
 #define TCP_LISTEN_BACKLOG     	        (1)
@@ -67,6 +77,28 @@ extern "C" {
    byte alignment -> define MEM_ALIGNMENT to 2. */
 #define MEM_ALIGNMENT                   4
 
+/* LWIP_MSYS_MEM: take lwIP's memory, pools and pbufs included, out of the
+   os_msys mbuf pools instead of reserving separate RAM for it.  lwIP and
+   the other os_msys users then draw from the same packet budget.
+   Allocations too large for any msys block come from the heap; see
+   ip_msys_stats(). */
+#ifndef LWIP_MSYS_MEM
+#define LWIP_MSYS_MEM                   0
+#endif
+
+#if LWIP_MSYS_MEM
+#include <stddef.h>
+
+void *lwip_msys_malloc(size_t size);
+void *lwip_msys_calloc(size_t count, size_t size);
+void lwip_msys_free(void *ptr);
+
+#define MEMP_MEM_MALLOC                 1
+#define mem_clib_malloc                 lwip_msys_malloc
+#define mem_clib_calloc                 lwip_msys_calloc
+#define mem_clib_free                   lwip_msys_free
+#endif
+
 /* MEMP_NUM_PBUF: the number of memp struct pbufs. If the application
    sends a lot of data out of ROM (or other static memory), this
    should be set high. */
@@ -111,6 +143,14 @@ extern "C" {
    link level header. */
 #define PBUF_LINK_HLEN                  16
 
+/* LWIP_SOCK_RX_PBUF_REFS: the number of received pbuf segments sockets
+   may hold on to instead of copying them to mbufs.  These are not available
+   to lwIP until the application frees the data, so keep this below
+   PBUF_POOL_SIZE. */
+#ifndef LWIP_SOCK_RX_PBUF_REFS
+#define LWIP_SOCK_RX_PBUF_REFS          (PBUF_POOL_SIZE - 1)
+#endif
+
 /* ---------- TCP options ---------- */
 #define LWIP_TCP                        1
 #define TCP_TTL                         255
@@ -173,6 +213,24 @@ extern "C" {
 
 #define LWIP_SOCKET                     0
 
+/* ---------- HTTPD options ---------- */
+/* LWIP_HTTPD_FS: serve httpd files out of fs/fs, falling back to the
+   compiled in fsdata.  Requires the net/ip/httpd_fs package. */
+#ifndef LWIP_HTTPD_FS
+#define LWIP_HTTPD_FS                   0
+#endif
+
+#if LWIP_HTTPD_FS
+#define LWIP_HTTPD_CUSTOM_FILES         1
+#define LWIP_HTTPD_DYNAMIC_FILE_READ    1
+
+/* The httpd's file API uses the same names as fs/fs. */
+#define fs_open                         httpd_fs_open
+#define fs_close                        httpd_fs_close
+#define fs_read                         httpd_fs_read
+#define fs_file                         httpd_fs_file
+#endif
+
 /* ---------- Statistics options ---------- */
 /* XXX hook into sys/stats */
 #define STATS                           0
@@ -20,6 +20,8 @@
 #define __SYS_MN_SOCKET_H_
 
 #include <inttypes.h>
+#include <os/queue.h>
+#include <os/os_eventq.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -182,6 +184,68 @@ int mn_close(struct mn_socket *);
         (sock)->ms_cb_arg = (cb_arg);                                   \
     } while (0)
 
+/*
+ * Batched send/receive.
+ *
+ * mn_sendmmsg() sends messages in order until one fails. Messages which were
+ * sent are consumed by the socket; the rest stay owned by the caller.
+ * mn_recvmmsg() takes whatever is queued on the socket, up to cnt messages.
+ * mm_addr can be NULL if the address is not wanted.
+ *
+ * The number of messages handled is returned in *done. Return code is 0 if
+ * at least one message was handled, otherwise the error of the first call.
+ */
+struct mn_mmsg {
+    struct os_mbuf *mm_data;
+    struct mn_sockaddr *mm_addr;
+};
+
+int mn_sendmmsg(struct mn_socket *, struct mn_mmsg *, int cnt, int *done);
+int mn_recvmmsg(struct mn_socket *, struct mn_mmsg *, int cnt, int *done);
+
+/*
+ * Poll set. Sockets added to a poll set report readiness through a single
+ * event posted to the poll set's eventq, no matter how many of them become
+ * readable/writable in the meantime. When the event runs, the owner calls
+ * mn_pollset_next() to get sockets which are ready, and should drain each
+ * one of them; readiness is reported again only when new data arrives.
+ *
+ * Adding a socket replaces its callbacks. Socket must be removed from the
+ * poll set before it is closed.
+ */
+#define MN_POLL_READ       0x01
+#define MN_POLL_WRITE      0x02
+
+struct mn_pollset;
+
+struct mn_poll_entry {
+    struct mn_socket *mpe_sock;
+    void *mpe_arg;                              /* filled in by user */
+    struct mn_pollset *mpe_set;
+    STAILQ_ENTRY(mn_poll_entry) mpe_next;
+    int mpe_err;                                /* last error reported */
+    uint8_t mpe_events;                         /* MN_POLL_XXX pending */
+    uint8_t mpe_queued;
+};
+
+struct mn_pollset {
+    struct os_event mps_ev;
+    struct os_eventq *mps_evq;
+    STAILQ_HEAD(, mn_poll_entry) mps_ready;
+};
+
+void mn_pollset_init(struct mn_pollset *, struct os_eventq *evq,
+  os_event_fn *cb, void *arg);
+void mn_pollset_add(struct mn_pollset *, struct mn_poll_entry *,
+  struct mn_socket *, void *arg);
+void mn_pollset_remove(struct mn_pollset *, struct mn_poll_entry *);
+
+/*
+ * Returns next socket which is ready, or NULL if none are. Pending events
+ * are returned in *events, and cleared.
+ */
+struct mn_poll_entry *mn_pollset_next(struct mn_pollset *, uint8_t *events);
+
 /*
  * Address conversion
  */
@@ -95,6 +95,49 @@ mn_sendto(struct mn_socket *s, struct os_mbuf *m, struct mn_sockaddr *to)
     return s->ms_ops->mso_sendto(s, m, to);
 }
 
+int
+mn_sendmmsg(struct mn_socket *s, struct mn_mmsg *msgs, int cnt, int *done)
+{
+    int rc = 0;
+    int i;
+
+    for (i = 0; i < cnt; i++) {
+        rc = s->ms_ops->mso_sendto(s, msgs[i].mm_data, msgs[i].mm_addr);
+        if (rc) {
+            break;
+        }
+        msgs[i].mm_data = NULL;
+    }
+    *done = i;
+    if (i > 0) {
+        return 0;
+    }
+    return rc;
+}
+
+int
+mn_recvmmsg(struct mn_socket *s, struct mn_mmsg *msgs, int cnt, int *done)
+{
+    int rc = 0;
+    int i;
+
+    for (i = 0; i < cnt; i++) {
+        msgs[i].mm_data = NULL;
+        rc = s->ms_ops->mso_recvfrom(s, &msgs[i].mm_data, msgs[i].mm_addr);
+        if (rc || !msgs[i].mm_data) {
+            break;
+        }
+    }
+    *done = i;
+    if (i > 0) {
+        return 0;
+    }
+    if (!rc) {
+        rc = MN_EAGAIN;
+    }
+    return rc;
+}
+
 int
 mn_getsockopt(struct mn_socket *s, uint8_t level, uint8_t name, void *val)
 {
@@ -0,0 +1,131 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+
+#include <os/os.h>
+
+#include "mn_socket/mn_socket.h"
+
+static void mn_pollset_readable(void *cb_arg, int err);
+static void mn_pollset_writable(void *cb_arg, int err);
+
+static const union mn_socket_cb mn_pollset_cbs = {
+    .socket.readable = mn_pollset_readable,
+    .socket.writable = mn_pollset_writable
+};
+
+/*
+ * Called from socket provider context.
+ */
+static void
+mn_pollset_mark(struct mn_poll_entry *pe, uint8_t events, int err)
+{
+    struct mn_pollset *ps;
+    int sr;
+
+    OS_ENTER_CRITICAL(sr);
+    ps = pe->mpe_set;
+    if (!ps) {
+        OS_EXIT_CRITICAL(sr);
+        return;
+    }
+    pe->mpe_events |= events;
+    if (err) {
+        pe->mpe_err = err;
+    }
+    if (!pe->mpe_queued) {
+        pe->mpe_queued = 1;
+        STAILQ_INSERT_TAIL(&ps->mps_ready, pe, mpe_next);
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    os_eventq_put(ps->mps_evq, &ps->mps_ev);
+}
+
+static void
+mn_pollset_readable(void *cb_arg, int err)
+{
+    mn_pollset_mark(cb_arg, MN_POLL_READ, err);
+}
+
+static void
+mn_pollset_writable(void *cb_arg, int err)
+{
+    mn_pollset_mark(cb_arg, MN_POLL_WRITE, err);
+}
+
+void
+mn_pollset_init(struct mn_pollset *ps, struct os_eventq *evq, os_event_fn *cb,
+  void *arg)
+{
+    memset(ps, 0, sizeof(*ps));
+    ps->mps_evq = evq;
+    ps->mps_ev.ev_cb = cb;
+    ps->mps_ev.ev_arg = arg;
+    STAILQ_INIT(&ps->mps_ready);
+}
+
+void
+mn_pollset_add(struct mn_pollset *ps, struct mn_poll_entry *pe,
+  struct mn_socket *sock, void *arg)
+{
+    memset(pe, 0, sizeof(*pe));
+    pe->mpe_sock = sock;
+    pe->mpe_arg = arg;
+    pe->mpe_set = ps;
+    mn_socket_set_cbs(sock, pe, &mn_pollset_cbs);
+}
+
+void
+mn_pollset_remove(struct mn_pollset *ps, struct mn_poll_entry *pe)
+{
+    int sr;
+
+    OS_ENTER_CRITICAL(sr);
+    if (pe->mpe_queued) {
+        STAILQ_REMOVE(&ps->mps_ready, pe, mn_poll_entry, mpe_next);
+        pe->mpe_queued = 0;
+    }
+    pe->mpe_set = NULL;
+    pe->mpe_events = 0;
+    OS_EXIT_CRITICAL(sr);
+
+    mn_socket_set_cbs(pe->mpe_sock, NULL, NULL);
+}
+
+struct mn_poll_entry *
+mn_pollset_next(struct mn_pollset *ps, uint8_t *events)
+{
+    struct mn_poll_entry *pe;
+    int sr;
+
+    OS_ENTER_CRITICAL(sr);
+    pe = STAILQ_FIRST(&ps->mps_ready);
+    if (pe) {
+        STAILQ_REMOVE_HEAD(&ps->mps_ready, mpe_next);
+        pe->mpe_queued = 0;
+        *events = pe->mpe_events;
+        pe->mpe_events = 0;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return pe;
+}
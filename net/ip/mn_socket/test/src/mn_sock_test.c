@@ -42,6 +42,7 @@ static struct os_mbuf_pool test_mbuf_pool;
 TEST_CASE_DECL(inet_pton_test)
 TEST_CASE_DECL(inet_ntop_test)
 TEST_CASE_DECL(socket_tests)
+TEST_CASE_DECL(os_queue_spsc_test)
 
 TEST_SUITE(mn_socket_test_all)
 {
@@ -59,6 +60,7 @@ TEST_SUITE(mn_socket_test_all)
     inet_pton_test();
     inet_ntop_test();
     socket_tests();
+    os_queue_spsc_test();
 }
 
 void
@@ -265,6 +265,130 @@ sock_udp_data(void)
     mn_close(sock2);
 }
 
+static void
+sub_poll_ev(struct os_event *ev)
+{
+    int *i;
+
+    i = (int *)ev->ev_arg;
+    *i = *i + 1;
+}
+
+void
+sock_udp_batch(void)
+{
+    struct mn_socket *sock1;
+    struct mn_socket *sock2;
+    struct mn_sockaddr_in msin;
+    struct mn_sockaddr_in msin2;
+    struct mn_sockaddr_in from[3];
+    struct mn_mmsg msgs[3];
+    struct mn_pollset ps;
+    struct mn_poll_entry pe1;
+    struct mn_poll_entry pe2;
+    struct mn_poll_entry *pe;
+    struct os_eventq evq;
+    struct os_eventq *evqp = &evq;
+    struct os_event *ev;
+    uint8_t events;
+    int wakeups = 0;
+    char data[] = "1234567890";
+    int received;
+    int cnt;
+    int rc;
+    int i;
+
+    os_eventq_init(&evq);
+    mn_pollset_init(&ps, &evq, sub_poll_ev, &wakeups);
+
+    rc = mn_socket(&sock1, MN_PF_INET, MN_SOCK_DGRAM, 0);
+    TEST_ASSERT(rc == 0);
+    mn_pollset_add(&ps, &pe1, sock1, &pe1);
+
+    rc = mn_socket(&sock2, MN_PF_INET, MN_SOCK_DGRAM, 0);
+    TEST_ASSERT(rc == 0);
+    mn_pollset_add(&ps, &pe2, sock2, &pe2);
+
+    msin.msin_family = MN_PF_INET;
+    msin.msin_len = sizeof(msin);
+    msin.msin_port = htons(12446);
+
+    mn_inet_pton(MN_PF_INET, "127.0.0.1", &msin.msin_addr);
+
+    rc = mn_bind(sock1, (struct mn_sockaddr *)&msin);
+    TEST_ASSERT(rc == 0);
+
+    msin2.msin_family = MN_PF_INET;
+    msin2.msin_len = sizeof(msin2);
+    msin2.msin_port = 0;
+    msin2.msin_addr.s_addr = 0;
+    rc = mn_bind(sock2, (struct mn_sockaddr *)&msin2);
+    TEST_ASSERT(rc == 0);
+
+    /*
+     * Nothing queued yet.
+     */
+    msgs[0].mm_addr = NULL;
+    rc = mn_recvmmsg(sock1, msgs, 1, &cnt);
+    TEST_ASSERT(rc != 0);
+    TEST_ASSERT(cnt == 0);
+    TEST_ASSERT(mn_pollset_next(&ps, &events) == NULL);
+
+    for (i = 0; i < 3; i++) {
+        msgs[i].mm_data = os_msys_get_pkthdr(sizeof(data), 0);
+        TEST_ASSERT(msgs[i].mm_data);
+        data[0] = '0' + i;
+        rc = os_mbuf_copyinto(msgs[i].mm_data, 0, data, sizeof(data));
+        TEST_ASSERT(rc == 0);
+        msgs[i].mm_addr = (struct mn_sockaddr *)&msin;
+    }
+    rc = mn_sendmmsg(sock2, msgs, 3, &cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cnt == 3);
+
+    /*
+     * Collect the datagrams. They might not all be there on the first
+     * wakeup.
+     */
+    received = 0;
+    while (received < 3) {
+        ev = os_eventq_poll(&evqp, 1, OS_TICKS_PER_SEC);
+        TEST_ASSERT_FATAL(ev == &ps.mps_ev);
+        ev->ev_cb(ev);
+
+        while ((pe = mn_pollset_next(&ps, &events)) != NULL) {
+            TEST_ASSERT(pe == &pe1);
+            TEST_ASSERT(pe->mpe_arg == &pe1);
+            TEST_ASSERT(events & MN_POLL_READ);
+
+            for (i = 0; i < 3; i++) {
+                msgs[i].mm_addr = (struct mn_sockaddr *)&from[i];
+            }
+            rc = mn_recvmmsg(pe->mpe_sock, msgs, 3 - received, &cnt);
+            if (rc) {
+                continue;
+            }
+            for (i = 0; i < cnt; i++) {
+                TEST_ASSERT(from[i].msin_family == MN_AF_INET);
+                TEST_ASSERT(from[i].msin_port != 0);
+                TEST_ASSERT(OS_MBUF_PKTLEN(msgs[i].mm_data) == sizeof(data));
+                data[0] = '0' + received + i;
+                TEST_ASSERT(os_mbuf_cmpf(msgs[i].mm_data, 0, data,
+                                         sizeof(data)) == 0);
+                os_mbuf_free_chain(msgs[i].mm_data);
+            }
+            received += cnt;
+        }
+    }
+    TEST_ASSERT(received == 3);
+    TEST_ASSERT(wakeups > 0 && wakeups <= 3);
+
+    mn_pollset_remove(&ps, &pe1);
+    mn_pollset_remove(&ps, &pe2);
+    mn_close(sock1);
+    mn_close(sock2);
+}
+
 void
 std_writable(void *cb_arg, int err)
 {
@@ -765,6 +889,7 @@ mn_socket_test_handler(void *arg)
     sock_listen();
     sock_tcp_connect();
     sock_udp_data();
+    sock_udp_batch();
     sock_tcp_data();
     sock_itf_list();
     sock_udp_ll();
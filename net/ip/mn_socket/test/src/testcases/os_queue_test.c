@@ -0,0 +1,160 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "mn_sock_test.h"
+
+#include "ip/os_queue.h"
+
+#define OS_QUEUE_TEST_CNT       4
+#define OS_QUEUE_TEST_TMO       2
+
+static struct os_queue os_queue_test_q;
+
+/*
+ * The producer runs at a lower priority than the consumer (the test task),
+ * so it only gets to put an element when the consumer sleeps.
+ */
+static struct os_task os_queue_test_prod_task;
+static os_stack_t os_queue_test_prod_stack[OS_STACK_ALIGN(TEST_STACK_SIZE)];
+static struct os_sem os_queue_test_prod_sem;
+static uint32_t os_queue_test_prod_val;
+
+static void
+os_queue_test_prod(void *arg)
+{
+    int rc;
+
+    while (1) {
+        os_sem_pend(&os_queue_test_prod_sem, OS_WAIT_FOREVER);
+        rc = os_queue_put(&os_queue_test_q, &os_queue_test_prod_val,
+          OS_WAIT_FOREVER);
+        TEST_ASSERT(rc == 0);
+        os_queue_test_prod_val++;
+    }
+}
+
+static void
+os_queue_test_put(uint32_t val)
+{
+    int rc;
+
+    rc = os_queue_put(&os_queue_test_q, &val, 0);
+    TEST_ASSERT(rc == 0);
+}
+
+static void
+os_queue_test_get(int max, int exp_cnt, uint32_t first, uint32_t timeout)
+{
+    uint32_t vals[OS_QUEUE_TEST_CNT * 2];
+    int cnt;
+    int rc;
+    int i;
+
+    memset(vals, 0xa5, sizeof(vals));
+    rc = os_queue_get_batch(&os_queue_test_q, vals, max, &cnt, timeout);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cnt == exp_cnt);
+    for (i = 0; i < cnt; i++) {
+        TEST_ASSERT(vals[i] == first + i);
+    }
+    TEST_ASSERT(vals[cnt] == 0xa5a5a5a5);
+}
+
+static void
+os_queue_test_cons(void *arg)
+{
+    uint32_t val;
+    os_time_t start;
+    int cnt;
+    int rc;
+    int i;
+
+    /* Empty ring: the fetch times out without taking anything. */
+    start = os_time_get();
+    cnt = -1;
+    rc = os_queue_get_batch(&os_queue_test_q, &val, 1, &cnt,
+      OS_QUEUE_TEST_TMO);
+    TEST_ASSERT(rc == OS_TIMEOUT);
+    TEST_ASSERT(cnt == 0);
+    TEST_ASSERT(os_time_get() - start >= OS_QUEUE_TEST_TMO);
+
+    /* Full ring: a put times out. */
+    for (i = 0; i < OS_QUEUE_TEST_CNT; i++) {
+        os_queue_test_put(i);
+    }
+    val = OS_QUEUE_TEST_CNT;
+    rc = os_queue_put(&os_queue_test_q, &val, 0);
+    TEST_ASSERT(rc == OS_TIMEOUT);
+    start = os_time_get();
+    rc = os_queue_put(&os_queue_test_q, &val, OS_QUEUE_TEST_TMO);
+    TEST_ASSERT(rc == OS_TIMEOUT);
+    TEST_ASSERT(os_time_get() - start >= OS_QUEUE_TEST_TMO);
+
+    /*
+     * Batches are limited by max and by what is in the ring, and keep their
+     * order across the end of the ring.
+     */
+    os_queue_test_get(3, 3, 0, 0);
+    for (i = OS_QUEUE_TEST_CNT; i < OS_QUEUE_TEST_CNT + 3; i++) {
+        os_queue_test_put(i);
+    }
+    os_queue_test_get(OS_QUEUE_TEST_CNT * 2, OS_QUEUE_TEST_CNT, 3, 0);
+    os_queue_test_put(7);
+    os_queue_test_put(8);
+    os_queue_test_get(1, 1, 7, 0);
+    os_queue_test_get(OS_QUEUE_TEST_CNT * 2, 1, 8, 0);
+
+    /* A consumer sleeping on an empty ring is woken by the next put. */
+    os_queue_test_prod_val = 100;
+    os_sem_release(&os_queue_test_prod_sem);
+    os_queue_test_get(OS_QUEUE_TEST_CNT * 2, 1, 100, OS_TICKS_PER_SEC);
+
+    /* A producer sleeping on a full ring is woken by the next fetch. */
+    for (i = 0; i < OS_QUEUE_TEST_CNT; i++) {
+        os_queue_test_put(10 + i);
+    }
+    os_sem_release(&os_queue_test_prod_sem);
+    os_time_delay(1);
+    TEST_ASSERT(os_queue_test_prod_val == 101);
+    os_queue_test_get(2, 2, 10, 0);
+    os_queue_test_get(OS_QUEUE_TEST_CNT * 2, 2, 12, 0);
+    os_queue_test_get(OS_QUEUE_TEST_CNT * 2, 1, 101, OS_TICKS_PER_SEC);
+    os_time_delay(1);
+    TEST_ASSERT(os_queue_test_prod_val == 102);
+
+    tu_restart();
+}
+
+TEST_CASE(os_queue_spsc_test)
+{
+    int rc;
+
+    sysinit();
+
+    rc = os_queue_init_spsc(&os_queue_test_q, sizeof(uint32_t),
+      OS_QUEUE_TEST_CNT);
+    TEST_ASSERT_FATAL(rc == 0);
+    os_sem_init(&os_queue_test_prod_sem, 0);
+
+    os_task_init(&test_task, "os_queue_cons", os_queue_test_cons, NULL,
+      TEST_PRIO, OS_WAIT_FOREVER, test_stack, TEST_STACK_SIZE);
+    os_task_init(&os_queue_test_prod_task, "os_queue_prod",
+      os_queue_test_prod, NULL, TEST_PRIO + 1, OS_WAIT_FOREVER,
+      os_queue_test_prod_stack, TEST_STACK_SIZE);
+    os_start();
+}
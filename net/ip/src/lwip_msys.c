@@ -0,0 +1,128 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <string.h>
+
+#include <os/os.h>
+#include <os/os_mbuf.h>
+
+#include <lwip/opt.h>
+#include <ip/init.h>
+
+static struct ip_msys_stats lwip_msys_stats;
+
+#if LWIP_MSYS_MEM
+/*
+ * Precedes every allocation.  lmh_om is the mbuf holding the memory, or
+ * NULL if it came from the heap.
+ */
+struct lwip_msys_hdr {
+    struct os_mbuf *lmh_om;
+};
+
+#define LWIP_MSYS_HDR_SZ \
+    OS_ALIGN(sizeof(struct lwip_msys_hdr), MEM_ALIGNMENT)
+
+void *
+lwip_msys_malloc(size_t size)
+{
+    struct lwip_msys_hdr *hdr;
+    struct os_mbuf *om;
+    size_t len;
+    os_sr_t sr;
+
+    len = size + LWIP_MSYS_HDR_SZ;
+    om = NULL;
+    if (len <= UINT16_MAX) {
+        om = os_msys_get(len, 0);
+        if (!om) {
+            OS_ENTER_CRITICAL(sr);
+            lwip_msys_stats.ims_fails++;
+            OS_EXIT_CRITICAL(sr);
+            return NULL;
+        }
+        if (om->om_omp->omp_databuf_len < len) {
+            os_mbuf_free(om);
+            om = NULL;
+        }
+    }
+    if (om) {
+        hdr = (struct lwip_msys_hdr *)om->om_databuf;
+        OS_ENTER_CRITICAL(sr);
+        if (++lwip_msys_stats.ims_blocks > lwip_msys_stats.ims_blocks_peak) {
+            lwip_msys_stats.ims_blocks_peak = lwip_msys_stats.ims_blocks;
+        }
+        OS_EXIT_CRITICAL(sr);
+    } else {
+        /*
+         * Nothing in msys is large enough for this.
+         */
+        hdr = malloc(len);
+        if (!hdr) {
+            return NULL;
+        }
+        OS_ENTER_CRITICAL(sr);
+        lwip_msys_stats.ims_heap++;
+        OS_EXIT_CRITICAL(sr);
+    }
+    hdr->lmh_om = om;
+    return (uint8_t *)hdr + LWIP_MSYS_HDR_SZ;
+}
+
+void *
+lwip_msys_calloc(size_t count, size_t size)
+{
+    void *ptr;
+
+    ptr = lwip_msys_malloc(count * size);
+    if (ptr) {
+        memset(ptr, 0, count * size);
+    }
+    return ptr;
+}
+
+void
+lwip_msys_free(void *ptr)
+{
+    struct lwip_msys_hdr *hdr;
+    os_sr_t sr;
+
+    hdr = (struct lwip_msys_hdr *)((uint8_t *)ptr - LWIP_MSYS_HDR_SZ);
+    if (hdr->lmh_om) {
+        os_mbuf_free(hdr->lmh_om);
+        OS_ENTER_CRITICAL(sr);
+        lwip_msys_stats.ims_blocks--;
+        OS_EXIT_CRITICAL(sr);
+    } else {
+        free(hdr);
+        OS_ENTER_CRITICAL(sr);
+        lwip_msys_stats.ims_heap--;
+        OS_EXIT_CRITICAL(sr);
+    }
+}
+#endif
+
+void
+ip_msys_stats(struct ip_msys_stats *stats)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    *stats = lwip_msys_stats;
+    OS_EXIT_CRITICAL(sr);
+}
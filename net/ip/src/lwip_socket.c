@@ -78,7 +78,17 @@ struct lwip_sock {
     struct os_mbuf *ls_tx;
 };
 
+/*
+ * Received pbuf segment lent to an mbuf chain.  The mbuf points straight at
+ * the pbuf payload; the pbuf reference is dropped when the mbuf is freed.
+ */
+struct lwip_pbuf_ext {
+    struct os_mbuf_ext lpe_ext;
+    struct pbuf *lpe_pbuf;
+};
+
 static struct os_mempool lwip_sockets;
+static struct os_mempool lwip_pbuf_exts;
 
 static int lwip_stream_tx(struct lwip_sock *s, int notify);
 
@@ -177,6 +187,58 @@ lwip_err_to_mn_err(int rc)
     }
 }
 
+static void
+lwip_pbuf_ext_free(struct os_mbuf_ext *ext)
+{
+    struct lwip_pbuf_ext *pe = (struct lwip_pbuf_ext *)ext;
+
+    pbuf_free(pe->lpe_pbuf);
+    os_memblock_put(&lwip_pbuf_exts, pe);
+}
+
+/*
+ * Turns a received pbuf chain into an mbuf chain.  As long as there are
+ * spare descriptors, segments are referenced instead of copied; the rest
+ * gets copied.  Caller still has to release its own reference to p.
+ */
+static struct os_mbuf *
+lwip_pbuf_to_mbuf(struct pbuf *p, uint8_t hdr_len)
+{
+    struct lwip_pbuf_ext *pe;
+    struct os_mbuf *m;
+    struct os_mbuf *n;
+    struct pbuf *q;
+
+    m = os_msys_get_pkthdr(0, hdr_len);
+    if (!m) {
+        return NULL;
+    }
+    for (q = p; q; q = q->next) {
+        if (q->len == 0) {
+            continue;
+        }
+        n = NULL;
+        pe = os_memblock_get(&lwip_pbuf_exts);
+        if (pe) {
+            os_mbuf_ext_init(&pe->lpe_ext, q->payload, q->len,
+              lwip_pbuf_ext_free, NULL);
+            pe->lpe_pbuf = q;
+            n = os_mbuf_get_ext(m->om_omp, &pe->lpe_ext, 0, q->len);
+            if (n) {
+                pbuf_ref(q);
+                os_mbuf_concat(m, n);
+            } else {
+                os_memblock_put(&lwip_pbuf_exts, pe);
+            }
+        }
+        if (!n && os_mbuf_append(m, q->payload, q->len)) {
+            os_mbuf_free_chain(m);
+            return NULL;
+        }
+    }
+    return m;
+}
+
 #if LWIP_UDP
 static void
 lwip_sock_udp_rx(void *arg, struct udp_pcb *pcb, struct pbuf *p,
@@ -184,20 +246,14 @@ lwip_sock_udp_rx(void *arg, struct udp_pcb *pcb, struct pbuf *p,
 {
     struct lwip_sock *s = (struct lwip_sock *)arg;
     struct os_mbuf *m;
-    struct pbuf *q;
-    int off;
 
-    m = os_msys_get_pkthdr(p->tot_len, sizeof(struct mn_sockaddr_in6));
+    m = lwip_pbuf_to_mbuf(p, sizeof(struct mn_sockaddr_in6));
+    pbuf_free(p);
     if (!m) {
-        pbuf_free(p);
         return;
     }
     lwip_addr_to_mn_addr((struct mn_sockaddr *)OS_MBUF_USRHDR(m),
       addr, port);
-    off = 0;
-    for (q = p; q; q = q->next) {
-        os_mbuf_copyinto(m, off, q->payload, p->len);
-    }
     STAILQ_INSERT_TAIL(&s->ls_rx, OS_MBUF_PKTHDR(m), omp_next);
     mn_socket_readable(&s->ls_sock, 0);
 }
@@ -209,8 +265,6 @@ lwip_sock_tcp_rx(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
 {
     struct lwip_sock *s = (struct lwip_sock *)arg;
     struct os_mbuf *m;
-    struct pbuf *q;
-    int off;
 
     if (!p) {
         /*
@@ -219,13 +273,15 @@ lwip_sock_tcp_rx(void *arg, struct tcp_pcb *pcb, struct pbuf *p, err_t err)
         mn_socket_readable(&s->ls_sock, MN_ECONNABORTED);
         return ERR_OK;
     }
-    m = os_msys_get_pkthdr(p->tot_len, 0);
-    assert(m);
-    /* XXX fix this */
-    off = 0;
-    for (q = p; q; q = q->next) {
-        os_mbuf_copyinto(m, off, q->payload, p->len);
+    m = lwip_pbuf_to_mbuf(p, 0);
+    if (!m) {
+        /*
+         * Refuse the data; lwIP holds on to it and offers it again later.
+         */
+        return ERR_MEM;
     }
+    tcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
     STAILQ_INSERT_TAIL(&s->ls_rx, OS_MBUF_PKTHDR(m), omp_next);
     mn_socket_readable(&s->ls_sock, 0);
 
@@ -445,18 +501,34 @@ static int
 lwip_stream_tx(struct lwip_sock *s, int notify)
 {
     int rc;
+    int written;
+    uint8_t flags;
     struct os_mbuf *m;
     struct os_mbuf *n;
 
+    /*
+     * Data is copied into lwIP's segments: it keeps them queued for
+     * retransmission, possibly after the socket itself has been closed.
+     */
+    rc = 0;
+    written = 0;
     while (s->ls_tx && rc == 0) {
         m = s->ls_tx;
         n = SLIST_NEXT(m, om_next);
-        rc = tcp_write(s->ls_pcb.tcp, m->om_data, m->om_len, 0);
+        flags = TCP_WRITE_FLAG_COPY;
+        if (n) {
+            flags |= TCP_WRITE_FLAG_MORE;
+        }
+        rc = tcp_write(s->ls_pcb.tcp, m->om_data, m->om_len, flags);
         if (rc == 0) {
             s->ls_tx = n;
             os_mbuf_free(m);
+            written = 1;
         }
     }
+    if (written) {
+        tcp_output(s->ls_pcb.tcp);
+    }
     if (rc) {
         if (rc == ERR_MEM) {
             rc = 0;
@@ -474,6 +546,41 @@ lwip_stream_tx(struct lwip_sock *s, int notify)
     return rc;
 }
 
+#if LWIP_UDP
+/*
+ * Wraps the mbuf data in PBUF_REF pbufs, so the datagram goes out without
+ * being copied.  lwIP copies PBUF_REF data before queueing it anywhere, so
+ * the mbufs only need to stay around until udp_sendto() returns.
+ */
+static struct pbuf *
+lwip_mbuf_to_pbuf(struct os_mbuf *m)
+{
+    struct pbuf *p;
+    struct pbuf *q;
+
+    p = NULL;
+    for (; m; m = SLIST_NEXT(m, om_next)) {
+        if (m->om_len == 0) {
+            continue;
+        }
+        q = pbuf_alloc(PBUF_RAW, m->om_len, PBUF_REF);
+        if (!q) {
+            if (p) {
+                pbuf_free(p);
+            }
+            return NULL;
+        }
+        q->payload = m->om_data;
+        if (p) {
+            pbuf_cat(p, q);
+        } else {
+            p = q;
+        }
+    }
+    return p;
+}
+#endif
+
 static int
 lwip_sendto(struct mn_socket *ms, struct os_mbuf *m,
   struct mn_sockaddr *addr)
@@ -496,26 +603,28 @@ lwip_sendto(struct mn_socket *ms, struct os_mbuf *m,
         if (rc) {
             return rc;
         }
-        off = 0;
-        for (n = m; n; n = SLIST_NEXT(n, om_next)) {
-            off += n->om_len;
-        }
-        p = pbuf_alloc(PBUF_TRANSPORT, off, PBUF_RAM);
+        p = lwip_mbuf_to_pbuf(m);
         if (!p) {
-            return MN_ENOBUFS;
-        }
+            off = 0;
+            for (n = m; n; n = SLIST_NEXT(n, om_next)) {
+                off += n->om_len;
+            }
+            p = pbuf_alloc(PBUF_TRANSPORT, off, PBUF_RAM);
+            if (!p) {
+                return MN_ENOBUFS;
+            }
 
-        off = 0;
-        for (n = m; n; n = SLIST_NEXT(n, om_next)) {
-            pbuf_take_at(p, n->om_data, n->om_len, off);
-            off += n->om_len;
+            off = 0;
+            for (n = m; n; n = SLIST_NEXT(n, om_next)) {
+                pbuf_take_at(p, n->om_data, n->om_len, off);
+                off += n->om_len;
+            }
         }
 
         rc = udp_sendto(s->ls_pcb.udp, p, &ip_addr, port);
+        pbuf_free(p);
         if (rc) {
-            rc = lwip_err_to_mn_err(rc);
-            pbuf_free(p);
-            return rc;
+            return lwip_err_to_mn_err(rc);
         }
         os_mbuf_free_chain(m);
         return 0;
@@ -649,6 +758,16 @@ lwip_socket_init(void)
     }
     os_mempool_init(&lwip_sockets, cnt, sizeof(struct lwip_sock), mem, "sock");
 
+    cnt = LWIP_SOCK_RX_PBUF_REFS;
+    if (cnt) {
+        mem = malloc(OS_MEMPOOL_SIZE(cnt, sizeof(struct lwip_pbuf_ext)));
+        if (!mem) {
+            return -1;
+        }
+        os_mempool_init(&lwip_pbuf_exts, cnt, sizeof(struct lwip_pbuf_ext),
+          mem, "sock_pbuf");
+    }
+
     rc = mn_socket_ops_reg(&lwip_sock_ops);
     if (rc) {
         return -1;
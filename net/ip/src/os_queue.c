@@ -40,11 +40,145 @@ os_queue_init(struct os_queue *q, uint8_t elem_size, uint8_t elem_cnt)
     q->oq_head = q->oq_tail = 0;
     q->oq_size = elem_cnt;
     q->oq_elem_size = elem_size;
+    q->oq_flags = 0;
     os_sem_init(&q->oq_space, elem_cnt);
     os_sem_init(&q->oq_items, 0);
     return 0;
 }
 
+/*
+ * Queue for exactly one putting and one getting task (or interrupt).  The
+ * ring indices are only written by their owner, so elements move without a
+ * critical section.  The semaphores merely wake up a side that went to sleep
+ * on an empty or full ring, and are only touched on those transitions.
+ * One slot is left unused to tell a full ring from an empty one.
+ */
+int
+os_queue_init_spsc(struct os_queue *q, uint8_t elem_size, uint8_t elem_cnt)
+{
+    assert(elem_cnt < UINT8_MAX);
+
+    q->oq_q = malloc(elem_size * (elem_cnt + 1));
+    if (!q->oq_q) {
+        return -1;
+    }
+    q->oq_head = q->oq_tail = 0;
+    q->oq_size = elem_cnt + 1;
+    q->oq_elem_size = elem_size;
+    q->oq_flags = OS_QUEUE_F_SPSC;
+    os_sem_init(&q->oq_space, 0);
+    os_sem_init(&q->oq_items, 0);
+    return 0;
+}
+
+/*
+ * Orders the ring accesses against the index updates, and each side's index
+ * store against its load of the other side's index.
+ */
+#define OS_QUEUE_BARRIER()      __sync_synchronize()
+
+static inline uint8_t
+os_queue_next(struct os_queue *q, uint8_t idx)
+{
+    idx++;
+    if (idx >= q->oq_size) {
+        idx = 0;
+    }
+    return idx;
+}
+
+/*
+ * Sleeps on sem for whatever remains of timeout since start.  Wakeups can
+ * be spurious; callers recheck the ring.
+ */
+static int
+os_queue_wait(struct os_sem *sem, uint32_t timeout, os_time_t start)
+{
+    os_time_t elapsed;
+
+    if (timeout != OS_WAIT_FOREVER) {
+        elapsed = os_time_get() - start;
+        if (elapsed >= timeout) {
+            return OS_TIMEOUT;
+        }
+        timeout -= elapsed;
+    }
+    return os_sem_pend(sem, timeout);
+}
+
+static int
+os_queue_put_spsc(struct os_queue *q, void *elem, uint32_t timeout)
+{
+    os_time_t start;
+    uint8_t head;
+    uint8_t next;
+    int rc;
+
+    start = os_time_get();
+    head = q->oq_head;
+    next = os_queue_next(q, head);
+    while (next == q->oq_tail) {
+        rc = os_queue_wait(&q->oq_space, timeout, start);
+        if (rc) {
+            return rc;
+        }
+    }
+    memcpy((uint8_t *)q->oq_q + q->oq_elem_size * head, elem,
+      q->oq_elem_size);
+    OS_QUEUE_BARRIER();
+    q->oq_head = next;
+    OS_QUEUE_BARRIER();
+
+    /*
+     * If the consumer had drained everything, it may be asleep.
+     */
+    if (q->oq_tail == head) {
+        os_sem_release(&q->oq_items);
+    }
+    return 0;
+}
+
+static int
+os_queue_get_spsc(struct os_queue *q, uint8_t *elems, int max, int *cnt,
+  uint32_t timeout)
+{
+    os_time_t start;
+    uint8_t head;
+    uint8_t tail;
+    uint8_t first;
+    int n;
+    int rc;
+
+    start = os_time_get();
+    first = tail = q->oq_tail;
+    while (tail == q->oq_head) {
+        rc = os_queue_wait(&q->oq_items, timeout, start);
+        if (rc) {
+            return rc;
+        }
+    }
+    head = q->oq_head;
+    OS_QUEUE_BARRIER();
+    for (n = 0; n < max && tail != head; n++) {
+        memcpy(elems, (uint8_t *)q->oq_q + q->oq_elem_size * tail,
+          q->oq_elem_size);
+        elems += q->oq_elem_size;
+        tail = os_queue_next(q, tail);
+    }
+    OS_QUEUE_BARRIER();
+    q->oq_tail = tail;
+    OS_QUEUE_BARRIER();
+
+    /*
+     * If the producer found the ring full, it may be asleep.
+     */
+    if (os_queue_next(q, q->oq_head) == first) {
+        os_sem_release(&q->oq_space);
+    }
+    *cnt = n;
+    return 0;
+}
+
 int
 os_queue_put(struct os_queue *q, void *elem, uint32_t timeout)
 {
@@ -52,6 +186,9 @@ os_queue_put(struct os_queue *q, void *elem, uint32_t timeout)
     int sr;
     uint8_t *ptr;
 
+    if (q->oq_flags & OS_QUEUE_F_SPSC) {
+        return os_queue_put_spsc(q, elem, timeout);
+    }
     rc = os_sem_pend(&q->oq_space, timeout);
     if (rc) {
         return rc;
@@ -69,26 +206,53 @@ os_queue_put(struct os_queue *q, void *elem, uint32_t timeout)
     return 0;
 }
 
+/*
+ * Waits up to timeout for the queue to have elements, then takes as many as
+ * are there, up to max.  The number taken is returned in cnt.
+ */
 int
-os_queue_get(struct os_queue *q, void *elem, uint32_t timeout)
+os_queue_get_batch(struct os_queue *q, void *elems, int max, int *cnt,
+  uint32_t timeout)
 {
     int rc;
     int sr;
+    int n;
     uint8_t *ptr;
+    uint8_t *dst;
 
+    *cnt = 0;
+    if (q->oq_flags & OS_QUEUE_F_SPSC) {
+        return os_queue_get_spsc(q, elems, max, cnt, timeout);
+    }
     rc = os_sem_pend(&q->oq_items, timeout);
     if (rc) {
         return rc;
     }
-    OS_ENTER_CRITICAL(sr);
-    ptr = q->oq_q;
-    ptr += q->oq_elem_size * q->oq_tail;
-    memcpy(elem, ptr, q->oq_elem_size);
-    q->oq_tail++;
-    if (q->oq_tail >= q->oq_size) {
-        q->oq_tail = 0;
+    dst = elems;
+    for (n = 0; n < max; n++) {
+        if (n && os_sem_pend(&q->oq_items, 0)) {
+            break;
+        }
+        OS_ENTER_CRITICAL(sr);
+        ptr = q->oq_q;
+        ptr += q->oq_elem_size * q->oq_tail;
+        memcpy(dst, ptr, q->oq_elem_size);
+        q->oq_tail++;
+        if (q->oq_tail >= q->oq_size) {
+            q->oq_tail = 0;
+        }
+        OS_EXIT_CRITICAL(sr);
+        os_sem_release(&q->oq_space);
+        dst += q->oq_elem_size;
     }
-    OS_EXIT_CRITICAL(sr);
-    os_sem_release(&q->oq_space);
+    *cnt = n;
     return 0;
 }
+
+int
+os_queue_get(struct os_queue *q, void *elem, uint32_t timeout)
+{
+    int cnt;
+
+    return os_queue_get_batch(q, elem, 1, &cnt, timeout);
+}
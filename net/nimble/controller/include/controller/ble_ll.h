@@ -122,6 +122,15 @@ STATS_SECT_START(ble_ll_stats)
     STATS_SECT_ENTRY(scan_req_txf)
     STATS_SECT_ENTRY(scan_req_txg)
     STATS_SECT_ENTRY(scan_rsp_txg)
+    STATS_SECT_ENTRY(scan_dup_filtered)
+    STATS_SECT_ENTRY(scan_dup_evicted)
+    STATS_SECT_ENTRY(rpa_cache_hits)
+    STATS_SECT_ENTRY(rpa_cache_misses)
+    STATS_SECT_ENTRY(rpa_resolv_cputime)
+    STATS_SECT_ENTRY(chan_map_adapt)
+    STATS_SECT_ENTRY(chan_excluded)
+    STATS_SECT_ENTRY(chan_restored)
+    STATS_SECT_ENTRY(scan_filt_dropped)
 STATS_SECT_END
 extern STATS_SECT_DECL(ble_ll_stats) ble_ll_stats;
 
@@ -0,0 +1,74 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#ifndef H_BLE_LL_CHAN_
+#define H_BLE_LL_CHAN_
+
+#include <stdint.h>
+#include "syscfg/syscfg.h"
+#include "controller/ble_phy.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Per data channel packet counters, maintained for all connections. A
+ * received PDU either passes or fails the CRC check; a transmitted PDU is
+ * either acknowledged by the peer or has to be retransmitted.
+ */
+struct ble_ll_chan_stats
+{
+    uint32_t rx_crc_ok;
+    uint32_t rx_crc_err;
+    uint32_t tx_ack;
+    uint32_t tx_retry;
+};
+
+#if MYNEWT_VAL(BLE_LL_CHAN_STATS)
+extern struct ble_ll_chan_stats g_ble_ll_chan_stats[BLE_PHY_NUM_DATA_CHANS];
+
+/* Count a PDU on a data channel (interrupt context) */
+#define BLE_LL_CHAN_STATS_INC(chan, field) \
+    (++g_ble_ll_chan_stats[(chan)].field)
+#else
+#define BLE_LL_CHAN_STATS_INC(chan, field)
+#endif
+
+/* Vendor specific HCI commands */
+int ble_ll_chan_hci_rd_stats(uint8_t *cmdbuf, uint8_t *rspbuf,
+                             uint8_t *rsplen);
+int ble_ll_chan_hci_rd_map(uint8_t *rspbuf, uint8_t *rsplen);
+int ble_ll_chan_hci_clr_stats(void);
+
+/* Called when the host sets a new channel map */
+void ble_ll_chan_host_map_set(uint8_t *chanmap);
+
+/* Called when a connection is created */
+void ble_ll_chan_conn_created(void);
+
+void ble_ll_chan_reset(void);
+void ble_ll_chan_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* H_BLE_LL_CHAN_ */
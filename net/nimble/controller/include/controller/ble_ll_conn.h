@@ -57,6 +57,58 @@ extern "C" {
 /* Definition for RSSI when the RSSI is unknown */
 #define BLE_LL_CONN_UNKNOWN_RSSI        (127)
 
+/*
+ * Transmit priority classes. Each connection keeps one transmit queue per
+ * class; lower numbered queues are always serviced first.
+ *  CTRL: LL control PDUs.
+ *  PRIO: single fragment ATT indications/confirmations/notifications.
+ *  BULK: all other host data.
+ */
+#define BLE_LL_CONN_TXQ_CTRL            (0)
+#define BLE_LL_CONN_TXQ_PRIO            (1)
+#define BLE_LL_CONN_TXQ_BULK            (2)
+#define BLE_LL_CONN_TXQ_NUM             (3)
+
+/*
+ * Per-connection, per-class transmit queueing statistics. Delay is measured
+ * from the time a packet is enqueued on the connection until it is first
+ * handed to the phy.
+ */
+struct ble_ll_conn_txq_stats
+{
+    uint32_t pkts;
+    uint32_t delay_sum;     /* usecs */
+    uint32_t delay_max;     /* usecs */
+};
+
+#if MYNEWT_VAL(BLE_LL_CONN_PERF)
+/*
+ * Per-connection link statistics. The rx and tx counters count the same
+ * events as the per-channel statistics, but for one connection. Transmit
+ * latency is measured from the time an ACL packet is enqueued on the
+ * connection until its last fragment is acknowledged by the peer.
+ */
+struct ble_ll_conn_perf
+{
+    uint32_t events;        /* connection events run */
+    uint32_t rx_ok;
+    uint32_t rx_crc_err;
+    uint32_t rx_empty;      /* empty pdus received with a good crc */
+    uint32_t tx_ack;
+    uint32_t tx_retry;
+    uint32_t tx_empty;      /* empty pdus acknowledged */
+    uint32_t tx_pkts;       /* acl packets completed */
+    uint32_t tx_lat_sum;    /* usecs */
+    uint32_t tx_lat_max;    /* usecs */
+    int16_t rssi_avg;       /* dBm, in 1/16 units */
+};
+
+/* Count a link event on a connection (interrupt context) */
+#define BLE_LL_CONN_PERF_INC(csm, field)    (++(csm)->perf.field)
+#else
+#define BLE_LL_CONN_PERF_INC(csm, field)
+#endif
+
 #if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_ENCRYPTION) == 1)
 /*
  * Encryption states for a connection
@@ -191,6 +243,10 @@ struct ble_ll_conn_sm
     uint32_t ce_end_time;   /* cputime at which connection event should end */
     uint32_t terminate_timeout;
     uint32_t last_scheduled;
+    uint16_t sched_skips;       /* consecutive events not scheduled */
+    uint32_t events_skipped;    /* total events not scheduled */
+    uint8_t ce_slots;           /* slots reserved for a connection event */
+    uint8_t ce_pdus;            /* pdus received in current event */
 
     /* Connection timing */
     uint16_t conn_itvl_min;
@@ -220,9 +276,15 @@ struct ble_ll_conn_sm
     /* Connection end event */
     struct os_event conn_ev_end;
 
-    /* Packet transmit queue */
+    /* Packet transmit queues (one per priority class) */
     struct os_mbuf *cur_tx_pdu;
-    STAILQ_HEAD(conn_txq_head, os_mbuf_pkthdr) conn_txq;
+    STAILQ_HEAD(conn_txq_head, os_mbuf_pkthdr) conn_txq[BLE_LL_CONN_TXQ_NUM];
+    uint32_t txq_l2cap_rem;     /* host bytes left in current l2cap pdu */
+    uint8_t txq_bulk_mid_pdu;   /* bulk l2cap pdu partially dequeued */
+    struct ble_ll_conn_txq_stats txq_stats[BLE_LL_CONN_TXQ_NUM];
+#if MYNEWT_VAL(BLE_LL_CONN_PERF)
+    struct ble_ll_conn_perf perf;
+#endif
 
     /* List entry for active/free connection pools */
     union {
@@ -91,6 +91,9 @@ uint32_t ble_ll_resolv_get_rpa_tmo(void);
 /* Resolve a resolvable private address */
 int ble_ll_resolv_rpa(uint8_t *rpa, uint8_t *irk);
 
+/* Find the resolving list entry that resolves a peer RPA */
+int ble_ll_resolv_list_match(uint8_t *rpa);
+
 /* Initialize resolv*/
 void ble_ll_resolv_init(void);
 
@@ -20,6 +20,7 @@
 #ifndef H_BLE_LL_SCAN_
 #define H_BLE_LL_SCAN_
 
+#include "syscfg/syscfg.h"
 #include "controller/ble_ll_sched.h"
 #include "hal/hal_timer.h"
 
@@ -141,6 +142,29 @@ void ble_ll_scan_chk_resume(void);
 /* Called when wait for response timer expires in scanning mode */
 void ble_ll_scan_wfr_timer_exp(void);
 
+#if MYNEWT_VAL(BLE_LL_SCAN_FILT_RULES)
+/*
+ * Advertising report filter rule. Matches an advertising PDU containing an
+ * AD structure of type ad_type whose data starts with the first prefix_len
+ * bytes of prefix (e.g. a manufacturer's company identifier).
+ */
+struct ble_ll_scan_filt_rule
+{
+    uint8_t ad_type;
+    uint8_t prefix_len;
+    uint8_t prefix[MYNEWT_VAL(BLE_LL_SCAN_FILT_PREFIX_MAX)];
+};
+
+/* Register an advertising report filter rule */
+int ble_ll_scan_filt_add(const struct ble_ll_scan_filt_rule *rule);
+
+/* Remove all advertising report filter rules */
+void ble_ll_scan_filt_clear(void);
+
+/* Set the minimum RSSI of reported advertising PDUs */
+void ble_ll_scan_filt_set_min_rssi(int8_t min_rssi);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
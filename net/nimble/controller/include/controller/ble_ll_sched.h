@@ -105,6 +105,9 @@ int ble_ll_sched_next_time(uint32_t *next_event_time);
 /* Stop the scheduler */
 void ble_ll_sched_stop(void);
 
+/* Reserve airtime for scanning (window of zero cancels) */
+int ble_ll_sched_scan_reserve(uint32_t itvl_usecs, uint32_t window_usecs);
+
 #ifdef __cplusplus
 }
 #endif
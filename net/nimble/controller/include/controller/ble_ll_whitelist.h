@@ -42,6 +42,9 @@ void ble_ll_whitelist_enable(void);
 /* Disable whitelisting */
 void ble_ll_whitelist_disable(void);
 
+/* Let the radio drop PDUs from devices not on the whitelist */
+void ble_ll_whitelist_hw_filter(int enable);
+
 /* Boolean function returning true if address matches a whitelist entry */
 int ble_ll_whitelist_match(uint8_t *addr, uint8_t addr_type, int is_ident);
 
@@ -152,6 +152,12 @@ void ble_phy_resolv_list_enable(void);
 /* Disable phy resolving list */
 void ble_phy_resolv_list_disable(void);
 
+/* Drop received PDUs not matching the hw whitelist in the radio */
+void ble_phy_wl_filter_enable(void);
+
+/* Pass all received PDUs up to the link layer */
+void ble_phy_wl_filter_disable(void);
+
 #ifdef __cplusplus
 }
 #endif
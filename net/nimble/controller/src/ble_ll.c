@@ -39,6 +39,7 @@
 #include "controller/ble_ll_hci.h"
 #include "controller/ble_ll_whitelist.h"
 #include "controller/ble_ll_resolv.h"
+#include "controller/ble_ll_chan.h"
 #include "ble_ll_conn_priv.h"
 
 /* XXX:
@@ -179,6 +180,15 @@ STATS_NAME_START(ble_ll_stats)
     STATS_NAME(ble_ll_stats, scan_req_txf)
     STATS_NAME(ble_ll_stats, scan_req_txg)
     STATS_NAME(ble_ll_stats, scan_rsp_txg)
+    STATS_NAME(ble_ll_stats, scan_dup_filtered)
+    STATS_NAME(ble_ll_stats, scan_dup_evicted)
+    STATS_NAME(ble_ll_stats, rpa_cache_hits)
+    STATS_NAME(ble_ll_stats, rpa_cache_misses)
+    STATS_NAME(ble_ll_stats, rpa_resolv_cputime)
+    STATS_NAME(ble_ll_stats, chan_map_adapt)
+    STATS_NAME(ble_ll_stats, chan_excluded)
+    STATS_NAME(ble_ll_stats, chan_restored)
+    STATS_NAME(ble_ll_stats, scan_filt_dropped)
 STATS_NAME_END(ble_ll_stats)
 
 static void ble_ll_event_rx_pkt(struct os_event *ev);
@@ -1165,6 +1175,11 @@ ble_ll_reset(void)
     /* Reset connection module */
     ble_ll_conn_module_reset();
 
+#if MYNEWT_VAL(BLE_LL_CHAN_STATS)
+    /* Reset channel statistics; adopts the default channel map */
+    ble_ll_chan_reset();
+#endif
+
     /* All this does is re-initialize the event masks so call the hci init */
     ble_ll_hci_init();
 
@@ -1271,6 +1286,11 @@ ble_ll_init(void)
     /* Initialize the connection module */
     ble_ll_conn_module_init();
 
+#if MYNEWT_VAL(BLE_LL_CHAN_STATS)
+    /* Initialize per-channel statistics */
+    ble_ll_chan_init();
+#endif
+
     /* Set the supported features. NOTE: we always support extended reject. */
     features = BLE_LL_FEAT_EXTENDED_REJ;
 
@@ -438,6 +438,13 @@ ble_ll_adv_tx_start_cb(struct ble_ll_sched_item *sch)
     /* Enable/disable whitelisting based on filter policy */
     if (advsm->adv_filter_policy != BLE_HCI_ADV_FILT_NONE) {
         ble_ll_whitelist_enable();
+
+        /*
+         * Scan and connect requests can only be dropped in hardware if both
+         * are filtered.
+         */
+        ble_ll_whitelist_hw_filter(advsm->adv_filter_policy ==
+                                   BLE_HCI_ADV_FILT_BOTH);
     } else {
         ble_ll_whitelist_disable();
     }
@@ -862,6 +869,7 @@ ble_ll_adv_set_enable(uint8_t *cmd)
 int
 ble_ll_adv_set_scan_rsp_data(uint8_t *cmd, uint8_t len)
 {
+    os_sr_t sr;
     uint8_t datalen;
     struct ble_ll_adv_sm *advsm;
 
@@ -871,10 +879,16 @@ ble_ll_adv_set_scan_rsp_data(uint8_t *cmd, uint8_t len)
         return BLE_ERR_INV_HCI_CMD_PARMS;
     }
 
-    /* Copy the new data into the advertising structure. */
+    /*
+     * Copy the new data into the advertising structure. The data may be
+     * changed while advertising; the PDU is built from it at the start of
+     * each advertising event, so make sure it never sees a partial update.
+     */
     advsm = &g_ble_ll_adv_sm;
+    OS_ENTER_CRITICAL(sr);
     advsm->scan_rsp_len = datalen;
     memcpy(advsm->scan_rsp_data, cmd + 1, datalen);
+    OS_EXIT_CRITICAL(sr);
 
     return 0;
 }
@@ -891,6 +905,7 @@ ble_ll_adv_set_scan_rsp_data(uint8_t *cmd, uint8_t len)
 int
 ble_ll_adv_set_adv_data(uint8_t *cmd, uint8_t len)
 {
+    os_sr_t sr;
     uint8_t datalen;
     struct ble_ll_adv_sm *advsm;
 
@@ -900,10 +915,16 @@ ble_ll_adv_set_adv_data(uint8_t *cmd, uint8_t len)
         return BLE_ERR_INV_HCI_CMD_PARMS;
     }
 
-    /* Copy the new data into the advertising structure. */
+    /*
+     * Copy the new data into the advertising structure. The data may be
+     * changed while advertising; the PDU is built from it at the start of
+     * each advertising event, so make sure it never sees a partial update.
+     */
     advsm = &g_ble_ll_adv_sm;
+    OS_ENTER_CRITICAL(sr);
     advsm->adv_len = datalen;
     memcpy(advsm->adv_data, cmd + 1, datalen);
+    OS_EXIT_CRITICAL(sr);
 
     return 0;
 }
@@ -963,7 +984,7 @@ ble_ll_adv_rx_req(uint8_t pdu_type, struct os_mbuf *rxpdu)
 
 #if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY) == 1)
     if (ble_ll_is_rpa(peer, txadd) && ble_ll_resolv_enabled()) {
-        advsm->adv_rpa_index = ble_hw_resolv_list_match();
+        advsm->adv_rpa_index = ble_ll_resolv_list_match(peer);
         if (advsm->adv_rpa_index >= 0) {
             ble_hdr->rxinfo.flags |= BLE_MBUF_HDR_F_RESOLVED;
             if (chk_wl) {
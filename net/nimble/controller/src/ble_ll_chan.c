@@ -0,0 +1,363 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include <stdint.h>
+#include <string.h>
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "nimble/ble.h"
+#include "controller/ble_phy.h"
+#include "controller/ble_ll.h"
+#include "controller/ble_ll_conn.h"
+#include "controller/ble_ll_chan.h"
+#include "ble_ll_conn_priv.h"
+
+#if MYNEWT_VAL(BLE_LL_CHAN_STATS)
+
+struct ble_ll_chan_stats g_ble_ll_chan_stats[BLE_PHY_NUM_DATA_CHANS];
+
+#if MYNEWT_VAL(BLE_LL_CHAN_ADAPT)
+
+#define BLE_LL_CHAN_ASSESS_TICKS    \
+    (MYNEWT_VAL(BLE_LL_CHAN_ASSESS_MS) * OS_TICKS_PER_SEC / 1000 + 1)
+
+/*
+ * Channel quality assessment state. Every assessment period, the error rate
+ * (CRC errors plus retransmissions, as a percentage of all PDUs) each
+ * channel had over the period is compared with BLE_LL_CHAN_BAD_PCT. A
+ * channel that is bad for BLE_LL_CHAN_BAD_STREAK periods in a row is removed
+ * from the channel map for BLE_LL_CHAN_QUARANTINE periods, after which it
+ * gets another chance.
+ */
+struct ble_ll_chan_adapt_state
+{
+    uint32_t last_err;
+    uint32_t last_total;
+    uint8_t err_pct;
+    uint8_t bad_streak;
+    uint8_t quarantine;
+};
+
+static struct ble_ll_chan_adapt_state
+    g_ble_ll_chan_adapt[BLE_PHY_NUM_DATA_CHANS];
+
+/* The channel map requested by the host */
+static uint8_t g_ble_ll_chan_host_map[BLE_LL_CONN_CHMAP_LEN];
+
+static struct os_callout g_ble_ll_chan_assess_timer;
+
+static int
+ble_ll_chan_in_map(const uint8_t *chanmap, int chan)
+{
+    return (chanmap[chan >> 3] & (1 << (chan & 7))) != 0;
+}
+
+/**
+ * Derives the channel map used by master connections from the host channel
+ * map and the channels currently in quarantine, and starts channel map update
+ * procedures if it changed.
+ *
+ * Context: Link Layer task
+ */
+static void
+ble_ll_chan_apply(void)
+{
+    int i;
+    uint8_t chanmap[BLE_LL_CONN_CHMAP_LEN];
+
+    memcpy(chanmap, g_ble_ll_chan_host_map, BLE_LL_CONN_CHMAP_LEN);
+    for (i = 0; i < BLE_PHY_NUM_DATA_CHANS; ++i) {
+        if (g_ble_ll_chan_adapt[i].quarantine) {
+            chanmap[i >> 3] &= ~(1 << (i & 7));
+        }
+    }
+
+    /* Never go below the minimum the specification allows */
+    if (ble_ll_conn_calc_used_chans(chanmap) < 2) {
+        memcpy(chanmap, g_ble_ll_chan_host_map, BLE_LL_CONN_CHMAP_LEN);
+    }
+
+    ble_ll_conn_master_chanmap_set(chanmap);
+}
+
+/**
+ * Periodic channel quality assessment.
+ *
+ * Context: Link Layer task
+ *
+ * @param ev
+ */
+static void
+ble_ll_chan_assess(struct os_event *ev)
+{
+    int i;
+    int worst;
+    int used;
+    int changed;
+    uint32_t err;
+    uint32_t total;
+    uint32_t d_err;
+    uint32_t d_total;
+    struct ble_ll_chan_stats *cs;
+    struct ble_ll_chan_adapt_state *cas;
+
+    changed = 0;
+    used = 0;
+    for (i = 0; i < BLE_PHY_NUM_DATA_CHANS; ++i) {
+        cs = &g_ble_ll_chan_stats[i];
+        cas = &g_ble_ll_chan_adapt[i];
+
+        /* The counters only ever increase, so wrap-around is harmless */
+        err = cs->rx_crc_err + cs->tx_retry;
+        total = err + cs->rx_crc_ok + cs->tx_ack;
+        d_err = err - cas->last_err;
+        d_total = total - cas->last_total;
+        cas->last_err = err;
+        cas->last_total = total;
+
+        if (cas->quarantine) {
+            --cas->quarantine;
+            if (cas->quarantine == 0) {
+                STATS_INC(ble_ll_stats, chan_restored);
+                changed = 1;
+            }
+            continue;
+        }
+
+        if (!ble_ll_chan_in_map(g_ble_ll_chan_host_map, i)) {
+            continue;
+        }
+        ++used;
+
+        /* Too few PDUs to judge the channel; keep the previous verdict */
+        if (d_total < MYNEWT_VAL(BLE_LL_CHAN_MIN_PKTS)) {
+            continue;
+        }
+
+        cas->err_pct = (d_err * 100) / d_total;
+        if (cas->err_pct >= MYNEWT_VAL(BLE_LL_CHAN_BAD_PCT)) {
+            if (cas->bad_streak < UINT8_MAX) {
+                ++cas->bad_streak;
+            }
+        } else {
+            cas->bad_streak = 0;
+        }
+    }
+
+    /*
+     * Quarantine persistently bad channels, worst first, as long as enough
+     * channels remain in use.
+     */
+    while (used > MYNEWT_VAL(BLE_LL_CHAN_MIN_USED)) {
+        worst = -1;
+        for (i = 0; i < BLE_PHY_NUM_DATA_CHANS; ++i) {
+            cas = &g_ble_ll_chan_adapt[i];
+            if (!cas->quarantine &&
+                (cas->bad_streak >= MYNEWT_VAL(BLE_LL_CHAN_BAD_STREAK)) &&
+                ble_ll_chan_in_map(g_ble_ll_chan_host_map, i) &&
+                ((worst < 0) ||
+                 (cas->err_pct > g_ble_ll_chan_adapt[worst].err_pct))) {
+                worst = i;
+            }
+        }
+        if (worst < 0) {
+            break;
+        }
+
+        cas = &g_ble_ll_chan_adapt[worst];
+        cas->quarantine = MYNEWT_VAL(BLE_LL_CHAN_QUARANTINE);
+        cas->bad_streak = 0;
+        --used;
+        changed = 1;
+        STATS_INC(ble_ll_stats, chan_excluded);
+    }
+
+    if (changed) {
+        STATS_INC(ble_ll_stats, chan_map_adapt);
+        ble_ll_chan_apply();
+    }
+
+    /* Keep assessing while there are connections to gather statistics */
+    if (!SLIST_EMPTY(&g_ble_ll_conn_active_list)) {
+        os_callout_reset(&g_ble_ll_chan_assess_timer,
+                         BLE_LL_CHAN_ASSESS_TICKS);
+    }
+}
+
+/**
+ * Called when the host sets the channel map. Channels in quarantine stay
+ * excluded from the map actually used.
+ *
+ * Context: Link Layer task
+ *
+ * @param chanmap
+ */
+void
+ble_ll_chan_host_map_set(uint8_t *chanmap)
+{
+    memcpy(g_ble_ll_chan_host_map, chanmap, BLE_LL_CONN_CHMAP_LEN);
+    ble_ll_chan_apply();
+}
+
+/**
+ * Called when a connection is created; makes sure channel quality is being
+ * assessed.
+ *
+ * Context: Link Layer task
+ */
+void
+ble_ll_chan_conn_created(void)
+{
+    if (!os_callout_queued(&g_ble_ll_chan_assess_timer)) {
+        os_callout_reset(&g_ble_ll_chan_assess_timer,
+                         BLE_LL_CHAN_ASSESS_TICKS);
+    }
+}
+#endif
+
+/**
+ * HCI vendor command: read the counters of one data channel.
+ *
+ * Command parameters: channel index (1 byte).
+ * Return parameters: channel index (1 byte), flags (1 byte; bit 0 set if
+ * the channel is currently excluded from the channel map), then the CRC ok,
+ * CRC error, acknowledged and retransmitted PDU counts (4 bytes each).
+ *
+ * @param cmdbuf
+ * @param rspbuf
+ * @param rsplen
+ *
+ * @return int BLE error code
+ */
+int
+ble_ll_chan_hci_rd_stats(uint8_t *cmdbuf, uint8_t *rspbuf, uint8_t *rsplen)
+{
+    uint8_t chan;
+    struct ble_ll_chan_stats *cs;
+
+    chan = cmdbuf[0];
+    if (chan >= BLE_PHY_NUM_DATA_CHANS) {
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    cs = &g_ble_ll_chan_stats[chan];
+    rspbuf[0] = chan;
+#if MYNEWT_VAL(BLE_LL_CHAN_ADAPT)
+    rspbuf[1] = g_ble_ll_chan_adapt[chan].quarantine ? 1 : 0;
+#else
+    rspbuf[1] = 0;
+#endif
+    htole32(rspbuf + 2, cs->rx_crc_ok);
+    htole32(rspbuf + 6, cs->rx_crc_err);
+    htole32(rspbuf + 10, cs->tx_ack);
+    htole32(rspbuf + 14, cs->tx_retry);
+    *rsplen = BLE_HCI_VS_RD_CHAN_STATS_RSPLEN;
+
+    return BLE_ERR_SUCCESS;
+}
+
+/**
+ * HCI vendor command: read the channel map requested by the host and the
+ * one actually used by master connections (5 bytes each).
+ *
+ * @param rspbuf
+ * @param rsplen
+ *
+ * @return int BLE error code
+ */
+int
+ble_ll_chan_hci_rd_map(uint8_t *rspbuf, uint8_t *rsplen)
+{
+#if MYNEWT_VAL(BLE_LL_CHAN_ADAPT)
+    memcpy(rspbuf, g_ble_ll_chan_host_map, BLE_LL_CONN_CHMAP_LEN);
+#else
+    memcpy(rspbuf, g_ble_ll_conn_params.master_chan_map,
+           BLE_LL_CONN_CHMAP_LEN);
+#endif
+    memcpy(rspbuf + BLE_LL_CONN_CHMAP_LEN,
+           g_ble_ll_conn_params.master_chan_map, BLE_LL_CONN_CHMAP_LEN);
+    *rsplen = BLE_HCI_VS_RD_CHAN_MAP_RSPLEN;
+
+    return BLE_ERR_SUCCESS;
+}
+
+/**
+ * HCI vendor command: clear the channel counters. Channels in quarantine
+ * stay excluded until their quarantine expires.
+ *
+ * @return int BLE error code
+ */
+int
+ble_ll_chan_hci_clr_stats(void)
+{
+#if MYNEWT_VAL(BLE_LL_CHAN_ADAPT)
+    int i;
+#endif
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    memset(g_ble_ll_chan_stats, 0, sizeof(g_ble_ll_chan_stats));
+    OS_EXIT_CRITICAL(sr);
+
+#if MYNEWT_VAL(BLE_LL_CHAN_ADAPT)
+    for (i = 0; i < BLE_PHY_NUM_DATA_CHANS; ++i) {
+        g_ble_ll_chan_adapt[i].last_err = 0;
+        g_ble_ll_chan_adapt[i].last_total = 0;
+    }
+#endif
+
+    return BLE_ERR_SUCCESS;
+}
+
+/**
+ * Called to reset the channel statistics and the adaptive channel map. The
+ * connection module must have been reset first.
+ *
+ * Context: Link Layer task
+ */
+void
+ble_ll_chan_reset(void)
+{
+    memset(g_ble_ll_chan_stats, 0, sizeof(g_ble_ll_chan_stats));
+
+#if MYNEWT_VAL(BLE_LL_CHAN_ADAPT)
+    os_callout_stop(&g_ble_ll_chan_assess_timer);
+    memset(g_ble_ll_chan_adapt, 0, sizeof(g_ble_ll_chan_adapt));
+    memcpy(g_ble_ll_chan_host_map, g_ble_ll_conn_params.master_chan_map,
+           BLE_LL_CONN_CHMAP_LEN);
+#endif
+}
+
+/**
+ * Initialize the channel statistics module. Called once at startup, after
+ * the connection module has been initialized.
+ */
+void
+ble_ll_chan_init(void)
+{
+#if MYNEWT_VAL(BLE_LL_CHAN_ADAPT)
+    os_callout_init(&g_ble_ll_chan_assess_timer, &g_ble_ll_data.ll_evq,
+                    ble_ll_chan_assess, NULL);
+#endif
+
+    ble_ll_chan_reset();
+}
+
+#endif
@@ -36,6 +36,7 @@
 #include "controller/ble_ll_sched.h"
 #include "controller/ble_ll_ctrl.h"
 #include "controller/ble_ll_resolv.h"
+#include "controller/ble_ll_chan.h"
 #include "controller/ble_ll_adv.h"
 #include "controller/ble_phy.h"
 #include "controller/ble_hw.h"
@@ -117,6 +118,22 @@ extern void bletest_completed_pkt(uint16_t handle);
  */
 #define BLE_LL_WFR_USECS                    (BLE_LL_IFS + 40 + 32)
 
+/*
+ * Transmit header flag set on the last host packet of an l2cap pdu. Priority
+ * data is only allowed to go out between l2cap pdus of the bulk queue.
+ */
+#define BLE_LL_CONN_TXF_L2CAP_END           (0x01)
+
+/*
+ * L2CAP/ATT fields the controller peeks at to classify host data. Only
+ * complete, single packet ATT PDUs of these types are prioritized.
+ */
+#define BLE_LL_CONN_L2CAP_HDR_LEN           (4)
+#define BLE_LL_CONN_L2CAP_CID_ATT           (0x0004)
+#define BLE_LL_CONN_ATT_OP_NOTIFY           (0x1b)
+#define BLE_LL_CONN_ATT_OP_INDICATE         (0x1d)
+#define BLE_LL_CONN_ATT_OP_CONFIRM          (0x1e)
+
 /* This is a dummy structure we use for the empty PDU */
 struct ble_ll_empty_pdu
 {
@@ -184,6 +201,10 @@ STATS_SECT_START(ble_ll_conn_stats)
     STATS_SECT_ENTRY(tx_l2cap_bytes)
     STATS_SECT_ENTRY(tx_empty_pdus)
     STATS_SECT_ENTRY(mic_failures)
+    STATS_SECT_ENTRY(conn_ev_skipped)
+    STATS_SECT_ENTRY(conn_events)
+    STATS_SECT_ENTRY(conn_ev_pdus)
+    STATS_SECT_ENTRY(conn_ev_extended)
 STATS_SECT_END
 STATS_SECT_DECL(ble_ll_conn_stats) ble_ll_conn_stats;
 
@@ -214,6 +235,10 @@ STATS_NAME_START(ble_ll_conn_stats)
     STATS_NAME(ble_ll_conn_stats, tx_l2cap_bytes)
     STATS_NAME(ble_ll_conn_stats, tx_empty_pdus)
     STATS_NAME(ble_ll_conn_stats, mic_failures)
+    STATS_NAME(ble_ll_conn_stats, conn_ev_skipped)
+    STATS_NAME(ble_ll_conn_stats, conn_events)
+    STATS_NAME(ble_ll_conn_stats, conn_ev_pdus)
+    STATS_NAME(ble_ll_conn_stats, conn_ev_extended)
 STATS_NAME_END(ble_ll_conn_stats)
 
 static void ble_ll_conn_spvn_timeout(struct os_event *ev);
@@ -237,7 +262,7 @@ ble_ll_init_get_conn_comp_ev(void)
     return evbuf;
 }
 
-#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_ENCRYPTION)
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_ENCRYPTION) || MYNEWT_VAL(BLE_LL_CONN_PERF)
 /**
  * Called to determine if the received PDU is an empty PDU or not.
  */
@@ -762,6 +787,241 @@ ble_ll_conn_chk_csm_flags(struct ble_ll_conn_sm *connsm)
     }
 }
 
+/**
+ * Returns the transmit queue the next packet for the connection should be
+ * taken from. LL control PDUs always go first. Priority data is allowed to
+ * pass bulk data only at l2cap pdu boundaries since fragments of different
+ * l2cap pdus cannot be interleaved on the link.
+ *
+ * Context: Any (interrupts disabled or interrupt context)
+ *
+ * @param connsm
+ *
+ * @return int The queue index, or -1 if nothing can be sent.
+ */
+static int
+ble_ll_conn_txq_next(struct ble_ll_conn_sm *connsm)
+{
+    if (!STAILQ_EMPTY(&connsm->conn_txq[BLE_LL_CONN_TXQ_CTRL])) {
+        return BLE_LL_CONN_TXQ_CTRL;
+    }
+
+    if (!connsm->txq_bulk_mid_pdu &&
+        !STAILQ_EMPTY(&connsm->conn_txq[BLE_LL_CONN_TXQ_PRIO])) {
+        return BLE_LL_CONN_TXQ_PRIO;
+    }
+
+    if (!STAILQ_EMPTY(&connsm->conn_txq[BLE_LL_CONN_TXQ_BULK])) {
+        return BLE_LL_CONN_TXQ_BULK;
+    }
+
+    return -1;
+}
+
+/**
+ * Returns the packet that will be transmitted next on the connection (not
+ * counting the current transmit pdu) or NULL if there is none.
+ *
+ * @param connsm
+ *
+ * @return struct os_mbuf_pkthdr*
+ */
+static struct os_mbuf_pkthdr *
+ble_ll_conn_txq_first(struct ble_ll_conn_sm *connsm)
+{
+    int q;
+
+    q = ble_ll_conn_txq_next(connsm);
+    if (q < 0) {
+        return NULL;
+    }
+    return STAILQ_FIRST(&connsm->conn_txq[q]);
+}
+
+/**
+ * Returns true if there are no packets enqueued on any of the connection
+ * transmit queues.
+ *
+ * @param connsm
+ *
+ * @return int
+ */
+int
+ble_ll_conn_txq_empty(struct ble_ll_conn_sm *connsm)
+{
+    int i;
+
+    for (i = 0; i < BLE_LL_CONN_TXQ_NUM; ++i) {
+        if (!STAILQ_EMPTY(&connsm->conn_txq[i])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Removes the packet at the head of a connection transmit queue and updates
+ * the queueing delay statistics of its priority class.
+ *
+ * Context: Interrupt
+ *
+ * @param connsm
+ * @param q         The queue to remove from
+ *
+ * @return struct os_mbuf* The removed packet
+ */
+static struct os_mbuf *
+ble_ll_conn_txq_remove(struct ble_ll_conn_sm *connsm, int q)
+{
+    uint32_t delay;
+    struct os_mbuf *m;
+    struct os_mbuf_pkthdr *pkthdr;
+    struct ble_mbuf_hdr *ble_hdr;
+    struct ble_ll_conn_txq_stats *stats;
+
+    pkthdr = STAILQ_FIRST(&connsm->conn_txq[q]);
+    STAILQ_REMOVE_HEAD(&connsm->conn_txq[q], omp_next);
+    m = OS_MBUF_PKTHDR_TO_MBUF(pkthdr);
+    ble_hdr = BLE_MBUF_HDR_PTR(m);
+
+    if (q == BLE_LL_CONN_TXQ_BULK) {
+        connsm->txq_bulk_mid_pdu =
+            !(ble_hdr->txinfo.flags & BLE_LL_CONN_TXF_L2CAP_END);
+    }
+
+    /* NOTE: the enqueue time is kept in the (unused on tx) start time */
+    delay = os_cputime_ticks_to_usecs(os_cputime_get32() -
+                                      ble_hdr->beg_cputime);
+    stats = &connsm->txq_stats[q];
+    ++stats->pkts;
+    stats->delay_sum += delay;
+    if (delay > stats->delay_max) {
+        stats->delay_max = delay;
+    }
+
+    return m;
+}
+
+#if MYNEWT_VAL(BLE_LL_CONN_PERF)
+/**
+ * Called when the last fragment of an ACL packet has been acknowledged.
+ * Accounts for the time the packet spent in the controller.
+ *
+ * Context: Interrupt
+ *
+ * @param connsm
+ * @param txhdr
+ */
+static void
+ble_ll_conn_perf_tx_done(struct ble_ll_conn_sm *connsm,
+                         struct ble_mbuf_hdr *txhdr)
+{
+    uint32_t lat;
+
+    /* The enqueue time is still in the start time; see txq_remove() */
+    lat = os_cputime_ticks_to_usecs(os_cputime_get32() - txhdr->beg_cputime);
+    ++connsm->perf.tx_pkts;
+    connsm->perf.tx_lat_sum += lat;
+    if (lat > connsm->perf.tx_lat_max) {
+        connsm->perf.tx_lat_max = lat;
+    }
+}
+
+/**
+ * Folds the RSSI of a received data PDU into the connection's running
+ * average (weight 1/16).
+ *
+ * @param connsm
+ * @param rssi
+ */
+static void
+ble_ll_conn_perf_rssi(struct ble_ll_conn_sm *connsm, int8_t rssi)
+{
+    int16_t avg;
+
+    avg = connsm->perf.rssi_avg;
+    if (avg == BLE_LL_CONN_UNKNOWN_RSSI * 16) {
+        avg = rssi * 16;
+    } else {
+        avg += rssi - avg / 16;
+    }
+    connsm->perf.rssi_avg = avg;
+}
+#endif
+
+/**
+ * Determines which transmit queue a packet belongs on. For host data, this
+ * also keeps track of l2cap pdu boundaries and marks the last packet of each
+ * l2cap pdu.
+ *
+ * Context: Link Layer task
+ *
+ * @param connsm
+ * @param om
+ * @param hdr_byte
+ * @param length
+ *
+ * @return int The queue index
+ */
+static int
+ble_ll_conn_txq_classify(struct ble_ll_conn_sm *connsm, struct os_mbuf *om,
+                         uint8_t hdr_byte, uint8_t length)
+{
+    int q;
+    uint8_t llid;
+    uint8_t l2hdr[BLE_LL_CONN_L2CAP_HDR_LEN + 1];
+    uint16_t cid;
+    uint32_t l2len;
+    struct ble_mbuf_hdr *ble_hdr;
+
+    llid = hdr_byte & BLE_LL_DATA_HDR_LLID_MASK;
+    if (llid == BLE_LL_LLID_CTRL) {
+        return BLE_LL_CONN_TXQ_CTRL;
+    }
+
+    q = BLE_LL_CONN_TXQ_BULK;
+    if (llid == BLE_LL_LLID_DATA_START) {
+        /*
+         * A new l2cap pdu. If the previous one was not finished, the host
+         * abandoned it; we just start tracking the new one.
+         */
+        connsm->txq_l2cap_rem = 0;
+        if (length >= BLE_LL_CONN_L2CAP_HDR_LEN) {
+            memset(l2hdr, 0, sizeof l2hdr);
+            os_mbuf_copydata(om, 0, min(length, sizeof l2hdr), l2hdr);
+            l2len = le16toh(l2hdr) + BLE_LL_CONN_L2CAP_HDR_LEN;
+            cid = le16toh(l2hdr + 2);
+            if (l2len > length) {
+                connsm->txq_l2cap_rem = l2len - length;
+            } else if ((cid == BLE_LL_CONN_L2CAP_CID_ATT) &&
+                       (length > BLE_LL_CONN_L2CAP_HDR_LEN)) {
+                switch (l2hdr[BLE_LL_CONN_L2CAP_HDR_LEN]) {
+                case BLE_LL_CONN_ATT_OP_NOTIFY:
+                case BLE_LL_CONN_ATT_OP_INDICATE:
+                case BLE_LL_CONN_ATT_OP_CONFIRM:
+                    q = BLE_LL_CONN_TXQ_PRIO;
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+    } else {
+        if (connsm->txq_l2cap_rem > length) {
+            connsm->txq_l2cap_rem -= length;
+        } else {
+            connsm->txq_l2cap_rem = 0;
+        }
+    }
+
+    if (connsm->txq_l2cap_rem == 0) {
+        ble_hdr = BLE_MBUF_HDR_PTR(om);
+        ble_hdr->txinfo.flags |= BLE_LL_CONN_TXF_L2CAP_END;
+    }
+
+    return q;
+}
+
 /**
  * Called when we want to send a data channel pdu inside a connection event.
  *
@@ -775,6 +1035,7 @@ static int
 ble_ll_conn_tx_data_pdu(struct ble_ll_conn_sm *connsm)
 {
     int rc;
+    int txq;
     uint8_t md;
     uint8_t hdr_byte;
     uint8_t end_transition;
@@ -801,7 +1062,8 @@ ble_ll_conn_tx_data_pdu(struct ble_ll_conn_sm *connsm)
      * We need to check if we are retrying a pdu or if there is a pdu on
      * the transmit queue.
      */
-    pkthdr = STAILQ_FIRST(&connsm->conn_txq);
+    txq = ble_ll_conn_txq_next(connsm);
+    pkthdr = (txq < 0) ? NULL : STAILQ_FIRST(&connsm->conn_txq[txq]);
     if (!connsm->cur_tx_pdu && !CONN_F_EMPTY_PDU_TXD(connsm) && !pkthdr) {
         CONN_F_EMPTY_PDU_TXD(connsm) = 1;
         goto conn_tx_pdu;
@@ -813,21 +1075,24 @@ ble_ll_conn_tx_data_pdu(struct ble_ll_conn_sm *connsm)
      */
     cur_offset = 0;
     if (!connsm->cur_tx_pdu && !CONN_F_EMPTY_PDU_TXD(connsm)) {
-        /* Convert packet header to mbuf */
-        m = OS_MBUF_PKTHDR_TO_MBUF(pkthdr);
-        nextpkthdr = STAILQ_NEXT(pkthdr, omp_next);
-
 #if MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_ENCRYPTION)
         /*
          * If we are encrypting, we are only allowed to send certain
          * kinds of LL control PDU's. If none is enqueued, send empty pdu!
          */
-        if (connsm->enc_data.enc_state > CONN_ENC_S_ENCRYPTED) {
-            if (!ble_ll_ctrl_enc_allowed_pdu(pkthdr)) {
-                CONN_F_EMPTY_PDU_TXD(connsm) = 1;
-                goto conn_tx_pdu;
-            }
+        if ((connsm->enc_data.enc_state > CONN_ENC_S_ENCRYPTED) &&
+            !ble_ll_ctrl_enc_allowed_pdu(pkthdr)) {
+            CONN_F_EMPTY_PDU_TXD(connsm) = 1;
+            goto conn_tx_pdu;
+        }
+#endif
 
+        /* Take packet off queue*/
+        m = ble_ll_conn_txq_remove(connsm, txq);
+        nextpkthdr = ble_ll_conn_txq_first(connsm);
+
+#if MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_ENCRYPTION)
+        if (connsm->enc_data.enc_state > CONN_ENC_S_ENCRYPTED) {
             /*
              * We will allow a next packet if it itself is allowed or we are
              * a slave and we are sending the START_ENC_RSP. The master has
@@ -841,8 +1106,6 @@ ble_ll_conn_tx_data_pdu(struct ble_ll_conn_sm *connsm)
             }
         }
 #endif
-        /* Take packet off queue*/
-        STAILQ_REMOVE_HEAD(&connsm->conn_txq, omp_next);
         ble_hdr = BLE_MBUF_HDR_PTR(m);
 
         /* Determine packet length we will transmit */
@@ -1228,9 +1491,75 @@ ble_ll_conn_event_start_cb(struct ble_ll_sched_item *sch)
 
     /* Set time that we last serviced the schedule */
     connsm->last_scheduled = os_cputime_get32();
+    connsm->sched_skips = 0;
     return rc;
 }
 
+/**
+ * Called when a connection event will not take place because the scheduler
+ * could not fit it in or gave its time to another schedule item.
+ *
+ * Context: Link Layer task or interrupt (scheduler)
+ *
+ * @param connsm
+ */
+void
+ble_ll_conn_sched_skipped(struct ble_ll_conn_sm *connsm)
+{
+    if (connsm->sched_skips != UINT16_MAX) {
+        ++connsm->sched_skips;
+    }
+    ++connsm->events_skipped;
+    STATS_INC(ble_ll_conn_stats, conn_ev_skipped);
+}
+
+#if (MYNEWT_VAL(BLE_LL_CONN_ADAPTIVE_CE) == 1)
+/**
+ * Adjust the number of slots reserved for the next connection event. If
+ * either side still had data to send when the event ended, the reservation
+ * is doubled (up to the configured maximum and one slot less than the
+ * connection interval); otherwise it is halved back towards the initial
+ * reservation.
+ *
+ * Context: Link Layer task
+ *
+ * @param connsm
+ */
+static void
+ble_ll_conn_ce_adapt(struct ble_ll_conn_sm *connsm)
+{
+    int more_data;
+    uint16_t max_slots;
+    uint16_t slots;
+
+    more_data = (connsm->cur_tx_pdu != NULL) ||
+                !ble_ll_conn_txq_empty(connsm) ||
+                (connsm->last_rxd_hdr_byte & BLE_LL_DATA_HDR_MD_MASK);
+
+    max_slots = MYNEWT_VAL(BLE_LL_CONN_MAX_CE_SLOTS);
+    if (max_slots >= connsm->conn_itvl) {
+        max_slots = connsm->conn_itvl - 1;
+    }
+    if (max_slots < MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS)) {
+        max_slots = MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS);
+    }
+
+    slots = connsm->ce_slots;
+    if (more_data) {
+        slots *= 2;
+        if (slots > max_slots) {
+            slots = max_slots;
+        }
+    } else {
+        slots /= 2;
+        if (slots < MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS)) {
+            slots = MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS);
+        }
+    }
+    connsm->ce_slots = slots;
+}
+#endif
+
 /**
  * Called to determine if the device is allowed to send the next pdu in the
  * connection event. This will always return 'true' if we are a slave. If we
@@ -1262,7 +1591,7 @@ ble_ll_conn_can_send_next_pdu(struct ble_ll_conn_sm *connsm, uint32_t begtime)
 
         txpdu = connsm->cur_tx_pdu;
         if (!txpdu) {
-            pkthdr = STAILQ_FIRST(&connsm->conn_txq);
+            pkthdr = ble_ll_conn_txq_first(connsm);
             if (pkthdr) {
                 txpdu = OS_MBUF_PKTHDR_TO_MBUF(pkthdr);
             }
@@ -1424,6 +1753,7 @@ ble_ll_conn_master_init(struct ble_ll_conn_sm *connsm,
 void
 ble_ll_conn_sm_new(struct ble_ll_conn_sm *connsm)
 {
+    int i;
     struct ble_ll_conn_global_params *conn_params;
 
     /* Reset following elements */
@@ -1438,6 +1768,10 @@ ble_ll_conn_sm_new(struct ble_ll_conn_sm *connsm)
     connsm->reject_reason = BLE_ERR_SUCCESS;
     connsm->conn_rssi = BLE_LL_CONN_UNKNOWN_RSSI;
     connsm->rpa_index = -1;
+    connsm->sched_skips = 0;
+    connsm->events_skipped = 0;
+    connsm->ce_slots = MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS);
+    connsm->ce_pdus = 0;
 
     /* Reset current control procedure */
     connsm->cur_ctrl_proc = BLE_LL_CTRL_PROC_IDLE;
@@ -1469,7 +1803,16 @@ ble_ll_conn_sm_new(struct ble_ll_conn_sm *connsm)
     connsm->conn_ev_end.ev_cb = ble_ll_conn_event_end;
 
     /* Initialize transmit queue and ack/flow control elements */
-    STAILQ_INIT(&connsm->conn_txq);
+    for (i = 0; i < BLE_LL_CONN_TXQ_NUM; ++i) {
+        STAILQ_INIT(&connsm->conn_txq[i]);
+    }
+    connsm->txq_l2cap_rem = 0;
+    connsm->txq_bulk_mid_pdu = 0;
+    memset(connsm->txq_stats, 0, sizeof(connsm->txq_stats));
+#if MYNEWT_VAL(BLE_LL_CONN_PERF)
+    memset(&connsm->perf, 0, sizeof(connsm->perf));
+    connsm->perf.rssi_avg = BLE_LL_CONN_UNKNOWN_RSSI * 16;
+#endif
     connsm->cur_tx_pdu = NULL;
     connsm->tx_seqnum = 0;
     connsm->next_exp_seqnum = 0;
@@ -1574,6 +1917,7 @@ ble_ll_conn_datalen_update(struct ble_ll_conn_sm *connsm,
 void
 ble_ll_conn_end(struct ble_ll_conn_sm *connsm, uint8_t ble_err)
 {
+    int i;
     uint8_t *evbuf;
     struct os_mbuf *m;
     struct os_mbuf_pkthdr *pkthdr;
@@ -1600,17 +1944,19 @@ ble_ll_conn_end(struct ble_ll_conn_sm *connsm, uint8_t ble_err)
         connsm->cur_tx_pdu = NULL;
     }
 
-    /* Free all packets on transmit queue */
-    while (1) {
-        /* Get mbuf pointer from packet header pointer */
-        pkthdr = STAILQ_FIRST(&connsm->conn_txq);
-        if (!pkthdr) {
-            break;
-        }
-        STAILQ_REMOVE_HEAD(&connsm->conn_txq, omp_next);
+    /* Free all packets on the transmit queues */
+    for (i = 0; i < BLE_LL_CONN_TXQ_NUM; ++i) {
+        while (1) {
+            /* Get mbuf pointer from packet header pointer */
+            pkthdr = STAILQ_FIRST(&connsm->conn_txq[i]);
+            if (!pkthdr) {
+                break;
+            }
+            STAILQ_REMOVE_HEAD(&connsm->conn_txq[i], omp_next);
 
-        m = (struct os_mbuf *)((uint8_t *)pkthdr - sizeof(struct os_mbuf));
-        os_mbuf_free_chain(m);
+            m = (struct os_mbuf *)((uint8_t *)pkthdr - sizeof(struct os_mbuf));
+            os_mbuf_free_chain(m);
+        }
     }
 
     /* Make sure events off queue */
@@ -1770,7 +2116,7 @@ ble_ll_conn_next_event(struct ble_ll_conn_sm *connsm)
      * Calculate ce end time. For a slave, we need to add window widening and
      * the transmit window if we still have one.
      */
-    itvl = MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS) * BLE_LL_SCHED_USECS_PER_SLOT;
+    itvl = connsm->ce_slots * BLE_LL_SCHED_USECS_PER_SLOT;
     if (connsm->conn_role == BLE_LL_CONN_ROLE_SLAVE) {
         cur_ww = ble_ll_conn_calc_window_widening(connsm);
         max_ww = (connsm->conn_itvl * (BLE_LL_CONN_ITVL_USECS/2)) - BLE_LL_IFS;
@@ -1813,6 +2159,11 @@ ble_ll_conn_created(struct ble_ll_conn_sm *connsm, uint32_t endtime)
     /* Set state to created */
     connsm->conn_state = BLE_LL_CONN_STATE_CREATED;
 
+#if MYNEWT_VAL(BLE_LL_CHAN_ADAPT)
+    /* Start assessing channel quality if not already doing so */
+    ble_ll_chan_conn_created();
+#endif
+
     /* Set supervision timeout */
     usecs = connsm->conn_itvl * BLE_LL_CONN_ITVL_USECS * 6;
     os_cputime_timer_relative(&connsm->conn_spvn_timer, usecs);
@@ -1929,6 +2280,19 @@ ble_ll_conn_event_end(struct os_event *ev)
         connsm->slave_cur_tx_win_usecs = 0;
     }
 
+    /* Account for the pdus exchanged in the event that just ended */
+    STATS_INC(ble_ll_conn_stats, conn_events);
+    BLE_LL_CONN_PERF_INC(connsm, events);
+    STATS_INCN(ble_ll_conn_stats, conn_ev_pdus, connsm->ce_pdus);
+    connsm->ce_pdus = 0;
+
+#if (MYNEWT_VAL(BLE_LL_CONN_ADAPTIVE_CE) == 1)
+    ble_ll_conn_ce_adapt(connsm);
+    if (connsm->ce_slots > MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS)) {
+        STATS_INC(ble_ll_conn_stats, conn_ev_extended);
+    }
+#endif
+
 #if MYNEWT_VAL(BLE_LL_CFG_FEAT_LE_PING)
     /*
      * If we are encrypted and have passed the authenticated payload timeout
@@ -1964,6 +2328,20 @@ ble_ll_conn_event_end(struct os_event *ev)
        we may want to force the first event to be scheduled. Not sure */
     /* Schedule the next connection event */
     while (ble_ll_sched_conn_reschedule(connsm)) {
+#if (MYNEWT_VAL(BLE_LL_CONN_ADAPTIVE_CE) == 1)
+        /*
+         * Rather than lose the event, retry with the initial reservation
+         * if an extended one does not fit.
+         */
+        if (connsm->ce_slots > MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS)) {
+            connsm->ce_end_time -= os_cputime_usecs_to_ticks(
+                (connsm->ce_slots - MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS)) *
+                BLE_LL_SCHED_USECS_PER_SLOT);
+            connsm->ce_slots = MYNEWT_VAL(BLE_LL_CONN_INIT_SLOTS);
+            continue;
+        }
+#endif
+        ble_ll_conn_sched_skipped(connsm);
         if (ble_ll_conn_next_event(connsm)) {
             ble_ll_conn_end(connsm, BLE_ERR_CONN_TERM_LOCAL);
             return;
@@ -2331,7 +2709,7 @@ ble_ll_init_rx_isr_end(uint8_t *rxbuf, uint8_t crcok,
 
 #if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY)
         if (ble_ll_is_rpa(adv_addr, addr_type) && ble_ll_resolv_enabled()) {
-            index = ble_hw_resolv_list_match();
+            index = ble_ll_resolv_list_match(adv_addr);
             if (index >= 0) {
                 ble_hdr->rxinfo.flags |= BLE_MBUF_HDR_F_RESOLVED;
                 connsm->rpa_index = index;
@@ -2567,6 +2945,9 @@ ble_ll_conn_rx_data_pdu(struct os_mbuf *rxpdu, struct ble_mbuf_hdr *hdr)
 
             /* Update RSSI */
             connsm->conn_rssi = hdr->rxinfo.rssi;
+#if MYNEWT_VAL(BLE_LL_CONN_PERF)
+            ble_ll_conn_perf_rssi(connsm, hdr->rxinfo.rssi);
+#endif
 
             /*
              * If we are a slave, we can only start to use slave latency
@@ -2709,6 +3090,8 @@ ble_ll_conn_rx_isr_end(uint8_t *rxbuf, struct ble_mbuf_hdr *rxhdr)
          * one we will end the connection event.
          */
         ++connsm->cons_rxd_bad_crc;
+        BLE_LL_CHAN_STATS_INC(connsm->data_chan_index, rx_crc_err);
+        BLE_LL_CONN_PERF_INC(connsm, rx_crc_err);
         if (connsm->cons_rxd_bad_crc >= 2) {
             reply = 0;
         } else {
@@ -2722,6 +3105,14 @@ ble_ll_conn_rx_isr_end(uint8_t *rxbuf, struct ble_mbuf_hdr *rxhdr)
     } else {
         /* Reset consecutively received bad crcs (since this one was good!) */
         connsm->cons_rxd_bad_crc = 0;
+        BLE_LL_CHAN_STATS_INC(connsm->data_chan_index, rx_crc_ok);
+        BLE_LL_CONN_PERF_INC(connsm, rx_ok);
+        if (ble_ll_conn_is_empty_pdu(rxbuf)) {
+            BLE_LL_CONN_PERF_INC(connsm, rx_empty);
+        }
+        if (connsm->ce_pdus != UINT8_MAX) {
+            ++connsm->ce_pdus;
+        }
 
         /*
          * Check for valid LLID before proceeding. We have seen some weird
@@ -2772,14 +3163,19 @@ ble_ll_conn_rx_isr_end(uint8_t *rxbuf, struct ble_mbuf_hdr *rxhdr)
             if ((hdr_nesn && conn_sn) || (!hdr_nesn && !conn_sn)) {
                 /* We did not get an ACK. Must retry the PDU */
                 STATS_INC(ble_ll_conn_stats, data_pdu_txf);
+                BLE_LL_CHAN_STATS_INC(connsm->data_chan_index, tx_retry);
+                BLE_LL_CONN_PERF_INC(connsm, tx_retry);
             } else {
                 /* Transmit success */
                 connsm->tx_seqnum ^= 1;
                 STATS_INC(ble_ll_conn_stats, data_pdu_txg);
+                BLE_LL_CHAN_STATS_INC(connsm->data_chan_index, tx_ack);
+                BLE_LL_CONN_PERF_INC(connsm, tx_ack);
 
                 /* If we transmitted the empty pdu, clear flag */
                 if (CONN_F_EMPTY_PDU_TXD(connsm)) {
                     CONN_F_EMPTY_PDU_TXD(connsm) = 0;
+                    BLE_LL_CONN_PERF_INC(connsm, tx_empty);
                     goto chk_rx_terminate_ind;
                 }
 
@@ -2817,6 +3213,9 @@ ble_ll_conn_rx_isr_end(uint8_t *rxbuf, struct ble_mbuf_hdr *rxhdr)
                             bletest_completed_pkt(connsm->conn_handle);
 #endif
                             ++connsm->completed_pkts;
+#if MYNEWT_VAL(BLE_LL_CONN_PERF)
+                            ble_ll_conn_perf_tx_done(connsm, txhdr);
+#endif
                         }
                         os_mbuf_free_chain(txpdu);
                         connsm->cur_tx_pdu = NULL;
@@ -2902,6 +3301,7 @@ ble_ll_conn_enqueue_pkt(struct ble_ll_conn_sm *connsm, struct os_mbuf *om,
     struct os_mbuf_pkthdr *pkthdr;
     struct ble_mbuf_hdr *ble_hdr;
     int lifo;
+    int txq;
 
     /* Set mbuf length and packet length if a control PDU */
     if (hdr_byte == BLE_LL_LLID_CTRL) {
@@ -2915,6 +3315,7 @@ ble_ll_conn_enqueue_pkt(struct ble_ll_conn_sm *connsm, struct os_mbuf *om,
     ble_hdr->txinfo.offset = 0;
     ble_hdr->txinfo.pyld_len = length;
     ble_hdr->txinfo.hdr_byte = hdr_byte;
+    ble_hdr->beg_cputime = os_cputime_get32();
 
     /*
      * We need to set the initial payload length if the total length of the
@@ -2955,13 +3356,14 @@ ble_ll_conn_enqueue_pkt(struct ble_ll_conn_sm *connsm, struct os_mbuf *om,
     }
 #endif
 
-    /* Add to transmit queue for the connection */
+    /* Add to the transmit queue of its priority class */
+    txq = ble_ll_conn_txq_classify(connsm, om, hdr_byte, length);
     pkthdr = OS_MBUF_PKTHDR(om);
     OS_ENTER_CRITICAL(sr);
     if (lifo) {
-        STAILQ_INSERT_HEAD(&connsm->conn_txq, pkthdr, omp_next);
+        STAILQ_INSERT_HEAD(&connsm->conn_txq[txq], pkthdr, omp_next);
     } else {
-        STAILQ_INSERT_TAIL(&connsm->conn_txq, pkthdr, omp_next);
+        STAILQ_INSERT_TAIL(&connsm->conn_txq[txq], pkthdr, omp_next);
     }
     OS_EXIT_CRITICAL(sr);
 }
@@ -3017,6 +3419,23 @@ ble_ll_conn_tx_pkt_in(struct os_mbuf *om, uint16_t handle, uint16_t length)
  */
 void
 ble_ll_conn_set_global_chanmap(uint8_t num_used_chans, uint8_t *chanmap)
+{
+#if MYNEWT_VAL(BLE_LL_CHAN_ADAPT)
+    /* Channels found to be bad stay excluded from the host's map */
+    ble_ll_chan_host_map_set(chanmap);
+#else
+    ble_ll_conn_master_chanmap_set(chanmap);
+#endif
+}
+
+/**
+ * Called to set the channel map used by master connections. Starts a channel
+ * map update procedure on each of them if the map changed.
+ *
+ * @param chanmap
+ */
+void
+ble_ll_conn_master_chanmap_set(uint8_t *chanmap)
 {
     struct ble_ll_conn_sm *connsm;
     struct ble_ll_conn_global_params *conn_params;
@@ -3028,7 +3447,7 @@ ble_ll_conn_set_global_chanmap(uint8_t num_used_chans, uint8_t *chanmap)
     }
 
     /* Change channel map and cause channel map update procedure to start */
-    conn_params->num_used_chans = num_used_chans;
+    conn_params->num_used_chans = ble_ll_conn_calc_used_chans(chanmap);
     memcpy(conn_params->master_chan_map, chanmap, BLE_LL_CONN_CHMAP_LEN);
 
     /* Perform channel map update */
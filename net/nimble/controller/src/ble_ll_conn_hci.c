@@ -34,6 +34,9 @@
 #include "controller/ble_ll_scan.h"
 #include "controller/ble_ll_adv.h"
 #include "ble_ll_conn_priv.h"
+#if MYNEWT_VAL(BLE_HCI_RAM_DIRECT)
+#include "transport/ram/ble_hci_ram.h"
+#endif
 
 /*
  * Used to limit the rate at which we send the number of completed packets
@@ -252,6 +255,18 @@ ble_ll_conn_num_comp_pkts_event_send(struct ble_ll_conn_sm *connsm)
     uint8_t *comp_pkt_ptr;
     uint8_t handles;
 
+#if MYNEWT_VAL(BLE_HCI_RAM_DIRECT)
+    /*
+     * In a combined build the host can take the count directly; there is
+     * then no need for events or the periodic sweep below.
+     */
+    if (ble_hci_ram_ll_num_comp_pkts(connsm->conn_handle,
+                                     connsm->completed_pkts) == 0) {
+        connsm->completed_pkts = 0;
+        return;
+    }
+#endif
+
     /*
      * At some periodic rate, make sure we go through all active connections
      * and send the number of completed packet events. We do this mainly
@@ -293,7 +308,7 @@ ble_ll_conn_num_comp_pkts_event_send(struct ble_ll_conn_sm *connsm)
          * event and that either has packets enqueued or has completed packets.
          */
         if ((connsm->conn_state != BLE_LL_CONN_STATE_IDLE) &&
-            (connsm->completed_pkts || !STAILQ_EMPTY(&connsm->conn_txq))) {
+            (connsm->completed_pkts || !ble_ll_conn_txq_empty(connsm))) {
             /* If no buffer, get one, If cant get one, leave. */
             if (!evbuf) {
                 evbuf = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_EVT_HI);
@@ -916,6 +931,78 @@ ble_ll_conn_hci_rd_rssi(uint8_t *cmdbuf, uint8_t *rspbuf, uint8_t *rsplen)
     return rc;
 }
 
+#if MYNEWT_VAL(BLE_LL_CONN_PERF)
+/**
+ * HCI vendor command: read the link statistics of a connection, and
+ * optionally clear them.
+ *
+ * The response holds the connection handle, the last and average RSSI
+ * (1 byte each), then the connection events run, connection events
+ * skipped, PDUs received with a good CRC, PDUs received with a CRC error,
+ * empty PDUs received, PDUs acknowledged, PDUs retransmitted, empty PDUs
+ * acknowledged, ACL packets completed, and the average and maximum time in
+ * usecs from ACL enqueue to acknowledgement (4 bytes each).
+ *
+ * @param cmdbuf
+ * @param rspbuf
+ * @param rsplen
+ *
+ * @return int BLE error code
+ */
+int
+ble_ll_conn_hci_rd_perf(uint8_t *cmdbuf, uint8_t *rspbuf, uint8_t *rsplen)
+{
+    os_sr_t sr;
+    uint16_t handle;
+    struct ble_ll_conn_perf perf;
+    struct ble_ll_conn_sm *connsm;
+    uint32_t skipped;
+    int8_t rssi;
+
+    handle = le16toh(cmdbuf);
+    htole16(rspbuf, handle);
+    *rsplen = sizeof(uint16_t);
+
+    connsm = ble_ll_conn_find_active_conn(handle);
+    if (!connsm) {
+        return BLE_ERR_UNK_CONN_ID;
+    }
+
+    /* The counters are updated from the radio interrupt */
+    OS_ENTER_CRITICAL(sr);
+    perf = connsm->perf;
+    skipped = connsm->events_skipped;
+    rssi = connsm->conn_rssi;
+    if (cmdbuf[2]) {
+        memset(&connsm->perf, 0, sizeof(connsm->perf));
+        connsm->perf.rssi_avg = perf.rssi_avg;
+        connsm->events_skipped = 0;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    rspbuf[2] = (uint8_t)rssi;
+    if (perf.rssi_avg == BLE_LL_CONN_UNKNOWN_RSSI * 16) {
+        rspbuf[3] = BLE_LL_CONN_UNKNOWN_RSSI;
+    } else {
+        rspbuf[3] = (uint8_t)(int8_t)(perf.rssi_avg / 16);
+    }
+    htole32(rspbuf + 4, perf.events);
+    htole32(rspbuf + 8, skipped);
+    htole32(rspbuf + 12, perf.rx_ok);
+    htole32(rspbuf + 16, perf.rx_crc_err);
+    htole32(rspbuf + 20, perf.rx_empty);
+    htole32(rspbuf + 24, perf.tx_ack);
+    htole32(rspbuf + 28, perf.tx_retry);
+    htole32(rspbuf + 32, perf.tx_empty);
+    htole32(rspbuf + 36, perf.tx_pkts);
+    htole32(rspbuf + 40, perf.tx_pkts ? perf.tx_lat_sum / perf.tx_pkts : 0);
+    htole32(rspbuf + 44, perf.tx_lat_max);
+    *rsplen = BLE_HCI_VS_RD_CONN_PERF_RSPLEN;
+
+    return BLE_ERR_SUCCESS;
+}
+#endif
+
 /**
  * Called to read the current channel map of a connection
  *
@@ -97,6 +97,7 @@ void ble_ll_conn_end(struct ble_ll_conn_sm *connsm, uint8_t ble_err);
 void ble_ll_conn_enqueue_pkt(struct ble_ll_conn_sm *connsm, struct os_mbuf *om,
                              uint8_t hdr_byte, uint8_t length);
 struct ble_ll_conn_sm *ble_ll_conn_sm_get(void);
+int ble_ll_conn_txq_empty(struct ble_ll_conn_sm *connsm);
 void ble_ll_conn_master_init(struct ble_ll_conn_sm *connsm,
                              struct hci_create_conn *hcc);
 struct ble_ll_conn_sm *ble_ll_conn_find_active_conn(uint16_t handle);
@@ -109,6 +110,7 @@ int ble_ll_conn_slave_start(uint8_t *rxbuf, uint32_t conn_req_end, uint8_t pat);
 /* Link Layer interface */
 void ble_ll_conn_module_init(void);
 void ble_ll_conn_set_global_chanmap(uint8_t num_used_chans, uint8_t *chanmap);
+void ble_ll_conn_master_chanmap_set(uint8_t *chanmap);
 void ble_ll_conn_module_reset(void);
 void ble_ll_conn_tx_pkt_in(struct os_mbuf *om, uint16_t handle, uint16_t len);
 int ble_ll_conn_rx_isr_start(struct ble_mbuf_hdr *rxhdr, uint32_t aa);
@@ -119,6 +121,7 @@ int ble_ll_init_rx_isr_end(uint8_t *rxbuf, uint8_t crcok,
                            struct ble_mbuf_hdr *ble_hdr);
 void ble_ll_conn_wfr_timer_exp(void);
 int ble_ll_conn_is_lru(struct ble_ll_conn_sm *s1, struct ble_ll_conn_sm *s2);
+void ble_ll_conn_sched_skipped(struct ble_ll_conn_sm *connsm);
 uint32_t ble_ll_conn_get_ce_end_time(void);
 void ble_ll_conn_event_halt(void);
 uint8_t ble_ll_conn_calc_used_chans(uint8_t *chmap);
@@ -142,6 +145,9 @@ int ble_ll_conn_hci_chk_conn_params(uint16_t itvl_min, uint16_t itvl_max,
                                     uint16_t latency, uint16_t spvn_tmo);
 int ble_ll_conn_hci_read_rem_features(uint8_t *cmdbuf);
 int ble_ll_conn_hci_rd_rssi(uint8_t *cmdbuf, uint8_t *rspbuf, uint8_t *rsplen);
+#if MYNEWT_VAL(BLE_LL_CONN_PERF)
+int ble_ll_conn_hci_rd_perf(uint8_t *cmdbuf, uint8_t *rspbuf, uint8_t *rsplen);
+#endif
 int ble_ll_conn_hci_rd_chan_map(uint8_t *cmdbuf, uint8_t *rspbuf,
                                 uint8_t *rsplen);
 int ble_ll_conn_hci_set_data_len(uint8_t *cmdbuf, uint8_t *rspbuf,
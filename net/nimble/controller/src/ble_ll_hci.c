@@ -32,6 +32,7 @@
 #include "controller/ble_ll_hci.h"
 #include "controller/ble_ll_whitelist.h"
 #include "controller/ble_ll_resolv.h"
+#include "controller/ble_ll_chan.h"
 #include "ble_ll_conn_priv.h"
 
 static void ble_ll_hci_cmd_proc(struct os_event *ev);
@@ -903,6 +904,60 @@ ble_ll_hci_status_params_cmd_proc(uint8_t *cmdbuf, uint16_t ocf, uint8_t *rsplen
     return rc;
 }
 
+#if MYNEWT_VAL(BLE_LL_CHAN_STATS) || MYNEWT_VAL(BLE_LL_CONN_PERF)
+static int
+ble_ll_hci_vendor_cmd_proc(uint8_t *cmdbuf, uint16_t ocf, uint8_t *rsplen)
+{
+    int rc;
+    uint8_t len;
+    uint8_t *rspbuf;
+
+    /* Assume error; if all pass rc gets set to 0 */
+    rc = BLE_ERR_INV_HCI_CMD_PARMS;
+
+    /* Get length from command */
+    len = cmdbuf[sizeof(uint16_t)];
+
+    /* See ble_ll_hci_status_params_cmd_proc() */
+    rspbuf = cmdbuf + BLE_HCI_EVENT_CMD_COMPLETE_MIN_LEN;
+
+    /* Move past HCI command header */
+    cmdbuf += BLE_HCI_CMD_HDR_LEN;
+
+    switch (ocf) {
+#if MYNEWT_VAL(BLE_LL_CHAN_STATS)
+    case BLE_HCI_OCF_VS_RD_CHAN_STATS:
+        if (len == BLE_HCI_VS_RD_CHAN_STATS_LEN) {
+            rc = ble_ll_chan_hci_rd_stats(cmdbuf, rspbuf, rsplen);
+        }
+        break;
+    case BLE_HCI_OCF_VS_RD_CHAN_MAP:
+        if (len == 0) {
+            rc = ble_ll_chan_hci_rd_map(rspbuf, rsplen);
+        }
+        break;
+    case BLE_HCI_OCF_VS_CLR_CHAN_STATS:
+        if (len == 0) {
+            rc = ble_ll_chan_hci_clr_stats();
+        }
+        break;
+#endif
+#if MYNEWT_VAL(BLE_LL_CONN_PERF)
+    case BLE_HCI_OCF_VS_RD_CONN_PERF:
+        if (len == BLE_HCI_VS_RD_CONN_PERF_LEN) {
+            rc = ble_ll_conn_hci_rd_perf(cmdbuf, rspbuf, rsplen);
+        }
+        break;
+#endif
+    default:
+        rc = BLE_ERR_UNKNOWN_HCI_CMD;
+        break;
+    }
+
+    return rc;
+}
+#endif
+
 /**
  * Called to process an HCI command from the host.
  *
@@ -951,6 +1006,11 @@ ble_ll_hci_cmd_proc(struct os_event *ev)
     case BLE_HCI_OGF_LE:
         rc = ble_ll_hci_le_cmd_proc(cmdbuf, ocf, &rsplen);
         break;
+#if MYNEWT_VAL(BLE_LL_CHAN_STATS) || MYNEWT_VAL(BLE_LL_CONN_PERF)
+    case BLE_HCI_OGF_VENDOR:
+        rc = ble_ll_hci_vendor_cmd_proc(cmdbuf, ocf, &rsplen);
+        break;
+#endif
     default:
         /* XXX: Need to support other OGF. For now, return unsupported */
         rc = BLE_ERR_UNKNOWN_HCI_CMD;
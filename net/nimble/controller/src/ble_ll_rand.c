@@ -26,6 +26,9 @@
 #include "nimble/nimble_opt.h"
 #include "controller/ble_hw.h"
 #include "controller/ble_ll.h"
+#if MYNEWT_VAL(ENTROPY_PRESENT)
+#include "entropy/entropy.h"
+#endif
 
 /* This is a simple circular buffer for holding N samples of random data */
 struct ble_ll_rnum_data
@@ -41,6 +44,23 @@ uint8_t g_ble_ll_rnum_buf[MYNEWT_VAL(BLE_LL_RNG_BUFSIZE)];
 #define IS_RNUM_BUF_END(x)  \
     (x == &g_ble_ll_rnum_buf[MYNEWT_VAL(BLE_LL_RNG_BUFSIZE) - 1])
 
+#if MYNEWT_VAL(ENTROPY_PRESENT)
+/*
+ * The radio RNG also feeds the system entropy pool. Our own small buffer is
+ * only used until the system DRBG has been seeded; after that, samples go to
+ * the pool and random data comes from the DRBG.
+ */
+static void
+ble_ll_rand_entropy_start(void *arg)
+{
+    ble_hw_rng_start();
+}
+
+static struct entropy_source g_ble_ll_rand_entropy_src = {
+    .es_start = ble_ll_rand_entropy_start,
+};
+#endif
+
 void
 ble_ll_rand_sample(uint8_t rnum)
 {
@@ -56,6 +76,13 @@ ble_ll_rand_sample(uint8_t rnum)
             ++g_ble_ll_rnum_data.rnd_in;
         }
     } else {
+#if MYNEWT_VAL(ENTROPY_PRESENT)
+        /* Our buffer is full; keep sampling while the system pool wants it */
+        if (entropy_add(&rnum, 1)) {
+            OS_EXIT_CRITICAL(sr);
+            return;
+        }
+#endif
         /* Stop generating random numbers as we are full */
         ble_hw_rng_stop();
     }
@@ -69,6 +96,13 @@ ble_ll_rand_data_get(uint8_t *buf, uint8_t len)
     uint8_t rnums;
     os_sr_t sr;
 
+#if MYNEWT_VAL(ENTROPY_PRESENT)
+    /* Once the system DRBG is seeded there is no need to wait on the RNG */
+    if (entropy_get(buf, len) == 0) {
+        return BLE_ERR_SUCCESS;
+    }
+#endif
+
     while (len != 0) {
         OS_ENTER_CRITICAL(sr);
         rnums = g_ble_ll_rnum_data.rnd_size;
@@ -157,5 +191,8 @@ ble_ll_rand_init(void)
     g_ble_ll_rnum_data.rnd_in = g_ble_ll_rnum_buf;
     g_ble_ll_rnum_data.rnd_out = g_ble_ll_rnum_buf;
     ble_hw_rng_init(ble_ll_rand_sample, 1);
+#if MYNEWT_VAL(ENTROPY_PRESENT)
+    entropy_source_register(&g_ble_ll_rand_entropy_src);
+#endif
     return 0;
 }
@@ -44,6 +44,38 @@ struct ble_ll_resolv_data g_ble_ll_resolv_data;
 
 struct ble_ll_resolv_entry g_ble_ll_resolv_list[MYNEWT_VAL(BLE_LL_RESOLV_LIST_SIZE)];
 
+#if (MYNEWT_VAL(BLE_LL_RESOLV_CACHE_SIZE) > 0)
+/*
+ * Cache of recently resolved peer RPAs. Entries are kept in most recently
+ * used order; rl_index is -1 for an address that did not resolve.
+ */
+struct ble_ll_resolv_cache_entry
+{
+    uint8_t rpa[BLE_DEV_ADDR_LEN];
+    int8_t rl_index;
+};
+
+struct ble_ll_resolv_cache_entry
+    g_ble_ll_resolv_cache[MYNEWT_VAL(BLE_LL_RESOLV_CACHE_SIZE)];
+uint8_t g_ble_ll_resolv_cache_cnt;
+#endif
+
+/**
+ * Empties the resolved RPA cache. Called whenever the resolving list changes
+ * or the RPA timeout expires.
+ */
+static void
+ble_ll_resolv_cache_clear(void)
+{
+#if (MYNEWT_VAL(BLE_LL_RESOLV_CACHE_SIZE) > 0)
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    g_ble_ll_resolv_cache_cnt = 0;
+    OS_EXIT_CRITICAL(sr);
+#endif
+}
+
 /**
  * Called to determine if a change is allowed to the resolving list at this
  * time. We are not allowed to modify the resolving list if address translation
@@ -87,6 +119,7 @@ ble_ll_resolv_rpa_timer_cb(struct os_event *ev)
         OS_EXIT_CRITICAL(sr);
         ++rl;
     }
+    ble_ll_resolv_cache_clear();
     os_callout_reset(&g_ble_ll_resolv_data.rpa_timer,
                      (int32_t)g_ble_ll_resolv_data.rpa_tmo);
 }
@@ -132,6 +165,7 @@ ble_ll_resolv_list_clr(void)
     /* Sets total on list to 0. Clears HW resolve list */
     g_ble_ll_resolv_data.rl_cnt = 0;
     ble_hw_resolv_list_clear();
+    ble_ll_resolv_cache_clear();
 
     return BLE_ERR_SUCCESS;
 }
@@ -251,6 +285,7 @@ ble_ll_resolv_list_add(uint8_t *cmdbuf)
             rl->rl_local_rpa_set = 1;
         }
         ++g_ble_ll_resolv_data.rl_cnt;
+        ble_ll_resolv_cache_clear();
     }
 
     return rc;
@@ -288,6 +323,7 @@ ble_ll_resolv_list_rmv(uint8_t *cmdbuf)
 
         /* Remove from HW list */
         ble_hw_resolv_list_rmv(position - 1);
+        ble_ll_resolv_cache_clear();
     }
 
     return BLE_ERR_SUCCESS;
@@ -523,6 +559,90 @@ ble_ll_resolv_rpa(uint8_t *rpa, uint8_t *irk)
     return rc;
 }
 
+/**
+ * Finds the resolving list entry whose peer IRK resolves the given RPA. The
+ * radio's own resolution result is used if it has one; otherwise the address
+ * is looked up in the resolved RPA cache and, on a miss, resolved against
+ * every resolving list entry in software. May be called from interrupt
+ * context.
+ *
+ * @param rpa Pointer to resolvable private address (little endian)
+ *
+ * @return int Index of the matching resolving list entry; -1 if the address
+ *             does not resolve.
+ */
+int
+ble_ll_resolv_list_match(uint8_t *rpa)
+{
+    int index;
+#if (MYNEWT_VAL(BLE_LL_RESOLV_CACHE_SIZE) > 0)
+    int i;
+    uint32_t start;
+    os_sr_t sr;
+    struct ble_ll_resolv_entry *rl;
+    struct ble_ll_resolv_cache_entry *entry;
+    struct ble_ll_resolv_cache_entry tmp;
+#endif
+
+    index = ble_hw_resolv_list_match();
+    if (index >= 0) {
+        return index;
+    }
+
+#if (MYNEWT_VAL(BLE_LL_RESOLV_CACHE_SIZE) > 0)
+    OS_ENTER_CRITICAL(sr);
+
+    entry = &g_ble_ll_resolv_cache[0];
+    for (i = 0; i < g_ble_ll_resolv_cache_cnt; ++i) {
+        if (!memcmp(entry->rpa, rpa, BLE_DEV_ADDR_LEN)) {
+            /* Move to front */
+            tmp = *entry;
+            memmove(&g_ble_ll_resolv_cache[1], &g_ble_ll_resolv_cache[0],
+                    i * sizeof(g_ble_ll_resolv_cache[0]));
+            g_ble_ll_resolv_cache[0] = tmp;
+            OS_EXIT_CRITICAL(sr);
+
+            STATS_INC(ble_ll_stats, rpa_cache_hits);
+            return tmp.rl_index;
+        }
+        ++entry;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    STATS_INC(ble_ll_stats, rpa_cache_misses);
+    start = os_cputime_get32();
+
+    index = -1;
+    rl = &g_ble_ll_resolv_list[0];
+    for (i = 0; i < g_ble_ll_resolv_data.rl_cnt; ++i) {
+        if (ble_ll_resolv_irk_nonzero(rl->rl_peer_irk) &&
+            ble_ll_resolv_rpa(rpa, rl->rl_peer_irk)) {
+            index = i;
+            break;
+        }
+        ++rl;
+    }
+
+    /* Insert at front, evicting the least recently used entry if full */
+    OS_ENTER_CRITICAL(sr);
+    if (g_ble_ll_resolv_cache_cnt < MYNEWT_VAL(BLE_LL_RESOLV_CACHE_SIZE)) {
+        ++g_ble_ll_resolv_cache_cnt;
+    }
+    memmove(&g_ble_ll_resolv_cache[1], &g_ble_ll_resolv_cache[0],
+            (g_ble_ll_resolv_cache_cnt - 1) *
+            sizeof(g_ble_ll_resolv_cache[0]));
+    memcpy(g_ble_ll_resolv_cache[0].rpa, rpa, BLE_DEV_ADDR_LEN);
+    g_ble_ll_resolv_cache[0].rl_index = index;
+
+    OS_EXIT_CRITICAL(sr);
+
+    STATS_INCN(ble_ll_stats, rpa_resolv_cputime,
+               os_cputime_get32() - start);
+#endif
+
+    return index;
+}
+
 /**
  * Returns whether or not address resolution is enabled.
  *
@@ -63,8 +63,7 @@ struct ble_ll_scan_sm g_ble_ll_scan_sm;
 
 /*
  * Structure used to store advertisers. This is used to limit sending scan
- * requests to the same advertiser and also to filter duplicate events sent
- * to the host.
+ * requests to the same advertiser.
  */
 struct ble_ll_scan_advertisers
 {
@@ -74,19 +73,53 @@ struct ble_ll_scan_advertisers
 
 #define BLE_LL_SC_ADV_F_RANDOM_ADDR     (0x01)
 #define BLE_LL_SC_ADV_F_SCAN_RSP_RXD    (0x02)
-#define BLE_LL_SC_ADV_F_DIRECT_RPT_SENT (0x04)
-#define BLE_LL_SC_ADV_F_ADV_RPT_SENT    (0x08)
 
 /* Contains list of advertisers that we have heard scan responses from */
 static uint8_t g_ble_ll_scan_num_rsp_advs;
 struct ble_ll_scan_advertisers
 g_ble_ll_scan_rsp_advs[MYNEWT_VAL(BLE_LL_NUM_SCAN_RSP_ADVS)];
 
-/* Used to filter duplicate advertising events to host */
+/*
+ * Hash table used to filter duplicate advertising events to host. An entry
+ * is keyed by advertiser address, address type and advertising PDU type
+ * and, optionally, remembers a hash of the advertising data.
+ */
+struct ble_ll_scan_dup_entry
+{
+    uint8_t sd_flags;
+    uint8_t sd_pdu_type;
+    uint8_t sd_addr[BLE_DEV_ADDR_LEN];
+#if (MYNEWT_VAL(BLE_LL_SCAN_DUP_DATA_HASH) == 1)
+    uint16_t sd_data_hash;
+#endif
+    uint32_t sd_seq;
+};
+
+#define BLE_LL_SCAN_DUP_F_USED          (0x01)
+#define BLE_LL_SCAN_DUP_F_RANDOM_ADDR   (0x02)
+
 static uint8_t g_ble_ll_scan_num_dup_advs;
-struct ble_ll_scan_advertisers
+static uint32_t g_ble_ll_scan_dup_seq;
+static struct ble_ll_scan_dup_entry
 g_ble_ll_scan_dup_advs[MYNEWT_VAL(BLE_LL_NUM_SCAN_DUP_ADVS)];
 
+#if MYNEWT_VAL(BLE_LL_SCAN_FILT_RULES)
+/*
+ * Advertising report filter. Rules and the RSSI threshold are registered by
+ * the application and are not affected by an HCI reset.
+ */
+struct ble_ll_scan_filt
+{
+    int8_t min_rssi;
+    uint8_t num_rules;
+    struct ble_ll_scan_filt_rule rules[MYNEWT_VAL(BLE_LL_SCAN_FILT_RULES)];
+};
+
+static struct ble_ll_scan_filt g_ble_ll_scan_filt = {
+    .min_rssi = INT8_MIN,
+};
+#endif
+
 /* See Vol 6 Part B Section 4.4.3.2. Active scanning backoff */
 static void
 ble_ll_scan_req_backoff(struct ble_ll_scan_sm *scansm, int success)
@@ -191,41 +224,99 @@ ble_ll_scan_req_pdu_make(struct ble_ll_scan_sm *scansm, uint8_t *adv_addr,
 }
 
 /**
- * Checks to see if an advertiser is on the duplicate address list.
+ * Compute the hash of an advertising report used to index the duplicate
+ * filter table. The key is the advertiser address, its address type and the
+ * advertising PDU type.
  *
- * @param addr Pointer to address
- * @param txadd TxAdd bit. 0: public; random otherwise
+ * @param pdu_type
+ * @param txadd
+ * @param addr
  *
- * @return uint8_t 0: not on list; any other value is
+ * @return uint8_t
  */
-static struct ble_ll_scan_advertisers *
-ble_ll_scan_find_dup_adv(uint8_t *addr, uint8_t txadd)
+static uint8_t
+ble_ll_scan_dup_hash(uint8_t pdu_type, uint8_t txadd, uint8_t *addr)
 {
-    uint8_t num_advs;
-    struct ble_ll_scan_advertisers *adv;
+    int i;
+    uint32_t h;
 
-    /* Do we have an address match? Must match address type */
-    adv = &g_ble_ll_scan_dup_advs[0];
-    num_advs = g_ble_ll_scan_num_dup_advs;
-    while (num_advs) {
-        if (!memcmp(&adv->adv_addr, addr, BLE_DEV_ADDR_LEN)) {
-            /* Address type must match */
-            if (txadd) {
-                if ((adv->sc_adv_flags & BLE_LL_SC_ADV_F_RANDOM_ADDR) == 0) {
-                    goto next_dup_adv;
-                }
-            } else {
-                if (adv->sc_adv_flags & BLE_LL_SC_ADV_F_RANDOM_ADDR) {
-                    goto next_dup_adv;
-                }
-            }
+    /* FNV-1a */
+    h = 2166136261UL;
+    for (i = 0; i < BLE_DEV_ADDR_LEN; ++i) {
+        h = (h ^ addr[i]) * 16777619UL;
+    }
+    h = (h ^ ((pdu_type << 1) | (txadd != 0))) * 16777619UL;
+
+    return (uint8_t)(h % MYNEWT_VAL(BLE_LL_NUM_SCAN_DUP_ADVS));
+}
+
+#if (MYNEWT_VAL(BLE_LL_SCAN_DUP_DATA_HASH) == 1)
+/**
+ * Compute a 16-bit hash of the advertising data so that a report whose
+ * payload changed is not considered a duplicate.
+ *
+ * @param data
+ * @param len
+ *
+ * @return uint16_t
+ */
+static uint16_t
+ble_ll_scan_dup_data_hash(uint8_t *data, uint8_t len)
+{
+    uint32_t h;
+
+    h = 2166136261UL;
+    h = (h ^ len) * 16777619UL;
+    while (len) {
+        h = (h ^ *data) * 16777619UL;
+        ++data;
+        --len;
+    }
+
+    return (uint16_t)(h ^ (h >> 16));
+}
+#endif
 
-            return adv;
+/**
+ * Find an advertiser in the duplicate filter table. The table is open
+ * addressed with linear probing; entries are only removed when the table
+ * is cleared, so the search stops at the first unused entry.
+ *
+ * @param pdu_type
+ * @param txadd     TxAdd bit. 0: public; random otherwise
+ * @param addr      Pointer to address
+ *
+ * @return struct ble_ll_scan_dup_entry* NULL if not in the table
+ */
+static struct ble_ll_scan_dup_entry *
+ble_ll_scan_find_dup_adv(uint8_t pdu_type, uint8_t txadd, uint8_t *addr)
+{
+    int probes;
+    uint8_t flags;
+    uint8_t index;
+    struct ble_ll_scan_dup_entry *dup;
+
+    flags = BLE_LL_SCAN_DUP_F_USED;
+    if (txadd) {
+        flags |= BLE_LL_SCAN_DUP_F_RANDOM_ADDR;
+    }
+
+    index = ble_ll_scan_dup_hash(pdu_type, txadd, addr);
+    for (probes = 0; probes < MYNEWT_VAL(BLE_LL_NUM_SCAN_DUP_ADVS); ++probes) {
+        dup = &g_ble_ll_scan_dup_advs[index];
+        if ((dup->sd_flags & BLE_LL_SCAN_DUP_F_USED) == 0) {
+            break;
         }
 
-next_dup_adv:
-        ++adv;
-        --num_advs;
+        if ((dup->sd_flags == flags) && (dup->sd_pdu_type == pdu_type) &&
+            !memcmp(dup->sd_addr, addr, BLE_DEV_ADDR_LEN)) {
+            return dup;
+        }
+
+        ++index;
+        if (index == MYNEWT_VAL(BLE_LL_NUM_SCAN_DUP_ADVS)) {
+            index = 0;
+        }
     }
 
     return NULL;
@@ -235,74 +326,234 @@ next_dup_adv:
  * Check if a packet is a duplicate advertising packet.
  *
  * @param pdu_type
- * @param rxbuf
+ * @param txadd     TxAdd bit (0 public, random otherwise)
+ * @param addr      Pointer to advertisers address or identity address
+ * @param data      Pointer to advertising data
+ * @param len       Length of advertising data
  *
  * @return int 0: not a duplicate. 1:duplicate
  */
-int
-ble_ll_scan_is_dup_adv(uint8_t pdu_type, uint8_t txadd, uint8_t *addr)
+static int
+ble_ll_scan_is_dup_adv(uint8_t pdu_type, uint8_t txadd, uint8_t *addr,
+                       uint8_t *data, uint8_t len)
 {
-    struct ble_ll_scan_advertisers *adv;
+    struct ble_ll_scan_dup_entry *dup;
 
-    adv = ble_ll_scan_find_dup_adv(addr, txadd);
-    if (adv) {
-        /* Check appropriate flag (based on type of PDU) */
-        if (pdu_type == BLE_ADV_PDU_TYPE_ADV_DIRECT_IND) {
-            if (adv->sc_adv_flags & BLE_LL_SC_ADV_F_DIRECT_RPT_SENT) {
-                return 1;
+    dup = ble_ll_scan_find_dup_adv(pdu_type, txadd, addr);
+    if (!dup) {
+        return 0;
+    }
+
+#if (MYNEWT_VAL(BLE_LL_SCAN_DUP_DATA_HASH) == 1)
+    if (dup->sd_data_hash != ble_ll_scan_dup_data_hash(data, len)) {
+        return 0;
+    }
+#endif
+
+    return 1;
+}
+
+/**
+ * Add an advertiser to the duplicate filter table. An advertiser gets added
+ * when the controller sends an advertising report to the host. If the table
+ * is full the oldest entry is replaced when BLE_LL_SCAN_DUP_EVICT is
+ * enabled; otherwise the advertiser is not added and its reports continue
+ * to be sent to the host.
+ *
+ * @param pdu_type
+ * @param txadd     TxAdd bit (0 public, random otherwise)
+ * @param addr      Pointer to advertisers address or identity address
+ * @param data      Pointer to advertising data
+ * @param len       Length of advertising data
+ */
+static void
+ble_ll_scan_add_dup_adv(uint8_t pdu_type, uint8_t txadd, uint8_t *addr,
+                        uint8_t *data, uint8_t len)
+{
+    int probes;
+    uint8_t index;
+    struct ble_ll_scan_dup_entry *dup;
+#if (MYNEWT_VAL(BLE_LL_SCAN_DUP_EVICT) == 1)
+    int i;
+    struct ble_ll_scan_dup_entry *oldest;
+#endif
+
+    dup = ble_ll_scan_find_dup_adv(pdu_type, txadd, addr);
+    if (!dup) {
+        if (g_ble_ll_scan_num_dup_advs < MYNEWT_VAL(BLE_LL_NUM_SCAN_DUP_ADVS)) {
+            /* Take the first unused entry in the probe sequence */
+            index = ble_ll_scan_dup_hash(pdu_type, txadd, addr);
+            for (probes = 0; probes < MYNEWT_VAL(BLE_LL_NUM_SCAN_DUP_ADVS);
+                 ++probes) {
+                dup = &g_ble_ll_scan_dup_advs[index];
+                if ((dup->sd_flags & BLE_LL_SCAN_DUP_F_USED) == 0) {
+                    break;
+                }
+                ++index;
+                if (index == MYNEWT_VAL(BLE_LL_NUM_SCAN_DUP_ADVS)) {
+                    index = 0;
+                }
             }
+            ++g_ble_ll_scan_num_dup_advs;
         } else {
-            if (adv->sc_adv_flags & BLE_LL_SC_ADV_F_ADV_RPT_SENT) {
-                return 1;
+#if (MYNEWT_VAL(BLE_LL_SCAN_DUP_EVICT) == 1)
+            /*
+             * The table has no unused entries so every search walks the
+             * whole table; replacing any entry in place keeps the table
+             * consistent. Replace the one added longest ago.
+             */
+            oldest = &g_ble_ll_scan_dup_advs[0];
+            for (i = 1; i < MYNEWT_VAL(BLE_LL_NUM_SCAN_DUP_ADVS); ++i) {
+                dup = &g_ble_ll_scan_dup_advs[i];
+                if ((int32_t)(dup->sd_seq - oldest->sd_seq) < 0) {
+                    oldest = dup;
+                }
             }
+            dup = oldest;
+            STATS_INC(ble_ll_stats, scan_dup_evicted);
+#else
+            return;
+#endif
+        }
+
+        dup->sd_flags = BLE_LL_SCAN_DUP_F_USED;
+        if (txadd) {
+            dup->sd_flags |= BLE_LL_SCAN_DUP_F_RANDOM_ADDR;
         }
+        dup->sd_pdu_type = pdu_type;
+        memcpy(dup->sd_addr, addr, BLE_DEV_ADDR_LEN);
+        dup->sd_seq = g_ble_ll_scan_dup_seq++;
     }
 
-    return 0;
+#if (MYNEWT_VAL(BLE_LL_SCAN_DUP_DATA_HASH) == 1)
+    dup->sd_data_hash = ble_ll_scan_dup_data_hash(data, len);
+#endif
+}
+
+/**
+ * Clear the duplicate filter table.
+ */
+static void
+ble_ll_scan_clr_dup_advs(void)
+{
+    g_ble_ll_scan_num_dup_advs = 0;
+    memset(&g_ble_ll_scan_dup_advs[0], 0, sizeof(g_ble_ll_scan_dup_advs));
 }
 
+#if MYNEWT_VAL(BLE_LL_SCAN_FILT_RULES)
 /**
- * Add an advertiser the list of duplicate advertisers. An address gets added to
- * the list of duplicate addresses when the controller sends an advertising
- * report to the host.
+ * Checks a received advertising PDU against the advertising report filter.
+ * Directed advertisements carry no data and are only subject to the RSSI
+ * threshold.
+ *
+ * Context: Link Layer task
  *
- * @param addr   Pointer to advertisers address or identity address
- * @param Txadd. TxAdd bit (0 public, random otherwise)
- * @param subev  Type of advertising report sent (direct or normal).
+ * @param pdu_type
+ * @param adv_data Pointer to advertising data
+ * @param adv_data_len Length of advertising data
+ * @param rssi
+ *
+ * @return int 0: report PDU to host. 1: discard PDU
  */
-void
-ble_ll_scan_add_dup_adv(uint8_t *addr, uint8_t txadd, uint8_t subev)
+static int
+ble_ll_scan_filt_chk(uint8_t pdu_type, uint8_t *adv_data,
+                     uint8_t adv_data_len, int8_t rssi)
 {
-    uint8_t num_advs;
-    struct ble_ll_scan_advertisers *adv;
+    int i;
+    uint8_t off;
+    uint8_t len;
+    struct ble_ll_scan_filt *filt;
+    struct ble_ll_scan_filt_rule *rule;
+
+    filt = &g_ble_ll_scan_filt;
+    if (rssi < filt->min_rssi) {
+        return 1;
+    }
 
-    /* Check to see if on list. */
-    adv = ble_ll_scan_find_dup_adv(addr, txadd);
-    if (!adv) {
-        /* XXX: for now, if we dont have room, just leave */
-        num_advs = g_ble_ll_scan_num_dup_advs;
-        if (num_advs == MYNEWT_VAL(BLE_LL_NUM_SCAN_DUP_ADVS)) {
-            return;
-        }
+    if ((filt->num_rules == 0) || (pdu_type == BLE_ADV_PDU_TYPE_ADV_DIRECT_IND)) {
+        return 0;
+    }
 
-        /* Add the advertiser to the array */
-        adv = &g_ble_ll_scan_dup_advs[num_advs];
-        memcpy(&adv->adv_addr, addr, BLE_DEV_ADDR_LEN);
-        ++g_ble_ll_scan_num_dup_advs;
+    /* Walk the AD structures; a zero length ends the significant part */
+    off = 0;
+    while (off < adv_data_len) {
+        len = adv_data[off];
+        if ((len == 0) || (off + 1 + len > adv_data_len)) {
+            break;
+        }
 
-        adv->sc_adv_flags = 0;
-        if (txadd) {
-            adv->sc_adv_flags |= BLE_LL_SC_ADV_F_RANDOM_ADDR;
+        for (i = 0; i < filt->num_rules; ++i) {
+            rule = &filt->rules[i];
+            if ((rule->ad_type == adv_data[off + 1]) &&
+                (rule->prefix_len <= len - 1) &&
+                !memcmp(adv_data + off + 2, rule->prefix, rule->prefix_len)) {
+                return 0;
+            }
         }
+
+        off += 1 + len;
     }
 
-    if (subev == BLE_HCI_LE_SUBEV_DIRECT_ADV_RPT) {
-        adv->sc_adv_flags |= BLE_LL_SC_ADV_F_DIRECT_RPT_SENT;
+    return 1;
+}
+
+/**
+ * Registers an advertising report filter rule. Once a rule is registered,
+ * only advertising PDUs matching at least one rule are reported to the host.
+ *
+ * @param rule
+ *
+ * @return int 0: success; BLE_ERR_MEM_CAPACITY if the rule table is full;
+ *         BLE_ERR_INV_HCI_CMD_PARMS if the prefix is too long.
+ */
+int
+ble_ll_scan_filt_add(const struct ble_ll_scan_filt_rule *rule)
+{
+    int rc;
+    os_sr_t sr;
+    struct ble_ll_scan_filt *filt;
+
+    if (rule->prefix_len > MYNEWT_VAL(BLE_LL_SCAN_FILT_PREFIX_MAX)) {
+        return BLE_ERR_INV_HCI_CMD_PARMS;
+    }
+
+    filt = &g_ble_ll_scan_filt;
+    OS_ENTER_CRITICAL(sr);
+    if (filt->num_rules < MYNEWT_VAL(BLE_LL_SCAN_FILT_RULES)) {
+        filt->rules[filt->num_rules] = *rule;
+        ++filt->num_rules;
+        rc = BLE_ERR_SUCCESS;
     } else {
-        adv->sc_adv_flags |= BLE_LL_SC_ADV_F_ADV_RPT_SENT;
+        rc = BLE_ERR_MEM_CAPACITY;
     }
+    OS_EXIT_CRITICAL(sr);
+
+    return rc;
+}
+
+/**
+ * Removes all advertising report filter rules; all advertising PDUs above
+ * the RSSI threshold are reported again.
+ */
+void
+ble_ll_scan_filt_clear(void)
+{
+    g_ble_ll_scan_filt.num_rules = 0;
 }
 
+/**
+ * Sets the RSSI below which advertising PDUs are not reported to the host.
+ * INT8_MIN (the default) reports everything.
+ *
+ * @param min_rssi
+ */
+void
+ble_ll_scan_filt_set_min_rssi(int8_t min_rssi)
+{
+    g_ble_ll_scan_filt.min_rssi = min_rssi;
+}
+#endif
+
 /**
  * Checks to see if we have received a scan response from this advertiser.
  *
@@ -380,13 +631,14 @@ ble_ll_scan_add_scan_rsp_adv(uint8_t *addr, uint8_t txadd)
  * @param rxbuf
  * @param hdr
  * @param scansm
+ *
+ * @return int 0: report sent to host. Otherwise, report not sent
  */
-static void
+static int
 ble_ll_hci_send_adv_report(uint8_t pdu_type, uint8_t txadd, uint8_t *rxbuf,
                            struct ble_mbuf_hdr *hdr,
                            struct ble_ll_scan_sm *scansm)
 {
-    int rc;
 #if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY)
     int index;
 #endif
@@ -476,15 +728,11 @@ ble_ll_hci_send_adv_report(uint8_t pdu_type, uint8_t txadd, uint8_t *rxbuf,
             evbuf[0] = addr_type;
             memcpy(evbuf + 1, adv_addr, BLE_DEV_ADDR_LEN);
 
-            rc = ble_ll_hci_event_send(orig_evbuf);
-            if (!rc) {
-                /* If filtering, add it to list of duplicate addresses */
-                if (g_ble_ll_scan_sm.scan_filt_dups) {
-                    ble_ll_scan_add_dup_adv(adv_addr, txadd, subev);
-                }
-            }
+            return ble_ll_hci_event_send(orig_evbuf);
         }
     }
+
+    return -1;
 }
 
 /**
@@ -588,6 +836,9 @@ ble_ll_scan_start(struct ble_ll_scan_sm *scansm, uint8_t chan)
     }
 #endif
 
+    /* Must be set before receive is started; the PHY reads it at rx setup */
+    ble_ll_whitelist_hw_filter(scansm->scan_filt_policy & 1);
+
     /* Start receiving */
     rc = ble_phy_rx();
     if (!rc) {
@@ -725,7 +976,7 @@ ble_ll_scan_sm_start(struct ble_ll_scan_sm *scansm)
 
     /* Forget filtered advertisers from previous scan. */
     g_ble_ll_scan_num_rsp_advs = 0;
-    g_ble_ll_scan_num_dup_advs = 0;
+    ble_ll_scan_clr_dup_advs();
 
     /* XXX: align to current or next slot???. */
     /* Schedule start time now */
@@ -979,7 +1230,7 @@ ble_ll_scan_rx_isr_end(struct os_mbuf *rxpdu, uint8_t crcok)
     index = -1;
 #if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY) == 1)
     if (ble_ll_is_rpa(peer, peer_addr_type) && ble_ll_resolv_enabled()) {
-        index = ble_hw_resolv_list_match();
+        index = ble_ll_resolv_list_match(peer);
         if (index >= 0) {
             ble_hdr->rxinfo.flags |= BLE_MBUF_HDR_F_RESOLVED;
             peer = g_ble_ll_resolv_list[index].rl_identity_addr;
@@ -1108,8 +1359,11 @@ ble_ll_scan_rx_pkt_in(uint8_t ptype, uint8_t *rxbuf, struct ble_mbuf_hdr *hdr)
 #if MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY)
     int index;
 #endif
+    int rc;
     uint8_t *adv_addr;
     uint8_t *adva;
+    uint8_t *adv_data;
+    uint8_t adv_data_len;
     uint8_t *ident_addr;
     uint8_t ident_addr_type;
     uint8_t txadd;
@@ -1180,14 +1434,39 @@ ble_ll_scan_rx_pkt_in(uint8_t ptype, uint8_t *rxbuf, struct ble_mbuf_hdr *hdr)
     }
 
     /* Filter duplicates */
+    if (ptype == BLE_ADV_PDU_TYPE_ADV_DIRECT_IND) {
+        adv_data_len = 0;
+    } else {
+        adv_data_len = (rxbuf[1] & BLE_ADV_PDU_HDR_LEN_MASK) - BLE_DEV_ADDR_LEN;
+    }
+    adv_data = adv_addr + BLE_DEV_ADDR_LEN;
+
+#if MYNEWT_VAL(BLE_LL_SCAN_FILT_RULES)
+    /* Drop reports the application is not interested in */
+    if (ble_ll_scan_filt_chk(ptype, adv_data, adv_data_len,
+                             hdr->rxinfo.rssi)) {
+        STATS_INC(ble_ll_stats, scan_filt_dropped);
+        goto scan_continue;
+    }
+#endif
+
     if (scansm->scan_filt_dups) {
-        if (ble_ll_scan_is_dup_adv(ptype, ident_addr_type, ident_addr)) {
+        if (ble_ll_scan_is_dup_adv(ptype, ident_addr_type, ident_addr,
+                                   adv_data, adv_data_len)) {
+            STATS_INC(ble_ll_stats, scan_dup_filtered);
             goto scan_continue;
         }
     }
 
     /* Send the advertising report */
-    ble_ll_hci_send_adv_report(ptype, ident_addr_type, rxbuf, hdr, scansm);
+    rc = ble_ll_hci_send_adv_report(ptype, ident_addr_type, rxbuf, hdr,
+                                    scansm);
+
+    /* If filtering, add it to the duplicate filter table */
+    if (!rc && scansm->scan_filt_dups) {
+        ble_ll_scan_add_dup_adv(ptype, ident_addr_type, ident_addr,
+                                adv_data, adv_data_len);
+    }
 
 scan_continue:
     /*
@@ -1450,8 +1729,7 @@ ble_ll_scan_reset(void)
     g_ble_ll_scan_num_rsp_advs = 0;
     memset(&g_ble_ll_scan_rsp_advs[0], 0, sizeof(g_ble_ll_scan_rsp_advs));
 
-    g_ble_ll_scan_num_dup_advs = 0;
-    memset(&g_ble_ll_scan_dup_advs[0], 0, sizeof(g_ble_ll_scan_dup_advs));
+    ble_ll_scan_clr_dup_advs();
 
     /* Call the init function again */
     ble_ll_scan_init();
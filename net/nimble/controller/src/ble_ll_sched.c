@@ -19,6 +19,7 @@
 #include <stdint.h>
 #include <assert.h>
 #include <string.h>
+#include "syscfg/syscfg.h"
 #include "os/os.h"
 #include "os/os_cputime.h"
 #include "ble/xcvr.h"
@@ -51,6 +52,195 @@ int32_t g_ble_ll_sched_max_late;
 /* Queue for timers */
 TAILQ_HEAD(ll_sched_qhead, ble_ll_sched_item) g_ble_ll_sched_q;
 
+/*
+ * Connection scheduling priorities. When two connection events overlap, the
+ * one with the higher priority is kept; between equal priorities, the one
+ * skipped more often and then the least recently serviced one wins. Reserved
+ * scan time is only given up to a starved or urgent connection.
+ */
+#define BLE_LL_SCHED_PRIO_NORMAL    (0)
+#define BLE_LL_SCHED_PRIO_STARVED   (1)
+#define BLE_LL_SCHED_PRIO_URGENT    (2)
+
+/*
+ * Airtime reserved for scanning: a window of 'window' ticks every 'itvl'
+ * ticks, starting at 'anchor'. Nothing gets scheduled in these windows except
+ * starved or urgent connection events, and events whose timing cannot be
+ * moved (a new slave connection or an advertising event already committed).
+ * The scanner runs whenever the radio is otherwise idle, so it gets the time.
+ */
+struct ble_ll_sched_scan_rsv
+{
+    uint32_t anchor;
+    uint32_t itvl;
+    uint32_t window;
+};
+struct ble_ll_sched_scan_rsv g_ble_ll_sched_scan_rsv;
+
+/**
+ * Returns the scheduling priority of a connection event starting at
+ * 'start_time'.
+ */
+static int
+ble_ll_sched_conn_prio(struct ble_ll_conn_sm *connsm, uint32_t start_time)
+{
+    uint32_t margin;
+
+    /* Supervision timer is always running while a connection is active */
+    margin = os_cputime_usecs_to_ticks(MYNEWT_VAL(BLE_LL_SCHED_URGENT_EVENTS) *
+                                       connsm->conn_itvl *
+                                       BLE_LL_CONN_ITVL_USECS);
+    if ((int32_t)(connsm->conn_spvn_timer.expiry - start_time) <
+        (int32_t)margin) {
+        return BLE_LL_SCHED_PRIO_URGENT;
+    }
+
+    if (connsm->sched_skips >= MYNEWT_VAL(BLE_LL_SCHED_STARVE_EVENTS)) {
+        return BLE_LL_SCHED_PRIO_STARVED;
+    }
+
+    return BLE_LL_SCHED_PRIO_NORMAL;
+}
+
+/**
+ * Determines if connection event s1 should be scheduled in place of the
+ * overlapping connection event s2.
+ *
+ * @return int 0: keep s2. 1: replace s2 with s1
+ */
+static int
+ble_ll_sched_conn_preempts(struct ble_ll_sched_item *s1,
+                           struct ble_ll_sched_item *s2)
+{
+    int p1;
+    int p2;
+    struct ble_ll_conn_sm *c1;
+    struct ble_ll_conn_sm *c2;
+
+    c1 = (struct ble_ll_conn_sm *)s1->cb_arg;
+    c2 = (struct ble_ll_conn_sm *)s2->cb_arg;
+
+    p1 = ble_ll_sched_conn_prio(c1, s1->start_time);
+    p2 = ble_ll_sched_conn_prio(c2, s2->start_time);
+    if (p1 != p2) {
+        return p1 > p2;
+    }
+
+    /* Fair share: rotate between connections of the same priority */
+    if (c1->sched_skips != c2->sched_skips) {
+        return c1->sched_skips > c2->sched_skips;
+    }
+
+    return ble_ll_conn_is_lru(c1, c2);
+}
+
+/**
+ * Checks if the time from start to end overlaps reserved scan time.
+ *
+ * Context: interrupts disabled
+ *
+ * @param start
+ * @param end
+ * @param rsv_end Set to the end of the overlapped reservation window
+ *
+ * @return int 0: no overlap 1: overlap
+ */
+static int
+ble_ll_sched_scan_rsv_overlap(uint32_t start, uint32_t end, uint32_t *rsv_end)
+{
+    int32_t diff;
+    uint32_t now;
+    uint32_t win_start;
+    struct ble_ll_sched_scan_rsv *rsv;
+
+    rsv = &g_ble_ll_sched_scan_rsv;
+    if (rsv->window == 0) {
+        return 0;
+    }
+
+    /* Keep the anchor at the last window start in the past */
+    now = os_cputime_get32();
+    if ((int32_t)(now - rsv->anchor) >= (int32_t)rsv->itvl) {
+        rsv->anchor += ((now - rsv->anchor) / rsv->itvl) * rsv->itvl;
+    }
+
+    diff = (int32_t)(start - rsv->anchor);
+    if (diff < 0) {
+        win_start = rsv->anchor - rsv->itvl;
+    } else {
+        win_start = rsv->anchor + ((uint32_t)diff / rsv->itvl) * rsv->itvl;
+    }
+
+    /* Starts inside a window */
+    if ((int32_t)(start - (win_start + rsv->window)) < 0) {
+        *rsv_end = win_start + rsv->window;
+        return 1;
+    }
+
+    /* Runs into the next window */
+    win_start += rsv->itvl;
+    if ((int32_t)(end - win_start) > 0) {
+        *rsv_end = win_start + rsv->window;
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Returns the earliest start time, no earlier than 'start', at which an item
+ * of duration 'dur' does not overlap reserved scan time. Gives up on the
+ * reservation if the item does not fit between two windows.
+ *
+ * Context: interrupts disabled
+ */
+static uint32_t
+ble_ll_sched_scan_rsv_avoid(uint32_t start, uint32_t dur)
+{
+    int i;
+    uint32_t rsv_end;
+
+    for (i = 0; i < 2; ++i) {
+        if (!ble_ll_sched_scan_rsv_overlap(start, start + dur, &rsv_end)) {
+            break;
+        }
+        start = rsv_end;
+    }
+
+    return start;
+}
+
+/**
+ * Reserve airtime for scanning. Every 'itvl_usecs', starting now, a window
+ * of 'window_usecs' is kept free of other link layer activity unless a
+ * connection would otherwise starve or time out. A window of zero removes
+ * the reservation.
+ *
+ * Context: Link Layer task
+ *
+ * @param itvl_usecs
+ * @param window_usecs
+ *
+ * @return int 0: success; -1 if the window does not fit in the interval
+ */
+int
+ble_ll_sched_scan_reserve(uint32_t itvl_usecs, uint32_t window_usecs)
+{
+    os_sr_t sr;
+
+    if (window_usecs && (window_usecs >= itvl_usecs)) {
+        return -1;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    g_ble_ll_sched_scan_rsv.anchor = os_cputime_get32();
+    g_ble_ll_sched_scan_rsv.itvl = os_cputime_usecs_to_ticks(itvl_usecs);
+    g_ble_ll_sched_scan_rsv.window = os_cputime_usecs_to_ticks(window_usecs);
+    OS_EXIT_CRITICAL(sr);
+
+    return 0;
+}
+
 /**
  * Checks if two events in the schedule will overlap in time. NOTE: consecutive
  * schedule items can end and start at the same time.
@@ -113,6 +303,7 @@ ble_ll_sched_conn_overlap(struct ble_ll_sched_item *entry)
         connsm = (struct ble_ll_conn_sm *)entry->cb_arg;
         entry->enqueued = 0;
         TAILQ_REMOVE(&g_ble_ll_sched_q, entry, link);
+        ble_ll_conn_sched_skipped(connsm);
         ble_ll_event_send(&connsm->conn_ev_end);
         rc = 0;
     } else {
@@ -141,6 +332,7 @@ ble_ll_sched_conn_reschedule(struct ble_ll_conn_sm *connsm)
     int rc;
     os_sr_t sr;
     uint32_t usecs;
+    uint32_t rsv_end;
     struct ble_ll_sched_item *sch;
     struct ble_ll_sched_item *start_overlap;
     struct ble_ll_sched_item *end_overlap;
@@ -173,6 +365,15 @@ ble_ll_sched_conn_reschedule(struct ble_ll_conn_sm *connsm)
         return -1;
     }
 
+    /* Reserved scan time is only given up to starved or urgent connections */
+    if (ble_ll_sched_scan_rsv_overlap(sch->start_time, sch->end_time,
+                                      &rsv_end) &&
+        (ble_ll_sched_conn_prio(connsm, sch->start_time) ==
+         BLE_LL_SCHED_PRIO_NORMAL)) {
+        OS_EXIT_CRITICAL(sr);
+        return -1;
+    }
+
     /* Stop timer since we will add an element */
     os_cputime_timer_stop(&g_ble_ll_sched_timer);
 
@@ -181,10 +382,9 @@ ble_ll_sched_conn_reschedule(struct ble_ll_conn_sm *connsm)
     rc = 0;
     TAILQ_FOREACH(entry, &g_ble_ll_sched_q, link) {
         if (ble_ll_sched_is_overlap(sch, entry)) {
-            /* Only insert if this element is older than all that we overlap */
+            /* Only insert if this element wins over all that we overlap */
             if ((entry->sched_type == BLE_LL_SCHED_TYPE_ADV) ||
-                !ble_ll_conn_is_lru((struct ble_ll_conn_sm *)sch->cb_arg,
-                                    (struct ble_ll_conn_sm *)entry->cb_arg)) {
+                !ble_ll_sched_conn_preempts(sch, entry)) {
                 start_overlap = NULL;
                 rc = -1;
                 break;
@@ -217,6 +417,7 @@ ble_ll_sched_conn_reschedule(struct ble_ll_conn_sm *connsm)
         start_overlap = TAILQ_NEXT(entry,link);
         if (entry->sched_type == BLE_LL_SCHED_TYPE_CONN) {
             tmp = (struct ble_ll_conn_sm *)entry->cb_arg;
+            ble_ll_conn_sched_skipped(tmp);
             ble_ll_event_send(&tmp->conn_ev_end);
         }
 
@@ -303,10 +504,19 @@ ble_ll_sched_master_new(struct ble_ll_conn_sm *connsm, uint32_t adv_rxend,
     }
     initial_start = earliest_start;
 
+    /* Stay out of reserved scan time, if that keeps us within an interval */
+    earliest_start = ble_ll_sched_scan_rsv_avoid(initial_start, dur);
+    if ((earliest_start - initial_start) > itvl_t) {
+        earliest_start = initial_start;
+    }
+    earliest_end = earliest_start + dur;
+    sch->start_time = earliest_start;
+
     if (!ble_ll_sched_insert_if_empty(sch)) {
         /* Nothing in schedule. Schedule as soon as possible */
         rc = 0;
-        connsm->tx_win_off = 0;
+        connsm->tx_win_off = (earliest_start - initial_start) /
+            os_cputime_usecs_to_ticks(BLE_LL_CONN_ITVL_USECS);
     } else {
         os_cputime_timer_stop(&g_ble_ll_sched_timer);
         TAILQ_FOREACH(entry, &g_ble_ll_sched_q, link) {
@@ -326,7 +536,8 @@ ble_ll_sched_master_new(struct ble_ll_conn_sm *connsm, uint32_t adv_rxend,
             /* Check for overlapping events */
             if (ble_ll_sched_is_overlap(sch, entry)) {
                 /* Earliest start is end of this event since we overlap */
-                earliest_start = entry->end_time;
+                earliest_start = ble_ll_sched_scan_rsv_avoid(entry->end_time,
+                                                             dur);
                 earliest_end = earliest_start + dur;
             }
         }
@@ -468,6 +679,10 @@ ble_ll_sched_adv_new(struct ble_ll_sched_item *sch)
         sch->end_time = ce_end_time + duration;
     }
 
+    /* Stay out of reserved scan time */
+    sch->start_time = ble_ll_sched_scan_rsv_avoid(sch->start_time, duration);
+    sch->end_time = sch->start_time + duration;
+
     entry = ble_ll_sched_insert_if_empty(sch);
     if (!entry) {
         rc = 0;
@@ -485,7 +700,8 @@ ble_ll_sched_adv_new(struct ble_ll_sched_item *sch)
             /* Check for overlapping events */
             if (ble_ll_sched_is_overlap(sch, entry)) {
                 /* Earliest start is end of this event since we overlap */
-                sch->start_time = entry->end_time;
+                sch->start_time = ble_ll_sched_scan_rsv_avoid(entry->end_time,
+                                                              duration);
                 sch->end_time = sch->start_time + duration;
             }
         }
@@ -654,6 +870,7 @@ ble_ll_sched_execute_item(struct ble_ll_sched_item *sch)
     }
 
     assert(sch->sched_cb);
+    OS_TRACE(OS_TRACE_ID_BLE_LL_SCHED, sch->sched_type, sch->start_time);
     rc = sch->sched_cb(sch);
     return rc;
 }
@@ -28,7 +28,9 @@
 #include "controller/ble_ll_hci.h"
 #include "controller/ble_ll_adv.h"
 #include "controller/ble_ll_scan.h"
+#include "controller/ble_ll_resolv.h"
 #include "controller/ble_hw.h"
+#include "controller/ble_phy.h"
 
 #if (MYNEWT_VAL(BLE_LL_WHITELIST_SIZE) < BLE_HW_WHITE_LIST_SIZE)
 #define BLE_LL_WHITELIST_SIZE       MYNEWT_VAL(BLE_LL_WHITELIST_SIZE)
@@ -269,5 +271,37 @@ ble_ll_whitelist_disable(void)
 {
 #if (BLE_USES_HW_WHITELIST == 1)
     ble_hw_whitelist_disable();
+#if MYNEWT_VAL(BLE_LL_HW_WL_FILTER)
+    ble_phy_wl_filter_disable();
+#endif
+#endif
+}
+
+/**
+ * Enable or disable dropping of PDUs from devices not on the whitelist in the
+ * radio itself. The caller must only enable this when it would discard every
+ * PDU whose first address does not match the whitelist. Filtering is never
+ * enabled while address resolution is on, as a resolvable private address
+ * only matches the whitelist after it has been resolved.
+ *
+ * Note: This function has no effect unless BLE_LL_HW_WL_FILTER is set
+ *
+ * @param enable
+ */
+void
+ble_ll_whitelist_hw_filter(int enable)
+{
+#if (BLE_USES_HW_WHITELIST == 1) && MYNEWT_VAL(BLE_LL_HW_WL_FILTER)
+#if (MYNEWT_VAL(BLE_LL_CFG_FEAT_LL_PRIVACY) == 1)
+    if (ble_ll_resolv_enabled()) {
+        enable = 0;
+    }
+#endif
+
+    if (enable) {
+        ble_phy_wl_filter_enable();
+    } else {
+        ble_phy_wl_filter_disable();
+    }
 #endif
 }
@@ -209,6 +209,106 @@ struct ble_gap_upd_params {
     uint16_t max_ce_len;
 };
 
+/** Throughput measured on a connection; see ble_gap_conn_tput(). */
+struct ble_gap_conn_tput {
+    /** L2CAP payload bytes per second sent since the previous query. */
+    uint32_t tx_bps;
+
+    /** L2CAP payload bytes per second received since the previous query. */
+    uint32_t rx_bps;
+
+    /** The connection's ATT MTU. */
+    uint16_t mtu;
+
+    /** The connection interval (units: 1.25 ms). */
+    uint16_t itvl;
+};
+
+/**
+ * Link statistics of a connection; see ble_gap_conn_perf().  The ctlr_*
+ * fields are only valid if ctlr_valid is set, i.e., if the controller
+ * supports the vendor specific command that reports them.  The host_*
+ * fields are only valid if host_valid is set (BLE_HS_CONN_PERF).
+ */
+struct ble_gap_conn_perf {
+    /** Whether the controller reported its statistics. */
+    unsigned ctlr_valid:1;
+
+    /** Whether the host statistics are kept. */
+    unsigned host_valid:1;
+
+    /** RSSI of the last and averaged over recent data PDUs (dBm). */
+    int8_t ctlr_rssi;
+    int8_t ctlr_rssi_avg;
+
+    /** Connection events run and skipped by the controller's scheduler. */
+    uint32_t ctlr_events;
+    uint32_t ctlr_events_skipped;
+
+    /** PDUs received with a good CRC (empty ones included), with a bad
+     * CRC, and empty PDUs received.
+     */
+    uint32_t ctlr_rx_ok;
+    uint32_t ctlr_rx_crc_err;
+    uint32_t ctlr_rx_empty;
+
+    /** PDUs acknowledged by the peer (empty ones included), PDUs
+     * retransmitted, and empty PDUs acknowledged.
+     */
+    uint32_t ctlr_tx_ack;
+    uint32_t ctlr_tx_retry;
+    uint32_t ctlr_tx_empty;
+
+    /** ACL packets completed, and their average and maximum time from being
+     * queued in the controller to being acknowledged (units: us).
+     */
+    uint32_t ctlr_tx_pkts;
+    uint32_t ctlr_tx_lat_avg;
+    uint32_t ctlr_tx_lat_max;
+
+    /** ACL fragments handed to the controller, and how many of them were
+     * sent while the controller had no free buffer.
+     */
+    uint32_t host_tx_frags;
+    uint32_t host_tx_no_credit;
+
+    /** Average and maximum time from handing a fragment to the controller
+     * to the controller reporting it completed (units: ms).
+     */
+    uint32_t host_comp_lat_avg;
+    uint32_t host_comp_lat_max;
+
+    /** Fragments currently in the controller, and the most there have been
+     * at once.
+     */
+    uint16_t host_outstanding;
+    uint16_t host_max_outstanding;
+};
+
+/**
+ * Configures the adaptive connection parameter manager; see
+ * ble_gap_cpm_enable().
+ */
+struct ble_gap_cpm_params {
+    /** Parameters to request while the connection is busy. */
+    struct ble_gap_upd_params busy;
+
+    /** Parameters to request once the connection has gone idle. */
+    struct ble_gap_upd_params idle;
+
+    /**
+     * L2CAP payload throughput (bytes per second, both directions combined)
+     * at which the connection counts as busy even if nothing is queued.
+     */
+    uint32_t busy_bps;
+
+    /**
+     * How long the connection must stay quiet before the idle parameters
+     * get requested (units: ms).
+     */
+    uint32_t idle_ms;
+};
+
 struct ble_gap_passkey_params {
     uint8_t action;
     uint32_t numcmp;
@@ -222,7 +322,11 @@ struct ble_gap_disc_desc {
     int8_t rssi;
     uint8_t addr[6];
 
-    /*** LE advertising report fields; both null if no data present. */
+    /***
+     * LE advertising report fields; both null if no data present.  fields is
+     * also null if BLE_GAP_DISC_PARSE_FIELDS is disabled; use
+     * ble_hs_adv_find_field() and friends to inspect the raw data instead.
+     */
     uint8_t *data;
     struct ble_hs_adv_fields *fields;
 
@@ -542,6 +646,9 @@ int ble_gap_adv_stop(void);
 int ble_gap_adv_active(void);
 int ble_gap_adv_set_fields(const struct ble_hs_adv_fields *adv_fields);
 int ble_gap_adv_rsp_set_fields(const struct ble_hs_adv_fields *rsp_fields);
+int ble_gap_adv_update_field(uint8_t type, const void *data, uint8_t data_len);
+int ble_gap_adv_rsp_update_field(uint8_t type, const void *data,
+                                 uint8_t data_len);
 int ble_gap_disc(uint8_t own_addr_type, int32_t duration_ms,
                  const struct ble_gap_disc_params *disc_params,
                  ble_gap_event_fn *cb, void *cb_arg);
@@ -565,6 +672,13 @@ int ble_gap_pair_initiate(uint16_t conn_handle);
 int ble_gap_encryption_initiate(uint16_t conn_handle, const uint8_t *ltk,
                                 uint16_t ediv, uint64_t rand_val, int auth);
 int ble_gap_conn_rssi(uint16_t conn_handle, int8_t *out_rssi);
+int ble_gap_tput_tune(uint16_t conn_handle, uint16_t itvl);
+int ble_gap_conn_tput(uint16_t conn_handle, struct ble_gap_conn_tput *out_tput);
+int ble_gap_conn_perf(uint16_t conn_handle, int reset,
+                      struct ble_gap_conn_perf *out_perf);
+int ble_gap_cpm_enable(uint16_t conn_handle,
+                       const struct ble_gap_cpm_params *params);
+int ble_gap_cpm_disable(uint16_t conn_handle);
 
 #ifdef __cplusplus
 }
@@ -22,6 +22,7 @@
 
 #include <inttypes.h>
 #include "host/ble_att.h"
+#include "host/ble_uuid.h"
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -188,6 +189,8 @@ int ble_gattc_notify_custom(uint16_t conn_handle, uint16_t att_handle,
                             struct os_mbuf *om);
 int ble_gattc_notify(uint16_t conn_handle, uint16_t chr_val_handle);
 int ble_gattc_indicate(uint16_t conn_handle, uint16_t chr_val_handle);
+int ble_gattc_disc_cache_clear(uint8_t peer_addr_type,
+                               const uint8_t *peer_addr);
 
 int ble_gattc_init(void);
 
@@ -200,9 +203,17 @@ typedef int ble_gatt_access_fn(uint16_t conn_handle, uint16_t attr_handle,
 typedef uint16_t ble_gatt_chr_flags;
 
 struct ble_gatt_chr_def {
+    /**
+     * The characteristic's UUID in its native width; use the
+     * BLE_UUID16_DECLARE macro for 16-bit UUIDs.  Takes precedence over
+     * uuid128.  If both are NULL, there are no more characteristics in the
+     * service.
+     */
+    const ble_uuid_t *uuid;
+
     /**
      * Pointer to first element in a uint8_t[16]; use the BLE_UUID16 macro for
-     * 16-bit UUIDs; NULL if there are no more characteristics in the service.
+     * 16-bit UUIDs.  Only consulted if uuid is NULL.
      */
     const uint8_t *uuid128;
 
@@ -241,9 +252,15 @@ struct ble_gatt_svc_def {
      */
     uint8_t type;
 
+    /**
+     * The service's UUID in its native width; use the BLE_UUID16_DECLARE
+     * macro for 16-bit UUIDs.  Takes precedence over uuid128.
+     */
+    const ble_uuid_t *uuid;
+
     /**
      * Pointer to first element in a uint8_t[16]; use the BLE_UUID16 macro for
-     * 16-bit UUIDs.
+     * 16-bit UUIDs.  Only consulted if uuid is NULL.
      */
     const uint8_t *uuid128;
 
@@ -262,9 +279,16 @@ struct ble_gatt_svc_def {
 };
 
 struct ble_gatt_dsc_def {
+    /**
+     * The descriptor's UUID in its native width; use the BLE_UUID16_DECLARE
+     * macro for 16-bit UUIDs.  Takes precedence over uuid128.  If both are
+     * NULL, there are no more descriptors in the characteristic.
+     */
+    const ble_uuid_t *uuid;
+
     /**
      * The first element in a uint8_t[16]; use the BLE_UUID16 macro for 16-bit
-     * UUIDs; NULL if there are no more descriptors in the characteristic.
+     * UUIDs.  Only consulted if uuid is NULL.
      */
     uint8_t *uuid128;
 
@@ -67,6 +67,7 @@ struct os_event;
 #define BLE_HS_ENOMEM_EVT           20
 #define BLE_HS_ENOADDR              21
 #define BLE_HS_ENOTSYNCED           22
+#define BLE_HS_ESTALLED             23
 
 #define BLE_HS_ERR_ATT_BASE         0x100   /* 256 */
 #define BLE_HS_ATT_ERR(x)           ((x) ? BLE_HS_ERR_ATT_BASE + (x) : 0)
@@ -152,6 +153,7 @@ struct ble_hs_cfg {
 extern struct ble_hs_cfg ble_hs_cfg;
 
 int ble_hs_synced(void);
+int ble_hs_tx_avail_pkts(void);
 int ble_hs_start(void);
 void ble_hs_evq_set(struct os_eventq *evq);
 void ble_hs_init(void);
@@ -104,6 +104,16 @@ struct ble_hs_adv_fields {
     uint8_t mfg_data_len;
 };
 
+/**
+ * A single AD structure within raw advertising data.  The data pointer refers
+ * into the buffer being walked; nothing is copied.
+ */
+struct ble_hs_adv_field {
+    uint8_t type;
+    uint8_t data_len;
+    const uint8_t *data;
+};
+
 #define BLE_HS_ADV_TYPE_FLAGS                   0x01
 #define BLE_HS_ADV_TYPE_INCOMP_UUIDS16          0x02
 #define BLE_HS_ADV_TYPE_COMP_UUIDS16            0x03
@@ -178,6 +188,13 @@ struct ble_hs_adv_fields {
 
 #define BLE_HS_ADV_SVC_DATA_UUID128_MIN_LEN     16
 
+int ble_hs_adv_iter_next(const uint8_t *src, uint8_t src_len, uint8_t *off,
+                         struct ble_hs_adv_field *field);
+int ble_hs_adv_find_field(uint8_t type, const uint8_t *src, uint8_t src_len,
+                          struct ble_hs_adv_field *field);
+int ble_hs_adv_find_uuid16(uint16_t uuid16, const uint8_t *src,
+                           uint8_t src_len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -27,6 +27,8 @@ extern "C" {
 
 struct ble_l2cap_sig_update_req;
 struct ble_hs_conn;
+struct ble_l2cap_chan;
+struct os_mbuf;
 
 #define BLE_L2CAP_SIG_OP_REJECT                 0x01
 #define BLE_L2CAP_SIG_OP_CONNECT_REQ            0x02
@@ -56,6 +58,16 @@ struct ble_hs_conn;
 #define BLE_L2CAP_SIG_ERR_MTU_EXCEEDED          0x0001
 #define BLE_L2CAP_SIG_ERR_INVALID_CID           0x0002
 
+#define BLE_L2CAP_COC_ERR_PSM_NOT_SUPP          0x0002
+#define BLE_L2CAP_COC_ERR_NO_RESOURCES          0x0004
+#define BLE_L2CAP_COC_ERR_INSUFFICIENT_AUTHEN   0x0005
+#define BLE_L2CAP_COC_ERR_INSUFFICIENT_AUTHOR   0x0006
+#define BLE_L2CAP_COC_ERR_INSUFFICIENT_KEY_SZ   0x0007
+#define BLE_L2CAP_COC_ERR_INSUFFICIENT_ENC      0x0008
+#define BLE_L2CAP_COC_ERR_INVALID_SOURCE_CID    0x0009
+#define BLE_L2CAP_COC_ERR_SOURCE_CID_ALREADY_USED   0x000a
+#define BLE_L2CAP_COC_ERR_UNACCEPTABLE_PARAMETERS   0x000b
+
 typedef void ble_l2cap_sig_update_fn(uint16_t conn_handle, int status,
                                      void *arg);
 
@@ -70,6 +82,74 @@ int ble_l2cap_sig_update(uint16_t conn_handle,
                          struct ble_l2cap_sig_update_params *params,
                          ble_l2cap_sig_update_fn *cb, void *cb_arg);
 
+/*** LE credit based connection oriented channels. */
+
+#define BLE_L2CAP_EVENT_COC_CONNECTED           0
+#define BLE_L2CAP_EVENT_COC_DISCONNECTED        1
+#define BLE_L2CAP_EVENT_COC_ACCEPT              2
+#define BLE_L2CAP_EVENT_COC_DATA_RECEIVED       3
+#define BLE_L2CAP_EVENT_COC_TX_UNSTALLED        4
+
+struct ble_l2cap_event {
+    int type;
+    uint16_t conn_handle;
+    struct ble_l2cap_chan *chan;
+
+    union {
+        /**
+         * Represents a channel connection attempt, successful or not.  Valid
+         * for the following event types:
+         *     o BLE_L2CAP_EVENT_COC_CONNECTED
+         */
+        struct {
+            /** 0 if the channel is open; a BLE_HS_E<...> code otherwise. */
+            int status;
+        } connect;
+
+        /**
+         * Represents a peer asking to open a channel to one of our servers.
+         * The application provides a receive buffer with
+         * ble_l2cap_recv_ready(), and returns 0 to accept the channel.
+         * Valid for the following event types:
+         *     o BLE_L2CAP_EVENT_COC_ACCEPT
+         */
+        struct {
+            /** The largest SDU the peer can receive. */
+            uint16_t peer_sdu_size;
+        } accept;
+
+        /**
+         * Represents a complete incoming SDU.  The application takes
+         * ownership of the buffer.  Valid for the following event types:
+         *     o BLE_L2CAP_EVENT_COC_DATA_RECEIVED
+         */
+        struct {
+            struct os_mbuf *sdu_rx;
+        } receive;
+
+        /**
+         * Represents a stalled transmission having completed; another SDU
+         * can be sent.  Valid for the following event types:
+         *     o BLE_L2CAP_EVENT_COC_TX_UNSTALLED
+         */
+        struct {
+            /** 0 if the SDU was sent; a BLE_HS_E<...> code otherwise. */
+            int status;
+        } tx_unstalled;
+    };
+};
+
+typedef int ble_l2cap_event_fn(struct ble_l2cap_event *event, void *arg);
+
+int ble_l2cap_create_server(uint16_t psm, uint16_t mtu,
+                            ble_l2cap_event_fn *cb, void *cb_arg);
+int ble_l2cap_connect(uint16_t conn_handle, uint16_t psm, uint16_t mtu,
+                      struct os_mbuf *sdu_rx,
+                      ble_l2cap_event_fn *cb, void *cb_arg);
+int ble_l2cap_disconnect(struct ble_l2cap_chan *chan);
+int ble_l2cap_send(struct ble_l2cap_chan *chan, struct os_mbuf *sdu_tx);
+int ble_l2cap_recv_ready(struct ble_l2cap_chan *chan, struct os_mbuf *sdu_rx);
+
 #ifdef __cplusplus
 }
 #endif
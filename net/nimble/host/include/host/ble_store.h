@@ -29,9 +29,18 @@ extern "C" {
 #define BLE_STORE_OBJ_TYPE_OUR_SEC      1
 #define BLE_STORE_OBJ_TYPE_PEER_SEC     2
 #define BLE_STORE_OBJ_TYPE_CCCD         3
+#define BLE_STORE_OBJ_TYPE_GATT_DISC    4
 
 #define BLE_STORE_ADDR_TYPE_NONE        0xff
 
+/** GATT discovery cache record kinds. */
+#define BLE_STORE_GATT_DISC_SVC         1
+#define BLE_STORE_GATT_DISC_CHR         2
+#define BLE_STORE_GATT_DISC_DSC         3
+#define BLE_STORE_GATT_DISC_SVCS_DONE   4
+#define BLE_STORE_GATT_DISC_CHRS_DONE   5
+#define BLE_STORE_GATT_DISC_DSCS_DONE   6
+
 /**
  * Used as a key for lookups of security material.  This struct corresponds to
  * the following store object types:
@@ -121,6 +130,57 @@ struct ble_store_value_cccd {
     unsigned value_changed:1;
 };
 
+/**
+ * Used as a key for lookups of cached GATT discovery results.  This struct
+ * corresponds to the BLE_STORE_OBJ_TYPE_GATT_DISC store object type.
+ */
+struct ble_store_key_gatt_disc {
+    /**
+     * Key by peer identity address;
+     * peer_addr_type=BLE_STORE_ADDR_TYPE_NONE means don't key off peer.
+     */
+    uint8_t peer_addr[6];
+    uint8_t peer_addr_type;
+
+    /**
+     * Key by record kind (BLE_STORE_GATT_DISC_[...]);
+     * kind=0 means don't key off kind.
+     */
+    uint8_t kind;
+
+    /** Key by handle; handle=0 means don't key off handle. */
+    uint16_t handle;
+
+    /** Number of results to skip; 0 means retrieve the first match. */
+    uint8_t idx;
+};
+
+/**
+ * Represents a cached GATT discovery result.  This struct corresponds to the
+ * BLE_STORE_OBJ_TYPE_GATT_DISC store object type.  The meaning of the handle
+ * fields depends on the record kind:
+ *
+ *     kind         handle              end_handle
+ *     SVC          start handle        end handle
+ *     CHR          definition handle   value handle
+ *     DSC          descriptor handle   characteristic value handle
+ *     SVCS_DONE    0                   0
+ *     CHRS_DONE    start handle        end handle
+ *     DSCS_DONE    chr value handle    chr end handle
+ *
+ * A *_DONE record indicates that the corresponding discovery procedure ran to
+ * completion and that every result it reported is in the store.
+ */
+struct ble_store_value_gatt_disc {
+    uint8_t peer_addr[6];
+    uint8_t peer_addr_type;
+    uint8_t kind;
+    uint16_t handle;
+    uint16_t end_handle;
+    uint8_t properties;
+    uint8_t uuid128[16];
+};
+
 /**
  * Used as a key for store lookups.  This union must be accompanied by an
  * object type code to indicate which field is valid.
@@ -128,6 +188,7 @@ struct ble_store_value_cccd {
 union ble_store_key {
     struct ble_store_key_sec sec;
     struct ble_store_key_cccd cccd;
+    struct ble_store_key_gatt_disc gatt_disc;
 };
 
 /**
@@ -137,6 +198,7 @@ union ble_store_key {
 union ble_store_value {
     struct ble_store_value_sec sec;
     struct ble_store_value_cccd cccd;
+    struct ble_store_value_gatt_disc gatt_disc;
 };
 
 /**
@@ -206,10 +268,18 @@ int ble_store_read_cccd(struct ble_store_key_cccd *key,
 int ble_store_write_cccd(struct ble_store_value_cccd *value);
 int ble_store_delete_cccd(struct ble_store_key_cccd *key);
 
+int ble_store_read_gatt_disc(struct ble_store_key_gatt_disc *key,
+                             struct ble_store_value_gatt_disc *out_value);
+int ble_store_write_gatt_disc(struct ble_store_value_gatt_disc *value);
+int ble_store_delete_gatt_disc(struct ble_store_key_gatt_disc *key);
+
 void ble_store_key_from_value_sec(struct ble_store_key_sec *out_key,
                                   struct ble_store_value_sec *value);
 void ble_store_key_from_value_cccd(struct ble_store_key_cccd *out_key,
                                    struct ble_store_value_cccd *value);
+void ble_store_key_from_value_gatt_disc(
+    struct ble_store_key_gatt_disc *out_key,
+    struct ble_store_value_gatt_disc *value);
 
 typedef int ble_store_iterator_fn(int obj_type,
                                   union ble_store_value *val,
@@ -21,12 +21,90 @@
 #define H_BLE_UUID_
 
 #include <inttypes.h>
+#include <stddef.h>
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 struct os_mbuf;
 
+/*** Compact UUIDs. */
+
+#define BLE_UUID_TYPE_16                16
+#define BLE_UUID_TYPE_32                32
+#define BLE_UUID_TYPE_128               128
+
+/**
+ * A UUID in its native width.  The type field tells which of the structures
+ * below the UUID really is; code passes UUIDs around as pointers to this
+ * header.
+ */
+typedef struct {
+    uint8_t type;
+} ble_uuid_t;
+
+typedef struct {
+    ble_uuid_t u;
+    uint16_t value;
+} ble_uuid16_t;
+
+typedef struct {
+    ble_uuid_t u;
+    uint32_t value;
+} ble_uuid32_t;
+
+typedef struct {
+    ble_uuid_t u;
+    uint8_t value[16];      /* Little endian, as sent over the air. */
+} ble_uuid128_t;
+
+/** Storage large enough for a UUID of any width. */
+typedef union {
+    ble_uuid_t u;
+    ble_uuid16_t u16;
+    ble_uuid32_t u32;
+    ble_uuid128_t u128;
+} ble_uuid_any_t;
+
+#define BLE_UUID16_INIT(uuid16)                                             \
+    {                                                                       \
+        .u.type = BLE_UUID_TYPE_16,                                         \
+        .value = (uuid16),                                                  \
+    }
+
+#define BLE_UUID32_INIT(uuid32)                                             \
+    {                                                                       \
+        .u.type = BLE_UUID_TYPE_32,                                         \
+        .value = (uuid32),                                                  \
+    }
+
+#define BLE_UUID128_INIT(uuid128...)                                        \
+    {                                                                       \
+        .u.type = BLE_UUID_TYPE_128,                                        \
+        .value = { uuid128 },                                               \
+    }
+
+/**
+ * Expand to a pointer to an anonymous UUID of the given width, suitable for
+ * the uuid field of a GATT service definition.
+ */
+#define BLE_UUID16_DECLARE(uuid16)                                          \
+    ((const ble_uuid_t *) (&(const ble_uuid16_t) BLE_UUID16_INIT(uuid16)))
+
+#define BLE_UUID32_DECLARE(uuid32)                                          \
+    ((const ble_uuid_t *) (&(const ble_uuid32_t) BLE_UUID32_INIT(uuid32)))
+
+#define BLE_UUID128_DECLARE(uuid128...)                                     \
+    ((const ble_uuid_t *) (&(const ble_uuid128_t) BLE_UUID128_INIT(uuid128)))
+
+int ble_uuid_init_from_buf(ble_uuid_any_t *uuid, const void *buf, size_t len);
+int ble_uuid_cmp(const ble_uuid_t *uuid1, const ble_uuid_t *uuid2);
+void ble_uuid_copy(ble_uuid_any_t *dst, const ble_uuid_t *src);
+void ble_uuid_to_128(const ble_uuid_t *uuid, void *dst);
+uint16_t ble_uuid_u16(const ble_uuid_t *uuid);
+
+/*** 128-bit byte array UUIDs. */
+
 uint16_t ble_uuid_128_to_16(const void *uuid128);
 int ble_uuid_16_to_128(uint16_t uuid16, void *dst);
 
@@ -20,10 +20,14 @@
 #ifndef _BLEUART_H_
 #define _BLEUART_H_
 
+#include <inttypes.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+struct os_eventq;
+
 void
 bleuart_init(void);
 int
@@ -32,6 +36,8 @@ int
 bleuart_gatt_svr_init(void);
 void
 bleuart_set_conn_handle(uint16_t conn_handle);
+void
+bleuart_evq_set(struct os_eventq *evq);
 
 extern const uint8_t gatt_svr_svc_uart[16];
 
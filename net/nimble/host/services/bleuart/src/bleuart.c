@@ -22,7 +22,9 @@
 #include <string.h>
 
 #include "sysinit/sysinit.h"
+#include "os/os.h"
 #include "host/ble_hs.h"
+#include "nimble/ble.h"
 #include "bleuart/bleuart.h"
 #include "os/endian.h"
 #include "console/console.h"
@@ -33,10 +35,60 @@ uint16_t g_bleuart_attr_read_handle;
 /* ble uart attr write handle */
 uint16_t g_bleuart_attr_write_handle;
 
+#if MYNEWT_VAL(BLEUART_RX_CREDITS)
+/* ble uart attr credit handle */
+uint16_t g_bleuart_attr_credit_handle;
+#endif
+
 /* Pointer to a console buffer */
 char *console_buf;
 
-uint16_t g_console_conn_handle;
+uint16_t g_console_conn_handle = BLE_HS_CONN_HANDLE_NONE;
+
+/**
+ * Console input waiting to be notified to the peer.  Each entry is an ATT
+ * packet ready to be handed to the host as is.  In line mode every console
+ * line gets its own entry; in stream mode input is packed into entries of up
+ * to one ATT payload.
+ */
+static STAILQ_HEAD(, os_mbuf_pkthdr) bleuart_tx_q =
+    STAILQ_HEAD_INITIALIZER(bleuart_tx_q);
+
+/* Number of bytes in bleuart_tx_q. */
+static uint16_t bleuart_tx_q_len;
+
+/* Time the newest, partially filled entry received its first byte. */
+static os_time_t bleuart_tx_tail_time;
+
+/* Bytes of the current console line read so far. */
+static int bleuart_rx_off;
+
+#if MYNEWT_VAL(BLEUART_RX_CREDITS)
+/*
+ * Credits are counted in notifications or writes without response.  A peer
+ * opts in by writing its first grant to the credit characteristic; until
+ * then neither side is limited.
+ */
+static uint8_t bleuart_credits_on;
+static uint16_t bleuart_tx_credits;
+static uint16_t bleuart_rx_credits_owed;
+#endif
+
+static struct os_eventq *bleuart_evq;
+static struct os_callout bleuart_tx_timer;
+static uint8_t bleuart_tx_timer_ready;
+
+static void bleuart_tx_ev_cb(struct os_event *ev);
+static void bleuart_rx_ev_cb(struct os_event *ev);
+
+static struct os_event bleuart_tx_ev = {
+    .ev_cb = bleuart_tx_ev_cb,
+};
+
+static struct os_event bleuart_rx_ev = {
+    .ev_cb = bleuart_rx_ev_cb,
+};
+
 /**
  * The vendor specific "bleuart" service consists of one write no-rsp characteristic
  * and one notification only read charateristic
@@ -44,6 +96,8 @@ uint16_t g_console_conn_handle;
  *       over a non-encrypted connection
  *     o "read": a single-byte characteristic that can always be read only via
  *       notifications
+ * With BLEUART_RX_CREDITS enabled, a third characteristic carries flow control
+ * credits in both directions as 16-bit little-endian counts.
  */
 
 /* {6E400001-B5A3-F393-E0A9-E50E24DCCA9E} */
@@ -65,10 +119,24 @@ const uint8_t gatt_svr_chr_uart_read[16] = {
     0x93, 0xf3, 0xa3, 0xb5, 0x03, 0x00, 0x40, 0x6e
 };
 
+#if MYNEWT_VAL(BLEUART_RX_CREDITS)
+/* {6E400004-B5A3-F393-E0A9-E50E24DCCA9E} */
+const uint8_t gatt_svr_chr_uart_credit[16] = {
+    0x9e, 0xca, 0xdc, 0x24, 0x0e, 0xe5, 0xa9, 0xe0,
+    0x93, 0xf3, 0xa3, 0xb5, 0x04, 0x00, 0x40, 0x6e
+};
+#endif
+
 static int
 gatt_svr_chr_access_uart_write(uint16_t conn_handle, uint16_t attr_handle,
                               struct ble_gatt_access_ctxt *ctxt, void *arg);
 
+#if MYNEWT_VAL(BLEUART_RX_CREDITS)
+static int
+gatt_svr_chr_access_uart_credit(uint16_t conn_handle, uint16_t attr_handle,
+                                struct ble_gatt_access_ctxt *ctxt, void *arg);
+#endif
+
 static const struct ble_gatt_svc_def gatt_svr_svcs[] = {
     {
         /* Service: uart */
@@ -86,6 +154,14 @@ static const struct ble_gatt_svc_def gatt_svr_svcs[] = {
             .flags = BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_NO_RSP,
             .val_handle = &g_bleuart_attr_write_handle,
         }, {
+#if MYNEWT_VAL(BLEUART_RX_CREDITS)
+            /* Characteristic: Credits */
+            .uuid128 = gatt_svr_chr_uart_credit,
+            .access_cb = gatt_svr_chr_access_uart_credit,
+            .flags = BLE_GATT_CHR_F_WRITE_NO_RSP | BLE_GATT_CHR_F_NOTIFY,
+            .val_handle = &g_bleuart_attr_credit_handle,
+        }, {
+#endif
             0, /* No more characteristics in this service */
         } },
     },
@@ -95,18 +171,81 @@ static const struct ble_gatt_svc_def gatt_svr_svcs[] = {
     },
 };
 
+static struct os_eventq *
+bleuart_evq_get(void)
+{
+    os_eventq_ensure(&bleuart_evq, NULL);
+    return bleuart_evq;
+}
+
+/**
+ * Designates the event queue that feeds console input to the peer.  By
+ * default the default event queue is used.
+ *
+ * @param evq                   The event queue to use.
+ */
+void
+bleuart_evq_set(struct os_eventq *evq)
+{
+    os_eventq_designate(&bleuart_evq, evq, NULL);
+}
+
+static void
+bleuart_tx_kick(void)
+{
+    os_eventq_put(bleuart_evq_get(), &bleuart_tx_ev);
+}
+
+static void
+bleuart_tx_retry(os_time_t ticks)
+{
+    if (!bleuart_tx_timer_ready) {
+        os_callout_init(&bleuart_tx_timer, bleuart_evq_get(),
+                        bleuart_tx_ev_cb, NULL);
+        bleuart_tx_timer_ready = 1;
+    }
+
+    if (!os_callout_queued(&bleuart_tx_timer)) {
+        os_callout_reset(&bleuart_tx_timer, ticks);
+    }
+}
+
 static int
 gatt_svr_chr_access_uart_write(uint16_t conn_handle, uint16_t attr_handle,
                                struct ble_gatt_access_ctxt *ctxt, void *arg)
 {
     struct os_mbuf *om = ctxt->om;
+#if MYNEWT_VAL(BLEUART_RX_CREDITS)
+    int kick;
+    os_sr_t sr;
+#endif
+
     switch (ctxt->op) {
         case BLE_GATT_ACCESS_OP_WRITE_CHR:
               while(om) {
                   console_write((char *)om->om_data, om->om_len);
                   om = SLIST_NEXT(om, om_next);
               }
+#if !MYNEWT_VAL(BLEUART_STREAM)
               console_write("\n", 1);
+#endif
+
+#if MYNEWT_VAL(BLEUART_RX_CREDITS)
+              /* The data has been consumed; hand the credit back, batched
+               * to half the window to limit the notification overhead.
+               */
+              OS_ENTER_CRITICAL(sr);
+              kick = 0;
+              if (bleuart_credits_on) {
+                  bleuart_rx_credits_owed++;
+                  kick = bleuart_rx_credits_owed >=
+                         (MYNEWT_VAL(BLEUART_RX_CREDITS) + 1) / 2;
+              }
+              OS_EXIT_CRITICAL(sr);
+              if (kick) {
+                  bleuart_tx_kick();
+              }
+#endif
               return 0;
         default:
             assert(0);
@@ -114,6 +253,88 @@ gatt_svr_chr_access_uart_write(uint16_t conn_handle, uint16_t attr_handle,
     }
 }
 
+#if MYNEWT_VAL(BLEUART_RX_CREDITS)
+static int
+gatt_svr_chr_access_uart_credit(uint16_t conn_handle, uint16_t attr_handle,
+                                struct ble_gatt_access_ctxt *ctxt, void *arg)
+{
+    uint8_t buf[2];
+    uint16_t credits;
+    os_sr_t sr;
+    int rc;
+
+    if (ctxt->op != BLE_GATT_ACCESS_OP_WRITE_CHR) {
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+
+    if (OS_MBUF_PKTLEN(ctxt->om) != sizeof buf) {
+        return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+    }
+
+    rc = os_mbuf_copydata(ctxt->om, 0, sizeof buf, buf);
+    if (rc != 0) {
+        return BLE_ATT_ERR_UNLIKELY;
+    }
+    credits = le16toh(buf);
+
+    OS_ENTER_CRITICAL(sr);
+    if (!bleuart_credits_on) {
+        /* First grant from the peer; answer with our receive window. */
+        bleuart_credits_on = 1;
+        bleuart_rx_credits_owed = MYNEWT_VAL(BLEUART_RX_CREDITS);
+    }
+    if (credits > UINT16_MAX - bleuart_tx_credits) {
+        bleuart_tx_credits = UINT16_MAX;
+    } else {
+        bleuart_tx_credits += credits;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    bleuart_tx_kick();
+    return 0;
+}
+
+/**
+ * Returns the credits owed to the peer in a notification on the credit
+ * characteristic.
+ */
+static void
+bleuart_rx_credits_send(void)
+{
+    struct os_mbuf *om;
+    uint16_t owed;
+    uint8_t buf[2];
+    os_sr_t sr;
+    int rc;
+
+    OS_ENTER_CRITICAL(sr);
+    owed = bleuart_rx_credits_owed;
+    OS_EXIT_CRITICAL(sr);
+
+    if (owed == 0) {
+        return;
+    }
+
+    htole16(buf, owed);
+    om = ble_hs_mbuf_from_flat(buf, sizeof buf);
+    if (om == NULL) {
+        bleuart_tx_retry(1);
+        return;
+    }
+
+    rc = ble_gattc_notify_custom(g_console_conn_handle,
+                                 g_bleuart_attr_credit_handle, om);
+    if (rc != 0) {
+        bleuart_tx_retry(1);
+        return;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    bleuart_rx_credits_owed -= owed;
+    OS_EXIT_CRITICAL(sr);
+}
+#endif
+
 /**
  * bleuart GATT server initialization
  *
@@ -140,47 +361,273 @@ err:
 }
 
 /**
- * Reads console and sends data over BLE
+ * Returns the largest notification payload the current connection carries.
  */
+static uint16_t
+bleuart_tx_payload_max(void)
+{
+    uint16_t mtu;
+
+    mtu = ble_att_mtu(g_console_conn_handle);
+    if (mtu < BLE_ATT_MTU_DFLT) {
+        mtu = BLE_ATT_MTU_DFLT;
+    }
+
+    return mtu - 3;
+}
+
+#if MYNEWT_VAL(BLEUART_STREAM)
+static os_time_t
+bleuart_tx_coalesce_ticks(void)
+{
+    uint32_t ticks;
+    int rc;
+
+    rc = os_time_ms_to_ticks(MYNEWT_VAL(BLEUART_TX_COALESCE_MS), &ticks);
+    if (rc != 0) {
+        return 0;
+    }
+
+    return ticks;
+}
+#endif
+
 static void
-bleuart_uart_read(void)
+bleuart_tx_q_flush(void)
+{
+    struct os_mbuf_pkthdr *omp;
+
+    while ((omp = STAILQ_FIRST(&bleuart_tx_q)) != NULL) {
+        STAILQ_REMOVE_HEAD(&bleuart_tx_q, omp_next);
+        os_mbuf_free_chain(OS_MBUF_PKTHDR_TO_MBUF(omp));
+    }
+    bleuart_tx_q_len = 0;
+}
+
+/**
+ * Queues console input for transmission.
+ *
+ * @param data                  The bytes to queue.
+ * @param len                   The number of bytes to queue.
+ * @param pack                  Whether the bytes may share an ATT packet with
+ *                                  previously queued input.
+ *
+ * @return                      0 on success; BLE_HS_ENOMEM if the input
+ *                                  could not be queued.
+ */
+static int
+bleuart_tx_enqueue(const char *data, int len, int pack)
 {
+    struct os_mbuf_pkthdr *omp;
+    struct os_mbuf *om;
+    uint16_t max;
+    int chunk;
     int rc;
-    int off;
-    int full_line;
+
+    max = bleuart_tx_payload_max();
+
+    while (len > 0) {
+        om = NULL;
+        if (pack) {
+            omp = STAILQ_LAST(&bleuart_tx_q, os_mbuf_pkthdr, omp_next);
+            if (omp != NULL && omp->omp_len < max) {
+                om = OS_MBUF_PKTHDR_TO_MBUF(omp);
+            }
+        }
+
+        if (om == NULL) {
+            om = ble_hs_mbuf_att_pkt();
+            if (om == NULL) {
+                return BLE_HS_ENOMEM;
+            }
+            STAILQ_INSERT_TAIL(&bleuart_tx_q, OS_MBUF_PKTHDR(om), omp_next);
+            bleuart_tx_tail_time = os_time_get();
+        }
+
+        chunk = min(len, max - OS_MBUF_PKTLEN(om));
+        if (!pack) {
+            /* Lines are never split; the host fragments as needed. */
+            chunk = len;
+        }
+
+        rc = os_mbuf_append(om, data, chunk);
+        if (rc != 0) {
+            return BLE_HS_ENOMEM;
+        }
+
+        bleuart_tx_q_len += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+
+    return 0;
+}
+
+/**
+ * Hands queued input to the host as long as the controller has free ACL
+ * buffers and, if the peer uses credits, the peer can take more.  Sending is
+ * resumed by a timer when the controller is full and by the peer's next
+ * grant when credits run out.
+ */
+static void
+bleuart_tx_drain(void)
+{
+    struct os_mbuf_pkthdr *omp;
     struct os_mbuf *om;
+#if MYNEWT_VAL(BLEUART_STREAM)
+    os_time_t coalesce;
+    os_time_t age;
+#endif
+#if MYNEWT_VAL(BLEUART_RX_CREDITS)
+    os_sr_t sr;
+#endif
+    int rc;
 
-    off = 0;
-    while (1) {
-        rc = console_read(console_buf + off,
-                          MYNEWT_VAL(BLEUART_MAX_INPUT) - off, &full_line);
-        if (rc <= 0 && !full_line) {
-            continue;
+    if (g_console_conn_handle == BLE_HS_CONN_HANDLE_NONE) {
+        return;
+    }
+
+#if MYNEWT_VAL(BLEUART_RX_CREDITS)
+    bleuart_rx_credits_send();
+#endif
+
+    while ((omp = STAILQ_FIRST(&bleuart_tx_q)) != NULL) {
+        if (ble_hs_tx_avail_pkts() <= 0) {
+            bleuart_tx_retry(1);
+            break;
         }
-        off += rc;
-        if (!full_line) {
+
+#if MYNEWT_VAL(BLEUART_RX_CREDITS)
+        if (bleuart_credits_on && bleuart_tx_credits == 0) {
+            break;
+        }
+#endif
+
+#if MYNEWT_VAL(BLEUART_STREAM)
+        /* Give a partially filled last packet a moment to fill up. */
+        if (STAILQ_NEXT(omp, omp_next) == NULL &&
+            omp->omp_len < bleuart_tx_payload_max()) {
+
+            coalesce = bleuart_tx_coalesce_ticks();
+            age = os_time_get() - bleuart_tx_tail_time;
+            if (age < coalesce) {
+                bleuart_tx_retry(coalesce - age);
+                break;
+            }
+        }
+#endif
+
+        STAILQ_REMOVE_HEAD(&bleuart_tx_q, omp_next);
+        bleuart_tx_q_len -= omp->omp_len;
+        om = OS_MBUF_PKTHDR_TO_MBUF(omp);
+
+        rc = ble_gattc_notify_custom(g_console_conn_handle,
+                                     g_bleuart_attr_read_handle, om);
+        if (rc != 0) {
+            /* The host consumed the packet; it is lost. */
             continue;
         }
 
-        om = ble_hs_mbuf_from_flat(console_buf, off);
-        if (!om) {
-            return;
+#if MYNEWT_VAL(BLEUART_RX_CREDITS)
+        OS_ENTER_CRITICAL(sr);
+        if (bleuart_credits_on) {
+            bleuart_tx_credits--;
         }
-        ble_gattc_notify_custom(g_console_conn_handle,
-                                g_bleuart_attr_read_handle, om);
-        off = 0;
-        break;
+        OS_EXIT_CRITICAL(sr);
+#endif
+    }
+
+    /* Room may have been freed for console input that was left waiting. */
+    if (bleuart_tx_q_len < MYNEWT_VAL(BLEUART_TX_BUF_SIZE)) {
+        os_eventq_put(bleuart_evq_get(), &bleuart_rx_ev);
     }
 }
 
+static void
+bleuart_tx_ev_cb(struct os_event *ev)
+{
+    bleuart_tx_drain();
+}
+
+/**
+ * Reads console input into the transmit queue, until the console is empty
+ * or the queue is full.
+ */
+static void
+bleuart_rx_ev_cb(struct os_event *ev)
+{
+    int full_line;
+    int rc;
+
+    while (bleuart_tx_q_len < MYNEWT_VAL(BLEUART_TX_BUF_SIZE)) {
+        /* Leave room for the newline in stream mode. */
+        rc = console_read(console_buf + bleuart_rx_off,
+                          MYNEWT_VAL(BLEUART_MAX_INPUT) - 1 - bleuart_rx_off,
+                          &full_line);
+        if (rc <= 0 && !full_line) {
+            break;
+        }
+        bleuart_rx_off += rc;
+
+#if MYNEWT_VAL(BLEUART_STREAM)
+        if (full_line) {
+            console_buf[bleuart_rx_off++] = '\n';
+        }
+        rc = bleuart_tx_enqueue(console_buf, bleuart_rx_off, 1);
+#else
+        if (!full_line &&
+            bleuart_rx_off < MYNEWT_VAL(BLEUART_MAX_INPUT) - 1) {
+
+            continue;
+        }
+        rc = bleuart_tx_enqueue(console_buf, bleuart_rx_off, 0);
+#endif
+        bleuart_rx_off = 0;
+        if (rc != 0) {
+            /* Out of buffers; the input is lost. */
+            break;
+        }
+    }
+
+    bleuart_tx_drain();
+}
+
+/**
+ * Called by the console, in interrupt context, when input is ready.
+ */
+static void
+bleuart_uart_read(void)
+{
+    os_eventq_put(bleuart_evq_get(), &bleuart_rx_ev);
+}
+
 /**
  * Sets the global connection handle
  *
- * @param connection handle
+ * @param connection handle; BLE_HS_CONN_HANDLE_NONE when the connection
+ *                              is gone.
  */
 void
 bleuart_set_conn_handle(uint16_t conn_handle) {
+#if MYNEWT_VAL(BLEUART_RX_CREDITS)
+    os_sr_t sr;
+#endif
+
     g_console_conn_handle = conn_handle;
+
+#if MYNEWT_VAL(BLEUART_RX_CREDITS)
+    OS_ENTER_CRITICAL(sr);
+    bleuart_credits_on = 0;
+    bleuart_tx_credits = 0;
+    bleuart_rx_credits_owed = 0;
+    OS_EXIT_CRITICAL(sr);
+#endif
+
+    if (conn_handle == BLE_HS_CONN_HANDLE_NONE) {
+        bleuart_tx_q_flush();
+    } else {
+        bleuart_tx_kick();
+    }
 }
 
 /**
@@ -19,6 +19,7 @@
 
 #include <stddef.h>
 #include <errno.h>
+#include <limits.h>
 #include "bsp/bsp.h"
 #include "ble_hs_priv.h"
 
@@ -121,6 +122,12 @@ STATS_NAME_START(ble_att_stats)
     STATS_NAME(ble_att_stats, indicate_rsp_tx)
     STATS_NAME(ble_att_stats, write_cmd_rx)
     STATS_NAME(ble_att_stats, write_cmd_tx)
+    STATS_NAME(ble_att_stats, notify_q_coalesced)
+    STATS_NAME(ble_att_stats, notify_q_full)
+    STATS_NAME(ble_att_stats, notify_q_tx_bytes)
+    STATS_NAME(ble_att_stats, notify_q_fair_defer)
+    STATS_NAME(ble_att_stats, read_copy_bytes)
+    STATS_NAME(ble_att_stats, write_copy_bytes)
 STATS_NAME_END(ble_att_stats)
 
 static const struct ble_att_rx_dispatch_entry *
@@ -399,6 +406,240 @@ ble_att_truncate_to_mtu(const struct ble_l2cap_chan *att_chan,
     }
 }
 
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+
+static uint16_t
+ble_att_notify_q_handle(struct os_mbuf *om)
+{
+    uint8_t buf[2];
+    int rc;
+
+    rc = os_mbuf_copydata(om, 1, sizeof buf, buf);
+    if (rc != 0) {
+        return 0;
+    }
+
+    return le16toh(buf);
+}
+
+/**
+ * Calculates how many controller ACL buffers a single connection may occupy
+ * when draining its notification queue.  The controller's buffers are shared
+ * by all connections; they are split evenly between the connections that have
+ * notifications queued or packets outstanding so that one busy connection
+ * cannot starve the others.  Must be called with the host lock held.
+ *
+ * @return                      The connection's share of the buffers;
+ *                              INT_MAX if no other connection is busy.
+ */
+static int
+ble_att_notify_q_fair_share(void)
+{
+    struct ble_hs_conn *conn;
+    int total;
+    int busy;
+
+    busy = 0;
+    for (conn = ble_hs_conn_first();
+         conn != NULL;
+         conn = SLIST_NEXT(conn, bhc_next)) {
+
+        if (conn->bhc_att_svr.basc_notify_q_len > 0 ||
+            conn->bhc_outstanding_pkts > 0) {
+
+            busy++;
+        }
+    }
+
+    if (busy <= 1) {
+        /* Nothing to share; only the free buffer count limits a lone
+         * connection.
+         */
+        return INT_MAX;
+    }
+
+    total = ble_hs_hci_total_pkts();
+    if (total < busy) {
+        return 1;
+    }
+    return total / busy;
+}
+
+/**
+ * Sends queued notifications on the specified connection for as long as the
+ * controller has free ACL buffers for them and the connection has not used up
+ * its fair share of those buffers.  Must be called with the host
+ * lock held.
+ *
+ * @param max_pdus              The maximum number of PDUs to send.
+ *
+ * @return                      The number of PDUs sent.
+ */
+static int
+ble_att_notify_q_drain(struct ble_hs_conn *conn, int max_pdus)
+{
+    struct ble_att_svr_conn *basc;
+    struct os_mbuf_pkthdr *omp;
+    struct ble_l2cap_chan *chan;
+    struct os_mbuf *om;
+    uint16_t len;
+    int share;
+    int sent;
+    int rc;
+
+    BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
+
+    basc = &conn->bhc_att_svr;
+    chan = ble_hs_conn_chan_find(conn, BLE_L2CAP_CID_ATT);
+    if (chan == NULL) {
+        return 0;
+    }
+
+    share = ble_att_notify_q_fair_share();
+
+    sent = 0;
+    while (sent < max_pdus &&
+           (omp = STAILQ_FIRST(&basc->basc_notify_q)) != NULL) {
+
+        om = OS_MBUF_PKTHDR_TO_MBUF(omp);
+        ble_att_truncate_to_mtu(chan, om);
+        len = OS_MBUF_PKTLEN(om);
+
+        if (ble_hs_hci_avail_pkts() <
+            ble_hs_hci_acl_frag_cnt(len + BLE_L2CAP_HDR_SZ)) {
+
+            break;
+        }
+
+        if (conn->bhc_outstanding_pkts >= share) {
+            STATS_INC(ble_att_stats, notify_q_fair_defer);
+            break;
+        }
+
+        STAILQ_REMOVE_HEAD(&basc->basc_notify_q, omp_next);
+        basc->basc_notify_q_len--;
+
+        rc = ble_l2cap_tx(conn, chan, om);
+        if (rc == 0) {
+            STATS_INCN(ble_att_stats, notify_q_tx_bytes, len);
+        }
+        sent++;
+    }
+
+    return sent;
+}
+
+/**
+ * Queues a notification PDU for transmission on the specified connection and
+ * sends as much of the connection's queue as the controller can accept.  If
+ * a notification for the same attribute is already queued, the new PDU
+ * replaces it.  This function consumes the supplied mbuf on success.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOTCONN if the connection is gone;
+ *                              BLE_HS_ENOMEM if the queue is full.
+ */
+int
+ble_att_notify_q_put(uint16_t conn_handle, struct os_mbuf *txom)
+{
+    struct ble_att_svr_conn *basc;
+    struct os_mbuf_pkthdr *omp;
+    struct os_mbuf_pkthdr *new;
+    struct ble_l2cap_chan *chan;
+    struct ble_hs_conn *conn;
+    uint16_t handle;
+    int rc;
+
+    BLE_HS_DBG_ASSERT(OS_MBUF_IS_PKTHDR(txom));
+
+    handle = ble_att_notify_q_handle(txom);
+    new = OS_MBUF_PKTHDR(txom);
+
+    ble_hs_lock();
+
+    ble_att_conn_chan_find(conn_handle, &conn, &chan);
+    if (chan == NULL) {
+        rc = BLE_HS_ENOTCONN;
+        goto done;
+    }
+    basc = &conn->bhc_att_svr;
+
+    STAILQ_FOREACH(omp, &basc->basc_notify_q, omp_next) {
+        if (ble_att_notify_q_handle(OS_MBUF_PKTHDR_TO_MBUF(omp)) == handle) {
+            break;
+        }
+    }
+
+    if (omp != NULL) {
+        /* Only the latest value matters; replace the stale PDU in place. */
+        STAILQ_INSERT_AFTER(&basc->basc_notify_q, omp, new, omp_next);
+        STAILQ_REMOVE(&basc->basc_notify_q, omp, os_mbuf_pkthdr, omp_next);
+        os_mbuf_free_chain(OS_MBUF_PKTHDR_TO_MBUF(omp));
+        STATS_INC(ble_att_stats, notify_q_coalesced);
+    } else if (basc->basc_notify_q_len >=
+               MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE_MAX)) {
+
+        STATS_INC(ble_att_stats, notify_q_full);
+        rc = BLE_HS_ENOMEM;
+        goto done;
+    } else {
+        STAILQ_INSERT_TAIL(&basc->basc_notify_q, new, omp_next);
+        basc->basc_notify_q_len++;
+    }
+
+    ble_att_notify_q_drain(conn, MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE_MAX));
+    rc = 0;
+
+done:
+    ble_hs_unlock();
+    return rc;
+}
+
+/**
+ * Sends queued notifications on all connections, one PDU per connection at a
+ * time, until the queues are empty or the controller runs out of buffers.
+ * Called when the controller reports completed packets.
+ */
+void
+ble_att_notify_q_tx(void)
+{
+    struct ble_hs_conn *conn;
+    int sent;
+
+    ble_hs_lock();
+
+    do {
+        sent = 0;
+        for (conn = ble_hs_conn_first();
+             conn != NULL;
+             conn = SLIST_NEXT(conn, bhc_next)) {
+
+            sent += ble_att_notify_q_drain(conn, 1);
+        }
+    } while (sent > 0);
+
+    ble_hs_unlock();
+}
+
+/**
+ * Frees all notifications queued on the specified connection.
+ */
+void
+ble_att_notify_q_clear(struct ble_hs_conn *conn)
+{
+    struct ble_att_svr_conn *basc;
+    struct os_mbuf_pkthdr *omp;
+
+    basc = &conn->bhc_att_svr;
+    while ((omp = STAILQ_FIRST(&basc->basc_notify_q)) != NULL) {
+        STAILQ_REMOVE_HEAD(&basc->basc_notify_q, omp_next);
+        os_mbuf_free_chain(OS_MBUF_PKTHDR_TO_MBUF(omp));
+    }
+    basc->basc_notify_q_len = 0;
+}
+
+#endif
+
 /**
  * Retrieves the ATT MTU of the specified connection.  If an MTU exchange for
  * this connection has occurred, the MTU is the lower of the two peers'
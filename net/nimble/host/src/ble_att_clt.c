@@ -1116,11 +1116,20 @@ ble_att_clt_tx_notify(uint16_t conn_handle,
     }
     ble_att_notify_req_write(txom->om_data, BLE_ATT_NOTIFY_REQ_BASE_SZ, req);
 
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+    ble_att_inc_tx_stat(BLE_ATT_OP_NOTIFY_REQ);
+    rc = ble_att_notify_q_put(conn_handle, txom);
+    if (rc != 0) {
+        goto err;
+    }
+    txom = NULL;
+#else
     rc = ble_att_clt_tx_req(conn_handle, txom);
     txom = NULL;
     if (rc != 0) {
         goto err;
     }
+#endif
 
     BLE_ATT_LOG_CMD(1, "notify req", conn_handle, ble_att_notify_req_log, req);
 
@@ -24,6 +24,7 @@
 #include "stats/stats.h"
 #include "os/queue.h"
 #include "host/ble_att.h"
+#include "host/ble_uuid.h"
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -101,6 +102,12 @@ STATS_SECT_START(ble_att_stats)
     STATS_SECT_ENTRY(indicate_rsp_tx)
     STATS_SECT_ENTRY(write_cmd_rx)
     STATS_SECT_ENTRY(write_cmd_tx)
+    STATS_SECT_ENTRY(notify_q_coalesced)
+    STATS_SECT_ENTRY(notify_q_full)
+    STATS_SECT_ENTRY(notify_q_tx_bytes)
+    STATS_SECT_ENTRY(notify_q_fair_defer)
+    STATS_SECT_ENTRY(read_copy_bytes)
+    STATS_SECT_ENTRY(write_copy_bytes)
 STATS_SECT_END
 extern STATS_SECT_DECL(ble_att_stats) ble_att_stats;
 
@@ -109,18 +116,34 @@ struct ble_att_prep_entry {
     uint16_t bape_handle;
     uint16_t bape_offset;
 
-    /* XXX: This is wasteful; we should use one mbuf chain for the entire
-     * prepared write, and compress the data into as few mbufs as possible.
+    /* Unless BLE_ATT_SVR_PREP_COALESCE is enabled, each partial write gets
+     * its own entry and mbuf chain.
      */
     struct os_mbuf *bape_value;
 };
 
 SLIST_HEAD(ble_att_prep_entry_list, ble_att_prep_entry);
 
+STAILQ_HEAD(ble_att_notify_q, os_mbuf_pkthdr);
+
 struct ble_att_svr_conn {
     /** This list is sorted by attribute handle ID. */
     struct ble_att_prep_entry_list basc_prep_list;
     uint32_t basc_prep_write_rx_time;
+
+    /** Total attribute value bytes in basc_prep_list. */
+    uint16_t basc_prep_bytes;
+
+#if MYNEWT_VAL(BLE_ATT_SVR_PREP_COALESCE)
+    /** The entry most recently written to; checked first for appending. */
+    struct ble_att_prep_entry *basc_prep_last;
+#endif
+
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+    /** Notification PDUs waiting for a free controller buffer. */
+    struct ble_att_notify_q basc_notify_q;
+    uint8_t basc_notify_q_len;
+#endif
 };
 
 /**
@@ -139,19 +162,26 @@ typedef int ble_att_svr_access_fn(uint16_t conn_handle, uint16_t attr_handle,
                                   uint8_t op, uint16_t offset,
                                   struct os_mbuf **om, void *arg);
 
-int ble_att_svr_register(const uint8_t *uuid, uint8_t flags,
+int ble_att_svr_register(const uint8_t *uuid128, uint8_t flags,
                          uint16_t *handle_id,
                          ble_att_svr_access_fn *cb, void *cb_arg);
+int ble_att_svr_register_uuid(const ble_uuid_t *uuid, uint8_t flags,
+                              uint16_t *handle_id, ble_att_svr_access_fn *cb,
+                              void *cb_arg);
 int ble_att_svr_register_uuid16(uint16_t uuid16, uint8_t flags,
                                 uint16_t *handle_id, ble_att_svr_access_fn *cb,
                                 void *cb_arg);
+int ble_att_svr_register_static(const ble_uuid_t *uuid, uint8_t flags,
+                                uint16_t *handle_id, ble_att_svr_access_fn *cb,
+                                void *cb_arg);
 
-struct ble_att_svr_entry {
-    STAILQ_ENTRY(ble_att_svr_entry) ha_next;
+/** The entry owns its UUID copy; freed when the table is reset. */
+#define BLE_ATT_SVR_F_UUID_OWNED            0x01
 
-    uint8_t ha_uuid[16];
+struct ble_att_svr_entry {
+    const ble_uuid_t *ha_uuid;  /* Always in its shortest form. */
     uint8_t ha_flags;
-    uint8_t ha_pad1;
+    uint8_t ha_svr_flags;
     uint16_t ha_handle_id;
     ble_att_svr_access_fn *ha_cb;
     void *ha_cb_arg;
@@ -165,6 +195,9 @@ struct ble_l2cap_chan *ble_att_create_chan(void);
 void ble_att_conn_chan_find(uint16_t conn_handle, struct ble_hs_conn **out_conn,
                             struct ble_l2cap_chan **out_chan);
 void ble_att_inc_tx_stat(uint8_t att_op);
+int ble_att_notify_q_put(uint16_t conn_handle, struct os_mbuf *txom);
+void ble_att_notify_q_tx(void);
+void ble_att_notify_q_clear(struct ble_hs_conn *conn);
 void ble_att_truncate_to_mtu(const struct ble_l2cap_chan *att_chan,
                              struct os_mbuf *txom);
 void ble_att_set_peer_mtu(struct ble_l2cap_chan *chan, uint16_t peer_mtu);
@@ -182,7 +215,7 @@ int ble_att_svr_start(void);
 
 struct ble_att_svr_entry *
 ble_att_svr_find_by_uuid(struct ble_att_svr_entry *start_at,
-                         const uint8_t *uuid,
+                         const ble_uuid_t *uuid,
                          uint16_t end_handle);
 uint16_t ble_att_svr_prev_handle(void);
 int ble_att_svr_rx_mtu(uint16_t conn_handle, struct os_mbuf **rxom);
@@ -25,13 +25,23 @@
 #include "host/ble_uuid.h"
 #include "ble_hs_priv.h"
 
-STAILQ_HEAD(ble_att_svr_entry_list, ble_att_svr_entry);
-static struct ble_att_svr_entry_list ble_att_svr_list;
+/**
+ * Registered attributes, in handle order.  Entries never get removed and
+ * handles are allocated consecutively, so an entry's index is its handle
+ * minus the first registered handle.  Allocated by ble_att_svr_start() with
+ * room for ble_hs_max_attrs entries.
+ *
+ * The table is only modified while services are registered, before the host
+ * starts accepting connections.  Afterwards it is read-only, so lookups do
+ * not take the host lock.
+ */
+static struct ble_att_svr_entry *ble_att_svr_entries;
+static uint16_t ble_att_svr_entry_cnt;
 
-static uint16_t ble_att_svr_id;
+/** Indices into ble_att_svr_entries, sorted by UUID, then by handle. */
+static uint16_t *ble_att_svr_uuid_idx;
 
-static void *ble_att_svr_entry_mem;
-static struct os_mempool ble_att_svr_entry_pool;
+static uint16_t ble_att_svr_id;
 
 static os_membuf_t ble_att_svr_prep_entry_mem[
     OS_MEMPOOL_SIZE(MYNEWT_VAL(BLE_ATT_MAX_PREP_ENTRIES),
@@ -40,18 +50,10 @@ static os_membuf_t ble_att_svr_prep_entry_mem[
 
 static struct os_mempool ble_att_svr_prep_entry_pool;
 
-static struct ble_att_svr_entry *
-ble_att_svr_entry_alloc(void)
-{
-    struct ble_att_svr_entry *entry;
-
-    entry = os_memblock_get(&ble_att_svr_entry_pool);
-    if (entry != NULL) {
-        memset(entry, 0, sizeof *entry);
-    }
-
-    return entry;
-}
+#define BLE_ATT_SVR_FOREACH(entry)                                  \
+    for ((entry) = ble_att_svr_entries;                             \
+         (entry) < ble_att_svr_entries + ble_att_svr_entry_cnt;     \
+         (entry)++)
 
 /**
  * Allocate the next handle id and return it.
@@ -67,34 +69,133 @@ ble_att_svr_next_id(void)
 }
 
 /**
- * Register a host attribute with the BLE stack.
- *
- * @param ha                    A filled out ble_att structure to register
- * @param handle_id             A pointer to a 16-bit handle ID, which will be
- *                                  the handle that is allocated.
- * @param fn                    The callback function that gets executed when
- *                                  the attribute is operated on.
- *
- * @return 0 on success, non-zero error code on failure.
+ * Compares an attribute entry against a UUID / handle pair in the order used
+ * by the UUID index.
  */
-int
-ble_att_svr_register(const uint8_t *uuid, uint8_t flags, uint16_t *handle_id,
-                     ble_att_svr_access_fn *cb, void *cb_arg)
+static int
+ble_att_svr_uuid_idx_cmp(const struct ble_att_svr_entry *entry,
+                         const ble_uuid_t *uuid, uint16_t handle_id)
+{
+    int rc;
+
+    rc = ble_uuid_cmp(entry->ha_uuid, uuid);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (entry->ha_handle_id < handle_id) {
+        return -1;
+    }
+    if (entry->ha_handle_id > handle_id) {
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Returns the position of the first entry in the UUID index that sorts at or
+ * after the specified UUID / handle pair.
+ */
+static int
+ble_att_svr_uuid_idx_lower(const ble_uuid_t *uuid, uint16_t handle_id)
+{
+    int mid;
+    int lo;
+    int hi;
+
+    lo = 0;
+    hi = ble_att_svr_entry_cnt;
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (ble_att_svr_uuid_idx_cmp(
+                ble_att_svr_entries + ble_att_svr_uuid_idx[mid],
+                uuid, handle_id) < 0) {
+
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/**
+ * Searches the UUID index for the first attribute with the specified UUID and
+ * a handle of at least start_handle.
+ */
+static struct ble_att_svr_entry *
+ble_att_svr_uuid_idx_find(const ble_uuid_t *uuid, uint16_t start_handle)
 {
     struct ble_att_svr_entry *entry;
+    int pos;
+
+    pos = ble_att_svr_uuid_idx_lower(uuid, start_handle);
+    if (pos >= ble_att_svr_entry_cnt) {
+        return NULL;
+    }
+
+    entry = ble_att_svr_entries + ble_att_svr_uuid_idx[pos];
+    if (ble_uuid_cmp(entry->ha_uuid, uuid) != 0) {
+        return NULL;
+    }
+
+    return entry;
+}
+
+/**
+ * Frees the UUID copies owned by registered attributes and empties the
+ * attribute table.
+ */
+static void
+ble_att_svr_reset_entries(void)
+{
+    struct ble_att_svr_entry *entry;
+
+    BLE_ATT_SVR_FOREACH(entry) {
+        if (entry->ha_svr_flags & BLE_ATT_SVR_F_UUID_OWNED) {
+            free((void *)entry->ha_uuid);
+        }
+    }
+
+    ble_att_svr_entry_cnt = 0;
+}
+
+static int
+ble_att_svr_register_entry(const ble_uuid_t *uuid, uint8_t svr_flags,
+                           uint8_t flags, uint16_t *handle_id,
+                           ble_att_svr_access_fn *cb, void *cb_arg)
+{
+    struct ble_att_svr_entry *entry;
+    int pos;
+
+    BLE_HS_DBG_ASSERT(ble_uuid_is_compact(uuid));
+
+    if (ble_att_svr_entry_cnt >= ble_hs_max_attrs ||
+        ble_att_svr_entries == NULL) {
 
-    entry = ble_att_svr_entry_alloc();
-    if (entry == NULL) {
         return BLE_HS_ENOMEM;
     }
 
-    memcpy(&entry->ha_uuid, uuid, sizeof entry->ha_uuid);
+    entry = ble_att_svr_entries + ble_att_svr_entry_cnt;
+    memset(entry, 0, sizeof *entry);
+
+    entry->ha_uuid = uuid;
+    entry->ha_svr_flags = svr_flags;
     entry->ha_flags = flags;
     entry->ha_handle_id = ble_att_svr_next_id();
     entry->ha_cb = cb;
     entry->ha_cb_arg = cb_arg;
 
-    STAILQ_INSERT_TAIL(&ble_att_svr_list, entry, ha_next);
+    /* The new handle is the largest one registered, so the entry goes after
+     * all others with the same UUID.
+     */
+    pos = ble_att_svr_uuid_idx_lower(uuid, entry->ha_handle_id);
+    memmove(ble_att_svr_uuid_idx + pos + 1, ble_att_svr_uuid_idx + pos,
+            (ble_att_svr_entry_cnt - pos) * sizeof *ble_att_svr_uuid_idx);
+    ble_att_svr_uuid_idx[pos] = ble_att_svr_entry_cnt;
+
+    ble_att_svr_entry_cnt++;
 
     if (handle_id != NULL) {
         *handle_id = entry->ha_handle_id;
@@ -103,27 +204,114 @@ ble_att_svr_register(const uint8_t *uuid, uint8_t flags, uint16_t *handle_id,
     return 0;
 }
 
+/**
+ * Register a host attribute with the BLE stack.  The UUID is copied in its
+ * shortest form, unless an attribute with the same UUID is already
+ * registered, in which case the existing copy is shared.
+ *
+ * @param uuid                  The attribute's UUID; any width.
+ * @param flags                 The attribute's BLE_ATT_F_[...] flags.
+ * @param handle_id             A pointer to a 16-bit handle ID, which will be
+ *                                  the handle that is allocated.
+ * @param cb                    The callback function that gets executed when
+ *                                  the attribute is operated on.
+ * @param cb_arg                The optional argument to pass to the callback.
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
 int
-ble_att_svr_register_uuid16(uint16_t uuid16, uint8_t flags,
-                            uint16_t *handle_id, ble_att_svr_access_fn *cb,
-                            void *cb_arg)
+ble_att_svr_register_uuid(const ble_uuid_t *uuid, uint8_t flags,
+                          uint16_t *handle_id, ble_att_svr_access_fn *cb,
+                          void *cb_arg)
 {
+    struct ble_att_svr_entry *existing;
+    ble_uuid_any_t compact;
     uint8_t uuid128[16];
+    void *copy;
     int rc;
 
-    rc = ble_uuid_16_to_128(uuid16, uuid128);
+    ble_uuid_to_128(uuid, uuid128);
+    rc = ble_uuid_init_from_buf(&compact, uuid128, 16);
     if (rc != 0) {
         return rc;
     }
 
-    rc = ble_att_svr_register(uuid128, flags, handle_id, cb, cb_arg);
+    existing = ble_att_svr_uuid_idx_find(&compact.u, 0);
+    if (existing != NULL) {
+        return ble_att_svr_register_entry(existing->ha_uuid, 0, flags,
+                                          handle_id, cb, cb_arg);
+    }
+
+    copy = malloc(ble_uuid_sizeof(&compact.u));
+    if (copy == NULL) {
+        return BLE_HS_ENOMEM;
+    }
+    memcpy(copy, &compact, ble_uuid_sizeof(&compact.u));
+
+    rc = ble_att_svr_register_entry(copy, BLE_ATT_SVR_F_UUID_OWNED, flags,
+                                    handle_id, cb, cb_arg);
     if (rc != 0) {
+        free(copy);
         return rc;
     }
 
     return 0;
 }
 
+/**
+ * Register a host attribute identified by a 128-bit byte array UUID.  See
+ * ble_att_svr_register_uuid().
+ */
+int
+ble_att_svr_register(const uint8_t *uuid128, uint8_t flags,
+                     uint16_t *handle_id, ble_att_svr_access_fn *cb,
+                     void *cb_arg)
+{
+    ble_uuid_any_t uuid;
+    int rc;
+
+    rc = ble_uuid_init_from_buf(&uuid, uuid128, 16);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return ble_att_svr_register_uuid(&uuid.u, flags, handle_id, cb, cb_arg);
+}
+
+/**
+ * Register a host attribute whose UUID lives in caller-owned storage (e.g.,
+ * a const service definition in flash).  The UUID is referenced rather than
+ * copied, so it must remain valid for as long as the attribute is
+ * registered.  A UUID that is not in its shortest form (e.g., a 16-bit UUID
+ * written out in 128 bits) gets copied after all.
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+int
+ble_att_svr_register_static(const ble_uuid_t *uuid, uint8_t flags,
+                            uint16_t *handle_id, ble_att_svr_access_fn *cb,
+                            void *cb_arg)
+{
+    if (!ble_uuid_is_compact(uuid)) {
+        return ble_att_svr_register_uuid(uuid, flags, handle_id, cb, cb_arg);
+    }
+
+    return ble_att_svr_register_entry(uuid, 0, flags, handle_id, cb, cb_arg);
+}
+
+int
+ble_att_svr_register_uuid16(uint16_t uuid16, uint8_t flags,
+                            uint16_t *handle_id, ble_att_svr_access_fn *cb,
+                            void *cb_arg)
+{
+    if (uuid16 == 0) {
+        return BLE_HS_EINVAL;
+    }
+
+    return ble_att_svr_register_uuid(BLE_UUID16_DECLARE(uuid16), flags,
+                                     handle_id, cb, cb_arg);
+}
+
 uint16_t
 ble_att_svr_prev_handle(void)
 {
@@ -134,37 +322,34 @@ ble_att_svr_prev_handle(void)
  * Find a host attribute by handle id.
  *
  * @param handle_id             The handle_id to search for
- * @param ha_ptr                On input: Indicates the starting point of the
- *                                  walk; null means start at the beginning of
- *                                  the list, non-null means start at the
- *                                  following entry.
- *                              On output: Indicates the last ble_att element
- *                                  processed, or NULL if the entire list has
- *                                  been processed.
  *
- * @return                      0 on success; BLE_HS_ENOENT on not found.
+ * @return                      The matching attribute on success; NULL if
+ *                                  no attribute has the specified handle.
  */
 struct ble_att_svr_entry *
 ble_att_svr_find_by_handle(uint16_t handle_id)
 {
     struct ble_att_svr_entry *entry;
+    uint16_t first;
 
-    for (entry = STAILQ_FIRST(&ble_att_svr_list);
-         entry != NULL;
-         entry = STAILQ_NEXT(entry, ha_next)) {
+    if (ble_att_svr_entry_cnt == 0) {
+        return NULL;
+    }
 
-        if (entry->ha_handle_id == handle_id) {
-            return entry;
-        }
+    first = ble_att_svr_entries[0].ha_handle_id;
+    if (handle_id < first || handle_id - first >= ble_att_svr_entry_cnt) {
+        return NULL;
     }
 
-    return NULL;
+    entry = ble_att_svr_entries + (handle_id - first);
+    BLE_HS_DBG_ASSERT(entry->ha_handle_id == handle_id);
+    return entry;
 }
 
 /**
  * Find a host attribute by UUID.
  *
- * @param uuid                  The ble_uuid_t to search for
+ * @param uuid                  The UUID to search for, in its shortest form
  * @param prev                  On input: Indicates the starting point of the
  *                                  walk; null means start at the beginning of
  *                                  the list, non-null means start at the
@@ -176,27 +361,26 @@ ble_att_svr_find_by_handle(uint16_t handle_id)
  * @return                      0 on success; BLE_HS_ENOENT on not found.
  */
 struct ble_att_svr_entry *
-ble_att_svr_find_by_uuid(struct ble_att_svr_entry *prev, const uint8_t *uuid,
-                         uint16_t end_handle)
+ble_att_svr_find_by_uuid(struct ble_att_svr_entry *prev,
+                         const ble_uuid_t *uuid, uint16_t end_handle)
 {
     struct ble_att_svr_entry *entry;
+    uint16_t start_handle;
 
     if (prev == NULL) {
-        entry = STAILQ_FIRST(&ble_att_svr_list);
+        start_handle = 0;
+    } else if (prev->ha_handle_id == UINT16_MAX) {
+        return NULL;
     } else {
-        entry = STAILQ_NEXT(prev, ha_next);
+        start_handle = prev->ha_handle_id + 1;
     }
 
-    for (;
-         entry != NULL && entry->ha_handle_id <= end_handle;
-         entry = STAILQ_NEXT(entry, ha_next)) {
-
-        if (memcmp(entry->ha_uuid, uuid, sizeof entry->ha_uuid) == 0) {
-            return entry;
-        }
+    entry = ble_att_svr_uuid_idx_find(uuid, start_handle);
+    if (entry == NULL || entry->ha_handle_id > end_handle) {
+        return NULL;
     }
 
-    return NULL;
+    return entry;
 }
 
 static int
@@ -347,6 +531,39 @@ err:
     return rc;
 }
 
+/**
+ * Reads an attribute into a newly allocated mbuf chain.  The chain is built
+ * by the attribute's access callback; no copy is made here.  On success, the
+ * caller assumes ownership of the chain.
+ */
+static int
+ble_att_svr_read_mbuf(uint16_t conn_handle,
+                      struct ble_att_svr_entry *entry,
+                      uint16_t offset,
+                      struct os_mbuf **out_om,
+                      uint8_t *out_att_err)
+{
+    struct os_mbuf *om;
+    int rc;
+
+    om = ble_hs_mbuf_bare_pkt();
+    if (om == NULL) {
+        if (out_att_err != NULL) {
+            *out_att_err = BLE_ATT_ERR_INSUFFICIENT_RES;
+        }
+        return BLE_HS_ENOMEM;
+    }
+
+    rc = ble_att_svr_read(conn_handle, entry, offset, om, out_att_err);
+    if (rc != 0) {
+        os_mbuf_free_chain(om);
+        return rc;
+    }
+
+    *out_om = om;
+    return 0;
+}
+
 static int
 ble_att_svr_read_flat(uint16_t conn_handle, 
                       struct ble_att_svr_entry *entry,
@@ -360,15 +577,9 @@ ble_att_svr_read_flat(uint16_t conn_handle,
     uint16_t len;
     int rc;
 
-    om = ble_hs_mbuf_l2cap_pkt();
-    if (om == NULL) {
-        rc = BLE_HS_ENOMEM;
-        goto done;
-    }
-
-    rc = ble_att_svr_read(conn_handle, entry, offset, om, out_att_err);
+    rc = ble_att_svr_read_mbuf(conn_handle, entry, offset, &om, out_att_err);
     if (rc != 0) {
-        goto done;
+        return rc;
     }
 
     len = OS_MBUF_PKTLEN(om);
@@ -380,6 +591,7 @@ ble_att_svr_read_flat(uint16_t conn_handle,
 
     rc = os_mbuf_copydata(om, 0, len, dst);
     BLE_HS_DBG_ASSERT(rc == 0);
+    STATS_INCN(ble_att_stats, read_copy_bytes, len);
 
     *out_len = len;
     rc = 0;
@@ -740,7 +952,6 @@ ble_att_svr_fill_info(struct ble_att_find_info_req *req, struct os_mbuf *om,
                       uint16_t mtu, uint8_t *format)
 {
     struct ble_att_svr_entry *ha;
-    uint16_t uuid16;
     uint8_t *buf;
     int num_entries;
     int entry_sz;
@@ -750,15 +961,13 @@ ble_att_svr_fill_info(struct ble_att_find_info_req *req, struct os_mbuf *om,
     num_entries = 0;
     rc = 0;
 
-    STAILQ_FOREACH(ha, &ble_att_svr_list, ha_next) {
+    BLE_ATT_SVR_FOREACH(ha) {
         if (ha->ha_handle_id > req->bafq_end_handle) {
             rc = 0;
             goto done;
         }
         if (ha->ha_handle_id >= req->bafq_start_handle) {
-            uuid16 = ble_uuid_128_to_16(ha->ha_uuid);
-
-            if (uuid16 != 0) {
+            if (ha->ha_uuid->type == BLE_UUID_TYPE_16) {
                 if (*format == 0) {
                     *format = BLE_ATT_FIND_INFO_RSP_FORMAT_16BIT;
                 } else if (*format != BLE_ATT_FIND_INFO_RSP_FORMAT_16BIT) {
@@ -789,20 +998,7 @@ ble_att_svr_fill_info(struct ble_att_find_info_req *req, struct os_mbuf *om,
             }
 
             htole16(buf + 0, ha->ha_handle_id);
-
-            switch (*format) {
-            case BLE_ATT_FIND_INFO_RSP_FORMAT_16BIT:
-                htole16(buf + 2, uuid16);
-                break;
-
-            case BLE_ATT_FIND_INFO_RSP_FORMAT_128BIT:
-                memcpy(buf + 2, ha->ha_uuid, sizeof ha->ha_uuid);
-                break;
-
-            default:
-                BLE_HS_DBG_ASSERT(0);
-                break;
-            }
+            ble_uuid_flat(ha->ha_uuid, buf + 2);
 
             num_entries++;
         }
@@ -1061,9 +1257,8 @@ ble_att_svr_fill_type_value(uint16_t conn_handle,
                             uint16_t mtu, uint8_t *out_att_err)
 {
     struct ble_att_svr_entry *ha;
-    uint8_t buf[16];
-    uint16_t attr_len;
-    uint16_t uuid16;
+    struct os_mbuf *attr_om;
+    uint16_t value_len;
     uint16_t first;
     uint16_t prev;
     int any_entries;
@@ -1074,11 +1269,13 @@ ble_att_svr_fill_type_value(uint16_t conn_handle,
     prev = 0;
     rc = 0;
 
+    value_len = OS_MBUF_PKTLEN(rxom) - BLE_ATT_FIND_TYPE_VALUE_REQ_BASE_SZ;
+
     /* Iterate through the attribute list, keeping track of the current
      * matching group.  For each attribute entry, determine if data needs to be
      * written to the response.
      */
-    STAILQ_FOREACH(ha, &ble_att_svr_list, ha_next) {
+    BLE_ATT_SVR_FOREACH(ha) {
         match = 0;
 
         if (ha->ha_handle_id > req->bavq_end_handle) {
@@ -1089,18 +1286,22 @@ ble_att_svr_fill_type_value(uint16_t conn_handle,
             /* Compare the attribute type and value to the request fields to
              * determine if this attribute matches.
              */
-            uuid16 = ble_uuid_128_to_16(ha->ha_uuid);
-            if (uuid16 == req->bavq_attr_type) {
-                rc = ble_att_svr_read_flat(conn_handle, ha, 0, sizeof buf, buf,
-                                           &attr_len, out_att_err);
+            if (ble_uuid_u16(ha->ha_uuid) == req->bavq_attr_type) {
+                rc = ble_att_svr_read_mbuf(conn_handle, ha, 0, &attr_om,
+                                           out_att_err);
                 if (rc != 0) {
                     goto done;
                 }
-                rc = os_mbuf_cmpf(rxom, BLE_ATT_FIND_TYPE_VALUE_REQ_BASE_SZ,
-                                  buf, attr_len);
-                if (rc == 0) {
+
+                /* Compare the two chains in place. */
+                if (OS_MBUF_PKTLEN(attr_om) == value_len &&
+                    os_mbuf_cmpm(attr_om, 0,
+                                 rxom, BLE_ATT_FIND_TYPE_VALUE_REQ_BASE_SZ,
+                                 value_len) == 0) {
+
                     match = 1;
                 }
+                os_mbuf_free_chain(attr_om);
             }
         }
 
@@ -1242,7 +1443,7 @@ done:
 static int
 ble_att_svr_build_read_type_rsp(uint16_t conn_handle,
                                 struct ble_att_read_type_req *req,
-                                uint8_t *uuid128,
+                                const ble_uuid_t *uuid,
                                 struct os_mbuf **rxom,
                                 struct os_mbuf **out_txom,
                                 uint8_t *att_err,
@@ -1250,10 +1451,10 @@ ble_att_svr_build_read_type_rsp(uint16_t conn_handle,
 {
     struct ble_att_read_type_rsp rsp;
     struct ble_att_svr_entry *entry;
+    struct os_mbuf *attr_om;
     struct os_mbuf *txom;
     uint16_t attr_len;
     uint16_t mtu;
-    uint8_t buf[19];
     uint8_t *dptr;
     int entry_written;
     int txomlen;
@@ -1263,6 +1464,7 @@ ble_att_svr_build_read_type_rsp(uint16_t conn_handle,
     *att_err = 0;    /* Silence unnecessary warning. */
 
     *err_handle = req->batq_start_handle;
+    attr_om = NULL;
     entry_written = 0;
     prev_attr_len = 0;
 
@@ -1288,23 +1490,29 @@ ble_att_svr_build_read_type_rsp(uint16_t conn_handle,
     /* Find all matching attributes, writing a record for each. */
     entry = NULL;
     while (1) {
-        entry = ble_att_svr_find_by_uuid(entry, uuid128, req->batq_end_handle);
+        entry = ble_att_svr_find_by_uuid(entry, uuid, req->batq_end_handle);
         if (entry == NULL) {
             rc = BLE_HS_ENOENT;
             break;
         }
 
         if (entry->ha_handle_id >= req->batq_start_handle) {
-            rc = ble_att_svr_read_flat(conn_handle, entry, 0, sizeof buf, buf,
-                                       &attr_len, att_err);
+            rc = ble_att_svr_read_mbuf(conn_handle, entry, 0, &attr_om,
+                                       att_err);
             if (rc != 0) {
                 *err_handle = entry->ha_handle_id;
                 goto done;
             }
 
+            /* The one-byte length field limits each record to 255 bytes. */
+            attr_len = OS_MBUF_PKTLEN(attr_om);
             if (attr_len > mtu - 4) {
                 attr_len = mtu - 4;
             }
+            if (attr_len > UINT8_MAX - 2) {
+                attr_len = UINT8_MAX - 2;
+            }
+            os_mbuf_adj(attr_om, attr_len - OS_MBUF_PKTLEN(attr_om));
 
             if (prev_attr_len == 0) {
                 prev_attr_len = attr_len;
@@ -1317,7 +1525,7 @@ ble_att_svr_build_read_type_rsp(uint16_t conn_handle,
                 break;
             }
 
-            dptr = os_mbuf_extend(txom, 2 + attr_len);
+            dptr = os_mbuf_extend(txom, 2);
             if (dptr == NULL) {
                 *att_err = BLE_ATT_ERR_INSUFFICIENT_RES;
                 *err_handle = entry->ha_handle_id;
@@ -1325,13 +1533,17 @@ ble_att_svr_build_read_type_rsp(uint16_t conn_handle,
                 goto done;
             }
 
+            /* Attach the attribute value to the response without copying. */
             htole16(dptr + 0, entry->ha_handle_id);
-            memcpy(dptr + 2, buf, attr_len);
+            os_mbuf_concat(txom, attr_om);
+            attr_om = NULL;
             entry_written = 1;
         }
     }
 
 done:
+    os_mbuf_free_chain(attr_om);
+
     if (!entry_written) {
         /* No matching attributes. */
         if (*att_err == 0) {
@@ -1366,10 +1578,9 @@ ble_att_svr_rx_read_type(uint16_t conn_handle, struct os_mbuf **rxom)
 
     struct ble_att_read_type_req req;
     struct os_mbuf *txom;
+    ble_uuid_any_t uuid;
     uint16_t err_handle;
-    uint16_t uuid16;
     uint16_t pktlen;
-    uint8_t uuid128[16];
     uint8_t att_err;
     int rc;
 
@@ -1406,8 +1617,9 @@ ble_att_svr_rx_read_type(uint16_t conn_handle, struct os_mbuf **rxom)
 
     switch ((*rxom)->om_len) {
     case BLE_ATT_READ_TYPE_REQ_SZ_16:
-        uuid16 = le16toh((*rxom)->om_data + 5);
-        rc = ble_uuid_16_to_128(uuid16, uuid128);
+    case BLE_ATT_READ_TYPE_REQ_SZ_128:
+        rc = ble_uuid_init_from_buf(&uuid, (*rxom)->om_data + 5,
+                                    (*rxom)->om_len - 5);
         if (rc != 0) {
             att_err = BLE_ATT_ERR_ATTR_NOT_FOUND;
             err_handle = 0;
@@ -1416,10 +1628,6 @@ ble_att_svr_rx_read_type(uint16_t conn_handle, struct os_mbuf **rxom)
         }
         break;
 
-    case BLE_ATT_READ_TYPE_REQ_SZ_128:
-        memcpy(uuid128, (*rxom)->om_data + 5, 16);
-        break;
-
     default:
         att_err = BLE_ATT_ERR_INVALID_PDU;
         err_handle = 0;
@@ -1427,7 +1635,7 @@ ble_att_svr_rx_read_type(uint16_t conn_handle, struct os_mbuf **rxom)
         goto done;
     }
 
-    rc = ble_att_svr_build_read_type_rsp(conn_handle, &req, uuid128,
+    rc = ble_att_svr_build_read_type_rsp(conn_handle, &req, &uuid.u,
                                          rxom, &txom, &att_err, &err_handle);
     if (rc != 0) {
         goto done;
@@ -1668,11 +1876,11 @@ done:
 }
 
 static int
-ble_att_svr_is_valid_group_type(uint8_t *uuid128)
+ble_att_svr_is_valid_group_type(const ble_uuid_t *uuid)
 {
     uint16_t uuid16;
 
-    uuid16 = ble_uuid_128_to_16(uuid128);
+    uuid16 = ble_uuid_u16(uuid);
 
     return uuid16 == BLE_ATT_UUID_PRIMARY_SERVICE ||
            uuid16 == BLE_ATT_UUID_SECONDARY_SERVICE;
@@ -1749,7 +1957,7 @@ ble_att_svr_read_group_type_entry_write(struct os_mbuf *om, uint16_t mtu,
 static int
 ble_att_svr_build_read_group_type_rsp(uint16_t conn_handle,
                                       struct ble_att_read_group_type_req *req,
-                                      uint8_t *group_uuid128,
+                                      const ble_uuid_t *group_uuid,
                                       struct os_mbuf **rxom,
                                       struct os_mbuf **out_txom,
                                       uint8_t *att_err,
@@ -1791,7 +1999,7 @@ ble_att_svr_build_read_group_type_rsp(uint16_t conn_handle,
 
     start_group_handle = 0;
     rsp.bagp_length = 0;
-    STAILQ_FOREACH(entry, &ble_att_svr_list, ha_next) {
+    BLE_ATT_SVR_FOREACH(entry) {
         if (entry->ha_handle_id < req->bagq_start_handle) {
             continue;
         }
@@ -1829,7 +2037,7 @@ ble_att_svr_build_read_group_type_rsp(uint16_t conn_handle,
 
         if (start_group_handle == 0) {
             /* We are looking for the start of a group. */
-            if (memcmp(entry->ha_uuid, group_uuid128, 16) == 0) {
+            if (ble_uuid_cmp(entry->ha_uuid, group_uuid) == 0) {
                 /* Found a group start.  Read the group UUID. */
                 rc = ble_att_svr_service_uuid(entry, &service_uuid16,
                                               service_uuid128);
@@ -1887,7 +2095,7 @@ done:
              * response.
              */
 
-            if (entry == NULL) {
+            if (entry == ble_att_svr_entries + ble_att_svr_entry_cnt) {
                 /* We have reached the end of the attribute list.  Indicate an
                  * end handle of 0xffff so that the client knows there are no
                  * more attributes without needing to send a follow-up request.
@@ -1931,7 +2139,7 @@ ble_att_svr_rx_read_group_type(uint16_t conn_handle, struct os_mbuf **rxom)
 
     struct ble_att_read_group_type_req req;
     struct os_mbuf *txom;
-    uint8_t uuid128[16];
+    ble_uuid_any_t uuid;
     uint16_t err_handle;
     uint16_t pktlen;
     uint8_t att_err;
@@ -1967,8 +2175,10 @@ ble_att_svr_rx_read_group_type(uint16_t conn_handle, struct os_mbuf **rxom)
         goto done;
     }
 
-    rc = ble_uuid_extract(*rxom, BLE_ATT_READ_GROUP_TYPE_REQ_BASE_SZ,
-                          uuid128);
+    rc = ble_uuid_init_from_buf(&uuid,
+                                (*rxom)->om_data +
+                                    BLE_ATT_READ_GROUP_TYPE_REQ_BASE_SZ,
+                                pktlen - BLE_ATT_READ_GROUP_TYPE_REQ_BASE_SZ);
     if (rc != 0) {
         att_err = BLE_ATT_ERR_INVALID_PDU;
         err_handle = req.bagq_start_handle;
@@ -1976,14 +2186,14 @@ ble_att_svr_rx_read_group_type(uint16_t conn_handle, struct os_mbuf **rxom)
         goto done;
     }
 
-    if (!ble_att_svr_is_valid_group_type(uuid128)) {
+    if (!ble_att_svr_is_valid_group_type(&uuid.u)) {
         att_err = BLE_ATT_ERR_UNSUPPORTED_GROUP;
         err_handle = req.bagq_start_handle;
         rc = BLE_HS_ENOTSUP;
         goto done;
     }
 
-    rc = ble_att_svr_build_read_group_type_rsp(conn_handle, &req, uuid128,
+    rc = ble_att_svr_build_read_group_type_rsp(conn_handle, &req, &uuid.u,
                                                rxom, &txom, &att_err,
                                                &err_handle);
     if (rc != 0) {
@@ -2280,6 +2490,9 @@ ble_att_svr_prep_extract(struct ble_att_prep_entry_list *prep_list,
         ble_att_svr_prep_free(entry);
     }
 
+    /* The entries' chains were each allocated with their own headroom. */
+    os_mbuf_compact_wasteful(om);
+
     *out_attr_handle = attr_handle;
     *out_om = om;
 }
@@ -2327,6 +2540,40 @@ ble_att_svr_prep_write(uint16_t conn_handle,
     return 0;
 }
 
+#if MYNEWT_VAL(BLE_ATT_SVR_PREP_COALESCE)
+static int
+ble_att_svr_prep_is_contig(const struct ble_att_prep_entry *entry,
+                           uint16_t handle, uint16_t offset)
+{
+    return entry != NULL &&
+           entry->bape_handle == handle &&
+           entry->bape_offset + OS_MBUF_PKTLEN(entry->bape_value) == offset;
+}
+
+/**
+ * Appends a partial write onto an existing queue entry.  On failure, the
+ * entry is left unchanged.
+ */
+static int
+ble_att_svr_prep_append(struct ble_att_prep_entry *entry,
+                        const struct os_mbuf *rxom, uint16_t len)
+{
+    uint16_t old_len;
+    int rc;
+
+    old_len = OS_MBUF_PKTLEN(entry->bape_value);
+    rc = os_mbuf_appendfrom(entry->bape_value, rxom,
+                            BLE_ATT_PREP_WRITE_CMD_BASE_SZ, len);
+    if (rc != 0) {
+        os_mbuf_adj(entry->bape_value,
+                    old_len - OS_MBUF_PKTLEN(entry->bape_value));
+        return rc;
+    }
+
+    return 0;
+}
+#endif
+
 static int
 ble_att_svr_insert_prep_entry(uint16_t conn_handle,
                               const struct ble_att_prep_write_cmd *req,
@@ -2335,10 +2582,53 @@ ble_att_svr_insert_prep_entry(uint16_t conn_handle,
 {
     struct ble_att_prep_entry *prep_entry;
     struct ble_att_prep_entry *prep_prev;
+    struct ble_att_svr_conn *basc;
     struct ble_hs_conn *conn;
+    uint16_t len;
     int rc;
 
     conn = ble_hs_conn_find_assert(conn_handle);
+    basc = &conn->bhc_att_svr;
+
+    len = OS_MBUF_PKTLEN(rxom) - BLE_ATT_PREP_WRITE_CMD_BASE_SZ;
+
+#if MYNEWT_VAL(BLE_ATT_SVR_PREP_CONN_MAX_BYTES) > 0
+    if (basc->basc_prep_bytes + len >
+        MYNEWT_VAL(BLE_ATT_SVR_PREP_CONN_MAX_BYTES)) {
+
+        *out_att_err = BLE_ATT_ERR_PREPARE_QUEUE_FULL;
+        return BLE_HS_ENOMEM;
+    }
+#endif
+
+#if MYNEWT_VAL(BLE_ATT_SVR_PREP_COALESCE)
+    /* Peers almost always send a long write as a run of contiguous
+     * requests, so the previously written entry is usually the one to
+     * extend.  Otherwise, fall back to a search of the sorted list.
+     */
+    prep_prev = basc->basc_prep_last;
+    if (!ble_att_svr_prep_is_contig(prep_prev, req->bapc_handle,
+                                    req->bapc_offset)) {
+
+        prep_prev = ble_att_svr_prep_find_prev(basc, req->bapc_handle,
+                                               req->bapc_offset);
+    }
+
+    if (ble_att_svr_prep_is_contig(prep_prev, req->bapc_handle,
+                                   req->bapc_offset)) {
+
+        rc = ble_att_svr_prep_append(prep_prev, rxom, len);
+        if (rc != 0) {
+            *out_att_err = BLE_ATT_ERR_PREPARE_QUEUE_FULL;
+            return rc;
+        }
+        STATS_INCN(ble_att_stats, write_copy_bytes, len);
+
+        basc->basc_prep_bytes += len;
+        basc->basc_prep_last = prep_prev;
+        return 0;
+    }
+#endif
 
     prep_entry = ble_att_svr_prep_alloc();
     if (prep_entry == NULL) {
@@ -2349,27 +2639,28 @@ ble_att_svr_insert_prep_entry(uint16_t conn_handle,
     prep_entry->bape_offset = req->bapc_offset;
 
     /* Append attribute value from request onto prep mbuf. */
-    rc = os_mbuf_appendfrom(
-        prep_entry->bape_value,
-        rxom,
-        BLE_ATT_PREP_WRITE_CMD_BASE_SZ,
-        OS_MBUF_PKTLEN(rxom) - BLE_ATT_PREP_WRITE_CMD_BASE_SZ);
+    rc = os_mbuf_appendfrom(prep_entry->bape_value, rxom,
+                            BLE_ATT_PREP_WRITE_CMD_BASE_SZ, len);
     if (rc != 0) {
         ble_att_svr_prep_free(prep_entry);
         *out_att_err = BLE_ATT_ERR_PREPARE_QUEUE_FULL;
         return rc;
     }
+    STATS_INCN(ble_att_stats, write_copy_bytes, len);
 
-    prep_prev = ble_att_svr_prep_find_prev(&conn->bhc_att_svr,
-                                           req->bapc_handle,
+    prep_prev = ble_att_svr_prep_find_prev(basc, req->bapc_handle,
                                            req->bapc_offset);
     if (prep_prev == NULL) {
-        SLIST_INSERT_HEAD(&conn->bhc_att_svr.basc_prep_list, prep_entry,
-                          bape_next);
+        SLIST_INSERT_HEAD(&basc->basc_prep_list, prep_entry, bape_next);
     } else {
         SLIST_INSERT_AFTER(prep_prev, prep_entry, bape_next);
     }
 
+    basc->basc_prep_bytes += len;
+#if MYNEWT_VAL(BLE_ATT_SVR_PREP_COALESCE)
+    basc->basc_prep_last = prep_entry;
+#endif
+
     return 0;
 }
 
@@ -2537,6 +2828,10 @@ done:
          */
         prep_list = conn->bhc_att_svr.basc_prep_list;
         SLIST_INIT(&conn->bhc_att_svr.basc_prep_list);
+        conn->bhc_att_svr.basc_prep_bytes = 0;
+#if MYNEWT_VAL(BLE_ATT_SVR_PREP_COALESCE)
+        conn->bhc_att_svr.basc_prep_last = NULL;
+#endif
         ble_hs_unlock();
 
         if (req.baeq_flags & BLE_ATT_EXEC_WRITE_F_CONFIRM) {
@@ -2666,6 +2961,7 @@ ble_att_svr_rx_indicate(uint16_t conn_handle, struct os_mbuf **rxom)
     /* Strip the request base from the front of the mbuf. */
     os_mbuf_adj(*rxom, BLE_ATT_INDICATE_REQ_BASE_SZ);
 
+    ble_gattc_rx_indicate(conn_handle, req.baiq_handle);
     ble_gap_notify_rx_event(conn_handle, req.baiq_handle, *rxom, 1);
     *rxom = NULL;
 
@@ -2686,40 +2982,33 @@ done:
 static void
 ble_att_svr_free_start_mem(void)
 {
-    free(ble_att_svr_entry_mem);
-    ble_att_svr_entry_mem = NULL;
+    ble_att_svr_reset_entries();
+
+    free(ble_att_svr_entries);
+    ble_att_svr_entries = NULL;
+    ble_att_svr_uuid_idx = NULL;
 }
 
 int
 ble_att_svr_start(void)
 {
-    int rc;
-
     ble_att_svr_free_start_mem();
 
     if (ble_hs_max_attrs > 0) {
-        ble_att_svr_entry_mem = malloc(
-            OS_MEMPOOL_BYTES(ble_hs_max_attrs,
-                             sizeof (struct ble_att_svr_entry)));
-        if (ble_att_svr_entry_mem == NULL) {
-            rc = BLE_HS_ENOMEM;
-            goto err;
-        }
-
-        rc = os_mempool_init(&ble_att_svr_entry_pool, ble_hs_max_attrs,
-                             sizeof (struct ble_att_svr_entry),
-                             ble_att_svr_entry_mem, "ble_att_svr_entry_pool");
-        if (rc != 0) {
-            rc = BLE_HS_EOS;
-            goto err;
+        /* One allocation holds both the attribute table and the UUID
+         * index.
+         */
+        ble_att_svr_entries = malloc(
+            ble_hs_max_attrs * (sizeof *ble_att_svr_entries +
+                                sizeof *ble_att_svr_uuid_idx));
+        if (ble_att_svr_entries == NULL) {
+            return BLE_HS_ENOMEM;
         }
+        ble_att_svr_uuid_idx =
+            (uint16_t *)(ble_att_svr_entries + ble_hs_max_attrs);
     }
 
     return 0;
-
-err:
-    ble_att_svr_free_start_mem();
-    return rc;
 }
 
 int
@@ -2738,7 +3027,7 @@ ble_att_svr_init(void)
         }
     }
 
-    STAILQ_INIT(&ble_att_svr_list);
+    ble_att_svr_reset_entries();
 
     ble_att_svr_id = 0;
 
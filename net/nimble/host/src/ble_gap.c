@@ -73,6 +73,11 @@
 
 #define BLE_GAP_UPDATE_TIMEOUT                  (30 * OS_TICKS_PER_SEC)
 
+#define BLE_GAP_CPM_SAMPLE_TICKS                                    \
+    (MYNEWT_VAL(BLE_GAP_CPM_SAMPLE_MS) * OS_TICKS_PER_SEC / 1000 + 1)
+#define BLE_GAP_CPM_BACKOFF_TICKS                                   \
+    (MYNEWT_VAL(BLE_GAP_CPM_BACKOFF_MS) * OS_TICKS_PER_SEC / 1000 + 1)
+
 /**
  * The maximum amount of user data that can be put into the advertising data.
  * The stack will automatically insert the flags field on its own if requested
@@ -177,6 +182,11 @@ static int ble_gap_adv_enable_tx(int enable);
 static int ble_gap_conn_cancel_tx(void);
 static int ble_gap_disc_enable_tx(int enable, int filter_duplicates);
 
+#if MYNEWT_VAL(BLE_GAP_CPM)
+static int32_t ble_gap_cpm_timer(void);
+static void ble_gap_cpm_update_done(uint16_t conn_handle, int status);
+#endif
+
 STATS_SECT_DECL(ble_gap_stats) ble_gap_stats;
 STATS_NAME_START(ble_gap_stats)
     STATS_NAME(ble_gap_stats, wl_set)
@@ -189,6 +199,8 @@ STATS_NAME_START(ble_gap_stats)
     STATS_NAME(ble_gap_stats, adv_set_fields_fail)
     STATS_NAME(ble_gap_stats, adv_rsp_set_fields)
     STATS_NAME(ble_gap_stats, adv_rsp_set_fields_fail)
+    STATS_NAME(ble_gap_stats, adv_update_field)
+    STATS_NAME(ble_gap_stats, adv_update_field_fail)
     STATS_NAME(ble_gap_stats, discover)
     STATS_NAME(ble_gap_stats, discover_fail)
     STATS_NAME(ble_gap_stats, initiate)
@@ -210,6 +222,9 @@ STATS_NAME_START(ble_gap_stats)
     STATS_NAME(ble_gap_stats, discover_cancel_fail)
     STATS_NAME(ble_gap_stats, security_initiate)
     STATS_NAME(ble_gap_stats, security_initiate_fail)
+    STATS_NAME(ble_gap_stats, cpm_busy)
+    STATS_NAME(ble_gap_stats, cpm_idle)
+    STATS_NAME(ble_gap_stats, cpm_fail)
 STATS_NAME_END(ble_gap_stats)
 
 /*****************************************************************************
@@ -655,6 +670,10 @@ ble_gap_update_notify(uint16_t conn_handle, int status)
 
     ble_gap_call_conn_event_cb(&event, conn_handle);
 
+#if MYNEWT_VAL(BLE_GAP_CPM)
+    ble_gap_cpm_update_done(conn_handle, status);
+#endif
+
     /* Terminate the connection on procedure timeout. */
     if (status == BLE_HS_ETIMEOUT) {
         ble_gap_terminate(conn_handle, BLE_ERR_REM_USER_CONN_TERM);
@@ -1066,7 +1085,11 @@ ble_gap_rx_adv_report(struct ble_gap_disc_desc *desc)
     return;
 #endif
 
+#if MYNEWT_VAL(BLE_GAP_DISC_PARSE_FIELDS)
     struct ble_hs_adv_fields fields;
+#else
+    struct ble_hs_adv_field flags;
+#endif
     int rc;
 
     STATS_INC(ble_gap_stats, rx_adv_report);
@@ -1075,6 +1098,7 @@ ble_gap_rx_adv_report(struct ble_gap_disc_desc *desc)
         return;
     }
 
+#if MYNEWT_VAL(BLE_GAP_DISC_PARSE_FIELDS)
     rc = ble_hs_adv_parse_fields(&fields, desc->data, desc->length_data);
     if (rc != 0) {
         /* XXX: Increment stat. */
@@ -1091,6 +1115,23 @@ ble_gap_rx_adv_report(struct ble_gap_disc_desc *desc)
     }
 
     desc->fields = &fields;
+#else
+    /* The application walks the raw data itself; only look at the flags
+     * field, and only if a limited discovery procedure is active.
+     */
+    if (ble_gap_master.disc.limited) {
+        rc = ble_hs_adv_find_field(BLE_HS_ADV_TYPE_FLAGS, desc->data,
+                                   desc->length_data, &flags);
+        if (rc != 0 || flags.data_len != BLE_HS_ADV_FLAGS_LEN ||
+            !(flags.data[0] & BLE_HS_ADV_F_DISC_LTD)) {
+
+            return;
+        }
+    }
+
+    desc->fields = NULL;
+#endif
+
     ble_gap_disc_report(desc);
 }
 
@@ -1366,6 +1407,9 @@ ble_gap_timer(void)
     master_ticks = ble_gap_master_timer();
     slave_ticks = ble_gap_slave_timer();
     update_ticks = ble_gap_update_timer();
+#if MYNEWT_VAL(BLE_GAP_CPM)
+    update_ticks = min(update_ticks, ble_gap_cpm_timer());
+#endif
 
     return min(min(master_ticks, slave_ticks), update_ticks);
 }
@@ -2054,6 +2098,119 @@ done:
     return rc;
 }
 
+static int
+ble_gap_adv_update_field_gen(int rsp, uint8_t type, const void *data,
+                             uint8_t data_len)
+{
+    uint8_t *dst;
+    uint8_t *dst_len;
+    uint8_t old_len;
+    uint8_t old[BLE_HCI_MAX_ADV_DATA_LEN];
+    int max_sz;
+    int rc;
+
+    STATS_INC(ble_gap_stats, adv_update_field);
+
+    ble_hs_lock();
+
+    if (rsp) {
+        dst = ble_gap_slave.rsp_data;
+        dst_len = &ble_gap_slave.rsp_data_len;
+        max_sz = BLE_HCI_MAX_ADV_DATA_LEN;
+    } else {
+        dst = ble_gap_slave.adv_data;
+        dst_len = &ble_gap_slave.adv_data_len;
+        if (ble_gap_slave.adv_auto_flags) {
+            max_sz = BLE_GAP_ADV_DATA_LIMIT_FLAGS;
+        } else {
+            max_sz = BLE_GAP_ADV_DATA_LIMIT_NO_FLAGS;
+        }
+    }
+
+    old_len = *dst_len;
+    memcpy(old, dst, old_len);
+
+    rc = ble_hs_adv_update_field(type, data_len, data, dst, dst_len, max_sz);
+    if (rc != 0) {
+        goto done;
+    }
+
+    /* While advertising, hand the new data to the controller right away;
+     * it takes effect from the next advertising event.
+     */
+    if (ble_gap_slave.op == BLE_GAP_OP_S_ADV) {
+        if (rsp) {
+            rc = ble_gap_adv_rsp_data_tx();
+        } else {
+            rc = ble_gap_adv_data_tx();
+        }
+        if (rc != 0) {
+            /* Keep the host copy in sync with the controller. */
+            memcpy(dst, old, old_len);
+            *dst_len = old_len;
+        }
+    }
+
+done:
+    ble_hs_unlock();
+
+    if (rc != 0) {
+        STATS_INC(ble_gap_stats, adv_update_field_fail);
+    }
+    return rc;
+}
+
+/**
+ * Replaces a single field of the advertising data, leaving the other fields
+ * as last set. The field is added if not present. Unlike
+ * ble_gap_adv_set_fields(), this may be called while advertising; the new
+ * data is then sent to the controller immediately.
+ *
+ * @param type                  The AD type of the field (BLE_HS_ADV_TYPE_*).
+ * @param data                  The field contents, without the AD header.
+ * @param data_len              The length of the field contents; 0 removes
+ *                                  the field.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EMSGSIZE if the data does not fit in
+ *                                  an advertisement;
+ *                              Other nonzero on failure.
+ */
+int
+ble_gap_adv_update_field(uint8_t type, const void *data, uint8_t data_len)
+{
+#if !NIMBLE_BLE_ADVERTISE
+    return BLE_HS_ENOTSUP;
+#endif
+
+    return ble_gap_adv_update_field_gen(0, type, data, data_len);
+}
+
+/**
+ * Replaces a single field of the scan response data; see
+ * ble_gap_adv_update_field().
+ *
+ * @param type                  The AD type of the field (BLE_HS_ADV_TYPE_*).
+ * @param data                  The field contents, without the AD header.
+ * @param data_len              The length of the field contents; 0 removes
+ *                                  the field.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EMSGSIZE if the data does not fit in
+ *                                  a scan response;
+ *                              Other nonzero on failure.
+ */
+int
+ble_gap_adv_rsp_update_field(uint8_t type, const void *data,
+                             uint8_t data_len)
+{
+#if !NIMBLE_BLE_ADVERTISE
+    return BLE_HS_ENOTSUP;
+#endif
+
+    return ble_gap_adv_update_field_gen(1, type, data, data_len);
+}
+
 /**
  * Indicates whether an advertisement procedure is currently in progress.
  *
@@ -3144,6 +3301,656 @@ ble_gap_conn_rssi(uint16_t conn_handle, int8_t *out_rssi)
     return rc;
 }
 
+/*****************************************************************************
+ * $throughput                                                               *
+ *****************************************************************************/
+
+/**
+ * Configures a connection for bulk data transfer.  This:
+ *     o Asks the controller for the longest link layer payload (LE Data
+ *       Length Extension).  Controllers without DLE reject the request; that
+ *       is not treated as an error.
+ *     o Initiates an ATT MTU exchange, unless one has already been done, so
+ *       that the local preferred MTU (ble_att_set_preferred_mtu()) takes
+ *       effect.
+ *     o Requests the specified connection interval with no slave latency
+ *       and a connection event length spanning the whole interval.
+ *
+ * The MTU exchange and parameter update complete asynchronously; the usual
+ * BLE_GAP_EVENT_MTU and BLE_GAP_EVENT_CONN_UPDATE events report the outcome.
+ *
+ * @param conn_handle           The connection to tune.
+ * @param itvl                  The connection interval to request (units:
+ *                                  1.25 ms).  BLE_HCI_CONN_ITVL_MIN gives
+ *                                  the highest throughput.
+ *
+ * @return                      0 if all requests were issued successfully;
+ *                              BLE_HS_ENOTCONN if there is no such
+ *                                  connection;
+ *                              Other nonzero on error.
+ */
+int
+ble_gap_tput_tune(uint16_t conn_handle, uint16_t itvl)
+{
+    struct ble_gap_upd_params params;
+    struct ble_l2cap_chan *chan;
+    struct ble_hs_conn *conn;
+    uint16_t min_timeout;
+    int mtu_txed;
+    int rc;
+
+    if (itvl < BLE_HCI_CONN_ITVL_MIN || itvl > BLE_HCI_CONN_ITVL_MAX) {
+        return BLE_HS_EINVAL;
+    }
+
+    memset(&params, 0, sizeof params);
+    mtu_txed = 0;
+
+    ble_hs_lock();
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn != NULL) {
+        params.supervision_timeout = conn->bhc_supervision_timeout;
+        chan = ble_hs_conn_chan_find(conn, BLE_L2CAP_CID_ATT);
+        mtu_txed = chan != NULL && (chan->blc_flags & BLE_L2CAP_CHAN_F_TXED_MTU);
+    }
+    ble_hs_unlock();
+
+    if (conn == NULL) {
+        return BLE_HS_ENOTCONN;
+    }
+
+    rc = ble_hs_hci_util_set_data_len(conn_handle,
+                                      BLE_HCI_SET_DATALEN_TX_OCTETS_MAX,
+                                      BLE_HCI_SET_DATALEN_TX_TIME_MAX);
+    if (rc != 0 &&
+        rc != BLE_HS_HCI_ERR(BLE_ERR_UNKNOWN_HCI_CMD) &&
+        rc != BLE_HS_HCI_ERR(BLE_ERR_UNSUPPORTED)) {
+
+        return rc;
+    }
+
+    if (!mtu_txed) {
+        rc = ble_gattc_exchange_mtu(conn_handle, NULL, NULL);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    /* The supervision timeout (10 ms units) must exceed twice the interval
+     * (1.25 ms units).
+     */
+    min_timeout = itvl / 4 + 1;
+    if (params.supervision_timeout < min_timeout) {
+        params.supervision_timeout = min_timeout;
+    }
+
+    params.itvl_min = itvl;
+    params.itvl_max = itvl;
+    params.latency = 0;
+    params.min_ce_len = 0;
+    params.max_ce_len = itvl * 2;
+
+    rc = ble_gap_update_params(conn_handle, &params);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return 0;
+}
+
+/**
+ * Reports the L2CAP payload throughput a connection has achieved since the
+ * previous call to this function (or since the connection was established),
+ * and restarts the measurement window.
+ *
+ * @param conn_handle           The connection to query.
+ * @param out_tput              On success, the measurement gets written here.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOTCONN if there is no such
+ *                                  connection.
+ */
+int
+ble_gap_conn_tput(uint16_t conn_handle, struct ble_gap_conn_tput *out_tput)
+{
+    struct ble_l2cap_chan *chan;
+    struct ble_hs_conn *conn;
+    os_time_t elapsed;
+    os_time_t now;
+
+    now = os_time_get();
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn != NULL) {
+        elapsed = now - conn->bhc_tput_start;
+        if (elapsed == 0) {
+            elapsed = 1;
+        }
+
+        out_tput->tx_bps = (uint64_t)conn->bhc_tx_bytes * OS_TICKS_PER_SEC /
+                           elapsed;
+        out_tput->rx_bps = (uint64_t)conn->bhc_rx_bytes * OS_TICKS_PER_SEC /
+                           elapsed;
+        out_tput->itvl = conn->bhc_itvl;
+
+        chan = ble_hs_conn_chan_find(conn, BLE_L2CAP_CID_ATT);
+        if (chan != NULL) {
+            out_tput->mtu = ble_l2cap_chan_mtu(chan);
+        } else {
+            out_tput->mtu = 0;
+        }
+
+        conn->bhc_tx_bytes = 0;
+        conn->bhc_rx_bytes = 0;
+        conn->bhc_tput_start = now;
+    }
+
+    ble_hs_unlock();
+
+    if (conn == NULL) {
+        return BLE_HS_ENOTCONN;
+    }
+
+    return 0;
+}
+
+/**
+ * Reports the link statistics of a connection, as kept by the controller
+ * and by the host, and optionally clears them.  Comparing the two tells a
+ * lossy link (CRC errors, retransmissions, skipped connection events) from
+ * a host that does not keep the controller busy (mostly empty PDUs, no
+ * outstanding fragments).
+ *
+ * Controllers that do not support the vendor specific command that reports
+ * the controller's statistics are not an error; ctlr_valid is cleared
+ * instead.
+ *
+ * @param conn_handle           The connection to query.
+ * @param reset                 Whether to clear the statistics once read.
+ * @param out_perf              On success, the statistics get written here.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOTCONN if there is no such
+ *                                  connection.
+ */
+int
+ble_gap_conn_perf(uint16_t conn_handle, int reset,
+                  struct ble_gap_conn_perf *out_perf)
+{
+    struct ble_hs_conn *conn;
+    int rc;
+
+    memset(out_perf, 0, sizeof *out_perf);
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+#if MYNEWT_VAL(BLE_HS_CONN_PERF)
+    if (conn != NULL) {
+        struct ble_hs_conn_perf *perf;
+
+        perf = &conn->bhc_perf;
+        out_perf->host_valid = 1;
+        out_perf->host_tx_frags = perf->tx_frags;
+        out_perf->host_tx_no_credit = perf->tx_no_credit;
+        if (perf->comp_pkts != 0) {
+            out_perf->host_comp_lat_avg =
+                (uint64_t)perf->comp_lat_sum * 1000 / OS_TICKS_PER_SEC /
+                perf->comp_pkts;
+        }
+        out_perf->host_comp_lat_max =
+            (uint64_t)perf->comp_lat_max * 1000 / OS_TICKS_PER_SEC;
+        out_perf->host_outstanding = conn->bhc_outstanding_pkts;
+        out_perf->host_max_outstanding = perf->max_outstanding;
+
+        if (reset) {
+            /* Keep timing the fragments still in the controller. */
+            perf->tx_frags = 0;
+            perf->tx_no_credit = 0;
+            perf->comp_pkts = 0;
+            perf->comp_lat_sum = 0;
+            perf->comp_lat_max = 0;
+            perf->max_outstanding = conn->bhc_outstanding_pkts;
+        }
+    }
+#endif
+
+    ble_hs_unlock();
+
+    if (conn == NULL) {
+        return BLE_HS_ENOTCONN;
+    }
+
+    rc = ble_hs_hci_util_read_conn_perf(conn_handle, reset, out_perf);
+    out_perf->ctlr_valid = rc == 0;
+
+    return 0;
+}
+
+/*****************************************************************************
+ * $adaptive connection parameters                                           *
+ *****************************************************************************/
+
+#if MYNEWT_VAL(BLE_GAP_CPM)
+
+static os_time_t ble_gap_cpm_next_sample;
+
+/** Whether any connection was managed as of the last sample. */
+static uint8_t ble_gap_cpm_active;
+
+static int
+ble_gap_cpm_params_valid(const struct ble_gap_upd_params *params)
+{
+    uint32_t min_timeout;
+
+    if (params->itvl_min < BLE_HCI_CONN_ITVL_MIN ||
+        params->itvl_max > BLE_HCI_CONN_ITVL_MAX ||
+        params->itvl_min > params->itvl_max ||
+        params->latency > BLE_HCI_CONN_LATENCY_MAX ||
+        params->supervision_timeout > BLE_HCI_CONN_SPVN_TIMEOUT_MAX) {
+
+        return 0;
+    }
+
+    /* The latency must leave room for a valid supervision timeout. */
+    min_timeout = (1 + (uint32_t)params->latency) * params->itvl_max / 4 + 1;
+    if (min_timeout > BLE_HCI_CONN_SPVN_TIMEOUT_MAX) {
+        return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Fills in the parameters to request for the specified mode.
+ */
+static void
+ble_gap_cpm_fill_params(const struct ble_gap_cpm_conn *cpm, uint8_t mode,
+                        struct ble_gap_upd_params *out_params)
+{
+    uint16_t min_timeout;
+
+    if (mode == BLE_GAP_CPM_MODE_BUSY) {
+        *out_params = cpm->params.busy;
+    } else {
+        *out_params = cpm->params.idle;
+    }
+
+    /* The supervision timeout (10 ms units) must exceed twice the interval
+     * (1.25 ms units) as stretched by the slave latency.
+     */
+    min_timeout = (1 + (uint32_t)out_params->latency) *
+                  out_params->itvl_max / 4 + 1;
+    if (out_params->supervision_timeout < min_timeout) {
+        out_params->supervision_timeout = min_timeout;
+    }
+}
+
+/**
+ * Holds off further requests on a connection whose peer rejected our
+ * parameters or chose its own.  The hold-off doubles with each consecutive
+ * occurrence, up to eight times the base period.
+ */
+static void
+ble_gap_cpm_backoff(struct ble_gap_cpm_conn *cpm, os_time_t now)
+{
+    if (cpm->backoff == 0) {
+        cpm->backoff = BLE_GAP_CPM_BACKOFF_TICKS;
+    } else if (cpm->backoff < BLE_GAP_CPM_BACKOFF_TICKS * 8) {
+        cpm->backoff *= 2;
+    }
+    cpm->holdoff_until = now + cpm->backoff;
+}
+
+/**
+ * Measures a connection's traffic since the previous sample and decides
+ * which parameter set it should be using.  A connection is busy if it moves
+ * at least busy_bps or has BLE_GAP_CPM_QUEUE_BUSY or more packets queued; it
+ * is idle once it has not been busy for idle_ms.  The decision is recorded in
+ * req_mode so that the update can be initiated after the host lock is
+ * released.  Must be called with the host lock held.
+ */
+static void
+ble_gap_cpm_sample(struct ble_hs_conn *conn, os_time_t now)
+{
+    struct ble_gap_cpm_conn *cpm;
+    os_time_t elapsed;
+    uint32_t bytes;
+    uint32_t delta;
+    uint32_t bps;
+    uint8_t mode;
+    int queued;
+    int busy;
+
+    cpm = &conn->bhc_cpm;
+
+    bytes = conn->bhc_tx_bytes + conn->bhc_rx_bytes;
+    if (bytes >= cpm->last_bytes) {
+        delta = bytes - cpm->last_bytes;
+    } else {
+        /* ble_gap_conn_tput() restarted the count. */
+        delta = bytes;
+    }
+    cpm->last_bytes = bytes;
+
+    elapsed = now - cpm->last_sample;
+    if (elapsed == 0) {
+        elapsed = 1;
+    }
+    cpm->last_sample = now;
+    bps = (uint64_t)delta * OS_TICKS_PER_SEC / elapsed;
+
+    queued = conn->bhc_outstanding_pkts;
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+    queued += conn->bhc_att_svr.basc_notify_q_len;
+#endif
+
+    busy = (cpm->params.busy_bps != 0 && bps >= cpm->params.busy_bps) ||
+           queued >= MYNEWT_VAL(BLE_GAP_CPM_QUEUE_BUSY);
+    if (busy) {
+        cpm->last_busy = now;
+    }
+
+    if (cpm->pending || OS_TIME_TICK_LT(now, cpm->holdoff_until)) {
+        return;
+    }
+
+    if (busy) {
+        mode = BLE_GAP_CPM_MODE_BUSY;
+    } else if (now - cpm->last_busy >= cpm->idle_ticks) {
+        mode = BLE_GAP_CPM_MODE_IDLE;
+    } else {
+        /* Not idle for long enough yet; keep the current parameters. */
+        return;
+    }
+
+    if (mode != cpm->mode) {
+        cpm->req_mode = mode;
+    }
+}
+
+/**
+ * Records the outcome of initiating an update procedure on behalf of the
+ * manager.
+ */
+static void
+ble_gap_cpm_update_started(uint16_t conn_handle, uint8_t mode, int status)
+{
+    struct ble_gap_cpm_conn *cpm;
+    struct ble_hs_conn *conn;
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn != NULL && conn->bhc_cpm.enabled) {
+        cpm = &conn->bhc_cpm;
+        switch (status) {
+        case 0:
+            cpm->mode = mode;
+            cpm->pending = 1;
+            if (mode == BLE_GAP_CPM_MODE_BUSY) {
+                STATS_INC(ble_gap_stats, cpm_busy);
+            } else {
+                STATS_INC(ble_gap_stats, cpm_idle);
+            }
+            break;
+
+        case BLE_HS_EALREADY:
+            /* Another update is in progress; try again at the next
+             * sample.
+             */
+            break;
+
+        default:
+            STATS_INC(ble_gap_stats, cpm_fail);
+            ble_gap_cpm_backoff(cpm, os_time_get());
+            break;
+        }
+    }
+
+    ble_hs_unlock();
+}
+
+/**
+ * Called whenever a connection update procedure completes, whoever initiated
+ * it.
+ */
+static void
+ble_gap_cpm_update_done(uint16_t conn_handle, int status)
+{
+    struct ble_gap_cpm_conn *cpm;
+    struct ble_hs_conn *conn;
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn != NULL && conn->bhc_cpm.enabled) {
+        cpm = &conn->bhc_cpm;
+        if (cpm->pending && status == 0) {
+            cpm->backoff = 0;
+        } else {
+            /* Either the peer rejected our parameters, or the peer or the
+             * application picked different ones.  Leave the connection
+             * alone for a while before trying again.
+             */
+            if (cpm->pending) {
+                STATS_INC(ble_gap_stats, cpm_fail);
+            }
+            cpm->mode = BLE_GAP_CPM_MODE_NONE;
+            ble_gap_cpm_backoff(cpm, os_time_get());
+        }
+        cpm->pending = 0;
+    }
+
+    ble_hs_unlock();
+}
+
+/**
+ * Samples every managed connection and initiates the parameter updates that
+ * are called for.
+ *
+ * @return                      The number of ticks until this function should
+ *                                  be called again.
+ */
+static int32_t
+ble_gap_cpm_timer(void)
+{
+    struct ble_gap_upd_params params;
+    struct ble_hs_conn *conn;
+    uint16_t conn_handle;
+    os_time_t now;
+    int32_t ticks;
+    uint8_t mode;
+    int active;
+    int rc;
+
+    if (!ble_gap_cpm_active) {
+        return BLE_HS_FOREVER;
+    }
+
+    now = os_time_get();
+    ticks = ble_gap_cpm_next_sample - now;
+    if (ticks > 0) {
+        return ticks;
+    }
+    ble_gap_cpm_next_sample = now + BLE_GAP_CPM_SAMPLE_TICKS;
+
+    active = 0;
+
+    ble_hs_lock();
+    for (conn = ble_hs_conn_first();
+         conn != NULL;
+         conn = SLIST_NEXT(conn, bhc_next)) {
+
+        if (conn->bhc_cpm.enabled) {
+            ble_gap_cpm_sample(conn, now);
+            active = 1;
+        }
+    }
+    ble_hs_unlock();
+
+    ble_gap_cpm_active = active;
+
+    /* ble_gap_update_params() acquires the host lock itself, so initiate the
+     * updates one at a time with the lock released.
+     */
+    do {
+        mode = BLE_GAP_CPM_MODE_NONE;
+        conn_handle = 0;
+
+        ble_hs_lock();
+        for (conn = ble_hs_conn_first();
+             conn != NULL;
+             conn = SLIST_NEXT(conn, bhc_next)) {
+
+            if (conn->bhc_cpm.enabled &&
+                conn->bhc_cpm.req_mode != BLE_GAP_CPM_MODE_NONE) {
+
+                mode = conn->bhc_cpm.req_mode;
+                conn->bhc_cpm.req_mode = BLE_GAP_CPM_MODE_NONE;
+                conn_handle = conn->bhc_handle;
+                ble_gap_cpm_fill_params(&conn->bhc_cpm, mode, &params);
+                break;
+            }
+        }
+        ble_hs_unlock();
+
+        if (mode != BLE_GAP_CPM_MODE_NONE) {
+            rc = ble_gap_update_params(conn_handle, &params);
+            ble_gap_cpm_update_started(conn_handle, mode, rc);
+        }
+    } while (mode != BLE_GAP_CPM_MODE_NONE);
+
+    if (!active) {
+        return BLE_HS_FOREVER;
+    }
+
+    return BLE_GAP_CPM_SAMPLE_TICKS;
+}
+
+#endif
+
+/**
+ * Hands a connection's parameters over to the adaptive connection parameter
+ * manager.  The manager samples the connection's L2CAP throughput and queue
+ * depth every BLE_GAP_CPM_SAMPLE_MS milliseconds.  While the connection is
+ * busy, it requests the busy parameters (typically a short interval without
+ * slave latency); once the connection has been quiet for idle_ms, it requests
+ * the idle parameters (typically a long interval with slave latency).  The
+ * supervision timeout is raised where necessary to suit the requested
+ * interval and latency.
+ *
+ * If the peer rejects a request, or the peer or the application changes the
+ * parameters itself, the manager backs off before requesting again.  Updates
+ * are reported through the usual BLE_GAP_EVENT_CONN_UPDATE events.
+ *
+ * @param conn_handle           The connection to manage.
+ * @param params                The parameter sets to choose from.  Copied;
+ *                                  the caller need not keep it.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EINVAL if either parameter set is
+ *                                  invalid;
+ *                              BLE_HS_ENOTCONN if there is no such
+ *                                  connection;
+ *                              BLE_HS_ENOTSUP if the manager is not
+ *                                  enabled (BLE_GAP_CPM).
+ */
+int
+ble_gap_cpm_enable(uint16_t conn_handle,
+                   const struct ble_gap_cpm_params *params)
+{
+#if !MYNEWT_VAL(BLE_GAP_CPM)
+    return BLE_HS_ENOTSUP;
+#else
+    struct ble_gap_cpm_conn *cpm;
+    struct ble_hs_conn *conn;
+    uint32_t idle_ticks;
+    os_time_t now;
+    int rc;
+
+    if (!ble_gap_cpm_params_valid(&params->busy) ||
+        !ble_gap_cpm_params_valid(&params->idle)) {
+
+        return BLE_HS_EINVAL;
+    }
+
+    rc = os_time_ms_to_ticks(params->idle_ms, &idle_ticks);
+    if (rc != 0) {
+        return BLE_HS_EINVAL;
+    }
+
+    now = os_time_get();
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn != NULL) {
+        cpm = &conn->bhc_cpm;
+        memset(cpm, 0, sizeof *cpm);
+        cpm->params = *params;
+        cpm->idle_ticks = idle_ticks;
+        cpm->last_bytes = conn->bhc_tx_bytes + conn->bhc_rx_bytes;
+        cpm->last_sample = now;
+        cpm->last_busy = now;
+        cpm->holdoff_until = now;
+        cpm->enabled = 1;
+
+        ble_gap_cpm_next_sample = now + BLE_GAP_CPM_SAMPLE_TICKS;
+        ble_gap_cpm_active = 1;
+    }
+
+    ble_hs_unlock();
+
+    if (conn == NULL) {
+        return BLE_HS_ENOTCONN;
+    }
+
+    ble_hs_timer_resched();
+
+    return 0;
+#endif
+}
+
+/**
+ * Stops managing a connection's parameters.  The parameters currently in
+ * effect are left as they are.
+ *
+ * @param conn_handle           The connection to stop managing.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOTCONN if there is no such
+ *                                  connection;
+ *                              BLE_HS_ENOTSUP if the manager is not
+ *                                  enabled (BLE_GAP_CPM).
+ */
+int
+ble_gap_cpm_disable(uint16_t conn_handle)
+{
+#if !MYNEWT_VAL(BLE_GAP_CPM)
+    return BLE_HS_ENOTSUP;
+#else
+    struct ble_hs_conn *conn;
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn != NULL) {
+        memset(&conn->bhc_cpm, 0, sizeof conn->bhc_cpm);
+    }
+
+    ble_hs_unlock();
+
+    if (conn == NULL) {
+        return BLE_HS_ENOTCONN;
+    }
+
+    return 0;
+#endif
+}
+
 /*****************************************************************************
  * $notify                                                                   *
  *****************************************************************************/
@@ -3248,6 +4055,9 @@ ble_gap_init(void)
 
     memset(&ble_gap_master, 0, sizeof ble_gap_master);
     memset(&ble_gap_slave, 0, sizeof ble_gap_slave);
+#if MYNEWT_VAL(BLE_GAP_CPM)
+    ble_gap_cpm_active = 0;
+#endif
 
     SLIST_INIT(&ble_gap_update_entries);
 
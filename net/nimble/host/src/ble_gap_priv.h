@@ -46,6 +46,8 @@ STATS_SECT_START(ble_gap_stats)
     STATS_SECT_ENTRY(adv_set_fields_fail)
     STATS_SECT_ENTRY(adv_rsp_set_fields)
     STATS_SECT_ENTRY(adv_rsp_set_fields_fail)
+    STATS_SECT_ENTRY(adv_update_field)
+    STATS_SECT_ENTRY(adv_update_field_fail)
     STATS_SECT_ENTRY(discover)
     STATS_SECT_ENTRY(discover_fail)
     STATS_SECT_ENTRY(initiate)
@@ -67,6 +69,9 @@ STATS_SECT_START(ble_gap_stats)
     STATS_SECT_ENTRY(discover_cancel_fail)
     STATS_SECT_ENTRY(security_initiate)
     STATS_SECT_ENTRY(security_initiate_fail)
+    STATS_SECT_ENTRY(cpm_busy)
+    STATS_SECT_ENTRY(cpm_idle)
+    STATS_SECT_ENTRY(cpm_fail)
 STATS_SECT_END
 
 extern STATS_SECT_DECL(ble_gap_stats) ble_gap_stats;
@@ -74,6 +79,38 @@ extern STATS_SECT_DECL(ble_gap_stats) ble_gap_stats;
 #define BLE_GAP_CONN_MODE_MAX               3
 #define BLE_GAP_DISC_MODE_MAX               3
 
+#define BLE_GAP_CPM_MODE_NONE               0
+#define BLE_GAP_CPM_MODE_BUSY               1
+#define BLE_GAP_CPM_MODE_IDLE               2
+
+/** Per-connection state of the adaptive connection parameter manager. */
+struct ble_gap_cpm_conn {
+    struct ble_gap_cpm_params params;
+
+    /* L2CAP bytes counted at the previous sample. */
+    uint32_t last_bytes;
+    os_time_t last_sample;
+    os_time_t last_busy;
+
+    /* No parameters get requested before this time; see backoff. */
+    os_time_t holdoff_until;
+    os_time_t backoff;
+
+    /* params.idle_ms, converted to ticks. */
+    os_time_t idle_ticks;
+
+    /* The parameter set currently in effect or being requested. */
+    uint8_t mode;
+
+    /* Set by the sampler: the mode to request outside the host lock. */
+    uint8_t req_mode;
+
+    unsigned enabled:1;
+
+    /* An update procedure initiated by the manager is in progress. */
+    unsigned pending:1;
+};
+
 void ble_gap_rx_adv_report(struct ble_gap_disc_desc *desc);
 int ble_gap_rx_conn_complete(struct hci_le_conn_complete *evt);
 void ble_gap_rx_disconn_complete(struct hci_disconn_complete *evt);
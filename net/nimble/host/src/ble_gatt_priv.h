@@ -69,6 +69,8 @@ STATS_SECT_START(ble_gattc_stats)
     STATS_SECT_ENTRY(indicate)
     STATS_SECT_ENTRY(indicate_fail)
     STATS_SECT_ENTRY(proc_timeout)
+    STATS_SECT_ENTRY(disc_cache_hit)
+    STATS_SECT_ENTRY(disc_cache_inval)
 STATS_SECT_END
 extern STATS_SECT_DECL(ble_gattc_stats) ble_gattc_stats;
 
@@ -130,6 +132,7 @@ void ble_gattc_rx_prep_write_rsp(uint16_t conn_handle, int status,
                                  struct os_mbuf **rxom);
 void ble_gattc_rx_exec_write_rsp(uint16_t conn_handle, int status);
 void ble_gattc_rx_indicate_rsp(uint16_t conn_handle);
+void ble_gattc_rx_indicate(uint16_t conn_handle, uint16_t attr_handle);
 void ble_gattc_rx_find_info_idata(uint16_t conn_handle,
                                   struct ble_att_find_info_idata *idata);
 void ble_gattc_rx_find_info_complete(uint16_t conn_handle, int status);
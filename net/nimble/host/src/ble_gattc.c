@@ -91,11 +91,19 @@
 /** Procedure stalled due to resource exhaustion. */
 #define BLE_GATTC_PROC_F_STALLED                0x01
 
+/** Procedure is being answered from the discovery cache. */
+#define BLE_GATTC_PROC_F_CACHED                 0x02
+
+/** A discovery result could not be written to the discovery cache. */
+#define BLE_GATTC_PROC_F_CACHE_FAIL             0x04
+
+#define BLE_GATTC_SVC_CHANGED_UUID16            0x2a05
+
 /** Represents an in-progress GATT procedure. */
 struct ble_gattc_proc {
     STAILQ_ENTRY(ble_gattc_proc) next;
 
-    uint32_t exp_os_ticks;
+    struct ble_hs_tmo tmo;
     uint16_t conn_handle;
     uint8_t op;
     uint8_t flags;
@@ -131,6 +139,7 @@ struct ble_gattc_proc {
         } find_inc_svcs;
 
         struct {
+            uint16_t start_handle;
             uint16_t prev_handle;
             uint16_t end_handle;
             ble_gatt_chr_fn *cb;
@@ -370,11 +379,20 @@ static struct os_mempool ble_gattc_proc_pool;
 /* The list of active GATT client procedures. */
 static struct ble_gattc_proc_list ble_gattc_procs;
 
+/* Deadlines of the active procedures, soonest first. */
+static struct ble_hs_tmo_list ble_gattc_tmos;
+
 /* The time when we should attempt to resume stalled procedures, in OS ticks.
  * A value of 0 indicates no stalled procedures.
  */
 static os_time_t ble_gattc_resume_at;
 
+/* Triggers delivery of discovery results from the cache. */
+static void ble_gattc_cache_event_cb(struct os_event *ev);
+static struct os_event ble_gattc_cache_ev = {
+    .ev_cb = ble_gattc_cache_event_cb,
+};
+
 /* Statistics. */
 STATS_SECT_DECL(ble_gattc_stats) ble_gattc_stats;
 STATS_NAME_START(ble_gattc_stats)
@@ -413,6 +431,8 @@ STATS_NAME_START(ble_gattc_stats)
     STATS_NAME(ble_gattc_stats, indicate)
     STATS_NAME(ble_gattc_stats, indicate_fail)
     STATS_NAME(ble_gattc_stats, proc_timeout)
+    STATS_NAME(ble_gattc_stats, disc_cache_hit)
+    STATS_NAME(ble_gattc_stats, disc_cache_inval)
 STATS_NAME_END(ble_gattc_stats)
 
 /*****************************************************************************
@@ -689,13 +709,14 @@ ble_gattc_proc_insert(struct ble_gattc_proc *proc)
 
     ble_hs_lock();
     STAILQ_INSERT_TAIL(&ble_gattc_procs, proc, next);
+    ble_hs_tmo_insert(&ble_gattc_tmos, &proc->tmo, proc->tmo.bht_exp_ticks);
     ble_hs_unlock();
 }
 
 static void
 ble_gattc_proc_set_exp_timer(struct ble_gattc_proc *proc)
 {
-    proc->exp_os_ticks = os_time_get() + BLE_GATTC_UNRESPONSIVE_TIMEOUT;
+    proc->tmo.bht_exp_ticks = os_time_get() + BLE_GATTC_UNRESPONSIVE_TIMEOUT;
 }
 
 static void
@@ -816,33 +837,6 @@ ble_gattc_proc_matches_conn_op(struct ble_gattc_proc *proc, void *arg)
     return 1;
 }
 
-struct ble_gattc_criteria_exp {
-    os_time_t now;
-    int32_t next_exp_in;
-};
-
-static int
-ble_gattc_proc_matches_expired(struct ble_gattc_proc *proc, void *arg)
-{
-    struct ble_gattc_criteria_exp *criteria;
-    int32_t time_diff;
-
-    criteria = arg;
-
-    time_diff = proc->exp_os_ticks - criteria->now;
-
-    if (time_diff <= 0) {
-        /* Procedure is expired. */
-        return 1;
-    }
-
-    /* Procedure isn't expired; determine if it is the next to expire. */
-    if (time_diff < criteria->next_exp_in) {
-        criteria->next_exp_in = time_diff;
-    }
-    return 0;
-}
-
 struct ble_gattc_criteria_conn_rx_entry {
     uint16_t conn_handle;
     const void *rx_entries;
@@ -898,6 +892,7 @@ ble_gattc_extract(ble_gattc_match_fn *cb, void *arg, int max_procs,
             } else {
                 STAILQ_REMOVE_AFTER(&ble_gattc_procs, prev, next);
             }
+            ble_hs_tmo_remove(&ble_gattc_tmos, &proc->tmo);
             STAILQ_INSERT_TAIL(dst_list, proc, next);
 
             if (max_procs > 0) {
@@ -965,15 +960,33 @@ ble_gattc_extract_stalled(struct ble_gattc_proc_list *dst_list)
 static int32_t
 ble_gattc_extract_expired(struct ble_gattc_proc_list *dst_list)
 {
-    struct ble_gattc_criteria_exp criteria;
+    struct ble_gattc_proc *proc;
+    struct ble_hs_tmo *tmo;
+    os_time_t now;
+    int32_t ticks;
 
-    criteria.now = os_time_get();
-    criteria.next_exp_in = BLE_HS_FOREVER;
+    /* Only the parent task is allowed to remove entries from the list. */
+    BLE_HS_DBG_ASSERT(ble_hs_is_parent_task());
 
+    now = os_time_get();
     STAILQ_INIT(dst_list);
-    ble_gattc_extract(ble_gattc_proc_matches_expired, &criteria, 0, dst_list);
 
-    return criteria.next_exp_in;
+    ble_hs_lock();
+
+    /* Deadlines are sorted; only the procedures that are due get visited. */
+    while ((tmo = ble_hs_tmo_first_expired(&ble_gattc_tmos, now)) != NULL) {
+        ble_hs_tmo_remove(&ble_gattc_tmos, tmo);
+
+        proc = BLE_HS_TMO_CONTAINER(tmo, struct ble_gattc_proc, tmo);
+        STAILQ_REMOVE(&ble_gattc_procs, proc, ble_gattc_proc, next);
+        STAILQ_INSERT_TAIL(dst_list, proc, next);
+    }
+
+    ticks = ble_hs_tmo_ticks_until_exp(&ble_gattc_tmos, now);
+
+    ble_hs_unlock();
+
+    return ticks;
 }
 
 static struct ble_gattc_proc *
@@ -1150,6 +1163,138 @@ ble_gattc_error(int status, uint16_t att_handle)
     return &error;
 }
 
+/*****************************************************************************
+ * $discovery cache                                                          *
+ *****************************************************************************/
+
+/**
+ * Retrieves the identity address of the peer on the specified connection.
+ * Cached discovery results are keyed by this address.
+ */
+static int
+ble_gattc_cache_peer(uint16_t conn_handle, uint8_t *out_addr_type,
+                     uint8_t *out_addr)
+{
+    struct ble_gap_conn_desc desc;
+    int rc;
+
+    rc = ble_gap_conn_find(conn_handle, &desc);
+    if (rc != 0) {
+        return rc;
+    }
+
+    *out_addr_type = desc.peer_id_addr_type;
+    memcpy(out_addr, desc.peer_id_addr, 6);
+    return 0;
+}
+
+/**
+ * Records a single discovery result in the store.  If the write fails, the
+ * procedure is flagged so that its completion does not get recorded; the next
+ * discovery then goes over the air rather than reporting a partial result.
+ */
+static void
+ble_gattc_cache_add(struct ble_gattc_proc *proc, uint8_t kind,
+                    uint16_t handle, uint16_t end_handle, uint8_t properties,
+                    const uint8_t *uuid128)
+{
+#if !MYNEWT_VAL(BLE_GATT_DISC_CACHE)
+    return;
+#endif
+
+    struct ble_store_value_gatt_disc value;
+    int rc;
+
+    if (proc->flags &
+        (BLE_GATTC_PROC_F_CACHED | BLE_GATTC_PROC_F_CACHE_FAIL)) {
+
+        return;
+    }
+
+    memset(&value, 0, sizeof value);
+    rc = ble_gattc_cache_peer(proc->conn_handle, &value.peer_addr_type,
+                              value.peer_addr);
+    if (rc == 0) {
+        value.kind = kind;
+        value.handle = handle;
+        value.end_handle = end_handle;
+        value.properties = properties;
+        if (uuid128 != NULL) {
+            memcpy(value.uuid128, uuid128, 16);
+        }
+
+        rc = ble_store_write_gatt_disc(&value);
+    }
+
+    if (rc != 0) {
+        proc->flags |= BLE_GATTC_PROC_F_CACHE_FAIL;
+    }
+}
+
+/**
+ * Indicates whether the store holds the complete result of the specified
+ * discovery procedure for the peer on the given connection.
+ *
+ * @param kind                  The BLE_STORE_GATT_DISC_[...]_DONE record
+ *                                  that marks the procedure as complete.
+ */
+static int
+ble_gattc_cache_complete(uint16_t conn_handle, uint8_t kind,
+                         uint16_t handle, uint16_t end_handle)
+{
+#if !MYNEWT_VAL(BLE_GATT_DISC_CACHE)
+    return 0;
+#endif
+
+    struct ble_store_value_gatt_disc value;
+    struct ble_store_key_gatt_disc key;
+    int rc;
+
+    memset(&key, 0, sizeof key);
+    rc = ble_gattc_cache_peer(conn_handle, &key.peer_addr_type,
+                              key.peer_addr);
+    if (rc != 0) {
+        return 0;
+    }
+
+    key.kind = kind;
+    key.handle = handle;
+    rc = ble_store_read_gatt_disc(&key, &value);
+
+    return rc == 0 && value.end_handle == end_handle;
+}
+
+/**
+ * Schedules delivery of cached discovery results in the host parent task.
+ */
+static void
+ble_gattc_cache_sched(void)
+{
+#if !MYNEWT_VAL(BLE_HS_REQUIRE_OS)
+    if (!os_started()) {
+        ble_gattc_cache_event_cb(NULL);
+        return;
+    }
+#endif
+
+    ble_hs_enqueue_event(&ble_gattc_cache_ev);
+}
+
+/**
+ * Starts a discovery procedure that is to be answered from the store.  As with
+ * a procedure that goes over the air, results are reported from the host
+ * parent task rather than from the initiating function.
+ */
+static void
+ble_gattc_cache_start(struct ble_gattc_proc *proc)
+{
+    STATS_INC(ble_gattc_stats, disc_cache_hit);
+
+    proc->flags |= BLE_GATTC_PROC_F_CACHED;
+    ble_gattc_process_status(proc, 0);
+    ble_gattc_cache_sched();
+}
+
 /*****************************************************************************
  * $mtu                                                                      *
  *****************************************************************************/
@@ -1289,6 +1434,15 @@ ble_gattc_disc_all_svcs_cb(struct ble_gattc_proc *proc,
         STATS_INC(ble_gattc_stats, disc_all_svcs_fail);
     }
 
+    if (status == 0) {
+        ble_gattc_cache_add(proc, BLE_STORE_GATT_DISC_SVC,
+                            service->start_handle, service->end_handle, 0,
+                            service->uuid128);
+    } else if (status == BLE_HS_EDONE) {
+        ble_gattc_cache_add(proc, BLE_STORE_GATT_DISC_SVCS_DONE, 0, 0, 0,
+                            NULL);
+    }
+
     if (proc->disc_all_svcs.cb == NULL) {
         rc = 0;
     } else {
@@ -1482,6 +1636,12 @@ ble_gattc_disc_all_svcs(uint16_t conn_handle, ble_gatt_disc_svc_fn *cb,
 
     ble_gattc_log_proc_init("discover all services\n");
 
+    if (ble_gattc_cache_complete(conn_handle, BLE_STORE_GATT_DISC_SVCS_DONE,
+                                 0, 0)) {
+        ble_gattc_cache_start(proc);
+        return 0;
+    }
+
     rc = ble_gattc_disc_all_svcs_tx(proc);
     if (rc != 0) {
         goto done;
@@ -2075,6 +2235,15 @@ ble_gattc_disc_all_chrs_cb(struct ble_gattc_proc *proc, int status,
         STATS_INC(ble_gattc_stats, disc_all_chrs_fail);
     }
 
+    if (status == 0) {
+        ble_gattc_cache_add(proc, BLE_STORE_GATT_DISC_CHR, chr->def_handle,
+                            chr->val_handle, chr->properties, chr->uuid128);
+    } else if (status == BLE_HS_EDONE) {
+        ble_gattc_cache_add(proc, BLE_STORE_GATT_DISC_CHRS_DONE,
+                            proc->disc_all_chrs.start_handle,
+                            proc->disc_all_chrs.end_handle, 0, NULL);
+    }
+
     if (proc->disc_all_chrs.cb == NULL) {
         rc = 0;
     } else {
@@ -2273,6 +2442,7 @@ ble_gattc_disc_all_chrs(uint16_t conn_handle, uint16_t start_handle,
 
     proc->op = BLE_GATT_OP_DISC_ALL_CHRS;
     proc->conn_handle = conn_handle;
+    proc->disc_all_chrs.start_handle = start_handle;
     proc->disc_all_chrs.prev_handle = start_handle - 1;
     proc->disc_all_chrs.end_handle = end_handle;
     proc->disc_all_chrs.cb = cb;
@@ -2280,6 +2450,12 @@ ble_gattc_disc_all_chrs(uint16_t conn_handle, uint16_t start_handle,
 
     ble_gattc_log_disc_all_chrs(proc);
 
+    if (ble_gattc_cache_complete(conn_handle, BLE_STORE_GATT_DISC_CHRS_DONE,
+                                 start_handle, end_handle)) {
+        ble_gattc_cache_start(proc);
+        return 0;
+    }
+
     rc = ble_gattc_disc_all_chrs_tx(proc);
     if (rc != 0) {
         goto done;
@@ -2577,6 +2753,16 @@ ble_gattc_disc_all_dscs_cb(struct ble_gattc_proc *proc, int status,
         STATS_INC(ble_gattc_stats, disc_all_dscs_fail);
     }
 
+    if (status == 0) {
+        ble_gattc_cache_add(proc, BLE_STORE_GATT_DISC_DSC, dsc->handle,
+                            proc->disc_all_dscs.chr_val_handle, 0,
+                            dsc->uuid128);
+    } else if (status == BLE_HS_EDONE) {
+        ble_gattc_cache_add(proc, BLE_STORE_GATT_DISC_DSCS_DONE,
+                            proc->disc_all_dscs.chr_val_handle,
+                            proc->disc_all_dscs.end_handle, 0, NULL);
+    }
+
     if (proc->disc_all_dscs.cb == NULL) {
         rc = 0;
     } else {
@@ -2757,6 +2943,12 @@ ble_gattc_disc_all_dscs(uint16_t conn_handle, uint16_t chr_val_handle,
 
     ble_gattc_log_disc_all_dscs(proc);
 
+    if (ble_gattc_cache_complete(conn_handle, BLE_STORE_GATT_DISC_DSCS_DONE,
+                                 chr_val_handle, chr_end_handle)) {
+        ble_gattc_cache_start(proc);
+        return 0;
+    }
+
     rc = ble_gattc_disc_all_dscs_tx(proc);
     if (rc != 0) {
         goto done;
@@ -4925,6 +5117,200 @@ ble_gattc_connection_broken(uint16_t conn_handle)
     ble_gattc_fail_procs(conn_handle, BLE_GATT_OP_NONE, BLE_HS_ENOTCONN);
 }
 
+static int
+ble_gattc_proc_matches_cached(struct ble_gattc_proc *proc, void *unused)
+{
+    return proc->flags & BLE_GATTC_PROC_F_CACHED;
+}
+
+/**
+ * Reports the stored results of a discovery procedure to the application.
+ */
+static void
+ble_gattc_cache_replay(struct ble_gattc_proc *proc)
+{
+    struct ble_store_value_gatt_disc value;
+    struct ble_store_key_gatt_disc key;
+    struct ble_gatt_svc svc;
+    struct ble_gatt_chr chr;
+    struct ble_gatt_dsc dsc;
+    uint16_t start_handle;
+    uint16_t end_handle;
+    int cbrc;
+    int rc;
+
+    memset(&key, 0, sizeof key);
+    rc = ble_gattc_cache_peer(proc->conn_handle, &key.peer_addr_type,
+                              key.peer_addr);
+    if (rc != 0) {
+        ble_gattc_err_dispatch_get(proc->op)(proc, rc, 0);
+        return;
+    }
+
+    switch (proc->op) {
+    case BLE_GATT_OP_DISC_ALL_SVCS:
+        key.kind = BLE_STORE_GATT_DISC_SVC;
+        start_handle = 0x0001;
+        end_handle = 0xffff;
+        break;
+
+    case BLE_GATT_OP_DISC_ALL_CHRS:
+        key.kind = BLE_STORE_GATT_DISC_CHR;
+        start_handle = proc->disc_all_chrs.start_handle;
+        end_handle = proc->disc_all_chrs.end_handle;
+        break;
+
+    case BLE_GATT_OP_DISC_ALL_DSCS:
+        key.kind = BLE_STORE_GATT_DISC_DSC;
+        start_handle = proc->disc_all_dscs.chr_val_handle + 1;
+        end_handle = proc->disc_all_dscs.end_handle;
+        break;
+
+    default:
+        BLE_HS_DBG_ASSERT(0);
+        return;
+    }
+
+    /* Entries are stored in the order they were discovered, i.e., in
+     * ascending handle order.
+     */
+    for (; key.idx < UINT8_MAX; key.idx++) {
+        rc = ble_store_read_gatt_disc(&key, &value);
+        if (rc != 0) {
+            break;
+        }
+
+        if (value.handle < start_handle || value.handle > end_handle) {
+            continue;
+        }
+
+        switch (proc->op) {
+        case BLE_GATT_OP_DISC_ALL_SVCS:
+            svc.start_handle = value.handle;
+            svc.end_handle = value.end_handle;
+            memcpy(svc.uuid128, value.uuid128, 16);
+            cbrc = ble_gattc_disc_all_svcs_cb(proc, 0, 0, &svc);
+            break;
+
+        case BLE_GATT_OP_DISC_ALL_CHRS:
+            chr.def_handle = value.handle;
+            chr.val_handle = value.end_handle;
+            chr.properties = value.properties;
+            memcpy(chr.uuid128, value.uuid128, 16);
+            cbrc = ble_gattc_disc_all_chrs_cb(proc, 0, 0, &chr);
+            break;
+
+        default:
+            dsc.handle = value.handle;
+            memcpy(dsc.uuid128, value.uuid128, 16);
+            cbrc = ble_gattc_disc_all_dscs_cb(proc, 0, 0, &dsc);
+            break;
+        }
+
+        if (cbrc != 0) {
+            /* Application aborted the procedure. */
+            return;
+        }
+    }
+
+    if (rc == BLE_HS_ENOENT) {
+        rc = BLE_HS_EDONE;
+    }
+    ble_gattc_err_dispatch_get(proc->op)(proc, rc, 0);
+}
+
+static void
+ble_gattc_cache_event_cb(struct os_event *ev)
+{
+    struct ble_gattc_proc_list proc_list;
+    struct ble_gattc_proc *proc;
+
+    ble_gattc_extract(ble_gattc_proc_matches_cached, NULL, 0, &proc_list);
+    while ((proc = STAILQ_FIRST(&proc_list)) != NULL) {
+        STAILQ_REMOVE_HEAD(&proc_list, next);
+        ble_gattc_cache_replay(proc);
+        ble_gattc_proc_free(proc);
+    }
+}
+
+/**
+ * Discards all cached discovery results for the specified peer.  The next
+ * discovery procedure against the peer goes over the air.
+ *
+ * @param peer_addr_type        The type of the peer's identity address.
+ * @param peer_addr             The peer's identity address.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+ble_gattc_disc_cache_clear(uint8_t peer_addr_type, const uint8_t *peer_addr)
+{
+#if !MYNEWT_VAL(BLE_GATT_DISC_CACHE)
+    return BLE_HS_ENOTSUP;
+#endif
+
+    struct ble_store_key_gatt_disc key;
+    int rc;
+
+    memset(&key, 0, sizeof key);
+    key.peer_addr_type = peer_addr_type;
+    memcpy(key.peer_addr, peer_addr, 6);
+
+    do {
+        rc = ble_store_delete_gatt_disc(&key);
+    } while (rc == 0);
+
+    if (rc != BLE_HS_ENOENT) {
+        return rc;
+    }
+
+    return 0;
+}
+
+/**
+ * Processes an incoming indication.  If the indicated attribute is the peer's
+ * Service Changed characteristic, all of the peer's cached discovery results
+ * are discarded.
+ */
+void
+ble_gattc_rx_indicate(uint16_t conn_handle, uint16_t attr_handle)
+{
+#if !MYNEWT_VAL(BLE_GATT_DISC_CACHE)
+    return;
+#endif
+
+    struct ble_store_value_gatt_disc value;
+    struct ble_store_key_gatt_disc key;
+    int rc;
+
+    memset(&key, 0, sizeof key);
+    rc = ble_gattc_cache_peer(conn_handle, &key.peer_addr_type,
+                              key.peer_addr);
+    if (rc != 0) {
+        return;
+    }
+
+    key.kind = BLE_STORE_GATT_DISC_CHR;
+    for (; key.idx < UINT8_MAX; key.idx++) {
+        rc = ble_store_read_gatt_disc(&key, &value);
+        if (rc != 0) {
+            return;
+        }
+
+        if (value.end_handle == attr_handle &&
+            ble_uuid_128_to_16(value.uuid128) ==
+                BLE_GATTC_SVC_CHANGED_UUID16) {
+
+            break;
+        }
+    }
+
+    if (key.idx < UINT8_MAX) {
+        STATS_INC(ble_gattc_stats, disc_cache_inval);
+        ble_gattc_disc_cache_clear(key.peer_addr_type, key.peer_addr);
+    }
+}
+
 /**
  * Indicates whether there are currently any active GATT client procedures.
  */
@@ -4940,6 +5326,7 @@ ble_gattc_init(void)
     int rc;
 
     STAILQ_INIT(&ble_gattc_procs);
+    TAILQ_INIT(&ble_gattc_tmos);
 
     if (MYNEWT_VAL(BLE_GATT_MAX_PROCS) > 0) {
         rc = os_mempool_init(&ble_gattc_proc_pool,
@@ -67,14 +67,88 @@ STATS_NAME_START(ble_gatts_stats)
     STATS_NAME(ble_gatts_stats, dsc_writes)
 STATS_NAME_END(ble_gatts_stats)
 
+/**
+ * Returns the UUID of a service, characteristic, or descriptor definition in
+ * its shortest form.  A native UUID already in that form is returned as is;
+ * anything else (e.g., a legacy uuid128 byte array) is converted into the
+ * supplied storage.
+ *
+ * @return                      The UUID; NULL if the definition has none.
+ */
+static const ble_uuid_t *
+ble_gatts_def_uuid(const ble_uuid_t *uuid, const uint8_t *uuid128,
+                   ble_uuid_any_t *storage)
+{
+    uint8_t flat[16];
+
+    if (uuid != NULL) {
+        if (ble_uuid_is_compact(uuid)) {
+            return uuid;
+        }
+
+        ble_uuid_to_128(uuid, flat);
+        uuid128 = flat;
+    }
+
+    if (uuid128 == NULL) {
+        return NULL;
+    }
+
+    if (ble_uuid_init_from_buf(storage, uuid128, 16) != 0) {
+        return NULL;
+    }
+
+    return &storage->u;
+}
+
+#define BLE_GATTS_DEF_UUID(def, storage)                                    \
+    ble_gatts_def_uuid((def)->uuid, (def)->uuid128, (storage))
+
+/** Whether a definition terminates its array. */
+#define BLE_GATTS_DEF_IS_END(def)                                           \
+    ((def)->uuid == NULL && (def)->uuid128 == NULL)
+
+/**
+ * Registers the attribute carrying a definition's UUID as its type.  A native
+ * UUID is referenced in place; a uuid128 byte array gets copied in its
+ * compact form.
+ */
+static int
+ble_gatts_register_def_attr(const ble_uuid_t *uuid, const uint8_t *uuid128,
+                            uint8_t flags, uint16_t *handle_id,
+                            ble_att_svr_access_fn *cb, void *cb_arg)
+{
+    if (uuid != NULL) {
+        return ble_att_svr_register_static(uuid, flags, handle_id, cb, cb_arg);
+    }
+
+    return ble_att_svr_register(uuid128, flags, handle_id, cb, cb_arg);
+}
+
+/**
+ * Appends a UUID to an attribute value in its ATT form (16 or 128 bits).
+ */
+static int
+ble_gatts_append_uuid(struct os_mbuf *om, const ble_uuid_t *uuid)
+{
+    uint8_t *buf;
+
+    buf = os_mbuf_extend(om, ble_uuid_att_len(uuid));
+    if (buf == NULL) {
+        return BLE_HS_ENOMEM;
+    }
+
+    ble_uuid_flat(uuid, buf);
+    return 0;
+}
+
 static int
 ble_gatts_svc_access(uint16_t conn_handle, uint16_t attr_handle,
                      uint8_t op, uint16_t offset, struct os_mbuf **om,
                      void *arg)
 {
     const struct ble_gatt_svc_def *svc;
-    uint16_t uuid16;
-    uint8_t *buf;
+    ble_uuid_any_t storage;
     int rc;
 
     STATS_INC(ble_gatts_stats, svc_def_reads);
@@ -83,18 +157,9 @@ ble_gatts_svc_access(uint16_t conn_handle, uint16_t attr_handle,
 
     svc = arg;
 
-    uuid16 = ble_uuid_128_to_16(svc->uuid128);
-    if (uuid16 != 0) {
-        buf = os_mbuf_extend(*om, 2);
-        if (buf == NULL) {
-            return BLE_ATT_ERR_INSUFFICIENT_RES;
-        }
-        htole16(buf, uuid16);
-    } else {
-        rc = os_mbuf_append(*om, svc->uuid128, 16);
-        if (rc != 0) {
-            return BLE_ATT_ERR_INSUFFICIENT_RES;
-        }
+    rc = ble_gatts_append_uuid(*om, BLE_GATTS_DEF_UUID(svc, &storage));
+    if (rc != 0) {
+        return BLE_ATT_ERR_INSUFFICIENT_RES;
     }
 
     return 0;
@@ -106,6 +171,7 @@ ble_gatts_inc_access(uint16_t conn_handle, uint16_t attr_handle,
                      void *arg)
 {
     const struct ble_gatts_svc_entry *entry;
+    ble_uuid_any_t storage;
     uint16_t uuid16;
     uint8_t *buf;
 
@@ -123,7 +189,7 @@ ble_gatts_inc_access(uint16_t conn_handle, uint16_t attr_handle,
     htole16(buf + 2, entry->end_group_handle);
 
     /* Only include the service UUID if it has a 16-bit representation. */
-    uuid16 = ble_uuid_128_to_16(entry->svc->uuid128);
+    uuid16 = ble_uuid_u16(BLE_GATTS_DEF_UUID(entry->svc, &storage));
     if (uuid16 != 0) {
         buf = os_mbuf_extend(*om, 2);
         if (buf == NULL) {
@@ -228,8 +294,9 @@ ble_gatts_chr_def_access(uint16_t conn_handle, uint16_t attr_handle,
                          void *arg)
 {
     const struct ble_gatt_chr_def *chr;
-    uint16_t uuid16;
+    ble_uuid_any_t storage;
     uint8_t *buf;
+    int rc;
 
     STATS_INC(ble_gatts_stats, chr_def_reads);
 
@@ -247,19 +314,9 @@ ble_gatts_chr_def_access(uint16_t conn_handle, uint16_t attr_handle,
     /* The value attribute is always immediately after the declaration. */
     htole16(buf + 1, attr_handle + 1);
 
-    uuid16 = ble_uuid_128_to_16(chr->uuid128);
-    if (uuid16 != 0) {
-        buf = os_mbuf_extend(*om, 2);
-        if (buf == NULL) {
-            return BLE_ATT_ERR_INSUFFICIENT_RES;
-        }
-        htole16(buf, uuid16);
-    } else {
-        buf = os_mbuf_extend(*om, 16);
-        if (buf == NULL) {
-            return BLE_ATT_ERR_INSUFFICIENT_RES;
-        }
-        memcpy(buf, chr->uuid128, 16);
+    rc = ble_gatts_append_uuid(*om, BLE_GATTS_DEF_UUID(chr, &storage));
+    if (rc != 0) {
+        return BLE_ATT_ERR_INSUFFICIENT_RES;
     }
 
     return 0;
@@ -268,7 +325,7 @@ ble_gatts_chr_def_access(uint16_t conn_handle, uint16_t attr_handle,
 static int
 ble_gatts_chr_is_sane(const struct ble_gatt_chr_def *chr)
 {
-    if (chr->uuid128 == NULL) {
+    if (BLE_GATTS_DEF_IS_END(chr)) {
         return 0;
     }
 
@@ -333,9 +390,14 @@ ble_gatts_val_access(uint16_t conn_handle, uint16_t attr_handle,
 
         rc = access_cb(conn_handle, attr_handle, gatt_ctxt, cb_arg);
         if (rc == 0) {
+            /* Hand the application's chain to the caller rather than
+             * copying it; only the bytes before the offset are trimmed.
+             */
             attr_len = OS_MBUF_PKTLEN(gatt_ctxt->om) - offset;
             if (attr_len > 0) {
-                os_mbuf_appendfrom(*om, gatt_ctxt->om, offset, attr_len);
+                os_mbuf_adj(gatt_ctxt->om, offset);
+                os_mbuf_concat(*om, gatt_ctxt->om);
+                gatt_ctxt->om = NULL;
             }
         }
 
@@ -488,7 +550,7 @@ ble_gatts_dsc_access(uint16_t conn_handle, uint16_t attr_handle,
 static int
 ble_gatts_dsc_is_sane(const struct ble_gatt_dsc_def *dsc)
 {
-    if (dsc->uuid128 == NULL) {
+    if (BLE_GATTS_DEF_IS_END(dsc)) {
         return 0;
     }
 
@@ -514,8 +576,9 @@ ble_gatts_register_dsc(const struct ble_gatt_svc_def *svc,
         return BLE_HS_EINVAL;
     }
 
-    rc = ble_att_svr_register(dsc->uuid128, dsc->att_flags, &dsc_handle,
-                              ble_gatts_dsc_access, (void *)dsc);
+    rc = ble_gatts_register_def_attr(dsc->uuid, dsc->uuid128, dsc->att_flags,
+                                     &dsc_handle, ble_gatts_dsc_access,
+                                     (void *)dsc);
     if (rc != 0) {
         return rc;
     }
@@ -742,16 +805,12 @@ ble_gatts_clt_cfg_access(uint16_t conn_handle, uint16_t attr_handle,
 static int
 ble_gatts_register_clt_cfg_dsc(uint16_t *att_handle)
 {
-    uint8_t uuid128[16];
     int rc;
 
-    rc = ble_uuid_16_to_128(BLE_GATT_DSC_CLT_CFG_UUID16, uuid128);
-    if (rc != 0) {
-        return rc;
-    }
-
-    rc = ble_att_svr_register(uuid128, BLE_ATT_F_READ | BLE_ATT_F_WRITE,
-                              att_handle, ble_gatts_clt_cfg_access, NULL);
+    rc = ble_att_svr_register_uuid16(BLE_GATT_DSC_CLT_CFG_UUID16,
+                                     BLE_ATT_F_READ | BLE_ATT_F_WRITE,
+                                     att_handle, ble_gatts_clt_cfg_access,
+                                     NULL);
     if (rc != 0) {
         return rc;
     }
@@ -799,8 +858,9 @@ ble_gatts_register_chr(const struct ble_gatt_svc_def *svc,
      * arg).
      */
     att_flags = ble_gatts_att_flags_from_chr_flags(chr->flags);
-    rc = ble_att_svr_register(chr->uuid128, att_flags, &val_handle,
-                              ble_gatts_chr_val_access, (void *)chr);
+    rc = ble_gatts_register_def_attr(chr->uuid, chr->uuid128, att_flags,
+                                     &val_handle, ble_gatts_chr_val_access,
+                                     (void *)chr);
     if (rc != 0) {
         return rc;
     }
@@ -829,7 +889,7 @@ ble_gatts_register_chr(const struct ble_gatt_svc_def *svc,
 
     /* Register each descriptor. */
     if (chr->descriptors != NULL) {
-        for (dsc = chr->descriptors; dsc->uuid128 != NULL; dsc++) {
+        for (dsc = chr->descriptors; !BLE_GATTS_DEF_IS_END(dsc); dsc++) {
             rc = ble_gatts_register_dsc(svc, chr, dsc, def_handle, register_cb,
                                         cb_arg);
             if (rc != 0) {
@@ -869,7 +929,7 @@ ble_gatts_svc_is_sane(const struct ble_gatt_svc_def *svc)
         return 0;
     }
 
-    if (svc->uuid128 == NULL) {
+    if (BLE_GATTS_DEF_IS_END(svc)) {
         return 0;
     }
 
@@ -933,7 +993,7 @@ ble_gatts_register_svc(const struct ble_gatt_svc_def *svc,
 
     /* Register each characteristic. */
     if (svc->characteristics != NULL) {
-        for (chr = svc->characteristics; chr->uuid128 != NULL; chr++) {
+        for (chr = svc->characteristics; !BLE_GATTS_DEF_IS_END(chr); chr++) {
             rc = ble_gatts_register_chr(svc, chr, register_cb, cb_arg);
             if (rc != 0) {
                 return rc;
@@ -1134,7 +1194,6 @@ ble_gatts_start(void)
     struct ble_att_svr_entry *ha;
     struct ble_gatt_chr_def *chr;
     uint16_t allowed_flags;
-    uint8_t uuid128[16];
     int num_elems;
     int idx;
     int rc;
@@ -1197,11 +1256,11 @@ ble_gatts_start(void)
     }
 
     /* Fill the cache. */
-    rc = ble_uuid_16_to_128(BLE_ATT_UUID_CHARACTERISTIC, uuid128);
-    BLE_HS_DBG_ASSERT_EVAL(rc == 0);
     idx = 0;
     ha = NULL;
-    while ((ha = ble_att_svr_find_by_uuid(ha, uuid128, 0xffff)) != NULL) {
+    while ((ha = ble_att_svr_find_by_uuid(
+                ha, BLE_UUID16_DECLARE(BLE_ATT_UUID_CHARACTERISTIC),
+                0xffff)) != NULL) {
         chr = ha->ha_cb_arg;
         allowed_flags = ble_gatts_chr_clt_cfg_allowed(chr);
         if (allowed_flags != 0) {
@@ -1710,11 +1769,19 @@ static struct ble_gatts_svc_entry *
 ble_gatts_find_svc_entry(const void *uuid128)
 {
     struct ble_gatts_svc_entry *entry;
+    const ble_uuid_t *svc_uuid;
+    ble_uuid_any_t storage;
+    ble_uuid_any_t uuid;
     int i;
 
+    if (ble_uuid_init_from_buf(&uuid, uuid128, 16) != 0) {
+        return NULL;
+    }
+
     for (i = 0; i < ble_gatts_num_svc_entries; i++) {
         entry = ble_gatts_svc_entries + i;
-        if (memcmp(uuid128, entry->svc->uuid128, 16) == 0) {
+        svc_uuid = BLE_GATTS_DEF_UUID(entry->svc, &storage);
+        if (ble_uuid_cmp(&uuid.u, svc_uuid) == 0) {
             return entry;
         }
     }
@@ -1731,7 +1798,13 @@ ble_gatts_find_svc_chr_attr(const void *svc_uuid128, const void *chr_uuid128,
     struct ble_att_svr_entry *att_svc;
     struct ble_att_svr_entry *next;
     struct ble_att_svr_entry *cur;
-    uint16_t uuid16;
+    ble_uuid_any_t chr_uuid;
+    int rc;
+
+    rc = ble_uuid_init_from_buf(&chr_uuid, chr_uuid128, 16);
+    if (rc != 0) {
+        return BLE_HS_ENOENT;
+    }
 
     svc_entry = ble_gatts_find_svc_entry(svc_uuid128);
     if (svc_entry == NULL) {
@@ -1743,23 +1816,22 @@ ble_gatts_find_svc_chr_attr(const void *svc_uuid128, const void *chr_uuid128,
         return BLE_HS_EUNKNOWN;
     }
 
-    cur = STAILQ_NEXT(att_svc, ha_next);
+    cur = ble_att_svr_find_by_handle(att_svc->ha_handle_id + 1);
     while (1) {
         if (cur == NULL) {
             /* Reached end of attribute list without a match. */
             return BLE_HS_ENOENT;
         }
-        next = STAILQ_NEXT(cur, ha_next);
+        next = ble_att_svr_find_by_handle(cur->ha_handle_id + 1);
 
         if (cur->ha_handle_id == svc_entry->end_group_handle) {
             /* Reached end of service without a match. */
             return BLE_HS_ENOENT;
         }
 
-        uuid16 = ble_uuid_128_to_16(cur->ha_uuid);
-        if (uuid16 == BLE_ATT_UUID_CHARACTERISTIC &&
+        if (ble_uuid_u16(cur->ha_uuid) == BLE_ATT_UUID_CHARACTERISTIC &&
             next != NULL &&
-            memcmp(next->ha_uuid, chr_uuid128, 16) == 0) {
+            ble_uuid_cmp(next->ha_uuid, &chr_uuid.u) == 0) {
 
             if (out_svc_entry != NULL) {
                 *out_svc_entry = svc_entry;
@@ -1862,16 +1934,21 @@ ble_gatts_find_dsc(const void *svc_uuid128, const void *chr_uuid128,
     struct ble_gatts_svc_entry *svc_entry;
     struct ble_att_svr_entry *att_chr;
     struct ble_att_svr_entry *cur;
-    uint16_t uuid16;
+    ble_uuid_any_t dsc_uuid;
     int rc;
 
+    rc = ble_uuid_init_from_buf(&dsc_uuid, dsc_uuid128, 16);
+    if (rc != 0) {
+        return BLE_HS_ENOENT;
+    }
+
     rc = ble_gatts_find_svc_chr_attr(svc_uuid128, chr_uuid128, &svc_entry,
                                      &att_chr);
     if (rc != 0) {
         return rc;
     }
 
-    cur = STAILQ_NEXT(att_chr, ha_next);
+    cur = ble_att_svr_find_by_handle(att_chr->ha_handle_id + 1);
     while (1) {
         if (cur == NULL) {
             /* Reached end of attribute list without a match. */
@@ -1883,19 +1960,18 @@ ble_gatts_find_dsc(const void *svc_uuid128, const void *chr_uuid128,
             return BLE_HS_ENOENT;
         }
 
-        uuid16 = ble_uuid_128_to_16(cur->ha_uuid);
-        if (uuid16 == BLE_ATT_UUID_CHARACTERISTIC) {
+        if (ble_uuid_u16(cur->ha_uuid) == BLE_ATT_UUID_CHARACTERISTIC) {
             /* Reached end of characteristic without a match. */
             return BLE_HS_ENOENT;
         }
 
-        if (memcmp(cur->ha_uuid, dsc_uuid128, 16) == 0) {
+        if (ble_uuid_cmp(cur->ha_uuid, &dsc_uuid.u) == 0) {
             if (out_handle != NULL) {
                 *out_handle = cur->ha_handle_id;
                 return 0;
             }
         }
-        cur = STAILQ_NEXT(cur, ha_next);
+        cur = ble_att_svr_find_by_handle(cur->ha_handle_id + 1);
     }
 }
 
@@ -1985,7 +2061,10 @@ ble_gatts_count_resources(const struct ble_gatt_svc_def *svcs,
         }
 
         if (svc->characteristics != NULL) {
-            for (c = 0; svc->characteristics[c].uuid128 != NULL; c++) {
+            for (c = 0;
+                 !BLE_GATTS_DEF_IS_END(svc->characteristics + c);
+                 c++) {
+
                 chr = svc->characteristics + c;
 
                 if (!ble_gatts_chr_is_sane(chr)) {
@@ -2017,7 +2096,10 @@ ble_gatts_count_resources(const struct ble_gatt_svc_def *svcs,
                 }
 
                 if (chr->descriptors != NULL) {
-                    for (d = 0; chr->descriptors[d].uuid128 != NULL; d++) {
+                    for (d = 0;
+                         !BLE_GATTS_DEF_IS_END(chr->descriptors + d);
+                         d++) {
+
                         if (!ble_gatts_dsc_is_sane(chr->descriptors + d)) {
                             BLE_HS_DBG_ASSERT(0);
                             return BLE_HS_EINVAL;
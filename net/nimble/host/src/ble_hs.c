@@ -27,6 +27,9 @@
 #include "os/os.h"
 #include "console/console.h"
 #include "nimble/ble_hci_trans.h"
+#if MYNEWT_VAL(BLE_HCI_RAM_DIRECT)
+#include "transport/ram/ble_hci_ram.h"
+#endif
 #include "ble_hs_priv.h"
 
 #define BLE_HS_HCI_EVT_COUNT                    \
@@ -105,6 +108,10 @@ STATS_NAME_START(ble_hs_stats)
     STATS_NAME(ble_hs_stats, hci_timeout)
     STATS_NAME(ble_hs_stats, reset)
     STATS_NAME(ble_hs_stats, sync)
+    STATS_NAME(ble_hs_stats, lock_contended)
+    STATS_NAME(ble_hs_stats, lock_wait_ticks)
+    STATS_NAME(ble_hs_stats, store_lock_contended)
+    STATS_NAME(ble_hs_stats, store_lock_wait_ticks)
 STATS_NAME_END(ble_hs_stats)
 
 static struct os_eventq *
@@ -148,6 +155,8 @@ ble_hs_is_parent_task(void)
 void
 ble_hs_lock(void)
 {
+    os_time_t start;
+    int contended;
     int rc;
 
     BLE_HS_DBG_ASSERT(!ble_hs_locked_by_cur_task());
@@ -159,8 +168,21 @@ ble_hs_lock(void)
     }
 #endif
 
+    /* Only time the wait if another task holds the lock; the uncontended
+     * path stays as cheap as before.
+     */
+    contended = ble_hs_mutex.mu_owner != NULL;
+    if (contended) {
+        start = os_time_get();
+    }
+
     rc = os_mutex_pend(&ble_hs_mutex, 0xffffffff);
     BLE_HS_DBG_ASSERT_EVAL(rc == 0 || rc == OS_NOT_STARTED);
+
+    if (contended) {
+        STATS_INC(ble_hs_stats, lock_contended);
+        STATS_INCN(ble_hs_stats, lock_wait_ticks, os_time_get() - start);
+    }
 }
 
 void
@@ -223,11 +245,33 @@ ble_hs_synced(void)
     return ble_hs_sync_state == BLE_HS_SYNC_STATE_GOOD;
 }
 
+/**
+ * Retrieves the number of ACL data packets the controller can accept right
+ * now.  The host hands every packet to the controller immediately, so an
+ * application that streams data can check this before sending to avoid
+ * piling packets up in the controller's queue.
+ *
+ * @return                      The number of free controller ACL buffers.
+ */
+int
+ble_hs_tx_avail_pkts(void)
+{
+    return ble_hs_hci_avail_pkts();
+}
+
 static int
 ble_hs_sync(void)
 {
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+    static uint8_t profiled;
+    uint32_t mark;
+#endif
     int rc;
 
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+    mark = SYSINIT_PROFILE_MARK();
+#endif
+
     /* Set the sync state to "bringup."  This allows the parent task to send
      * the startup sequence to the controller.  No other tasks are allowed to
      * send any commands.
@@ -237,9 +281,17 @@ ble_hs_sync(void)
     rc = ble_hs_startup_go();
     if (rc == 0) {
         ble_hs_sync_state = BLE_HS_SYNC_STATE_GOOD;
+        ble_sm_sc_sync();
         if (ble_hs_cfg.sync_cb != NULL) {
             ble_hs_cfg.sync_cb();
         }
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+        /* Only the first sync is part of the boot-time report. */
+        if (!profiled) {
+            SYSINIT_PROFILE_RECORD("ble_hs_sync", mark);
+            profiled = 1;
+        }
+#endif
     } else {
         ble_hs_sync_state = BLE_HS_SYNC_STATE_BAD;
     }
@@ -268,6 +320,8 @@ ble_hs_reset(void)
         return rc;
     }
 
+    ble_hs_hci_cmd_q_reset();
+
     ble_hs_clear_data_queue(&ble_hs_tx_q);
     ble_hs_clear_data_queue(&ble_hs_rx_q);
 
@@ -404,10 +458,29 @@ ble_hs_enqueue_hci_event(uint8_t *hci_evt)
         ev->ev_queued = 0;
         ev->ev_cb = ble_hs_event_rx_hci_ev,
         ev->ev_arg = hci_evt;
+
+        /* Don't let a burst of advertising reports delay link events. */
+        if (hci_evt[0] == BLE_HCI_EVCODE_LE_META &&
+            (hci_evt[2] == BLE_HCI_LE_SUBEV_ADV_RPT ||
+             hci_evt[2] == BLE_HCI_LE_SUBEV_DIRECT_ADV_RPT)) {
+
+            OS_EVENT_PRIO_SET(ev, OS_EVENT_PRIO_LOWEST);
+        } else {
+            OS_EVENT_PRIO_SET(ev, OS_EVENT_PRIO_HIGHEST);
+        }
         os_eventq_put(ble_hs_evq_get(), ev);
     }
 }
 
+/**
+ * Queues an event for processing in the host parent task.
+ */
+void
+ble_hs_enqueue_event(struct os_event *ev)
+{
+    os_eventq_put(ble_hs_evq_get(), ev);
+}
+
 /**
  * Schedules for all pending notifications and indications to be sent in the
  * host parent task.
@@ -537,8 +610,11 @@ ble_hs_tx_data(struct os_mbuf *om)
 void
 ble_hs_init(void)
 {
+    uint32_t mark;
     int rc;
 
+    mark = SYSINIT_PROFILE_MARK();
+
     log_init();
 
     /* Create memory pool of OS events */
@@ -594,10 +670,24 @@ ble_hs_init(void)
     rc = os_mutex_init(&ble_hs_mutex);
     SYSINIT_PANIC_ASSERT(rc == 0);
 
+    rc = ble_store_init();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+#if MYNEWT_VAL(BLE_HS_CONN_PERF_NEWTMGR)
+    rc = ble_hs_nmgr_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+
 #if MYNEWT_VAL(BLE_HS_DEBUG)
     ble_hs_dbg_mutex_locked = 0;
 #endif
 
     /* Configure the HCI transport to communicate with a host. */
     ble_hci_trans_cfg_hs(ble_hs_hci_rx_evt, NULL, ble_hs_rx_data, NULL);
+#if MYNEWT_VAL(BLE_HCI_RAM_DIRECT)
+    ble_hci_ram_cfg_hs_num_comp_pkts(ble_hs_hci_evt_num_comp_pkts_direct,
+                                     NULL);
+#endif
+
+    SYSINIT_PROFILE_RECORD("ble_hs", mark);
 }
@@ -107,6 +107,82 @@ ble_hs_adv_set_array32(uint8_t type, uint8_t num_elems, const uint32_t *elems,
     return 0;
 }
 
+/**
+ * Replaces, adds or removes a single AD structure in already encoded
+ * advertising data. A field whose length does not change is overwritten in
+ * place; otherwise the fields following it are moved.
+ *
+ * @param type                  The AD type of the field to update.
+ * @param data_len              The length of the new field contents; 0 to
+ *                                  remove the field.
+ * @param data                  The new field contents.
+ * @param dst                   The encoded advertising data.
+ * @param dst_len               On input, the length of the encoded data; on
+ *                                  success, its new length.
+ * @param max_len               The size limit of the encoded data.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EMSGSIZE if the result does not fit;
+ *                              BLE_HS_EBADDATA if the encoded data is
+ *                                  malformed.
+ */
+int
+ble_hs_adv_update_field(uint8_t type, uint8_t data_len, const void *data,
+                        uint8_t *dst, uint8_t *dst_len, uint8_t max_len)
+{
+#if !NIMBLE_BLE_ADVERTISE
+    return BLE_HS_ENOTSUP;
+#endif
+
+    uint8_t field_len;
+    int new_len;
+    int off;
+    int old_sz;
+    int new_sz;
+
+    /* Find the field. */
+    off = 0;
+    while (off < *dst_len) {
+        field_len = dst[off];
+        if (field_len == 0 || off + 1 + field_len > *dst_len) {
+            return BLE_HS_EBADDATA;
+        }
+        if (dst[off + 1] == type) {
+            break;
+        }
+        off += 1 + field_len;
+    }
+
+    if (off >= *dst_len) {
+        /* Not present; append it. */
+        if (data_len == 0) {
+            return 0;
+        }
+        return ble_hs_adv_set_flat(type, data_len, data, dst, dst_len,
+                                   max_len);
+    }
+
+    old_sz = 1 + dst[off];
+    new_sz = data_len == 0 ? 0 : 2 + data_len;
+    new_len = *dst_len - old_sz + new_sz;
+    if (new_len > max_len) {
+        return BLE_HS_EMSGSIZE;
+    }
+
+    if (new_sz != old_sz) {
+        memmove(dst + off + new_sz, dst + off + old_sz,
+                *dst_len - off - old_sz);
+    }
+    if (new_sz != 0) {
+        dst[off] = data_len + 1;
+        dst[off + 1] = type;
+        memcpy(dst + off + 2, data, data_len);
+    }
+    *dst_len = new_len;
+
+    return 0;
+}
+
 /**
  * Sets the significant part of the data in outgoing advertisements.
  *
@@ -621,3 +697,130 @@ ble_hs_adv_parse_fields(struct ble_hs_adv_fields *adv_fields, uint8_t *src,
 
     return 0;
 }
+
+/**
+ * Reads the AD structure at the specified offset within raw advertising data
+ * and advances the offset past it.  Use this to walk advertising data in
+ * place, without decoding it into a ble_hs_adv_fields struct.  A zero length
+ * byte marks the end of the significant part of the data.
+ *
+ * @param src                   The raw advertising data.
+ * @param src_len               The length of the advertising data.
+ * @param off                   On input, the offset of the AD structure to
+ *                                  read (0 for the first one); on success,
+ *                                  the offset of the following one.
+ * @param field                 On success, the AD structure gets written
+ *                                  here.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOENT if there are no more AD
+ *                                  structures;
+ *                              BLE_HS_EBADDATA if the data is malformed.
+ */
+int
+ble_hs_adv_iter_next(const uint8_t *src, uint8_t src_len, uint8_t *off,
+                     struct ble_hs_adv_field *field)
+{
+    uint8_t len;
+
+    if (*off >= src_len) {
+        return BLE_HS_ENOENT;
+    }
+
+    len = src[*off];
+    if (len == 0) {
+        return BLE_HS_ENOENT;
+    }
+    if (*off + 1 + len > src_len) {
+        return BLE_HS_EBADDATA;
+    }
+
+    field->type = src[*off + 1];
+    field->data = src + *off + 2;
+    field->data_len = len - 1;
+
+    *off += 1 + len;
+
+    return 0;
+}
+
+/**
+ * Finds the first AD structure of the specified type within raw advertising
+ * data.  AD structures following the match are not examined.
+ *
+ * @param type                  The AD type to search for
+ *                                  (BLE_HS_ADV_TYPE_[...]).
+ * @param src                   The raw advertising data.
+ * @param src_len               The length of the advertising data.
+ * @param field                 On success, the matching AD structure gets
+ *                                  written here.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOENT if no AD structure of the type
+ *                                  is present;
+ *                              BLE_HS_EBADDATA if the data is malformed.
+ */
+int
+ble_hs_adv_find_field(uint8_t type, const uint8_t *src, uint8_t src_len,
+                      struct ble_hs_adv_field *field)
+{
+    uint8_t off;
+    int rc;
+
+    off = 0;
+    while (1) {
+        rc = ble_hs_adv_iter_next(src, src_len, &off, field);
+        if (rc != 0) {
+            return rc;
+        }
+
+        if (field->type == type) {
+            return 0;
+        }
+    }
+}
+
+/**
+ * Indicates whether raw advertising data lists the specified 16-bit service
+ * UUID, in either a complete or an incomplete list.
+ *
+ * @param uuid16                The service UUID to search for.
+ * @param src                   The raw advertising data.
+ * @param src_len               The length of the advertising data.
+ *
+ * @return                      0 if the UUID is listed;
+ *                              BLE_HS_ENOENT if it is not;
+ *                              BLE_HS_EBADDATA if the data is malformed.
+ */
+int
+ble_hs_adv_find_uuid16(uint16_t uuid16, const uint8_t *src, uint8_t src_len)
+{
+    struct ble_hs_adv_field field;
+    uint8_t off;
+    int rc;
+    int i;
+
+    off = 0;
+    while (1) {
+        rc = ble_hs_adv_iter_next(src, src_len, &off, &field);
+        if (rc != 0) {
+            return rc;
+        }
+
+        if (field.type != BLE_HS_ADV_TYPE_INCOMP_UUIDS16 &&
+            field.type != BLE_HS_ADV_TYPE_COMP_UUIDS16) {
+
+            continue;
+        }
+
+        if (field.data_len % 2 != 0) {
+            return BLE_HS_EBADDATA;
+        }
+
+        for (i = 0; i < field.data_len; i += 2) {
+            if (le16toh(field.data + i) == uuid16) {
+                return 0;
+            }
+        }
+    }
+}
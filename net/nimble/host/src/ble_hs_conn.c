@@ -27,9 +27,33 @@
 /** At least three channels required per connection (sig, att, sm). */
 #define BLE_HS_CONN_MIN_CHANS       3
 
+/**
+ * Size of the connection handle lookup table; the smallest power of two
+ * greater than the maximum number of connections.  Controllers generally
+ * allocate handles sequentially starting from 0 or 1, so in practice each
+ * connection gets its own slot.
+ */
+#define BLE_HS_CONN_MAP_SZ                                                  \
+    (MYNEWT_VAL(BLE_MAX_CONNECTIONS) < 2  ? 2  :                            \
+     MYNEWT_VAL(BLE_MAX_CONNECTIONS) < 4  ? 4  :                            \
+     MYNEWT_VAL(BLE_MAX_CONNECTIONS) < 8  ? 8  :                            \
+     MYNEWT_VAL(BLE_MAX_CONNECTIONS) < 16 ? 16 :                            \
+     MYNEWT_VAL(BLE_MAX_CONNECTIONS) < 32 ? 32 : 64)
+
+#define BLE_HS_CONN_MAP_IDX(handle) ((handle) & (BLE_HS_CONN_MAP_SZ - 1))
+
 static SLIST_HEAD(, ble_hs_conn) ble_hs_conns;
 static struct os_mempool ble_hs_conn_pool;
 
+/**
+ * Direct-mapped connection handle lookup table.  A connection whose slot is
+ * already occupied when it is inserted is only reachable via the list;
+ * ble_hs_conn_map_spill counts such connections so that the list only gets
+ * searched when one might exist.  Protected by the host lock.
+ */
+static struct ble_hs_conn *ble_hs_conn_map[BLE_HS_CONN_MAP_SZ];
+static uint8_t ble_hs_conn_map_spill;
+
 static os_membuf_t ble_hs_conn_elem_mem[
     OS_MEMPOOL_SIZE(MYNEWT_VAL(BLE_MAX_CONNECTIONS),
                     sizeof (struct ble_hs_conn))
@@ -119,6 +143,10 @@ ble_hs_conn_alloc(void)
     memset(conn, 0, sizeof *conn);
 
     SLIST_INIT(&conn->bhc_channels);
+    conn->bhc_tput_start = os_time_get();
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+    STAILQ_INIT(&conn->bhc_att_svr.basc_notify_q);
+#endif
 
     chan = ble_att_create_chan();
     if (chan == NULL) {
@@ -166,7 +194,7 @@ err:
     return NULL;
 }
 
-static void
+void
 ble_hs_conn_delete_chan(struct ble_hs_conn *conn, struct ble_l2cap_chan *chan)
 {
     if (conn->bhc_rx_chan == chan) {
@@ -192,6 +220,14 @@ ble_hs_conn_free(struct ble_hs_conn *conn)
     }
 
     ble_att_svr_prep_clear(&conn->bhc_att_svr.basc_prep_list);
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+    ble_att_notify_q_clear(conn);
+#endif
+
+    /* The controller discards a connection's unacked packets when the
+     * connection terminates; their buffers are free again.
+     */
+    ble_hs_hci_add_avail_pkts(conn->bhc_outstanding_pkts);
 
     while ((chan = SLIST_FIRST(&conn->bhc_channels)) != NULL) {
         ble_hs_conn_delete_chan(conn, chan);
@@ -206,6 +242,8 @@ ble_hs_conn_free(struct ble_hs_conn *conn)
 void
 ble_hs_conn_insert(struct ble_hs_conn *conn)
 {
+    struct ble_hs_conn **slot;
+
 #if !NIMBLE_BLE_CONNECT
     return;
 #endif
@@ -214,11 +252,21 @@ ble_hs_conn_insert(struct ble_hs_conn *conn)
 
     BLE_HS_DBG_ASSERT_EVAL(ble_hs_conn_find(conn->bhc_handle) == NULL);
     SLIST_INSERT_HEAD(&ble_hs_conns, conn, bhc_next);
+
+    slot = ble_hs_conn_map + BLE_HS_CONN_MAP_IDX(conn->bhc_handle);
+    if (*slot == NULL) {
+        *slot = conn;
+    } else {
+        ble_hs_conn_map_spill++;
+    }
 }
 
 void
 ble_hs_conn_remove(struct ble_hs_conn *conn)
 {
+    struct ble_hs_conn **slot;
+    struct ble_hs_conn *cur;
+
 #if !NIMBLE_BLE_CONNECT
     return;
 #endif
@@ -226,6 +274,28 @@ ble_hs_conn_remove(struct ble_hs_conn *conn)
     BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
 
     SLIST_REMOVE(&ble_hs_conns, conn, ble_hs_conn, bhc_next);
+
+    slot = ble_hs_conn_map + BLE_HS_CONN_MAP_IDX(conn->bhc_handle);
+    if (*slot != conn) {
+        BLE_HS_DBG_ASSERT(ble_hs_conn_map_spill > 0);
+        ble_hs_conn_map_spill--;
+        return;
+    }
+
+    *slot = NULL;
+
+    /* Promote a connection that was spilled from this slot, if any. */
+    if (ble_hs_conn_map_spill > 0) {
+        SLIST_FOREACH(cur, &ble_hs_conns, bhc_next) {
+            if (BLE_HS_CONN_MAP_IDX(cur->bhc_handle) ==
+                BLE_HS_CONN_MAP_IDX(conn->bhc_handle)) {
+
+                *slot = cur;
+                ble_hs_conn_map_spill--;
+                break;
+            }
+        }
+    }
 }
 
 struct ble_hs_conn *
@@ -239,6 +309,15 @@ ble_hs_conn_find(uint16_t conn_handle)
 
     BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
 
+    conn = ble_hs_conn_map[BLE_HS_CONN_MAP_IDX(conn_handle)];
+    if (conn != NULL && conn->bhc_handle == conn_handle) {
+        return conn;
+    }
+
+    if (ble_hs_conn_map_spill == 0) {
+        return NULL;
+    }
+
     SLIST_FOREACH(conn, &ble_hs_conns, bhc_next) {
         if (conn->bhc_handle == conn_handle) {
             return conn;
@@ -270,9 +349,13 @@ ble_hs_conn_find_by_addr(uint8_t addr_type, uint8_t *addr)
 
     BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
 
+    /* Reject on the first address byte before calling memcmp(); the low
+     * bytes are the least likely to be shared between peers.
+     */
     SLIST_FOREACH(conn, &ble_hs_conns, bhc_next) {
-        if (conn->bhc_peer_addr_type == addr_type &&
-            memcmp(conn->bhc_peer_addr, addr, 6) == 0) {
+        if (conn->bhc_peer_addr[0] == addr[0] &&
+            conn->bhc_peer_addr_type == addr_type &&
+            memcmp(conn->bhc_peer_addr + 1, addr + 1, 5) == 0) {
 
             return conn;
         }
@@ -378,6 +461,75 @@ ble_hs_conn_addrs(const struct ble_hs_conn *conn,
     }
 }
 
+#if MYNEWT_VAL(BLE_HS_CONN_PERF)
+/**
+ * Accounts for an ACL fragment handed to the controller.  Must be called
+ * with the host lock held, before the fragment is added to
+ * bhc_outstanding_pkts.
+ *
+ * @param conn                  The connection the fragment was sent on.
+ * @param no_credit             Whether the controller had no free buffer
+ *                                  for the fragment.
+ */
+void
+ble_hs_conn_perf_tx(struct ble_hs_conn *conn, int no_credit)
+{
+    struct ble_hs_conn_perf *perf;
+    int idx;
+
+    perf = &conn->bhc_perf;
+
+    perf->tx_frags++;
+    if (no_credit) {
+        perf->tx_no_credit++;
+    }
+    if (conn->bhc_outstanding_pkts >= perf->max_outstanding) {
+        perf->max_outstanding = conn->bhc_outstanding_pkts + 1;
+    }
+
+    /* The controller completes fragments in order.  Only time this one if
+     * all older outstanding fragments are timed too; otherwise completions
+     * would be matched against the wrong timestamps.
+     */
+    if (perf->ts_cnt == conn->bhc_outstanding_pkts &&
+        perf->ts_cnt < BLE_HS_CONN_PERF_TS_CNT) {
+
+        idx = (perf->ts_head + perf->ts_cnt) % BLE_HS_CONN_PERF_TS_CNT;
+        perf->ts[idx] = os_time_get();
+        perf->ts_cnt++;
+    }
+}
+
+/**
+ * Accounts for ACL fragments the controller reports completed.  Must be
+ * called with the host lock held, before the fragments are removed from
+ * bhc_outstanding_pkts.
+ */
+void
+ble_hs_conn_perf_comp(struct ble_hs_conn *conn, uint16_t num_pkts)
+{
+    struct ble_hs_conn_perf *perf;
+    os_time_t lat;
+    os_time_t now;
+
+    perf = &conn->bhc_perf;
+    now = os_time_get();
+
+    while (num_pkts > 0 && perf->ts_cnt > 0) {
+        lat = now - perf->ts[perf->ts_head];
+        perf->comp_pkts++;
+        perf->comp_lat_sum += lat;
+        if (lat > perf->comp_lat_max) {
+            perf->comp_lat_max = lat;
+        }
+
+        perf->ts_head = (perf->ts_head + 1) % BLE_HS_CONN_PERF_TS_CNT;
+        perf->ts_cnt--;
+        num_pkts--;
+    }
+}
+#endif
+
 int 
 ble_hs_conn_init(void)
 {
@@ -391,6 +543,8 @@ ble_hs_conn_init(void)
     }
 
     SLIST_INIT(&ble_hs_conns);
+    memset(ble_hs_conn_map, 0, sizeof ble_hs_conn_map);
+    ble_hs_conn_map_spill = 0;
 
     return 0;
 }
@@ -24,6 +24,7 @@
 #include "ble_l2cap_priv.h"
 #include "ble_gatt_priv.h"
 #include "ble_att_priv.h"
+#include "ble_gap_priv.h"
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -36,6 +37,29 @@ typedef uint8_t ble_hs_conn_flags_t;
 
 #define BLE_HS_CONN_F_MASTER        0x01
 
+#if MYNEWT_VAL(BLE_HS_CONN_PERF)
+#define BLE_HS_CONN_PERF_TS_CNT     8
+
+/**
+ * Host side link statistics of a connection.  Completion latency is the
+ * time from handing an ACL fragment to the controller until the controller
+ * reports it completed.  Only the oldest BLE_HS_CONN_PERF_TS_CNT
+ * outstanding fragments are timed.
+ */
+struct ble_hs_conn_perf {
+    uint32_t tx_frags;
+    uint32_t tx_no_credit;      /* Fragments sent with no controller buffer. */
+    uint32_t comp_pkts;         /* Timed fragments completed. */
+    uint32_t comp_lat_sum;      /* OS ticks. */
+    uint32_t comp_lat_max;      /* OS ticks. */
+    uint16_t max_outstanding;
+
+    os_time_t ts[BLE_HS_CONN_PERF_TS_CNT];
+    uint8_t ts_head;            /* Oldest timed fragment. */
+    uint8_t ts_cnt;
+};
+#endif
+
 struct ble_hs_conn {
     SLIST_ENTRY(ble_hs_conn) bhc_next;
     uint16_t bhc_handle;
@@ -56,11 +80,24 @@ struct ble_hs_conn {
     struct ble_l2cap_chan *bhc_rx_chan; /* Channel rxing current packet. */
     uint16_t bhc_outstanding_pkts;
 
+    /* L2CAP payload bytes transferred since bhc_tput_start. */
+    uint32_t bhc_tx_bytes;
+    uint32_t bhc_rx_bytes;
+    os_time_t bhc_tput_start;
+
+#if MYNEWT_VAL(BLE_HS_CONN_PERF)
+    struct ble_hs_conn_perf bhc_perf;
+#endif
+
     struct ble_att_svr_conn bhc_att_svr;
     struct ble_gatts_conn bhc_gatt_svr;
 
     struct ble_gap_sec_state bhc_sec_state;
 
+#if MYNEWT_VAL(BLE_GAP_CPM)
+    struct ble_gap_cpm_conn bhc_cpm;
+#endif
+
     ble_gap_event_fn *bhc_cb;
     void *bhc_cb_arg;
 };
@@ -91,8 +128,14 @@ struct ble_l2cap_chan *ble_hs_conn_chan_find(struct ble_hs_conn *conn,
                                              uint16_t cid);
 int ble_hs_conn_chan_insert(struct ble_hs_conn *conn,
                             struct ble_l2cap_chan *chan);
+void ble_hs_conn_delete_chan(struct ble_hs_conn *conn,
+                             struct ble_l2cap_chan *chan);
 void ble_hs_conn_addrs(const struct ble_hs_conn *conn,
                        struct ble_hs_conn_addrs *addrs);
+#if MYNEWT_VAL(BLE_HS_CONN_PERF)
+void ble_hs_conn_perf_tx(struct ble_hs_conn *conn, int no_credit);
+void ble_hs_conn_perf_comp(struct ble_hs_conn *conn, uint16_t num_pkts);
+#endif
 
 int ble_hs_conn_init(void);
 
@@ -34,6 +34,58 @@ static uint8_t *ble_hs_hci_ack;
 static uint16_t ble_hs_hci_buf_sz;
 static uint8_t ble_hs_hci_max_pkts;
 
+/** The number of controller ACL buffers not holding an unacked fragment. */
+static uint8_t ble_hs_hci_avail_pkts_cnt;
+
+/**
+ * Queued HCI commands.  A command waits on the pending list until the
+ * controller has room for it (Num_HCI_Command_Packets), on the in-flight
+ * list until it is acknowledged, and on the done list until its callback
+ * gets called.  Acknowledgements are taken off in the context they arrive
+ * in, so the controller's command buffer is freed right away.  While a
+ * blocking command is in progress, nothing more gets sent from the queue.
+ */
+struct ble_hs_hci_cmd_q_entry {
+    STAILQ_ENTRY(ble_hs_hci_cmd_q_entry) bhcq_next;
+    ble_hs_hci_cmd_cb *bhcq_cb;
+    void *bhcq_arg;
+    int bhcq_status;
+    uint16_t bhcq_opcode;
+    uint8_t bhcq_params_len;
+
+    /* Command; return parameters once done. */
+    uint8_t bhcq_buf[BLE_HCI_CMD_HDR_LEN +
+                     MYNEWT_VAL(BLE_HS_HCI_CMD_Q_PARAM_LEN)];
+};
+
+STAILQ_HEAD(ble_hs_hci_cmd_q, ble_hs_hci_cmd_q_entry);
+
+static os_membuf_t ble_hs_hci_cmd_q_mem[
+    OS_MEMPOOL_SIZE(MYNEWT_VAL(BLE_HS_HCI_CMD_Q_LEN),
+                    sizeof (struct ble_hs_hci_cmd_q_entry))
+];
+static struct os_mempool ble_hs_hci_cmd_q_pool;
+
+static struct ble_hs_hci_cmd_q ble_hs_hci_cmd_q_pending;
+static struct ble_hs_hci_cmd_q ble_hs_hci_cmd_q_inflight;
+static struct ble_hs_hci_cmd_q ble_hs_hci_cmd_q_done;
+
+static struct os_sem ble_hs_hci_cmd_q_sem;
+static uint8_t ble_hs_hci_cmd_q_waiting;
+static uint8_t ble_hs_hci_cmd_q_blocked;
+
+/** Commands the controller can accept, as of its last acknowledgement. */
+static uint8_t ble_hs_hci_cmd_credits;
+
+/** First error from queued commands without a callback. */
+static int ble_hs_hci_cmd_q_err;
+
+static void ble_hs_hci_cmd_q_event(struct os_event *ev);
+
+static struct os_event ble_hs_hci_cmd_q_ev = {
+    .ev_cb = ble_hs_hci_cmd_q_event,
+};
+
 #if MYNEWT_VAL(BLE_HS_PHONY_HCI_ACKS)
 static ble_hs_hci_phony_ack_fn *ble_hs_hci_phony_ack_cb;
 #endif
@@ -73,10 +125,49 @@ ble_hs_hci_set_buf_sz(uint16_t pktlen, uint8_t max_pkts)
 
     ble_hs_hci_buf_sz = pktlen;
     ble_hs_hci_max_pkts = max_pkts;
+    ble_hs_hci_avail_pkts_cnt = max_pkts;
 
     return 0;
 }
 
+/**
+ * Retrieves the number of ACL data packets the controller can currently
+ * accept, as tracked from sent fragments and Number Of Completed Packets
+ * events.
+ */
+int
+ble_hs_hci_avail_pkts(void)
+{
+    return ble_hs_hci_avail_pkts_cnt;
+}
+
+/**
+ * Retrieves the total number of ACL data packets the controller can buffer.
+ */
+int
+ble_hs_hci_total_pkts(void)
+{
+    return ble_hs_hci_max_pkts;
+}
+
+/**
+ * Returns controller ACL buffers to the free count, either because the
+ * controller reported them completed or because their connection went away.
+ */
+void
+ble_hs_hci_add_avail_pkts(uint16_t delta)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    if (delta > ble_hs_hci_max_pkts - ble_hs_hci_avail_pkts_cnt) {
+        ble_hs_hci_avail_pkts_cnt = ble_hs_hci_max_pkts;
+    } else {
+        ble_hs_hci_avail_pkts_cnt += delta;
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+
 static int
 ble_hs_hci_rx_cmd_complete(uint8_t event_code, uint8_t *data, int len,
                            struct ble_hs_hci_ack *out_ack)
@@ -148,7 +239,7 @@ ble_hs_hci_rx_cmd_status(uint8_t event_code, uint8_t *data, int len,
 }
 
 static int
-ble_hs_hci_process_ack(uint16_t expected_opcode,
+ble_hs_hci_process_ack(uint8_t *ack_ev, uint16_t expected_opcode,
                        uint8_t *params_buf, uint8_t params_buf_len,
                        struct ble_hs_hci_ack *out_ack)
 {
@@ -157,16 +248,16 @@ ble_hs_hci_process_ack(uint16_t expected_opcode,
     uint8_t event_len;
     int rc;
 
-    BLE_HS_DBG_ASSERT(ble_hs_hci_ack != NULL);
+    BLE_HS_DBG_ASSERT(ack_ev != NULL);
 
     /* Count events received */
     STATS_INC(ble_hs_stats, hci_event);
 
     /* Display to console */
-    ble_hs_dbg_event_disp(ble_hs_hci_ack);
+    ble_hs_dbg_event_disp(ack_ev);
 
-    event_code = ble_hs_hci_ack[0];
-    param_len = ble_hs_hci_ack[1];
+    event_code = ack_ev[0];
+    param_len = ack_ev[1];
     event_len = param_len + 2;
 
     /* Clear ack fields up front to silence spurious gcc warnings. */
@@ -174,12 +265,12 @@ ble_hs_hci_process_ack(uint16_t expected_opcode,
 
     switch (event_code) {
     case BLE_HCI_EVCODE_COMMAND_COMPLETE:
-        rc = ble_hs_hci_rx_cmd_complete(event_code, ble_hs_hci_ack,
+        rc = ble_hs_hci_rx_cmd_complete(event_code, ack_ev,
                                          event_len, out_ack);
         break;
 
     case BLE_HCI_EVCODE_COMMAND_STATUS:
-        rc = ble_hs_hci_rx_cmd_status(event_code, ble_hs_hci_ack,
+        rc = ble_hs_hci_rx_cmd_status(event_code, ack_ev,
                                        event_len, out_ack);
         break;
 
@@ -246,6 +337,332 @@ ble_hs_hci_wait_for_ack(void)
     return rc;
 }
 
+static void
+ble_hs_hci_cmd_q_complete(struct ble_hs_hci_cmd_q_entry *entry, int status,
+                          uint8_t params_len)
+{
+    int wake;
+    os_sr_t sr;
+
+    entry->bhcq_status = status;
+    entry->bhcq_params_len = params_len;
+
+    OS_ENTER_CRITICAL(sr);
+    STAILQ_INSERT_TAIL(&ble_hs_hci_cmd_q_done, entry, bhcq_next);
+    wake = ble_hs_hci_cmd_q_waiting;
+    ble_hs_hci_cmd_q_waiting = 0;
+    OS_EXIT_CRITICAL(sr);
+
+    if (wake) {
+        os_sem_release(&ble_hs_hci_cmd_q_sem);
+    }
+    ble_hs_enqueue_event(&ble_hs_hci_cmd_q_ev);
+}
+
+/**
+ * Takes an acknowledgement for a queued command.  Runs in the context the
+ * event was received in.
+ *
+ * @return                      0 if the ack belonged to a queued command,
+ *                                  and has been freed;
+ *                              BLE_HS_ENOENT otherwise.
+ */
+static int
+ble_hs_hci_cmd_q_rx_ack(uint8_t *ack_ev)
+{
+    struct ble_hs_hci_cmd_q_entry *entry;
+    struct ble_hs_hci_ack ack;
+    uint16_t opcode;
+    os_sr_t sr;
+    int rc;
+
+    if (ack_ev[0] == BLE_HCI_EVCODE_COMMAND_COMPLETE) {
+        opcode = le16toh(ack_ev + 3);
+    } else {
+        opcode = le16toh(ack_ev + 4);
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    STAILQ_FOREACH(entry, &ble_hs_hci_cmd_q_inflight, bhcq_next) {
+        if (entry->bhcq_opcode == opcode) {
+            STAILQ_REMOVE(&ble_hs_hci_cmd_q_inflight, entry,
+                          ble_hs_hci_cmd_q_entry, bhcq_next);
+            break;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (entry == NULL) {
+        return BLE_HS_ENOENT;
+    }
+
+    rc = ble_hs_hci_process_ack(ack_ev, opcode, entry->bhcq_buf,
+                                MYNEWT_VAL(BLE_HS_HCI_CMD_Q_PARAM_LEN), &ack);
+    ble_hci_trans_buf_free(ack_ev);
+
+    if (rc == 0) {
+        rc = ack.bha_status;
+    }
+    ble_hs_hci_cmd_q_complete(entry, rc, ack.bha_params_len);
+
+    return 0;
+}
+
+#if MYNEWT_VAL(BLE_HS_PHONY_HCI_ACKS)
+static int
+ble_hs_hci_cmd_q_phony_ack(void)
+{
+    uint8_t *ack_ev;
+    int rc;
+
+    if (ble_hs_hci_phony_ack_cb == NULL) {
+        return BLE_HS_ETIMEOUT_HCI;
+    }
+
+    ack_ev = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_CMD);
+    BLE_HS_DBG_ASSERT(ack_ev != NULL);
+    rc = ble_hs_hci_phony_ack_cb(ack_ev, 260);
+    if (rc == 0) {
+        ble_hs_hci_cmd_credits++;
+        rc = ble_hs_hci_cmd_q_rx_ack(ack_ev);
+    }
+    if (rc != 0) {
+        ble_hci_trans_buf_free(ack_ev);
+        rc = BLE_HS_ECONTROLLER;
+    }
+
+    return rc;
+}
+#endif
+
+/**
+ * Sends queued commands for as long as the controller has room for them.
+ */
+static void
+ble_hs_hci_cmd_q_kick(void)
+{
+    struct ble_hs_hci_cmd_q_entry *entry;
+    os_sr_t sr;
+    int rc;
+
+    while (1) {
+        OS_ENTER_CRITICAL(sr);
+        entry = STAILQ_FIRST(&ble_hs_hci_cmd_q_pending);
+        if (entry == NULL || ble_hs_hci_cmd_credits == 0 ||
+            ble_hs_hci_cmd_q_blocked) {
+
+            OS_EXIT_CRITICAL(sr);
+            break;
+        }
+        STAILQ_REMOVE_HEAD(&ble_hs_hci_cmd_q_pending, bhcq_next);
+        STAILQ_INSERT_TAIL(&ble_hs_hci_cmd_q_inflight, entry, bhcq_next);
+        ble_hs_hci_cmd_credits--;
+        OS_EXIT_CRITICAL(sr);
+
+        rc = ble_hs_hci_cmd_send_buf(entry->bhcq_buf);
+#if MYNEWT_VAL(BLE_HS_PHONY_HCI_ACKS)
+        if (rc == 0) {
+            rc = ble_hs_hci_cmd_q_phony_ack();
+        }
+#endif
+        if (rc != 0) {
+            OS_ENTER_CRITICAL(sr);
+            STAILQ_REMOVE(&ble_hs_hci_cmd_q_inflight, entry,
+                          ble_hs_hci_cmd_q_entry, bhcq_next);
+            ble_hs_hci_cmd_credits++;
+            OS_EXIT_CRITICAL(sr);
+
+            ble_hs_hci_cmd_q_complete(entry, rc, 0);
+        }
+    }
+}
+
+/**
+ * Calls callbacks of completed commands, and sends more.
+ */
+static void
+ble_hs_hci_cmd_q_process(void)
+{
+    struct ble_hs_hci_cmd_q_entry *entry;
+    os_sr_t sr;
+
+    while (1) {
+        OS_ENTER_CRITICAL(sr);
+        entry = STAILQ_FIRST(&ble_hs_hci_cmd_q_done);
+        if (entry != NULL) {
+            STAILQ_REMOVE_HEAD(&ble_hs_hci_cmd_q_done, bhcq_next);
+        }
+        OS_EXIT_CRITICAL(sr);
+
+        if (entry == NULL) {
+            break;
+        }
+
+        if (entry->bhcq_cb != NULL) {
+            entry->bhcq_cb(entry->bhcq_status, entry->bhcq_buf,
+                           entry->bhcq_params_len, entry->bhcq_arg);
+        } else if (entry->bhcq_status != 0 && ble_hs_hci_cmd_q_err == 0) {
+            ble_hs_hci_cmd_q_err = entry->bhcq_status;
+        }
+        os_memblock_put(&ble_hs_hci_cmd_q_pool, entry);
+    }
+
+    ble_hs_hci_cmd_q_kick();
+}
+
+static void
+ble_hs_hci_cmd_q_event(struct os_event *ev)
+{
+    ble_hs_hci_cmd_q_process();
+}
+
+/**
+ * Waits until no queued commands are in flight; if all is set, also until
+ * there are none pending.
+ */
+static int
+ble_hs_hci_cmd_q_wait(int all)
+{
+    os_sr_t sr;
+    int idle;
+    int rc;
+
+    while (1) {
+        if (all) {
+            ble_hs_hci_cmd_q_process();
+        }
+
+        OS_ENTER_CRITICAL(sr);
+        idle = STAILQ_EMPTY(&ble_hs_hci_cmd_q_inflight) &&
+               (!all || (STAILQ_EMPTY(&ble_hs_hci_cmd_q_pending) &&
+                         STAILQ_EMPTY(&ble_hs_hci_cmd_q_done)));
+        if (!idle) {
+            ble_hs_hci_cmd_q_waiting = 1;
+        }
+        OS_EXIT_CRITICAL(sr);
+
+        if (idle) {
+            return 0;
+        }
+
+        rc = os_sem_pend(&ble_hs_hci_cmd_q_sem, BLE_HCI_CMD_TIMEOUT);
+        switch (rc) {
+        case 0:
+            break;
+        case OS_TIMEOUT:
+            STATS_INC(ble_hs_stats, hci_timeout);
+            return BLE_HS_ETIMEOUT_HCI;
+        default:
+            return BLE_HS_EOS;
+        }
+    }
+}
+
+/**
+ * Queues an HCI command without waiting for it to complete.  Commands are
+ * sent in order, as soon as the controller has room for them.
+ *
+ * @param cmd                   The command, header included.  Gets copied.
+ * @param cb                    Called with the command's status and return
+ *                                  parameters.  If NULL, a failure is
+ *                                  reported by ble_hs_hci_cmd_drain()
+ *                                  instead.
+ * @param arg                   Passed to cb.
+ *
+ * @return                      0 if the command was queued;
+ *                              BLE_HS_EINVAL if the command has more than
+ *                                  BLE_HS_HCI_CMD_Q_PARAM_LEN bytes of
+ *                                  parameters;
+ *                              BLE_HS_ENOMEM if the queue is full.
+ */
+int
+ble_hs_hci_cmd_tx_async(void *cmd, ble_hs_hci_cmd_cb *cb, void *arg)
+{
+    struct ble_hs_hci_cmd_q_entry *entry;
+    uint8_t *u8ptr;
+    os_sr_t sr;
+
+    u8ptr = cmd;
+    if (u8ptr[2] > MYNEWT_VAL(BLE_HS_HCI_CMD_Q_PARAM_LEN)) {
+        return BLE_HS_EINVAL;
+    }
+
+    entry = os_memblock_get(&ble_hs_hci_cmd_q_pool);
+    if (entry == NULL) {
+        return BLE_HS_ENOMEM;
+    }
+
+    entry->bhcq_cb = cb;
+    entry->bhcq_arg = arg;
+    entry->bhcq_opcode = le16toh(u8ptr);
+    memcpy(entry->bhcq_buf, u8ptr, BLE_HCI_CMD_HDR_LEN + u8ptr[2]);
+
+    OS_ENTER_CRITICAL(sr);
+    STAILQ_INSERT_TAIL(&ble_hs_hci_cmd_q_pending, entry, bhcq_next);
+    OS_EXIT_CRITICAL(sr);
+
+    ble_hs_hci_cmd_q_kick();
+
+    return 0;
+}
+
+/**
+ * Waits for all queued commands to complete.  Callbacks of completed
+ * commands are called from the calling task.
+ *
+ * @return                      The first error of commands queued without
+ *                                  a callback since the last drain;
+ *                              BLE_HS_ETIMEOUT_HCI if the controller
+ *                                  stopped responding.
+ */
+int
+ble_hs_hci_cmd_drain(void)
+{
+    int rc;
+
+    rc = ble_hs_hci_cmd_q_wait(1);
+    if (rc != 0) {
+        ble_hs_sched_reset(rc);
+    } else {
+        rc = ble_hs_hci_cmd_q_err;
+    }
+    ble_hs_hci_cmd_q_err = 0;
+
+    return rc;
+}
+
+/**
+ * Fails all queued commands with BLE_HS_ENOTSYNCED; called when the host
+ * resets.
+ */
+void
+ble_hs_hci_cmd_q_reset(void)
+{
+    struct ble_hs_hci_cmd_q_entry *entry;
+    struct ble_hs_hci_cmd_q aborted;
+    os_sr_t sr;
+
+    STAILQ_INIT(&aborted);
+
+    OS_ENTER_CRITICAL(sr);
+    while ((entry = STAILQ_FIRST(&ble_hs_hci_cmd_q_inflight)) != NULL) {
+        STAILQ_REMOVE_HEAD(&ble_hs_hci_cmd_q_inflight, bhcq_next);
+        STAILQ_INSERT_TAIL(&aborted, entry, bhcq_next);
+    }
+    while ((entry = STAILQ_FIRST(&ble_hs_hci_cmd_q_pending)) != NULL) {
+        STAILQ_REMOVE_HEAD(&ble_hs_hci_cmd_q_pending, bhcq_next);
+        STAILQ_INSERT_TAIL(&aborted, entry, bhcq_next);
+    }
+    ble_hs_hci_cmd_credits = 1;
+    OS_EXIT_CRITICAL(sr);
+
+    while ((entry = STAILQ_FIRST(&aborted)) != NULL) {
+        STAILQ_REMOVE_HEAD(&aborted, bhcq_next);
+        ble_hs_hci_cmd_q_complete(entry, BLE_HS_ENOTSYNCED, 0);
+    }
+    ble_hs_hci_cmd_q_process();
+}
+
 int
 ble_hs_hci_cmd_tx(void *cmd, void *evt_buf, uint8_t evt_buf_len,
                   uint8_t *out_evt_buf_len)
@@ -259,6 +676,14 @@ ble_hs_hci_cmd_tx(void *cmd, void *evt_buf, uint8_t evt_buf_len,
     BLE_HS_DBG_ASSERT(ble_hs_hci_ack == NULL);
     ble_hs_hci_lock();
 
+    /* Let queued commands that are already in flight complete first. */
+    ble_hs_hci_cmd_q_blocked = 1;
+    rc = ble_hs_hci_cmd_q_wait(0);
+    if (rc != 0) {
+        ble_hs_sched_reset(rc);
+        goto done;
+    }
+
     rc = ble_hs_hci_cmd_send_buf(cmd);
     if (rc != 0) {
         goto done;
@@ -270,7 +695,8 @@ ble_hs_hci_cmd_tx(void *cmd, void *evt_buf, uint8_t evt_buf_len,
         goto done;
     }
 
-    rc = ble_hs_hci_process_ack(opcode, evt_buf, evt_buf_len, &ack);
+    rc = ble_hs_hci_process_ack(ble_hs_hci_ack, opcode, evt_buf, evt_buf_len,
+                                &ack);
     if (rc != 0) {
         ble_hs_sched_reset(rc);
         goto done;
@@ -288,7 +714,10 @@ done:
         ble_hs_hci_ack = NULL;
     }
 
+    ble_hs_hci_cmd_q_blocked = 0;
     ble_hs_hci_unlock();
+
+    ble_hs_hci_cmd_q_kick();
     return rc;
 }
 
@@ -332,8 +761,20 @@ ble_hs_hci_rx_evt(uint8_t *hci_ev, void *arg)
     switch (hci_ev[0]) {
     case BLE_HCI_EVCODE_COMMAND_COMPLETE:
     case BLE_HCI_EVCODE_COMMAND_STATUS:
+        /* Num_HCI_Command_Packets says how many queued commands can go. */
+        if (hci_ev[0] == BLE_HCI_EVCODE_COMMAND_COMPLETE) {
+            ble_hs_hci_cmd_credits = hci_ev[2];
+        } else {
+            ble_hs_hci_cmd_credits = hci_ev[3];
+        }
+
         if (hci_ev[3] == 0 && hci_ev[4] == 0) {
             enqueue = 1;
+            if (!STAILQ_EMPTY(&ble_hs_hci_cmd_q_pending)) {
+                ble_hs_enqueue_event(&ble_hs_hci_cmd_q_ev);
+            }
+        } else if (ble_hs_hci_cmd_q_rx_ack(hci_ev) == 0) {
+            enqueue = 0;
         } else {
             ble_hs_hci_rx_ack(hci_ev);
             enqueue = 0;
@@ -362,6 +803,23 @@ ble_hs_hci_max_acl_payload_sz(void)
     return ble_hs_hci_buf_sz - BLE_HCI_DATA_HDR_SZ;
 }
 
+/**
+ * Calculates the number of ACL fragments an L2CAP packet of the specified
+ * length gets split into.
+ */
+int
+ble_hs_hci_acl_frag_cnt(uint16_t pktlen)
+{
+    uint16_t max_payload;
+
+    max_payload = ble_hs_hci_max_acl_payload_sz();
+    if (max_payload == 0) {
+        return 1;
+    }
+
+    return (pktlen + max_payload - 1) / max_payload;
+}
+
 /**
  * Splits an appropriately-sized fragment from the front of an outgoing ACL
  * data packet, if necessary.  If the packet size is within the controller's
@@ -462,7 +920,9 @@ int
 ble_hs_hci_acl_tx(struct ble_hs_conn *connection, struct os_mbuf *txom)
 {
     struct os_mbuf *frag;
+    os_sr_t sr;
     uint8_t pb;
+    int no_credit;
     int rc;
 
     /* The first fragment uses the first-non-flush packet boundary value.
@@ -494,6 +954,16 @@ ble_hs_hci_acl_tx(struct ble_hs_conn *connection, struct os_mbuf *txom)
             goto err;
         }
 
+        OS_ENTER_CRITICAL(sr);
+        no_credit = ble_hs_hci_avail_pkts_cnt == 0;
+        if (!no_credit) {
+            ble_hs_hci_avail_pkts_cnt--;
+        }
+        OS_EXIT_CRITICAL(sr);
+
+#if MYNEWT_VAL(BLE_HS_CONN_PERF)
+        ble_hs_conn_perf_tx(connection, no_credit);
+#endif
         connection->bhc_outstanding_pkts++;
     }
 
@@ -516,4 +986,18 @@ ble_hs_hci_init(void)
 
     rc = os_mutex_init(&ble_hs_hci_mutex);
     BLE_HS_DBG_ASSERT_EVAL(rc == 0);
+
+    rc = os_sem_init(&ble_hs_hci_cmd_q_sem, 0);
+    BLE_HS_DBG_ASSERT_EVAL(rc == 0);
+
+    rc = os_mempool_init(&ble_hs_hci_cmd_q_pool,
+                         MYNEWT_VAL(BLE_HS_HCI_CMD_Q_LEN),
+                         sizeof (struct ble_hs_hci_cmd_q_entry),
+                         ble_hs_hci_cmd_q_mem, "ble_hs_hci_cmd_q_pool");
+    BLE_HS_DBG_ASSERT_EVAL(rc == 0);
+
+    STAILQ_INIT(&ble_hs_hci_cmd_q_pending);
+    STAILQ_INIT(&ble_hs_hci_cmd_q_inflight);
+    STAILQ_INIT(&ble_hs_hci_cmd_q_done);
+    ble_hs_hci_cmd_credits = 1;
 }
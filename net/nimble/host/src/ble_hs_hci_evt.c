@@ -197,6 +197,56 @@ ble_hs_hci_evt_enc_key_refresh(uint8_t event_code, uint8_t *data, int len)
     return 0;
 }
 
+static void
+ble_hs_hci_evt_conn_comp_pkts(uint16_t handle, uint16_t num_pkts)
+{
+    struct ble_hs_conn *conn;
+
+    ble_hs_lock();
+    conn = ble_hs_conn_find(handle);
+    if (conn != NULL) {
+        if (num_pkts > conn->bhc_outstanding_pkts) {
+            num_pkts = conn->bhc_outstanding_pkts;
+        }
+#if MYNEWT_VAL(BLE_HS_CONN_PERF)
+        ble_hs_conn_perf_comp(conn, num_pkts);
+#endif
+        conn->bhc_outstanding_pkts -= num_pkts;
+        ble_hs_hci_add_avail_pkts(num_pkts);
+    }
+    ble_hs_unlock();
+}
+
+#if MYNEWT_VAL(BLE_HCI_RAM_DIRECT)
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+static void
+ble_hs_hci_evt_notify_q_ev(struct os_event *ev)
+{
+    ble_att_notify_q_tx();
+}
+
+static struct os_event ble_hs_hci_evt_notify_q_event = {
+    .ev_cb = ble_hs_hci_evt_notify_q_ev,
+};
+#endif
+
+/**
+ * Receives completed packet counts directly from a controller in the same
+ * image (see BLE_HCI_RAM_DIRECT). Executed in the controller's task.
+ */
+void
+ble_hs_hci_evt_num_comp_pkts_direct(uint16_t conn_handle, uint16_t num_pkts,
+                                    void *arg)
+{
+    ble_hs_hci_evt_conn_comp_pkts(conn_handle, num_pkts);
+
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+    /* Queued notifications are sent from the host task. */
+    ble_hs_enqueue_event(&ble_hs_hci_evt_notify_q_event);
+#endif
+}
+#endif
+
 static int
 ble_hs_hci_evt_num_completed_pkts(uint8_t event_code, uint8_t *data, int len)
 {
@@ -222,11 +272,13 @@ ble_hs_hci_evt_num_completed_pkts(uint8_t event_code, uint8_t *data, int len)
         handle = le16toh(data + off + 2 * i);
         num_pkts = le16toh(data + off + 2 * num_handles + 2 * i);
 
-        /* XXX: Do something with these values. */
-        (void)handle;
-        (void)num_pkts;
+        ble_hs_hci_evt_conn_comp_pkts(handle, num_pkts);
     }
 
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+    ble_att_notify_q_tx();
+#endif
+
     return 0;
 }
 
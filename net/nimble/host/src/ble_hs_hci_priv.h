@@ -27,6 +27,7 @@ extern "C" {
 
 struct ble_hs_conn;
 struct os_mbuf;
+struct ble_gap_conn_perf;
 
 struct ble_hs_hci_ack {
     int bha_status;         /* A BLE_HS_E<...> error; NOT a naked HCI code. */
@@ -39,6 +40,18 @@ struct ble_hs_hci_ack {
 int ble_hs_hci_cmd_tx(void *cmd, void *evt_buf, uint8_t evt_buf_len,
                       uint8_t *out_evt_buf_len);
 int ble_hs_hci_cmd_tx_empty_ack(void *cmd);
+
+/**
+ * Called when a queued command completes.  status is a BLE_HS_E<...> error;
+ * params are the return parameters following the status byte.  Called from
+ * the host task, or from the task waiting in ble_hs_hci_cmd_drain().
+ */
+typedef void ble_hs_hci_cmd_cb(int status, const uint8_t *params,
+                               uint8_t params_len, void *arg);
+
+int ble_hs_hci_cmd_tx_async(void *cmd, ble_hs_hci_cmd_cb *cb, void *arg);
+int ble_hs_hci_cmd_drain(void);
+void ble_hs_hci_cmd_q_reset(void);
 void ble_hs_hci_rx_ack(uint8_t *ack_ev);
 void ble_hs_hci_init(void);
 
@@ -50,6 +63,8 @@ void ble_hs_hci_set_phony_ack_cb(ble_hs_hci_phony_ack_fn *cb);
 int ble_hs_hci_util_read_adv_tx_pwr(int8_t *out_pwr);
 int ble_hs_hci_util_rand(void *dst, int len);
 int ble_hs_hci_util_read_rssi(uint16_t conn_handle, int8_t *out_rssi);
+int ble_hs_hci_util_read_conn_perf(uint16_t conn_handle, int reset,
+                                   struct ble_gap_conn_perf *out_perf);
 int ble_hs_hci_util_set_random_addr(const uint8_t *addr);
 int ble_hs_hci_util_set_data_len(uint16_t conn_handle, uint16_t tx_octets,
                                  uint16_t tx_time);
@@ -57,6 +72,10 @@ int ble_hs_hci_util_data_hdr_strip(struct os_mbuf *om,
                                    struct hci_data_hdr *out_hdr);
 
 int ble_hs_hci_evt_process(uint8_t *data);
+#if MYNEWT_VAL(BLE_HCI_RAM_DIRECT)
+void ble_hs_hci_evt_num_comp_pkts_direct(uint16_t conn_handle,
+                                         uint16_t num_pkts, void *arg);
+#endif
 uint16_t ble_hs_hci_util_opcode_join(uint8_t ogf, uint16_t ocf);
 void ble_hs_hci_cmd_write_hdr(uint8_t ogf, uint8_t ocf, uint8_t len,
                               void *buf);
@@ -129,6 +148,10 @@ void ble_hs_hci_cmd_build_le_rand(uint8_t *dst, int dst_len);
 void ble_hs_hci_cmd_build_le_start_encrypt(const struct hci_start_encrypt *cmd,
                                            uint8_t *dst, int dst_len);
 int ble_hs_hci_set_buf_sz(uint16_t pktlen, uint8_t max_pkts);
+int ble_hs_hci_avail_pkts(void);
+int ble_hs_hci_total_pkts(void);
+void ble_hs_hci_add_avail_pkts(uint16_t delta);
+int ble_hs_hci_acl_frag_cnt(uint16_t pktlen);
 
 uint16_t ble_hs_hci_util_handle_pb_bc_join(uint16_t handle, uint8_t pb,
                                            uint8_t bc);
@@ -18,8 +18,12 @@
  */
 
 #include <string.h>
+#include "syscfg/syscfg.h"
 #include "nimble/hci_common.h"
 #include "ble_hs_priv.h"
+#if MYNEWT_VAL(ENTROPY_PRESENT)
+#include "entropy/entropy.h"
+#endif
 
 uint16_t
 ble_hs_hci_util_opcode_join(uint8_t ogf, uint16_t ocf)
@@ -72,6 +76,15 @@ ble_hs_hci_util_rand(void *dst, int len)
     int chunk_sz;
     int rc;
 
+#if MYNEWT_VAL(ENTROPY_PRESENT)
+    /* Use the system DRBG when it is seeded; it saves an HCI round trip per
+     * eight bytes and never waits on the controller's RNG.
+     */
+    if (entropy_get(dst, len) == 0) {
+        return 0;
+    }
+#endif
+
     ble_hs_hci_cmd_build_le_rand(req_buf, sizeof req_buf);
 
     u8ptr = dst;
@@ -123,6 +136,53 @@ ble_hs_hci_util_read_rssi(uint16_t conn_handle, int8_t *out_rssi)
     return 0;
 }
 
+/**
+ * Reads the controller's link statistics of a connection with the vendor
+ * specific read connection performance command, and optionally clears
+ * them.  Fills in the ctlr_* fields of the supplied struct.
+ */
+int
+ble_hs_hci_util_read_conn_perf(uint16_t conn_handle, int reset,
+                               struct ble_gap_conn_perf *out_perf)
+{
+    uint8_t buf[BLE_HCI_CMD_HDR_LEN + BLE_HCI_VS_RD_CONN_PERF_LEN];
+    uint8_t params[BLE_HCI_VS_RD_CONN_PERF_RSPLEN];
+    uint8_t params_len;
+    int rc;
+
+    ble_hs_hci_cmd_write_hdr(BLE_HCI_OGF_VENDOR, BLE_HCI_OCF_VS_RD_CONN_PERF,
+                             BLE_HCI_VS_RD_CONN_PERF_LEN, buf);
+    htole16(buf + BLE_HCI_CMD_HDR_LEN, conn_handle);
+    buf[BLE_HCI_CMD_HDR_LEN + 2] = !!reset;
+
+    rc = ble_hs_hci_cmd_tx(buf, params, sizeof params, &params_len);
+    if (rc != 0) {
+        return rc;
+    }
+
+    if (params_len != BLE_HCI_VS_RD_CONN_PERF_RSPLEN ||
+        le16toh(params + 0) != conn_handle) {
+
+        return BLE_HS_ECONTROLLER;
+    }
+
+    out_perf->ctlr_rssi = params[2];
+    out_perf->ctlr_rssi_avg = params[3];
+    out_perf->ctlr_events = le32toh(params + 4);
+    out_perf->ctlr_events_skipped = le32toh(params + 8);
+    out_perf->ctlr_rx_ok = le32toh(params + 12);
+    out_perf->ctlr_rx_crc_err = le32toh(params + 16);
+    out_perf->ctlr_rx_empty = le32toh(params + 20);
+    out_perf->ctlr_tx_ack = le32toh(params + 24);
+    out_perf->ctlr_tx_retry = le32toh(params + 28);
+    out_perf->ctlr_tx_empty = le32toh(params + 32);
+    out_perf->ctlr_tx_pkts = le32toh(params + 36);
+    out_perf->ctlr_tx_lat_avg = le32toh(params + 40);
+    out_perf->ctlr_tx_lat_max = le32toh(params + 44);
+
+    return 0;
+}
+
 int
 ble_hs_hci_util_set_random_addr(const uint8_t *addr)
 {
@@ -0,0 +1,193 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(BLE_HS_CONN_PERF_NEWTMGR)
+
+#include <stdbool.h>
+
+#include "mgmt/mgmt.h"
+#include "cborattr/cborattr.h"
+
+#include "host/ble_gap.h"
+#include "ble_hs_priv.h"
+
+#define BLE_HS_NMGR_ID_CONN_PERF    0
+
+static int ble_hs_nmgr_conn_perf(struct mgmt_cbuf *);
+
+static const struct mgmt_handler ble_hs_nmgr_handlers[] = {
+    [BLE_HS_NMGR_ID_CONN_PERF] = { ble_hs_nmgr_conn_perf,
+                                   ble_hs_nmgr_conn_perf },
+};
+
+static struct mgmt_group ble_hs_nmgr_group = {
+    .mg_handlers = (struct mgmt_handler *)ble_hs_nmgr_handlers,
+    .mg_handlers_count = 1,
+    .mg_group_id = MGMT_GROUP_ID_BLE
+};
+
+/**
+ * Encodes the statistics of one connection as a map.  Controller and host
+ * statistics are left out if they are not available.
+ */
+static CborError
+ble_hs_nmgr_encode_perf(CborEncoder *penc, uint16_t conn_handle,
+                        const struct ble_gap_conn_perf *perf)
+{
+    CborError g_err = CborNoError;
+    CborEncoder map;
+
+    g_err |= cbor_encoder_create_map(penc, &map, CborIndefiniteLength);
+    g_err |= cbor_encode_text_stringz(&map, "conn");
+    g_err |= cbor_encode_uint(&map, conn_handle);
+
+    if (perf->ctlr_valid) {
+        g_err |= cbor_encode_text_stringz(&map, "rssi");
+        g_err |= cbor_encode_int(&map, perf->ctlr_rssi);
+        g_err |= cbor_encode_text_stringz(&map, "rssi_avg");
+        g_err |= cbor_encode_int(&map, perf->ctlr_rssi_avg);
+        g_err |= cbor_encode_text_stringz(&map, "events");
+        g_err |= cbor_encode_uint(&map, perf->ctlr_events);
+        g_err |= cbor_encode_text_stringz(&map, "events_skipped");
+        g_err |= cbor_encode_uint(&map, perf->ctlr_events_skipped);
+        g_err |= cbor_encode_text_stringz(&map, "rx_ok");
+        g_err |= cbor_encode_uint(&map, perf->ctlr_rx_ok);
+        g_err |= cbor_encode_text_stringz(&map, "rx_crc_err");
+        g_err |= cbor_encode_uint(&map, perf->ctlr_rx_crc_err);
+        g_err |= cbor_encode_text_stringz(&map, "rx_empty");
+        g_err |= cbor_encode_uint(&map, perf->ctlr_rx_empty);
+        g_err |= cbor_encode_text_stringz(&map, "tx_ack");
+        g_err |= cbor_encode_uint(&map, perf->ctlr_tx_ack);
+        g_err |= cbor_encode_text_stringz(&map, "tx_retry");
+        g_err |= cbor_encode_uint(&map, perf->ctlr_tx_retry);
+        g_err |= cbor_encode_text_stringz(&map, "tx_empty");
+        g_err |= cbor_encode_uint(&map, perf->ctlr_tx_empty);
+        g_err |= cbor_encode_text_stringz(&map, "tx_pkts");
+        g_err |= cbor_encode_uint(&map, perf->ctlr_tx_pkts);
+        g_err |= cbor_encode_text_stringz(&map, "tx_lat_avg_us");
+        g_err |= cbor_encode_uint(&map, perf->ctlr_tx_lat_avg);
+        g_err |= cbor_encode_text_stringz(&map, "tx_lat_max_us");
+        g_err |= cbor_encode_uint(&map, perf->ctlr_tx_lat_max);
+    }
+
+    if (perf->host_valid) {
+        g_err |= cbor_encode_text_stringz(&map, "hs_tx_frags");
+        g_err |= cbor_encode_uint(&map, perf->host_tx_frags);
+        g_err |= cbor_encode_text_stringz(&map, "hs_tx_no_credit");
+        g_err |= cbor_encode_uint(&map, perf->host_tx_no_credit);
+        g_err |= cbor_encode_text_stringz(&map, "hs_comp_lat_avg_ms");
+        g_err |= cbor_encode_uint(&map, perf->host_comp_lat_avg);
+        g_err |= cbor_encode_text_stringz(&map, "hs_comp_lat_max_ms");
+        g_err |= cbor_encode_uint(&map, perf->host_comp_lat_max);
+        g_err |= cbor_encode_text_stringz(&map, "hs_outstanding");
+        g_err |= cbor_encode_uint(&map, perf->host_outstanding);
+        g_err |= cbor_encode_text_stringz(&map, "hs_max_outstanding");
+        g_err |= cbor_encode_uint(&map, perf->host_max_outstanding);
+    }
+
+    g_err |= cbor_encoder_close_container(penc, &map);
+
+    return g_err;
+}
+
+/**
+ * Reports the link statistics of one connection ("conn"), or of all of
+ * them, and clears them if "reset" is set.
+ */
+static int
+ble_hs_nmgr_conn_perf(struct mgmt_cbuf *cb)
+{
+    uint16_t handles[MYNEWT_VAL(BLE_MAX_CONNECTIONS)];
+    long long int conn = -1;
+    bool reset = false;
+    const struct cbor_attr_t attr[3] = {
+        [0] = {
+            .attribute = "conn",
+            .type = CborAttrIntegerType,
+            .addr.integer = &conn,
+            .dflt.integer = -1
+        },
+        [1] = {
+            .attribute = "reset",
+            .type = CborAttrBooleanType,
+            .addr.boolean = &reset,
+            .dflt.boolean = false
+        },
+        [2] = {
+            .attribute = NULL
+        }
+    };
+    CborError g_err = CborNoError;
+    CborEncoder *penc = &cb->encoder;
+    CborEncoder rsp, list;
+    struct ble_gap_conn_perf perf;
+    struct ble_hs_conn *c;
+    int num_handles;
+    int rc;
+    int i;
+
+    rc = cbor_read_object(&cb->it, attr);
+    if (rc) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    num_handles = 0;
+    if (conn >= 0) {
+        handles[num_handles++] = conn;
+    } else {
+        ble_hs_lock();
+        for (i = 0; i < MYNEWT_VAL(BLE_MAX_CONNECTIONS); i++) {
+            c = ble_hs_conn_find_by_idx(i);
+            if (c == NULL) {
+                break;
+            }
+            handles[num_handles++] = c->bhc_handle;
+        }
+        ble_hs_unlock();
+    }
+
+    g_err |= cbor_encoder_create_map(penc, &rsp, CborIndefiniteLength);
+    g_err |= cbor_encode_text_stringz(&rsp, "rc");
+    g_err |= cbor_encode_int(&rsp, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&rsp, "conns");
+    g_err |= cbor_encoder_create_array(&rsp, &list, CborIndefiniteLength);
+    for (i = 0; i < num_handles; i++) {
+        /* Connections may go away while we are at it; leave them out. */
+        if (ble_gap_conn_perf(handles[i], reset, &perf) == 0) {
+            g_err |= ble_hs_nmgr_encode_perf(&list, handles[i], &perf);
+        }
+    }
+    g_err |= cbor_encoder_close_container(&rsp, &list);
+    g_err |= cbor_encoder_close_container(penc, &rsp);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return 0;
+}
+
+int
+ble_hs_nmgr_register(void)
+{
+    return mgmt_group_register(&ble_hs_nmgr_group);
+}
+
+#endif /* MYNEWT_VAL(BLE_HS_CONN_PERF_NEWTMGR) */
@@ -34,7 +34,9 @@
 #include "ble_hs_endian_priv.h"
 #include "ble_hs_mbuf_priv.h"
 #include "ble_hs_startup_priv.h"
+#include "ble_hs_tmo_priv.h"
 #include "ble_l2cap_priv.h"
+#include "ble_l2cap_coc_priv.h"
 #include "ble_l2cap_sig_priv.h"
 #include "ble_sm_priv.h"
 #include "ble_hs_adv_priv.h"
@@ -74,6 +76,10 @@ STATS_SECT_START(ble_hs_stats)
     STATS_SECT_ENTRY(hci_timeout)
     STATS_SECT_ENTRY(reset)
     STATS_SECT_ENTRY(sync)
+    STATS_SECT_ENTRY(lock_contended)
+    STATS_SECT_ENTRY(lock_wait_ticks)
+    STATS_SECT_ENTRY(store_lock_contended)
+    STATS_SECT_ENTRY(store_lock_wait_ticks)
 STATS_SECT_END
 extern STATS_SECT_DECL(ble_hs_stats) ble_hs_stats;
 
@@ -90,10 +96,14 @@ void ble_hs_process_tx_data_queue(void);
 void ble_hs_process_rx_data_queue(void);
 int ble_hs_tx_data(struct os_mbuf *om);
 void ble_hs_enqueue_hci_event(uint8_t *hci_evt);
+void ble_hs_enqueue_event(struct os_event *ev);
 void ble_hs_event_enqueue(struct os_event *ev);
 
 int ble_hs_hci_rx_evt(uint8_t *hci_ev, void *arg);
 int ble_hs_hci_evt_acl_process(struct os_mbuf *om);
+#if MYNEWT_VAL(BLE_HS_CONN_PERF_NEWTMGR)
+int ble_hs_nmgr_register(void);
+#endif
 
 int ble_hs_misc_conn_chan_find(uint16_t conn_handle, uint16_t cid,
                                struct ble_hs_conn **out_conn,
@@ -105,6 +115,7 @@ uint8_t ble_hs_misc_addr_type_to_id(uint8_t addr_type);
 
 int ble_hs_locked_by_cur_task(void);
 int ble_hs_is_parent_task(void);
+int ble_store_init(void);
 void ble_hs_lock(void);
 void ble_hs_unlock(void);
 void ble_hs_sched_reset(int reason);
@@ -112,7 +123,8 @@ void ble_hs_hw_error(uint8_t hw_code);
 void ble_hs_timer_resched(void);
 void ble_hs_notifications_sched(void);
 
-#if MYNEWT_VAL(LOG_LEVEL) <= LOG_LEVEL_DEBUG
+#if MYNEWT_VAL(LOG_LEVEL) <= LOG_LEVEL_DEBUG && \
+    MYNEWT_VAL(LOG_LEVEL_NIMBLE_HOST) <= LOG_LEVEL_DEBUG
 
 #define BLE_HS_LOG_CMD(is_tx, cmd_type, cmd_name, conn_handle,                \
                        log_cb, cmd) do                                        \
@@ -22,83 +22,105 @@
 #include "host/ble_hs.h"
 #include "ble_hs_priv.h"
 
-static int
-ble_hs_startup_le_read_sup_f_tx(void)
+/** First error reported to a startup command callback. */
+static int ble_hs_startup_rc;
+
+static void
+ble_hs_startup_fail(int rc)
 {
-    uint8_t ack_params[BLE_HCI_RD_LOC_SUPP_FEAT_RSPLEN];
-    uint8_t buf[BLE_HCI_CMD_HDR_LEN];
-    uint8_t ack_params_len;
-    int rc;
+    if (ble_hs_startup_rc == 0) {
+        ble_hs_startup_rc = rc;
+    }
+}
 
-    ble_hs_hci_cmd_build_le_read_loc_supp_feat(buf, sizeof buf);
-    rc = ble_hs_hci_cmd_tx(buf, ack_params, sizeof ack_params,
-                           &ack_params_len);
-    if (rc != 0) {
-        return rc;
+static void
+ble_hs_startup_le_read_sup_f_cb(int status, const uint8_t *params,
+                                uint8_t params_len, void *arg)
+{
+    if (status != 0) {
+        ble_hs_startup_fail(status);
+        return;
     }
 
-    if (ack_params_len != BLE_HCI_RD_LOC_SUPP_FEAT_RSPLEN) {
-        return BLE_HS_ECONTROLLER;
+    if (params_len != BLE_HCI_RD_LOC_SUPP_FEAT_RSPLEN) {
+        ble_hs_startup_fail(BLE_HS_ECONTROLLER);
+        return;
     }
 
     /* XXX: Do something with the supported features bit map. */
-
-    return 0;
 }
 
 static int
-ble_hs_startup_le_read_buf_sz_tx(void)
+ble_hs_startup_le_read_sup_f_tx(void)
 {
-    uint16_t pktlen;
-    uint8_t ack_params[BLE_HCI_RD_BUF_SIZE_RSPLEN];
     uint8_t buf[BLE_HCI_CMD_HDR_LEN];
-    uint8_t ack_params_len;
+
+    ble_hs_hci_cmd_build_le_read_loc_supp_feat(buf, sizeof buf);
+    return ble_hs_hci_cmd_tx_async(buf, ble_hs_startup_le_read_sup_f_cb,
+                                   NULL);
+}
+
+static void
+ble_hs_startup_le_read_buf_sz_cb(int status, const uint8_t *params,
+                                 uint8_t params_len, void *arg)
+{
+    uint16_t pktlen;
     uint8_t max_pkts;
     int rc;
 
-    ble_hs_hci_cmd_build_le_read_buffer_size(buf, sizeof buf);
-    rc = ble_hs_hci_cmd_tx(buf, ack_params, sizeof ack_params,
-                           &ack_params_len);
-    if (rc != 0) {
-        return rc;
+    if (status != 0) {
+        ble_hs_startup_fail(status);
+        return;
     }
 
-    if (ack_params_len != BLE_HCI_RD_BUF_SIZE_RSPLEN) {
-        return BLE_HS_ECONTROLLER;
+    if (params_len != BLE_HCI_RD_BUF_SIZE_RSPLEN) {
+        ble_hs_startup_fail(BLE_HS_ECONTROLLER);
+        return;
     }
 
-    pktlen = le16toh(ack_params + 0);
-    max_pkts = ack_params[2];
+    pktlen = le16toh(params + 0);
+    max_pkts = params[2];
 
     rc = ble_hs_hci_set_buf_sz(pktlen, max_pkts);
     if (rc != 0) {
-        return rc;
+        ble_hs_startup_fail(rc);
     }
-
-    return 0;
 }
 
 static int
-ble_hs_startup_read_bd_addr(void)
+ble_hs_startup_le_read_buf_sz_tx(void)
 {
-    uint8_t ack_params[BLE_HCI_IP_RD_BD_ADDR_ACK_PARAM_LEN];
     uint8_t buf[BLE_HCI_CMD_HDR_LEN];
-    uint8_t ack_params_len;
-    int rc;
 
-    ble_hs_hci_cmd_build_read_bd_addr(buf, sizeof buf);
-    rc = ble_hs_hci_cmd_tx(buf, ack_params, sizeof ack_params,
-                           &ack_params_len);
-    if (rc != 0) {
-        return rc;
+    ble_hs_hci_cmd_build_le_read_buffer_size(buf, sizeof buf);
+    return ble_hs_hci_cmd_tx_async(buf, ble_hs_startup_le_read_buf_sz_cb,
+                                   NULL);
+}
+
+static void
+ble_hs_startup_read_bd_addr_cb(int status, const uint8_t *params,
+                               uint8_t params_len, void *arg)
+{
+    if (status != 0) {
+        ble_hs_startup_fail(status);
+        return;
     }
 
-    if (ack_params_len != sizeof ack_params) {
-        return BLE_HS_ECONTROLLER;
+    if (params_len != BLE_HCI_IP_RD_BD_ADDR_ACK_PARAM_LEN) {
+        ble_hs_startup_fail(BLE_HS_ECONTROLLER);
+        return;
     }
 
-    ble_hs_id_set_pub(ack_params);
-    return 0;
+    ble_hs_id_set_pub(params);
+}
+
+static int
+ble_hs_startup_read_bd_addr(void)
+{
+    uint8_t buf[BLE_HCI_CMD_HDR_LEN];
+
+    ble_hs_hci_cmd_build_read_bd_addr(buf, sizeof buf);
+    return ble_hs_hci_cmd_tx_async(buf, ble_hs_startup_read_bd_addr_cb, NULL);
 }
 
 static int
@@ -120,7 +142,7 @@ ble_hs_startup_le_set_evmask_tx(void)
      */
     ble_hs_hci_cmd_build_le_set_event_mask(0x000000000000027f,
                                            buf, sizeof buf);
-    rc = ble_hs_hci_cmd_tx_empty_ack(buf);
+    rc = ble_hs_hci_cmd_tx_async(buf, NULL, NULL);
     if (rc != 0) {
         return rc;
     }
@@ -177,7 +199,7 @@ ble_hs_startup_set_evmask_tx(void)
      *     0x2000000000000000 LE Meta-Event
      */
     ble_hs_hci_cmd_build_set_event_mask(0x20009fffffffffff, buf, sizeof buf);
-    rc = ble_hs_hci_cmd_tx_empty_ack(buf);
+    rc = ble_hs_hci_cmd_tx_async(buf, NULL, NULL);
     if (rc != 0) {
         return rc;
     }
@@ -187,7 +209,7 @@ ble_hs_startup_set_evmask_tx(void)
      *     0x0000000000800000 Authenticated Payload Timeout Event
      */
     ble_hs_hci_cmd_build_set_event_mask2(0x0000000000800000, buf, sizeof buf);
-    rc = ble_hs_hci_cmd_tx_empty_ack(buf);
+    rc = ble_hs_hci_cmd_tx_async(buf, NULL, NULL);
     if (rc != 0) {
         return rc;
     }
@@ -213,6 +235,7 @@ ble_hs_startup_reset_tx(void)
 int
 ble_hs_startup_go(void)
 {
+    int drain_rc;
     int rc;
 
     rc = ble_hs_startup_reset_tx();
@@ -223,29 +246,36 @@ ble_hs_startup_go(void)
     /* XXX: Read local supported commands. */
     /* XXX: Read local supported features. */
 
-    rc = ble_hs_startup_set_evmask_tx();
-    if (rc != 0) {
-        return rc;
-    }
+    /* None of the remaining commands depend on each other's results, so
+     * queue them all and let the controller take them as fast as it can.
+     */
+    ble_hs_startup_rc = 0;
 
-    rc = ble_hs_startup_le_set_evmask_tx();
-    if (rc != 0) {
-        return rc;
+    rc = ble_hs_startup_set_evmask_tx();
+    if (rc == 0) {
+        rc = ble_hs_startup_le_set_evmask_tx();
     }
-
-    rc = ble_hs_startup_le_read_buf_sz_tx();
-    if (rc != 0) {
-        return rc;
+    if (rc == 0) {
+        rc = ble_hs_startup_le_read_buf_sz_tx();
     }
 
     /* XXX: Read buffer size. */
 
-    rc = ble_hs_startup_le_read_sup_f_tx();
-    if (rc != 0) {
-        return rc;
+    if (rc == 0) {
+        rc = ble_hs_startup_le_read_sup_f_tx();
+    }
+    if (rc == 0) {
+        rc = ble_hs_startup_read_bd_addr();
     }
 
-    rc = ble_hs_startup_read_bd_addr();
+    /* Wait for whatever got queued, even if queueing failed part way. */
+    drain_rc = ble_hs_hci_cmd_drain();
+    if (rc == 0) {
+        rc = drain_rc;
+    }
+    if (rc == 0) {
+        rc = ble_hs_startup_rc;
+    }
     if (rc != 0) {
         return rc;
     }
@@ -0,0 +1,123 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "ble_hs_priv.h"
+
+/**
+ * Adds a deadline to the specified list.  Procedures tend to be armed with the
+ * same timeout, so a new deadline almost always belongs at the end; the list
+ * is searched from the back to make this case constant-time.
+ */
+void
+ble_hs_tmo_insert(struct ble_hs_tmo_list *list, struct ble_hs_tmo *tmo,
+                  os_time_t exp_ticks)
+{
+    struct ble_hs_tmo *cur;
+
+    BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
+    BLE_HS_DBG_ASSERT(tmo->bht_next.tqe_prev == NULL);
+
+    tmo->bht_exp_ticks = exp_ticks;
+
+    TAILQ_FOREACH_REVERSE(cur, list, ble_hs_tmo_list, bht_next) {
+        if (!OS_TIME_TICK_LT(exp_ticks, cur->bht_exp_ticks)) {
+            TAILQ_INSERT_AFTER(list, cur, tmo, bht_next);
+            return;
+        }
+    }
+
+    TAILQ_INSERT_HEAD(list, tmo, bht_next);
+}
+
+/**
+ * Removes a deadline from the specified list.  No-op if the deadline is not
+ * in the list.
+ */
+void
+ble_hs_tmo_remove(struct ble_hs_tmo_list *list, struct ble_hs_tmo *tmo)
+{
+    BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
+
+    if (tmo->bht_next.tqe_prev != NULL) {
+        TAILQ_REMOVE(list, tmo, bht_next);
+        tmo->bht_next.tqe_prev = NULL;
+    }
+}
+
+/**
+ * Moves a deadline, inserting it into the list if it is not already present.
+ */
+void
+ble_hs_tmo_update(struct ble_hs_tmo_list *list, struct ble_hs_tmo *tmo,
+                  os_time_t exp_ticks)
+{
+    ble_hs_tmo_remove(list, tmo);
+    ble_hs_tmo_insert(list, tmo, exp_ticks);
+}
+
+/**
+ * Retrieves the soonest deadline in the specified list if it has passed.  The
+ * deadline is not removed from the list.
+ *
+ * @return                      The expired deadline on success;
+ *                              NULL if no deadline has passed.
+ */
+struct ble_hs_tmo *
+ble_hs_tmo_first_expired(struct ble_hs_tmo_list *list, os_time_t now)
+{
+    struct ble_hs_tmo *tmo;
+
+    BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
+
+    tmo = TAILQ_FIRST(list);
+    if (tmo != NULL && OS_TIME_TICK_GT(tmo->bht_exp_ticks, now)) {
+        tmo = NULL;
+    }
+
+    return tmo;
+}
+
+/**
+ * Calculates the number of ticks until the soonest deadline in the specified
+ * list passes.
+ *
+ * @return                      The number of ticks until the next expiration;
+ *                              0 if a deadline has already passed;
+ *                              BLE_HS_FOREVER if the list is empty.
+ */
+int32_t
+ble_hs_tmo_ticks_until_exp(struct ble_hs_tmo_list *list, os_time_t now)
+{
+    struct ble_hs_tmo *tmo;
+    int32_t ticks;
+
+    BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
+
+    tmo = TAILQ_FIRST(list);
+    if (tmo == NULL) {
+        return BLE_HS_FOREVER;
+    }
+
+    ticks = tmo->bht_exp_ticks - now;
+    if (ticks < 0) {
+        ticks = 0;
+    }
+
+    return ticks;
+}
@@ -0,0 +1,63 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_BLE_HS_TMO_
+#define H_BLE_HS_TMO_
+
+#include <stddef.h>
+#include <inttypes.h>
+#include "os/queue.h"
+#include "os/os_time.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A procedure deadline.  Each module that times out its procedures keeps its
+ * deadlines in a ble_hs_tmo_list, ordered soonest first, so that its timer
+ * only needs to look at the procedures that are actually due.  Lists are
+ * protected by the host lock.
+ */
+struct ble_hs_tmo {
+    TAILQ_ENTRY(ble_hs_tmo) bht_next;
+    os_time_t bht_exp_ticks;
+};
+
+TAILQ_HEAD(ble_hs_tmo_list, ble_hs_tmo);
+
+/** Retrieves the structure containing the specified deadline. */
+#define BLE_HS_TMO_CONTAINER(tmo, type, field) \
+    ((type *)((uint8_t *)(tmo) - offsetof(type, field)))
+
+void ble_hs_tmo_insert(struct ble_hs_tmo_list *list, struct ble_hs_tmo *tmo,
+                       os_time_t exp_ticks);
+void ble_hs_tmo_remove(struct ble_hs_tmo_list *list, struct ble_hs_tmo *tmo);
+void ble_hs_tmo_update(struct ble_hs_tmo_list *list, struct ble_hs_tmo *tmo,
+                       os_time_t exp_ticks);
+struct ble_hs_tmo *ble_hs_tmo_first_expired(struct ble_hs_tmo_list *list,
+                                            os_time_t now);
+int32_t ble_hs_tmo_ticks_until_exp(struct ble_hs_tmo_list *list,
+                                   os_time_t now);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
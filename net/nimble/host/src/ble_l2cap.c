@@ -30,8 +30,12 @@ _Static_assert(sizeof (struct ble_l2cap_hdr) == BLE_L2CAP_HDR_SZ,
 
 struct os_mempool ble_l2cap_chan_pool;
 
+/* Connection oriented channels come on top of the fixed ones. */
+#define BLE_L2CAP_CHAN_POOL_NUM                                 \
+    (MYNEWT_VAL(BLE_L2CAP_MAX_CHANS) + MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM))
+
 static os_membuf_t ble_l2cap_chan_mem[
-    OS_MEMPOOL_SIZE(MYNEWT_VAL(BLE_L2CAP_MAX_CHANS),
+    OS_MEMPOOL_SIZE(BLE_L2CAP_CHAN_POOL_NUM,
                      sizeof (struct ble_l2cap_chan))
 ];
 
@@ -47,6 +51,17 @@ STATS_NAME_START(ble_l2cap_stats)
     STATS_NAME(ble_l2cap_stats, sig_rx)
     STATS_NAME(ble_l2cap_stats, sm_tx)
     STATS_NAME(ble_l2cap_stats, sm_rx)
+    STATS_NAME(ble_l2cap_stats, rx_sdu)
+    STATS_NAME(ble_l2cap_stats, rx_sdu_mbufs)
+    STATS_NAME(ble_l2cap_stats, rx_frag)
+    STATS_NAME(ble_l2cap_stats, rx_reasm_nomem)
+    STATS_NAME(ble_l2cap_stats, coc_connect)
+    STATS_NAME(ble_l2cap_stats, coc_connect_fail)
+    STATS_NAME(ble_l2cap_stats, coc_disconnect)
+    STATS_NAME(ble_l2cap_stats, coc_rx_sdu)
+    STATS_NAME(ble_l2cap_stats, coc_tx_sdu)
+    STATS_NAME(ble_l2cap_stats, coc_tx_stall)
+    STATS_NAME(ble_l2cap_stats, coc_credit_tx)
 STATS_NAME_END(ble_l2cap_stats)
 
 struct ble_l2cap_chan *
@@ -75,6 +90,8 @@ ble_l2cap_chan_free(struct ble_l2cap_chan *chan)
         return;
     }
 
+    ble_l2cap_coc_chan_cleanup(chan);
+
     rc = os_memblock_put(&ble_l2cap_chan_pool, chan);
     BLE_HS_DBG_ASSERT_EVAL(rc == 0);
 
@@ -143,6 +160,7 @@ ble_l2cap_forget_rx(struct ble_hs_conn *conn, struct ble_l2cap_chan *chan)
     conn->bhc_rx_chan = NULL;
     chan->blc_rx_buf = NULL;
     chan->blc_rx_len = 0;
+    chan->blc_flags &= ~BLE_L2CAP_CHAN_F_RX_COPY;
 }
 
 static void
@@ -152,6 +170,71 @@ ble_l2cap_discard_rx(struct ble_hs_conn *conn, struct ble_l2cap_chan *chan)
     ble_l2cap_forget_rx(conn, chan);
 }
 
+#if MYNEWT_VAL(BLE_L2CAP_RX_COMPACT)
+/**
+ * Starts reassembly of an SDU that does not fit in its first fragment.  A
+ * buffer big enough for the whole SDU is allocated from msys, and the
+ * fragments get copied into it as they arrive.  This keeps the SDU in as few
+ * mbufs as possible, and hands the controller's ACL buffers back right away.
+ * If no such buffer is available, the fragments just get chained.
+ */
+static void
+ble_l2cap_rx_reasm_start(struct ble_l2cap_chan *chan, struct os_mbuf *om)
+{
+    struct os_mbuf *buf;
+    int rc;
+
+    buf = os_msys_get_pkthdr(chan->blc_rx_len, 0);
+    if (buf != NULL) {
+        rc = os_mbuf_appendfrom(buf, om, 0, OS_MBUF_PKTLEN(om));
+        if (rc == 0) {
+            os_mbuf_free_chain(om);
+            chan->blc_rx_buf = buf;
+            chan->blc_flags |= BLE_L2CAP_CHAN_F_RX_COPY;
+            return;
+        }
+        os_mbuf_free_chain(buf);
+    }
+
+    STATS_INC(ble_l2cap_stats, rx_reasm_nomem);
+    chan->blc_rx_buf = om;
+}
+#endif
+
+static void
+ble_l2cap_rx_reasm_append(struct ble_l2cap_chan *chan, struct os_mbuf *om)
+{
+    int rc;
+
+    if (chan->blc_flags & BLE_L2CAP_CHAN_F_RX_COPY) {
+        rc = os_mbuf_appendfrom(chan->blc_rx_buf, om, 0, OS_MBUF_PKTLEN(om));
+        if (rc == 0) {
+            os_mbuf_free_chain(om);
+            return;
+        }
+
+        /* Out of mbufs; chain what is left instead. */
+        STATS_INC(ble_l2cap_stats, rx_reasm_nomem);
+        chan->blc_flags &= ~BLE_L2CAP_CHAN_F_RX_COPY;
+    }
+
+    os_mbuf_concat(chan->blc_rx_buf, om);
+}
+
+static void
+ble_l2cap_rx_sdu_stats(struct os_mbuf *om)
+{
+    int num_mbufs;
+
+    num_mbufs = 0;
+    for (; om != NULL; om = SLIST_NEXT(om, om_next)) {
+        num_mbufs++;
+    }
+
+    STATS_INC(ble_l2cap_stats, rx_sdu);
+    STATS_INCN(ble_l2cap_stats, rx_sdu_mbufs, num_mbufs);
+}
+
 static int
 ble_l2cap_rx_payload(struct ble_hs_conn *conn, struct ble_l2cap_chan *chan,
                      struct os_mbuf *om,
@@ -160,10 +243,29 @@ ble_l2cap_rx_payload(struct ble_hs_conn *conn, struct ble_l2cap_chan *chan,
     int len_diff;
     int rc;
 
+    STATS_INC(ble_l2cap_stats, rx_frag);
+
     if (chan->blc_rx_buf == NULL) {
+#if MYNEWT_VAL(BLE_L2CAP_RX_COMPACT)
+        if (OS_MBUF_PKTLEN(om) < chan->blc_rx_len) {
+            ble_l2cap_rx_reasm_start(chan, om);
+        } else {
+            chan->blc_rx_buf = om;
+        }
+#else
         chan->blc_rx_buf = om;
+#endif
     } else {
-        os_mbuf_concat(chan->blc_rx_buf, om);
+        len_diff = OS_MBUF_PKTLEN(chan->blc_rx_buf) + OS_MBUF_PKTLEN(om) -
+                   chan->blc_rx_len;
+        if (len_diff > 0) {
+            /* More data than expected; data corruption. */
+            os_mbuf_free_chain(om);
+            ble_l2cap_discard_rx(conn, chan);
+            return BLE_HS_EBADDATA;
+        }
+
+        ble_l2cap_rx_reasm_append(chan, om);
     }
 
     /* Determine if packet is fully reassembled. */
@@ -174,6 +276,11 @@ ble_l2cap_rx_payload(struct ble_hs_conn *conn, struct ble_l2cap_chan *chan,
         rc = BLE_HS_EBADDATA;
     } else if (len_diff == 0) {
         /* All fragments received. */
+        ble_l2cap_rx_sdu_stats(chan->blc_rx_buf);
+        if (chan->blc_flags & BLE_L2CAP_CHAN_F_COC) {
+            /* Lets the channel's rx callback tell which channel it is. */
+            chan->blc_flags |= BLE_L2CAP_CHAN_F_COC_RXED;
+        }
         *out_rx_cb = chan->blc_rx_fn;
         *out_rx_buf = chan->blc_rx_buf;
         ble_l2cap_forget_rx(conn, chan);
@@ -266,6 +373,14 @@ ble_l2cap_rx(struct ble_hs_conn *conn,
             ble_l2cap_discard_rx(conn, chan);
         }
 
+        if (chan->blc_flags & BLE_L2CAP_CHAN_F_COC &&
+            l2cap_hdr.blh_len > chan->blc_my_mtu) {
+
+            /* PDU larger than our MPS. */
+            rc = BLE_HS_EBADDATA;
+            goto err;
+        }
+
         /* Remember channel and length of L2CAP data for reassembly. */
         conn->bhc_rx_chan = chan;
         chan->blc_rx_len = l2cap_hdr.blh_len;
@@ -291,6 +406,8 @@ ble_l2cap_rx(struct ble_hs_conn *conn,
         goto err;
     }
 
+    conn->bhc_rx_bytes += OS_MBUF_PKTLEN(*out_rx_buf);
+
     return 0;
 
 err:
@@ -311,9 +428,20 @@ int
 ble_l2cap_tx(struct ble_hs_conn *conn, struct ble_l2cap_chan *chan,
              struct os_mbuf *txom)
 {
+    uint16_t cid;
     int rc;
 
-    txom = ble_l2cap_prepend_hdr(txom, chan->blc_cid, OS_MBUF_PKTLEN(txom));
+    conn->bhc_tx_bytes += OS_MBUF_PKTLEN(txom);
+
+    /* Fixed channels have the same CID at both ends. */
+    cid = chan->blc_cid;
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+    if (chan->blc_flags & BLE_L2CAP_CHAN_F_COC) {
+        cid = chan->blc_dcid;
+    }
+#endif
+
+    txom = ble_l2cap_prepend_hdr(txom, cid, OS_MBUF_PKTLEN(txom));
     if (txom == NULL) {
         return BLE_HS_ENOMEM;
     }
@@ -331,7 +459,7 @@ ble_l2cap_init(void)
 {
     int rc;
 
-    rc = os_mempool_init(&ble_l2cap_chan_pool, MYNEWT_VAL(BLE_L2CAP_MAX_CHANS),
+    rc = os_mempool_init(&ble_l2cap_chan_pool, BLE_L2CAP_CHAN_POOL_NUM,
                          sizeof (struct ble_l2cap_chan),
                          ble_l2cap_chan_mem, "ble_l2cap_chan_pool");
     if (rc != 0) {
@@ -348,6 +476,11 @@ ble_l2cap_init(void)
         return rc;
     }
 
+    rc = ble_l2cap_coc_init();
+    if (rc != 0) {
+        return rc;
+    }
+
     rc = stats_init_and_reg(
         STATS_HDR(ble_l2cap_stats), STATS_SIZE_INIT_PARMS(ble_l2cap_stats,
         STATS_SIZE_32), STATS_NAME_INIT_PARMS(ble_l2cap_stats), "ble_l2cap");
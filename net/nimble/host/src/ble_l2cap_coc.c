@@ -0,0 +1,901 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * L2CAP LE credit based connection oriented channels; the data path.  The
+ * channels are opened and closed by the signaling code (ble_l2cap_sig.c).
+ *
+ * Receive: the peer gets enough credits for one full SDU.  Incoming PDUs are
+ * copied into the SDU buffer the application supplied with
+ * ble_l2cap_recv_ready() (or into an msys buffer if the application has not
+ * supplied one yet).  Once the SDU is complete, it is handed to the
+ * application; the credits the peer used up are given back when the
+ * application supplies the next buffer.
+ *
+ * Transmit: an SDU is segmented into PDUs of the peer's MPS, for as long as
+ * the peer has given us credits.  When they run out, the rest of the SDU is
+ * sent as more credits arrive, and the application gets a tx-unstalled event
+ * once the whole SDU is out.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include "syscfg/syscfg.h"
+#include "os/os.h"
+#include "nimble/ble.h"
+#include "ble_hs_priv.h"
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+
+STAILQ_HEAD(ble_l2cap_coc_srv_list, ble_l2cap_coc_srv);
+
+static struct ble_l2cap_coc_srv_list ble_l2cap_coc_srvs;
+
+static os_membuf_t ble_l2cap_coc_srv_mem[
+    OS_MEMPOOL_SIZE(MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM),
+                    sizeof (struct ble_l2cap_coc_srv))
+];
+
+static struct os_mempool ble_l2cap_coc_srv_pool;
+
+static ble_l2cap_rx_fn ble_l2cap_coc_rx;
+
+/*****************************************************************************
+ * $servers                                                                  *
+ *****************************************************************************/
+
+struct ble_l2cap_coc_srv *
+ble_l2cap_coc_srv_find(uint16_t psm)
+{
+    struct ble_l2cap_coc_srv *srv;
+
+    STAILQ_FOREACH(srv, &ble_l2cap_coc_srvs, next) {
+        if (srv->psm == psm) {
+            return srv;
+        }
+    }
+
+    return NULL;
+}
+
+int
+ble_l2cap_coc_create_server(uint16_t psm, uint16_t mtu,
+                            ble_l2cap_event_fn *cb, void *cb_arg)
+{
+    struct ble_l2cap_coc_srv *srv;
+    int rc;
+
+    if (psm == 0 || mtu < BLE_L2CAP_COC_MTU_MIN || cb == NULL) {
+        return BLE_HS_EINVAL;
+    }
+
+    ble_hs_lock();
+
+    if (ble_l2cap_coc_srv_find(psm) != NULL) {
+        rc = BLE_HS_EALREADY;
+        goto done;
+    }
+
+    srv = os_memblock_get(&ble_l2cap_coc_srv_pool);
+    if (srv == NULL) {
+        rc = BLE_HS_ENOMEM;
+        goto done;
+    }
+
+    srv->psm = psm;
+    srv->mtu = mtu;
+    srv->cb = cb;
+    srv->cb_arg = cb_arg;
+    STAILQ_INSERT_TAIL(&ble_l2cap_coc_srvs, srv, next);
+    rc = 0;
+
+done:
+    ble_hs_unlock();
+    return rc;
+}
+
+/*****************************************************************************
+ * $channels                                                                 *
+ *****************************************************************************/
+
+/**
+ * The number of credits the peer needs to send us one SDU of our MTU.
+ */
+static uint16_t
+ble_l2cap_coc_rx_quota(const struct ble_l2cap_chan *chan)
+{
+    const struct ble_l2cap_coc_endpoint *rx;
+
+    rx = &chan->blc_coc_rx;
+    return (rx->mtu + BLE_L2CAP_COC_SDU_LEN_SZ + rx->mps - 1) / rx->mps;
+}
+
+/**
+ * Allocates a connection oriented channel with a free CID of the specified
+ * connection.  The channel still needs to be inserted into the connection.
+ * Lock restrictions: Caller must lock ble_hs_mutex.
+ */
+struct ble_l2cap_chan *
+ble_l2cap_coc_chan_alloc(struct ble_hs_conn *conn, uint16_t psm, uint16_t mtu,
+                         struct os_mbuf *sdu_rx, ble_l2cap_event_fn *cb,
+                         void *cb_arg)
+{
+    struct ble_l2cap_chan *chan;
+    uint16_t cid;
+
+    BLE_HS_DBG_ASSERT(ble_hs_locked_by_cur_task());
+
+    for (cid = BLE_L2CAP_COC_CID_START; cid <= BLE_L2CAP_COC_CID_END; cid++) {
+        if (ble_hs_conn_chan_find(conn, cid) == NULL) {
+            break;
+        }
+    }
+    if (cid > BLE_L2CAP_COC_CID_END) {
+        return NULL;
+    }
+
+    chan = ble_l2cap_chan_alloc();
+    if (chan == NULL) {
+        return NULL;
+    }
+
+    chan->blc_cid = cid;
+    chan->blc_flags = BLE_L2CAP_CHAN_F_COC;
+    chan->blc_my_mtu = MYNEWT_VAL(BLE_L2CAP_COC_MPS);
+    chan->blc_default_mtu = MYNEWT_VAL(BLE_L2CAP_COC_MPS);
+    chan->blc_rx_fn = ble_l2cap_coc_rx;
+
+    chan->blc_conn_handle = conn->bhc_handle;
+    chan->blc_psm = psm;
+    chan->blc_cb = cb;
+    chan->blc_cb_arg = cb_arg;
+
+    chan->blc_coc_rx.mtu = mtu;
+    chan->blc_coc_rx.mps = MYNEWT_VAL(BLE_L2CAP_COC_MPS);
+    chan->blc_coc_rx.credits = ble_l2cap_coc_rx_quota(chan);
+    chan->blc_coc_rx.sdu = sdu_rx;
+
+    return chan;
+}
+
+/**
+ * Finds the connection oriented channel the peer knows by the specified CID.
+ * Lock restrictions: Caller must lock ble_hs_mutex.
+ */
+struct ble_l2cap_chan *
+ble_l2cap_coc_chan_find_peer(struct ble_hs_conn *conn, uint16_t peer_cid)
+{
+    struct ble_l2cap_chan *chan;
+
+    SLIST_FOREACH(chan, &conn->bhc_channels, blc_next) {
+        if (chan->blc_flags & BLE_L2CAP_CHAN_F_COC &&
+            chan->blc_dcid == peer_cid) {
+
+            return chan;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Checks that an application supplied channel pointer still refers to a
+ * channel of a live connection.
+ * Lock restrictions: Caller must lock ble_hs_mutex.
+ *
+ * @return                      0 if the channel is valid;
+ *                              BLE_HS_ENOTCONN otherwise.
+ */
+int
+ble_l2cap_coc_chan_valid(struct ble_l2cap_chan *chan,
+                         struct ble_hs_conn **out_conn)
+{
+    struct ble_hs_conn *conn;
+
+    if (chan == NULL) {
+        return BLE_HS_EINVAL;
+    }
+
+    conn = ble_hs_conn_find(chan->blc_conn_handle);
+    if (conn == NULL || ble_hs_conn_chan_find(conn, chan->blc_cid) != chan) {
+        return BLE_HS_ENOTCONN;
+    }
+
+    if (out_conn != NULL) {
+        *out_conn = conn;
+    }
+
+    return 0;
+}
+
+/**
+ * Removes a channel from its connection and frees it.
+ */
+void
+ble_l2cap_coc_chan_delete(struct ble_l2cap_chan *chan)
+{
+    struct ble_hs_conn *conn;
+
+    ble_hs_lock();
+    if (ble_l2cap_coc_chan_valid(chan, &conn) == 0) {
+        ble_hs_conn_delete_chan(conn, chan);
+    }
+    ble_hs_unlock();
+}
+
+/**
+ * Releases the buffers a channel holds; called when the channel is freed.
+ */
+void
+ble_l2cap_coc_chan_cleanup(struct ble_l2cap_chan *chan)
+{
+    if (chan->blc_flags & BLE_L2CAP_CHAN_F_COC) {
+        os_mbuf_free_chain(chan->blc_coc_rx.sdu);
+        os_mbuf_free_chain(chan->blc_coc_tx.sdu);
+        chan->blc_coc_rx.sdu = NULL;
+        chan->blc_coc_tx.sdu = NULL;
+    }
+}
+
+/*****************************************************************************
+ * $events                                                                   *
+ *****************************************************************************/
+
+int
+ble_l2cap_coc_call_cb(struct ble_l2cap_chan *chan,
+                      struct ble_l2cap_event *event)
+{
+    BLE_HS_DBG_ASSERT(!ble_hs_locked_by_cur_task());
+
+    event->conn_handle = chan->blc_conn_handle;
+    event->chan = chan;
+
+    if (chan->blc_cb == NULL) {
+        return 0;
+    }
+
+    return chan->blc_cb(event, chan->blc_cb_arg);
+}
+
+void
+ble_l2cap_coc_connected(struct ble_l2cap_chan *chan, int status)
+{
+    struct ble_l2cap_event event;
+
+    if (status == 0) {
+        STATS_INC(ble_l2cap_stats, coc_connect);
+    } else {
+        STATS_INC(ble_l2cap_stats, coc_connect_fail);
+    }
+
+    memset(&event, 0, sizeof event);
+    event.type = BLE_L2CAP_EVENT_COC_CONNECTED;
+    event.connect.status = status;
+    ble_l2cap_coc_call_cb(chan, &event);
+}
+
+void
+ble_l2cap_coc_disconnected(struct ble_l2cap_chan *chan)
+{
+    struct ble_l2cap_event event;
+
+    STATS_INC(ble_l2cap_stats, coc_disconnect);
+
+    memset(&event, 0, sizeof event);
+    event.type = BLE_L2CAP_EVENT_COC_DISCONNECTED;
+    ble_l2cap_coc_call_cb(chan, &event);
+}
+
+static void
+ble_l2cap_coc_tx_unstalled(struct ble_l2cap_chan *chan, int status)
+{
+    struct ble_l2cap_event event;
+
+    memset(&event, 0, sizeof event);
+    event.type = BLE_L2CAP_EVENT_COC_TX_UNSTALLED;
+    event.tx_unstalled.status = status;
+    ble_l2cap_coc_call_cb(chan, &event);
+}
+
+/**
+ * Reports each open channel of a connection that has gone away as
+ * disconnected.  The channels themselves get freed along with the
+ * connection.
+ */
+void
+ble_l2cap_coc_conn_broken(uint16_t conn_handle)
+{
+    struct ble_l2cap_chan *chans[MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM)];
+    struct ble_l2cap_chan *chan;
+    struct ble_hs_conn *conn;
+    int num_chans;
+    int i;
+
+    num_chans = 0;
+
+    ble_hs_lock();
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn != NULL) {
+        SLIST_FOREACH(chan, &conn->bhc_channels, blc_next) {
+            if (chan->blc_flags & BLE_L2CAP_CHAN_F_COC_OPEN &&
+                num_chans < MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM)) {
+
+                chan->blc_flags &= ~BLE_L2CAP_CHAN_F_COC_OPEN;
+                chans[num_chans++] = chan;
+            }
+        }
+    }
+    ble_hs_unlock();
+
+    for (i = 0; i < num_chans; i++) {
+        ble_l2cap_coc_disconnected(chans[i]);
+    }
+}
+
+/*****************************************************************************
+ * $rx                                                                       *
+ *****************************************************************************/
+
+/**
+ * Finds the channel ble_l2cap_rx() has just completed a PDU on.
+ * Lock restrictions: Caller must lock ble_hs_mutex.
+ */
+static struct ble_l2cap_chan *
+ble_l2cap_coc_rxed_chan(struct ble_hs_conn *conn)
+{
+    struct ble_l2cap_chan *chan;
+
+    SLIST_FOREACH(chan, &conn->bhc_channels, blc_next) {
+        if (chan->blc_flags & BLE_L2CAP_CHAN_F_COC_RXED) {
+            chan->blc_flags &= ~BLE_L2CAP_CHAN_F_COC_RXED;
+            return chan;
+        }
+    }
+
+    return NULL;
+}
+
+static int
+ble_l2cap_coc_rx(uint16_t conn_handle, struct os_mbuf **om)
+{
+    struct ble_l2cap_coc_endpoint *rx;
+    struct ble_l2cap_event event;
+    struct ble_l2cap_chan *chan;
+    struct ble_hs_conn *conn;
+    struct os_mbuf *sdu;
+    uint8_t sdu_len[BLE_L2CAP_COC_SDU_LEN_SZ];
+    uint16_t len;
+    int rc;
+
+    sdu = NULL;
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    chan = conn != NULL ? ble_l2cap_coc_rxed_chan(conn) : NULL;
+    if (chan == NULL || !(chan->blc_flags & BLE_L2CAP_CHAN_F_COC_OPEN)) {
+        ble_hs_unlock();
+        return BLE_HS_ENOENT;
+    }
+    rx = &chan->blc_coc_rx;
+
+    /* A peer sending without credits, or more than it announced, has broken
+     * the channel.
+     */
+    if (rx->credits == 0) {
+        rc = BLE_HS_EBADDATA;
+        goto err;
+    }
+    rx->credits--;
+
+    if (!rx->in_sdu) {
+        rc = os_mbuf_copydata(*om, 0, sizeof sdu_len, sdu_len);
+        if (rc != 0) {
+            rc = BLE_HS_EBADDATA;
+            goto err;
+        }
+        os_mbuf_adj(*om, sizeof sdu_len);
+
+        rx->sdu_len = le16toh(sdu_len);
+        if (rx->sdu_len > rx->mtu) {
+            rc = BLE_HS_EBADDATA;
+            goto err;
+        }
+
+        if (rx->sdu == NULL) {
+            /* The application has not supplied a buffer yet. */
+            rx->sdu = os_msys_get_pkthdr(rx->sdu_len, 0);
+            if (rx->sdu == NULL) {
+                rc = BLE_HS_ENOMEM;
+                goto err;
+            }
+        }
+
+        rx->data_len = 0;
+        rx->in_sdu = 1;
+    }
+
+    len = OS_MBUF_PKTLEN(*om);
+    if (rx->data_len + len > rx->sdu_len) {
+        rc = BLE_HS_EBADDATA;
+        goto err;
+    }
+
+    rc = os_mbuf_appendfrom(rx->sdu, *om, 0, len);
+    if (rc != 0) {
+        rc = BLE_HS_ENOMEM;
+        goto err;
+    }
+    rx->data_len += len;
+
+    if (rx->data_len == rx->sdu_len) {
+        sdu = rx->sdu;
+        rx->sdu = NULL;
+        rx->in_sdu = 0;
+        STATS_INC(ble_l2cap_stats, coc_rx_sdu);
+    }
+
+    ble_hs_unlock();
+
+    if (sdu != NULL) {
+        memset(&event, 0, sizeof event);
+        event.type = BLE_L2CAP_EVENT_COC_DATA_RECEIVED;
+        event.receive.sdu_rx = sdu;
+        ble_l2cap_coc_call_cb(chan, &event);
+    }
+
+    return 0;
+
+err:
+    rx->in_sdu = 0;
+    ble_hs_unlock();
+
+    ble_l2cap_sig_coc_disconnect(chan);
+    return rc;
+}
+
+/**
+ * Supplies the buffer the next SDU gets received into, and gives the peer
+ * back the credits it has used up.  The buffer is consumed, regardless of
+ * the outcome.
+ */
+int
+ble_l2cap_coc_recv_ready(struct ble_l2cap_chan *chan, struct os_mbuf *sdu_rx)
+{
+    struct ble_l2cap_coc_endpoint *rx;
+    uint16_t conn_handle;
+    uint16_t credits;
+    uint16_t quota;
+    uint16_t cid;
+    int rc;
+
+    if (sdu_rx == NULL) {
+        return BLE_HS_EINVAL;
+    }
+
+    ble_hs_lock();
+
+    rc = ble_l2cap_coc_chan_valid(chan, NULL);
+    if (rc != 0) {
+        goto err;
+    }
+    rx = &chan->blc_coc_rx;
+
+    if (rx->sdu != NULL) {
+        if (!rx->in_sdu) {
+            rc = BLE_HS_EALREADY;
+            goto err;
+        }
+
+        /* An SDU started arriving before the application was ready for it;
+         * carry on with it in the application's buffer.
+         */
+        rc = os_mbuf_appendfrom(sdu_rx, rx->sdu, 0, OS_MBUF_PKTLEN(rx->sdu));
+        if (rc != 0) {
+            rc = BLE_HS_ENOMEM;
+            goto err;
+        }
+        os_mbuf_free_chain(rx->sdu);
+    }
+    rx->sdu = sdu_rx;
+
+    quota = ble_l2cap_coc_rx_quota(chan);
+    if (rx->credits < quota && chan->blc_flags & BLE_L2CAP_CHAN_F_COC_OPEN) {
+        credits = quota - rx->credits;
+        rx->credits = quota;
+    } else {
+        credits = 0;
+    }
+    conn_handle = chan->blc_conn_handle;
+    cid = chan->blc_cid;
+
+    ble_hs_unlock();
+
+    if (credits != 0) {
+        STATS_INC(ble_l2cap_stats, coc_credit_tx);
+        ble_l2cap_sig_credit_tx(conn_handle, cid, credits);
+    }
+
+    return 0;
+
+err:
+    ble_hs_unlock();
+    os_mbuf_free_chain(sdu_rx);
+    return rc;
+}
+
+/*****************************************************************************
+ * $tx                                                                       *
+ *****************************************************************************/
+
+/**
+ * Sends as much of the channel's pending SDU as the peer has credits for.
+ * Lock restrictions: Caller must lock ble_hs_mutex.
+ *
+ * @return                      0 if the whole SDU has been sent;
+ *                              BLE_HS_ESTALLED if part of it is waiting for
+ *                                  credits;
+ *                              Other nonzero on error.
+ */
+static int
+ble_l2cap_coc_continue_tx(struct ble_hs_conn *conn,
+                          struct ble_l2cap_chan *chan)
+{
+    struct ble_l2cap_coc_endpoint *tx;
+    struct os_mbuf *txom;
+    uint8_t sdu_len[BLE_L2CAP_COC_SDU_LEN_SZ];
+    uint16_t len;
+    int rc;
+
+    tx = &chan->blc_coc_tx;
+
+    while (tx->sdu != NULL) {
+        if (tx->credits == 0) {
+            if (!(chan->blc_flags & BLE_L2CAP_CHAN_F_COC_STALLED)) {
+                chan->blc_flags |= BLE_L2CAP_CHAN_F_COC_STALLED;
+                STATS_INC(ble_l2cap_stats, coc_tx_stall);
+            }
+            return BLE_HS_ESTALLED;
+        }
+
+        txom = ble_hs_mbuf_l2cap_pkt();
+        if (txom == NULL) {
+            return BLE_HS_ENOMEM;
+        }
+
+        len = tx->mps;
+        if (!tx->in_sdu) {
+            htole16(sdu_len, tx->sdu_len);
+            rc = os_mbuf_append(txom, sdu_len, sizeof sdu_len);
+            if (rc != 0) {
+                os_mbuf_free_chain(txom);
+                return BLE_HS_ENOMEM;
+            }
+            len -= sizeof sdu_len;
+        }
+        len = min(len, tx->sdu_len - tx->data_len);
+
+        rc = os_mbuf_appendfrom(txom, tx->sdu, tx->data_len, len);
+        if (rc != 0) {
+            os_mbuf_free_chain(txom);
+            return BLE_HS_ENOMEM;
+        }
+
+        rc = ble_l2cap_tx(conn, chan, txom);
+        if (rc != 0) {
+            return rc;
+        }
+
+        tx->credits--;
+        tx->in_sdu = 1;
+        tx->data_len += len;
+
+        if (tx->data_len == tx->sdu_len) {
+            os_mbuf_free_chain(tx->sdu);
+            tx->sdu = NULL;
+            tx->in_sdu = 0;
+            STATS_INC(ble_l2cap_stats, coc_tx_sdu);
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Abandons the channel's pending SDU after a transmit error.  If part of it
+ * has already gone out, the peer cannot make sense of what follows, so the
+ * channel gets closed.
+ * Lock restrictions: Caller must lock ble_hs_mutex.
+ *
+ * @return                      1 if the channel needs to be disconnected;
+ *                              0 otherwise.
+ */
+static int
+ble_l2cap_coc_abort_tx(struct ble_l2cap_chan *chan)
+{
+    struct ble_l2cap_coc_endpoint *tx;
+    int partial;
+
+    tx = &chan->blc_coc_tx;
+    partial = tx->in_sdu;
+
+    os_mbuf_free_chain(tx->sdu);
+    tx->sdu = NULL;
+    tx->in_sdu = 0;
+
+    return partial;
+}
+
+/**
+ * Sends an SDU.  The buffer is consumed, regardless of the outcome.
+ *
+ * @return                      0 if the SDU has been sent;
+ *                              BLE_HS_ESTALLED if the peer has to give us
+ *                                  more credits first; the application gets
+ *                                  a BLE_L2CAP_EVENT_COC_TX_UNSTALLED event
+ *                                  once the SDU is out.
+ *                              BLE_HS_EBUSY if a stalled SDU is still
+ *                                  pending;
+ *                              Other nonzero on error.
+ */
+int
+ble_l2cap_coc_send(struct ble_l2cap_chan *chan, struct os_mbuf *sdu_tx)
+{
+    struct ble_l2cap_coc_endpoint *tx;
+    struct ble_hs_conn *conn;
+    int disconnect;
+    int rc;
+
+    disconnect = 0;
+
+    if (sdu_tx == NULL) {
+        return BLE_HS_EINVAL;
+    }
+
+    ble_hs_lock();
+
+    rc = ble_l2cap_coc_chan_valid(chan, &conn);
+    if (rc != 0) {
+        goto err;
+    }
+    if (!(chan->blc_flags & BLE_L2CAP_CHAN_F_COC_OPEN)) {
+        rc = BLE_HS_ENOTCONN;
+        goto err;
+    }
+
+    tx = &chan->blc_coc_tx;
+    if (tx->sdu != NULL) {
+        rc = BLE_HS_EBUSY;
+        goto err;
+    }
+    if (OS_MBUF_PKTLEN(sdu_tx) > tx->mtu) {
+        rc = BLE_HS_EMSGSIZE;
+        goto err;
+    }
+
+    tx->sdu = sdu_tx;
+    tx->sdu_len = OS_MBUF_PKTLEN(sdu_tx);
+    tx->data_len = 0;
+    tx->in_sdu = 0;
+
+    rc = ble_l2cap_coc_continue_tx(conn, chan);
+    if (rc != 0 && rc != BLE_HS_ESTALLED) {
+        disconnect = ble_l2cap_coc_abort_tx(chan);
+    }
+
+    ble_hs_unlock();
+
+    if (disconnect) {
+        ble_l2cap_sig_coc_disconnect(chan);
+    }
+
+    return rc;
+
+err:
+    ble_hs_unlock();
+    os_mbuf_free_chain(sdu_tx);
+    return rc;
+}
+
+/**
+ * Processes credits the peer has given us, and resumes a stalled SDU.
+ */
+void
+ble_l2cap_coc_credits_rx(uint16_t conn_handle, uint16_t peer_cid,
+                         uint16_t credits)
+{
+    struct ble_l2cap_coc_endpoint *tx;
+    struct ble_l2cap_chan *chan;
+    struct ble_hs_conn *conn;
+    int disconnect;
+    int unstalled;
+    int rc;
+
+    chan = NULL;
+    disconnect = 0;
+    unstalled = 0;
+    rc = 0;
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn != NULL) {
+        chan = ble_l2cap_coc_chan_find_peer(conn, peer_cid);
+    }
+    if (chan == NULL || !(chan->blc_flags & BLE_L2CAP_CHAN_F_COC_OPEN)) {
+        ble_hs_unlock();
+        return;
+    }
+
+    tx = &chan->blc_coc_tx;
+    if (tx->credits + credits > UINT16_MAX) {
+        /* The peer is not allowed to push us past 65535 credits. */
+        disconnect = 1;
+    } else {
+        tx->credits += credits;
+
+        if (chan->blc_flags & BLE_L2CAP_CHAN_F_COC_STALLED) {
+            rc = ble_l2cap_coc_continue_tx(conn, chan);
+            if (rc != BLE_HS_ESTALLED) {
+                chan->blc_flags &= ~BLE_L2CAP_CHAN_F_COC_STALLED;
+                unstalled = 1;
+                if (rc != 0) {
+                    disconnect = ble_l2cap_coc_abort_tx(chan);
+                }
+            }
+        }
+    }
+
+    ble_hs_unlock();
+
+    if (unstalled) {
+        ble_l2cap_coc_tx_unstalled(chan, rc);
+    }
+    if (disconnect) {
+        ble_l2cap_sig_coc_disconnect(chan);
+    }
+}
+
+int
+ble_l2cap_coc_init(void)
+{
+    int rc;
+
+    STAILQ_INIT(&ble_l2cap_coc_srvs);
+
+    rc = os_mempool_init(&ble_l2cap_coc_srv_pool,
+                         MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM),
+                         sizeof (struct ble_l2cap_coc_srv),
+                         ble_l2cap_coc_srv_mem, "ble_l2cap_coc_srv_pool");
+    if (rc != 0) {
+        return BLE_HS_EOS;
+    }
+
+    return 0;
+}
+
+#endif
+
+/*****************************************************************************
+ * $api                                                                      *
+ *****************************************************************************/
+
+/**
+ * Registers a server that accepts connection oriented channels on the
+ * specified PSM.  The callback receives a BLE_L2CAP_EVENT_COC_ACCEPT event
+ * for each channel a peer opens.
+ *
+ * @param psm                   The PSM to listen on.
+ * @param mtu                   The largest SDU the server can receive.
+ * @param cb                    The callback to associate with the server's
+ *                                  channels.
+ * @param cb_arg                The optional argument to pass to the callback.
+ *
+ * @return                      0 on success; nonzero on failure.
+ */
+int
+ble_l2cap_create_server(uint16_t psm, uint16_t mtu,
+                        ble_l2cap_event_fn *cb, void *cb_arg)
+{
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+    return ble_l2cap_coc_create_server(psm, mtu, cb, cb_arg);
+#else
+    return BLE_HS_ENOTSUP;
+#endif
+}
+
+/**
+ * Opens a connection oriented channel to a peer's PSM.  The outcome is
+ * reported with a BLE_L2CAP_EVENT_COC_CONNECTED event.
+ *
+ * @param conn_handle           The connection to open the channel over.
+ * @param psm                   The peer's PSM.
+ * @param mtu                   The largest SDU we can receive.
+ * @param sdu_rx                The buffer to receive the first SDU into.
+ * @param cb                    The callback to associate with the channel.
+ * @param cb_arg                The optional argument to pass to the callback.
+ *
+ * @return                      0 if the request has been sent; nonzero on
+ *                                  failure.
+ */
+int
+ble_l2cap_connect(uint16_t conn_handle, uint16_t psm, uint16_t mtu,
+                  struct os_mbuf *sdu_rx,
+                  ble_l2cap_event_fn *cb, void *cb_arg)
+{
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+    return ble_l2cap_sig_coc_connect(conn_handle, psm, mtu, sdu_rx,
+                                     cb, cb_arg);
+#else
+    return BLE_HS_ENOTSUP;
+#endif
+}
+
+/**
+ * Closes a connection oriented channel.  The application gets a
+ * BLE_L2CAP_EVENT_COC_DISCONNECTED event once the peer has confirmed.
+ */
+int
+ble_l2cap_disconnect(struct ble_l2cap_chan *chan)
+{
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+    return ble_l2cap_sig_coc_disconnect(chan);
+#else
+    return BLE_HS_ENOTSUP;
+#endif
+}
+
+/**
+ * Sends an SDU over a connection oriented channel.  The SDU is segmented
+ * as needed.  The supplied mbuf is consumed, regardless of the outcome.
+ *
+ * @return                      0 if the SDU has been sent;
+ *                              BLE_HS_ESTALLED if the rest of the SDU is
+ *                                  waiting for credits from the peer; a
+ *                                  BLE_L2CAP_EVENT_COC_TX_UNSTALLED event
+ *                                  follows;
+ *                              Other nonzero on error.
+ */
+int
+ble_l2cap_send(struct ble_l2cap_chan *chan, struct os_mbuf *sdu_tx)
+{
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+    return ble_l2cap_coc_send(chan, sdu_tx);
+#else
+    os_mbuf_free_chain(sdu_tx);
+    return BLE_HS_ENOTSUP;
+#endif
+}
+
+/**
+ * Supplies the buffer to receive the next SDU into.  Needs to be called
+ * after each BLE_L2CAP_EVENT_COC_DATA_RECEIVED event, as the peer gets more
+ * credits only then.  The supplied mbuf is consumed, regardless of the
+ * outcome.
+ */
+int
+ble_l2cap_recv_ready(struct ble_l2cap_chan *chan, struct os_mbuf *sdu_rx)
+{
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+    return ble_l2cap_coc_recv_ready(chan, sdu_rx);
+#else
+    os_mbuf_free_chain(sdu_rx);
+    return BLE_HS_ENOTSUP;
+#endif
+}
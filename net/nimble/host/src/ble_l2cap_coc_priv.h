@@ -0,0 +1,85 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef H_BLE_L2CAP_COC_PRIV_
+#define H_BLE_L2CAP_COC_PRIV_
+
+#include <inttypes.h>
+#include "syscfg/syscfg.h"
+#include "host/ble_l2cap.h"
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct ble_hs_conn;
+struct ble_l2cap_chan;
+struct os_mbuf;
+
+#define BLE_L2CAP_COC_CID_START             0x0040
+#define BLE_L2CAP_COC_CID_END               0x007f
+#define BLE_L2CAP_COC_SDU_LEN_SZ            2
+
+/* Smallest MTU and MPS a peer may ask for. */
+#define BLE_L2CAP_COC_MTU_MIN               23
+
+struct ble_l2cap_coc_srv {
+    STAILQ_ENTRY(ble_l2cap_coc_srv) next;
+    uint16_t psm;
+    uint16_t mtu;
+    ble_l2cap_event_fn *cb;
+    void *cb_arg;
+};
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+int ble_l2cap_coc_create_server(uint16_t psm, uint16_t mtu,
+                                ble_l2cap_event_fn *cb, void *cb_arg);
+struct ble_l2cap_coc_srv *ble_l2cap_coc_srv_find(uint16_t psm);
+struct ble_l2cap_chan *ble_l2cap_coc_chan_alloc(struct ble_hs_conn *conn,
+                                                uint16_t psm, uint16_t mtu,
+                                                struct os_mbuf *sdu_rx,
+                                                ble_l2cap_event_fn *cb,
+                                                void *cb_arg);
+struct ble_l2cap_chan *ble_l2cap_coc_chan_find_peer(struct ble_hs_conn *conn,
+                                                    uint16_t peer_cid);
+int ble_l2cap_coc_chan_valid(struct ble_l2cap_chan *chan,
+                             struct ble_hs_conn **out_conn);
+void ble_l2cap_coc_chan_delete(struct ble_l2cap_chan *chan);
+void ble_l2cap_coc_chan_cleanup(struct ble_l2cap_chan *chan);
+int ble_l2cap_coc_call_cb(struct ble_l2cap_chan *chan,
+                          struct ble_l2cap_event *event);
+void ble_l2cap_coc_connected(struct ble_l2cap_chan *chan, int status);
+void ble_l2cap_coc_disconnected(struct ble_l2cap_chan *chan);
+void ble_l2cap_coc_credits_rx(uint16_t conn_handle, uint16_t peer_cid,
+                              uint16_t credits);
+void ble_l2cap_coc_conn_broken(uint16_t conn_handle);
+int ble_l2cap_coc_send(struct ble_l2cap_chan *chan, struct os_mbuf *sdu_tx);
+int ble_l2cap_coc_recv_ready(struct ble_l2cap_chan *chan,
+                             struct os_mbuf *sdu_rx);
+int ble_l2cap_coc_init(void);
+#else
+#define ble_l2cap_coc_chan_cleanup(chan)
+#define ble_l2cap_coc_conn_broken(conn_handle)
+#define ble_l2cap_coc_init() 0
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -22,6 +22,7 @@
 
 #include "host/ble_l2cap.h"
 #include <inttypes.h>
+#include "syscfg/syscfg.h"
 #include "stats/stats.h"
 #include "os/queue.h"
 #include "os/os_mbuf.h"
@@ -43,6 +44,17 @@ STATS_SECT_START(ble_l2cap_stats)
     STATS_SECT_ENTRY(sig_rx)
     STATS_SECT_ENTRY(sm_tx)
     STATS_SECT_ENTRY(sm_rx)
+    STATS_SECT_ENTRY(rx_sdu)
+    STATS_SECT_ENTRY(rx_sdu_mbufs)
+    STATS_SECT_ENTRY(rx_frag)
+    STATS_SECT_ENTRY(rx_reasm_nomem)
+    STATS_SECT_ENTRY(coc_connect)
+    STATS_SECT_ENTRY(coc_connect_fail)
+    STATS_SECT_ENTRY(coc_disconnect)
+    STATS_SECT_ENTRY(coc_rx_sdu)
+    STATS_SECT_ENTRY(coc_tx_sdu)
+    STATS_SECT_ENTRY(coc_tx_stall)
+    STATS_SECT_ENTRY(coc_credit_tx)
 STATS_SECT_END
 extern STATS_SECT_DECL(ble_l2cap_stats) ble_l2cap_stats;
 
@@ -61,6 +73,17 @@ extern struct os_mempool ble_l2cap_chan_pool;
 
 typedef uint8_t ble_l2cap_chan_flags;
 
+/** One direction of a connection oriented channel. */
+struct ble_l2cap_coc_endpoint {
+    struct os_mbuf *sdu;
+    uint16_t mtu;
+    uint16_t mps;
+    uint16_t credits;
+    uint16_t sdu_len;           /* Length of the SDU in progress. */
+    uint16_t data_len;          /* Bytes of it received or sent so far. */
+    uint8_t in_sdu;
+};
+
 typedef int ble_l2cap_rx_fn(uint16_t conn_handle, struct os_mbuf **rxom);
 
 struct ble_l2cap_chan {
@@ -75,6 +98,17 @@ struct ble_l2cap_chan {
     uint16_t blc_rx_len;        /* Length of current reassembled rx packet. */
 
     ble_l2cap_rx_fn *blc_rx_fn;
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+    /* Connection oriented channels only; blc_my_mtu is our MPS. */
+    uint16_t blc_conn_handle;
+    uint16_t blc_dcid;          /* The peer's CID. */
+    uint16_t blc_psm;
+    struct ble_l2cap_coc_endpoint blc_coc_rx;
+    struct ble_l2cap_coc_endpoint blc_coc_tx;
+    ble_l2cap_event_fn *blc_cb;
+    void *blc_cb_arg;
+#endif
 };
 
 struct ble_l2cap_hdr {
@@ -86,6 +120,11 @@ typedef int ble_l2cap_tx_fn(struct ble_hs_conn *conn,
                             struct ble_l2cap_chan *chan);
 
 #define BLE_L2CAP_CHAN_F_TXED_MTU       0x01    /* We have sent our MTU. */
+#define BLE_L2CAP_CHAN_F_RX_COPY        0x02    /* rx_buf is ours to fill. */
+#define BLE_L2CAP_CHAN_F_COC            0x04    /* Connection oriented. */
+#define BLE_L2CAP_CHAN_F_COC_OPEN       0x08    /* Connection established. */
+#define BLE_L2CAP_CHAN_F_COC_RXED       0x10    /* Holds an unprocessed PDU. */
+#define BLE_L2CAP_CHAN_F_COC_STALLED    0x20    /* Ran out of tx credits. */
 
 SLIST_HEAD(ble_l2cap_chan_list, ble_l2cap_chan);
 
@@ -55,12 +55,14 @@
 #define BLE_L2CAP_SIG_UNRESPONSIVE_TIMEOUT      30000   /* Milliseconds. */
 
 #define BLE_L2CAP_SIG_PROC_OP_UPDATE            0
-#define BLE_L2CAP_SIG_PROC_OP_MAX               1
+#define BLE_L2CAP_SIG_PROC_OP_CONNECT           1
+#define BLE_L2CAP_SIG_PROC_OP_DISCONNECT        2
+#define BLE_L2CAP_SIG_PROC_OP_MAX               3
 
 struct ble_l2cap_sig_proc {
     STAILQ_ENTRY(ble_l2cap_sig_proc) next;
 
-    uint32_t exp_os_ticks;
+    struct ble_hs_tmo tmo;
     uint16_t conn_handle;
     uint8_t op;
     uint8_t id;
@@ -70,6 +72,14 @@ struct ble_l2cap_sig_proc {
             ble_l2cap_sig_update_fn *cb;
             void *cb_arg;
         } update;
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+        struct {
+            struct ble_l2cap_chan *chan;
+        } connect;
+        struct {
+            struct ble_l2cap_chan *chan;
+        } disconnect;
+#endif
     };
 };
 
@@ -77,6 +87,9 @@ STAILQ_HEAD(ble_l2cap_sig_proc_list, ble_l2cap_sig_proc);
 
 static struct ble_l2cap_sig_proc_list ble_l2cap_sig_procs;
 
+/* Deadlines of the active procedures, soonest first. */
+static struct ble_hs_tmo_list ble_l2cap_sig_tmos;
+
 typedef int ble_l2cap_sig_rx_fn(uint16_t conn_handle,
                                 struct ble_l2cap_sig_hdr *hdr,
                                 struct os_mbuf **om);
@@ -85,11 +98,26 @@ static ble_l2cap_sig_rx_fn ble_l2cap_sig_rx_noop;
 static ble_l2cap_sig_rx_fn ble_l2cap_sig_update_req_rx;
 static ble_l2cap_sig_rx_fn ble_l2cap_sig_update_rsp_rx;
 
-static ble_l2cap_sig_rx_fn * const ble_l2cap_sig_dispatch[] = {
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+static ble_l2cap_sig_rx_fn ble_l2cap_sig_coc_req_rx;
+static ble_l2cap_sig_rx_fn ble_l2cap_sig_coc_rsp_rx;
+static ble_l2cap_sig_rx_fn ble_l2cap_sig_credit_rx;
+static ble_l2cap_sig_rx_fn ble_l2cap_sig_disconn_req_rx;
+static ble_l2cap_sig_rx_fn ble_l2cap_sig_disconn_rsp_rx;
+#else
+#define ble_l2cap_sig_coc_rsp_rx        ble_l2cap_sig_rx_noop
+#define ble_l2cap_sig_disconn_rsp_rx    ble_l2cap_sig_rx_noop
+#endif
+
+static ble_l2cap_sig_rx_fn * const
+ble_l2cap_sig_dispatch[BLE_L2CAP_SIG_OP_MAX] = {
     [BLE_L2CAP_SIG_OP_REJECT]               = ble_l2cap_sig_rx_noop,
     [BLE_L2CAP_SIG_OP_CONNECT_RSP]          = ble_l2cap_sig_rx_noop,
     [BLE_L2CAP_SIG_OP_CONFIG_RSP]           = ble_l2cap_sig_rx_noop,
-    [BLE_L2CAP_SIG_OP_DISCONN_RSP]          = ble_l2cap_sig_rx_noop,
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+    [BLE_L2CAP_SIG_OP_DISCONN_REQ]          = ble_l2cap_sig_disconn_req_rx,
+#endif
+    [BLE_L2CAP_SIG_OP_DISCONN_RSP]          = ble_l2cap_sig_disconn_rsp_rx,
     [BLE_L2CAP_SIG_OP_ECHO_RSP]             = ble_l2cap_sig_rx_noop,
     [BLE_L2CAP_SIG_OP_INFO_RSP]             = ble_l2cap_sig_rx_noop,
     [BLE_L2CAP_SIG_OP_CREATE_CHAN_RSP]      = ble_l2cap_sig_rx_noop,
@@ -97,7 +125,11 @@ static ble_l2cap_sig_rx_fn * const ble_l2cap_sig_dispatch[] = {
     [BLE_L2CAP_SIG_OP_MOVE_CHAN_CONF_RSP]   = ble_l2cap_sig_rx_noop,
     [BLE_L2CAP_SIG_OP_UPDATE_REQ]           = ble_l2cap_sig_update_req_rx,
     [BLE_L2CAP_SIG_OP_UPDATE_RSP]           = ble_l2cap_sig_update_rsp_rx,
-    [BLE_L2CAP_SIG_OP_CREDIT_CONNECT_RSP]   = ble_l2cap_sig_rx_noop,
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+    [BLE_L2CAP_SIG_OP_CREDIT_CONNECT_REQ]   = ble_l2cap_sig_coc_req_rx,
+    [BLE_L2CAP_SIG_OP_FLOW_CTRL_CREDIT]     = ble_l2cap_sig_credit_rx,
+#endif
+    [BLE_L2CAP_SIG_OP_CREDIT_CONNECT_RSP]   = ble_l2cap_sig_coc_rsp_rx,
 };
 
 static uint8_t ble_l2cap_sig_cur_id;
@@ -129,7 +161,7 @@ ble_l2cap_sig_dbg_assert_proc_not_inserted(struct ble_l2cap_sig_proc *proc)
  * $misc                                                                     *
  *****************************************************************************/
 
-static uint8_t
+uint8_t
 ble_l2cap_sig_next_id(void)
 {
     ble_l2cap_sig_cur_id++;
@@ -144,7 +176,7 @@ ble_l2cap_sig_next_id(void)
 static ble_l2cap_sig_rx_fn *
 ble_l2cap_sig_dispatch_get(uint8_t op)
 {
-    if (op > BLE_L2CAP_SIG_OP_MAX) {
+    if (op >= BLE_L2CAP_SIG_OP_MAX) {
         return NULL;
     }
 
@@ -192,6 +224,8 @@ ble_l2cap_sig_proc_insert(struct ble_l2cap_sig_proc *proc)
 
     ble_hs_lock();
     STAILQ_INSERT_HEAD(&ble_l2cap_sig_procs, proc, next);
+    ble_hs_tmo_insert(&ble_l2cap_sig_tmos, &proc->tmo,
+                      proc->tmo.bht_exp_ticks);
     ble_hs_unlock();
 }
 
@@ -255,8 +289,11 @@ ble_l2cap_sig_proc_extract(uint16_t conn_handle, uint8_t op,
             } else {
                 STAILQ_REMOVE_AFTER(&ble_l2cap_sig_procs, prev, next);
             }
+            ble_hs_tmo_remove(&ble_l2cap_sig_tmos, &proc->tmo);
             break;
         }
+
+        prev = proc;
     }
 
     ble_hs_unlock();
@@ -275,7 +312,8 @@ ble_l2cap_sig_rx_noop(uint16_t conn_handle,
 static void
 ble_l2cap_sig_proc_set_timer(struct ble_l2cap_sig_proc *proc)
 {
-    proc->exp_os_ticks = os_time_get() + BLE_L2CAP_SIG_UNRESPONSIVE_TIMEOUT;
+    proc->tmo.bht_exp_ticks =
+        os_time_get() + BLE_L2CAP_SIG_UNRESPONSIVE_TIMEOUT;
     ble_hs_timer_resched();
 }
 
@@ -475,6 +513,437 @@ done:
     return rc;
 }
 
+/*****************************************************************************
+ * $connection oriented channels                                             *
+ *****************************************************************************/
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+
+static int
+ble_l2cap_sig_coc_err(uint16_t l2cap_result)
+{
+    switch (l2cap_result) {
+    case BLE_L2CAP_SIG_COC_RSP_RESULT_SUCCESS:
+        return 0;
+    case BLE_L2CAP_COC_ERR_PSM_NOT_SUPP:
+        return BLE_HS_ENOTSUP;
+    case BLE_L2CAP_COC_ERR_NO_RESOURCES:
+        return BLE_HS_ENOMEM;
+    case BLE_L2CAP_COC_ERR_INVALID_SOURCE_CID:
+    case BLE_L2CAP_COC_ERR_SOURCE_CID_ALREADY_USED:
+    case BLE_L2CAP_COC_ERR_UNACCEPTABLE_PARAMETERS:
+        return BLE_HS_EINVAL;
+    default:
+        return BLE_HS_EREJECT;
+    }
+}
+
+static void
+ble_l2cap_sig_coc_set_peer(struct ble_l2cap_chan *chan, uint16_t cid,
+                           uint16_t mtu, uint16_t mps, uint16_t credits)
+{
+    chan->blc_dcid = cid;
+    chan->blc_peer_mtu = mtu;
+    chan->blc_coc_tx.mtu = mtu;
+    chan->blc_coc_tx.mps = mps;
+    chan->blc_coc_tx.credits = credits;
+    chan->blc_flags |= BLE_L2CAP_CHAN_F_COC_OPEN;
+}
+
+static int
+ble_l2cap_sig_coc_req_rx(uint16_t conn_handle,
+                         struct ble_l2cap_sig_hdr *hdr,
+                         struct os_mbuf **om)
+{
+    struct ble_l2cap_sig_coc_req req;
+    struct ble_l2cap_sig_coc_rsp rsp;
+    struct ble_l2cap_coc_srv *srv;
+    struct ble_l2cap_event event;
+    struct ble_l2cap_chan *chan;
+    struct ble_hs_conn *conn;
+    int rc;
+
+    rc = ble_hs_mbuf_pullup_base(om, BLE_L2CAP_SIG_COC_REQ_SZ);
+    if (rc != 0) {
+        return rc;
+    }
+
+    ble_l2cap_sig_coc_req_parse((*om)->om_data, (*om)->om_len, &req);
+
+    memset(&rsp, 0, sizeof rsp);
+    chan = NULL;
+
+    ble_hs_lock();
+
+    conn = ble_hs_conn_find(conn_handle);
+    srv = ble_l2cap_coc_srv_find(req.psm);
+    if (conn == NULL) {
+        ble_hs_unlock();
+        return BLE_HS_ENOTCONN;
+    }
+
+    if (srv == NULL) {
+        rsp.result = BLE_L2CAP_COC_ERR_PSM_NOT_SUPP;
+    } else if (req.mtu < BLE_L2CAP_COC_MTU_MIN ||
+               req.mps < BLE_L2CAP_COC_MTU_MIN) {
+        rsp.result = BLE_L2CAP_COC_ERR_UNACCEPTABLE_PARAMETERS;
+    } else if (req.scid < BLE_L2CAP_COC_CID_START ||
+               req.scid > BLE_L2CAP_COC_CID_END) {
+        rsp.result = BLE_L2CAP_COC_ERR_INVALID_SOURCE_CID;
+    } else if (ble_l2cap_coc_chan_find_peer(conn, req.scid) != NULL) {
+        rsp.result = BLE_L2CAP_COC_ERR_SOURCE_CID_ALREADY_USED;
+    } else {
+        chan = ble_l2cap_coc_chan_alloc(conn, req.psm, srv->mtu, NULL,
+                                        srv->cb, srv->cb_arg);
+        if (chan == NULL) {
+            rsp.result = BLE_L2CAP_COC_ERR_NO_RESOURCES;
+        } else {
+            ble_l2cap_sig_coc_set_peer(chan, req.scid, req.mtu, req.mps,
+                                       req.credits);
+            chan->blc_flags &= ~BLE_L2CAP_CHAN_F_COC_OPEN;
+            ble_hs_conn_chan_insert(conn, chan);
+        }
+    }
+
+    ble_hs_unlock();
+
+    if (chan != NULL) {
+        /* Let the server decide, and supply a receive buffer. */
+        memset(&event, 0, sizeof event);
+        event.type = BLE_L2CAP_EVENT_COC_ACCEPT;
+        event.accept.peer_sdu_size = req.mtu;
+        rc = ble_l2cap_coc_call_cb(chan, &event);
+        if (rc != 0) {
+            ble_l2cap_coc_chan_delete(chan);
+            chan = NULL;
+            rsp.result = BLE_L2CAP_COC_ERR_NO_RESOURCES;
+        }
+    }
+
+    if (chan != NULL) {
+        rsp.dcid = chan->blc_cid;
+        rsp.mtu = chan->blc_coc_rx.mtu;
+        rsp.mps = chan->blc_coc_rx.mps;
+        rsp.credits = chan->blc_coc_rx.credits;
+        chan->blc_flags |= BLE_L2CAP_CHAN_F_COC_OPEN;
+    }
+
+    rc = ble_l2cap_sig_coc_rsp_tx(conn_handle, hdr->identifier, &rsp);
+    if (chan != NULL) {
+        if (rc != 0) {
+            ble_l2cap_coc_chan_delete(chan);
+        } else {
+            ble_l2cap_coc_connected(chan, 0);
+        }
+    }
+
+    return rc;
+}
+
+static int
+ble_l2cap_sig_coc_rsp_rx(uint16_t conn_handle,
+                         struct ble_l2cap_sig_hdr *hdr,
+                         struct os_mbuf **om)
+{
+    struct ble_l2cap_sig_coc_rsp rsp;
+    struct ble_l2cap_sig_proc *proc;
+    struct ble_l2cap_chan *chan;
+    int cb_status;
+    int rc;
+
+    proc = ble_l2cap_sig_proc_extract(conn_handle,
+                                      BLE_L2CAP_SIG_PROC_OP_CONNECT,
+                                      hdr->identifier);
+    if (proc == NULL) {
+        return BLE_HS_ENOENT;
+    }
+    chan = proc->connect.chan;
+
+    rc = ble_hs_mbuf_pullup_base(om, BLE_L2CAP_SIG_COC_RSP_SZ);
+    if (rc != 0) {
+        cb_status = rc;
+        goto done;
+    }
+
+    ble_l2cap_sig_coc_rsp_parse((*om)->om_data, (*om)->om_len, &rsp);
+
+    cb_status = ble_l2cap_sig_coc_err(rsp.result);
+    if (cb_status == 0 &&
+        (rsp.mtu < BLE_L2CAP_COC_MTU_MIN || rsp.mps < BLE_L2CAP_COC_MTU_MIN ||
+         rsp.dcid < BLE_L2CAP_COC_CID_START ||
+         rsp.dcid > BLE_L2CAP_COC_CID_END)) {
+
+        cb_status = BLE_HS_EBADDATA;
+        rc = BLE_HS_EBADDATA;
+    }
+
+    if (cb_status == 0) {
+        ble_hs_lock();
+        ble_l2cap_sig_coc_set_peer(chan, rsp.dcid, rsp.mtu, rsp.mps,
+                                   rsp.credits);
+        ble_hs_unlock();
+    }
+
+done:
+    ble_l2cap_coc_connected(chan, cb_status);
+    if (cb_status != 0) {
+        ble_l2cap_coc_chan_delete(chan);
+    }
+    ble_l2cap_sig_proc_free(proc);
+    return rc;
+}
+
+static int
+ble_l2cap_sig_credit_rx(uint16_t conn_handle,
+                        struct ble_l2cap_sig_hdr *hdr,
+                        struct os_mbuf **om)
+{
+    struct ble_l2cap_sig_credit cmd;
+    int rc;
+
+    rc = ble_hs_mbuf_pullup_base(om, BLE_L2CAP_SIG_CREDIT_SZ);
+    if (rc != 0) {
+        return rc;
+    }
+
+    ble_l2cap_sig_credit_parse((*om)->om_data, (*om)->om_len, &cmd);
+    ble_l2cap_coc_credits_rx(conn_handle, cmd.cid, cmd.credits);
+
+    return 0;
+}
+
+static int
+ble_l2cap_sig_disconn_req_rx(uint16_t conn_handle,
+                             struct ble_l2cap_sig_hdr *hdr,
+                             struct os_mbuf **om)
+{
+    struct ble_l2cap_sig_disconn_req req;
+    struct ble_l2cap_sig_disconn_rsp rsp;
+    struct ble_l2cap_chan *chan;
+    struct ble_hs_conn *conn;
+    int was_open;
+    int rc;
+
+    rc = ble_hs_mbuf_pullup_base(om, BLE_L2CAP_SIG_DISCONN_REQ_SZ);
+    if (rc != 0) {
+        return rc;
+    }
+
+    ble_l2cap_sig_disconn_req_parse((*om)->om_data, (*om)->om_len, &req);
+
+    was_open = 0;
+
+    ble_hs_lock();
+    conn = ble_hs_conn_find(conn_handle);
+    chan = conn != NULL ? ble_hs_conn_chan_find(conn, req.dcid) : NULL;
+    if (chan != NULL &&
+        (!(chan->blc_flags & BLE_L2CAP_CHAN_F_COC) ||
+         chan->blc_dcid != req.scid)) {
+
+        chan = NULL;
+    }
+    if (chan != NULL) {
+        /* If we are disconnecting already, our own request finishes the
+         * job when the peer answers it.
+         */
+        was_open = chan->blc_flags & BLE_L2CAP_CHAN_F_COC_OPEN;
+        chan->blc_flags &= ~BLE_L2CAP_CHAN_F_COC_OPEN;
+    }
+    ble_hs_unlock();
+
+    if (chan == NULL) {
+        ble_l2cap_sig_reject_invalid_cid_tx(conn_handle, hdr->identifier,
+                                            req.scid, req.dcid);
+        return BLE_HS_L2C_ERR(BLE_L2CAP_SIG_ERR_INVALID_CID);
+    }
+
+    rsp.dcid = req.dcid;
+    rsp.scid = req.scid;
+    rc = ble_l2cap_sig_disconn_rsp_tx(conn_handle, hdr->identifier, &rsp);
+
+    if (was_open) {
+        ble_l2cap_coc_disconnected(chan);
+        ble_l2cap_coc_chan_delete(chan);
+    }
+
+    return rc;
+}
+
+static int
+ble_l2cap_sig_disconn_rsp_rx(uint16_t conn_handle,
+                             struct ble_l2cap_sig_hdr *hdr,
+                             struct os_mbuf **om)
+{
+    struct ble_l2cap_sig_proc *proc;
+    struct ble_l2cap_chan *chan;
+
+    proc = ble_l2cap_sig_proc_extract(conn_handle,
+                                      BLE_L2CAP_SIG_PROC_OP_DISCONNECT,
+                                      hdr->identifier);
+    if (proc == NULL) {
+        return BLE_HS_ENOENT;
+    }
+    chan = proc->disconnect.chan;
+
+    ble_l2cap_coc_disconnected(chan);
+    ble_l2cap_coc_chan_delete(chan);
+    ble_l2cap_sig_proc_free(proc);
+
+    return 0;
+}
+
+int
+ble_l2cap_sig_coc_connect(uint16_t conn_handle, uint16_t psm, uint16_t mtu,
+                          struct os_mbuf *sdu_rx,
+                          ble_l2cap_event_fn *cb, void *cb_arg)
+{
+    struct ble_l2cap_sig_coc_req req;
+    struct ble_l2cap_sig_proc *proc;
+    struct ble_l2cap_chan *chan;
+    struct ble_hs_conn *conn;
+    int rc;
+
+    chan = NULL;
+
+    if (mtu < BLE_L2CAP_COC_MTU_MIN || cb == NULL) {
+        rc = BLE_HS_EINVAL;
+        goto err;
+    }
+
+    proc = ble_l2cap_sig_proc_alloc();
+    if (proc == NULL) {
+        rc = BLE_HS_ENOMEM;
+        goto err;
+    }
+
+    ble_hs_lock();
+    conn = ble_hs_conn_find(conn_handle);
+    if (conn == NULL) {
+        rc = BLE_HS_ENOTCONN;
+    } else {
+        chan = ble_l2cap_coc_chan_alloc(conn, psm, mtu, sdu_rx, cb, cb_arg);
+        if (chan == NULL) {
+            rc = BLE_HS_ENOMEM;
+        } else {
+            ble_hs_conn_chan_insert(conn, chan);
+            rc = 0;
+        }
+    }
+    ble_hs_unlock();
+
+    if (rc != 0) {
+        ble_l2cap_sig_proc_free(proc);
+        goto err;
+    }
+
+    proc->op = BLE_L2CAP_SIG_PROC_OP_CONNECT;
+    proc->id = ble_l2cap_sig_next_id();
+    proc->conn_handle = conn_handle;
+    proc->connect.chan = chan;
+
+    req.psm = psm;
+    req.scid = chan->blc_cid;
+    req.mtu = chan->blc_coc_rx.mtu;
+    req.mps = chan->blc_coc_rx.mps;
+    req.credits = chan->blc_coc_rx.credits;
+
+    rc = ble_l2cap_sig_coc_req_tx(conn_handle, proc->id, &req);
+    if (rc != 0) {
+        /* The channel owns sdu_rx now, and frees it. */
+        ble_l2cap_coc_chan_delete(chan);
+    }
+
+    ble_l2cap_sig_process_status(proc, rc);
+    return rc;
+
+err:
+    os_mbuf_free_chain(sdu_rx);
+    return rc;
+}
+
+int
+ble_l2cap_sig_coc_disconnect(struct ble_l2cap_chan *chan)
+{
+    struct ble_l2cap_sig_disconn_req req;
+    struct ble_l2cap_sig_proc *proc;
+    uint16_t conn_handle;
+    int rc;
+
+    ble_hs_lock();
+    rc = ble_l2cap_coc_chan_valid(chan, NULL);
+    if (rc == 0 && !(chan->blc_flags & BLE_L2CAP_CHAN_F_COC_OPEN)) {
+        rc = BLE_HS_EALREADY;
+    }
+    if (rc == 0) {
+        conn_handle = chan->blc_conn_handle;
+        req.dcid = chan->blc_dcid;
+        req.scid = chan->blc_cid;
+    }
+    ble_hs_unlock();
+
+    if (rc != 0) {
+        return rc;
+    }
+
+    proc = ble_l2cap_sig_proc_alloc();
+    if (proc == NULL) {
+        return BLE_HS_ENOMEM;
+    }
+
+    proc->op = BLE_L2CAP_SIG_PROC_OP_DISCONNECT;
+    proc->id = ble_l2cap_sig_next_id();
+    proc->conn_handle = conn_handle;
+    proc->disconnect.chan = chan;
+
+    rc = ble_l2cap_sig_disconn_req_tx(conn_handle, proc->id, &req);
+    if (rc == 0) {
+        /* No more data in either direction. */
+        ble_hs_lock();
+        chan->blc_flags &= ~BLE_L2CAP_CHAN_F_COC_OPEN;
+        ble_hs_unlock();
+    }
+
+    ble_l2cap_sig_process_status(proc, rc);
+    return rc;
+}
+
+#endif
+
+/**
+ * Reports the failure of a procedure that is not going to complete.
+ */
+static void
+ble_l2cap_sig_proc_fail(struct ble_l2cap_sig_proc *proc, int status,
+                        int conn_broken)
+{
+    switch (proc->op) {
+    case BLE_L2CAP_SIG_PROC_OP_UPDATE:
+        ble_l2cap_sig_update_call_cb(proc, status);
+        break;
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+    case BLE_L2CAP_SIG_PROC_OP_CONNECT:
+        ble_l2cap_coc_connected(proc->connect.chan, status);
+        if (!conn_broken) {
+            ble_l2cap_coc_chan_delete(proc->connect.chan);
+        }
+        break;
+
+    case BLE_L2CAP_SIG_PROC_OP_DISCONNECT:
+        /* The channel is gone either way. */
+        ble_l2cap_coc_disconnected(proc->disconnect.chan);
+        if (!conn_broken) {
+            ble_l2cap_coc_chan_delete(proc->disconnect.chan);
+        }
+        break;
+#endif
+
+    default:
+        BLE_HS_DBG_ASSERT(0);
+        break;
+    }
+}
+
 static int
 ble_l2cap_sig_rx(uint16_t conn_handle, struct os_mbuf **om)
 {
@@ -540,43 +1009,27 @@ static int32_t
 ble_l2cap_sig_extract_expired(struct ble_l2cap_sig_proc_list *dst_list)
 {
     struct ble_l2cap_sig_proc *proc;
-    struct ble_l2cap_sig_proc *prev;
-    struct ble_l2cap_sig_proc *next;
+    struct ble_hs_tmo *tmo;
     uint32_t now;
     int32_t next_exp_in;
-    int32_t time_diff;
 
     now = os_time_get();
     STAILQ_INIT(dst_list);
 
-    /* Assume each event is either expired or has infinite duration. */
-    next_exp_in = BLE_HS_FOREVER;
-
     ble_hs_lock();
 
-    prev = NULL;
-    proc = STAILQ_FIRST(&ble_l2cap_sig_procs);
-    while (proc != NULL) {
-        next = STAILQ_NEXT(proc, next);
-    
-        time_diff = proc->exp_os_ticks - now;
-        if (time_diff <= 0) {
-            /* Procedure has expired; move it to the destination list. */
-            if (prev == NULL) {
-                STAILQ_REMOVE_HEAD(&ble_l2cap_sig_procs, next);
-            } else {
-                STAILQ_REMOVE_AFTER(&ble_l2cap_sig_procs, prev, next);
-            }
-            STAILQ_INSERT_TAIL(dst_list, proc, next);
-        } else {
-            if (time_diff < next_exp_in) {
-                next_exp_in = time_diff;
-            }
-        }
+    /* Deadlines are sorted; only the procedures that are due get visited. */
+    while ((tmo = ble_hs_tmo_first_expired(&ble_l2cap_sig_tmos,
+                                           now)) != NULL) {
+        ble_hs_tmo_remove(&ble_l2cap_sig_tmos, tmo);
 
-        proc = next;
+        proc = BLE_HS_TMO_CONTAINER(tmo, struct ble_l2cap_sig_proc, tmo);
+        STAILQ_REMOVE(&ble_l2cap_sig_procs, proc, ble_l2cap_sig_proc, next);
+        STAILQ_INSERT_TAIL(dst_list, proc, next);
     }
 
+    next_exp_in = ble_hs_tmo_ticks_until_exp(&ble_l2cap_sig_tmos, now);
+
     ble_hs_unlock();
 
     return next_exp_in;
@@ -586,18 +1039,22 @@ void
 ble_l2cap_sig_conn_broken(uint16_t conn_handle, int reason)
 {
     struct ble_l2cap_sig_proc *proc;
+    int op;
 
-    /* If there was a connection update in progress, indicate to the
-     * application that it did not complete.
+    /* Indicate to the application that none of the connection's procedures
+     * (e.g., a connection update) will complete.  Its channels are freed
+     * along with the connection.
      */
+    for (op = 0; op < BLE_L2CAP_SIG_PROC_OP_MAX; op++) {
+        while ((proc = ble_l2cap_sig_proc_extract(conn_handle, op, 0)) !=
+               NULL) {
 
-    proc = ble_l2cap_sig_proc_extract(conn_handle,
-                                      BLE_L2CAP_SIG_PROC_OP_UPDATE, 0);
-
-    if (proc != NULL) {
-        ble_l2cap_sig_update_call_cb(proc, reason);
-        ble_l2cap_sig_proc_free(proc);
+            ble_l2cap_sig_proc_fail(proc, reason, 1);
+            ble_l2cap_sig_proc_free(proc);
+        }
     }
+
+    ble_l2cap_coc_conn_broken(conn_handle);
 }
 
 /**
@@ -622,7 +1079,7 @@ ble_l2cap_sig_timer(void)
     /* Report a failure for each timed out procedure. */
     while ((proc = STAILQ_FIRST(&temp_list)) != NULL) {
         STATS_INC(ble_l2cap_stats, proc_timeout);
-        ble_l2cap_sig_update_call_cb(proc, BLE_HS_ETIMEOUT);
+        ble_l2cap_sig_proc_fail(proc, BLE_HS_ETIMEOUT, 0);
 
         STAILQ_REMOVE_HEAD(&temp_list, next);
         ble_l2cap_sig_proc_free(proc);
@@ -637,6 +1094,7 @@ ble_l2cap_sig_init(void)
     int rc;
 
     STAILQ_INIT(&ble_l2cap_sig_procs);
+    TAILQ_INIT(&ble_l2cap_sig_tmos);
 
     rc = os_mempool_init(&ble_l2cap_sig_proc_pool,
                          MYNEWT_VAL(BLE_L2CAP_SIG_MAX_PROCS),
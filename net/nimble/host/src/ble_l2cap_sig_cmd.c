@@ -273,3 +273,197 @@ ble_l2cap_sig_update_rsp_tx(uint16_t conn_handle, uint8_t id, uint16_t result)
 
     return 0;
 }
+
+static void
+ble_l2cap_sig_disconn_req_swap(struct ble_l2cap_sig_disconn_req *dst,
+                               struct ble_l2cap_sig_disconn_req *src)
+{
+    dst->dcid = TOFROMLE16(src->dcid);
+    dst->scid = TOFROMLE16(src->scid);
+}
+
+void
+ble_l2cap_sig_disconn_req_parse(void *payload, int len,
+                                struct ble_l2cap_sig_disconn_req *dst)
+{
+    BLE_HS_DBG_ASSERT(len >= BLE_L2CAP_SIG_DISCONN_REQ_SZ);
+    ble_l2cap_sig_disconn_req_swap(dst, payload);
+}
+
+int
+ble_l2cap_sig_disconn_req_tx(uint16_t conn_handle, uint8_t id,
+                             struct ble_l2cap_sig_disconn_req *req)
+{
+    struct os_mbuf *txom;
+    void *payload_buf;
+    int rc;
+
+    rc = ble_l2cap_sig_init_cmd(BLE_L2CAP_SIG_OP_DISCONN_REQ, id,
+                                BLE_L2CAP_SIG_DISCONN_REQ_SZ, &txom,
+                                &payload_buf);
+    if (rc != 0) {
+        return rc;
+    }
+
+    ble_l2cap_sig_disconn_req_swap(payload_buf, req);
+
+    return ble_l2cap_sig_tx(conn_handle, txom);
+}
+
+static void
+ble_l2cap_sig_disconn_rsp_swap(struct ble_l2cap_sig_disconn_rsp *dst,
+                               struct ble_l2cap_sig_disconn_rsp *src)
+{
+    dst->dcid = TOFROMLE16(src->dcid);
+    dst->scid = TOFROMLE16(src->scid);
+}
+
+void
+ble_l2cap_sig_disconn_rsp_parse(void *payload, int len,
+                                struct ble_l2cap_sig_disconn_rsp *dst)
+{
+    BLE_HS_DBG_ASSERT(len >= BLE_L2CAP_SIG_DISCONN_RSP_SZ);
+    ble_l2cap_sig_disconn_rsp_swap(dst, payload);
+}
+
+int
+ble_l2cap_sig_disconn_rsp_tx(uint16_t conn_handle, uint8_t id,
+                             struct ble_l2cap_sig_disconn_rsp *rsp)
+{
+    struct os_mbuf *txom;
+    void *payload_buf;
+    int rc;
+
+    rc = ble_l2cap_sig_init_cmd(BLE_L2CAP_SIG_OP_DISCONN_RSP, id,
+                                BLE_L2CAP_SIG_DISCONN_RSP_SZ, &txom,
+                                &payload_buf);
+    if (rc != 0) {
+        return rc;
+    }
+
+    ble_l2cap_sig_disconn_rsp_swap(payload_buf, rsp);
+
+    return ble_l2cap_sig_tx(conn_handle, txom);
+}
+
+static void
+ble_l2cap_sig_coc_req_swap(struct ble_l2cap_sig_coc_req *dst,
+                           struct ble_l2cap_sig_coc_req *src)
+{
+    dst->psm = TOFROMLE16(src->psm);
+    dst->scid = TOFROMLE16(src->scid);
+    dst->mtu = TOFROMLE16(src->mtu);
+    dst->mps = TOFROMLE16(src->mps);
+    dst->credits = TOFROMLE16(src->credits);
+}
+
+void
+ble_l2cap_sig_coc_req_parse(void *payload, int len,
+                            struct ble_l2cap_sig_coc_req *dst)
+{
+    BLE_HS_DBG_ASSERT(len >= BLE_L2CAP_SIG_COC_REQ_SZ);
+    ble_l2cap_sig_coc_req_swap(dst, payload);
+}
+
+int
+ble_l2cap_sig_coc_req_tx(uint16_t conn_handle, uint8_t id,
+                         struct ble_l2cap_sig_coc_req *req)
+{
+    struct os_mbuf *txom;
+    void *payload_buf;
+    int rc;
+
+    rc = ble_l2cap_sig_init_cmd(BLE_L2CAP_SIG_OP_CREDIT_CONNECT_REQ, id,
+                                BLE_L2CAP_SIG_COC_REQ_SZ, &txom,
+                                &payload_buf);
+    if (rc != 0) {
+        return rc;
+    }
+
+    ble_l2cap_sig_coc_req_swap(payload_buf, req);
+
+    return ble_l2cap_sig_tx(conn_handle, txom);
+}
+
+static void
+ble_l2cap_sig_coc_rsp_swap(struct ble_l2cap_sig_coc_rsp *dst,
+                           struct ble_l2cap_sig_coc_rsp *src)
+{
+    dst->dcid = TOFROMLE16(src->dcid);
+    dst->mtu = TOFROMLE16(src->mtu);
+    dst->mps = TOFROMLE16(src->mps);
+    dst->credits = TOFROMLE16(src->credits);
+    dst->result = TOFROMLE16(src->result);
+}
+
+void
+ble_l2cap_sig_coc_rsp_parse(void *payload, int len,
+                            struct ble_l2cap_sig_coc_rsp *dst)
+{
+    BLE_HS_DBG_ASSERT(len >= BLE_L2CAP_SIG_COC_RSP_SZ);
+    ble_l2cap_sig_coc_rsp_swap(dst, payload);
+}
+
+int
+ble_l2cap_sig_coc_rsp_tx(uint16_t conn_handle, uint8_t id,
+                         struct ble_l2cap_sig_coc_rsp *rsp)
+{
+    struct os_mbuf *txom;
+    void *payload_buf;
+    int rc;
+
+    rc = ble_l2cap_sig_init_cmd(BLE_L2CAP_SIG_OP_CREDIT_CONNECT_RSP, id,
+                                BLE_L2CAP_SIG_COC_RSP_SZ, &txom,
+                                &payload_buf);
+    if (rc != 0) {
+        return rc;
+    }
+
+    ble_l2cap_sig_coc_rsp_swap(payload_buf, rsp);
+
+    return ble_l2cap_sig_tx(conn_handle, txom);
+}
+
+static void
+ble_l2cap_sig_credit_swap(struct ble_l2cap_sig_credit *dst,
+                          struct ble_l2cap_sig_credit *src)
+{
+    dst->cid = TOFROMLE16(src->cid);
+    dst->credits = TOFROMLE16(src->credits);
+}
+
+void
+ble_l2cap_sig_credit_parse(void *payload, int len,
+                           struct ble_l2cap_sig_credit *dst)
+{
+    BLE_HS_DBG_ASSERT(len >= BLE_L2CAP_SIG_CREDIT_SZ);
+    ble_l2cap_sig_credit_swap(dst, payload);
+}
+
+/**
+ * Gives the peer more credits on a channel.
+ *
+ * @param cid                   Our CID of the channel.
+ */
+int
+ble_l2cap_sig_credit_tx(uint16_t conn_handle, uint16_t cid, uint16_t credits)
+{
+    struct ble_l2cap_sig_credit cmd;
+    struct os_mbuf *txom;
+    void *payload_buf;
+    int rc;
+
+    /* Nothing answers a credit packet, but its identifier must be nonzero. */
+    rc = ble_l2cap_sig_init_cmd(BLE_L2CAP_SIG_OP_FLOW_CTRL_CREDIT,
+                                ble_l2cap_sig_next_id(),
+                                BLE_L2CAP_SIG_CREDIT_SZ, &txom, &payload_buf);
+    if (rc != 0) {
+        return rc;
+    }
+
+    cmd.cid = cid;
+    cmd.credits = credits;
+    ble_l2cap_sig_credit_swap(payload_buf, &cmd);
+
+    return ble_l2cap_sig_tx(conn_handle, txom);
+}
@@ -54,6 +54,45 @@ struct ble_l2cap_sig_update_rsp {
 #define BLE_L2CAP_SIG_UPDATE_RSP_RESULT_ACCEPT  0x0000
 #define BLE_L2CAP_SIG_UPDATE_RSP_RESULT_REJECT  0x0001
 
+#define BLE_L2CAP_SIG_DISCONN_REQ_SZ        4
+struct ble_l2cap_sig_disconn_req {
+    uint16_t dcid;
+    uint16_t scid;
+} __attribute__((packed));
+
+#define BLE_L2CAP_SIG_DISCONN_RSP_SZ        4
+struct ble_l2cap_sig_disconn_rsp {
+    uint16_t dcid;
+    uint16_t scid;
+} __attribute__((packed));
+
+#define BLE_L2CAP_SIG_COC_REQ_SZ            10
+struct ble_l2cap_sig_coc_req {
+    uint16_t psm;
+    uint16_t scid;
+    uint16_t mtu;
+    uint16_t mps;
+    uint16_t credits;
+} __attribute__((packed));
+
+#define BLE_L2CAP_SIG_COC_RSP_SZ            10
+struct ble_l2cap_sig_coc_rsp {
+    uint16_t dcid;
+    uint16_t mtu;
+    uint16_t mps;
+    uint16_t credits;
+    uint16_t result;
+} __attribute__((packed));
+
+#define BLE_L2CAP_SIG_COC_RSP_RESULT_SUCCESS    0x0000
+
+#define BLE_L2CAP_SIG_CREDIT_SZ             4
+struct ble_l2cap_sig_credit {
+    uint16_t cid;
+    uint16_t credits;
+} __attribute__((packed));
+
+uint8_t ble_l2cap_sig_next_id(void);
 int ble_l2cap_sig_init_cmd(uint8_t op, uint8_t id, uint8_t payload_len,
                            struct os_mbuf **out_om, void **out_payload_buf);
 void ble_l2cap_sig_hdr_parse(void *payload, uint16_t len,
@@ -79,6 +118,34 @@ int ble_l2cap_sig_update_rsp_tx(uint16_t conn_handle, uint8_t id,
 int ble_l2cap_sig_reject_invalid_cid_tx(uint16_t conn_handle, uint8_t id,
                                         uint16_t src_cid, uint16_t dst_cid);
 
+void ble_l2cap_sig_disconn_req_parse(void *payload, int len,
+                                     struct ble_l2cap_sig_disconn_req *dst);
+int ble_l2cap_sig_disconn_req_tx(uint16_t conn_handle, uint8_t id,
+                                 struct ble_l2cap_sig_disconn_req *req);
+void ble_l2cap_sig_disconn_rsp_parse(void *payload, int len,
+                                     struct ble_l2cap_sig_disconn_rsp *dst);
+int ble_l2cap_sig_disconn_rsp_tx(uint16_t conn_handle, uint8_t id,
+                                 struct ble_l2cap_sig_disconn_rsp *rsp);
+void ble_l2cap_sig_coc_req_parse(void *payload, int len,
+                                 struct ble_l2cap_sig_coc_req *dst);
+int ble_l2cap_sig_coc_req_tx(uint16_t conn_handle, uint8_t id,
+                             struct ble_l2cap_sig_coc_req *req);
+void ble_l2cap_sig_coc_rsp_parse(void *payload, int len,
+                                 struct ble_l2cap_sig_coc_rsp *dst);
+int ble_l2cap_sig_coc_rsp_tx(uint16_t conn_handle, uint8_t id,
+                             struct ble_l2cap_sig_coc_rsp *rsp);
+void ble_l2cap_sig_credit_parse(void *payload, int len,
+                                struct ble_l2cap_sig_credit *dst);
+int ble_l2cap_sig_credit_tx(uint16_t conn_handle, uint16_t cid,
+                            uint16_t credits);
+
+#if MYNEWT_VAL(BLE_L2CAP_COC_MAX_NUM) != 0
+int ble_l2cap_sig_coc_connect(uint16_t conn_handle, uint16_t psm,
+                              uint16_t mtu, struct os_mbuf *sdu_rx,
+                              ble_l2cap_event_fn *cb, void *cb_arg);
+int ble_l2cap_sig_coc_disconnect(struct ble_l2cap_chan *chan);
+#endif
+
 void ble_l2cap_sig_conn_broken(uint16_t conn_handle, int reason);
 int32_t ble_l2cap_sig_timer(void);
 struct ble_l2cap_chan *ble_l2cap_sig_create_chan(void);
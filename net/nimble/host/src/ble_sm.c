@@ -137,6 +137,9 @@ static struct os_mempool ble_sm_proc_pool;
 /* Maintains the list of active security manager procedures. */
 static struct ble_sm_proc_list ble_sm_procs;
 
+/* Deadlines of the active procedures, soonest first. */
+static struct ble_hs_tmo_list ble_sm_tmos;
+
 static void ble_sm_pair_cfg(struct ble_sm_proc *proc);
 
 
@@ -348,7 +351,8 @@ static void
 ble_sm_proc_set_timer(struct ble_sm_proc *proc)
 {
     /* Set a timeout of 30 seconds. */
-    proc->exp_os_ticks = os_time_get() + BLE_SM_TIMEOUT_OS_TICKS;
+    ble_hs_tmo_update(&ble_sm_tmos, &proc->tmo,
+                      os_time_get() + BLE_SM_TIMEOUT_OS_TICKS);
     ble_hs_timer_resched();
 }
 
@@ -407,6 +411,7 @@ ble_sm_proc_remove(struct ble_sm_proc *proc,
         BLE_HS_DBG_ASSERT(STAILQ_NEXT(prev, next) == proc);
         STAILQ_REMOVE_AFTER(&ble_sm_procs, prev, next);
     }
+    ble_hs_tmo_remove(&ble_sm_tmos, &proc->tmo);
 
     ble_sm_dbg_assert_no_cycles();
 }
@@ -600,50 +605,33 @@ ble_sm_insert(struct ble_sm_proc *proc)
 #endif
 
     STAILQ_INSERT_HEAD(&ble_sm_procs, proc, next);
+    ble_hs_tmo_insert(&ble_sm_tmos, &proc->tmo, proc->tmo.bht_exp_ticks);
 }
 
 static int32_t
 ble_sm_extract_expired(struct ble_sm_proc_list *dst_list)
 {
     struct ble_sm_proc *proc;
-    struct ble_sm_proc *prev;
-    struct ble_sm_proc *next;
+    struct ble_hs_tmo *tmo;
     uint32_t now;
     int32_t next_exp_in;
-    int32_t time_diff;
 
     now = os_time_get();
     STAILQ_INIT(dst_list);
 
-    /* Assume each event is either expired or has infinite duration. */
-    next_exp_in = BLE_HS_FOREVER;
-
     ble_hs_lock();
 
-    prev = NULL;
-    proc = STAILQ_FIRST(&ble_sm_procs);
-    while (proc != NULL) {
-        next = STAILQ_NEXT(proc, next);
-
-        time_diff = proc->exp_os_ticks - now;
-        if (time_diff <= 0) {
-            /* Procedure has expired; move it to the destination list. */
-            if (prev == NULL) {
-                STAILQ_REMOVE_HEAD(&ble_sm_procs, next);
-            } else {
-                STAILQ_REMOVE_AFTER(&ble_sm_procs, prev, next);
-            }
-            STAILQ_INSERT_HEAD(dst_list, proc, next);
-        } else {
-            if (time_diff < next_exp_in) {
-                next_exp_in = time_diff;
-            }
-        }
+    /* Deadlines are sorted; only the procedures that are due get visited. */
+    while ((tmo = ble_hs_tmo_first_expired(&ble_sm_tmos, now)) != NULL) {
+        ble_hs_tmo_remove(&ble_sm_tmos, tmo);
 
-        prev = proc;
-        proc = next;
+        proc = BLE_HS_TMO_CONTAINER(tmo, struct ble_sm_proc, tmo);
+        STAILQ_REMOVE(&ble_sm_procs, proc, ble_sm_proc, next);
+        STAILQ_INSERT_HEAD(dst_list, proc, next);
     }
 
+    next_exp_in = ble_hs_tmo_ticks_until_exp(&ble_sm_tmos, now);
+
     ble_sm_dbg_assert_no_cycles();
 
     ble_hs_unlock();
@@ -2315,6 +2303,7 @@ ble_sm_init(void)
     int rc;
 
     STAILQ_INIT(&ble_sm_procs);
+    TAILQ_INIT(&ble_sm_tmos);
 
     rc = os_mempool_init(&ble_sm_proc_pool,
                          MYNEWT_VAL(BLE_SM_MAX_PROCS),
@@ -2325,7 +2314,10 @@ ble_sm_init(void)
         return rc;
     }
 
-    ble_sm_sc_init();
+    rc = ble_sm_sc_init();
+    if (rc != 0) {
+        return rc;
+    }
 
     return 0;
 }
@@ -24,6 +24,7 @@
 #include "syscfg/syscfg.h"
 #include "os/queue.h"
 #include "nimble/nimble_opt.h"
+#include "ble_hs_tmo_priv.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -224,6 +225,9 @@ struct ble_sm_dhkey_check {
 #define BLE_SM_PROC_F_AUTHENTICATED         0x08
 #define BLE_SM_PROC_F_SC                    0x10
 #define BLE_SM_PROC_F_BONDING               0x20
+#define BLE_SM_PROC_F_DHKEY_PENDING         0x40
+#define BLE_SM_PROC_F_DHKEY_WAIT            0x80
+#define BLE_SM_PROC_F_SC_KEY                0x100
 
 #define BLE_SM_KE_F_ENC_INFO                0x01
 #define BLE_SM_KE_F_MASTER_ID               0x02
@@ -231,7 +235,7 @@ struct ble_sm_dhkey_check {
 #define BLE_SM_KE_F_ADDR_INFO               0x08
 #define BLE_SM_KE_F_SIGN_INFO               0x10
 
-typedef uint8_t ble_sm_proc_flags;
+typedef uint16_t ble_sm_proc_flags;
 
 struct ble_sm_keys {
     unsigned ltk_valid:1;
@@ -248,10 +252,26 @@ struct ble_sm_keys {
     uint8_t addr[6];    /* Little endian. */
 };
 
+/**
+ * An LE Secure Connections P-256 key pair.  Some crypto functions accept
+ * pointers to uint32_t; others accept pointers to uint8_t.  The use of unions
+ * ensures the keys are properly aligned for pointers to uint32_t.
+ */
+struct ble_sm_sc_key_pair {
+    union {
+        uint32_t u32[16];
+        uint8_t u8[64];
+    } pub;
+    union {
+        uint32_t u32[8];
+        uint8_t u8[32];
+    } priv;
+};
+
 struct ble_sm_proc {
     STAILQ_ENTRY(ble_sm_proc) next;
 
-    uint32_t exp_os_ticks;
+    struct ble_hs_tmo tmo;
     ble_sm_proc_flags flags;
     uint16_t conn_handle;
     uint8_t pair_alg;
@@ -275,6 +295,12 @@ struct ble_sm_proc {
     struct ble_sm_public_key pub_key_peer;
     uint8_t mackey[16];
     uint8_t dhkey[32];
+
+    /* Our key pair for this procedure; valid if BLE_SM_PROC_F_SC_KEY is set.
+     * A copy is kept so that the shared pair can be rotated while other
+     * procedures are still in progress.
+     */
+    struct ble_sm_sc_key_pair our_key;
 #endif
 };
 
@@ -428,7 +454,8 @@ void ble_sm_sc_dhkey_check_exec(struct ble_sm_proc *proc,
 void ble_sm_sc_dhkey_check_rx(uint16_t conn_handle, uint8_t op,
                               struct os_mbuf **rxom,
                               struct ble_sm_result *res);
-void ble_sm_sc_init(void);
+void ble_sm_sc_sync(void);
+int ble_sm_sc_init(void);
 #else
 #define ble_sm_sc_io_action(proc) (BLE_SM_IOACT_NONE)
 #define ble_sm_sc_confirm_exec(proc, res)
@@ -438,7 +465,8 @@ void ble_sm_sc_init(void);
 #define ble_sm_sc_public_key_rx(conn_handle, op, om, res)
 #define ble_sm_sc_dhkey_check_exec(proc, res, arg)
 #define ble_sm_sc_dhkey_check_rx(conn_handle, op, om, res)
-#define ble_sm_sc_init()
+#define ble_sm_sc_sync()
+#define ble_sm_sc_init() 0
 
 #endif
 
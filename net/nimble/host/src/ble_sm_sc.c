@@ -30,25 +30,71 @@
 #define BLE_SM_SC_PASSKEY_BITS      20
 
 /**
- * The public and private keys are stored in unions.  Some crypto functions
- * accept pointers to uint32_t; others accept pointers to uint8_t.  The use of
- * unions ensures the keys are properly aligned for pointers to uint32_t.
+ * Pre-generated key pairs are only available if there is a crypto task to
+ * generate them in the background.
  */
-static union {
-    uint32_t u32[16];
-    uint8_t u8[64];
-} ble_sm_sc_pub_key;
-static union {
-    uint32_t u32[8];
-    uint8_t u8[32];
-} ble_sm_sc_priv_key;
+#define BLE_SM_SC_KEY_POOL                                      \
+    (MYNEWT_VAL(BLE_SM_SC_CRYPTO_TASK) &&                      \
+     MYNEWT_VAL(BLE_SM_SC_KEY_POOL_SIZE) > 0)
+
+/** Our current key pair; each new pairing procedure gets a copy of it. */
+static struct ble_sm_sc_key_pair ble_sm_sc_key;
 
 /**
- * Whether our public-private key pair has been generated.  We generate it on
+ * Whether our current key pair has been generated.  We generate it on
  * startup for now until we have a non-volatile storage mechanism.
  */
 static uint8_t ble_sm_sc_keys_generated;
 
+#if MYNEWT_VAL(BLE_SM_SC_KEY_ROTATE)
+/** Number of pairing procedures the current key pair has been used for. */
+static uint16_t ble_sm_sc_key_uses;
+#endif
+
+#if BLE_SM_SC_KEY_POOL
+/**
+ * Spare key pairs generated by the crypto task while it is otherwise idle.
+ * When the current pair gets rotated out, its replacement is taken from here
+ * rather than generated while the peer waits.
+ */
+static struct ble_sm_sc_key_pair
+    ble_sm_sc_key_pool[MYNEWT_VAL(BLE_SM_SC_KEY_POOL_SIZE)];
+static uint8_t ble_sm_sc_key_pool_cnt;
+#endif
+
+#if MYNEWT_VAL(BLE_SM_SC_CRYPTO_TASK)
+/**
+ * A DHKey computation handed to the crypto task.  The event is first queued
+ * to the crypto task, then reused to report completion to the host parent
+ * task.
+ */
+struct ble_sm_sc_dhkey_job {
+    struct os_event ev;
+    struct ble_sm_public_key peer_key;
+    uint32_t priv_key[8];
+    uint8_t dhkey[32];
+    uint16_t conn_handle;
+    int status;
+};
+
+static struct os_mempool ble_sm_sc_dhkey_job_pool;
+static os_membuf_t ble_sm_sc_dhkey_job_mem[
+    OS_MEMPOOL_SIZE(MYNEWT_VAL(BLE_SM_MAX_PROCS),
+                    sizeof (struct ble_sm_sc_dhkey_job))
+];
+
+static struct os_eventq ble_sm_sc_crypto_evq;
+static struct os_task ble_sm_sc_crypto_task_s;
+static os_stack_t ble_sm_sc_crypto_stack[
+    OS_STACK_ALIGN(MYNEWT_VAL(BLE_SM_SC_CRYPTO_TASK_STACK_SIZE))
+];
+static uint8_t ble_sm_sc_crypto_task_started;
+static struct os_event ble_sm_sc_keygen_ev;
+#endif
+
+static void ble_sm_sc_random_finish(struct ble_sm_proc *proc,
+                                    struct ble_sm_result *res);
+
 /**
  * Create some shortened names for the passkey actions so that the table is
  * easier to read.
@@ -177,31 +223,178 @@ ble_sm_gen_pub_priv(void *pub, uint32_t *priv)
     return 0;
 }
 
+/**
+ * Adds a freshly generated key pair.  It becomes our current pair if we do
+ * not have one yet; otherwise it gets stored in the pool, if there is room.
+ */
+static void
+ble_sm_sc_key_add(const struct ble_sm_sc_key_pair *key)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    if (!ble_sm_sc_keys_generated) {
+        ble_sm_sc_key = *key;
+        ble_sm_sc_keys_generated = 1;
+    }
+#if BLE_SM_SC_KEY_POOL
+    else if (ble_sm_sc_key_pool_cnt < MYNEWT_VAL(BLE_SM_SC_KEY_POOL_SIZE)) {
+        ble_sm_sc_key_pool[ble_sm_sc_key_pool_cnt++] = *key;
+    }
+#endif
+    OS_EXIT_CRITICAL(sr);
+}
+
+/**
+ * Removes a pre-generated key pair from the pool.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOENT if the pool is empty.
+ */
+static int
+ble_sm_sc_key_pool_take(struct ble_sm_sc_key_pair *out_key)
+{
+#if BLE_SM_SC_KEY_POOL
+    os_sr_t sr;
+    int rc;
+
+    OS_ENTER_CRITICAL(sr);
+    if (ble_sm_sc_key_pool_cnt == 0) {
+        rc = BLE_HS_ENOENT;
+    } else {
+        *out_key = ble_sm_sc_key_pool[--ble_sm_sc_key_pool_cnt];
+        rc = 0;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return rc;
+#else
+    return BLE_HS_ENOENT;
+#endif
+}
+
+#if MYNEWT_VAL(BLE_SM_SC_CRYPTO_TASK)
+/**
+ * Indicates whether the crypto task has key pairs left to generate.
+ */
+static int
+ble_sm_sc_keygen_needed(void)
+{
+    if (!ble_sm_sc_keys_generated) {
+        return 1;
+    }
+
+#if BLE_SM_SC_KEY_POOL
+    if (ble_sm_sc_key_pool_cnt < MYNEWT_VAL(BLE_SM_SC_KEY_POOL_SIZE)) {
+        return 1;
+    }
+#endif
+
+    return 0;
+}
+
+/**
+ * Schedules background key generation in the crypto task, if needed.
+ */
+static void
+ble_sm_sc_keygen_kick(void)
+{
+    if (os_started() && ble_sm_sc_keygen_needed()) {
+        os_eventq_put(&ble_sm_sc_crypto_evq, &ble_sm_sc_keygen_ev);
+    }
+}
+
+static void
+ble_sm_sc_keygen_run(struct os_event *ev)
+{
+    struct ble_sm_sc_key_pair key;
+    int rc;
+
+    if (!ble_sm_sc_keygen_needed()) {
+        return;
+    }
+
+    rc = ble_sm_gen_pub_priv(key.pub.u32, key.priv.u32);
+    if (rc != 0) {
+        /* On failure, the keys get generated on demand when pairing. */
+        return;
+    }
+    ble_sm_sc_key_add(&key);
+
+    /* Only one pair is generated per event so that DHKey computations queued
+     * in the meantime wait for at most one key generation.
+     */
+    ble_sm_sc_keygen_kick();
+}
+#endif
+
 static int
 ble_sm_sc_ensure_keys_generated(void)
 {
+    struct ble_sm_sc_key_pair key;
     int rc;
 
+#if MYNEWT_VAL(BLE_SM_SC_KEY_ROTATE)
+    if (ble_sm_sc_key_uses >= MYNEWT_VAL(BLE_SM_SC_KEY_ROTATE)) {
+        /* The current pair has served its quota of pairing procedures;
+         * procedures still using it keep their own copy.
+         */
+        ble_sm_sc_keys_generated = 0;
+        ble_sm_sc_key_uses = 0;
+    }
+#endif
+
     if (!ble_sm_sc_keys_generated) {
-        rc = ble_sm_gen_pub_priv(ble_sm_sc_pub_key.u32,
-                                 ble_sm_sc_priv_key.u32);
+        rc = ble_sm_sc_key_pool_take(&key);
         if (rc != 0) {
-            return rc;
+            rc = ble_sm_gen_pub_priv(key.pub.u32, key.priv.u32);
+            if (rc != 0) {
+                return rc;
+            }
         }
-
-        ble_sm_sc_keys_generated = 1;
+        ble_sm_sc_key_add(&key);
     }
 
+#if MYNEWT_VAL(BLE_SM_SC_CRYPTO_TASK)
+    /* Replenish the pool while the procedure is in progress. */
+    ble_sm_sc_keygen_kick();
+#endif
+
     BLE_HS_LOG(DEBUG, "our pubkey=");
-    ble_hs_log_flat_buf(&ble_sm_sc_pub_key, 64);
+    ble_hs_log_flat_buf(&ble_sm_sc_key.pub, 64);
     BLE_HS_LOG(DEBUG, "\n");
     BLE_HS_LOG(DEBUG, "our privkey=");
-    ble_hs_log_flat_buf(&ble_sm_sc_priv_key, 32);
+    ble_hs_log_flat_buf(&ble_sm_sc_key.priv, 32);
     BLE_HS_LOG(DEBUG, "\n");
 
     return 0;
 }
 
+/**
+ * Gives the specified procedure a copy of our current key pair, unless it
+ * already has one.  The procedure keeps using that pair even if the current
+ * one gets rotated before pairing completes.
+ */
+static void
+ble_sm_sc_key_assign(struct ble_sm_proc *proc)
+{
+    os_sr_t sr;
+
+    if (proc->flags & BLE_SM_PROC_F_SC_KEY) {
+        return;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    proc->our_key = ble_sm_sc_key;
+    OS_EXIT_CRITICAL(sr);
+
+    proc->flags |= BLE_SM_PROC_F_SC_KEY;
+
+#if MYNEWT_VAL(BLE_SM_SC_KEY_ROTATE)
+    ble_sm_sc_key_uses++;
+#endif
+}
+
 /* Initiator does not send a confirm when pairing algorithm is any of:
  *     o just works
  *     o numeric comparison
@@ -284,7 +477,7 @@ ble_sm_sc_confirm_exec(struct ble_sm_proc *proc, struct ble_sm_result *res)
         return;
     }
 
-    rc = ble_sm_alg_f4(ble_sm_sc_pub_key.u8, proc->pub_key_peer.x,
+    rc = ble_sm_alg_f4(proc->our_key.pub.u8, proc->pub_key_peer.x,
                        ble_sm_our_pair_rand(proc), proc->ri, cmd.value);
     if (rc != 0) {
         res->app_status = rc;
@@ -313,11 +506,11 @@ ble_sm_sc_gen_numcmp(struct ble_sm_proc *proc, struct ble_sm_result *res)
     uint8_t *pkb;
 
     if (proc->flags & BLE_SM_PROC_F_INITIATOR) {
-        pka = ble_sm_sc_pub_key.u8;
+        pka = proc->our_key.pub.u8;
         pkb = proc->pub_key_peer.x;
     } else {
         pka = proc->pub_key_peer.x;
-        pkb = ble_sm_sc_pub_key.u8;
+        pkb = proc->our_key.pub.u8;
     }
     res->app_status = ble_sm_alg_g2(pka, pkb, proc->randm, proc->rands,
                                     &res->passkey_params.numcmp);
@@ -392,11 +585,6 @@ void
 ble_sm_sc_random_rx(struct ble_sm_proc *proc, struct ble_sm_result *res)
 {
     uint8_t confirm_val[16];
-    uint8_t ia[6];
-    uint8_t ra[6];
-    uint8_t ioact;
-    uint8_t iat;
-    uint8_t rat;
     int rc;
 
     if (proc->flags & BLE_SM_PROC_F_INITIATOR ||
@@ -406,7 +594,7 @@ ble_sm_sc_random_rx(struct ble_sm_proc *proc, struct ble_sm_result *res)
         ble_hs_log_flat_buf(proc->tk, 32);
         BLE_HS_LOG(DEBUG, "\n");
 
-        rc = ble_sm_alg_f4(proc->pub_key_peer.x, ble_sm_sc_pub_key.u8,
+        rc = ble_sm_alg_f4(proc->pub_key_peer.x, proc->our_key.pub.u8,
                            ble_sm_peer_pair_rand(proc), proc->ri,
                            confirm_val);
         if (rc != 0) {
@@ -425,6 +613,31 @@ ble_sm_sc_random_rx(struct ble_sm_proc *proc, struct ble_sm_result *res)
         }
     }
 
+#if MYNEWT_VAL(BLE_SM_SC_CRYPTO_TASK)
+    if (proc->flags & BLE_SM_PROC_F_DHKEY_PENDING) {
+        /* The DHKey is still being computed; resume when it is ready. */
+        proc->flags |= BLE_SM_PROC_F_DHKEY_WAIT;
+        return;
+    }
+#endif
+
+    ble_sm_sc_random_finish(proc, res);
+}
+
+/**
+ * Completes the random state once the peer's random value has been verified
+ * and the DHKey is known.
+ */
+static void
+ble_sm_sc_random_finish(struct ble_sm_proc *proc, struct ble_sm_result *res)
+{
+    uint8_t ia[6];
+    uint8_t ra[6];
+    uint8_t ioact;
+    uint8_t iat;
+    uint8_t rat;
+    int rc;
+
     /* Calculate the mac key and ltk. */
     ble_sm_ia_ra(proc, &iat, ia, &rat, ra);
     rc = ble_sm_alg_f5(proc->dhkey, proc->randm, proc->rands,
@@ -474,15 +687,22 @@ ble_sm_sc_public_key_exec(struct ble_sm_proc *proc, struct ble_sm_result *res,
     struct ble_sm_public_key cmd;
     uint8_t ioact;
 
-    res->app_status = ble_sm_sc_ensure_keys_generated();
-    if (res->app_status != 0) {
-        res->enc_cb = 1;
-        res->sm_err = BLE_SM_ERR_UNSPECIFIED;
-        return;
+    /* As responder, we already picked our key pair when the peer's public
+     * key was received.
+     */
+    if (!(proc->flags & BLE_SM_PROC_F_SC_KEY)) {
+        res->app_status = ble_sm_sc_ensure_keys_generated();
+        if (res->app_status != 0) {
+            res->enc_cb = 1;
+            res->sm_err = BLE_SM_ERR_UNSPECIFIED;
+            return;
+        }
+
+        ble_sm_sc_key_assign(proc);
     }
 
-    memcpy(cmd.x, ble_sm_sc_pub_key.u8 + 0, 32);
-    memcpy(cmd.y, ble_sm_sc_pub_key.u8 + 32, 32);
+    memcpy(cmd.x, proc->our_key.pub.u8 + 0, 32);
+    memcpy(cmd.y, proc->our_key.pub.u8 + 32, 32);
     res->app_status = ble_sm_public_key_tx(proc->conn_handle, &cmd);
     if (res->app_status != 0) {
         res->enc_cb = 1;
@@ -506,14 +726,174 @@ ble_sm_sc_public_key_exec(struct ble_sm_proc *proc, struct ble_sm_result *res,
     }
 }
 
+/**
+ * Advances a procedure past the public key exchange.  The host lock must be
+ * held.
+ */
+static void
+ble_sm_sc_public_key_advance(struct ble_sm_proc *proc,
+                             struct ble_sm_result *res)
+{
+    uint8_t ioact;
+
+    if (proc->flags & BLE_SM_PROC_F_INITIATOR) {
+        proc->state = BLE_SM_PROC_STATE_CONFIRM;
+
+        ioact = ble_sm_sc_io_action(proc);
+        if (ble_sm_ioact_state(ioact) == proc->state) {
+            res->passkey_params.action = ioact;
+        }
+
+        if (ble_sm_proc_can_advance(proc) &&
+            ble_sm_sc_initiator_txes_confirm(proc)) {
+
+            res->execute = 1;
+        }
+    } else {
+        res->execute = 1;
+    }
+}
+
+#if MYNEWT_VAL(BLE_SM_SC_CRYPTO_TASK)
+
+static void
+ble_sm_sc_dhkey_job_done(struct os_event *ev)
+{
+    struct ble_sm_sc_dhkey_job *job;
+    struct ble_sm_result res;
+    struct ble_sm_proc *proc;
+    uint16_t conn_handle;
+
+    job = ev->ev_arg;
+    conn_handle = job->conn_handle;
+
+    memset(&res, 0, sizeof res);
+
+    ble_hs_lock();
+
+    /* The procedure may have failed or been replaced while the key was being
+     * computed.  Only apply the result if it still corresponds to the
+     * received public key.
+     */
+    proc = ble_sm_proc_find(conn_handle, BLE_SM_PROC_STATE_NONE, -1, NULL);
+    if (proc != NULL &&
+        proc->flags & BLE_SM_PROC_F_DHKEY_PENDING &&
+        memcmp(&proc->pub_key_peer, &job->peer_key,
+               sizeof proc->pub_key_peer) == 0) {
+
+        proc->flags &= ~BLE_SM_PROC_F_DHKEY_PENDING;
+        if (job->status != 0) {
+            res.app_status = BLE_HS_SM_US_ERR(BLE_SM_ERR_DHKEY);
+            res.sm_err = BLE_SM_ERR_DHKEY;
+            res.enc_cb = 1;
+        } else {
+            memcpy(proc->dhkey, job->dhkey, sizeof proc->dhkey);
+            if (proc->flags & BLE_SM_PROC_F_DHKEY_WAIT) {
+                proc->flags &= ~BLE_SM_PROC_F_DHKEY_WAIT;
+                ble_sm_sc_random_finish(proc, &res);
+            }
+        }
+    } else {
+        proc = NULL;
+    }
+
+    ble_hs_unlock();
+
+    os_memblock_put(&ble_sm_sc_dhkey_job_pool, job);
+
+    if (proc != NULL) {
+        ble_sm_process_result(conn_handle, &res);
+    }
+}
+
+static void
+ble_sm_sc_dhkey_job_run(struct os_event *ev)
+{
+    struct ble_sm_sc_dhkey_job *job;
+
+    job = ev->ev_arg;
+    job->status = ble_sm_alg_gen_dhkey(job->peer_key.x, job->peer_key.y,
+                                       job->priv_key, job->dhkey);
+
+    /* Hand the result back to the host parent task. */
+    ev->ev_cb = ble_sm_sc_dhkey_job_done;
+    ble_hs_enqueue_event(ev);
+}
+
+/**
+ * Processes a received public key, handing the DHKey computation to the SM
+ * crypto task.  The pairing procedure continues in the meantime; the key is
+ * only needed once both random values have been exchanged.
+ *
+ * @return                      0 if the computation was offloaded;
+ *                              BLE_HS_EAGAIN if it must be performed
+ *                                  synchronously instead.
+ */
+static int
+ble_sm_sc_dhkey_job_start(uint16_t conn_handle,
+                          const struct ble_sm_public_key *cmd,
+                          struct ble_sm_result *res)
+{
+    struct ble_sm_sc_dhkey_job *job;
+    struct ble_sm_proc *proc;
+
+    if (!os_started()) {
+        return BLE_HS_EAGAIN;
+    }
+
+    job = os_memblock_get(&ble_sm_sc_dhkey_job_pool);
+    if (job == NULL) {
+        return BLE_HS_EAGAIN;
+    }
+
+    memset(job, 0, sizeof *job);
+    job->conn_handle = conn_handle;
+    job->peer_key = *cmd;
+    job->ev.ev_cb = ble_sm_sc_dhkey_job_run;
+    job->ev.ev_arg = job;
+
+    ble_hs_lock();
+    proc = ble_sm_proc_find(conn_handle, BLE_SM_PROC_STATE_PUBLIC_KEY, -1,
+                            NULL);
+    if (proc == NULL) {
+        res->app_status = BLE_HS_ENOENT;
+        res->sm_err = BLE_SM_ERR_UNSPECIFIED;
+    } else {
+        ble_sm_sc_key_assign(proc);
+        memcpy(job->priv_key, proc->our_key.priv.u32, sizeof job->priv_key);
+        proc->pub_key_peer = *cmd;
+        proc->flags |= BLE_SM_PROC_F_DHKEY_PENDING;
+        ble_sm_sc_public_key_advance(proc, res);
+    }
+    ble_hs_unlock();
+
+    if (proc == NULL) {
+        os_memblock_put(&ble_sm_sc_dhkey_job_pool, job);
+    } else {
+        os_eventq_put(&ble_sm_sc_crypto_evq, &job->ev);
+    }
+
+    return 0;
+}
+
+static void
+ble_sm_sc_crypto_task(void *arg)
+{
+    while (1) {
+        os_eventq_run(&ble_sm_sc_crypto_evq);
+    }
+}
+
+#endif
+
 void
 ble_sm_sc_public_key_rx(uint16_t conn_handle, uint8_t op, struct os_mbuf **om,
                         struct ble_sm_result *res)
 {
     struct ble_sm_public_key cmd;
     struct ble_sm_proc *proc;
-    struct ble_sm_proc *prev;
-    uint8_t ioact;
+    uint32_t priv_key[8];
+    uint8_t dhkey[32];
     int rc;
 
     res->app_status = ble_hs_mbuf_pullup_base(om, BLE_SM_PUBLIC_KEY_SZ);
@@ -532,39 +912,51 @@ ble_sm_sc_public_key_rx(uint16_t conn_handle, uint8_t op, struct os_mbuf **om,
     ble_sm_public_key_parse((*om)->om_data, (*om)->om_len, &cmd);
     BLE_SM_LOG_CMD(0, "public key", conn_handle, ble_sm_public_key_log, &cmd);
 
+#if MYNEWT_VAL(BLE_SM_SC_CRYPTO_TASK)
+    rc = ble_sm_sc_dhkey_job_start(conn_handle, &cmd, res);
+    if (rc == 0) {
+        return;
+    }
+#endif
+
     ble_hs_lock();
     proc = ble_sm_proc_find(conn_handle, BLE_SM_PROC_STATE_PUBLIC_KEY, -1,
-                            &prev);
+                            NULL);
+    if (proc != NULL) {
+        ble_sm_sc_key_assign(proc);
+        memcpy(priv_key, proc->our_key.priv.u32, sizeof priv_key);
+    }
+    ble_hs_unlock();
+
+    if (proc == NULL) {
+        res->app_status = BLE_HS_ENOENT;
+        res->sm_err = BLE_SM_ERR_UNSPECIFIED;
+        return;
+    }
+
+    /* The DHKey computation is by far the most expensive step in pairing.
+     * It only depends on the received key and our private key, so perform
+     * it without holding the host lock; other tasks can then keep using
+     * the host in the meantime.  The procedure's state is verified
+     * afterwards.
+     */
+    rc = ble_sm_alg_gen_dhkey(cmd.x, cmd.y, priv_key, dhkey);
+
+    ble_hs_lock();
+    proc = ble_sm_proc_find(conn_handle, BLE_SM_PROC_STATE_PUBLIC_KEY, -1,
+                            NULL);
     if (proc == NULL) {
         res->app_status = BLE_HS_ENOENT;
         res->sm_err = BLE_SM_ERR_UNSPECIFIED;
     } else {
         proc->pub_key_peer = cmd;
-        rc = ble_sm_alg_gen_dhkey(proc->pub_key_peer.x,
-                                  proc->pub_key_peer.y,
-                                  ble_sm_sc_priv_key.u32,
-                                  proc->dhkey);
         if (rc != 0) {
             res->app_status = BLE_HS_SM_US_ERR(BLE_SM_ERR_DHKEY);
             res->sm_err = BLE_SM_ERR_DHKEY;
             res->enc_cb = 1;
         } else {
-            if (proc->flags & BLE_SM_PROC_F_INITIATOR) {
-                proc->state = BLE_SM_PROC_STATE_CONFIRM;
-
-                ioact = ble_sm_sc_io_action(proc);
-                if (ble_sm_ioact_state(ioact) == proc->state) {
-                    res->passkey_params.action = ioact;
-                }
-
-                if (ble_sm_proc_can_advance(proc) &&
-                    ble_sm_sc_initiator_txes_confirm(proc)) {
-
-                    res->execute = 1;
-                }
-            } else {
-                res->execute = 1;
-            }
+            memcpy(proc->dhkey, dhkey, sizeof proc->dhkey);
+            ble_sm_sc_public_key_advance(proc, res);
         }
     }
     ble_hs_unlock();
@@ -740,10 +1132,62 @@ ble_sm_sc_dhkey_check_rx(uint16_t conn_handle, uint8_t op, struct os_mbuf **om,
     ble_hs_unlock();
 }
 
+/**
+ * Called when the host syncs with the controller.  If a crypto task is
+ * configured, our key pair (and any spare pairs for the pool) gets generated
+ * in the background so that pairing procedures do not have to wait for it.
+ */
 void
+ble_sm_sc_sync(void)
+{
+#if MYNEWT_VAL(BLE_SM_SC_CRYPTO_TASK)
+    ble_sm_sc_keygen_kick();
+#endif
+}
+
+int
 ble_sm_sc_init(void)
 {
+#if MYNEWT_VAL(BLE_SM_SC_CRYPTO_TASK)
+    int rc;
+#endif
+
     ble_sm_sc_keys_generated = 0;
+#if MYNEWT_VAL(BLE_SM_SC_KEY_ROTATE)
+    ble_sm_sc_key_uses = 0;
+#endif
+#if BLE_SM_SC_KEY_POOL
+    ble_sm_sc_key_pool_cnt = 0;
+#endif
+
+#if MYNEWT_VAL(BLE_SM_SC_CRYPTO_TASK)
+    rc = os_mempool_init(&ble_sm_sc_dhkey_job_pool,
+                         MYNEWT_VAL(BLE_SM_MAX_PROCS),
+                         sizeof (struct ble_sm_sc_dhkey_job),
+                         ble_sm_sc_dhkey_job_mem,
+                         "ble_sm_sc_dhkey_job_pool");
+    if (rc != 0) {
+        return BLE_HS_EOS;
+    }
+
+    ble_sm_sc_keygen_ev.ev_cb = ble_sm_sc_keygen_run;
+
+    /* The task survives host resets; only create it once. */
+    if (!ble_sm_sc_crypto_task_started) {
+        os_eventq_init(&ble_sm_sc_crypto_evq);
+        rc = os_task_init(&ble_sm_sc_crypto_task_s, "ble_sm_crypto",
+                          ble_sm_sc_crypto_task, NULL,
+                          MYNEWT_VAL(BLE_SM_SC_CRYPTO_TASK_PRIO),
+                          OS_WAIT_FOREVER, ble_sm_sc_crypto_stack,
+                          MYNEWT_VAL(BLE_SM_SC_CRYPTO_TASK_STACK_SIZE));
+        if (rc != 0) {
+            return BLE_HS_EOS;
+        }
+        ble_sm_sc_crypto_task_started = 1;
+    }
+#endif
+
+    return 0;
 }
 
 #endif  /* MYNEWT_VAL(BLE_SM_SC) */
@@ -22,6 +22,48 @@
 #include "host/ble_store.h"
 #include "ble_hs_priv.h"
 
+/**
+ * Serializes calls into the application's store callbacks.  This is
+ * independent of the host lock, so a slow persistent store does not stall
+ * unrelated host activity.  The host lock must not be held when this lock
+ * is acquired; a store callback may, however, call into the host.
+ */
+static struct os_mutex ble_store_mutex;
+
+static void
+ble_store_lock(void)
+{
+    os_time_t start;
+    int contended;
+    int rc;
+
+    BLE_HS_DBG_ASSERT(!ble_hs_locked_by_cur_task());
+
+    contended = ble_store_mutex.mu_owner != NULL &&
+                ble_store_mutex.mu_owner != os_sched_get_current_task();
+    if (contended) {
+        start = os_time_get();
+    }
+
+    rc = os_mutex_pend(&ble_store_mutex, 0xffffffff);
+    BLE_HS_DBG_ASSERT_EVAL(rc == 0 || rc == OS_NOT_STARTED);
+
+    if (contended) {
+        STATS_INC(ble_hs_stats, store_lock_contended);
+        STATS_INCN(ble_hs_stats, store_lock_wait_ticks,
+                   os_time_get() - start);
+    }
+}
+
+static void
+ble_store_unlock(void)
+{
+    int rc;
+
+    rc = os_mutex_release(&ble_store_mutex);
+    BLE_HS_DBG_ASSERT_EVAL(rc == 0 || rc == OS_NOT_STARTED);
+}
+
 int
 ble_store_read(int obj_type, union ble_store_key *key,
                union ble_store_value *val)
@@ -31,7 +73,9 @@ ble_store_read(int obj_type, union ble_store_key *key,
     if (ble_hs_cfg.store_read_cb == NULL) {
         rc = BLE_HS_ENOTSUP;
     } else {
+        ble_store_lock();
         rc = ble_hs_cfg.store_read_cb(obj_type, key, val);
+        ble_store_unlock();
     }
 
     return rc;
@@ -45,7 +89,9 @@ ble_store_write(int obj_type, union ble_store_value *val)
     if (ble_hs_cfg.store_write_cb == NULL) {
         rc = BLE_HS_ENOTSUP;
     } else {
+        ble_store_lock();
         rc = ble_hs_cfg.store_write_cb(obj_type, val);
+        ble_store_unlock();
     }
 
     return rc;
@@ -59,7 +105,9 @@ ble_store_delete(int obj_type, union ble_store_key *key)
     if (ble_hs_cfg.store_delete_cb == NULL) {
         rc = BLE_HS_ENOTSUP;
     } else {
+        ble_store_lock();
         rc = ble_hs_cfg.store_delete_cb(obj_type, key);
+        ble_store_unlock();
     }
 
     return rc;
@@ -225,6 +273,53 @@ ble_store_delete_cccd(struct ble_store_key_cccd *key)
     return rc;
 }
 
+int
+ble_store_read_gatt_disc(struct ble_store_key_gatt_disc *key,
+                         struct ble_store_value_gatt_disc *out_value)
+{
+    union ble_store_value *store_value;
+    union ble_store_key *store_key;
+    int rc;
+
+    store_key = (void *)key;
+    store_value = (void *)out_value;
+    rc = ble_store_read(BLE_STORE_OBJ_TYPE_GATT_DISC, store_key, store_value);
+    return rc;
+}
+
+int
+ble_store_write_gatt_disc(struct ble_store_value_gatt_disc *value)
+{
+    union ble_store_value *store_value;
+    int rc;
+
+    store_value = (void *)value;
+    rc = ble_store_write(BLE_STORE_OBJ_TYPE_GATT_DISC, store_value);
+    return rc;
+}
+
+int
+ble_store_delete_gatt_disc(struct ble_store_key_gatt_disc *key)
+{
+    union ble_store_key *store_key;
+    int rc;
+
+    store_key = (void *)key;
+    rc = ble_store_delete(BLE_STORE_OBJ_TYPE_GATT_DISC, store_key);
+    return rc;
+}
+
+void
+ble_store_key_from_value_gatt_disc(struct ble_store_key_gatt_disc *out_key,
+                                   struct ble_store_value_gatt_disc *value)
+{
+    out_key->peer_addr_type = value->peer_addr_type;
+    memcpy(out_key->peer_addr, value->peer_addr, 6);
+    out_key->kind = value->kind;
+    out_key->handle = value->handle;
+    out_key->idx = 0;
+}
+
 void
 ble_store_key_from_value_cccd(struct ble_store_key_cccd *out_key,
                               struct ble_store_value_cccd *value)
@@ -268,6 +363,11 @@ void ble_store_iterate(int obj_type,
         case BLE_STORE_OBJ_TYPE_CCCD:
             key.cccd.peer_addr_type = BLE_STORE_ADDR_TYPE_NONE;
             pidx = &key.cccd.idx;
+            break;
+        case BLE_STORE_OBJ_TYPE_GATT_DISC:
+            key.gatt_disc.peer_addr_type = BLE_STORE_ADDR_TYPE_NONE;
+            pidx = &key.gatt_disc.idx;
+            break;
         default:
             return;
     }
@@ -285,3 +385,16 @@ void ble_store_iterate(int obj_type,
         idx++;
     }
 }
+
+int
+ble_store_init(void)
+{
+    int rc;
+
+    rc = os_mutex_init(&ble_store_mutex);
+    if (rc != 0) {
+        return BLE_HS_EOS;
+    }
+
+    return 0;
+}
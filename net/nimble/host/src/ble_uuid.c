@@ -154,3 +154,235 @@ ble_uuid_extract(struct os_mbuf *om, int off, void *uuid128)
         return BLE_HS_EMSGSIZE;
     }
 }
+
+/**
+ * Fills in a compact UUID from its flat little endian representation.  The
+ * result always takes the shortest form the UUID has, so two UUIDs
+ * initialized this way are equal exactly when their types and values are.
+ *
+ * @param uuid                  The UUID to fill in.
+ * @param buf                   The flat UUID.
+ * @param len                   The length of the flat UUID: 2, 4, or 16.
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_EINVAL if the length is not one of the
+ *                                  above, or the UUID is zero.
+ */
+int
+ble_uuid_init_from_buf(ble_uuid_any_t *uuid, const void *buf, size_t len)
+{
+    const uint8_t *u8ptr;
+    uint32_t uuid32;
+
+    u8ptr = buf;
+
+    switch (len) {
+    case 2:
+        uuid32 = le16toh(u8ptr);
+        break;
+
+    case 4:
+        uuid32 = le32toh(u8ptr);
+        break;
+
+    case 16:
+        if (memcmp(u8ptr, ble_uuid_base, sizeof ble_uuid_base - 4) != 0) {
+            uuid->u128.u.type = BLE_UUID_TYPE_128;
+            memcpy(uuid->u128.value, u8ptr, 16);
+            return 0;
+        }
+
+        uuid32 = le32toh(u8ptr + 12);
+        if (uuid32 == 0) {
+            /* The base UUID itself has no shorter form. */
+            uuid->u128.u.type = BLE_UUID_TYPE_128;
+            memcpy(uuid->u128.value, u8ptr, 16);
+            return 0;
+        }
+        break;
+
+    default:
+        return BLE_HS_EINVAL;
+    }
+
+    if (uuid32 == 0) {
+        return BLE_HS_EINVAL;
+    }
+
+    if (uuid32 <= UINT16_MAX) {
+        uuid->u16.u.type = BLE_UUID_TYPE_16;
+        uuid->u16.value = uuid32;
+    } else {
+        uuid->u32.u.type = BLE_UUID_TYPE_32;
+        uuid->u32.value = uuid32;
+    }
+
+    return 0;
+}
+
+/**
+ * Indicates whether a UUID is in its shortest form, i.e., whether it would
+ * come out of ble_uuid_init_from_buf() unchanged.
+ */
+int
+ble_uuid_is_compact(const ble_uuid_t *uuid)
+{
+    const ble_uuid128_t *u128;
+    uint32_t uuid32;
+
+    switch (uuid->type) {
+    case BLE_UUID_TYPE_16:
+        return ((const ble_uuid16_t *)uuid)->value != 0;
+
+    case BLE_UUID_TYPE_32:
+        return ((const ble_uuid32_t *)uuid)->value > UINT16_MAX;
+
+    case BLE_UUID_TYPE_128:
+        u128 = (const ble_uuid128_t *)uuid;
+        if (memcmp(u128->value, ble_uuid_base,
+                   sizeof ble_uuid_base - 4) != 0) {
+            return 1;
+        }
+        uuid32 = le32toh(u128->value + 12);
+        return uuid32 == 0;
+
+    default:
+        return 0;
+    }
+}
+
+/**
+ * Compares two UUIDs.  Both must be in their shortest form (see
+ * ble_uuid_init_from_buf()); 16- and 32-bit UUIDs then compare as integers.
+ *
+ * @return                      0 if the UUIDs are equal;
+ *                              <0 or >0 otherwise, consistently, so the
+ *                                  result can be used for sorting.
+ */
+int
+ble_uuid_cmp(const ble_uuid_t *uuid1, const ble_uuid_t *uuid2)
+{
+    uint32_t val1;
+    uint32_t val2;
+
+    if (uuid1->type != uuid2->type) {
+        return uuid1->type - uuid2->type;
+    }
+
+    switch (uuid1->type) {
+    case BLE_UUID_TYPE_16:
+        return (int)((const ble_uuid16_t *)uuid1)->value -
+               (int)((const ble_uuid16_t *)uuid2)->value;
+
+    case BLE_UUID_TYPE_32:
+        val1 = ((const ble_uuid32_t *)uuid1)->value;
+        val2 = ((const ble_uuid32_t *)uuid2)->value;
+        return (val1 > val2) - (val1 < val2);
+
+    case BLE_UUID_TYPE_128:
+        return memcmp(((const ble_uuid128_t *)uuid1)->value,
+                      ((const ble_uuid128_t *)uuid2)->value, 16);
+
+    default:
+        BLE_HS_DBG_ASSERT(0);
+        return -1;
+    }
+}
+
+/**
+ * Returns the size of the structure holding the specified UUID.
+ */
+int
+ble_uuid_sizeof(const ble_uuid_t *uuid)
+{
+    switch (uuid->type) {
+    case BLE_UUID_TYPE_16:
+        return sizeof (ble_uuid16_t);
+    case BLE_UUID_TYPE_32:
+        return sizeof (ble_uuid32_t);
+    case BLE_UUID_TYPE_128:
+        return sizeof (ble_uuid128_t);
+    default:
+        BLE_HS_DBG_ASSERT(0);
+        return 0;
+    }
+}
+
+void
+ble_uuid_copy(ble_uuid_any_t *dst, const ble_uuid_t *src)
+{
+    memcpy(dst, src, ble_uuid_sizeof(src));
+}
+
+/**
+ * Writes the 128-bit form of a UUID.
+ *
+ * @param dst                   The 16-byte buffer to write to.
+ */
+void
+ble_uuid_to_128(const ble_uuid_t *uuid, void *dst)
+{
+    uint8_t *u8ptr;
+
+    u8ptr = dst;
+
+    switch (uuid->type) {
+    case BLE_UUID_TYPE_16:
+        memcpy(u8ptr, ble_uuid_base, 16);
+        htole16(u8ptr + 12, ((const ble_uuid16_t *)uuid)->value);
+        break;
+
+    case BLE_UUID_TYPE_32:
+        memcpy(u8ptr, ble_uuid_base, 16);
+        htole32(u8ptr + 12, ((const ble_uuid32_t *)uuid)->value);
+        break;
+
+    case BLE_UUID_TYPE_128:
+        memcpy(u8ptr, ((const ble_uuid128_t *)uuid)->value, 16);
+        break;
+
+    default:
+        BLE_HS_DBG_ASSERT(0);
+        break;
+    }
+}
+
+/**
+ * Returns the value of a 16-bit UUID; 0 if the UUID is wider.
+ */
+uint16_t
+ble_uuid_u16(const ble_uuid_t *uuid)
+{
+    if (uuid->type != BLE_UUID_TYPE_16) {
+        return 0;
+    }
+
+    return ((const ble_uuid16_t *)uuid)->value;
+}
+
+/**
+ * Returns the number of bytes a UUID takes up in an ATT PDU.  ATT only knows
+ * 16- and 128-bit UUIDs, so 32-bit ones are sent in their 128-bit form.
+ */
+int
+ble_uuid_att_len(const ble_uuid_t *uuid)
+{
+    return uuid->type == BLE_UUID_TYPE_16 ? 2 : 16;
+}
+
+/**
+ * Writes a UUID the way it is sent in an ATT PDU.
+ *
+ * @return                      The number of bytes written: 2 or 16.
+ */
+int
+ble_uuid_flat(const ble_uuid_t *uuid, void *dst)
+{
+    if (uuid->type == BLE_UUID_TYPE_16) {
+        htole16(dst, ((const ble_uuid16_t *)uuid)->value);
+        return 2;
+    }
+
+    ble_uuid_to_128(uuid, dst);
+    return 16;
+}
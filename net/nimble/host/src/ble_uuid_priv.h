@@ -20,6 +20,8 @@
 #ifndef H_BLE_UUID_PRIV_
 #define H_BLE_UUID_PRIV_
 
+#include "host/ble_uuid.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -28,6 +30,10 @@ struct os_mbuf;
 
 int ble_uuid_append(struct os_mbuf *om, const void *uuid128);
 int ble_uuid_extract(struct os_mbuf *om, int off, void *uuid128);
+int ble_uuid_is_compact(const ble_uuid_t *uuid);
+int ble_uuid_sizeof(const ble_uuid_t *uuid);
+int ble_uuid_att_len(const ble_uuid_t *uuid);
+int ble_uuid_flat(const ble_uuid_t *uuid, void *dst);
 
 #ifdef __cplusplus
 }
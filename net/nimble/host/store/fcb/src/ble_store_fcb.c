@@ -0,0 +1,775 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * This file implements a flash-backed persistence layer for the NimBLE host.
+ * Every object is also kept in a RAM table, so reads never touch flash; the
+ * flash area is only read once, at startup, to rebuild the tables.
+ *
+ * Records are appended to an FCB; an object is never rewritten in place.  A
+ * deleted object is marked by a tombstone record.  When the FCB runs out of
+ * free sectors, the live objects in the oldest sector are re-appended from
+ * RAM and the sector is erased.
+ *
+ * Security records are written as soon as the host hands them to the store.
+ * CCCD changes are frequent (a peer may toggle a subscription many times per
+ * connection), so they are only marked dirty and written by a timer.
+ */
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "bsp/bsp.h"
+#include "os/os.h"
+#include "flash_map/flash_map.h"
+#include "fcb/fcb.h"
+#include "host/ble_hs.h"
+#include "store/fcb/ble_store_fcb.h"
+
+/** Version of the on-flash record layout; bump when it changes. */
+#define BLE_STORE_FCB_VERSION               1
+
+/** RAM copy is newer than the flash record. */
+#define BLE_STORE_FCB_F_DIRTY               0x01
+
+/** Object has been deleted; its tombstone has not been written yet. */
+#define BLE_STORE_FCB_F_DELETED             0x02
+
+#define BLE_STORE_FCB_CCCD_FLUSH_TICKS                          \
+    (MYNEWT_VAL(BLE_STORE_FCB_CCCD_FLUSH_MS) * OS_TICKS_PER_SEC / 1000)
+
+/** Record flag: the record deletes the object it describes. */
+#define BLE_STORE_FCB_REC_F_TOMBSTONE       0x01
+
+struct ble_store_fcb_rec {
+    uint8_t obj_type;
+    uint8_t flags;
+    uint8_t reserved[2];
+    union ble_store_value value;
+};
+
+struct ble_store_fcb_entry {
+    union ble_store_value value;
+
+    /** Location of the current flash record; fe_area=NULL if none. */
+    struct fcb_entry loc;
+
+    uint8_t flags;
+};
+
+struct ble_store_fcb_table {
+    struct ble_store_fcb_entry *entries;
+    uint8_t obj_type;
+    uint8_t max;
+    uint8_t num;
+};
+
+static struct ble_store_fcb_entry
+    ble_store_fcb_our_secs[MYNEWT_VAL(BLE_STORE_FCB_MAX_OUR_SECS)];
+static struct ble_store_fcb_entry
+    ble_store_fcb_peer_secs[MYNEWT_VAL(BLE_STORE_FCB_MAX_PEER_SECS)];
+static struct ble_store_fcb_entry
+    ble_store_fcb_cccds[MYNEWT_VAL(BLE_STORE_FCB_MAX_CCCDS)];
+
+static struct ble_store_fcb_table ble_store_fcb_tables[] = {
+    {
+        .entries = ble_store_fcb_our_secs,
+        .obj_type = BLE_STORE_OBJ_TYPE_OUR_SEC,
+        .max = MYNEWT_VAL(BLE_STORE_FCB_MAX_OUR_SECS),
+    },
+    {
+        .entries = ble_store_fcb_peer_secs,
+        .obj_type = BLE_STORE_OBJ_TYPE_PEER_SEC,
+        .max = MYNEWT_VAL(BLE_STORE_FCB_MAX_PEER_SECS),
+    },
+    {
+        .entries = ble_store_fcb_cccds,
+        .obj_type = BLE_STORE_OBJ_TYPE_CCCD,
+        .max = MYNEWT_VAL(BLE_STORE_FCB_MAX_CCCDS),
+    },
+};
+
+#define BLE_STORE_FCB_NUM_TABLES                                \
+    (sizeof ble_store_fcb_tables / sizeof ble_store_fcb_tables[0])
+
+static struct flash_area ble_store_fcb_area[NFFS_AREA_MAX + 1];
+
+static struct fcb ble_store_fcb_fcb = {
+    .f_magic = MYNEWT_VAL(BLE_STORE_FCB_MAGIC),
+    .f_version = BLE_STORE_FCB_VERSION,
+    .f_scratch_cnt = 1,
+    .f_sectors = ble_store_fcb_area,
+};
+
+static struct os_mutex ble_store_fcb_mutex;
+static struct os_callout ble_store_fcb_flush_timer;
+
+/*****************************************************************************
+ * $table                                                                    *
+ *****************************************************************************/
+
+static struct ble_store_fcb_table *
+ble_store_fcb_table_find(int obj_type)
+{
+    int i;
+
+    for (i = 0; i < BLE_STORE_FCB_NUM_TABLES; i++) {
+        if (ble_store_fcb_tables[i].obj_type == obj_type) {
+            return ble_store_fcb_tables + i;
+        }
+    }
+
+    return NULL;
+}
+
+static int
+ble_store_fcb_sec_matches(struct ble_store_key_sec *key,
+                          struct ble_store_value_sec *value)
+{
+    if (key->peer_addr_type != BLE_STORE_ADDR_TYPE_NONE) {
+        if (value->peer_addr_type != key->peer_addr_type) {
+            return 0;
+        }
+
+        if (memcmp(value->peer_addr, key->peer_addr,
+                   sizeof value->peer_addr) != 0) {
+            return 0;
+        }
+    }
+
+    if (key->ediv_rand_present) {
+        if (value->ediv != key->ediv) {
+            return 0;
+        }
+
+        if (value->rand_num != key->rand_num) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int
+ble_store_fcb_cccd_matches(struct ble_store_key_cccd *key,
+                           struct ble_store_value_cccd *value)
+{
+    if (key->peer_addr_type != BLE_STORE_ADDR_TYPE_NONE) {
+        if (value->peer_addr_type != key->peer_addr_type) {
+            return 0;
+        }
+
+        if (memcmp(value->peer_addr, key->peer_addr, 6) != 0) {
+            return 0;
+        }
+    }
+
+    if (key->chr_val_handle != 0) {
+        if (value->chr_val_handle != key->chr_val_handle) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Finds the entry matching the specified key.  Entries with a pending
+ * tombstone are only returned if include_deleted is set; they are never
+ * counted against the key's idx.
+ *
+ * @return                      The index of the matching entry; -1 if there
+ *                                  is no match.
+ */
+static int
+ble_store_fcb_find(struct ble_store_fcb_table *table, union ble_store_key *key,
+                   int include_deleted)
+{
+    struct ble_store_fcb_entry *entry;
+    int matches;
+    int skipped;
+    int idx;
+    int i;
+
+    switch (table->obj_type) {
+    case BLE_STORE_OBJ_TYPE_CCCD:
+        idx = key->cccd.idx;
+        break;
+
+    default:
+        idx = key->sec.idx;
+        break;
+    }
+
+    skipped = 0;
+    for (i = 0; i < table->num; i++) {
+        entry = table->entries + i;
+
+        if (entry->flags & BLE_STORE_FCB_F_DELETED && !include_deleted) {
+            continue;
+        }
+
+        switch (table->obj_type) {
+        case BLE_STORE_OBJ_TYPE_CCCD:
+            matches = ble_store_fcb_cccd_matches(&key->cccd,
+                                                 &entry->value.cccd);
+            break;
+
+        default:
+            matches = ble_store_fcb_sec_matches(&key->sec, &entry->value.sec);
+            break;
+        }
+
+        if (!matches) {
+            continue;
+        }
+
+        if (idx > skipped) {
+            skipped++;
+            continue;
+        }
+
+        return i;
+    }
+
+    return -1;
+}
+
+static void
+ble_store_fcb_key_from_value(int obj_type, union ble_store_key *key,
+                             union ble_store_value *value)
+{
+    switch (obj_type) {
+    case BLE_STORE_OBJ_TYPE_CCCD:
+        ble_store_key_from_value_cccd(&key->cccd, &value->cccd);
+        break;
+
+    default:
+        ble_store_key_from_value_sec(&key->sec, &value->sec);
+        break;
+    }
+}
+
+static void
+ble_store_fcb_remove(struct ble_store_fcb_table *table, int idx)
+{
+    /* Preserve the order of the remaining entries; the host iterates the
+     * store by index.
+     */
+    table->num--;
+    memmove(table->entries + idx, table->entries + idx + 1,
+            (table->num - idx) * sizeof *table->entries);
+}
+
+/**
+ * Inserts or updates the entry corresponding to the specified value.
+ *
+ * @return                      The index of the entry; -1 if the table is
+ *                                  full.
+ */
+static int
+ble_store_fcb_upsert(struct ble_store_fcb_table *table,
+                     union ble_store_value *value)
+{
+    struct ble_store_fcb_entry *entry;
+    union ble_store_key key;
+    int idx;
+
+    ble_store_fcb_key_from_value(table->obj_type, &key, value);
+    idx = ble_store_fcb_find(table, &key, 1);
+    if (idx == -1) {
+        if (table->num >= table->max) {
+            return -1;
+        }
+
+        idx = table->num++;
+        entry = table->entries + idx;
+        memset(entry, 0, sizeof *entry);
+    } else {
+        entry = table->entries + idx;
+    }
+
+    entry->value = *value;
+    return idx;
+}
+
+/*****************************************************************************
+ * $flash                                                                    *
+ *****************************************************************************/
+
+static int
+ble_store_fcb_append_rec(struct ble_store_fcb_rec *rec, struct fcb_entry *loc)
+{
+    int rc;
+
+    rc = fcb_append(&ble_store_fcb_fcb, sizeof *rec, loc);
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = flash_area_write(loc->fe_area, loc->fe_data_off, rec, sizeof *rec);
+    if (rc != 0) {
+        return FCB_ERR_FLASH;
+    }
+
+    rc = fcb_append_finish(&ble_store_fcb_fcb, loc);
+    return rc;
+}
+
+static void
+ble_store_fcb_fill_rec(struct ble_store_fcb_rec *rec, int obj_type,
+                       union ble_store_value *value, uint8_t flags)
+{
+    memset(rec, 0, sizeof *rec);
+    rec->obj_type = obj_type;
+    rec->flags = flags;
+    rec->value = *value;
+}
+
+/**
+ * Frees the oldest sector.  Live objects recorded there are re-appended to
+ * the scratch sector from their RAM copies; this also writes out any pending
+ * change to those objects.  Superseded records, tombstones, and objects with
+ * a pending tombstone are dropped.
+ */
+static int
+ble_store_fcb_compress(void)
+{
+    struct ble_store_fcb_table *table;
+    struct ble_store_fcb_entry *entry;
+    struct ble_store_fcb_rec rec;
+    struct flash_area *oldest;
+    int rc;
+    int i;
+    int j;
+
+    rc = fcb_append_to_scratch(&ble_store_fcb_fcb);
+    if (rc != 0) {
+        return rc;
+    }
+
+    oldest = ble_store_fcb_fcb.f_oldest;
+    for (i = 0; i < BLE_STORE_FCB_NUM_TABLES; i++) {
+        table = ble_store_fcb_tables + i;
+        for (j = 0; j < table->num; j++) {
+            entry = table->entries + j;
+            if (entry->loc.fe_area != oldest) {
+                continue;
+            }
+
+            if (entry->flags & BLE_STORE_FCB_F_DELETED) {
+                /* The record is about to be erased; no tombstone needed. */
+                entry->loc.fe_area = NULL;
+                continue;
+            }
+
+            ble_store_fcb_fill_rec(&rec, table->obj_type, &entry->value, 0);
+            rc = ble_store_fcb_append_rec(&rec, &entry->loc);
+            if (rc != 0) {
+                return rc;
+            }
+            entry->flags &= ~BLE_STORE_FCB_F_DIRTY;
+        }
+    }
+
+    rc = fcb_rotate(&ble_store_fcb_fcb);
+    return rc;
+}
+
+/**
+ * Writes the current state of the specified entry to flash.  If the entry
+ * has a pending tombstone, it is removed from its table.
+ */
+static int
+ble_store_fcb_persist(struct ble_store_fcb_table *table, int idx)
+{
+    struct ble_store_fcb_entry *entry;
+    struct ble_store_fcb_rec rec;
+    struct fcb_entry loc;
+    int compressed;
+    uint8_t flags;
+    int rc;
+
+    entry = table->entries + idx;
+    compressed = 0;
+
+    while (1) {
+        if (entry->flags & BLE_STORE_FCB_F_DELETED) {
+            if (entry->loc.fe_area == NULL) {
+                /* Never reached flash; nothing to delete. */
+                ble_store_fcb_remove(table, idx);
+                return 0;
+            }
+            flags = BLE_STORE_FCB_REC_F_TOMBSTONE;
+        } else {
+            if (!(entry->flags & BLE_STORE_FCB_F_DIRTY)) {
+                /* Written out by a compaction. */
+                return 0;
+            }
+            flags = 0;
+        }
+
+        ble_store_fcb_fill_rec(&rec, table->obj_type, &entry->value, flags);
+        rc = ble_store_fcb_append_rec(&rec, &loc);
+        if (rc != FCB_ERR_NOSPACE || compressed) {
+            break;
+        }
+
+        rc = ble_store_fcb_compress();
+        if (rc != 0) {
+            break;
+        }
+        compressed = 1;
+    }
+
+    if (rc != 0) {
+        BLE_HS_LOG(ERROR, "error persisting store object; obj_type=%d "
+                          "rc=%d\n", table->obj_type, rc);
+        return BLE_HS_EOS;
+    }
+
+    if (flags & BLE_STORE_FCB_REC_F_TOMBSTONE) {
+        ble_store_fcb_remove(table, idx);
+    } else {
+        entry->loc = loc;
+        entry->flags &= ~BLE_STORE_FCB_F_DIRTY;
+    }
+
+    return 0;
+}
+
+/**
+ * Writes all pending changes to flash.  Must be called with the store mutex
+ * held.
+ */
+static int
+ble_store_fcb_flush_locked(void)
+{
+    struct ble_store_fcb_table *table;
+    int first_rc;
+    int rc;
+    int i;
+    int j;
+
+    first_rc = 0;
+    for (i = 0; i < BLE_STORE_FCB_NUM_TABLES; i++) {
+        table = ble_store_fcb_tables + i;
+
+        /* Iterate backwards; persisting a tombstone removes the entry. */
+        for (j = table->num - 1; j >= 0; j--) {
+            if (!(table->entries[j].flags &
+                  (BLE_STORE_FCB_F_DIRTY | BLE_STORE_FCB_F_DELETED))) {
+                continue;
+            }
+
+            rc = ble_store_fcb_persist(table, j);
+            if (rc != 0 && first_rc == 0) {
+                first_rc = rc;
+            }
+        }
+    }
+
+    /* Compact in the background while the scratch sector is the only free
+     * one, so that a later bond write does not pay for it.
+     */
+    if (fcb_free_sector_cnt(&ble_store_fcb_fcb) <=
+        ble_store_fcb_fcb.f_scratch_cnt) {
+
+        rc = ble_store_fcb_compress();
+        if (rc != 0 && first_rc == 0) {
+            first_rc = BLE_HS_EOS;
+        }
+    }
+
+    return first_rc;
+}
+
+static void
+ble_store_fcb_flush_sched(os_time_t ticks)
+{
+    if (!os_callout_queued(&ble_store_fcb_flush_timer)) {
+        os_callout_reset(&ble_store_fcb_flush_timer, ticks);
+    }
+}
+
+static void
+ble_store_fcb_flush_event_cb(struct os_event *ev)
+{
+    ble_store_fcb_flush();
+}
+
+/*****************************************************************************
+ * $restore                                                                  *
+ *****************************************************************************/
+
+static int
+ble_store_fcb_restore_cb(struct fcb_entry *loc, void *arg)
+{
+    struct ble_store_fcb_table *table;
+    struct ble_store_fcb_rec rec;
+    union ble_store_key key;
+    int idx;
+    int rc;
+
+    if (loc->fe_data_len != sizeof rec) {
+        return 0;
+    }
+
+    rc = flash_area_read(loc->fe_area, loc->fe_data_off, &rec, sizeof rec);
+    if (rc != 0) {
+        return 0;
+    }
+
+    table = ble_store_fcb_table_find(rec.obj_type);
+    if (table == NULL) {
+        return 0;
+    }
+
+    if (rec.flags & BLE_STORE_FCB_REC_F_TOMBSTONE) {
+        ble_store_fcb_key_from_value(rec.obj_type, &key, &rec.value);
+        idx = ble_store_fcb_find(table, &key, 1);
+        if (idx != -1) {
+            ble_store_fcb_remove(table, idx);
+        }
+    } else {
+        idx = ble_store_fcb_upsert(table, &rec.value);
+        if (idx == -1) {
+            BLE_HS_LOG(ERROR, "dropping persisted store object; table full; "
+                              "obj_type=%d\n", rec.obj_type);
+        } else {
+            table->entries[idx].loc = *loc;
+        }
+    }
+
+    return 0;
+}
+
+/*****************************************************************************
+ * $api                                                                      *
+ *****************************************************************************/
+
+/**
+ * Searches the database for an object matching the specified criteria.  This
+ * function only consults the RAM copy of the database.
+ *
+ * @return                      0 if a key was found; else BLE_HS_ENOENT.
+ */
+int
+ble_store_fcb_read(int obj_type, union ble_store_key *key,
+                   union ble_store_value *value)
+{
+    struct ble_store_fcb_table *table;
+    int idx;
+    int rc;
+
+    table = ble_store_fcb_table_find(obj_type);
+    if (table == NULL) {
+        return BLE_HS_ENOTSUP;
+    }
+
+    os_mutex_pend(&ble_store_fcb_mutex, OS_TIMEOUT_NEVER);
+
+    idx = ble_store_fcb_find(table, key, 0);
+    if (idx == -1) {
+        rc = BLE_HS_ENOENT;
+    } else {
+        *value = table->entries[idx].value;
+        rc = 0;
+    }
+
+    os_mutex_release(&ble_store_fcb_mutex);
+
+    return rc;
+}
+
+/**
+ * Adds the specified object to the database.  Security objects are written
+ * to flash before this function returns; CCCDs are written after
+ * BLE_STORE_FCB_CCCD_FLUSH_MS milliseconds, or on ble_store_fcb_flush().
+ *
+ * @return                      0 on success;
+ *                              BLE_HS_ENOMEM if the database is full;
+ *                              BLE_HS_EOS if the object could not be
+ *                                  written to flash.
+ */
+int
+ble_store_fcb_write(int obj_type, union ble_store_value *val)
+{
+    struct ble_store_fcb_table *table;
+    struct ble_store_fcb_entry *entry;
+    union ble_store_key key;
+    int idx;
+    int rc;
+
+    table = ble_store_fcb_table_find(obj_type);
+    if (table == NULL) {
+        return BLE_HS_ENOTSUP;
+    }
+
+    os_mutex_pend(&ble_store_fcb_mutex, OS_TIMEOUT_NEVER);
+
+    ble_store_fcb_key_from_value(obj_type, &key, val);
+    idx = ble_store_fcb_find(table, &key, 1);
+    if (idx != -1) {
+        entry = table->entries + idx;
+        if (!(entry->flags & BLE_STORE_FCB_F_DELETED) &&
+            memcmp(&entry->value, val, sizeof *val) == 0) {
+
+            /* Unchanged; don't wear the flash. */
+            rc = 0;
+            goto done;
+        }
+    }
+
+    idx = ble_store_fcb_upsert(table, val);
+    if (idx == -1) {
+        BLE_HS_LOG(DEBUG, "error persisting store object; too many entries; "
+                          "obj_type=%d\n", obj_type);
+        rc = BLE_HS_ENOMEM;
+        goto done;
+    }
+
+    entry = table->entries + idx;
+    entry->flags &= ~BLE_STORE_FCB_F_DELETED;
+    entry->flags |= BLE_STORE_FCB_F_DIRTY;
+
+    if (obj_type == BLE_STORE_OBJ_TYPE_CCCD) {
+        ble_store_fcb_flush_sched(BLE_STORE_FCB_CCCD_FLUSH_TICKS);
+        rc = 0;
+    } else {
+        rc = ble_store_fcb_persist(table, idx);
+        if (fcb_free_sector_cnt(&ble_store_fcb_fcb) <=
+            ble_store_fcb_fcb.f_scratch_cnt) {
+
+            ble_store_fcb_flush_sched(0);
+        }
+    }
+
+done:
+    os_mutex_release(&ble_store_fcb_mutex);
+
+    return rc;
+}
+
+/**
+ * Deletes the first object matching the specified criteria.  Deleting a
+ * security object is immediately recorded in flash; CCCD deletions are
+ * deferred like CCCD writes.
+ *
+ * @return                      0 if an object was deleted;
+ *                              BLE_HS_ENOENT if no matching object was found;
+ *                              BLE_HS_EOS if the deletion could not be
+ *                                  written to flash.
+ */
+int
+ble_store_fcb_delete(int obj_type, union ble_store_key *key)
+{
+    struct ble_store_fcb_table *table;
+    int idx;
+    int rc;
+
+    table = ble_store_fcb_table_find(obj_type);
+    if (table == NULL) {
+        return BLE_HS_ENOTSUP;
+    }
+
+    os_mutex_pend(&ble_store_fcb_mutex, OS_TIMEOUT_NEVER);
+
+    idx = ble_store_fcb_find(table, key, 0);
+    if (idx == -1) {
+        rc = BLE_HS_ENOENT;
+        goto done;
+    }
+
+    table->entries[idx].flags |= BLE_STORE_FCB_F_DELETED;
+
+    if (obj_type == BLE_STORE_OBJ_TYPE_CCCD) {
+        ble_store_fcb_flush_sched(BLE_STORE_FCB_CCCD_FLUSH_TICKS);
+        rc = 0;
+    } else {
+        rc = ble_store_fcb_persist(table, idx);
+    }
+
+done:
+    os_mutex_release(&ble_store_fcb_mutex);
+
+    return rc;
+}
+
+/**
+ * Writes all pending CCCD changes to flash.  Applications should call this
+ * before a planned reset or power-down.
+ *
+ * @return                      0 on success; BLE_HS_EOS if an object could
+ *                                  not be written to flash.
+ */
+int
+ble_store_fcb_flush(void)
+{
+    int rc;
+
+    os_mutex_pend(&ble_store_fcb_mutex, OS_TIMEOUT_NEVER);
+    os_callout_stop(&ble_store_fcb_flush_timer);
+    rc = ble_store_fcb_flush_locked();
+    os_mutex_release(&ble_store_fcb_mutex);
+
+    return rc;
+}
+
+void
+ble_store_fcb_init(void)
+{
+    int cnt;
+    int rc;
+
+    rc = os_mutex_init(&ble_store_fcb_mutex);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    os_callout_init(&ble_store_fcb_flush_timer, os_eventq_dflt_get(),
+                    ble_store_fcb_flush_event_cb, NULL);
+
+    rc = flash_area_to_sectors(MYNEWT_VAL(BLE_STORE_FCB_FLASH_AREA), &cnt,
+                               NULL);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+    SYSINIT_PANIC_ASSERT(
+        cnt <= sizeof ble_store_fcb_area / sizeof ble_store_fcb_area[0]);
+    flash_area_to_sectors(MYNEWT_VAL(BLE_STORE_FCB_FLASH_AREA), &cnt,
+                          ble_store_fcb_area);
+    ble_store_fcb_fcb.f_sector_cnt = cnt;
+
+    rc = fcb_init(&ble_store_fcb_fcb);
+    if (rc != 0) {
+        /* Unformatted or corrupt; start over with an empty store. */
+        for (cnt = 0; cnt < ble_store_fcb_fcb.f_sector_cnt; cnt++) {
+            flash_area_erase(&ble_store_fcb_area[cnt], 0,
+                             ble_store_fcb_area[cnt].fa_size);
+        }
+        rc = fcb_init(&ble_store_fcb_fcb);
+    }
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    rc = fcb_walk(&ble_store_fcb_fcb, NULL, ble_store_fcb_restore_cb, NULL);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    ble_hs_cfg.store_read_cb = ble_store_fcb_read;
+    ble_hs_cfg.store_write_cb = ble_store_fcb_write;
+    ble_hs_cfg.store_delete_cb = ble_store_fcb_delete;
+}
@@ -30,6 +30,9 @@ union ble_store_value;
 int ble_store_ram_read(int obj_type, union ble_store_key *key,
                        union ble_store_value *value);
 int ble_store_ram_write(int obj_type, union ble_store_value *val);
+int ble_store_ram_delete(int obj_type, union ble_store_key *key);
+
+void ble_store_ram_init(void);
 
 #ifdef __cplusplus
 }
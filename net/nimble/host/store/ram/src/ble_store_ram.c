@@ -19,29 +19,154 @@
 
 /**
  * This file implements a simple in-RAM key database for BLE host security
- * material and CCCDs.  As this database is only ble_store_ramd in RAM, its
+ * material, CCCDs, and cached GATT discovery results.  As this database is only ble_store_ramd in RAM, its
  * contents are lost when the application terminates.
  */
 
 #include <inttypes.h>
 #include <string.h>
 
+#include "syscfg/syscfg.h"
 #include "host/ble_hs.h"
 #include "store/ram/ble_store_ram.h"
 
-/* XXX: This should be configurable. */
-#define STORE_MAX_SLV_LTKS   4
-#define STORE_MAX_MST_LTKS   4
-#define STORE_MAX_CCCDS      16
+#define STORE_MAX_GATT_DISCS 64
 
-static struct ble_store_value_sec ble_store_ram_our_secs[STORE_MAX_SLV_LTKS];
-static int ble_store_ram_num_our_secs;
+/**
+ * Security entries and CCCDs are located through hash indexes rather than by
+ * scanning the whole array.  Each bucket heads a chain of array entries linked
+ * through a parallel "next" array.  Links are stored as array index + 1, so a
+ * zeroed index is empty.  Chains are kept in ascending array order; the nth
+ * match found by walking a chain is therefore the nth match in the array, as
+ * required by the key's idx field.  The bucket count equals the table
+ * capacity.
+ */
+#define BLE_STORE_RAM_IDX_END   0
+
+struct ble_store_ram_secs {
+    struct ble_store_value_sec values[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
+    int num;
+
+    /* Indexed by peer address. */
+    uint16_t addr_heads[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
+    uint16_t addr_next[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
+
+    /* Indexed by EDIV and Rand. */
+    uint16_t ediv_heads[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
+    uint16_t ediv_next[MYNEWT_VAL(BLE_STORE_MAX_BONDS)];
+};
+
+static struct ble_store_ram_secs ble_store_ram_our_secs;
+static struct ble_store_ram_secs ble_store_ram_peer_secs;
+
+struct ble_store_ram_cccds {
+    struct ble_store_value_cccd values[MYNEWT_VAL(BLE_STORE_MAX_CCCDS)];
+    int num;
+
+    /* Indexed by peer address. */
+    uint16_t addr_heads[MYNEWT_VAL(BLE_STORE_MAX_CCCDS)];
+    uint16_t addr_next[MYNEWT_VAL(BLE_STORE_MAX_CCCDS)];
+
+    /* Indexed by characteristic value handle. */
+    uint16_t handle_heads[MYNEWT_VAL(BLE_STORE_MAX_CCCDS)];
+    uint16_t handle_next[MYNEWT_VAL(BLE_STORE_MAX_CCCDS)];
+};
+
+static struct ble_store_ram_cccds ble_store_ram_cccds;
+
+#if MYNEWT_VAL(BLE_GATT_DISC_CACHE)
+static struct ble_store_value_gatt_disc
+    ble_store_ram_gatt_discs[STORE_MAX_GATT_DISCS];
+static int ble_store_ram_num_gatt_discs;
+#endif
+
+/*****************************************************************************
+ * $index                                                                    *
+ *****************************************************************************/
+
+/**
+ * FNV-1a; continues the hash h over the specified bytes.
+ */
+static uint32_t
+ble_store_ram_hash(uint32_t h, const void *data, int len)
+{
+    const uint8_t *u8p;
+    int i;
+
+    u8p = data;
+    for (i = 0; i < len; i++) {
+        h ^= u8p[i];
+        h *= 16777619;
+    }
+
+    return h;
+}
+
+static int
+ble_store_ram_hash_addr(uint8_t addr_type, const uint8_t *addr, int size)
+{
+    uint32_t h;
+
+    h = ble_store_ram_hash(2166136261UL, &addr_type, 1);
+    h = ble_store_ram_hash(h, addr, 6);
+    return h % size;
+}
 
-static struct ble_store_value_sec ble_store_ram_peer_secs[STORE_MAX_MST_LTKS];
-static int ble_store_ram_num_peer_secs;
+static int
+ble_store_ram_hash_ediv(uint16_t ediv, uint64_t rand_num, int size)
+{
+    uint32_t h;
+
+    h = ble_store_ram_hash(2166136261UL, &ediv, sizeof ediv);
+    h = ble_store_ram_hash(h, &rand_num, sizeof rand_num);
+    return h % size;
+}
+
+static int
+ble_store_ram_hash_handle(uint16_t handle, int size)
+{
+    uint32_t h;
+
+    h = ble_store_ram_hash(2166136261UL, &handle, sizeof handle);
+    return h % size;
+}
+
+/**
+ * Appends the specified array entry to the tail of a bucket's chain.  Entries
+ * are always inserted in ascending order, keeping the chain sorted.
+ */
+static void
+ble_store_ram_idx_insert(uint16_t *heads, uint16_t *next, int bucket,
+                         int entry)
+{
+    uint16_t *link;
 
-static struct ble_store_value_cccd ble_store_ram_cccds[STORE_MAX_CCCDS];
-static int ble_store_ram_num_cccds;
+    link = heads + bucket;
+    while (*link != BLE_STORE_RAM_IDX_END) {
+        link = next + *link - 1;
+    }
+
+    *link = entry + 1;
+    next[entry] = BLE_STORE_RAM_IDX_END;
+}
+
+/**
+ * Returns the array index following the specified one during a lookup, or -1
+ * if there are no more candidates.  A NULL chain indicates a full scan.
+ */
+static int
+ble_store_ram_idx_step(const uint16_t *chain, int entry, int num)
+{
+    if (chain != NULL) {
+        return (int)chain[entry] - 1;
+    }
+
+    if (entry + 1 < num) {
+        return entry + 1;
+    }
+
+    return -1;
+}
 
 /*****************************************************************************
  * $sec                                                                      *
@@ -85,18 +210,58 @@ ble_store_ram_print_key_sec(struct ble_store_key_sec *key_sec)
     }
 }
 
+static void
+ble_store_ram_index_sec(struct ble_store_ram_secs *secs, int entry)
+{
+    struct ble_store_value_sec *sec;
+    int size;
+
+    sec = secs->values + entry;
+    size = MYNEWT_VAL(BLE_STORE_MAX_BONDS);
+
+    ble_store_ram_idx_insert(secs->addr_heads, secs->addr_next,
+                             ble_store_ram_hash_addr(sec->peer_addr_type,
+                                                     sec->peer_addr, size),
+                             entry);
+    ble_store_ram_idx_insert(secs->ediv_heads, secs->ediv_next,
+                             ble_store_ram_hash_ediv(sec->ediv, sec->rand_num,
+                                                     size),
+                             entry);
+}
+
 static int
 ble_store_ram_find_sec(struct ble_store_key_sec *key_sec,
-                   struct ble_store_value_sec *value_secs, int num_value_secs)
+                       struct ble_store_ram_secs *secs)
 {
     struct ble_store_value_sec *cur;
+    const uint16_t *chain;
     int skipped;
+    int size;
     int i;
 
+    size = MYNEWT_VAL(BLE_STORE_MAX_BONDS);
+
+    /* Walk the most selective index the key allows; an empty key matches
+     * everything and requires a full scan.
+     */
+    if (key_sec->ediv_rand_present) {
+        i = ble_store_ram_hash_ediv(key_sec->ediv, key_sec->rand_num, size);
+        i = (int)secs->ediv_heads[i] - 1;
+        chain = secs->ediv_next;
+    } else if (key_sec->peer_addr_type != BLE_STORE_ADDR_TYPE_NONE) {
+        i = ble_store_ram_hash_addr(key_sec->peer_addr_type,
+                                    key_sec->peer_addr, size);
+        i = (int)secs->addr_heads[i] - 1;
+        chain = secs->addr_next;
+    } else {
+        i = secs->num > 0 ? 0 : -1;
+        chain = NULL;
+    }
+
     skipped = 0;
 
-    for (i = 0; i < num_value_secs; i++) {
-        cur = value_secs + i;
+    for (; i != -1; i = ble_store_ram_idx_step(chain, i, secs->num)) {
+        cur = secs->values + i;
 
         if (key_sec->peer_addr_type != BLE_STORE_ADDR_TYPE_NONE) {
             if (cur->peer_addr_type != key_sec->peer_addr_type) {
@@ -131,105 +296,170 @@ ble_store_ram_find_sec(struct ble_store_key_sec *key_sec,
 }
 
 static int
-ble_store_ram_read_our_sec(struct ble_store_key_sec *key_sec,
-                       struct ble_store_value_sec *value_sec)
+ble_store_ram_read_sec(struct ble_store_key_sec *key_sec,
+                       struct ble_store_value_sec *value_sec,
+                       struct ble_store_ram_secs *secs)
 {
     int idx;
 
-    idx = ble_store_ram_find_sec(key_sec, ble_store_ram_our_secs,
-                                 ble_store_ram_num_our_secs);
+    idx = ble_store_ram_find_sec(key_sec, secs);
     if (idx == -1) {
         return BLE_HS_ENOENT;
     }
 
-    *value_sec = ble_store_ram_our_secs[idx];
+    *value_sec = secs->values[idx];
     return 0;
 }
 
 static int
-ble_store_ram_write_our_sec(struct ble_store_value_sec *value_sec)
+ble_store_ram_write_sec(struct ble_store_value_sec *value_sec,
+                        struct ble_store_ram_secs *secs)
 {
     struct ble_store_key_sec key_sec;
     int idx;
 
-    BLE_HS_LOG(DEBUG, "persisting our sec; ");
-    ble_store_ram_print_value_sec(value_sec);
-
     ble_store_key_from_value_sec(&key_sec, value_sec);
-    idx = ble_store_ram_find_sec(&key_sec, ble_store_ram_our_secs,
-                             ble_store_ram_num_our_secs);
+    idx = ble_store_ram_find_sec(&key_sec, secs);
     if (idx == -1) {
-        if (ble_store_ram_num_our_secs >= STORE_MAX_SLV_LTKS) {
-            BLE_HS_LOG(DEBUG, "error persisting our sec; too many entries "
-                              "(%d)\n", ble_store_ram_num_our_secs);
+        if (secs->num >= MYNEWT_VAL(BLE_STORE_MAX_BONDS)) {
+            BLE_HS_LOG(DEBUG, "error persisting sec; too many entries "
+                              "(%d)\n", secs->num);
             return BLE_HS_ENOMEM;
         }
 
-        idx = ble_store_ram_num_our_secs;
-        ble_store_ram_num_our_secs++;
+        idx = secs->num;
+        secs->num++;
+
+        secs->values[idx] = *value_sec;
+        ble_store_ram_index_sec(secs, idx);
+        return 0;
     }
 
-    ble_store_ram_our_secs[idx] = *value_sec;
+    /* An existing entry is only replaced by a value with the same key, so
+     * its index positions remain valid.
+     */
+    secs->values[idx] = *value_sec;
     return 0;
 }
 
 static int
-ble_store_ram_read_peer_sec(struct ble_store_key_sec *key_sec,
-                        struct ble_store_value_sec *value_sec)
+ble_store_ram_delete_sec(struct ble_store_key_sec *key_sec,
+                         struct ble_store_ram_secs *secs)
 {
     int idx;
+    int i;
 
-    idx = ble_store_ram_find_sec(key_sec, ble_store_ram_peer_secs,
-                             ble_store_ram_num_peer_secs);
+    idx = ble_store_ram_find_sec(key_sec, secs);
     if (idx == -1) {
         return BLE_HS_ENOENT;
     }
 
-    *value_sec = ble_store_ram_peer_secs[idx];
+    /* Close the gap, keeping the remaining entries in order, and rebuild the
+     * indexes; every entry after the deleted one has moved.
+     */
+    secs->num--;
+    memmove(secs->values + idx, secs->values + idx + 1,
+            (secs->num - idx) * sizeof *secs->values);
+
+    memset(secs->addr_heads, 0, sizeof secs->addr_heads);
+    memset(secs->ediv_heads, 0, sizeof secs->ediv_heads);
+    for (i = 0; i < secs->num; i++) {
+        ble_store_ram_index_sec(secs, i);
+    }
+
     return 0;
 }
 
 static int
-ble_store_ram_write_peer_sec(struct ble_store_value_sec *value_sec)
+ble_store_ram_read_our_sec(struct ble_store_key_sec *key_sec,
+                           struct ble_store_value_sec *value_sec)
 {
-    struct ble_store_key_sec key_sec;
-    int idx;
+    return ble_store_ram_read_sec(key_sec, value_sec, &ble_store_ram_our_secs);
+}
 
-    BLE_HS_LOG(DEBUG, "persisting peer sec; ");
+static int
+ble_store_ram_write_our_sec(struct ble_store_value_sec *value_sec)
+{
+    BLE_HS_LOG(DEBUG, "persisting our sec; ");
     ble_store_ram_print_value_sec(value_sec);
 
-    ble_store_key_from_value_sec(&key_sec, value_sec);
-    idx = ble_store_ram_find_sec(&key_sec, ble_store_ram_peer_secs,
-                             ble_store_ram_num_peer_secs);
-    if (idx == -1) {
-        if (ble_store_ram_num_peer_secs >= STORE_MAX_MST_LTKS) {
-            BLE_HS_LOG(DEBUG, "error persisting peer sec; too many entries "
-                             "(%d)\n", ble_store_ram_num_peer_secs);
-            return BLE_HS_ENOMEM;
-        }
+    return ble_store_ram_write_sec(value_sec, &ble_store_ram_our_secs);
+}
 
-        idx = ble_store_ram_num_peer_secs;
-        ble_store_ram_num_peer_secs++;
-    }
+static int
+ble_store_ram_read_peer_sec(struct ble_store_key_sec *key_sec,
+                            struct ble_store_value_sec *value_sec)
+{
+    return ble_store_ram_read_sec(key_sec, value_sec,
+                                  &ble_store_ram_peer_secs);
+}
 
-    ble_store_ram_peer_secs[idx] = *value_sec;
-    return 0;
+static int
+ble_store_ram_write_peer_sec(struct ble_store_value_sec *value_sec)
+{
+    BLE_HS_LOG(DEBUG, "persisting peer sec; ");
+    ble_store_ram_print_value_sec(value_sec);
+
+    return ble_store_ram_write_sec(value_sec, &ble_store_ram_peer_secs);
 }
 
 /*****************************************************************************
  * $cccd                                                                     *
  *****************************************************************************/
 
+static void
+ble_store_ram_index_cccd(int entry)
+{
+    struct ble_store_ram_cccds *cccds;
+    struct ble_store_value_cccd *cccd;
+    int size;
+
+    cccds = &ble_store_ram_cccds;
+    cccd = cccds->values + entry;
+    size = MYNEWT_VAL(BLE_STORE_MAX_CCCDS);
+
+    ble_store_ram_idx_insert(cccds->addr_heads, cccds->addr_next,
+                             ble_store_ram_hash_addr(cccd->peer_addr_type,
+                                                     cccd->peer_addr, size),
+                             entry);
+    ble_store_ram_idx_insert(cccds->handle_heads, cccds->handle_next,
+                             ble_store_ram_hash_handle(cccd->chr_val_handle,
+                                                       size),
+                             entry);
+}
+
 static int
 ble_store_ram_find_cccd(struct ble_store_key_cccd *key)
 {
+    struct ble_store_ram_cccds *cccds;
     struct ble_store_value_cccd *cccd;
+    const uint16_t *chain;
     int skipped;
+    int size;
     int i;
 
+    cccds = &ble_store_ram_cccds;
+    size = MYNEWT_VAL(BLE_STORE_MAX_CCCDS);
+
+    /* A handle identifies at most one entry per peer, so prefer the handle
+     * index when both fields are specified.
+     */
+    if (key->chr_val_handle != 0) {
+        i = ble_store_ram_hash_handle(key->chr_val_handle, size);
+        i = (int)cccds->handle_heads[i] - 1;
+        chain = cccds->handle_next;
+    } else if (key->peer_addr_type != BLE_STORE_ADDR_TYPE_NONE) {
+        i = ble_store_ram_hash_addr(key->peer_addr_type, key->peer_addr, size);
+        i = (int)cccds->addr_heads[i] - 1;
+        chain = cccds->addr_next;
+    } else {
+        i = cccds->num > 0 ? 0 : -1;
+        chain = NULL;
+    }
+
     skipped = 0;
-    for (i = 0; i < ble_store_ram_num_cccds; i++) {
-        cccd = ble_store_ram_cccds + i;
+    for (; i != -1; i = ble_store_ram_idx_step(chain, i, cccds->num)) {
+        cccd = cccds->values + i;
 
         if (key->peer_addr_type != BLE_STORE_ADDR_TYPE_NONE) {
             if (cccd->peer_addr_type != key->peer_addr_type) {
@@ -269,7 +499,7 @@ ble_store_ram_read_cccd(struct ble_store_key_cccd *key_cccd,
         return BLE_HS_ENOENT;
     }
 
-    *value_cccd = ble_store_ram_cccds[idx];
+    *value_cccd = ble_store_ram_cccds.values[idx];
     return 0;
 }
 
@@ -282,20 +512,161 @@ ble_store_ram_write_cccd(struct ble_store_value_cccd *value_cccd)
     ble_store_key_from_value_cccd(&key_cccd, value_cccd);
     idx = ble_store_ram_find_cccd(&key_cccd);
     if (idx == -1) {
-        if (ble_store_ram_num_cccds >= STORE_MAX_SLV_LTKS) {
+        if (ble_store_ram_cccds.num >= MYNEWT_VAL(BLE_STORE_MAX_CCCDS)) {
             BLE_HS_LOG(DEBUG, "error persisting cccd; too many entries (%d)\n",
-                       ble_store_ram_num_cccds);
+                       ble_store_ram_cccds.num);
             return BLE_HS_ENOMEM;
         }
 
-        idx = ble_store_ram_num_cccds;
-        ble_store_ram_num_cccds++;
+        idx = ble_store_ram_cccds.num;
+        ble_store_ram_cccds.num++;
+
+        ble_store_ram_cccds.values[idx] = *value_cccd;
+        ble_store_ram_index_cccd(idx);
+        return 0;
+    }
+
+    ble_store_ram_cccds.values[idx] = *value_cccd;
+    return 0;
+}
+
+static int
+ble_store_ram_delete_cccd(struct ble_store_key_cccd *key_cccd)
+{
+    struct ble_store_ram_cccds *cccds;
+    int idx;
+    int i;
+
+    cccds = &ble_store_ram_cccds;
+
+    idx = ble_store_ram_find_cccd(key_cccd);
+    if (idx == -1) {
+        return BLE_HS_ENOENT;
+    }
+
+    cccds->num--;
+    memmove(cccds->values + idx, cccds->values + idx + 1,
+            (cccds->num - idx) * sizeof *cccds->values);
+
+    memset(cccds->addr_heads, 0, sizeof cccds->addr_heads);
+    memset(cccds->handle_heads, 0, sizeof cccds->handle_heads);
+    for (i = 0; i < cccds->num; i++) {
+        ble_store_ram_index_cccd(i);
     }
 
-    ble_store_ram_cccds[idx] = *value_cccd;
     return 0;
 }
 
+/*****************************************************************************
+ * $gatt disc                                                                *
+ *****************************************************************************/
+
+#if MYNEWT_VAL(BLE_GATT_DISC_CACHE)
+
+static int
+ble_store_ram_find_gatt_disc(struct ble_store_key_gatt_disc *key)
+{
+    struct ble_store_value_gatt_disc *disc;
+    int skipped;
+    int i;
+
+    skipped = 0;
+    for (i = 0; i < ble_store_ram_num_gatt_discs; i++) {
+        disc = ble_store_ram_gatt_discs + i;
+
+        if (key->peer_addr_type != BLE_STORE_ADDR_TYPE_NONE) {
+            if (disc->peer_addr_type != key->peer_addr_type) {
+                continue;
+            }
+
+            if (memcmp(disc->peer_addr, key->peer_addr, 6) != 0) {
+                continue;
+            }
+        }
+
+        if (key->kind != 0) {
+            if (disc->kind != key->kind) {
+                continue;
+            }
+        }
+
+        if (key->handle != 0) {
+            if (disc->handle != key->handle) {
+                continue;
+            }
+        }
+
+        if (key->idx > skipped) {
+            skipped++;
+            continue;
+        }
+
+        return i;
+    }
+
+    return -1;
+}
+
+static int
+ble_store_ram_read_gatt_disc(struct ble_store_key_gatt_disc *key,
+                             struct ble_store_value_gatt_disc *value)
+{
+    int idx;
+
+    idx = ble_store_ram_find_gatt_disc(key);
+    if (idx == -1) {
+        return BLE_HS_ENOENT;
+    }
+
+    *value = ble_store_ram_gatt_discs[idx];
+    return 0;
+}
+
+static int
+ble_store_ram_write_gatt_disc(struct ble_store_value_gatt_disc *value)
+{
+    struct ble_store_key_gatt_disc key;
+    int idx;
+
+    ble_store_key_from_value_gatt_disc(&key, value);
+    idx = ble_store_ram_find_gatt_disc(&key);
+    if (idx == -1) {
+        if (ble_store_ram_num_gatt_discs >= STORE_MAX_GATT_DISCS) {
+            BLE_HS_LOG(DEBUG, "error persisting gatt disc; too many entries "
+                              "(%d)\n", ble_store_ram_num_gatt_discs);
+            return BLE_HS_ENOMEM;
+        }
+
+        idx = ble_store_ram_num_gatt_discs;
+        ble_store_ram_num_gatt_discs++;
+    }
+
+    ble_store_ram_gatt_discs[idx] = *value;
+    return 0;
+}
+
+static int
+ble_store_ram_delete_gatt_disc(struct ble_store_key_gatt_disc *key)
+{
+    int idx;
+
+    idx = ble_store_ram_find_gatt_disc(key);
+    if (idx == -1) {
+        return BLE_HS_ENOENT;
+    }
+
+    /* Preserve the order of the remaining entries; cached results are
+     * reported in the order they were discovered.
+     */
+    ble_store_ram_num_gatt_discs--;
+    memmove(ble_store_ram_gatt_discs + idx, ble_store_ram_gatt_discs + idx + 1,
+            (ble_store_ram_num_gatt_discs - idx) *
+            sizeof *ble_store_ram_gatt_discs);
+    return 0;
+}
+
+#endif
+
 /*****************************************************************************
  * $api                                                                      *
  *****************************************************************************/
@@ -338,6 +709,12 @@ ble_store_ram_read(int obj_type, union ble_store_key *key,
         rc = ble_store_ram_read_cccd(&key->cccd, &value->cccd);
         return rc;
 
+#if MYNEWT_VAL(BLE_GATT_DISC_CACHE)
+    case BLE_STORE_OBJ_TYPE_GATT_DISC:
+        rc = ble_store_ram_read_gatt_disc(&key->gatt_disc, &value->gatt_disc);
+        return rc;
+#endif
+
     default:
         return BLE_HS_ENOTSUP;
     }
@@ -367,6 +744,42 @@ ble_store_ram_write(int obj_type, union ble_store_value *val)
         rc = ble_store_ram_write_cccd(&val->cccd);
         return rc;
 
+#if MYNEWT_VAL(BLE_GATT_DISC_CACHE)
+    case BLE_STORE_OBJ_TYPE_GATT_DISC:
+        rc = ble_store_ram_write_gatt_disc(&val->gatt_disc);
+        return rc;
+#endif
+
+    default:
+        return BLE_HS_ENOTSUP;
+    }
+}
+
+/**
+ * Deletes the first object matching the specified criteria.
+ *
+ * @return                      0 if an object was deleted;
+ *                              BLE_HS_ENOENT if no matching object was found;
+ *                              BLE_HS_ENOTSUP for other object types.
+ */
+int
+ble_store_ram_delete(int obj_type, union ble_store_key *key)
+{
+    switch (obj_type) {
+    case BLE_STORE_OBJ_TYPE_PEER_SEC:
+        return ble_store_ram_delete_sec(&key->sec, &ble_store_ram_peer_secs);
+
+    case BLE_STORE_OBJ_TYPE_OUR_SEC:
+        return ble_store_ram_delete_sec(&key->sec, &ble_store_ram_our_secs);
+
+    case BLE_STORE_OBJ_TYPE_CCCD:
+        return ble_store_ram_delete_cccd(&key->cccd);
+
+#if MYNEWT_VAL(BLE_GATT_DISC_CACHE)
+    case BLE_STORE_OBJ_TYPE_GATT_DISC:
+        return ble_store_ram_delete_gatt_disc(&key->gatt_disc);
+#endif
+
     default:
         return BLE_HS_ENOTSUP;
     }
@@ -375,6 +788,14 @@ ble_store_ram_write(int obj_type, union ble_store_value *val)
 void
 ble_store_ram_init(void)
 {
+    memset(&ble_store_ram_our_secs, 0, sizeof ble_store_ram_our_secs);
+    memset(&ble_store_ram_peer_secs, 0, sizeof ble_store_ram_peer_secs);
+    memset(&ble_store_ram_cccds, 0, sizeof ble_store_ram_cccds);
+#if MYNEWT_VAL(BLE_GATT_DISC_CACHE)
+    ble_store_ram_num_gatt_discs = 0;
+#endif
+
     ble_hs_cfg.store_read_cb = ble_store_ram_read;
     ble_hs_cfg.store_write_cb = ble_store_ram_write;
+    ble_hs_cfg.store_delete_cb = ble_store_ram_delete;
 }
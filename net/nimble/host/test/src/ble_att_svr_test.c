@@ -2161,6 +2161,70 @@ TEST_CASE(ble_att_svr_test_prep_write)
                                      BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN, 6);
 }
 
+TEST_CASE(ble_att_svr_test_prep_write_budget)
+{
+    struct ble_att_prep_entry *entry;
+    struct ble_hs_conn *conn;
+    uint16_t conn_handle;
+    int num_entries;
+    int i;
+
+    static uint8_t data[1024];
+
+    conn_handle = ble_att_svr_test_misc_init(205);
+
+    for (i = 0; i < sizeof data; i++) {
+        data[i] = i;
+    }
+
+    ble_att_svr_test_misc_register_uuid16(0x1234, HA_FLAG_PERM_RW, 1,
+                                          ble_att_svr_test_misc_attr_fn_w_1);
+
+    /*** Fill the queue with contiguous partial writes. */
+    for (i = 0; i < 5; i++) {
+        ble_att_svr_test_misc_prep_write(conn_handle, 1, i * 100,
+                                         data + i * 100, 100, 0);
+    }
+
+    ble_hs_lock();
+    conn = ble_hs_conn_find(conn_handle);
+    TEST_ASSERT_FATAL(conn != NULL);
+    TEST_ASSERT(conn->bhc_att_svr.basc_prep_bytes == 500);
+
+    num_entries = 0;
+    SLIST_FOREACH(entry, &conn->bhc_att_svr.basc_prep_list, bape_next) {
+        num_entries++;
+    }
+#if MYNEWT_VAL(BLE_ATT_SVR_PREP_COALESCE)
+    /* Contiguous writes share a single entry. */
+    TEST_ASSERT(num_entries == 1);
+#else
+    TEST_ASSERT(num_entries == 5);
+#endif
+    ble_hs_unlock();
+
+    ble_att_svr_test_misc_exec_write(conn_handle, BLE_ATT_EXEC_WRITE_F_CONFIRM,
+                                     0, 0);
+    ble_att_svr_test_misc_verify_w_1(data, 500);
+
+#if MYNEWT_VAL(BLE_ATT_SVR_PREP_CONN_MAX_BYTES) > 0
+    /*** Exceed the per-connection byte budget. */
+    for (i = 0;
+         (i + 1) * 100 <= MYNEWT_VAL(BLE_ATT_SVR_PREP_CONN_MAX_BYTES);
+         i++) {
+
+        ble_att_svr_test_misc_prep_write(conn_handle, 1, 0, data, 100, 0);
+    }
+    ble_att_svr_test_misc_prep_write(conn_handle, 1, 0, data, 100,
+                                     BLE_ATT_ERR_PREPARE_QUEUE_FULL);
+
+    /*** Cancelling the queue restores the budget. */
+    ble_att_svr_test_misc_exec_write(conn_handle, 0, 0, 0);
+    ble_att_svr_test_misc_prep_write(conn_handle, 1, 0, data, 100, 0);
+    ble_att_svr_test_misc_exec_write(conn_handle, 0, 0, 0);
+#endif
+}
+
 TEST_CASE(ble_att_svr_test_notify)
 {
     uint16_t conn_handle;
@@ -2255,6 +2319,343 @@ TEST_CASE(ble_att_svr_test_oom)
     os_mbuf_free_chain(oms);
 }
 
+static void
+ble_att_svr_test_misc_verify_uuid_walk(const ble_uuid_t *uuid,
+                                       uint16_t end_handle,
+                                       const uint16_t *handles, int num_handles)
+{
+    struct ble_att_svr_entry *entry;
+    int i;
+
+    entry = NULL;
+    for (i = 0; i < num_handles; i++) {
+        entry = ble_att_svr_find_by_uuid(entry, uuid, end_handle);
+        TEST_ASSERT_FATAL(entry != NULL);
+        TEST_ASSERT(entry->ha_handle_id == handles[i]);
+        TEST_ASSERT(ble_uuid_cmp(entry->ha_uuid, uuid) == 0);
+    }
+
+    TEST_ASSERT(ble_att_svr_find_by_uuid(entry, uuid, end_handle) == NULL);
+}
+
+TEST_CASE(ble_att_svr_test_index)
+{
+    static const ble_uuid128_t uuid128 =
+        BLE_UUID128_INIT(0xf0, 0xde, 0xbc, 0x9a, 0x78, 0x56, 0x34, 0x12,
+                         0xf0, 0xde, 0xbc, 0x9a, 0x78, 0x56, 0x34, 0x12);
+    static const uint16_t uuids[] = {
+        0x2800, 0x2803, 0x1234, 0x1234, 0x2803, 0x2800, 0, 0x2803, 0,
+    };
+    struct ble_att_svr_entry *entry;
+    uint16_t handles[sizeof uuids / sizeof uuids[0]];
+    uint16_t h2800[2];
+    uint16_t h2803[3];
+    uint16_t h1234[2];
+    uint16_t h128[2];
+    int i;
+    int rc;
+
+    ble_att_svr_test_misc_init(0);
+
+    /* Interleave the UUIDs so that the index order differs from the handle
+     * order, with one pair of neighbours sharing a UUID; 0 stands for the
+     * 128-bit UUID.
+     */
+    for (i = 0; i < sizeof uuids / sizeof uuids[0]; i++) {
+        if (uuids[i] == 0) {
+            rc = ble_att_svr_register_uuid(&uuid128.u, HA_FLAG_PERM_RW,
+                                           handles + i,
+                                           ble_att_svr_test_misc_attr_fn_r_1,
+                                           (void *)(uintptr_t)i);
+        } else {
+            rc = ble_att_svr_register_uuid16(uuids[i], HA_FLAG_PERM_RW,
+                                             handles + i,
+                                             ble_att_svr_test_misc_attr_fn_r_1,
+                                             (void *)(uintptr_t)i);
+        }
+        TEST_ASSERT_FATAL(rc == 0);
+        if (i > 0) {
+            TEST_ASSERT_FATAL(handles[i] == handles[i - 1] + 1);
+        }
+    }
+
+    /*** By handle. */
+    for (i = 0; i < sizeof uuids / sizeof uuids[0]; i++) {
+        entry = ble_att_svr_find_by_handle(handles[i]);
+        TEST_ASSERT_FATAL(entry != NULL);
+        TEST_ASSERT(entry->ha_handle_id == handles[i]);
+        TEST_ASSERT(entry->ha_cb_arg == (void *)(uintptr_t)i);
+    }
+    TEST_ASSERT(ble_att_svr_find_by_handle(0) == NULL);
+    TEST_ASSERT(ble_att_svr_find_by_handle(handles[i - 1] + 1) == NULL);
+    TEST_ASSERT(ble_att_svr_find_by_handle(0xffff) == NULL);
+
+    /*** By UUID; matches come back in handle order. */
+    h2800[0] = handles[0];
+    h2800[1] = handles[5];
+    h2803[0] = handles[1];
+    h2803[1] = handles[4];
+    h2803[2] = handles[7];
+    h1234[0] = handles[2];
+    h1234[1] = handles[3];
+    h128[0] = handles[6];
+    h128[1] = handles[8];
+
+    ble_att_svr_test_misc_verify_uuid_walk(BLE_UUID16_DECLARE(0x2800), 0xffff,
+                                           h2800, 2);
+    ble_att_svr_test_misc_verify_uuid_walk(BLE_UUID16_DECLARE(0x2803), 0xffff,
+                                           h2803, 3);
+    ble_att_svr_test_misc_verify_uuid_walk(BLE_UUID16_DECLARE(0x1234), 0xffff,
+                                           h1234, 2);
+    ble_att_svr_test_misc_verify_uuid_walk(&uuid128.u, 0xffff, h128, 2);
+
+    /* The end handle cuts the walk short. */
+    ble_att_svr_test_misc_verify_uuid_walk(BLE_UUID16_DECLARE(0x2803),
+                                           handles[7] - 1, h2803, 2);
+    ble_att_svr_test_misc_verify_uuid_walk(BLE_UUID16_DECLARE(0x2803),
+                                           handles[1] - 1, h2803, 0);
+
+    /* Unregistered UUIDs. */
+    ble_att_svr_test_misc_verify_uuid_walk(BLE_UUID16_DECLARE(0x2801), 0xffff,
+                                           NULL, 0);
+    ble_att_svr_test_misc_verify_uuid_walk(BLE_UUID16_DECLARE(0xffff), 0xffff,
+                                           NULL, 0);
+}
+
+TEST_CASE(ble_att_svr_test_register_static)
+{
+    static const ble_uuid16_t uuid16 = BLE_UUID16_INIT(0xabcd);
+    /* 0x2a00 written out in 128 bits. */
+    static const ble_uuid128_t uuid16_as_128 =
+        BLE_UUID128_INIT(0xfb, 0x34, 0x9b, 0x5f, 0x80, 0x00, 0x00, 0x80,
+                         0x00, 0x10, 0x00, 0x00, 0x00, 0x2a, 0x00, 0x00);
+    struct ble_att_svr_entry *entry1;
+    struct ble_att_svr_entry *entry2;
+    uint16_t handle1;
+    uint16_t handle2;
+    uint16_t handle;
+    int num_regs;
+    int rc;
+
+    ble_att_svr_test_misc_init(0);
+
+    /*** A compact UUID is referenced, not copied. */
+    rc = ble_att_svr_register_static(&uuid16.u, HA_FLAG_PERM_RW, &handle1,
+                                     ble_att_svr_test_misc_attr_fn_r_1, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    entry1 = ble_att_svr_find_by_handle(handle1);
+    TEST_ASSERT_FATAL(entry1 != NULL);
+    TEST_ASSERT(entry1->ha_uuid == &uuid16.u);
+    TEST_ASSERT(!(entry1->ha_svr_flags & BLE_ATT_SVR_F_UUID_OWNED));
+
+    /* A later registration of the same UUID shares the caller's copy. */
+    rc = ble_att_svr_register_uuid16(0xabcd, HA_FLAG_PERM_RW, &handle2,
+                                     ble_att_svr_test_misc_attr_fn_r_1, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    entry2 = ble_att_svr_find_by_handle(handle2);
+    TEST_ASSERT_FATAL(entry2 != NULL);
+    TEST_ASSERT(entry2->ha_uuid == &uuid16.u);
+    TEST_ASSERT(!(entry2->ha_svr_flags & BLE_ATT_SVR_F_UUID_OWNED));
+
+    /*** A 16-bit UUID written out in 128 bits is copied in its short form. */
+    rc = ble_att_svr_register_static(&uuid16_as_128.u, HA_FLAG_PERM_RW,
+                                     &handle1,
+                                     ble_att_svr_test_misc_attr_fn_r_1, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    entry1 = ble_att_svr_find_by_handle(handle1);
+    TEST_ASSERT_FATAL(entry1 != NULL);
+    TEST_ASSERT(entry1->ha_uuid != &uuid16_as_128.u);
+    TEST_ASSERT(entry1->ha_uuid->type == BLE_UUID_TYPE_16);
+    TEST_ASSERT(ble_uuid_cmp(entry1->ha_uuid,
+                             BLE_UUID16_DECLARE(0x2a00)) == 0);
+    TEST_ASSERT(entry1->ha_svr_flags & BLE_ATT_SVR_F_UUID_OWNED);
+
+    /*** Copied UUIDs are shared too; only the first entry owns its copy. */
+    rc = ble_att_svr_register_uuid16(0x2a00, HA_FLAG_PERM_RW, &handle2,
+                                     ble_att_svr_test_misc_attr_fn_r_1, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+    entry2 = ble_att_svr_find_by_handle(handle2);
+    TEST_ASSERT_FATAL(entry2 != NULL);
+    TEST_ASSERT(entry2->ha_uuid == entry1->ha_uuid);
+    TEST_ASSERT(!(entry2->ha_svr_flags & BLE_ATT_SVR_F_UUID_OWNED));
+
+    /*** The table holds ble_hs_max_attrs entries. */
+    num_regs = 0;
+    do {
+        rc = ble_att_svr_register_uuid16(0x2a01, HA_FLAG_PERM_RW, &handle,
+                                         ble_att_svr_test_misc_attr_fn_r_1,
+                                         NULL);
+        num_regs++;
+    } while (rc == 0 && num_regs <= ble_hs_max_attrs);
+    TEST_ASSERT(rc == BLE_HS_ENOMEM);
+    TEST_ASSERT(ble_att_svr_find_by_handle(handle) != NULL);
+    TEST_ASSERT(ble_att_svr_find_by_handle(handle + 1) == NULL);
+    TEST_ASSERT(ble_att_svr_find_by_handle(handle2) == entry2);
+}
+
+static void
+ble_att_svr_test_misc_rx_read_type(uint16_t conn_handle, uint16_t uuid16)
+{
+    struct ble_att_read_type_req req;
+    uint8_t buf[BLE_ATT_READ_TYPE_REQ_SZ_16];
+    int rc;
+
+    req.batq_start_handle = 1;
+    req.batq_end_handle = 0xffff;
+    ble_att_read_type_req_write(buf, sizeof buf, &req);
+    htole16(buf + BLE_ATT_READ_TYPE_REQ_BASE_SZ, uuid16);
+
+    rc = ble_hs_test_util_l2cap_rx_payload_flat(conn_handle, BLE_L2CAP_CID_ATT,
+                                                buf, sizeof buf);
+    TEST_ASSERT(rc == 0);
+}
+
+TEST_CASE(ble_att_svr_test_long_values)
+{
+    struct ble_att_find_type_value_req req;
+    struct os_mbuf *om;
+    uint8_t buf[BLE_ATT_FIND_TYPE_VALUE_REQ_BASE_SZ + 21];
+    uint8_t hdr[4];
+    uint32_t copy_bytes;
+    uint16_t conn_handle;
+    int rc;
+    int i;
+
+    static uint8_t value1[300];
+    static uint8_t value2[300];
+
+    for (i = 0; i < sizeof value1; i++) {
+        value1[i] = i;
+        value2[i] = 255 - i;
+    }
+
+    /*** Read by type returns values longer than 19 bytes uncopied. */
+    conn_handle = ble_att_svr_test_misc_init(128);
+    ble_att_svr_test_misc_register_uuid16(0x2a00, HA_FLAG_PERM_RW, 1,
+                                          ble_att_svr_test_misc_attr_fn_r_1);
+    ble_att_svr_test_misc_register_uuid16(0x2a00, HA_FLAG_PERM_RW, 2,
+                                          ble_att_svr_test_misc_attr_fn_r_2);
+    ble_att_svr_test_attr_r_1 = value1;
+    ble_att_svr_test_attr_r_1_len = 40;
+    ble_att_svr_test_attr_r_2 = value2;
+    ble_att_svr_test_attr_r_2_len = 40;
+
+    copy_bytes = ble_att_stats.sread_copy_bytes;
+    ble_att_svr_test_misc_rx_read_type(conn_handle, 0x2a00);
+    ble_att_svr_test_misc_verify_tx_read_type_rsp(
+        ((struct ble_att_svr_test_type_entry[]) { {
+            .handle = 1,
+            .value = value1,
+            .value_len = 40,
+        }, {
+            .handle = 2,
+            .value = value2,
+            .value_len = 40,
+        }, {
+            .handle = 0,
+        } }));
+    TEST_ASSERT(ble_att_stats.sread_copy_bytes == copy_bytes);
+
+    /*** Values are truncated to MTU - 4. */
+    conn_handle = ble_att_svr_test_misc_init(30);
+    ble_att_svr_test_misc_register_uuid16(0x2a00, HA_FLAG_PERM_RW, 1,
+                                          ble_att_svr_test_misc_attr_fn_r_1);
+    ble_att_svr_test_misc_register_uuid16(0x2a00, HA_FLAG_PERM_RW, 2,
+                                          ble_att_svr_test_misc_attr_fn_r_2);
+    ble_att_svr_test_attr_r_1 = value1;
+    ble_att_svr_test_attr_r_1_len = 40;
+    ble_att_svr_test_attr_r_2 = value2;
+    ble_att_svr_test_attr_r_2_len = 40;
+
+    ble_att_svr_test_misc_rx_read_type(conn_handle, 0x2a00);
+    ble_att_svr_test_misc_verify_tx_read_type_rsp(
+        ((struct ble_att_svr_test_type_entry[]) { {
+            .handle = 1,
+            .value = value1,
+            .value_len = 26,
+        }, {
+            .handle = 0,
+        } }));
+
+    /*** Values are truncated to fit the one-byte length field. */
+    conn_handle = ble_att_svr_test_misc_init(300);
+    ble_att_svr_test_misc_register_uuid16(0x2a00, HA_FLAG_PERM_RW, 1,
+                                          ble_att_svr_test_misc_attr_fn_r_1);
+    ble_att_svr_test_attr_r_1 = value1;
+    ble_att_svr_test_attr_r_1_len = 300;
+
+    ble_att_svr_test_misc_rx_read_type(conn_handle, 0x2a00);
+
+    /* The response is too long to pull up into a single buffer. */
+    ble_hs_test_util_tx_all();
+    om = ble_hs_test_util_prev_tx_dequeue();
+    TEST_ASSERT_FATAL(om != NULL);
+    TEST_ASSERT(OS_MBUF_PKTLEN(om) ==
+                BLE_ATT_READ_TYPE_RSP_BASE_SZ + UINT8_MAX);
+
+    rc = os_mbuf_copydata(om, 0, sizeof hdr, hdr);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(hdr[0] == BLE_ATT_OP_READ_TYPE_RSP);
+    TEST_ASSERT(hdr[1] == UINT8_MAX);
+    TEST_ASSERT(le16toh(hdr + 2) == 1);
+    TEST_ASSERT(os_mbuf_cmpf(om, sizeof hdr, value1, UINT8_MAX - 2) == 0);
+
+    /*** Find by type value compares a 20-byte value. */
+    conn_handle = ble_att_svr_test_misc_init(128);
+    ble_att_svr_test_misc_register_uuid16(0x2a00, HA_FLAG_PERM_RW, 1,
+                                          ble_att_svr_test_misc_attr_fn_r_1);
+    ble_att_svr_test_attr_r_1 = value1;
+    ble_att_svr_test_attr_r_1_len = 20;
+
+    req.bavq_start_handle = 1;
+    req.bavq_end_handle = 0xffff;
+    req.bavq_attr_type = 0x2a00;
+    ble_att_find_type_value_req_write(buf, sizeof buf, &req);
+    memcpy(buf + BLE_ATT_FIND_TYPE_VALUE_REQ_BASE_SZ, value1, 20);
+
+    rc = ble_hs_test_util_l2cap_rx_payload_flat(
+        conn_handle, BLE_L2CAP_CID_ATT, buf,
+        BLE_ATT_FIND_TYPE_VALUE_REQ_BASE_SZ + 20);
+    TEST_ASSERT(rc == 0);
+    ble_att_svr_test_misc_verify_tx_find_type_value_rsp(
+        ((struct ble_att_svr_test_type_value_entry[]) { {
+            .first = 1,
+            .last = 1,
+        }, {
+            .first = 0,
+        } }));
+
+    /*** A prefix of the value does not match. */
+    rc = ble_hs_test_util_l2cap_rx_payload_flat(
+        conn_handle, BLE_L2CAP_CID_ATT, buf,
+        BLE_ATT_FIND_TYPE_VALUE_REQ_BASE_SZ + 19);
+    TEST_ASSERT(rc != 0);
+    ble_hs_test_util_verify_tx_err_rsp(
+        BLE_ATT_OP_FIND_TYPE_VALUE_REQ, 1,
+        BLE_ATT_ERR_ATTR_NOT_FOUND);
+
+    /*** Nor does a value with extra bytes. */
+    buf[BLE_ATT_FIND_TYPE_VALUE_REQ_BASE_SZ + 20] = value1[20];
+    rc = ble_hs_test_util_l2cap_rx_payload_flat(
+        conn_handle, BLE_L2CAP_CID_ATT, buf,
+        BLE_ATT_FIND_TYPE_VALUE_REQ_BASE_SZ + 21);
+    TEST_ASSERT(rc != 0);
+    ble_hs_test_util_verify_tx_err_rsp(
+        BLE_ATT_OP_FIND_TYPE_VALUE_REQ, 1,
+        BLE_ATT_ERR_ATTR_NOT_FOUND);
+
+    /*** Prepared write payloads are counted as copied. */
+    ble_att_svr_test_misc_register_uuid16(0x1234, HA_FLAG_PERM_RW, 2,
+                                          ble_att_svr_test_misc_attr_fn_w_1);
+
+    copy_bytes = ble_att_stats.swrite_copy_bytes;
+    ble_att_svr_test_misc_prep_write(conn_handle, 2, 0, value1, 30, 0);
+    TEST_ASSERT(ble_att_stats.swrite_copy_bytes == copy_bytes + 30);
+    ble_att_svr_test_misc_exec_write(conn_handle, BLE_ATT_EXEC_WRITE_F_CONFIRM,
+                                     0, 0);
+    ble_att_svr_test_misc_verify_w_1(value1, 30);
+}
+
 TEST_SUITE(ble_att_svr_suite)
 {
     /* When checking for mbuf leaks, ensure no stale prep entries. */
@@ -2276,9 +2677,13 @@ TEST_SUITE(ble_att_svr_suite)
     ble_att_svr_test_read_type();
     ble_att_svr_test_read_group_type();
     ble_att_svr_test_prep_write();
+    ble_att_svr_test_prep_write_budget();
     ble_att_svr_test_notify();
     ble_att_svr_test_indicate();
     ble_att_svr_test_oom();
+    ble_att_svr_test_index();
+    ble_att_svr_test_register_static();
+    ble_att_svr_test_long_values();
 }
 
 int
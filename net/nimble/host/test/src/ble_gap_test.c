@@ -2900,6 +2900,157 @@ TEST_SUITE(ble_gap_test_suite_mtu)
     ble_gap_test_case_mtu_peer();
 }
 
+/*****************************************************************************
+ * $connection parameter manager                                             *
+ *****************************************************************************/
+
+#define BLE_GAP_TEST_CPM_SAMPLE_TICKS                               \
+    (MYNEWT_VAL(BLE_GAP_CPM_SAMPLE_MS) * OS_TICKS_PER_SEC / 1000 + 1)
+
+static void
+ble_gap_test_util_cpm_add_traffic(uint32_t bytes)
+{
+    struct ble_hs_conn *conn;
+
+    ble_hs_lock();
+    conn = ble_hs_conn_find(2);
+    TEST_ASSERT_FATAL(conn != NULL);
+    conn->bhc_tx_bytes += bytes;
+    ble_hs_unlock();
+}
+
+static void
+ble_gap_test_util_cpm_sample(uint8_t hci_status)
+{
+    ble_hs_test_util_prev_hci_tx_clear();
+    ble_hs_test_util_set_ack(
+        ble_hs_hci_util_opcode_join(BLE_HCI_OGF_LE,
+                                    BLE_HCI_OCF_LE_CONN_UPDATE),
+        hci_status);
+
+    os_time_advance(BLE_GAP_TEST_CPM_SAMPLE_TICKS);
+    ble_gap_timer();
+}
+
+TEST_CASE(ble_gap_test_case_cpm_bad_params)
+{
+    struct ble_gap_cpm_params params;
+    int rc;
+
+    uint8_t peer_addr[6] = { 1, 2, 3, 4, 5, 6 };
+
+    ble_gap_test_util_init();
+    ble_hs_test_util_create_conn(2, peer_addr, ble_gap_test_util_connect_cb,
+                                 NULL);
+
+    memset(&params, 0, sizeof params);
+    params.busy.itvl_min = 12;
+    params.busy.itvl_max = 6;
+    params.idle.itvl_min = 400;
+    params.idle.itvl_max = 800;
+    rc = ble_gap_cpm_enable(2, &params);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+
+    /* Latency too great for any supervision timeout. */
+    params.busy.itvl_min = 6;
+    params.busy.itvl_max = 12;
+    params.idle.latency = 100;
+    rc = ble_gap_cpm_enable(2, &params);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+
+    params.idle.latency = 4;
+    rc = ble_gap_cpm_enable(3, &params);
+    TEST_ASSERT(rc == BLE_HS_ENOTCONN);
+
+    rc = ble_gap_cpm_disable(3);
+    TEST_ASSERT(rc == BLE_HS_ENOTCONN);
+}
+
+TEST_CASE(ble_gap_test_case_cpm_busy_idle)
+{
+    struct ble_gap_upd_params idle;
+    struct ble_gap_cpm_params params;
+    int rc;
+
+    uint8_t peer_addr[6] = { 1, 2, 3, 4, 5, 6 };
+
+    ble_gap_test_util_init();
+    ble_hs_test_util_create_conn(2, peer_addr, ble_gap_test_util_connect_cb,
+                                 NULL);
+
+    memset(&params, 0, sizeof params);
+    params.busy.itvl_min = 6;
+    params.busy.itvl_max = 12;
+    params.busy.supervision_timeout = 100;
+    params.idle.itvl_min = 400;
+    params.idle.itvl_max = 800;
+    params.idle.latency = 4;
+    params.idle.supervision_timeout = 100;
+    params.busy_bps = 1000;
+    params.idle_ms = 2000;
+
+    rc = ble_gap_cpm_enable(2, &params);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /*** Traffic above the threshold; busy parameters get requested. */
+    ble_gap_test_util_cpm_add_traffic(10000);
+    ble_gap_test_util_cpm_sample(0);
+    ble_gap_test_util_verify_tx_update_conn(&params.busy);
+    TEST_ASSERT(ble_gap_dbg_update_active(2));
+
+    ble_gap_test_util_rx_update_complete(0, &params.busy);
+    TEST_ASSERT(!ble_gap_dbg_update_active(2));
+    TEST_ASSERT(ble_gap_test_conn_desc.conn_itvl == params.busy.itvl_max);
+
+    /*** Quiet, but not for long enough yet; nothing happens. */
+    ble_gap_test_util_cpm_sample(0);
+    TEST_ASSERT(ble_hs_test_util_get_first_hci_tx() == NULL);
+
+    /*** Quiet for idle_ms; idle parameters get requested.  The supervision
+     * timeout is raised to suit the latency.
+     */
+    os_time_advance(2 * OS_TICKS_PER_SEC);
+    ble_gap_test_util_cpm_sample(0);
+
+    idle = params.idle;
+    idle.supervision_timeout = 5 * 800 / 4 + 1;
+    ble_gap_test_util_verify_tx_update_conn(&idle);
+    TEST_ASSERT(ble_gap_dbg_update_active(2));
+
+    /*** Peer rejects; the manager backs off despite new traffic. */
+    ble_gap_test_util_rx_update_complete(BLE_ERR_UNSUPPORTED, &idle);
+    TEST_ASSERT(!ble_gap_dbg_update_active(2));
+
+    ble_gap_test_util_cpm_add_traffic(10000);
+    ble_gap_test_util_cpm_sample(0);
+    TEST_ASSERT(ble_hs_test_util_get_first_hci_tx() == NULL);
+
+    /*** After the back-off period, the busy parameters get requested. */
+    os_time_advance(MYNEWT_VAL(BLE_GAP_CPM_BACKOFF_MS) *
+                    OS_TICKS_PER_SEC / 1000);
+    ble_gap_test_util_cpm_add_traffic(10000);
+    ble_gap_test_util_cpm_sample(0);
+    ble_gap_test_util_verify_tx_update_conn(&params.busy);
+
+    ble_gap_test_util_rx_update_complete(0, &params.busy);
+
+    /*** Disabled; the connection is left alone. */
+    rc = ble_gap_cpm_disable(2);
+    TEST_ASSERT(rc == 0);
+
+    os_time_advance(10 * OS_TICKS_PER_SEC);
+    ble_gap_test_util_cpm_sample(0);
+    TEST_ASSERT(ble_hs_test_util_get_first_hci_tx() == NULL);
+}
+
+TEST_SUITE(ble_gap_test_suite_cpm)
+{
+    tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
+
+    ble_gap_test_case_cpm_bad_params();
+    ble_gap_test_case_cpm_busy_idle();
+}
+
 /*****************************************************************************
  * $all                                                                      *
  *****************************************************************************/
@@ -2918,6 +3069,7 @@ ble_gap_test_all(void)
     ble_gap_test_suite_update_conn();
     ble_gap_test_suite_timeout();
     ble_gap_test_suite_mtu();
+    ble_gap_test_suite_cpm();
 
     return tu_any_failed;
 }
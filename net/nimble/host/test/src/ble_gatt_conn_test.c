@@ -705,12 +705,55 @@ TEST_CASE(ble_gatt_conn_test_timeout)
     ble_gatt_conn_test_util_timeout(1);
 }
 
+TEST_CASE(ble_gatt_conn_test_timeout_order)
+{
+    static const uint8_t peer_addr1[6] = { 1, 2, 3, 4, 5, 6 };
+    static const uint8_t peer_addr2[6] = { 2, 3, 4, 5, 6, 7 };
+    int32_t ticks_from_now;
+    int rc;
+
+    ble_gatt_conn_test_util_init();
+
+    ble_hs_test_util_create_conn(1, peer_addr1, NULL, NULL);
+    ble_hs_test_util_create_conn(2, peer_addr2, NULL, NULL);
+
+    /*** Start procedures 10 seconds apart. */
+    rc = ble_gattc_disc_all_svcs(1, ble_gatt_conn_test_disc_all_svcs_cb, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    os_time_advance(10 * OS_TICKS_PER_SEC);
+    rc = ble_gattc_disc_all_svcs(2, ble_gatt_conn_test_disc_all_svcs_cb, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ticks_from_now = ble_gattc_timer();
+    TEST_ASSERT(ticks_from_now == 20 * OS_TICKS_PER_SEC);
+
+    /*** First procedure expires; second one is next. */
+    ble_hs_test_util_set_ack_disconnect(0);
+    os_time_advance(20 * OS_TICKS_PER_SEC);
+    ticks_from_now = ble_gattc_timer();
+    TEST_ASSERT(ticks_from_now == 10 * OS_TICKS_PER_SEC);
+
+    ble_hs_test_util_verify_tx_disconnect(1, BLE_ERR_REM_USER_CONN_TERM);
+    ble_hs_test_util_rx_disconn_complete(1, BLE_ERR_REM_USER_CONN_TERM);
+
+    /*** Second procedure expires. */
+    ble_hs_test_util_set_ack_disconnect(0);
+    os_time_advance(10 * OS_TICKS_PER_SEC);
+    ticks_from_now = ble_gattc_timer();
+    TEST_ASSERT(ticks_from_now == BLE_HS_FOREVER);
+
+    ble_hs_test_util_verify_tx_disconnect(2, BLE_ERR_REM_USER_CONN_TERM);
+    ble_hs_test_util_rx_disconn_complete(2, BLE_ERR_REM_USER_CONN_TERM);
+}
+
 TEST_SUITE(ble_gatt_conn_suite)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
 
     ble_gatt_conn_test_disconnect();
     ble_gatt_conn_test_timeout();
+    ble_gatt_conn_test_timeout_order();
 }
 
 int
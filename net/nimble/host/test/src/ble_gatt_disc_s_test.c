@@ -24,6 +24,7 @@
 #include "host/ble_hs_test.h"
 #include "host/ble_uuid.h"
 #include "ble_hs_test_util.h"
+#include "ble_hs_test_util_store.h"
 
 struct ble_gatt_disc_s_test_svc {
     uint16_t start_handle;
@@ -631,6 +632,88 @@ TEST_CASE(ble_gatt_disc_s_test_oom_timeout)
     os_mbuf_free_chain(oms);
 }
 
+TEST_CASE(ble_gatt_disc_s_test_disc_all_cached)
+{
+    struct ble_gatt_disc_s_test_svc services[] = {
+        { 1, 5, 0,      {1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 }, },
+        { 6, 7, 0x1234 },
+        { 0 }
+    };
+    struct ble_store_value_gatt_disc svc_chg;
+    struct ble_att_indicate_req req;
+    struct ble_gap_conn_desc desc;
+    uint8_t buf[BLE_ATT_INDICATE_REQ_BASE_SZ];
+    int rc;
+
+    ble_gatt_disc_s_test_init();
+
+    ble_hs_test_util_store_init(0, 0, 0);
+    ble_hs_cfg.store_read_cb = ble_hs_test_util_store_read;
+    ble_hs_cfg.store_write_cb = ble_hs_test_util_store_write;
+    ble_hs_cfg.store_delete_cb = ble_hs_test_util_store_delete;
+
+    ble_hs_test_util_create_conn(2, ((uint8_t[]){2,3,4,5,6,7,8,9}),
+                                 NULL, NULL);
+
+    /*** First discovery goes over the air and populates the cache. */
+    rc = ble_gattc_disc_all_svcs(2, ble_gatt_disc_s_test_misc_disc_cb, NULL);
+    TEST_ASSERT(rc == 0);
+    ble_gatt_disc_s_test_misc_rx_all_rsp(2, services);
+    ble_gatt_disc_s_test_misc_verify_services(services);
+
+    /* Two services plus the completion record. */
+    TEST_ASSERT(ble_hs_test_util_store_num_gatt_discs == 3);
+    ble_hs_test_util_prev_tx_queue_clear();
+
+    /*** Second discovery is answered from the cache. */
+    ble_gatt_disc_s_test_num_svcs = 0;
+    ble_gatt_disc_s_test_rx_complete = 0;
+
+    rc = ble_gattc_disc_all_svcs(2, ble_gatt_disc_s_test_misc_disc_cb, NULL);
+    TEST_ASSERT(rc == 0);
+    ble_gatt_disc_s_test_misc_verify_services(services);
+
+    ble_hs_test_util_tx_all();
+    TEST_ASSERT(ble_hs_test_util_prev_tx_queue_sz() == 0);
+
+    /*** Service Changed indication invalidates the cache. */
+    rc = ble_gap_conn_find(2, &desc);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    memset(&svc_chg, 0, sizeof svc_chg);
+    svc_chg.peer_addr_type = desc.peer_id_addr_type;
+    memcpy(svc_chg.peer_addr, desc.peer_id_addr, 6);
+    svc_chg.kind = BLE_STORE_GATT_DISC_CHR;
+    svc_chg.handle = 2;
+    svc_chg.end_handle = 3;
+    svc_chg.properties = BLE_GATT_CHR_PROP_INDICATE;
+    rc = ble_uuid_16_to_128(0x2a05, svc_chg.uuid128);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = ble_store_write_gatt_disc(&svc_chg);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    req.baiq_handle = 3;
+    ble_att_indicate_req_write(buf, sizeof buf, &req);
+    rc = ble_hs_test_util_l2cap_rx_payload_flat(2, BLE_L2CAP_CID_ATT,
+                                                buf, sizeof buf);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(ble_hs_test_util_store_num_gatt_discs == 0);
+    ble_hs_test_util_prev_tx_queue_clear();
+
+    /*** Third discovery goes over the air again. */
+    ble_gatt_disc_s_test_num_svcs = 0;
+    ble_gatt_disc_s_test_rx_complete = 0;
+
+    rc = ble_gattc_disc_all_svcs(2, ble_gatt_disc_s_test_misc_disc_cb, NULL);
+    TEST_ASSERT(rc == 0);
+    ble_gatt_disc_s_test_misc_rx_all_rsp(2, services);
+    ble_gatt_disc_s_test_misc_verify_services(services);
+
+    ble_hs_cfg.store_read_cb = NULL;
+    ble_hs_cfg.store_write_cb = NULL;
+    ble_hs_cfg.store_delete_cb = NULL;
+}
+
 TEST_SUITE(ble_gatt_disc_s_test_suite)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
@@ -640,6 +723,7 @@ TEST_SUITE(ble_gatt_disc_s_test_suite)
     ble_gatt_disc_s_test_oom_all();
     ble_gatt_disc_s_test_oom_uuid();
     ble_gatt_disc_s_test_oom_timeout();
+    ble_gatt_disc_s_test_disc_all_cached();
 }
 
 int
@@ -1045,6 +1045,150 @@ TEST_CASE(ble_gatts_notify_test_disallowed)
         2, chr3_val_handle - 1, BLE_GATTS_CLT_CFG_F_INDICATE, 0);
 }
 
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+static void
+ble_gatts_notify_test_misc_notify_flat(uint16_t conn_handle,
+                                       uint16_t attr_handle, uint8_t val)
+{
+    struct os_mbuf *om;
+    int rc;
+
+    om = ble_hs_mbuf_from_flat(&val, 1);
+    TEST_ASSERT_FATAL(om != NULL);
+
+    rc = ble_gattc_notify_custom(conn_handle, attr_handle, om);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+static void
+ble_gatts_notify_test_misc_verify_tx_flat(uint16_t attr_handle, uint8_t val)
+{
+    struct ble_att_notify_req req;
+    struct os_mbuf *om;
+
+    ble_hs_test_util_tx_all();
+
+    om = ble_hs_test_util_prev_tx_dequeue_pullup();
+    TEST_ASSERT_FATAL(om != NULL);
+
+    ble_att_notify_req_parse(om->om_data, om->om_len, &req);
+    TEST_ASSERT(req.banq_handle == attr_handle);
+    TEST_ASSERT(om->om_len == BLE_ATT_NOTIFY_REQ_BASE_SZ + 1);
+    TEST_ASSERT(om->om_data[BLE_ATT_NOTIFY_REQ_BASE_SZ] == val);
+
+    TEST_ASSERT(ble_hs_test_util_prev_tx_dequeue() == NULL);
+}
+
+TEST_CASE(ble_gatts_notify_test_queue)
+{
+    uint32_t coalesced;
+    uint16_t conn_handle;
+    uint16_t chr1_val_handle;
+    uint16_t chr2_val_handle;
+    int rc;
+
+    ble_gatts_notify_test_misc_init(&conn_handle, 0,
+                                    BLE_GATTS_CLT_CFG_F_NOTIFY,
+                                    BLE_GATTS_CLT_CFG_F_NOTIFY);
+    chr1_val_handle = ble_gatts_notify_test_chr_1_def_handle + 1;
+    chr2_val_handle = ble_gatts_notify_test_chr_2_def_handle + 1;
+
+    /* Pretend the controller only has a single ACL buffer. */
+    rc = ble_hs_hci_set_buf_sz(255, 1);
+    TEST_ASSERT_FATAL(rc == 0);
+    coalesced = ble_att_stats.snotify_q_coalesced;
+
+    /* The first notification goes straight to the controller; the rest wait
+     * for a free buffer.  The third replaces the second.
+     */
+    ble_gatts_notify_test_misc_notify_flat(conn_handle, chr1_val_handle, 1);
+    ble_gatts_notify_test_misc_notify_flat(conn_handle, chr1_val_handle, 2);
+    ble_gatts_notify_test_misc_notify_flat(conn_handle, chr1_val_handle, 3);
+    ble_gatts_notify_test_misc_notify_flat(conn_handle, chr2_val_handle, 4);
+    TEST_ASSERT(ble_att_stats.snotify_q_coalesced == coalesced + 1);
+
+    ble_gatts_notify_test_misc_verify_tx_flat(chr1_val_handle, 1);
+
+    /* Each completed packet releases the next queued notification. */
+    ble_hs_test_util_rx_num_completed_pkts_event(
+        (struct ble_hs_test_util_num_completed_pkts_entry []) {
+            { conn_handle, 1 },
+            { 0 }
+        });
+    ble_gatts_notify_test_misc_verify_tx_flat(chr1_val_handle, 3);
+
+    ble_hs_test_util_rx_num_completed_pkts_event(
+        (struct ble_hs_test_util_num_completed_pkts_entry []) {
+            { conn_handle, 1 },
+            { 0 }
+        });
+    ble_gatts_notify_test_misc_verify_tx_flat(chr2_val_handle, 4);
+
+    /* Queue empty; nothing more to send. */
+    ble_hs_test_util_rx_num_completed_pkts_event(
+        (struct ble_hs_test_util_num_completed_pkts_entry []) {
+            { conn_handle, 1 },
+            { 0 }
+        });
+    ble_hs_test_util_tx_all();
+    TEST_ASSERT(ble_hs_test_util_prev_tx_dequeue() == NULL);
+}
+
+TEST_CASE(ble_gatts_notify_test_queue_fair)
+{
+    static const uint8_t peer_addr2[6] = { 3, 4, 5, 6, 7, 8 };
+    uint32_t deferred;
+    uint16_t conn_handle;
+    int rc;
+
+    ble_gatts_notify_test_misc_init(&conn_handle, 0, 0, 0);
+    ble_hs_test_util_create_conn(3, peer_addr2,
+                                 ble_gatts_notify_test_util_gap_event, NULL);
+
+    /* Four controller buffers; nothing outstanding on either connection. */
+    rc = ble_hs_hci_set_buf_sz(255, 4);
+    TEST_ASSERT_FATAL(rc == 0);
+    ble_hs_test_util_rx_num_completed_pkts_event(
+        (struct ble_hs_test_util_num_completed_pkts_entry []) {
+            { conn_handle, 255 },
+            { 3, 255 },
+            { 0 }
+        });
+    deferred = ble_att_stats.snotify_q_fair_defer;
+
+    /* A lone busy connection may use every free buffer. */
+    ble_gatts_notify_test_misc_notify_flat(3, 10, 1);
+    ble_gatts_notify_test_misc_verify_tx_flat(10, 1);
+
+    /* With two connections busy, each gets half of the buffers.  The third
+     * notification waits even though a buffer is free.
+     */
+    ble_gatts_notify_test_misc_notify_flat(conn_handle, 10, 2);
+    ble_gatts_notify_test_misc_verify_tx_flat(10, 2);
+    ble_gatts_notify_test_misc_notify_flat(conn_handle, 11, 3);
+    ble_gatts_notify_test_misc_verify_tx_flat(11, 3);
+    ble_gatts_notify_test_misc_notify_flat(conn_handle, 12, 4);
+    ble_hs_test_util_tx_all();
+    TEST_ASSERT(ble_hs_test_util_prev_tx_dequeue() == NULL);
+    TEST_ASSERT(ble_att_stats.snotify_q_fair_defer == deferred + 1);
+    TEST_ASSERT(ble_hs_hci_avail_pkts() == 1);
+
+    /* The other connection can still use its share. */
+    ble_gatts_notify_test_misc_notify_flat(3, 11, 5);
+    ble_gatts_notify_test_misc_verify_tx_flat(11, 5);
+    TEST_ASSERT(ble_hs_hci_avail_pkts() == 0);
+
+    /* Once the other connection is idle, the deferred notification goes. */
+    ble_hs_test_util_rx_num_completed_pkts_event(
+        (struct ble_hs_test_util_num_completed_pkts_entry []) {
+            { 3, 2 },
+            { 0 }
+        });
+    ble_gatts_notify_test_misc_verify_tx_flat(12, 4);
+    TEST_ASSERT(ble_hs_hci_avail_pkts() == 1);
+}
+#endif
+
 TEST_SUITE(ble_gatts_notify_suite)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
@@ -1059,6 +1203,11 @@ TEST_SUITE(ble_gatts_notify_suite)
 
     ble_gatts_notify_test_disallowed();
 
+#if MYNEWT_VAL(BLE_GATT_NOTIFY_QUEUE)
+    ble_gatts_notify_test_queue();
+    ble_gatts_notify_test_queue_fair();
+#endif
+
     /* XXX: Test corner cases:
      *     o Bonding after CCCD configuration.
      *     o Disconnect prior to rx of indicate ack.
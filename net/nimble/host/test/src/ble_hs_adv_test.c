@@ -1466,6 +1466,200 @@ TEST_CASE(ble_hs_adv_test_case_user_full_payload)
     TEST_ASSERT(rc == BLE_HS_EMSGSIZE);
 }
 
+TEST_CASE(ble_hs_adv_test_case_update_field)
+{
+    struct ble_hs_adv_fields adv_fields;
+    struct ble_hs_adv_fields rsp_fields;
+    uint8_t big[30];
+    int rc;
+
+    memset(&adv_fields, 0, sizeof adv_fields);
+    adv_fields.name = (uint8_t *)"myname";
+    adv_fields.name_len = 6;
+    adv_fields.name_is_complete = 1;
+    adv_fields.mfg_data = (uint8_t[]){ 0x01, 0x02, 0x03, 0x04 };
+    adv_fields.mfg_data_len = 4;
+
+    memset(&rsp_fields, 0, sizeof rsp_fields);
+
+    /*** Same length; field is replaced in place before advertising. */
+    ble_hs_test_util_init();
+
+    rc = ble_hs_test_util_adv_set_fields(&adv_fields, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = ble_gap_adv_rsp_set_fields(&rsp_fields);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = ble_gap_adv_update_field(BLE_HS_ADV_TYPE_MFG_DATA,
+                                  (uint8_t[]){ 0x05, 0x06, 0x07, 0x08 }, 4);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = ble_hs_test_util_adv_start(BLE_ADDR_TYPE_PUBLIC, 0, NULL,
+                                    &ble_hs_test_util_adv_params,
+                                    BLE_HS_FOREVER, NULL, NULL, 0, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /* Discard the adv-enable and scan response data commands. */
+    ble_hs_test_util_get_last_hci_tx();
+    ble_hs_test_util_get_last_hci_tx();
+
+    ble_hs_adv_test_misc_verify_tx_adv_data(
+        (struct ble_hs_adv_test_field[]) {
+            {
+                .type = BLE_HS_ADV_TYPE_COMP_NAME,
+                .val = (uint8_t *)"myname",
+                .val_len = 6,
+            },
+            {
+                .type = BLE_HS_ADV_TYPE_MFG_DATA,
+                .val = (uint8_t[]){ 0x05, 0x06, 0x07, 0x08 },
+                .val_len = 4,
+            },
+            { 0 },
+        });
+
+    /*** Different length while advertising; sent immediately. */
+    ble_hs_test_util_set_ack(
+        ble_hs_hci_util_opcode_join(BLE_HCI_OGF_LE,
+                                    BLE_HCI_OCF_LE_SET_ADV_DATA), 0);
+    rc = ble_gap_adv_update_field(BLE_HS_ADV_TYPE_COMP_NAME,
+                                  (uint8_t *)"nm", 2);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_hs_adv_test_misc_verify_tx_adv_data(
+        (struct ble_hs_adv_test_field[]) {
+            {
+                .type = BLE_HS_ADV_TYPE_COMP_NAME,
+                .val = (uint8_t *)"nm",
+                .val_len = 2,
+            },
+            {
+                .type = BLE_HS_ADV_TYPE_MFG_DATA,
+                .val = (uint8_t[]){ 0x05, 0x06, 0x07, 0x08 },
+                .val_len = 4,
+            },
+            { 0 },
+        });
+
+    /*** Remove a field. */
+    ble_hs_test_util_set_ack(
+        ble_hs_hci_util_opcode_join(BLE_HCI_OGF_LE,
+                                    BLE_HCI_OCF_LE_SET_ADV_DATA), 0);
+    rc = ble_gap_adv_update_field(BLE_HS_ADV_TYPE_COMP_NAME, NULL, 0);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_hs_adv_test_misc_verify_tx_adv_data(
+        (struct ble_hs_adv_test_field[]) {
+            {
+                .type = BLE_HS_ADV_TYPE_MFG_DATA,
+                .val = (uint8_t[]){ 0x05, 0x06, 0x07, 0x08 },
+                .val_len = 4,
+            },
+            { 0 },
+        });
+
+    /*** Too large; data is left unchanged. */
+    memset(big, 0xaa, sizeof big);
+    rc = ble_gap_adv_update_field(BLE_HS_ADV_TYPE_MFG_DATA, big, sizeof big);
+    TEST_ASSERT(rc == BLE_HS_EMSGSIZE);
+
+    /*** Controller failure; host copy is restored. */
+    ble_hs_test_util_set_ack(
+        ble_hs_hci_util_opcode_join(BLE_HCI_OGF_LE,
+                                    BLE_HCI_OCF_LE_SET_ADV_DATA),
+        BLE_ERR_UNSPECIFIED);
+    rc = ble_gap_adv_update_field(BLE_HS_ADV_TYPE_MFG_DATA,
+                                  (uint8_t[]){ 0x09 }, 1);
+    TEST_ASSERT(rc == BLE_HS_HCI_ERR(BLE_ERR_UNSPECIFIED));
+    ble_hs_test_util_get_last_hci_tx();
+
+    ble_hs_test_util_set_ack(
+        ble_hs_hci_util_opcode_join(BLE_HCI_OGF_LE,
+                                    BLE_HCI_OCF_LE_SET_SCAN_RSP_DATA), 0);
+    rc = ble_gap_adv_rsp_update_field(BLE_HS_ADV_TYPE_MFG_DATA,
+                                      (uint8_t[]){ 0x0a }, 1);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_hs_adv_test_misc_verify_tx_rsp_data(
+        (struct ble_hs_adv_test_field[]) {
+            {
+                .type = BLE_HS_ADV_TYPE_MFG_DATA,
+                .val = (uint8_t[]){ 0x0a },
+                .val_len = 1,
+            },
+            { 0 },
+        });
+}
+
+TEST_CASE(ble_hs_adv_test_case_find_field)
+{
+    struct ble_hs_adv_field field;
+    uint8_t off;
+    int rc;
+
+    static const uint8_t data[] = {
+        0x02, BLE_HS_ADV_TYPE_FLAGS, 0x06,
+        0x05, BLE_HS_ADV_TYPE_INCOMP_UUIDS16, 0x0d, 0x18, 0x11, 0x18,
+        0x03, BLE_HS_ADV_TYPE_COMP_NAME, 'a', 'b',
+        0x03, BLE_HS_ADV_TYPE_MFG_DATA, 0x01, 0x02,
+    };
+
+    /*** Iterate all fields. */
+    off = 0;
+    rc = ble_hs_adv_iter_next(data, sizeof data, &off, &field);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(field.type == BLE_HS_ADV_TYPE_FLAGS);
+    TEST_ASSERT(field.data_len == 1);
+    TEST_ASSERT(field.data == data + 2);
+    TEST_ASSERT(off == 3);
+
+    rc = ble_hs_adv_iter_next(data, sizeof data, &off, &field);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(field.type == BLE_HS_ADV_TYPE_INCOMP_UUIDS16);
+    TEST_ASSERT(field.data_len == 4);
+
+    rc = ble_hs_adv_iter_next(data, sizeof data, &off, &field);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(field.type == BLE_HS_ADV_TYPE_COMP_NAME);
+
+    rc = ble_hs_adv_iter_next(data, sizeof data, &off, &field);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(field.type == BLE_HS_ADV_TYPE_MFG_DATA);
+    TEST_ASSERT(off == sizeof data);
+
+    rc = ble_hs_adv_iter_next(data, sizeof data, &off, &field);
+    TEST_ASSERT(rc == BLE_HS_ENOENT);
+
+    /*** Find by type. */
+    rc = ble_hs_adv_find_field(BLE_HS_ADV_TYPE_MFG_DATA, data, sizeof data,
+                               &field);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(field.data_len == 2);
+    TEST_ASSERT(memcmp(field.data, ((uint8_t[]){ 0x01, 0x02 }), 2) == 0);
+
+    rc = ble_hs_adv_find_field(BLE_HS_ADV_TYPE_TX_PWR_LVL, data, sizeof data,
+                               &field);
+    TEST_ASSERT(rc == BLE_HS_ENOENT);
+
+    /*** Find a service UUID. */
+    rc = ble_hs_adv_find_uuid16(0x1811, data, sizeof data);
+    TEST_ASSERT(rc == 0);
+    rc = ble_hs_adv_find_uuid16(0x180f, data, sizeof data);
+    TEST_ASSERT(rc == BLE_HS_ENOENT);
+
+    /*** Zero length terminates the data. */
+    rc = ble_hs_adv_find_field(BLE_HS_ADV_TYPE_COMP_NAME,
+                               (uint8_t[]){ 0x02, 0x01, 0x06, 0x00, 0x00 }, 5,
+                               &field);
+    TEST_ASSERT(rc == BLE_HS_ENOENT);
+
+    /*** Truncated field. */
+    rc = ble_hs_adv_find_field(BLE_HS_ADV_TYPE_COMP_NAME,
+                               (uint8_t[]){ 0x02, 0x01, 0x06, 0x05, 0x09 }, 5,
+                               &field);
+    TEST_ASSERT(rc == BLE_HS_EBADDATA);
+}
+
 TEST_SUITE(ble_hs_adv_test_suite)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
@@ -1474,6 +1668,8 @@ TEST_SUITE(ble_hs_adv_test_suite)
     ble_hs_adv_test_case_user();
     ble_hs_adv_test_case_user_rsp();
     ble_hs_adv_test_case_user_full_payload();
+    ble_hs_adv_test_case_update_field();
+    ble_hs_adv_test_case_find_field();
 }
 
 int
@@ -203,6 +203,178 @@ TEST_CASE(ble_hs_conn_test_undirect_connectable_success)
     ble_hs_unlock();
 }
 
+TEST_CASE(ble_hs_conn_test_find_collide)
+{
+    /* Handles that map to the same lookup table slot. */
+    static const uint16_t handles[] = { 1, 65, 129 };
+    struct ble_hs_conn *conns[3];
+    int i;
+
+    ble_hs_test_util_init();
+
+    ble_hs_lock();
+
+    for (i = 0; i < 3; i++) {
+        conns[i] = ble_hs_conn_alloc();
+        TEST_ASSERT_FATAL(conns[i] != NULL);
+        conns[i]->bhc_handle = handles[i];
+        ble_hs_conn_insert(conns[i]);
+    }
+
+    for (i = 0; i < 3; i++) {
+        TEST_ASSERT(ble_hs_conn_find(handles[i]) == conns[i]);
+    }
+    TEST_ASSERT(ble_hs_conn_find(2) == NULL);
+    TEST_ASSERT(ble_hs_conn_find(193) == NULL);
+
+    /* Remove the connection occupying the slot; the others must remain
+     * reachable.
+     */
+    ble_hs_conn_remove(conns[0]);
+    ble_hs_conn_free(conns[0]);
+    TEST_ASSERT(ble_hs_conn_find(handles[0]) == NULL);
+    TEST_ASSERT(ble_hs_conn_find(handles[1]) == conns[1]);
+    TEST_ASSERT(ble_hs_conn_find(handles[2]) == conns[2]);
+
+    ble_hs_conn_remove(conns[2]);
+    ble_hs_conn_free(conns[2]);
+    TEST_ASSERT(ble_hs_conn_find(handles[1]) == conns[1]);
+    TEST_ASSERT(ble_hs_conn_find(handles[2]) == NULL);
+
+    ble_hs_conn_remove(conns[1]);
+    ble_hs_conn_free(conns[1]);
+    TEST_ASSERT(ble_hs_conn_find(handles[1]) == NULL);
+    TEST_ASSERT(ble_hs_conn_first() == NULL);
+
+    ble_hs_unlock();
+}
+
+#if MYNEWT_VAL(BLE_HS_CONN_PERF)
+static void
+ble_hs_conn_test_util_tx_frag(uint16_t conn_handle)
+{
+    struct ble_l2cap_chan *chan;
+    struct ble_hs_conn *conn;
+    struct os_mbuf *om;
+    uint8_t val;
+    int rc;
+
+    om = ble_hs_mbuf_l2cap_pkt();
+    TEST_ASSERT_FATAL(om != NULL);
+
+    val = 0;
+    rc = os_mbuf_append(om, &val, sizeof val);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    ble_hs_lock();
+    conn = ble_hs_conn_find(conn_handle);
+    TEST_ASSERT_FATAL(conn != NULL);
+    chan = ble_hs_conn_chan_find(conn, BLE_L2CAP_CID_ATT);
+    TEST_ASSERT_FATAL(chan != NULL);
+    rc = ble_l2cap_tx(conn, chan, om);
+    ble_hs_unlock();
+
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+TEST_CASE(ble_hs_conn_test_perf)
+{
+    static const uint8_t peer_addr[6] = { 2, 3, 4, 5, 6, 7 };
+    struct ble_gap_conn_perf perf;
+    uint8_t params[BLE_HCI_VS_RD_CONN_PERF_RSPLEN];
+    int rc;
+
+    ble_hs_test_util_init();
+    ble_hs_test_util_create_conn(2, peer_addr, NULL, NULL);
+
+    /* Two controller buffers. */
+    rc = ble_hs_hci_set_buf_sz(255, 2);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = ble_gap_conn_perf(3, 0, &perf);
+    TEST_ASSERT(rc == BLE_HS_ENOTCONN);
+
+    /* The third fragment is sent with no free controller buffer. */
+    ble_hs_conn_test_util_tx_frag(2);
+    os_time_advance(10);
+    ble_hs_conn_test_util_tx_frag(2);
+    ble_hs_conn_test_util_tx_frag(2);
+    ble_hs_test_util_prev_tx_queue_clear();
+
+    /* The controller rejects the vendor command. */
+    ble_hs_test_util_set_ack(
+        ble_hs_hci_util_opcode_join(BLE_HCI_OGF_VENDOR,
+                                    BLE_HCI_OCF_VS_RD_CONN_PERF),
+        BLE_ERR_UNKNOWN_HCI_CMD);
+    rc = ble_gap_conn_perf(2, 0, &perf);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!perf.ctlr_valid);
+    TEST_ASSERT(perf.host_valid);
+    TEST_ASSERT(perf.host_tx_frags == 3);
+    TEST_ASSERT(perf.host_tx_no_credit == 1);
+    TEST_ASSERT(perf.host_outstanding == 3);
+    TEST_ASSERT(perf.host_max_outstanding == 3);
+    TEST_ASSERT(perf.host_comp_lat_avg == 0);
+    TEST_ASSERT(perf.host_comp_lat_max == 0);
+
+    /* Latencies: 30, 20 and 30 ticks. */
+    os_time_advance(20);
+    ble_hs_test_util_rx_num_completed_pkts_event(
+        (struct ble_hs_test_util_num_completed_pkts_entry []) {
+            { 2, 2 },
+            { 0 }
+        });
+    os_time_advance(10);
+    ble_hs_test_util_rx_num_completed_pkts_event(
+        (struct ble_hs_test_util_num_completed_pkts_entry []) {
+            { 2, 1 },
+            { 0 }
+        });
+
+    /* Read and clear; this time the controller reports its part. */
+    memset(params, 0, sizeof params);
+    htole16(params + 0, 2);
+    params[2] = (uint8_t)-50;
+    params[3] = (uint8_t)-55;
+    htole32(params + 4, 100);
+    htole32(params + 16, 7);
+    htole32(params + 44, 1234);
+    ble_hs_test_util_set_ack_params(
+        ble_hs_hci_util_opcode_join(BLE_HCI_OGF_VENDOR,
+                                    BLE_HCI_OCF_VS_RD_CONN_PERF),
+        0, params, sizeof params);
+
+    rc = ble_gap_conn_perf(2, 1, &perf);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(perf.ctlr_valid);
+    TEST_ASSERT(perf.ctlr_rssi == -50);
+    TEST_ASSERT(perf.ctlr_rssi_avg == -55);
+    TEST_ASSERT(perf.ctlr_events == 100);
+    TEST_ASSERT(perf.ctlr_rx_crc_err == 7);
+    TEST_ASSERT(perf.ctlr_tx_lat_max == 1234);
+    TEST_ASSERT(perf.host_valid);
+    TEST_ASSERT(perf.host_tx_frags == 3);
+    TEST_ASSERT(perf.host_outstanding == 0);
+    TEST_ASSERT(perf.host_max_outstanding == 3);
+    TEST_ASSERT(perf.host_comp_lat_avg == 80 * 1000 / OS_TICKS_PER_SEC / 3);
+    TEST_ASSERT(perf.host_comp_lat_max == 30 * 1000 / OS_TICKS_PER_SEC);
+
+    /* The host counters have been cleared. */
+    ble_hs_test_util_set_ack(
+        ble_hs_hci_util_opcode_join(BLE_HCI_OGF_VENDOR,
+                                    BLE_HCI_OCF_VS_RD_CONN_PERF),
+        BLE_ERR_UNKNOWN_HCI_CMD);
+    rc = ble_gap_conn_perf(2, 0, &perf);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(!perf.ctlr_valid);
+    TEST_ASSERT(perf.host_tx_frags == 0);
+    TEST_ASSERT(perf.host_tx_no_credit == 0);
+    TEST_ASSERT(perf.host_max_outstanding == 0);
+    TEST_ASSERT(perf.host_comp_lat_avg == 0);
+    TEST_ASSERT(perf.host_comp_lat_max == 0);
+}
+#endif
+
 TEST_SUITE(conn_suite)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
@@ -210,6 +382,10 @@ TEST_SUITE(conn_suite)
     ble_hs_conn_test_direct_connect_success();
     ble_hs_conn_test_direct_connectable_success();
     ble_hs_conn_test_undirect_connectable_success();
+    ble_hs_conn_test_find_collide();
+#if MYNEWT_VAL(BLE_HS_CONN_PERF)
+    ble_hs_conn_test_perf();
+#endif
 }
 
 int
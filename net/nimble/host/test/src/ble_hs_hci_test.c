@@ -83,12 +83,75 @@ TEST_CASE(ble_hs_hci_test_rssi)
     TEST_ASSERT(rc == BLE_HS_ECONTROLLER);
 }
 
+static int ble_hs_hci_test_async_status;
+static uint8_t ble_hs_hci_test_async_params[8];
+static uint8_t ble_hs_hci_test_async_params_len;
+static int ble_hs_hci_test_async_calls;
+
+static void
+ble_hs_hci_test_async_cb(int status, const uint8_t *params,
+                         uint8_t params_len, void *arg)
+{
+    TEST_ASSERT(arg == &ble_hs_hci_test_async_calls);
+    TEST_ASSERT_FATAL(params_len <= sizeof ble_hs_hci_test_async_params);
+
+    ble_hs_hci_test_async_status = status;
+    memcpy(ble_hs_hci_test_async_params, params, params_len);
+    ble_hs_hci_test_async_params_len = params_len;
+    ble_hs_hci_test_async_calls++;
+}
+
+TEST_CASE(ble_hs_hci_test_async)
+{
+    uint8_t buf[BLE_HCI_CMD_HDR_LEN + BLE_HCI_READ_RSSI_LEN];
+    uint8_t params[BLE_HCI_READ_RSSI_ACK_PARAM_LEN];
+    uint16_t opcode;
+    int rc;
+
+    ble_hs_test_util_init();
+
+    opcode = ble_hs_hci_util_opcode_join(BLE_HCI_OGF_STATUS_PARAMS,
+                                         BLE_HCI_OCF_RD_RSSI);
+    ble_hs_hci_cmd_build_read_rssi(1, buf, sizeof buf);
+
+    /*** Success; callback gets the return parameters. */
+    htole16(params + 0, 1);
+    params[2] = -8;
+    ble_hs_test_util_set_ack_params(opcode, 0, params, sizeof params);
+
+    rc = ble_hs_hci_cmd_tx_async(buf, ble_hs_hci_test_async_cb,
+                                 &ble_hs_hci_test_async_calls);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = ble_hs_hci_cmd_drain();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(ble_hs_hci_test_async_calls == 1);
+    TEST_ASSERT(ble_hs_hci_test_async_status == 0);
+    TEST_ASSERT(ble_hs_hci_test_async_params_len == sizeof params);
+    TEST_ASSERT(memcmp(ble_hs_hci_test_async_params, params,
+                       sizeof params) == 0);
+
+    /*** Failure without a callback; reported by drain, once. */
+    ble_hs_test_util_set_ack(opcode, BLE_ERR_UNK_CONN_ID);
+
+    rc = ble_hs_hci_cmd_tx_async(buf, NULL, NULL);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    rc = ble_hs_hci_cmd_drain();
+    TEST_ASSERT(rc == BLE_HS_HCI_ERR(BLE_ERR_UNK_CONN_ID));
+    TEST_ASSERT(ble_hs_hci_test_async_calls == 1);
+
+    rc = ble_hs_hci_cmd_drain();
+    TEST_ASSERT(rc == 0);
+}
+
 TEST_SUITE(ble_hs_hci_suite)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
 
     ble_hs_hci_test_event_bad();
     ble_hs_hci_test_rssi();
+    ble_hs_hci_test_async();
 }
 
 int
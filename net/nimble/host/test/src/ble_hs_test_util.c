@@ -238,15 +238,15 @@ ble_hs_test_util_rx_hci_evt(uint8_t *evt)
     totlen = BLE_HCI_EVENT_HDR_LEN + evt[1];
     TEST_ASSERT_FATAL(totlen <= UINT8_MAX + BLE_HCI_EVENT_HDR_LEN);
 
-    if (os_started()) {
-        evbuf = ble_hci_trans_buf_alloc(
-            BLE_HCI_TRANS_BUF_EVT_LO);
-        TEST_ASSERT_FATAL(evbuf != NULL);
+    /* The host frees the event buffer, so it must come from the transport. */
+    evbuf = ble_hci_trans_buf_alloc(BLE_HCI_TRANS_BUF_EVT_LO);
+    TEST_ASSERT_FATAL(evbuf != NULL);
+    memcpy(evbuf, evt, totlen);
 
-        memcpy(evbuf, evt, totlen);
+    if (os_started()) {
         rc = ble_hci_trans_ll_evt_tx(evbuf);
     } else {
-        rc = ble_hs_hci_evt_process(evt);
+        rc = ble_hs_hci_evt_process(evbuf);
     }
 
     TEST_ASSERT_FATAL(rc == 0);
@@ -1261,10 +1261,10 @@ ble_hs_test_util_verify_tx_err_rsp(uint8_t req_op, uint16_t handle,
     TEST_ASSERT(rsp.baep_error_code == error_code);
 }
 
-static struct os_mbuf *
+struct os_mbuf *
 ble_hs_test_util_verify_tx_l2cap_sig_hdr(uint8_t op, uint8_t id,
-                                   uint16_t payload_len,
-                                   struct ble_l2cap_sig_hdr *out_hdr)
+                                         uint16_t payload_len,
+                                         struct ble_l2cap_sig_hdr *out_hdr)
 {
     struct ble_l2cap_sig_hdr hdr;
     struct os_mbuf *om;
@@ -1644,6 +1644,11 @@ ble_hs_test_util_init_no_start(void)
 {
     tu_init();
 
+    /* sysinit installs the RAM store; tests that need one pick their own. */
+    ble_hs_cfg.store_read_cb = NULL;
+    ble_hs_cfg.store_write_cb = NULL;
+    ble_hs_cfg.store_delete_cb = NULL;
+
     os_eventq_init(&ble_hs_test_util_evq);
     STAILQ_INIT(&ble_hs_test_util_prev_tx_queue);
     ble_hs_test_util_prev_tx_cur = NULL;
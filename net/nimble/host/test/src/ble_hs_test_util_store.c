@@ -34,6 +34,11 @@ int ble_hs_test_util_store_num_our_secs;
 int ble_hs_test_util_store_num_peer_secs;
 int ble_hs_test_util_store_num_cccds;
 
+#define BLE_HS_TEST_UTIL_STORE_MAX_GATT_DISCS   64
+static struct ble_store_value_gatt_disc
+    ble_hs_test_util_store_gatt_discs[BLE_HS_TEST_UTIL_STORE_MAX_GATT_DISCS];
+int ble_hs_test_util_store_num_gatt_discs;
+
 
 #define BLE_HS_TEST_UTIL_STORE_WRITE_GEN(store, num_vals, max_vals, \
                                          val, idx) do               \
@@ -57,6 +62,10 @@ ble_hs_test_util_store_init(int max_our_secs, int max_peer_secs, int max_cccds)
     free(ble_hs_test_util_store_peer_secs);
     free(ble_hs_test_util_store_cccds);
 
+    ble_hs_test_util_store_max_our_secs = max_our_secs;
+    ble_hs_test_util_store_max_peer_secs = max_peer_secs;
+    ble_hs_test_util_store_max_cccds = max_cccds;
+
     ble_hs_test_util_store_our_secs = malloc(
         ble_hs_test_util_store_max_our_secs *
         sizeof *ble_hs_test_util_store_our_secs);
@@ -72,12 +81,10 @@ ble_hs_test_util_store_init(int max_our_secs, int max_peer_secs, int max_cccds)
         sizeof *ble_hs_test_util_store_cccds);
     TEST_ASSERT_FATAL(ble_hs_test_util_store_cccds != NULL);
 
-    ble_hs_test_util_store_max_our_secs = max_our_secs;
-    ble_hs_test_util_store_max_peer_secs = max_peer_secs;
-    ble_hs_test_util_store_max_cccds = max_cccds;
     ble_hs_test_util_store_num_our_secs = 0;
     ble_hs_test_util_store_num_peer_secs = 0;
     ble_hs_test_util_store_num_cccds = 0;
+    ble_hs_test_util_store_num_gatt_discs = 0;
 }
 
 static int
@@ -181,6 +188,61 @@ ble_hs_test_util_store_read_cccd(struct ble_store_key_cccd *key,
     return 0;
 }
 
+static int
+ble_hs_test_util_store_find_gatt_disc(struct ble_store_key_gatt_disc *key)
+{
+    struct ble_store_value_gatt_disc *cur;
+    int skipped;
+    int i;
+
+    skipped = 0;
+    for (i = 0; i < ble_hs_test_util_store_num_gatt_discs; i++) {
+        cur = ble_hs_test_util_store_gatt_discs + i;
+
+        if (key->peer_addr_type != BLE_STORE_ADDR_TYPE_NONE) {
+            if (cur->peer_addr_type != key->peer_addr_type) {
+                continue;
+            }
+
+            if (memcmp(cur->peer_addr, key->peer_addr, 6) != 0) {
+                continue;
+            }
+        }
+
+        if (key->kind != 0 && cur->kind != key->kind) {
+            continue;
+        }
+
+        if (key->handle != 0 && cur->handle != key->handle) {
+            continue;
+        }
+
+        if (key->idx > skipped) {
+            skipped++;
+            continue;
+        }
+
+        return i;
+    }
+
+    return -1;
+}
+
+static int
+ble_hs_test_util_store_read_gatt_disc(struct ble_store_key_gatt_disc *key,
+                                      struct ble_store_value_gatt_disc *value)
+{
+    int idx;
+
+    idx = ble_hs_test_util_store_find_gatt_disc(key);
+    if (idx == -1) {
+        return BLE_HS_ENOENT;
+    }
+
+    *value = ble_hs_test_util_store_gatt_discs[idx];
+    return 0;
+}
+
 int
 ble_hs_test_util_store_read(int obj_type, union ble_store_key *key,
                             union ble_store_value *dst)
@@ -203,6 +265,10 @@ ble_hs_test_util_store_read(int obj_type, union ble_store_key *key,
     case BLE_STORE_OBJ_TYPE_CCCD:
         return ble_hs_test_util_store_read_cccd(&key->cccd, &dst->cccd);
 
+    case BLE_STORE_OBJ_TYPE_GATT_DISC:
+        return ble_hs_test_util_store_read_gatt_disc(&key->gatt_disc,
+                                                     &dst->gatt_disc);
+
     default:
         TEST_ASSERT_FATAL(0);
         return BLE_HS_EUNKNOWN;
@@ -212,6 +278,7 @@ ble_hs_test_util_store_read(int obj_type, union ble_store_key *key,
 int
 ble_hs_test_util_store_write(int obj_type, union ble_store_value *value)
 {
+    struct ble_store_key_gatt_disc key_gatt_disc;
     struct ble_store_key_cccd key_cccd;
     int idx;
 
@@ -239,6 +306,15 @@ ble_hs_test_util_store_write(int obj_type, union ble_store_value *value)
             ble_hs_test_util_store_max_cccds,
             value->cccd, idx);
 
+    case BLE_STORE_OBJ_TYPE_GATT_DISC:
+        ble_store_key_from_value_gatt_disc(&key_gatt_disc, &value->gatt_disc);
+        idx = ble_hs_test_util_store_find_gatt_disc(&key_gatt_disc);
+        BLE_HS_TEST_UTIL_STORE_WRITE_GEN(
+            ble_hs_test_util_store_gatt_discs,
+            ble_hs_test_util_store_num_gatt_discs,
+            BLE_HS_TEST_UTIL_STORE_MAX_GATT_DISCS,
+            value->gatt_disc, idx);
+
     default:
         TEST_ASSERT_FATAL(0);
         return BLE_HS_EUNKNOWN;
@@ -246,3 +322,27 @@ ble_hs_test_util_store_write(int obj_type, union ble_store_value *value)
 
     return 0;
 }
+
+int
+ble_hs_test_util_store_delete(int obj_type, union ble_store_key *key)
+{
+    int idx;
+
+    switch (obj_type) {
+    case BLE_STORE_OBJ_TYPE_GATT_DISC:
+        idx = ble_hs_test_util_store_find_gatt_disc(&key->gatt_disc);
+        if (idx == -1) {
+            return BLE_HS_ENOENT;
+        }
+
+        ble_hs_test_util_store_num_gatt_discs--;
+        memmove(ble_hs_test_util_store_gatt_discs + idx,
+                ble_hs_test_util_store_gatt_discs + idx + 1,
+                (ble_hs_test_util_store_num_gatt_discs - idx) *
+                sizeof *ble_hs_test_util_store_gatt_discs);
+        return 0;
+
+    default:
+        return BLE_HS_ENOTSUP;
+    }
+}
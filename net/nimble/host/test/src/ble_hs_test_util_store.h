@@ -30,12 +30,14 @@ union ble_store_key;
 extern int ble_hs_test_util_store_num_our_ltks;
 extern int ble_hs_test_util_store_num_peer_ltks;
 extern int ble_hs_test_util_store_num_cccds;
+extern int ble_hs_test_util_store_num_gatt_discs;
 
 void ble_hs_test_util_store_init(int max_our_ltks, int max_peer_ltks,
                                  int max_cccds);
 int ble_hs_test_util_store_read(int obj_type, union ble_store_key *key,
                                 union ble_store_value *dst);
 int ble_hs_test_util_store_write(int obj_type, union ble_store_value *value);
+int ble_hs_test_util_store_delete(int obj_type, union ble_store_key *key);
 
 #ifdef __cplusplus
 }
@@ -19,6 +19,7 @@
 
 #include <stddef.h>
 #include <errno.h>
+#include <string.h>
 #include "testutil/testutil.h"
 #include "nimble/hci_common.h"
 #include "host/ble_hs_test.h"
@@ -317,6 +318,58 @@ TEST_CASE(ble_l2cap_test_case_frag_multiple)
     ble_l2cap_test_util_verify_last_frag(2, 1);
 }
 
+static int ble_l2cap_test_frag_rx_len;
+static int ble_l2cap_test_frag_rx_mbufs;
+
+static int
+ble_l2cap_test_util_count_rx(uint16_t conn_handle, struct os_mbuf **om)
+{
+    struct os_mbuf *cur;
+
+    ble_l2cap_test_frag_rx_len = OS_MBUF_PKTLEN(*om);
+    ble_l2cap_test_frag_rx_mbufs = 0;
+    for (cur = *om; cur != NULL; cur = SLIST_NEXT(cur, om_next)) {
+        ble_l2cap_test_frag_rx_mbufs++;
+    }
+
+    return 0;
+}
+
+TEST_CASE(ble_l2cap_test_case_frag_compact)
+{
+    struct ble_l2cap_chan *chan;
+    struct ble_hs_conn *conn;
+    int i;
+
+    ble_l2cap_test_util_init();
+
+    ble_l2cap_test_util_create_conn(2, ((uint8_t[]){1,2,3,4,5,6}),
+                                    NULL, NULL);
+
+    ble_hs_lock();
+    conn = ble_hs_conn_find(2);
+    TEST_ASSERT_FATAL(conn != NULL);
+    chan = ble_hs_conn_chan_find(conn, BLE_L2CAP_TEST_CID);
+    TEST_ASSERT_FATAL(chan != NULL);
+    chan->blc_rx_fn = ble_l2cap_test_util_count_rx;
+    ble_hs_unlock();
+
+    /*** Six fragments; the reassembled packet should use fewer mbufs. */
+    ble_l2cap_test_frag_rx_len = 0;
+    ble_l2cap_test_util_verify_first_frag(2, 10, 60);
+    for (i = 0; i < 4; i++) {
+        ble_l2cap_test_util_verify_middle_frag(2, 10);
+    }
+    ble_l2cap_test_util_verify_last_frag(2, 10);
+
+    TEST_ASSERT(ble_l2cap_test_frag_rx_len == 60);
+#if MYNEWT_VAL(BLE_L2CAP_RX_COMPACT)
+    TEST_ASSERT(ble_l2cap_test_frag_rx_mbufs < 6);
+#else
+    TEST_ASSERT(ble_l2cap_test_frag_rx_mbufs == 6);
+#endif
+}
+
 TEST_CASE(ble_l2cap_test_case_frag_channels)
 {
     struct ble_hs_conn *conn;
@@ -561,6 +614,172 @@ TEST_CASE(ble_l2cap_test_case_sig_update_init_fail_bad_id)
     TEST_ASSERT(ble_l2cap_test_update_arg == NULL);
 }
 
+/*****************************************************************************
+ * $coc                                                                      *
+ *****************************************************************************/
+
+#define BLE_L2CAP_TEST_PSM          0x0080
+#define BLE_L2CAP_TEST_PEER_CID     0x0045
+
+struct ble_l2cap_test_coc_state {
+    int num_connected;
+    int num_disconnected;
+    int num_accepted;
+    int connect_status;
+    struct ble_l2cap_chan *chan;
+    uint8_t data[16];
+    int data_len;
+};
+
+static int
+ble_l2cap_test_util_coc_cb(struct ble_l2cap_event *event, void *arg)
+{
+    struct ble_l2cap_test_coc_state *state;
+    struct os_mbuf *sdu;
+
+    state = arg;
+
+    switch (event->type) {
+    case BLE_L2CAP_EVENT_COC_ACCEPT:
+        state->num_accepted++;
+        state->chan = event->chan;
+        sdu = os_msys_get_pkthdr(0, 0);
+        TEST_ASSERT_FATAL(sdu != NULL);
+        return ble_l2cap_recv_ready(event->chan, sdu);
+
+    case BLE_L2CAP_EVENT_COC_CONNECTED:
+        state->num_connected++;
+        state->connect_status = event->connect.status;
+        return 0;
+
+    case BLE_L2CAP_EVENT_COC_DISCONNECTED:
+        state->num_disconnected++;
+        return 0;
+
+    case BLE_L2CAP_EVENT_COC_DATA_RECEIVED:
+        sdu = event->receive.sdu_rx;
+        state->data_len = OS_MBUF_PKTLEN(sdu);
+        TEST_ASSERT_FATAL(state->data_len <= sizeof state->data);
+        os_mbuf_copydata(sdu, 0, state->data_len, state->data);
+        os_mbuf_free_chain(sdu);
+        return 0;
+
+    default:
+        return 0;
+    }
+}
+
+static void
+ble_l2cap_test_util_rx_sig(uint16_t conn_handle, uint8_t op, uint8_t id,
+                           const uint8_t *payload, int len)
+{
+    uint8_t buf[BLE_L2CAP_SIG_HDR_SZ + 16];
+    int rc;
+
+    TEST_ASSERT_FATAL(len <= sizeof buf - BLE_L2CAP_SIG_HDR_SZ);
+
+    buf[0] = op;
+    buf[1] = id;
+    htole16(buf + 2, len);
+    memcpy(buf + BLE_L2CAP_SIG_HDR_SZ, payload, len);
+
+    rc = ble_hs_test_util_l2cap_rx_payload_flat(conn_handle, BLE_L2CAP_CID_SIG,
+                                                buf,
+                                                BLE_L2CAP_SIG_HDR_SZ + len);
+    TEST_ASSERT(rc == 0);
+}
+
+TEST_CASE(ble_l2cap_test_case_coc_accept)
+{
+    struct ble_l2cap_test_coc_state state;
+    struct ble_l2cap_sig_disconn_rsp disconn_rsp;
+    struct ble_l2cap_sig_coc_rsp coc_rsp;
+    struct os_mbuf *om;
+    uint8_t buf[16];
+    int rc;
+
+    ble_l2cap_test_util_init();
+    memset(&state, 0, sizeof state);
+
+    ble_l2cap_test_util_create_conn(2, ((uint8_t[]){1,2,3,4,5,6}),
+                                    NULL, NULL);
+
+    rc = ble_l2cap_create_server(BLE_L2CAP_TEST_PSM, 100,
+                                 ble_l2cap_test_util_coc_cb, &state);
+    TEST_ASSERT_FATAL(rc == 0);
+
+    /*** Peer connects: psm, scid, mtu, mps, credits. */
+    htole16(buf + 0, BLE_L2CAP_TEST_PSM);
+    htole16(buf + 2, BLE_L2CAP_TEST_PEER_CID);
+    htole16(buf + 4, 64);
+    htole16(buf + 6, 32);
+    htole16(buf + 8, 4);
+    ble_l2cap_test_util_rx_sig(2, BLE_L2CAP_SIG_OP_CREDIT_CONNECT_REQ, 1,
+                               buf, BLE_L2CAP_SIG_COC_REQ_SZ);
+
+    TEST_ASSERT(state.num_accepted == 1);
+    TEST_ASSERT(state.num_connected == 1);
+    TEST_ASSERT(state.connect_status == 0);
+    TEST_ASSERT_FATAL(state.chan != NULL);
+
+    /* Ensure a successful response got sent. */
+    ble_hs_test_util_tx_all();
+    om = ble_hs_test_util_verify_tx_l2cap_sig_hdr(
+        BLE_L2CAP_SIG_OP_CREDIT_CONNECT_RSP, 1, BLE_L2CAP_SIG_COC_RSP_SZ,
+        NULL);
+    ble_l2cap_sig_coc_rsp_parse(om->om_data, om->om_len, &coc_rsp);
+    TEST_ASSERT(coc_rsp.result == BLE_L2CAP_SIG_COC_RSP_RESULT_SUCCESS);
+    TEST_ASSERT(coc_rsp.dcid == BLE_L2CAP_COC_CID_START);
+    TEST_ASSERT(coc_rsp.mtu == 100);
+    TEST_ASSERT(coc_rsp.credits > 0);
+
+    /*** Peer sends a three byte SDU in one K-frame. */
+    htole16(buf, 3);
+    memcpy(buf + 2, "abc", 3);
+    rc = ble_hs_test_util_l2cap_rx_payload_flat(2, BLE_L2CAP_COC_CID_START,
+                                                buf, 5);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(state.data_len == 3);
+    TEST_ASSERT(memcmp(state.data, "abc", 3) == 0);
+
+    /*** Unknown PSM gets refused. */
+    htole16(buf + 0, BLE_L2CAP_TEST_PSM + 2);
+    htole16(buf + 2, BLE_L2CAP_TEST_PEER_CID + 1);
+    htole16(buf + 4, 64);
+    htole16(buf + 6, 32);
+    htole16(buf + 8, 4);
+    ble_l2cap_test_util_rx_sig(2, BLE_L2CAP_SIG_OP_CREDIT_CONNECT_REQ, 2,
+                               buf, BLE_L2CAP_SIG_COC_REQ_SZ);
+    TEST_ASSERT(state.num_accepted == 1);
+
+    ble_hs_test_util_tx_all();
+    om = ble_hs_test_util_verify_tx_l2cap_sig_hdr(
+        BLE_L2CAP_SIG_OP_CREDIT_CONNECT_RSP, 2, BLE_L2CAP_SIG_COC_RSP_SZ,
+        NULL);
+    ble_l2cap_sig_coc_rsp_parse(om->om_data, om->om_len, &coc_rsp);
+    TEST_ASSERT(coc_rsp.result == BLE_L2CAP_COC_ERR_PSM_NOT_SUPP);
+
+    /*** Peer disconnects: dcid, scid. */
+    htole16(buf + 0, BLE_L2CAP_COC_CID_START);
+    htole16(buf + 2, BLE_L2CAP_TEST_PEER_CID);
+    ble_l2cap_test_util_rx_sig(2, BLE_L2CAP_SIG_OP_DISCONN_REQ, 3,
+                               buf, BLE_L2CAP_SIG_DISCONN_REQ_SZ);
+    TEST_ASSERT(state.num_disconnected == 1);
+
+    ble_hs_test_util_tx_all();
+    om = ble_hs_test_util_verify_tx_l2cap_sig_hdr(
+        BLE_L2CAP_SIG_OP_DISCONN_RSP, 3, BLE_L2CAP_SIG_DISCONN_RSP_SZ, NULL);
+    ble_l2cap_sig_disconn_rsp_parse(om->om_data, om->om_len, &disconn_rsp);
+    TEST_ASSERT(disconn_rsp.dcid == BLE_L2CAP_COC_CID_START);
+    TEST_ASSERT(disconn_rsp.scid == BLE_L2CAP_TEST_PEER_CID);
+
+    /* Ensure the channel is gone. */
+    ble_hs_lock();
+    TEST_ASSERT(ble_hs_conn_chan_find(ble_hs_conn_find(2),
+                                      BLE_L2CAP_COC_CID_START) == NULL);
+    ble_hs_unlock();
+}
+
 TEST_SUITE(ble_l2cap_test_suite)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
@@ -568,6 +787,7 @@ TEST_SUITE(ble_l2cap_test_suite)
     ble_l2cap_test_case_bad_header();
     ble_l2cap_test_case_frag_single();
     ble_l2cap_test_case_frag_multiple();
+    ble_l2cap_test_case_frag_compact();
     ble_l2cap_test_case_frag_channels();
     ble_l2cap_test_case_sig_unsol_rsp();
     ble_l2cap_test_case_sig_update_accept();
@@ -576,6 +796,7 @@ TEST_SUITE(ble_l2cap_test_suite)
     ble_l2cap_test_case_sig_update_init_reject();
     ble_l2cap_test_case_sig_update_init_fail_master();
     ble_l2cap_test_case_sig_update_init_fail_bad_id();
+    ble_l2cap_test_case_coc_accept();
 }
 
 int
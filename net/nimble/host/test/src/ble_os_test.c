@@ -376,6 +376,120 @@ TEST_CASE(ble_gap_terminate_test_case)
     os_start();
 }
 
+/** Set while the lock test task holds the lock under test. */
+static int ble_os_lock_test_holding;
+
+static int
+ble_os_lock_test_store_read(int obj_type, union ble_store_key *key,
+                            union ble_store_value *dst)
+{
+    return BLE_HS_ENOENT;
+}
+
+static void
+ble_os_lock_test_store_ev_cb(struct os_event *ev)
+{
+    union ble_store_value val;
+    union ble_store_key key;
+
+    /* Blocks until the test task releases the store lock. */
+    memset(&key, 0, sizeof key);
+    ble_store_read(BLE_STORE_OBJ_TYPE_CCCD, &key, &val);
+    TEST_ASSERT(!ble_os_lock_test_holding);
+}
+
+static void
+ble_os_lock_test_hs_ev_cb(struct os_event *ev)
+{
+    /* Blocks until the test task releases the host lock. */
+    ble_hs_lock();
+    TEST_ASSERT(!ble_os_lock_test_holding);
+    ble_hs_unlock();
+}
+
+static struct os_event ble_os_lock_test_store_ev = {
+    .ev_cb = ble_os_lock_test_store_ev_cb,
+};
+
+static struct os_event ble_os_lock_test_hs_ev = {
+    .ev_cb = ble_os_lock_test_hs_ev_cb,
+};
+
+static int
+ble_os_lock_test_store_read_slow(int obj_type, union ble_store_key *key,
+                                 union ble_store_value *dst)
+{
+    /* Let the higher priority app task contend for the store lock, then
+     * keep it waiting.
+     */
+    ble_hs_cfg.store_read_cb = ble_os_lock_test_store_read;
+    ble_os_lock_test_holding = 1;
+    os_eventq_put(&ble_hs_test_util_evq, &ble_os_lock_test_store_ev);
+    os_time_delay(5);
+    ble_os_lock_test_holding = 0;
+
+    return BLE_HS_ENOENT;
+}
+
+static void
+ble_os_lock_test_task_handler(void *arg)
+{
+    union ble_store_value val;
+    union ble_store_key key;
+    uint32_t wait_ticks;
+    uint32_t contended;
+
+    /*** Uncontended store access is not counted. */
+    ble_hs_cfg.store_read_cb = ble_os_lock_test_store_read;
+    memset(&key, 0, sizeof key);
+
+    contended = ble_hs_stats.sstore_lock_contended;
+    ble_store_read(BLE_STORE_OBJ_TYPE_CCCD, &key, &val);
+    TEST_ASSERT(ble_hs_stats.sstore_lock_contended == contended);
+
+    /*** The app task waits for the store lock while the callback runs. */
+    ble_hs_cfg.store_read_cb = ble_os_lock_test_store_read_slow;
+    wait_ticks = ble_hs_stats.sstore_lock_wait_ticks;
+    ble_store_read(BLE_STORE_OBJ_TYPE_CCCD, &key, &val);
+    TEST_ASSERT(ble_hs_stats.sstore_lock_contended == contended + 1);
+    TEST_ASSERT(ble_hs_stats.sstore_lock_wait_ticks >= wait_ticks + 5);
+    TEST_ASSERT(!ble_os_lock_test_store_ev.ev_queued);
+
+    /*** Uncontended host lock acquisition is not counted. */
+    contended = ble_hs_stats.slock_contended;
+    wait_ticks = ble_hs_stats.slock_wait_ticks;
+    ble_hs_lock();
+    ble_hs_unlock();
+    TEST_ASSERT(ble_hs_stats.slock_contended == contended);
+
+    /*** The app task waits for the host lock. */
+    ble_hs_lock();
+    ble_os_lock_test_holding = 1;
+    os_eventq_put(&ble_hs_test_util_evq, &ble_os_lock_test_hs_ev);
+    os_time_delay(5);
+    ble_os_lock_test_holding = 0;
+    ble_hs_unlock();
+
+    TEST_ASSERT(ble_hs_stats.slock_contended == contended + 1);
+    TEST_ASSERT(ble_hs_stats.slock_wait_ticks >= wait_ticks + 5);
+    TEST_ASSERT(!ble_os_lock_test_hs_ev.ev_queued);
+
+    tu_restart();
+}
+
+TEST_CASE(ble_os_lock_test_case)
+{
+    ble_os_test_misc_init();
+
+    os_task_init(&ble_os_test_task,
+                 "ble_os_lock_test_task",
+                 ble_os_lock_test_task_handler, NULL,
+                 BLE_OS_TEST_TASK_PRIO, OS_WAIT_FOREVER, ble_os_test_stack,
+                 OS_STACK_ALIGN(BLE_OS_TEST_STACK_SIZE));
+
+    os_start();
+}
+
 TEST_SUITE(ble_os_test_suite)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
@@ -383,6 +497,7 @@ TEST_SUITE(ble_os_test_suite)
     ble_os_disc_test_case();
     ble_gap_direct_connect_test_case();
     ble_gap_terminate_test_case();
+    ble_os_lock_test_case();
 }
 
 int
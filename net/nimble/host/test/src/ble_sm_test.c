@@ -645,6 +645,41 @@ TEST_CASE(ble_sm_test_case_us_fail_inval)
     ble_sm_test_util_us_fail_inval(&params);
 }
 
+#if MYNEWT_VAL(BLE_SM_SC) && MYNEWT_VAL(BLE_SM_SC_KEY_ROTATE)
+TEST_CASE(ble_sm_test_case_us_sc_key_rotate)
+{
+    struct ble_sm_public_key key1;
+    struct ble_sm_public_key key2;
+    uint8_t priv_key[32];
+
+    /* The keys are only sent, never used in a computation. */
+    memset(key1.x, 0x11, sizeof key1.x);
+    memset(key1.y, 0x12, sizeof key1.y);
+    memset(key2.x, 0x21, sizeof key2.x);
+    memset(key2.y, 0x22, sizeof key2.y);
+    memset(priv_key, 0x33, sizeof priv_key);
+
+    ble_sm_test_util_us_sc_key_rotate(
+        &(struct ble_sm_pair_cmd) {
+            .io_cap = 3,
+            .oob_data_flag = 0,
+            .authreq = BLE_SM_PAIR_AUTHREQ_SC,
+            .max_enc_key_size = 16,
+            .init_key_dist = 0,
+            .resp_key_dist = 0,
+        },
+        &(struct ble_sm_pair_cmd) {
+            .io_cap = 3,
+            .oob_data_flag = 0,
+            .authreq = BLE_SM_PAIR_AUTHREQ_SC,
+            .max_enc_key_size = 16,
+            .init_key_dist = 0,
+            .resp_key_dist = 0,
+        },
+        &key1, &key2, priv_key);
+}
+#endif
+
 TEST_SUITE(ble_sm_gen_test_suite)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
@@ -660,6 +695,9 @@ TEST_SUITE(ble_sm_gen_test_suite)
     ble_sm_test_case_peer_bonding_bad();
     ble_sm_test_case_conn_broken();
     ble_sm_test_case_peer_sec_req_inval();
+#if MYNEWT_VAL(BLE_SM_SC) && MYNEWT_VAL(BLE_SM_SC_KEY_ROTATE)
+    ble_sm_test_case_us_sc_key_rotate();
+#endif
 }
 #endif
 
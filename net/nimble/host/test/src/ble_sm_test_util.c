@@ -1980,6 +1980,23 @@ ble_sm_test_util_peer_lgcy_good(struct ble_sm_test_params *params)
     ble_sm_test_util_bonding_all(params, 0);
 }
 
+static void
+ble_sm_test_util_verify_dhkey_ready(uint16_t conn_handle)
+{
+#if MYNEWT_VAL(BLE_SM_SC_CRYPTO_TASK)
+    struct ble_sm_proc *proc;
+
+    /* Without a running OS there is no crypto task; the DHKey must have
+     * been computed as soon as the peer's public key was received.
+     */
+    ble_hs_lock();
+    proc = ble_sm_proc_find(conn_handle, BLE_SM_PROC_STATE_NONE, -1, NULL);
+    TEST_ASSERT_FATAL(proc != NULL);
+    TEST_ASSERT(!(proc->flags & BLE_SM_PROC_F_DHKEY_PENDING));
+    ble_hs_unlock();
+#endif
+}
+
 static void
 ble_sm_test_util_us_sc_good_once(struct ble_sm_test_params *params)
 {
@@ -2031,6 +2048,7 @@ ble_sm_test_util_us_sc_good_once(struct ble_sm_test_params *params)
     TEST_ASSERT(!conn->bhc_sec_state.encrypted);
     TEST_ASSERT(ble_sm_dbg_num_procs() == 1);
     ble_sm_test_util_io_inject_bad(2, params->passkey_info.passkey.action);
+    ble_sm_test_util_verify_dhkey_ready(2);
 
     switch (params->pair_alg) {
     case BLE_SM_PAIR_ALG_PASSKEY:
@@ -2197,6 +2215,7 @@ ble_sm_test_util_peer_sc_good_once(struct ble_sm_test_params *params)
     TEST_ASSERT(!conn->bhc_sec_state.encrypted);
     TEST_ASSERT(ble_sm_dbg_num_procs() == 1);
     ble_sm_test_util_io_inject_bad(2, params->passkey_info.passkey.action);
+    ble_sm_test_util_verify_dhkey_ready(2);
 
     /* Ensure we sent the expected public key. */
     ble_hs_test_util_tx_all();
@@ -2354,6 +2373,72 @@ ble_sm_test_util_peer_sc_good(struct ble_sm_test_params *params)
     ble_sm_test_util_bonding_all(params, 0);
 }
 
+#if MYNEWT_VAL(BLE_SM_SC) && MYNEWT_VAL(BLE_SM_SC_KEY_ROTATE)
+/**
+ * Starts pairing procedures as initiator until our key pair gets rotated,
+ * verifying the public key we send in each.  Each procedure is aborted by
+ * a disconnect once our public key has been sent.  The first key pair gets
+ * generated as key1; key2 is what the next generation yields.
+ */
+void
+ble_sm_test_util_us_sc_key_rotate(struct ble_sm_pair_cmd *pair_req,
+                                  struct ble_sm_pair_cmd *pair_rsp,
+                                  struct ble_sm_public_key *key1,
+                                  struct ble_sm_public_key *key2,
+                                  uint8_t *priv_key)
+{
+    struct ble_sm_public_key *exp_key;
+    int rc;
+    int i;
+
+    ble_sm_test_util_init();
+
+    ble_hs_cfg.sm_io_cap = pair_req->io_cap;
+    ble_hs_cfg.sm_oob_data_flag = pair_req->oob_data_flag;
+    ble_hs_cfg.sm_bonding = !!(pair_req->authreq & BLE_SM_PAIR_AUTHREQ_BOND);
+    ble_hs_cfg.sm_mitm = !!(pair_req->authreq & BLE_SM_PAIR_AUTHREQ_MITM);
+    ble_hs_cfg.sm_sc = !!(pair_req->authreq & BLE_SM_PAIR_AUTHREQ_SC);
+    ble_hs_cfg.sm_keypress = !!(pair_req->authreq &
+                                BLE_SM_PAIR_AUTHREQ_KEYPRESS);
+    ble_hs_cfg.sm_our_key_dist = pair_req->init_key_dist;
+    ble_hs_cfg.sm_their_key_dist = pair_req->resp_key_dist;
+
+    ble_sm_dbg_set_sc_keys(key1->x, priv_key);
+
+    for (i = 0; i <= MYNEWT_VAL(BLE_SM_SC_KEY_ROTATE); i++) {
+        ble_sm_dbg_set_next_pair_rand(((uint8_t[16]){0}));
+        ble_hs_test_util_create_conn(2, ((uint8_t[6]){1,2,3,5,6,7}),
+                                     ble_sm_test_util_conn_cb, NULL);
+
+        rc = ble_hs_test_util_security_initiate(2, 0);
+        TEST_ASSERT_FATAL(rc == 0);
+
+        ble_hs_test_util_tx_all();
+        ble_sm_test_util_verify_tx_pair_req(pair_req);
+
+        ble_sm_test_util_rx_pair_rsp(2, pair_rsp, 0);
+
+        /* Our key pair is only replaced once it has been used for the
+         * configured number of procedures.
+         */
+        if (i < MYNEWT_VAL(BLE_SM_SC_KEY_ROTATE)) {
+            exp_key = key1;
+        } else {
+            exp_key = key2;
+        }
+        ble_hs_test_util_tx_all();
+        ble_sm_test_util_verify_tx_public_key(exp_key);
+        TEST_ASSERT(ble_sm_dbg_num_procs() == 1);
+
+        /* From now on, a generated key pair is key2. */
+        ble_sm_dbg_set_sc_keys(key2->x, priv_key);
+
+        ble_hs_test_util_conn_disconnect(2);
+        TEST_ASSERT(ble_sm_dbg_num_procs() == 0);
+    }
+}
+#endif
+
 void
 ble_sm_test_util_us_fail_inval(struct ble_sm_test_params *params)
 {
@@ -119,6 +119,11 @@ void ble_sm_test_util_peer_bonding_bad(uint16_t ediv, uint64_t rand_num);
 void ble_sm_test_util_peer_sc_good(struct ble_sm_test_params *params);
 void ble_sm_test_util_us_sc_good(struct ble_sm_test_params *params);
 void ble_sm_test_util_us_fail_inval(struct ble_sm_test_params *params);
+void ble_sm_test_util_us_sc_key_rotate(struct ble_sm_pair_cmd *pair_req,
+                                       struct ble_sm_pair_cmd *pair_rsp,
+                                       struct ble_sm_public_key *key1,
+                                       struct ble_sm_public_key *key2,
+                                       uint8_t *priv_key);
 
 #ifdef __cplusplus
 }
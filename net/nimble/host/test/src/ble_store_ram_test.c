@@ -0,0 +1,351 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ * 
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include <string.h>
+#include "testutil/testutil.h"
+#include "host/ble_hs_test.h"
+#include "host/ble_store.h"
+#include "store/ram/ble_store_ram.h"
+#include "ble_hs_test_util.h"
+#include "ble_hs_test_util_store.h"
+
+/* The security table limit before it became BLE_STORE_MAX_BONDS; the CCCD
+ * table was wrongly capped at it too.
+ */
+#define BLE_STORE_RAM_TEST_OLD_MAX  4
+
+#define BLE_STORE_RAM_TEST_NUM_SECS     MYNEWT_VAL(BLE_STORE_MAX_BONDS)
+#define BLE_STORE_RAM_TEST_NUM_CCCDS    MYNEWT_VAL(BLE_STORE_MAX_CCCDS)
+
+static const uint8_t ble_store_ram_test_addrs[2][6] = {
+    { 1, 2, 3, 4, 5, 6 },
+    { 6, 5, 4, 3, 2, 1 },
+};
+
+static struct ble_store_value_sec
+    ble_store_ram_test_secs[BLE_STORE_RAM_TEST_NUM_SECS + 1];
+static int ble_store_ram_test_num_secs;
+static struct ble_store_value_cccd
+    ble_store_ram_test_cccds[BLE_STORE_RAM_TEST_NUM_CCCDS + 1];
+static int ble_store_ram_test_num_cccds;
+
+static void
+ble_store_ram_test_init(void)
+{
+    ble_hs_test_util_init();
+
+    /* The reference store holds exactly what the RAM store should. */
+    ble_hs_test_util_store_init(BLE_STORE_RAM_TEST_NUM_SECS,
+                                BLE_STORE_RAM_TEST_NUM_SECS,
+                                BLE_STORE_RAM_TEST_NUM_CCCDS);
+    ble_store_ram_init();
+
+    /* Leave the host without a store, as other tests expect. */
+    ble_hs_cfg.store_read_cb = NULL;
+    ble_hs_cfg.store_write_cb = NULL;
+    ble_hs_cfg.store_delete_cb = NULL;
+
+    ble_store_ram_test_num_secs = 0;
+    ble_store_ram_test_num_cccds = 0;
+}
+
+static void
+ble_store_ram_test_gen_sec(struct ble_store_value_sec *sec, int i)
+{
+    memset(sec, 0, sizeof *sec);
+
+    /* Peer addresses repeat in an irregular pattern, so nth-match lookups
+     * have to skip entries of the other peer.
+     */
+    memcpy(sec->peer_addr, ble_store_ram_test_addrs[(i * 5 / 3) % 2], 6);
+    sec->peer_addr_type = BLE_ADDR_TYPE_PUBLIC;
+    sec->ediv = 0x100 + i;
+    sec->rand_num = 0x1122334455667700ULL + i;
+    sec->ltk[0] = i;
+    sec->ltk_present = 1;
+}
+
+static void
+ble_store_ram_test_gen_cccd(struct ble_store_value_cccd *cccd, int i)
+{
+    memset(cccd, 0, sizeof *cccd);
+
+    /* Both peers subscribe to the same handles. */
+    memcpy(cccd->peer_addr, ble_store_ram_test_addrs[i % 2], 6);
+    cccd->peer_addr_type = BLE_ADDR_TYPE_PUBLIC;
+    cccd->chr_val_handle = 0x10 + i / 2;
+    cccd->flags = i;
+}
+
+static void
+ble_store_ram_test_write(int obj_type, union ble_store_value *val,
+                         int exp_rc)
+{
+    int rc;
+
+    rc = ble_store_ram_write(obj_type, val);
+    TEST_ASSERT(rc == exp_rc);
+
+    rc = ble_hs_test_util_store_write(obj_type, val);
+    TEST_ASSERT(rc == exp_rc);
+}
+
+/**
+ * Looks up a key in both stores; the RAM store must return the same result
+ * as the reference store's linear scan.
+ */
+static void
+ble_store_ram_test_read(int obj_type, union ble_store_key *key)
+{
+    union ble_store_value val_ram;
+    union ble_store_value val_ref;
+    int rc_ram;
+    int rc_ref;
+
+    rc_ram = ble_store_ram_read(obj_type, key, &val_ram);
+    rc_ref = ble_hs_test_util_store_read(obj_type, key, &val_ref);
+    TEST_ASSERT(rc_ram == rc_ref);
+    if (rc_ram != 0 || rc_ref != 0) {
+        return;
+    }
+
+    switch (obj_type) {
+    case BLE_STORE_OBJ_TYPE_PEER_SEC:
+        TEST_ASSERT(memcmp(val_ram.sec.peer_addr, val_ref.sec.peer_addr,
+                           6) == 0);
+        TEST_ASSERT(val_ram.sec.ediv == val_ref.sec.ediv);
+        TEST_ASSERT(val_ram.sec.rand_num == val_ref.sec.rand_num);
+        TEST_ASSERT(val_ram.sec.ltk[0] == val_ref.sec.ltk[0]);
+        break;
+
+    case BLE_STORE_OBJ_TYPE_CCCD:
+        TEST_ASSERT(memcmp(val_ram.cccd.peer_addr, val_ref.cccd.peer_addr,
+                           6) == 0);
+        TEST_ASSERT(val_ram.cccd.chr_val_handle ==
+                    val_ref.cccd.chr_val_handle);
+        TEST_ASSERT(val_ram.cccd.flags == val_ref.cccd.flags);
+        break;
+
+    default:
+        TEST_ASSERT(0);
+        break;
+    }
+}
+
+/**
+ * Compares every kind of lookup the indexes serve: by address, by EDIV/Rand
+ * or handle, by both, and fully wildcarded, for every idx up to one past the
+ * last match.
+ */
+static void
+ble_store_ram_test_verify(void)
+{
+    struct ble_store_value_sec sec;
+    union ble_store_key key;
+    int a;
+    int i;
+    int n;
+
+    /*** Security: wildcard, address, EDIV/Rand. */
+    for (n = 0; n <= BLE_STORE_RAM_TEST_NUM_SECS; n++) {
+        memset(&key, 0, sizeof key);
+        key.sec.peer_addr_type = BLE_STORE_ADDR_TYPE_NONE;
+        key.sec.idx = n;
+        ble_store_ram_test_read(BLE_STORE_OBJ_TYPE_PEER_SEC, &key);
+
+        for (a = 0; a < 2; a++) {
+            memset(&key, 0, sizeof key);
+            key.sec.peer_addr_type = BLE_ADDR_TYPE_PUBLIC;
+            memcpy(key.sec.peer_addr, ble_store_ram_test_addrs[a], 6);
+            key.sec.idx = n;
+            ble_store_ram_test_read(BLE_STORE_OBJ_TYPE_PEER_SEC, &key);
+
+            key.sec.peer_addr_type = BLE_ADDR_TYPE_RANDOM;
+            ble_store_ram_test_read(BLE_STORE_OBJ_TYPE_PEER_SEC, &key);
+        }
+    }
+    for (i = 0; i <= BLE_STORE_RAM_TEST_NUM_SECS; i++) {
+        ble_store_ram_test_gen_sec(&sec, i);
+        ble_store_key_from_value_sec(&key.sec, &sec);
+        ble_store_ram_test_read(BLE_STORE_OBJ_TYPE_PEER_SEC, &key);
+
+        key.sec.peer_addr_type = BLE_STORE_ADDR_TYPE_NONE;
+        ble_store_ram_test_read(BLE_STORE_OBJ_TYPE_PEER_SEC, &key);
+    }
+
+    /*** CCCDs: wildcard, address, handle, both. */
+    for (n = 0; n <= BLE_STORE_RAM_TEST_NUM_CCCDS; n++) {
+        memset(&key, 0, sizeof key);
+        key.cccd.peer_addr_type = BLE_STORE_ADDR_TYPE_NONE;
+        key.cccd.idx = n;
+        ble_store_ram_test_read(BLE_STORE_OBJ_TYPE_CCCD, &key);
+
+        for (a = 0; a < 2; a++) {
+            memset(&key, 0, sizeof key);
+            key.cccd.peer_addr_type = BLE_ADDR_TYPE_PUBLIC;
+            memcpy(key.cccd.peer_addr, ble_store_ram_test_addrs[a], 6);
+            key.cccd.idx = n;
+            ble_store_ram_test_read(BLE_STORE_OBJ_TYPE_CCCD, &key);
+        }
+    }
+    for (i = 0; i <= BLE_STORE_RAM_TEST_NUM_CCCDS / 2; i++) {
+        for (n = 0; n < 3; n++) {
+            memset(&key, 0, sizeof key);
+            key.cccd.peer_addr_type = BLE_STORE_ADDR_TYPE_NONE;
+            key.cccd.chr_val_handle = 0x10 + i;
+            key.cccd.idx = n;
+            ble_store_ram_test_read(BLE_STORE_OBJ_TYPE_CCCD, &key);
+
+            for (a = 0; a < 2; a++) {
+                key.cccd.peer_addr_type = BLE_ADDR_TYPE_PUBLIC;
+                memcpy(key.cccd.peer_addr, ble_store_ram_test_addrs[a], 6);
+                ble_store_ram_test_read(BLE_STORE_OBJ_TYPE_CCCD, &key);
+            }
+        }
+    }
+}
+
+/**
+ * Reloads the reference store with the entries the RAM store should still
+ * hold, in order.
+ */
+static void
+ble_store_ram_test_reload_ref(void)
+{
+    int i;
+
+    ble_hs_test_util_store_init(BLE_STORE_RAM_TEST_NUM_SECS,
+                                BLE_STORE_RAM_TEST_NUM_SECS,
+                                BLE_STORE_RAM_TEST_NUM_CCCDS);
+    for (i = 0; i < ble_store_ram_test_num_secs; i++) {
+        ble_hs_test_util_store_write(
+            BLE_STORE_OBJ_TYPE_PEER_SEC,
+            (union ble_store_value *)(ble_store_ram_test_secs + i));
+    }
+    for (i = 0; i < ble_store_ram_test_num_cccds; i++) {
+        ble_hs_test_util_store_write(
+            BLE_STORE_OBJ_TYPE_CCCD,
+            (union ble_store_value *)(ble_store_ram_test_cccds + i));
+    }
+}
+
+static void
+ble_store_ram_test_fill_tables(void)
+{
+    union ble_store_value val;
+    int i;
+
+    for (i = 0; i < BLE_STORE_RAM_TEST_NUM_SECS; i++) {
+        ble_store_ram_test_gen_sec(&val.sec, i);
+        ble_store_ram_test_write(BLE_STORE_OBJ_TYPE_PEER_SEC, &val, 0);
+        ble_store_ram_test_secs[ble_store_ram_test_num_secs++] = val.sec;
+    }
+    ble_store_ram_test_gen_sec(&val.sec, i);
+    ble_store_ram_test_write(BLE_STORE_OBJ_TYPE_PEER_SEC, &val,
+                             BLE_HS_ENOMEM);
+
+    for (i = 0; i < BLE_STORE_RAM_TEST_NUM_CCCDS; i++) {
+        ble_store_ram_test_gen_cccd(&val.cccd, i);
+        ble_store_ram_test_write(BLE_STORE_OBJ_TYPE_CCCD, &val, 0);
+        ble_store_ram_test_cccds[ble_store_ram_test_num_cccds++] = val.cccd;
+    }
+    ble_store_ram_test_gen_cccd(&val.cccd, i);
+    ble_store_ram_test_write(BLE_STORE_OBJ_TYPE_CCCD, &val, BLE_HS_ENOMEM);
+}
+
+TEST_CASE(ble_store_ram_test_full)
+{
+    TEST_ASSERT_FATAL(BLE_STORE_RAM_TEST_NUM_SECS >
+                      BLE_STORE_RAM_TEST_OLD_MAX);
+    TEST_ASSERT_FATAL(BLE_STORE_RAM_TEST_NUM_CCCDS >
+                      BLE_STORE_RAM_TEST_OLD_MAX);
+
+    ble_store_ram_test_init();
+    ble_store_ram_test_fill_tables();
+    ble_store_ram_test_verify();
+}
+
+TEST_CASE(ble_store_ram_test_delete)
+{
+    union ble_store_value val;
+    union ble_store_key key;
+    int rc;
+    int i;
+
+    ble_store_ram_test_init();
+    ble_store_ram_test_fill_tables();
+
+    /*** Delete a security entry from the middle of its address chains. */
+    i = 2;
+    ble_store_key_from_value_sec(&key.sec, ble_store_ram_test_secs + i);
+    rc = ble_store_ram_delete(BLE_STORE_OBJ_TYPE_PEER_SEC, &key);
+    TEST_ASSERT(rc == 0);
+    rc = ble_store_ram_delete(BLE_STORE_OBJ_TYPE_PEER_SEC, &key);
+    TEST_ASSERT(rc == BLE_HS_ENOENT);
+    rc = ble_store_ram_read(BLE_STORE_OBJ_TYPE_PEER_SEC, &key, &val);
+    TEST_ASSERT(rc == BLE_HS_ENOENT);
+
+    ble_store_ram_test_num_secs--;
+    memmove(ble_store_ram_test_secs + i, ble_store_ram_test_secs + i + 1,
+            (ble_store_ram_test_num_secs - i) *
+            sizeof *ble_store_ram_test_secs);
+
+    /*** Delete the first and last CCCDs. */
+    ble_store_key_from_value_cccd(&key.cccd, ble_store_ram_test_cccds);
+    rc = ble_store_ram_delete(BLE_STORE_OBJ_TYPE_CCCD, &key);
+    TEST_ASSERT(rc == 0);
+    ble_store_key_from_value_cccd(
+        &key.cccd, ble_store_ram_test_cccds + ble_store_ram_test_num_cccds - 1);
+    rc = ble_store_ram_delete(BLE_STORE_OBJ_TYPE_CCCD, &key);
+    TEST_ASSERT(rc == 0);
+
+    ble_store_ram_test_num_cccds -= 2;
+    memmove(ble_store_ram_test_cccds, ble_store_ram_test_cccds + 1,
+            ble_store_ram_test_num_cccds * sizeof *ble_store_ram_test_cccds);
+
+    ble_store_ram_test_reload_ref();
+    ble_store_ram_test_verify();
+
+    /*** The freed slots can be reused. */
+    ble_store_ram_test_gen_sec(&val.sec, BLE_STORE_RAM_TEST_NUM_SECS);
+    ble_store_ram_test_write(BLE_STORE_OBJ_TYPE_PEER_SEC, &val, 0);
+    ble_store_ram_test_secs[ble_store_ram_test_num_secs++] = val.sec;
+
+    ble_store_ram_test_gen_cccd(&val.cccd, BLE_STORE_RAM_TEST_NUM_CCCDS);
+    ble_store_ram_test_write(BLE_STORE_OBJ_TYPE_CCCD, &val, 0);
+    ble_store_ram_test_cccds[ble_store_ram_test_num_cccds++] = val.cccd;
+
+    ble_store_ram_test_verify();
+}
+
+TEST_SUITE(ble_store_ram_test_suite)
+{
+    tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
+
+    ble_store_ram_test_full();
+    ble_store_ram_test_delete();
+}
+
+int
+ble_store_ram_test_all(void)
+{
+    ble_store_ram_test_suite();
+
+    return tu_any_failed;
+}
@@ -77,11 +77,65 @@ TEST_CASE(ble_uuid_test_128_to_16)
     }));
 }
 
+TEST_CASE(ble_uuid_test_compact)
+{
+    ble_uuid_any_t uuid1;
+    ble_uuid_any_t uuid2;
+    uint8_t flat[16];
+    int rc;
+
+    /*** 128-bit form of a 16-bit UUID shrinks to 16 bits. */
+    rc = ble_uuid_init_from_buf(&uuid1, BLE_UUID16(0x2a00), 16);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(uuid1.u.type == BLE_UUID_TYPE_16);
+    TEST_ASSERT(uuid1.u16.value == 0x2a00);
+    TEST_ASSERT(ble_uuid_u16(&uuid1.u) == 0x2a00);
+    TEST_ASSERT(ble_uuid_cmp(&uuid1.u, BLE_UUID16_DECLARE(0x2a00)) == 0);
+    TEST_ASSERT(ble_uuid_cmp(&uuid1.u, BLE_UUID16_DECLARE(0x2a01)) < 0);
+
+    /*** 16-bit flat UUID. */
+    rc = ble_uuid_init_from_buf(&uuid2, ((uint8_t[]){ 0x00, 0x2a }), 2);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(ble_uuid_cmp(&uuid1.u, &uuid2.u) == 0);
+
+    /*** 32-bit UUIDs stay 32 bits; short ones shrink. */
+    rc = ble_uuid_init_from_buf(&uuid1, ((uint8_t[]){ 1, 2, 3, 4 }), 4);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(uuid1.u.type == BLE_UUID_TYPE_32);
+    TEST_ASSERT(uuid1.u32.value == 0x04030201);
+    TEST_ASSERT(ble_uuid_u16(&uuid1.u) == 0);
+
+    ble_uuid_to_128(&uuid1.u, flat);
+    rc = ble_uuid_init_from_buf(&uuid2, flat, 16);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(ble_uuid_cmp(&uuid1.u, &uuid2.u) == 0);
+
+    rc = ble_uuid_init_from_buf(&uuid1, ((uint8_t[]){ 1, 2, 0, 0 }), 4);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(uuid1.u.type == BLE_UUID_TYPE_16);
+
+    /*** Vendor specific 128-bit UUID. */
+    memcpy(flat, BLE_UUID16(0x2a00), 16);
+    flat[0]++;
+    rc = ble_uuid_init_from_buf(&uuid1, flat, 16);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(uuid1.u.type == BLE_UUID_TYPE_128);
+    TEST_ASSERT(memcmp(uuid1.u128.value, flat, 16) == 0);
+    TEST_ASSERT(ble_uuid_cmp(&uuid1.u, BLE_UUID16_DECLARE(0x2a00)) != 0);
+
+    /*** Invalid lengths and zero UUIDs. */
+    rc = ble_uuid_init_from_buf(&uuid1, flat, 3);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+    rc = ble_uuid_init_from_buf(&uuid1, ((uint8_t[]){ 0, 0 }), 2);
+    TEST_ASSERT(rc == BLE_HS_EINVAL);
+}
+
 TEST_SUITE(ble_uuid_test_suite)
 {
     tu_suite_set_post_test_cb(ble_hs_test_util_post_test, NULL);
 
     ble_uuid_test_128_to_16();
+    ble_uuid_test_compact();
 }
 
 int
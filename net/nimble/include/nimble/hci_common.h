@@ -51,6 +51,7 @@ extern "C" {
 #define BLE_HCI_OGF_STATUS_PARAMS           (0x05)
 #define BLE_HCI_OGF_TESTING                 (0x06)
 #define BLE_HCI_OGF_LE                      (0x08)
+#define BLE_HCI_OGF_VENDOR                  (0x3F)
 
 /*
  * Number of LE commands. NOTE: this is really just used to size the array
@@ -128,6 +129,12 @@ extern "C" {
 #define BLE_HCI_OCF_LE_SET_RPA_TMO          (0x002E)
 #define BLE_HCI_OCF_LE_RD_MAX_DATA_LEN      (0x002F)
 
+/* List of OCF for vendor specific commands (OGF = 0x3F) */
+#define BLE_HCI_OCF_VS_RD_CHAN_STATS        (0x0001)
+#define BLE_HCI_OCF_VS_RD_CHAN_MAP          (0x0002)
+#define BLE_HCI_OCF_VS_CLR_CHAN_STATS       (0x0003)
+#define BLE_HCI_OCF_VS_RD_CONN_PERF         (0x0004)
+
 /* Command Specific Definitions */
 /* --- Disconnect command (OGF 0x01, OCF 0x0006) --- */
 #define BLE_HCI_DISCONNECT_CMD_LEN          (3)
@@ -151,6 +158,17 @@ extern "C" {
 #define BLE_HCI_READ_RSSI_LEN               (2)
 #define BLE_HCI_READ_RSSI_ACK_PARAM_LEN     (3)  /* No status byte. */
 
+/* --- Vendor read channel statistics (OGF 0x3F, OCF 0x0001) --- */
+#define BLE_HCI_VS_RD_CHAN_STATS_LEN        (1)
+#define BLE_HCI_VS_RD_CHAN_STATS_RSPLEN     (18) /* No status byte. */
+
+/* --- Vendor read adapted channel map (OGF 0x3F, OCF 0x0002) --- */
+#define BLE_HCI_VS_RD_CHAN_MAP_RSPLEN       (10) /* No status byte. */
+
+/* --- Vendor read connection performance (OGF 0x3F, OCF 0x0004) --- */
+#define BLE_HCI_VS_RD_CONN_PERF_LEN         (3)
+#define BLE_HCI_VS_RD_CONN_PERF_RSPLEN      (48) /* No status byte. */
+
 /* --- LE set event mask (OCF 0x0001) --- */
 #define BLE_HCI_SET_LE_EVENT_MASK_LEN       (8)
 
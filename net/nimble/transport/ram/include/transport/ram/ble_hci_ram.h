@@ -28,6 +28,18 @@ extern "C" {
 
 int ble_hci_ram_init(void);
 
+/**
+ * Callback used to hand the host a number of completed packets for a
+ * connection without encoding an HCI event. Executed in the controller's
+ * task.
+ */
+typedef void ble_hci_ram_num_comp_pkts_fn(uint16_t conn_handle,
+                                          uint16_t num_pkts, void *arg);
+
+void ble_hci_ram_cfg_hs_num_comp_pkts(ble_hci_ram_num_comp_pkts_fn *cb,
+                                      void *arg);
+int ble_hci_ram_ll_num_comp_pkts(uint16_t conn_handle, uint16_t num_pkts);
+
 #ifdef __cplusplus
 }
 #endif
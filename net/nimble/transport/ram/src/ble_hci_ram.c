@@ -45,6 +45,11 @@ static void *ble_hci_ram_evt_hi_buf;
 static struct os_mempool ble_hci_ram_evt_lo_pool;
 static void *ble_hci_ram_evt_lo_buf;
 
+#if MYNEWT_VAL(BLE_HCI_RAM_DIRECT)
+static ble_hci_ram_num_comp_pkts_fn *ble_hci_ram_num_comp_pkts_hs_cb;
+static void *ble_hci_ram_num_comp_pkts_hs_arg;
+#endif
+
 static uint8_t *ble_hci_ram_hs_cmd_buf;
 static uint8_t ble_hci_ram_hs_cmd_buf_alloced;
 
@@ -116,6 +121,49 @@ ble_hci_trans_ll_acl_tx(struct os_mbuf *om)
     return rc;
 }
 
+/**
+ * Configures the host callback that receives completed packet counts
+ * directly from the controller. Until this is called, the controller sends
+ * Number Of Completed Packets events as usual.
+ *
+ * @param cb                    The callback to execute.
+ * @param arg                   Optional argument to pass to the callback.
+ */
+void
+ble_hci_ram_cfg_hs_num_comp_pkts(ble_hci_ram_num_comp_pkts_fn *cb, void *arg)
+{
+#if MYNEWT_VAL(BLE_HCI_RAM_DIRECT)
+    ble_hci_ram_num_comp_pkts_hs_cb = cb;
+    ble_hci_ram_num_comp_pkts_hs_arg = arg;
+#endif
+}
+
+/**
+ * Hands the host the number of packets completed on a connection.
+ *
+ * @param conn_handle           The connection the packets were sent on.
+ * @param num_pkts              The number of completed packets.
+ *
+ * @return                      0 if the host has been told;
+ *                              BLE_ERR_UNSUPPORTED if the host must be sent
+ *                                  an HCI event instead.
+ */
+int
+ble_hci_ram_ll_num_comp_pkts(uint16_t conn_handle, uint16_t num_pkts)
+{
+#if MYNEWT_VAL(BLE_HCI_RAM_DIRECT)
+    if (ble_hci_ram_num_comp_pkts_hs_cb != NULL) {
+        if (num_pkts != 0) {
+            ble_hci_ram_num_comp_pkts_hs_cb(conn_handle, num_pkts,
+                                            ble_hci_ram_num_comp_pkts_hs_arg);
+        }
+        return 0;
+    }
+#endif
+
+    return BLE_ERR_UNSUPPORTED;
+}
+
 uint8_t *
 ble_hci_trans_buf_alloc(int type)
 {
@@ -29,6 +29,9 @@
 #include "mem/mem.h"
 #include "hal/hal_gpio.h"
 #include "hal/hal_uart.h"
+#if MYNEWT_VAL(BLE_HCI_UART_DMA)
+#include "stats/stats.h"
+#endif
 
 /* BLE */
 #include "nimble/ble.h"
@@ -143,6 +146,10 @@ static struct {
 
 static uint16_t ble_hci_uart_max_acl_datalen;
 
+#if MYNEWT_VAL(BLE_HCI_UART_DMA)
+static void ble_hci_uart_dma_tx_start(void);
+#endif
+
 /**
  * Allocates a buffer (mbuf) for ACL operation.
  *
@@ -182,7 +189,11 @@ ble_hci_uart_acl_tx(struct os_mbuf *om)
     STAILQ_INSERT_TAIL(&ble_hci_uart_state.tx_pkts, pkt, next);
     OS_EXIT_CRITICAL(sr);
 
+#if MYNEWT_VAL(BLE_HCI_UART_DMA)
+    ble_hci_uart_dma_tx_start();
+#else
     hal_uart_start_tx(MYNEWT_VAL(BLE_HCI_UART_PORT));
+#endif
 
     return 0;
 }
@@ -206,7 +217,11 @@ ble_hci_uart_cmdevt_tx(uint8_t *hci_ev, uint8_t h4_type)
     STAILQ_INSERT_TAIL(&ble_hci_uart_state.tx_pkts, pkt, next);
     OS_EXIT_CRITICAL(sr);
 
+#if MYNEWT_VAL(BLE_HCI_UART_DMA)
+    ble_hci_uart_dma_tx_start();
+#else
     hal_uart_start_tx(MYNEWT_VAL(BLE_HCI_UART_PORT));
+#endif
 
     return 0;
 }
@@ -642,6 +657,478 @@ ble_hci_uart_rx_char(void *arg, uint8_t data)
     }
 }
 
+#if MYNEWT_VAL(BLE_HCI_UART_DMA)
+/***
+ * DMA transport mode.
+ *
+ * Packets are moved by the UART driver a whole H4 field at a time: the
+ * packet type byte, the HCI header and then the payload, which is received
+ * directly into the command/event buffer or ACL mbuf. Transmission sends
+ * the packet type byte followed by the packet buffer (or each mbuf of an
+ * ACL chain). The per-byte framing above is only used for sync loss
+ * recovery, where the reset command has to be found in the byte stream.
+ */
+
+/* Largest single transfer handed to the UART driver */
+#define BLE_HCI_UART_DMA_MAX_XFER       (255)
+
+/* Size of buffer used to receive headers and payload of skipped packets */
+#define BLE_HCI_UART_DMA_SCRATCH_SZ     (32)
+
+#define BLE_HCI_UART_DMA_RX_TYPE        (0)
+#define BLE_HCI_UART_DMA_RX_HDR         (1)
+#define BLE_HCI_UART_DMA_RX_DATA        (2)
+#define BLE_HCI_UART_DMA_RX_SYNC        (3)
+
+STATS_SECT_START(ble_hci_uart_stats)
+    STATS_SECT_ENTRY(rx_cmds)
+    STATS_SECT_ENTRY(rx_evts)
+    STATS_SECT_ENTRY(rx_acls)
+    STATS_SECT_ENTRY(rx_bytes)
+    STATS_SECT_ENTRY(rx_skipped)
+    STATS_SECT_ENTRY(rx_sync_losses)
+    STATS_SECT_ENTRY(rx_xfers)
+    STATS_SECT_ENTRY(tx_cmds)
+    STATS_SECT_ENTRY(tx_evts)
+    STATS_SECT_ENTRY(tx_acls)
+    STATS_SECT_ENTRY(tx_bytes)
+    STATS_SECT_ENTRY(tx_xfers)
+STATS_SECT_END
+STATS_SECT_DECL(ble_hci_uart_stats) ble_hci_uart_stats;
+
+STATS_NAME_START(ble_hci_uart_stats)
+    STATS_NAME(ble_hci_uart_stats, rx_cmds)
+    STATS_NAME(ble_hci_uart_stats, rx_evts)
+    STATS_NAME(ble_hci_uart_stats, rx_acls)
+    STATS_NAME(ble_hci_uart_stats, rx_bytes)
+    STATS_NAME(ble_hci_uart_stats, rx_skipped)
+    STATS_NAME(ble_hci_uart_stats, rx_sync_losses)
+    STATS_NAME(ble_hci_uart_stats, rx_xfers)
+    STATS_NAME(ble_hci_uart_stats, tx_cmds)
+    STATS_NAME(ble_hci_uart_stats, tx_evts)
+    STATS_NAME(ble_hci_uart_stats, tx_acls)
+    STATS_NAME(ble_hci_uart_stats, tx_bytes)
+    STATS_NAME(ble_hci_uart_stats, tx_xfers)
+STATS_NAME_END(ble_hci_uart_stats)
+
+static struct {
+    /*** Receive side. */
+    uint8_t rx_phase;       /* BLE_HCI_UART_DMA_RX_[...] */
+    uint8_t rx_discard;     /* Received bytes are not kept */
+    uint8_t rx_h4_type;     /* Received packet type byte */
+    uint16_t rx_xfer;       /* Length of transfer in progress */
+    uint16_t rx_left;       /* Bytes left to receive in this phase */
+    uint16_t rx_pktlen;     /* Total length of packet being received */
+    uint8_t *rx_dptr;       /* Where next transfer is received */
+    uint8_t rx_scratch[BLE_HCI_UART_DMA_SCRATCH_SZ];
+
+    /*** Transmit side. */
+    uint8_t tx_busy;
+    uint8_t tx_h4_type;     /* Packet type byte being sent */
+    struct os_mbuf *tx_om;  /* Current mbuf of ACL data being sent */
+} ble_hci_uart_dma;
+
+static uint8_t ble_hci_uart_dma_stats_initialized;
+
+static void ble_hci_uart_dma_rx_phase_done(void);
+
+/**
+ * Start receiving a field of an H4 packet.
+ *
+ * @param dptr                  Where to place the received bytes. If NULL,
+ *                                  received bytes are discarded.
+ * @param len                   Number of bytes to receive.
+ */
+static void
+ble_hci_uart_dma_rx_start(uint8_t *dptr, uint16_t len)
+{
+    uint16_t xfer;
+    int rc;
+
+    if (dptr == NULL) {
+        ble_hci_uart_dma.rx_discard = 1;
+        dptr = ble_hci_uart_dma.rx_scratch;
+        xfer = min(len, BLE_HCI_UART_DMA_SCRATCH_SZ);
+    } else {
+        ble_hci_uart_dma.rx_discard = 0;
+        xfer = min(len, BLE_HCI_UART_DMA_MAX_XFER);
+    }
+
+    ble_hci_uart_dma.rx_dptr = dptr;
+    ble_hci_uart_dma.rx_left = len;
+    ble_hci_uart_dma.rx_xfer = xfer;
+
+    rc = hal_uart_dma_rx(MYNEWT_VAL(BLE_HCI_UART_PORT), dptr, xfer);
+    assert(rc == 0);
+}
+
+/**
+ * Called by the UART driver when a receive transfer completes.
+ */
+static void
+ble_hci_uart_dma_rx_done(void *arg)
+{
+    uint16_t xfer;
+    int rc;
+
+    STATS_INC(ble_hci_uart_stats, rx_xfers);
+    STATS_INCN(ble_hci_uart_stats, rx_bytes, ble_hci_uart_dma.rx_xfer);
+
+    ble_hci_uart_dma.rx_left -= ble_hci_uart_dma.rx_xfer;
+    if (ble_hci_uart_dma.rx_left == 0) {
+        ble_hci_uart_dma_rx_phase_done();
+        return;
+    }
+
+    /* Field is longer than one transfer; continue with the next part */
+    if (ble_hci_uart_dma.rx_discard) {
+        xfer = min(ble_hci_uart_dma.rx_left, BLE_HCI_UART_DMA_SCRATCH_SZ);
+    } else {
+        ble_hci_uart_dma.rx_dptr += ble_hci_uart_dma.rx_xfer;
+        xfer = min(ble_hci_uart_dma.rx_left, BLE_HCI_UART_DMA_MAX_XFER);
+    }
+    ble_hci_uart_dma.rx_xfer = xfer;
+
+    rc = hal_uart_dma_rx(MYNEWT_VAL(BLE_HCI_UART_PORT),
+                         ble_hci_uart_dma.rx_dptr, xfer);
+    assert(rc == 0);
+}
+
+static void
+ble_hci_uart_dma_rx_next_pkt(void)
+{
+    ble_hci_uart_state.rx_type = BLE_HCI_UART_H4_NONE;
+    ble_hci_uart_dma.rx_phase = BLE_HCI_UART_DMA_RX_TYPE;
+    ble_hci_uart_dma_rx_start(&ble_hci_uart_dma.rx_h4_type, 1);
+}
+
+#if MYNEWT_VAL(BLE_DEVICE)
+static void
+ble_hci_uart_dma_rx_sync_lost(void)
+{
+    STATS_INC(ble_hci_uart_stats, rx_sync_losses);
+    ble_hci_uart_sync_lost();
+    ble_hci_uart_dma.rx_phase = BLE_HCI_UART_DMA_RX_SYNC;
+    ble_hci_uart_dma_rx_start(ble_hci_uart_dma.rx_scratch, 1);
+}
+#endif
+
+/**
+ * Packet type byte received: allocate a buffer for the packet and start
+ * receiving its header.
+ */
+static void
+ble_hci_uart_dma_rx_type(void)
+{
+    uint8_t *hdr;
+    uint16_t hdr_len;
+
+    ble_hci_uart_rx_pkt_type(ble_hci_uart_dma.rx_h4_type);
+
+    switch (ble_hci_uart_state.rx_type) {
+#if MYNEWT_VAL(BLE_DEVICE)
+    case BLE_HCI_UART_H4_CMD:
+        hdr = ble_hci_uart_state.rx_cmd.data;
+        hdr_len = BLE_HCI_CMD_HDR_LEN;
+        break;
+    case BLE_HCI_UART_H4_SKIP_CMD:
+        hdr = ble_hci_uart_dma.rx_scratch;
+        hdr_len = BLE_HCI_CMD_HDR_LEN;
+        break;
+    case BLE_HCI_UART_H4_SYNC_LOSS:
+        STATS_INC(ble_hci_uart_stats, rx_sync_losses);
+        ble_hci_uart_dma.rx_phase = BLE_HCI_UART_DMA_RX_SYNC;
+        ble_hci_uart_dma_rx_start(ble_hci_uart_dma.rx_scratch, 1);
+        return;
+#endif
+#if MYNEWT_VAL(BLE_HOST)
+    case BLE_HCI_UART_H4_EVT:
+        hdr = ble_hci_uart_state.rx_cmd.data;
+        hdr_len = BLE_HCI_EVENT_HDR_LEN;
+        break;
+#endif
+    case BLE_HCI_UART_H4_ACL:
+        hdr = ble_hci_uart_state.rx_acl.dptr;
+        hdr_len = BLE_HCI_DATA_HDR_SZ;
+        break;
+    case BLE_HCI_UART_H4_SKIP_ACL:
+        hdr = ble_hci_uart_dma.rx_scratch;
+        hdr_len = BLE_HCI_DATA_HDR_SZ;
+        break;
+    default:
+        ble_hci_uart_dma_rx_next_pkt();
+        return;
+    }
+
+    ble_hci_uart_dma.rx_phase = BLE_HCI_UART_DMA_RX_HDR;
+    ble_hci_uart_dma_rx_start(hdr, hdr_len);
+}
+
+/**
+ * Packet header received: start receiving the payload.
+ */
+static void
+ble_hci_uart_dma_rx_hdr(void)
+{
+    uint8_t *hdr;
+    uint8_t *dptr;
+    uint16_t hdr_len;
+    uint16_t len;
+
+    switch (ble_hci_uart_state.rx_type) {
+#if MYNEWT_VAL(BLE_DEVICE)
+    case BLE_HCI_UART_H4_CMD:
+        hdr = ble_hci_uart_state.rx_cmd.data;
+        hdr_len = BLE_HCI_CMD_HDR_LEN;
+        len = hdr[2];
+        dptr = hdr + hdr_len;
+        break;
+    case BLE_HCI_UART_H4_SKIP_CMD:
+        hdr_len = BLE_HCI_CMD_HDR_LEN;
+        len = ble_hci_uart_dma.rx_scratch[2];
+        dptr = NULL;
+        break;
+#endif
+#if MYNEWT_VAL(BLE_HOST)
+    case BLE_HCI_UART_H4_EVT:
+        hdr = ble_hci_uart_state.rx_cmd.data;
+        hdr_len = BLE_HCI_EVENT_HDR_LEN;
+        len = hdr[1];
+        dptr = hdr + hdr_len;
+        break;
+#endif
+    case BLE_HCI_UART_H4_ACL:
+        hdr = ble_hci_uart_state.rx_acl.dptr;
+        hdr_len = BLE_HCI_DATA_HDR_SZ;
+        len = le16toh(hdr + 2);
+        if (len > ble_hci_uart_max_acl_datalen) {
+            os_mbuf_free_chain(ble_hci_uart_state.rx_acl.buf);
+#if MYNEWT_VAL(BLE_DEVICE)
+            ble_hci_uart_dma_rx_sync_lost();
+#else
+            ble_hci_uart_dma_rx_next_pkt();
+#endif
+            return;
+        }
+        dptr = hdr + hdr_len;
+        break;
+    case BLE_HCI_UART_H4_SKIP_ACL:
+        hdr_len = BLE_HCI_DATA_HDR_SZ;
+        len = le16toh(ble_hci_uart_dma.rx_scratch + 2);
+        dptr = NULL;
+        break;
+    default:
+        assert(0);
+        return;
+    }
+
+    ble_hci_uart_dma.rx_pktlen = hdr_len + len;
+    if (len == 0) {
+        ble_hci_uart_dma_rx_phase_done();
+        return;
+    }
+
+    ble_hci_uart_dma.rx_phase = BLE_HCI_UART_DMA_RX_DATA;
+    ble_hci_uart_dma_rx_start(dptr, len);
+}
+
+/**
+ * A complete packet has been received; hand it to the upper layer.
+ */
+static void
+ble_hci_uart_dma_rx_pkt(void)
+{
+    struct os_mbuf *om;
+    int rc;
+
+    switch (ble_hci_uart_state.rx_type) {
+#if MYNEWT_VAL(BLE_DEVICE)
+    case BLE_HCI_UART_H4_CMD:
+        STATS_INC(ble_hci_uart_stats, rx_cmds);
+        assert(ble_hci_uart_rx_cmd_cb != NULL);
+        rc = ble_hci_uart_rx_cmd_cb(ble_hci_uart_state.rx_cmd.data,
+                                    ble_hci_uart_rx_cmd_arg);
+        if (rc != 0) {
+            ble_hci_trans_buf_free(ble_hci_uart_state.rx_cmd.data);
+        }
+        break;
+    case BLE_HCI_UART_H4_SKIP_CMD:
+        STATS_INC(ble_hci_uart_stats, rx_skipped);
+        break;
+#endif
+#if MYNEWT_VAL(BLE_HOST)
+    case BLE_HCI_UART_H4_EVT:
+        STATS_INC(ble_hci_uart_stats, rx_evts);
+        assert(ble_hci_uart_rx_cmd_cb != NULL);
+        rc = ble_hci_uart_rx_cmd_cb(ble_hci_uart_state.rx_cmd.data,
+                                    ble_hci_uart_rx_cmd_arg);
+        if (rc != 0) {
+            ble_hci_trans_buf_free(ble_hci_uart_state.rx_cmd.data);
+        }
+        break;
+#endif
+    case BLE_HCI_UART_H4_ACL:
+        STATS_INC(ble_hci_uart_stats, rx_acls);
+        assert(ble_hci_uart_rx_acl_cb != NULL);
+        om = ble_hci_uart_state.rx_acl.buf;
+        OS_MBUF_PKTLEN(om) = ble_hci_uart_dma.rx_pktlen;
+        om->om_len = ble_hci_uart_dma.rx_pktlen;
+        ble_hci_uart_rx_acl_cb(om, ble_hci_uart_rx_acl_arg);
+        break;
+    case BLE_HCI_UART_H4_SKIP_ACL:
+        STATS_INC(ble_hci_uart_stats, rx_skipped);
+#if MYNEWT_VAL(BLE_DEVICE)
+        ble_ll_data_buffer_overflow();
+#endif
+        break;
+    default:
+        assert(0);
+        break;
+    }
+
+    ble_hci_uart_dma_rx_next_pkt();
+}
+
+static void
+ble_hci_uart_dma_rx_phase_done(void)
+{
+    switch (ble_hci_uart_dma.rx_phase) {
+    case BLE_HCI_UART_DMA_RX_TYPE:
+        ble_hci_uart_dma_rx_type();
+        break;
+    case BLE_HCI_UART_DMA_RX_HDR:
+        ble_hci_uart_dma_rx_hdr();
+        break;
+    case BLE_HCI_UART_DMA_RX_DATA:
+        ble_hci_uart_dma_rx_pkt();
+        break;
+#if MYNEWT_VAL(BLE_DEVICE)
+    case BLE_HCI_UART_DMA_RX_SYNC:
+        /* Look for a reset command one byte at a time */
+        ble_hci_uart_rx_sync_loss(ble_hci_uart_dma.rx_scratch[0]);
+        if (ble_hci_uart_state.rx_type == BLE_HCI_UART_H4_NONE) {
+            ble_hci_uart_dma_rx_next_pkt();
+        } else {
+            ble_hci_uart_dma_rx_start(ble_hci_uart_dma.rx_scratch, 1);
+        }
+        break;
+#endif
+    default:
+        assert(0);
+        break;
+    }
+}
+
+/**
+ * Start the next transmit transfer, if any. Picks the next packet from the
+ * queue when the current one is finished.
+ *
+ * Context: interrupts disabled.
+ */
+static void
+ble_hci_uart_dma_tx_next(void)
+{
+    const uint8_t *dptr;
+    uint16_t len;
+    int rc;
+
+    switch (ble_hci_uart_state.tx_type) {
+    case BLE_HCI_UART_H4_NONE:
+        rc = ble_hci_uart_tx_pkt_type();
+        if (rc < 0) {
+            ble_hci_uart_dma.tx_busy = 0;
+            return;
+        }
+
+        /* Send the packet type byte first */
+        ble_hci_uart_dma.tx_h4_type = rc;
+        if (rc == BLE_HCI_UART_H4_ACL) {
+            STATS_INC(ble_hci_uart_stats, tx_acls);
+            ble_hci_uart_dma.tx_om = ble_hci_uart_state.tx_acl;
+        } else if (rc == BLE_HCI_UART_H4_CMD) {
+            STATS_INC(ble_hci_uart_stats, tx_cmds);
+        } else {
+            STATS_INC(ble_hci_uart_stats, tx_evts);
+        }
+        dptr = &ble_hci_uart_dma.tx_h4_type;
+        len = 1;
+        break;
+
+    case BLE_HCI_UART_H4_CMD:
+    case BLE_HCI_UART_H4_EVT:
+        if (ble_hci_uart_state.tx_cmd.cur == ble_hci_uart_state.tx_cmd.len) {
+            ble_hci_trans_buf_free(ble_hci_uart_state.tx_cmd.data);
+            ble_hci_uart_state.tx_type = BLE_HCI_UART_H4_NONE;
+            ble_hci_uart_dma_tx_next();
+            return;
+        }
+        dptr = ble_hci_uart_state.tx_cmd.data + ble_hci_uart_state.tx_cmd.cur;
+        len = ble_hci_uart_state.tx_cmd.len - ble_hci_uart_state.tx_cmd.cur;
+        len = min(len, BLE_HCI_UART_DMA_MAX_XFER);
+        ble_hci_uart_state.tx_cmd.cur += len;
+        break;
+
+    case BLE_HCI_UART_H4_ACL:
+        /* Skip any empty mbufs in the chain */
+        while ((ble_hci_uart_dma.tx_om != NULL) &&
+               (ble_hci_uart_dma.tx_om->om_len == 0)) {
+            ble_hci_uart_dma.tx_om = SLIST_NEXT(ble_hci_uart_dma.tx_om,
+                                                om_next);
+        }
+        if (ble_hci_uart_dma.tx_om == NULL) {
+            os_mbuf_free_chain(ble_hci_uart_state.tx_acl);
+            ble_hci_uart_state.tx_type = BLE_HCI_UART_H4_NONE;
+            ble_hci_uart_dma_tx_next();
+            return;
+        }
+
+        /*
+         * The chain is freed only after the last transfer, so the data can
+         * be consumed in place by trimming the front of the current mbuf.
+         */
+        dptr = ble_hci_uart_dma.tx_om->om_data;
+        len = min(ble_hci_uart_dma.tx_om->om_len, BLE_HCI_UART_DMA_MAX_XFER);
+        ble_hci_uart_dma.tx_om->om_data += len;
+        ble_hci_uart_dma.tx_om->om_len -= len;
+        break;
+
+    default:
+        assert(0);
+        return;
+    }
+
+    STATS_INC(ble_hci_uart_stats, tx_xfers);
+    STATS_INCN(ble_hci_uart_stats, tx_bytes, len);
+    ble_hci_uart_dma.tx_busy = 1;
+    rc = hal_uart_dma_tx(MYNEWT_VAL(BLE_HCI_UART_PORT), dptr, len);
+    assert(rc == 0);
+}
+
+/**
+ * Called by the UART driver when a transmit transfer completes.
+ */
+static void
+ble_hci_uart_dma_tx_done(void *arg)
+{
+    ble_hci_uart_dma_tx_next();
+}
+
+/**
+ * Start transmitting queued packets if the UART is idle.
+ */
+static void
+ble_hci_uart_dma_tx_start(void)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    if (!ble_hci_uart_dma.tx_busy) {
+        ble_hci_uart_dma_tx_next();
+    }
+    OS_EXIT_CRITICAL(sr);
+}
+#endif
+
 static void
 ble_hci_uart_set_rx_cbs(ble_hci_trans_rx_cmd_fn *cmd_cb,
                         void *cmd_arg,
@@ -700,9 +1187,15 @@ ble_hci_uart_config(void)
 {
     int rc;
 
+#if MYNEWT_VAL(BLE_HCI_UART_DMA)
+    rc = hal_uart_dma_init_cbs(MYNEWT_VAL(BLE_HCI_UART_PORT),
+                               ble_hci_uart_dma_tx_done,
+                               ble_hci_uart_dma_rx_done, NULL);
+#else
     rc = hal_uart_init_cbs(MYNEWT_VAL(BLE_HCI_UART_PORT),
                            ble_hci_uart_tx_char, NULL,
                            ble_hci_uart_rx_char, NULL);
+#endif
     if (rc != 0) {
         return BLE_ERR_UNSPECIFIED;
     }
@@ -717,6 +1210,12 @@ ble_hci_uart_config(void)
         return BLE_ERR_HW_FAIL;
     }
 
+#if MYNEWT_VAL(BLE_HCI_UART_DMA)
+    /* Any transfer in progress was aborted when the UART was closed */
+    memset(&ble_hci_uart_dma, 0, sizeof ble_hci_uart_dma);
+    ble_hci_uart_dma_rx_next_pkt();
+#endif
+
     return 0;
 }
 
@@ -1044,14 +1543,26 @@ ble_hci_uart_init(void)
         goto err;
     }
 
-    rc = ble_hci_uart_config();
-    if (rc != 0) {
-        goto err;
+#if MYNEWT_VAL(BLE_HCI_UART_DMA)
+    if (!ble_hci_uart_dma_stats_initialized) {
+        rc = stats_init_and_reg(STATS_HDR(ble_hci_uart_stats),
+                                STATS_SIZE_INIT_PARMS(ble_hci_uart_stats,
+                                                      STATS_SIZE_32),
+                                STATS_NAME_INIT_PARMS(ble_hci_uart_stats),
+                                "ble_hci_uart");
+        assert(rc == 0);
+        ble_hci_uart_dma_stats_initialized = 1;
     }
+#endif
 
     memset(&ble_hci_uart_state, 0, sizeof ble_hci_uart_state);
     STAILQ_INIT(&ble_hci_uart_state.tx_pkts);
 
+    rc = ble_hci_uart_config();
+    if (rc != 0) {
+        goto err;
+    }
+
     return 0;
 
 err:
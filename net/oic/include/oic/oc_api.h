@@ -85,6 +85,15 @@ void oc_resource_set_discoverable(oc_resource_t *resource);
 void oc_resource_set_observable(oc_resource_t *resource);
 void oc_resource_set_periodic_observable(oc_resource_t *resource,
                                          uint16_t seconds);
+/*
+ * Notifications to an observer are at least pmin seconds apart; changes in
+ * between are coalesced into one.  If pmax is non-zero, observers hear from
+ * the resource at least every pmax seconds.  0 disables either limit.
+ */
+void oc_resource_set_observe_interval(oc_resource_t *resource, uint16_t pmin,
+                                      uint16_t pmax);
+/* Skip building request_payload; handlers use oc_get_request_stream(). */
+void oc_resource_set_raw_payload(oc_resource_t *resource);
 void oc_resource_set_request_handler(oc_resource_t *resource,
                                      oc_method_t method,
                                      oc_request_handler_t handler);
@@ -97,7 +106,24 @@ int oc_interate_query(oc_request_t *request, char **key, int *key_len,
                       char **value, int *value_len);
 int oc_get_query_value(oc_request_t *request, const char *key, char **value);
 
+/* Opens a streaming reader over the request payload; 0 on success. */
+int oc_get_request_stream(oc_request_t *request, oc_rep_stream_t *s);
+
 void oc_send_response(oc_request_t *request, oc_status_t response_code);
+
+/*
+ * Blockwise transfers (RFC 7959).  A handler for a representation larger
+ * than one block fills in the block that starts at oc_get_block_offset()
+ * (at most oc_get_block_size() bytes) with oc_send_block(), and the client
+ * fetches the rest block by block.  Raw payload resources receive Block1
+ * uploads one fragment per request; oc_get_request_block() tells where the
+ * fragment goes and whether more follow.
+ */
+uint32_t oc_get_block_offset(oc_request_t *request);
+uint16_t oc_get_block_size(oc_request_t *request);
+void oc_send_block(oc_request_t *request, oc_status_t response_code,
+                   const uint8_t *data, uint16_t len, bool more);
+bool oc_get_request_block(oc_request_t *request, uint32_t *offset, bool *more);
 void oc_ignore_request(oc_request_t *request);
 
 void oc_indicate_separate_response(oc_request_t *request,
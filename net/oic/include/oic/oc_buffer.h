@@ -21,13 +21,12 @@
 extern "C" {
 #endif
 
-struct oc_message_s;
-struct oc_message_s *oc_allocate_message(void);
-void oc_message_add_ref(struct oc_message_s *message);
-void oc_message_unref(struct oc_message_s *message);
+struct os_mbuf;
+struct oc_endpoint;
+struct os_mbuf *oc_allocate_mbuf(struct oc_endpoint *oe);
 
-void oc_recv_message(struct oc_message_s *message);
-void oc_send_message(struct oc_message_s *message);
+void oc_recv_message(struct os_mbuf *m);
+void oc_send_message(struct os_mbuf *m);
 
 #ifdef __cplusplus
 }
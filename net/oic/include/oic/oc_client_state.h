@@ -82,7 +82,9 @@ oc_client_cb_t *oc_ri_get_client_cb(const char *uri, oc_server_handle_t *server,
 
 void oc_ri_remove_client_cb_by_mid(uint16_t mid);
 
-oc_discovery_flags_t oc_ri_process_discovery_payload(uint8_t *payload, int len,
+struct os_mbuf;
+oc_discovery_flags_t oc_ri_process_discovery_payload(struct os_mbuf *m,
+                                                     uint16_t off,
                                                      oc_discovery_cb_t *handler,
                                                      oc_endpoint_t *endpoint);
 
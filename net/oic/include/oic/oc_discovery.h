@@ -23,6 +23,13 @@ extern "C" {
 
 void oc_create_discovery_resource(void);
 
+/*
+ * Drops the cached discovery responses.  Called when resources are added or
+ * removed; applications that change a registered resource's types,
+ * interfaces or properties afterwards must call it too.
+ */
+void oc_discovery_cache_invalidate(void);
+
 #ifdef __cplusplus
 }
 #endif
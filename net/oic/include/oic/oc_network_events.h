@@ -21,9 +21,9 @@
 extern "C" {
 #endif
 
-typedef struct oc_message_s oc_message_t;
+struct os_mbuf;
 
-void oc_network_event(oc_message_t *message);
+void oc_network_event(struct os_mbuf *m);
 
 #ifdef __cplusplus
 }
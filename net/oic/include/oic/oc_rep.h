@@ -18,6 +18,7 @@
 #define OC_REP_H
 
 #include <tinycbor/cbor.h>
+#include <tinycbor/cbor_mbuf_reader.h>
 #include "oc_constants.h"
 #include "oc_helpers.h"
 #include "../src/port/mynewt/config.h"
@@ -227,8 +228,45 @@ typedef struct oc_rep_s
 uint16_t oc_parse_rep(const uint8_t *payload, uint16_t payload_size,
                       oc_rep_t **value_list);
 
+struct os_mbuf;
+/* Parses the payload that starts at off and runs to the end of the chain. */
+uint16_t oc_parse_rep_mbuf(struct os_mbuf *m, uint16_t off,
+                           oc_rep_t **value_list);
+
 void oc_free_rep(oc_rep_t *rep);
 
+/*
+ * Streaming access to a payload.  Instead of building an oc_rep_t tree,
+ * fields of the top-level map are decoded straight out of the mbuf as they
+ * are asked for; nothing is allocated.  The stream must not be copied, as
+ * the iterators point back into it.
+ */
+typedef struct oc_rep_stream_s
+{
+  struct CborMbufReader reader;
+  CborParser parser;
+  CborValue root;
+} oc_rep_stream_t;
+
+/* Returns 0 if the payload at off is a CBOR map, -1 otherwise. */
+int oc_rep_stream_init(oc_rep_stream_t *s, struct os_mbuf *m, uint16_t off);
+
+/*
+ * Look up key in the top-level map.  The getters return false if the key is
+ * missing or holds a different type.  For strings, *len is the size of buf
+ * on entry and the string length on return; strings are null terminated.
+ */
+bool oc_rep_stream_find(oc_rep_stream_t *s, const char *key, CborValue *value);
+bool oc_rep_stream_get_int(oc_rep_stream_t *s, const char *key,
+                           int64_t *value);
+bool oc_rep_stream_get_bool(oc_rep_stream_t *s, const char *key, bool *value);
+bool oc_rep_stream_get_double(oc_rep_stream_t *s, const char *key,
+                              double *value);
+bool oc_rep_stream_get_text_string(oc_rep_stream_t *s, const char *key,
+                                   char *buf, size_t *len);
+bool oc_rep_stream_get_byte_string(oc_rep_stream_t *s, const char *key,
+                                   uint8_t *buf, size_t *len);
+
 #ifdef __cplusplus
 }
 #endif
@@ -34,8 +34,12 @@ typedef enum {
   OC_ACTIVE = (1 << 2),
   OC_SECURE = (1 << 4),
   OC_PERIODIC = (1 << 6),
+  OC_RAW_PAYLOAD = (1 << 7),
 } oc_resource_properties_t;
 
+/* Properties that are local to this stack and not advertised in "bm". */
+#define OC_LOCAL_PROPERTIES (OC_PERIODIC | OC_RAW_PAYLOAD)
+
 typedef enum {
   OC_STATUS_OK = 0,
   OC_STATUS_CREATED,
@@ -97,13 +101,27 @@ typedef enum {
 
 typedef struct oc_resource_s oc_resource_t;
 
+/* One key=value pair of a request query, decoded once per request. */
+typedef struct
+{
+  const char *key;
+  const char *value;
+  uint8_t key_len;
+  uint8_t value_len;
+} oc_query_param_t;
+
 typedef struct
 {
   oc_endpoint_t *origin;
   oc_resource_t *resource;
   const char *query;
   int query_len;
+  oc_query_param_t *query_params; /* NULL if query was not decoded */
+  uint8_t num_query_params;
+  uint8_t query_iter;
   oc_rep_t *request_payload;
+  struct os_mbuf *payload_m;    /* raw payload, valid during the handler */
+  uint16_t payload_off;
   oc_response_t *response;
   void *packet;
 } oc_request_t;
@@ -113,6 +131,7 @@ typedef void (*oc_request_handler_t)(oc_request_t *, oc_interface_mask_t);
 typedef struct oc_resource_s
 {
   struct oc_resource_s *next;
+  struct oc_resource_s *hash_next;  /* URI hash bucket chain */
   int device;
   oc_string_t uri;
   oc_string_array_t types;
@@ -125,6 +144,8 @@ typedef struct oc_resource_s
   oc_request_handler_t delete_handler;
   struct os_callout callout;
   uint16_t observe_period_seconds;
+  uint16_t observe_pmin;        /* seconds between notifications, min */
+  uint16_t observe_pmax;        /* seconds between notifications, max */
   uint8_t num_observers;
 } oc_resource_t;
 
@@ -149,6 +170,15 @@ int oc_ri_get_query_nth_key_value(const char *query, int query_len, char **key,
                                   int n);
 int oc_ri_get_query_value(const char *query, int query_len, const char *key,
                           char **value);
+/*
+ * Splits query into at most max key=value pairs.  Returns the number of
+ * pairs, or -1 if there are more than max.
+ */
+int oc_ri_parse_query(const char *query, int query_len,
+                      oc_query_param_t *params, int max);
+/* Like oc_ri_get_query_value(), over pairs from oc_ri_parse_query(). */
+int oc_ri_find_query_param(const oc_query_param_t *params, int n,
+                           const char *key, char **value);
 
 oc_interface_mask_t oc_ri_get_interface_mask(char *iface, int if_len);
 
@@ -21,36 +21,36 @@
 #ifdef OC_CLIENT
 #define OC_CLIENT_CB_TIMEOUT_SECS COAP_RESPONSE_TIMEOUT
 
-static oc_message_t *message;
+static struct os_mbuf *message;
 static coap_transaction_t *transaction;
 coap_packet_t request[1];
+/* request payloads are built here, and copied to mbufs when serialized */
+static uint8_t oc_client_buf[COAP_MAX_BLOCK_SIZE];
 
 static bool
 dispatch_coap_request(void)
 {
   int response_length = oc_rep_finalize();
+  if (response_length) {
+    coap_set_payload(request, oc_client_buf, response_length);
+    coap_set_header_content_format(request, APPLICATION_CBOR);
+  }
   if (!transaction) {
     if (message) {
-      if (response_length) {
-        coap_set_payload(request, message->data + COAP_MAX_HEADER_SIZE,
-                         response_length);
-        coap_set_header_content_format(request, APPLICATION_CBOR);
+      if (coap_serialize_message(request, message)) {
+        coap_send_message(message);
+      } else {
+        os_mbuf_free_chain(message);
       }
-      message->length = coap_serialize_message(request, message->data);
-      coap_send_message(message);
       message = 0;
       return true;
     }
   } else {
-    if (response_length) {
-      coap_set_payload(request,
-                       transaction->message->data + COAP_MAX_HEADER_SIZE,
-                       response_length);
-      coap_set_header_content_format(request, APPLICATION_CBOR);
+    if (coap_serialize_message(request, transaction->message)) {
+      coap_send_transaction(transaction);
+    } else {
+      coap_clear_transaction(transaction);
     }
-    transaction->message->length =
-      coap_serialize_message(request, transaction->message->data);
-    coap_send_transaction(transaction);
     transaction = 0;
     return true;
   }
@@ -67,15 +67,12 @@ prepare_coap_request(oc_client_cb_t *cb, oc_string_t *query)
     transaction = coap_new_transaction(cb->mid, &cb->server.endpoint);
     if (!transaction)
       return false;
-    oc_rep_new(transaction->message->data + COAP_MAX_HEADER_SIZE,
-               COAP_MAX_BLOCK_SIZE);
   } else {
-    message = oc_allocate_message();
+    message = oc_allocate_mbuf(&cb->server.endpoint);
     if (!message)
       return false;
-    memcpy(&message->endpoint, &cb->server.endpoint, sizeof(oc_endpoint_t));
-    oc_rep_new(message->data + COAP_MAX_HEADER_SIZE, COAP_MAX_BLOCK_SIZE);
   }
+  oc_rep_new(oc_client_buf, COAP_MAX_BLOCK_SIZE);
 
   coap_init_message(request, type, cb->method, cb->mid);
 
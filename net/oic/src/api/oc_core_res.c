@@ -15,6 +15,7 @@
  */
 
 #include "oc_core_res.h"
+#include "oc_discovery.h"
 #include "messaging/coap/oc_coap.h"
 #include "oc_rep.h"
 #include "oc_ri.h"
@@ -213,7 +214,7 @@ oc_core_init_platform(const char *mfg_name, oc_core_init_platform_cb_t init_cb,
 
   oc_core_encode_interfaces_mask(oc_rep_object(root),
                                  core_resources[OCF_P].interfaces);
-  oc_rep_set_uint(root, p, core_resources[OCF_P].properties & ~OC_PERIODIC);
+  oc_rep_set_uint(root, p, core_resources[OCF_P].properties & ~OC_LOCAL_PROPERTIES);
 
   oc_uuid_t uuid; /*fix uniqueness of platform id?? */
   oc_gen_uuid(&uuid);
@@ -253,6 +254,7 @@ oc_core_populate_resource(int type, const char *uri, const char *rt,
   r->put_handler = put;
   r->post_handler = post;
   r->delete_handler = delete;
+  oc_discovery_cache_invalidate();
 }
 
 oc_uuid_t *
@@ -18,9 +18,118 @@
 #include "oc_client_state.h"
 #endif /* OC_CLIENT */
 
+#include <stdlib.h>
+#include <string.h>
+#include <syscfg/syscfg.h>
+
 #include "messaging/coap/oc_coap.h"
 #include "oc_api.h"
 #include "oc_core_res.h"
+#include "oc_discovery.h"
+
+#if MYNEWT_VAL(OC_DISCOVERY_CACHE_ENTRIES) > 0
+/*
+ * Encoded discovery responses, keyed by interface and rt filter.  Building
+ * the response walks and encodes every resource; answering from the cache
+ * is a copy.  Entries are dropped whenever the set of resources changes.
+ */
+struct oc_discovery_cache_entry {
+  uint8_t *data;          /* rt filter followed by the payload; heap */
+  uint16_t rt_len;
+  uint16_t payload_len;   /* 0: the filter matched nothing */
+  oc_interface_mask_t interface;
+  uint32_t last_use;
+};
+
+static struct oc_discovery_cache_entry
+  oc_discovery_cache[MYNEWT_VAL(OC_DISCOVERY_CACHE_ENTRIES)];
+static uint32_t oc_discovery_cache_clock;
+static oc_uuid_t oc_discovery_cache_di;
+
+void
+oc_discovery_cache_invalidate(void)
+{
+  int i;
+
+  for (i = 0; i < MYNEWT_VAL(OC_DISCOVERY_CACHE_ENTRIES); i++) {
+    free(oc_discovery_cache[i].data);
+    oc_discovery_cache[i].data = NULL;
+  }
+}
+
+static struct oc_discovery_cache_entry *
+oc_discovery_cache_find(oc_interface_mask_t interface, const char *rt,
+                        int rt_len)
+{
+  struct oc_discovery_cache_entry *e;
+  int i;
+
+  /* The device id is part of the payload. */
+  if (memcmp(&oc_discovery_cache_di, oc_core_get_device_id(0),
+             sizeof(oc_discovery_cache_di))) {
+    oc_discovery_cache_invalidate();
+    memcpy(&oc_discovery_cache_di, oc_core_get_device_id(0),
+           sizeof(oc_discovery_cache_di));
+    return NULL;
+  }
+
+  for (i = 0; i < MYNEWT_VAL(OC_DISCOVERY_CACHE_ENTRIES); i++) {
+    e = &oc_discovery_cache[i];
+    if (e->data != NULL && e->interface == interface &&
+        e->rt_len == rt_len && memcmp(e->data, rt, rt_len) == 0) {
+      e->last_use = ++oc_discovery_cache_clock;
+      return e;
+    }
+  }
+  return NULL;
+}
+
+static void
+oc_discovery_cache_add(oc_interface_mask_t interface, const char *rt,
+                       int rt_len, const uint8_t *payload, int payload_len)
+{
+  struct oc_discovery_cache_entry *e, *victim;
+  uint8_t *data;
+  int i;
+
+  /* Never zero-sized; a NULL data pointer marks a free entry. */
+  data = malloc(rt_len + payload_len + 1);
+  if (data == NULL) {
+    return;
+  }
+  if (rt_len) {
+    memcpy(data, rt, rt_len);
+  }
+  if (payload_len) {
+    memcpy(data + rt_len, payload, payload_len);
+  }
+
+  /* Take a free entry, else the least recently used one. */
+  victim = &oc_discovery_cache[0];
+  for (i = 0; i < MYNEWT_VAL(OC_DISCOVERY_CACHE_ENTRIES); i++) {
+    e = &oc_discovery_cache[i];
+    if (e->data == NULL) {
+      victim = e;
+      break;
+    }
+    if ((int32_t)(e->last_use - victim->last_use) < 0) {
+      victim = e;
+    }
+  }
+
+  free(victim->data);
+  victim->data = data;
+  victim->rt_len = rt_len;
+  victim->payload_len = payload_len;
+  victim->interface = interface;
+  victim->last_use = ++oc_discovery_cache_clock;
+}
+#else
+void
+oc_discovery_cache_invalidate(void)
+{
+}
+#endif
 
 static bool
 filter_resource(oc_resource_t *resource, const char *rt, int rt_len,
@@ -65,7 +174,7 @@ filter_resource(oc_resource_t *resource, const char *rt, int rt_len,
 
   // p
   oc_rep_set_object(res, p);
-  oc_rep_set_uint(p, bm, resource->properties & ~OC_PERIODIC);
+  oc_rep_set_uint(p, bm, resource->properties & ~OC_LOCAL_PROPERTIES);
 #ifdef OC_SECURITY
   if (resource->properties & OC_SECURE) {
     oc_rep_set_boolean(p, sec, true);
@@ -129,9 +238,28 @@ oc_core_discovery_handler(oc_request_t *request, oc_interface_mask_t interface)
   char *rt = NULL;
   int rt_len = 0, matches = 0;
   if (request->query_len) {
-    rt_len =
-      oc_ri_get_query_value(request->query, request->query_len, "rt", &rt);
+    rt_len = oc_get_query_value(request, "rt", &rt);
+  }
+
+#if MYNEWT_VAL(OC_DISCOVERY_CACHE_ENTRIES) > 0
+  oc_response_buffer_t *rb = request->response->response_buffer;
+  struct oc_discovery_cache_entry *e;
+
+  if (rt_len < 0) {
+    rt_len = 0;
+  }
+  e = oc_discovery_cache_find(interface, rt, rt_len);
+  if (e != NULL && e->payload_len <= rb->buffer_size) {
+    if (e->payload_len == 0) {
+      rb->code = OC_IGNORE;
+    } else {
+      memcpy(rb->buffer, e->data + e->rt_len, e->payload_len);
+      rb->response_length = e->payload_len;
+      rb->code = oc_status_code(OC_STATUS_OK);
+    }
+    return;
   }
+#endif
 
   char uuid[37];
   oc_uuid_to_str(oc_core_get_device_id(0), uuid, 37);
@@ -163,6 +291,18 @@ oc_core_discovery_handler(oc_request_t *request, oc_interface_mask_t interface)
     /* There were rt/if selections and there were no matches, so ignore */
     request->response->response_buffer->code = OC_IGNORE;
   }
+
+#if MYNEWT_VAL(OC_DISCOVERY_CACHE_ENTRIES) > 0
+  if (interface == OC_IF_LL || interface == OC_IF_BASELINE) {
+    if (matches && response_length > 0) {
+      oc_discovery_cache_add(interface, rt, rt_len, rb->buffer,
+                             response_length);
+    } else if (response_length >= 0) {
+      /* Remember that the filter matches nothing, too. */
+      oc_discovery_cache_add(interface, rt, rt_len, NULL, 0);
+    }
+  }
+#endif
 }
 
 void
@@ -175,7 +315,7 @@ oc_create_discovery_resource(void)
 
 #ifdef OC_CLIENT
 oc_discovery_flags_t
-oc_ri_process_discovery_payload(uint8_t *payload, int len,
+oc_ri_process_discovery_payload(struct os_mbuf *m, uint16_t off,
                                 oc_discovery_cb_t *handler,
                                 oc_endpoint_t *endpoint)
 {
@@ -192,7 +332,8 @@ oc_ri_process_discovery_payload(uint8_t *payload, int len,
   memcpy(&handle.endpoint, endpoint, sizeof(oc_endpoint_t));
 
   oc_rep_t *array = 0, *rep;
-  int s = oc_parse_rep(payload, len, &rep);
+  unsigned int arena = oc_mmem_arena_mark();
+  int s = oc_parse_rep_mbuf(m, off, &rep);
   if (s == 0)
     array = rep;
   while (array != NULL) {
@@ -293,6 +434,7 @@ oc_ri_process_discovery_payload(uint8_t *payload, int len,
   }
 done:
   oc_free_rep(rep);
+  oc_mmem_arena_release(arena);
   return ret;
 }
 #endif /* OC_CLIENT */
@@ -15,43 +15,34 @@
 */
 
 #include <os/os_eventq.h>
+#include <os/os_mbuf.h>
 
 #include "oc_network_events.h"
 #include "oc_buffer.h"
 #include "port/oc_connectivity.h"
 #include "port/oc_signal_main_loop.h"
-#include "port/oc_network_events_mutex.h"
 #include "port/mynewt/adaptor.h"
-#include "util/oc_list.h"
 
-OC_LIST(network_events);
 static void oc_network_ev_process(struct os_event *ev);
-static struct os_event oc_network_ev = {
-    .ev_cb = oc_network_ev_process
+static struct os_mqueue oc_network_mq = {
+    .mq_head = STAILQ_HEAD_INITIALIZER(oc_network_mq.mq_head),
+    .mq_ev.ev_cb = oc_network_ev_process,
 };
 
 static void
 oc_network_ev_process(struct os_event *ev)
 {
-    struct oc_message_s *head;
+    struct os_mbuf *m;
 
-    oc_network_event_handler_mutex_lock();
-    while (1) {
-        head = oc_list_pop(network_events);
-        if (!head) {
-            break;
-        }
-        oc_recv_message(head);
+    while ((m = os_mqueue_get(&oc_network_mq)) != NULL) {
+        oc_recv_message(m);
     }
-    oc_network_event_handler_mutex_unlock();
 }
 
 void
-oc_network_event(oc_message_t *message)
+oc_network_event(struct os_mbuf *m)
 {
-    oc_network_event_handler_mutex_lock();
-    oc_list_add(network_events, message);
-    oc_network_event_handler_mutex_unlock();
-
-    os_eventq_put(oc_evq_get(), &oc_network_ev);
+    if (os_mqueue_put(&oc_network_mq, oc_evq_get(), m)) {
+        os_mbuf_free_chain(m);
+    }
 }
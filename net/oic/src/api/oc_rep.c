@@ -15,6 +15,7 @@
 */
 
 #include <stddef.h>
+#include <string.h>
 #include <os/os_mempool.h>
 
 #include "oc_rep.h"
@@ -24,6 +25,7 @@
 #include "api/oc_priv.h"
 #include <tinycbor/cbor_buf_writer.h>
 #include <tinycbor/cbor_buf_reader.h>
+#include <tinycbor/cbor_mbuf_reader.h>
 
 static struct os_mempool oc_rep_objects;
 static uint8_t oc_rep_objects_area[OS_MEMPOOL_BYTES(EST_NUM_REP_OBJECTS,
@@ -278,17 +280,15 @@ oc_parse_rep_value(CborValue *value, oc_rep_t **rep, CborError *err)
   }
 }
 
-uint16_t
-oc_parse_rep(const uint8_t *in_payload, uint16_t payload_size,
-             oc_rep_t **out_rep)
+static uint16_t
+oc_parse_rep_reader(struct cbor_decoder_reader *r, oc_rep_t **out_rep)
 {
   CborParser parser;
   CborValue root_value, cur_value, map;
   CborError err = CborNoError;
-  struct cbor_buf_reader br;
 
-  cbor_buf_reader_init(&br, in_payload, payload_size);
-  err |= cbor_parser_init(&br.r, 0, &parser, &root_value);
+  oc_mmem_arena_begin();
+  err |= cbor_parser_init(r, 0, &parser, &root_value);
   if (cbor_value_is_map(&root_value)) {
     err |= cbor_value_enter_container(&root_value, &cur_value);
     *out_rep = 0;
@@ -312,9 +312,138 @@ oc_parse_rep(const uint8_t *in_payload, uint16_t payload_size,
       cur = &(*cur)->next;
     }
   }
+  oc_mmem_arena_end();
   return (uint16_t)err;
 }
 
+uint16_t
+oc_parse_rep(const uint8_t *in_payload, uint16_t payload_size,
+             oc_rep_t **out_rep)
+{
+  struct cbor_buf_reader br;
+
+  cbor_buf_reader_init(&br, in_payload, payload_size);
+  return oc_parse_rep_reader(&br.r, out_rep);
+}
+
+uint16_t
+oc_parse_rep_mbuf(struct os_mbuf *m, uint16_t off, oc_rep_t **out_rep)
+{
+  struct CborMbufReader mr;
+
+  cbor_mbuf_reader_init(&mr, m, off);
+  return oc_parse_rep_reader(&mr.r, out_rep);
+}
+
+int
+oc_rep_stream_init(oc_rep_stream_t *s, struct os_mbuf *m, uint16_t off)
+{
+  cbor_mbuf_reader_init(&s->reader, m, off);
+  if (cbor_parser_init(&s->reader.r, 0, &s->parser, &s->root) != CborNoError ||
+      !cbor_value_is_map(&s->root)) {
+    return -1;
+  }
+  return 0;
+}
+
+/*
+ * cbor_value_map_find_value() can't be used with these readers, so keys
+ * are matched here: only keys of the right length are copied and compared.
+ */
+bool
+oc_rep_stream_find(oc_rep_stream_t *s, const char *key, CborValue *value)
+{
+  size_t key_len = strlen(key);
+  size_t len;
+  char name[key_len + 1];
+  bool match;
+
+  if (cbor_value_enter_container(&s->root, value) != CborNoError) {
+    return false;
+  }
+  while (!cbor_value_at_end(value)) {
+    match = false;
+    if (cbor_value_is_text_string(value) &&
+        cbor_value_calculate_string_length(value, &len) == CborNoError &&
+        len == key_len) {
+      len = sizeof(name);
+      if (cbor_value_copy_text_string(value, name, &len, NULL) ==
+            CborNoError && !memcmp(name, key, key_len)) {
+        match = true;
+      }
+    }
+    /* step over the key, and then the value unless this is the one */
+    if (cbor_value_advance(value) != CborNoError ||
+        cbor_value_at_end(value)) {
+      return false;
+    }
+    if (match) {
+      return true;
+    }
+    if (cbor_value_advance(value) != CborNoError) {
+      return false;
+    }
+  }
+  return false;
+}
+
+bool
+oc_rep_stream_get_int(oc_rep_stream_t *s, const char *key, int64_t *value)
+{
+  CborValue v;
+
+  if (!oc_rep_stream_find(s, key, &v) || !cbor_value_is_integer(&v)) {
+    return false;
+  }
+  return cbor_value_get_int64(&v, value) == CborNoError;
+}
+
+bool
+oc_rep_stream_get_bool(oc_rep_stream_t *s, const char *key, bool *value)
+{
+  CborValue v;
+
+  if (!oc_rep_stream_find(s, key, &v) || !cbor_value_is_boolean(&v)) {
+    return false;
+  }
+  return cbor_value_get_boolean(&v, value) == CborNoError;
+}
+
+bool
+oc_rep_stream_get_double(oc_rep_stream_t *s, const char *key, double *value)
+{
+  CborValue v;
+
+  if (!oc_rep_stream_find(s, key, &v) || !cbor_value_is_double(&v)) {
+    return false;
+  }
+  return cbor_value_get_double(&v, value) == CborNoError;
+}
+
+bool
+oc_rep_stream_get_text_string(oc_rep_stream_t *s, const char *key, char *buf,
+                              size_t *len)
+{
+  CborValue v;
+
+  if (!oc_rep_stream_find(s, key, &v) || !cbor_value_is_text_string(&v)) {
+    return false;
+  }
+  return cbor_value_copy_text_string(&v, buf, len, NULL) == CborNoError;
+}
+
+bool
+oc_rep_stream_get_byte_string(oc_rep_stream_t *s, const char *key,
+                              uint8_t *buf, size_t *len)
+{
+  CborValue v;
+
+  if (!oc_rep_stream_find(s, key, &v) || !cbor_value_is_byte_string(&v)) {
+    return false;
+  }
+  return cbor_value_copy_byte_string(&v, buf, len, NULL) == CborNoError;
+}
+
 void
 oc_rep_init(void)
 {
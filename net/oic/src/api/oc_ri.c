@@ -51,6 +51,10 @@ static struct os_mempool oc_resources;
 static uint8_t oc_resource_area[OS_MEMPOOL_BYTES(MAX_APP_RESOURCES,
       sizeof(oc_resource_t))];
 
+/* Application resources hashed by URI, so dispatch does not walk the list. */
+#define OC_RI_URI_BUCKETS 16
+static oc_resource_t *uri_buckets[OC_RI_URI_BUCKETS];
+
 static void periodic_observe_handler(struct os_event *ev);
 #endif /* OC_SERVER */
 
@@ -162,6 +166,50 @@ oc_ri_get_query_nth_key_value(const char *query, int query_len, char **key,
   return next_pos;
 }
 
+int
+oc_ri_parse_query(const char *query, int query_len, oc_query_param_t *params,
+                  int max)
+{
+  const char *end = query + query_len, *amp, *eq;
+  int n = 0;
+
+  while (query < end) {
+    amp = memchr(query, '&', end - query);
+    if (!amp) {
+      amp = end;
+    }
+    eq = memchr(query, '=', amp - query);
+    if (eq) {
+      if (n == max) {
+        return -1;
+      }
+      params[n].key = query;
+      params[n].key_len = eq - query;
+      params[n].value = eq + 1;
+      params[n].value_len = amp - (eq + 1);
+      n++;
+    }
+    query = amp + 1;
+  }
+  return n;
+}
+
+int
+oc_ri_find_query_param(const oc_query_param_t *params, int n, const char *key,
+                       char **value)
+{
+  int i;
+
+  for (i = 0; i < n; i++) {
+    if (params[i].key_len == strlen(key) &&
+        strncasecmp(key, params[i].key, params[i].key_len) == 0) {
+      *value = (char *)params[i].value;
+      return params[i].value_len;
+    }
+  }
+  return -1;
+}
+
 int
 oc_ri_get_query_value(const char *query, int query_len, const char *key,
                       char **value)
@@ -201,17 +249,41 @@ stop_processes(void)
 }
 
 #ifdef OC_SERVER
+/* FNV-1a over the path, without its leading '/'. */
+static unsigned int
+oc_ri_uri_bucket(const char *path, int len)
+{
+  uint32_t h = 2166136261UL;
+
+  while (len-- > 0) {
+    h ^= (uint8_t)*path++;
+    h *= 16777619UL;
+  }
+  return h & (OC_RI_URI_BUCKETS - 1);
+}
+
+static oc_resource_t *
+oc_ri_find_app_resource(const char *path, int len)
+{
+  oc_resource_t *res;
+
+  for (res = uri_buckets[oc_ri_uri_bucket(path, len)]; res;
+       res = res->hash_next) {
+    if (oc_string_len(res->uri) == (len + 1) &&
+        strncmp((const char *)oc_string(res->uri) + 1, path, len) == 0) {
+      return res;
+    }
+  }
+  return NULL;
+}
+
 oc_resource_t *
 oc_ri_get_app_resource_by_uri(const char *uri)
 {
-  oc_resource_t *res = oc_ri_get_app_resources();
-  while (res != NULL) {
-    if (oc_string_len(res->uri) == strlen(uri) &&
-        strncmp(uri, oc_string(res->uri), strlen(uri)) == 0)
-      return res;
-    res = res->next;
+  if (uri[0] != '/') {
+    return NULL;
   }
-  return res;
+  return oc_ri_find_app_resource(uri + 1, strlen(uri) - 1);
 }
 #endif
 
@@ -257,6 +329,8 @@ oc_ri_alloc_resource(void)
     if (resource) {
         os_callout_init(&resource->callout, oc_evq_get(),
           periodic_observe_handler, resource);
+        /* Periodic notifications yield to request / response traffic. */
+        OS_EVENT_PRIO_SET(&resource->callout.c_ev, OS_EVENT_PRIO_LOWEST);
     }
     return resource;
 }
@@ -264,6 +338,19 @@ oc_ri_alloc_resource(void)
 void
 oc_ri_delete_resource(oc_resource_t *resource)
 {
+    oc_resource_t **prev;
+
+    prev = &uri_buckets[oc_ri_uri_bucket(oc_string(resource->uri) + 1,
+                                         oc_string_len(resource->uri) - 1)];
+    while (*prev) {
+        if (*prev == resource) {
+            *prev = resource->hash_next;
+            oc_list_remove(app_resources, resource);
+            oc_discovery_cache_invalidate();
+            break;
+        }
+        prev = &(*prev)->hash_next;
+    }
     os_memblock_put(&oc_resources, resource);
 }
 
@@ -280,8 +367,18 @@ oc_ri_add_resource(oc_resource_t *resource)
       resource->observe_period_seconds == 0) {
         valid = false;
     }
+    if (oc_string_len(resource->uri) < 1 ||
+      oc_string(resource->uri)[0] != '/') {
+        valid = false;
+    }
     if (valid) {
+        unsigned int b = oc_ri_uri_bucket(oc_string(resource->uri) + 1,
+                                          oc_string_len(resource->uri) - 1);
+
         oc_list_add(app_resources, resource);
+        resource->hash_next = uri_buckets[b];
+        uri_buckets[b] = resource;
+        oc_discovery_cache_invalidate();
     }
 
     return valid;
@@ -397,7 +494,12 @@ oc_ri_invoke_coap_entity_handler(void *request, void *response, uint8_t *buffer,
 
   request_obj.response = &response_obj;
   request_obj.request_payload = 0;
+  request_obj.payload_m = NULL;
+  request_obj.payload_off = 0;
   request_obj.query_len = 0;
+  request_obj.query_params = NULL;
+  request_obj.num_query_params = 0;
+  request_obj.query_iter = 0;
   request_obj.resource = 0;
   request_obj.origin = endpoint;
   request_obj.packet = packet;
@@ -413,42 +515,47 @@ oc_ri_invoke_coap_entity_handler(void *request, void *response, uint8_t *buffer,
   const char *uri_query;
   int uri_query_len = coap_get_header_uri_query(request, &uri_query);
 
+  oc_query_param_t query_params[MAX_QUERY_PARAMS];
   if (uri_query_len) {
     request_obj.query = uri_query;
     request_obj.query_len = uri_query_len;
 
+    /* Split the query once; handlers look values up in the result.  If it
+     * has too many parameters, they fall back to scanning the string. */
+    int n = oc_ri_parse_query(uri_query, uri_query_len, query_params,
+                              MAX_QUERY_PARAMS);
+    if (n >= 0) {
+      request_obj.query_params = query_params;
+      request_obj.num_query_params = n;
+    }
+
     /* Check if query string includes interface selection. */
     char *iface;
-    int if_len = oc_ri_get_query_value(uri_query, uri_query_len, "if", &iface);
+    int if_len = (n >= 0)
+      ? oc_ri_find_query_param(query_params, n, "if", &iface)
+      : oc_ri_get_query_value(uri_query, uri_query_len, "if", &iface);
     if (if_len != -1) {
       interface |= oc_ri_get_interface_mask(iface, if_len);
     }
   }
 
-  /* Obtain handle to buffer containing the serialized payload */
-  const uint8_t *payload;
-  int payload_len = coap_get_payload(request, &payload);
+  /* Obtain handle to the mbuf containing the serialized payload */
+  struct os_mbuf *payload;
+  uint16_t payload_off;
+  int payload_len = coap_get_payload(request, &payload, &payload_off);
   if (payload_len) {
-    /* Attempt to parse request payload using tinyCBOR via oc_rep helper
-     * functions. The result of this parse is a tree of oc_rep_t structures
-     * which will reflect the schema of the payload.
-     * Any failures while parsing the payload is viewed as an erroneous
-     * request and results in a 4.00 response being sent.
-     */
-    if (oc_parse_rep(payload, payload_len, &request_obj.request_payload) != 0) {
-      LOG("ocri: error parsing request payload\n");
-      bad_request = true;
-    }
+    request_obj.payload_m = payload;
+    request_obj.payload_off = payload_off;
   }
 
   oc_resource_t *resource, *cur_resource = NULL;
 
-  /* If there were no errors thus far, attempt to locate the specific
-   * resource object that will handle the request using the request uri.
+  /* Attempt to locate the specific resource object that will handle the
+   * request using the request uri.
    */
   /* Check against list of declared core resources.
    */
-  if (!bad_request) {
+  {
     int i;
     for (i = 0; i < NUM_OC_CORE_RESOURCES; i++) {
       resource = oc_core_get_resource_by_index(i);
@@ -464,20 +571,31 @@ oc_ri_invoke_coap_entity_handler(void *request, void *response, uint8_t *buffer,
 #ifdef OC_SERVER
   /* Check against list of declared application resources.
    */
-  if (!cur_resource && !bad_request) {
-    for (resource = oc_ri_get_app_resources(); resource;
-         resource = resource->next) {
-      if (oc_string_len(resource->uri) == (uri_path_len + 1) &&
-          strncmp((const char *)oc_string(resource->uri) + 1, uri_path,
-                  uri_path_len) == 0) {
-        request_obj.resource = cur_resource = resource;
-        break;
-      }
-    }
+  if (!cur_resource) {
+    request_obj.resource = cur_resource =
+      oc_ri_find_app_resource(uri_path, uri_path_len);
   }
 #endif
 
-  if (cur_resource) {
+  unsigned int arena = oc_mmem_arena_mark();
+  if (payload_len &&
+      !(cur_resource && (cur_resource->properties & OC_RAW_PAYLOAD))) {
+    /* Attempt to parse request payload using tinyCBOR via oc_rep helper
+     * functions. The result of this parse is a tree of oc_rep_t structures
+     * which will reflect the schema of the payload.
+     * Any failures while parsing the payload is viewed as an erroneous
+     * request and results in a 4.00 response being sent.
+     * Resources marked OC_RAW_PAYLOAD read the payload through
+     * oc_rep_stream_t instead, so no tree is built for them.
+     */
+    if (oc_parse_rep_mbuf(payload, payload_off,
+                          &request_obj.request_payload) != 0) {
+      LOG("ocri: error parsing request payload\n");
+      bad_request = true;
+    }
+  }
+
+  if (cur_resource && !bad_request) {
     /* If there was no interface selection, pick the "default interface". */
     if (interface == 0)
       interface = cur_resource->default_interface;
@@ -539,6 +657,7 @@ oc_ri_invoke_coap_entity_handler(void *request, void *response, uint8_t *buffer,
      * payload structure (and return its memory to the pool).
      */
     oc_free_rep(request_obj.request_payload);
+    oc_mmem_arena_release(arena);
   }
 
   if (bad_request) {
@@ -649,12 +768,29 @@ oc_ri_invoke_coap_entity_handler(void *request, void *response, uint8_t *buffer,
      */
     erbium_status_code = CLEAR_TRANSACTION;
   } else {
+    /* A raw payload resource takes Block1 uploads one fragment at a time.
+     * Acknowledge each fragment by echoing its Block1 option, with a 2.31
+     * response for all but the last one.
+     */
+    uint32_t block1_num;
+    uint16_t block1_size;
+    uint8_t block1_more = 0;
+    if (cur_resource && (cur_resource->properties & OC_RAW_PAYLOAD) &&
+        coap_get_header_block1(request, &block1_num, &block1_more,
+                               &block1_size, NULL) &&
+        response_buffer.code < oc_status_code(OC_STATUS_BAD_REQUEST)) {
+      coap_set_header_block1(response, block1_num, block1_more,
+                             MIN(block1_size, COAP_MAX_BLOCK_SIZE));
+      if (block1_more) {
+        response_buffer.code = CONTINUE_2_31;
+      }
+    }
 #ifdef OC_SERVER
     /* If the recently handled request was a PUT/POST, it conceivably
      * altered the resource state, so attempt to notify all observers
      * of that resource with the change.
      */
-    if ((method == OC_PUT || method == OC_POST) &&
+    if ((method == OC_PUT || method == OC_POST) && !block1_more &&
         response_buffer.code < oc_status_code(OC_STATUS_BAD_REQUEST))
       coap_notify_observers(cur_resource, NULL, NULL);
 #endif
@@ -702,11 +838,13 @@ oc_ri_send_rst(oc_endpoint_t *endpoint, uint8_t *token, uint8_t token_len,
   coap_init_message(rst, COAP_TYPE_RST, 0, mid);
   coap_set_header_observe(rst, 1);
   coap_set_token(rst, token, token_len);
-  oc_message_t *message = oc_allocate_message();
-  if (message) {
-    message->length = coap_serialize_message(rst, message->data);
-    coap_send_message(message);
-    return true;
+  struct os_mbuf *m = oc_allocate_mbuf(endpoint);
+  if (m) {
+    if (coap_serialize_message(rst, m)) {
+      coap_send_message(m);
+      return true;
+    }
+    os_mbuf_free_chain(m);
   }
   return false;
 }
@@ -714,7 +852,8 @@ oc_ri_send_rst(oc_endpoint_t *endpoint, uint8_t *token, uint8_t token_len,
 bool
 oc_ri_invoke_client_cb(void *response, oc_endpoint_t *endpoint)
 {
-  uint8_t *payload;
+  struct os_mbuf *payload;
+  uint16_t payload_off;
   int payload_len;
   coap_packet_t *const pkt = (coap_packet_t *)response;
   oc_client_cb_t *cb = oc_list_head(client_cbs);
@@ -766,21 +905,24 @@ oc_ri_invoke_client_cb(void *response, oc_endpoint_t *endpoint)
   if payload exists, process payload and save in client response
   send client response to callback and return
       */
-      payload_len = coap_get_payload(response, (const uint8_t **)&payload);
+      payload_len = coap_get_payload(response, &payload, &payload_off);
       if (payload_len) {
         if (cb->discovery) {
-          if (oc_ri_process_discovery_payload(payload, payload_len, cb->handler,
-                                              endpoint) == OC_STOP_DISCOVERY) {
+          if (oc_ri_process_discovery_payload(payload, payload_off,
+                                              cb->handler, endpoint) ==
+              OC_STOP_DISCOVERY) {
             free_client_cb(cb);
           }
         } else {
+          unsigned int arena = oc_mmem_arena_mark();
           uint16_t err =
-            oc_parse_rep(payload, payload_len, &client_response.payload);
+            oc_parse_rep_mbuf(payload, payload_off, &client_response.payload);
           if (err == 0) {
             oc_response_handler_t handler = (oc_response_handler_t)cb->handler;
             handler(&client_response);
           }
           oc_free_rep(client_response.payload);
+          oc_mmem_arena_release(arena);
         }
       } else { // no payload
         if (pkt->type == COAP_TYPE_ACK && pkt->code == 0) {
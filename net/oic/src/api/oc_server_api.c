@@ -15,6 +15,8 @@
 */
 #include <stddef.h>
 
+#include <string.h>
+
 #include <os/os_callout.h>
 
 #include "messaging/coap/engine.h"
@@ -57,7 +59,21 @@ oc_init_platform(const char *mfg_name, oc_init_platform_cb_t init_platform_cb,
 int
 oc_get_query_value(oc_request_t *request, const char *key, char **value)
 {
-  return oc_ri_get_query_value(request->query, request->query_len, key, value);
+  if (!request->query_params) {
+    return oc_ri_get_query_value(request->query, request->query_len, key,
+                                 value);
+  }
+  return oc_ri_find_query_param(request->query_params,
+                                request->num_query_params, key, value);
+}
+
+int
+oc_get_request_stream(oc_request_t *request, oc_rep_stream_t *s)
+{
+  if (!request->payload_m) {
+    return -1;
+  }
+  return oc_rep_stream_init(s, request->payload_m, request->payload_off);
 }
 
 static int
@@ -75,6 +91,51 @@ oc_send_response(oc_request_t *request, oc_status_t response_code)
   request->response->response_buffer->code = oc_status_code(response_code);
 }
 
+uint32_t
+oc_get_block_offset(oc_request_t *request)
+{
+  int32_t off = *request->response->response_buffer->block_offset;
+
+  return off < 0 ? 0 : off;
+}
+
+uint16_t
+oc_get_block_size(oc_request_t *request)
+{
+  return request->response->response_buffer->buffer_size;
+}
+
+void
+oc_send_block(oc_request_t *request, oc_status_t response_code,
+              const uint8_t *data, uint16_t len, bool more)
+{
+  oc_response_buffer_t *rb = request->response->response_buffer;
+  uint32_t off = oc_get_block_offset(request);
+
+  if (len > rb->buffer_size) {
+    len = rb->buffer_size;
+    more = true;
+  }
+  if (data != rb->buffer) {
+    memmove(rb->buffer, data, len);
+  }
+  rb->response_length = len;
+  rb->code = oc_status_code(response_code);
+  *rb->block_offset = more ? (int32_t)(off + len) : -1;
+}
+
+bool
+oc_get_request_block(oc_request_t *request, uint32_t *offset, bool *more)
+{
+  uint8_t m;
+
+  if (!coap_get_header_block1(request->packet, NULL, &m, NULL, offset)) {
+    return false;
+  }
+  *more = m;
+  return true;
+}
+
 void
 oc_ignore_request(oc_request_t *request)
 {
@@ -86,7 +147,7 @@ oc_process_baseline_interface(oc_resource_t *resource)
 {
   oc_rep_set_string_array(root, rt, resource->types);
   oc_core_encode_interfaces_mask(oc_rep_object(root), resource->interfaces);
-  oc_rep_set_uint(root, p, resource->properties & ~OC_PERIODIC);
+  oc_rep_set_uint(root, p, resource->properties & ~OC_LOCAL_PROPERTIES);
 }
 
 #ifdef OC_SERVER
@@ -106,6 +167,8 @@ oc_new_resource(const char *uri, uint8_t num_resource_types, int device)
   resource->interfaces = OC_IF_BASELINE;
   resource->default_interface = OC_IF_BASELINE;
   resource->observe_period_seconds = 0;
+  resource->observe_pmin = MYNEWT_VAL(OC_OBSERVE_PMIN);
+  resource->observe_pmax = MYNEWT_VAL(OC_OBSERVE_PMAX);
   resource->properties = OC_ACTIVE;
   resource->num_observers = 0;
   resource->device = device;
@@ -158,6 +221,20 @@ oc_resource_set_periodic_observable(oc_resource_t *resource, uint16_t seconds)
   resource->observe_period_seconds = seconds;
 }
 
+void
+oc_resource_set_observe_interval(oc_resource_t *resource, uint16_t pmin,
+                                 uint16_t pmax)
+{
+  resource->observe_pmin = pmin;
+  resource->observe_pmax = pmax;
+}
+
+void
+oc_resource_set_raw_payload(oc_resource_t *resource)
+{
+  resource->properties |= OC_RAW_PAYLOAD;
+}
+
 void
 oc_deactivate_resource(oc_resource_t *resource)
 {
@@ -202,12 +279,25 @@ void
 oc_init_query_iterator(oc_request_t *request)
 {
   query_iterator = 0;
+  request->query_iter = 0;
 }
 
 int
 oc_interate_query(oc_request_t *request, char **key, int *key_len, char **value,
                   int *value_len)
 {
+  oc_query_param_t *qp;
+
+  if (request->query_params) {
+    if (request->query_iter >= request->num_query_params)
+      return -1;
+    qp = &request->query_params[request->query_iter++];
+    *key = (char *)qp->key;
+    *key_len = qp->key_len;
+    *value = (char *)qp->value;
+    *value_len = qp->value_len;
+    return 1;
+  }
   if (query_iterator >= request->query_len)
     return -1;
   query_iterator += oc_ri_get_query_nth_key_value(
@@ -258,8 +348,11 @@ oc_send_separate_response(oc_separate_response_t *handle,
           coap_set_payload(response, handle->buffer,
                            response_buffer.response_length);
         }
-        t->message->length = coap_serialize_message(response, t->message->data);
-        coap_send_transaction(t);
+        if (coap_serialize_message(response, t->message)) {
+          coap_send_transaction(t);
+        } else {
+          coap_clear_transaction(t);
+        }
       }
       coap_separate_clear(handle, cur);
     } else {
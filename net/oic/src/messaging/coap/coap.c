@@ -115,10 +115,11 @@ coap_set_option_header(unsigned int delta, size_t length, uint8_t *buffer)
   return ++written;
 }
 /*---------------------------------------------------------------------------*/
-static size_t
+static int
 coap_serialize_int_option(unsigned int number, unsigned int current_number,
-                          uint8_t *buffer, uint32_t value)
+                          struct os_mbuf *m, uint32_t value)
 {
+  uint8_t buffer[5 + 4];
   size_t i = 0;
 
   if (0xFF000000 & value) {
@@ -149,15 +150,16 @@ coap_serialize_int_option(unsigned int number, unsigned int current_number,
   if (0xFFFFFFFF & value) {
     buffer[i++] = (uint8_t)(value);
   }
-  return i;
+  return os_mbuf_append(m, buffer, i);
 }
 /*---------------------------------------------------------------------------*/
-static size_t
+static int
 coap_serialize_array_option(unsigned int number, unsigned int current_number,
-                            uint8_t *buffer, uint8_t *array, size_t length,
+                            struct os_mbuf *m, uint8_t *array, size_t length,
                             char split_char)
 {
-  size_t i = 0;
+  uint8_t buffer[5];
+  size_t i;
 
   LOG("ARRAY type %u, len %zu, full [%.*s]\n", number, length, (int)length,
       array);
@@ -174,13 +176,16 @@ coap_serialize_array_option(unsigned int number, unsigned int current_number,
         part_end = array + j;
         temp_length = part_end - part_start;
 
-        i += coap_set_option_header(number - current_number, temp_length,
-                                    &buffer[i]);
-        memcpy(&buffer[i], part_start, temp_length);
-        i += temp_length;
+        i = coap_set_option_header(number - current_number, temp_length,
+                                   buffer);
+        if (os_mbuf_append(m, buffer, i) ||
+            os_mbuf_append(m, part_start, temp_length)) {
+          return -1;
+        }
 
         LOG("OPTION type %u, delta %u, len %zu, part [%.*s]\n", number,
-            number - current_number, i, (int)temp_length, part_start);
+            number - current_number, temp_length, (int)temp_length,
+            part_start);
 
         ++j; /* skip the splitter */
         current_number = number;
@@ -188,15 +193,16 @@ coap_serialize_array_option(unsigned int number, unsigned int current_number,
       }
     } /* for */
   } else {
-    i += coap_set_option_header(number - current_number, length, &buffer[i]);
-    memcpy(&buffer[i], array, length);
-    i += length;
+    i = coap_set_option_header(number - current_number, length, buffer);
+    if (os_mbuf_append(m, buffer, i) || os_mbuf_append(m, array, length)) {
+      return -1;
+    }
 
     LOG("OPTION type %u, delta %u, len %zu\n", number, number - current_number,
         length);
   }
 
-  return i;
+  return 0;
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -287,52 +293,49 @@ coap_init_message(void *packet, coap_message_type_t type, uint8_t code,
 }
 /*---------------------------------------------------------------------------*/
 size_t
-coap_serialize_message(void *packet, uint8_t *buffer)
+coap_serialize_message(void *packet, struct os_mbuf *m)
 {
   coap_packet_t *const coap_pkt = (coap_packet_t *)packet;
-  uint8_t *option;
+  uint8_t hdr[COAP_HEADER_LEN];
   unsigned int current_number = 0;
 
   /* Initialize */
-  coap_pkt->buffer = buffer;
   coap_pkt->version = 1;
 
-  LOG("-Serializing MID %u to %p, ", coap_pkt->mid, coap_pkt->buffer);
+  LOG("-Serializing MID %u to %p, ", coap_pkt->mid, m);
 
   /* set header fields */
-  coap_pkt->buffer[0] = 0x00;
-  coap_pkt->buffer[0] |= COAP_HEADER_VERSION_MASK &
-                         (coap_pkt->version) << COAP_HEADER_VERSION_POSITION;
-  coap_pkt->buffer[0] |=
-    COAP_HEADER_TYPE_MASK & (coap_pkt->type) << COAP_HEADER_TYPE_POSITION;
-  coap_pkt->buffer[0] |= COAP_HEADER_TOKEN_LEN_MASK &
-                         (coap_pkt->token_len)
-                           << COAP_HEADER_TOKEN_LEN_POSITION;
-  coap_pkt->buffer[1] = coap_pkt->code;
-  coap_pkt->buffer[2] = (uint8_t)((coap_pkt->mid) >> 8);
-  coap_pkt->buffer[3] = (uint8_t)(coap_pkt->mid);
+  hdr[0] = 0x00;
+  hdr[0] |= COAP_HEADER_VERSION_MASK &
+            (coap_pkt->version) << COAP_HEADER_VERSION_POSITION;
+  hdr[0] |= COAP_HEADER_TYPE_MASK & (coap_pkt->type) << COAP_HEADER_TYPE_POSITION;
+  hdr[0] |= COAP_HEADER_TOKEN_LEN_MASK &
+            (coap_pkt->token_len) << COAP_HEADER_TOKEN_LEN_POSITION;
+  hdr[1] = coap_pkt->code;
+  hdr[2] = (uint8_t)((coap_pkt->mid) >> 8);
+  hdr[3] = (uint8_t)(coap_pkt->mid);
+
+  if (os_mbuf_append(m, hdr, sizeof(hdr))) {
+    goto err_mem;
+  }
 
   /* empty packet, dont need to do more stuff */
   if (!coap_pkt->code) {
-    LOG("-Done serializing empty message at %p-\n", coap_pkt->buffer);
-    return 4;
+    LOG("-Done serializing empty message at %p-\n", m);
+    return OS_MBUF_PKTLEN(m);
   }
 
   /* set Token */
   LOG("Token (len %u)", coap_pkt->token_len);
-  option = coap_pkt->buffer + COAP_HEADER_LEN;
-  for (current_number = 0; current_number < coap_pkt->token_len;
-       ++current_number) {
-    LOG(" %02X", coap_pkt->token[current_number]);
-    *option = coap_pkt->token[current_number];
-    ++option;
+  if (os_mbuf_append(m, coap_pkt->token, coap_pkt->token_len)) {
+    goto err_mem;
   }
   LOG("-\n");
 
   /* Serialize options */
   current_number = 0;
 
-  LOG("-Serializing options at %p-\n", option);
+  LOG("-Serializing options at %u-\n", OS_MBUF_PKTLEN(m));
 #if 0
   /* The options must be serialized in the order of their number */
   COAP_SERIALIZE_BYTE_OPTION(COAP_OPTION_IF_MATCH, if_match, "If-Match");
@@ -374,48 +377,115 @@ coap_serialize_message(void *packet, uint8_t *buffer)
 #endif
   COAP_SERIALIZE_INT_OPTION(COAP_OPTION_SIZE1, size1, "Size1");
 
-  LOG("-Done serializing at %p----\n", option);
+  LOG("-Done serializing at %u----\n", OS_MBUF_PKTLEN(m));
 
   /* Pack payload */
-  if ((option - coap_pkt->buffer) <= COAP_MAX_HEADER_SIZE) {
+  if (coap_pkt->payload_len) {
     /* Payload marker */
-    if (coap_pkt->payload_len) {
-      *option = 0xFF;
-      ++option;
+    hdr[0] = 0xFF;
+    if (os_mbuf_append(m, hdr, 1) ||
+        os_mbuf_append(m, coap_pkt->payload, coap_pkt->payload_len)) {
+      goto err_mem;
     }
-    memmove(option, coap_pkt->payload, coap_pkt->payload_len);
-  } else {
-    /* an error occurred: caller must check for !=0 */
-    coap_pkt->buffer = NULL;
-    coap_error_message = "Serialized header exceeds COAP_MAX_HEADER_SIZE";
-    return 0;
   }
 
   LOG("-Done %u B (header len %u, payload len %u)-\n",
-      (unsigned int)(coap_pkt->payload_len + option - buffer),
-      (unsigned int)(option - buffer), (unsigned int)coap_pkt->payload_len);
-
-  LOG("Dump [0x%02X %02X %02X %02X  %02X %02X %02X %02X]\n",
-      coap_pkt->buffer[0], coap_pkt->buffer[1], coap_pkt->buffer[2],
-      coap_pkt->buffer[3], coap_pkt->buffer[4], coap_pkt->buffer[5],
-      coap_pkt->buffer[6], coap_pkt->buffer[7]);
-  return (option - buffer) + coap_pkt->payload_len; /* packet length */
+      OS_MBUF_PKTLEN(m), OS_MBUF_PKTLEN(m) - coap_pkt->payload_len,
+      (unsigned int)coap_pkt->payload_len);
+
+  return OS_MBUF_PKTLEN(m); /* packet length */
+
+err_mem:
+  /* an error occurred: caller must check for !=0 */
+  coap_error_message = "No mbufs to serialize message";
+  return 0;
 }
 /*---------------------------------------------------------------------------*/
 void
-coap_send_message(oc_message_t *message)
+coap_send_message(struct os_mbuf *m)
 {
-  LOG("-sending OCF message (%u)-\n", (unsigned int) message->length);
+  LOG("-sending OCF message (%u)-\n", OS_MBUF_PKTLEN(m));
 
-  oc_send_message(message);
+  oc_send_message(m);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * Returns the length of the CoAP header, token and options at the start
+ * of the chain, including the payload marker, or -1 if they run past the
+ * end of the packet.
+ */
+static int
+coap_header_len(struct os_mbuf *m)
+{
+  uint16_t pkt_len = OS_MBUF_PKTLEN(m);
+  uint32_t off;
+  uint16_t option_length;
+  uint8_t b[2];
+
+  if (pkt_len < COAP_HEADER_LEN || os_mbuf_copydata(m, 0, 1, b)) {
+    return -1;
+  }
+  off = COAP_HEADER_LEN +
+    ((COAP_HEADER_TOKEN_LEN_MASK & b[0]) >> COAP_HEADER_TOKEN_LEN_POSITION);
+
+  while (off < pkt_len) {
+    os_mbuf_copydata(m, off++, 1, b);
+    if ((b[0] & 0xF0) == 0xF0) {
+      break;
+    }
+    option_length = b[0] & 0x0F;
+
+    if ((b[0] >> 4) == 13) {
+      off += 1;
+    } else if ((b[0] >> 4) == 14) {
+      off += 2;
+    }
+    if (option_length == 13) {
+      if (os_mbuf_copydata(m, off, 1, b)) {
+        return -1;
+      }
+      option_length += b[0];
+      off += 1;
+    } else if (option_length == 14) {
+      if (os_mbuf_copydata(m, off, 2, b)) {
+        return -1;
+      }
+      option_length += 255 + (b[0] << 8) + b[1];
+      off += 2;
+    }
+    off += option_length;
+  }
+  if (off > pkt_len) {
+    return -1;
+  }
+  return off;
 }
 /*---------------------------------------------------------------------------*/
 coap_status_t
-coap_parse_message(void *packet, uint8_t *data, uint16_t data_len)
+coap_parse_message(void *packet, struct os_mbuf **mp)
 {
   coap_packet_t *const coap_pkt = (coap_packet_t *)packet;
+  struct os_mbuf *m;
+  uint8_t *data;
+  int data_len;
+
   /* initialize packet */
   memset(coap_pkt, 0, sizeof(coap_packet_t));
+
+  /* make header, token and options contiguous; payload stays in the chain */
+  data_len = coap_header_len(*mp);
+  if (data_len < 0) {
+    coap_error_message = "Truncated message";
+    return BAD_REQUEST_4_00;
+  }
+  m = os_mbuf_pullup(*mp, data_len);
+  *mp = m;
+  if (!m) {
+    coap_error_message = "No mbufs to parse message";
+    return SERVICE_UNAVAILABLE_5_03;
+  }
+  data = m->om_data;
+
   /* pointer to packet bytes */
   coap_pkt->buffer = data;
   /* parse header fields */
@@ -459,15 +529,14 @@ coap_parse_message(void *packet, uint8_t *data, uint16_t data_len)
     /* payload marker 0xFF, currently only checking for 0xF* because rest is
      * reserved */
     if ((current_option[0] & 0xF0) == 0xF0) {
-      coap_pkt->payload = ++current_option;
-      coap_pkt->payload_len = data_len - (coap_pkt->payload - data);
+      coap_pkt->payload_m = m;
+      coap_pkt->payload_off = ++current_option - data;
+      coap_pkt->payload_len = OS_MBUF_PKTLEN(m) - coap_pkt->payload_off;
 
       /* also for receiving, the Erbium upper bound is MAX_PAYLOAD_SIZE */
       if (coap_pkt->payload_len > MAX_PAYLOAD_SIZE) {
         coap_pkt->payload_len = MAX_PAYLOAD_SIZE;
-        /* null-terminate payload */
       }
-      coap_pkt->payload[coap_pkt->payload_len] = '\0';
 
       break;
     }
@@ -1161,15 +1230,17 @@ int coap_set_header_size1(void *packet, uint32_t size)
 #endif
 /*---------------------------------------------------------------------------*/
 int
-coap_get_payload(void *packet, const uint8_t **payload)
+coap_get_payload(void *packet, struct os_mbuf **m, uint16_t *off)
 {
   coap_packet_t *const coap_pkt = (coap_packet_t *)packet;
 
-  if (coap_pkt->payload) {
-    *payload = coap_pkt->payload;
+  if (coap_pkt->payload_m) {
+    *m = coap_pkt->payload_m;
+    *off = coap_pkt->payload_off;
     return coap_pkt->payload_len;
   } else {
-    *payload = NULL;
+    *m = NULL;
+    *off = 0;
     return 0;
   }
 }
@@ -38,6 +38,7 @@
 #include "constants.h"
 #include <stddef.h> /* for size_t */
 #include <stdint.h>
+#include <os/os_mbuf.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -97,8 +98,7 @@ enum
 /* parsed message struct */
 typedef struct
 {
-  uint8_t *buffer; /* pointer to CoAP header / incoming packet buffer / memory
-                      to serialize packet */
+  uint8_t *buffer; /* pointer to CoAP header of incoming packet */
 
   uint8_t version;
   coap_message_type_t type;
@@ -148,15 +148,19 @@ typedef struct
   uint8_t if_none_match;
 
   uint16_t payload_len;
-  uint8_t *payload;
+  uint8_t *payload; /* outgoing payload, set by coap_set_payload() */
+  struct os_mbuf *payload_m; /* incoming payload stays in the rx chain */
+  uint16_t payload_off;
 } coap_packet_t;
 
 /* option format serialization */
 #define COAP_SERIALIZE_INT_OPTION(number, field, text)                         \
   if (IS_OPTION(coap_pkt, number)) {                                           \
     LOG(text " [%u]\n", (unsigned int)coap_pkt->field);                        \
-    option += coap_serialize_int_option(number, current_number, option,        \
-                                        coap_pkt->field);                      \
+    if (coap_serialize_int_option(number, current_number, m,                   \
+                                  coap_pkt->field)) {                          \
+      goto err_mem;                                                            \
+    }                                                                          \
     current_number = number;                                                   \
   }
 #define COAP_SERIALIZE_BYTE_OPTION(number, field, text)                        \
@@ -166,17 +170,21 @@ typedef struct
         coap_pkt->field[1], coap_pkt->field[2], coap_pkt->field[3],            \
         coap_pkt->field[4], coap_pkt->field[5], coap_pkt->field[6],            \
         coap_pkt->field[7]); /* FIXME always prints 8 bytes */                 \
-    option += coap_serialize_array_option(number, current_number, option,      \
-                                          coap_pkt->field,                     \
-                                          coap_pkt->field##_len, '\0');        \
+    if (coap_serialize_array_option(number, current_number, m,                 \
+                                    coap_pkt->field, coap_pkt->field##_len,    \
+                                    '\0')) {                                   \
+      goto err_mem;                                                            \
+    }                                                                          \
     current_number = number;                                                   \
   }
 #define COAP_SERIALIZE_STRING_OPTION(number, field, splitter, text)            \
   if (IS_OPTION(coap_pkt, number)) {                                           \
     LOG(text " [%.*s]\n", (int)coap_pkt->field##_len, coap_pkt->field);        \
-    option += coap_serialize_array_option(number, current_number, option,      \
-                                          (uint8_t *)coap_pkt->field,          \
-                                          coap_pkt->field##_len, splitter);    \
+    if (coap_serialize_array_option(number, current_number, m,                 \
+                                    (uint8_t *)coap_pkt->field,                \
+                                    coap_pkt->field##_len, splitter)) {        \
+      goto err_mem;                                                            \
+    }                                                                          \
     current_number = number;                                                   \
   }
 #define COAP_SERIALIZE_BLOCK_OPTION(number, field, text)                       \
@@ -189,8 +197,9 @@ typedef struct
     }                                                                          \
     block |= 0xF & coap_log_2(coap_pkt->field##_size / 16);                    \
     LOG(text " encoded: 0x%lX\n", (unsigned long)block);                       \
-    option +=                                                                  \
-      coap_serialize_int_option(number, current_number, option, block);        \
+    if (coap_serialize_int_option(number, current_number, m, block)) {         \
+      goto err_mem;                                                            \
+    }                                                                          \
     current_number = number;                                                   \
   }
 
@@ -203,10 +212,9 @@ uint16_t coap_get_mid(void);
 
 void coap_init_message(void *packet, coap_message_type_t type, uint8_t code,
                        uint16_t mid);
-size_t coap_serialize_message(void *packet, uint8_t *buffer);
-void coap_send_message(oc_message_t *message);
-coap_status_t coap_parse_message(void *request, uint8_t *data,
-                                 uint16_t data_len);
+size_t coap_serialize_message(void *packet, struct os_mbuf *m);
+void coap_send_message(struct os_mbuf *m);
+coap_status_t coap_parse_message(void *request, struct os_mbuf **mp);
 
 int coap_get_query_variable(void *packet, const char *name,
                             const char **output);
@@ -295,7 +303,7 @@ int coap_set_header_size2(void *packet, uint32_t size);
 int coap_get_header_size1(void *packet, uint32_t *size);
 int coap_set_header_size1(void *packet, uint32_t size);
 
-int coap_get_payload(void *packet, const uint8_t **payload);
+int coap_get_payload(void *packet, struct os_mbuf **m, uint16_t *off);
 int coap_set_payload(void *packet, const void *payload, size_t length);
 
 #ifdef __cplusplus
@@ -72,6 +72,9 @@ extern "C" {
  * check client. */
 #define COAP_OBSERVE_REFRESH_INTERVAL 20
 
+/* How soon to retry a coalesced notification while a CON one is unacked. */
+#define COAP_OBSERVE_BUSY_RETRY_TICKS (OS_TICKS_PER_SEC / 4)
+
 #ifdef __cplusplus
 }
 #endif
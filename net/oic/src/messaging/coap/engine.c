@@ -53,12 +53,32 @@ extern bool oc_ri_invoke_coap_entity_handler(void *request, void *response,
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+/* response payloads are built here, and copied to mbufs when serialized */
+static uint8_t coap_rsp_buf[COAP_MAX_BLOCK_SIZE];
+
+static void
+coap_send_empty(coap_packet_t *pkt, oc_endpoint_t *oe)
+{
+  struct os_mbuf *m;
+
+  m = oc_allocate_mbuf(oe);
+  if (m) {
+    if (coap_serialize_message(pkt, m)) {
+      coap_send_message(m);
+    } else {
+      os_mbuf_free_chain(m);
+    }
+  }
+}
+
 int
-coap_receive(oc_message_t *msg)
+coap_receive(struct os_mbuf **mp)
 {
+  oc_endpoint_t *oe;
+
   erbium_status_code = NO_ERROR;
 
-  LOG("\n\nCoAP Engine: received datalen=%u \n", (unsigned int) msg->length);
+  LOG("\n\nCoAP Engine: received datalen=%u \n", OS_MBUF_PKTLEN(*mp));
 
   /* static declaration reduces stack peaks and program code size */
   static coap_packet_t
@@ -66,7 +86,11 @@ coap_receive(oc_message_t *msg)
   static coap_packet_t response[1];
   static coap_transaction_t *transaction = NULL;
 
-  erbium_status_code = coap_parse_message(message, msg->data, msg->length);
+  erbium_status_code = coap_parse_message(message, mp);
+  if (*mp == NULL) {
+    return erbium_status_code;
+  }
+  oe = OC_MBUF_ENDPOINT(*mp);
 
   if (erbium_status_code == NO_ERROR) {
 
@@ -112,10 +136,10 @@ coap_receive(oc_message_t *msg)
         break;
       }
       LOG("  URL: %.*s\n", (int) message->uri_path_len, message->uri_path);
-      LOG("  Payload: %.*s\n", (int) message->payload_len, message->payload);
+      LOG("  Payload: %u bytes\n", message->payload_len);
 #endif
       /* use transaction buffer for response to confirmable request */
-      if ((transaction = coap_new_transaction(message->mid, &msg->endpoint))) {
+      if ((transaction = coap_new_transaction(message->mid, oe))) {
         uint32_t block_num = 0;
         uint16_t block_size = COAP_MAX_BLOCK_SIZE;
         uint32_t block_offset = 0;
@@ -146,9 +170,8 @@ coap_receive(oc_message_t *msg)
 
         /* invoke resource handler in RI layer */
         if (oc_ri_invoke_coap_entity_handler(
-              message, response,
-              transaction->message->data + COAP_MAX_HEADER_SIZE, block_size,
-              &new_offset, &msg->endpoint)) {
+              message, response, coap_rsp_buf, block_size, &new_offset,
+              oe)) {
 
           if (erbium_status_code == NO_ERROR) {
 
@@ -219,8 +242,7 @@ coap_receive(oc_message_t *msg)
           /* serialize response */
         }
         if (erbium_status_code == NO_ERROR) {
-          if ((transaction->message->length = coap_serialize_message(
-                 response, transaction->message->data)) == 0) {
+          if (coap_serialize_message(response, transaction->message) == 0) {
             erbium_status_code = PACKET_SERIALIZATION_ERROR;
           }
         }
@@ -238,12 +260,15 @@ coap_receive(oc_message_t *msg)
       } else if (message->type == COAP_TYPE_RST) {
 #ifdef OC_SERVER
         /* cancel possible subscriptions */
-        coap_remove_observer_by_mid(&msg->endpoint, message->mid);
+        coap_remove_observer_by_mid(oe, message->mid);
 #endif
       }
 
       /* Open transaction now cleared for ACK since mid matches */
       if ((transaction = coap_get_transaction_by_mid(message->mid))) {
+        if (message->type == COAP_TYPE_ACK) {
+          coap_transaction_acked(transaction);
+        }
         coap_clear_transaction(transaction);
       }
       /* if(ACKed transaction) */
@@ -251,7 +276,7 @@ coap_receive(oc_message_t *msg)
 
 #ifdef OC_CLIENT // ACKs and RSTs sent to oc_ri.. RSTs cleared, ACKs sent to
                  // client
-      oc_ri_invoke_client_cb(message, &msg->endpoint);
+      oc_ri_invoke_client_cb(message, oe);
 #endif
 
     } /* request or response */
@@ -269,12 +294,7 @@ coap_receive(oc_message_t *msg)
 #ifdef OC_CLIENT
   else if (erbium_status_code == EMPTY_ACK_RESPONSE) {
     coap_init_message(message, COAP_TYPE_ACK, 0, message->mid);
-    oc_message_t *response = oc_allocate_message();
-    if (response) {
-      memcpy(&response->endpoint, &msg->endpoint, sizeof(msg->endpoint));
-      response->length = coap_serialize_message(message, response->data);
-      coap_send_message(response);
-    }
+    coap_send_empty(message, oe);
   }
 #endif /* OC_CLIENT */
 #ifdef OC_SERVER
@@ -285,13 +305,7 @@ coap_receive(oc_message_t *msg)
 
     coap_init_message(message, reply_type, SERVICE_UNAVAILABLE_5_03,
                       message->mid);
-
-    oc_message_t *response = oc_allocate_message();
-    if (response) {
-      memcpy(&response->endpoint, &msg->endpoint, sizeof(msg->endpoint));
-      response->length = coap_serialize_message(message, response->data);
-      coap_send_message(response);
-    }
+    coap_send_empty(message, oe);
   }
 #endif /* OC_SERVER */
 
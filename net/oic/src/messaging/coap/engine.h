@@ -44,7 +44,7 @@ extern "C" {
 #endif
 
 void coap_engine_init(void);
-int coap_receive(oc_message_t *message);
+int coap_receive(struct os_mbuf **mp);
 
 #ifdef __cplusplus
 }
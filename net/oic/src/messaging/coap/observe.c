@@ -39,12 +39,15 @@
 #include <string.h>
 
 #include <os/os_mempool.h>
+#include <os/os_callout.h>
+#include <os/os_time.h>
 
 #include "observe.h"
 
 #include "oc_coap.h"
 #include "oc_rep.h"
 #include "oc_ri.h"
+#include "port/mynewt/adaptor.h"
 /*-------------------*/
 uint64_t observe_counter = 3;
 /*---------------------------------------------------------------------------*/
@@ -54,6 +57,9 @@ static struct os_mempool coap_observers;
 static uint8_t coap_observer_area[OS_MEMPOOL_BYTES(COAP_MAX_OBSERVERS,
       sizeof(coap_observer_t))];
 
+/* Sends coalesced and pmax notifications once they become due. */
+static struct os_callout coap_observe_timer;
+
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
@@ -79,6 +85,8 @@ add_observer(oc_resource_t *resource, oc_endpoint_t *endpoint,
         memcpy(o->token, token, token_len);
         o->last_mid = 0;
         o->obs_counter = observe_counter;
+        o->last_notify = os_time_get();
+        o->pending = 0;
         o->resource = resource;
         resource->num_observers++;
         LOG("Adding observer (%u/%u) for /%s [0x%02X%02X]\n",
@@ -192,27 +200,132 @@ coap_remove_observer_by_mid(oc_endpoint_t *endpoint, uint16_t mid)
 /*---------------------------------------------------------------------------*/
 /*- Notification ------------------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
+/*
+ * A CON notification is in flight until it is ACKed; until then, and until
+ * pmin has passed since the last one, further changes are only flagged as
+ * pending.  Only the latest state matters, so a pending observer gets a
+ * fresh GET when it becomes due, not a queue of old representations.
+ */
+static int
+coap_observer_busy(coap_observer_t *obs)
+{
+    return obs->last_mid && coap_get_transaction_by_mid(obs->last_mid);
+}
+
+static os_time_t
+coap_observer_due(coap_observer_t *obs)
+{
+    uint16_t secs;
+
+    secs = obs->pending ? obs->resource->observe_pmin :
+      obs->resource->observe_pmax;
+    return obs->last_notify + secs * OS_TICKS_PER_SEC;
+}
+
+static int
+coap_observer_ready(coap_observer_t *obs, os_time_t now)
+{
+    return !coap_observer_busy(obs) &&
+      OS_TIME_TICK_GEQ(now, obs->last_notify +
+        obs->resource->observe_pmin * OS_TICKS_PER_SEC);
+}
+
+static void
+coap_observe_schedule(os_time_t now)
+{
+    coap_observer_t *obs;
+    os_time_t due = 0, t;
+    int armed = 0;
+
+    for (obs = (coap_observer_t *)oc_list_head(observers_list); obs;
+         obs = obs->next) {
+        if (!obs->pending && !obs->resource->observe_pmax) {
+            continue;
+        }
+        t = coap_observer_due(obs);
+        if (coap_observer_busy(obs) && OS_TIME_TICK_LT(t, now +
+            COAP_OBSERVE_BUSY_RETRY_TICKS)) {
+            t = now + COAP_OBSERVE_BUSY_RETRY_TICKS;
+        }
+        if (!armed || OS_TIME_TICK_LT(t, due)) {
+            due = t;
+            armed = 1;
+        }
+    }
+    if (!armed) {
+        os_callout_stop(&coap_observe_timer);
+    } else {
+        os_callout_reset(&coap_observe_timer,
+          OS_TIME_TICK_GT(due, now) ? due - now : 0);
+    }
+}
+
+static void
+coap_observe_timer_cb(struct os_event *ev)
+{
+    coap_observer_t *obs;
+    os_time_t now = os_time_get();
+
+    for (obs = (coap_observer_t *)oc_list_head(observers_list); obs;
+         obs = obs->next) {
+        if (coap_observer_busy(obs) ||
+          !OS_TIME_TICK_GEQ(now, coap_observer_due(obs))) {
+            continue;
+        }
+        if (obs->pending || obs->resource->observe_pmax) {
+            /* one GET serves every due observer of this resource */
+            obs->pending = 1;
+            coap_notify_observers(obs->resource, NULL, NULL);
+        }
+    }
+    coap_observe_schedule(now);
+}
+
 int
 coap_notify_observers(oc_resource_t *resource,
                       oc_response_buffer_t *response_buf,
                       oc_endpoint_t *endpoint)
 {
     int num_observers = 0;
+    int ready = 0;
+    os_time_t now = os_time_get();
+    coap_observer_t *obs = NULL;
+
     if (resource) {
         if (!resource->num_observers) {
             LOG("coap_notify_observers: no observers; returning\n");
             return 0;
         }
         num_observers = resource->num_observers;
+
+        /* Hold back observers that are rate limited or still have a
+         * notification in flight. */
+        for (obs = (coap_observer_t *)oc_list_head(observers_list); obs;
+             obs = obs->next) {
+            if (obs->resource != resource) {
+                continue;
+            }
+            if (coap_observer_ready(obs, now)) {
+                ready++;
+            } else {
+                obs->pending = 1;
+            }
+        }
+        if (!ready) {
+            LOG("coap_notify_observers: coalescing notification\n");
+            coap_observe_schedule(now);
+            return num_observers;
+        }
     }
     uint8_t buffer[COAP_MAX_BLOCK_SIZE];
     oc_request_t request = {};
     oc_response_t response = {};
     response.separate_response = 0;
     oc_response_buffer_t response_buffer;
-    if (!response_buf && resource && (resource->properties & OC_PERIODIC)) {
+    if (!response_buf && resource && resource->get_handler) {
         LOG("coap_notify_observers: Issue GET request to resource\n");
-        /* performing GET on the resource */
+        /* performing GET on the resource; the representation is shared by
+         * all the observers notified below */
         response_buffer.buffer = buffer;
         response_buffer.buffer_size = COAP_MAX_BLOCK_SIZE;
         response_buffer.block_offset = NULL;
@@ -229,13 +342,17 @@ coap_notify_observers(oc_resource_t *resource,
         }
     }
 
-    coap_observer_t *obs = NULL;
     /* iterate over observers */
-    for (obs = (coap_observer_t *)oc_list_head(observers_list);
-         obs && ((resource && obs->resource == resource) ||
-           (endpoint &&
-             memcmp(&obs->endpoint, endpoint, sizeof(oc_endpoint_t)) == 0));
+    for (obs = (coap_observer_t *)oc_list_head(observers_list); obs;
          obs = obs->next) {
+        if (!((resource && obs->resource == resource) ||
+            (endpoint &&
+              memcmp(&obs->endpoint, endpoint, sizeof(oc_endpoint_t)) == 0))) {
+            continue;
+        }
+        if (resource && !coap_observer_ready(obs, now)) {
+            continue;
+        }
         num_observers = obs->resource->num_observers;
         if (response.separate_response != NULL &&
           response_buf->code == oc_status_code(OC_STATUS_OK)) {
@@ -259,11 +376,10 @@ coap_notify_observers(oc_resource_t *resource,
             coap_transaction_t *transaction = NULL;
             if (response_buf && (transaction = coap_new_transaction(
                   coap_get_mid(), &obs->endpoint))) {
-                memcpy(transaction->message->data + COAP_MAX_HEADER_SIZE,
-                  response_buf->buffer, response_buf->response_length);
-
                 /* update last MID for RST matching */
                 obs->last_mid = transaction->mid;
+                obs->last_notify = now;
+                obs->pending = 0;
 
                 /* prepare response */
                 /* build notification */
@@ -289,14 +405,21 @@ coap_notify_observers(oc_resource_t *resource,
                 }
                 coap_set_token(notification, obs->token, obs->token_len);
 
-                transaction->message->length =
-                  coap_serialize_message(notification,
-                    transaction->message->data);
-
-                coap_send_transaction(transaction);
+                if (coap_serialize_message(notification,
+                    transaction->message)) {
+                    coap_send_transaction(transaction);
+                } else {
+                    coap_clear_transaction(transaction);
+                }
+            } else if (resource) {
+                /* out of transactions; try again when due */
+                obs->pending = 1;
             }
         }
     }
+    if (resource) {
+        coap_observe_schedule(now);
+    }
     return num_observers;
 }
 /*---------------------------------------------------------------------------*/
@@ -331,5 +454,7 @@ coap_observe_init(void)
 {
     os_mempool_init(&coap_observers, COAP_MAX_OBSERVERS,
       sizeof(coap_observer_t), coap_observer_area, "coap_obs");
+    os_callout_init(&coap_observe_timer, oc_evq_get(), coap_observe_timer_cb,
+      NULL);
 }
 #endif /* OC_SERVER */
@@ -60,8 +60,10 @@ typedef struct coap_observer
   uint16_t last_mid;
 
   int32_t obs_counter;
+  os_time_t last_notify;
 
   uint8_t retrans_counter;
+  uint8_t pending;      /* a change is waiting for pmin or an ACK */
 } coap_observer_t;
 
 oc_list_t coap_get_observers(void);
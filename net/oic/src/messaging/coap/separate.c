@@ -100,13 +100,13 @@ coap_separate_accept(void *request, oc_separate_response_t *separate_response,
             coap_set_header_observe(ack, observe);
         }
         coap_set_token(ack, coap_req->token, coap_req->token_len);
-        oc_message_t *message = oc_allocate_message();
-        if (message != NULL) {
-            message->endpoint.flags = IP;
-            memcpy(&message->endpoint, endpoint, sizeof(oc_endpoint_t));
-            message->length = coap_serialize_message(ack, message->data);
-            coap_send_message(message);
+        struct os_mbuf *m = oc_allocate_mbuf(endpoint);
+        if (m != NULL && coap_serialize_message(ack, m)) {
+            coap_send_message(m);
         } else {
+            if (m) {
+                os_mbuf_free_chain(m);
+            }
             coap_separate_clear(separate_response, separate_store);
             erbium_status_code = SERVICE_UNAVAILABLE_5_03;
             return 0;
@@ -35,6 +35,8 @@
 
 #include <os/os_callout.h>
 #include <os/os_mempool.h>
+#include <os/os_time.h>
+#include <stats/stats.h>
 
 #include "transactions.h"
 #include "observe.h"
@@ -57,13 +59,140 @@ static uint8_t oc_transaction_area[OS_MEMPOOL_BYTES(COAP_MAX_OPEN_TRANSACTIONS,
 
 OC_LIST(transactions_list);
 
+/*
+ * Confirmable transactions waiting to be retransmitted, kept in a min-heap
+ * on their due time.  A single callout is armed for the earliest one, so
+ * timer cost does not grow with the number of open transactions.
+ */
+static coap_transaction_t *retrans_heap[COAP_MAX_OPEN_TRANSACTIONS];
+static int retrans_heap_cnt;
+static struct os_callout retrans_timer;
+
+STATS_SECT_START(coap_trans_stats)
+    STATS_SECT_ENTRY(con_tx)
+    STATS_SECT_ENTRY(retrans)
+    STATS_SECT_ENTRY(timeout)
+    STATS_SECT_ENTRY(acked)
+    STATS_SECT_ENTRY(ack_lat_ms)
+    STATS_SECT_ENTRY(ack_lat_max_ms)
+STATS_SECT_END
+
+static STATS_SECT_DECL(coap_trans_stats) coap_trans_stats;
+
+STATS_NAME_START(coap_trans_stats)
+    STATS_NAME(coap_trans_stats, con_tx)
+    STATS_NAME(coap_trans_stats, retrans)
+    STATS_NAME(coap_trans_stats, timeout)
+    STATS_NAME(coap_trans_stats, acked)
+    STATS_NAME(coap_trans_stats, ack_lat_ms)
+    STATS_NAME(coap_trans_stats, ack_lat_max_ms)
+STATS_NAME_END(coap_trans_stats)
+
 static void coap_transaction_retrans(struct os_event *ev);
 
+static void
+retrans_heap_set(int i, coap_transaction_t *t)
+{
+    retrans_heap[i] = t;
+    t->heap_idx = i;
+}
+
+static void
+retrans_heap_up(int i)
+{
+    coap_transaction_t *t = retrans_heap[i];
+    int parent;
+
+    while (i > 0) {
+        parent = (i - 1) / 2;
+        if (!OS_TIME_TICK_LT(t->retrans_due,
+            retrans_heap[parent]->retrans_due)) {
+            break;
+        }
+        retrans_heap_set(i, retrans_heap[parent]);
+        i = parent;
+    }
+    retrans_heap_set(i, t);
+}
+
+static void
+retrans_heap_down(int i)
+{
+    coap_transaction_t *t = retrans_heap[i];
+    int child;
+
+    while ((child = 2 * i + 1) < retrans_heap_cnt) {
+        if (child + 1 < retrans_heap_cnt &&
+          OS_TIME_TICK_LT(retrans_heap[child + 1]->retrans_due,
+            retrans_heap[child]->retrans_due)) {
+            child++;
+        }
+        if (!OS_TIME_TICK_LT(retrans_heap[child]->retrans_due,
+            t->retrans_due)) {
+            break;
+        }
+        retrans_heap_set(i, retrans_heap[child]);
+        i = child;
+    }
+    retrans_heap_set(i, t);
+}
+
+static void
+retrans_timer_arm(void)
+{
+    int32_t delta;
+
+    if (!retrans_heap_cnt) {
+        os_callout_stop(&retrans_timer);
+        return;
+    }
+    delta = (int32_t)(retrans_heap[0]->retrans_due - os_time_get());
+    os_callout_reset(&retrans_timer, delta > 0 ? delta : 0);
+}
+
+static void
+retrans_heap_remove(coap_transaction_t *t)
+{
+    int i = t->heap_idx;
+
+    if (i < 0) {
+        return;
+    }
+    t->heap_idx = -1;
+    if (--retrans_heap_cnt != i) {
+        coap_transaction_t *last = retrans_heap[retrans_heap_cnt];
+
+        retrans_heap_set(i, last);
+        retrans_heap_up(i);
+        retrans_heap_down(last->heap_idx);
+    }
+    if (i == 0) {
+        retrans_timer_arm();
+    }
+}
+
+static void
+retrans_heap_insert(coap_transaction_t *t)
+{
+    retrans_heap_remove(t);
+    retrans_heap_set(retrans_heap_cnt++, t);
+    retrans_heap_up(t->heap_idx);
+    if (t->heap_idx == 0) {
+        retrans_timer_arm();
+    }
+}
+
 void
 coap_transaction_init(void)
 {
     os_mempool_init(&oc_transaction_memb, COAP_MAX_OPEN_TRANSACTIONS,
       sizeof(coap_transaction_t), oc_transaction_area, "coap_tran");
+    retrans_heap_cnt = 0;
+    os_callout_init(&retrans_timer, oc_evq_get(), coap_transaction_retrans,
+      NULL);
+    stats_init_and_reg(STATS_HDR(coap_trans_stats),
+      STATS_SIZE_INIT_PARMS(coap_trans_stats, STATS_SIZE_32),
+      STATS_NAME_INIT_PARMS(coap_trans_stats), "coap_trans");
 }
 
 coap_transaction_t *
@@ -73,19 +202,16 @@ coap_new_transaction(uint16_t mid, oc_endpoint_t *endpoint)
 
     t = os_memblock_get(&oc_transaction_memb);
     if (t) {
-        oc_message_t *message = oc_allocate_message();
-        if (message) {
-            LOG("Created new transaction %d %d\n", mid, (int) message->length);
+        /* save client address with the message */
+        struct os_mbuf *m = oc_allocate_mbuf(endpoint);
+        if (m) {
+            LOG("Created new transaction %d\n", mid);
             t->mid = mid;
             t->retrans_counter = 0;
+            t->heap_idx = -1;
 
-            t->message = message;
+            t->message = m;
 
-            /* save client address */
-            memcpy(&t->message->endpoint, endpoint, sizeof(oc_endpoint_t));
-
-            os_callout_init(&t->retrans_timer, oc_evq_get(),
-              coap_transaction_retrans, t);
             /* list itself makes sure same element is not added twice */
             oc_list_add(transactions_list, t);
         } else {
@@ -103,9 +229,12 @@ coap_send_transaction(coap_transaction_t *t)
 {
   LOG("Sending transaction %u\n", t->mid);
   bool confirmable = false;
+  struct os_mbuf *m;
+  uint8_t hdr;
 
   confirmable =
-    (COAP_TYPE_CON == ((COAP_HEADER_TYPE_MASK & t->message->data[0]) >>
+    (os_mbuf_copydata(t->message, 0, sizeof(hdr), &hdr) == 0 &&
+     COAP_TYPE_CON == ((COAP_HEADER_TYPE_MASK & hdr) >>
                        COAP_HEADER_TYPE_POSITION))
       ? true
       : false;
@@ -116,6 +245,8 @@ coap_send_transaction(coap_transaction_t *t)
       LOG("Keeping transaction %u\n", t->mid);
 
       if (t->retrans_counter == 0) {
+        t->first_tx = os_time_get();
+        STATS_INC(coap_trans_stats, con_tx);
         t->retrans_tmo =
           COAP_RESPONSE_TIMEOUT_TICKS +
           (oc_random_rand() %
@@ -124,28 +255,33 @@ coap_send_transaction(coap_transaction_t *t)
       } else {
         t->retrans_tmo <<= 1; /* double */
         LOG("Doubled " OC_CLK_FMT "\n", t->retrans_tmo);
+        STATS_INC(coap_trans_stats, retrans);
       }
 
-      os_callout_reset(&t->retrans_timer, t->retrans_tmo);
-
-      coap_send_message(t->message);
+      t->retrans_due = os_time_get() + t->retrans_tmo;
+      retrans_heap_insert(t);
 
-      oc_message_add_ref(t->message);
+      /* keep the original for retransmission */
+      m = os_mbuf_dup(t->message);
+      if (m) {
+        coap_send_message(m);
+      }
 
       t = NULL;
     } else {
       /* timed out */
       LOG("Timeout\n");
+      STATS_INC(coap_trans_stats, timeout);
 
 #ifdef OC_SERVER
       LOG("timeout.. so removing observers\n");
       /* handle observers */
-      coap_remove_observer_by_client(&t->message->endpoint);
+      coap_remove_observer_by_client(OC_MBUF_ENDPOINT(t->message));
 #endif /* OC_SERVER */
 
 #ifdef OC_SECURITY
-      if (t->message->endpoint.flags & SECURED) {
-        oc_sec_dtls_close_init(&t->message->endpoint);
+      if (OC_MBUF_ENDPOINT(t->message)->flags & SECURED) {
+        oc_sec_dtls_close_init(OC_MBUF_ENDPOINT(t->message));
       }
 #endif /* OC_SECURITY */
 
@@ -157,7 +293,7 @@ coap_send_transaction(coap_transaction_t *t)
     }
   } else {
     coap_send_message(t->message);
-    oc_message_add_ref(t->message);
+    t->message = NULL;
 
     coap_clear_transaction(t);
   }
@@ -169,8 +305,10 @@ coap_clear_transaction(coap_transaction_t *t)
     if (t) {
         LOG("Freeing transaction %u: %p\n", t->mid, t);
 
-        os_callout_stop(&t->retrans_timer);
-        oc_message_unref(t->message);
+        retrans_heap_remove(t);
+        if (t->message) {
+            os_mbuf_free_chain(t->message);
+        }
         oc_list_remove(transactions_list, t);
         os_memblock_put(&oc_transaction_memb, t);
   }
@@ -191,12 +329,36 @@ coap_get_transaction_by_mid(uint16_t mid)
   return NULL;
 }
 
+void
+coap_transaction_acked(coap_transaction_t *t)
+{
+    uint32_t ms;
+
+    if (t->heap_idx < 0) {
+        return;
+    }
+    ms = (os_time_get() - t->first_tx) * 1000 / OS_TICKS_PER_SEC;
+    STATS_INC(coap_trans_stats, acked);
+    STATS_INCN(coap_trans_stats, ack_lat_ms, ms);
+    if (ms > coap_trans_stats.STATS_SECT_VAR(ack_lat_max_ms)) {
+        coap_trans_stats.STATS_SECT_VAR(ack_lat_max_ms) = ms;
+    }
+}
+
 static void
 coap_transaction_retrans(struct os_event *ev)
 {
-    coap_transaction_t *t = ev->ev_arg;
-    ++(t->retrans_counter);
-    LOG("Retransmitting %u (%u)\n", t->mid, t->retrans_counter);
-    coap_send_transaction(t);
+    coap_transaction_t *t;
+    os_time_t now = os_time_get();
+
+    while (retrans_heap_cnt &&
+      OS_TIME_TICK_GEQ(now, retrans_heap[0]->retrans_due)) {
+        t = retrans_heap[0];
+        retrans_heap_remove(t);
+        ++(t->retrans_counter);
+        LOG("Retransmitting %u (%u)\n", t->mid, t->retrans_counter);
+        coap_send_transaction(t);
+    }
+    retrans_timer_arm();
 }
 
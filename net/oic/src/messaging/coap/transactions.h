@@ -60,9 +60,11 @@ typedef struct coap_transaction
 
   uint16_t mid;
   uint8_t retrans_counter;
+  int8_t heap_idx;              /* slot in the retransmit heap, -1 if none */
   uint32_t retrans_tmo;
-  struct os_callout retrans_timer;
-  oc_message_t *message;
+  os_time_t retrans_due;
+  os_time_t first_tx;
+  struct os_mbuf *message;
 
 } coap_transaction_t;
 
@@ -72,6 +74,7 @@ coap_transaction_t *coap_new_transaction(uint16_t mid, oc_endpoint_t *endpoint);
 
 void coap_send_transaction(coap_transaction_t *t);
 void coap_clear_transaction(coap_transaction_t *t);
+void coap_transaction_acked(coap_transaction_t *t);
 coap_transaction_t *coap_get_transaction_by_mid(uint16_t mid);
 
 void coap_check_transactions(void);
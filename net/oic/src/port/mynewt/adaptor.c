@@ -68,54 +68,69 @@ oc_network_event_handler_mutex_unlock(void)
 }
 
 void
-oc_send_buffer(oc_message_t *message)
+oc_send_buffer(struct os_mbuf *m)
 {
-    switch (message->endpoint.flags) {
+    oc_endpoint_t *oe;
+
+    oe = OC_MBUF_ENDPOINT(m);
+
+    switch (oe->flags) {
 #if (MYNEWT_VAL(OC_TRANSPORT_IP) == 1)
     case IP:
-        oc_send_buffer_ip(message);
+        oc_send_buffer_ip(m);
         break;
 #endif
 #if (MYNEWT_VAL(OC_TRANSPORT_GATT) == 1)
     case GATT:
-        oc_send_buffer_gatt(message);
+        oc_send_buffer_gatt(m);
         break;
 #endif
 #if (MYNEWT_VAL(OC_TRANSPORT_SERIAL) == 1)
     case SERIAL:
-        oc_send_buffer_serial(message);
+        oc_send_buffer_serial(m);
         break;
 #endif
     default:
-        ERROR("Unknown transport option %u\n", message->endpoint.flags);
-        oc_message_unref(message);
+        ERROR("Unknown transport option %u\n", oe->flags);
+        os_mbuf_free_chain(m);
     }
 }
 
-void oc_send_multicast_message(oc_message_t *message)
+void
+oc_send_multicast_message(struct os_mbuf *m)
 {
-    oc_message_add_ref(message);
-
-    /* send on all the transports.  Don't forget to reference the message
-     * so it doesn't get deleted  */
-
+    /*
+     * Send on all the transports.  Each transport consumes the mbuf it is
+     * given, so hand out duplicates and keep the original for the last one.
+     */
+    void (*funcs[])(struct os_mbuf *) = {
 #if (MYNEWT_VAL(OC_TRANSPORT_IP) == 1)
-    oc_send_buffer_ip_mcast(message);
+        oc_send_buffer_ip_mcast,
 #endif
-
 #if (MYNEWT_VAL(OC_TRANSPORT_GATT) == 1)
-    /* no multicast for GATT, just send unicast */
-    oc_message_add_ref(message);
-    oc_send_buffer_gatt(message);
+        /* no multicast for GATT, just send unicast */
+        oc_send_buffer_gatt,
 #endif
-
 #if (MYNEWT_VAL(OC_TRANSPORT_SERIAL) == 1)
-    /* no multi-cast for serial.  just send unicast */
-    oc_message_add_ref(message);
-    oc_send_buffer_serial(message);
+        /* no multi-cast for serial.  just send unicast */
+        oc_send_buffer_serial,
 #endif
-
-    oc_message_unref(message);
+        NULL
+    };
+    struct os_mbuf *n;
+    int i;
+
+    for (i = 0; funcs[i] && funcs[i + 1]; i++) {
+        n = os_mbuf_dup(m);
+        if (n) {
+            funcs[i](n);
+        }
+    }
+    if (funcs[i]) {
+        funcs[i](m);
+    } else {
+        os_mbuf_free_chain(m);
+    }
 }
 
 void
@@ -22,6 +22,7 @@
 #include <assert.h>
 #include <os/os.h>
 #include <string.h>
+#include <stats/stats.h>
 #include "oc_buffer.h"
 #include "port/oc_connectivity.h"
 #include "../oc_log.h"
@@ -47,6 +48,34 @@ const uint8_t gatt_svr_chr_coap[16] = {
 /* queue to hold mbufs until we get called from oic */
 struct os_mqueue ble_coap_mq;
 
+/*
+ * Messages larger than one ATT payload are carried in several writes (to us)
+ * or notifications (from us).  A fragment that fills the payload means more
+ * follow; a shorter one, possibly empty, ends the message.  Fragments are
+ * chained together and split apart without copying the message data.
+ */
+STATS_SECT_START(oc_ble_stats)
+    STATS_SECT_ENTRY(rx_frags)
+    STATS_SECT_ENTRY(rx_msgs)
+    STATS_SECT_ENTRY(rx_reasm_timeout)
+    STATS_SECT_ENTRY(rx_reasm_toobig)
+    STATS_SECT_ENTRY(tx_frags)
+    STATS_SECT_ENTRY(tx_msgs)
+    STATS_SECT_ENTRY(tx_err)
+STATS_SECT_END
+
+static STATS_SECT_DECL(oc_ble_stats) oc_ble_stats;
+
+STATS_NAME_START(oc_ble_stats)
+    STATS_NAME(oc_ble_stats, rx_frags)
+    STATS_NAME(oc_ble_stats, rx_msgs)
+    STATS_NAME(oc_ble_stats, rx_reasm_timeout)
+    STATS_NAME(oc_ble_stats, rx_reasm_toobig)
+    STATS_NAME(oc_ble_stats, tx_frags)
+    STATS_NAME(oc_ble_stats, tx_msgs)
+    STATS_NAME(oc_ble_stats, tx_err)
+STATS_NAME_END(oc_ble_stats)
+
 #if (MYNEWT_VAL(OC_SERVER) == 1)
 /* ble nmgr attr handle */
 uint16_t g_ble_coap_attr_handle;
@@ -75,33 +104,212 @@ static const struct ble_gatt_svc_def gatt_svr_svcs[] = {
     },
 };
 
+/* Partially received messages, one per connection. */
+struct oc_ble_reasm {
+    uint16_t conn_handle;
+    os_time_t deadline;
+    struct os_mbuf *m;
+};
+
+static struct oc_ble_reasm oc_ble_reasm[MYNEWT_VAL(BLE_MAX_CONNECTIONS)];
+static struct os_callout oc_ble_reasm_timer;
+
+static os_time_t
+oc_ble_reasm_timeout_ticks(void)
+{
+    uint32_t ticks;
+
+    if (os_time_ms_to_ticks(MYNEWT_VAL(OC_BLE_REASM_TIMEOUT_MS), &ticks)) {
+        ticks = OS_TICKS_PER_SEC;
+    }
+    return ticks;
+}
+
+/*
+ * Takes the partial message of a connection out of its slot.  *slot is set
+ * to the connection's slot, or to a free one if it has none (NULL if all
+ * are taken).  Called with interrupts disabled.
+ */
+static struct os_mbuf *
+oc_ble_reasm_take(uint16_t conn_handle, struct oc_ble_reasm **slot)
+{
+    struct oc_ble_reasm *free_slot;
+    struct os_mbuf *m;
+    int i;
+
+    free_slot = NULL;
+    for (i = 0; i < MYNEWT_VAL(BLE_MAX_CONNECTIONS); i++) {
+        if (oc_ble_reasm[i].m == NULL) {
+            if (free_slot == NULL) {
+                free_slot = &oc_ble_reasm[i];
+            }
+        } else if (oc_ble_reasm[i].conn_handle == conn_handle) {
+            *slot = &oc_ble_reasm[i];
+            m = oc_ble_reasm[i].m;
+            oc_ble_reasm[i].m = NULL;
+            return m;
+        }
+    }
+
+    *slot = free_slot;
+    return NULL;
+}
+
+static void
+oc_ble_reasm_timer_arm(void)
+{
+    os_time_t now;
+    os_time_t next;
+    os_sr_t sr;
+    int armed;
+    int i;
+
+    now = os_time_get();
+    next = 0;
+    armed = 0;
+
+    OS_ENTER_CRITICAL(sr);
+    for (i = 0; i < MYNEWT_VAL(BLE_MAX_CONNECTIONS); i++) {
+        if (oc_ble_reasm[i].m == NULL) {
+            continue;
+        }
+        if (!armed || OS_TIME_TICK_LT(oc_ble_reasm[i].deadline, next)) {
+            next = oc_ble_reasm[i].deadline;
+            armed = 1;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (armed) {
+        os_callout_reset(&oc_ble_reasm_timer,
+          OS_TIME_TICK_GT(next, now) ? next - now : 0);
+    }
+}
+
+/*
+ * Drops partial messages whose next fragment did not arrive in time.
+ */
+static void
+oc_ble_reasm_expire(struct os_event *ev)
+{
+    struct os_mbuf *m;
+    os_time_t now;
+    os_sr_t sr;
+    int i;
+
+    now = os_time_get();
+    for (i = 0; i < MYNEWT_VAL(BLE_MAX_CONNECTIONS); i++) {
+        OS_ENTER_CRITICAL(sr);
+        m = oc_ble_reasm[i].m;
+        if (m != NULL && OS_TIME_TICK_GEQ(now, oc_ble_reasm[i].deadline)) {
+            oc_ble_reasm[i].m = NULL;
+        } else {
+            m = NULL;
+        }
+        OS_EXIT_CRITICAL(sr);
+
+        if (m != NULL) {
+            ERROR("oc_transport_gatt: reassembly timeout conn=%u len=%u\n",
+                  oc_ble_reasm[i].conn_handle, OS_MBUF_PKTLEN(m));
+            STATS_INC(oc_ble_stats, rx_reasm_timeout);
+            os_mbuf_free_chain(m);
+        }
+    }
+
+    oc_ble_reasm_timer_arm();
+}
+
+/*
+ * Adds a received fragment to the connection's message.  Complete messages
+ * are queued for the OIC task, with the connection handle appended.
+ */
+static int
+oc_ble_reasm_rx(uint16_t conn_handle, struct os_mbuf *frag)
+{
+    struct oc_ble_reasm *slot;
+    struct os_mbuf *m;
+    uint16_t frag_len;
+    uint16_t mtu;
+    os_sr_t sr;
+    int rc;
+
+    STATS_INC(oc_ble_stats, rx_frags);
+
+    frag_len = OS_MBUF_PKTLEN(frag);
+    mtu = ble_att_mtu(conn_handle);
+
+    OS_ENTER_CRITICAL(sr);
+    m = oc_ble_reasm_take(conn_handle, &slot);
+    OS_EXIT_CRITICAL(sr);
+
+    if (m == NULL) {
+        m = frag;
+    } else if (frag_len == 0) {
+        os_mbuf_free_chain(frag);
+    } else {
+        os_mbuf_concat(m, frag);
+    }
+
+    if (OS_MBUF_PKTLEN(m) > MYNEWT_VAL(OC_MAX_PAYLOAD_SIZE)) {
+        STATS_INC(oc_ble_stats, rx_reasm_toobig);
+        rc = BLE_ATT_ERR_INSUFFICIENT_RES;
+        goto err;
+    }
+
+    if (mtu > 3 && frag_len == mtu - 3) {
+        /* More to follow; park the message until they arrive. */
+        if (slot == NULL) {
+            rc = BLE_ATT_ERR_PREPARE_QUEUE_FULL;
+            goto err;
+        }
+
+        OS_ENTER_CRITICAL(sr);
+        slot->conn_handle = conn_handle;
+        slot->deadline = os_time_get() + oc_ble_reasm_timeout_ticks();
+        slot->m = m;
+        OS_EXIT_CRITICAL(sr);
+
+        oc_ble_reasm_timer_arm();
+        return 0;
+    }
+
+    /* stick the conn handle at the end of the frame -- we will
+     * pull it out later */
+    rc = os_mbuf_append(m, &conn_handle, sizeof(conn_handle));
+    if (rc) {
+        rc = BLE_ATT_ERR_INSUFFICIENT_RES;
+        goto err;
+    }
+    rc = os_mqueue_put(&ble_coap_mq, oc_evq_get(), m);
+    if (rc) {
+        rc = BLE_ATT_ERR_PREPARE_QUEUE_FULL;
+        goto err;
+    }
+
+    STATS_INC(oc_ble_stats, rx_msgs);
+    return 0;
+
+err:
+    os_mbuf_free_chain(m);
+    return rc;
+}
+
 static int
 gatt_svr_chr_access_coap(uint16_t conn_handle, uint16_t attr_handle,
                          struct ble_gatt_access_ctxt *ctxt, void *arg)
 {
     struct os_mbuf *m;
-    int rc;
     (void) attr_handle; /* no need to use this since we have onyl one attr
                          * tied to this callback */
 
     switch (ctxt->op) {
         case BLE_GATT_ACCESS_OP_WRITE_CHR:
             m = ctxt->om;
-            /* stick the conn handle at the end of the frame -- we will
-             * pull it out later */
-            rc = os_mbuf_append(m, &conn_handle, sizeof(conn_handle));
-            if (rc) {
-                return BLE_ATT_ERR_INSUFFICIENT_RES;
-            }
-            rc = os_mqueue_put(&ble_coap_mq, oc_evq_get(), m);
-            if (rc) {
-                return BLE_ATT_ERR_PREPARE_QUEUE_FULL;
-            }
 
             /* tell nimble we are keeping the mbuf */
             ctxt->om = NULL;
 
-            break;
+            return oc_ble_reasm_rx(conn_handle, m);
         default:
             assert(0);
             return BLE_ATT_ERR_UNLIKELY;
@@ -109,75 +317,56 @@ gatt_svr_chr_access_coap(uint16_t conn_handle, uint16_t attr_handle,
     return 0;
 }
 
-oc_message_t *
+struct os_mbuf *
 oc_attempt_rx_gatt(void)
 {
     int rc;
-    struct os_mbuf *m = NULL;
+    struct os_mbuf *m;
+    struct os_mbuf *n;
     struct os_mbuf_pkthdr *pkt;
-    uint16_t conn_handle;
-    oc_message_t *message = NULL;
+    oc_endpoint_t oe;
 
     LOG("oc_transport_gatt attempt rx\n");
 
     /* get an mbuf from the queue */
-    m = os_mqueue_get(&ble_coap_mq);
-    if (NULL == m) {
+    n = os_mqueue_get(&ble_coap_mq);
+    if (NULL == n) {
         ERROR("oc_transport_gatt: Woke for for receive but found no mbufs\n");
-        goto rx_attempt_err;
+        return NULL;
     }
 
-    if (!OS_MBUF_IS_PKTHDR(m)) {
-        ERROR("oc_transport_gatt: received mbuf that wasn't a packet header\n");
-        goto rx_attempt_err;
-    }
-
-    pkt = OS_MBUF_PKTHDR(m);
+    pkt = OS_MBUF_PKTHDR(n);
 
     LOG("oc_transport_gatt rx %p-%u\n", pkt, pkt->omp_len);
+    memset(&oe, 0, sizeof(oe));
+    oe.flags = GATT;
+
     /* get the conn handle from the end of the message */
-    rc = os_mbuf_copydata(m, pkt->omp_len - sizeof(conn_handle),
-                          sizeof(conn_handle), &conn_handle);
+    rc = os_mbuf_copydata(n, pkt->omp_len - sizeof(oe.bt_addr.conn_handle),
+                          sizeof(oe.bt_addr.conn_handle),
+                          &oe.bt_addr.conn_handle);
     if (rc != 0) {
         ERROR("Failed to retrieve conn_handle from mbuf \n");
         goto rx_attempt_err;
     }
 
     /* trim conn_handle from the end */
-    os_mbuf_adj(m, - sizeof(conn_handle));
+    os_mbuf_adj(n, - sizeof(oe.bt_addr.conn_handle));
 
-    message = oc_allocate_message();
-    if (NULL == message) {
+    m = oc_allocate_mbuf(&oe);
+    if (!m) {
         ERROR("Could not allocate OC message buffer\n");
         goto rx_attempt_err;
     }
 
-    if (pkt->omp_len > MAX_PAYLOAD_SIZE) {
-        ERROR("Message to large for OC message buffer\n");
-        goto rx_attempt_err;
-    }
-    /* copy to message from mbuf chain */
-    rc = os_mbuf_copydata(m, 0, pkt->omp_len, message->data);
-    if (rc != 0) {
-        ERROR("Failed to copy message from mbuf to OC message buffer \n");
-        goto rx_attempt_err;
-    }
+    /* chain the received data behind the endpoint, no copy */
+    os_mbuf_concat(m, n);
 
-    os_mbuf_free_chain(m);
-    message->endpoint.flags = GATT;
-    message->endpoint.bt_addr.conn_handle = conn_handle;
-    message->length = pkt->omp_len;
-    LOG("Successfully rx length %lu\n", (unsigned long)message->length);
-    return message;
+    LOG("Successfully rx length %u\n", OS_MBUF_PKTLEN(m));
+    return m;
 
-    /* add the addr info to the message */
 rx_attempt_err:
-    if (m) {
-        os_mbuf_free_chain(m);
-    }
-    if (message) {
-        oc_message_unref(message);
-    }
+    os_mbuf_free_chain(n);
     return NULL;
 }
 #endif
@@ -204,17 +393,30 @@ ble_coap_gatt_srv_init(void)
 static void
 oc_event_gatt(struct os_event *ev)
 {
-    oc_message_t *pmsg;
+    struct os_mbuf *m;
 
-    while ((pmsg = oc_attempt_rx_gatt()) != NULL) {
-        oc_network_event(pmsg);
+    while ((m = oc_attempt_rx_gatt()) != NULL) {
+        oc_network_event(m);
     }
 }
 
 int
 oc_connectivity_init_gatt(void)
 {
+    int rc;
+
+    rc = stats_init_and_reg(STATS_HDR(oc_ble_stats),
+      STATS_SIZE_INIT_PARMS(oc_ble_stats, STATS_SIZE_32),
+      STATS_NAME_INIT_PARMS(oc_ble_stats), "oc_ble");
+    if (rc) {
+        return rc;
+    }
+
     os_mqueue_init(&ble_coap_mq, oc_event_gatt, NULL);
+#if (MYNEWT_VAL(OC_SERVER) == 1)
+    os_callout_init(&oc_ble_reasm_timer, oc_evq_get(), oc_ble_reasm_expire,
+                    NULL);
+#endif
     return 0;
 }
 
@@ -225,52 +427,82 @@ oc_connectivity_shutdown_gatt(void)
 }
 
 void
-oc_send_buffer_gatt(oc_message_t *message)
+oc_send_buffer_gatt(struct os_mbuf *m)
 {
-    struct os_mbuf *m = NULL;
-    int rc;
-
-    /* get a packet header */
-    m = os_msys_get_pkthdr(0, 0);
-    if (m == NULL) {
-        ERROR("oc_transport_gatt: No mbuf available\n");
-        goto err;
-    }
-
-    /* add this data to the mbuf */
-    rc = os_mbuf_append(m, message->data, message->length);
-    if (rc != 0) {
-        ERROR("oc_transport_gatt: could not append data \n");
-        goto err;
-    }
-
 #if (MYNEWT_VAL(OC_CLIENT) == 1)
     ERROR("send not supported on client");
 #endif
 
 #if (MYNEWT_VAL(OC_SERVER) == 1)
-    ble_gattc_notify_custom(message->endpoint.bt_addr.conn_handle,
-                            g_ble_coap_attr_handle, m);
-    m = NULL;
-#endif
+    struct os_mbuf *frag;
+    uint16_t conn_handle;
+    uint16_t mtu;
+    int last;
+    int rc;
 
-err:
-    if (m) {
+    conn_handle = OC_MBUF_ENDPOINT(m)->bt_addr.conn_handle;
+    mtu = ble_att_mtu(conn_handle);
+    if (mtu <= 3) {
+        STATS_INC(oc_ble_stats, tx_err);
         os_mbuf_free_chain(m);
+        return;
+    }
+    mtu -= 3;
+
+    /* Send the message in payload sized pieces.  A message that ends on a
+     * full fragment is followed by an empty one to terminate it.
+     */
+    while (m != NULL) {
+        if (OS_MBUF_PKTLEN(m) > mtu) {
+            frag = m;
+            m = os_mbuf_split(frag, mtu);
+            if (m == NULL) {
+                STATS_INC(oc_ble_stats, tx_err);
+                os_mbuf_free_chain(frag);
+                return;
+            }
+            last = 0;
+        } else if (OS_MBUF_PKTLEN(m) == mtu) {
+            frag = m;
+            m = os_msys_get_pkthdr(0, 0);
+            if (m == NULL) {
+                STATS_INC(oc_ble_stats, tx_err);
+                os_mbuf_free_chain(frag);
+                return;
+            }
+            last = 0;
+        } else {
+            frag = m;
+            m = NULL;
+            last = 1;
+        }
+
+        rc = ble_gattc_notify_custom(conn_handle, g_ble_coap_attr_handle,
+                                     frag);
+        if (rc) {
+            STATS_INC(oc_ble_stats, tx_err);
+            os_mbuf_free_chain(m);
+            return;
+        }
+        STATS_INC(oc_ble_stats, tx_frags);
+        if (last) {
+            STATS_INC(oc_ble_stats, tx_msgs);
+        }
     }
-    oc_message_unref(message);
-    return;
+#else
+    os_mbuf_free_chain(m);
+#endif
 }
 
 void
-oc_send_buffer_gatt_mcast(oc_message_t *message)
+oc_send_buffer_gatt_mcast(struct os_mbuf *m)
 {
 #if (MYNEWT_VAL(OC_CLIENT) == 1)
     ERROR("send not supported on client");
 #elif (MYNEWT_VAL(OC_SERVER) == 1)
-    oc_message_unref(message);
     ERROR("oc_transport_gatt: no multicast support for server only system \n");
 #endif
+    os_mbuf_free_chain(m);
 }
 
 #endif
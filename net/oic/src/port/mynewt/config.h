@@ -41,10 +41,16 @@ typedef os_time_t oc_clock_time_t;
 #define OC_INTS_POOL_SIZE (16)
 #define OC_DOUBLES_POOL_SIZE (16)
 
+/* Arena for parsed request/response payloads, released per request */
+#define OC_ARENA_SIZE MYNEWT_VAL(OC_ARENA_SIZE)
+
 /* Server-side parameters */
 /* Maximum number of server resources */
 #define MAX_APP_RESOURCES MYNEWT_VAL(OC_APP_RESOURCES)
 
+/* Maximum number of key=value pairs decoded from a request query */
+#define MAX_QUERY_PARAMS MYNEWT_VAL(OC_MAX_QUERY_PARAMS)
+
 /* Common paramters */
 /* Maximum number of concurrent requests */
 #define MAX_NUM_CONCURRENT_REQUESTS MYNEWT_VAL(OC_CONCURRENT_REQUESTS)
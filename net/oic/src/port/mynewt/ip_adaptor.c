@@ -33,9 +33,12 @@
 
 static void oc_event_ip(struct os_event *ev);
 
-struct os_event oc_sock_read_event = {
-    .ev_cb = oc_event_ip,
-};
+/* datagrams taken from a socket per mn_recvmmsg() call */
+#define OC_IP_RX_BATCH      4
+
+/* one event wakes us up for both sockets */
+static struct mn_pollset oc_pollset;
+static struct mn_poll_entry oc_ucast_pe;
 
 #ifdef OC_SECURITY
 #error This implementation does not yet support security
@@ -55,30 +58,27 @@ struct mn_socket *ucast;
 
 #if (MYNEWT_VAL(OC_SERVER) == 1)
 struct mn_socket *mcast;
+static struct mn_poll_entry oc_mcast_pe;
 #endif
 
 static void
-oc_send_buffer_ip_int(oc_message_t *message, int mcast)
+oc_send_buffer_ip_int(struct os_mbuf *m, int mcast)
 {
     struct mn_sockaddr_in6 to;
-    struct os_mbuf m;
+    oc_endpoint_t *oe;
+    struct os_mbuf *n;
     int rc;
 
-    LOG("oc_transport_ip attempt send buffer %lu\n",
-        (unsigned long)message->length);
+    LOG("oc_transport_ip attempt send buffer %u\n", OS_MBUF_PKTLEN(m));
+
+    oe = OC_MBUF_ENDPOINT(m);
 
     to.msin6_len = sizeof(to);
     to.msin6_family = MN_AF_INET6;
 
-    to.msin6_port = htons(message->endpoint.ipv6_addr.port);
-    memcpy(&to.msin6_addr, message->endpoint.ipv6_addr.address,
-           sizeof(to.msin6_addr));
-
-    /* put on an mbuf header to make the socket happy */
-    memset(&m,0, sizeof(m));
-    m.om_data = message->data;
-    m.om_len = message->length;
-    to.msin6_scope_id = message->endpoint.ipv6_addr.scope;
+    to.msin6_port = htons(oe->ipv6_addr.port);
+    memcpy(&to.msin6_addr, oe->ipv6_addr.address, sizeof(to.msin6_addr));
+    to.msin6_scope_id = oe->ipv6_addr.scope;
 
     if (mcast) {
         struct mn_itf itf;
@@ -96,121 +96,137 @@ oc_send_buffer_ip_int(oc_message_t *message, int mcast)
 
             to.msin6_scope_id = itf.mif_idx;
 
-            rc = mn_sendto(ucast, &m, (struct mn_sockaddr *) &to);
+            /* the socket consumes what it sends; keep m for the next itf */
+            n = os_mbuf_dup(m);
+            if (!n) {
+                ERROR("Could not duplicate buffer for itf %d\n",
+                      to.msin6_scope_id);
+                break;
+            }
+            rc = mn_sendto(ucast, n, (struct mn_sockaddr *) &to);
             if (rc != 0) {
-                ERROR("Failed sending buffer %lu on itf %d\n",
-                      (unsigned long)message->length, to.msin6_scope_id);
+                ERROR("Failed sending buffer %u on itf %d\n",
+                      OS_MBUF_PKTLEN(m), to.msin6_scope_id);
+                os_mbuf_free_chain(n);
             }
         }
+        os_mbuf_free_chain(m);
     } else {
-        rc = mn_sendto(ucast, &m, (struct mn_sockaddr *) &to);
+        rc = mn_sendto(ucast, m, (struct mn_sockaddr *) &to);
         if (rc != 0) {
-            ERROR("Failed sending buffer %lu on itf %d\n",
-                  (unsigned long)message->length, to.msin6_scope_id);
+            ERROR("Failed sending buffer %u on itf %d\n",
+                  OS_MBUF_PKTLEN(m), to.msin6_scope_id);
+            os_mbuf_free_chain(m);
         }
     }
-    oc_message_unref(message);
 }
 
 void
-oc_send_buffer_ip(oc_message_t *message) {
-    oc_send_buffer_ip_int(message, 0);
+oc_send_buffer_ip(struct os_mbuf *m) {
+    oc_send_buffer_ip_int(m, 0);
 }
 void
-oc_send_buffer_ip_mcast(oc_message_t *message) {
-    oc_send_buffer_ip_int(message, 1);
+oc_send_buffer_ip_mcast(struct os_mbuf *m) {
+    oc_send_buffer_ip_int(m, 1);
 }
 
-oc_message_t *
-oc_attempt_rx_ip_sock(struct mn_socket * rxsock) {
-    int rc;
-    struct os_mbuf *m = NULL;
+static struct os_mbuf *
+oc_rx_ip_wrap(struct mn_socket *rxsock, struct os_mbuf *n,
+              struct mn_sockaddr_in6 *from)
+{
+    struct os_mbuf *m;
     struct os_mbuf_pkthdr *pkt;
-    oc_message_t *message = NULL;
-    struct mn_sockaddr_in6 from;
-
-    LOG("oc_transport_ip attempt rx from %p\n", rxsock);
-
-    rc= mn_recvfrom(rxsock, &m, (struct mn_sockaddr *) &from);
+    oc_endpoint_t oe;
 
-    if ( rc != 0) {
-        return NULL;
-    }
-
-    if (!OS_MBUF_IS_PKTHDR(m)) {
+    if (!OS_MBUF_IS_PKTHDR(n)) {
         goto rx_attempt_err;
     }
 
-    pkt = OS_MBUF_PKTHDR(m);
+    pkt = OS_MBUF_PKTHDR(n);
 
     LOG("rx from %p %p-%u\n", rxsock, pkt, pkt->omp_len);
 
-    message = oc_allocate_message();
-    if (NULL == message) {
+    oe.flags = IP;
+    memcpy(&oe.ipv6_addr.address, &from->msin6_addr,
+             sizeof(oe.ipv6_addr.address));
+    oe.ipv6_addr.scope = from->msin6_scope_id;
+    oe.ipv6_addr.port = ntohs(from->msin6_port);
+
+    m = oc_allocate_mbuf(&oe);
+    if (!m) {
         ERROR("Could not allocate OC message buffer\n");
         goto rx_attempt_err;
     }
 
-    if (pkt->omp_len > MAX_PAYLOAD_SIZE) {
-        ERROR("Message to large for OC message buffer\n");
-        goto rx_attempt_err;
-    }
-    /* copy to message from mbuf chain */
-    rc = os_mbuf_copydata(m, 0, pkt->omp_len, message->data);
-    if (rc != 0) {
-        ERROR("Failed to copy message from mbuf to OC message buffer \n");
-        goto rx_attempt_err;
-    }
+    /* chain the received data behind the endpoint, no copy */
+    os_mbuf_concat(m, n);
 
-    os_mbuf_free_chain(m);
+    LOG("Successfully rx from %p len %u\n", rxsock, OS_MBUF_PKTLEN(m));
+    return m;
 
-    message->endpoint.flags = IP;
-    message->length = pkt->omp_len;
-    memcpy(&message->endpoint.ipv6_addr.address, &from.msin6_addr,
-             sizeof(message->endpoint.ipv6_addr.address));
-    message->endpoint.ipv6_addr.scope = from.msin6_scope_id;
-    message->endpoint.ipv6_addr.port = ntohs(from.msin6_port);
+rx_attempt_err:
+    os_mbuf_free_chain(n);
+    return NULL;
+}
 
-    LOG("Successfully rx from %p len %lu\n", rxsock,
-        (unsigned long)message->length);
-    return message;
+struct os_mbuf *
+oc_attempt_rx_ip_sock(struct mn_socket * rxsock) {
+    int rc;
+    struct os_mbuf *n = NULL;
+    struct mn_sockaddr_in6 from;
 
-    /* add the addr info to the message */
-rx_attempt_err:
-    if (m) {
-        os_mbuf_free_chain(m);
-    }
+    LOG("oc_transport_ip attempt rx from %p\n", rxsock);
+
+    rc= mn_recvfrom(rxsock, &n, (struct mn_sockaddr *) &from);
 
-    if (message) {
-        oc_message_unref(message);
+    if ( rc != 0) {
+        return NULL;
     }
+    return oc_rx_ip_wrap(rxsock, n, &from);
+}
 
-    return NULL;
+/*
+ * Take everything queued on the socket, OC_IP_RX_BATCH datagrams at a time.
+ */
+static void
+oc_rx_ip_drain(struct mn_socket *rxsock)
+{
+    struct mn_sockaddr_in6 from[OC_IP_RX_BATCH];
+    struct mn_mmsg msgs[OC_IP_RX_BATCH];
+    struct os_mbuf *m;
+    int cnt;
+    int rc;
+    int i;
+
+    for (i = 0; i < OC_IP_RX_BATCH; i++) {
+        msgs[i].mm_addr = (struct mn_sockaddr *)&from[i];
+    }
+    do {
+        rc = mn_recvmmsg(rxsock, msgs, OC_IP_RX_BATCH, &cnt);
+        if (rc != 0) {
+            break;
+        }
+        LOG("oc_transport_ip rx %d from %p\n", cnt, rxsock);
+        for (i = 0; i < cnt; i++) {
+            m = oc_rx_ip_wrap(rxsock, msgs[i].mm_data, &from[i]);
+            if (m) {
+                oc_network_event(m);
+            }
+        }
+    } while (cnt == OC_IP_RX_BATCH);
 }
 
-oc_message_t *
+struct os_mbuf *
 oc_attempt_rx_ip(void) {
-    oc_message_t *pmsg;
-    pmsg = oc_attempt_rx_ip_sock(ucast);
+    struct os_mbuf *m;
+
+    m = oc_attempt_rx_ip_sock(ucast);
 #if (MYNEWT_VAL(OC_SERVER) == 1)
-    if (pmsg == NULL ) {
-        pmsg = oc_attempt_rx_ip_sock(mcast);
+    if (m == NULL ) {
+        m = oc_attempt_rx_ip_sock(mcast);
     }
 #endif
-    return pmsg;
-}
-
-static void oc_socks_readable(void *cb_arg, int err);
-
-union mn_socket_cb oc_sock_cbs = {
-    .socket.readable = oc_socks_readable,
-    .socket.writable = NULL
-};
-
-void
-oc_socks_readable(void *cb_arg, int err)
-{
-    os_eventq_put(oc_evq_get(), &oc_sock_read_event);
+    return m;
 }
 
 void
@@ -219,11 +235,13 @@ oc_connectivity_shutdown_ip(void)
     LOG("OC shutdown IP\n");
 
     if (ucast) {
+        mn_pollset_remove(&oc_pollset, &oc_ucast_pe);
         mn_close(ucast);
     }
 
 #if (MYNEWT_VAL(OC_SERVER) == 1)
     if (mcast) {
+        mn_pollset_remove(&oc_pollset, &oc_mcast_pe);
         mn_close(mcast);
     }
 #endif
@@ -233,10 +251,13 @@ oc_connectivity_shutdown_ip(void)
 static void
 oc_event_ip(struct os_event *ev)
 {
-    oc_message_t *pmsg;
+    struct mn_poll_entry *pe;
+    uint8_t events;
 
-    while ((pmsg = oc_attempt_rx_ip()) != NULL) {
-        oc_network_event(pmsg);
+    while ((pe = mn_pollset_next(&oc_pollset, &events)) != NULL) {
+        if (events & MN_POLL_READ) {
+            oc_rx_ip_drain(pe->mpe_sock);
+        }
     }
 }
 
@@ -255,21 +276,24 @@ oc_connectivity_init_ip(void)
         ERROR("Could not create oc logging\n");
         return rc;    }
 
+    mn_pollset_init(&oc_pollset, oc_evq_get(), oc_event_ip, NULL);
+
     rc = mn_socket(&ucast, MN_PF_INET6, MN_SOCK_DGRAM, 0);
     if ( rc != 0 || !ucast ) {
         ERROR("Could not create oc unicast socket\n");
         return rc;
     }
-    mn_socket_set_cbs(ucast, ucast, &oc_sock_cbs);
+    mn_pollset_add(&oc_pollset, &oc_ucast_pe, ucast, NULL);
 
 #if (MYNEWT_VAL(OC_SERVER) == 1)
     rc = mn_socket(&mcast, MN_PF_INET6, MN_SOCK_DGRAM, 0);
     if ( rc != 0 || !mcast ) {
+        mn_pollset_remove(&oc_pollset, &oc_ucast_pe);
         mn_close(ucast);
         ERROR("Could not create oc multicast socket\n");
         return rc;
     }
-    mn_socket_set_cbs(mcast, mcast, &oc_sock_cbs);
+    mn_pollset_add(&oc_pollset, &oc_mcast_pe, mcast, NULL);
 #endif
 
     sin.msin6_len = sizeof(sin);
@@ -18,12 +18,25 @@
  */
 #include "../oc_random.h"
 #include <stdlib.h>
+#include "syscfg/syscfg.h"
+#if MYNEWT_VAL(ENTROPY_PRESENT)
+#include "entropy/entropy.h"
+#endif
 
 void oc_random_init(unsigned short seed) {
     srand(seed);
 }
 
 unsigned short oc_random_rand(void) {
+#if MYNEWT_VAL(ENTROPY_PRESENT)
+    unsigned short r;
+
+    /* Message ids, tokens and UUIDs need to be unpredictable; prefer the
+     * system DRBG and fall back to rand() only until it is seeded. */
+    if (entropy_get(&r, sizeof(r)) == 0) {
+        return r;
+    }
+#endif
     return rand();
 }
 
@@ -21,6 +21,7 @@
 #if (MYNEWT_VAL(OC_TRANSPORT_SERIAL) == 1)
 
 #include <assert.h>
+#include <string.h>
 #include <os/os.h>
 #include <shell/shell.h>
 #include "oc_buffer.h"
@@ -45,10 +46,10 @@ oc_connectivity_shutdown_serial(void) {
 static void
 oc_event_serial(struct os_event *ev)
 {
-    oc_message_t *pmsg;
+    struct os_mbuf *m;
 
-    while ((pmsg = oc_attempt_rx_serial()) != NULL) {
-        oc_network_event(pmsg);
+    while ((m = oc_attempt_rx_serial()) != NULL) {
+        oc_network_event(m);
     }
 }
 
@@ -75,101 +76,60 @@ err:
 
 
 void
-oc_send_buffer_serial(oc_message_t *message)
+oc_send_buffer_serial(struct os_mbuf *m)
 {
     int rc;
-    struct os_mbuf *m;
-
-    /* get a packet header */
-    m = os_msys_get_pkthdr(0, 0);
-    if (m == NULL) {
-        ERROR("oc_transport_serial: No mbuf available\n");
-        goto err;
-    }
-
-    /* add this data to the mbuf */
-    rc = os_mbuf_append(m, message->data, message->length);
-    if (rc != 0) {
+    uint16_t len;
 
-        ERROR("oc_transport_serial: could not append data \n");
-        goto err;
-    }
+    len = OS_MBUF_PKTLEN(m);
 
     /* send over the shell output */
     rc = shell_nlip_output(m);
     if (rc != 0) {
         ERROR("oc_transport_serial: nlip output failed \n");
-        goto err;
+        os_mbuf_free_chain(m);
+        return;
     }
 
-    LOG("oc_transport_serial: send buffer %zu\n", message->length);
-
-err:
-    oc_message_unref(message);
-    return;
-
+    LOG("oc_transport_serial: send buffer %u\n", len);
 }
 
-oc_message_t *
+struct os_mbuf *
 oc_attempt_rx_serial(void) {
-    int rc;
-    struct os_mbuf *m = NULL;
+    struct os_mbuf *m;
+    struct os_mbuf *n;
     struct os_mbuf_pkthdr *pkt;
-    oc_message_t *message = NULL;
+    oc_endpoint_t oe;
 
     LOG("oc_transport_serial attempt rx\n");
 
     /* get an mbuf from the queue */
-    m = os_mqueue_get(&oc_serial_mqueue);
-    if (NULL == m) {
+    n = os_mqueue_get(&oc_serial_mqueue);
+    if (NULL == n) {
         ERROR("oc_transport_serial: Woke for for receive but found no mbufs\n");
-        goto rx_attempt_err;
-    }
-
-    if (!OS_MBUF_IS_PKTHDR(m)) {
-        ERROR("oc_transport_serial: received mbuf that wasn't a packet header\n");
-        goto rx_attempt_err;
+        return NULL;
     }
 
-    pkt = OS_MBUF_PKTHDR(m);
+    pkt = OS_MBUF_PKTHDR(n);
 
     LOG("oc_transport_serial rx %p-%u\n", pkt, pkt->omp_len);
 
-    message = oc_allocate_message();
-    if (NULL == message) {
+    memset(&oe, 0, sizeof(oe));
+    oe.flags = SERIAL;
+    m = oc_allocate_mbuf(&oe);
+    if (!m) {
         ERROR("Could not allocate OC message buffer\n");
         goto rx_attempt_err;
     }
 
-    if (pkt->omp_len > MAX_PAYLOAD_SIZE) {
-        ERROR("Message to large for OC message buffer\n");
-        goto rx_attempt_err;
-    }
-    /* copy to message from mbuf chain */
-    rc = os_mbuf_copydata(m, 0, pkt->omp_len, message->data);
-    if (rc != 0) {
-        ERROR("Failed to copy message from mbuf to OC message buffer \n");
-        goto rx_attempt_err;
-    }
-
-    os_mbuf_free_chain(m);
+    /* chain the received data behind the endpoint, no copy */
+    os_mbuf_concat(m, n);
 
-    message->endpoint.flags = SERIAL;
-    message->length = pkt->omp_len;
+    LOG("Successfully rx length %u\n", OS_MBUF_PKTLEN(m));
+    return m;
 
-    LOG("Successfully rx length %zu\n", message->length);
-    return message;
-
-    /* add the addr info to the message */
 rx_attempt_err:
-    if (m) {
-        os_mbuf_free_chain(m);
-    }
-
-    if (message) {
-        oc_message_unref(message);
-    }
-
+    os_mbuf_free_chain(n);
     return NULL;
 }
 
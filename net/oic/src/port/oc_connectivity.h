@@ -21,6 +21,7 @@
 #include "oic/oc_network_events.h"
 #include "oc_log.h"
 #include <stdint.h>
+#include <os/os_mbuf.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -40,7 +41,7 @@ typedef struct
   uint16_t conn_handle;
 } oc_le_addr_t;
 
-typedef struct
+typedef struct oc_endpoint
 {
   enum transport_flags
   {
@@ -64,16 +65,14 @@ typedef struct
                             .ipv6_addr = {.port = __port__,                    \
                                           .address = { __VA_ARGS__ } } }
 
-typedef struct oc_message_s
-{
-  struct oc_message_s *next;
-  oc_endpoint_t endpoint;
-  size_t length;
-  uint8_t ref_count;
-  uint8_t data[MAX_PAYLOAD_SIZE];
-} oc_message_t;
+/*
+ * Messages are carried as mbuf chains with a packet header.  The endpoint
+ * the message came from, or is going to, lives in the user header.
+ */
+#define OC_MBUF_ENDPOINT(m)                                                    \
+  ((oc_endpoint_t *)OS_MBUF_USRHDR(m))
 
-void oc_send_buffer(oc_message_t *message);
+void oc_send_buffer(struct os_mbuf *m);
 
 #ifdef OC_SECURITY
 uint16_t oc_connectivity_get_dtls_port(void);
@@ -83,7 +82,7 @@ int oc_connectivity_init(void);
 
 void oc_connectivity_shutdown(void);
 
-void oc_send_multicast_message(oc_message_t *message);
+void oc_send_multicast_message(struct os_mbuf *m);
 
 #ifdef __cplusplus
 }
@@ -34,9 +34,11 @@ oc_sec_load_doxm(void)
   if (oc_sec_provisioned()) {
     ret = oc_storage_read("/doxm", buf, size);
     if (ret > 0) {
+      unsigned int arena = oc_mmem_arena_mark();
       oc_parse_rep(buf, ret, &rep);
       oc_sec_decode_doxm(rep);
       oc_free_rep(rep);
+      oc_mmem_arena_release(arena);
     }
   }
 
@@ -59,9 +61,11 @@ oc_sec_load_pstat(void)
 
   ret = oc_storage_read("/pstat", buf, size);
   if (ret > 0) {
+    unsigned int arena = oc_mmem_arena_mark();
     oc_parse_rep(buf, ret, &rep);
     oc_sec_decode_pstat(rep);
     oc_free_rep(rep);
+    oc_mmem_arena_release(arena);
   }
 
   if (ret <= 0) {
@@ -83,9 +87,11 @@ oc_sec_load_cred(void)
     if (ret <= 0)
       return;
 
+    unsigned int arena = oc_mmem_arena_mark();
     oc_parse_rep(buf, ret, &rep);
     oc_sec_decode_cred(rep, NULL);
     oc_free_rep(rep);
+    oc_mmem_arena_release(arena);
   }
 }
 
@@ -102,9 +108,11 @@ oc_sec_load_acl(void)
   if (oc_sec_provisioned()) {
     ret = oc_storage_read("/acl", buf, size);
     if (ret > 0) {
+      unsigned int arena = oc_mmem_arena_mark();
       oc_parse_rep(buf, ret, &rep);
       oc_sec_decode_acl(rep);
       oc_free_rep(rep);
+      oc_mmem_arena_release(arena);
     }
   }
 
@@ -44,6 +44,10 @@
 #error "Please define byte, int, double pool sizes in config.h"
 #endif /* ...POOL_SIZE */
 
+#if !defined(OC_ARENA_SIZE)
+#error "Please define the request arena size in config.h"
+#endif /* OC_ARENA_SIZE */
+
 static double doubles[OC_DOUBLES_POOL_SIZE];
 static int64_t ints[OC_INTS_POOL_SIZE];
 static unsigned char bytes[OC_BYTES_POOL_SIZE];
@@ -53,10 +57,83 @@ OC_LIST(bytes_list);
 OC_LIST(ints_list);
 OC_LIST(doubles_list);
 
+/*
+ * Request arena.  Allocations made while an arena scope is open are bumped
+ * off the top of the arena and never compacted; oc_mmem_free() on them is a
+ * no-op and oc_mmem_arena_release() gives everything back in one go.
+ * Kept in 8 byte units so int and double arrays stay aligned.
+ */
+#define OC_ARENA_UNITS ((OC_ARENA_SIZE + 7) / 8)
+static uint64_t arena[OC_ARENA_UNITS];
+static unsigned int arena_used;
+static int arena_depth;
+
+static int
+oc_mmem_arena_alloc(struct oc_mmem *m, unsigned int size, pool pool_type)
+{
+  unsigned int units;
+
+  switch (pool_type) {
+  case BYTE_POOL:
+    units = (size + 7) / 8;
+    break;
+  case INT_POOL:
+  case DOUBLE_POOL:
+    units = size;
+    break;
+  default:
+    return 0;
+  }
+  if (OC_ARENA_UNITS - arena_used < units) {
+    return 0;
+  }
+  m->next = NULL;
+  m->ptr = &arena[arena_used];
+  m->size = size;
+  arena_used += units;
+  return 1;
+}
+
+static int
+oc_mmem_in_arena(struct oc_mmem *m)
+{
+  return (uint64_t *)m->ptr >= arena &&
+         (uint64_t *)m->ptr < &arena[OC_ARENA_UNITS];
+}
+
+void
+oc_mmem_arena_begin(void)
+{
+  arena_depth++;
+}
+
+void
+oc_mmem_arena_end(void)
+{
+  arena_depth--;
+}
+
+unsigned int
+oc_mmem_arena_mark(void)
+{
+  return arena_used;
+}
+
+void
+oc_mmem_arena_release(unsigned int mark)
+{
+  if (mark < arena_used) {
+    arena_used = mark;
+  }
+}
+
 /*---------------------------------------------------------------------------*/
 int
 oc_mmem_alloc(struct oc_mmem *m, unsigned int size, pool pool_type)
 {
+  if (arena_depth > 0 && oc_mmem_arena_alloc(m, size, pool_type)) {
+    return 1;
+  }
   switch (pool_type) {
   case BYTE_POOL:
     if (avail_bytes < size) {
@@ -96,6 +173,9 @@ oc_mmem_free(struct oc_mmem *m, pool pool_type)
 {
   struct oc_mmem *n;
 
+  if (oc_mmem_in_arena(m)) {
+    return;
+  }
   if (m->next != NULL) {
     switch (pool_type) {
     case BYTE_POOL:
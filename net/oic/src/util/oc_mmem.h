@@ -54,6 +54,17 @@ int oc_mmem_alloc(struct oc_mmem *m, unsigned int size, pool pool_type);
 void oc_mmem_free(struct oc_mmem *, pool pool_type);
 void oc_mmem_init(void);
 
+/*
+ * Per-request arena.  Between oc_mmem_arena_begin() and oc_mmem_arena_end()
+ * allocations come from the arena (falling back to the pools when it is
+ * full).  Freeing them is a no-op; oc_mmem_arena_release() returns everything
+ * allocated since the matching oc_mmem_arena_mark() in one step.
+ */
+void oc_mmem_arena_begin(void);
+void oc_mmem_arena_end(void);
+unsigned int oc_mmem_arena_mark(void);
+void oc_mmem_arena_release(unsigned int mark);
+
 #ifdef __cplusplus
 }
 #endif
@@ -60,14 +60,18 @@ struct conf_handler {
     int (*ch_commit)(void);
     int (*ch_export)(void (*export_func)(char *name, char *val),
       enum conf_export_tgt tgt);
+    uint8_t ch_dirty;           /* Set since last commit; internal. */
 };
 
 void conf_init(void);
 int conf_register(struct conf_handler *);
 int conf_load(void);
+int conf_load_one(char *name);
 
 int conf_save(void);
 int conf_save_one(const char *name, char *var);
+int conf_save_begin(void);
+int conf_save_commit(void);
 
 void conf_store_init(void);
 
@@ -99,6 +103,7 @@ struct conf_store_itf;
 struct conf_store {
     SLIST_ENTRY(conf_store) cs_next;
     const struct conf_store_itf *cs_itf;
+    uint32_t cs_loc;		/* where the last loaded/saved item is */
 };
 
 #ifdef __cplusplus
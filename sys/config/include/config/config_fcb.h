@@ -33,6 +33,13 @@ struct conf_fcb {
 extern int conf_fcb_src(struct conf_fcb *cf);
 extern int conf_fcb_dst(struct conf_fcb *cf);
 
+/*
+ * Compresses the oldest sector if only the scratch sector is free and the
+ * active one is more than half full, so that conf_save() does not need to. Meant to be called from a background task;
+ * must not run at the same time as a save. Returns 1 if it compressed.
+ */
+extern int conf_fcb_compact(struct conf_fcb *cf);
+
 #ifdef __cplusplus
 }
 #endif
@@ -32,6 +32,16 @@ struct conf_handler_head conf_handlers;
 
 static uint8_t conf_cmd_inited;
 
+#if MYNEWT_VAL(CONFIG_COMMIT_DEBOUNCE_MS) > 0
+static struct os_callout conf_commit_callout;
+
+static void
+conf_commit_ev_cb(struct os_event *ev)
+{
+    conf_commit(NULL);
+}
+#endif
+
 void
 conf_init(void)
 {
@@ -40,6 +50,11 @@ conf_init(void)
     SLIST_INIT(&conf_handlers);
     conf_store_init();
 
+#if MYNEWT_VAL(CONFIG_COMMIT_DEBOUNCE_MS) > 0
+    os_callout_init(&conf_commit_callout, os_eventq_dflt_get(),
+                    conf_commit_ev_cb, NULL);
+#endif
+
     if (conf_cmd_inited) {
         return;
     }
@@ -61,6 +76,8 @@ conf_init(void)
 int
 conf_register(struct conf_handler *handler)
 {
+    /* Every handler gets committed at least once. */
+    handler->ch_dirty = 1;
     SLIST_INSERT_HEAD(&conf_handlers, handler, ch_list);
     return 0;
 }
@@ -233,13 +250,18 @@ conf_set_value(char *name, char *val_str)
     int name_argc;
     char *name_argv[CONF_MAX_DIR_DEPTH];
     struct conf_handler *ch;
+    int rc;
 
     ch = conf_parse_and_lookup(name, &name_argc, name_argv);
     if (!ch) {
         return OS_INVALID_PARM;
     }
 
-    return ch->ch_set(name_argc - 1, &name_argv[1], val_str);
+    rc = ch->ch_set(name_argc - 1, &name_argv[1], val_str);
+    if (rc == 0) {
+        ch->ch_dirty = 1;
+    }
+    return rc;
 }
 
 /*
@@ -263,6 +285,10 @@ conf_get_value(char *name, char *buf, int buf_len)
     return ch->ch_get(name_argc - 1, &name_argv[1], buf, buf_len);
 }
 
+/*
+ * Commits the named handler, or with a NULL name, every handler that has had
+ * a value set since it was last committed.
+ */
 int
 conf_commit(char *name)
 {
@@ -277,14 +303,22 @@ conf_commit(char *name)
         if (!ch) {
             return OS_INVALID_PARM;
         }
+        ch->ch_dirty = 0;
         if (ch->ch_commit) {
             return ch->ch_commit();
         } else {
             return 0;
         }
     } else {
+#if MYNEWT_VAL(CONFIG_COMMIT_DEBOUNCE_MS) > 0
+        os_callout_stop(&conf_commit_callout);
+#endif
         rc = 0;
         SLIST_FOREACH(ch, &conf_handlers, ch_list) {
+            if (!ch->ch_dirty) {
+                continue;
+            }
+            ch->ch_dirty = 0;
             if (ch->ch_commit) {
                 rc2 = ch->ch_commit();
                 if (!rc) {
@@ -295,3 +329,25 @@ conf_commit(char *name)
         return rc;
     }
 }
+
+/*
+ * Commits dirty handlers once no further value has been set for
+ * CONFIG_COMMIT_DEBOUNCE_MS, so that a burst of remote writes results in a
+ * single commit.  Commits right away if debouncing is disabled.
+ */
+int
+conf_commit_debounced(void)
+{
+#if MYNEWT_VAL(CONFIG_COMMIT_DEBOUNCE_MS) > 0
+    os_time_t ticks;
+    int rc;
+
+    rc = os_time_ms_to_ticks(MYNEWT_VAL(CONFIG_COMMIT_DEBOUNCE_MS), &ticks);
+    if (rc) {
+        return rc;
+    }
+    return os_callout_reset(&conf_commit_callout, ticks);
+#else
+    return conf_commit(NULL);
+#endif
+}
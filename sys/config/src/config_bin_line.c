@@ -0,0 +1,191 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(CONFIG_FCB_BINARY)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <tinycbor/cbor.h>
+#include <tinycbor/cbor_buf_writer.h>
+#include <tinycbor/cbor_buf_reader.h>
+#include <base64/base64.h>
+
+#include "config/config.h"
+#include "config_priv.h"
+
+/*
+ * Binary config items are CBOR arrays holding name and value. Values which
+ * are decimal integers are stored as CBOR integers, and ones which are
+ * base64 encoded as byte strings tagged for base64 conversion. Value string
+ * is restored exactly when the item is read back. Empty values are CBOR
+ * null, other values text strings.
+ */
+
+#define CONF_BIN_BYTES_MAX	(CONF_MAX_VAL_LEN / 4 * 3)
+
+static int
+conf_bin_int(const char *val, long *ival)
+{
+    char buf[16];
+    char *eptr;
+
+    *ival = strtol(val, &eptr, 10);
+    if (*eptr != '\0') {
+        return 0;
+    }
+    snprintf(buf, sizeof(buf), "%ld", *ival);
+    return !strcmp(buf, val);
+}
+
+/*
+ * Returns the number of bytes val decodes to, if it is base64 encoded the
+ * same way as conf_str_from_bytes() does. Returns -1 otherwise.
+ */
+static int
+conf_bin_bytes(const char *val, uint8_t *bytes)
+{
+    char grp[5];
+    char enc[5];
+    int len;
+    int off;
+    int cnt;
+    int n;
+
+    len = strlen(val);
+    if (len == 0 || len % 4 || len / 4 * 3 > CONF_BIN_BYTES_MAX) {
+        return -1;
+    }
+    cnt = 0;
+    for (off = 0; off < len; off += 4) {
+        memcpy(grp, val + off, 4);
+        grp[4] = '\0';
+        n = base64_decode(grp, bytes + cnt);
+        if (n <= 0 || (n < 3 && off + 4 < len)) {
+            return -1;
+        }
+        base64_encode(bytes + cnt, n, enc, 1);
+        if (memcmp(enc, grp, 4)) {
+            return -1;
+        }
+        cnt += n;
+    }
+    return cnt;
+}
+
+int
+conf_bin_line_make(uint8_t *dst, int dlen, const char *name,
+                   const char *value)
+{
+    struct CborBufWriter writer;
+    CborEncoder enc;
+    CborEncoder arr;
+    CborError err;
+    uint8_t bytes[CONF_BIN_BYTES_MAX];
+    long ival;
+    int blen;
+
+    cbor_buf_writer_init(&writer, dst, dlen);
+    cbor_encoder_init(&enc, &writer.enc, 0);
+
+    err = cbor_encoder_create_array(&enc, &arr, 2);
+    err |= cbor_encode_text_stringz(&arr, name);
+    if (!value || value[0] == '\0') {
+        err |= cbor_encode_null(&arr);
+    } else if (conf_bin_int(value, &ival)) {
+        err |= cbor_encode_int(&arr, ival);
+    } else if ((blen = conf_bin_bytes(value, bytes)) > 0) {
+        err |= cbor_encode_tag(&arr, CborExpectedBase64Tag);
+        err |= cbor_encode_byte_string(&arr, bytes, blen);
+    } else {
+        err |= cbor_encode_text_stringz(&arr, value);
+    }
+    err |= cbor_encoder_close_container(&enc, &arr);
+    if (err) {
+        return -1;
+    }
+    return cbor_buf_writer_buffer_size(&writer, dst);
+}
+
+int
+conf_bin_line_parse(const uint8_t *src, int slen, char *buf, int blen,
+                    char **namep, char **valp)
+{
+    struct cbor_buf_reader reader;
+    CborParser parser;
+    CborValue it;
+    CborValue arr;
+    CborTag tag;
+    uint8_t bytes[CONF_BIN_BYTES_MAX];
+    int64_t ival;
+    size_t len;
+
+    cbor_buf_reader_init(&reader, src, slen);
+    if (cbor_parser_init(&reader.r, 0, &parser, &it) ||
+        !cbor_value_is_array(&it) ||
+        cbor_value_enter_container(&it, &arr) ||
+        !cbor_value_is_text_string(&arr)) {
+        return -1;
+    }
+    len = blen;
+    if (cbor_value_copy_text_string(&arr, buf, &len, &arr) ||
+        len + 1 >= blen) {
+        return -1;
+    }
+    *namep = buf;
+    buf += len + 1;
+    blen -= len + 1;
+
+    *valp = buf;
+    if (cbor_value_is_null(&arr)) {
+        *valp = NULL;
+    } else if (cbor_value_is_integer(&arr)) {
+        if (cbor_value_get_int64(&arr, &ival)) {
+            return -1;
+        }
+        snprintf(buf, blen, "%ld", (long)ival);
+    } else if (cbor_value_is_tag(&arr)) {
+        if (cbor_value_get_tag(&arr, &tag) ||
+            tag != CborExpectedBase64Tag ||
+            cbor_value_skip_tag(&arr) ||
+            !cbor_value_is_byte_string(&arr)) {
+            return -1;
+        }
+        len = sizeof(bytes);
+        if (cbor_value_copy_byte_string(&arr, bytes, &len, NULL) ||
+            BASE64_ENCODE_SIZE(len) >= blen) {
+            return -1;
+        }
+        base64_encode(bytes, len, buf, 1);
+    } else if (cbor_value_is_text_string(&arr)) {
+        len = blen;
+        if (cbor_value_copy_text_string(&arr, buf, &len, NULL) ||
+            len >= blen) {
+            return -1;
+        }
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+#endif
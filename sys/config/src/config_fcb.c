@@ -32,20 +32,136 @@
 #define CONF_FCB_MAGIC		0xc0ffeeee
 #define CONF_FCB_VERS		1
 
+/*
+ * Transaction markers are 2 byte entries: a zero byte followed by the
+ * marker type. Items between BEGIN and COMMIT are only valid if COMMIT was
+ * written. ABORT closes a transaction cut short by reset.
+ */
+#define CONF_FCB_TXN_BEGIN	'B'
+#define CONF_FCB_TXN_COMMIT	'C'
+#define CONF_FCB_TXN_ABORT	'A'
+
+#define CONF_FCB_TXN_BUF_SIZE	MYNEWT_VAL(CONFIG_FCB_TXN_BUF_SIZE)
+#define CONF_FCB_TXN_MARKER_MAX	24	/* marker with 8 byte alignment */
+
 struct conf_fcb_load_cb_arg {
+    struct conf_fcb *cf;
     load_cb cb;
     void *cb_arg;
 };
 
 static int conf_fcb_load(struct conf_store *, load_cb cb, void *cb_arg);
+static int conf_fcb_load_at(struct conf_store *, uint32_t loc, load_cb cb,
+  void *cb_arg);
 static int conf_fcb_save(struct conf_store *, const char *name,
   const char *value);
+#if CONF_FCB_TXN_BUF_SIZE > 0
+static int conf_fcb_save_start(struct conf_store *);
+static int conf_fcb_save_end(struct conf_store *);
+#endif
+static int conf_fcb_append(struct conf_fcb *cf, char *buf, int len);
 
 static struct conf_store_itf conf_fcb_itf = {
     .csi_load = conf_fcb_load,
+    .csi_load_at = conf_fcb_load_at,
+#if CONF_FCB_TXN_BUF_SIZE > 0
+    .csi_save_start = conf_fcb_save_start,
+    .csi_save_end = conf_fcb_save_end,
+#endif
     .csi_save = conf_fcb_save,
 };
 
+#if CONF_FCB_TXN_BUF_SIZE > 0
+static uint8_t conf_fcb_txn_buf[CONF_FCB_TXN_BUF_SIZE];
+static struct fcb_batch conf_fcb_txn;
+static struct conf_fcb *conf_fcb_txn_cf;
+#endif
+
+/*
+ * Returns marker type of the entry at loc, or 0 if it is not a marker.
+ */
+static int
+conf_fcb_marker(struct fcb_entry *loc)
+{
+    uint8_t buf[2];
+
+    if (loc->fe_data_len != sizeof(buf)) {
+        return 0;
+    }
+    if (flash_area_read(loc->fe_area, loc->fe_data_off, buf, sizeof(buf)) ||
+        buf[0] != 0) {
+        return 0;
+    }
+    return buf[1];
+}
+
+/*
+ * Like fcb_getnext(), but leaves out transaction markers, and items from
+ * transactions which were not committed.
+ */
+static int
+conf_fcb_getnext(struct conf_fcb *cf, struct fcb_entry *loc)
+{
+    struct fcb_entry end;
+    int marker;
+    int rc;
+
+    rc = fcb_getnext(&cf->cf_fcb, loc);
+    while (rc == 0) {
+        marker = conf_fcb_marker(loc);
+        if (!marker) {
+            return 0;
+        }
+        if (marker == CONF_FCB_TXN_BEGIN) {
+            end = *loc;
+            while ((rc = fcb_getnext(&cf->cf_fcb, &end)) == 0) {
+                marker = conf_fcb_marker(&end);
+                if (marker) {
+                    break;
+                }
+            }
+            if (rc) {
+                return rc;
+            }
+            if (marker != CONF_FCB_TXN_COMMIT) {
+                /*
+                 * Skip to the marker which ended this one.
+                 */
+                *loc = end;
+                continue;
+            }
+        }
+        rc = fcb_getnext(&cf->cf_fcb, loc);
+    }
+    return rc;
+}
+
+/*
+ * If the last transaction was cut short by reset, mark it aborted so that
+ * the items written after it are not taken to be part of it.
+ */
+static void
+conf_fcb_txn_close(struct conf_fcb *cf)
+{
+    static const char abort_marker[2] = { 0, CONF_FCB_TXN_ABORT };
+    struct fcb_entry loc;
+    int open;
+    int marker;
+
+    open = 0;
+    loc.fe_area = NULL;
+    loc.fe_elem_off = 0;
+    while (fcb_getnext(&cf->cf_fcb, &loc) == 0) {
+        marker = conf_fcb_marker(&loc);
+        if (marker) {
+            open = (marker == CONF_FCB_TXN_BEGIN);
+        }
+    }
+    if (open) {
+        conf_fcb_append(cf, (char *)abort_marker, sizeof(abort_marker));
+    }
+}
+
 int
 conf_fcb_src(struct conf_fcb *cf)
 {
@@ -72,6 +188,7 @@ conf_fcb_src(struct conf_fcb *cf)
             break;
         }
     }
+    conf_fcb_txn_close(cf);
 
     cf->cf_store.cs_itf = &conf_fcb_itf;
     conf_src_register(&cf->cf_store);
@@ -88,33 +205,71 @@ conf_fcb_dst(struct conf_fcb *cf)
     return OS_OK;
 }
 
+/*
+ * Location of an entry as seen by config store: sector index, and
+ * offset within the sector.
+ */
+static uint32_t
+conf_fcb_loc(struct conf_fcb *cf, struct fcb_entry *loc)
+{
+    return ((loc->fe_area - cf->cf_fcb.f_sectors) << 24) | loc->fe_elem_off;
+}
+
+#define CONF_FCB_BUF_LEN	(CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32)
+
+/*
+ * Reads and parses the entry at loc into buf, which must have room for
+ * CONF_FCB_BUF_LEN bytes. Entries can be text lines, or binary items.
+ */
 static int
-conf_fcb_load_cb(struct fcb_entry *loc, void *arg)
+conf_fcb_var_read(struct fcb_entry *loc, char *buf, char **name, char **val)
 {
-    struct conf_fcb_load_cb_arg *argp;
-    char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
-    char *name_str;
-    char *val_str;
+#if MYNEWT_VAL(CONFIG_FCB_BINARY)
+    uint8_t rec[CONF_FCB_BUF_LEN];
+#endif
     int rc;
     int len;
 
-    argp = (struct conf_fcb_load_cb_arg *)arg;
-
     len = loc->fe_data_len;
-    if (len >= sizeof(buf)) {
-        len = sizeof(buf) - 1;
+    if (len >= CONF_FCB_BUF_LEN) {
+        len = CONF_FCB_BUF_LEN - 1;
     }
-
+#if MYNEWT_VAL(CONFIG_FCB_BINARY)
+    rc = flash_area_read(loc->fe_area, loc->fe_data_off, rec, len);
+    if (rc) {
+        return rc;
+    }
+    if (len > 0 && rec[0] == CONF_BIN_LINE_START) {
+        return conf_bin_line_parse(rec, len, buf, CONF_FCB_BUF_LEN, name, val);
+    }
+    memcpy(buf, rec, len);
+#else
     rc = flash_area_read(loc->fe_area, loc->fe_data_off, buf, len);
     if (rc) {
-        return 0;
+        return rc;
     }
+#endif
     buf[len] = '\0';
+    rc = conf_line_parse(buf, name, val);
+    return rc;
+}
 
-    rc = conf_line_parse(buf, &name_str, &val_str);
+static int
+conf_fcb_load_cb(struct fcb_entry *loc, void *arg)
+{
+    struct conf_fcb_load_cb_arg *argp;
+    char buf[CONF_FCB_BUF_LEN];
+    char *name_str;
+    char *val_str;
+    int rc;
+
+    argp = (struct conf_fcb_load_cb_arg *)arg;
+
+    rc = conf_fcb_var_read(loc, buf, &name_str, &val_str);
     if (rc) {
         return 0;
     }
+    argp->cf->cf_store.cs_loc = conf_fcb_loc(argp->cf, loc);
     argp->cb(name_str, val_str, argp->cb_arg);
     return 0;
 }
@@ -124,93 +279,202 @@ conf_fcb_load(struct conf_store *cs, load_cb cb, void *cb_arg)
 {
     struct conf_fcb *cf = (struct conf_fcb *)cs;
     struct conf_fcb_load_cb_arg arg;
+    struct fcb_entry loc;
     int rc;
 
+    arg.cf = cf;
     arg.cb = cb;
     arg.cb_arg = cb_arg;
-    rc = fcb_walk(&cf->cf_fcb, 0, conf_fcb_load_cb, &arg);
-    if (rc) {
+    loc.fe_area = NULL;
+    loc.fe_elem_off = 0;
+    while ((rc = conf_fcb_getnext(cf, &loc)) == 0) {
+        conf_fcb_load_cb(&loc, &arg);
+    }
+    if (rc != FCB_ERR_NOVAR) {
         return OS_EINVAL;
     }
     return OS_OK;
 }
 
 static int
-conf_fcb_var_read(struct fcb_entry *loc, char *buf, char **name, char **val)
+conf_fcb_load_at(struct conf_store *cs, uint32_t loc, load_cb cb,
+  void *cb_arg)
 {
-    int rc;
+    struct conf_fcb *cf = (struct conf_fcb *)cs;
+    struct conf_fcb_load_cb_arg arg;
+    struct fcb_entry entry;
 
-    rc = flash_area_read(loc->fe_area, loc->fe_data_off, buf, loc->fe_data_len);
-    if (rc) {
-        return rc;
+    if ((loc >> 24) >= cf->cf_fcb.f_sector_cnt) {
+        return OS_EINVAL;
     }
-    buf[loc->fe_data_len] = '\0';
-    rc = conf_line_parse(buf, name, val);
-    return rc;
+    entry.fe_area = &cf->cf_fcb.f_sectors[loc >> 24];
+    entry.fe_elem_off = loc & 0xffffff;
+    if (fcb_elem_info(&cf->cf_fcb, &entry)) {
+        return OS_EINVAL;
+    }
+    arg.cf = cf;
+    arg.cb = cb;
+    arg.cb_arg = cb_arg;
+    conf_fcb_load_cb(&entry, &arg);
+    return OS_OK;
+}
+
+/*
+ * Entries of the oldest sector that are being considered for copying during
+ * compression. Slots with the same name hash are chained from a bucket.
+ */
+struct conf_fcb_slot {
+    struct fcb_entry cfs_loc;
+    uint32_t cfs_hash;
+    int16_t cfs_next;
+    uint8_t cfs_live;
+};
+
+#define CONF_FCB_SLOTS	MYNEWT_VAL(CONFIG_FCB_COMPRESS_ENTRIES)
+
+static struct conf_fcb_slot conf_fcb_slots[CONF_FCB_SLOTS];
+static int16_t conf_fcb_buckets[CONF_FCB_SLOTS];
+
+/*
+ * Returns the live slot for name, if any. Names are compared by reading
+ * the slot's entry, which only happens when hashes match.
+ */
+static struct conf_fcb_slot *
+conf_fcb_slot_find(uint32_t hash, const char *name, char *buf)
+{
+    struct conf_fcb_slot *slot;
+    char *name2, *val2;
+    int i;
+
+    for (i = conf_fcb_buckets[hash % CONF_FCB_SLOTS]; i >= 0;
+         i = slot->cfs_next) {
+        slot = &conf_fcb_slots[i];
+        if (!slot->cfs_live || slot->cfs_hash != hash) {
+            continue;
+        }
+        if (conf_fcb_var_read(&slot->cfs_loc, buf, &name2, &val2)) {
+            continue;
+        }
+        if (!strcmp(name, name2)) {
+            return slot;
+        }
+    }
+    return NULL;
 }
 
+/*
+ * Copies entries from the oldest sector which are not overwritten by later
+ * ones, and then rotates the FCB. The oldest sector is processed in rounds
+ * of up to CONFIG_FCB_COMPRESS_ENTRIES entries; each round reads through
+ * the rest of the FCB once, dropping entries whose name shows up again.
+ */
 static void
 conf_fcb_compress(struct conf_fcb *cf)
 {
     int rc;
-    char buf1[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
-    char buf2[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
+    char buf1[CONF_FCB_BUF_LEN];
+    char buf2[CONF_FCB_BUF_LEN];
+    struct fcb_entry start;
     struct fcb_entry loc1;
     struct fcb_entry loc2;
+    struct conf_fcb_slot *slot;
     char *name1, *val1;
-    char *name2, *val2;
-    int copy;
+    uint32_t hash;
+    int more;
+    int cnt;
+    int len;
+    int i;
 
     rc = fcb_append_to_scratch(&cf->cf_fcb);
     if (rc) {
         return; /* XXX */
     }
 
-    loc1.fe_area = NULL;
-    loc1.fe_elem_off = 0;
-    while (fcb_getnext(&cf->cf_fcb, &loc1) == 0) {
-        if (loc1.fe_area != cf->cf_fcb.f_oldest) {
-            break;
-        }
-        rc = conf_fcb_var_read(&loc1, buf1, &name1, &val1);
-        if (rc) {
-            continue;
-        }
-        loc2 = loc1;
-        copy = 1;
-        while (fcb_getnext(&cf->cf_fcb, &loc2) == 0) {
-            rc = conf_fcb_var_read(&loc2, buf2, &name2, &val2);
-            if (rc) {
+    start.fe_area = NULL;
+    start.fe_elem_off = 0;
+    do {
+        memset(conf_fcb_buckets, 0xff, sizeof(conf_fcb_buckets));
+        cnt = 0;
+
+        loc1 = start;
+        while ((rc = conf_fcb_getnext(cf, &loc1)) == 0) {
+            if (loc1.fe_area != cf->cf_fcb.f_oldest || cnt == CONF_FCB_SLOTS) {
+                break;
+            }
+            start = loc1;
+            if (conf_fcb_var_read(&loc1, buf1, &name1, &val1)) {
                 continue;
             }
-            if (!strcmp(name1, name2)) {
-                copy = 0;
-                break;
+            hash = conf_name_hash(name1, strlen(name1));
+            slot = conf_fcb_slot_find(hash, name1, buf2);
+            if (slot) {
+                slot->cfs_live = 0;
             }
+            slot = &conf_fcb_slots[cnt];
+            slot->cfs_loc = loc1;
+            slot->cfs_hash = hash;
+            slot->cfs_live = 1;
+            slot->cfs_next = conf_fcb_buckets[hash % CONF_FCB_SLOTS];
+            conf_fcb_buckets[hash % CONF_FCB_SLOTS] = cnt;
+            cnt++;
         }
-        if (!copy) {
-            continue;
-        }
+        more = (rc == 0 && loc1.fe_area == cf->cf_fcb.f_oldest);
 
         /*
-         * Can't find one. Must copy.
+         * Drop the ones which are overwritten later.
          */
-        rc = flash_area_read(loc1.fe_area, loc1.fe_data_off, buf1,
-          loc1.fe_data_len);
-        if (rc) {
-            continue;
-        }
-        rc = fcb_append(&cf->cf_fcb, loc1.fe_data_len, &loc2);
-        if (rc) {
-            continue;
+        while (cnt && rc == 0) {
+            if (!conf_fcb_var_read(&loc1, buf1, &name1, &val1)) {
+                hash = conf_name_hash(name1, strlen(name1));
+                slot = conf_fcb_slot_find(hash, name1, buf2);
+                if (slot) {
+                    slot->cfs_live = 0;
+                }
+            }
+            rc = conf_fcb_getnext(cf, &loc1);
         }
-        rc = flash_area_write(loc2.fe_area, loc2.fe_data_off, buf1,
-          loc1.fe_data_len);
-        if (rc) {
-            continue;
+
+        /*
+         * Copy the rest.
+         */
+        for (i = 0; i < cnt; i++) {
+            slot = &conf_fcb_slots[i];
+            if (!slot->cfs_live) {
+                continue;
+            }
+#if MYNEWT_VAL(CONFIG_FCB_BINARY)
+            /*
+             * Text lines get converted while being copied.
+             */
+            if (conf_fcb_var_read(&slot->cfs_loc, buf2, &name1, &val1)) {
+                continue;
+            }
+            len = conf_bin_line_make((uint8_t *)buf1, sizeof(buf1), name1,
+              val1);
+            if (len < 0) {
+                continue;
+            }
+#else
+            len = slot->cfs_loc.fe_data_len;
+            rc = flash_area_read(slot->cfs_loc.fe_area,
+              slot->cfs_loc.fe_data_off, buf1, len);
+            if (rc) {
+                continue;
+            }
+#endif
+            rc = fcb_append(&cf->cf_fcb, len, &loc2);
+            if (rc) {
+                continue;
+            }
+            rc = flash_area_write(loc2.fe_area, loc2.fe_data_off, buf1, len);
+            if (rc) {
+                continue;
+            }
+            fcb_append_finish(&cf->cf_fcb, &loc2);
         }
-        fcb_append_finish(&cf->cf_fcb, &loc2);
-    }
+    } while (more);
+
+    conf_index_reset(&cf->cf_store);
     rc = fcb_rotate(&cf->cf_fcb);
     if (rc) {
         /* XXXX */
@@ -218,6 +482,20 @@ conf_fcb_compress(struct conf_fcb *cf)
     }
 }
 
+int
+conf_fcb_compact(struct conf_fcb *cf)
+{
+    struct fcb_entry *active;
+
+    active = &cf->cf_fcb.f_active;
+    if (fcb_free_sector_cnt(&cf->cf_fcb) > cf->cf_fcb.f_scratch_cnt ||
+        active->fe_elem_off < active->fe_area->fa_size / 2) {
+        return 0;
+    }
+    conf_fcb_compress(cf);
+    return 1;
+}
+
 static int
 conf_fcb_append(struct conf_fcb *cf, char *buf, int len)
 {
@@ -240,24 +518,139 @@ conf_fcb_append(struct conf_fcb *cf, char *buf, int len)
         return OS_EINVAL;
     }
     fcb_append_finish(&cf->cf_fcb, &loc);
+    cf->cf_store.cs_loc = conf_fcb_loc(cf, &loc);
     return OS_OK;
 }
 
+#if CONF_FCB_TXN_BUF_SIZE > 0
+static int
+conf_fcb_txn_marker(struct conf_fcb *cf, int type)
+{
+    uint8_t marker[2] = { 0, type };
+
+    return fcb_batch_add(&cf->cf_fcb, &conf_fcb_txn, marker, sizeof(marker));
+}
+
+/*
+ * Starts a new batch with BEGIN marker. Room for COMMIT marker is held
+ * back from the items.
+ */
+static int
+conf_fcb_txn_begin(struct conf_fcb *cf)
+{
+    fcb_batch_init(&conf_fcb_txn, conf_fcb_txn_buf,
+      sizeof(conf_fcb_txn_buf) - CONF_FCB_TXN_MARKER_MAX);
+    return conf_fcb_txn_marker(cf, CONF_FCB_TXN_BEGIN);
+}
+
+/*
+ * Writes staged items followed by COMMIT marker.
+ */
+static int
+conf_fcb_txn_write(struct conf_fcb *cf)
+{
+    int rc;
+    int i;
+
+    if (conf_fcb_txn.fb_cnt <= 1) {
+        /*
+         * Nothing besides BEGIN.
+         */
+        return 0;
+    }
+    conf_fcb_txn.fb_buf_sz = sizeof(conf_fcb_txn_buf);
+    rc = conf_fcb_txn_marker(cf, CONF_FCB_TXN_COMMIT);
+    if (rc) {
+        return OS_ENOMEM;
+    }
+    for (i = 0; i < 10; i++) {
+        rc = fcb_batch_write(&cf->cf_fcb, &conf_fcb_txn);
+        if (rc != FCB_ERR_NOSPACE) {
+            break;
+        }
+        conf_fcb_compress(cf);
+    }
+    conf_index_reset(&cf->cf_store);
+    if (rc) {
+        return OS_EINVAL;
+    }
+    return 0;
+}
+
+/*
+ * Stages an item. If the staging buffer fills up, what has been staged is
+ * committed, and the transaction continues in a new batch.
+ */
+static int
+conf_fcb_txn_add(struct conf_fcb *cf, char *buf, int len)
+{
+    int rc;
+
+    cf->cf_store.cs_loc = CONF_LOC_NONE;
+    rc = fcb_batch_add(&cf->cf_fcb, &conf_fcb_txn, buf, len);
+    if (rc == 0) {
+        return 0;
+    }
+    if (rc != FCB_ERR_NOMEM) {
+        return OS_EINVAL;
+    }
+    rc = conf_fcb_txn_write(cf);
+    if (conf_fcb_txn_begin(cf) ||
+        fcb_batch_add(&cf->cf_fcb, &conf_fcb_txn, buf, len)) {
+        return OS_ENOMEM;
+    }
+    return rc;
+}
+
+static int
+conf_fcb_save_start(struct conf_store *cs)
+{
+    struct conf_fcb *cf = (struct conf_fcb *)cs;
+
+    if (conf_fcb_txn_begin(cf)) {
+        return OS_ENOMEM;
+    }
+    conf_fcb_txn_cf = cf;
+    return 0;
+}
+
+static int
+conf_fcb_save_end(struct conf_store *cs)
+{
+    struct conf_fcb *cf = (struct conf_fcb *)cs;
+
+    if (conf_fcb_txn_cf != cf) {
+        return 0;
+    }
+    conf_fcb_txn_cf = NULL;
+    return conf_fcb_txn_write(cf);
+}
+#endif
+
 static int
 conf_fcb_save(struct conf_store *cs, const char *name, const char *value)
 {
     struct conf_fcb *cf = (struct conf_fcb *)cs;
-    char buf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
+    char buf[CONF_FCB_BUF_LEN];
     int len;
 
     if (!name) {
         return OS_INVALID_PARM;
     }
 
+#if MYNEWT_VAL(CONFIG_FCB_BINARY)
+    len = conf_bin_line_make((uint8_t *)buf, sizeof(buf), name, value);
+#else
     len = conf_line_make(buf, sizeof(buf), name, value);
+#endif
     if (len < 0 || len + 2 > sizeof(buf)) {
         return OS_INVALID_PARM;
     }
+#if CONF_FCB_TXN_BUF_SIZE > 0
+    if (conf_fcb_txn_cf == cf) {
+        return conf_fcb_txn_add(cf, buf, len);
+    }
+#endif
     return conf_fcb_append(cf, buf, len);
 }
 
@@ -32,11 +32,14 @@
 #include "config_priv.h"
 
 static int conf_file_load(struct conf_store *, load_cb cb, void *cb_arg);
+static int conf_file_load_at(struct conf_store *, uint32_t loc, load_cb cb,
+  void *cb_arg);
 static int conf_file_save(struct conf_store *, const char *name,
   const char *value);
 
 static struct conf_store_itf conf_file_itf = {
     .csi_load = conf_file_load,
+    .csi_load_at = conf_file_load_at,
     .csi_save = conf_file_save,
 };
 
@@ -124,6 +127,7 @@ conf_file_load(struct conf_store *cs, load_cb cb, void *cb_arg)
     loc = 0;
     lines = 0;
     while (1) {
+        cs->cs_loc = loc;
         rc = conf_getnext_line(file, tmpbuf, sizeof(tmpbuf), &loc);
         if (loc == 0) {
             break;
@@ -143,6 +147,40 @@ conf_file_load(struct conf_store *cs, load_cb cb, void *cb_arg)
     return OS_OK;
 }
 
+/*
+ * Loads the configuration item on the line starting at file offset loc.
+ */
+static int
+conf_file_load_at(struct conf_store *cs, uint32_t loc, load_cb cb,
+  void *cb_arg)
+{
+    struct conf_file *cf = (struct conf_file *)cs;
+    struct fs_file *file;
+    char tmpbuf[CONF_MAX_NAME_LEN + CONF_MAX_VAL_LEN + 32];
+    char *name_str;
+    char *val_str;
+    uint32_t off;
+    int rc;
+
+    rc = fs_open(cf->cf_name, FS_ACCESS_READ, &file);
+    if (rc != FS_EOK) {
+        return OS_EINVAL;
+    }
+    off = loc;
+    rc = conf_getnext_line(file, tmpbuf, sizeof(tmpbuf), &off);
+    fs_close(file);
+    if (off == 0 || rc < 0) {
+        return OS_EINVAL;
+    }
+    rc = conf_line_parse(tmpbuf, &name_str, &val_str);
+    if (rc != 0) {
+        return OS_EINVAL;
+    }
+    cs->cs_loc = loc;
+    cb(name_str, val_str, cb_arg);
+    return OS_OK;
+}
+
 static void
 conf_tmpfile(char *dst, const char *src, char *pfx)
 {
@@ -187,6 +225,8 @@ conf_file_compress(struct conf_file *cf)
         return;
     }
 
+    conf_index_reset(&cf->cf_store);
+
     loc1 = 0;
     lines = 0;
     while (1) {
@@ -270,7 +310,7 @@ conf_file_save(struct conf_store *cs, const char *name, const char *value)
     if (fs_open(cf->cf_name, FS_ACCESS_WRITE | FS_ACCESS_APPEND, &file)) {
         return OS_EINVAL;
     }
-    if (fs_write(file, buf, len)) {
+    if (fs_filelen(file, &cs->cs_loc) || fs_write(file, buf, len)) {
         rc = OS_EINVAL;
     } else {
         rc = 0;
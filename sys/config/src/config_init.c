@@ -18,6 +18,7 @@
  */
 
 #include <assert.h>
+#include <stddef.h>
 
 #include "sysinit/sysinit.h"
 #include "syscfg/syscfg.h"
@@ -91,14 +92,53 @@ config_init_fcb(void)
 
 #endif
 
+#if MYNEWT_VAL(CONFIG_LOAD_ASYNC)
+static const char * const config_load_deps[] = { "nffs", NULL };
+
+static int
+config_load_async(void *arg)
+{
+    uint32_t mark;
+
+    mark = SYSINIT_PROFILE_MARK();
+
+#if MYNEWT_VAL(CONFIG_NFFS)
+    config_init_fs();
+#endif
+    conf_load();
+
+    SYSINIT_PROFILE_RECORD("conf_load", mark);
+
+    return 0;
+}
+
+static struct sysinit_job config_load_job = {
+    .sj_name = "config",
+    .sj_fn = config_load_async,
+    .sj_deps = config_load_deps,
+};
+#endif
+
 void
 config_pkg_init(void)
 {
+#if MYNEWT_VAL(CONFIG_LOAD_ASYNC)
+    int rc;
+#endif
+
     conf_init();
 
+#if MYNEWT_VAL(CONFIG_LOAD_ASYNC)
+#if MYNEWT_VAL(CONFIG_FCB)
+    config_init_fcb();
+#endif
+    rc = sysinit_defer(&config_load_job);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#else
 #if MYNEWT_VAL(CONFIG_NFFS)
     config_init_fs();
 #elif MYNEWT_VAL(CONFIG_FCB)
     config_init_fcb();
 #endif
+#endif
 }
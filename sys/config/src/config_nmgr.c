@@ -101,7 +101,7 @@ conf_nmgr_write(struct mgmt_cbuf *cb)
         return MGMT_ERR_EINVAL;
     }
 
-    rc = conf_commit(NULL);
+    rc = conf_commit_debounced();
     if (rc) {
         return MGMT_ERR_EINVAL;
     }
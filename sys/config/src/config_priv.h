@@ -26,6 +26,7 @@ extern "C" {
 
 int conf_cli_register(void);
 int conf_nmgr_register(void);
+int conf_commit_debounced(void);
 
 struct mgmt_cbuf;
 int
@@ -35,12 +36,30 @@ int conf_line_parse(char *buf, char **namep, char **valp);
 int conf_line_make(char *dst, int dlen, const char *name, const char *val);
 int conf_line_make2(char *dst, int dlen, const char *name, const char *value);
 
+#define CONF_BIN_LINE_START	0x82	/* CBOR array of 2 items */
+int conf_bin_line_make(uint8_t *dst, int dlen, const char *name,
+  const char *value);
+int conf_bin_line_parse(const uint8_t *src, int slen, char *buf, int blen,
+  char **namep, char **valp);
+
+uint32_t conf_name_hash(const char *name, int len);
+
+#define CONF_LOC_NONE		0xffffffff
+
 /*
  * API for config storage.
+ *
+ * csi_load and csi_save set cs_loc to the location of the item passed to
+ * the callback, or written, within the store. csi_save sets it to
+ * CONF_LOC_NONE if the item is not written yet. If csi_load_at is given,
+ * it calls cb for the single item at such location; this lets the store
+ * be indexed. A store must call conf_index_reset() when items move.
  */
 typedef void (*load_cb)(char *name, char *val, void *cb_arg);
 struct conf_store_itf {
     int (*csi_load)(struct conf_store *cs, load_cb cb, void *cb_arg);
+    int (*csi_load_at)(struct conf_store *cs, uint32_t loc, load_cb cb,
+      void *cb_arg);
     int (*csi_save_start)(struct conf_store *cs);
     int (*csi_save)(struct conf_store *cs, const char *name, const char *value);
     int (*csi_save_end)(struct conf_store *cs);
@@ -48,6 +67,7 @@ struct conf_store_itf {
 
 void conf_src_register(struct conf_store *cs);
 void conf_dst_register(struct conf_store *cs);
+void conf_index_reset(struct conf_store *cs);
 
 SLIST_HEAD(conf_store_head, conf_store);
 extern struct conf_store_head conf_load_srcs;
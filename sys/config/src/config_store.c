@@ -22,6 +22,7 @@
 
 #include <os/os.h>
 
+#include "syscfg/syscfg.h"
 #include "config/config.h"
 #include "config_priv.h"
 
@@ -33,6 +34,270 @@ struct conf_dup_check_arg {
 
 struct conf_store_head conf_load_srcs;
 struct conf_store *conf_save_dst;
+static int conf_save_depth;
+
+#define CONF_INDEX_SIZE		MYNEWT_VAL(CONFIG_INDEX_ENTRIES)
+#define CONF_INDEX_EMPTY	CONF_LOC_NONE
+
+#if CONF_INDEX_SIZE > 0
+/*
+ * Open addressed hash table of items in conf_index_cs. An item is found by
+ * the hash of its name; the name itself is checked by loading the item.
+ */
+struct conf_index_entry {
+    uint32_t cie_name_hash;
+    uint32_t cie_sub_hash;	/* hash of the first element of name */
+    uint32_t cie_loc;
+};
+
+struct conf_index_match_arg {
+    const char *name;
+    int match;
+    load_cb cb;
+    void *cb_arg;
+};
+
+struct conf_index_build_arg {
+    struct conf_store *cs;
+    int ok;
+    load_cb cb;
+    void *cb_arg;
+};
+
+static struct conf_index_entry conf_index[CONF_INDEX_SIZE];
+static int conf_index_cnt;
+static struct conf_store *conf_index_cs;
+#endif
+
+struct conf_load_one_arg {
+    char *name;
+    int len;
+};
+
+/*
+ * FNV-1a hash of at most len characters of name.
+ */
+uint32_t
+conf_name_hash(const char *name, int len)
+{
+    uint32_t hash;
+
+    hash = 2166136261u;
+    while (len-- > 0 && *name) {
+        hash ^= (uint8_t)*name++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int
+conf_subtree_len(const char *name)
+{
+    return strcspn(name, CONF_NAME_SEPARATOR);
+}
+
+#if CONF_INDEX_SIZE > 0
+static void
+conf_index_match_cb(char *name, char *val, void *cb_arg)
+{
+    struct conf_index_match_arg *cima = (struct conf_index_match_arg *)cb_arg;
+
+    if (strcmp(name, cima->name)) {
+        return;
+    }
+    cima->match = 1;
+    if (cima->cb) {
+        cima->cb(name, val, cima->cb_arg);
+    }
+}
+
+/*
+ * Returns the slot for name, or the empty slot where it would go. If the
+ * name is found, its item is passed to cb.
+ */
+static int
+conf_index_find(struct conf_store *cs, const char *name, uint32_t hash,
+                load_cb cb, void *cb_arg, int *found)
+{
+    struct conf_index_match_arg cima;
+    struct conf_index_entry *cie;
+    int i;
+
+    *found = 0;
+    for (i = hash % CONF_INDEX_SIZE; ; i = (i + 1) % CONF_INDEX_SIZE) {
+        cie = &conf_index[i];
+        if (cie->cie_loc == CONF_INDEX_EMPTY) {
+            return i;
+        }
+        if (cie->cie_name_hash != hash) {
+            continue;
+        }
+        cima.name = name;
+        cima.match = 0;
+        cima.cb = cb;
+        cima.cb_arg = cb_arg;
+        cs->cs_itf->csi_load_at(cs, cie->cie_loc, conf_index_match_cb, &cima);
+        if (cima.match) {
+            *found = 1;
+            return i;
+        }
+    }
+}
+
+/*
+ * Record that the latest value for name is at loc.
+ */
+static int
+conf_index_add(struct conf_store *cs, const char *name, uint32_t loc)
+{
+    struct conf_index_entry *cie;
+    uint32_t hash;
+    int found;
+    int i;
+
+    hash = conf_name_hash(name, strlen(name));
+    i = conf_index_find(cs, name, hash, NULL, NULL, &found);
+    cie = &conf_index[i];
+    if (!found) {
+        /*
+         * Keep one slot empty to terminate searches.
+         */
+        if (conf_index_cnt + 1 >= CONF_INDEX_SIZE) {
+            return -1;
+        }
+        conf_index_cnt++;
+        cie->cie_name_hash = hash;
+        cie->cie_sub_hash = conf_name_hash(name, conf_subtree_len(name));
+    }
+    cie->cie_loc = loc;
+    return 0;
+}
+
+static void
+conf_index_build_cb(char *name, char *val, void *cb_arg)
+{
+    struct conf_index_build_arg *ciba = (struct conf_index_build_arg *)cb_arg;
+
+    if (ciba->ok && conf_index_add(ciba->cs, name, ciba->cs->cs_loc)) {
+        ciba->ok = 0;
+    }
+    if (ciba->cb) {
+        ciba->cb(name, val, ciba->cb_arg);
+    }
+}
+
+static int
+conf_index_valid(struct conf_store *cs)
+{
+    return cs && conf_index_cs == cs;
+}
+
+void
+conf_index_reset(struct conf_store *cs)
+{
+    if (conf_index_cs == cs) {
+        conf_index_cs = NULL;
+    }
+}
+
+static void
+conf_index_load(struct conf_store *cs, const char *name, load_cb cb,
+                void *cb_arg)
+{
+    int found;
+
+    conf_index_find(cs, name, conf_name_hash(name, strlen(name)), cb, cb_arg,
+      &found);
+}
+
+static void
+conf_index_load_subtree(struct conf_store *cs, const char *name, int len,
+                        load_cb cb, void *cb_arg)
+{
+    uint32_t hash;
+    int i;
+
+    hash = conf_name_hash(name, len);
+    for (i = 0; i < CONF_INDEX_SIZE; i++) {
+        if (conf_index[i].cie_loc != CONF_INDEX_EMPTY &&
+            conf_index[i].cie_sub_hash == hash) {
+            cs->cs_itf->csi_load_at(cs, conf_index[i].cie_loc, cb, cb_arg);
+        }
+    }
+}
+
+static void
+conf_index_saved(struct conf_store *cs, const char *name)
+{
+    /*
+     * Item not written yet; store resets the index when it is.
+     */
+    if (cs->cs_loc == CONF_LOC_NONE) {
+        return;
+    }
+    if (conf_index_valid(cs) && conf_index_add(cs, name, cs->cs_loc)) {
+        conf_index_reset(cs);
+    }
+}
+#else
+static int
+conf_index_valid(struct conf_store *cs)
+{
+    return 0;
+}
+
+void
+conf_index_reset(struct conf_store *cs)
+{
+}
+
+static void
+conf_index_load(struct conf_store *cs, const char *name, load_cb cb,
+                void *cb_arg)
+{
+}
+
+static void
+conf_index_load_subtree(struct conf_store *cs, const char *name, int len,
+                        load_cb cb, void *cb_arg)
+{
+}
+
+static void
+conf_index_saved(struct conf_store *cs, const char *name)
+{
+}
+#endif
+
+/*
+ * Load all items from cs. The index is rebuilt on the way if cs is the
+ * save destination.
+ */
+static int
+conf_store_load(struct conf_store *cs, load_cb cb, void *cb_arg)
+{
+#if CONF_INDEX_SIZE > 0
+    struct conf_index_build_arg ciba;
+    int rc;
+
+    if (cs == conf_save_dst && cs->cs_itf->csi_load_at) {
+        memset(conf_index, 0xff, sizeof(conf_index));
+        conf_index_cnt = 0;
+        conf_index_cs = NULL;
+
+        ciba.cs = cs;
+        ciba.ok = 1;
+        ciba.cb = cb;
+        ciba.cb_arg = cb_arg;
+        rc = cs->cs_itf->csi_load(cs, conf_index_build_cb, &ciba);
+        if (!rc && ciba.ok) {
+            conf_index_cs = cs;
+        }
+        return rc;
+    }
+#endif
+    return cs->cs_itf->csi_load(cs, cb, cb_arg);
+}
 
 void
 conf_src_register(struct conf_store *cs)
@@ -75,11 +340,46 @@ conf_load(void)
      */
 
     SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
-        cs->cs_itf->csi_load(cs, conf_load_cb, NULL);
+        conf_store_load(cs, conf_load_cb, NULL);
     }
     return conf_commit(NULL);
 }
 
+static void
+conf_load_one_cb(char *name, char *val, void *cb_arg)
+{
+    struct conf_load_one_arg *cloa = (struct conf_load_one_arg *)cb_arg;
+
+    if (conf_subtree_len(name) == cloa->len &&
+        !strncmp(name, cloa->name, cloa->len)) {
+        conf_set_value(name, val);
+    }
+}
+
+/*
+ * Load and commit only the items of one subsystem. If the index covers the
+ * only config source, just those items are read.
+ */
+int
+conf_load_one(char *name)
+{
+    struct conf_load_one_arg cloa;
+    struct conf_store *cs;
+
+    cloa.name = name;
+    cloa.len = strlen(name);
+
+    cs = SLIST_FIRST(&conf_load_srcs);
+    if (cs && !SLIST_NEXT(cs, cs_next) && conf_index_valid(cs)) {
+        conf_index_load_subtree(cs, name, cloa.len, conf_load_one_cb, &cloa);
+    } else {
+        SLIST_FOREACH(cs, &conf_load_srcs, cs_next) {
+            conf_store_load(cs, conf_load_one_cb, &cloa);
+        }
+    }
+    return conf_commit(name);
+}
+
 static void
 conf_dup_check_cb(char *name, char *val, void *cb_arg)
 {
@@ -111,6 +411,7 @@ conf_save_one(const char *name, char *value)
 {
     struct conf_store *cs;
     struct conf_dup_check_arg cdca;
+    int rc;
 
     cs = conf_save_dst;
     if (!cs) {
@@ -123,11 +424,19 @@ conf_save_one(const char *name, char *value)
     cdca.name = name;
     cdca.val = value;
     cdca.is_dup = 0;
-    cs->cs_itf->csi_load(cs, conf_dup_check_cb, &cdca);
+    if (conf_index_valid(cs)) {
+        conf_index_load(cs, name, conf_dup_check_cb, &cdca);
+    } else {
+        conf_store_load(cs, conf_dup_check_cb, &cdca);
+    }
     if (cdca.is_dup == 1) {
         return 0;
     }
-    return cs->cs_itf->csi_save(cs, name, value);
+    rc = cs->cs_itf->csi_save(cs, name, value);
+    if (!rc) {
+        conf_index_saved(cs, name);
+    }
+    return rc;
 }
 
 /*
@@ -140,6 +449,45 @@ conf_store_one(char *name, char *value)
     conf_save_one(name, value);
 }
 
+/*
+ * Values saved between conf_save_begin() and conf_save_commit() are
+ * persisted together, if the store supports it. Calls can be nested; the
+ * outermost commit writes. A name should be saved at most once within one
+ * transaction.
+ */
+int
+conf_save_begin(void)
+{
+    struct conf_store *cs;
+
+    cs = conf_save_dst;
+    if (!cs) {
+        return OS_ENOENT;
+    }
+    if (conf_save_depth++ == 0 && cs->cs_itf->csi_save_start) {
+        return cs->cs_itf->csi_save_start(cs);
+    }
+    return 0;
+}
+
+int
+conf_save_commit(void)
+{
+    struct conf_store *cs;
+
+    cs = conf_save_dst;
+    if (!cs) {
+        return OS_ENOENT;
+    }
+    if (conf_save_depth == 0) {
+        return OS_EINVAL;
+    }
+    if (--conf_save_depth == 0 && cs->cs_itf->csi_save_end) {
+        return cs->cs_itf->csi_save_end(cs);
+    }
+    return 0;
+}
+
 int
 conf_save(void)
 {
@@ -153,9 +501,7 @@ conf_save(void)
         return OS_ENOENT;
     }
 
-    if (cs->cs_itf->csi_save_start) {
-        cs->cs_itf->csi_save_start(cs);
-    }
+    conf_save_begin();
     rc = 0;
     SLIST_FOREACH(ch, &conf_handlers, ch_list) {
         if (ch->ch_export) {
@@ -165,8 +511,9 @@ conf_save(void)
             }
         }
     }
-    if (cs->cs_itf->csi_save_end) {
-        cs->cs_itf->csi_save_end(cs);
+    rc2 = conf_save_commit();
+    if (!rc) {
+        rc = rc2;
     }
     return rc;
 }
@@ -313,6 +313,14 @@ TEST_CASE_DECL(config_test_save_2_fcb)
 TEST_CASE_DECL(config_test_insert3)
 TEST_CASE_DECL(config_test_save_3_fcb)
 TEST_CASE_DECL(config_test_compress_reset)
+TEST_CASE_DECL(config_test_compress_fcb)
+TEST_CASE_DECL(config_test_index_fcb)
+#if MYNEWT_VAL(CONFIG_FCB_BINARY)
+TEST_CASE_DECL(config_test_binary_fcb)
+#endif
+#if MYNEWT_VAL(CONFIG_FCB_TXN_BUF_SIZE) > 0
+TEST_CASE_DECL(config_test_txn_fcb)
+#endif
 TEST_CASE_DECL(config_test_save_one_fcb)
 
 TEST_SUITE(config_test_all)
@@ -342,6 +350,16 @@ TEST_SUITE(config_test_all)
     config_test_save_3_fcb();
 
     config_test_compress_reset();
+    config_test_compress_fcb();
+    config_test_index_fcb();
+
+#if MYNEWT_VAL(CONFIG_FCB_BINARY)
+    config_test_binary_fcb();
+#endif
+
+#if MYNEWT_VAL(CONFIG_FCB_TXN_BUF_SIZE) > 0
+    config_test_txn_fcb();
+#endif
 
     config_test_save_one_fcb();
 }
@@ -0,0 +1,121 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_fcb.h"
+
+#if MYNEWT_VAL(CONFIG_FCB_BINARY)
+
+struct config_test_binary_val {
+    char *name;
+    char *val;
+    int found;
+};
+
+static struct config_test_binary_val config_test_binary_vals[] = {
+    { "bin/int", "-1234" },
+    { "bin/zero", "0" },
+    { "bin/notint", "0123" },
+    { "bin/big", "99999999999999999999" },
+    { "bin/bytes", "AAECAwQFBgcICQoLDA0ODw==" },
+    { "bin/bytes2", "/w==" },
+    { "bin/notbytes", "YQ=a" },
+    { "bin/str", "some text" },
+    { "bin/empty", "" },
+    { NULL }
+};
+
+static void
+config_test_binary_cb(char *name, char *val, void *cb_arg)
+{
+    struct config_test_binary_val *ctbv;
+
+    for (ctbv = config_test_binary_vals; ctbv->name; ctbv++) {
+        if (!strcmp(name, ctbv->name)) {
+            if (ctbv->val[0] == '\0') {
+                TEST_ASSERT(val == NULL);
+            } else {
+                TEST_ASSERT(val && !strcmp(val, ctbv->val));
+            }
+            ctbv->found++;
+        }
+    }
+}
+
+TEST_CASE(config_test_binary_fcb)
+{
+    int rc;
+    struct conf_fcb cf;
+    struct fcb_entry loc;
+    struct config_test_binary_val *ctbv;
+    char *old = "myfoo/mybar=7";
+    uint32_t off;
+
+    config_wipe_srcs();
+    config_wipe_fcb(fcb_areas, sizeof(fcb_areas) / sizeof(fcb_areas[0]));
+
+    memset(&cf, 0, sizeof(cf));
+    cf.cf_fcb.f_sectors = fcb_areas;
+    cf.cf_fcb.f_sector_cnt = sizeof(fcb_areas) / sizeof(fcb_areas[0]);
+
+    rc = conf_fcb_src(&cf);
+    TEST_ASSERT(rc == 0);
+
+    rc = conf_fcb_dst(&cf);
+    TEST_ASSERT(rc == 0);
+
+    /*
+     * Text entries, as written before, are still read.
+     */
+    rc = fcb_append(&cf.cf_fcb, strlen(old), &loc);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_write(loc.fe_area, loc.fe_data_off, old, strlen(old));
+    TEST_ASSERT(rc == 0);
+    rc = fcb_append_finish(&cf.cf_fcb, &loc);
+    TEST_ASSERT(rc == 0);
+
+    val8 = 0;
+    rc = conf_load();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(val8 == 7);
+
+    /*
+     * Values come back as they were saved.
+     */
+    for (ctbv = config_test_binary_vals; ctbv->name; ctbv++) {
+        rc = conf_save_one(ctbv->name, ctbv->val);
+        TEST_ASSERT(rc == 0);
+        ctbv->found = 0;
+    }
+    rc = cf.cf_store.cs_itf->csi_load(&cf.cf_store, config_test_binary_cb,
+      NULL);
+    TEST_ASSERT(rc == 0);
+    for (ctbv = config_test_binary_vals; ctbv->name; ctbv++) {
+        TEST_ASSERT(ctbv->found == 1);
+    }
+
+    /*
+     * Binary data takes less space than its base64 text.
+     */
+    off = cf.cf_fcb.f_active.fe_elem_off;
+    rc = conf_save_one("bin/key", "AAECAwQFBgcICQoLDA0ODw==");
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cf.cf_fcb.f_active.fe_elem_off - off <
+      strlen("bin/key=AAECAwQFBgcICQoLDA0ODw=="));
+}
+
+#endif
@@ -33,6 +33,22 @@ TEST_CASE(config_test_commit)
     TEST_ASSERT(test_commit_called == 1);
     ctest_clear_call_state();
 
+    /*
+     * Nothing has been set since, so handler is not committed again.
+     */
+    rc = conf_commit(NULL);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(test_commit_called == 0);
+
+    strcpy(name, "myfoo/mybar");
+    rc = conf_set_value(name, "1");
+    TEST_ASSERT(rc == 0);
+    ctest_clear_call_state();
+    rc = conf_commit(NULL);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(test_commit_called == 1);
+    ctest_clear_call_state();
+
     strcpy(name, "myfoo");
     rc = conf_commit(name);
     TEST_ASSERT(rc == 0);
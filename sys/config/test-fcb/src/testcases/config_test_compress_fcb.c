@@ -0,0 +1,98 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_fcb.h"
+
+TEST_CASE(config_test_compress_fcb)
+{
+    int rc;
+    struct conf_fcb cf;
+    struct flash_area *oldest;
+    char test_value[CONF_TEST_FCB_VAL_STR_CNT][CONF_MAX_VAL_LEN];
+    int rotations;
+    int i;
+
+    config_wipe_srcs();
+    config_wipe_fcb(fcb_areas, sizeof(fcb_areas) / sizeof(fcb_areas[0]));
+
+    memset(&cf, 0, sizeof(cf));
+    cf.cf_fcb.f_sectors = fcb_areas;
+    cf.cf_fcb.f_sector_cnt = sizeof(fcb_areas) / sizeof(fcb_areas[0]);
+
+    rc = conf_fcb_src(&cf);
+    TEST_ASSERT(rc == 0);
+
+    rc = conf_fcb_dst(&cf);
+    TEST_ASSERT(rc == 0);
+
+    /* Plenty of space, nothing to do */
+    TEST_ASSERT(conf_fcb_compact(&cf) == 0);
+
+    /*
+     * Save all values once, then keep changing only the first few. The
+     * oldest sector then holds more live entries than are handled by one
+     * pass of compression.
+     */
+    c2_var_count = 24;
+    config_test_fill_area(test_value, 0);
+    memcpy(val_string, test_value, sizeof(val_string));
+    rc = conf_save();
+    TEST_ASSERT(rc == 0);
+
+    rotations = 0;
+    oldest = cf.cf_fcb.f_oldest;
+    for (i = 1; rotations < 6; i++) {
+        memset(test_value[i % 4], '0' + i % 10, CONF_MAX_VAL_LEN - 1);
+        memcpy(val_string, test_value, sizeof(val_string));
+        rc = conf_save();
+        TEST_ASSERT_FATAL(rc == 0);
+
+        if (cf.cf_fcb.f_oldest != oldest) {
+            oldest = cf.cf_fcb.f_oldest;
+            rotations++;
+        }
+
+        memset(val_string, 0, sizeof(val_string));
+        rc = conf_load();
+        TEST_ASSERT(rc == 0);
+        TEST_ASSERT_FATAL(!memcmp(val_string, test_value,
+          c2_var_count * sizeof(val_string[0])));
+    }
+
+    /* Compress from outside of conf_save() */
+    while (fcb_free_sector_cnt(&cf.cf_fcb) > cf.cf_fcb.f_scratch_cnt ||
+           cf.cf_fcb.f_active.fe_elem_off < fcb_areas[0].fa_size / 2) {
+        memset(test_value[i % 4], '0' + i % 10, CONF_MAX_VAL_LEN - 1);
+        memcpy(val_string, test_value, sizeof(val_string));
+        rc = conf_save();
+        TEST_ASSERT_FATAL(rc == 0);
+        i++;
+    }
+    oldest = cf.cf_fcb.f_oldest;
+    TEST_ASSERT(conf_fcb_compact(&cf) == 1);
+    TEST_ASSERT(cf.cf_fcb.f_oldest != oldest);
+    TEST_ASSERT(conf_fcb_compact(&cf) == 0);
+
+    memset(val_string, 0, sizeof(val_string));
+    rc = conf_load();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!memcmp(val_string, test_value,
+      c2_var_count * sizeof(val_string[0])));
+
+    c2_var_count = 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_fcb.h"
+
+TEST_CASE(config_test_index_fcb)
+{
+    int rc;
+    struct conf_fcb cf;
+    struct flash_area *fa;
+    char test_value[CONF_TEST_FCB_VAL_STR_CNT][CONF_MAX_VAL_LEN];
+    char myfoo[] = "myfoo";
+    char c2[] = "2nd";
+    uint32_t off;
+    int i;
+
+    config_wipe_srcs();
+    config_wipe_fcb(fcb_areas, sizeof(fcb_areas) / sizeof(fcb_areas[0]));
+
+    memset(&cf, 0, sizeof(cf));
+    cf.cf_fcb.f_sectors = fcb_areas;
+    cf.cf_fcb.f_sector_cnt = sizeof(fcb_areas) / sizeof(fcb_areas[0]);
+
+    rc = conf_fcb_src(&cf);
+    TEST_ASSERT(rc == 0);
+
+    rc = conf_fcb_dst(&cf);
+    TEST_ASSERT(rc == 0);
+
+    test_export_block = 0;
+    c2_var_count = 8;
+    val8 = 33;
+    config_test_fill_area(test_value, 0);
+    memcpy(val_string, test_value, sizeof(val_string));
+    rc = conf_save();
+    TEST_ASSERT(rc == 0);
+
+    val8 = 0;
+    memset(val_string, 0, sizeof(val_string));
+    rc = conf_load();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(val8 == 33);
+    TEST_ASSERT(!memcmp(val_string, test_value,
+      c2_var_count * sizeof(val_string[0])));
+
+    /*
+     * Nothing gets written if values did not change.
+     */
+    fa = cf.cf_fcb.f_active.fe_area;
+    off = cf.cf_fcb.f_active.fe_elem_off;
+    rc = conf_save();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cf.cf_fcb.f_active.fe_area == fa);
+    TEST_ASSERT(cf.cf_fcb.f_active.fe_elem_off == off);
+
+    /*
+     * Load one subsystem at a time.
+     */
+    val8 = 0;
+    memset(val_string, 0, sizeof(val_string));
+    ctest_clear_call_state();
+    rc = conf_load_one(myfoo);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(val8 == 33);
+    TEST_ASSERT(test_set_called && test_commit_called);
+    TEST_ASSERT(val_string[0][0] == '\0');
+
+    rc = conf_load_one(c2);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!memcmp(val_string, test_value,
+      c2_var_count * sizeof(val_string[0])));
+
+    /*
+     * Locations stay current across compression.
+     */
+    for (i = 1; i < 256; i++) {
+        val8 = i;
+        memset(test_value[i % 4], '0' + i % 10, CONF_MAX_VAL_LEN - 1);
+        memcpy(val_string, test_value, sizeof(val_string));
+        rc = conf_save();
+        TEST_ASSERT_FATAL(rc == 0);
+
+        val8 = 0;
+        rc = conf_load_one(myfoo);
+        TEST_ASSERT_FATAL(rc == 0);
+        TEST_ASSERT_FATAL(val8 == i);
+    }
+
+    memset(val_string, 0, sizeof(val_string));
+    rc = conf_load_one(c2);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(!memcmp(val_string, test_value,
+      c2_var_count * sizeof(val_string[0])));
+
+    ctest_clear_call_state();
+    c2_var_count = 0;
+}
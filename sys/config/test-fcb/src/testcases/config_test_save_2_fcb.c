@@ -27,6 +27,7 @@ TEST_CASE(config_test_save_2_fcb)
 
     config_wipe_srcs();
 
+    memset(&cf, 0, sizeof(cf));
     cf.cf_fcb.f_sectors = fcb_areas;
     cf.cf_fcb.f_sector_cnt = sizeof(fcb_areas) / sizeof(fcb_areas[0]);
 
@@ -27,6 +27,7 @@ TEST_CASE(config_test_save_3_fcb)
     config_wipe_srcs();
     config_wipe_fcb(fcb_areas, sizeof(fcb_areas) / sizeof(fcb_areas[0]));
 
+    memset(&cf, 0, sizeof(cf));
     cf.cf_fcb.f_sectors = fcb_areas;
     cf.cf_fcb.f_sector_cnt = 4;
 
@@ -0,0 +1,123 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "conf_test_fcb.h"
+
+static void
+config_test_txn_append(struct fcb *fcb, char *buf, int len)
+{
+    struct fcb_entry loc;
+    int rc;
+
+    rc = fcb_append(fcb, len, &loc);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = flash_area_write(loc.fe_area, loc.fe_data_off, buf, len);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = fcb_append_finish(fcb, &loc);
+    TEST_ASSERT_FATAL(rc == 0);
+}
+
+TEST_CASE(config_test_txn_fcb)
+{
+    int rc;
+    struct conf_fcb cf;
+    struct flash_area *fa;
+    char begin_marker[2] = { 0, 'B' };
+    char item[] = "myfoo/mybar=99";
+    char name[] = "myfoo/mybar";
+    char value[] = "41";
+    char value2[] = "42";
+    uint32_t off;
+
+    config_wipe_srcs();
+    config_wipe_fcb(fcb_areas, sizeof(fcb_areas) / sizeof(fcb_areas[0]));
+
+    memset(&cf, 0, sizeof(cf));
+    cf.cf_fcb.f_sectors = fcb_areas;
+    cf.cf_fcb.f_sector_cnt = sizeof(fcb_areas) / sizeof(fcb_areas[0]);
+
+    rc = conf_fcb_src(&cf);
+    TEST_ASSERT(rc == 0);
+
+    rc = conf_fcb_dst(&cf);
+    TEST_ASSERT(rc == 0);
+
+    /*
+     * Nothing is written before commit.
+     */
+    fa = cf.cf_fcb.f_active.fe_area;
+    off = cf.cf_fcb.f_active.fe_elem_off;
+
+    rc = conf_save_begin();
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_one(name, value);
+    TEST_ASSERT(rc == 0);
+    rc = conf_save_one("2nd/string0", "abc");
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cf.cf_fcb.f_active.fe_area == fa);
+    TEST_ASSERT(cf.cf_fcb.f_active.fe_elem_off == off);
+
+    rc = conf_save_commit();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cf.cf_fcb.f_active.fe_elem_off != off);
+    rc = conf_save_commit();
+    TEST_ASSERT(rc == OS_EINVAL);
+
+    c2_var_count = 1;
+    val8 = 0;
+    memset(val_string, 0, sizeof(val_string));
+    rc = conf_load();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(val8 == 41);
+    TEST_ASSERT(!strcmp(val_string[0], "abc"));
+
+    /*
+     * Transaction cut short by reset is ignored.
+     */
+    config_test_txn_append(&cf.cf_fcb, begin_marker, sizeof(begin_marker));
+    config_test_txn_append(&cf.cf_fcb, item, strlen(item));
+
+    config_wipe_srcs();
+    memset(&cf, 0, sizeof(cf));
+    cf.cf_fcb.f_sectors = fcb_areas;
+    cf.cf_fcb.f_sector_cnt = sizeof(fcb_areas) / sizeof(fcb_areas[0]);
+
+    rc = conf_fcb_src(&cf);
+    TEST_ASSERT(rc == 0);
+    rc = conf_fcb_dst(&cf);
+    TEST_ASSERT(rc == 0);
+
+    val8 = 0;
+    rc = conf_load();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(val8 == 41);
+
+    /*
+     * Items written after it are not part of it.
+     */
+    rc = conf_save_one(name, value2);
+    TEST_ASSERT(rc == 0);
+
+    val8 = 0;
+    rc = conf_load();
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(val8 == 42);
+
+    ctest_clear_call_state();
+    c2_var_count = 0;
+}
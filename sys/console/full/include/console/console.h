@@ -20,6 +20,7 @@
 #define __CONSOLE_H__
 
 #include <stdarg.h>
+#include <inttypes.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -34,6 +35,16 @@ int console_read(char *str, int cnt, int *newline);
 void console_blocking_mode(void);
 void console_echo(int on);
 
+/*
+ * Output stats, kept if CONSOLE_STATS is set.
+ */
+struct console_stats {
+    uint32_t cs_tx_dropped;     /* chars dropped, TX buffer full */
+    uint32_t cs_tx_blocked;     /* writes which waited for TX buffer */
+    uint32_t cs_tx_block_ticks; /* OS ticks spent waiting */
+};
+void console_get_stats(struct console_stats *cs);
+
 void console_printf(const char *fmt, ...)
     __attribute__ ((format (printf, 1, 2)));;
 
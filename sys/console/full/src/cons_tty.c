@@ -32,6 +32,7 @@
 int console_is_midline;
 
 #define CONSOLE_RX_CHUNK        16
+#define CONSOLE_TX_CHUNK        16
 
 #if MYNEWT_VAL(CONSOLE_HIST_ENABLE)
 #define CONSOLE_HIST_SZ         32
@@ -51,8 +52,8 @@ typedef void (*console_write_char)(char);
 void console_print_prompt(void);
 
 struct console_ring {
-    uint8_t cr_head;
-    uint8_t cr_tail;
+    uint16_t cr_head;
+    uint16_t cr_tail;
     uint16_t cr_size;
     uint8_t *cr_buf;
 };
@@ -74,6 +75,14 @@ struct console_tty {
     uint8_t ct_esc_seq:2;
 } console_tty;
 
+#if MYNEWT_VAL(CONSOLE_STATS)
+static struct console_stats console_stats;
+
+#define CONSOLE_STATS_INCN(__var, __n)  (console_stats.__var += (__n))
+#else
+#define CONSOLE_STATS_INCN(__var, __n)
+#endif
+
 #if MYNEWT_VAL(CONSOLE_HIST_ENABLE)
 struct console_hist {
     uint8_t ch_head;
@@ -112,6 +121,15 @@ console_pull_char_head(struct console_ring *cr)
     }
 }
 
+static int
+console_buf_space(struct console_ring *cr)
+{
+    int space;
+
+    space = (cr->cr_tail - cr->cr_head) & (cr->cr_size - 1);
+    return space - 1;
+}
+
 static void
 console_queue_char(char ch)
 {
@@ -270,6 +288,90 @@ console_echo(int on)
     ct->ct_echo_off = !on;
 }
 
+/*
+ * Copy as much of str to TX queue as fits, expanding '\n' to "\r\n".
+ * Interrupts are enabled every CONSOLE_TX_CHUNK characters.
+ *
+ * Returns the number of characters taken from str.
+ */
+static int
+console_queue_str(struct console_tty *ct, const char *str, int cnt)
+{
+    struct console_ring *cr = &ct->ct_tx;
+    int sr;
+    int i;
+    int n;
+
+    i = 0;
+    OS_ENTER_CRITICAL(sr);
+    for (n = 0; i < cnt; n++) {
+        if ((n & (CONSOLE_TX_CHUNK - 1)) == (CONSOLE_TX_CHUNK - 1)) {
+            OS_EXIT_CRITICAL(sr);
+            OS_ENTER_CRITICAL(sr);
+        }
+        if (str[i] == '\n') {
+            if (console_buf_space(cr) < 2) {
+                break;
+            }
+            console_add_char(cr, '\r');
+        } else if (console_buf_space(cr) < 1) {
+            break;
+        }
+        console_add_char(cr, str[i]);
+        i++;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return i;
+}
+
+/*
+ * Queue the whole string for transmission. If TX queue fills up, rest of
+ * the data is either dropped, or caller waits for the UART to drain it,
+ * depending on CONSOLE_TX_DROP.
+ */
+static void
+console_tx_str(struct console_tty *ct, const char *str, int cnt)
+{
+#if !MYNEWT_VAL(CONSOLE_TX_DROP)
+#if MYNEWT_VAL(CONSOLE_STATS)
+    os_time_t start = 0;
+#endif
+    int blocked = 0;
+#endif
+    int n;
+
+    while (1) {
+        n = console_queue_str(ct, str, cnt);
+        str += n;
+        cnt -= n;
+        if (cnt == 0) {
+            break;
+        }
+        uart_start_tx(ct->ct_dev);
+#if MYNEWT_VAL(CONSOLE_TX_DROP)
+        CONSOLE_STATS_INCN(cs_tx_dropped, cnt);
+        break;
+#else
+        if (!blocked) {
+            blocked = 1;
+#if MYNEWT_VAL(CONSOLE_STATS)
+            start = os_time_get();
+#endif
+            CONSOLE_STATS_INCN(cs_tx_blocked, 1);
+        }
+        if (os_started()) {
+            os_time_delay(1);
+        }
+#endif
+    }
+#if !MYNEWT_VAL(CONSOLE_TX_DROP) && MYNEWT_VAL(CONSOLE_STATS)
+    if (blocked) {
+        CONSOLE_STATS_INCN(cs_tx_block_ticks, os_time_get() - start);
+    }
+#endif
+}
+
 size_t
 console_file_write(void *arg, const char *str, size_t cnt)
 {
@@ -279,11 +381,15 @@ console_file_write(void *arg, const char *str, size_t cnt)
     if (!ct->ct_write_char) {
         return cnt;
     }
-    for (i = 0; i < cnt; i++) {
-        if (str[i] == '\n') {
-            ct->ct_write_char('\r');
+    if (ct->ct_write_char == console_queue_char) {
+        console_tx_str(ct, str, cnt);
+    } else {
+        for (i = 0; i < cnt; i++) {
+            if (str[i] == '\n') {
+                ct->ct_write_char('\r');
+            }
+            ct->ct_write_char(str[i]);
         }
-        ct->ct_write_char(str[i]);
     }
     if (cnt > 0) {
         console_is_midline = str[cnt - 1] != '\n';
@@ -355,15 +461,6 @@ console_tx_char(void *arg)
     return console_pull_char(cr);
 }
 
-static int
-console_buf_space(struct console_ring *cr)
-{
-    int space;
-
-    space = (cr->cr_tail - cr->cr_head) & (cr->cr_size - 1);
-    return space - 1;
-}
-
 static int
 console_rx_char(void *arg, uint8_t data)
 {
@@ -442,7 +539,7 @@ console_rx_char(void *arg, uint8_t data)
         }
         if (!ct->ct_echo_off) {
             /* HACK: clean line by backspacing up to maximum possible space */
-            for (i = 0; i < MYNEWT_VAL(CONSOLE_TX_BUF_SIZE); i++) {
+            for (i = 0; i < MYNEWT_VAL(CONSOLE_RX_BUF_SIZE); i++) {
                 if (console_buf_space(tx) < 3) {
                     console_tx_flush(ct, 3);
                 }
@@ -507,6 +604,18 @@ out:
     return 0;
 }
 
+#if MYNEWT_VAL(CONSOLE_STATS)
+void
+console_get_stats(struct console_stats *cs)
+{
+    int sr;
+
+    OS_ENTER_CRITICAL(sr);
+    *cs = console_stats;
+    OS_EXIT_CRITICAL(sr);
+}
+#endif
+
 int
 console_is_init(void)
 {
@@ -553,6 +662,7 @@ console_init(console_rx_cb rx_cb)
 
     /* must be a power of 2 */
     assert(is_power_of_two(MYNEWT_VAL(CONSOLE_RX_BUF_SIZE)));
+    assert(is_power_of_two(MYNEWT_VAL(CONSOLE_TX_BUF_SIZE)));
 
 #if MYNEWT_VAL(CONSOLE_HIST_ENABLE)
     console_hist_init();
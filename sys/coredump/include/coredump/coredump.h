@@ -34,6 +34,18 @@ extern "C" {
 #define COREDUMP_TLV_IMAGE          1   /* SHA256 of image creating this */
 #define COREDUMP_TLV_MEM            2   /* Memory dump */
 #define COREDUMP_TLV_REGS           3   /* CPU registers */
+#define COREDUMP_TLV_MEM_RLE        4   /* Memory dump, compressed */
+
+/*
+ * COREDUMP_TLV_MEM_RLE data starts with uint32_t length of memory when
+ * expanded. It is followed by records of 32-bit words, each starting with
+ * uint16_t. If COREDUMP_RLE_REPEAT is set, the following word is repeated
+ * count times, otherwise count words follow.
+ */
+#define COREDUMP_RLE_REPEAT         0x8000
+#define COREDUMP_RLE_CNT_MAX        0x7fff
+#define COREDUMP_RLE_MIN_RUN        3
+#define COREDUMP_RLE_MAX_IN         16384   /* max memory in one TLV */
 
 struct coredump_tlv {
     uint8_t ct_type;
@@ -50,8 +62,19 @@ struct coredump_header {
     uint32_t ch_size;                   /* Size of everything */
 };
 
+void coredump_init(void);
 void coredump_dump(void *regs, int regs_sz);
 
+struct flash_area;
+
+/*
+ * Access the corefile in fa as it would be without compression; such
+ * TLVs are presented as COREDUMP_TLV_MEM. Both return 0 on success.
+ */
+int coredump_size(const struct flash_area *fa, uint32_t *size);
+int coredump_read(const struct flash_area *fa, uint32_t off, void *buf,
+                  uint32_t len);
+
 /*
  * Set this to non-zero to prevent coredump from taking place.
  */
@@ -18,26 +18,249 @@
  */
 
 #include <stddef.h>
+#include <string.h>
 #include <limits.h>
 #include "syscfg/syscfg.h"
 #include "sysflash/sysflash.h"
+#include "sysinit/sysinit.h"
+#include "os/os.h"
 #include "hal/hal_bsp.h"
+#include "hal/hal_watchdog.h"
 #include "flash_map/flash_map.h"
 #include "bootutil/image.h"
 #include "imgmgr/imgmgr.h"
 #include "coredump/coredump.h"
 
+/* Largest piece of memory in one COREDUMP_TLV_MEM. */
+#define COREDUMP_MEM_MAX        (SHRT_MAX + 1)
+
+#define COREDUMP_WR_BUF_SZ      32
+
 uint8_t coredump_disabled;
 
+/* Set when the area is known to be erased. */
+static uint8_t coredump_erased;
+
+/*
+ * State of corefile being written. Flash is erased a sector at a time,
+ * just ahead of where data is going, so only as much of the area is erased
+ * as the dump needs. Small writes are gathered into cw_buf.
+ */
+struct coredump_wr {
+    const struct flash_area *cw_fa;
+    uint32_t cw_off;                    /* cw_buf goes here */
+    uint32_t cw_erased;                 /* area is erased up to here */
+    uint16_t cw_len;
+    int cw_rc;
+    uint8_t cw_buf[COREDUMP_WR_BUF_SZ];
+};
+
+static int
+coredump_erase_to(struct coredump_wr *cw, uint32_t end)
+{
+    const struct flash_area *fa = cw->cw_fa;
+    struct flash_area sector;
+
+    if (end > fa->fa_size) {
+        return -1;
+    }
+    while (cw->cw_erased < end) {
+        if (flash_area_sector_from_off(fa, cw->cw_erased, &sector) < 0) {
+            /*
+             * Sector layout not known, erase the rest.
+             */
+            sector.fa_off = fa->fa_off + cw->cw_erased;
+            sector.fa_size = fa->fa_size - cw->cw_erased;
+        }
+        hal_watchdog_tickle();
+        if (flash_area_erase(fa, sector.fa_off - fa->fa_off,
+                             sector.fa_size)) {
+            return -1;
+        }
+        cw->cw_erased = sector.fa_off - fa->fa_off + sector.fa_size;
+    }
+    return 0;
+}
+
+static void
+coredump_wr_flash(struct coredump_wr *cw, uint32_t off, const void *data,
+                  uint32_t len)
+{
+    if (cw->cw_rc) {
+        return;
+    }
+    cw->cw_rc = coredump_erase_to(cw, off + len);
+    if (!cw->cw_rc) {
+        cw->cw_rc = flash_area_write(cw->cw_fa, off, data, len);
+    }
+}
+
+static void
+coredump_wr_flush(struct coredump_wr *cw)
+{
+    if (cw->cw_len) {
+        coredump_wr_flash(cw, cw->cw_off, cw->cw_buf, cw->cw_len);
+        cw->cw_off += cw->cw_len;
+        cw->cw_len = 0;
+    }
+}
+
+static void
+coredump_wr(struct coredump_wr *cw, const void *data, uint32_t len)
+{
+    if (cw->cw_len + len > sizeof(cw->cw_buf)) {
+        coredump_wr_flush(cw);
+        if (len > sizeof(cw->cw_buf)) {
+            coredump_wr_flash(cw, cw->cw_off, data, len);
+            cw->cw_off += len;
+            return;
+        }
+    }
+    memcpy(cw->cw_buf + cw->cw_len, data, len);
+    cw->cw_len += len;
+}
+
+static void
+dump_core_tlv(struct coredump_wr *cw, struct coredump_tlv *tlv, void *data)
+{
+    coredump_wr(cw, tlv, sizeof(*tlv));
+    coredump_wr(cw, data, tlv->ct_len);
+}
+
+#if MYNEWT_VAL(COREDUMP_COMPRESS)
+/*
+ * Number of identical words at the start of w.
+ */
+static int
+dump_core_rle_run(const uint32_t *w, int cnt)
+{
+    int i;
+
+    if (cnt > COREDUMP_RLE_CNT_MAX) {
+        cnt = COREDUMP_RLE_CNT_MAX;
+    }
+    for (i = 1; i < cnt; i++) {
+        if (w[i] != w[0]) {
+            break;
+        }
+    }
+    return i;
+}
+
+/*
+ * Write cnt words from w as COREDUMP_TLV_MEM_RLE. The TLV header is filled
+ * in after the data, once its length is known.
+ */
+static void
+dump_core_rle(struct coredump_wr *cw, const uint32_t *w, int cnt)
+{
+    struct coredump_tlv tlv;
+    uint32_t tlv_off;
+    uint32_t rawlen;
+    uint16_t rec;
+    int lit;
+    int run;
+
+    coredump_wr_flush(cw);
+    tlv_off = cw->cw_off;
+    cw->cw_off += sizeof(tlv);
+
+    rawlen = cnt * sizeof(*w);
+    coredump_wr(cw, &rawlen, sizeof(rawlen));
+
+    while (cnt > 0) {
+        /*
+         * Gather words until there's a run worth encoding.
+         */
+        lit = 0;
+        while (lit < cnt && lit < COREDUMP_RLE_CNT_MAX) {
+            run = dump_core_rle_run(w + lit, cnt - lit);
+            if (run >= COREDUMP_RLE_MIN_RUN) {
+                break;
+            }
+            lit += run;
+        }
+        if (lit) {
+            lit = min(lit, COREDUMP_RLE_CNT_MAX);
+            rec = lit;
+            coredump_wr(cw, &rec, sizeof(rec));
+            coredump_wr(cw, w, lit * sizeof(*w));
+            w += lit;
+            cnt -= lit;
+        } else {
+            run = dump_core_rle_run(w, cnt);
+            rec = COREDUMP_RLE_REPEAT | run;
+            coredump_wr(cw, &rec, sizeof(rec));
+            coredump_wr(cw, w, sizeof(*w));
+            w += run;
+            cnt -= run;
+        }
+    }
+    coredump_wr_flush(cw);
+
+    tlv.ct_type = COREDUMP_TLV_MEM_RLE;
+    tlv._pad = 0;
+    tlv.ct_len = cw->cw_off - tlv_off - sizeof(tlv);
+    tlv.ct_off = (uint32_t)(w - rawlen / sizeof(*w));
+    coredump_wr_flash(cw, tlv_off, &tlv, sizeof(tlv));
+}
+#endif
+
+static void
+dump_core_mem(struct coredump_wr *cw, void *start, uint32_t size)
+{
+    struct coredump_tlv tlv;
+    uint32_t area_off;
+    uint32_t area_end;
+
+    area_off = (uint32_t)start;
+    area_end = area_off + size;
+
+#if MYNEWT_VAL(COREDUMP_COMPRESS)
+    if ((area_off & 3) == 0 && (size & 3) == 0) {
+        while (area_off < area_end) {
+            size = min(area_end - area_off, COREDUMP_RLE_MAX_IN);
+            dump_core_rle(cw, (uint32_t *)area_off, size / sizeof(uint32_t));
+            area_off += size;
+            hal_watchdog_tickle();
+        }
+        return;
+    }
+#endif
+    while (area_off < area_end) {
+        tlv.ct_type = COREDUMP_TLV_MEM;
+        tlv._pad = 0;
+        tlv.ct_len = min(area_end - area_off, COREDUMP_MEM_MAX);
+        tlv.ct_off = area_off;
+        dump_core_tlv(cw, &tlv, (void *)area_off);
+        area_off += tlv.ct_len;
+        hal_watchdog_tickle();
+    }
+}
+
 static void
-dump_core_tlv(const struct flash_area *fa, uint32_t *off,
-  struct coredump_tlv *tlv, void *data)
+dump_core_regions(struct coredump_wr *cw)
 {
-    flash_area_write(fa, *off, tlv, sizeof(*tlv));
-    *off += sizeof(*tlv);
+#if MYNEWT_VAL(COREDUMP_TASKS_ONLY)
+    struct os_task_info oti;
+    struct os_task *t;
+
+    t = NULL;
+    while ((t = os_task_info_get_next(t, &oti)) != NULL) {
+        dump_core_mem(cw, t, sizeof(*t));
+        dump_core_mem(cw, t->t_stacktop - t->t_stacksize,
+                      t->t_stacksize * sizeof(os_stack_t));
+    }
+#else
+    const struct hal_bsp_mem_dump *mem;
+    int area_cnt;
+    int i;
 
-    flash_area_write(fa, *off, data, tlv->ct_len);
-    *off += tlv->ct_len;
+    mem = hal_bsp_core_dump(&area_cnt);
+    for (i = 0; i < area_cnt; i++) {
+        dump_core_mem(cw, mem[i].hbmd_start, mem[i].hbmd_size);
+    }
+#endif
 }
 
 void
@@ -45,13 +268,10 @@ coredump_dump(void *regs, int regs_sz)
 {
     struct coredump_header hdr;
     struct coredump_tlv tlv;
+    struct coredump_wr cw;
     const struct flash_area *fa;
     struct image_version ver;
-    const struct hal_bsp_mem_dump *mem, *cur;
-    int area_cnt, i;
     uint8_t hash[IMGMGR_HASH_LEN];
-    uint32_t off;
-    uint32_t area_off, area_end;
     int slot;
 
     if (coredump_disabled) {
@@ -81,8 +301,10 @@ coredump_dump(void *regs, int regs_sz)
         }
     }
 
-    if (flash_area_erase(fa, 0, fa->fa_size)) {
-        return;
+    memset(&cw, 0, sizeof(cw));
+    cw.cw_fa = fa;
+    if (coredump_erased) {
+        cw.cw_erased = fa->fa_size;
     }
 
     /*
@@ -93,35 +315,239 @@ coredump_dump(void *regs, int regs_sz)
     tlv.ct_len = regs_sz;
     tlv.ct_off = 0;
 
-    off = sizeof(hdr);
-    dump_core_tlv(fa, &off, &tlv, regs);
+    cw.cw_off = sizeof(hdr);
+    dump_core_tlv(&cw, &tlv, regs);
 
     if (imgr_read_info(boot_current_slot, &ver, hash, NULL) == 0) {
         tlv.ct_type = COREDUMP_TLV_IMAGE;
         tlv.ct_len = IMGMGR_HASH_LEN;
 
-        dump_core_tlv(fa, &off, &tlv, hash);
+        dump_core_tlv(&cw, &tlv, hash);
     }
 
-    mem = hal_bsp_core_dump(&area_cnt);
-    for (i = 0; i < area_cnt; i++) {
-        cur = &mem[i];
-        area_off = (uint32_t)cur->hbmd_start;
-        area_end = area_off + cur->hbmd_size;
-        while (area_off < area_end) {
+    dump_core_regions(&cw);
+    coredump_wr_flush(&cw);
+    if (cw.cw_rc) {
+        return;
+    }
+
+    hdr.ch_magic = COREDUMP_MAGIC;
+    hdr.ch_size = cw.cw_off;
+
+    coredump_wr_flash(&cw, 0, &hdr, sizeof(hdr));
+}
+
+/*
+ * Expand len bytes, starting at off, from RLE records stored at roff.
+ */
+static int
+coredump_rle_read(const struct flash_area *fa, uint32_t roff, uint32_t rlen,
+                  uint32_t off, uint8_t *buf, uint32_t len)
+{
+    uint32_t rend;
+    uint32_t pos;
+    uint32_t cnt;
+    uint32_t skip;
+    uint32_t word;
+    uint32_t n;
+    uint32_t i;
+    uint16_t rec;
+
+    rend = roff + rlen;
+    pos = 0;
+    while (len > 0) {
+        if (roff + sizeof(rec) > rend) {
+            return -1;
+        }
+        if (flash_area_read(fa, roff, &rec, sizeof(rec))) {
+            return -1;
+        }
+        roff += sizeof(rec);
+        cnt = (rec & COREDUMP_RLE_CNT_MAX) * sizeof(word);
+        if (off < pos + cnt) {
+            skip = off - pos;
+            n = min(cnt - skip, len);
+            if (rec & COREDUMP_RLE_REPEAT) {
+                if (flash_area_read(fa, roff, &word, sizeof(word))) {
+                    return -1;
+                }
+                for (i = 0; i < n; i++) {
+                    buf[i] = ((uint8_t *)&word)[(skip + i) & 3];
+                }
+            } else if (flash_area_read(fa, roff + skip, buf, n)) {
+                return -1;
+            }
+            buf += n;
+            off += n;
+            len -= n;
+        }
+        pos += cnt;
+        if (rec & COREDUMP_RLE_REPEAT) {
+            roff += sizeof(word);
+        } else {
+            roff += cnt;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Walk through the TLVs of corefile, as it would be without compression.
+ * Copies the TLVs overlapping [off, off + len) to buf, and/or returns the
+ * expanded size in vsize.
+ */
+static int
+coredump_walk(const struct flash_area *fa, uint32_t size, uint32_t off,
+              uint8_t *buf, uint32_t len, uint32_t *vsize)
+{
+    struct coredump_tlv tlv;
+    uint32_t soff;
+    uint32_t voff;
+    uint32_t slen;
+    uint32_t rawlen;
+    uint32_t o;
+    uint32_t n;
+    int rle;
+    int rc;
+
+    soff = sizeof(struct coredump_header);
+    voff = soff;
+    while (soff + sizeof(tlv) <= size) {
+        if (len == 0 && !vsize) {
+            break;
+        }
+        if (flash_area_read(fa, soff, &tlv, sizeof(tlv))) {
+            return -1;
+        }
+        slen = tlv.ct_len;
+        if (soff + sizeof(tlv) + slen > size) {
+            return -1;
+        }
+        rle = 0;
+        if (tlv.ct_type == COREDUMP_TLV_MEM_RLE) {
+            if (slen < sizeof(rawlen) ||
+              flash_area_read(fa, soff + sizeof(tlv), &rawlen,
+                              sizeof(rawlen))) {
+                return -1;
+            }
             tlv.ct_type = COREDUMP_TLV_MEM;
-            if (cur->hbmd_size > USHRT_MAX) {
-                tlv.ct_len = SHRT_MAX + 1;
+            tlv.ct_len = rawlen;
+            rle = 1;
+        }
+        if (len && off < voff + sizeof(tlv)) {
+            o = off - voff;
+            n = min(sizeof(tlv) - o, len);
+            memcpy(buf, (uint8_t *)&tlv + o, n);
+            buf += n;
+            off += n;
+            len -= n;
+        }
+        if (len && off < voff + sizeof(tlv) + tlv.ct_len) {
+            o = off - voff - sizeof(tlv);
+            n = min(tlv.ct_len - o, len);
+            if (rle) {
+                rc = coredump_rle_read(fa, soff + sizeof(tlv) + sizeof(rawlen),
+                                       slen - sizeof(rawlen), o, buf, n);
             } else {
-                tlv.ct_len = cur->hbmd_size;
+                rc = flash_area_read(fa, soff + sizeof(tlv) + o, buf, n);
+            }
+            if (rc) {
+                return -1;
             }
-            tlv.ct_off = area_off;
-            dump_core_tlv(fa, &off, &tlv, (void *)area_off);
-            area_off += tlv.ct_len;
+            buf += n;
+            off += n;
+            len -= n;
         }
+        soff += sizeof(tlv) + slen;
+        voff += sizeof(tlv) + tlv.ct_len;
     }
-    hdr.ch_magic = COREDUMP_MAGIC;
-    hdr.ch_size = off;
+    if (vsize) {
+        *vsize = voff;
+    }
+    return 0;
+}
 
-    flash_area_write(fa, 0, &hdr, sizeof(hdr));
+int
+coredump_size(const struct flash_area *fa, uint32_t *size)
+{
+    struct coredump_header hdr;
+
+    if (flash_area_read(fa, 0, &hdr, sizeof(hdr))) {
+        return -1;
+    }
+    if (hdr.ch_magic != COREDUMP_MAGIC || hdr.ch_size > fa->fa_size) {
+        return -1;
+    }
+    return coredump_walk(fa, hdr.ch_size, 0, NULL, 0, size);
+}
+
+int
+coredump_read(const struct flash_area *fa, uint32_t off, void *buf,
+              uint32_t len)
+{
+    struct coredump_header hdr;
+    uint32_t vsize;
+    uint8_t *b;
+    uint32_t n;
+
+    if (flash_area_read(fa, 0, &hdr, sizeof(hdr))) {
+        return -1;
+    }
+    if (hdr.ch_magic != COREDUMP_MAGIC || hdr.ch_size > fa->fa_size) {
+        return -1;
+    }
+    b = buf;
+    if (off < sizeof(hdr)) {
+        if (coredump_walk(fa, hdr.ch_size, 0, NULL, 0, &vsize)) {
+            return -1;
+        }
+        hdr.ch_size = vsize;
+        n = min(sizeof(hdr) - off, len);
+        memcpy(b, (uint8_t *)&hdr + off, n);
+        b += n;
+        off += n;
+        len -= n;
+    }
+    if (len == 0) {
+        return 0;
+    }
+    return coredump_walk(fa, hdr.ch_size, off, b, len, NULL);
+}
+
+void
+coredump_init(void)
+{
+#if MYNEWT_VAL(COREDUMP_PREERASE)
+    const struct flash_area *fa;
+    struct coredump_header hdr;
+    uint32_t word;
+    uint32_t off;
+
+    /*
+     * Images get written to slots after boot; only keep the area erased
+     * ahead of time if nothing else uses it.
+     */
+    if (flash_area_id_to_image_slot(MYNEWT_VAL(COREDUMP_FLASH_AREA)) != -1) {
+        return;
+    }
+    if (flash_area_open(MYNEWT_VAL(COREDUMP_FLASH_AREA), &fa)) {
+        return;
+    }
+    if (flash_area_read(fa, 0, &hdr, sizeof(hdr)) ||
+      hdr.ch_magic == COREDUMP_MAGIC) {
+        return;
+    }
+    for (off = 0; off < fa->fa_size; off += sizeof(word)) {
+        if (flash_area_read(fa, off, &word, sizeof(word))) {
+            return;
+        }
+        if (word != 0xffffffff) {
+            break;
+        }
+    }
+    if (off < fa->fa_size && flash_area_erase(fa, 0, fa->fa_size)) {
+        return;
+    }
+    coredump_erased = 1;
+#endif
 }
@@ -0,0 +1,91 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __SYS_ENTROPY_H__
+#define __SYS_ENTROPY_H__
+
+#include <stddef.h>
+#include <inttypes.h>
+#include "os/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A hardware entropy source.  Sources feed raw samples into the pool with
+ * entropy_add(); the pool asks them for more through es_start when it runs
+ * low.  A source should stop sampling once entropy_add() reports that the
+ * pool is full.
+ */
+struct entropy_source {
+    /** Called (possibly from interrupt context) to restart sampling. */
+    void (*es_start)(void *arg);
+    void *es_arg;
+    SLIST_ENTRY(entropy_source) es_next;
+};
+
+/**
+ * Registers a hardware entropy source.
+ */
+void entropy_source_register(struct entropy_source *src);
+
+/**
+ * Adds raw samples to the entropy pool.  Safe to call from interrupt
+ * context.
+ *
+ * @param data                  The samples to add.
+ * @param len                   The number of bytes to add.
+ *
+ * @return                      1 if the pool wants more samples;
+ *                              0 if the pool is full.
+ */
+int entropy_add(const void *data, int len);
+
+/**
+ * Fills a buffer with random bytes from the DRBG.  The DRBG is seeded (and
+ * periodically reseeded) from the pool; after the first seed this never
+ * waits for the hardware.  Must be called from task context.
+ *
+ * @param buf                   The buffer to fill.
+ * @param len                   The number of bytes to generate.
+ *
+ * @return                      0 on success;
+ *                              SYS_EAGAIN if the pool has not yet gathered
+ *                                  enough samples for the initial seed;
+ *                              SYS_EIO on DRBG failure.
+ */
+int entropy_get(void *buf, size_t len);
+
+/**
+ * entropy_get() wrapper with the mbedtls f_rng signature, for passing to
+ * mbedtls routines (ECDH, ECDSA, SSL/DTLS) that need a random source.
+ */
+int entropy_mbedtls_rng(void *arg, unsigned char *buf, size_t len);
+
+/**
+ * Initializes the entropy service.  Called by sysinit.
+ */
+void entropy_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
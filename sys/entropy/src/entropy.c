@@ -0,0 +1,232 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "sysinit/sysinit.h"
+#include "syscfg/syscfg.h"
+#include "defs/error.h"
+#include "hal/hal_bsp.h"
+#include "os/os.h"
+#include "mbedtls/ctr_drbg.h"
+
+#include "entropy/entropy.h"
+
+#if MYNEWT_VAL(ENTROPY_POOL_SIZE) < MBEDTLS_CTR_DRBG_ENTROPY_LEN
+#error "ENTROPY_POOL_SIZE must be at least MBEDTLS_CTR_DRBG_ENTROPY_LEN"
+#endif
+
+/*
+ * Raw samples from the hardware sources.  Written from interrupt context,
+ * drained in chunks of MBEDTLS_CTR_DRBG_ENTROPY_LEN when (re)seeding.
+ */
+static uint8_t entropy_pool[MYNEWT_VAL(ENTROPY_POOL_SIZE)];
+static uint16_t entropy_pool_in;
+static volatile uint16_t entropy_pool_cnt;
+
+static SLIST_HEAD(, entropy_source) entropy_sources =
+    SLIST_HEAD_INITIALIZER(entropy_sources);
+
+static struct os_mutex entropy_mtx;
+static mbedtls_ctr_drbg_context entropy_drbg;
+static uint8_t entropy_seeded;
+static uint16_t entropy_gets_since_seed;
+
+static void
+entropy_sources_start(void)
+{
+    struct entropy_source *src;
+
+    SLIST_FOREACH(src, &entropy_sources, es_next) {
+        src->es_start(src->es_arg);
+    }
+}
+
+void
+entropy_source_register(struct entropy_source *src)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    SLIST_INSERT_HEAD(&entropy_sources, src, es_next);
+    OS_EXIT_CRITICAL(sr);
+
+    src->es_start(src->es_arg);
+}
+
+int
+entropy_add(const void *data, int len)
+{
+    const uint8_t *u8p;
+    os_sr_t sr;
+    int rc;
+
+    u8p = data;
+
+    OS_ENTER_CRITICAL(sr);
+    while (len > 0 && entropy_pool_cnt < sizeof entropy_pool) {
+        entropy_pool[entropy_pool_in] = *u8p;
+        entropy_pool_in = (entropy_pool_in + 1) % sizeof entropy_pool;
+        entropy_pool_cnt++;
+        u8p++;
+        len--;
+    }
+    rc = entropy_pool_cnt < sizeof entropy_pool;
+    OS_EXIT_CRITICAL(sr);
+
+    return rc;
+}
+
+/**
+ * mbedtls entropy callback; takes exactly 'len' bytes out of the pool or
+ * fails without consuming anything.
+ */
+static int
+entropy_pool_take(void *arg, unsigned char *buf, size_t len)
+{
+    uint16_t out;
+    os_sr_t sr;
+    int rc;
+
+    OS_ENTER_CRITICAL(sr);
+    if (entropy_pool_cnt < len) {
+        rc = MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
+    } else {
+        out = (entropy_pool_in + sizeof entropy_pool - entropy_pool_cnt) %
+              sizeof entropy_pool;
+        while (len > 0) {
+            *buf++ = entropy_pool[out];
+            out = (out + 1) % sizeof entropy_pool;
+            entropy_pool_cnt--;
+            len--;
+        }
+        rc = 0;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    /* Refill the pool for the next reseed. */
+    entropy_sources_start();
+
+    return rc;
+}
+
+/**
+ * Seeds or reseeds the DRBG if the pool holds enough samples.  Must be
+ * called with the mutex held.
+ */
+static void
+entropy_seed(void)
+{
+    uint8_t pers[HAL_BSP_MAX_ID_LEN];
+    int pers_len;
+    int rc;
+
+    if (entropy_pool_cnt < MBEDTLS_CTR_DRBG_ENTROPY_LEN) {
+        return;
+    }
+
+    if (!entropy_seeded) {
+        /* Personalize with the hardware id so that devices without much
+         * entropy still produce distinct streams.
+         */
+        pers_len = hal_bsp_hw_id(pers, sizeof pers);
+        if (pers_len < 0) {
+            pers_len = 0;
+        }
+        rc = mbedtls_ctr_drbg_seed(&entropy_drbg, entropy_pool_take, NULL,
+                                   pers, pers_len);
+        if (rc == 0) {
+            /* Reseeding is done here, opportunistically, so that generation
+             * never fails because the hardware has not caught up.
+             */
+            mbedtls_ctr_drbg_set_reseed_interval(&entropy_drbg, INT32_MAX);
+            entropy_seeded = 1;
+        }
+    } else {
+        rc = mbedtls_ctr_drbg_reseed(&entropy_drbg, NULL, 0);
+    }
+
+    if (rc == 0) {
+        entropy_gets_since_seed = 0;
+    }
+}
+
+int
+entropy_get(void *buf, size_t len)
+{
+    uint8_t *u8p;
+    size_t chunk;
+    int rc;
+
+    os_mutex_pend(&entropy_mtx, OS_TIMEOUT_NEVER);
+
+    if (!entropy_seeded ||
+        entropy_gets_since_seed >= MYNEWT_VAL(ENTROPY_RESEED_INTERVAL)) {
+
+        entropy_seed();
+    }
+    if (!entropy_seeded) {
+        rc = SYS_EAGAIN;
+        goto done;
+    }
+
+    if (entropy_gets_since_seed < UINT16_MAX) {
+        entropy_gets_since_seed++;
+    }
+
+    u8p = buf;
+    while (len > 0) {
+        chunk = len;
+        if (chunk > MBEDTLS_CTR_DRBG_MAX_REQUEST) {
+            chunk = MBEDTLS_CTR_DRBG_MAX_REQUEST;
+        }
+        if (mbedtls_ctr_drbg_random(&entropy_drbg, u8p, chunk) != 0) {
+            rc = SYS_EIO;
+            goto done;
+        }
+        u8p += chunk;
+        len -= chunk;
+    }
+    rc = 0;
+
+done:
+    os_mutex_release(&entropy_mtx);
+    return rc;
+}
+
+int
+entropy_mbedtls_rng(void *arg, unsigned char *buf, size_t len)
+{
+    if (entropy_get(buf, len) != 0) {
+        return MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
+    }
+    return 0;
+}
+
+void
+entropy_init(void)
+{
+    int rc;
+
+    rc = os_mutex_init(&entropy_mtx);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+
+    mbedtls_ctr_drbg_init(&entropy_drbg);
+}
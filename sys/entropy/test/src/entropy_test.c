@@ -0,0 +1,78 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <string.h>
+
+#include "syscfg/syscfg.h"
+#include "defs/error.h"
+#include "os/os.h"
+#include "testutil/testutil.h"
+#include "entropy/entropy.h"
+
+static uint8_t entropy_test_big[2000];
+
+TEST_CASE(entropy_test_seed)
+{
+    uint8_t sample;
+    uint8_t a[16];
+    uint8_t b[16];
+    int rc;
+    int i;
+
+    /* Nothing gathered yet; the DRBG cannot be seeded. */
+    rc = entropy_get(a, sizeof a);
+    TEST_ASSERT(rc == SYS_EAGAIN);
+
+    /* The pool keeps asking for samples until it is full. */
+    for (i = 0; i < MYNEWT_VAL(ENTROPY_POOL_SIZE) - 1; i++) {
+        sample = i * 37;
+        TEST_ASSERT(entropy_add(&sample, 1) == 1);
+    }
+    sample = 0xa5;
+    TEST_ASSERT(entropy_add(&sample, 1) == 0);
+
+    /* Seeded; successive outputs differ. */
+    rc = entropy_get(a, sizeof a);
+    TEST_ASSERT_FATAL(rc == 0);
+    rc = entropy_get(b, sizeof b);
+    TEST_ASSERT_FATAL(rc == 0);
+    TEST_ASSERT(memcmp(a, b, sizeof a) != 0);
+
+    /* Requests larger than a single DRBG request are split. */
+    rc = entropy_get(entropy_test_big, sizeof entropy_test_big);
+    TEST_ASSERT(rc == 0);
+}
+
+TEST_SUITE(entropy_test_all)
+{
+    entropy_test_seed();
+}
+
+#if MYNEWT_VAL(SELFTEST)
+int
+main(int argc, char **argv)
+{
+    ts_config.ts_print_results = 1;
+    tu_init();
+
+    entropy_init();
+    entropy_test_all();
+
+    return tu_any_failed;
+}
+#endif
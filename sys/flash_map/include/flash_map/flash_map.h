@@ -86,6 +86,15 @@ uint8_t flash_area_align(const struct flash_area *);
  */
 int flash_area_to_sectors(int idx, int *cnt, struct flash_area *ret);
 
+/*
+ * Find the sector which contains offset off within the area. Returns index
+ * of the sector, as in flash_area_to_sectors(), or -1 if offset is not
+ * within any of the area's sectors. If sector is not NULL, it is filled
+ * with the sector's location.
+ */
+int flash_area_sector_from_off(const struct flash_area *fa, uint32_t off,
+  struct flash_area *sector);
+
 int flash_area_id_from_image_slot(int slot);
 int flash_area_id_to_image_slot(int area_id);
 
@@ -34,6 +34,27 @@
 const struct flash_area *flash_map;
 int flash_map_entries;
 
+/*
+ * Sector layout of an area, precomputed so that sector queries do not have
+ * to walk through all the sectors of the flash device.
+ */
+struct flash_map_sectors {
+    uint16_t fms_first;         /* index of first sector in hal_flash */
+    uint16_t fms_cnt;
+    uint32_t fms_start;         /* flash offset of the first sector */
+    uint32_t fms_size;          /* sector size; 0 if sizes vary */
+};
+
+static struct flash_map_sectors
+flash_map_sectors[MYNEWT_VAL(FLASH_MAP_MAX_AREAS)];
+
+/*
+ * Flash map the table was built for. Map can be replaced after
+ * flash_map_init() (e.g. by unit tests); table is then rebuilt.
+ */
+static const struct flash_area *flash_map_sectors_map;
+static int flash_map_sectors_entries;
+
 int
 flash_area_open(uint8_t id, const struct flash_area **fap)
 {
@@ -61,11 +82,106 @@ flash_area_close(const struct flash_area *fa)
     /* nothing to do for now */
 }
 
+/*
+ * Area consists of the sectors which start within it.
+ */
+static int
+flash_map_sectors_calc(const struct flash_area *fa,
+                       struct flash_map_sectors *fms)
+{
+    const struct hal_flash *hf;
+    uint32_t start;
+    uint32_t size;
+    int i;
+
+    memset(fms, 0, sizeof(*fms));
+
+    hf = hal_bsp_flash_dev(fa->fa_device_id);
+    if (hf == NULL) {
+        return -1;
+    }
+    for (i = 0; i < hf->hf_sector_cnt; i++) {
+        if (hf->hf_itf->hff_sector_info(i, &start, &size)) {
+            return -1;
+        }
+        if (start < fa->fa_off || start >= fa->fa_off + fa->fa_size) {
+            continue;
+        }
+        if (fms->fms_cnt == 0) {
+            fms->fms_first = i;
+            fms->fms_start = start;
+            fms->fms_size = size;
+        } else if (fms->fms_size != size) {
+            fms->fms_size = 0;
+        }
+        fms->fms_cnt++;
+    }
+    return 0;
+}
+
+static void
+flash_map_sectors_build(void)
+{
+    int i;
+
+    flash_map_sectors_map = flash_map;
+    flash_map_sectors_entries = flash_map_entries;
+    if (flash_map_entries > MYNEWT_VAL(FLASH_MAP_MAX_AREAS)) {
+        return;
+    }
+    for (i = 0; i < flash_map_entries; i++) {
+        if (flash_map_sectors_calc(&flash_map[i], &flash_map_sectors[i])) {
+            flash_map_sectors_entries = 0;
+            return;
+        }
+    }
+}
+
+/*
+ * Returns sector layout for area. Uses the precomputed one if fa is an
+ * entry in the flash map; computes it into tmp otherwise.
+ */
+static const struct flash_map_sectors *
+flash_map_sectors_get(const struct flash_area *fa,
+                      struct flash_map_sectors *tmp)
+{
+    if (flash_map != flash_map_sectors_map ||
+        flash_map_entries != flash_map_sectors_entries) {
+        flash_map_sectors_build();
+    }
+    if (fa >= flash_map && fa < flash_map + flash_map_entries &&
+        flash_map_sectors_entries == flash_map_entries &&
+        flash_map_entries <= MYNEWT_VAL(FLASH_MAP_MAX_AREAS)) {
+        return &flash_map_sectors[fa - flash_map];
+    }
+    if (flash_map_sectors_calc(fa, tmp)) {
+        return NULL;
+    }
+    return tmp;
+}
+
+static int
+flash_map_sector_info(const struct flash_area *fa,
+                      const struct flash_map_sectors *fms, int idx,
+                      uint32_t *start, uint32_t *size)
+{
+    const struct hal_flash *hf;
+
+    if (fms->fms_size) {
+        *start = fms->fms_start + idx * fms->fms_size;
+        *size = fms->fms_size;
+        return 0;
+    }
+    hf = hal_bsp_flash_dev(fa->fa_device_id);
+    return hf->hf_itf->hff_sector_info(fms->fms_first + idx, start, size);
+}
+
 int
 flash_area_to_sectors(int id, int *cnt, struct flash_area *ret)
 {
     const struct flash_area *fa;
-    const struct hal_flash *hf;
+    const struct flash_map_sectors *fms;
+    struct flash_map_sectors tmp;
     uint32_t start;
     uint32_t size;
     int rc;
@@ -76,25 +192,86 @@ flash_area_to_sectors(int id, int *cnt, struct flash_area *ret)
         return rc;
     }
 
-    *cnt = 0;
+    fms = flash_map_sectors_get(fa, &tmp);
+    if (fms == NULL) {
+        return -1;
+    }
 
-    hf = hal_bsp_flash_dev(fa->fa_device_id);
-    for (i = 0; i < hf->hf_sector_cnt; i++) {
-        hf->hf_itf->hff_sector_info(i, &start, &size);
-        if (start >= fa->fa_off && start < fa->fa_off + fa->fa_size) {
-            if (ret) {
-                ret->fa_id = id;
-                ret->fa_device_id = fa->fa_device_id;
-                ret->fa_off = start;
-                ret->fa_size = size;
-                ret++;
-            }
-            (*cnt)++;
+    *cnt = fms->fms_cnt;
+    if (ret) {
+        for (i = 0; i < fms->fms_cnt; i++) {
+            flash_map_sector_info(fa, fms, i, &start, &size);
+            ret->fa_id = id;
+            ret->fa_device_id = fa->fa_device_id;
+            ret->fa_off = start;
+            ret->fa_size = size;
+            ret++;
         }
     }
     return 0;
 }
 
+int
+flash_area_sector_from_off(const struct flash_area *fa, uint32_t off,
+  struct flash_area *sector)
+{
+    const struct flash_map_sectors *fms;
+    struct flash_map_sectors tmp;
+    uint32_t start;
+    uint32_t size;
+    int lo;
+    int hi;
+    int idx;
+
+    fms = flash_map_sectors_get(fa, &tmp);
+    if (fms == NULL || fms->fms_cnt == 0 || off >= fa->fa_size) {
+        return -1;
+    }
+    off += fa->fa_off;
+    if (off < fms->fms_start) {
+        return -1;
+    }
+
+    if (fms->fms_size) {
+        idx = (off - fms->fms_start) / fms->fms_size;
+        if (idx >= fms->fms_cnt) {
+            return -1;
+        }
+        flash_map_sector_info(fa, fms, idx, &start, &size);
+    } else {
+        /*
+         * Sector sizes vary; binary search for the last sector starting
+         * at or before off.
+         */
+        lo = 0;
+        hi = fms->fms_cnt - 1;
+        while (lo < hi) {
+            idx = (lo + hi + 1) / 2;
+            if (flash_map_sector_info(fa, fms, idx, &start, &size)) {
+                return -1;
+            }
+            if (start <= off) {
+                lo = idx;
+            } else {
+                hi = idx - 1;
+            }
+        }
+        idx = lo;
+        if (flash_map_sector_info(fa, fms, idx, &start, &size) ||
+            off >= start + size) {
+            return -1;
+        }
+    }
+
+    if (sector) {
+        sector->fa_id = fa->fa_id;
+        sector->fa_device_id = fa->fa_device_id;
+        sector->fa_off = start;
+        sector->fa_size = size;
+    }
+    return idx;
+}
+
 int
 flash_area_read(const struct flash_area *fa, uint32_t off, void *dst,
     uint32_t len)
@@ -265,4 +442,6 @@ flash_map_init(void)
         flash_map = mfg_areas;
         flash_map_entries = num_areas;
     }
+
+    flash_map_sectors_build();
 }
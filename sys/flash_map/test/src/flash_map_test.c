@@ -40,11 +40,13 @@ struct flash_area *fa_sectors;
 
 TEST_CASE_DECL(flash_map_test_case_1)
 TEST_CASE_DECL(flash_map_test_case_2)
+TEST_CASE_DECL(flash_map_test_case_3)
 
 TEST_SUITE(flash_map_test_suite)
 {
     flash_map_test_case_1();
     flash_map_test_case_2();
+    flash_map_test_case_3();
 }
 
 #if MYNEWT_VAL(SELFTEST)
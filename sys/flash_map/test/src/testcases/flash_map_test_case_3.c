@@ -0,0 +1,71 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "flash_map_test.h"
+
+extern int flash_map_entries;
+extern struct flash_area *fa_sectors;
+
+/*
+ * Test flash_area_sector_from_off()
+ */
+TEST_CASE(flash_map_test_case_3)
+{
+    const struct flash_area *fa;
+    struct flash_area sector;
+    int areas_checked = 0;
+    int sect_cnt;
+    int i, j, rc;
+    uint32_t off;
+
+#if MYNEWT_VAL(SELFTEST)
+    sysinit();
+#endif
+
+    for (i = 0; i < flash_map_entries; i++) {
+        rc = flash_area_open(i, &fa);
+        if (rc) {
+            continue;
+        }
+
+        rc = flash_area_to_sectors(i, &sect_cnt, fa_sectors);
+        TEST_ASSERT_FATAL(rc == 0, "flash_area_to_sectors failed");
+        if (sect_cnt == 0) {
+            continue;
+        }
+        areas_checked++;
+
+        for (j = 0; j < sect_cnt; j++) {
+            /* first and last byte of every sector */
+            off = fa_sectors[j].fa_off - fa->fa_off;
+            rc = flash_area_sector_from_off(fa, off, &sector);
+            TEST_ASSERT_FATAL(rc == j, "wrong sector for start of sector");
+            TEST_ASSERT(sector.fa_off == fa_sectors[j].fa_off);
+            TEST_ASSERT(sector.fa_size == fa_sectors[j].fa_size);
+            TEST_ASSERT(sector.fa_device_id == fa->fa_device_id);
+
+            off += fa_sectors[j].fa_size - 1;
+            rc = flash_area_sector_from_off(fa, off, NULL);
+            TEST_ASSERT_FATAL(rc == j, "wrong sector for end of sector");
+        }
+
+        rc = flash_area_sector_from_off(fa, fa->fa_size, NULL);
+        TEST_ASSERT(rc == -1);
+    }
+    TEST_ASSERT_FATAL(areas_checked != 0, "No flash map areas to check!");
+}
@@ -51,12 +51,33 @@ typedef int (*lh_append_func_t)(struct log *, void *buf, int len);
 typedef int (*lh_walk_func_t)(struct log *,
         log_walk_func_t walk_func, void *arg);
 typedef int (*lh_flush_func_t)(struct log *);
+/*
+ * Walks the entries after the one at *cursor, and leaves *cursor at the
+ * last entry walk_func returned 0 for. A cursor of LOG_CURSOR_START walks
+ * from the oldest entry.
+ */
+typedef int (*lh_walk_from_func_t)(struct log *,
+        log_walk_func_t walk_func, void *arg, uint64_t *cursor);
 /*
  * This function pointer points to a function that restores the numebr
  * of entries that are specified while erasing
  */
 typedef int (*lh_rtr_erase_func_t)(struct log *, void *arg);
 
+/*
+ * One entry of a batch passed to log_append_batch.
+ */
+struct log_buf {
+    void *lb_data;
+    uint16_t lb_len;
+};
+/*
+ * Appends several entries, in order. Optional; log_append is called for
+ * each entry if this is not given.
+ */
+typedef int (*lh_append_batch_func_t)(struct log *, struct log_buf *bufs,
+        int cnt);
+
 #define LOG_TYPE_STREAM  (0)
 #define LOG_TYPE_MEMORY  (1)
 #define LOG_TYPE_STORAGE (2)
@@ -68,6 +89,8 @@ struct log_handler {
     lh_walk_func_t log_walk;
     lh_flush_func_t log_flush;
     lh_rtr_erase_func_t log_rtr_erase;
+    lh_append_batch_func_t log_append_batch;
+    lh_walk_from_func_t log_walk_from;
 };
 
 struct log_entry_hdr {
@@ -131,36 +154,105 @@ struct log_entry_hdr {
 
 #define LOG_NAME_MAX_LEN    (64)
 
+/*
+ * Lowest level logged by a module, set at build time. Call sites of a
+ * constant module below its level compile to nothing.
+ */
+#define LOG_MODULE_MIN_LEVEL(__mod) \
+    (LOG_MODULE_OS          == (__mod) ? MYNEWT_VAL(LOG_LEVEL_OS)          :\
+    (LOG_MODULE_NEWTMGR     == (__mod) ? MYNEWT_VAL(LOG_LEVEL_NEWTMGR)     :\
+    (LOG_MODULE_NIMBLE_CTLR == (__mod) ? MYNEWT_VAL(LOG_LEVEL_NIMBLE_CTLR) :\
+    (LOG_MODULE_NIMBLE_HOST == (__mod) ? MYNEWT_VAL(LOG_LEVEL_NIMBLE_HOST) :\
+    (LOG_MODULE_NFFS        == (__mod) ? MYNEWT_VAL(LOG_LEVEL_NFFS)        :\
+    (LOG_MODULE_IOTIVITY    == (__mod) ? MYNEWT_VAL(LOG_LEVEL_IOTIVITY)    :\
+     0))))))
+
+#if MYNEWT_VAL(LOG_MODULE_LEVELS) > 0
+/* Lowest level logged by a module, set at run time with log_level_set(). */
+extern uint8_t g_log_module_level[MYNEWT_VAL(LOG_MODULE_LEVELS)];
+
+#define LOG_MODULE_LEVEL_OK(__mod, __lvl) \
+    ((__mod) >= MYNEWT_VAL(LOG_MODULE_LEVELS) || \
+     (__lvl) >= g_log_module_level[(__mod)])
+#else
+#define LOG_MODULE_LEVEL_OK(__mod, __lvl) (1)
+#endif
+
+#define LOG_LEVEL_ENABLED(__mod, __lvl) \
+    ((__lvl) >= LOG_MODULE_MIN_LEVEL(__mod) && \
+     LOG_MODULE_LEVEL_OK(__mod, __lvl))
+
+#if MYNEWT_VAL(LOG_RATE_SITE)
+/*
+ * Each LOG_<level>() call site has its own token bucket, a static word,
+ * checked before the message is formatted.
+ */
+#define LOG_SITE_DECL   static uint32_t log_site_tat_;
+#define LOG_SITE_OK     log_rate_site_ok(&log_site_tat_)
+#else
+#define LOG_SITE_DECL
+#define LOG_SITE_OK     (1)
+#endif
+
+#if MYNEWT_VAL(LOG_BINARY)
+/*
+ * Binary entries hold the address of the format string, which is placed in
+ * its own input section, followed by the raw arguments. The text is
+ * formatted on the host, with the format strings read from the ELF image.
+ */
+#define LOG_FMT_SECTION __attribute__((section(".rodata.log_fmt")))
+
+#define LOG_MODULE_PRINTF(__l, __mod, __lvl, __msg, ...) do {        \
+    if (LOG_LEVEL_ENABLED(__mod, __lvl)) {                           \
+        static const char log_fmt_[] LOG_FMT_SECTION = __msg;        \
+        LOG_SITE_DECL                                                \
+        if (LOG_SITE_OK) {                                           \
+            log_printf_bin(__l, __mod, __lvl, log_fmt_,              \
+                           ##__VA_ARGS__);                           \
+        }                                                            \
+    }                                                                \
+} while (0)
+#else
+#define LOG_MODULE_PRINTF(__l, __mod, __lvl, __msg, ...) do {        \
+    if (LOG_LEVEL_ENABLED(__mod, __lvl)) {                           \
+        LOG_SITE_DECL                                                \
+        if (LOG_SITE_OK) {                                           \
+            log_printf(__l, __mod, __lvl, __msg, ##__VA_ARGS__);     \
+        }                                                            \
+    }                                                                \
+} while (0)
+#endif
+
 #if MYNEWT_VAL(LOG_LEVEL) <= LOG_LEVEL_DEBUG
-#define LOG_DEBUG(__l, __mod, __msg, ...) log_printf(__l, __mod, \
+#define LOG_DEBUG(__l, __mod, __msg, ...) LOG_MODULE_PRINTF(__l, __mod, \
         LOG_LEVEL_DEBUG, __msg, ##__VA_ARGS__)
 #else
 #define LOG_DEBUG(__l, __mod, ...) IGNORE(__VA_ARGS__)
 #endif
 
 #if MYNEWT_VAL(LOG_LEVEL) <= LOG_LEVEL_INFO
-#define LOG_INFO(__l, __mod, __msg, ...) log_printf(__l, __mod, \
+#define LOG_INFO(__l, __mod, __msg, ...) LOG_MODULE_PRINTF(__l, __mod, \
         LOG_LEVEL_INFO, __msg, ##__VA_ARGS__)
 #else
 #define LOG_INFO(__l, __mod, ...) IGNORE(__VA_ARGS__)
 #endif
 
 #if MYNEWT_VAL(LOG_LEVEL) <= LOG_LEVEL_WARN
-#define LOG_WARN(__l, __mod, __msg, ...) log_printf(__l, __mod, \
+#define LOG_WARN(__l, __mod, __msg, ...) LOG_MODULE_PRINTF(__l, __mod, \
         LOG_LEVEL_WARN, __msg, ##__VA_ARGS__)
 #else
 #define LOG_WARN(__l, __mod, ...) IGNORE(__VA_ARGS__)
 #endif
 
 #if MYNEWT_VAL(LOG_LEVEL) <= LOG_LEVEL_ERROR
-#define LOG_ERROR(__l, __mod, __msg, ...) log_printf(__l, __mod, \
+#define LOG_ERROR(__l, __mod, __msg, ...) LOG_MODULE_PRINTF(__l, __mod, \
         LOG_LEVEL_ERROR, __msg, ##__VA_ARGS__)
 #else
 #define LOG_ERROR(__l, __mod, ...) IGNORE(__VA_ARGS__)
 #endif
 
 #if MYNEWT_VAL(LOG_LEVEL) <= LOG_LEVEL_CRITICAL
-#define LOG_CRITICAL(__l, __mod, __msg, ...) log_printf(__l, __mod, \
+#define LOG_CRITICAL(__l, __mod, __msg, ...) LOG_MODULE_PRINTF(__l, __mod, \
         LOG_LEVEL_CRITICAL, __msg, ##__VA_ARGS__)
 #else
 #define LOG_CRITICAL(__l, __mod, ...) IGNORE(__VA_ARGS__)
@@ -172,12 +264,56 @@ struct log_entry_hdr {
 #define LOG_SYSLEVEL    ((uint8_t)MYNEWT_VAL_LOG_LEVEL)
 #endif
 
+#if MYNEWT_VAL(LOG_RING_ENTRIES) > 0
+/*
+ * RAM ring in front of a log. log_append() copies entries into the ring,
+ * and the log ring task writes them to the log handler in batches.
+ */
+struct log_ring_rec {
+    volatile uint8_t lrr_ready;
+    uint16_t lrr_len;
+    uint8_t lrr_data[LOG_ENTRY_HDR_SIZE + MYNEWT_VAL(LOG_RING_ENTRY_LEN)];
+};
+
+struct log_ring {
+    struct log_ring_rec lr_recs[MYNEWT_VAL(LOG_RING_ENTRIES)];
+    uint16_t lr_head;           /* Next record to fill */
+    uint16_t lr_tail;           /* Next record to write to the log */
+    uint32_t lr_full_drops;     /* Entries dropped, ring was full */
+    uint32_t lr_len_drops;      /* Entries dropped, too long for a record */
+    uint32_t lr_err_drops;      /* Entries the log handler failed to write */
+};
+#endif
+
+#define LOG_SUPPRESS (MYNEWT_VAL(LOG_RATE_MODULES) > 0 || \
+                      MYNEWT_VAL(LOG_RATE_SITE) || \
+                      MYNEWT_VAL(LOG_DUP_SUPPRESS))
+
+#if MYNEWT_VAL(LOG_DUP_SUPPRESS)
+/* The last entry appended to a log, and how often it has been repeated. */
+struct log_dup {
+    uint32_t ld_hash;
+    uint32_t ld_start;          /* os_time_t the run started */
+    uint32_t ld_window;         /* Longest run, in ticks; 0 if disabled */
+    uint32_t ld_cnt;            /* Duplicates dropped in this run */
+    uint8_t ld_module;
+    uint8_t ld_level;
+    uint8_t ld_valid;
+};
+#endif
+
 struct log {
     char *l_name;
     struct log_handler *l_log;
     void *l_arg;
     STAILQ_ENTRY(log) l_next;
     uint8_t l_level;
+#if MYNEWT_VAL(LOG_RING_ENTRIES) > 0
+    struct log_ring *l_ring;
+#endif
+#if MYNEWT_VAL(LOG_DUP_SUPPRESS)
+    struct log_dup l_dup;
+#endif
 };
 
 /* Newtmgr Log opcodes */
@@ -196,15 +332,43 @@ struct log *log_list_get_next(struct log *);
 int log_register(char *name, struct log *log, const struct log_handler *,
                  void *arg, uint8_t level);
 int log_append(struct log *, uint16_t, uint16_t, void *, uint16_t);
+int64_t log_ts_usec(int64_t ts);
 
 #define LOG_PRINTF_MAX_ENTRY_LEN (128)
 void log_printf(struct log *log, uint16_t, uint16_t, char *, ...);
+
+/*
+ * Body of a binary entry: LOG_BIN_MARKER, format string address, and the
+ * arguments the format string converts. Arguments are stored in their C
+ * size and byte order, promoted as when passed through '...'; strings are
+ * copied, NUL terminated. Arguments that do not fit are left out.
+ */
+#define LOG_BIN_MARKER  (0x00)
+void log_printf_bin(struct log *log, uint16_t, uint16_t, const char *, ...);
+int log_entry_is_bin(const void *body, int len);
 int log_read(struct log *log, void *dptr, void *buf, uint16_t off,
         uint16_t len);
 int log_walk(struct log *log, log_walk_func_t walk_func,
         void *arg);
+#define LOG_CURSOR_START    (0)
+int log_walk_from(struct log *log, log_walk_func_t walk_func, void *arg,
+        uint64_t *cursor);
 int log_flush(struct log *log);
 int log_rtr_erase(struct log *log, void *arg);
+#if MYNEWT_VAL(LOG_MODULE_LEVELS) > 0
+int log_level_set(uint8_t module, uint8_t level);
+uint8_t log_level_get(uint8_t module);
+#endif
+#if MYNEWT_VAL(LOG_RATE_MODULES) > 0
+int log_rate_set(uint8_t module, uint16_t per_sec, uint16_t burst);
+#endif
+#if MYNEWT_VAL(LOG_DUP_SUPPRESS)
+void log_dup_window_set(struct log *log, uint32_t window_ms);
+#endif
+#if MYNEWT_VAL(LOG_RING_ENTRIES) > 0
+int log_ring_attach(struct log *log, struct log_ring *ring);
+int log_ring_drain(struct log *log);
+#endif
 
 /* Handler exports */
 extern const struct log_handler log_console_handler;
@@ -212,9 +376,33 @@ extern const struct log_handler log_cbmem_handler;
 extern const struct log_handler log_fcb_handler;
 
 /* Private */
+int log_append_entry(struct log *log, uint16_t module, uint16_t level,
+        void *data, uint16_t len);
+#if LOG_SUPPRESS
+void log_rate_init(void);
+#endif
+#if MYNEWT_VAL(LOG_RATE_MODULES) > 0
+int log_rate_module_peek(uint16_t module);
+int log_rate_module_take(uint16_t module);
+#endif
+#if MYNEWT_VAL(LOG_RATE_SITE)
+int log_rate_site_ok(uint32_t *tat);
+#endif
+#if MYNEWT_VAL(LOG_DUP_SUPPRESS)
+int log_dup_check(struct log *log, uint16_t module, uint16_t level,
+        const void *body, uint16_t len);
+#endif
 #if MYNEWT_VAL(LOG_NEWTMGR)
 int log_nmgr_register_group(void);
 #endif
+#if MYNEWT_VAL(LOG_FCB_COMPRESS_BLOCK) > 0
+int log_lz_compress(const uint8_t *src, int len, uint8_t *dst, int dst_len);
+int log_lz_decompress(const uint8_t *src, int len, uint8_t *dst, int dst_len);
+#endif
+#if MYNEWT_VAL(LOG_RING_ENTRIES) > 0
+void log_ring_init(void);
+int log_ring_put(struct log *log, void *data, int len);
+#endif
 
 #ifdef __cplusplus
 }
@@ -34,6 +34,10 @@
 
 struct log_info g_log_info;
 
+#if MYNEWT_VAL(LOG_MODULE_LEVELS) > 0
+uint8_t g_log_module_level[MYNEWT_VAL(LOG_MODULE_LEVELS)];
+#endif
+
 static STAILQ_HEAD(, log) g_log_list = STAILQ_HEAD_INITIALIZER(g_log_list);
 static uint8_t log_inited;
 
@@ -69,6 +73,14 @@ log_init(void)
     rc = log_nmgr_register_group();
     SYSINIT_PANIC_ASSERT(rc == 0);
 #endif
+
+#if MYNEWT_VAL(LOG_RING_ENTRIES) > 0
+    log_ring_init();
+#endif
+
+#if LOG_SUPPRESS
+    log_rate_init();
+#endif
 }
 
 struct log *
@@ -113,6 +125,10 @@ log_register(char *name, struct log *log, const struct log_handler *lh,
     log->l_log = (struct log_handler *)lh;
     log->l_arg = arg;
     log->l_level = level;
+#if MYNEWT_VAL(LOG_DUP_SUPPRESS)
+    log->l_dup.ld_cnt = 0;
+    log_dup_window_set(log, MYNEWT_VAL(LOG_DUP_WINDOW_MS));
+#endif
 
     /*assert(!log_registered(log));*/
     if (!log_registered(log)) {
@@ -122,33 +138,59 @@ log_register(char *name, struct log *log, const struct log_handler *lh,
     return (0);
 }
 
+#if MYNEWT_VAL(LOG_MODULE_LEVELS) > 0
+/**
+ * Sets the lowest level of messages a module logs. Messages below it are
+ * dropped before they are formatted.
+ *
+ * @param module The module.
+ * @param level  The level; LOG_LEVEL_DEBUG logs everything.
+ *
+ * @return 0 on success; OS_EINVAL if the module has no level of its own.
+ */
 int
-log_append(struct log *log, uint16_t module, uint16_t level, void *data,
-        uint16_t len)
+log_level_set(uint8_t module, uint8_t level)
 {
-    struct log_entry_hdr *ue;
-    int rc;
-    struct os_timeval tv;
-
-    if (log->l_name == NULL || log->l_log == NULL) {
-        rc = -1;
-        goto err;
+    if (module >= MYNEWT_VAL(LOG_MODULE_LEVELS)) {
+        return OS_EINVAL;
     }
+    g_log_module_level[module] = level;
+    return 0;
+}
 
-    /*
-     * If the log message is below what this log instance is
-     * configured to accept, then just drop it.
-     */
-    if (level < log->l_level) {
-        rc = -1;
-        goto err;
+uint8_t
+log_level_get(uint8_t module)
+{
+    if (module >= MYNEWT_VAL(LOG_MODULE_LEVELS)) {
+        return LOG_LEVEL_DEBUG;
     }
+    return g_log_module_level[module];
+}
+#endif
+
+/*
+ * Stamps an entry and hands it to the log, past the level, rate and
+ * duplicate checks.
+ */
+int
+log_append_entry(struct log *log, uint16_t module, uint16_t level,
+        void *data, uint16_t len)
+{
+    struct log_entry_hdr *ue;
+#if !MYNEWT_VAL(LOG_TS_TICKS)
+    int rc;
+    struct os_timeval tv;
+#endif
 
     ue = (struct log_entry_hdr *) data;
 
     /* Could check for li_index wraparound here */
     g_log_info.li_index++;
 
+#if MYNEWT_VAL(LOG_TS_TICKS)
+    /* Converted by log_ts_usec() when the entry is read. */
+    ue->ue_ts = os_time_get64();
+#else
     /* Try to get UTC Time */
     rc = os_gettimeofday(&tv, NULL);
     if (rc || tv.tv_sec < UTC01_01_2016) {
@@ -156,13 +198,82 @@ log_append(struct log *log, uint16_t module, uint16_t level, void *data,
     } else {
         ue->ue_ts = tv.tv_sec * 1000000 + tv.tv_usec;
     }
+#endif
 
     g_log_info.li_timestamp = ue->ue_ts;
     ue->ue_level = level;
     ue->ue_module = module;
     ue->ue_index = g_log_info.li_index;
 
-    rc = log->l_log->log_append(log, data, len + LOG_ENTRY_HDR_SIZE);
+#if MYNEWT_VAL(LOG_RING_ENTRIES) > 0
+    if (log->l_ring) {
+        return log_ring_put(log, data, len + LOG_ENTRY_HDR_SIZE);
+    }
+#endif
+
+    return log->l_log->log_append(log, data, len + LOG_ENTRY_HDR_SIZE);
+}
+
+/**
+ * Converts the timestamp of an entry to microseconds: UTC if the time of
+ * day has been set, time since boot otherwise.
+ *
+ * @param ts The ue_ts of the entry.
+ *
+ * @return The timestamp in microseconds.
+ */
+int64_t
+log_ts_usec(int64_t ts)
+{
+#if MYNEWT_VAL(LOG_TS_TICKS)
+    int64_t usec;
+
+    if (os_time_ticks64_to_utc(ts, &usec) == 0 &&
+        usec >= (int64_t)UTC01_01_2016 * 1000000) {
+        return usec;
+    }
+    return os_time_ticks64_to_usec(ts);
+#else
+    return ts;
+#endif
+}
+
+int
+log_append(struct log *log, uint16_t module, uint16_t level, void *data,
+        uint16_t len)
+{
+    int rc;
+
+    if (log->l_name == NULL || log->l_log == NULL) {
+        rc = -1;
+        goto err;
+    }
+
+    /*
+     * If the log message is below what this log instance is
+     * configured to accept, then just drop it.
+     */
+    if (level < log->l_level || !LOG_MODULE_LEVEL_OK(module, level)) {
+        rc = -1;
+        goto err;
+    }
+
+#if MYNEWT_VAL(LOG_DUP_SUPPRESS)
+    /* Repeats of the previous entry are counted, not written. */
+    if (log_dup_check(log, module, level,
+                      (uint8_t *)data + LOG_ENTRY_HDR_SIZE, len)) {
+        return 0;
+    }
+#endif
+
+#if MYNEWT_VAL(LOG_RATE_MODULES) > 0
+    if (!log_rate_module_take(module)) {
+        rc = -1;
+        goto err;
+    }
+#endif
+
+    rc = log_append_entry(log, module, level, data, len);
     if (rc != 0) {
         goto err;
     }
@@ -179,6 +290,18 @@ log_printf(struct log *log, uint16_t module, uint16_t level, char *msg, ...)
     char buf[LOG_ENTRY_HDR_SIZE + LOG_PRINTF_MAX_ENTRY_LEN];
     int len;
 
+    /*
+     * Drop the message before formatting it, if it would be dropped anyway.
+     */
+    if (level < log->l_level || !LOG_MODULE_LEVEL_OK(module, level)) {
+        return;
+    }
+#if MYNEWT_VAL(LOG_RATE_MODULES) > 0
+    if (!log_rate_module_peek(module)) {
+        return;
+    }
+#endif
+
     va_start(args, msg);
     len = vsnprintf(&buf[LOG_ENTRY_HDR_SIZE], LOG_PRINTF_MAX_ENTRY_LEN, msg,
             args);
@@ -189,6 +312,165 @@ log_printf(struct log *log, uint16_t module, uint16_t level, char *msg, ...)
     log_append(log, module, level, (uint8_t *) buf, len);
 }
 
+/*
+ * Appends an argument to a binary entry body. Returns 0 if it did not fit.
+ */
+static int
+log_bin_put(uint8_t *buf, int *off, int max, const void *val, int len)
+{
+    if (*off + len > max) {
+        return 0;
+    }
+    memcpy(buf + *off, val, len);
+    *off += len;
+    return 1;
+}
+
+/**
+ * Stores a binary entry: the format string address and the raw arguments.
+ * The format string is only scanned for the types of its arguments; no
+ * text is formatted.
+ */
+void
+log_printf_bin(struct log *log, uint16_t module, uint16_t level,
+        const char *fmt, ...)
+{
+    uint8_t buf[LOG_ENTRY_HDR_SIZE + LOG_PRINTF_MAX_ENTRY_LEN];
+    uint8_t *body;
+    const char *p;
+    const char *str;
+    va_list args;
+    long double ld;
+    long long ll;
+    double d;
+    void *ptr;
+    size_t sz;
+    long l;
+    int max;
+    int off;
+    int lmod;
+    int ok;
+    int i;
+
+    if (level < log->l_level || !LOG_MODULE_LEVEL_OK(module, level)) {
+        return;
+    }
+#if MYNEWT_VAL(LOG_RATE_MODULES) > 0
+    if (!log_rate_module_peek(module)) {
+        return;
+    }
+#endif
+
+    body = &buf[LOG_ENTRY_HDR_SIZE];
+    max = LOG_PRINTF_MAX_ENTRY_LEN;
+    off = 0;
+    body[off++] = LOG_BIN_MARKER;
+    log_bin_put(body, &off, max, &fmt, sizeof(fmt));
+
+    va_start(args, fmt);
+    ok = 1;
+    for (p = fmt; ok && *p; p++) {
+        if (*p != '%') {
+            continue;
+        }
+        p++;
+        while (*p && strchr("-+ #0", *p)) {
+            p++;
+        }
+        while (ok && *p && strchr("0123456789.*", *p)) {
+            if (*p == '*') {
+                i = va_arg(args, int);
+                ok = log_bin_put(body, &off, max, &i, sizeof(i));
+            }
+            p++;
+        }
+        /* 0: int, 1: long, 2: long long, 3: size_t, 4: long double */
+        lmod = 0;
+        while (*p && strchr("hlLjzt", *p)) {
+            if (*p == 'l') {
+                lmod++;
+            } else if (*p == 'j') {
+                lmod = 2;
+            } else if (*p == 'z' || *p == 't') {
+                lmod = 3;
+            } else if (*p == 'L') {
+                lmod = 4;
+            }
+            p++;
+        }
+        if (!ok) {
+            break;
+        }
+        switch (*p) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o':
+        case 'c':
+            if (lmod == 2) {
+                ll = va_arg(args, long long);
+                ok = log_bin_put(body, &off, max, &ll, sizeof(ll));
+            } else if (lmod == 3) {
+                sz = va_arg(args, size_t);
+                ok = log_bin_put(body, &off, max, &sz, sizeof(sz));
+            } else if (lmod == 1) {
+                l = va_arg(args, long);
+                ok = log_bin_put(body, &off, max, &l, sizeof(l));
+            } else {
+                i = va_arg(args, int);
+                ok = log_bin_put(body, &off, max, &i, sizeof(i));
+            }
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+        case 'a': case 'A':
+            if (lmod == 4) {
+                ld = va_arg(args, long double);
+                ok = log_bin_put(body, &off, max, &ld, sizeof(ld));
+            } else {
+                d = va_arg(args, double);
+                ok = log_bin_put(body, &off, max, &d, sizeof(d));
+            }
+            break;
+        case 'p': case 'n':
+            ptr = va_arg(args, void *);
+            ok = log_bin_put(body, &off, max, &ptr, sizeof(ptr));
+            break;
+        case 's':
+            str = va_arg(args, const char *);
+            if (!str) {
+                str = "(null)";
+            }
+            i = strlen(str);
+            if (off + i + 1 > max) {
+                i = max - off - 1;
+                ok = 0;
+            }
+            if (i >= 0) {
+                memcpy(body + off, str, i);
+                off += i;
+                body[off++] = '\0';
+            }
+            break;
+        case '\0':
+            p--;
+            break;
+        default:
+            break;
+        }
+    }
+    va_end(args);
+
+    log_append(log, module, level, buf, off);
+}
+
+/**
+ * Tells whether an entry body, as read after the header, is a binary entry
+ * written by log_printf_bin().
+ */
+int
+log_entry_is_bin(const void *body, int len)
+{
+    return len >= 1 + sizeof(void *) &&
+           ((const uint8_t *)body)[0] == LOG_BIN_MARKER;
+}
+
 int
 log_walk(struct log *log, log_walk_func_t walk_func, void *arg)
 {
@@ -204,6 +486,60 @@ err:
     return (rc);
 }
 
+struct log_walk_cnt {
+    log_walk_func_t lwc_func;
+    void *lwc_arg;
+    uint64_t *lwc_cursor;
+    uint32_t lwc_cnt;
+};
+
+static int
+log_walk_cnt_func(struct log *log, void *arg, void *dptr, uint16_t len)
+{
+    struct log_walk_cnt *lwc;
+    int rc;
+
+    lwc = arg;
+    if (++lwc->lwc_cnt <= *lwc->lwc_cursor) {
+        return 0;
+    }
+    rc = lwc->lwc_func(log, lwc->lwc_arg, dptr, len);
+    if (rc == 0) {
+        *lwc->lwc_cursor = lwc->lwc_cnt;
+    }
+    return rc;
+}
+
+/**
+ * Walks the entries after the one at *cursor, and leaves *cursor at the
+ * last entry walk_func returned 0 for, so that a later call resumes after
+ * it. If the log handler cannot locate an entry directly, the cursor is the
+ * number of entries walked, and entries before it are skipped over.
+ *
+ * @param log       The log.
+ * @param walk_func Called for each entry; non-zero stops the walk.
+ * @param arg       Passed to walk_func.
+ * @param cursor    LOG_CURSOR_START to walk from the oldest entry.
+ *
+ * @return 0 on success; non-zero on error or from walk_func.
+ */
+int
+log_walk_from(struct log *log, log_walk_func_t walk_func, void *arg,
+        uint64_t *cursor)
+{
+    struct log_walk_cnt lwc;
+
+    if (log->l_log->log_walk_from) {
+        return log->l_log->log_walk_from(log, walk_func, arg, cursor);
+    }
+
+    lwc.lwc_func = walk_func;
+    lwc.lwc_arg = arg;
+    lwc.lwc_cursor = cursor;
+    lwc.lwc_cnt = 0;
+    return log_walk(log, log_walk_cnt_func, &lwc);
+}
+
 int
 log_read(struct log *log, void *dptr, void *buf, uint16_t off,
         uint16_t len)
@@ -38,6 +38,13 @@ log_console_append(struct log *log, void *buf, int len)
                 hdr->ue_level);
     }
 
+    if (log_entry_is_bin((char *) buf + LOG_ENTRY_HDR_SIZE,
+                         len - LOG_ENTRY_HDR_SIZE)) {
+        console_printf("<binary, %d bytes>\n",
+                       (int)(len - LOG_ENTRY_HDR_SIZE));
+        return (0);
+    }
+
     console_write((char *) buf + LOG_ENTRY_HDR_SIZE, len - LOG_ENTRY_HDR_SIZE);
 
     return (0);
@@ -32,11 +32,15 @@
 
 static struct flash_area sector;
 
+/*
+ * Makes room for an entry of given length, or for a staged batch if one is
+ * given, and writes the batch.
+ */
 static int
-log_fcb_append(struct log *log, void *buf, int len)
+log_fcb_reserve(struct log *log, struct fcb_batch *batch, int len,
+                struct fcb_entry *loc)
 {
     struct fcb *fcb;
-    struct fcb_entry loc;
     struct fcb_log *fcb_log;
     int rc;
 
@@ -44,28 +48,60 @@ log_fcb_append(struct log *log, void *buf, int len)
     fcb = &fcb_log->fl_fcb;
 
     while (1) {
-        rc = fcb_append(fcb, len, &loc);
+#if MYNEWT_VAL(LOG_FCB_STAGE_SIZE) > 0
+        if (batch) {
+            rc = fcb_batch_write(fcb, batch);
+        } else
+#endif
+        rc = fcb_append(fcb, len, loc);
         if (rc == 0) {
             break;
         }
 
         if (rc != FCB_ERR_NOSPACE) {
-            goto err;
+            break;
         }
 
         if (log->l_log->log_rtr_erase && fcb_log->fl_entries) {
             rc = log->l_log->log_rtr_erase(log, fcb_log);
             if (rc) {
-                goto err;
+                break;
             }
             continue;
         }
 
         rc = fcb_rotate(fcb);
         if (rc) {
-            goto err;
+            break;
         }
     }
+    return rc;
+}
+
+static int
+log_fcb_append(struct log *log, void *buf, int len)
+{
+    struct fcb *fcb;
+    struct fcb_entry loc;
+    int rc;
+#if MYNEWT_VAL(LOG_FCB_STAGE_SIZE) > 0
+    uint8_t stage_buf[MYNEWT_VAL(LOG_FCB_STAGE_SIZE)];
+    struct fcb_batch batch;
+#endif
+
+    fcb = &((struct fcb_log *)log->l_arg)->fl_fcb;
+
+#if MYNEWT_VAL(LOG_FCB_STAGE_SIZE) > 0
+    fcb_batch_init(&batch, stage_buf, sizeof(stage_buf));
+    if (fcb_batch_add(fcb, &batch, buf, len) == 0) {
+        return log_fcb_reserve(log, &batch, len, NULL);
+    }
+#endif
+
+    rc = log_fcb_reserve(log, NULL, len, &loc);
+    if (rc) {
+        goto err;
+    }
 
     rc = flash_area_write(loc.fe_area, loc.fe_data_off, buf, len);
     if (rc) {
@@ -78,14 +114,174 @@ err:
     return (rc);
 }
 
+#if MYNEWT_VAL(LOG_FCB_COMPRESS_BLOCK) > 0
+/*
+ * Compressed record starts with LOG_ENTRY_HDR_SIZE bytes of 0xff, which no
+ * entry header has, then the length of the raw data and the LZ stream. Raw
+ * data is a sequence of entries, each preceded by its 2 byte length.
+ */
+#define LOG_FCB_Z_BLOCK         MYNEWT_VAL(LOG_FCB_COMPRESS_BLOCK)
+#define LOG_FCB_Z_HDR_SIZE      (LOG_ENTRY_HDR_SIZE + 2)
+#define LOG_FCB_Z_MAX_ENTRIES   255
+
+/*
+ * Write buffers are only used by log_fcb_append_batch(), which the log ring
+ * task calls. Read buffers are shared by walks, under the mutex; a zeroed
+ * os_mutex is an initialized one.
+ */
+static uint8_t log_fcb_zw_raw[LOG_FCB_Z_BLOCK];
+static uint8_t log_fcb_zw_buf[LOG_FCB_Z_HDR_SIZE + LOG_FCB_Z_BLOCK];
+static uint8_t log_fcb_zr_raw[LOG_FCB_Z_BLOCK];
+static uint8_t log_fcb_zr_buf[LOG_FCB_Z_HDR_SIZE + LOG_FCB_Z_BLOCK];
+static struct os_mutex log_fcb_zr_mtx;
+#endif
+
+/*
+ * Location of an entry passed to walk functions.
+ */
+struct log_fcb_dptr {
+    struct fcb_entry ld_loc;
+#if MYNEWT_VAL(LOG_FCB_COMPRESS_BLOCK) > 0
+    uint8_t *ld_data;           /* Entry expanded in RAM, or NULL */
+    uint16_t ld_len;
+#endif
+};
+
+#if MYNEWT_VAL(LOG_FCB_STAGE_SIZE) > 0
+/*
+ * Stages as many entries as fit together, and writes them with one FCB
+ * batch write. Sets *used to the number of entries written.
+ */
+static int
+log_fcb_append_staged(struct log *log, struct log_buf *bufs, int cnt,
+                      int *used)
+{
+    uint8_t stage_buf[MYNEWT_VAL(LOG_FCB_STAGE_SIZE)];
+    struct fcb_batch batch;
+    struct fcb *fcb;
+    int i;
+
+    fcb = &((struct fcb_log *)log->l_arg)->fl_fcb;
+
+    fcb_batch_init(&batch, stage_buf, sizeof(stage_buf));
+    for (i = 0; i < cnt; i++) {
+        if (fcb_batch_add(fcb, &batch, bufs[i].lb_data, bufs[i].lb_len)) {
+            break;
+        }
+    }
+    if (i == 0) {
+        /*
+         * Too long to stage.
+         */
+        *used = 1;
+        return log_fcb_append(log, bufs[0].lb_data, bufs[0].lb_len);
+    }
+    *used = i;
+    return log_fcb_reserve(log, &batch, 0, NULL);
+}
+#endif
+
+#if MYNEWT_VAL(LOG_FCB_COMPRESS_BLOCK) > 0
+/*
+ * Compresses as many entries as fit in a block into one record. Sets *used
+ * to the number of entries written; 0 if they did not compress.
+ */
+static int
+log_fcb_append_z(struct log *log, struct log_buf *bufs, int cnt, int *used)
+{
+    int raw_len;
+    int zlen;
+    int i;
+
+    *used = 0;
+    raw_len = 0;
+    for (i = 0; i < cnt && i < LOG_FCB_Z_MAX_ENTRIES; i++) {
+        if (raw_len + 2 + bufs[i].lb_len > LOG_FCB_Z_BLOCK) {
+            break;
+        }
+        log_fcb_zw_raw[raw_len] = bufs[i].lb_len;
+        log_fcb_zw_raw[raw_len + 1] = bufs[i].lb_len >> 8;
+        memcpy(log_fcb_zw_raw + raw_len + 2, bufs[i].lb_data, bufs[i].lb_len);
+        raw_len += 2 + bufs[i].lb_len;
+    }
+    if (i < 2) {
+        return 0;
+    }
+
+    /*
+     * Must come out shorter than the entries written one by one.
+     */
+    zlen = log_lz_compress(log_fcb_zw_raw, raw_len,
+                           log_fcb_zw_buf + LOG_FCB_Z_HDR_SIZE,
+                           raw_len - 2 * i - LOG_FCB_Z_HDR_SIZE - 1);
+    if (zlen < 0) {
+        return 0;
+    }
+    memset(log_fcb_zw_buf, 0xff, LOG_ENTRY_HDR_SIZE);
+    log_fcb_zw_buf[LOG_ENTRY_HDR_SIZE] = raw_len;
+    log_fcb_zw_buf[LOG_ENTRY_HDR_SIZE + 1] = raw_len >> 8;
+
+    *used = i;
+    return log_fcb_append(log, log_fcb_zw_buf, LOG_FCB_Z_HDR_SIZE + zlen);
+}
+#endif
+
+#if MYNEWT_VAL(LOG_FCB_STAGE_SIZE) > 0 || \
+    MYNEWT_VAL(LOG_FCB_COMPRESS_BLOCK) > 0
+static int
+log_fcb_append_batch(struct log *log, struct log_buf *bufs, int cnt)
+{
+    int used;
+    int rc;
+    int i;
+
+    i = 0;
+    while (i < cnt) {
+#if MYNEWT_VAL(LOG_FCB_COMPRESS_BLOCK) > 0
+        rc = log_fcb_append_z(log, bufs + i, cnt - i, &used);
+        if (rc) {
+            return rc;
+        }
+        if (used) {
+            i += used;
+            continue;
+        }
+#endif
+#if MYNEWT_VAL(LOG_FCB_STAGE_SIZE) > 0
+        rc = log_fcb_append_staged(log, bufs + i, cnt - i, &used);
+#else
+        rc = log_fcb_append(log, bufs[i].lb_data, bufs[i].lb_len);
+        used = 1;
+#endif
+        if (rc) {
+            return rc;
+        }
+        i += used;
+    }
+    return 0;
+}
+#endif
+
 static int
 log_fcb_read(struct log *log, void *dptr, void *buf, uint16_t offset,
   uint16_t len)
 {
     struct fcb_entry *loc;
     int rc;
+#if MYNEWT_VAL(LOG_FCB_COMPRESS_BLOCK) > 0
+    struct log_fcb_dptr *ld;
+
+    ld = (struct log_fcb_dptr *)dptr;
+    if (ld->ld_data) {
+        if (offset + len > ld->ld_len) {
+            len = ld->ld_len - offset;
+        }
+        memcpy(buf, ld->ld_data + offset, len);
+        return len;
+    }
+#endif
 
-    loc = (struct fcb_entry *)dptr;
+    loc = &((struct log_fcb_dptr *)dptr)->ld_loc;
 
     if (offset + len > loc->fe_data_len) {
         len = loc->fe_data_len - offset;
@@ -98,20 +294,156 @@ log_fcb_read(struct log *log, void *dptr, void *buf, uint16_t offset,
     }
 }
 
+/*
+ * Cursor is the sector number plus one, the record offset within the
+ * sector, and for compressed records the number of its entries walked.
+ */
+#define LOG_FCB_CURSOR(fcb, loc, sub)                                   \
+    (((uint64_t)((loc)->fe_area - (fcb)->f_sectors + 1) << 40) |        \
+     ((uint64_t)(loc)->fe_elem_off << 8) | (sub))
+
+#if MYNEWT_VAL(LOG_FCB_COMPRESS_BLOCK) > 0
 static int
-log_fcb_walk(struct log *log, log_walk_func_t walk_func, void *arg)
+log_fcb_is_z(struct fcb_entry *loc)
+{
+    uint8_t hdr[LOG_ENTRY_HDR_SIZE];
+    int i;
+
+    if (loc->fe_data_len < LOG_FCB_Z_HDR_SIZE ||
+        flash_area_read(loc->fe_area, loc->fe_data_off, hdr, sizeof(hdr))) {
+        return 0;
+    }
+    for (i = 0; i < sizeof(hdr); i++) {
+        if (hdr[i] != 0xff) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+ * Expands a compressed record, and walks its entries after the first
+ * 'skip'. A record which does not expand is skipped.
+ */
+static int
+log_fcb_walk_z(struct log *log, struct log_fcb_dptr *ld,
+               log_walk_func_t walk_func, void *arg, uint64_t *cursor,
+               int skip)
+{
+    struct fcb *fcb;
+    int raw_len;
+    int elen;
+    int off;
+    int rc;
+    int n;
+
+    fcb = &((struct fcb_log *)log->l_arg)->fl_fcb;
+    rc = 0;
+
+    os_mutex_pend(&log_fcb_zr_mtx, OS_TIMEOUT_NEVER);
+    if (ld->ld_loc.fe_data_len > sizeof(log_fcb_zr_buf) ||
+        flash_area_read(ld->ld_loc.fe_area, ld->ld_loc.fe_data_off,
+                        log_fcb_zr_buf, ld->ld_loc.fe_data_len)) {
+        goto out;
+    }
+    raw_len = log_fcb_zr_buf[LOG_ENTRY_HDR_SIZE] |
+              (log_fcb_zr_buf[LOG_ENTRY_HDR_SIZE + 1] << 8);
+    if (log_lz_decompress(log_fcb_zr_buf + LOG_FCB_Z_HDR_SIZE,
+                          ld->ld_loc.fe_data_len - LOG_FCB_Z_HDR_SIZE,
+                          log_fcb_zr_raw, sizeof(log_fcb_zr_raw)) != raw_len) {
+        goto out;
+    }
+
+    off = 0;
+    n = 0;
+    while (off + 2 <= raw_len) {
+        elen = log_fcb_zr_raw[off] | (log_fcb_zr_raw[off + 1] << 8);
+        off += 2;
+        if (off + elen > raw_len) {
+            break;
+        }
+        if (++n > skip) {
+            ld->ld_data = log_fcb_zr_raw + off;
+            ld->ld_len = elen;
+            rc = walk_func(log, arg, (void *) ld, elen);
+            if (rc) {
+                break;
+            }
+            *cursor = LOG_FCB_CURSOR(fcb, &ld->ld_loc, n);
+        }
+        off += elen;
+    }
+    ld->ld_data = NULL;
+out:
+    os_mutex_release(&log_fcb_zr_mtx);
+    return rc;
+}
+#endif
+
+/*
+ * Walks the entries of one record, after the first 'skip'.
+ */
+static int
+log_fcb_walk_record(struct log *log, struct log_fcb_dptr *ld,
+                    log_walk_func_t walk_func, void *arg, uint64_t *cursor,
+                    int skip)
 {
     struct fcb *fcb;
-    struct fcb_entry loc;
+    int rc;
+
+#if MYNEWT_VAL(LOG_FCB_COMPRESS_BLOCK) > 0
+    if (log_fcb_is_z(&ld->ld_loc)) {
+        return log_fcb_walk_z(log, ld, walk_func, arg, cursor, skip);
+    }
+#endif
+    if (skip) {
+        return 0;
+    }
+
+    fcb = &((struct fcb_log *)log->l_arg)->fl_fcb;
+    rc = walk_func(log, arg, (void *) ld, ld->ld_loc.fe_data_len);
+    if (rc == 0) {
+        *cursor = LOG_FCB_CURSOR(fcb, &ld->ld_loc, 0);
+    }
+    return rc;
+}
+
+static int
+log_fcb_walk_from(struct log *log, log_walk_func_t walk_func, void *arg,
+                  uint64_t *cursor)
+{
+    struct fcb *fcb;
+    struct log_fcb_dptr ld;
+    uint32_t idx;
     int rc;
 
     rc = 0;
     fcb = &((struct fcb_log *)log->l_arg)->fl_fcb;
 
-    memset(&loc, 0, sizeof(loc));
+    memset(&ld, 0, sizeof(ld));
+    idx = *cursor >> 40;
+    if (idx > 0 && idx <= fcb->f_sector_cnt) {
+        ld.ld_loc.fe_area = &fcb->f_sectors[idx - 1];
+        ld.ld_loc.fe_elem_off = *cursor >> 8;
+        if (fcb_elem_info(fcb, &ld.ld_loc)) {
+            /*
+             * Entry has been rotated out; start from the oldest one.
+             */
+            memset(&ld, 0, sizeof(ld));
+        } else if (*cursor & 0xff) {
+            /*
+             * Rest of a compressed record.
+             */
+            rc = log_fcb_walk_record(log, &ld, walk_func, arg, cursor,
+                                     *cursor & 0xff);
+            if (rc) {
+                return (rc);
+            }
+        }
+    }
 
-    while (fcb_getnext(fcb, &loc) == 0) {
-        rc = walk_func(log, arg, (void *) &loc, loc.fe_data_len);
+    while (fcb_getnext(fcb, &ld.ld_loc) == 0) {
+        rc = log_fcb_walk_record(log, &ld, walk_func, arg, cursor, 0);
         if (rc) {
             break;
         }
@@ -119,6 +451,15 @@ log_fcb_walk(struct log *log, log_walk_func_t walk_func, void *arg)
     return (rc);
 }
 
+static int
+log_fcb_walk(struct log *log, log_walk_func_t walk_func, void *arg)
+{
+    uint64_t cursor;
+
+    cursor = LOG_CURSOR_START;
+    return log_fcb_walk_from(log, walk_func, arg, &cursor);
+}
+
 static int
 log_fcb_flush(struct log *log)
 {
@@ -126,7 +467,7 @@ log_fcb_flush(struct log *log)
 }
 
 /**
- * Copies one log entry from source fcb to destination fcb
+ * Copies one log record, as it is, from source fcb to destination fcb
  * @param src_fcb, dst_fcb
  * @return 0 on success; non-zero on error
  */
@@ -134,34 +475,31 @@ static int
 log_fcb_copy_entry(struct log *log, struct fcb_entry *entry,
                    struct fcb *dst_fcb)
 {
-    struct log_entry_hdr ueh;
-    char data[LOG_PRINTF_MAX_ENTRY_LEN + sizeof(ueh)];
-    int dlen;
+    uint8_t data[64];
+    struct fcb_entry loc;
+    int off;
+    int len;
     int rc;
-    struct fcb *fcb_tmp;
 
-    rc = log_fcb_read(log, entry, &ueh, 0, sizeof(ueh));
-    if (rc != sizeof(ueh)) {
+    rc = fcb_append(dst_fcb, entry->fe_data_len, &loc);
+    if (rc) {
         goto err;
     }
 
-    dlen = min(entry->fe_data_len, LOG_PRINTF_MAX_ENTRY_LEN + sizeof(ueh));
-
-    rc = log_fcb_read(log, entry, data, 0, dlen);
-    if (rc < 0) {
-        goto err;
+    for (off = 0; off < entry->fe_data_len; off += len) {
+        len = min(entry->fe_data_len - off, sizeof(data));
+        rc = flash_area_read(entry->fe_area, entry->fe_data_off + off, data,
+                             len);
+        if (rc) {
+            goto err;
+        }
+        rc = flash_area_write(loc.fe_area, loc.fe_data_off + off, data, len);
+        if (rc) {
+            goto err;
+        }
     }
-    data[rc] = '\0';
 
-    /* Changing the fcb to be logged to be dst fcb */
-    fcb_tmp = &((struct fcb_log *)log->l_arg)->fl_fcb;
-
-    log->l_arg = dst_fcb;
-    rc = log_fcb_append(log, data, dlen);
-    log->l_arg = fcb_tmp;
-    if (rc) {
-        goto err;
-    }
+    rc = fcb_append_finish(dst_fcb, &loc);
 
 err:
     return (rc);
@@ -270,6 +608,11 @@ const struct log_handler log_fcb_handler = {
     .log_walk = log_fcb_walk,
     .log_flush = log_fcb_flush,
     .log_rtr_erase = log_fcb_rtr_erase,
+    .log_walk_from = log_fcb_walk_from,
+#if MYNEWT_VAL(LOG_FCB_STAGE_SIZE) > 0 || \
+    MYNEWT_VAL(LOG_FCB_COMPRESS_BLOCK) > 0
+    .log_append_batch = log_fcb_append_batch,
+#endif
 };
 
 #endif
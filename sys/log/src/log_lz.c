@@ -0,0 +1,162 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(LOG_FCB_COMPRESS_BLOCK) > 0
+
+#include <string.h>
+
+#include "os/os.h"
+#include "log/log.h"
+
+/*
+ * Byte oriented LZ77. The stream is a sequence of tokens:
+ *  0x00 - 0x7f: literal run; token + 1 bytes follow.
+ *  0x80 - 0xff: match of (token & 0x7f) + 3 bytes, copied from the output
+ *               at the distance in the 2 bytes that follow, little endian.
+ */
+#define LOG_LZ_MIN_MATCH    3
+#define LOG_LZ_MAX_MATCH    (0x7f + LOG_LZ_MIN_MATCH)
+#define LOG_LZ_MAX_LIT      0x80
+#define LOG_LZ_HASH_BITS    8
+#define LOG_LZ_NONE         0xffff
+
+static int
+log_lz_hash(const uint8_t *p)
+{
+    uint32_t v;
+
+    v = p[0] | (p[1] << 8) | (p[2] << 16);
+    return (v * 2654435761u) >> (32 - LOG_LZ_HASH_BITS);
+}
+
+static int
+log_lz_literals(uint8_t *dst, int off, int dst_len, const uint8_t *src, int n)
+{
+    int cnt;
+
+    while (n > 0) {
+        cnt = min(n, LOG_LZ_MAX_LIT);
+        if (off + 1 + cnt > dst_len) {
+            return -1;
+        }
+        dst[off++] = cnt - 1;
+        memcpy(dst + off, src, cnt);
+        off += cnt;
+        src += cnt;
+        n -= cnt;
+    }
+    return off;
+}
+
+/**
+ * Compresses a block of at most 65534 bytes.
+ *
+ * @return Length of compressed data; -1 if it does not fit in dst.
+ */
+int
+log_lz_compress(const uint8_t *src, int len, uint8_t *dst, int dst_len)
+{
+    uint16_t table[1 << LOG_LZ_HASH_BITS];
+    int cand;
+    int mlen;
+    int dist;
+    int lit;
+    int off;
+    int h;
+    int i;
+
+    memset(table, 0xff, sizeof(table));
+    off = 0;
+    lit = 0;
+    i = 0;
+    while (i + LOG_LZ_MIN_MATCH <= len) {
+        h = log_lz_hash(src + i);
+        cand = table[h];
+        table[h] = i;
+        if (cand == LOG_LZ_NONE ||
+          memcmp(src + cand, src + i, LOG_LZ_MIN_MATCH)) {
+            i++;
+            continue;
+        }
+        mlen = LOG_LZ_MIN_MATCH;
+        while (i + mlen < len && mlen < LOG_LZ_MAX_MATCH &&
+          src[cand + mlen] == src[i + mlen]) {
+            mlen++;
+        }
+        off = log_lz_literals(dst, off, dst_len, src + lit, i - lit);
+        if (off < 0 || off + 3 > dst_len) {
+            return -1;
+        }
+        dist = i - cand;
+        dst[off++] = 0x80 | (mlen - LOG_LZ_MIN_MATCH);
+        dst[off++] = dist;
+        dst[off++] = dist >> 8;
+        i += mlen;
+        lit = i;
+    }
+    return log_lz_literals(dst, off, dst_len, src + lit, len - lit);
+}
+
+/**
+ * Decompresses a block.
+ *
+ * @return Length of decompressed data; -1 if the data is corrupt, or does
+ *         not fit in dst.
+ */
+int
+log_lz_decompress(const uint8_t *src, int len, uint8_t *dst, int dst_len)
+{
+    int dist;
+    int off;
+    int in;
+    int n;
+    int c;
+
+    off = 0;
+    in = 0;
+    while (in < len) {
+        c = src[in++];
+        if (c < 0x80) {
+            n = c + 1;
+            if (in + n > len || off + n > dst_len) {
+                return -1;
+            }
+            memcpy(dst + off, src + in, n);
+            in += n;
+        } else {
+            if (in + 2 > len) {
+                return -1;
+            }
+            n = (c & 0x7f) + LOG_LZ_MIN_MATCH;
+            dist = src[in] | (src[in + 1] << 8);
+            in += 2;
+            if (dist == 0 || dist > off || off + n > dst_len) {
+                return -1;
+            }
+            for (c = 0; c < n; c++) {
+                dst[off + c] = dst[off - dist + c];
+            }
+        }
+        off += n;
+    }
+    return off;
+}
+
+#endif
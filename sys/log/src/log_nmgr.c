@@ -58,9 +58,41 @@ struct encode_off {
     CborEncoder *eo_encoder;
     int64_t eo_ts;
     uint8_t eo_index;
+    uint8_t eo_level;           /* Lowest level to return */
+    int16_t eo_module;          /* Module to return; -1 for all */
     uint32_t rsp_len;
 };
 
+/*
+ * Encodes one entry. Text entries go in "msg", binary entries in "bin".
+ */
+static CborError
+log_nmgr_encode_map(CborEncoder *enc, struct log_entry_hdr *ueh, char *data,
+                    int dlen)
+{
+    CborError g_err = CborNoError;
+    CborEncoder rsp;
+
+    g_err |= cbor_encoder_create_map(enc, &rsp, CborIndefiniteLength);
+    if (log_entry_is_bin(data, dlen)) {
+        g_err |= cbor_encode_text_stringz(&rsp, "bin");
+        g_err |= cbor_encode_byte_string(&rsp, (uint8_t *)data, dlen);
+    } else {
+        g_err |= cbor_encode_text_stringz(&rsp, "msg");
+        g_err |= cbor_encode_text_stringz(&rsp, data);
+    }
+    g_err |= cbor_encode_text_stringz(&rsp, "ts");
+    g_err |= cbor_encode_int(&rsp, ueh->ue_ts);
+    g_err |= cbor_encode_text_stringz(&rsp, "level");
+    g_err |= cbor_encode_uint(&rsp, ueh->ue_level);
+    g_err |= cbor_encode_text_stringz(&rsp, "index");
+    g_err |= cbor_encode_uint(&rsp,  ueh->ue_index);
+    g_err |= cbor_encode_text_stringz(&rsp, "module");
+    g_err |= cbor_encode_uint(&rsp,  ueh->ue_module);
+    g_err |= cbor_encoder_close_container(enc, &rsp);
+    return g_err;
+}
+
 /**
  * Log encode entry
  * @param log structure, arg:struct passed locally, dataptr, len
@@ -71,13 +103,12 @@ log_nmgr_encode_entry(struct log *log, void *arg, void *dptr, uint16_t len)
 {
     struct encode_off *encode_off = (struct encode_off *)arg;
     struct log_entry_hdr ueh;
-    char data[128];
+    char data[128 + 1];
     int dlen;
     int rc;
     int rsp_len;
     CborError g_err = CborNoError;
     CborEncoder *penc = encode_off->eo_encoder;
-    CborEncoder rsp;
     struct CborCntWriter cnt_writer;
     CborEncoder cnt_encoder;
 
@@ -87,6 +118,7 @@ log_nmgr_encode_entry(struct log *log, void *arg, void *dptr, uint16_t len)
         goto err;
     }
     rc = OS_OK;
+    ueh.ue_ts = log_ts_usec(ueh.ue_ts);
 
     /* Matching timestamps and indices for sending a log entry */
     if (ueh.ue_ts < encode_off->eo_ts   ||
@@ -94,6 +126,11 @@ log_nmgr_encode_entry(struct log *log, void *arg, void *dptr, uint16_t len)
          ueh.ue_index <= encode_off->eo_index)) {
         goto err;
     }
+    if (ueh.ue_level < encode_off->eo_level ||
+        (encode_off->eo_module >= 0 &&
+         ueh.ue_module != encode_off->eo_module)) {
+        goto err;
+    }
 
     dlen = min(len-sizeof(ueh), 128);
 
@@ -102,6 +139,7 @@ log_nmgr_encode_entry(struct log *log, void *arg, void *dptr, uint16_t len)
         rc = OS_ENOENT;
         goto err;
     }
+    dlen = rc;
     data[rc] = 0;
 
     /*calculate whether this would fit */
@@ -109,19 +147,7 @@ log_nmgr_encode_entry(struct log *log, void *arg, void *dptr, uint16_t len)
     cbor_cnt_writer_init(&cnt_writer);
     cbor_encoder_init(&cnt_encoder, &cnt_writer.enc, 0);
 
-    /* NOTE This code should exactly match what is below */
-    g_err |= cbor_encoder_create_map(&cnt_encoder, &rsp, CborIndefiniteLength);
-    g_err |= cbor_encode_text_stringz(&rsp, "msg");
-    g_err |= cbor_encode_text_stringz(&rsp, data);
-    g_err |= cbor_encode_text_stringz(&rsp, "ts");
-    g_err |= cbor_encode_int(&rsp, ueh.ue_ts);
-    g_err |= cbor_encode_text_stringz(&rsp, "level");
-    g_err |= cbor_encode_uint(&rsp, ueh.ue_level);
-    g_err |= cbor_encode_text_stringz(&rsp, "index");
-    g_err |= cbor_encode_uint(&rsp,  ueh.ue_index);
-    g_err |= cbor_encode_text_stringz(&rsp, "module");
-    g_err |= cbor_encode_uint(&rsp,  ueh.ue_module);
-    g_err |= cbor_encoder_close_container(&cnt_encoder, &rsp);
+    g_err |= log_nmgr_encode_map(&cnt_encoder, &ueh, data, dlen);
     rsp_len = encode_off->rsp_len;
     rsp_len += cbor_encode_bytes_written(&cnt_encoder);
     if (rsp_len > 400) {
@@ -130,18 +156,7 @@ log_nmgr_encode_entry(struct log *log, void *arg, void *dptr, uint16_t len)
     }
     encode_off->rsp_len = rsp_len;
 
-    g_err |= cbor_encoder_create_map(penc, &rsp, CborIndefiniteLength);
-    g_err |= cbor_encode_text_stringz(&rsp, "msg");
-    g_err |= cbor_encode_text_stringz(&rsp, data);
-    g_err |= cbor_encode_text_stringz(&rsp, "ts");
-    g_err |= cbor_encode_int(&rsp, ueh.ue_ts);
-    g_err |= cbor_encode_text_stringz(&rsp, "level");
-    g_err |= cbor_encode_uint(&rsp, ueh.ue_level);
-    g_err |= cbor_encode_text_stringz(&rsp, "index");
-    g_err |= cbor_encode_uint(&rsp,  ueh.ue_index);
-    g_err |= cbor_encode_text_stringz(&rsp, "module");
-    g_err |= cbor_encode_uint(&rsp,  ueh.ue_module);
-    g_err |= cbor_encoder_close_container(penc, &rsp);
+    g_err |= log_nmgr_encode_map(penc, &ueh, data, dlen);
 
     if (g_err) {
         return MGMT_ERR_ENOMEM;
@@ -151,14 +166,26 @@ err:
     return (rc);
 }
 
+/*
+ * Filters and resume point of a read request.
+ */
+struct log_nmgr_filter {
+    int64_t lnf_ts;
+    uint64_t lnf_index;
+    uint64_t lnf_level;
+    int64_t lnf_module;
+    uint64_t lnf_cursor;        /* LOG_NMGR_NO_CURSOR if not given */
+};
+#define LOG_NMGR_NO_CURSOR  UINT64_MAX
+
 /**
  * Log encode entries
- * @param log structure, the encoder, timestamp, index
+ * @param log structure, the encoder, filters, cursor to resume at
  * @return 0 on success; non-zero on failure
  */
 static int
 log_encode_entries(struct log *log, CborEncoder *cb,
-                   int64_t ts, uint32_t index)
+                   struct log_nmgr_filter *f, uint64_t *cursor)
 {
     int rc;
     struct encode_off encode_off;
@@ -189,11 +216,13 @@ log_encode_entries(struct log *log, CborEncoder *cb,
     g_err |= cbor_encoder_create_array(cb, &entries, CborIndefiniteLength);
 
     encode_off.eo_encoder  = &entries;
-    encode_off.eo_index    = index;
-    encode_off.eo_ts       = ts;
+    encode_off.eo_index    = f->lnf_index;
+    encode_off.eo_ts       = f->lnf_ts;
+    encode_off.eo_level    = f->lnf_level;
+    encode_off.eo_module   = f->lnf_module;
     encode_off.rsp_len = rsp_len;
 
-    rc = log_walk(log, log_nmgr_encode_entry, &encode_off);
+    rc = log_walk_from(log, log_nmgr_encode_entry, &encode_off, cursor);
 
     g_err |= cbor_encoder_close_container(cb, &entries);
 
@@ -203,14 +232,13 @@ err:
 
 /**
  * Log encode function
- * @param log structure, the encoder, json_value,
- *        timestamp, index
+ * @param log structure, the encoder, filters and cursor
  * @return 0 on success; non-zero on failure
  */
 static int
-log_encode(struct log *log, CborEncoder *cb,
-            int64_t ts, uint32_t index)
+log_encode(struct log *log, CborEncoder *cb, struct log_nmgr_filter *f)
 {
+    uint64_t cursor;
     int rc;
     CborEncoder logs;
     CborError g_err = CborNoError;
@@ -222,7 +250,23 @@ log_encode(struct log *log, CborEncoder *cb,
     g_err |= cbor_encode_text_stringz(&logs, "type");
     g_err |= cbor_encode_uint(&logs, log->l_log->log_type);
 
-    rc = log_encode_entries(log, &logs, ts, index);
+    if (f->lnf_cursor == LOG_NMGR_NO_CURSOR) {
+        cursor = LOG_CURSOR_START;
+    } else {
+        cursor = f->lnf_cursor;
+    }
+    rc = log_encode_entries(log, &logs, f, &cursor);
+    if (f->lnf_cursor != LOG_NMGR_NO_CURSOR) {
+        /*
+         * Streaming read; a full response is not an error, the client
+         * resumes at "next".
+         */
+        if (rc == OS_ENOMEM) {
+            rc = 0;
+        }
+        g_err |= cbor_encode_text_stringz(&logs, "next");
+        g_err |= cbor_encode_uint(&logs, cursor);
+    }
     g_err |= cbor_encoder_close_container(cb, &logs);
     if (g_err) {
         return MGMT_ERR_ENOMEM;
@@ -242,13 +286,12 @@ log_nmgr_read(struct mgmt_cbuf *cb)
     int rc;
     char name[LOG_NAME_MAX_LEN] = {0};
     int name_len;
-    int64_t ts;
-    uint64_t index;
+    struct log_nmgr_filter f;
     CborError g_err = CborNoError;
     CborEncoder *penc = &cb->encoder;
     CborEncoder rsp, logs;
 
-    const struct cbor_attr_t attr[4] = {
+    const struct cbor_attr_t attr[7] = {
         [0] = {
             .attribute = "log_name",
             .type = CborAttrTextStringType,
@@ -258,18 +301,40 @@ log_nmgr_read(struct mgmt_cbuf *cb)
         [1] = {
             .attribute = "ts",
             .type = CborAttrIntegerType,
-            .addr.integer = &ts
+            .addr.integer = &f.lnf_ts
         },
         [2] = {
             .attribute = "index",
             .type = CborAttrUnsignedIntegerType,
-            .addr.uinteger = &index
+            .addr.uinteger = &f.lnf_index
         },
         [3] = {
+            .attribute = "level",
+            .type = CborAttrUnsignedIntegerType,
+            .addr.uinteger = &f.lnf_level
+        },
+        [4] = {
+            .attribute = "module",
+            .type = CborAttrIntegerType,
+            .addr.integer = &f.lnf_module,
+            .nodefault = true
+        },
+        [5] = {
+            .attribute = "cursor",
+            .type = CborAttrUnsignedIntegerType,
+            .addr.uinteger = &f.lnf_cursor,
+            .nodefault = true
+        },
+        [6] = {
             .attribute = NULL
         }
     };
 
+    f.lnf_ts = 0;
+    f.lnf_index = 0;
+    f.lnf_level = 0;
+    f.lnf_module = -1;
+    f.lnf_cursor = LOG_NMGR_NO_CURSOR;
     rc = cbor_read_object(&cb->it, attr);
     if (rc) {
         return rc;
@@ -298,7 +363,7 @@ log_nmgr_read(struct mgmt_cbuf *cb)
             continue;
         }
 
-        rc = log_encode(log, &logs, ts, index);
+        rc = log_encode(log, &logs, &f);
         if (rc) {
             goto err;
         }
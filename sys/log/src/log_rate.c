@@ -0,0 +1,332 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "syscfg/syscfg.h"
+#include "log/log.h"
+
+#if LOG_SUPPRESS
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "os/os.h"
+#include "stats/stats.h"
+
+STATS_SECT_START(log_stats)
+    STATS_SECT_ENTRY(rate_module_drops)
+    STATS_SECT_ENTRY(rate_site_drops)
+    STATS_SECT_ENTRY(dup_drops)
+    STATS_SECT_ENTRY(repeat_entries)
+STATS_SECT_END
+
+STATS_SECT_DECL(log_stats) log_stats;
+
+STATS_NAME_START(log_stats)
+    STATS_NAME(log_stats, rate_module_drops)
+    STATS_NAME(log_stats, rate_site_drops)
+    STATS_NAME(log_stats, dup_drops)
+    STATS_NAME(log_stats, repeat_entries)
+STATS_NAME_END(log_stats)
+
+/*
+ * Token buckets are kept as the time at which the bucket is full again
+ * (the "theoretical arrival time").  Each entry moves it forward by one
+ * period, and an entry is let through as long as it stays within the burst
+ * of the current time, so a call site needs only one word of state.
+ */
+struct log_rate_bucket {
+    os_time_t lrb_tat;
+    os_time_t lrb_period;
+    os_time_t lrb_tolerance;
+};
+
+#if MYNEWT_VAL(LOG_RATE_MODULES) > 0
+static struct log_rate_bucket log_rate_modules[MYNEWT_VAL(LOG_RATE_MODULES)];
+
+static void
+log_rate_bucket_set(struct log_rate_bucket *lrb, uint16_t per_sec,
+                    uint16_t burst)
+{
+    if (per_sec == 0) {
+        lrb->lrb_period = 0;
+        lrb->lrb_tolerance = 0;
+    } else {
+        lrb->lrb_period = OS_TICKS_PER_SEC / per_sec;
+        if (lrb->lrb_period == 0) {
+            lrb->lrb_period = 1;
+        }
+        lrb->lrb_tolerance = (burst > 0 ? burst - 1 : 0) * lrb->lrb_period;
+    }
+    lrb->lrb_tat = os_time_get();
+}
+#endif
+
+/*
+ * Tells whether an entry may pass, and if take is set, charges it to the
+ * bucket.
+ */
+static int
+log_rate_bucket_ok(os_time_t *tat, os_time_t period, os_time_t tolerance,
+                   int take)
+{
+    os_sr_t sr;
+    os_time_t now;
+    os_time_t ahead;
+    int ok;
+
+    if (period == 0) {
+        return 1;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    now = os_time_get();
+    ahead = *tat - now;
+
+    /*
+     * A bucket never runs more than a burst ahead of the clock; if it
+     * appears to, it has been idle for so long that the tick counter
+     * wrapped, and it is full.
+     */
+    if (OS_TIME_TICK_LT(*tat, now) || ahead > tolerance + period) {
+        *tat = now;
+        ahead = 0;
+    }
+    ok = ahead <= tolerance;
+    if (ok && take) {
+        *tat += period;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return ok;
+}
+
+#if MYNEWT_VAL(LOG_RATE_MODULES) > 0
+/**
+ * Limits the rate at which a module's entries are appended to any log.
+ * Entries over the limit are dropped and counted in the log stats.
+ *
+ * @param module  The module.
+ * @param per_sec Sustained entries per second; 0 removes the limit.
+ * @param burst   Entries that may be appended back to back.
+ *
+ * @return 0 on success; OS_EINVAL if the module has no bucket of its own.
+ */
+int
+log_rate_set(uint8_t module, uint16_t per_sec, uint16_t burst)
+{
+    if (module >= MYNEWT_VAL(LOG_RATE_MODULES)) {
+        return OS_EINVAL;
+    }
+    log_rate_bucket_set(&log_rate_modules[module], per_sec, burst);
+    return 0;
+}
+
+/*
+ * Tells whether an entry of the module would be appended, without charging
+ * for it.  Used to skip formatting entries that would be dropped anyway.
+ */
+int
+log_rate_module_peek(uint16_t module)
+{
+    struct log_rate_bucket *lrb;
+
+    if (module >= MYNEWT_VAL(LOG_RATE_MODULES)) {
+        return 1;
+    }
+    lrb = &log_rate_modules[module];
+    if (!log_rate_bucket_ok(&lrb->lrb_tat, lrb->lrb_period,
+                            lrb->lrb_tolerance, 0)) {
+        STATS_INC(log_stats, rate_module_drops);
+        return 0;
+    }
+    return 1;
+}
+
+int
+log_rate_module_take(uint16_t module)
+{
+    struct log_rate_bucket *lrb;
+
+    if (module >= MYNEWT_VAL(LOG_RATE_MODULES)) {
+        return 1;
+    }
+    lrb = &log_rate_modules[module];
+    if (!log_rate_bucket_ok(&lrb->lrb_tat, lrb->lrb_period,
+                            lrb->lrb_tolerance, 1)) {
+        STATS_INC(log_stats, rate_module_drops);
+        return 0;
+    }
+    return 1;
+}
+#endif
+
+#if MYNEWT_VAL(LOG_RATE_SITE)
+/**
+ * Charges an entry to the bucket of a LOG_<level>() call site.  The bucket
+ * is a static word the macro declares at the call site.
+ *
+ * @return 1 if the entry may be logged; 0 if it is to be dropped.
+ */
+int
+log_rate_site_ok(uint32_t *tat)
+{
+    os_time_t period;
+
+    period = OS_TICKS_PER_SEC / MYNEWT_VAL(LOG_RATE_SITE_PER_SEC);
+    if (period == 0) {
+        period = 1;
+    }
+    if (!log_rate_bucket_ok(tat, period,
+                            (MYNEWT_VAL(LOG_RATE_SITE_BURST) - 1) * period,
+                            1)) {
+        STATS_INC(log_stats, rate_site_drops);
+        return 0;
+    }
+    return 1;
+}
+#endif
+
+#if MYNEWT_VAL(LOG_DUP_SUPPRESS)
+static uint32_t
+log_dup_hash(uint16_t module, uint16_t level, const uint8_t *body, int len)
+{
+    uint32_t hash;
+    int i;
+
+    /* FNV-1a */
+    hash = 2166136261u ^ ((uint32_t)module << 8 | level);
+    for (i = 0; i < len; i++) {
+        hash ^= body[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/*
+ * Appends a "repeated N times" entry for the run of duplicates that ends,
+ * if any were dropped.
+ */
+static void
+log_dup_flush(struct log *log)
+{
+    uint8_t buf[LOG_ENTRY_HDR_SIZE + 40];
+    struct log_dup *ld;
+    int len;
+
+    ld = &log->l_dup;
+    if (ld->ld_cnt == 0) {
+        return;
+    }
+
+    len = snprintf((char *)&buf[LOG_ENTRY_HDR_SIZE],
+                   sizeof(buf) - LOG_ENTRY_HDR_SIZE,
+                   "last message repeated %lu times",
+                   (unsigned long)ld->ld_cnt);
+    ld->ld_cnt = 0;
+    STATS_INC(log_stats, repeat_entries);
+    log_append_entry(log, ld->ld_module, ld->ld_level, buf, len);
+}
+
+/**
+ * Collapses runs of identical entries appended to the log into the first
+ * entry and a single "last message repeated N times" entry.  A run is
+ * closed by a different entry, or by an identical one more than window_ms
+ * after the run started.
+ *
+ * @param log       The log.
+ * @param window_ms Longest run; 0 stops suppressing duplicates.
+ */
+void
+log_dup_window_set(struct log *log, uint32_t window_ms)
+{
+    os_time_t ticks;
+
+    log_dup_flush(log);
+    memset(&log->l_dup, 0, sizeof(log->l_dup));
+    if (window_ms > 0) {
+        os_time_ms_to_ticks(window_ms, &ticks);
+        log->l_dup.ld_window = ticks > 0 ? ticks : 1;
+    }
+}
+
+/*
+ * Checks an entry against the previous one appended to the log.
+ *
+ * @return 1 if the entry is a duplicate, and is to be dropped.
+ */
+int
+log_dup_check(struct log *log, uint16_t module, uint16_t level,
+              const void *body, uint16_t len)
+{
+    struct log_dup *ld;
+    os_time_t now;
+    uint32_t hash;
+
+    ld = &log->l_dup;
+    if (ld->ld_window == 0) {
+        return 0;
+    }
+
+    hash = log_dup_hash(module, level, body, len);
+    now = os_time_get();
+    if (ld->ld_valid && hash == ld->ld_hash &&
+        OS_TIME_TICK_LT(now, ld->ld_start + ld->ld_window)) {
+
+        ld->ld_cnt++;
+        STATS_INC(log_stats, dup_drops);
+        return 1;
+    }
+
+    log_dup_flush(log);
+    ld->ld_hash = hash;
+    ld->ld_start = now;
+    ld->ld_module = module;
+    ld->ld_level = level;
+    ld->ld_valid = 1;
+    return 0;
+}
+#endif
+
+/*
+ * Registers the log stats. Called once, from log_init().
+ */
+void
+log_rate_init(void)
+{
+    int rc;
+
+    rc = stats_init_and_reg(STATS_HDR(log_stats),
+                            STATS_SIZE_INIT_PARMS(log_stats, STATS_SIZE_32),
+                            STATS_NAME_INIT_PARMS(log_stats), "log");
+    assert(rc == 0);
+
+#if MYNEWT_VAL(LOG_RATE_MODULES) > 0
+    {
+        int i;
+
+        for (i = 0; i < MYNEWT_VAL(LOG_RATE_MODULES); i++) {
+            log_rate_bucket_set(&log_rate_modules[i],
+                                MYNEWT_VAL(LOG_RATE_PER_SEC),
+                                MYNEWT_VAL(LOG_RATE_BURST));
+        }
+    }
+#endif
+}
+
+#endif
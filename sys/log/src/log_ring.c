@@ -0,0 +1,214 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(LOG_RING_ENTRIES) > 0
+
+#include <assert.h>
+#include <string.h>
+
+#include "os/os.h"
+#include "log/log.h"
+
+#define LOG_RING_MASK   (MYNEWT_VAL(LOG_RING_ENTRIES) - 1)
+
+#if MYNEWT_VAL(LOG_RING_TASK)
+static struct os_eventq log_ring_evq;
+static struct os_event log_ring_ev;
+static struct os_task log_ring_task;
+static os_stack_t log_ring_stack[OS_STACK_ALIGN(MYNEWT_VAL(LOG_RING_STACK_SIZE))];
+
+static void
+log_ring_drain_all(struct os_event *ev)
+{
+    struct log *log;
+
+    log = NULL;
+    while ((log = log_list_get_next(log)) != NULL) {
+        if (log->l_ring) {
+            log_ring_drain(log);
+        }
+    }
+}
+
+static void
+log_ring_task_handler(void *arg)
+{
+    while (1) {
+        os_eventq_run(&log_ring_evq);
+    }
+}
+#endif
+
+/*
+ * Creates the task that drains log rings. Called once, from log_init().
+ */
+void
+log_ring_init(void)
+{
+#if MYNEWT_VAL(LOG_RING_TASK)
+    int rc;
+
+    os_eventq_init(&log_ring_evq);
+    log_ring_ev.ev_cb = log_ring_drain_all;
+    rc = os_task_init(&log_ring_task, "log_ring", log_ring_task_handler, NULL,
+                      MYNEWT_VAL(LOG_RING_TASK_PRIO), OS_WAIT_FOREVER,
+                      log_ring_stack,
+                      OS_STACK_ALIGN(MYNEWT_VAL(LOG_RING_STACK_SIZE)));
+    assert(rc == 0);
+#endif
+}
+
+/**
+ * Puts a RAM ring in front of a log. Entries appended to the log after this
+ * are written out by the log ring task, or by log_ring_drain().
+ *
+ * @param log  The log.
+ * @param ring The ring to use; NULL to write entries directly again, once
+ *             the ring has been drained.
+ *
+ * @return 0 on success; non-zero on error
+ */
+int
+log_ring_attach(struct log *log, struct log_ring *ring)
+{
+    if (ring) {
+        memset(ring, 0, sizeof(*ring));
+    }
+    log->l_ring = ring;
+    return 0;
+}
+
+/*
+ * Copies an entry, with its header filled in, to the log's ring. Takes
+ * only a short critical section to claim a record, and can be called
+ * from an interrupt handler.
+ */
+int
+log_ring_put(struct log *log, void *data, int len)
+{
+    struct log_ring *ring;
+    struct log_ring_rec *rec;
+    os_sr_t sr;
+
+    ring = log->l_ring;
+    if (len > sizeof(rec->lrr_data)) {
+        OS_ENTER_CRITICAL(sr);
+        ring->lr_len_drops++;
+        OS_EXIT_CRITICAL(sr);
+        return OS_EINVAL;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    if ((uint16_t)(ring->lr_head - ring->lr_tail) >
+      LOG_RING_MASK) {
+        ring->lr_full_drops++;
+        OS_EXIT_CRITICAL(sr);
+        return OS_ENOMEM;
+    }
+    rec = &ring->lr_recs[ring->lr_head & LOG_RING_MASK];
+    ring->lr_head++;
+    OS_EXIT_CRITICAL(sr);
+
+    memcpy(rec->lrr_data, data, len);
+    rec->lrr_len = len;
+    rec->lrr_ready = 1;
+
+#if MYNEWT_VAL(LOG_RING_TASK)
+    os_eventq_put(&log_ring_evq, &log_ring_ev);
+#endif
+    return 0;
+}
+
+/**
+ * Writes the entries in the log's ring to the log handler. Stops at the
+ * first entry that is still being filled in. Must not be called from more
+ * than one task at a time.
+ *
+ * @param log The log.
+ *
+ * @return 0 on success; non-zero if the log handler failed to write some of
+ *         the entries; they are dropped.
+ */
+int
+log_ring_drain(struct log *log)
+{
+    struct log_buf bufs[MYNEWT_VAL(LOG_RING_BATCH)];
+    struct log_ring *ring;
+    struct log_ring_rec *rec;
+    uint16_t tail;
+    os_sr_t sr;
+    int cnt;
+    int rc;
+    int rc2;
+    int i;
+
+    ring = log->l_ring;
+    if (!ring) {
+        return 0;
+    }
+
+    rc = 0;
+    while (1) {
+        tail = ring->lr_tail;
+        for (cnt = 0; cnt < MYNEWT_VAL(LOG_RING_BATCH); cnt++) {
+            if ((uint16_t)(tail + cnt) == ring->lr_head) {
+                break;
+            }
+            rec = &ring->lr_recs[(tail + cnt) & LOG_RING_MASK];
+            if (!rec->lrr_ready) {
+                break;
+            }
+            bufs[cnt].lb_data = rec->lrr_data;
+            bufs[cnt].lb_len = rec->lrr_len;
+        }
+        if (cnt == 0) {
+            break;
+        }
+
+        if (log->l_log->log_append_batch) {
+            rc2 = log->l_log->log_append_batch(log, bufs, cnt);
+            if (rc2) {
+                ring->lr_err_drops += cnt;
+            }
+        } else {
+            rc2 = 0;
+            for (i = 0; i < cnt; i++) {
+                if (log->l_log->log_append(log, bufs[i].lb_data,
+                                           bufs[i].lb_len)) {
+                    ring->lr_err_drops++;
+                    rc2 = OS_EINVAL;
+                }
+            }
+        }
+        if (rc2) {
+            rc = rc2;
+        }
+
+        for (i = 0; i < cnt; i++) {
+            ring->lr_recs[(tail + i) & LOG_RING_MASK].lrr_ready = 0;
+        }
+        OS_ENTER_CRITICAL(sr);
+        ring->lr_tail = tail + cnt;
+        OS_EXIT_CRITICAL(sr);
+    }
+    return rc;
+}
+
+#endif
@@ -38,7 +38,7 @@ static int
 shell_log_dump_entry(struct log *log, void *arg, void *dptr, uint16_t len)
 {
     struct log_entry_hdr ueh;
-    char data[128];
+    char data[128 + 1];
     int dlen;
     int rc;
 
@@ -54,12 +54,18 @@ shell_log_dump_entry(struct log *log, void *arg, void *dptr, uint16_t len)
         goto err;
     }
     data[rc] = 0;
+    ueh.ue_ts = log_ts_usec(ueh.ue_ts);
 
     /* XXX: This is evil.  newlib printf does not like 64-bit
      * values, and this causes memory to be overwritten.  Cast to a
      * unsigned 32-bit value for now.
      */
-    console_printf("[%lu] %s\n", (unsigned long) ueh.ue_ts, data);
+    if (log_entry_is_bin(data, rc)) {
+        console_printf("[%lu] <binary, %d bytes>\n", (unsigned long) ueh.ue_ts,
+                       rc);
+    } else {
+        console_printf("[%lu] %s\n", (unsigned long) ueh.ue_ts, data);
+    }
 
     return (0);
 err:
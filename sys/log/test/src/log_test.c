@@ -84,6 +84,20 @@ TEST_CASE_DECL(log_setup_fcb)
 TEST_CASE_DECL(log_append_fcb)
 TEST_CASE_DECL(log_walk_fcb)
 TEST_CASE_DECL(log_flush_fcb)
+TEST_CASE_DECL(log_bin_fcb)
+TEST_CASE_DECL(log_walk_from_fcb)
+#if MYNEWT_VAL(LOG_FCB_COMPRESS_BLOCK) > 0 && MYNEWT_VAL(LOG_RING_ENTRIES) > 0
+TEST_CASE_DECL(log_compress_fcb)
+#endif
+#if MYNEWT_VAL(LOG_MODULE_LEVELS) > 0
+TEST_CASE_DECL(log_level_fcb)
+#endif
+#if MYNEWT_VAL(LOG_RATE_MODULES) > 0 && MYNEWT_VAL(LOG_DUP_SUPPRESS)
+TEST_CASE_DECL(log_suppress_fcb)
+#endif
+#if MYNEWT_VAL(LOG_RING_ENTRIES) > 0
+TEST_CASE_DECL(log_ring_fcb)
+#endif
 
 TEST_SUITE(log_test_all)
 {
@@ -91,6 +105,20 @@ TEST_SUITE(log_test_all)
     log_append_fcb();
     log_walk_fcb();
     log_flush_fcb();
+    log_bin_fcb();
+    log_walk_from_fcb();
+#if MYNEWT_VAL(LOG_FCB_COMPRESS_BLOCK) > 0 && MYNEWT_VAL(LOG_RING_ENTRIES) > 0
+    log_compress_fcb();
+#endif
+#if MYNEWT_VAL(LOG_MODULE_LEVELS) > 0
+    log_level_fcb();
+#endif
+#if MYNEWT_VAL(LOG_RATE_MODULES) > 0 && MYNEWT_VAL(LOG_DUP_SUPPRESS)
+    log_suppress_fcb();
+#endif
+#if MYNEWT_VAL(LOG_RING_ENTRIES) > 0
+    log_ring_fcb();
+#endif
 }
 
 #if MYNEWT_VAL(SELFTEST)
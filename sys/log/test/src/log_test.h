@@ -18,6 +18,7 @@
  */
 #ifndef _LOG_TEST_H
 #define _LOG_TEST_H
+#include <stdio.h>
 #include <string.h>
 
 #include "syscfg/syscfg.h"
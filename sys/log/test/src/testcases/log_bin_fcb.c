@@ -0,0 +1,85 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "log_test.h"
+
+static const char log_bin_test_fmt[] = "%d%% %-4s %lld %c %zu";
+
+static int
+log_bin_test_walk(struct log *log, void *arg, void *dptr, uint16_t len)
+{
+    uint8_t body[LOG_PRINTF_MAX_ENTRY_LEN];
+    const char *fmt;
+    long long ll;
+    size_t sz;
+    int off;
+    int i;
+    int rc;
+
+    rc = log_read(log, dptr, body, LOG_ENTRY_HDR_SIZE, sizeof(body));
+    TEST_ASSERT(rc == len - LOG_ENTRY_HDR_SIZE);
+    TEST_ASSERT(log_entry_is_bin(body, rc));
+
+    off = 1;
+    memcpy(&fmt, body + off, sizeof(fmt));
+    off += sizeof(fmt);
+    TEST_ASSERT(fmt == log_bin_test_fmt);
+
+    memcpy(&i, body + off, sizeof(i));
+    off += sizeof(i);
+    TEST_ASSERT(i == -5);
+
+    TEST_ASSERT(!strcmp((char *)body + off, "abc"));
+    off += 4;
+
+    memcpy(&ll, body + off, sizeof(ll));
+    off += sizeof(ll);
+    TEST_ASSERT(ll == 1LL << 40);
+
+    memcpy(&i, body + off, sizeof(i));
+    off += sizeof(i);
+    TEST_ASSERT(i == 'q');
+
+    memcpy(&sz, body + off, sizeof(sz));
+    off += sizeof(sz);
+    TEST_ASSERT(sz == 77);
+
+    TEST_ASSERT(off == rc);
+    (*(int *)arg)++;
+    return 0;
+}
+
+TEST_CASE(log_bin_fcb)
+{
+    int cnt;
+    int rc;
+
+    rc = log_flush(&my_log);
+    TEST_ASSERT(rc == 0);
+
+    log_printf_bin(&my_log, LOG_MODULE_TEST, LOG_LEVEL_INFO,
+                   log_bin_test_fmt, -5, "abc", 1LL << 40, 'q', (size_t)77);
+
+    cnt = 0;
+    rc = log_walk(&my_log, log_bin_test_walk, &cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cnt == 1);
+
+    rc = log_flush(&my_log);
+    TEST_ASSERT(rc == 0);
+}
@@ -0,0 +1,123 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "log_test.h"
+
+#if MYNEWT_VAL(LOG_FCB_COMPRESS_BLOCK) > 0 && MYNEWT_VAL(LOG_RING_ENTRIES) > 0
+
+#define LOG_COMPRESS_TEST_CNT   MYNEWT_VAL(LOG_RING_ENTRIES)
+
+struct log_compress_test {
+    int lct_cnt;
+    int lct_stop;
+};
+
+static int
+log_compress_test_walk(struct log *log, void *arg, void *dptr, uint16_t len)
+{
+    struct log_compress_test *lct;
+    struct log_entry_hdr ueh;
+    char data[64];
+    char exp[64];
+    int rc;
+
+    lct = arg;
+    if (lct->lct_cnt == lct->lct_stop) {
+        return 1;
+    }
+
+    rc = log_read(log, dptr, &ueh, 0, sizeof(ueh));
+    TEST_ASSERT(rc == sizeof(ueh));
+    TEST_ASSERT(ueh.ue_module == LOG_MODULE_TEST);
+
+    rc = log_read(log, dptr, data, sizeof(ueh), len - sizeof(ueh));
+    TEST_ASSERT(rc == len - sizeof(ueh));
+    data[rc] = '\0';
+    snprintf(exp, sizeof(exp), "compressed entry number %d", lct->lct_cnt);
+    TEST_ASSERT(!strcmp(data, exp));
+
+    lct->lct_cnt++;
+    return 0;
+}
+
+static int
+log_compress_test_fcb_cnt(struct fcb_entry *loc, void *arg)
+{
+    (*(int *)arg)++;
+    return 0;
+}
+
+TEST_CASE(log_compress_fcb)
+{
+    static struct log_ring ring;
+    struct log_compress_test lct;
+    uint64_t cursor;
+    int cnt;
+    int rc;
+    int i;
+
+    rc = log_flush(&my_log);
+    TEST_ASSERT(rc == 0);
+    rc = log_ring_attach(&my_log, &ring);
+    TEST_ASSERT(rc == 0);
+
+    for (i = 0; i < LOG_COMPRESS_TEST_CNT; i++) {
+        log_printf(&my_log, LOG_MODULE_TEST, 0, "compressed entry number %d",
+                   i);
+    }
+    rc = log_ring_drain(&my_log);
+    TEST_ASSERT(rc == 0);
+
+    /*
+     * Entries share one FCB record.
+     */
+    cnt = 0;
+    rc = fcb_walk(&log_fcb, NULL, log_compress_test_fcb_cnt, &cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cnt == 1);
+
+    lct.lct_cnt = 0;
+    lct.lct_stop = -1;
+    rc = log_walk(&my_log, log_compress_test_walk, &lct);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(lct.lct_cnt == LOG_COMPRESS_TEST_CNT);
+
+    /*
+     * Walk resumes in the middle of a compressed record.
+     */
+    cursor = LOG_CURSOR_START;
+    lct.lct_cnt = 0;
+    lct.lct_stop = 3;
+    rc = log_walk_from(&my_log, log_compress_test_walk, &lct, &cursor);
+    TEST_ASSERT(rc == 1);
+
+    lct.lct_stop = -1;
+    rc = log_walk_from(&my_log, log_compress_test_walk, &lct, &cursor);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(lct.lct_cnt == LOG_COMPRESS_TEST_CNT);
+
+    rc = log_walk_from(&my_log, log_test_walk2, NULL, &cursor);
+    TEST_ASSERT(rc == 0);
+
+    rc = log_ring_attach(&my_log, NULL);
+    TEST_ASSERT(rc == 0);
+    rc = log_flush(&my_log);
+    TEST_ASSERT(rc == 0);
+}
+
+#endif
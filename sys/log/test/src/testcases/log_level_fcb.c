@@ -0,0 +1,61 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "log_test.h"
+
+#if MYNEWT_VAL(LOG_MODULE_LEVELS) > 0
+
+static int
+log_level_test_count(struct log *log, void *arg, void *dptr, uint16_t len)
+{
+    (*(int *)arg)++;
+    return 0;
+}
+
+TEST_CASE(log_level_fcb)
+{
+    int cnt;
+    int rc;
+
+    rc = log_flush(&my_log);
+    TEST_ASSERT(rc == 0);
+
+    rc = log_level_set(LOG_MODULE_TEST, LOG_LEVEL_WARN);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(log_level_get(LOG_MODULE_TEST) == LOG_LEVEL_WARN);
+    rc = log_level_set(MYNEWT_VAL(LOG_MODULE_LEVELS), LOG_LEVEL_WARN);
+    TEST_ASSERT(rc != 0);
+
+    LOG_DEBUG(&my_log, LOG_MODULE_TEST, "debug");
+    LOG_INFO(&my_log, LOG_MODULE_TEST, "info");
+    LOG_WARN(&my_log, LOG_MODULE_TEST, "warn");
+    LOG_ERROR(&my_log, LOG_MODULE_TEST, "error");
+    LOG_DEBUG(&my_log, LOG_MODULE_DEFAULT, "debug");
+
+    cnt = 0;
+    rc = log_walk(&my_log, log_level_test_count, &cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cnt == 3);
+
+    rc = log_level_set(LOG_MODULE_TEST, LOG_LEVEL_DEBUG);
+    TEST_ASSERT(rc == 0);
+    rc = log_flush(&my_log);
+    TEST_ASSERT(rc == 0);
+}
+
+#endif
@@ -0,0 +1,95 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "log_test.h"
+
+#if MYNEWT_VAL(LOG_RING_ENTRIES) > 0
+
+static int
+log_ring_test_count(struct log *log, void *arg, void *dptr, uint16_t len)
+{
+    (*(int *)arg)++;
+    return 0;
+}
+
+TEST_CASE(log_ring_fcb)
+{
+    static struct log_ring ring;
+    uint8_t big[LOG_ENTRY_HDR_SIZE + MYNEWT_VAL(LOG_RING_ENTRY_LEN) + 1];
+    char *str;
+    int cnt;
+    int rc;
+    int i;
+
+    rc = log_flush(&my_log);
+    TEST_ASSERT(rc == 0);
+    rc = log_ring_attach(&my_log, &ring);
+    TEST_ASSERT(rc == 0);
+
+    str_idx = 0;
+    str_max_idx = 0;
+    while (1) {
+        str = str_logs[str_max_idx];
+        if (!str) {
+            break;
+        }
+        log_printf(&my_log, 0, 0, str, strlen(str));
+        str_max_idx++;
+    }
+
+    /*
+     * Nothing is written before the ring is drained.
+     */
+    rc = log_walk(&my_log, log_test_walk2, NULL);
+    TEST_ASSERT(rc == 0);
+
+    rc = log_ring_drain(&my_log);
+    TEST_ASSERT(rc == 0);
+    rc = log_walk(&my_log, log_test_walk1, NULL);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(str_idx == str_max_idx);
+
+    /*
+     * Entries are dropped and counted when ring is full, or when they are
+     * too long.
+     */
+    for (i = 0; i < MYNEWT_VAL(LOG_RING_ENTRIES) + 2; i++) {
+        log_printf(&my_log, 0, 0, "entry %d", i);
+    }
+    TEST_ASSERT(ring.lr_full_drops == 2);
+
+    rc = log_append(&my_log, 0, 0, big, sizeof(big) - LOG_ENTRY_HDR_SIZE);
+    TEST_ASSERT(rc != 0);
+    TEST_ASSERT(ring.lr_len_drops == 1);
+
+    rc = log_ring_drain(&my_log);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(ring.lr_err_drops == 0);
+
+    cnt = 0;
+    rc = log_walk(&my_log, log_ring_test_count, &cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cnt == str_max_idx + MYNEWT_VAL(LOG_RING_ENTRIES));
+
+    rc = log_ring_attach(&my_log, NULL);
+    TEST_ASSERT(rc == 0);
+    rc = log_flush(&my_log);
+    TEST_ASSERT(rc == 0);
+}
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "log_test.h"
+
+#if MYNEWT_VAL(LOG_RATE_MODULES) > 0 && MYNEWT_VAL(LOG_DUP_SUPPRESS)
+
+static char *log_suppress_expect[] = {
+    "same",
+    "last message repeated 3 times",
+    "other",
+};
+
+static int
+log_suppress_test_walk(struct log *log, void *arg, void *dptr, uint16_t len)
+{
+    char data[64];
+    int *cnt;
+    int dlen;
+    int rc;
+
+    cnt = arg;
+    TEST_ASSERT_FATAL(*cnt < 3);
+
+    dlen = len - LOG_ENTRY_HDR_SIZE;
+    TEST_ASSERT_FATAL(dlen < sizeof(data));
+    rc = log_read(log, dptr, data, LOG_ENTRY_HDR_SIZE, dlen);
+    TEST_ASSERT(rc == dlen);
+    data[dlen] = '\0';
+    TEST_ASSERT(!strcmp(data, log_suppress_expect[*cnt]));
+
+    (*cnt)++;
+    return 0;
+}
+
+static int
+log_suppress_test_count(struct log *log, void *arg, void *dptr, uint16_t len)
+{
+    (*(int *)arg)++;
+    return 0;
+}
+
+TEST_CASE(log_suppress_fcb)
+{
+    int cnt;
+    int rc;
+    int i;
+
+    rc = log_flush(&my_log);
+    TEST_ASSERT(rc == 0);
+
+    /* Identical entries collapse into one "repeated" entry. */
+    log_dup_window_set(&my_log, 1000);
+    for (i = 0; i < 4; i++) {
+        log_printf(&my_log, LOG_MODULE_TEST, LOG_LEVEL_INFO, "same");
+    }
+    log_printf(&my_log, LOG_MODULE_TEST, LOG_LEVEL_INFO, "other");
+
+    cnt = 0;
+    rc = log_walk(&my_log, log_suppress_test_walk, &cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cnt == 3);
+
+    log_dup_window_set(&my_log, 0);
+    rc = log_flush(&my_log);
+    TEST_ASSERT(rc == 0);
+
+    /* Time does not advance here, so only the burst gets through. */
+    rc = log_rate_set(LOG_MODULE_TEST, 1, 3);
+    TEST_ASSERT(rc == 0);
+    rc = log_rate_set(MYNEWT_VAL(LOG_RATE_MODULES), 1, 3);
+    TEST_ASSERT(rc != 0);
+    for (i = 0; i < 5; i++) {
+        log_printf(&my_log, LOG_MODULE_TEST, LOG_LEVEL_INFO, "entry %d", i);
+    }
+    log_printf(&my_log, LOG_MODULE_DEFAULT, LOG_LEVEL_INFO, "default");
+
+    cnt = 0;
+    rc = log_walk(&my_log, log_suppress_test_count, &cnt);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(cnt == 4);
+
+    rc = log_rate_set(LOG_MODULE_TEST, 0, 0);
+    TEST_ASSERT(rc == 0);
+    rc = log_flush(&my_log);
+    TEST_ASSERT(rc == 0);
+}
+
+#endif
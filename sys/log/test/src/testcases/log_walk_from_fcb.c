@@ -0,0 +1,103 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "log_test.h"
+
+struct log_walk_from_test {
+    int lwf_cnt;
+    int lwf_stop;
+};
+
+static int
+log_walk_from_test_func(struct log *log, void *arg, void *dptr, uint16_t len)
+{
+    struct log_walk_from_test *lwf;
+    int rc;
+
+    lwf = arg;
+    if (lwf->lwf_cnt == lwf->lwf_stop) {
+        return 1;
+    }
+    rc = log_test_walk1(log, NULL, dptr, len);
+    if (rc == 0) {
+        lwf->lwf_cnt++;
+    }
+    return rc;
+}
+
+TEST_CASE(log_walk_from_fcb)
+{
+    struct log_walk_from_test lwf;
+    uint64_t cursor;
+    char *str;
+    int rc;
+
+    rc = log_flush(&my_log);
+    TEST_ASSERT(rc == 0);
+
+    str_idx = 0;
+    str_max_idx = 0;
+    while (1) {
+        str = str_logs[str_max_idx];
+        if (!str) {
+            break;
+        }
+        log_printf(&my_log, 0, 0, str, strlen(str));
+        str_max_idx++;
+    }
+
+    /*
+     * Stop after the first entry, and resume after it.
+     */
+    cursor = LOG_CURSOR_START;
+    lwf.lwf_cnt = 0;
+    lwf.lwf_stop = 1;
+    rc = log_walk_from(&my_log, log_walk_from_test_func, &lwf, &cursor);
+    TEST_ASSERT(rc == 1);
+    TEST_ASSERT(str_idx == 1);
+    TEST_ASSERT(cursor != LOG_CURSOR_START);
+
+    lwf.lwf_cnt = 0;
+    lwf.lwf_stop = -1;
+    rc = log_walk_from(&my_log, log_walk_from_test_func, &lwf, &cursor);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(str_idx == str_max_idx);
+    TEST_ASSERT(lwf.lwf_cnt == str_max_idx - 1);
+
+    /*
+     * Nothing new after the last entry.
+     */
+    rc = log_walk_from(&my_log, log_test_walk2, NULL, &cursor);
+    TEST_ASSERT(rc == 0);
+
+    /*
+     * Cursor to an entry that is gone walks from the oldest entry.
+     */
+    rc = log_flush(&my_log);
+    TEST_ASSERT(rc == 0);
+    log_printf(&my_log, 0, 0, str_logs[0], strlen(str_logs[0]));
+    str_idx = 0;
+    str_max_idx = 1;
+    lwf.lwf_cnt = 0;
+    rc = log_walk_from(&my_log, log_walk_from_test_func, &lwf, &cursor);
+    TEST_ASSERT(rc == 0);
+    TEST_ASSERT(str_idx == 1);
+
+    rc = log_flush(&my_log);
+    TEST_ASSERT(rc == 0);
+}
@@ -36,6 +36,30 @@ struct shell_cmd {
 
 int shell_cmd_register(struct shell_cmd *sc);
 
+/*
+ * Commands defined with SHELL_CMD() are collected by the linker into a
+ * table in flash, and need not be registered.  The table is ordered once
+ * when the shell starts, and looked up with a binary search; commands
+ * registered with shell_cmd_register() are searched after it.
+ *
+ * Alignment is given explicitly so that the compiler does not pad entries,
+ * and the section can be walked as an array.
+ */
+#if defined(__APPLE__)
+#define SHELL_CMD_SECTION_NAME  "__DATA,shell_cmd"
+#else
+#define SHELL_CMD_SECTION_NAME  "shell_cmd"
+#endif
+#define SHELL_CMD_SECTION                                               \
+    __attribute__((section(SHELL_CMD_SECTION_NAME), used,               \
+                   aligned(sizeof(void *))))
+
+#define SHELL_CMD(var, name, func)                                      \
+    static const struct shell_cmd var SHELL_CMD_SECTION = {             \
+        .sc_cmd = (name),                                               \
+        .sc_cmd_func = (func)                                           \
+    }
+
 #define SHELL_NLIP_PKT_START1 (6)
 #define SHELL_NLIP_PKT_START2 (9)
 #define SHELL_NLIP_DATA_START1 (4)
@@ -49,30 +49,40 @@ static void shell_event_console_rdy(struct os_event *ev);
 /* Shared queue that the shell uses for work items. */
 static struct os_eventq *shell_evq;
 
-static struct shell_cmd g_shell_echo_cmd = {
-    .sc_cmd = "echo",
-    .sc_cmd_func = shell_echo_cmd
-};
-static struct shell_cmd g_shell_help_cmd = {
-    .sc_cmd = "?",
-    .sc_cmd_func = shell_help_cmd
-};
-static struct shell_cmd g_shell_prompt_cmd = {
-   .sc_cmd = "prompt",
-   .sc_cmd_func = shell_prompt_cmd
-};
-static struct shell_cmd g_shell_os_tasks_display_cmd = {
-    .sc_cmd = "tasks",
-    .sc_cmd_func = shell_os_tasks_display_cmd
-};
-static struct shell_cmd g_shell_os_mpool_display_cmd = {
-    .sc_cmd = "mempools",
-    .sc_cmd_func = shell_os_mpool_display_cmd
-};
-static struct shell_cmd g_shell_os_date_cmd = {
-    .sc_cmd = "date",
-    .sc_cmd_func = shell_os_date_cmd
-};
+SHELL_CMD(g_shell_echo_cmd, "echo", shell_echo_cmd);
+SHELL_CMD(g_shell_help_cmd, "?", shell_help_cmd);
+SHELL_CMD(g_shell_prompt_cmd, "prompt", shell_prompt_cmd);
+SHELL_CMD(g_shell_os_tasks_display_cmd, "tasks", shell_os_tasks_display_cmd);
+SHELL_CMD(g_shell_os_mpool_display_cmd, "mempools",
+          shell_os_mpool_display_cmd);
+SHELL_CMD(g_shell_os_date_cmd, "date", shell_os_date_cmd);
+#if MYNEWT_VAL(OS_EVENTQ_LATENCY)
+SHELL_CMD(g_shell_os_eventq_display_cmd, "eventqs",
+          shell_os_eventq_display_cmd);
+#endif
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+SHELL_CMD(g_shell_os_sysinit_display_cmd, "sysinit",
+          shell_os_sysinit_display_cmd);
+#endif
+
+/*
+ * Bounds of the SHELL_CMD() table, provided by the linker.
+ */
+#if defined(__APPLE__)
+extern const struct shell_cmd shell_cmd_tbl_start[]
+    __asm("section$start$__DATA$shell_cmd");
+extern const struct shell_cmd shell_cmd_tbl_end[]
+    __asm("section$end$__DATA$shell_cmd");
+#else
+extern const struct shell_cmd __start_shell_cmd[];
+extern const struct shell_cmd __stop_shell_cmd[];
+#define shell_cmd_tbl_start     __start_shell_cmd
+#define shell_cmd_tbl_end       __stop_shell_cmd
+#endif
+
+/* Table entries ordered by command name. */
+static uint16_t *shell_cmd_tbl_idx;
+static int shell_cmd_tbl_cnt;
 
 static struct os_event shell_console_rdy_ev = {
     .ev_cb = shell_event_console_rdy,
@@ -88,7 +98,9 @@ static STAILQ_HEAD(, shell_cmd) g_shell_cmd_list =
     STAILQ_HEAD_INITIALIZER(g_shell_cmd_list);
 
 static struct os_mbuf *g_nlip_mbuf;
+static struct os_mbuf *g_nlip_tail;
 static uint16_t g_nlip_expected_len;
+static struct base64_decoder g_nlip_dec;
 
 static struct os_eventq *
 shell_evq_get(void)
@@ -162,12 +174,84 @@ err:
     return (rc);
 }
 
+static int
+shell_cmd_tbl_init(void)
+{
+    uint16_t tmp;
+    int cnt;
+    int i;
+    int j;
+
+    cnt = shell_cmd_tbl_end - shell_cmd_tbl_start;
+
+    free(shell_cmd_tbl_idx);
+    shell_cmd_tbl_idx = malloc(cnt * sizeof(shell_cmd_tbl_idx[0]));
+    if (!shell_cmd_tbl_idx) {
+        shell_cmd_tbl_cnt = 0;
+        return OS_ENOMEM;
+    }
+
+    /*
+     * Insertion sort; the table is small, and this is done just once.
+     */
+    for (i = 0; i < cnt; i++) {
+        tmp = i;
+        for (j = i; j > 0; j--) {
+            if (strcmp(shell_cmd_tbl_start[shell_cmd_tbl_idx[j - 1]].sc_cmd,
+                       shell_cmd_tbl_start[tmp].sc_cmd) <= 0) {
+                break;
+            }
+            shell_cmd_tbl_idx[j] = shell_cmd_tbl_idx[j - 1];
+        }
+        shell_cmd_tbl_idx[j] = tmp;
+    }
+    shell_cmd_tbl_cnt = cnt;
+
+    return 0;
+}
+
+static const struct shell_cmd *
+shell_cmd_tbl_find(const char *cmd)
+{
+    const struct shell_cmd *sc;
+    int lo;
+    int hi;
+    int mid;
+    int rc;
+
+    lo = 0;
+    hi = shell_cmd_tbl_cnt - 1;
+    while (lo <= hi) {
+        mid = (lo + hi) / 2;
+        sc = &shell_cmd_tbl_start[shell_cmd_tbl_idx[mid]];
+        rc = strcmp(cmd, sc->sc_cmd);
+        if (rc == 0) {
+            return sc;
+        } else if (rc < 0) {
+            hi = mid - 1;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return NULL;
+}
+
 static int
 shell_cmd(char *cmd, char **argv, int argc)
 {
+    const struct shell_cmd *tsc;
     struct shell_cmd *sc;
     int rc;
 
+    /*
+     * Table is read-only after init, no need to lock it.
+     */
+    tsc = shell_cmd_tbl_find(cmd);
+    if (tsc) {
+        tsc->sc_cmd_func(argc, argv);
+        return (0);
+    }
+
     rc = shell_cmd_list_lock();
     if (rc != 0) {
         goto err;
@@ -224,88 +308,170 @@ shell_process_command(char *line, int len)
     return (0);
 }
 
+static void
+shell_nlip_reset(void)
+{
+    if (g_nlip_mbuf) {
+        os_mbuf_free_chain(g_nlip_mbuf);
+        g_nlip_mbuf = NULL;
+    }
+    g_nlip_tail = NULL;
+    g_nlip_expected_len = 0;
+    base64_decoder_init(&g_nlip_dec);
+}
+
+/*
+ * Decode base64 text straight into the trailing space of the packet being
+ * received, adding buffers to the chain as needed.
+ */
 static int
-shell_nlip_process(char *data, int len)
+shell_nlip_decode(char *data, int len)
 {
-    uint16_t copy_len;
+    struct os_mbuf *om;
+    uint16_t want;
+    int space;
+    int n;
     int rc;
-    struct os_mbuf *m;
-    uint16_t crc;
 
-    rc = base64_decode(data, data);
-    if (rc < 0) {
-        goto err;
+    while (len > 0) {
+        /*
+         * Largest chunk whose decode, including a token carried over from
+         * the previous chunk, fits in the last buffer.
+         */
+        space = OS_MBUF_TRAILINGSPACE(g_nlip_tail);
+        n = (space / 3) * 4 - 3;
+        if (n <= 0) {
+            if (g_nlip_expected_len &&
+              OS_MBUF_PKTLEN(g_nlip_mbuf) < g_nlip_expected_len + 2) {
+                want = g_nlip_expected_len + 2 - OS_MBUF_PKTLEN(g_nlip_mbuf);
+            } else {
+                want = BASE64_DECODE_SIZE(len + 3);
+            }
+            om = os_msys_get(want, 0);
+            if (!om) {
+                return -1;
+            }
+            os_mbuf_concat(g_nlip_mbuf, om);
+            g_nlip_tail = om;
+            continue;
+        }
+        n = min(n, len);
+
+        rc = base64_decoder_update(&g_nlip_dec, data, n,
+          g_nlip_tail->om_data + g_nlip_tail->om_len);
+        if (rc < 0) {
+            return -1;
+        }
+        g_nlip_tail->om_len += rc;
+        OS_MBUF_PKTHDR(g_nlip_mbuf)->omp_len += rc;
+
+        data += n;
+        len -= n;
     }
-    len = rc;
+    return 0;
+}
+
+static int
+shell_nlip_process(char *data, int len)
+{
+    uint16_t pktlen;
+    uint16_t crc;
+    struct os_mbuf *om;
+    struct os_mbuf *m;
+    int rc;
 
     if (g_nlip_mbuf == NULL) {
-        if (len < 2) {
+        g_nlip_mbuf = os_msys_get_pkthdr(BASE64_DECODE_SIZE(len + 3), 0);
+        if (!g_nlip_mbuf) {
             rc = -1;
             goto err;
         }
+        g_nlip_tail = g_nlip_mbuf;
+        g_nlip_expected_len = 0;
+        base64_decoder_init(&g_nlip_dec);
+    }
 
-        g_nlip_expected_len = ntohs(*(uint16_t *) data);
-        g_nlip_mbuf = os_msys_get_pkthdr(g_nlip_expected_len, 0);
-        if (!g_nlip_mbuf) {
+    rc = shell_nlip_decode(data, len);
+    if (rc != 0) {
+        goto err;
+    }
+
+    /*
+     * Packet starts with its length; this is not included in the data.
+     */
+    pktlen = OS_MBUF_PKTLEN(g_nlip_mbuf);
+    if (g_nlip_expected_len == 0) {
+        if (pktlen < sizeof(uint16_t)) {
+            return (0);
+        }
+        os_mbuf_copydata(g_nlip_mbuf, 0, sizeof(uint16_t),
+          &g_nlip_expected_len);
+        g_nlip_expected_len = ntohs(g_nlip_expected_len);
+        if (g_nlip_expected_len < sizeof(crc)) {
             rc = -1;
             goto err;
         }
-
-        data += sizeof(uint16_t);
-        len -= sizeof(uint16_t);
+    }
+    if (pktlen < g_nlip_expected_len + sizeof(uint16_t)) {
+        return (0);
     }
 
-    copy_len = min(g_nlip_expected_len - OS_MBUF_PKTHDR(g_nlip_mbuf)->omp_len,
-            len);
-
-    rc = os_mbuf_copyinto(g_nlip_mbuf, OS_MBUF_PKTHDR(g_nlip_mbuf)->omp_len,
-            data, copy_len);
-    if (rc != 0) {
-        goto err;
+    m = g_nlip_mbuf;
+    os_mbuf_adj(m, sizeof(uint16_t));
+    if (OS_MBUF_PKTLEN(m) > g_nlip_expected_len) {
+        os_mbuf_adj(m, g_nlip_expected_len - OS_MBUF_PKTLEN(m));
     }
+    g_nlip_mbuf = NULL;
+    shell_nlip_reset();
 
-    if (OS_MBUF_PKTHDR(g_nlip_mbuf)->omp_len == g_nlip_expected_len) {
-        if (g_shell_nlip_in_func) {
-            crc = CRC16_INITIAL_CRC;
-            for (m = g_nlip_mbuf; m; m = SLIST_NEXT(m, om_next)) {
-                crc = crc16_ccitt(crc, m->om_data, m->om_len);
-            }
-            if (crc == 0 && g_nlip_expected_len >= sizeof(crc)) {
-                os_mbuf_adj(g_nlip_mbuf, -sizeof(crc));
-                g_shell_nlip_in_func(g_nlip_mbuf, g_shell_nlip_in_arg);
-            } else {
-                os_mbuf_free_chain(g_nlip_mbuf);
-            }
+    if (g_shell_nlip_in_func) {
+        crc = CRC16_INITIAL_CRC;
+        for (om = m; om; om = SLIST_NEXT(om, om_next)) {
+            crc = crc16_ccitt(crc, om->om_data, om->om_len);
+        }
+        if (crc == 0) {
+            os_mbuf_adj(m, -(int)sizeof(crc));
+            g_shell_nlip_in_func(m, g_shell_nlip_in_arg);
         } else {
-            os_mbuf_free_chain(g_nlip_mbuf);
+            os_mbuf_free_chain(m);
         }
-        g_nlip_mbuf = NULL;
-        g_nlip_expected_len = 0;
+    } else {
+        os_mbuf_free_chain(m);
     }
 
     return (0);
 err:
+    shell_nlip_reset();
     return (rc);
 }
 
+static void
+shell_nlip_mtx_line(char *buf, int len)
+{
+    buf[len++] = '\n';
+    console_write(buf, len);
+}
+
 static int
 shell_nlip_mtx(struct os_mbuf *m)
 {
-#define SHELL_NLIP_MTX_BUF_SIZE (12)
-    uint8_t readbuf[SHELL_NLIP_MTX_BUF_SIZE];
-    char encodebuf[BASE64_ENCODE_SIZE(SHELL_NLIP_MTX_BUF_SIZE)];
+/*
+ * Bytes of input per line; multiple of 3, and base64 encoded data must be
+ * less than 122 bytes per line to avoid overflows and adhere to convention.
+ */
+#define SHELL_NLIP_MTX_LINE_BYTES   84
+    char buf[3 + BASE64_ENCODE_SIZE(SHELL_NLIP_MTX_LINE_BYTES + 2) + 4 + 2];
     char pkt_seq[3] = { '\n', SHELL_NLIP_PKT_START1, SHELL_NLIP_PKT_START2 };
     char esc_seq[2] = { SHELL_NLIP_DATA_START1, SHELL_NLIP_DATA_START2 };
+    struct base64_encoder be;
+    struct os_mbuf *tmp;
+    uint16_t linebytes;
     uint16_t totlen;
-    uint16_t dlen;
-    uint16_t off;
     uint16_t crc;
-    int rb_off;
-    int elen;
-    uint16_t nwritten;
-    uint16_t linelen;
-    int rc;
-    struct os_mbuf *tmp;
+    uint8_t *data;
+    int left;
+    int off;
+    int n;
     void *ptr;
 
     /* Convert the mbuf into a packet.
@@ -315,11 +481,11 @@ shell_nlip_mtx(struct os_mbuf *m)
      *  - total packet length (uint16_t)
      *  - data
      *  - crc
-     * base64 encoded data must be less than 122 bytes per line to
-     * avoid overflows and adhere to convention.
      *
      * continuation packets are preceded by 04 20 until the entire
      * buffer has been sent.
+     *
+     * Data is encoded straight from the mbufs, one line at a time.
      */
     crc = CRC16_INITIAL_CRC;
     for (tmp = m; tmp; tmp = SLIST_NEXT(tmp, om_next)) {
@@ -328,64 +494,39 @@ shell_nlip_mtx(struct os_mbuf *m)
     crc = htons(crc);
     ptr = os_mbuf_extend(m, sizeof(crc));
     if (!ptr) {
-        rc = -1;
-        goto err;
+        return -1;
     }
     memcpy(ptr, &crc, sizeof(crc));
 
-    totlen = OS_MBUF_PKTHDR(m)->omp_len;
-    nwritten = 0;
-    off = 0;
+    totlen = htons(OS_MBUF_PKTHDR(m)->omp_len);
 
-    /* Start a packet */
-    console_write(pkt_seq, sizeof(pkt_seq));
+    base64_encoder_init(&be);
+    memcpy(buf, pkt_seq, sizeof(pkt_seq));
+    off = sizeof(pkt_seq);
+    off += base64_encoder_update(&be, &totlen, sizeof(totlen), buf + off);
+    linebytes = sizeof(totlen);
 
-    linelen = 0;
-
-    rb_off = 2;
-    dlen = htons(totlen);
-    memcpy(readbuf, &dlen, sizeof(dlen));
-
-    while (totlen > 0) {
-        dlen = min(SHELL_NLIP_MTX_BUF_SIZE - rb_off, totlen);
-
-        rc = os_mbuf_copydata(m, off, dlen, readbuf + rb_off);
-        if (rc != 0) {
-            goto err;
-        }
-        off += dlen;
-
-        /* If the next packet will overwhelm the line length, truncate
-         * this line.
-         */
-        if (linelen +
-                BASE64_ENCODE_SIZE(min(SHELL_NLIP_MTX_BUF_SIZE - rb_off,
-                        totlen - dlen)) >= 120) {
-            elen = base64_encode(readbuf, dlen + rb_off, encodebuf, 1);
-            console_write(encodebuf, elen);
-            console_write("\n", 1);
-            console_write(esc_seq, sizeof(esc_seq));
-            linelen = 0;
-        } else {
-            elen = base64_encode(readbuf, dlen + rb_off, encodebuf, 0);
-            console_write(encodebuf, elen);
-            linelen += elen;
+    for (tmp = m; tmp; tmp = SLIST_NEXT(tmp, om_next)) {
+        data = tmp->om_data;
+        left = tmp->om_len;
+        while (left > 0) {
+            if (linebytes == SHELL_NLIP_MTX_LINE_BYTES) {
+                shell_nlip_mtx_line(buf, off);
+                memcpy(buf, esc_seq, sizeof(esc_seq));
+                off = sizeof(esc_seq);
+                linebytes = 0;
+            }
+            n = min(left, SHELL_NLIP_MTX_LINE_BYTES - linebytes);
+            off += base64_encoder_update(&be, data, n, buf + off);
+            data += n;
+            left -= n;
+            linebytes += n;
         }
-
-        rb_off = 0;
-
-        nwritten += elen;
-        totlen -= dlen;
     }
-
-    elen = base64_pad(encodebuf, linelen);
-    console_write(encodebuf, elen);
-
-    console_write("\n", 1);
+    off += base64_encoder_finish(&be, buf + off, 1);
+    shell_nlip_mtx_line(buf, off);
 
     return (0);
-err:
-    return (rc);
 }
 
 int
@@ -429,11 +570,7 @@ shell_read_console(void)
             if (shell_line_len > 2) {
                 if (shell_line[0] == SHELL_NLIP_PKT_START1 &&
                         shell_line[1] == SHELL_NLIP_PKT_START2) {
-                    if (g_nlip_mbuf) {
-                        os_mbuf_free_chain(g_nlip_mbuf);
-                        g_nlip_mbuf = NULL;
-                    }
-                    g_nlip_expected_len = 0;
+                    shell_nlip_reset();
 
                     rc = shell_nlip_process(&shell_line[2], shell_line_len - 2);
                 } else if (shell_line[0] == SHELL_NLIP_DATA_START1 &&
@@ -506,13 +643,21 @@ shell_help_cmd(int argc, char **argv)
 {
     int rc;
     int i = 0;
-    struct shell_cmd *sc;
+    const struct shell_cmd *sc;
+
+    console_printf("Commands:\n");
+    for (; i < shell_cmd_tbl_cnt; i++) {
+        sc = &shell_cmd_tbl_start[shell_cmd_tbl_idx[i]];
+        console_printf("%9s ", sc->sc_cmd);
+        if (i % SHELL_HELP_PER_LINE == SHELL_HELP_PER_LINE - 1) {
+            console_printf("\n");
+        }
+    }
 
     rc = shell_cmd_list_lock();
     if (rc != 0) {
         return -1;
     }
-    console_printf("Commands:\n");
     STAILQ_FOREACH(sc, &g_shell_cmd_list, sc_next) {
         console_printf("%9s ", sc->sc_cmd);
         if (i++ % SHELL_HELP_PER_LINE == SHELL_HELP_PER_LINE - 1) {
@@ -547,22 +692,7 @@ shell_init(void)
     rc = os_mutex_init(&g_shell_cmd_list_lock);
     SYSINIT_PANIC_ASSERT(rc == 0);
 
-    rc = shell_cmd_register(&g_shell_echo_cmd);
-    SYSINIT_PANIC_ASSERT(rc == 0);
-
-    rc = shell_cmd_register(&g_shell_help_cmd);
-    SYSINIT_PANIC_ASSERT(rc == 0);
-
-    rc = shell_cmd_register(&g_shell_prompt_cmd);
-    SYSINIT_PANIC_ASSERT(rc == 0);
-
-    rc = shell_cmd_register(&g_shell_os_tasks_display_cmd);
-    SYSINIT_PANIC_ASSERT(rc == 0);
-
-    rc = shell_cmd_register(&g_shell_os_mpool_display_cmd);
-    SYSINIT_PANIC_ASSERT(rc == 0);
-
-    rc = shell_cmd_register(&g_shell_os_date_cmd);
+    rc = shell_cmd_tbl_init();
     SYSINIT_PANIC_ASSERT(rc == 0);
 
     os_mqueue_init(&g_shell_nlip_mq, shell_event_data_in, NULL);
@@ -17,12 +17,14 @@
  * under the License.
  */
 
+#include "syscfg/syscfg.h"
 #include "os/os.h"
 
 #include "os/queue.h"
 #include "os/os_time.h"
 
 #include "console/console.h"
+#include "sysinit/sysinit.h"
 #include "shell/shell.h"
 #include "shell_priv.h"
 
@@ -70,9 +72,20 @@ shell_os_tasks_display_cmd(int argc, char **argv)
                 oti.oti_stksize, oti.oti_stkusage,
                 (unsigned long)oti.oti_last_checkin,
                 (unsigned long)oti.oti_next_checkin, oti.oti_flags);
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+        console_printf("%8s run %lu maxrun %lu preempt %lu yield %lu cpu %u%%\n",
+                "", (unsigned long)oti.oti_prof_run,
+                (unsigned long)oti.oti_prof_max_run,
+                (unsigned long)oti.oti_prof_preempts,
+                (unsigned long)oti.oti_prof_yields, oti.oti_cpu_pct);
+#endif
 
     }
 
+#if MYNEWT_VAL(OS_TASK_PROFILE)
+    console_printf("isr time %lu\n", (unsigned long)os_prof_isr_time());
+#endif
+
     if (name && !found) {
         console_printf("Couldn't find task with name %s\n", name);
     }
@@ -85,11 +98,13 @@ shell_os_mpool_display_cmd(int argc, char **argv)
 {
     struct os_mempool *mp;
     struct os_mempool_info omi;
+    uint32_t total;
     char *name;
     int found;
 
     name = NULL;
     found = 0;
+    total = 0;
 
     if (argc > 1 && strcmp(argv[1], "")) {
         name = argv[1];
@@ -111,9 +126,17 @@ shell_os_mpool_display_cmd(int argc, char **argv)
             }
         }
 
-        console_printf("  %s (blksize: %d, nblocks: %d, nfree: %d)\n",
+        console_printf("  %s (blksize: %d, nblocks: %d, nfree: %d, "
+                "min: %d, nfail: %lu, bytes: %lu)\n",
                 omi.omi_name, omi.omi_block_size, omi.omi_num_blocks,
-                omi.omi_num_free);
+                omi.omi_num_free, omi.omi_min_free,
+                (unsigned long)omi.omi_num_fail,
+                (unsigned long)omi.omi_mem_bytes);
+        total += omi.omi_mem_bytes;
+    }
+
+    if (!name) {
+        console_printf("Total: %lu bytes\n", (unsigned long)total);
     }
 
     if (name && !found) {
@@ -124,6 +147,59 @@ shell_os_mpool_display_cmd(int argc, char **argv)
     return (0);
 }
 
+#if MYNEWT_VAL(OS_EVENTQ_LATENCY)
+int
+shell_os_eventq_display_cmd(int argc, char **argv)
+{
+    struct os_eventq *evq;
+    struct os_eventq_info oei;
+    int i;
+
+    console_printf("Eventq latency (cputime ticks: count):\n");
+    evq = NULL;
+    while (1) {
+        evq = os_eventq_info_get_next(evq, &oei);
+        if (evq == NULL) {
+            break;
+        }
+
+        console_printf("  %s:", oei.oei_name);
+        for (i = 0; i < MYNEWT_VAL(OS_EVENTQ_LATENCY_BUCKETS); i++) {
+            if (oei.oei_lat_hist[i] != 0) {
+                console_printf(" %lu: %lu", i == 0 ? 0UL : 1UL << i,
+                               (unsigned long)oei.oei_lat_hist[i]);
+            }
+        }
+        console_printf("\n");
+    }
+
+    return (0);
+}
+#endif
+
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+int
+shell_os_sysinit_display_cmd(int argc, char **argv)
+{
+    struct sysinit_profile_entry entry;
+    int i;
+
+    console_printf("Init steps (usecs):\n");
+    console_printf("%16s %10s %10s %5s\n", "step", "start", "duration",
+                   "async");
+    for (i = 0; sysinit_profile_get(i, &entry) == 0; i++) {
+        console_printf("%16s %10lu %10lu %5u\n", entry.spe_name,
+                       (unsigned long)os_cputime_ticks_to_usecs(
+                           entry.spe_start),
+                       (unsigned long)os_cputime_ticks_to_usecs(
+                           entry.spe_ticks),
+                       entry.spe_async);
+    }
+
+    return (0);
+}
+#endif
+
 int
 shell_os_date_cmd(int argc, char **argv)
 {
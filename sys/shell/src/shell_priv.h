@@ -27,6 +27,8 @@ extern "C" {
 int shell_os_tasks_display_cmd(int argc, char **argv);
 int shell_os_mpool_display_cmd(int argc, char **argv);
 int shell_os_date_cmd(int argc, char **argv);
+int shell_os_eventq_display_cmd(int argc, char **argv);
+int shell_os_sysinit_display_cmd(int argc, char **argv);
 
 #ifdef __cplusplus
 }
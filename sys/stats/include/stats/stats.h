@@ -22,6 +22,7 @@
 #include <stdint.h>
 #include "syscfg/syscfg.h"
 #include "os/queue.h"
+#include "os/os_cputime.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,14 +33,63 @@ struct stats_name_map {
     char *snm_name;
 } __attribute__((packed));
 
+/* Kinds of statistics section; all entries in a section are of one kind. */
+#define STATS_TYPE_CNT      (0)
+#define STATS_TYPE_HIST     (1)
+#define STATS_TYPE_TIME     (2)
+#define STATS_TYPE_SHARD    (3)
+
+/* Slots of a sharded counter; each is written from one context only. */
+#define STATS_SHARD_TASK    (0)
+#define STATS_SHARD_ISR     (1)
+#define STATS_SHARD_CNT     (2)
+
+/**
+ * Histogram entry.  With sh_width of 0, bucket 0 counts zero values and
+ * bucket n counts values in [2^(n-1), 2^n).  Otherwise bucket n counts
+ * values in [n * sh_width, (n + 1) * sh_width).  Larger values are counted
+ * in the last bucket.
+ */
+struct stats_hist {
+    uint32_t sh_width;
+    uint32_t sh_buckets[MYNEWT_VAL(STATS_HIST_BUCKETS)];
+};
+
+/**
+ * Timing entry; accumulates durations in os_cputime ticks.  st_min and
+ * st_max are only meaningful when st_cnt is non-zero.
+ */
+struct stats_time {
+    uint32_t st_cnt;
+    uint32_t st_min;
+    uint32_t st_max;
+    uint64_t st_sum;
+};
+
+/**
+ * Sharded counter.  Each slot is only incremented from one context, so
+ * increments need no critical section as long as a single task and
+ * non-nesting interrupt handlers share the counter.  Readers report the
+ * sum of the slots.
+ */
+struct stats_shard {
+    uint32_t ss_cnt[STATS_SHARD_CNT];
+};
+
 struct stats_hdr {
     char *s_name;
     uint8_t s_size;
     uint8_t s_cnt;
-    uint16_t s_pad1;
+    uint8_t s_type;
+    uint8_t s_pad1;
 #if MYNEWT_VAL(STATS_NAMES)
     const struct stats_name_map *s_map;
     int s_map_cnt;
+#endif
+#if MYNEWT_VAL(STATS_SNAPSHOT)
+    /* Entry values at the last snapshot read, and that read's generation. */
+    void *s_snap;
+    uint32_t s_snap_gen;
 #endif
     STAILQ_ENTRY(stats_hdr) s_next;
 };
@@ -61,11 +111,17 @@ STATS_SECT_DECL(__name) {                   \
 #define STATS_SIZE_16 (sizeof(uint16_t))
 #define STATS_SIZE_32 (sizeof(uint32_t))
 #define STATS_SIZE_64 (sizeof(uint64_t))
+#define STATS_SIZE_HIST (sizeof(struct stats_hist))
+#define STATS_SIZE_TIME (sizeof(struct stats_time))
+#define STATS_SIZE_SHARD (sizeof(struct stats_shard))
 
 #define STATS_SECT_ENTRY(__var) uint32_t STATS_SECT_VAR(__var);
 #define STATS_SECT_ENTRY16(__var) uint16_t STATS_SECT_VAR(__var);
 #define STATS_SECT_ENTRY32(__var) uint32_t STATS_SECT_VAR(__var);
 #define STATS_SECT_ENTRY64(__var) uint64_t STATS_SECT_VAR(__var);
+#define STATS_SECT_HIST(__var) struct stats_hist STATS_SECT_VAR(__var);
+#define STATS_SECT_TIME(__var) struct stats_time STATS_SECT_VAR(__var);
+#define STATS_SECT_SHARD(__var) struct stats_shard STATS_SECT_VAR(__var);
 
 #define STATS_SIZE_INIT_PARMS(__sectvarname, __size)                        \
     (__size),                                                               \
@@ -80,6 +136,36 @@ STATS_SECT_DECL(__name) {                   \
 #define STATS_CLEAR(__sectvarname, __var)        \
     ((__sectvarname).STATS_SECT_VAR(__var) = 0)
 
+/* Histogram sections. */
+#define STATS_HIST_WIDTH(__sectvarname, __var, __width)    \
+    ((__sectvarname).STATS_SECT_VAR(__var).sh_width = (__width))
+
+#define STATS_HIST_ADD(__sectvarname, __var, __val)        \
+    stats_hist_add(&(__sectvarname).STATS_SECT_VAR(__var), (__val))
+
+/* Sharded counter sections.  __ctx is STATS_SHARD_TASK or STATS_SHARD_ISR,
+ * according to the context the caller runs in.
+ */
+#define STATS_SHARD_INC(__sectvarname, __var, __ctx)                        \
+    ((__sectvarname).STATS_SECT_VAR(__var).ss_cnt[(__ctx)]++)
+
+#define STATS_SHARD_INCN(__sectvarname, __var, __ctx, __n)                  \
+    ((__sectvarname).STATS_SECT_VAR(__var).ss_cnt[(__ctx)] += (__n))
+
+#define STATS_SHARD_GET(__sectvarname, __var)                               \
+    stats_shard_sum(&(__sectvarname).STATS_SECT_VAR(__var))
+
+/* Timing sections.  __start is a uint32_t holding an os_cputime value. */
+#define STATS_TIME_START(__start)                           \
+    ((__start) = os_cputime_get32())
+
+#define STATS_TIME_END(__sectvarname, __var, __start)       \
+    stats_time_add(&(__sectvarname).STATS_SECT_VAR(__var),  \
+                   os_cputime_get32() - (__start))
+
+#define STATS_TIME_ADD(__sectvarname, __var, __ticks)       \
+    stats_time_add(&(__sectvarname).STATS_SECT_VAR(__var), (__ticks))
+
 #if MYNEWT_VAL(STATS_NAMES)
 
 #define STATS_NAME_MAP_NAME(__sectname) g_stats_map_ ## __sectname
@@ -110,11 +196,30 @@ const struct stats_name_map STATS_NAME_MAP_NAME(__sectname)[] = {
 void stats_module_init(void);
 int stats_init(struct stats_hdr *shdr, uint8_t size, uint8_t cnt,
     const struct stats_name_map *map, uint8_t map_cnt);
+int stats_init_type(struct stats_hdr *shdr, uint8_t type, uint8_t size,
+    uint8_t cnt, const struct stats_name_map *map, uint8_t map_cnt);
 int stats_register(char *name, struct stats_hdr *shdr);
 int stats_init_and_reg(struct stats_hdr *shdr, uint8_t size, uint8_t cnt,
                        const struct stats_name_map *map, uint8_t map_cnt,
                        char *name);
 void stats_reset(struct stats_hdr *shdr);
+void stats_hist_add(struct stats_hist *hist, uint32_t val);
+void stats_time_add(struct stats_time *time, uint32_t ticks);
+
+static inline uint32_t
+stats_shard_sum(const struct stats_shard *shard)
+{
+    uint32_t sum;
+    int i;
+
+    sum = 0;
+    for (i = 0; i < STATS_SHARD_CNT; i++) {
+        sum += shard->ss_cnt[i];
+    }
+
+    return (sum);
+}
+uint32_t stats_hist_bucket_min(const struct stats_hist *hist, int bucket);
 
 typedef int (*stats_walk_func_t)(struct stats_hdr *, void *, char *,
         uint16_t);
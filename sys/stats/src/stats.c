@@ -59,6 +59,22 @@
  *
  * - STATS_SECT_ENTRY64(): 64-bits.  Useful for storing chunks of data.
  *
+ * Two further entry kinds aggregate samples rather than count events.  A
+ * section made of these is initialized with stats_init_type():
+ *
+ * - STATS_SECT_HIST(): a histogram (struct stats_hist) of
+ *   STATS_HIST_BUCKETS buckets, fed with STATS_HIST_ADD().  Buckets are
+ *   powers of two unless a fixed width is set with STATS_HIST_WIDTH().
+ *
+ * - STATS_SECT_TIME(): count, minimum, maximum and sum of durations in
+ *   os_cputime ticks (struct stats_time), fed with STATS_TIME_START() /
+ *   STATS_TIME_END() or STATS_TIME_ADD().
+ *
+ * - STATS_SECT_SHARD(): a 32-bit counter with one slot per context (task or
+ *   interrupt), incremented with STATS_SHARD_INC().  Counters bumped from
+ *   both an interrupt handler and a task stay exact without a critical
+ *   section per increment; readers see the sum of the slots.
+ *
  * Following the statics entry declaration is the statistic names declaration.
  * This is compiled out when STATS_NAME_ENABLE is set to 0.  This declaration
  * is const, and therefore can be located in .text, not .data.
@@ -212,10 +228,60 @@ int
 stats_init(struct stats_hdr *shdr, uint8_t size, uint8_t cnt,
         const struct stats_name_map *map, uint8_t map_cnt)
 {
+    return stats_init_type(shdr, STATS_TYPE_CNT, size, cnt, map, map_cnt);
+}
+
+/**
+ * Initialize a statistics structure whose entries are of the specified
+ * kind.
+ *
+ * @param hdr The header of the statistics structure.
+ * @param type The kind of entries in the structure, one of the
+ *             STATS_TYPE_[...] values.
+ * @param size The size of the individual statistics elements: 2, 4 or 8
+ *             for counters, STATS_SIZE_HIST for histograms,
+ *             STATS_SIZE_TIME for timings.
+ * @param cnt The number of elements in the statistics structure
+ * @param map The mapping of statistics name to statistic entry
+ * @param map_cnt The number of items in the statistics map
+ *
+ * @return 0 on success, non-zero error code on failure.
+ */
+int
+stats_init_type(struct stats_hdr *shdr, uint8_t type, uint8_t size,
+        uint8_t cnt, const struct stats_name_map *map, uint8_t map_cnt)
+{
+    switch (type) {
+    case STATS_TYPE_CNT:
+        break;
+    case STATS_TYPE_HIST:
+        if (size != STATS_SIZE_HIST) {
+            return (OS_EINVAL);
+        }
+        break;
+    case STATS_TYPE_TIME:
+        if (size != STATS_SIZE_TIME) {
+            return (OS_EINVAL);
+        }
+        break;
+    case STATS_TYPE_SHARD:
+        if (size != STATS_SIZE_SHARD) {
+            return (OS_EINVAL);
+        }
+        break;
+    default:
+        return (OS_EINVAL);
+    }
+
     memset((uint8_t *) shdr+sizeof(*shdr), 0, size * cnt);
 
     shdr->s_size = size;
     shdr->s_cnt = cnt;
+    shdr->s_type = type;
+#if MYNEWT_VAL(STATS_SNAPSHOT)
+    shdr->s_snap = NULL;
+    shdr->s_snap_gen = 0;
+#endif
 #if MYNEWT_VAL(STATS_NAMES)
     shdr->s_map = map;
     shdr->s_map_cnt = map_cnt;
@@ -365,6 +431,23 @@ stats_reset(struct stats_hdr *hdr)
 
     while (cur < end) {
         stat_val = (uint8_t*)hdr + cur;
+        switch (hdr->s_type) {
+        case STATS_TYPE_HIST:
+            /* The bucket width is configuration, not data; keep it. */
+            memset(((struct stats_hist *)stat_val)->sh_buckets, 0,
+                   sizeof(((struct stats_hist *)stat_val)->sh_buckets));
+            cur += hdr->s_size;
+            continue;
+        case STATS_TYPE_TIME:
+            memset(stat_val, 0, sizeof(struct stats_time));
+            cur += hdr->s_size;
+            continue;
+        case STATS_TYPE_SHARD:
+            memset(stat_val, 0, sizeof(struct stats_shard));
+            cur += hdr->s_size;
+            continue;
+        }
+
         switch (hdr->s_size) {
             case sizeof(uint16_t):
                 *(uint16_t *)stat_val = 0;
@@ -385,3 +468,82 @@ stats_reset(struct stats_hdr *hdr)
     }
     return;
 }
+
+/**
+ * Returns the index of the histogram bucket that counts the specified
+ * value.
+ */
+static int
+stats_hist_bucket(const struct stats_hist *hist, uint32_t val)
+{
+    uint32_t bucket;
+
+    if (hist->sh_width != 0) {
+        bucket = val / hist->sh_width;
+    } else if (val == 0) {
+        bucket = 0;
+    } else {
+        bucket = 32 - __builtin_clz(val);
+    }
+
+    if (bucket >= MYNEWT_VAL(STATS_HIST_BUCKETS)) {
+        bucket = MYNEWT_VAL(STATS_HIST_BUCKETS) - 1;
+    }
+
+    return (bucket);
+}
+
+/**
+ * Records a sample in a histogram entry.
+ *
+ * @param hist The histogram to update.
+ * @param val The sample value.
+ */
+void
+stats_hist_add(struct stats_hist *hist, uint32_t val)
+{
+    hist->sh_buckets[stats_hist_bucket(hist, val)]++;
+}
+
+/**
+ * Returns the smallest value counted by the specified histogram bucket.
+ *
+ * @param hist The histogram.
+ * @param bucket The index of the bucket.
+ *
+ * @return The lower bound of the bucket.
+ */
+uint32_t
+stats_hist_bucket_min(const struct stats_hist *hist, int bucket)
+{
+    if (hist->sh_width != 0) {
+        return (bucket * hist->sh_width);
+    } else if (bucket == 0) {
+        return (0);
+    } else {
+        return (1UL << (bucket - 1));
+    }
+}
+
+/**
+ * Records a duration in a timing entry.
+ *
+ * @param time The timing entry to update.
+ * @param ticks The duration, in os_cputime ticks.
+ */
+void
+stats_time_add(struct stats_time *time, uint32_t ticks)
+{
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    if (time->st_cnt == 0 || ticks < time->st_min) {
+        time->st_min = ticks;
+    }
+    if (time->st_cnt == 0 || ticks > time->st_max) {
+        time->st_max = ticks;
+    }
+    time->st_cnt++;
+    time->st_sum += ticks;
+    OS_EXIT_CRITICAL(sr);
+}
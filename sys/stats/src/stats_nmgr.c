@@ -19,6 +19,7 @@
 
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "syscfg/syscfg.h"
 
@@ -34,31 +35,91 @@
  */
 static int stats_nmgr_read(struct mgmt_cbuf *cb);
 static int stats_nmgr_list(struct mgmt_cbuf *cb);
+#if MYNEWT_VAL(STATS_SNAPSHOT)
+static int stats_nmgr_snap(struct mgmt_cbuf *cb);
+#endif
 
 static struct mgmt_group shell_nmgr_group;
 
 #define STATS_NMGR_ID_READ  (0)
 #define STATS_NMGR_ID_LIST  (1)
+#define STATS_NMGR_ID_SNAP  (2)
 
 /* ORDER MATTERS HERE.
  * Each element represents the command ID, referenced from newtmgr.
  */
 static struct mgmt_handler shell_nmgr_group_handlers[] = {
     [STATS_NMGR_ID_READ] = {stats_nmgr_read, stats_nmgr_read},
-    [STATS_NMGR_ID_LIST] = {stats_nmgr_list, stats_nmgr_list}
+    [STATS_NMGR_ID_LIST] = {stats_nmgr_list, stats_nmgr_list},
+#if MYNEWT_VAL(STATS_SNAPSHOT)
+    [STATS_NMGR_ID_SNAP] = {stats_nmgr_snap, stats_nmgr_snap},
+#endif
 };
 
-static int
-stats_nmgr_walk_func(struct stats_hdr *hdr, void *arg, char *sname,
-        uint16_t stat_off)
+/**
+ * Encodes a histogram as {"width": <uint>, "buckets": [<uint>, ...]}.  A
+ * width of 0 indicates power-of-two buckets.
+ */
+static CborError
+stats_nmgr_encode_hist(CborEncoder *penc, const struct stats_hist *hist)
 {
-    void *stat_val;
-    CborEncoder *penc = (CborEncoder *) arg;
     CborError g_err = CborNoError;
+    CborEncoder map, buckets;
+    int i;
+
+    g_err |= cbor_encoder_create_map(penc, &map, 2);
+    g_err |= cbor_encode_text_stringz(&map, "width");
+    g_err |= cbor_encode_uint(&map, hist->sh_width);
+    g_err |= cbor_encode_text_stringz(&map, "buckets");
+    g_err |= cbor_encoder_create_array(&map, &buckets,
+                                       MYNEWT_VAL(STATS_HIST_BUCKETS));
+    for (i = 0; i < MYNEWT_VAL(STATS_HIST_BUCKETS); i++) {
+        g_err |= cbor_encode_uint(&buckets, hist->sh_buckets[i]);
+    }
+    g_err |= cbor_encoder_close_container(&map, &buckets);
+    g_err |= cbor_encoder_close_container(penc, &map);
 
-    stat_val = (uint8_t *)hdr + stat_off;
+    return (g_err);
+}
 
-    g_err |= cbor_encode_text_stringz(penc, sname);
+/**
+ * Encodes a timing entry as {"cnt", "min", "max", "sum"}, all in os_cputime
+ * ticks.
+ */
+static CborError
+stats_nmgr_encode_time(CborEncoder *penc, const struct stats_time *time)
+{
+    CborError g_err = CborNoError;
+    CborEncoder map;
+
+    g_err |= cbor_encoder_create_map(penc, &map, 4);
+    g_err |= cbor_encode_text_stringz(&map, "cnt");
+    g_err |= cbor_encode_uint(&map, time->st_cnt);
+    g_err |= cbor_encode_text_stringz(&map, "min");
+    g_err |= cbor_encode_uint(&map, time->st_min);
+    g_err |= cbor_encode_text_stringz(&map, "max");
+    g_err |= cbor_encode_uint(&map, time->st_max);
+    g_err |= cbor_encode_text_stringz(&map, "sum");
+    g_err |= cbor_encode_uint(&map, time->st_sum);
+    g_err |= cbor_encoder_close_container(penc, &map);
+
+    return (g_err);
+}
+
+static CborError
+stats_nmgr_encode_val(CborEncoder *penc, struct stats_hdr *hdr,
+                      void *stat_val)
+{
+    CborError g_err = CborNoError;
+
+    switch (hdr->s_type) {
+        case STATS_TYPE_HIST:
+            return stats_nmgr_encode_hist(penc, stat_val);
+        case STATS_TYPE_TIME:
+            return stats_nmgr_encode_time(penc, stat_val);
+        case STATS_TYPE_SHARD:
+            return cbor_encode_uint(penc, stats_shard_sum(stat_val));
+    }
 
     switch (hdr->s_size) {
         case sizeof(uint16_t):
@@ -75,6 +136,19 @@ stats_nmgr_walk_func(struct stats_hdr *hdr, void *arg, char *sname,
     return (g_err);
 }
 
+static int
+stats_nmgr_walk_func(struct stats_hdr *hdr, void *arg, char *sname,
+        uint16_t stat_off)
+{
+    CborEncoder *penc = (CborEncoder *) arg;
+    CborError g_err = CborNoError;
+
+    g_err |= cbor_encode_text_stringz(penc, sname);
+    g_err |= stats_nmgr_encode_val(penc, hdr, (uint8_t *)hdr + stat_off);
+
+    return (g_err);
+}
+
 static int
 stats_nmgr_encode_name(struct stats_hdr *hdr, void *arg)
 {
@@ -161,6 +235,164 @@ stats_nmgr_list(struct mgmt_cbuf *cb)
     return (0);
 }
 
+#if MYNEWT_VAL(STATS_SNAPSHOT)
+
+/* Generation of the most recent snapshot read; 0 is never issued. */
+static uint32_t stats_nmgr_snap_gen;
+
+struct stats_nmgr_snap_arg {
+    CborEncoder *sa_groups;
+    CborEncoder sa_fields;
+    uint32_t sa_gen;
+    int sa_group_idx;
+    int sa_full;
+    int sa_open;
+    CborError sa_err;
+};
+
+static int
+stats_nmgr_snap_entry(struct stats_hdr *hdr, void *arg, char *sname,
+                      uint16_t stat_off)
+{
+    struct stats_nmgr_snap_arg *sa;
+    uint8_t val[sizeof(struct stats_hist) > sizeof(struct stats_time) ?
+                sizeof(struct stats_hist) : sizeof(struct stats_time)];
+    uint8_t *snap_val;
+    uint16_t idx;
+
+    sa = arg;
+    idx = (stat_off - sizeof(*hdr)) / hdr->s_size;
+
+    /* Copy the entry first so that the value reported is the value
+     * remembered, even if the statistic is updated concurrently.
+     */
+    memcpy(val, (uint8_t *)hdr + stat_off, hdr->s_size);
+    if (hdr->s_snap != NULL) {
+        snap_val = (uint8_t *)hdr->s_snap + idx * hdr->s_size;
+        if (!sa->sa_full && memcmp(snap_val, val, hdr->s_size) == 0) {
+            return (0);
+        }
+        memcpy(snap_val, val, hdr->s_size);
+    }
+
+    if (!sa->sa_open) {
+        sa->sa_err |= cbor_encode_uint(sa->sa_groups, sa->sa_group_idx);
+        sa->sa_err |= cbor_encoder_create_map(sa->sa_groups, &sa->sa_fields,
+                                              CborIndefiniteLength);
+        sa->sa_open = 1;
+    }
+    sa->sa_err |= cbor_encode_uint(&sa->sa_fields, idx);
+    sa->sa_err |= stats_nmgr_encode_val(&sa->sa_fields, hdr, val);
+
+    return (0);
+}
+
+static int
+stats_nmgr_snap_group(struct stats_hdr *hdr, void *arg)
+{
+    struct stats_nmgr_snap_arg *sa;
+    int full;
+
+    sa = arg;
+
+    if (hdr->s_snap == NULL) {
+        /* On allocation failure the group is simply reported in full. */
+        hdr->s_snap = malloc(hdr->s_size * hdr->s_cnt);
+        hdr->s_snap_gen = 0;
+    }
+
+    /* A group only has a valid baseline if it took part in the snapshot
+     * the client is asking about.
+     */
+    full = sa->sa_full;
+    if (hdr->s_snap == NULL || hdr->s_snap_gen != stats_nmgr_snap_gen) {
+        sa->sa_full = 1;
+    }
+
+    sa->sa_open = 0;
+    stats_walk(hdr, stats_nmgr_snap_entry, sa);
+    if (sa->sa_open) {
+        sa->sa_err |= cbor_encoder_close_container(sa->sa_groups,
+                                                   &sa->sa_fields);
+    }
+
+    if (hdr->s_snap != NULL) {
+        hdr->s_snap_gen = sa->sa_gen;
+    }
+    sa->sa_full = full;
+    sa->sa_group_idx++;
+
+    return (0);
+}
+
+/**
+ * Reads all statistics groups.  Request: {"gen": <uint>}, the generation
+ * returned by the client's previous snapshot, or 0.  Response:
+ *     {"rc": 0, "gen": <uint>, "full": <bool>,
+ *      "groups": {<group idx>: {<entry idx>: <value>, ...}, ...}}
+ * Group indices follow the order of the "list" command and entry indices
+ * the order of the entries in the group.  Unless "full" is set, only entries
+ * that changed since the requested generation are present, and unchanged
+ * groups are omitted.  Only the latest generation is remembered; a client
+ * presenting any other gets a full read.
+ */
+static int
+stats_nmgr_snap(struct mgmt_cbuf *cb)
+{
+    struct stats_nmgr_snap_arg sa;
+    uint64_t req_gen;
+    struct cbor_attr_t attrs[] = {
+        { "gen", CborAttrUnsignedIntegerType, .addr.uinteger = &req_gen,
+            .nodefault = true },
+        { NULL },
+    };
+    CborError g_err = CborNoError;
+    CborEncoder *penc = &cb->encoder;
+    CborEncoder rsp, groups;
+
+    req_gen = 0;
+    g_err = cbor_read_object(&cb->it, attrs);
+    if (g_err != 0) {
+        mgmt_cbuf_setoerr(cb, MGMT_ERR_EINVAL);
+        return (0);
+    }
+
+    memset(&sa, 0, sizeof sa);
+    sa.sa_full = req_gen == 0 || req_gen != stats_nmgr_snap_gen;
+    sa.sa_gen = stats_nmgr_snap_gen + 1;
+    if (sa.sa_gen == 0) {
+        sa.sa_gen = 1;
+    }
+
+    g_err |= cbor_encoder_create_map(penc, &rsp, CborIndefiniteLength);
+    g_err |= cbor_encode_text_stringz(&rsp, "rc");
+    g_err |= cbor_encode_int(&rsp, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&rsp, "gen");
+    g_err |= cbor_encode_uint(&rsp, sa.sa_gen);
+    g_err |= cbor_encode_text_stringz(&rsp, "full");
+    g_err |= cbor_encode_boolean(&rsp, sa.sa_full);
+    g_err |= cbor_encode_text_stringz(&rsp, "groups");
+    g_err |= cbor_encoder_create_map(&rsp, &groups, CborIndefiniteLength);
+
+    sa.sa_groups = &groups;
+    stats_group_walk(stats_nmgr_snap_group, &sa);
+    g_err |= sa.sa_err;
+
+    g_err |= cbor_encoder_close_container(&rsp, &groups);
+    g_err |= cbor_encoder_close_container(penc, &rsp);
+
+    if (g_err) {
+        /* The snapshots have moved on; force the next read to be full. */
+        stats_nmgr_snap_gen = 0;
+        return MGMT_ERR_ENOMEM;
+    }
+    stats_nmgr_snap_gen = sa.sa_gen;
+
+    return (0);
+}
+
+#endif /* MYNEWT_VAL(STATS_SNAPSHOT) */
+
 /**
  * Register nmgr group handlers
  */
@@ -37,6 +37,36 @@ static struct shell_cmd shell_stats_cmd = {
 };
 uint8_t stats_shell_registered;
 
+static void
+stats_shell_display_hist(char *name, const struct stats_hist *hist)
+{
+    int i;
+
+    console_printf("%s:\n", name);
+    for (i = 0; i < MYNEWT_VAL(STATS_HIST_BUCKETS); i++) {
+        console_printf("    >=%lu: %lu\n",
+                       (unsigned long)stats_hist_bucket_min(hist, i),
+                       (unsigned long)hist->sh_buckets[i]);
+    }
+}
+
+static void
+stats_shell_display_time(char *name, const struct stats_time *time)
+{
+    unsigned long avg;
+
+    if (time->st_cnt == 0) {
+        console_printf("%s: cnt=0\n", name);
+        return;
+    }
+
+    avg = time->st_sum / time->st_cnt;
+    console_printf("%s: cnt=%lu min=%lu max=%lu avg=%lu sum=%llu\n", name,
+                   (unsigned long)time->st_cnt, (unsigned long)time->st_min,
+                   (unsigned long)time->st_max, avg,
+                   (unsigned long long)time->st_sum);
+}
+
 static int 
 stats_shell_display_entry(struct stats_hdr *hdr, void *arg, char *name,
         uint16_t stat_off)
@@ -44,6 +74,19 @@ stats_shell_display_entry(struct stats_hdr *hdr, void *arg, char *name,
     void *stat_val;
 
     stat_val = (uint8_t *)hdr + stat_off;
+    switch (hdr->s_type) {
+        case STATS_TYPE_HIST:
+            stats_shell_display_hist(name, stat_val);
+            return (0);
+        case STATS_TYPE_TIME:
+            stats_shell_display_time(name, stat_val);
+            return (0);
+        case STATS_TYPE_SHARD:
+            console_printf("%s: %lu\n", name,
+                           (unsigned long)stats_shard_sum(stat_val));
+            return (0);
+    }
+
     switch (hdr->s_size) {
         case sizeof(uint16_t):
             console_printf("%s: %u\n", name, *(uint16_t *) stat_val);
@@ -20,6 +20,7 @@
 #ifndef H_SYSINIT_
 #define H_SYSINIT_
 
+#include <inttypes.h>
 #include "syscfg/syscfg.h"
 #include "bootutil/bootutil.h"
 
@@ -48,12 +49,71 @@ void MYNEWT_VAL(SYSINIT_PANIC_FN)(const char *file, int line);
     }                               \
 } while (0)
 
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+
+#include "os/os_cputime.h"
+
+/** One line of the boot-time report. */
+struct sysinit_profile_entry {
+    const char *spe_name;
+    uint32_t spe_start;         /* os_cputime when the step began. */
+    uint32_t spe_ticks;         /* Duration, in os_cputime ticks. */
+    uint8_t spe_async;          /* 1 if the step ran as a deferred job. */
+};
+
+void sysinit_profile_record(const char *name, uint32_t start, int async);
+int sysinit_profile_get(int idx, struct sysinit_profile_entry *out_entry);
+
+#define SYSINIT_PROFILE_MARK()              os_cputime_get32()
+#define SYSINIT_PROFILE_RECORD(name, mark)  \
+    sysinit_profile_record((name), (mark), 0)
+
+#else
+
+#define SYSINIT_PROFILE_MARK()              0
+#define SYSINIT_PROFILE_RECORD(name, mark)  ((void)(mark))
+
+#endif
+
+#if MYNEWT_VAL(SYSINIT_ASYNC)
+
+#include "os/queue.h"
+
+typedef int sysinit_job_fn(void *arg);
+
+/**
+ * A deferred piece of package initialization.  sj_deps is an optional
+ * NULL-terminated list of names of jobs that must complete before this one
+ * runs; names with no registered job are treated as complete.
+ */
+struct sysinit_job {
+    const char *sj_name;
+    sysinit_job_fn *sj_fn;
+    void *sj_arg;
+    const char * const *sj_deps;
+
+    /*** Private. */
+    uint8_t sj_done;
+    int sj_rc;
+    STAILQ_ENTRY(sysinit_job) sj_next;
+};
+
+int sysinit_defer(struct sysinit_job *job);
+int sysinit_job_done(const struct sysinit_job *job, int *out_rc);
+
+#endif
+
 
 #if MYNEWT_VAL(SPLIT_LOADER)
 
 /*** System initialization for loader (first stage of split image). */
 void sysinit_loader(void);
-#define sysinit() sysinit_loader()
+#define sysinit() do                                                        \
+{                                                                           \
+    uint32_t sysinit_mark__ = SYSINIT_PROFILE_MARK();                       \
+    sysinit_loader();                                                       \
+    SYSINIT_PROFILE_RECORD("sysinit", sysinit_mark__);                      \
+} while (0)
 
 #elif MYNEWT_VAL(SPLIT_APPLICATION)
 
@@ -61,16 +121,23 @@ void sysinit_loader(void);
 void sysinit_app(void);
 #define sysinit() do                                                        \
 {                                                                           \
+    uint32_t sysinit_mark__ = SYSINIT_PROFILE_MARK();                       \
     /* Record that a split app is running; imgmgt needs to know this. */    \
     split_app_active_set(1);                                           \
     sysinit_app();                                                          \
+    SYSINIT_PROFILE_RECORD("sysinit", sysinit_mark__);                      \
 } while (0)
 
 #else
 
 /*** System initialization for a unified image (no split). */
 void sysinit_app(void);
-#define sysinit() sysinit_app()
+#define sysinit() do                                                        \
+{                                                                           \
+    uint32_t sysinit_mark__ = SYSINIT_PROFILE_MARK();                       \
+    sysinit_app();                                                          \
+    SYSINIT_PROFILE_RECORD("sysinit", sysinit_mark__);                      \
+} while (0)
 
 #endif
 
@@ -0,0 +1,273 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <string.h>
+
+#include "syscfg/syscfg.h"
+#include "defs/error.h"
+#include "os/os.h"
+#include "sysinit/sysinit.h"
+
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+
+static struct sysinit_profile_entry
+    sysinit_profile_entries[MYNEWT_VAL(SYSINIT_PROFILE_MAX)];
+static uint8_t sysinit_profile_cnt;
+
+/**
+ * Adds a step to the boot-time report.  The step's duration is measured from
+ * the specified start time to now.
+ *
+ * @param name                  The name of the step; must remain valid.
+ * @param start                 The os_cputime at which the step began.
+ * @param async                 1 if the step ran as a deferred job.
+ */
+void
+sysinit_profile_record(const char *name, uint32_t start, int async)
+{
+    struct sysinit_profile_entry *entry;
+    uint32_t now;
+    os_sr_t sr;
+
+    now = os_cputime_get32();
+
+    OS_ENTER_CRITICAL(sr);
+    if (sysinit_profile_cnt >= MYNEWT_VAL(SYSINIT_PROFILE_MAX)) {
+        entry = NULL;
+    } else {
+        entry = sysinit_profile_entries + sysinit_profile_cnt++;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (entry != NULL) {
+        entry->spe_name = name;
+        entry->spe_start = start;
+        entry->spe_ticks = now - start;
+        entry->spe_async = async;
+    }
+}
+
+/**
+ * Retrieves a step from the boot-time report.  Steps are numbered in the
+ * order in which they completed.
+ *
+ * @param idx                   The index of the step to retrieve.
+ * @param out_entry             On success, the step is written here.
+ *
+ * @return                      0 on success;
+ *                              SYS_ENOENT if there is no such step.
+ */
+int
+sysinit_profile_get(int idx, struct sysinit_profile_entry *out_entry)
+{
+    os_sr_t sr;
+    int rc;
+
+    OS_ENTER_CRITICAL(sr);
+    if (idx < 0 || idx >= sysinit_profile_cnt) {
+        rc = SYS_ENOENT;
+    } else {
+        *out_entry = sysinit_profile_entries[idx];
+        rc = 0;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return rc;
+}
+
+#endif
+
+#if MYNEWT_VAL(SYSINIT_ASYNC)
+
+static STAILQ_HEAD(, sysinit_job) sysinit_jobs =
+    STAILQ_HEAD_INITIALIZER(sysinit_jobs);
+
+static struct os_task sysinit_async_task;
+static os_stack_t sysinit_async_stack[
+    OS_STACK_ALIGN(MYNEWT_VAL(SYSINIT_ASYNC_TASK_STACK_SIZE))
+];
+static struct os_sem sysinit_async_sem;
+static uint8_t sysinit_async_started;
+
+static struct sysinit_job *
+sysinit_job_find(const char *name)
+{
+    struct sysinit_job *job;
+
+    STAILQ_FOREACH(job, &sysinit_jobs, sj_next) {
+        if (strcmp(job->sj_name, name) == 0) {
+            return job;
+        }
+    }
+
+    return NULL;
+}
+
+static int
+sysinit_job_ready(const struct sysinit_job *job)
+{
+    const struct sysinit_job *dep;
+    int i;
+
+    if (job->sj_deps == NULL) {
+        return 1;
+    }
+
+    for (i = 0; job->sj_deps[i] != NULL; i++) {
+        dep = sysinit_job_find(job->sj_deps[i]);
+        if (dep != NULL && !dep->sj_done) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Finds the first pending job whose dependencies have all completed.
+ */
+static struct sysinit_job *
+sysinit_job_next(void)
+{
+    struct sysinit_job *job;
+    os_sr_t sr;
+
+    OS_ENTER_CRITICAL(sr);
+    STAILQ_FOREACH(job, &sysinit_jobs, sj_next) {
+        if (!job->sj_done && sysinit_job_ready(job)) {
+            break;
+        }
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return job;
+}
+
+static void
+sysinit_async_task_handler(void *arg)
+{
+    struct sysinit_job *job;
+    uint32_t mark;
+    os_sr_t sr;
+    int rc;
+
+    while (1) {
+        job = sysinit_job_next();
+        if (job == NULL) {
+            /* Nothing runnable; wait for another job to be deferred. */
+            os_sem_pend(&sysinit_async_sem, OS_TIMEOUT_NEVER);
+            continue;
+        }
+
+        mark = SYSINIT_PROFILE_MARK();
+        rc = job->sj_fn(job->sj_arg);
+#if MYNEWT_VAL(SYSINIT_PROFILE)
+        sysinit_profile_record(job->sj_name, mark, 1);
+#else
+        (void)mark;
+#endif
+
+        OS_ENTER_CRITICAL(sr);
+        job->sj_rc = rc;
+        job->sj_done = 1;
+        OS_EXIT_CRITICAL(sr);
+    }
+}
+
+/**
+ * Defers part of a package's initialization to the sysinit task.  The job
+ * runs once the OS has started and every job named in its dependency list
+ * has completed.  The job structure must remain valid indefinitely.
+ *
+ * @param job                   The job to defer.
+ *
+ * @return                      0 on success;
+ *                              SYS_EINVAL if the job is malformed;
+ *                              SYS_EBUSY if a job with the same name has
+ *                                  already been deferred.
+ */
+int
+sysinit_defer(struct sysinit_job *job)
+{
+    os_sr_t sr;
+    int rc;
+
+    if (job->sj_name == NULL || job->sj_fn == NULL) {
+        return SYS_EINVAL;
+    }
+
+    if (!sysinit_async_started) {
+        os_sem_init(&sysinit_async_sem, 0);
+        rc = os_task_init(&sysinit_async_task, "sysinit",
+                          sysinit_async_task_handler, NULL,
+                          MYNEWT_VAL(SYSINIT_ASYNC_TASK_PRIO), OS_WAIT_FOREVER,
+                          sysinit_async_stack,
+                          MYNEWT_VAL(SYSINIT_ASYNC_TASK_STACK_SIZE));
+        if (rc != 0) {
+            return SYS_EINVAL;
+        }
+        sysinit_async_started = 1;
+    }
+
+    OS_ENTER_CRITICAL(sr);
+    if (sysinit_job_find(job->sj_name) != NULL) {
+        rc = SYS_EBUSY;
+    } else {
+        job->sj_done = 0;
+        job->sj_rc = 0;
+        STAILQ_INSERT_TAIL(&sysinit_jobs, job, sj_next);
+        rc = 0;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    if (rc == 0) {
+        os_sem_release(&sysinit_async_sem);
+    }
+
+    return rc;
+}
+
+/**
+ * Indicates whether a deferred job has completed.
+ *
+ * @param job                   The job to query.
+ * @param out_rc                On completion, the job's return code is
+ *                                  written here.  Pass NULL if you do not
+ *                                  require this information.
+ *
+ * @return                      1 if the job has completed; 0 otherwise.
+ */
+int
+sysinit_job_done(const struct sysinit_job *job, int *out_rc)
+{
+    os_sr_t sr;
+    int done;
+
+    OS_ENTER_CRITICAL(sr);
+    done = job->sj_done;
+    if (done && out_rc != NULL) {
+        *out_rc = job->sj_rc;
+    }
+    OS_EXIT_CRITICAL(sr);
+
+    return done;
+}
+
+#endif
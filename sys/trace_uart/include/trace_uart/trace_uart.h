@@ -0,0 +1,45 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef __TRACE_UART_H__
+#define __TRACE_UART_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Wire format: each os_trace_rec is sent as a TRACE_UART_SYNC byte followed
+ * by the 12 record bytes, all fields little endian:
+ *
+ *     [0xa5] [ts:4] [id:1] [task:1] [p16:2] [p32:4]
+ *
+ * The stream starts with an OS_TRACE_ID_INFO record whose p16 is the format
+ * version and whose p32 is the timestamp frequency in Hz.
+ */
+#define TRACE_UART_SYNC         0xa5
+#define TRACE_UART_FRAME_LEN    13
+
+void trace_uart_pkg_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,150 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "syscfg/syscfg.h"
+#include "sysinit/sysinit.h"
+#include "os/os.h"
+#include "uart/uart.h"
+#include "trace_uart/trace_uart.h"
+
+#define TRACE_UART_BUF_MASK     (MYNEWT_VAL(TRACE_UART_BUF_SIZE) - 1)
+#define TRACE_UART_BATCH        8
+
+static struct uart_dev *trace_uart_dev;
+
+static uint8_t trace_uart_buf[MYNEWT_VAL(TRACE_UART_BUF_SIZE)];
+static volatile uint16_t trace_uart_head;
+static volatile uint16_t trace_uart_tail;
+
+static struct os_task trace_uart_task;
+static os_stack_t trace_uart_stack[MYNEWT_VAL(TRACE_UART_STACK_SIZE)];
+
+/* Called by the UART driver with interrupts disabled. */
+static int
+trace_uart_tx_char(void *arg)
+{
+    uint8_t byte;
+
+    if (trace_uart_tail == trace_uart_head) {
+        return -1;
+    }
+
+    byte = trace_uart_buf[trace_uart_tail & TRACE_UART_BUF_MASK];
+    trace_uart_tail++;
+
+    return byte;
+}
+
+static int
+trace_uart_space(void)
+{
+    return MYNEWT_VAL(TRACE_UART_BUF_SIZE) -
+           (uint16_t)(trace_uart_head - trace_uart_tail);
+}
+
+static void
+trace_uart_put(uint8_t byte)
+{
+    trace_uart_buf[trace_uart_head & TRACE_UART_BUF_MASK] = byte;
+    trace_uart_head++;
+}
+
+static void
+trace_uart_put_le(uint32_t val, int len)
+{
+    while (len-- > 0) {
+        trace_uart_put(val);
+        val >>= 8;
+    }
+}
+
+static void
+trace_uart_put_rec(const struct os_trace_rec *rec)
+{
+    trace_uart_put(TRACE_UART_SYNC);
+    trace_uart_put_le(rec->otr_ts, 4);
+    trace_uart_put(rec->otr_id);
+    trace_uart_put(rec->otr_task);
+    trace_uart_put_le(rec->otr_p16, 2);
+    trace_uart_put_le(rec->otr_p32, 4);
+}
+
+static void
+trace_uart_task_handler(void *arg)
+{
+    struct os_trace_rec recs[TRACE_UART_BATCH];
+    int max;
+    int cnt;
+    int i;
+
+    /* Emits the INFO record the host synchronizes on. */
+    os_trace_enable(1);
+
+    while (1) {
+        max = trace_uart_space() / TRACE_UART_FRAME_LEN;
+        if (max > TRACE_UART_BATCH) {
+            max = TRACE_UART_BATCH;
+        }
+
+        cnt = 0;
+        if (max > 0) {
+            cnt = os_trace_read(recs, max);
+            for (i = 0; i < cnt; i++) {
+                trace_uart_put_rec(&recs[i]);
+            }
+            if (cnt > 0) {
+                uart_start_tx(trace_uart_dev);
+            }
+        }
+
+        if (cnt < TRACE_UART_BATCH) {
+            os_time_delay(MYNEWT_VAL(TRACE_UART_POLL_MS) *
+                          OS_TICKS_PER_SEC / 1000 + 1);
+        }
+    }
+}
+
+void
+trace_uart_pkg_init(void)
+{
+    struct uart_conf uc = {
+        .uc_speed = MYNEWT_VAL(TRACE_UART_BAUD),
+        .uc_databits = 8,
+        .uc_stopbits = 1,
+        .uc_parity = UART_PARITY_NONE,
+        .uc_flow_ctl = UART_FLOW_CTL_NONE,
+        .uc_tx_char = trace_uart_tx_char,
+        .uc_cb_arg = NULL,
+    };
+    int rc;
+
+    assert((MYNEWT_VAL(TRACE_UART_BUF_SIZE) & TRACE_UART_BUF_MASK) == 0);
+
+    trace_uart_dev = (struct uart_dev *)os_dev_open(MYNEWT_VAL(TRACE_UART_DEV),
+                                                    OS_TIMEOUT_NEVER, &uc);
+    SYSINIT_PANIC_ASSERT(trace_uart_dev != NULL);
+
+    rc = os_task_init(&trace_uart_task, "trace_uart", trace_uart_task_handler,
+                      NULL, MYNEWT_VAL(TRACE_UART_TASK_PRIO), OS_WAIT_FOREVER,
+                      trace_uart_stack, MYNEWT_VAL(TRACE_UART_STACK_SIZE));
+    SYSINIT_PANIC_ASSERT(rc == 0);
+}
@@ -0,0 +1,102 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <inttypes.h>
+#include "os/queue.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Prepares a benchmark's state before its iterations are timed.  Returns 0
+ * on success.
+ */
+typedef int bench_setup_fn(void *arg);
+
+/*
+ * Performs one iteration of the operation being measured.  A nonzero return
+ * code aborts the benchmark.
+ */
+typedef int bench_run_fn(void *arg);
+
+/*
+ * Releases whatever the setup function acquired.
+ */
+typedef void bench_teardown_fn(void *arg);
+
+/*
+ * Outcome of a benchmark run.  Per-iteration figures are in bench units
+ * (see bench_units()), with the cost of the timing loop itself removed.
+ */
+struct bench_result {
+    uint32_t br_iters;          /* Iterations per repetition. */
+    uint32_t br_reps;           /* Number of repetitions. */
+    uint32_t br_min;            /* Per iteration, fastest repetition. */
+    uint32_t br_max;            /* Per iteration, slowest repetition. */
+    uint32_t br_avg;            /* Per iteration, all repetitions. */
+    uint32_t br_total;          /* All repetitions. */
+    int br_rc;                  /* Nonzero if the run was aborted. */
+};
+
+struct bench_case {
+    const char *bc_name;
+    bench_setup_fn *bc_setup;           /* Optional. */
+    bench_run_fn *bc_run;
+    bench_teardown_fn *bc_teardown;     /* Optional. */
+    void *bc_arg;
+    uint32_t bc_iters;                  /* Iterations per repetition. */
+
+    /*** Private. */
+    struct bench_result bc_last;
+    uint8_t bc_ran;
+    SLIST_ENTRY(bench_case) bc_next;
+};
+
+/*
+ * Current value of the benchmark timer; the DWT cycle counter or os_cputime,
+ * depending on BENCH_DWT_CYCCNT.
+ */
+uint32_t bench_now(void);
+
+/*
+ * Name of the unit bench_now() counts in: "cycles" or "ticks".
+ */
+const char *bench_units(void);
+
+int bench_register(struct bench_case *bc);
+struct bench_case *bench_find(const char *name);
+struct bench_case *bench_next(struct bench_case *prev);
+int bench_run(struct bench_case *bc, struct bench_result *out_result);
+void bench_print(const struct bench_case *bc,
+                 const struct bench_result *result);
+
+/*
+ * Registers the configured benchmarks and adds the bench commands to your
+ * shell/newtmgr.
+ */
+void bench_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BENCH_H__ */
@@ -0,0 +1,291 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <inttypes.h>
+#include <string.h>
+#include <assert.h>
+
+#include "syscfg/syscfg.h"
+#include "sysinit/sysinit.h"
+#include "defs/error.h"
+#include "os/os.h"
+#include "os/os_cputime.h"
+#include "console/console.h"
+
+#if MYNEWT_VAL(BENCH_DWT_CYCCNT)
+#include <bsp/cmsis_nvic.h>
+#endif
+
+#include "bench/bench.h"
+#include "bench_priv.h"
+
+#if MYNEWT_VAL(BENCH_CLI)
+#include "shell/shell.h"
+#endif
+#if MYNEWT_VAL(BENCH_NEWTMGR)
+#include "mgmt/mgmt.h"
+#endif
+
+static SLIST_HEAD(, bench_case) bench_cases =
+    SLIST_HEAD_INITIALIZER(bench_cases);
+
+uint32_t
+bench_now(void)
+{
+#if MYNEWT_VAL(BENCH_DWT_CYCCNT)
+    return DWT->CYCCNT;
+#else
+    return os_cputime_get32();
+#endif
+}
+
+const char *
+bench_units(void)
+{
+#if MYNEWT_VAL(BENCH_DWT_CYCCNT)
+    return "cycles";
+#else
+    return "ticks";
+#endif
+}
+
+static void
+bench_timer_init(void)
+{
+#if MYNEWT_VAL(BENCH_DWT_CYCCNT)
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+/**
+ * Empty iteration; timing a batch of these gives the cost of the loop and
+ * the indirect call, which is subtracted from every measurement.
+ */
+static int
+bench_nop(void *arg)
+{
+    return 0;
+}
+
+static uint32_t
+bench_loop(bench_run_fn *fn, void *arg, uint32_t iters, int *out_rc)
+{
+    uint32_t start;
+    uint32_t i;
+    int rc;
+
+    rc = 0;
+    start = bench_now();
+    for (i = 0; i < iters; i++) {
+        rc = fn(arg);
+        if (rc != 0) {
+            break;
+        }
+    }
+    *out_rc = rc;
+
+    return bench_now() - start;
+}
+
+/**
+ * Adds a benchmark to the set that can be listed and run by name.
+ *
+ * @param bc                    The benchmark to register; must remain valid.
+ *
+ * @return                      0 on success;
+ *                              SYS_EINVAL if the benchmark is malformed or
+ *                                  its name is already taken.
+ */
+int
+bench_register(struct bench_case *bc)
+{
+    if (bc->bc_name == NULL || bc->bc_run == NULL) {
+        return SYS_EINVAL;
+    }
+    if (bench_find(bc->bc_name) != NULL) {
+        return SYS_EINVAL;
+    }
+
+    bc->bc_ran = 0;
+    SLIST_INSERT_HEAD(&bench_cases, bc, bc_next);
+
+    return 0;
+}
+
+struct bench_case *
+bench_find(const char *name)
+{
+    struct bench_case *bc;
+
+    SLIST_FOREACH(bc, &bench_cases, bc_next) {
+        if (strcmp(bc->bc_name, name) == 0) {
+            return bc;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * Iterates the registered benchmarks.  Pass NULL to get the first one.
+ */
+struct bench_case *
+bench_next(struct bench_case *prev)
+{
+    if (prev == NULL) {
+        return SLIST_FIRST(&bench_cases);
+    }
+    return SLIST_NEXT(prev, bc_next);
+}
+
+/**
+ * Runs a benchmark: its setup function, BENCH_REPS timed batches of
+ * bc_iters iterations, then its teardown function.  The result is also kept
+ * as the benchmark's last result.
+ *
+ * @param bc                    The benchmark to run.
+ * @param out_result            On return, the result is written here.  Pass
+ *                                  NULL if you do not require it.
+ *
+ * @return                      0 on success; the setup or iteration return
+ *                                  code if the run was aborted.
+ */
+int
+bench_run(struct bench_case *bc, struct bench_result *out_result)
+{
+    struct bench_result res;
+    uint32_t overhead;
+    uint32_t elapsed;
+    uint32_t per_iter;
+    uint32_t iters;
+    int rc;
+    int i;
+
+    memset(&res, 0, sizeof res);
+
+    iters = bc->bc_iters;
+    if (iters == 0) {
+        iters = 1;
+    }
+    res.br_iters = iters;
+
+    if (bc->bc_setup != NULL) {
+        rc = bc->bc_setup(bc->bc_arg);
+        if (rc != 0) {
+            res.br_rc = rc;
+            goto done;
+        }
+    }
+
+    res.br_min = UINT32_MAX;
+    for (i = 0; i < MYNEWT_VAL(BENCH_REPS); i++) {
+        overhead = bench_loop(bench_nop, NULL, iters, &rc);
+        elapsed = bench_loop(bc->bc_run, bc->bc_arg, iters, &rc);
+        if (rc != 0) {
+            res.br_rc = rc;
+            break;
+        }
+
+        if (elapsed > overhead) {
+            elapsed -= overhead;
+        } else {
+            elapsed = 0;
+        }
+
+        per_iter = elapsed / iters;
+        if (per_iter < res.br_min) {
+            res.br_min = per_iter;
+        }
+        if (per_iter > res.br_max) {
+            res.br_max = per_iter;
+        }
+        res.br_total += elapsed;
+        res.br_reps++;
+    }
+
+    if (res.br_reps == 0) {
+        res.br_min = 0;
+    } else {
+        res.br_avg = res.br_total / (res.br_reps * iters);
+    }
+
+    if (bc->bc_teardown != NULL) {
+        bc->bc_teardown(bc->bc_arg);
+    }
+
+done:
+    bc->bc_last = res;
+    bc->bc_ran = 1;
+    if (out_result != NULL) {
+        *out_result = res;
+    }
+
+    return res.br_rc;
+}
+
+/**
+ * Prints a result as a single line of key=value pairs, so that console logs
+ * can be collected and compared by scripts.
+ */
+void
+bench_print(const struct bench_case *bc, const struct bench_result *result)
+{
+    console_printf("bench name=%s iters=%lu reps=%lu min=%lu avg=%lu "
+                   "max=%lu total=%lu unit=%s rc=%d\n",
+                   bc->bc_name,
+                   (unsigned long)result->br_iters,
+                   (unsigned long)result->br_reps,
+                   (unsigned long)result->br_min,
+                   (unsigned long)result->br_avg,
+                   (unsigned long)result->br_max,
+                   (unsigned long)result->br_total,
+                   bench_units(), result->br_rc);
+}
+
+void
+bench_init(void)
+{
+    int rc;
+
+    bench_timer_init();
+
+#if MYNEWT_VAL(BENCH_STD)
+    rc = bench_std_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+#if MYNEWT_VAL(BENCH_FS) || MYNEWT_VAL(BENCH_FCB)
+    rc = bench_fs_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+#if MYNEWT_VAL(BENCH_BLE_ATT)
+    rc = bench_ble_register();
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+
+#if MYNEWT_VAL(BENCH_CLI)
+    shell_cmd_register(&bench_cli_cmd);
+#endif
+#if MYNEWT_VAL(BENCH_NEWTMGR)
+    rc = mgmt_group_register(&bench_nmgr_group);
+    SYSINIT_PANIC_ASSERT(rc == 0);
+#endif
+
+    (void)rc;
+}
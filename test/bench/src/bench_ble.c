@@ -0,0 +1,61 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(BENCH_BLE_ATT)
+
+#include <inttypes.h>
+
+#include "host/ble_hs.h"
+#include "host/ble_uuid.h"
+
+#include "bench/bench.h"
+#include "bench_priv.h"
+
+/* GAP service and device name characteristic. */
+#define BENCH_BLE_SVC_UUID16        0x1800
+#define BENCH_BLE_CHR_UUID16        0x2a00
+
+/*** att_lookup: resolve a characteristic the way ATT requests do. */
+
+static int
+bench_ble_att_lookup_run(void *arg)
+{
+    uint16_t def_handle;
+    uint16_t val_handle;
+
+    return ble_gatts_find_chr(BLE_UUID16(BENCH_BLE_SVC_UUID16),
+                              BLE_UUID16(BENCH_BLE_CHR_UUID16),
+                              &def_handle, &val_handle);
+}
+
+static struct bench_case bench_ble_att_lookup = {
+    .bc_name = "att_lookup",
+    .bc_run = bench_ble_att_lookup_run,
+    .bc_iters = 100,
+};
+
+int
+bench_ble_register(void)
+{
+    return bench_register(&bench_ble_att_lookup);
+}
+
+#endif /* MYNEWT_VAL(BENCH_BLE_ATT) */
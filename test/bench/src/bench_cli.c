@@ -0,0 +1,77 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(BENCH_CLI)
+#include <inttypes.h>
+#include <string.h>
+#include <os/os.h>
+#include <console/console.h>
+#include <shell/shell.h>
+
+#include "bench/bench.h"
+#include "bench_priv.h"
+
+static int bench_cli_cmd_fn(int argc, char **argv);
+struct shell_cmd bench_cli_cmd = {
+    .sc_cmd = "bench",
+    .sc_cmd_func = bench_cli_cmd_fn
+};
+
+static void
+bench_cli_run(struct bench_case *bc)
+{
+    struct bench_result res;
+
+    bench_run(bc, &res);
+    bench_print(bc, &res);
+}
+
+static int
+bench_cli_cmd_fn(int argc, char **argv)
+{
+    struct bench_case *bc;
+
+    if (argc < 2) {
+        for (bc = bench_next(NULL); bc != NULL; bc = bench_next(bc)) {
+            console_printf("%s\n", bc->bc_name);
+        }
+        console_printf("Usage bench [<name>|all]\n");
+        return 0;
+    }
+
+    if (strcmp(argv[1], "all") == 0) {
+        for (bc = bench_next(NULL); bc != NULL; bc = bench_next(bc)) {
+            bench_cli_run(bc);
+        }
+        return 0;
+    }
+
+    bc = bench_find(argv[1]);
+    if (bc == NULL) {
+        console_printf("No benchmark named %s\n", argv[1]);
+        return 0;
+    }
+    bench_cli_run(bc);
+
+    return 0;
+}
+
+#endif /* MYNEWT_VAL(BENCH_CLI) */
@@ -0,0 +1,249 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(BENCH_FS) || MYNEWT_VAL(BENCH_FCB)
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "os/os.h"
+
+#if MYNEWT_VAL(BENCH_FS)
+#include "fs/fs.h"
+#endif
+#if MYNEWT_VAL(BENCH_FCB)
+#include "flash_map/flash_map.h"
+#include "fcb/fcb.h"
+#endif
+
+#include "bench/bench.h"
+#include "bench_priv.h"
+
+#define BENCH_FS_CHUNK          128
+#define BENCH_FS_FILE_SIZE      4096
+#define BENCH_FCB_ENTRY_LEN     32
+#define BENCH_FCB_MAX_SECTORS   16
+#define BENCH_FCB_MAGIC         0xbe4c4fcb
+
+static uint8_t bench_fs_buf[BENCH_FS_CHUNK];
+
+#if MYNEWT_VAL(BENCH_FS)
+
+static struct fs_file *bench_fs_file;
+static uint32_t bench_fs_off;
+
+/*** fs_write: append a chunk to a file. */
+
+static int
+bench_fs_write_setup(void *arg)
+{
+    fs_unlink(MYNEWT_VAL(BENCH_FS_FILE));
+    return fs_open(MYNEWT_VAL(BENCH_FS_FILE), FS_ACCESS_WRITE,
+                   &bench_fs_file);
+}
+
+static int
+bench_fs_write_run(void *arg)
+{
+    return fs_write(bench_fs_file, bench_fs_buf, sizeof bench_fs_buf);
+}
+
+static void
+bench_fs_teardown(void *arg)
+{
+    fs_close(bench_fs_file);
+    bench_fs_file = NULL;
+    fs_unlink(MYNEWT_VAL(BENCH_FS_FILE));
+}
+
+/*** fs_read: read a chunk at successive offsets of a 4KB file. */
+
+static int
+bench_fs_read_setup(void *arg)
+{
+    int rc;
+    int i;
+
+    rc = bench_fs_write_setup(arg);
+    if (rc != 0) {
+        return rc;
+    }
+    for (i = 0; i < BENCH_FS_FILE_SIZE / BENCH_FS_CHUNK; i++) {
+        rc = fs_write(bench_fs_file, bench_fs_buf, sizeof bench_fs_buf);
+        if (rc != 0) {
+            goto err;
+        }
+    }
+    rc = fs_close(bench_fs_file);
+    bench_fs_file = NULL;
+    if (rc != 0) {
+        goto err;
+    }
+
+    rc = fs_open(MYNEWT_VAL(BENCH_FS_FILE), FS_ACCESS_READ, &bench_fs_file);
+    if (rc != 0) {
+        goto err;
+    }
+    bench_fs_off = 0;
+
+    return 0;
+
+err:
+    bench_fs_teardown(arg);
+    return rc;
+}
+
+static int
+bench_fs_read_run(void *arg)
+{
+    uint32_t len;
+    int rc;
+
+    rc = fs_seek(bench_fs_file, bench_fs_off);
+    if (rc != 0) {
+        return rc;
+    }
+    rc = fs_read(bench_fs_file, sizeof bench_fs_buf, bench_fs_buf, &len);
+    if (rc != 0) {
+        return rc;
+    }
+
+    bench_fs_off = (bench_fs_off + BENCH_FS_CHUNK) % BENCH_FS_FILE_SIZE;
+
+    return 0;
+}
+
+#endif /* MYNEWT_VAL(BENCH_FS) */
+
+#if MYNEWT_VAL(BENCH_FCB)
+
+static struct flash_area bench_fcb_sectors[BENCH_FCB_MAX_SECTORS];
+static struct fcb bench_fcb;
+
+/*** fcb_append: reserve, write and commit a 32 byte entry. */
+
+static int
+bench_fcb_setup(void *arg)
+{
+    int cnt;
+    int rc;
+
+    cnt = BENCH_FCB_MAX_SECTORS;
+    rc = flash_area_to_sectors(MYNEWT_VAL(BENCH_FCB_FLASH_AREA), &cnt, NULL);
+    if (rc != 0 || cnt > BENCH_FCB_MAX_SECTORS || cnt < 2) {
+        return FCB_ERR_ARGS;
+    }
+    flash_area_to_sectors(MYNEWT_VAL(BENCH_FCB_FLASH_AREA), &cnt,
+                          bench_fcb_sectors);
+
+    memset(&bench_fcb, 0, sizeof bench_fcb);
+    bench_fcb.f_magic = BENCH_FCB_MAGIC;
+    bench_fcb.f_sector_cnt = cnt;
+    bench_fcb.f_scratch_cnt = 1;
+    bench_fcb.f_sectors = bench_fcb_sectors;
+
+    rc = fcb_init(&bench_fcb);
+    if (rc != 0) {
+        return rc;
+    }
+    return fcb_clear(&bench_fcb);
+}
+
+static int
+bench_fcb_append_run(void *arg)
+{
+    struct fcb_entry loc;
+    int rc;
+
+    rc = fcb_append(&bench_fcb, BENCH_FCB_ENTRY_LEN, &loc);
+    if (rc == FCB_ERR_NOSPACE) {
+        /* Wrapped around; the erase is part of the cost of appending. */
+        rc = fcb_rotate(&bench_fcb);
+        if (rc == 0) {
+            rc = fcb_append(&bench_fcb, BENCH_FCB_ENTRY_LEN, &loc);
+        }
+    }
+    if (rc != 0) {
+        return rc;
+    }
+
+    rc = flash_area_write(loc.fe_area, loc.fe_data_off, bench_fs_buf,
+                          BENCH_FCB_ENTRY_LEN);
+    if (rc != 0) {
+        return rc;
+    }
+
+    return fcb_append_finish(&bench_fcb, &loc);
+}
+
+#endif /* MYNEWT_VAL(BENCH_FCB) */
+
+static struct bench_case bench_fs_cases[] = {
+#if MYNEWT_VAL(BENCH_FS)
+    {
+        .bc_name = "fs_write",
+        .bc_setup = bench_fs_write_setup,
+        .bc_run = bench_fs_write_run,
+        .bc_teardown = bench_fs_teardown,
+        .bc_iters = 16,
+    },
+    {
+        .bc_name = "fs_read",
+        .bc_setup = bench_fs_read_setup,
+        .bc_run = bench_fs_read_run,
+        .bc_teardown = bench_fs_teardown,
+        .bc_iters = 32,
+    },
+#endif
+#if MYNEWT_VAL(BENCH_FCB)
+    {
+        .bc_name = "fcb_append",
+        .bc_setup = bench_fcb_setup,
+        .bc_run = bench_fcb_append_run,
+        .bc_iters = 32,
+    },
+#endif
+};
+
+int
+bench_fs_register(void)
+{
+    int rc;
+    int i;
+
+    for (i = 0; i < sizeof bench_fs_buf; i++) {
+        bench_fs_buf[i] = i;
+    }
+
+    for (i = 0;
+         i < sizeof bench_fs_cases / sizeof bench_fs_cases[0];
+         i++) {
+
+        rc = bench_register(bench_fs_cases + i);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
+#endif /* MYNEWT_VAL(BENCH_FS) || MYNEWT_VAL(BENCH_FCB) */
@@ -0,0 +1,170 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(BENCH_NEWTMGR)
+
+#include <string.h>
+
+#include "mgmt/mgmt.h"
+#include "cborattr/cborattr.h"
+
+#include "bench/bench.h"
+#include "bench_priv.h"
+
+#define BENCH_NMGR_ID_LIST      0
+#define BENCH_NMGR_ID_RUN       1
+
+static int bench_nmgr_list(struct mgmt_cbuf *);
+static int bench_nmgr_run(struct mgmt_cbuf *);
+
+static const struct mgmt_handler bench_nmgr_handlers[] = {
+    [BENCH_NMGR_ID_LIST] = { bench_nmgr_list, NULL },
+    [BENCH_NMGR_ID_RUN] = { NULL, bench_nmgr_run },
+};
+
+struct mgmt_group bench_nmgr_group = {
+    .mg_handlers = (struct mgmt_handler *)bench_nmgr_handlers,
+    .mg_handlers_count = 2,
+    .mg_group_id = MGMT_GROUP_ID_BENCH
+};
+
+/**
+ * Encodes a result as {"name", "iters", "reps", "min", "avg", "max",
+ * "total", "rc"}.
+ */
+static CborError
+bench_nmgr_encode_result(CborEncoder *penc, const struct bench_case *bc,
+                         const struct bench_result *res)
+{
+    CborError g_err = CborNoError;
+    CborEncoder map;
+
+    g_err |= cbor_encoder_create_map(penc, &map, 8);
+    g_err |= cbor_encode_text_stringz(&map, "name");
+    g_err |= cbor_encode_text_stringz(&map, bc->bc_name);
+    g_err |= cbor_encode_text_stringz(&map, "iters");
+    g_err |= cbor_encode_uint(&map, res->br_iters);
+    g_err |= cbor_encode_text_stringz(&map, "reps");
+    g_err |= cbor_encode_uint(&map, res->br_reps);
+    g_err |= cbor_encode_text_stringz(&map, "min");
+    g_err |= cbor_encode_uint(&map, res->br_min);
+    g_err |= cbor_encode_text_stringz(&map, "avg");
+    g_err |= cbor_encode_uint(&map, res->br_avg);
+    g_err |= cbor_encode_text_stringz(&map, "max");
+    g_err |= cbor_encode_uint(&map, res->br_max);
+    g_err |= cbor_encode_text_stringz(&map, "total");
+    g_err |= cbor_encode_uint(&map, res->br_total);
+    g_err |= cbor_encode_text_stringz(&map, "rc");
+    g_err |= cbor_encode_int(&map, res->br_rc);
+    g_err |= cbor_encoder_close_container(penc, &map);
+
+    return g_err;
+}
+
+/**
+ * Lists the registered benchmarks, with the last result of each one that
+ * has been run.
+ */
+static int
+bench_nmgr_list(struct mgmt_cbuf *cb)
+{
+    CborError g_err = CborNoError;
+    CborEncoder *penc = &cb->encoder;
+    CborEncoder rsp, list;
+    struct bench_case *bc;
+
+    g_err |= cbor_encoder_create_map(penc, &rsp, CborIndefiniteLength);
+    g_err |= cbor_encode_text_stringz(&rsp, "rc");
+    g_err |= cbor_encode_int(&rsp, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&rsp, "unit");
+    g_err |= cbor_encode_text_stringz(&rsp, bench_units());
+
+    g_err |= cbor_encode_text_stringz(&rsp, "bench");
+    g_err |= cbor_encoder_create_array(&rsp, &list, CborIndefiniteLength);
+    for (bc = bench_next(NULL); bc != NULL; bc = bench_next(bc)) {
+        if (bc->bc_ran) {
+            g_err |= bench_nmgr_encode_result(&list, bc, &bc->bc_last);
+        } else {
+            g_err |= cbor_encode_text_stringz(&list, bc->bc_name);
+        }
+    }
+    g_err |= cbor_encoder_close_container(&rsp, &list);
+    g_err |= cbor_encoder_close_container(penc, &rsp);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return 0;
+}
+
+/**
+ * Runs the benchmark named in the request and returns its result.
+ */
+static int
+bench_nmgr_run(struct mgmt_cbuf *cb)
+{
+    char name[32];
+    const struct cbor_attr_t attr[2] = {
+        [0] = {
+            .attribute = "name",
+            .type = CborAttrTextStringType,
+            .addr.string = name,
+            .len = sizeof(name)
+        },
+        [1] = {
+            .attribute = NULL
+        }
+    };
+    CborError g_err = CborNoError;
+    CborEncoder *penc = &cb->encoder;
+    CborEncoder rsp;
+    struct bench_result res;
+    struct bench_case *bc;
+    int rc;
+
+    rc = cbor_read_object(&cb->it, attr);
+    if (rc) {
+        return MGMT_ERR_EINVAL;
+    }
+
+    bc = bench_find(name);
+    if (bc == NULL) {
+        return MGMT_ERR_ENOENT;
+    }
+
+    bench_run(bc, &res);
+
+    g_err |= cbor_encoder_create_map(penc, &rsp, CborIndefiniteLength);
+    g_err |= cbor_encode_text_stringz(&rsp, "rc");
+    g_err |= cbor_encode_int(&rsp, MGMT_ERR_EOK);
+    g_err |= cbor_encode_text_stringz(&rsp, "unit");
+    g_err |= cbor_encode_text_stringz(&rsp, bench_units());
+    g_err |= cbor_encode_text_stringz(&rsp, "result");
+    g_err |= bench_nmgr_encode_result(&rsp, bc, &res);
+    g_err |= cbor_encoder_close_container(penc, &rsp);
+
+    if (g_err) {
+        return MGMT_ERR_ENOMEM;
+    }
+    return 0;
+}
+
+#endif /* MYNEWT_VAL(BENCH_NEWTMGR) */
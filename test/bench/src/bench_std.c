@@ -0,0 +1,319 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "syscfg/syscfg.h"
+
+#if MYNEWT_VAL(BENCH_STD)
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "defs/error.h"
+#include "os/os.h"
+#include "crc/crc8.h"
+#include "crc/crc16.h"
+
+#include "bench/bench.h"
+#include "bench_priv.h"
+
+#define BENCH_STD_BLOCK_SIZE    32
+#define BENCH_STD_BLOCK_CNT     8
+#define BENCH_STD_MBUF_SIZE     (128 + sizeof (struct os_mbuf))
+#define BENCH_STD_MBUF_CNT      8
+#define BENCH_STD_CRC_LEN       256
+
+static struct os_mempool bench_std_pool;
+static os_membuf_t bench_std_pool_mem[
+    OS_MEMPOOL_SIZE(BENCH_STD_BLOCK_CNT, BENCH_STD_BLOCK_SIZE)
+];
+
+static struct os_mempool bench_std_mbuf_mpool;
+static struct os_mbuf_pool bench_std_mbuf_pool;
+static os_membuf_t bench_std_mbuf_mem[
+    OS_MEMPOOL_SIZE(BENCH_STD_MBUF_CNT, BENCH_STD_MBUF_SIZE)
+];
+
+static struct os_eventq bench_std_evq;
+static struct os_event bench_std_ev;
+
+static struct os_task bench_std_task;
+static os_stack_t bench_std_stack[
+    OS_STACK_ALIGN(MYNEWT_VAL(BENCH_TASK_STACK_SIZE))
+];
+static struct os_sem bench_std_ping;
+static struct os_sem bench_std_pong;
+static uint8_t bench_std_task_started;
+
+static uint8_t bench_std_buf[BENCH_STD_CRC_LEN];
+
+/*** mempool: one get and one put. */
+
+static int
+bench_std_mempool_setup(void *arg)
+{
+    return os_mempool_init(&bench_std_pool, BENCH_STD_BLOCK_CNT,
+                           BENCH_STD_BLOCK_SIZE, bench_std_pool_mem,
+                           "bench_pool");
+}
+
+static int
+bench_std_mempool_run(void *arg)
+{
+    void *block;
+
+    block = os_memblock_get(&bench_std_pool);
+    if (block == NULL) {
+        return SYS_ENOMEM;
+    }
+    return os_memblock_put(&bench_std_pool, block);
+}
+
+/*** mbuf: allocate a packet, append a payload, prepend a header, free. */
+
+static int
+bench_std_mbuf_setup(void *arg)
+{
+    int rc;
+
+    rc = os_mempool_init(&bench_std_mbuf_mpool, BENCH_STD_MBUF_CNT,
+                         BENCH_STD_MBUF_SIZE, bench_std_mbuf_mem,
+                         "bench_mbuf");
+    if (rc != 0) {
+        return rc;
+    }
+    return os_mbuf_pool_init(&bench_std_mbuf_pool, &bench_std_mbuf_mpool,
+                             BENCH_STD_MBUF_SIZE, BENCH_STD_MBUF_CNT);
+}
+
+static int
+bench_std_mbuf_run(void *arg)
+{
+    struct os_mbuf *om;
+    int rc;
+
+    om = os_mbuf_get_pkthdr(&bench_std_mbuf_pool, 0);
+    if (om == NULL) {
+        return SYS_ENOMEM;
+    }
+
+    rc = os_mbuf_append(om, bench_std_buf, 64);
+    if (rc != 0) {
+        os_mbuf_free_chain(om);
+        return SYS_ENOMEM;
+    }
+
+    om = os_mbuf_prepend(om, 4);
+    if (om == NULL) {
+        return SYS_ENOMEM;
+    }
+
+    return os_mbuf_free_chain(om);
+}
+
+/*** mbuf_pullup: make the first 48 bytes of a fragmented packet contiguous. */
+
+static int
+bench_std_mbuf_pullup_run(void *arg)
+{
+    struct os_mbuf *om;
+    struct os_mbuf *frag;
+    int rc;
+    int i;
+
+    om = os_mbuf_get_pkthdr(&bench_std_mbuf_pool, 0);
+    if (om == NULL) {
+        return SYS_ENOMEM;
+    }
+
+    /* Build a chain of four 16-byte fragments. */
+    rc = os_mbuf_append(om, bench_std_buf, 16);
+    for (i = 0; rc == 0 && i < 3; i++) {
+        frag = os_mbuf_get(&bench_std_mbuf_pool, 0);
+        if (frag == NULL) {
+            rc = SYS_ENOMEM;
+            break;
+        }
+        rc = os_mbuf_append(frag, bench_std_buf, 16);
+        os_mbuf_concat(om, frag);
+    }
+    if (rc != 0) {
+        os_mbuf_free_chain(om);
+        return SYS_ENOMEM;
+    }
+
+    om = os_mbuf_pullup(om, 48);
+    if (om == NULL) {
+        return SYS_ENOMEM;
+    }
+
+    return os_mbuf_free_chain(om);
+}
+
+/*** eventq: put an event and take it back off the queue. */
+
+static int
+bench_std_eventq_setup(void *arg)
+{
+    os_eventq_init(&bench_std_evq);
+    memset(&bench_std_ev, 0, sizeof bench_std_ev);
+    return 0;
+}
+
+static int
+bench_std_eventq_run(void *arg)
+{
+    os_eventq_put(&bench_std_evq, &bench_std_ev);
+    if (os_eventq_get(&bench_std_evq) != &bench_std_ev) {
+        return SYS_EINVAL;
+    }
+    return 0;
+}
+
+/*** ctxsw: semaphore ping-pong with a helper task; two switches each. */
+
+static void
+bench_std_task_handler(void *arg)
+{
+    while (1) {
+        os_sem_pend(&bench_std_ping, OS_TIMEOUT_NEVER);
+        os_sem_release(&bench_std_pong);
+    }
+}
+
+static int
+bench_std_ctxsw_setup(void *arg)
+{
+    int rc;
+
+    if (bench_std_task_started) {
+        return 0;
+    }
+
+    os_sem_init(&bench_std_ping, 0);
+    os_sem_init(&bench_std_pong, 0);
+    rc = os_task_init(&bench_std_task, "bench", bench_std_task_handler, NULL,
+                      MYNEWT_VAL(BENCH_TASK_PRIO), OS_WAIT_FOREVER,
+                      bench_std_stack,
+                      MYNEWT_VAL(BENCH_TASK_STACK_SIZE));
+    if (rc != 0) {
+        return rc;
+    }
+    bench_std_task_started = 1;
+
+    return 0;
+}
+
+static int
+bench_std_ctxsw_run(void *arg)
+{
+    os_sem_release(&bench_std_ping);
+    return os_sem_pend(&bench_std_pong, OS_TIMEOUT_NEVER);
+}
+
+/*** crc: checksum a 256-byte buffer. */
+
+static int
+bench_std_crc16_run(void *arg)
+{
+    volatile uint16_t crc;
+
+    crc = crc16_ccitt(CRC16_INITIAL_CRC, bench_std_buf, sizeof bench_std_buf);
+    (void)crc;
+
+    return 0;
+}
+
+static int
+bench_std_crc8_run(void *arg)
+{
+    volatile uint8_t crc;
+
+    crc = crc8_calc(crc8_init(), bench_std_buf, sizeof bench_std_buf);
+    (void)crc;
+
+    return 0;
+}
+
+static struct bench_case bench_std_cases[] = {
+    {
+        .bc_name = "mempool",
+        .bc_setup = bench_std_mempool_setup,
+        .bc_run = bench_std_mempool_run,
+        .bc_iters = 1000,
+    },
+    {
+        .bc_name = "mbuf",
+        .bc_setup = bench_std_mbuf_setup,
+        .bc_run = bench_std_mbuf_run,
+        .bc_iters = 500,
+    },
+    {
+        .bc_name = "mbuf_pullup",
+        .bc_setup = bench_std_mbuf_setup,
+        .bc_run = bench_std_mbuf_pullup_run,
+        .bc_iters = 200,
+    },
+    {
+        .bc_name = "eventq",
+        .bc_setup = bench_std_eventq_setup,
+        .bc_run = bench_std_eventq_run,
+        .bc_iters = 1000,
+    },
+    {
+        .bc_name = "ctxsw",
+        .bc_setup = bench_std_ctxsw_setup,
+        .bc_run = bench_std_ctxsw_run,
+        .bc_iters = 500,
+    },
+    {
+        .bc_name = "crc16",
+        .bc_run = bench_std_crc16_run,
+        .bc_iters = 100,
+    },
+    {
+        .bc_name = "crc8",
+        .bc_run = bench_std_crc8_run,
+        .bc_iters = 100,
+    },
+};
+
+int
+bench_std_register(void)
+{
+    int rc;
+    int i;
+
+    for (i = 0; i < sizeof bench_std_buf; i++) {
+        bench_std_buf[i] = i;
+    }
+
+    for (i = 0;
+         i < sizeof bench_std_cases / sizeof bench_std_cases[0];
+         i++) {
+
+        rc = bench_register(bench_std_cases + i);
+        if (rc != 0) {
+            return rc;
+        }
+    }
+
+    return 0;
+}
+
+#endif /* MYNEWT_VAL(BENCH_STD) */
@@ -27,9 +27,19 @@ extern "C" {
 
 struct cbmem_entry_hdr {
     uint16_t ceh_len;
-    uint16_t ceh_flags;
+    uint16_t ceh_seq;
 } __attribute__((packed));
 
+/*
+ * Lock-free mode. There must be only one writer (appending, or flushing)
+ * at a time, but that can be an interrupt handler. Readers don't block the
+ * writer; instead they check that entries they read were not overwritten
+ * meanwhile, and skip forward if they fell behind. Readers should use
+ * cbmem_iter_read(). Sequence numbers are 16 bits, so buffer must hold less
+ * than 32768 entries.
+ */
+#define CBMEM_F_LOCKFREE    0x01
+
 struct cbmem {
     struct os_mutex c_lock;
 
@@ -38,12 +48,21 @@ struct cbmem {
     uint8_t *c_buf;
     uint8_t *c_buf_end;
     uint8_t *c_buf_cur_end;
+
+    uint8_t c_flags;
+    uint16_t c_seq;                     /* seq of next entry */
+    uint16_t c_seq_start;               /* seq of oldest entry */
 };
 
 struct cbmem_iter {
     struct cbmem_entry_hdr *ci_start;
     struct cbmem_entry_hdr *ci_cur;
     struct cbmem_entry_hdr *ci_end;
+
+    struct cbmem_entry_hdr *ci_last;    /* entry last returned */
+    uint16_t ci_last_len;
+    uint16_t ci_last_seq;
+    uint16_t ci_seq;                    /* seq of ci_cur */
 };
 
 #define CBMEM_ENTRY_SIZE(__p) (sizeof(struct cbmem_entry_hdr) \
@@ -57,12 +76,15 @@ typedef int (*cbmem_walk_func_t)(struct cbmem *, struct cbmem_entry_hdr *,
 int cbmem_lock_acquire(struct cbmem *cbmem);
 int cbmem_lock_release(struct cbmem *cbmem);
 int cbmem_init(struct cbmem *cbmem, void *buf, uint32_t buf_len);
+int cbmem_init_lockfree(struct cbmem *cbmem, void *buf, uint32_t buf_len);
 int cbmem_append(struct cbmem *cbmem, void *data, uint16_t len);
 void cbmem_iter_start(struct cbmem *cbmem, struct cbmem_iter *iter);
 struct cbmem_entry_hdr *cbmem_iter_next(struct cbmem *cbmem, 
         struct cbmem_iter *iter);
 int cbmem_read(struct cbmem *cbmem, struct cbmem_entry_hdr *hdr, void *buf, 
         uint16_t off, uint16_t len);
+int cbmem_iter_read(struct cbmem *cbmem, struct cbmem_iter *iter, void *buf,
+        uint16_t off, uint16_t len);
 int cbmem_walk(struct cbmem *cbmem, cbmem_walk_func_t walk_func, void *arg);
 
 int cbmem_flush(struct cbmem *);
@@ -22,25 +22,57 @@
 
 #include "cbmem/cbmem.h"
 
+/*
+ * In lock-free mode the writer may interrupt a reader (or the other way
+ * around) on the same CPU, so only compiler reordering needs to be
+ * prevented.
+ */
+#define CBMEM_BARRIER()     __asm__ volatile("" ::: "memory")
+
+/*
+ * How many times a lock-free reader tries to restart from the oldest entry
+ * after having been overtaken by the writer.
+ */
+#define CBMEM_LF_RETRIES    4
 
 int
 cbmem_init(struct cbmem *cbmem, void *buf, uint32_t buf_len)
 {
+    memset(cbmem, 0, sizeof(*cbmem));
     os_mutex_init(&cbmem->c_lock);
 
-    memset(cbmem, 0, sizeof(*cbmem));
     cbmem->c_buf = buf;
     cbmem->c_buf_end = buf + buf_len;
 
     return (0);
 }
 
+int
+cbmem_init_lockfree(struct cbmem *cbmem, void *buf, uint32_t buf_len)
+{
+    cbmem_init(cbmem, buf, buf_len);
+    cbmem->c_flags |= CBMEM_F_LOCKFREE;
+
+    return (0);
+}
+
+/*
+ * Returns non-zero if entry with sequence number seq has been, or is being,
+ * overwritten.
+ */
+static int
+cbmem_seq_lost(struct cbmem *cbmem, uint16_t seq)
+{
+    CBMEM_BARRIER();
+    return (int16_t)(seq - cbmem->c_seq_start) < 0;
+}
+
 int
 cbmem_lock_acquire(struct cbmem *cbmem)
 {
     int rc;
 
-    if (!os_started()) {
+    if (!os_started() || cbmem->c_flags & CBMEM_F_LOCKFREE) {
         return (0);
     }
 
@@ -59,7 +91,7 @@ cbmem_lock_release(struct cbmem *cbmem)
 {
     int rc;
 
-    if (!os_started()) {
+    if (!os_started() || cbmem->c_flags & CBMEM_F_LOCKFREE) {
         return (0);
     }
 
@@ -73,6 +105,86 @@ err:
     return (rc);
 }
 
+/*
+ * Append without taking the lock. The writer first publishes which
+ * entries it is about to overwrite, then fills in the new entry, and only
+ * then makes it visible by advancing c_seq. c_buf_cur_end is kept at the
+ * end of the last entry before the wrap, so readers can tell where the
+ * next entry is.
+ */
+static int
+cbmem_append_lockfree(struct cbmem *cbmem, void *data, uint16_t len)
+{
+    struct cbmem_entry_hdr *dst;
+    uint8_t *cur_end;
+    uint8_t *start;
+    uint8_t *end;
+    uint16_t seq;
+
+    if (sizeof(*dst) + len > cbmem->c_buf_end - cbmem->c_buf) {
+        return (-1);
+    }
+
+    seq = cbmem->c_seq;
+    cur_end = cbmem->c_buf_cur_end;
+    start = (uint8_t *) cbmem->c_entry_start;
+
+    if (cbmem->c_entry_end) {
+        dst = CBMEM_ENTRY_NEXT(cbmem->c_entry_end);
+    } else {
+        dst = (struct cbmem_entry_hdr *) cbmem->c_buf;
+    }
+    end = (uint8_t *) dst + len + sizeof(*dst);
+
+    if (end > cbmem->c_buf_end) {
+        cur_end = (uint8_t *) dst;
+        dst = (struct cbmem_entry_hdr *) cbmem->c_buf;
+        end = (uint8_t *) dst + len + sizeof(*dst);
+        if (start >= cur_end) {
+            start = cbmem->c_buf;
+        }
+    }
+
+    if (start && (uint8_t *) dst < start + CBMEM_ENTRY_SIZE(start) &&
+            end > start) {
+        while (start < end) {
+            start = (uint8_t *) CBMEM_ENTRY_NEXT(start);
+            if (start == cur_end) {
+                start = cbmem->c_buf;
+                break;
+            }
+        }
+    }
+    if (!start) {
+        start = (uint8_t *) dst;
+    }
+    if (end > cur_end) {
+        cur_end = end;
+    }
+
+    /*
+     * Entries from dst up to the new start are going away.
+     */
+    if (start == (uint8_t *) dst) {
+        cbmem->c_seq_start = seq;
+    } else {
+        cbmem->c_seq_start = ((struct cbmem_entry_hdr *) start)->ceh_seq;
+    }
+    CBMEM_BARRIER();
+    cbmem->c_entry_start = (struct cbmem_entry_hdr *) start;
+    cbmem->c_buf_cur_end = cur_end;
+    CBMEM_BARRIER();
+
+    dst->ceh_len = len;
+    dst->ceh_seq = seq;
+    memcpy((uint8_t *) dst + sizeof(*dst), data, len);
+    CBMEM_BARRIER();
+
+    cbmem->c_entry_end = dst;
+    cbmem->c_seq = seq + 1;
+
+    return (0);
+}
 
 int
 cbmem_append(struct cbmem *cbmem, void *data, uint16_t len)
@@ -82,6 +194,10 @@ cbmem_append(struct cbmem *cbmem, void *data, uint16_t len)
     uint8_t *end;
     int rc;
 
+    if (cbmem->c_flags & CBMEM_F_LOCKFREE) {
+        return cbmem_append_lockfree(cbmem, data, len);
+    }
+
     rc = cbmem_lock_acquire(cbmem);
     if (rc != 0) {
         goto err;
@@ -126,6 +242,7 @@ cbmem_append(struct cbmem *cbmem, void *data, uint16_t len)
     /* Copy the entry into the log
      */
     dst->ceh_len = len;
+    dst->ceh_seq = cbmem->c_seq++;
     memcpy((uint8_t *) dst + sizeof(*dst), data, len);
 
     cbmem->c_entry_end = dst;
@@ -146,16 +263,69 @@ err:
 void
 cbmem_iter_start(struct cbmem *cbmem, struct cbmem_iter *iter)
 {
+    iter->ci_last = NULL;
+    if (cbmem->c_flags & CBMEM_F_LOCKFREE) {
+        iter->ci_seq = cbmem->c_seq_start;
+        CBMEM_BARRIER();
+        iter->ci_cur = cbmem->c_entry_start;
+        return;
+    }
     iter->ci_start = cbmem->c_entry_start;
     iter->ci_cur = cbmem->c_entry_start;
     iter->ci_end = cbmem->c_entry_end;
 }
 
+/*
+ * Next entry in lock-free mode. The header is copied out, and only trusted
+ * if the writer has not started overwriting the entry by the time the copy
+ * is done. Otherwise the iterator has been overtaken, and it restarts from
+ * whatever is oldest now.
+ */
+static struct cbmem_entry_hdr *
+cbmem_iter_next_lockfree(struct cbmem *cbmem, struct cbmem_iter *iter)
+{
+    struct cbmem_entry_hdr hdr;
+    uint8_t *p;
+    int i;
+
+    for (i = 0; i < CBMEM_LF_RETRIES; i++) {
+        CBMEM_BARRIER();
+        if (iter->ci_seq == cbmem->c_seq) {
+            break;
+        }
+        CBMEM_BARRIER();
+        p = (uint8_t *) iter->ci_cur;
+        if (p == cbmem->c_buf_cur_end ||
+                p + sizeof(hdr) > cbmem->c_buf_end) {
+            p = cbmem->c_buf;
+        }
+        memcpy(&hdr, p, sizeof(hdr));
+        if (hdr.ceh_seq == iter->ci_seq &&
+                p + sizeof(hdr) + hdr.ceh_len <= cbmem->c_buf_end &&
+                !cbmem_seq_lost(cbmem, iter->ci_seq)) {
+            iter->ci_last = (struct cbmem_entry_hdr *) p;
+            iter->ci_last_len = hdr.ceh_len;
+            iter->ci_last_seq = hdr.ceh_seq;
+            iter->ci_cur = (struct cbmem_entry_hdr *)
+                (p + sizeof(hdr) + hdr.ceh_len);
+            iter->ci_seq++;
+            return (iter->ci_last);
+        }
+        cbmem_iter_start(cbmem, iter);
+    }
+    iter->ci_last = NULL;
+    return (NULL);
+}
+
 struct cbmem_entry_hdr *
 cbmem_iter_next(struct cbmem *cbmem, struct cbmem_iter *iter)
 {
     struct cbmem_entry_hdr *hdr;
 
+    if (cbmem->c_flags & CBMEM_F_LOCKFREE) {
+        return cbmem_iter_next_lockfree(cbmem, iter);
+    }
+
     if (iter->ci_start > iter->ci_end) {
         hdr = iter->ci_cur;
         iter->ci_cur = CBMEM_ENTRY_NEXT(iter->ci_cur);
@@ -178,6 +348,10 @@ cbmem_iter_next(struct cbmem *cbmem, struct cbmem_iter *iter)
     }
 
 err:
+    iter->ci_last = hdr;
+    if (hdr) {
+        iter->ci_last_len = hdr->ceh_len;
+    }
     return (hdr);
 }
 
@@ -186,6 +360,12 @@ cbmem_flush(struct cbmem *cbmem)
 {
     int rc;
 
+    if (cbmem->c_flags & CBMEM_F_LOCKFREE) {
+        /* Same as having overwritten everything. */
+        cbmem->c_seq_start = cbmem->c_seq;
+        CBMEM_BARRIER();
+    }
+
     rc = cbmem_lock_acquire(cbmem);
     if (rc != 0) {
         goto err;
@@ -241,6 +421,36 @@ err:
     return (-1);
 }
 
+/*
+ * Read from the entry last returned by cbmem_iter_next(). In lock-free
+ * mode this fails if the entry got overwritten while being read.
+ */
+int
+cbmem_iter_read(struct cbmem *cbmem, struct cbmem_iter *iter, void *buf,
+        uint16_t off, uint16_t len)
+{
+    if (!iter->ci_last) {
+        return (-1);
+    }
+    if (!(cbmem->c_flags & CBMEM_F_LOCKFREE)) {
+        return cbmem_read(cbmem, iter->ci_last, buf, off, len);
+    }
+
+    if (off > iter->ci_last_len) {
+        return (-1);
+    }
+    if (off + len > iter->ci_last_len) {
+        len = iter->ci_last_len - off;
+    }
+    memcpy(buf, (uint8_t *) iter->ci_last + sizeof(*iter->ci_last) + off,
+            len);
+    if (cbmem_seq_lost(cbmem, iter->ci_last_seq)) {
+        return (-1);
+    }
+
+    return (len);
+}
+
 int
 cbmem_walk(struct cbmem *cbmem, cbmem_walk_func_t walk_func, void *arg)
 {
@@ -0,0 +1,78 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "cbmem_test.h"
+
+TEST_CASE(cbmem_test_case_4)
+{
+    struct cbmem_entry_hdr *hdr;
+    struct cbmem_iter iter;
+    uint8_t val;
+    int i;
+    int rc;
+
+    rc = cbmem_init_lockfree(&cbmem1, cbmem1_buf, CBMEM1_BUF_SIZE);
+    TEST_ASSERT_FATAL(rc == 0, "cbmem_init_lockfree() failed, rc = %d", rc);
+
+    memset(cbmem1_entry, 0xff, sizeof(cbmem1_entry));
+    for (i = 0; i < 65; i++) {
+        cbmem1_entry[0] = i;
+        rc = cbmem_append(&cbmem1, cbmem1_entry, sizeof(cbmem1_entry));
+        TEST_ASSERT_FATAL(rc == 0, "Could not append entry %d, rc = %d", i, rc);
+    }
+
+    /* Same contents as when locking. */
+    i = 2;
+    cbmem_iter_start(&cbmem1, &iter);
+    while ((hdr = cbmem_iter_next(&cbmem1, &iter)) != NULL) {
+        rc = cbmem_iter_read(&cbmem1, &iter, &val, 0, sizeof(val));
+        TEST_ASSERT_FATAL(rc == 1, "Couldn't read 1 byte from cbmem");
+        TEST_ASSERT_FATAL(val == i, "Entry index does not match %d vs %d",
+                val, i);
+        i++;
+    }
+    TEST_ASSERT_FATAL(i == 65, "Processed %d entries instead of 63", i - 2);
+
+    /* Writer overtakes reader; entry being read must be reported lost. */
+    cbmem_iter_start(&cbmem1, &iter);
+    hdr = cbmem_iter_next(&cbmem1, &iter);
+    TEST_ASSERT_FATAL(hdr != NULL);
+    for (i = 65; i < 130; i++) {
+        cbmem1_entry[0] = i;
+        rc = cbmem_append(&cbmem1, cbmem1_entry, sizeof(cbmem1_entry));
+        TEST_ASSERT_FATAL(rc == 0, "Could not append entry %d, rc = %d", i, rc);
+    }
+    rc = cbmem_iter_read(&cbmem1, &iter, &val, 0, sizeof(val));
+    TEST_ASSERT_FATAL(rc < 0, "Read of overwritten entry returned %d", rc);
+
+    /* Iterator skips forward to oldest entry. */
+    i = 67;
+    while ((hdr = cbmem_iter_next(&cbmem1, &iter)) != NULL) {
+        rc = cbmem_iter_read(&cbmem1, &iter, &val, 0, sizeof(val));
+        TEST_ASSERT_FATAL(rc == 1, "Couldn't read 1 byte from cbmem");
+        TEST_ASSERT_FATAL(val == i, "Entry index does not match %d vs %d",
+                val, i);
+        i++;
+    }
+    TEST_ASSERT_FATAL(i == 130, "Iteration stopped at %d", i);
+
+    /* Flush drops everything. */
+    cbmem_flush(&cbmem1);
+    cbmem_iter_start(&cbmem1, &iter);
+    TEST_ASSERT(cbmem_iter_next(&cbmem1, &iter) == NULL);
+}
@@ -0,0 +1,92 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include <stddef.h>
+#include "syscfg/syscfg.h"
+#include "testutil/testutil.h"
+#include "crc_test.h"
+
+uint8_t crc_test_buf[CRC_TEST_BUF_SIZE];
+
+/**
+ * Bit-at-a-time CRC16-CCITT; the reference the table driven code is checked
+ * against.
+ */
+uint16_t
+crc_test_crc16_ref(uint16_t initial_crc, const void *buf, int len)
+{
+    const uint8_t *ptr;
+    uint16_t crc;
+    int i;
+
+    crc = initial_crc;
+    ptr = buf;
+    while (len-- > 0) {
+        crc ^= (uint16_t)*ptr++ << 8;
+        for (i = 0; i < 8; i++) {
+            if (crc & 0x8000) {
+                crc = (crc << 1) ^ 0x1021;
+            } else {
+                crc <<= 1;
+            }
+        }
+    }
+
+    return crc;
+}
+
+static void
+crc_test_fill_buf(void *arg)
+{
+    uint32_t x;
+    int i;
+
+    /* Deterministic pseudo-random contents. */
+    x = 0x12345678;
+    for (i = 0; i < CRC_TEST_BUF_SIZE; i++) {
+        x = x * 1103515245 + 12345;
+        crc_test_buf[i] = x >> 16;
+    }
+}
+
+TEST_CASE_DECL(crc16_test_known)
+TEST_CASE_DECL(crc16_test_ref)
+TEST_CASE_DECL(crc16_test_large)
+
+TEST_SUITE(crc_test_suite)
+{
+    crc16_test_known();
+    crc16_test_ref();
+    crc16_test_large();
+}
+
+#if MYNEWT_VAL(SELFTEST)
+
+int
+main(int argc, char **argv)
+{
+    ts_config.ts_print_results = 1;
+    tu_init();
+
+    tu_suite_set_init_cb(crc_test_fill_buf, NULL);
+    crc_test_suite();
+
+    return tu_any_failed;
+}
+
+#endif
@@ -0,0 +1,37 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "crc_test.h"
+
+TEST_CASE(crc16_test_known)
+{
+    static const char check[] = "123456789";
+    uint16_t crc;
+
+    /* CRC-16/XMODEM check value. */
+    crc = crc16_ccitt(CRC16_INITIAL_CRC, check, 9);
+    TEST_ASSERT(crc == 0x31c3);
+
+    /* CRC-16/CCITT-FALSE check value. */
+    crc = crc16_ccitt(0xffff, check, 9);
+    TEST_ASSERT(crc == 0x29b1);
+
+    /* Empty input leaves the seed untouched. */
+    crc = crc16_ccitt(0xabcd, check, 0);
+    TEST_ASSERT(crc == 0xabcd);
+}
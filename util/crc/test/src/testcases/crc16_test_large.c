@@ -0,0 +1,46 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "crc_test.h"
+
+#define CRC16_TEST_LARGE_ITERS  256
+
+/**
+ * Chains crc16_ccitt() over many copies of the test buffer and checks the
+ * result against the bitwise reference.  Throughput is measured by the
+ * crc16 benchmark in test/bench, not here.
+ */
+TEST_CASE(crc16_test_large)
+{
+    uint16_t crc_ref;
+    uint16_t crc;
+    int i;
+
+    crc_ref = 0;
+    for (i = 0; i < CRC16_TEST_LARGE_ITERS; i++) {
+        crc_ref = crc_test_crc16_ref(crc_ref, crc_test_buf,
+                                     CRC_TEST_BUF_SIZE);
+    }
+
+    crc = 0;
+    for (i = 0; i < CRC16_TEST_LARGE_ITERS; i++) {
+        crc = crc16_ccitt(crc, crc_test_buf, CRC_TEST_BUF_SIZE);
+    }
+
+    TEST_ASSERT(crc == crc_ref);
+}
@@ -0,0 +1,51 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+#include "crc_test.h"
+
+TEST_CASE(crc16_test_ref)
+{
+    uint16_t expected;
+    uint16_t crc;
+    int split;
+    int off;
+    int len;
+
+    /* Every alignment and every tail length around the slice size. */
+    for (off = 0; off < 16; off++) {
+        for (len = 0; len < 64; len++) {
+            expected = crc_test_crc16_ref(0xffff, crc_test_buf + off, len);
+            crc = crc16_ccitt(0xffff, crc_test_buf + off, len);
+            TEST_ASSERT_FATAL(crc == expected,
+                              "off=%d len=%d crc=0x%04x expected=0x%04x",
+                              off, len, crc, expected);
+        }
+    }
+
+    /* Whole buffer, in one call and split across two calls. */
+    expected = crc_test_crc16_ref(0, crc_test_buf, CRC_TEST_BUF_SIZE);
+    crc = crc16_ccitt(0, crc_test_buf, CRC_TEST_BUF_SIZE);
+    TEST_ASSERT(crc == expected);
+
+    for (split = 1; split < 16; split++) {
+        crc = crc16_ccitt(0, crc_test_buf, split);
+        crc = crc16_ccitt(crc, crc_test_buf + split,
+                          CRC_TEST_BUF_SIZE - split);
+        TEST_ASSERT(crc == expected);
+    }
+}